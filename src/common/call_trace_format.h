@@ -0,0 +1,67 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0 OR MIT
+//
+
+/*!
+ * @file
+ *
+ * The layout of the call trace file written by the conformance layer (XR_CONFORMANCE_LAYER_TRACE). The layer writes
+ * it, the framework's ReadCallTrace reads it, and decode_call_trace.py reads the constants below out of this file, so
+ * this is the only place the layout is spelled out.
+ *
+ * The file is the header, then MaxFunctions NUL-terminated names of FunctionNameSize bytes each, indexed by function
+ * id, then the ring of records. All values are little endian. Keep each constant a single line of the form
+ * "constexpr <type> <Name> = <expression>;" so the decoder can evaluate it.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace CallTraceFormat {
+constexpr char Magic[] = "XRCTRACE";  // the first MagicSize bytes of the file
+constexpr uint32_t MagicSize = 8;
+constexpr uint32_t Version = 1;
+constexpr uint32_t MaxFunctions = 1024;
+constexpr uint32_t FunctionNameSize = 64;
+constexpr uint32_t HeaderSize = 256;
+constexpr uint32_t RecordsOffset = HeaderSize + MaxFunctions * FunctionNameSize;
+constexpr uint32_t RecordSize = 32;
+
+// Header fields: u32 version, u32 record size, u64 record capacity, u32 function count, u32 thread count,
+// i64 steady clock and i64 system clock read at the same moment at open, u64 total records ever reserved (the ring
+// position is this modulo capacity).
+constexpr uint32_t VersionOffset = 8;
+constexpr uint32_t RecordSizeOffset = 12;
+constexpr uint32_t RecordCapacityOffset = 16;
+constexpr uint32_t FunctionCountOffset = 24;
+constexpr uint32_t ThreadCountOffset = 28;
+constexpr uint32_t SteadyStartOffset = 32;
+constexpr uint32_t SystemStartOffset = 40;
+constexpr uint32_t RecordsReservedOffset = 48;
+
+// One call. A start timestamp of zero marks a record that has not been written.
+struct Record {
+    int64_t startNs;  // steady clock
+    uint64_t handle;  // the first parameter
+    int32_t result;
+    uint32_t durationNs;  // saturates at ~4.3 seconds
+    uint32_t threadIndex;
+    uint16_t functionId;
+    uint16_t reserved;
+};
+static_assert(sizeof(Record) == RecordSize, "Record does not match RecordSize");
+
+constexpr uint32_t RecordStartOffset = 0;
+constexpr uint32_t RecordHandleOffset = 8;
+constexpr uint32_t RecordResultOffset = 16;
+constexpr uint32_t RecordDurationOffset = 20;
+constexpr uint32_t RecordThreadOffset = 24;
+constexpr uint32_t RecordFunctionOffset = 28;
+static_assert(offsetof(Record, startNs) == RecordStartOffset && offsetof(Record, handle) == RecordHandleOffset &&
+                  offsetof(Record, result) == RecordResultOffset && offsetof(Record, durationNs) == RecordDurationOffset &&
+                  offsetof(Record, threadIndex) == RecordThreadOffset && offsetof(Record, functionId) == RecordFunctionOffset,
+              "Record does not match its offsets");
+}  // namespace CallTraceFormat
@@ -0,0 +1,158 @@
+// Copyright (c) 2017-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0 OR MIT
+//
+
+/*!
+ * @file
+ *
+ * A table of the extensions known to this build, generated from XR_LIST_EXTENSIONS, and a bitset of enabled
+ * extensions indexed by it. Looking an extension up by name or number does not allocate, and checking whether it
+ * is enabled is a single bit test, so it is cheap enough to do on every call.
+ */
+
+#pragma once
+
+#include <openxr/openxr.h>
+#include <openxr/openxr_reflection.h>
+
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+struct XrExtensionRegistryEntry {
+    const char* name;
+    uint32_t number;
+};
+
+// NAME is only ever stringized: every extension name is also defined as a macro by openxr.h.
+#define XR_EXTENSION_REGISTRY_ENTRY(NAME, NUMBER) {#NAME, NUMBER},
+constexpr XrExtensionRegistryEntry kXrExtensionRegistry[] = {XR_LIST_EXTENSIONS(XR_EXTENSION_REGISTRY_ENTRY)};
+#undef XR_EXTENSION_REGISTRY_ENTRY
+
+//! The number of extensions in kXrExtensionRegistry, which is also returned for an extension that is not in it.
+constexpr size_t kXrExtensionCount = sizeof(kXrExtensionRegistry) / sizeof(kXrExtensionRegistry[0]);
+
+namespace xr_extension_registry_detail {
+
+constexpr uint32_t MaxNumber(size_t i = 0, uint32_t max = 0) {
+    return i == kXrExtensionCount ? max : MaxNumber(i + 1, kXrExtensionRegistry[i].number > max ? kXrExtensionRegistry[i].number : max);
+}
+
+// A power of two at least twice the number of extensions, so that probe sequences stay short.
+constexpr size_t HashTableSize(size_t size = 1) { return size >= 2 * kXrExtensionCount ? size : HashTableSize(size * 2); }
+
+inline uint32_t HashName(const char* name) {
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (; *name != '\0'; ++name) {
+        hash = (hash ^ static_cast<unsigned char>(*name)) * 16777619u;
+    }
+    return hash;
+}
+
+using IndexType = uint16_t;
+static_assert(kXrExtensionCount < 0xffff, "IndexType is too small for the extension registry");
+
+// Maps names and numbers to registry indices. Built once on first use; slots hold index + 1, with 0 marking an empty one.
+struct Lookup {
+    std::array<IndexType, HashTableSize()> byName{};
+    std::array<IndexType, MaxNumber() + 1> byNumber{};
+
+    Lookup() {
+        for (size_t i = 0; i < kXrExtensionCount; ++i) {
+            size_t slot = HashName(kXrExtensionRegistry[i].name) & (byName.size() - 1);
+            while (byName[slot] != 0) {
+                slot = (slot + 1) & (byName.size() - 1);
+            }
+            byName[slot] = static_cast<IndexType>(i + 1);
+            byNumber[kXrExtensionRegistry[i].number] = static_cast<IndexType>(i + 1);
+        }
+    }
+};
+
+inline const Lookup& GetLookup() {
+    static const Lookup lookup;
+    return lookup;
+}
+
+}  // namespace xr_extension_registry_detail
+
+//! Returns the index of the named extension in kXrExtensionRegistry (case-sensitive), or kXrExtensionCount if it is unknown.
+inline size_t XrExtensionIndexFromName(const char* name) {
+    const auto& byName = xr_extension_registry_detail::GetLookup().byName;
+    for (size_t slot = xr_extension_registry_detail::HashName(name) & (byName.size() - 1); byName[slot] != 0;
+         slot = (slot + 1) & (byName.size() - 1)) {
+        const size_t index = byName[slot] - 1u;
+        if (std::strcmp(kXrExtensionRegistry[index].name, name) == 0) {
+            return index;
+        }
+    }
+    return kXrExtensionCount;
+}
+
+//! Returns the index of the extension with this number in kXrExtensionRegistry, or kXrExtensionCount if it is unknown.
+inline size_t XrExtensionIndexFromNumber(uint64_t number) {
+    const auto& byNumber = xr_extension_registry_detail::GetLookup().byNumber;
+    if (number >= byNumber.size() || byNumber[static_cast<size_t>(number)] == 0) {
+        return kXrExtensionCount;
+    }
+    return byNumber[static_cast<size_t>(number)] - 1u;
+}
+
+//! The set of enabled extensions that are in kXrExtensionRegistry. Extensions unknown to this build cannot be
+//! represented, so callers that accept arbitrary names keep their own list to fall back on.
+class XrExtensionSet {
+   public:
+    //! Adds the named extension, returning false if it is not in the registry.
+    bool Insert(const char* name) {
+        const size_t index = XrExtensionIndexFromName(name);
+        if (index == kXrExtensionCount) {
+            return false;
+        }
+        bits_.set(index);
+        return true;
+    }
+
+    bool Contains(size_t index) const { return index < kXrExtensionCount && bits_.test(index); }
+    bool ContainsName(const char* name) const { return Contains(XrExtensionIndexFromName(name)); }
+    bool ContainsNumber(uint64_t number) const { return Contains(XrExtensionIndexFromNumber(number)); }
+
+    void Clear() { bits_.reset(); }
+
+   private:
+    std::bitset<kXrExtensionCount> bits_;
+};
+
+//! A set of extension names that may include ones unknown to this build. The known ones are kept as bits of an
+//! XrExtensionSet, so only names missing from the registry are copied and compared as strings.
+class XrExtensionNameSet {
+   public:
+    void Insert(const char* name) {
+        if (!known_.Insert(name) && !ContainsUnknown(name)) {
+            unknown_.emplace_back(name);
+        }
+    }
+
+    bool Contains(const char* name) const {
+        const size_t index = XrExtensionIndexFromName(name);
+        return index != kXrExtensionCount ? known_.Contains(index) : ContainsUnknown(name);
+    }
+
+   private:
+    bool ContainsUnknown(const char* name) const {
+        for (const std::string& unknown : unknown_) {
+            if (unknown == name) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    XrExtensionSet known_;
+    std::vector<std::string> unknown_;
+};
@@ -51,6 +51,13 @@
 #define DIRECTORY_SYMBOL '/'
 #endif
 
+static inline bool StringEndsWith(const std::string& value, const std::string& ending) {
+    if (ending.size() > value.size()) {
+        return false;
+    }
+    return value.compare(value.size() - ending.size(), ending.size(), ending) == 0;
+}
+
 #if (USE_FINAL_FS == 1) || (USE_EXPERIMENTAL_FS == 1)
 // We can use one of the C++ filesystem packages
 
@@ -121,6 +128,57 @@ bool FileSysUtilsFindFilesInPath(const std::string& path, std::vector<std::strin
     return true;
 }
 
+bool FileSysUtilsGetFileStamp(const std::string& path, FileSysUtilsFileStamp& stamp) {
+    std::error_code ec;
+    const auto last_write_time = FS_PREFIX::last_write_time(path, ec);
+    if (ec) {
+        return false;
+    }
+    stamp.last_write_time = static_cast<int64_t>(last_write_time.time_since_epoch().count());
+    stamp.size = 0;
+    if (FS_PREFIX::is_regular_file(path, ec)) {
+        const auto size = FS_PREFIX::file_size(path, ec);
+        if (!ec) {
+            stamp.size = static_cast<uint64_t>(size);
+        }
+    }
+    return true;
+}
+
+bool FileSysUtilsFindAbsoluteFilesInPath(const std::string& path, const std::string& extension, std::vector<std::string>& files) {
+    const FS_PREFIX::path absolute_path = FS_PREFIX::absolute(path);
+    for (auto& dir_iter : FS_PREFIX::directory_iterator(absolute_path)) {
+        const FS_PREFIX::path& file_path = dir_iter.path();
+        if (StringEndsWith(file_path.filename().string(), extension)) {
+            files.push_back(file_path.string());
+        }
+    }
+    return true;
+}
+
+bool FileSysUtilsGetFileStatus(const std::string& path, FileSysUtilsFileStatus& status) {
+    std::error_code ec;
+    const auto file_status = FS_PREFIX::status(path, ec);
+    if (ec || !FS_PREFIX::exists(file_status)) {
+        return false;
+    }
+    status.is_regular_file = FS_PREFIX::is_regular_file(file_status);
+    status.is_directory = FS_PREFIX::is_directory(file_status);
+    const auto last_write_time = FS_PREFIX::last_write_time(path, ec);
+    if (ec) {
+        return false;
+    }
+    status.stamp.last_write_time = static_cast<int64_t>(last_write_time.time_since_epoch().count());
+    status.stamp.size = 0;
+    if (status.is_regular_file) {
+        const auto size = FS_PREFIX::file_size(path, ec);
+        if (!ec) {
+            status.stamp.size = static_cast<uint64_t>(size);
+        }
+    }
+    return true;
+}
+
 #elif defined(XR_OS_WINDOWS)
 
 // For pre C++17 compiler that doesn't support experimental filesystem
@@ -227,6 +285,50 @@ bool FileSysUtilsFindFilesInPath(const std::string& path, std::vector<std::strin
     return false;
 }
 
+bool FileSysUtilsGetFileStamp(const std::string& path, FileSysUtilsFileStamp& stamp) {
+    WIN32_FILE_ATTRIBUTE_DATA attributes;
+    if (!GetFileAttributesExW(utf8_to_wide(path).c_str(), GetFileExInfoStandard, &attributes)) {
+        return false;
+    }
+    stamp.last_write_time = static_cast<int64_t>((static_cast<uint64_t>(attributes.ftLastWriteTime.dwHighDateTime) << 32) |
+                                                 attributes.ftLastWriteTime.dwLowDateTime);
+    stamp.size = (static_cast<uint64_t>(attributes.nFileSizeHigh) << 32) | attributes.nFileSizeLow;
+    return true;
+}
+
+bool FileSysUtilsFindAbsoluteFilesInPath(const std::string& path, const std::string& extension, std::vector<std::string>& files) {
+    // GetFullPathNameW only works on the string, so making the directory absolute once gives the same result.
+    std::string absolute_path;
+    if (!FileSysUtilsGetAbsolutePath(path, absolute_path)) {
+        return false;
+    }
+    std::vector<std::string> filenames;
+    if (!FileSysUtilsFindFilesInPath(absolute_path, filenames)) {
+        return false;
+    }
+    for (const std::string& filename : filenames) {
+        if (StringEndsWith(filename, extension)) {
+            std::string combined;
+            FileSysUtilsCombinePaths(absolute_path, filename, combined);
+            files.push_back(combined);
+        }
+    }
+    return true;
+}
+
+bool FileSysUtilsGetFileStatus(const std::string& path, FileSysUtilsFileStatus& status) {
+    WIN32_FILE_ATTRIBUTE_DATA attributes;
+    if (!GetFileAttributesExW(utf8_to_wide(path).c_str(), GetFileExInfoStandard, &attributes)) {
+        return false;
+    }
+    status.is_directory = (attributes.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+    status.is_regular_file = !status.is_directory;
+    status.stamp.last_write_time = static_cast<int64_t>(
+        (static_cast<uint64_t>(attributes.ftLastWriteTime.dwHighDateTime) << 32) | attributes.ftLastWriteTime.dwLowDateTime);
+    status.stamp.size = (static_cast<uint64_t>(attributes.nFileSizeHigh) << 32) | attributes.nFileSizeLow;
+    return true;
+}
+
 #else  // XR_OS_LINUX/XR_OS_APPLE fallback
 
 // simple POSIX-compatible implementation of the <filesystem> pieces used by OpenXR
@@ -319,4 +421,68 @@ bool FileSysUtilsFindFilesInPath(const std::string& path, std::vector<std::strin
     return true;
 }
 
+static void FileStampFromStat(const struct stat& path_stat, FileSysUtilsFileStamp& stamp) {
+#if defined(XR_OS_APPLE)
+    const struct timespec& mtime = path_stat.st_mtimespec;
+#else
+    const struct timespec& mtime = path_stat.st_mtim;
+#endif
+    stamp.last_write_time = static_cast<int64_t>(mtime.tv_sec) * 1000000000 + mtime.tv_nsec;
+    stamp.size = static_cast<uint64_t>(path_stat.st_size);
+}
+
+bool FileSysUtilsFindAbsoluteFilesInPath(const std::string& path, const std::string& extension, std::vector<std::string>& files) {
+    std::string absolute_path;
+    if (!FileSysUtilsGetAbsolutePath(path, absolute_path)) {
+        return false;
+    }
+    DIR* dir = opendir(absolute_path.c_str());
+    if (dir == nullptr) {
+        return false;
+    }
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        const std::string filename = entry->d_name;
+        if (!StringEndsWith(filename, extension)) {
+            continue;
+        }
+        std::string combined;
+        FileSysUtilsCombinePaths(absolute_path, filename, combined);
+#ifdef DT_LNK
+        // The directory is already canonical, so only a symbolic link (or an entry of unknown type) can
+        // have a canonical path other than the combined one.
+        if (entry->d_type != DT_LNK && entry->d_type != DT_UNKNOWN) {
+            files.push_back(combined);
+            continue;
+        }
+#endif  // DT_LNK
+        std::string canonical;
+        if (FileSysUtilsGetCanonicalPath(combined, canonical)) {
+            files.push_back(canonical);
+        }
+    }
+    closedir(dir);
+    return true;
+}
+
+bool FileSysUtilsGetFileStamp(const std::string& path, FileSysUtilsFileStamp& stamp) {
+    struct stat path_stat;
+    if (stat(path.c_str(), &path_stat) != 0) {
+        return false;
+    }
+    FileStampFromStat(path_stat, stamp);
+    return true;
+}
+
+bool FileSysUtilsGetFileStatus(const std::string& path, FileSysUtilsFileStatus& status) {
+    struct stat path_stat;
+    if (stat(path.c_str(), &path_stat) != 0) {
+        return false;
+    }
+    status.is_regular_file = S_ISREG(path_stat.st_mode);
+    status.is_directory = S_ISDIR(path_stat.st_mode);
+    FileStampFromStat(path_stat, status.stamp);
+    return true;
+}
+
 #endif
@@ -9,9 +9,30 @@
 
 #pragma once
 
+#include <stdint.h>
 #include <string>
 #include <vector>
 
+// Last modification time and size of a path, used to tell whether a file or directory has changed
+// since it was last read. The time is in platform-specific units and only meaningful for comparison.
+struct FileSysUtilsFileStamp {
+    int64_t last_write_time;
+    uint64_t size;
+};
+
+inline bool operator==(const FileSysUtilsFileStamp& lhs, const FileSysUtilsFileStamp& rhs) {
+    return lhs.last_write_time == rhs.last_write_time && lhs.size == rhs.size;
+}
+
+inline bool operator!=(const FileSysUtilsFileStamp& lhs, const FileSysUtilsFileStamp& rhs) { return !(lhs == rhs); }
+
+// Kind and modification stamp of a path, read with as few filesystem queries as the platform allows.
+struct FileSysUtilsFileStatus {
+    bool is_regular_file;
+    bool is_directory;
+    FileSysUtilsFileStamp stamp;
+};
+
 // Determine if the path indicates a regular file (not a directory or symbolic link)
 bool FileSysUtilsIsRegularFile(const std::string& path);
 
@@ -44,3 +65,14 @@ bool FileSysUtilsParsePathList(std::string& path_list, std::vector<std::string>&
 
 // Record all the filenames for files found in the provided path.
 bool FileSysUtilsFindFilesInPath(const std::string& path, std::vector<std::string>& files);
+
+// Record the absolute paths of the files in the provided directory whose names end with the extension.
+// Equivalent to FileSysUtilsFindFilesInPath followed by FileSysUtilsGetAbsolutePath on each match, but the
+// directory is only resolved once instead of once per file.
+bool FileSysUtilsFindAbsoluteFilesInPath(const std::string& path, const std::string& extension, std::vector<std::string>& files);
+
+// Get the modification stamp of a file or directory.  Returns false if the path does not exist.
+bool FileSysUtilsGetFileStamp(const std::string& path, FileSysUtilsFileStamp& stamp);
+
+// Get the kind and modification stamp of a file or directory.  Returns false if the path does not exist.
+bool FileSysUtilsGetFileStatus(const std::string& path, FileSysUtilsFileStatus& status);
@@ -18,6 +18,7 @@
 
 #include <openxr/openxr.h>
 
+#include <array>
 #include <string>
 #include <stdint.h>
 
@@ -84,25 +85,73 @@ static inline bool IsIntegerNullHandle(uint64_t handle) { return XR_NULL_HANDLE
 
 #endif
 
+/// Caller-provided storage for the *ToHexChars formatters: "0x", up to 16 digits and a terminator.
+using HexCharsBuffer = std::array<char, 19>;
+
+/// Writes the low digits hex digits of val, with leading zeros and a "0x" prefix, into buffer and returns it as a
+/// null-terminated string. Does not allocate.
+inline const char* ToHexChars(uint64_t val, size_t digits, HexCharsBuffer& buffer) {
+    static const char hex[] = "0123456789abcdef";
+    buffer[0] = '0';
+    buffer[1] = 'x';
+    char* const first = buffer.data() + 2;
+    char* ch = first + digits;
+    *ch = '\0';
+    while (ch != first) {
+        *--ch = hex[val & 0xf];
+        val >>= 4;
+    }
+    return buffer.data();
+}
+
+/// Formats a uint64_t as hex into buffer, as Uint64ToHexString does.
+inline const char* Uint64ToHexChars(uint64_t val, HexCharsBuffer& buffer) { return ToHexChars(val, 16, buffer); }
+
+/// Formats a uint32_t as hex into buffer, as Uint32ToHexString does.
+inline const char* Uint32ToHexChars(uint32_t val, HexCharsBuffer& buffer) { return ToHexChars(val, 8, buffer); }
+
+/// Formats an OpenXR handle as hex into buffer, as HandleToHexString does.
+template <typename T>
+inline const char* HandleToHexChars(T handle, HexCharsBuffer& buffer) {
+    return ToHexChars(MakeHandleGeneric(handle), sizeof(handle) * 2, buffer);
+}
+
+/// Formats a pointer as hex into buffer, as PointerToHexString does.
+template <typename T>
+inline const char* PointerToHexChars(T const* ptr, HexCharsBuffer& buffer) {
+    return ToHexChars(reinterpret_cast<uintptr_t>(ptr), sizeof(ptr) * 2, buffer);
+}
+
 /// Turns a uint64_t into a string formatted as hex.
 ///
 /// The core of the HandleToHexString implementation is in here.
-inline std::string Uint64ToHexString(uint64_t val) { return to_hex(val); }
+inline std::string Uint64ToHexString(uint64_t val) {
+    HexCharsBuffer buffer;
+    return std::string(Uint64ToHexChars(val, buffer), 2 + 16);
+}
 
 /// Turns a uint32_t into a string formatted as hex.
-inline std::string Uint32ToHexString(uint32_t val) { return to_hex(val); }
+inline std::string Uint32ToHexString(uint32_t val) {
+    HexCharsBuffer buffer;
+    return std::string(Uint32ToHexChars(val, buffer), 2 + 8);
+}
 
 /// Turns an OpenXR handle into a string formatted as hex.
 template <typename T>
 inline std::string HandleToHexString(T handle) {
-    return to_hex(handle);
+    HexCharsBuffer buffer;
+    return std::string(HandleToHexChars(handle, buffer), 2 + sizeof(handle) * 2);
 }
 
 /// Turns a pointer-sized integer into a string formatted as hex.
-inline std::string UintptrToHexString(uintptr_t val) { return to_hex(val); }
+inline std::string UintptrToHexString(uintptr_t val) {
+    HexCharsBuffer buffer;
+    return std::string(ToHexChars(val, sizeof(val) * 2, buffer), 2 + sizeof(val) * 2);
+}
 
 /// Convert a pointer to a string formatted as hex.
 template <typename T>
 inline std::string PointerToHexString(T const* ptr) {
-    return to_hex(ptr);
+    HexCharsBuffer buffer;
+    return std::string(PointerToHexChars(ptr, buffer), 2 + sizeof(ptr) * 2);
 }
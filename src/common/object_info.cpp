@@ -12,7 +12,6 @@
 
 #include "object_info.h"
 
-#include "extra_algorithms.h"
 #include "hex_and_handles.h"
 
 #include <openxr/openxr.h>
@@ -20,19 +19,21 @@
 #include <algorithm>
 #include <iterator>
 #include <memory>
-#include <sstream>
 #include <string>
 #include <vector>
 
 #include "memory.h"
 
 std::string XrSdkLogObjectInfo::ToString() const {
-    std::ostringstream oss;
-    oss << Uint64ToHexString(handle);
+    HexCharsBuffer buffer;
+    std::string result = Uint64ToHexChars(handle, buffer);
     if (!name.empty()) {
-        oss << " (" << name << ")";
+        result.reserve(result.size() + name.size() + 3);
+        result += " (";
+        result += name;
+        result += ")";
     }
-    return oss.str();
+    return result;
 }
 
 void ObjectInfoCollection::AddObjectName(uint64_t object_handle, XrObjectType object_type, const std::string& object_name) {
@@ -43,39 +44,28 @@ void ObjectInfoCollection::AddObjectName(uint64_t object_handle, XrObjectType ob
     }
 
     // Otherwise, add it or update the name
-    XrSdkLogObjectInfo new_obj = {object_handle, object_type};
-
-    // If it already exists, update the name
-    auto lookup_info = LookUpStoredObjectInfo(new_obj);
-    if (lookup_info != nullptr) {
-        lookup_info->name = object_name;
-        return;
-    }
-
-    // It doesn't exist, so add a new info block
-    new_obj.name = object_name;
-    object_info_.push_back(new_obj);
+    XrSdkLogObjectInfo& stored_obj = object_info_[{object_handle, object_type}];
+    stored_obj.handle = object_handle;
+    stored_obj.type = object_type;
+    stored_obj.name = object_name;
 }
 
 void ObjectInfoCollection::RemoveObject(uint64_t object_handle, XrObjectType object_type) {
-    vector_remove_if_and_erase(
-        object_info_, [=](XrSdkLogObjectInfo const& info) { return info.handle == object_handle && info.type == object_type; });
+    object_info_.erase({object_handle, object_type});
 }
 
 XrSdkLogObjectInfo const* ObjectInfoCollection::LookUpStoredObjectInfo(XrSdkLogObjectInfo const& info) const {
-    auto e = object_info_.end();
-    auto it = std::find_if(object_info_.begin(), e, [&](XrSdkLogObjectInfo const& stored) { return Equivalent(stored, info); });
-    if (it != e) {
-        return &(*it);
+    auto it = object_info_.find({info.handle, info.type});
+    if (it != object_info_.end()) {
+        return &it->second;
     }
     return nullptr;
 }
 
 XrSdkLogObjectInfo* ObjectInfoCollection::LookUpStoredObjectInfo(XrSdkLogObjectInfo const& info) {
-    auto e = object_info_.end();
-    auto it = std::find_if(object_info_.begin(), e, [&](XrSdkLogObjectInfo const& stored) { return Equivalent(stored, info); });
-    if (it != e) {
-        return &(*it);
+    auto it = object_info_.find({info.handle, info.type});
+    if (it != object_info_.end()) {
+        return &it->second;
     }
     return nullptr;
 }
@@ -229,11 +219,35 @@ NamesAndLabels DebugUtilsData::PopulateNamesAndLabels(std::vector<XrSdkLogObject
         }
     }
 
-    return {objects, labels};
+    return {std::move(objects), std::move(labels)};
+}
+
+void DebugUtilsData::PopulateNamesAndLabels(std::vector<XrSdkLogObjectInfo> const& objects,
+                                            NamesAndLabels& names_and_labels) const {
+    // Assigning over the existing elements keeps the capacity of their name strings.
+    names_and_labels.sdk_objects.assign(objects.begin(), objects.end());
+    names_and_labels.objects.clear();
+    names_and_labels.labels.clear();
+    for (auto& obj : names_and_labels.sdk_objects) {
+        // Check for any names that have been associated with the objects and set them up here
+        object_info_.LookUpObjectName(obj);
+        // If this is a session, see if there are any labels associated with it for us to add
+        // to the callback content.
+        if (XR_OBJECT_TYPE_SESSION == obj.type) {
+            LookUpSessionLabels(obj.GetTypedHandle<XrSession>(), names_and_labels.labels);
+        }
+    }
+    for (auto const& obj : names_and_labels.sdk_objects) {
+        names_and_labels.objects.push_back(
+            {XR_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT, nullptr, obj.type, obj.handle, obj.name.c_str()});
+    }
 }
 
 void DebugUtilsData::WrapCallbackData(AugmentedCallbackData* aug_data,
                                       const XrDebugUtilsMessengerCallbackDataEXT* callback_data) const {
+    aug_data->labels.clear();
+    aug_data->new_objects.clear();
+
     // If there's nothing to add, just return the original data as the augmented copy
     aug_data->exported_data = callback_data;
     if (object_info_.Empty() || callback_data->objectCount == 0) {
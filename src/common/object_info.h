@@ -19,6 +19,7 @@
 
 #include <openxr/openxr.h>
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -121,7 +122,8 @@ class ObjectInfoCollection {
     //! Find the stored object info, if any.
     //! Return nullptr if not found.
     XrSdkLogObjectInfo const* LookUpStoredObjectInfo(uint64_t handle, XrObjectType type) const {
-        return LookUpStoredObjectInfo({handle, type});
+        auto it = object_info_.find({handle, type});
+        return it != object_info_.end() ? &it->second : nullptr;
     }
 
     //! Find the object name, if any, and update debug utils info accordingly.
@@ -136,8 +138,21 @@ class ObjectInfoCollection {
     bool Empty() const { return object_info_.empty(); }
 
    private:
-    // Object names that have been set for given objects
-    std::vector<XrSdkLogObjectInfo> object_info_;
+    struct ObjectKey {
+        uint64_t handle;
+        XrObjectType type;
+
+        bool operator==(ObjectKey const& other) const { return handle == other.handle && type == other.type; }
+    };
+
+    struct ObjectKeyHash {
+        size_t operator()(ObjectKey const& key) const {
+            return std::hash<uint64_t>()(key.handle ^ (static_cast<uint64_t>(key.type) * 0x9E3779B97F4A7C15ULL));
+        }
+    };
+
+    // Object names that have been set for given objects, indexed by handle and type.
+    std::unordered_map<ObjectKey, XrSdkLogObjectInfo, ObjectKeyHash> object_info_;
 };
 
 struct XrSdkSessionLabel;
@@ -213,6 +228,15 @@ class DebugUtilsData {
     /// Given the collection of objects, populate their names and list of labels
     NamesAndLabels PopulateNamesAndLabels(std::vector<XrSdkLogObjectInfo> objects) const;
 
+    /// @overload
+    ///
+    /// Overwrites the contents of names_and_labels, reusing the capacity of its vectors and strings, so that a
+    /// caller keeping a NamesAndLabels around does not allocate for every message once it has grown large enough.
+    void PopulateNamesAndLabels(std::vector<XrSdkLogObjectInfo> const& objects, NamesAndLabels& names_and_labels) const;
+
+    /// Augments the callback data with object names and session labels, if there are any to add.
+    ///
+    /// Overwrites the contents of aug_data and reuses the capacity of its vectors, like PopulateNamesAndLabels.
     void WrapCallbackData(AugmentedCallbackData* aug_data,
                           const XrDebugUtilsMessengerCallbackDataEXT* provided_callback_data) const;
 
@@ -0,0 +1,82 @@
+// Copyright (c) 2017-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0 OR MIT
+//
+
+/*!
+ * @file
+ *
+ * Zone and frame markers for a system profiler, so that the work of the conformance tests, their graphics plugins and
+ * the conformance layer can be lined up with runtime threads on one timeline.
+ *
+ * XR_TRACE_SCOPE(name) opens a zone, named by a string literal, that lasts until the end of the enclosing block. Use at
+ * most one per block. XR_TRACE_FRAME_MARK(name) marks a frame boundary, named by a string literal.
+ *
+ * Both compile to nothing unless the build defines one of XR_TRACE_TRACY (Tracy), XR_TRACE_ATRACE (Android ATrace,
+ * recorded by Perfetto and systrace) or XR_TRACE_PIX (WinPixEventRuntime, which also reaches ETW), as the CMake option
+ * BUILD_CONFORMANCE_TRACING does for the platform.
+ */
+
+#pragma once
+
+#define XR_TRACE_CONCAT_INNER(a, b) a##b
+#define XR_TRACE_CONCAT(a, b) XR_TRACE_CONCAT_INNER(a, b)
+
+#if defined(XR_TRACE_TRACY)
+
+#include <tracy/Tracy.hpp>
+
+#define XR_TRACE_SCOPE(name) ZoneScopedN(name)
+#define XR_TRACE_FRAME_MARK(name) FrameMarkNamed(name)
+
+#elif defined(XR_TRACE_ATRACE)
+
+#include <android/trace.h>
+
+namespace xr_trace_detail {
+class ATraceScope {
+   public:
+    explicit ATraceScope(const char* name) { ATrace_beginSection(name); }
+    ~ATraceScope() { ATrace_endSection(); }
+
+    ATraceScope(const ATraceScope&) = delete;
+    ATraceScope& operator=(const ATraceScope&) = delete;
+};
+}  // namespace xr_trace_detail
+
+#define XR_TRACE_SCOPE(name) const xr_trace_detail::ATraceScope XR_TRACE_CONCAT(xrTraceScope, __LINE__)(name)
+// ATrace has no frame markers: an empty section shows where each frame ends.
+#define XR_TRACE_FRAME_MARK(name)  \
+    do {                           \
+        ATrace_beginSection(name); \
+        ATrace_endSection();       \
+    } while (false)
+
+#elif defined(XR_TRACE_PIX)
+
+#ifndef USE_PIX
+#define USE_PIX
+#endif
+#include <windows.h>
+#include <pix3.h>
+
+namespace xr_trace_detail {
+class PixScope {
+   public:
+    explicit PixScope(const char* name) { PIXBeginEvent(PIX_COLOR_DEFAULT, name); }
+    ~PixScope() { PIXEndEvent(); }
+
+    PixScope(const PixScope&) = delete;
+    PixScope& operator=(const PixScope&) = delete;
+};
+}  // namespace xr_trace_detail
+
+#define XR_TRACE_SCOPE(name) const xr_trace_detail::PixScope XR_TRACE_CONCAT(xrTraceScope, __LINE__)(name)
+#define XR_TRACE_FRAME_MARK(name) PIXSetMarker(PIX_COLOR_DEFAULT, name)
+
+#else
+
+#define XR_TRACE_SCOPE(name) (void)0
+#define XR_TRACE_FRAME_MARK(name) (void)0
+
+#endif
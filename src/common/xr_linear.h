@@ -101,6 +101,10 @@ inline static void XrMatrix4x4f_InvertRigidBody(XrMatrix4x4f* result, const XrMa
 inline static void XrMatrix4x4f_TransformVector3f(XrVector3f* result, const XrMatrix4x4f* m, const XrVector3f* v);
 inline static void XrMatrix4x4f_TransformVector4f(XrVector4f* result, const XrMatrix4x4f* m, const XrVector4f* v);
 
+inline static void XrMatrix4x4f_TransformVector3fArray(XrVector3f* results, const XrMatrix4x4f* m, const XrVector3f* v, size_t count);
+inline static void XrMatrix4x4f_MultiplyPoseArray(XrMatrix4x4f* results, const XrMatrix4x4f* a, const XrPosef* poses,
+                                                  const XrVector3f* scales, size_t stride, size_t count);
+
 inline static void XrMatrix4x4f_TransformBounds(XrVector3f* resultMins, XrVector3f* resultMaxs, const XrMatrix4x4f* matrix,
                                                 const XrVector3f* mins, const XrVector3f* maxs);
 inline static bool XrMatrix4x4f_CullBounds(const XrMatrix4x4f* mvp, const XrVector3f* mins, const XrVector3f* maxs);
@@ -111,6 +115,17 @@ inline static bool XrMatrix4x4f_CullBounds(const XrMatrix4x4f* mvp, const XrVect
 #include <assert.h>
 #include <math.h>
 #include <stdbool.h>
+#include <stddef.h>
+
+// The matrix multiply and transform functions use SSE or NEON when the target has it.
+// Define XR_LINEAR_NO_SIMD to build the scalar versions everywhere.
+#if !defined(XR_LINEAR_NO_SIMD) && (defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1))
+#define XR_LINEAR_USE_SSE 1
+#include <xmmintrin.h>
+#elif !defined(XR_LINEAR_NO_SIMD) && (defined(__ARM_NEON) || defined(_M_ARM64))
+#define XR_LINEAR_USE_NEON 1
+#include <arm_neon.h>
+#endif
 
 #define MATH_PI 3.14159265358979323846f
 
@@ -133,6 +148,28 @@ struct XrMatrix4x4f {
     float m[16];
 };
 
+#if defined(XR_LINEAR_USE_SSE)
+typedef __m128 XrSimd4f;
+inline static XrSimd4f XrSimd4f_Load(const float* p) { return _mm_loadu_ps(p); }
+inline static void XrSimd4f_Store(float* p, XrSimd4f v) { _mm_storeu_ps(p, v); }
+inline static XrSimd4f XrSimd4f_Splat(const float x) { return _mm_set1_ps(x); }
+inline static XrSimd4f XrSimd4f_Add(XrSimd4f a, XrSimd4f b) { return _mm_add_ps(a, b); }
+inline static XrSimd4f XrSimd4f_Sub(XrSimd4f a, XrSimd4f b) { return _mm_sub_ps(a, b); }
+inline static XrSimd4f XrSimd4f_Mul(XrSimd4f a, XrSimd4f b) { return _mm_mul_ps(a, b); }
+// Returns a * b + c.
+inline static XrSimd4f XrSimd4f_MulAdd(XrSimd4f a, XrSimd4f b, XrSimd4f c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+#elif defined(XR_LINEAR_USE_NEON)
+typedef float32x4_t XrSimd4f;
+inline static XrSimd4f XrSimd4f_Load(const float* p) { return vld1q_f32(p); }
+inline static void XrSimd4f_Store(float* p, XrSimd4f v) { vst1q_f32(p, v); }
+inline static XrSimd4f XrSimd4f_Splat(const float x) { return vdupq_n_f32(x); }
+inline static XrSimd4f XrSimd4f_Add(XrSimd4f a, XrSimd4f b) { return vaddq_f32(a, b); }
+inline static XrSimd4f XrSimd4f_Sub(XrSimd4f a, XrSimd4f b) { return vsubq_f32(a, b); }
+inline static XrSimd4f XrSimd4f_Mul(XrSimd4f a, XrSimd4f b) { return vmulq_f32(a, b); }
+// Returns a * b + c.
+inline static XrSimd4f XrSimd4f_MulAdd(XrSimd4f a, XrSimd4f b, XrSimd4f c) { return vmlaq_f32(c, a, b); }
+#endif
+
 inline static float XrRcpSqrt(const float x) {
     const float SMALLEST_NON_DENORMAL = 1.1754943508222875e-038f;  // ( 1U << 23 )
     const float rcp = (x >= SMALLEST_NON_DENORMAL) ? 1.0f / sqrtf(x) : 1.0f;
@@ -240,6 +277,21 @@ inline static void XrQuaternionf_Multiply(XrQuaternionf* result, const XrQuatern
 
 // Use left-multiplication to accumulate transformations.
 inline static void XrMatrix4x4f_Multiply(XrMatrix4x4f* result, const XrMatrix4x4f* a, const XrMatrix4x4f* b) {
+#if defined(XR_LINEAR_USE_SSE) || defined(XR_LINEAR_USE_NEON)
+    // Each result column is a linear combination of a's columns. All of a is loaded first so result may alias a or b.
+    const XrSimd4f a0 = XrSimd4f_Load(&a->m[0]);
+    const XrSimd4f a1 = XrSimd4f_Load(&a->m[4]);
+    const XrSimd4f a2 = XrSimd4f_Load(&a->m[8]);
+    const XrSimd4f a3 = XrSimd4f_Load(&a->m[12]);
+    for (int c = 0; c < 4; c++) {
+        const float* bc = &b->m[4 * c];
+        XrSimd4f col = XrSimd4f_Mul(a0, XrSimd4f_Splat(bc[0]));
+        col = XrSimd4f_MulAdd(a1, XrSimd4f_Splat(bc[1]), col);
+        col = XrSimd4f_MulAdd(a2, XrSimd4f_Splat(bc[2]), col);
+        col = XrSimd4f_MulAdd(a3, XrSimd4f_Splat(bc[3]), col);
+        XrSimd4f_Store(&result->m[4 * c], col);
+    }
+#else
     result->m[0] = a->m[0] * b->m[0] + a->m[4] * b->m[1] + a->m[8] * b->m[2] + a->m[12] * b->m[3];
     result->m[1] = a->m[1] * b->m[0] + a->m[5] * b->m[1] + a->m[9] * b->m[2] + a->m[13] * b->m[3];
     result->m[2] = a->m[2] * b->m[0] + a->m[6] * b->m[1] + a->m[10] * b->m[2] + a->m[14] * b->m[3];
@@ -259,6 +311,7 @@ inline static void XrMatrix4x4f_Multiply(XrMatrix4x4f* result, const XrMatrix4x4
     result->m[13] = a->m[1] * b->m[12] + a->m[5] * b->m[13] + a->m[9] * b->m[14] + a->m[13] * b->m[15];
     result->m[14] = a->m[2] * b->m[12] + a->m[6] * b->m[13] + a->m[10] * b->m[14] + a->m[14] * b->m[15];
     result->m[15] = a->m[3] * b->m[12] + a->m[7] * b->m[13] + a->m[11] * b->m[14] + a->m[15] * b->m[15];
+#endif
 }
 
 // Creates the transpose of the given matrix.
@@ -295,27 +348,46 @@ inline static float XrMatrix4x4f_Minor(const XrMatrix4x4f* matrix, int r0, int r
 }
 
 // Calculates the inverse of a 4x4 matrix.
+// The cofactors are built from twelve shared 2x2 sub-determinants instead of expanding every 3x3 minor.
 inline static void XrMatrix4x4f_Invert(XrMatrix4x4f* result, const XrMatrix4x4f* src) {
-    const float rcpDet =
-        1.0f / (src->m[0] * XrMatrix4x4f_Minor(src, 1, 2, 3, 1, 2, 3) - src->m[1] * XrMatrix4x4f_Minor(src, 1, 2, 3, 0, 2, 3) +
-                src->m[2] * XrMatrix4x4f_Minor(src, 1, 2, 3, 0, 1, 3) - src->m[3] * XrMatrix4x4f_Minor(src, 1, 2, 3, 0, 1, 2));
-
-    result->m[0] = XrMatrix4x4f_Minor(src, 1, 2, 3, 1, 2, 3) * rcpDet;
-    result->m[1] = -XrMatrix4x4f_Minor(src, 0, 2, 3, 1, 2, 3) * rcpDet;
-    result->m[2] = XrMatrix4x4f_Minor(src, 0, 1, 3, 1, 2, 3) * rcpDet;
-    result->m[3] = -XrMatrix4x4f_Minor(src, 0, 1, 2, 1, 2, 3) * rcpDet;
-    result->m[4] = -XrMatrix4x4f_Minor(src, 1, 2, 3, 0, 2, 3) * rcpDet;
-    result->m[5] = XrMatrix4x4f_Minor(src, 0, 2, 3, 0, 2, 3) * rcpDet;
-    result->m[6] = -XrMatrix4x4f_Minor(src, 0, 1, 3, 0, 2, 3) * rcpDet;
-    result->m[7] = XrMatrix4x4f_Minor(src, 0, 1, 2, 0, 2, 3) * rcpDet;
-    result->m[8] = XrMatrix4x4f_Minor(src, 1, 2, 3, 0, 1, 3) * rcpDet;
-    result->m[9] = -XrMatrix4x4f_Minor(src, 0, 2, 3, 0, 1, 3) * rcpDet;
-    result->m[10] = XrMatrix4x4f_Minor(src, 0, 1, 3, 0, 1, 3) * rcpDet;
-    result->m[11] = -XrMatrix4x4f_Minor(src, 0, 1, 2, 0, 1, 3) * rcpDet;
-    result->m[12] = -XrMatrix4x4f_Minor(src, 1, 2, 3, 0, 1, 2) * rcpDet;
-    result->m[13] = XrMatrix4x4f_Minor(src, 0, 2, 3, 0, 1, 2) * rcpDet;
-    result->m[14] = -XrMatrix4x4f_Minor(src, 0, 1, 3, 0, 1, 2) * rcpDet;
-    result->m[15] = XrMatrix4x4f_Minor(src, 0, 1, 2, 0, 1, 2) * rcpDet;
+    const float* m = src->m;
+    const float m0 = m[0], m1 = m[1], m2 = m[2], m3 = m[3];
+    const float m4 = m[4], m5 = m[5], m6 = m[6], m7 = m[7];
+    const float m8 = m[8], m9 = m[9], m10 = m[10], m11 = m[11];
+    const float m12 = m[12], m13 = m[13], m14 = m[14], m15 = m[15];
+
+    const float s0 = m0 * m5 - m4 * m1;
+    const float s1 = m0 * m6 - m4 * m2;
+    const float s2 = m0 * m7 - m4 * m3;
+    const float s3 = m1 * m6 - m5 * m2;
+    const float s4 = m1 * m7 - m5 * m3;
+    const float s5 = m2 * m7 - m6 * m3;
+
+    const float c5 = m10 * m15 - m14 * m11;
+    const float c4 = m9 * m15 - m13 * m11;
+    const float c3 = m9 * m14 - m13 * m10;
+    const float c2 = m8 * m15 - m12 * m11;
+    const float c1 = m8 * m14 - m12 * m10;
+    const float c0 = m8 * m13 - m12 * m9;
+
+    const float rcpDet = 1.0f / (s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0);
+
+    result->m[0] = (m5 * c5 - m6 * c4 + m7 * c3) * rcpDet;
+    result->m[1] = (-m1 * c5 + m2 * c4 - m3 * c3) * rcpDet;
+    result->m[2] = (m13 * s5 - m14 * s4 + m15 * s3) * rcpDet;
+    result->m[3] = (-m9 * s5 + m10 * s4 - m11 * s3) * rcpDet;
+    result->m[4] = (-m4 * c5 + m6 * c2 - m7 * c1) * rcpDet;
+    result->m[5] = (m0 * c5 - m2 * c2 + m3 * c1) * rcpDet;
+    result->m[6] = (-m12 * s5 + m14 * s2 - m15 * s1) * rcpDet;
+    result->m[7] = (m8 * s5 - m10 * s2 + m11 * s1) * rcpDet;
+    result->m[8] = (m4 * c4 - m5 * c2 + m7 * c0) * rcpDet;
+    result->m[9] = (-m0 * c4 + m1 * c2 - m3 * c0) * rcpDet;
+    result->m[10] = (m12 * s4 - m13 * s2 + m15 * s0) * rcpDet;
+    result->m[11] = (-m8 * s4 + m9 * s2 - m11 * s0) * rcpDet;
+    result->m[12] = (-m4 * c3 + m5 * c1 - m6 * c0) * rcpDet;
+    result->m[13] = (m0 * c3 - m1 * c1 + m2 * c0) * rcpDet;
+    result->m[14] = (-m12 * s3 + m13 * s1 - m14 * s0) * rcpDet;
+    result->m[15] = (m8 * s3 - m9 * s1 + m10 * s0) * rcpDet;
 }
 
 // Calculates the inverse of a rigid body transform.
@@ -455,20 +527,26 @@ inline static void XrMatrix4x4f_CreateFromQuaternion(XrMatrix4x4f* result, const
 }
 
 // Creates a combined translation(rotation(scale(object))) matrix.
+// Same result as multiplying the three matrices, written out since most of the products are zero.
 inline static void XrMatrix4x4f_CreateTranslationRotationScale(XrMatrix4x4f* result, const XrVector3f* translation,
                                                                const XrQuaternionf* rotation, const XrVector3f* scale) {
-    XrMatrix4x4f scaleMatrix;
-    XrMatrix4x4f_CreateScale(&scaleMatrix, scale->x, scale->y, scale->z);
+    XrMatrix4x4f_CreateFromQuaternion(result, rotation);
+
+    result->m[0] *= scale->x;
+    result->m[1] *= scale->x;
+    result->m[2] *= scale->x;
 
-    XrMatrix4x4f rotationMatrix;
-    XrMatrix4x4f_CreateFromQuaternion(&rotationMatrix, rotation);
+    result->m[4] *= scale->y;
+    result->m[5] *= scale->y;
+    result->m[6] *= scale->y;
 
-    XrMatrix4x4f translationMatrix;
-    XrMatrix4x4f_CreateTranslation(&translationMatrix, translation->x, translation->y, translation->z);
+    result->m[8] *= scale->z;
+    result->m[9] *= scale->z;
+    result->m[10] *= scale->z;
 
-    XrMatrix4x4f combinedMatrix;
-    XrMatrix4x4f_Multiply(&combinedMatrix, &rotationMatrix, &scaleMatrix);
-    XrMatrix4x4f_Multiply(result, &translationMatrix, &combinedMatrix);
+    result->m[12] = translation->x;
+    result->m[13] = translation->y;
+    result->m[14] = translation->z;
 }
 
 // Creates a projection matrix based on the specified dimensions.
@@ -688,19 +766,83 @@ inline static void XrMatrix4x4f_GetScale(XrVector3f* result, const XrMatrix4x4f*
 
 // Transforms a 3D vector.
 inline static void XrMatrix4x4f_TransformVector3f(XrVector3f* result, const XrMatrix4x4f* m, const XrVector3f* v) {
+#if defined(XR_LINEAR_USE_SSE) || defined(XR_LINEAR_USE_NEON)
+    XrSimd4f r = XrSimd4f_Load(&m->m[12]);
+    r = XrSimd4f_MulAdd(XrSimd4f_Load(&m->m[0]), XrSimd4f_Splat(v->x), r);
+    r = XrSimd4f_MulAdd(XrSimd4f_Load(&m->m[4]), XrSimd4f_Splat(v->y), r);
+    r = XrSimd4f_MulAdd(XrSimd4f_Load(&m->m[8]), XrSimd4f_Splat(v->z), r);
+    float xyzw[4];
+    XrSimd4f_Store(xyzw, r);
+    const float rcpW = 1.0f / xyzw[3];
+    result->x = xyzw[0] * rcpW;
+    result->y = xyzw[1] * rcpW;
+    result->z = xyzw[2] * rcpW;
+#else
     const float w = m->m[3] * v->x + m->m[7] * v->y + m->m[11] * v->z + m->m[15];
     const float rcpW = 1.0f / w;
     result->x = (m->m[0] * v->x + m->m[4] * v->y + m->m[8] * v->z + m->m[12]) * rcpW;
     result->y = (m->m[1] * v->x + m->m[5] * v->y + m->m[9] * v->z + m->m[13]) * rcpW;
     result->z = (m->m[2] * v->x + m->m[6] * v->y + m->m[10] * v->z + m->m[14]) * rcpW;
+#endif
 }
 
 // Transforms a 4D vector.
 inline static void XrMatrix4x4f_TransformVector4f(XrVector4f* result, const XrMatrix4x4f* m, const XrVector4f* v) {
+#if defined(XR_LINEAR_USE_SSE) || defined(XR_LINEAR_USE_NEON)
+    XrSimd4f r = XrSimd4f_Mul(XrSimd4f_Load(&m->m[0]), XrSimd4f_Splat(v->x));
+    r = XrSimd4f_MulAdd(XrSimd4f_Load(&m->m[4]), XrSimd4f_Splat(v->y), r);
+    r = XrSimd4f_MulAdd(XrSimd4f_Load(&m->m[8]), XrSimd4f_Splat(v->z), r);
+    r = XrSimd4f_MulAdd(XrSimd4f_Load(&m->m[12]), XrSimd4f_Splat(v->w), r);
+    XrSimd4f_Store(&result->x, r);
+#else
     result->x = m->m[0] * v->x + m->m[4] * v->y + m->m[8] * v->z + m->m[12] * v->w;
     result->y = m->m[1] * v->x + m->m[5] * v->y + m->m[9] * v->z + m->m[13] * v->w;
     result->z = m->m[2] * v->x + m->m[6] * v->y + m->m[10] * v->z + m->m[14] * v->w;
     result->w = m->m[3] * v->x + m->m[7] * v->y + m->m[11] * v->z + m->m[15] * v->w;
+#endif
+}
+
+// Transforms an array of 3D vectors.
+inline static void XrMatrix4x4f_TransformVector3fArray(XrVector3f* results, const XrMatrix4x4f* m, const XrVector3f* v, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        XrMatrix4x4f_TransformVector3f(&results[i], m, &v[i]);
+    }
+}
+
+// Sets results[i] to a * translation(rotation(scale(object))) for each of count poses and scales, e.g. a
+// view-projection matrix times each object's model matrix. stride is the distance in bytes from one pose to the
+// next, and from one scale to the next, so both can be read straight out of an array of structs.
+inline static void XrMatrix4x4f_MultiplyPoseArray(XrMatrix4x4f* results, const XrMatrix4x4f* a, const XrPosef* poses,
+                                                  const XrVector3f* scales, size_t stride, size_t count) {
+    const char* posePtr = (const char*)poses;
+    const char* scalePtr = (const char*)scales;
+#if defined(XR_LINEAR_USE_SSE) || defined(XR_LINEAR_USE_NEON)
+    const XrSimd4f a0 = XrSimd4f_Load(&a->m[0]);
+    const XrSimd4f a1 = XrSimd4f_Load(&a->m[4]);
+    const XrSimd4f a2 = XrSimd4f_Load(&a->m[8]);
+    const XrSimd4f a3 = XrSimd4f_Load(&a->m[12]);
+#endif
+    for (size_t i = 0; i < count; i++, posePtr += stride, scalePtr += stride) {
+        const XrPosef* pose = (const XrPosef*)posePtr;
+        XrMatrix4x4f model;
+        XrMatrix4x4f_CreateTranslationRotationScale(&model, &pose->position, &pose->orientation, (const XrVector3f*)scalePtr);
+#if defined(XR_LINEAR_USE_SSE) || defined(XR_LINEAR_USE_NEON)
+        // The model matrix has a last row of (0, 0, 0, 1), so a's last column only contributes to the translation.
+        for (int c = 0; c < 3; c++) {
+            const float* mc = &model.m[4 * c];
+            XrSimd4f col = XrSimd4f_Mul(a0, XrSimd4f_Splat(mc[0]));
+            col = XrSimd4f_MulAdd(a1, XrSimd4f_Splat(mc[1]), col);
+            col = XrSimd4f_MulAdd(a2, XrSimd4f_Splat(mc[2]), col);
+            XrSimd4f_Store(&results[i].m[4 * c], col);
+        }
+        XrSimd4f col = XrSimd4f_MulAdd(a0, XrSimd4f_Splat(model.m[12]), a3);
+        col = XrSimd4f_MulAdd(a1, XrSimd4f_Splat(model.m[13]), col);
+        col = XrSimd4f_MulAdd(a2, XrSimd4f_Splat(model.m[14]), col);
+        XrSimd4f_Store(&results[i].m[12], col);
+#else
+        XrMatrix4x4f_Multiply(&results[i], a, &model);
+#endif
+    }
 }
 
 // Transforms the 'mins' and 'maxs' bounds with the given 'matrix'.
@@ -0,0 +1,140 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "benchmark_statistics.h"
+#include "results_stream.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+
+namespace Conformance
+{
+    namespace
+    {
+        template <typename T>
+        double SortedMedian(const std::vector<T>& sorted)
+        {
+            const size_t n = sorted.size();
+            return n % 2 == 1 ? (double)sorted[n / 2] : ((double)sorted[n / 2 - 1] + (double)sorted[n / 2]) / 2.0;
+        }
+
+        // Nearest-rank, as ReportLatencyPercentiles reports them.
+        double SortedPercentile(const std::vector<int64_t>& sorted, double p)
+        {
+            const size_t rank = (size_t)std::ceil(p / 100.0 * sorted.size());
+            return (double)sorted[std::max<size_t>(rank, 1) - 1];
+        }
+
+        bool ReadJsonNumber(const std::string& line, const char* key, double& value)
+        {
+            const char* c = FindJsonValue(line, key);
+            if (c == nullptr) {
+                return false;
+            }
+            char* end = nullptr;
+            value = strtod(c, &end);
+            return end != c;
+        }
+    }  // namespace
+
+    BenchmarkStatistics ComputeBenchmarkStatistics(std::vector<int64_t>& nanosecondSamples)
+    {
+        std::sort(nanosecondSamples.begin(), nanosecondSamples.end());
+
+        BenchmarkStatistics statistics;
+        const size_t n = nanosecondSamples.size();
+        statistics.count = n;
+        statistics.median = SortedMedian(nanosecondSamples);
+        statistics.p95 = SortedPercentile(nanosecondSamples, 95);
+        statistics.p99 = SortedPercentile(nanosecondSamples, 99);
+
+        std::vector<double> deviations;
+        deviations.reserve(n);
+        for (int64_t sample : nanosecondSamples) {
+            deviations.push_back(std::abs((double)sample - statistics.median));
+        }
+        std::sort(deviations.begin(), deviations.end());
+        statistics.mad = SortedMedian(deviations);
+
+        // The count of samples below the median is binomial(n, 1/2), so the order statistics with ranks n/2 -+ 1.96 sqrt(n)/2
+        // bound it with 95% confidence whatever the distribution. Few samples widen this to the whole range.
+        const double halfWidth = 1.96 * std::sqrt((double)n) / 2.0;
+        const double lowRank = std::floor(n / 2.0 - halfWidth);
+        const double highRank = std::ceil(1.0 + n / 2.0 + halfWidth);
+        statistics.medianLow = (double)nanosecondSamples[(size_t)std::max(lowRank, 1.0) - 1];
+        statistics.medianHigh = (double)nanosecondSamples[(size_t)std::min(highRank, (double)n) - 1];
+        return statistics;
+    }
+
+    bool WriteBenchmarkBaseline(const std::string& path, const std::map<std::string, BenchmarkStatistics>& statisticsByMetric)
+    {
+        std::ofstream file(path, std::ios::out | std::ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+
+        file << "[\n";
+        size_t index = 0;
+        for (const auto& metric : statisticsByMetric) {
+            const BenchmarkStatistics& statistics = metric.second;
+            file << JsonLine()
+                        .Add("metric", metric.first)
+                        .Add("count", static_cast<uint64_t>(statistics.count))
+                        .Add("median", statistics.median)
+                        .Add("p95", statistics.p95)
+                        .Add("p99", statistics.p99)
+                        .Add("mad", statistics.mad)
+                        .Add("medianLow", statistics.medianLow)
+                        .Add("medianHigh", statistics.medianHigh)
+                        .String()
+                 << (++index < statisticsByMetric.size() ? ",\n" : "\n");
+        }
+        file << "]\n";
+        return file.good();
+    }
+
+    bool ReadBenchmarkBaseline(const std::string& path, std::map<std::string, BenchmarkStatistics>& statisticsByMetric)
+    {
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            return false;
+        }
+
+        std::string line;
+        std::string metric;
+        while (std::getline(file, line)) {
+            const char* metricValue = FindJsonValue(line, "metric");
+            if (metricValue == nullptr || !ParseJsonString(metricValue, metric)) {
+                continue;  // The brackets of the array.
+            }
+
+            BenchmarkStatistics statistics;
+            double count = 0;
+            if (!ReadJsonNumber(line, "count", count) || !ReadJsonNumber(line, "median", statistics.median)) {
+                continue;
+            }
+            statistics.count = (size_t)count;
+            ReadJsonNumber(line, "p95", statistics.p95);
+            ReadJsonNumber(line, "p99", statistics.p99);
+            ReadJsonNumber(line, "mad", statistics.mad);
+            ReadJsonNumber(line, "medianLow", statistics.medianLow);
+            ReadJsonNumber(line, "medianHigh", statistics.medianHigh);
+            statisticsByMetric[metric] = statistics;
+        }
+        return true;
+    }
+}  // namespace Conformance
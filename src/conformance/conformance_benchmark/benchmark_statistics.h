@@ -0,0 +1,49 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Conformance
+{
+    // Robust summary of one benchmark metric, in nanoseconds.
+    struct BenchmarkStatistics
+    {
+        size_t count = 0;
+        double median = 0;
+        double p95 = 0;
+        double p99 = 0;
+        // Median absolute deviation from the median, unscaled.
+        double mad = 0;
+        // Distribution-free 95% confidence interval for the median, from the order statistics of the samples.
+        double medianLow = 0;
+        double medianHigh = 0;
+    };
+
+    // Summarizes a set of durations in nanoseconds. Sorts the samples in place; they must not be empty.
+    BenchmarkStatistics ComputeBenchmarkStatistics(std::vector<int64_t>& nanosecondSamples);
+
+    // Writes the statistics of each metric as a JSON array with one object per line.
+    bool WriteBenchmarkBaseline(const std::string& path, const std::map<std::string, BenchmarkStatistics>& statisticsByMetric);
+
+    // Reads a file written by WriteBenchmarkBaseline. Returns false if it could not be opened.
+    bool ReadBenchmarkBaseline(const std::string& path, std::map<std::string, BenchmarkStatistics>& statisticsByMetric);
+}  // namespace Conformance
@@ -0,0 +1,260 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <iostream>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <xr_dependencies.h>
+#include <conformance_test.h>
+#include "benchmark_statistics.h"
+#include "results_stream.h"
+
+#if defined(_WIN32)
+#ifndef ENABLE_VIRTUAL_TERMINAL_PROCESSING
+#define ENABLE_VIRTUAL_TERMINAL_PROCESSING 0x0004
+#endif
+// Favor the high performance NVIDIA or AMD GPUs
+extern "C" {
+// http://developer.download.nvidia.com/devzone/devcenter/gamegraphics/files/OptimusRenderingPolicies.pdf
+_declspec(dllexport) DWORD NvOptimusEnablement = 0x00000001;
+// https://gpuopen.com/learn/amdpowerxpressrequesthighperformance/
+_declspec(dllexport) DWORD AmdPowerXpressRequestHighPerformance = 0x00000001;
+}
+#endif  // defined(_WIN32)
+
+// Runs the [benchmark] test cases of the conformance tests a number of times in this process, pools the samples that
+// each one reports through ReportLatencyPercentiles, and summarizes every metric with robust statistics. A baseline
+// written by an earlier run can be compared against, to fail when a metric has regressed.
+
+namespace
+{
+    using Conformance::BenchmarkStatistics;
+
+    XRAPI_ATTR void XRAPI_CALL OnTestMessage(MessageType type, const char* message)
+    {
+        constexpr const char* ResetColorAndNewLine = "\033[0m\n";
+        switch (type) {
+        case MessageType_Stdout:
+            std::cout << message << std::endl;
+            break;
+        case MessageType_Stderr:
+            std::cerr << message << std::endl;
+            break;
+        case MessageType_AssertionFailed:
+            std::cout << /* Red */ "\033[1;31m" << message << ResetColorAndNewLine;
+            break;
+        case MessageType_TestSectionStarting:
+            std::cout << /* White */ "\033[1;37m" << message << ResetColorAndNewLine;
+            break;
+        }
+    }
+
+    void SetupConsole()
+    {
+#if _WIN32  // Enable ANSI style color escape codes on Windows. Not enabled by default :-(
+        DWORD consoleMode;
+        if (GetConsoleMode(GetStdHandle(STD_OUTPUT_HANDLE), &consoleMode)) {
+            consoleMode |= ENABLE_VIRTUAL_TERMINAL_PROCESSING;
+            SetConsoleMode(GetStdHandle(STD_OUTPUT_HANDLE), consoleMode);
+        }
+#endif
+    }
+
+    struct BenchmarkOptions
+    {
+        uint32_t warmupRuns = 1;
+        uint32_t measuredRuns = 5;
+        std::string select;
+        std::string baselineFile;
+        std::string saveBaselineFile;
+        double thresholdPercent = 10.0;
+    };
+
+    // Adds the [benchmark] tag to each comma separated alternative of a Catch test spec, so that only benchmarks run.
+    std::string BenchmarkTestSpec(const std::string& select)
+    {
+        if (select.empty()) {
+            return "[benchmark]";
+        }
+        std::string spec;
+        size_t start = 0;
+        while (true) {
+            const size_t comma = select.find(',', start);
+            spec += select.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
+            spec += "[benchmark]";
+            if (comma == std::string::npos) {
+                return spec;
+            }
+            spec += ',';
+            start = comma + 1;
+        }
+    }
+
+    void PrintStatistics(const std::string& metric, const BenchmarkStatistics& statistics, const std::vector<double>& runMedians)
+    {
+        const auto minmax = std::minmax_element(runMedians.begin(), runMedians.end());
+        printf("%s\n", metric.c_str());
+        printf("    %zu samples: median %.1fus (95%% CI %.1f-%.1fus), p95 %.1fus, p99 %.1fus, MAD %.1fus, run medians %.1f-%.1fus\n",
+               statistics.count, statistics.median / 1000.0, statistics.medianLow / 1000.0, statistics.medianHigh / 1000.0,
+               statistics.p95 / 1000.0, statistics.p99 / 1000.0, statistics.mad / 1000.0, *minmax.first / 1000.0,
+               *minmax.second / 1000.0);
+    }
+
+    // Returns the number of metrics that have regressed: those whose confidence interval for the median lies wholly
+    // above the baseline median grown by the threshold.
+    size_t CompareWithBaseline(const std::map<std::string, BenchmarkStatistics>& statisticsByMetric,
+                               const std::map<std::string, BenchmarkStatistics>& baseline, double thresholdPercent)
+    {
+        printf("\nComparison with baseline, regression threshold %.1f%%:\n", thresholdPercent);
+        size_t regressionCount = 0;
+        for (const auto& metric : statisticsByMetric) {
+            const auto it = baseline.find(metric.first);
+            if (it == baseline.end()) {
+                printf("    new        %s\n", metric.first.c_str());
+                continue;
+            }
+            const double baselineMedian = it->second.median;
+            const double change = baselineMedian > 0 ? (metric.second.median / baselineMedian - 1.0) * 100.0 : 0.0;
+            const bool regressed = metric.second.medianLow > baselineMedian * (1.0 + thresholdPercent / 100.0);
+            if (regressed) {
+                ++regressionCount;
+            }
+            printf("    %-10s %s: median %.1fus vs %.1fus (%+.1f%%)\n", regressed ? "REGRESSED" : "ok", metric.first.c_str(),
+                   metric.second.median / 1000.0, baselineMedian / 1000.0, change);
+        }
+        for (const auto& metric : baseline) {
+            if (statisticsByMetric.find(metric.first) == statisticsByMetric.end()) {
+                printf("    missing    %s\n", metric.first.c_str());
+            }
+        }
+        return regressionCount;
+    }
+}  // namespace
+
+int main(int argc, const char** argv)
+{
+    SetupConsole();
+
+    // The benchmark options are handled here; everything else is passed through to the conformance tests.
+    BenchmarkOptions options;
+    std::vector<std::string> forwardedArgs;
+    for (int i = 1; i < argc; ++i) {
+        const bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--warmup") == 0 && hasValue) {
+            options.warmupRuns = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--iterations") == 0 && hasValue) {
+            options.measuredRuns = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+            if (options.measuredRuns == 0) {
+                std::cerr << "--iterations must be at least 1" << std::endl;
+                return 2;
+            }
+        }
+        else if (strcmp(argv[i], "--select") == 0 && hasValue) {
+            options.select = argv[++i];
+        }
+        else if (strcmp(argv[i], "--baseline") == 0 && hasValue) {
+            options.baselineFile = argv[++i];
+        }
+        else if (strcmp(argv[i], "--saveBaseline") == 0 && hasValue) {
+            options.saveBaselineFile = argv[++i];
+        }
+        else if (strcmp(argv[i], "--threshold") == 0 && hasValue) {
+            options.thresholdPercent = std::strtod(argv[++i], nullptr);
+        }
+        else {
+            forwardedArgs.push_back(argv[i]);
+        }
+    }
+
+    std::map<std::string, BenchmarkStatistics> baseline;
+    if (!options.baselineFile.empty() && !Conformance::ReadBenchmarkBaseline(options.baselineFile, baseline)) {
+        std::cerr << "Could not open baseline file " << options.baselineFile << std::endl;
+        return 2;
+    }
+
+    const std::string testSpec = BenchmarkTestSpec(options.select);
+    const uint32_t runCount = options.warmupRuns + options.measuredRuns;
+    uint32_t totalFailureCount = 0;
+    std::map<std::string, std::vector<int64_t>> samplesByMetric;
+    std::map<std::string, std::vector<double>> runMediansByMetric;
+    for (uint32_t run = 0; run < runCount; ++run) {
+        const bool warmup = run < options.warmupRuns;
+        printf("\nBenchmark run %u of %u%s\n", run + 1, runCount, warmup ? " (warmup)" : "");
+        fflush(stdout);
+
+        // Each run gets its own results stream, kept for later inspection.
+        const std::string resultsStreamFile = "conformance_benchmark_run_" + std::to_string(run) + ".jsonl";
+        std::vector<const char*> testArgs{argv[0]};
+        for (const std::string& arg : forwardedArgs) {
+            testArgs.push_back(arg.c_str());
+        }
+        testArgs.push_back("--resultsStream");
+        testArgs.push_back(resultsStreamFile.c_str());
+        testArgs.push_back(testSpec.c_str());
+
+        ConformanceLaunchSettings launchSettings;
+        launchSettings.argc = (int)testArgs.size();
+        launchSettings.argv = testArgs.data();
+        launchSettings.message = OnTestMessage;
+
+        uint32_t failureCount = 0;
+        XrcResult result = xrcRunConformanceTests(&launchSettings, &failureCount);
+        if (result != XRC_SUCCESS) {
+            return 2;  // Tests failed to run.
+        }
+        totalFailureCount += failureCount;
+
+        if (warmup) {
+            continue;
+        }
+        std::map<std::string, std::vector<int64_t>> runSamples;
+        if (!Conformance::ReadBenchmarkSamples(resultsStreamFile, runSamples)) {
+            std::cerr << "Could not read results stream file " << resultsStreamFile << std::endl;
+            return 2;
+        }
+        for (auto& metric : runSamples) {
+            std::vector<int64_t>& samples = samplesByMetric[metric.first];
+            samples.insert(samples.end(), metric.second.begin(), metric.second.end());
+            runMediansByMetric[metric.first].push_back(Conformance::ComputeBenchmarkStatistics(metric.second).median);
+        }
+    }
+
+    if (samplesByMetric.empty()) {
+        printf("\nNo benchmark samples were reported by the selected test cases.\n");
+        return totalFailureCount == 0 ? 0 : 1;
+    }
+
+    printf("\nBenchmark results over %u runs after %u warmup runs:\n", options.measuredRuns, options.warmupRuns);
+    std::map<std::string, BenchmarkStatistics> statisticsByMetric;
+    for (auto& metric : samplesByMetric) {
+        statisticsByMetric[metric.first] = Conformance::ComputeBenchmarkStatistics(metric.second);
+        PrintStatistics(metric.first, statisticsByMetric[metric.first], runMediansByMetric[metric.first]);
+    }
+
+    if (!options.saveBaselineFile.empty()) {
+        if (Conformance::WriteBenchmarkBaseline(options.saveBaselineFile, statisticsByMetric)) {
+            printf("\nWrote baseline %s\n", options.saveBaselineFile.c_str());
+        }
+        else {
+            std::cerr << "Could not write baseline file " << options.saveBaselineFile << std::endl;
+            return 2;
+        }
+    }
+
+    size_t regressionCount = 0;
+    if (!options.baselineFile.empty()) {
+        regressionCount = CompareWithBaseline(statisticsByMetric, baseline, options.thresholdPercent);
+    }
+
+    if (totalFailureCount != 0) {
+        return 1;  // Test failures.
+    }
+    return regressionCount == 0 ? 0 : 3;  // Regressions against the baseline.
+}
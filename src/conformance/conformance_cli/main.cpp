@@ -3,10 +3,24 @@
 // SPDX-License-Identifier: Apache-2.0
 
 #include <iostream>
+#include <fstream>
 #include <algorithm>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
 #include <xr_dependencies.h>
 #include <conformance_test.h>
 
+#if !defined(_WIN32)
+#include <errno.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+extern char** environ;
+#endif  // !defined(_WIN32)
+
 #if defined(_WIN32)
 #ifndef ENABLE_VIRTUAL_TERMINAL_PROCESSING
 #define ENABLE_VIRTUAL_TERMINAL_PROCESSING 0x0004
@@ -51,15 +65,252 @@ namespace
         }
 #endif
     }
+
+    // Sharded runs
+    //
+    // With --shards N this executable launches N copies of itself, each running one part of the selected test cases
+    // through --shardCount and --shardIndex, and waits for all of them. Each copy writes its console output to
+    // conformance_shard_<index>.log, which is printed once that copy finishes, followed by the merged test counts.
+    // An -o/--out reporter output file, a --resultsStream file and a --junitStream file get the shard index added before
+    // their extension.
+
+#if defined(_WIN32)
+    typedef PROCESS_INFORMATION ShardProcess;
+
+    // Quotes an argument so that CommandLineToArgvW and the C runtime parse it back unchanged.
+    std::string QuoteArgument(const std::string& arg)
+    {
+        if (!arg.empty() && arg.find_first_of(" \t\"") == std::string::npos) {
+            return arg;
+        }
+
+        std::string quoted = "\"";
+        size_t backslashCount = 0;
+        for (char c : arg) {
+            if (c == '\\') {
+                ++backslashCount;
+                continue;
+            }
+            quoted.append(c == '"' ? backslashCount * 2 + 1 : backslashCount, '\\');
+            backslashCount = 0;
+            quoted += c;
+        }
+        quoted.append(backslashCount * 2, '\\');
+        quoted += '"';
+        return quoted;
+    }
+
+    std::string GetExecutablePath(const char* /* argv0 */)
+    {
+        char path[MAX_PATH];
+        DWORD length = GetModuleFileNameA(nullptr, path, MAX_PATH);
+        return std::string(path, length);
+    }
+
+    bool LaunchShard(const std::string& executable, const std::vector<std::string>& args, const std::string& logPath,
+                     ShardProcess& process)
+    {
+        SECURITY_ATTRIBUTES securityAttributes{sizeof(securityAttributes), nullptr, TRUE};  // The child inherits the log handle.
+        HANDLE log = CreateFileA(logPath.c_str(), GENERIC_WRITE, FILE_SHARE_READ, &securityAttributes, CREATE_ALWAYS,
+                                 FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (log == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+
+        STARTUPINFOA startupInfo{};
+        startupInfo.cb = sizeof(startupInfo);
+        startupInfo.dwFlags = STARTF_USESTDHANDLES;
+        startupInfo.hStdInput = GetStdHandle(STD_INPUT_HANDLE);
+        startupInfo.hStdOutput = log;
+        startupInfo.hStdError = log;
+
+        std::string commandLine = QuoteArgument(executable);
+        for (const std::string& arg : args) {
+            commandLine += ' ';
+            commandLine += QuoteArgument(arg);
+        }
+
+        BOOL created =
+            CreateProcessA(executable.c_str(), &commandLine[0], nullptr, nullptr, TRUE, 0, nullptr, nullptr, &startupInfo, &process);
+        CloseHandle(log);
+        return created != FALSE;
+    }
+
+    // Returns the exit code of the shard, or -1 if it could not be determined.
+    int WaitForShard(ShardProcess& process)
+    {
+        WaitForSingleObject(process.hProcess, INFINITE);
+        DWORD exitCode = 0;
+        BOOL gotExitCode = GetExitCodeProcess(process.hProcess, &exitCode);
+        CloseHandle(process.hThread);
+        CloseHandle(process.hProcess);
+        return gotExitCode ? (int)exitCode : -1;
+    }
+#else
+    typedef pid_t ShardProcess;
+
+    std::string GetExecutablePath(const char* argv0)
+    {
+        return argv0;  // posix_spawnp searches PATH the same way the shell did when there is no slash.
+    }
+
+    bool LaunchShard(const std::string& executable, const std::vector<std::string>& args, const std::string& logPath,
+                     ShardProcess& process)
+    {
+        posix_spawn_file_actions_t fileActions;
+        posix_spawn_file_actions_init(&fileActions);
+        posix_spawn_file_actions_addopen(&fileActions, STDOUT_FILENO, logPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        posix_spawn_file_actions_adddup2(&fileActions, STDOUT_FILENO, STDERR_FILENO);
+
+        std::vector<char*> argv;
+        argv.push_back(const_cast<char*>(executable.c_str()));
+        for (const std::string& arg : args) {
+            argv.push_back(const_cast<char*>(arg.c_str()));
+        }
+        argv.push_back(nullptr);
+
+        int error = posix_spawnp(&process, executable.c_str(), &fileActions, nullptr, argv.data(), environ);
+        posix_spawn_file_actions_destroy(&fileActions);
+        return error == 0;
+    }
+
+    // Returns the exit code of the shard, or -1 if it could not be determined or the shard did not exit normally.
+    int WaitForShard(ShardProcess& process)
+    {
+        int status = 0;
+        while (waitpid(process, &status, 0) < 0) {
+            if (errno != EINTR) {
+                return -1;
+            }
+        }
+        return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+    }
+#endif  // defined(_WIN32)
+
+    // Inserts ".shard<index>" before the extension of a reporter output file name.
+    std::string ShardOutputFilename(const std::string& filename, uint32_t shardIndex)
+    {
+        const std::string suffix = ".shard" + std::to_string(shardIndex);
+        const size_t lastSeparator = filename.find_last_of("/\\");
+        const size_t extension = filename.find_last_of('.');
+        if (extension == std::string::npos || (lastSeparator != std::string::npos && extension < lastSeparator)) {
+            return filename + suffix;
+        }
+        return filename.substr(0, extension) + suffix + filename.substr(extension);
+    }
+
+    // Prints the shard log and adds the test counts from its conformance report.
+    void ReportShardLog(const std::string& logPath, size_t& testSuccessCount, size_t& testFailureCount)
+    {
+        static const std::string successPrefix = "Test Success Count: ";
+        static const std::string failurePrefix = "Test Failure Count: ";
+
+        std::ifstream log(logPath);
+        std::string line;
+        while (std::getline(log, line)) {
+            std::cout << line << '\n';
+            if (line.compare(0, successPrefix.size(), successPrefix) == 0) {
+                testSuccessCount += std::strtoul(line.c_str() + successPrefix.size(), nullptr, 10);
+            }
+            else if (line.compare(0, failurePrefix.size(), failurePrefix) == 0) {
+                testFailureCount += std::strtoul(line.c_str() + failurePrefix.size(), nullptr, 10);
+            }
+        }
+        std::cout.flush();
+    }
+
+    // Returns the exit code for main: 2 if any shard failed to run, 1 if any test failed, otherwise 0.
+    int RunShards(const char* argv0, const std::vector<std::string>& args, uint32_t shardCount)
+    {
+        const std::string executable = GetExecutablePath(argv0);
+
+        std::vector<ShardProcess> processes(shardCount);
+        std::vector<bool> launched(shardCount, false);
+        for (uint32_t shardIndex = 0; shardIndex < shardCount; ++shardIndex) {
+            std::vector<std::string> shardArgs;
+            for (size_t i = 0; i < args.size(); ++i) {
+                shardArgs.push_back(args[i]);
+                if ((args[i] == "-o" || args[i] == "--out" || args[i] == "--resultsStream" ||
+                     args[i] == "--junitStream") && i + 1 < args.size()) {
+                    shardArgs.push_back(ShardOutputFilename(args[++i], shardIndex));
+                }
+            }
+            shardArgs.push_back("--shardCount");
+            shardArgs.push_back(std::to_string(shardCount));
+            shardArgs.push_back("--shardIndex");
+            shardArgs.push_back(std::to_string(shardIndex));
+
+            const std::string logPath = "conformance_shard_" + std::to_string(shardIndex) + ".log";
+            launched[shardIndex] = LaunchShard(executable, shardArgs, logPath, processes[shardIndex]);
+            if (!launched[shardIndex]) {
+                std::cerr << "Failed to launch shard " << shardIndex << " of " << shardCount << std::endl;
+            }
+        }
+
+        int exitCode = 0;
+        size_t testSuccessCount = 0;
+        size_t testFailureCount = 0;
+        for (uint32_t shardIndex = 0; shardIndex < shardCount; ++shardIndex) {
+            if (!launched[shardIndex]) {
+                exitCode = 2;
+                continue;
+            }
+
+            const int shardExitCode = WaitForShard(processes[shardIndex]);
+            std::cout << "Shard " << shardIndex << " of " << shardCount << " finished with exit code " << shardExitCode << std::endl;
+            ReportShardLog("conformance_shard_" + std::to_string(shardIndex) + ".log", testSuccessCount, testFailureCount);
+
+            if (shardExitCode != 0 && shardExitCode != 1) {
+                exitCode = 2;  // Tests failed to run.
+            }
+            else if (shardExitCode == 1 && exitCode == 0) {
+                exitCode = 1;
+            }
+        }
+
+        std::cout << "*********************************************\n"
+                     "Merged Conformance Report ("
+                  << shardCount
+                  << " shards)\n"
+                     "*********************************************\n"
+                  << "Test Success Count: " << testSuccessCount << "\n"
+                  << "Test Failure Count: " << testFailureCount << std::endl;
+        return exitCode;
+    }
 }  // namespace
 
 int main(int argc, const char** argv)
 {
     SetupConsole();
 
+    // --shards is handled here; everything else is passed through to the conformance tests.
+    uint32_t shardCount = 1;
+    std::vector<std::string> forwardedArgs;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--shards") == 0 && i + 1 < argc) {
+            shardCount = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+            if (shardCount == 0) {
+                std::cerr << "--shards must be at least 1" << std::endl;
+                return 2;
+            }
+        }
+        else {
+            forwardedArgs.push_back(argv[i]);
+        }
+    }
+
+    if (shardCount > 1) {
+        return RunShards(argv[0], forwardedArgs, shardCount);
+    }
+
+    std::vector<const char*> testArgs{argv[0]};
+    for (const std::string& arg : forwardedArgs) {
+        testArgs.push_back(arg.c_str());
+    }
+
     ConformanceLaunchSettings launchSettings;
-    launchSettings.argc = argc;
-    launchSettings.argv = argv;
+    launchSettings.argc = (int)testArgs.size();
+    launchSettings.argv = testArgs.data();
     launchSettings.message = OnTestMessage;
 
     uint32_t failureCount = 0;
@@ -27,7 +27,33 @@ namespace action
 
     CustomActionState* GetCustomActionState(XrAction handle)
     {
-        return dynamic_cast<CustomActionState*>(GetActionState(handle)->customState.get());
+        return GetCustomState<CustomActionState>(GetActionState(handle));
+    }
+
+    // The sync state of a session as seen at one moment. The session is the dispatch handle of the xrGetActionState*
+    // calls, so looking it up takes no lock.
+    struct SyncObservation
+    {
+        uint64_t generation;
+        bool syncing;
+    };
+
+    SyncObservation ObserveSync(XrSession session)
+    {
+        const session::CustomSessionState* const sessionState = session::GetCustomSessionState(session);
+        const bool syncing = sessionState->syncsInProgress.load() != 0;
+        return {sessionState->syncGeneration.load(), syncing};
+    }
+
+    // False only if no xrSyncActions overlapped the state query, from before it went down to the runtime until now, and
+    // the action's set was not active in the last sync. A query that raced a sync may have been answered from either.
+    bool CanBeActive(XrSession session, const CustomActionState* action, const SyncObservation& beforeQuery)
+    {
+        const SyncObservation afterQuery = ObserveSync(session);
+        if (beforeQuery.syncing || afterQuery.syncing || beforeQuery.generation != afterQuery.generation) {
+            return true;
+        }
+        return actionset::WasActiveInLastSync(action->actionSet, afterQuery.generation);
     }
 }  // namespace action
 
@@ -42,31 +68,39 @@ XrResult ConformanceHooks::xrCreateAction(XrActionSet actionSet, const XrActionC
     const XrResult result = ConformanceHooksBase::xrCreateAction(actionSet, createInfo, action);
     if (XR_SUCCEEDED(result)) {
         // Tag on the custom action state to the generated handle state.
-        GetActionState(*action)->customState = std::unique_ptr<CustomActionState>(new CustomActionState(createInfo));
+        GetActionState(*action)->customState =
+            std::unique_ptr<CustomActionState>(new CustomActionState(createInfo, actionset::GetCustomActionSetState(actionSet)));
     }
     return result;
 }
 
 XrResult ConformanceHooks::xrGetActionStateBoolean(XrSession session, const XrActionStateGetInfo* getInfo, XrActionStateBoolean* data)
 {
-    VALIDATE_STRUCT_CHAIN(getInfo);
-    VALIDATE_STRUCT_CHAIN(data);
+    SAMPLE_DEEP_VALIDATION();
+    VALIDATE_STRUCT_CHAIN_IF(deepValidation, getInfo);
+    VALIDATE_STRUCT_CHAIN_IF(deepValidation, data);
+    const SyncObservation beforeQuery = ObserveSync(session);
     const XrResult result = ConformanceHooksBase::xrGetActionStateBoolean(session, getInfo, data);
     if (XR_SUCCEEDED(result)) {
         CustomActionState* const actionData = GetCustomActionState(getInfo->action);
         NONCONFORMANT_IF(actionData->type != XR_ACTION_TYPE_BOOLEAN_INPUT, "Expected failure due to action type mismatch");
-        VALIDATE_XRBOOL32(data->isActive);
-        VALIDATE_XRBOOL32(data->currentState);
-        VALIDATE_XRBOOL32(data->changedSinceLastSync);
-
-        if (!data->isActive) {
-            NONCONFORMANT_IF(data->currentState != XR_FALSE, "currentState must be false when isActive is false");
-            NONCONFORMANT_IF(data->changedSinceLastSync != XR_FALSE, "changedSinceLastSync must be false when isActive is false");
-            NONCONFORMANT_IF(data->lastChangeTime != 0, "lastChangeTime must be 0 when isActive is false");
-        }
-        else {
-            NONCONFORMANT_IF(data->changedSinceLastSync && data->lastChangeTime == 0,
-                             "lastChangeTime must be non-0 when changedSinceLastSync is true");
+
+        if (deepValidation) {
+            VALIDATE_XRBOOL32(data->isActive);
+            NONCONFORMANT_IF(data->isActive && !CanBeActive(session, actionData, beforeQuery),
+                             "isActive must be false when the action set was not active in the last successful xrSyncActions");
+            VALIDATE_XRBOOL32(data->currentState);
+            VALIDATE_XRBOOL32(data->changedSinceLastSync);
+
+            if (!data->isActive) {
+                NONCONFORMANT_IF(data->currentState != XR_FALSE, "currentState must be false when isActive is false");
+                NONCONFORMANT_IF(data->changedSinceLastSync != XR_FALSE, "changedSinceLastSync must be false when isActive is false");
+                NONCONFORMANT_IF(data->lastChangeTime != 0, "lastChangeTime must be 0 when isActive is false");
+            }
+            else {
+                NONCONFORMANT_IF(data->changedSinceLastSync && data->lastChangeTime == 0,
+                                 "lastChangeTime must be non-0 when changedSinceLastSync is true");
+            }
         }
     }
     return result;
@@ -74,25 +108,33 @@ XrResult ConformanceHooks::xrGetActionStateBoolean(XrSession session, const XrAc
 
 XrResult ConformanceHooks::xrGetActionStateFloat(XrSession session, const XrActionStateGetInfo* getInfo, XrActionStateFloat* data)
 {
-    VALIDATE_STRUCT_CHAIN(getInfo);
-    VALIDATE_STRUCT_CHAIN(data);
+    SAMPLE_DEEP_VALIDATION();
+    VALIDATE_STRUCT_CHAIN_IF(deepValidation, getInfo);
+    VALIDATE_STRUCT_CHAIN_IF(deepValidation, data);
+    const SyncObservation beforeQuery = ObserveSync(session);
     const XrResult result = ConformanceHooksBase::xrGetActionStateFloat(session, getInfo, data);
     if (XR_SUCCEEDED(result)) {
         CustomActionState* const actionData = GetCustomActionState(getInfo->action);
         NONCONFORMANT_IF(actionData->type != XR_ACTION_TYPE_FLOAT_INPUT, "Expected failure due to action type mismatch");
-        VALIDATE_XRBOOL32(data->isActive);
-        VALIDATE_XRBOOL32(data->changedSinceLastSync);
-        VALIDATE_FLOAT(data->currentState, -1.0, +1.0);  // TODO: This could be more strict depending on suggested bindings being used (0.0
-                                                         // to 1.0). Not sure if this is possible though.
-
-        if (!data->isActive) {
-            NONCONFORMANT_IF(data->currentState != 0.0f, "currentState must be 0 when isActive is false");
-            NONCONFORMANT_IF(data->changedSinceLastSync != XR_FALSE, "changedSinceLastSync must be false when isActive is false");
-            NONCONFORMANT_IF(data->lastChangeTime != 0, "lastChangeTime must be 0 when isActive is false");
-        }
-        else {
-            NONCONFORMANT_IF(data->changedSinceLastSync && data->lastChangeTime == 0,
-                             "lastChangeTime must be non-0 when changedSinceLastSync is true");
+
+        if (deepValidation) {
+            VALIDATE_XRBOOL32(data->isActive);
+            NONCONFORMANT_IF(data->isActive && !CanBeActive(session, actionData, beforeQuery),
+                             "isActive must be false when the action set was not active in the last successful xrSyncActions");
+            VALIDATE_XRBOOL32(data->changedSinceLastSync);
+            // TODO: This could be more strict depending on suggested bindings being used (0.0 to 1.0). Not sure if this is
+            // possible though.
+            VALIDATE_FLOAT(data->currentState, -1.0, +1.0);
+
+            if (!data->isActive) {
+                NONCONFORMANT_IF(data->currentState != 0.0f, "currentState must be 0 when isActive is false");
+                NONCONFORMANT_IF(data->changedSinceLastSync != XR_FALSE, "changedSinceLastSync must be false when isActive is false");
+                NONCONFORMANT_IF(data->lastChangeTime != 0, "lastChangeTime must be 0 when isActive is false");
+            }
+            else {
+                NONCONFORMANT_IF(data->changedSinceLastSync && data->lastChangeTime == 0,
+                                 "lastChangeTime must be non-0 when changedSinceLastSync is true");
+            }
         }
     }
     return result;
@@ -100,27 +142,34 @@ XrResult ConformanceHooks::xrGetActionStateFloat(XrSession session, const XrActi
 
 XrResult ConformanceHooks::xrGetActionStateVector2f(XrSession session, const XrActionStateGetInfo* getInfo, XrActionStateVector2f* data)
 {
-    VALIDATE_STRUCT_CHAIN(getInfo);
-    VALIDATE_STRUCT_CHAIN(data);
+    SAMPLE_DEEP_VALIDATION();
+    VALIDATE_STRUCT_CHAIN_IF(deepValidation, getInfo);
+    VALIDATE_STRUCT_CHAIN_IF(deepValidation, data);
+    const SyncObservation beforeQuery = ObserveSync(session);
     const XrResult result = ConformanceHooksBase::xrGetActionStateVector2f(session, getInfo, data);
     if (XR_SUCCEEDED(result)) {
         CustomActionState* const actionData = GetCustomActionState(getInfo->action);
         NONCONFORMANT_IF(actionData->type != XR_ACTION_TYPE_VECTOR2F_INPUT, "Expected failure due to action type mismatch");
-        VALIDATE_XRBOOL32(data->isActive);
-        VALIDATE_XRBOOL32(data->changedSinceLastSync);
-        VALIDATE_XRTIME(data->lastChangeTime);
-        VALIDATE_FLOAT(data->currentState.x, -1.0, +1.0);
-        VALIDATE_FLOAT(data->currentState.y, -1.0, +1.0);
-
-        if (!data->isActive) {
-            NONCONFORMANT_IF(data->currentState.x != 0, "currentState.x must be 0 when isActive is false");
-            NONCONFORMANT_IF(data->currentState.y != 0, "currentState.y must be 0 when isActive is false");
-            NONCONFORMANT_IF(data->changedSinceLastSync != XR_FALSE, "changedSinceLastSync must be false when isActive is false");
-            NONCONFORMANT_IF(data->lastChangeTime != 0, "lastChangeTime must be 0 when isActive is false");
-        }
-        else {
-            NONCONFORMANT_IF(data->changedSinceLastSync && data->lastChangeTime == 0,
-                             "lastChangeTime must be non-0 when changedSinceLastSync is true");
+
+        if (deepValidation) {
+            VALIDATE_XRBOOL32(data->isActive);
+            NONCONFORMANT_IF(data->isActive && !CanBeActive(session, actionData, beforeQuery),
+                             "isActive must be false when the action set was not active in the last successful xrSyncActions");
+            VALIDATE_XRBOOL32(data->changedSinceLastSync);
+            VALIDATE_XRTIME(data->lastChangeTime);
+            VALIDATE_FLOAT(data->currentState.x, -1.0, +1.0);
+            VALIDATE_FLOAT(data->currentState.y, -1.0, +1.0);
+
+            if (!data->isActive) {
+                NONCONFORMANT_IF(data->currentState.x != 0, "currentState.x must be 0 when isActive is false");
+                NONCONFORMANT_IF(data->currentState.y != 0, "currentState.y must be 0 when isActive is false");
+                NONCONFORMANT_IF(data->changedSinceLastSync != XR_FALSE, "changedSinceLastSync must be false when isActive is false");
+                NONCONFORMANT_IF(data->lastChangeTime != 0, "lastChangeTime must be 0 when isActive is false");
+            }
+            else {
+                NONCONFORMANT_IF(data->changedSinceLastSync && data->lastChangeTime == 0,
+                                 "lastChangeTime must be non-0 when changedSinceLastSync is true");
+            }
         }
     }
     return result;
@@ -128,14 +177,21 @@ XrResult ConformanceHooks::xrGetActionStateVector2f(XrSession session, const XrA
 
 XrResult ConformanceHooks::xrGetActionStatePose(XrSession session, const XrActionStateGetInfo* getInfo, XrActionStatePose* data)
 {
-    VALIDATE_STRUCT_CHAIN(getInfo);
-    VALIDATE_STRUCT_CHAIN(data);
+    SAMPLE_DEEP_VALIDATION();
+    VALIDATE_STRUCT_CHAIN_IF(deepValidation, getInfo);
+    VALIDATE_STRUCT_CHAIN_IF(deepValidation, data);
+    const SyncObservation beforeQuery = ObserveSync(session);
     const XrResult result = ConformanceHooksBase::xrGetActionStatePose(session, getInfo, data);
     if (XR_SUCCEEDED(result)) {
         CustomActionState* const actionData = GetCustomActionState(getInfo->action);
         NONCONFORMANT_IF(actionData->type != XR_ACTION_TYPE_POSE_INPUT, "Unexpected success with action handle type %s",
                          (int)actionData->type);
-        VALIDATE_XRBOOL32(data->isActive);
+
+        if (deepValidation) {
+            VALIDATE_XRBOOL32(data->isActive);
+            NONCONFORMANT_IF(data->isActive && !CanBeActive(session, actionData, beforeQuery),
+                             "isActive must be false when the action set was not active in the last successful xrSyncActions");
+        }
     }
     return result;
 }
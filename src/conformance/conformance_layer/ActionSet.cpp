@@ -27,19 +27,20 @@ namespace actionset
 
     CustomActionSetState* GetCustomActionSetState(XrActionSet handle)
     {
-        return dynamic_cast<CustomActionSetState*>(GetActionSetState(handle)->customState.get());
+        return GetCustomState<CustomActionSetState>(GetActionSetState(handle));
     }
 
-    void OnSyncActionData(XrResult syncResult, const XrActiveActionSet* activeActionSet)
+    void OnSyncActionData(XrResult syncResult, const XrActiveActionSet* activeActionSet, uint64_t syncGeneration)
     {
         CustomActionSetState* const actionSet = GetCustomActionSetState(activeActionSet->actionSet);
 
-        std::unique_lock<std::mutex> lock(actionSet->mutex);
         if (syncResult == XR_SESSION_NOT_FOCUSED) {
-            actionSet->lastSyncResult = SyncResult::NotFocused;
+            actionSet->lastSyncResult.store(SyncResult::NotFocused, std::memory_order_relaxed);
+            actionSet->lastSyncGeneration.store(syncGeneration, std::memory_order_release);
         }
         else if (syncResult == XR_SUCCESS) {
-            actionSet->lastSyncResult = SyncResult::Synced;
+            actionSet->lastSyncResult.store(SyncResult::Synced, std::memory_order_relaxed);
+            actionSet->lastSyncGeneration.store(syncGeneration, std::memory_order_release);
         }
         else if (XR_SUCCEEDED(syncResult)) {
             // e.g. XR_SESSION_LOSS_PENDING
@@ -49,6 +50,18 @@ namespace actionset
             // In case of failure, assume xrSyncActionData was no-op.
         }
     }
+
+    bool WasActiveInLastSync(const CustomActionSetState* actionSet, uint64_t sessionSyncGeneration)
+    {
+        const uint64_t setSyncGeneration = actionSet->lastSyncGeneration.load(std::memory_order_acquire);
+        if (setSyncGeneration > sessionSyncGeneration) {
+            // An xrSyncActions on another thread has stamped this set but not yet published its generation, so the
+            // runtime may have answered from either sync. Only a set that is definitely older can be ruled out.
+            return true;
+        }
+        return setSyncGeneration == sessionSyncGeneration &&
+               actionSet->lastSyncResult.load(std::memory_order_relaxed) == SyncResult::Synced;
+    }
 }  // namespace actionset
 
 /////////////////
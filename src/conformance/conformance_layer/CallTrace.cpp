@@ -0,0 +1,271 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "CallTrace.h"
+
+#include "call_trace_format.h"
+#include "xr_dependencies.h"
+#include "platform_utils.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+
+#if !defined(XR_USE_PLATFORM_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    constexpr const char* CallTraceEnvVar = "XR_CONFORMANCE_LAYER_TRACE";
+    constexpr const char* CallTraceSizeEnvVar = "XR_CONFORMANCE_LAYER_TRACE_SIZE_MB";
+
+    using CallTraceFormat::FunctionNameSize;
+    using CallTraceFormat::HeaderSize;
+    using CallTraceFormat::MaxFunctions;
+    using CallTraceFormat::RecordsOffset;
+    using TraceRecord = CallTraceFormat::Record;
+
+    // Records a thread reserves at a time. The ring capacity is a multiple of it, so a block never wraps.
+    constexpr uint64_t BlockRecords = 256;
+
+    // The header as laid out in call_trace_format.h.
+    struct TraceHeader
+    {
+        char magic[CallTraceFormat::MagicSize];
+        uint32_t version;
+        uint32_t recordSize;
+        uint64_t recordCapacity;
+        uint32_t functionCount;
+        std::atomic<uint32_t> threadCount;
+        int64_t steadyStartNs;
+        int64_t systemStartNs;
+        std::atomic<uint64_t> recordsReserved;
+    };
+    static_assert(sizeof(TraceHeader) <= HeaderSize, "TraceHeader does not fit");
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) && sizeof(std::atomic<uint64_t>) == sizeof(uint64_t),
+                  "atomics must be usable in the mapped file");
+    static_assert(offsetof(TraceHeader, version) == CallTraceFormat::VersionOffset &&
+                      offsetof(TraceHeader, recordSize) == CallTraceFormat::RecordSizeOffset &&
+                      offsetof(TraceHeader, recordCapacity) == CallTraceFormat::RecordCapacityOffset &&
+                      offsetof(TraceHeader, functionCount) == CallTraceFormat::FunctionCountOffset &&
+                      offsetof(TraceHeader, threadCount) == CallTraceFormat::ThreadCountOffset &&
+                      offsetof(TraceHeader, steadyStartNs) == CallTraceFormat::SteadyStartOffset &&
+                      offsetof(TraceHeader, systemStartNs) == CallTraceFormat::SystemStartOffset &&
+                      offsetof(TraceHeader, recordsReserved) == CallTraceFormat::RecordsReservedOffset,
+                  "TraceHeader does not match call_trace_format.h");
+
+    class TraceFile
+    {
+    public:
+        TraceFile()
+        {
+            const std::string path = PlatformUtilsGetEnv(CallTraceEnvVar);
+            if (path.empty()) {
+                return;
+            }
+
+            uint64_t sizeMb = 64;
+            const std::string sizeValue = PlatformUtilsGetEnv(CallTraceSizeEnvVar);
+            if (!sizeValue.empty() && std::strtoull(sizeValue.c_str(), nullptr, 10) > 0) {
+                sizeMb = std::strtoull(sizeValue.c_str(), nullptr, 10);
+            }
+            const uint64_t blocks = ((sizeMb << 20) - RecordsOffset) / (BlockRecords * sizeof(TraceRecord));
+            m_capacity = (blocks > 0 ? blocks : 1) * BlockRecords;
+            m_size = (size_t)(RecordsOffset + m_capacity * sizeof(TraceRecord));
+
+            if (!Map(path)) {
+                std::cerr << "Unable to map " << CallTraceEnvVar << " file '" << path << "'" << std::endl;
+                m_base = nullptr;
+                return;
+            }
+
+            // The file is freshly sized, so everything not set here reads as zero.
+            std::memset(m_base, 0, (size_t)RecordsOffset);
+            TraceHeader* const header = Header();
+            std::memcpy(header->magic, CallTraceFormat::Magic, CallTraceFormat::MagicSize);
+            header->version = CallTraceFormat::Version;
+            header->recordSize = sizeof(TraceRecord);
+            header->recordCapacity = m_capacity;
+            header->steadyStartNs = ToNs(std::chrono::steady_clock::now());
+            header->systemStartNs = ToNs(std::chrono::system_clock::now());
+            header->threadCount.store(0, std::memory_order_relaxed);
+            header->recordsReserved.store(0, std::memory_order_relaxed);
+        }
+
+        bool Enabled() const
+        {
+            return m_base != nullptr;
+        }
+
+        TraceHeader* Header() const
+        {
+            return reinterpret_cast<TraceHeader*>(m_base);
+        }
+
+        char* FunctionName(uint32_t id) const
+        {
+            return m_base + HeaderSize + id * FunctionNameSize;
+        }
+
+        TraceRecord* Records() const
+        {
+            return reinterpret_cast<TraceRecord*>(m_base + RecordsOffset);
+        }
+
+        uint64_t Capacity() const
+        {
+            return m_capacity;
+        }
+
+        void Flush()
+        {
+#if defined(XR_USE_PLATFORM_WIN32)
+            ::FlushViewOfFile(m_base, 0);
+#else
+            ::msync(m_base, m_size, MS_ASYNC);
+#endif
+        }
+
+        template <typename TimePoint>
+        static int64_t ToNs(TimePoint time)
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+        }
+
+        std::mutex registrationMutex;
+
+    private:
+        // The mapping is never unmapped: calls may still be recorded while statics are destroyed, and the operating
+        // system writes the pages back when the process exits.
+        bool Map(const std::string& path)
+        {
+#if defined(XR_USE_PLATFORM_WIN32)
+            const HANDLE file = ::CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS,
+                                              FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (file == INVALID_HANDLE_VALUE) {
+                return false;
+            }
+            const HANDLE mapping = ::CreateFileMappingA(file, nullptr, PAGE_READWRITE, (DWORD)((uint64_t)m_size >> 32),
+                                                        (DWORD)(m_size & 0xffffffff), nullptr);
+            ::CloseHandle(file);
+            if (mapping == nullptr) {
+                return false;
+            }
+            m_base = static_cast<char*>(::MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, m_size));
+            ::CloseHandle(mapping);
+            return m_base != nullptr;
+#else
+            const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+            if (fd < 0) {
+                return false;
+            }
+            if (::ftruncate(fd, (off_t)m_size) != 0) {
+                ::close(fd);
+                return false;
+            }
+            void* const mapped = ::mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if (mapped == MAP_FAILED) {
+                return false;
+            }
+            m_base = static_cast<char*>(mapped);
+            return true;
+#endif
+        }
+
+        char* m_base{nullptr};
+        size_t m_size{0};
+        uint64_t m_capacity{0};
+    };
+
+    TraceFile& GetTraceFile()
+    {
+        static TraceFile* traceFile = new TraceFile();  // Leaked on purpose, see TraceFile::Map.
+        return *traceFile;
+    }
+
+    // The block of the ring the calling thread is filling.
+    struct ThreadBlock
+    {
+        uint32_t threadIndex{0};
+        uint64_t next{0};
+        uint64_t end{0};
+    };
+}  // namespace
+
+bool IsCallTraceEnabled()
+{
+    static const bool enabled = GetTraceFile().Enabled();
+    return enabled;
+}
+
+CallTraceFunctionId RegisterCallTraceFunction(const char* functionName)
+{
+    if (!IsCallTraceEnabled()) {
+        return 0;
+    }
+
+    TraceFile& traceFile = GetTraceFile();
+    std::unique_lock<std::mutex> lock(traceFile.registrationMutex);
+    TraceHeader* const header = traceFile.Header();
+    if (header->functionCount == MaxFunctions) {
+        return MaxFunctions - 1;  // Unreachable with today's API; shares the last name rather than failing.
+    }
+    const uint32_t id = header->functionCount++;
+    std::strncpy(traceFile.FunctionName(id), functionName, FunctionNameSize - 1);
+    return (CallTraceFunctionId)id;
+}
+
+void RecordCall(CallTraceFunctionId id, uint64_t handle, XrResult result, std::chrono::steady_clock::time_point start,
+                std::chrono::steady_clock::time_point end)
+{
+    TraceFile& traceFile = GetTraceFile();
+    TraceHeader* const header = traceFile.Header();
+
+    thread_local ThreadBlock block;
+    if (block.next == block.end) {
+        if (block.threadIndex == 0) {
+            block.threadIndex = header->threadCount.fetch_add(1, std::memory_order_relaxed) + 1;
+        }
+        block.next = header->recordsReserved.fetch_add(BlockRecords, std::memory_order_relaxed);
+        block.end = block.next + BlockRecords;
+    }
+
+    TraceRecord& record = traceFile.Records()[block.next++ % traceFile.Capacity()];
+    const int64_t startNs = TraceFile::ToNs(start);
+    const int64_t durationNs = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    record.startNs = startNs != 0 ? startNs : 1;
+    record.handle = handle;
+    record.result = (int32_t)result;
+    record.durationNs = durationNs < 0 ? 0 : durationNs > 0xffffffffll ? 0xffffffffu : (uint32_t)durationNs;
+    record.threadIndex = block.threadIndex;
+    record.functionId = id;
+    record.reserved = 0;
+}
+
+void FlushCallTrace()
+{
+    if (IsCallTraceEnabled()) {
+        GetTraceFile().Flush();
+    }
+}
@@ -0,0 +1,71 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <openxr/openxr.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Optional binary trace of every call through the layer. Enabled by setting the XR_CONFORMANCE_LAYER_TRACE environment
+// variable to the path of a trace file; XR_CONFORMANCE_LAYER_TRACE_SIZE_MB sets its size (default 64). The file is
+// memory mapped and used as a ring, so it always holds the most recent calls, and whatever was written survives a crash
+// of the process. Decode it with decode_call_trace.py.
+//
+// Each thread reserves blocks of records in the ring with a single atomic add and fills them in without locks.
+using CallTraceFunctionId = uint16_t;
+
+bool IsCallTraceEnabled();
+
+// Returns the id to record calls of functionName under. Called once per entry point, from a function-local static.
+CallTraceFunctionId RegisterCallTraceFunction(const char* functionName);
+
+void RecordCall(CallTraceFunctionId id, uint64_t handle, XrResult result, std::chrono::steady_clock::time_point start,
+                std::chrono::steady_clock::time_point end);
+
+// Flushes the trace file to disk. Does nothing if tracing is disabled.
+void FlushCallTrace();
+
+// Times the enclosing call and records it with the result passed to Finish, if tracing is enabled.
+class ScopedCallTrace
+{
+public:
+    ScopedCallTrace(CallTraceFunctionId id, uint64_t handle) : m_id(id), m_handle(handle), m_enabled(IsCallTraceEnabled())
+    {
+        if (m_enabled) {
+            m_start = std::chrono::steady_clock::now();
+        }
+    }
+
+    XrResult Finish(XrResult result) const
+    {
+        if (m_enabled) {
+            RecordCall(m_id, m_handle, result, m_start, std::chrono::steady_clock::now());
+        }
+        return result;
+    }
+
+    ScopedCallTrace(const ScopedCallTrace&) = delete;
+    ScopedCallTrace& operator=(const ScopedCallTrace&) = delete;
+
+private:
+    const CallTraceFunctionId m_id;
+    const uint64_t m_handle;
+    const bool m_enabled;
+    std::chrono::steady_clock::time_point m_start{};
+};
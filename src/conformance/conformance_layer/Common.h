@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include <atomic>
+#include <memory>
 #include <mutex>
 #include <unordered_set>
 #include <unordered_map>
@@ -37,6 +39,8 @@
 
 #include <xr_generated_dispatch_table.h>
 
+#include "ScratchArena.h"
+
 // Macro to generate stringify functions for OpenXR enumerations based data provided in openxr_reflection.h
 // clang-format off
 #define ENUM_CASE_STR(name, val) case name: return #name;
@@ -62,11 +66,64 @@ void ForEachExtension(const void* next, TCallback callback)
     }
 }
 
+namespace detail
+{
+// The bits of a value of up to 8 bytes, mixed with the splitmix64 finalizer so that neighbouring enumerants and
+// handles spread over the table.
+template <typename T>
+uint64_t DuplicateHash(const T& value)
+{
+    uint64_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(T));
+    bits = (bits ^ (bits >> 30)) * 0xbf58476d1ce4e5b9ull;
+    bits = (bits ^ (bits >> 27)) * 0x94d049bb133111ebull;
+    return bits ^ (bits >> 31);
+}
+}  // namespace detail
+
+/// Returns true if any two of the values are equal. Short arrays are sorted in a copy on the stack; longer ones are
+/// inserted into an open-addressing hash set in the thread's ScratchArena, so neither allocates from the heap.
+template <typename T>
+bool ContainsDuplicates(const T* values, size_t count)
+{
+    static_assert(std::is_trivially_copyable<T>::value && sizeof(T) <= sizeof(uint64_t),
+                  "Values are hashed by their bits, so must be plain values of up to 8 bytes");
+
+    constexpr size_t SmallCount = 16;
+    if (count <= SmallCount) {
+        T sorted[SmallCount];
+        std::copy(values, values + count, sorted);
+        std::sort(sorted, sorted + count);
+        return std::adjacent_find(sorted, sorted + count) != sorted + count;
+    }
+
+    // A power of two at least twice the count keeps probe sequences short.
+    size_t capacity = 2 * SmallCount;
+    while (capacity < 2 * count) {
+        capacity *= 2;
+    }
+    ScratchScope scratch;
+    T* slots = scratch.Arena().Allocate<T>(capacity);
+    bool* used = scratch.Arena().Allocate<bool>(capacity);
+    std::fill(used, used + capacity, false);
+
+    for (const T* value = values; value != values + count; ++value) {
+        size_t slot = size_t(detail::DuplicateHash(*value)) & (capacity - 1);
+        for (; used[slot]; slot = (slot + 1) & (capacity - 1)) {
+            if (slots[slot] == *value) {
+                return true;
+            }
+        }
+        used[slot] = true;
+        slots[slot] = *value;
+    }
+    return false;
+}
+
 template <typename T>
 bool ContainsDuplicates(const std::vector<T>& collection)
 {
-    std::set<T> unique(collection.begin(), collection.end());
-    return unique.size() != collection.size();
+    return ContainsDuplicates(collection.data(), collection.size());
 }
 
 inline bool IsValidXrBool32(XrBool32 value)
@@ -74,37 +131,46 @@ inline bool IsValidXrBool32(XrBool32 value)
     return value == XR_TRUE || value == XR_FALSE;
 }
 
+constexpr float UnitQuaternionTolerance = 0.000001f;
+
 inline bool IsUnitQuaternion(const XrQuaternionf& q, float* length)
 {
     *length = std::sqrt(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
-    return std::abs(1 - *length) < 0.000001f;
+    return std::abs(1 - *length) < UnitQuaternionTolerance;
 }
 
+/// Answers questions about an array of values, such as the output of an enumeration call. The values are sorted into
+/// a copy taken from the thread's ScratchArena, so inspecting does not allocate from the heap.
 template <typename T>
 class VectorInspection
 {
 public:
     using VectorType = std::vector<T>;
-    VectorInspection(VectorType const& currentVector) : currentVector_(currentVector)
+    VectorInspection(const T* values, size_t count)
+        : sorted_(ScratchArena::ForThisThread().Allocate<T>(count)), sortedEnd_(sorted_ + count)
+    {
+        std::copy(values, values + count, sorted_);
+        std::sort(sorted_, sortedEnd_);
+    }
+
+    VectorInspection(VectorType const& currentVector) : VectorInspection(currentVector.data(), currentVector.size())
     {
-        std::copy(currentVector_.begin(), currentVector_.end(), std::inserter(currentElements_, currentElements_.begin()));
     }
 
     bool ContainsDuplicates() const
     {
-        return currentVector_.size() != currentElements_.size();
+        return std::adjacent_find(sorted_, sortedEnd_) != sortedEnd_;
     }
 
     bool ContainsValue(T const& elt) const
     {
-        auto it = currentElements_.find(elt);
-        return it != currentElements_.end();
+        return std::binary_search(sorted_, sortedEnd_, elt);
     }
 
     /// Compares the contents of vectors, ignoring order of elements.
     bool SameElementsAs(VectorType const& prevVector) const
     {
-        if (currentVector_.size() != prevVector.size()) {
+        if (size_t(sortedEnd_ - sorted_) != prevVector.size()) {
             return false;
         }
         for (const auto& elt : prevVector) {
@@ -119,8 +185,8 @@ public:
     {
         auto b = known.begin();
         auto e = known.end();
-        for (const auto& elt : currentElements_) {
-            auto it = std::find(b, e, elt);
+        for (const T* elt = sorted_; elt != sortedEnd_; ++elt) {
+            auto it = std::find(b, e, *elt);
             if (it == e) {
                 // current vec contains an element not found in the provided list
                 return true;
@@ -130,7 +196,6 @@ public:
     }
 
 private:
-    using SetType = std::set<T>;
-    VectorType const& currentVector_;
-    SetType currentElements_;
+    T* const sorted_;
+    T* const sortedEnd_;
 };
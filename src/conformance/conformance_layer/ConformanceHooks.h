@@ -17,6 +17,7 @@
 #pragma once
 
 #include "gen_dispatch.h"
+#include "FailureLimiter.h"
 
 // Implementation of methods are distributed across multiple files, based on the primary handle type.
 // IConformanceHooks provides empty default implementations of all OpenXR functions. Only provide an override
@@ -33,11 +34,14 @@ struct ConformanceHooks : ConformanceHooksBase
 
     void ConformanceFailure(XrDebugUtilsMessageSeverityFlagsEXT severity, const char* functionName, const char* fmtMessage, ...) override;
 
+    // Reports the failures that FailureLimiter has suppressed and not yet summarized. Defined in RuntimeFailure.cpp.
+    void ReportSuppressedFailures(bool force);
+
     //
     // Defined in Instance.cpp
     //
     // xrCreateInstance is handled by CreateApiLayerInstance()
-    //XrResult xrDestroyInstance(XrInstance instance) override;
+    XrResult xrDestroyInstance(XrInstance instance) override;
     XrResult xrPollEvent(XrInstance instance, XrEventDataBuffer* eventData) override;
 
     // Defined in Session.cpp
@@ -82,10 +86,11 @@ struct ConformanceHooks : ConformanceHooksBase
     //             remove the action space from the lookup table.
     //XrResult xrCreateActionSpace(XrAction action, const XrActionSpaceCreateInfo* createInfo,
     //                             XrSpace* space) override;
-    //XrResult xrCreateReferenceSpace(XrSession session, const XrReferenceSpaceCreateInfo* createInfo,
-    //                                XrSpace* space) override;
     //XrResult xrDestroySpace(XrSpace space) override;
+    XrResult xrCreateReferenceSpace(XrSession session, const XrReferenceSpaceCreateInfo* createInfo, XrSpace* space) override;
     XrResult xrLocateSpace(XrSpace space, XrSpace baseSpace, XrTime time, XrSpaceLocation* location) override;
+    XrResult xrLocateHandJointsEXT(XrHandTrackerEXT handTracker, const XrHandJointsLocateInfoEXT* locateInfo,
+                                   XrHandJointLocationsEXT* locations) override;
 
     //
     // Defined in Swapchain.cpp
@@ -128,4 +133,5 @@ struct ConformanceHooks : ConformanceHooksBase
 #endif
 
 private:
+    FailureLimiter m_failureLimiter;
 };
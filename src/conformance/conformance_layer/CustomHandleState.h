@@ -17,28 +17,102 @@
 #pragma once
 
 #include "Common.h"
+#include "FrameTiming.h"
+#include "IGraphicsValidator.h"
 
 //
 // XrSession
 //
 namespace session
 {
+    // The results of an enumeration that must not change: filled by the first enumeration, under enumerationLock, and
+    // then published, so that the create hooks can look values up without taking a lock. Values below 64, such as the
+    // core reference space types, are also kept in a bitmask that answers Contains without a search.
+    template <typename T>
+    class EnumeratedValues
+    {
+    public:
+        bool IsFilled() const
+        {
+            return m_filled.load(std::memory_order_acquire);
+        }
+
+        // Called once, with enumerationLock held.
+        void Fill(const T* values, uint32_t count)
+        {
+            m_sorted.assign(values, values + count);
+            std::sort(m_sorted.begin(), m_sorted.end());
+            for (const T value : m_sorted) {
+                if ((int64_t)value >= 0 && (int64_t)value < 64) {
+                    m_smallValueMask |= uint64_t(1) << (int64_t)value;
+                }
+            }
+            m_filled.store(true, std::memory_order_release);
+        }
+
+        // Only valid once IsFilled returns true.
+        const std::vector<T>& Values() const
+        {
+            return m_sorted;
+        }
+
+        bool Contains(T value) const
+        {
+            if ((int64_t)value >= 0 && (int64_t)value < 64) {
+                return (m_smallValueMask & (uint64_t(1) << (int64_t)value)) != 0;
+            }
+            return std::binary_search(m_sorted.begin(), m_sorted.end(), value);
+        }
+
+    private:
+        std::atomic<bool> m_filled{false};
+        uint64_t m_smallValueMask{0};
+        std::vector<T> m_sorted;
+    };
+
     struct CustomSessionState : ICustomHandleState
     {
-        std::mutex lock;
+        static constexpr XrObjectType ObjectType = XR_OBJECT_TYPE_SESSION;
+
+        // Set at creation and constant afterwards, so read without a lock.
         XrSystemId systemId{XR_NULL_SYSTEM_ID};
-        XrSessionState sessionState{XR_SESSION_STATE_UNKNOWN};
-        bool sessionBegun{false};
-        bool sessionExitRequested{false};
-        bool frameBegun{false};
         bool headless{false};  //< true if a headless extension is enabled *and* in use
         XrStructureType graphicsBinding{XR_TYPE_UNKNOWN};
+        std::vector<XrStructureType> creationExtensionTypes;
+
+        // Each lock below guards one concern, so that the frame loop, action syncing and enumeration on different
+        // threads do not serialize on each other. When more than one is needed, take them in the order declared.
+
+        // Session lifecycle: begin, end, exit requests and state change events. The atomics are only written under it
+        // but may be read without it.
+        std::mutex lock;
+        std::atomic<XrSessionState> sessionState{XR_SESSION_STATE_UNKNOWN};
+        std::atomic<bool> sessionBegun{false};
+        bool sessionExitRequested{false};
+
+        // xrBeginFrame and xrEndFrame. Held across the runtime's xrEndFrame, which may queue the SYNCHRONIZED state
+        // change that is checked against frameCount, so the state change handler takes it too.
+        std::mutex frameLock;
+        bool frameBegun{false};
+        std::atomic<uint32_t> frameCount{0};
+
+        // The results of xrWaitFrame, which may be called on a different thread from xrBeginFrame and xrEndFrame.
+        std::mutex waitFrameLock;
         XrTime lastPredictedDisplayTime{0};
         XrDuration lastPredictedDisplayPeriod{0};
-        uint32_t frameCount{0};
-        std::vector<XrReferenceSpaceType> referenceSpaces;
-        std::vector<int64_t> swapchainFormats;
-        std::vector<XrStructureType> creationExtensionTypes;
+        FrameTimingAnalyzer frameTiming;  //< Only fed when IsFrameTimingEnabled()
+
+        // xrSyncActions. Counts the calls that updated action state, and the calls that have gone down to the runtime
+        // but not yet recorded what they did. Both are read without the lock by the xrGetActionState* hooks.
+        std::mutex syncLock;
+        std::atomic<uint64_t> syncGeneration{0};
+        std::atomic<uint32_t> syncsInProgress{0};
+
+        // The first enumeration results, which later enumerations are compared against and which reference spaces and
+        // swapchains must be created from. Only filling them takes the lock.
+        std::mutex enumerationLock;
+        EnumeratedValues<XrReferenceSpaceType> referenceSpaces;
+        EnumeratedValues<int64_t> swapchainFormats;
     };
 
     HandleState* GetSessionState(XrSession handle);
@@ -73,19 +147,39 @@ namespace swapchain
 
     struct CustomSwapchainState : ICustomHandleState
     {
+        static constexpr XrObjectType ObjectType = XR_OBJECT_TYPE_SWAPCHAIN;
+
         CustomSwapchainState(const XrSwapchainCreateInfo* createInfo, const XrStructureType graphicsBinding)
             : isStatic((createInfo->createFlags & XR_SWAPCHAIN_CREATE_STATIC_IMAGE_BIT) != 0)
             , graphicsBinding(graphicsBinding)
             , createInfo(*createInfo)
+            , graphicsValidator(Conformance::CreateGraphicsValidator(graphicsBinding))
         {
         }
 
-        std::recursive_mutex mutex;
+        // Only taken to set up the image tracking once the image count is known. The per-image acquire, wait
+        // and release tracking below is lock-free.
+        std::mutex setupMutex;
         bool isStatic;
-        std::vector<ImageState> imageStates;
-        std::queue<int> acquiredSwapchains;
         XrStructureType graphicsBinding;
         XrSwapchainCreateInfo createInfo;
+
+        // Zero until the images have been enumerated; published after imageStates and acquiredRing are allocated.
+        std::atomic<uint32_t> imageCount{0};
+        std::unique_ptr<std::atomic<ImageState>[]> imageStates;
+
+        // Indices of acquired images in acquire order, as a ring of imageCount entries. acquiredHead counts
+        // acquires and acquiredTail counts releases, so the oldest acquired image is at acquiredTail % imageCount.
+        std::unique_ptr<std::atomic<uint32_t>[]> acquiredRing;
+        std::atomic<uint64_t> acquiredHead{0};
+        std::atomic<uint64_t> acquiredTail{0};
+
+        // Null if there is no validator for the graphics binding. Created once, it holds no per-call state.
+        const std::shared_ptr<Conformance::IGraphicsValidator> graphicsValidator;
+        // Per image index, the IGraphicsValidator::GetImageKey of the image last validated there, or 0. The images
+        // and createInfo never change, so each image only needs validating the first time it is enumerated.
+        // Guarded by setupMutex.
+        std::vector<uint64_t> validatedImageKeys;
     };
 
     HandleState* GetSwapchainState(XrSwapchain handle);
@@ -106,18 +200,28 @@ namespace actionset
 
     struct CustomActionSetState : ICustomHandleState
     {
+        static constexpr XrObjectType ObjectType = XR_OBJECT_TYPE_ACTION_SET;
+
         CustomActionSetState(const XrActionSetCreateInfo* /*createInfo*/)
         {
         }
 
-        std::mutex mutex;
-        SyncResult lastSyncResult{SyncResult::NotSynced};
+        // Both are written by xrSyncActions without a lock: lastSyncResult first, then lastSyncGeneration with release
+        // ordering, so a reader that acquires the generation sees the result stored with it.
+        std::atomic<SyncResult> lastSyncResult{SyncResult::NotSynced};
+        std::atomic<uint64_t> lastSyncGeneration{0};  //< The session syncGeneration this set was last synced in.
     };
 
     HandleState* GetActionSetState(XrActionSet handle);
     CustomActionSetState* GetCustomActionSetState(XrActionSet handle);
 
-    void OnSyncActionData(XrResult syncResult, const XrActiveActionSet* activeActionSet);
+    // Records that the action set was synced as generation syncGeneration of its session.
+    void OnSyncActionData(XrResult syncResult, const XrActiveActionSet* activeActionSet, uint64_t syncGeneration);
+
+    // True if the action set was included in the xrSyncActions call that produced the session's current generation,
+    // and that call returned XR_SUCCESS, or if a later xrSyncActions that includes it is still in progress. Actions of
+    // any other action set must be inactive.
+    bool WasActiveInLastSync(const CustomActionSetState* actionSet, uint64_t sessionSyncGeneration);
 }  // namespace actionset
 
 //
@@ -127,14 +231,16 @@ namespace action
 {
     struct CustomActionState : ICustomHandleState
     {
-        CustomActionState(const XrActionCreateInfo* actionCreateInfo) : type(actionCreateInfo->actionType)
+        static constexpr XrObjectType ObjectType = XR_OBJECT_TYPE_ACTION;
+
+        CustomActionState(const XrActionCreateInfo* actionCreateInfo, actionset::CustomActionSetState* actionSet)
+            : type(actionCreateInfo->actionType), actionSet(actionSet)
         {
         }
 
         const XrActionType type;
-
-        std::mutex mutex;
-        // TODO: Useful state.
+        // Cached at creation so state queries need no handle lookup. Actions are destroyed with their action set.
+        actionset::CustomActionSetState* const actionSet;
     };
 
     HandleState* GetActionState(XrAction handle);
@@ -141,8 +141,14 @@ namespace Conformance
             (void)formats;
         }
 
+        uint64_t GetImageKey(const XrSwapchainImageBaseHeader* images, uint32_t index) const override
+        {
+            const XrSwapchainImageD3D11KHR* const d3d11Images = reinterpret_cast<const XrSwapchainImageD3D11KHR*>(images);
+            return reinterpret_cast<uint64_t>(d3d11Images[index].texture);
+        }
+
         void ValidateSwapchainImageStructs(ConformanceHooksBase* conformanceHooks, uint64_t swapchainFormat, uint32_t count,
-                                           XrSwapchainImageBaseHeader* images) const override
+                                           XrSwapchainImageBaseHeader* images, const std::vector<bool>& validate) const override
         {
 #if !defined(MISSING_DIRECTX_COLORS)
             const auto it = g_typelessMap.find((DXGI_FORMAT)swapchainFormat);
@@ -151,6 +157,9 @@ namespace Conformance
 
             const XrSwapchainImageD3D11KHR* const d3d11Images = reinterpret_cast<const XrSwapchainImageD3D11KHR*>(images);
             for (uint32_t i = 0; i < count; i++) {
+                if (!validate[i]) {
+                    continue;
+                }
                 if (d3d11Images[i].type != XR_TYPE_SWAPCHAIN_IMAGE_D3D11_KHR) {
                     conformanceHooks->ConformanceFailure(XR_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT, "xrEnumerateSwapchainImages",
                                                          "xrEnumerateSwapchainImages failed due to image header structure not D3D11: %d",
@@ -174,11 +183,11 @@ namespace Conformance
         }
 
         void ValidateUsageFlags(ConformanceHooksBase* conformanceHooks, uint64_t usageFlags, uint32_t count,
-                                XrSwapchainImageBaseHeader* images) const override
+                                XrSwapchainImageBaseHeader* images, const std::vector<bool>& validate) const override
         {
             const XrSwapchainImageD3D11KHR* const d3d11Images = reinterpret_cast<const XrSwapchainImageD3D11KHR*>(images);
             for (uint32_t i = 0; i < count; i++) {
-                if (d3d11Images[i].type != XR_TYPE_SWAPCHAIN_IMAGE_D3D11_KHR) {
+                if (!validate[i] || d3d11Images[i].type != XR_TYPE_SWAPCHAIN_IMAGE_D3D11_KHR) {
                     // This will already have caused a conformance failure above.
                     continue;
                 }
@@ -0,0 +1,107 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "FailureLimiter.h"
+
+#include "platform_utils.hpp"
+
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+    constexpr const char* FailureLimitEnvVar = "XR_CONFORMANCE_LAYER_FAILURES";
+    constexpr std::chrono::seconds SummaryInterval{10};
+
+    bool ParseFailureLimitEnabled(const std::string& value)
+    {
+        if (value.empty() || value == "limited") {
+            return true;
+        }
+        if (value == "all") {
+            return false;
+        }
+        std::cerr << "Unrecognized " << FailureLimitEnvVar << " value '" << value << "', limiting repeated failures" << std::endl;
+        return true;
+    }
+}  // namespace
+
+bool IsFailureLimitEnabled()
+{
+    static const bool enabled = ParseFailureLimitEnabled(PlatformUtilsGetEnv(FailureLimitEnvVar));
+    return enabled;
+}
+
+FailureLimiter::FailureLimiter() : m_lastSummary(Clock::now())
+{
+}
+
+FailureLimiter::Decision FailureLimiter::Count(const char* functionName, const char* fmtMessage)
+{
+    Decision decision;
+    if (!IsFailureLimitEnabled()) {
+        return decision;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Site& site = m_sites[Key{functionName, fmtMessage}];
+    decision.occurrence = ++site.count;
+    if (site.count < site.nextReport) {
+        site.suppressed++;
+        m_anySuppressed = true;
+        decision.report = false;
+        return decision;
+    }
+
+    // Reporting shows the suppressed count, so the summary need not repeat it.
+    site.nextReport *= 2;
+    decision.suppressed = site.suppressed;
+    site.suppressed = 0;
+    site.summarized = 0;
+    return decision;
+}
+
+std::string FailureLimiter::TakeSummary(bool force)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_anySuppressed) {
+        return {};
+    }
+    const Clock::time_point now = Clock::now();
+    if (!force && now - m_lastSummary < SummaryInterval) {
+        return {};
+    }
+    m_lastSummary = now;
+    m_anySuppressed = false;
+
+    std::ostringstream summary;
+    uint64_t siteCount = 0;
+    for (auto& entry : m_sites) {
+        Site& site = entry.second;
+        const uint64_t unsummarized = site.suppressed - site.summarized;
+        if (unsummarized == 0) {
+            continue;
+        }
+        site.summarized = site.suppressed;
+        siteCount++;
+        summary << "\n  [" << entry.first.functionName << "] " << entry.first.fmtMessage << ": " << unsummarized
+                << " more suppressed, " << site.count << " in total, next reported at occurrence " << site.nextReport;
+    }
+    if (siteCount == 0) {
+        return {};
+    }
+    return "Repeated conformance failures suppressed at " + std::to_string(siteCount) + " call sites:" + summary.str();
+}
@@ -0,0 +1,91 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Deduplication of the layer's conformance failure reports, so that a runtime which fails the same check on every frame
+// does not have the message formatted, printed and sent to every debug messenger each time. Errors are still sent to the
+// debug messengers every time, since a conformance test that sees none would pass; only their standard error and
+// debugger output is limited. Selected once per process with the XR_CONFORMANCE_LAYER_FAILURES environment variable:
+//   "limited"  - (default) Each call site, that is each function name and message format, is reported on its 1st, 2nd,
+//                4th, 8th, ... occurrence, with the number of occurrences suppressed since its last report. Every 10
+//                seconds, and when the instance is destroyed, one summary lists the call sites with suppressed failures.
+//   "all"      - Report every failure.
+bool IsFailureLimitEnabled();
+
+// Thread safe; one lives in each instance's hooks. The names are compared by pointer, since the layer passes string
+// literals and __func__, so they must outlive the layer.
+class FailureLimiter
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Decision
+    {
+        bool report{true};
+        // Counts since the call site was first seen and since it was last reported.
+        uint64_t occurrence{1};
+        uint64_t suppressed{0};
+    };
+
+    FailureLimiter();
+
+    // Counts one occurrence of the failure and says whether to report it: in full, or for an error, on the console.
+    Decision Count(const char* functionName, const char* fmtMessage);
+
+    // Returns a summary of the call sites that have suppressed failures if the summary interval has passed, or always
+    // with force, and starts their counts of suppressed failures over. Returns an empty string if none have any.
+    std::string TakeSummary(bool force);
+
+private:
+    struct Key
+    {
+        const char* functionName;
+        const char* fmtMessage;
+
+        bool operator==(const Key& other) const
+        {
+            return functionName == other.functionName && fmtMessage == other.fmtMessage;
+        }
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const Key& key) const
+        {
+            return std::hash<const void*>()(key.functionName) ^ (std::hash<const void*>()(key.fmtMessage) * 31);
+        }
+    };
+
+    struct Site
+    {
+        uint64_t count{0};
+        uint64_t nextReport{1};
+        uint64_t suppressed{0};
+        uint64_t summarized{0};
+    };
+
+    std::mutex m_mutex;
+    std::unordered_map<Key, Site, KeyHash> m_sites;
+    Clock::time_point m_lastSummary;
+    bool m_anySuppressed{false};
+};
@@ -0,0 +1,168 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "FrameTiming.h"
+
+#include "platform_utils.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+
+namespace
+{
+    constexpr const char* FrameTimingEnvVar = "XR_CONFORMANCE_LAYER_FRAME_TIMING";
+
+    // Timings are judged in units of the predicted display period. A delta more than a quarter period away from a whole
+    // number of periods is jitter rather than a skipped interval.
+    constexpr double JitterTolerancePeriods = 0.25;
+    constexpr double LongWaitPeriods = 2.0;
+
+    struct FrameTimingSettings
+    {
+        bool enabled{false};
+        uint32_t reportInterval{300};
+    };
+
+    const FrameTimingSettings& GetFrameTimingSettings()
+    {
+        static const FrameTimingSettings settings = [] {
+            FrameTimingSettings s;
+            const std::string value = PlatformUtilsGetEnv(FrameTimingEnvVar);
+            s.enabled = !value.empty();
+            const unsigned long interval = std::strtoul(value.c_str(), nullptr, 10);
+            if (interval > 0) {
+                s.reportInterval = (uint32_t)interval;
+            }
+            return s;
+        }();
+        return settings;
+    }
+
+    double ToPeriods(double ns, XrDuration period)
+    {
+        return ns / (double)period;
+    }
+}  // namespace
+
+bool IsFrameTimingEnabled()
+{
+    return GetFrameTimingSettings().enabled;
+}
+
+void FrameTimingAnalyzer::OnWaitFrame(Clock::duration blocked, const XrFrameState& frameState, bool visible)
+{
+    m_window.frames++;
+
+    const XrDuration period = frameState.predictedDisplayPeriod;
+    if (period > 0) {
+        const double waitPeriods =
+            ToPeriods((double)std::chrono::duration_cast<std::chrono::nanoseconds>(blocked).count(), period);
+        if (waitPeriods > m_window.maxWaitPeriods) {
+            m_window.maxWaitPeriods = waitPeriods;
+        }
+        if (waitPeriods > LongWaitPeriods) {
+            m_window.longWaits++;
+        }
+    }
+
+    if (m_lastDisplayPeriod != 0 && period != m_lastDisplayPeriod) {
+        m_window.periodChanges++;
+    }
+
+    // Going backwards is already reported as an error by xrWaitFrame.
+    if (m_lastDisplayTime != 0 && period > 0 && frameState.predictedDisplayTime > m_lastDisplayTime) {
+        const double deltaPeriods = ToPeriods((double)(frameState.predictedDisplayTime - m_lastDisplayTime), period);
+        const double wholePeriods = std::round(deltaPeriods);
+        const double jitter = std::fabs(deltaPeriods - wholePeriods);
+        if (jitter > m_window.maxJitterPeriods) {
+            m_window.maxJitterPeriods = jitter;
+        }
+        if (jitter > JitterTolerancePeriods) {
+            m_window.jitteryFrames++;
+        }
+        if (wholePeriods < 1) {
+            m_window.shortIntervals++;
+        }
+        else if (wholePeriods > 1) {
+            m_window.skippedPeriods += (uint32_t)(wholePeriods - 1);
+        }
+    }
+
+    if (visible && !frameState.shouldRender) {
+        m_window.throttledFrames++;
+    }
+
+    m_lastDisplayTime = frameState.predictedDisplayTime;
+    m_lastDisplayPeriod = period;
+}
+
+void FrameTimingAnalyzer::OnBeginFrame(Clock::time_point now)
+{
+    m_beginTime = now;
+    m_frameBegun = true;
+}
+
+void FrameTimingAnalyzer::OnEndFrame(Clock::time_point now)
+{
+    if (m_frameBegun && m_lastDisplayPeriod > 0) {
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_beginTime).count();
+        if (ns > m_lastDisplayPeriod) {
+            m_window.overBudgetFrames++;
+        }
+    }
+    m_frameBegun = false;
+}
+
+std::string FrameTimingAnalyzer::TakeReport()
+{
+    if (m_window.frames < GetFrameTimingSettings().reportInterval) {
+        return {};
+    }
+    const Window window = m_window;
+    m_window = Window{};
+
+    // Skipped periods while frames are over budget are the app missing frames, not the runtime throttling it.
+    const bool throttling = window.throttledFrames > 0 || (window.skippedPeriods > 0 && window.overBudgetFrames == 0);
+    if (window.longWaits == 0 && window.jitteryFrames == 0 && window.shortIntervals == 0 && !throttling && window.periodChanges == 0) {
+        return {};
+    }
+
+    std::ostringstream report;
+    report << "Frame timing anomalies in the last " << window.frames << " frames:";
+    if (window.longWaits > 0) {
+        report << " xrWaitFrame blocked for over " << LongWaitPeriods << " display periods " << window.longWaits
+               << " times (longest " << window.maxWaitPeriods << ").";
+    }
+    if (window.jitteryFrames > 0) {
+        report << " predictedDisplayTime advanced by a fraction of a display period " << window.jitteryFrames
+               << " times (worst off by " << window.maxJitterPeriods << " periods).";
+    }
+    if (window.shortIntervals > 0) {
+        report << " predictedDisplayTime advanced by less than a display period " << window.shortIntervals << " times.";
+    }
+    if (throttling) {
+        report << " Runtime appears to be throttling: " << window.skippedPeriods << " display periods skipped and "
+               << window.throttledFrames << " frames with shouldRender false.";
+    }
+    if (window.periodChanges > 0) {
+        report << " predictedDisplayPeriod changed " << window.periodChanges << " times.";
+    }
+    if (window.overBudgetFrames > 0) {
+        report << " " << window.overBudgetFrames << " frames took longer than a display period from xrBeginFrame to xrEndFrame.";
+    }
+    return report.str();
+}
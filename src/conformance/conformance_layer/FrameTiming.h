@@ -0,0 +1,74 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <openxr/openxr.h>
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Optional online analysis of a session's frame timing. Enabled by setting the XR_CONFORMANCE_LAYER_FRAME_TIMING
+// environment variable; a positive number sets how many frames each report covers (default 300).
+//
+// None of these are spec violations on their own, so they are reported as warnings, and only once per window of frames
+// with everything found in that window rolled up into one message:
+//   - xrWaitFrame blocking for more than two display periods.
+//   - predictedDisplayTime advancing by something other than a whole number of display periods (jitter), or by less
+//     than one period.
+//   - predictedDisplayTime skipping display periods while the app is keeping up, or shouldRender being false while the
+//     session is visible, which is the runtime throttling the app.
+//   - predictedDisplayPeriod changing.
+//   - The app spending more than a display period between xrBeginFrame and xrEndFrame.
+bool IsFrameTimingEnabled();
+
+// Not thread safe; lives in the session state and is only used under its lock.
+class FrameTimingAnalyzer
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // visible says whether the session is VISIBLE or FOCUSED, the only states in which shouldRender false is throttling.
+    void OnWaitFrame(Clock::duration blocked, const XrFrameState& frameState, bool visible);
+    void OnBeginFrame(Clock::time_point now);
+    void OnEndFrame(Clock::time_point now);
+
+    // Returns a summary of the anomalies seen once a full window of frames has been recorded, then starts the next
+    // window. Returns an empty string if the window is not complete or nothing was found.
+    std::string TakeReport();
+
+private:
+    struct Window
+    {
+        uint32_t frames{0};
+        uint32_t longWaits{0};
+        uint32_t jitteryFrames{0};
+        uint32_t shortIntervals{0};
+        uint32_t skippedPeriods{0};
+        uint32_t throttledFrames{0};
+        uint32_t periodChanges{0};
+        uint32_t overBudgetFrames{0};
+        double maxWaitPeriods{0};
+        double maxJitterPeriods{0};
+    };
+
+    Window m_window;
+    XrTime m_lastDisplayTime{0};
+    XrDuration m_lastDisplayPeriod{0};
+    Clock::time_point m_beginTime{};
+    bool m_frameBegun{false};
+};
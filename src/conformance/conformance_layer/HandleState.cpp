@@ -14,6 +14,8 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <array>
+#include <shared_mutex>
 #include <string>
 #include "gen_dispatch.h"
 #include "Common.h"
@@ -29,45 +31,89 @@ namespace
         }
     };
 
-    std::unordered_map<HandleStateKey, std::unique_ptr<HandleState>, HandleStateKeyHash> g_handleStates;
+    // Every intercepted call looks up its handle, so the registry is split into shards that each have a reader-writer
+    // lock. Lookups only take a shared lock on one shard and never contend with each other, even on the same handle.
+    constexpr size_t HandleStateShardCount = 16;
+    static_assert((HandleStateShardCount & (HandleStateShardCount - 1)) == 0, "Shard count must be a power of two");
+
+    struct HandleStateShard
+    {
+        std::shared_timed_mutex mutex;
+        std::unordered_map<HandleStateKey, std::unique_ptr<HandleState>, HandleStateKeyHash> handleStates;
+    };
+
+    std::array<HandleStateShard, HandleStateShardCount> g_handleStateShards;
+
+    // Serializes registration and unregistration, which may touch several shards when a parent takes its children with it.
     std::mutex g_handleStatesMutex;
+
+    HandleStateShard& GetShard(const HandleStateKey& key)
+    {
+        // Handles are frequently aligned pointers, so mix the bits before picking a shard rather than using the low bits.
+        const uint64_t mixed = (uint64_t)HandleStateKeyHash()(key) * 0x9E3779B97F4A7C15ull;
+        return g_handleStateShards[(size_t)(mixed >> 32) & (HandleStateShardCount - 1)];
+    }
+
+    // Set by ScopedDispatchHandleState for the duration of a generated ABI entry point.
+    thread_local HandleState* t_dispatchHandleState = nullptr;
+
+    HandleException UnknownHandleException(const HandleStateKey& key)
+    {
+        return HandleException(std::string("Encountered unknown ") + to_string(key.second) + " handle with value " +
+                               std::to_string(key.first));
+    }
 }  // namespace
 
 void RegisterHandleState(std::unique_ptr<HandleState> handleState)
 {
     std::unique_lock<std::mutex> lock(g_handleStatesMutex);
     HandleStateKey mapKey(handleState->handle, handleState->type);
-    auto it = g_handleStates.insert(std::pair<HandleStateKey, std::unique_ptr<HandleState>>(mapKey, std::move(handleState)));
+    HandleStateShard& shard = GetShard(mapKey);
+    std::unique_lock<std::shared_timed_mutex> shardLock(shard.mutex);
+    auto it = shard.handleStates.insert(std::pair<HandleStateKey, std::unique_ptr<HandleState>>(mapKey, std::move(handleState)));
     if (!it.second) {
-        throw HandleException(std::string("Encountered duplicate ") + to_string(handleState->type) + " handle with value " +
-                              std::to_string(handleState->handle));
+        throw HandleException(std::string("Encountered duplicate ") + to_string(mapKey.second) + " handle with value " +
+                              std::to_string(mapKey.first));
     }
 }
 
 void UnregisterHandleStateInternal(std::unique_lock<std::mutex>& lockProof, HandleStateKey key)
 {
-    auto it = g_handleStates.find(key);
-    if (it == g_handleStates.end()) {
-        throw HandleException(std::string("Encountered unknown ") + to_string(key.second) + " handle with value " +
-                              std::to_string(key.first));
+    // Writers are serialized by lockProof, so the entry can't disappear between the lookup and the erase, and
+    // only the shard's own lock is needed to keep readers out while the map itself changes.
+    HandleState* handleState = nullptr;
+    HandleStateShard& shard = GetShard(key);
+    {
+        std::shared_lock<std::shared_timed_mutex> shardLock(shard.mutex);
+        auto it = shard.handleStates.find(key);
+        if (it == shard.handleStates.end()) {
+            throw UnknownHandleException(key);
+        }
+        handleState = it->second.get();
     }
 
     // Unregister children from map (recursively)
-    while (!it->second->children.empty()) {
+    while (!handleState->children.empty()) {
         // Unregistering the child will cause it to be removed from the list of children.
-        HandleState* const frontChild = it->second->children.front();
+        HandleState* const frontChild = handleState->children.front();
         UnregisterHandleStateInternal(lockProof, HandleStateKey(frontChild->handle, frontChild->type));
     }
 
-    if (it->second->parent != nullptr) {  // XrInstance has no parent
+    if (handleState->parent != nullptr) {  // XrInstance has no parent
         // Remove self from parent's list of children
-        std::unique_lock<std::mutex> lock(it->second->parent->mutex);
-        std::vector<HandleState*>& siblings = it->second->parent->children;
-        siblings.erase(std::remove(siblings.begin(), siblings.end(), it->second.get()), siblings.end());
+        std::unique_lock<std::mutex> lock(handleState->parent->mutex);
+        std::vector<HandleState*>& siblings = handleState->parent->children;
+        siblings.erase(std::remove(siblings.begin(), siblings.end(), handleState), siblings.end());
+    }
+
+    // Don't let a scope on this thread keep handing out the state once it is gone.
+    if (t_dispatchHandleState == handleState) {
+        t_dispatchHandleState = nullptr;
     }
 
     // Finally remove self from map.
-    g_handleStates.erase(it);
+    std::unique_lock<std::shared_timed_mutex> shardLock(shard.mutex);
+    shard.handleStates.erase(key);
 }
 
 void UnregisterHandleState(HandleStateKey key)
@@ -78,11 +124,26 @@ void UnregisterHandleState(HandleStateKey key)
 
 HandleState* GetHandleState(HandleStateKey key)
 {
-    std::unique_lock<std::mutex> lock(g_handleStatesMutex);
-    auto it = g_handleStates.find(key);
-    if (it == g_handleStates.end()) {
-        throw HandleException(std::string("Encountered unknown ") + to_string(key.second) + " handle with value " +
-                              std::to_string(key.first));
+    HandleState* const dispatchHandleState = t_dispatchHandleState;
+    if (dispatchHandleState != nullptr && dispatchHandleState->handle == key.first && dispatchHandleState->type == key.second) {
+        return dispatchHandleState;
+    }
+
+    HandleStateShard& shard = GetShard(key);
+    std::shared_lock<std::shared_timed_mutex> shardLock(shard.mutex);
+    auto it = shard.handleStates.find(key);
+    if (it == shard.handleStates.end()) {
+        throw UnknownHandleException(key);
     }
     return it->second.get();
 }
+
+ScopedDispatchHandleState::ScopedDispatchHandleState(HandleState* handleState) : m_previous(t_dispatchHandleState)
+{
+    t_dispatchHandleState = handleState;
+}
+
+ScopedDispatchHandleState::~ScopedDispatchHandleState()
+{
+    t_dispatchHandleState = m_previous;
+}
@@ -24,6 +24,9 @@
 
 #include <memory>
 #include <mutex>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
 #include <vector>
 
 struct ICustomHandleState
@@ -86,3 +89,30 @@ void UnregisterHandleState(HandleStateKey key);
 void RegisterHandleState(std::unique_ptr<HandleState> handleState);
 
 HandleState* GetHandleState(HandleStateKey key);
+
+// Records the HandleState that a generated ABI entry point resolved for its first handle, so the hand-written hooks
+// it calls into get it back from GetHandleState without another registry lookup. Scopes nest on a per-thread basis.
+class ScopedDispatchHandleState
+{
+public:
+    explicit ScopedDispatchHandleState(HandleState* handleState);
+    ~ScopedDispatchHandleState();
+
+    ScopedDispatchHandleState(const ScopedDispatchHandleState&) = delete;
+    ScopedDispatchHandleState& operator=(const ScopedDispatchHandleState&) = delete;
+
+private:
+    HandleState* const m_previous;
+};
+
+// Typed access to HandleState::customState. Each custom state type names the object type it is attached to in a
+// static ObjectType member, and that tag is checked instead of paying for a dynamic_cast on every call.
+template <typename TCustomState>
+TCustomState* GetCustomState(HandleState* handleState)
+{
+    static_assert(std::is_base_of<ICustomHandleState, TCustomState>::value, "Custom state must derive from ICustomHandleState");
+    if (handleState->type != TCustomState::ObjectType) {
+        throw HandleException("Custom state requested for a handle of the wrong object type");
+    }
+    return static_cast<TCustomState*>(handleState->customState.get());
+}
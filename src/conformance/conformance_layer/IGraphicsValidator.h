@@ -17,6 +17,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 #include "Common.h"
 
@@ -27,10 +28,16 @@ namespace Conformance
         virtual ~IGraphicsValidator() = default;
 
         virtual void ValidateSwapchainFormats(ConformanceHooksBase* conformanceHooks, uint32_t count, uint64_t* formats) const = 0;
+
+        // Returns a value identifying the image at index for as long as it exists, such as its API handle, so that
+        // validation results can be cached across enumerations. Zero means the image is validated every time.
+        virtual uint64_t GetImageKey(const XrSwapchainImageBaseHeader* images, uint32_t index) const = 0;
+
+        // These only check the images whose entry in validate is true; validate has count entries.
         virtual void ValidateSwapchainImageStructs(ConformanceHooksBase* conformanceHooks, uint64_t swapchainFormat, uint32_t count,
-                                                   XrSwapchainImageBaseHeader* images) const = 0;
+                                                   XrSwapchainImageBaseHeader* images, const std::vector<bool>& validate) const = 0;
         virtual void ValidateUsageFlags(ConformanceHooksBase* conformanceHooks, uint64_t usageFlags, uint32_t count,
-                                        XrSwapchainImageBaseHeader* images) const = 0;
+                                        XrSwapchainImageBaseHeader* images, const std::vector<bool>& validate) const = 0;
     };
 
     // Create a graphics plugin for the graphics API specified in the options.
@@ -17,12 +17,27 @@
 #include "ConformanceHooks.h"
 #include "CustomHandleState.h"
 #include "RuntimeFailure.h"
+#include "CallTrace.h"
+#include "LatencyHistogram.h"
 #include <loader_interfaces.h>
 
 /////////////////
 // ABI
 /////////////////
 
+XrResult ConformanceHooks::xrDestroyInstance(XrInstance instance)
+{
+    ReportSuppressedFailures(true);
+
+    const XrResult result = ConformanceHooksBase::xrDestroyInstance(instance);
+
+    // The instance's handle state, which owns this object, is gone now. Don't touch members past this point.
+    WriteLatencyHistograms();
+    FlushCallTrace();
+
+    return result;
+}
+
 XrResult ConformanceHooks::xrPollEvent(XrInstance instance, XrEventDataBuffer* eventData)
 {
     const XrResult result = ConformanceHooksBase::xrPollEvent(instance, eventData);
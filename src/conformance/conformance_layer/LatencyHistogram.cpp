@@ -0,0 +1,180 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "LatencyHistogram.h"
+
+#include "platform_utils.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace
+{
+    constexpr const char* LatencyHistogramEnvVar = "XR_CONFORMANCE_LAYER_LATENCY_HISTOGRAM";
+
+    // 8 linear sub-buckets per power of two gives at most 12.5% relative error. Magnitudes 0-35 cover up to ~68 seconds,
+    // anything longer lands in the last bucket.
+    constexpr uint32_t SubBucketBits = 3;
+    constexpr uint32_t SubBucketCount = 1u << SubBucketBits;
+    constexpr uint32_t MagnitudeCount = 36;
+    constexpr size_t BucketCount = SubBucketCount + (MagnitudeCount - SubBucketBits) * SubBucketCount;
+
+    // Values below SubBucketCount map 1:1. Above that, the top SubBucketBits bits below the leading one pick the sub-bucket.
+    size_t BucketIndex(uint64_t ns)
+    {
+        if (ns < SubBucketCount) {
+            return (size_t)ns;
+        }
+        uint32_t magnitude = 63;
+        while ((ns >> magnitude) == 0) {
+            --magnitude;
+        }
+        if (magnitude >= MagnitudeCount) {
+            return BucketCount - 1;
+        }
+        const uint64_t subBucket = (ns >> (magnitude - SubBucketBits)) & (SubBucketCount - 1);
+        return SubBucketCount + (magnitude - SubBucketBits) * SubBucketCount + (size_t)subBucket;
+    }
+
+    uint64_t BucketLowerBound(size_t index)
+    {
+        if (index < SubBucketCount) {
+            return index;
+        }
+        const uint32_t magnitude = (uint32_t)((index - SubBucketCount) / SubBucketCount) + SubBucketBits;
+        const uint64_t subBucket = (index - SubBucketCount) % SubBucketCount;
+        return (uint64_t(1) << magnitude) + (subBucket << (magnitude - SubBucketBits));
+    }
+
+    // Counters for one function on one thread. Only the owning thread writes, so plain load/store is enough;
+    // atomics just keep the concurrent read in WriteLatencyHistograms well defined.
+    struct ThreadHistogram
+    {
+        std::array<std::atomic<uint64_t>, BucketCount> buckets{};
+    };
+
+    struct ThreadHistograms
+    {
+        // Indexed by LatencyHistogramId, grown on demand by the owning thread under the registry lock.
+        std::vector<std::unique_ptr<ThreadHistogram>> histograms;
+    };
+
+    struct Registry
+    {
+        std::mutex mutex;
+        std::vector<const char*> functionNames;
+        // Owned here rather than by the thread so counters survive thread exit until they are written out.
+        std::vector<std::unique_ptr<ThreadHistograms>> threads;
+    };
+
+    Registry& GetRegistry()
+    {
+        static Registry* registry = new Registry();  // Leaked on purpose, other statics may record during shutdown.
+        return *registry;
+    }
+
+    const std::string& GetOutputPath()
+    {
+        static const std::string path = PlatformUtilsGetEnv(LatencyHistogramEnvVar);
+        return path;
+    }
+
+    ThreadHistogram& GetThreadHistogram(LatencyHistogramId id)
+    {
+        thread_local ThreadHistograms* threadHistograms = nullptr;
+        if (threadHistograms == nullptr || id >= threadHistograms->histograms.size() || !threadHistograms->histograms[id]) {
+            Registry& registry = GetRegistry();
+            std::unique_lock<std::mutex> lock(registry.mutex);
+            if (threadHistograms == nullptr) {
+                registry.threads.emplace_back(new ThreadHistograms());
+                threadHistograms = registry.threads.back().get();
+            }
+            if (id >= threadHistograms->histograms.size()) {
+                threadHistograms->histograms.resize(registry.functionNames.size());
+            }
+            threadHistograms->histograms[id].reset(new ThreadHistogram());
+        }
+        return *threadHistograms->histograms[id];
+    }
+}  // namespace
+
+bool IsLatencyHistogramEnabled()
+{
+    static const bool enabled = !GetOutputPath().empty();
+    return enabled;
+}
+
+LatencyHistogramId RegisterLatencyHistogram(const char* functionName)
+{
+    Registry& registry = GetRegistry();
+    std::unique_lock<std::mutex> lock(registry.mutex);
+    registry.functionNames.push_back(functionName);
+    return registry.functionNames.size() - 1;
+}
+
+void RecordLatency(LatencyHistogramId id, std::chrono::nanoseconds duration)
+{
+    const uint64_t ns = duration.count() > 0 ? (uint64_t)duration.count() : 0;
+    ThreadHistogram& histogram = GetThreadHistogram(id);
+    std::atomic<uint64_t>& bucket = histogram.buckets[BucketIndex(ns)];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+void WriteLatencyHistograms()
+{
+    if (!IsLatencyHistogramEnabled()) {
+        return;
+    }
+
+    Registry& registry = GetRegistry();
+    std::unique_lock<std::mutex> lock(registry.mutex);
+
+    std::ofstream out(GetOutputPath(), std::ios::trunc);
+    if (!out) {
+        std::cerr << "Unable to write " << LatencyHistogramEnvVar << " file '" << GetOutputPath() << "'" << std::endl;
+        return;
+    }
+
+    // One row per non-empty bucket. The upper bound is exclusive; the last bucket is open-ended.
+    out << "function,lower_ns,upper_ns,count\n";
+    for (size_t id = 0; id < registry.functionNames.size(); ++id) {
+        std::array<uint64_t, BucketCount> merged{};
+        for (const auto& thread : registry.threads) {
+            if (id < thread->histograms.size() && thread->histograms[id]) {
+                for (size_t i = 0; i < BucketCount; ++i) {
+                    merged[i] += thread->histograms[id]->buckets[i].load(std::memory_order_relaxed);
+                }
+            }
+        }
+        for (size_t i = 0; i < BucketCount; ++i) {
+            if (merged[i] == 0) {
+                continue;
+            }
+            out << registry.functionNames[id] << ',' << BucketLowerBound(i) << ',';
+            if (i + 1 < BucketCount) {
+                out << BucketLowerBound(i + 1);
+            }
+            out << ',' << merged[i] << '\n';
+        }
+    }
+}
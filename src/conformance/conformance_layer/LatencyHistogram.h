@@ -0,0 +1,66 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+// Optional per-entry-point call latency histograms. Enabled by setting the XR_CONFORMANCE_LAYER_LATENCY_HISTOGRAM
+// environment variable to the path of a CSV file, which is rewritten every time an instance is destroyed with the
+// totals for the whole process so far.
+//
+// Buckets are fixed and log-linear (HDR-style): each power of two of nanoseconds is split into a fixed number of
+// linear sub-buckets. Every thread records into its own counters, so recording takes no locks.
+using LatencyHistogramId = size_t;
+
+bool IsLatencyHistogramEnabled();
+
+// Returns the id to record calls of functionName under. Called once per entry point, from a function-local static.
+// functionName must outlive the layer (the generated code passes string literals).
+LatencyHistogramId RegisterLatencyHistogram(const char* functionName);
+
+void RecordLatency(LatencyHistogramId id, std::chrono::nanoseconds duration);
+
+// Writes all recorded histograms to the configured file. Does nothing if histograms are disabled.
+void WriteLatencyHistograms();
+
+// Times the enclosing scope and records it, if histograms are enabled.
+class ScopedLatencyRecord
+{
+public:
+    explicit ScopedLatencyRecord(LatencyHistogramId id) : m_id(id), m_enabled(IsLatencyHistogramEnabled())
+    {
+        if (m_enabled) {
+            m_start = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~ScopedLatencyRecord()
+    {
+        if (m_enabled) {
+            RecordLatency(m_id, std::chrono::steady_clock::now() - m_start);
+        }
+    }
+
+    ScopedLatencyRecord(const ScopedLatencyRecord&) = delete;
+    ScopedLatencyRecord& operator=(const ScopedLatencyRecord&) = delete;
+
+private:
+    const LatencyHistogramId m_id;
+    const bool m_enabled;
+    std::chrono::steady_clock::time_point m_start{};
+};
@@ -18,15 +18,24 @@
 #include <iostream>
 #include <cmath>
 #include <stdarg.h>
+#include <stdio.h>
 #include "Common.h"
 #include "ConformanceHooks.h"
 #include "RuntimeFailure.h"
 
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define CONFORMANCE_LAYER_USE_SSE 1
+#include <xmmintrin.h>
+#endif
+
 namespace
 {
     void RuntimeFailure(const XrGeneratedDispatchTable* dispatchTable, XrInstance instance, XrDebugUtilsMessageSeverityFlagsEXT severity,
-                        const char* xrFuncName, const char* detailsFmt, va_list vl)
+                        const char* xrFuncName, const FailureLimiter::Decision& decision, const char* detailsFmt, va_list vl)
     {
+        // A failure the limiter suppresses still reaches the messengers when it is an error, but not the console.
+        const bool printDirect = decision.report;
+
         std::string detailsStr;
         {
             va_list vl2;
@@ -45,25 +54,32 @@ namespace
                 }
             }
         }
+        if (printDirect && decision.occurrence > 1) {
+            detailsStr += " (occurrence " + std::to_string(decision.occurrence) + ", " + std::to_string(decision.suppressed) +
+                          " suppressed since the last report)";
+        }
 
-        std::stringstream ss;
-        ss << "[" << xrFuncName << "]:" << detailsStr << std::endl;
-        const std::string directMsg = ss.str();
+        if (printDirect) {
+            std::stringstream ss;
+            ss << "[" << xrFuncName << "]:" << detailsStr << std::endl;
+            const std::string directMsg = ss.str();
 
 #ifdef XR_USE_PLATFORM_WIN32
-        OutputDebugStringA(directMsg.c_str());
+            OutputDebugStringA(directMsg.c_str());
 #endif
 
-        std::cerr << directMsg << std::endl;
+            std::cerr << directMsg << std::endl;
+        }
 
-        XrDebugUtilsMessengerCallbackDataEXT callbackData{XR_TYPE_DEBUG_UTILS_MESSENGER_CALLBACK_DATA_EXT};
+        XrDebugUtilsMessengerCallbackDataEXT callbackData{};
+        callbackData.type = XR_TYPE_DEBUG_UTILS_MESSENGER_CALLBACK_DATA_EXT;
         callbackData.functionName = xrFuncName;
         callbackData.message = detailsStr.c_str();
         callbackData.messageId = "CONF";  // TODO: Technically should have a distinct ID per message.
 
         dispatchTable->SubmitDebugUtilsMessageEXT(instance, severity, XR_DEBUG_UTILS_MESSAGE_TYPE_CONFORMANCE_BIT_EXT, &callbackData);
 
-        if (severity & XR_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT) {
+        if (printDirect && (severity & XR_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT)) {
 #if !defined(NDEBUG)
 #ifdef _MSC_VER
             if (::IsDebuggerPresent()) {
@@ -79,46 +95,125 @@ namespace
 void ConformanceHooks::ConformanceFailure(XrDebugUtilsMessageSeverityFlagsEXT severity, const char* functionName, const char* fmtMessage,
                                           ...)
 {
-    va_list vl;
-    va_start(vl, fmtMessage);
-    RuntimeFailure(&this->dispatchTable, this->instance, severity, functionName, fmtMessage, vl);
-    va_end(vl);
+    // Counted before anything is formatted, so that a warning repeated every frame costs only the count. Errors always go
+    // to the messengers, where the conformance tests fail on them, so only their console output is limited.
+    const FailureLimiter::Decision decision = m_failureLimiter.Count(functionName, fmtMessage);
+    if (decision.report || (severity & XR_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT) != 0) {
+        va_list vl;
+        va_start(vl, fmtMessage);
+        RuntimeFailure(&this->dispatchTable, this->instance, severity, functionName, decision, fmtMessage, vl);
+        va_end(vl);
+    }
+    ReportSuppressedFailures(false);
 }
 
-XrBaseStructChainValidator::XrBaseStructChainValidator(ConformanceHooksBase* conformanceHook, const void* arg, std::string parameterName,
-                                                       std::string functionName)
-    : m_conformanceHook(conformanceHook)
-    , m_parameterName(std::move(parameterName))
-    , m_functionName(std::move(functionName))
-    , m_head(reinterpret_cast<const XrBaseInStructure*>(arg))
+void ConformanceHooks::ReportSuppressedFailures(bool force)
 {
-    for (const XrBaseInStructure* baseArg = m_head; baseArg != nullptr; baseArg = baseArg->next) {
-        m_chainCache.push_back(*baseArg);
+    const std::string summary = m_failureLimiter.TakeSummary(force);
+    if (summary.empty()) {
+        return;
     }
+
+    const std::string directMsg = "[ConformanceLayer]:" + summary + "\n";
+#ifdef XR_USE_PLATFORM_WIN32
+    OutputDebugStringA(directMsg.c_str());
+#endif
+    std::cerr << directMsg << std::endl;
+
+    XrDebugUtilsMessengerCallbackDataEXT callbackData{};
+    callbackData.type = XR_TYPE_DEBUG_UTILS_MESSENGER_CALLBACK_DATA_EXT;
+    callbackData.functionName = "ConformanceLayer";
+    callbackData.message = summary.c_str();
+    callbackData.messageId = "CONF";
+    dispatchTable.SubmitDebugUtilsMessageEXT(instance, XR_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT,
+                                             XR_DEBUG_UTILS_MESSAGE_TYPE_CONFORMANCE_BIT_EXT, &callbackData);
 }
 
-XrBaseStructChainValidator::~XrBaseStructChainValidator()
+constexpr uint32_t XrBaseStructChainValidator::InlineChainLength;
+
+XrBaseStructChainValidator::XrBaseStructChainValidator(ConformanceHooksBase* conformanceHook, const void* arg, const char* parameterName,
+                                                       const char* functionName)
+    : XrBaseStructChainValidator(conformanceHook, arg, 0, arg != nullptr ? 1 : 0, parameterName, functionName)
+{
+}
+
+XrBaseStructChainValidator::XrBaseStructChainValidator(ConformanceHooksBase* conformanceHook, const void* array, size_t structSize,
+                                                       uint32_t count, const char* parameterName, const char* functionName)
+    : m_conformanceHook(conformanceHook)
+    , m_parameterName(parameterName)
+    , m_functionName(functionName)
+    , m_array(reinterpret_cast<const unsigned char*>(array))
+    , m_structSize(structSize)
+    , m_count(array != nullptr ? count : 0)
 {
-    for (const XrBaseInStructure* baseArg = m_head; baseArg != nullptr; baseArg = baseArg->next) {
-        if (m_chainCache.empty()) {
-            m_conformanceHook->ConformanceFailure(XR_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT, m_functionName.c_str(),
-                                                  "Parameter %s next chain was lengthened", m_parameterName.c_str());
-            continue;
+    if (m_count == 0) {
+        return;
+    }
+
+    if (m_count == 1) {
+        uint32_t length = 0;
+        for (const XrBaseInStructure* baseArg = GetHead(0); baseArg != nullptr && length <= InlineChainLength; baseArg = baseArg->next) {
+            length++;
         }
-        const XrBaseInStructure expected = m_chainCache.front();
-        m_chainCache.pop_front();
-        if (expected.type != baseArg->type) {
-            m_conformanceHook->ConformanceFailure(XR_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT, m_functionName.c_str(),
-                                                  "Struct 'type' modified for parameter %s or chained structure", m_parameterName.c_str());
+        if (length <= InlineChainLength) {
+            m_inlineChainLength = length;
+            m_chainLengths = &m_inlineChainLength;
+            m_chainCache = m_inlineChain;
+            XrBaseInStructure* cached = m_chainCache;
+            for (const XrBaseInStructure* baseArg = GetHead(0); baseArg != nullptr; baseArg = baseArg->next) {
+                *cached++ = *baseArg;
+            }
+            return;
         }
-        if (expected.next != baseArg->next) {
-            m_conformanceHook->ConformanceFailure(XR_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT, m_functionName.c_str(),
-                                                  "Struct 'next' chain modified for parameter %s or chained structure",
-                                                  m_parameterName.c_str());
+    }
+
+    ScratchArena& arena = ScratchArena::ForThisThread();
+    m_chainLengths = arena.Allocate<uint32_t>(m_count);
+    size_t totalLength = 0;
+    for (uint32_t i = 0; i < m_count; i++) {
+        uint32_t length = 0;
+        for (const XrBaseInStructure* baseArg = GetHead(i); baseArg != nullptr; baseArg = baseArg->next) {
+            length++;
+        }
+        m_chainLengths[i] = length;
+        totalLength += length;
+    }
+
+    m_chainCache = arena.Allocate<XrBaseInStructure>(totalLength);
+    XrBaseInStructure* cached = m_chainCache;
+    for (uint32_t i = 0; i < m_count; i++) {
+        for (const XrBaseInStructure* baseArg = GetHead(i); baseArg != nullptr; baseArg = baseArg->next) {
+            *cached++ = *baseArg;
         }
     }
 }
 
+XrBaseStructChainValidator::~XrBaseStructChainValidator()
+{
+    const XrBaseInStructure* cached = m_chainCache;
+    for (uint32_t i = 0; i < m_count; i++) {
+        const XrBaseInStructure* const cachedEnd = cached + m_chainLengths[i];
+        for (const XrBaseInStructure* baseArg = GetHead(i); baseArg != nullptr; baseArg = baseArg->next) {
+            if (cached == cachedEnd) {
+                m_conformanceHook->ConformanceFailure(XR_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT, m_functionName,
+                                                      "Parameter %s next chain was lengthened", m_parameterName);
+                continue;
+            }
+            const XrBaseInStructure expected = *cached++;
+            if (expected.type != baseArg->type) {
+                m_conformanceHook->ConformanceFailure(XR_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT, m_functionName,
+                                                      "Struct 'type' modified for parameter %s or chained structure", m_parameterName);
+            }
+            if (expected.next != baseArg->next) {
+                m_conformanceHook->ConformanceFailure(XR_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT, m_functionName,
+                                                      "Struct 'next' chain modified for parameter %s or chained structure",
+                                                      m_parameterName);
+            }
+        }
+        cached = cachedEnd;
+    }
+}
+
 void ValidateXrBool32(ConformanceHooksBase* conformanceHook, XrBool32 value, const char* valueName, const char* xrFunctionName)
 {
     if (!IsValidXrBool32(value)) {
@@ -164,3 +259,162 @@ void ValidateXrVector3f(ConformanceHooksBase* conformanceHook, const XrVector3f&
                                             "%s is not a valid XrVector3d value: (%f, %f, %f)", valueName, v.x, v.y, v.z);
     }
 }
+
+namespace
+{
+    constexpr uint32_t BatchWidth = 4;
+
+    template <typename T>
+    const T& StridedElement(const T* first, size_t stride, uint32_t index)
+    {
+        return *reinterpret_cast<const T*>(reinterpret_cast<const unsigned char*>(first) + index * stride);
+    }
+
+    // Each of these returns a mask with bit i set if element i of the BatchWidth elements from first fails its check.
+    // The checks match the scalar ones, which check a failing element again before it is reported.
+#if CONFORMANCE_LAYER_USE_SSE
+    unsigned FloatOutOfRangeMask(const float* first, size_t stride, float min, float max)
+    {
+        const __m128 v = _mm_setr_ps(StridedElement(first, stride, 0), StridedElement(first, stride, 1), StridedElement(first, stride, 2),
+                                     StridedElement(first, stride, 3));
+        // Ordered comparisons, so NaN is out of range.
+        const __m128 inRange = _mm_and_ps(_mm_cmpge_ps(v, _mm_set1_ps(min)), _mm_cmple_ps(v, _mm_set1_ps(max)));
+        return ~static_cast<unsigned>(_mm_movemask_ps(inRange)) & 0xF;
+    }
+
+    unsigned NonUnitQuaternionMask(const XrQuaternionf* first, size_t stride)
+    {
+        __m128 x = _mm_loadu_ps(&StridedElement(first, stride, 0).x);
+        __m128 y = _mm_loadu_ps(&StridedElement(first, stride, 1).x);
+        __m128 z = _mm_loadu_ps(&StridedElement(first, stride, 2).x);
+        __m128 w = _mm_loadu_ps(&StridedElement(first, stride, 3).x);
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+        const __m128 lengthSquared =
+            _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)), _mm_mul_ps(w, w));
+        const __m128 deviation = _mm_sub_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(lengthSquared));
+        const __m128 absDeviation = _mm_andnot_ps(_mm_set1_ps(-0.0f), deviation);
+        const __m128 unit = _mm_cmplt_ps(absDeviation, _mm_set1_ps(UnitQuaternionTolerance));
+        return ~static_cast<unsigned>(_mm_movemask_ps(unit)) & 0xF;
+    }
+
+    unsigned NonFiniteVector3fMask(const XrVector3f* first, size_t stride)
+    {
+        const XrVector3f& v0 = StridedElement(first, stride, 0);
+        const XrVector3f& v1 = StridedElement(first, stride, 1);
+        const XrVector3f& v2 = StridedElement(first, stride, 2);
+        const XrVector3f& v3 = StridedElement(first, stride, 3);
+        const __m128 x = _mm_setr_ps(v0.x, v1.x, v2.x, v3.x);
+        const __m128 y = _mm_setr_ps(v0.y, v1.y, v2.y, v3.y);
+        const __m128 z = _mm_setr_ps(v0.z, v1.z, v2.z, v3.z);
+        // v - v is zero for a finite v and NaN for NaN or infinity.
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 finite = _mm_and_ps(_mm_and_ps(_mm_cmpeq_ps(_mm_sub_ps(x, x), zero), _mm_cmpeq_ps(_mm_sub_ps(y, y), zero)),
+                                         _mm_cmpeq_ps(_mm_sub_ps(z, z), zero));
+        return ~static_cast<unsigned>(_mm_movemask_ps(finite)) & 0xF;
+    }
+#else
+    // Written as branch-free passes over the batch so that the compiler can vectorize them.
+    unsigned FloatOutOfRangeMask(const float* first, size_t stride, float min, float max)
+    {
+        unsigned mask = 0;
+        for (uint32_t i = 0; i < BatchWidth; ++i) {
+            const float v = StridedElement(first, stride, i);
+            mask |= static_cast<unsigned>(!(v >= min && v <= max)) << i;
+        }
+        return mask;
+    }
+
+    unsigned NonUnitQuaternionMask(const XrQuaternionf* first, size_t stride)
+    {
+        unsigned mask = 0;
+        for (uint32_t i = 0; i < BatchWidth; ++i) {
+            float length;
+            mask |= static_cast<unsigned>(!IsUnitQuaternion(StridedElement(first, stride, i), &length)) << i;
+        }
+        return mask;
+    }
+
+    unsigned NonFiniteVector3fMask(const XrVector3f* first, size_t stride)
+    {
+        unsigned mask = 0;
+        for (uint32_t i = 0; i < BatchWidth; ++i) {
+            const XrVector3f& v = StridedElement(first, stride, i);
+            mask |= static_cast<unsigned>(!(v.x - v.x == 0 && v.y - v.y == 0 && v.z - v.z == 0)) << i;
+        }
+        return mask;
+    }
+#endif
+
+    // Runs failureMask over the array a batch at a time and calls report(element, index) for each element that fails
+    // and has validBits set. A partial batch at the end is copied out and padded with its own first element.
+    template <typename T, typename FailureMask, typename Report>
+    void ValidateStridedArray(const T* first, size_t stride, uint32_t count, const XrFlags64* validFlags, XrFlags64 validBits,
+                              FailureMask failureMask, Report report)
+    {
+        for (uint32_t batchStart = 0; batchStart < count; batchStart += BatchWidth) {
+            const uint32_t batchCount = std::min(count - batchStart, BatchWidth);
+            unsigned mask;
+            if (batchCount == BatchWidth) {
+                mask = failureMask(&StridedElement(first, stride, batchStart), stride);
+            }
+            else {
+                T tail[BatchWidth];
+                for (uint32_t i = 0; i < BatchWidth; ++i) {
+                    tail[i] = StridedElement(first, stride, batchStart + (i < batchCount ? i : 0));
+                }
+                mask = failureMask(tail, sizeof(T)) & ((1u << batchCount) - 1);
+            }
+
+            for (uint32_t i = 0; mask != 0; ++i, mask >>= 1) {
+                const uint32_t index = batchStart + i;
+                if ((mask & 1) == 0 || (validFlags != nullptr && (StridedElement(validFlags, stride, index) & validBits) != validBits)) {
+                    continue;
+                }
+                report(StridedElement(first, stride, index), index);
+            }
+        }
+    }
+
+    struct ElementName
+    {
+        ElementName(const char* arrayName, uint32_t index, const char* memberName)
+        {
+            (void)snprintf(value, sizeof(value), "%s[%u].%s", arrayName, index, memberName);
+        }
+
+        char value[256];
+    };
+}  // namespace
+
+void ValidateFloatArray(ConformanceHooksBase* conformanceHook, const float* first, size_t stride, uint32_t count, float min, float max,
+                        const XrFlags64* validFlags, XrFlags64 validBits, const char* arrayName, const char* memberName,
+                        const char* xrFunctionName)
+{
+    ValidateStridedArray(
+        first, stride, count, validFlags, validBits, [=](const float* batch, size_t batchStride) {
+            return FloatOutOfRangeMask(batch, batchStride, min, max);
+        },
+        [&](float value, uint32_t index) {
+            conformanceHook->ConformanceFailure(XR_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT, xrFunctionName,
+                                                "%s float value is out of range [%f, %f]: %f",
+                                                ElementName(arrayName, index, memberName).value, min, max, value);
+        });
+}
+
+void ValidateXrQuaternionArray(ConformanceHooksBase* conformanceHook, const XrQuaternionf* first, size_t stride, uint32_t count,
+                               const XrFlags64* validFlags, XrFlags64 validBits, const char* arrayName, const char* memberName,
+                               const char* xrFunctionName)
+{
+    ValidateStridedArray(first, stride, count, validFlags, validBits, NonUnitQuaternionMask, [&](const XrQuaternionf& q, uint32_t index) {
+        ValidateXrQuaternion(conformanceHook, q, ElementName(arrayName, index, memberName).value, xrFunctionName);
+    });
+}
+
+void ValidateXrVector3fArray(ConformanceHooksBase* conformanceHook, const XrVector3f* first, size_t stride, uint32_t count,
+                             const XrFlags64* validFlags, XrFlags64 validBits, const char* arrayName, const char* memberName,
+                             const char* xrFunctionName)
+{
+    ValidateStridedArray(first, stride, count, validFlags, validBits, NonFiniteVector3fMask, [&](const XrVector3f& v, uint32_t index) {
+        ValidateXrVector3f(conformanceHook, v, ElementName(arrayName, index, memberName).value, xrFunctionName);
+    });
+}
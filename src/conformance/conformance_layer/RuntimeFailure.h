@@ -18,21 +18,45 @@
 
 #include "Common.h"
 #include "gen_dispatch.h"
+#include "ValidationSettings.h"
 #include <openxr/openxr_reflection.h>
 
 // Backs up the chain of type and next pointers. On destruction, validates there have been no changes.
 // This should be used on all non-const pointer arguments (out parameters).
+// The names must outlive the validator; the macros below pass string literals and __func__.
+// A single structure with a short chain, the usual case, is backed up inside the validator. Anything larger is backed
+// up in the thread's ScratchArena, so the validator must be destroyed before the hook's ScratchScope ends.
 struct XrBaseStructChainValidator
 {
-    XrBaseStructChainValidator(ConformanceHooksBase* conformanceHook, const void* arg, std::string parameterName, std::string functionName);
+    XrBaseStructChainValidator(ConformanceHooksBase* conformanceHook, const void* arg, const char* parameterName, const char* functionName);
+
+    // Validates the chains of each of the count structures in an array, each structSize bytes long, such as the views
+    // of xrLocateViews.
+    XrBaseStructChainValidator(ConformanceHooksBase* conformanceHook, const void* array, size_t structSize, uint32_t count,
+                               const char* parameterName, const char* functionName);
     ~XrBaseStructChainValidator();
 
+    XrBaseStructChainValidator(const XrBaseStructChainValidator&) = delete;
+    XrBaseStructChainValidator& operator=(const XrBaseStructChainValidator&) = delete;
+
 private:
+    const XrBaseInStructure* GetHead(uint32_t index) const
+    {
+        return reinterpret_cast<const XrBaseInStructure*>(m_array + index * m_structSize);
+    }
+
     ConformanceHooksBase* const m_conformanceHook;
-    const std::string m_parameterName;
-    const std::string m_functionName;
-    const XrBaseInStructure* const m_head;
-    std::deque<XrBaseInStructure> m_chainCache;
+    const char* const m_parameterName;
+    const char* const m_functionName;
+    const unsigned char* const m_array;
+    const size_t m_structSize;
+    const uint32_t m_count;
+    uint32_t* m_chainLengths{nullptr};         // Per structure, the number of entries in m_chainCache.
+    XrBaseInStructure* m_chainCache{nullptr};  // The chains of all the structures, one after another.
+
+    static constexpr uint32_t InlineChainLength = 4;
+    uint32_t m_inlineChainLength;
+    XrBaseInStructure m_inlineChain[InlineChainLength];
 };
 
 void ValidateXrBool32(ConformanceHooksBase* conformanceHook, XrBool32 value, const char* valueName, const char* xrFunctionName);
@@ -42,6 +66,21 @@ void ValidateXrTime(ConformanceHooksBase* conformanceHook, XrTime time, const ch
 void ValidateXrQuaternion(ConformanceHooksBase* conformanceHook, const XrQuaternionf& q, const char* valueName, const char* xrFunctionName);
 void ValidateXrVector3f(ConformanceHooksBase* conformanceHook, const XrVector3f& v, const char* valueName, const char* xrFunctionName);
 
+// Batch forms of the above for a member of each of the count elements of an array of structures, such as the poses of the
+// views from xrLocateViews or of the joints from xrLocateHandJointsEXT. first points at the member of the first element and
+// the others follow stride bytes apart. If validFlags is not null it points at the flags of the first element, at the same
+// stride, and elements without all of validBits set are not checked. Elements are checked four at a time, and a failure is
+// reported for arrayName[index].memberName as by the scalar functions.
+void ValidateFloatArray(ConformanceHooksBase* conformanceHook, const float* first, size_t stride, uint32_t count, float min, float max,
+                        const XrFlags64* validFlags, XrFlags64 validBits, const char* arrayName, const char* memberName,
+                        const char* xrFunctionName);
+void ValidateXrQuaternionArray(ConformanceHooksBase* conformanceHook, const XrQuaternionf* first, size_t stride, uint32_t count,
+                               const XrFlags64* validFlags, XrFlags64 validBits, const char* arrayName, const char* memberName,
+                               const char* xrFunctionName);
+void ValidateXrVector3fArray(ConformanceHooksBase* conformanceHook, const XrVector3f* first, size_t stride, uint32_t count,
+                             const XrFlags64* validFlags, XrFlags64 validBits, const char* arrayName, const char* memberName,
+                             const char* xrFunctionName);
+
 // clang-format off
 #define ENUM_CASE_BOOL(name, val) case name: return true;
 #define MAKE_IS_VALID_ENUM_VALUE(enumType, zeroIsValid) \
@@ -94,11 +133,37 @@ void ValidateXrEnum(ConformanceHooksBase* conformanceHook, TEnum value, const ch
         }                                                     \
     } while (false)
 
-#define CREATE_STRUCT_CHAIN_VALIDATOR(parameter) XrBaseStructChainValidator(this, parameter, #parameter, __func__)
+// Declares deepValidation, which says whether this call of the enclosing hot function validates its output structures
+// in depth. See ValidationSettings.h. State tracking must not be skipped based on it.
+#define SAMPLE_DEEP_VALIDATION()                           \
+    static ValidationSampler __deepValidationSampler;      \
+    const bool deepValidation = __deepValidationSampler.Sample()
+
 #define VALIDATE_STRUCT_CHAIN(parameter) const XrBaseStructChainValidator __chainValidator##parameter(this, parameter, #parameter, __func__)
+// As VALIDATE_STRUCT_CHAIN, but a no-op unless enabled is true.
+#define VALIDATE_STRUCT_CHAIN_IF(enabled, parameter) \
+    const XrBaseStructChainValidator __chainValidator##parameter(this, (enabled) ? parameter : nullptr, #parameter, __func__)
+// As VALIDATE_STRUCT_CHAIN_IF, for each of the count structures in the array parameter.
+#define VALIDATE_STRUCT_CHAIN_ARRAY_IF(enabled, parameter, count)                                                              \
+    const XrBaseStructChainValidator __chainValidator##parameter(this, (enabled) ? parameter : nullptr, sizeof(*parameter), \
+                                                                 (enabled) ? (count) : 0, #parameter, __func__)
 #define VALIDATE_XRBOOL32(value) ValidateXrBool32(this, value, #value, __func__)
 #define VALIDATE_FLOAT(value, min, max) ValidateFloat(this, value, min, max, #value, __func__)
 #define VALIDATE_XRTIME(value) ValidateXrTime(this, value, #value, __func__)
 #define VALIDATE_QUATERNION(value) ValidateXrQuaternion(this, value, #value, __func__)
 #define VALIDATE_VECTOR3F(value) ValidateXrVector3f(this, value, #value, __func__)
+// Validate member of each of the count elements of array, optionally only those whose flags member has all of validBits.
+#define VALIDATE_FLOAT_ARRAY(array, count, member, min, max) \
+    ValidateFloatArray(this, &(array)[0].member, sizeof(*(array)), count, min, max, nullptr, 0, #array, #member, __func__)
+#define VALIDATE_FLOAT_ARRAY_IF_FLAGS(array, count, member, min, max, flags, validBits)                                             \
+    ValidateFloatArray(this, &(array)[0].member, sizeof(*(array)), count, min, max, &(array)[0].flags, validBits, #array, #member, \
+                       __func__)
+#define VALIDATE_QUATERNION_ARRAY(array, count, member) \
+    ValidateXrQuaternionArray(this, &(array)[0].member, sizeof(*(array)), count, nullptr, 0, #array, #member, __func__)
+#define VALIDATE_QUATERNION_ARRAY_IF_FLAGS(array, count, member, flags, validBits) \
+    ValidateXrQuaternionArray(this, &(array)[0].member, sizeof(*(array)), count, &(array)[0].flags, validBits, #array, #member, __func__)
+#define VALIDATE_VECTOR3F_ARRAY(array, count, member) \
+    ValidateXrVector3fArray(this, &(array)[0].member, sizeof(*(array)), count, nullptr, 0, #array, #member, __func__)
+#define VALIDATE_VECTOR3F_ARRAY_IF_FLAGS(array, count, member, flags, validBits) \
+    ValidateXrVector3fArray(this, &(array)[0].member, sizeof(*(array)), count, &(array)[0].flags, validBits, #array, #member, __func__)
 #define VALIDATE_XRENUM(value) ValidateXrEnum(this, value, #value, __func__)
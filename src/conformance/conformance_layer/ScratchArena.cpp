@@ -0,0 +1,53 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ScratchArena.h"
+
+#include <algorithm>
+
+constexpr size_t ScratchArena::MinBlockSize;
+
+ScratchArena& ScratchArena::ForThisThread()
+{
+    static thread_local ScratchArena arena;
+    return arena;
+}
+
+void* ScratchArena::AllocateBytes(size_t size, size_t alignment)
+{
+    if (m_block < m_blocks.size()) {
+        const size_t offset = (m_offset + alignment - 1) & ~(alignment - 1);
+        if (offset + size <= m_blocks[m_block].size) {
+            m_offset = offset + size;
+            return m_blocks[m_block].data.get() + offset;
+        }
+
+        // Blocks after the current one are free, since everything in them was released.
+        ++m_block;
+    }
+
+    // Block data comes from new[], which aligns it for any fundamental type, so offset 0 suits any alignment.
+    if (m_block < m_blocks.size() && m_blocks[m_block].size < size) {
+        m_blocks.erase(m_blocks.begin() + m_block, m_blocks.end());
+    }
+    if (m_block == m_blocks.size()) {
+        const size_t blockSize = std::max(MinBlockSize, size);
+        m_blocks.push_back(Block{std::unique_ptr<unsigned char[]>(new unsigned char[blockSize]), blockSize});
+    }
+
+    m_offset = size;
+    return m_blocks[m_block].data.get();
+}
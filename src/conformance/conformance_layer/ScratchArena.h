@@ -0,0 +1,99 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+// Per-thread bump allocator for the temporaries of a hook call, such as copies of struct chains or of enumerated
+// values to inspect. Memory is handed out from blocks that the thread keeps for its lifetime, so once they have grown
+// to fit a call, later calls allocate nothing from the heap. Allocations are released in LIFO order through
+// ScratchScope, which every generated entry point opens for the duration of the call.
+class ScratchArena
+{
+public:
+    struct Mark
+    {
+        size_t block;
+        size_t offset;
+    };
+
+    static ScratchArena& ForThisThread();
+
+    // Returns uninitialized storage for count objects of T, valid until the enclosing ScratchScope ends.
+    template <typename T>
+    T* Allocate(size_t count)
+    {
+        static_assert(std::is_trivially_copyable<T>::value && std::is_trivially_destructible<T>::value,
+                      "The arena does not run constructors or destructors");
+        return static_cast<T*>(AllocateBytes(sizeof(T) * count, alignof(T)));
+    }
+
+    Mark GetMark() const
+    {
+        return {m_block, m_offset};
+    }
+
+    void Release(Mark mark)
+    {
+        m_block = mark.block;
+        m_offset = mark.offset;
+    }
+
+private:
+    static constexpr size_t MinBlockSize = 16 * 1024;
+
+    struct Block
+    {
+        std::unique_ptr<unsigned char[]> data;
+        size_t size;
+    };
+
+    void* AllocateBytes(size_t size, size_t alignment);
+
+    std::vector<Block> m_blocks;
+    size_t m_block = 0;
+    size_t m_offset = 0;
+};
+
+// Releases everything allocated from this thread's arena during the enclosing scope.
+class ScratchScope
+{
+public:
+    ScratchScope() : m_arena(ScratchArena::ForThisThread()), m_mark(m_arena.GetMark())
+    {
+    }
+
+    ~ScratchScope()
+    {
+        m_arena.Release(m_mark);
+    }
+
+    ScratchScope(const ScratchScope&) = delete;
+    ScratchScope& operator=(const ScratchScope&) = delete;
+
+    ScratchArena& Arena() const
+    {
+        return m_arena;
+    }
+
+private:
+    ScratchArena& m_arena;
+    const ScratchArena::Mark m_mark;
+};
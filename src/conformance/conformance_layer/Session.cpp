@@ -50,19 +50,24 @@ namespace session
 
     CustomSessionState* GetCustomSessionState(XrSession handle)
     {
-        return dynamic_cast<CustomSessionState*>(GetSessionState(handle)->customState.get());
+        return GetCustomState<CustomSessionState>(GetSessionState(handle));
     }
 
     void SessionStateChanged(ConformanceHooksBase* conformanceHooks, const XrEventDataSessionStateChanged* sessionStateChanged)
     {
-        // Check under the lock to guarantee xrEndFrame completes if it's being called on another thread.
         CustomSessionState* const customSessionState = GetCustomSessionState(sessionStateChanged->session);
         std::unique_lock<std::mutex> lock(customSessionState->lock);
+        // Check frameCount under the frame lock to guarantee xrEndFrame completes if it's being called on another thread.
+        std::unique_lock<std::mutex> frameLock(customSessionState->frameLock, std::defer_lock);
+        if (sessionStateChanged->state == XR_SESSION_STATE_SYNCHRONIZED) {
+            frameLock.lock();
+        }
 
-        if (!IsValidStateTransition(customSessionState->sessionState, sessionStateChanged->state)) {
+        const XrSessionState previousState = customSessionState->sessionState.load(std::memory_order_relaxed);
+        if (!IsValidStateTransition(previousState, sessionStateChanged->state)) {
             conformanceHooks->ConformanceFailure(XR_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT, "XrEventDataSessionStateChanged",
-                                                 "Invalid session state transition from %s to %s",
-                                                 to_string(customSessionState->sessionState), to_string(sessionStateChanged->state));
+                                                 "Invalid session state transition from %s to %s", to_string(previousState),
+                                                 to_string(sessionStateChanged->state));
         }
 
         if (sessionStateChanged->state == XR_SESSION_STATE_SYNCHRONIZED && !customSessionState->sessionBegun) {
@@ -92,7 +97,7 @@ namespace session
                                                  to_string(sessionStateChanged->state));
         }
 
-        customSessionState->sessionState = sessionStateChanged->state;
+        customSessionState->sessionState.store(sessionStateChanged->state, std::memory_order_relaxed);
     }
 
     void VisibilityMaskChanged(ConformanceHooksBase* conformanceHooks, const XrEventDataVisibilityMaskChangedKHR* visibilityMaskChanged)
@@ -176,23 +181,42 @@ XrResult ConformanceHooks::xrCreateSession(XrInstance instance, const XrSessionC
 
 XrResult ConformanceHooks::xrSyncActions(XrSession session, const XrActionsSyncInfo* syncInfo)
 {
+    CustomSessionState* const customSessionState = GetCustomSessionState(session);
+
+    // Marked before the runtime changes action state and cleared once the generations below record it, so that the
+    // xrGetActionState* hooks do not judge isActive against a sync the runtime has made but the layer not yet recorded.
+    customSessionState->syncsInProgress.fetch_add(1);
+    struct SyncInProgress
+    {
+        std::atomic<uint32_t>& count;
+        ~SyncInProgress()
+        {
+            count.fetch_sub(1);
+        }
+    } syncInProgress{customSessionState->syncsInProgress};
+
     const XrResult result = ConformanceHooksBase::xrSyncActions(session, syncInfo);
 
-    CustomSessionState* const customSessionState = GetCustomSessionState(session);
-    std::unique_lock<std::mutex> lock(customSessionState->lock);
+    std::unique_lock<std::mutex> lock(customSessionState->syncLock);
 
-    if (result == XR_SESSION_NOT_FOCUSED && customSessionState->sessionState == XR_SESSION_STATE_FOCUSED) {
+    const XrSessionState sessionState = customSessionState->sessionState.load(std::memory_order_relaxed);
+    if (result == XR_SESSION_NOT_FOCUSED && sessionState == XR_SESSION_STATE_FOCUSED) {
         // Suspicious but possibly legal if there is a queued-but-unobserved state change.
         POSSIBLE_NONCONFORMANT("XR_SESSION_NOT_FOCUSED returned when session state is XR_SESSION_STATE_FOCUSED");
     }
-    else if (result == XR_SUCCESS && customSessionState->sessionState != XR_SESSION_STATE_FOCUSED) {
+    else if (result == XR_SUCCESS && sessionState != XR_SESSION_STATE_FOCUSED) {
         // Suspicious but possibly legal if there is a queued-but-unobserved state change.
-        POSSIBLE_NONCONFORMANT("XR_SUCCESS returned when session state is %s", to_string(customSessionState->sessionState));
+        POSSIBLE_NONCONFORMANT("XR_SUCCESS returned when session state is %s", to_string(sessionState));
     }
 
-    // Notify each action set individually.
-    for (uint32_t i = 0; i < syncInfo->countActiveActionSets; i++) {
-        actionset::OnSyncActionData(result, &syncInfo->activeActionSets[i]);
+    // Only these results update action state; anything else leaves the previous sync's state in place.
+    if (result == XR_SUCCESS || result == XR_SESSION_NOT_FOCUSED) {
+        const uint64_t syncGeneration = customSessionState->syncGeneration.load(std::memory_order_relaxed) + 1;
+        for (uint32_t i = 0; i < syncInfo->countActiveActionSets; i++) {
+            actionset::OnSyncActionData(result, &syncInfo->activeActionSets[i], syncGeneration);
+        }
+        // Published after the action sets so a query that sees the new generation also sees which sets it included.
+        customSessionState->syncGeneration.store(syncGeneration, std::memory_order_release);
     }
     return result;
 }
@@ -200,23 +224,20 @@ XrResult ConformanceHooks::xrSyncActions(XrSession session, const XrActionsSyncI
 XrResult ConformanceHooks::xrLocateViews(XrSession session, const XrViewLocateInfo* viewLocateInfo, XrViewState* viewState,
                                          uint32_t viewCapacityInput, uint32_t* viewCountOutput, XrView* views)
 {
-    std::vector<XrBaseStructChainValidator> viewChainValidations;
-    for (uint32_t i = 0; i < viewCapacityInput; i++) {
-        viewChainValidations.emplace_back(CREATE_STRUCT_CHAIN_VALIDATOR(&views[i]));
-    }
+    SAMPLE_DEEP_VALIDATION();
+    VALIDATE_STRUCT_CHAIN_ARRAY_IF(deepValidation, views, viewCapacityInput);
 
     const XrResult result =
         ConformanceHooksBase::xrLocateViews(session, viewLocateInfo, viewState, viewCapacityInput, viewCountOutput, views);
 
     if (XR_SUCCEEDED(result)) {
         CustomSessionState* const customSessionState = GetCustomSessionState(session);
-        std::unique_lock<std::mutex> lock(customSessionState->lock);
 
-        NONCONFORMANT_IF(!customSessionState->sessionBegun, "Session must be begun");
+        NONCONFORMANT_IF(!customSessionState->sessionBegun.load(std::memory_order_relaxed), "Session must be begun");
 
         // TODO: What is status of viewState if called two-idiom style to look up capacity?
         // For now, only check ViewState if viewCountOutput > 0.
-        if (*viewCountOutput > 0) {
+        if (deepValidation && *viewCountOutput > 0) {
             if ((viewState->viewStateFlags & XR_VIEW_STATE_ORIENTATION_TRACKED_BIT) != 0 &&
                 (viewState->viewStateFlags & XR_VIEW_STATE_ORIENTATION_VALID_BIT) == 0) {
                 NONCONFORMANT("View state orientation cannot be tracked but invalid");
@@ -227,17 +248,14 @@ XrResult ConformanceHooks::xrLocateViews(XrSession session, const XrViewLocateIn
                 NONCONFORMANT("View state position cannot be tracked but invalid");
             }
 
-            for (uint32_t i = 0; i < *viewCountOutput; i++) {
-                const XrView& currentView = views[i];
-                if ((viewState->viewStateFlags & XR_VIEW_STATE_ORIENTATION_VALID_BIT) != 0) {
-                    VALIDATE_QUATERNION(currentView.pose.orientation);
-                }
-                if ((viewState->viewStateFlags & XR_VIEW_STATE_POSITION_VALID_BIT) != 0) {
-                    VALIDATE_VECTOR3F(currentView.pose.position);
-                }
-
-                // TODO: Validate FOV.
+            if ((viewState->viewStateFlags & XR_VIEW_STATE_ORIENTATION_VALID_BIT) != 0) {
+                VALIDATE_QUATERNION_ARRAY(views, *viewCountOutput, pose.orientation);
             }
+            if ((viewState->viewStateFlags & XR_VIEW_STATE_POSITION_VALID_BIT) != 0) {
+                VALIDATE_VECTOR3F_ARRAY(views, *viewCountOutput, pose.position);
+            }
+
+            // TODO: Validate FOV.
         }
     }
     return result;
@@ -269,9 +287,9 @@ XrResult ConformanceHooks::xrEndSession(XrSession session)
 
     if (XR_SUCCEEDED(result)) {
         NONCONFORMANT_IF(!customSessionState->sessionBegun, "Expected XR_ERROR_SESSION_NOT_RUNNING but got %s", to_string(result));
-        POSSIBLE_NONCONFORMANT_IF(customSessionState->sessionState != XR_SESSION_STATE_STOPPING,
+        POSSIBLE_NONCONFORMANT_IF(customSessionState->sessionState.load() != XR_SESSION_STATE_STOPPING,
                                   "Expected XR_ERROR_SESSION_NOT_STOPPING when last known session state was %s", to_string(result),
-                                  to_string(customSessionState->sessionState));
+                                  to_string(customSessionState->sessionState.load()));
 
         customSessionState->sessionBegun = false;
         customSessionState->sessionExitRequested = false;
@@ -281,7 +299,7 @@ XrResult ConformanceHooks::xrEndSession(XrSession session)
     }
     else if (result == XR_ERROR_SESSION_NOT_STOPPING) {
         POSSIBLE_NONCONFORMANT_IF(
-            customSessionState->sessionState == XR_SESSION_STATE_STOPPING,
+            customSessionState->sessionState.load() == XR_SESSION_STATE_STOPPING,
             "Unexpected XR_ERROR_SESSION_NOT_STOPPING failure when last observed session state was XR_SESSION_STATE_STOPPING");
     }
 
@@ -307,13 +325,18 @@ XrResult ConformanceHooks::xrRequestExitSession(XrSession session)
 
 XrResult ConformanceHooks::xrWaitFrame(XrSession session, const XrFrameWaitInfo* frameWaitInfo, XrFrameState* frameState)
 {
-    VALIDATE_STRUCT_CHAIN(frameState);
+    SAMPLE_DEEP_VALIDATION();
+    VALIDATE_STRUCT_CHAIN_IF(deepValidation, frameState);
+
+    const bool frameTimingEnabled = IsFrameTimingEnabled();
+    const auto waitStart = frameTimingEnabled ? FrameTimingAnalyzer::Clock::now() : FrameTimingAnalyzer::Clock::time_point{};
 
     const XrResult result = ConformanceHooksBase::xrWaitFrame(session, frameWaitInfo, frameState);
 
     if (XR_SUCCEEDED(result)) {
+        const auto waitEnd = frameTimingEnabled ? FrameTimingAnalyzer::Clock::now() : FrameTimingAnalyzer::Clock::time_point{};
         CustomSessionState* const customSessionState = GetCustomSessionState(session);
-        std::unique_lock<std::mutex> lock(customSessionState->lock);
+        std::unique_lock<std::mutex> lock(customSessionState->waitFrameLock);
 
         // SPEC: If a frame submitted to xrEndFrame is consumed by the compositor before its target display time, a subsequent call
         // to xrWaitFrame must block the caller until the start of the next rendering interval after the frame's target display time
@@ -324,6 +347,14 @@ XrResult ConformanceHooks::xrWaitFrame(XrSession session, const XrFrameWaitInfo*
 
         customSessionState->lastPredictedDisplayTime = frameState->predictedDisplayTime;
         customSessionState->lastPredictedDisplayPeriod = frameState->predictedDisplayPeriod;
+
+        if (frameTimingEnabled) {
+            const XrSessionState sessionState = customSessionState->sessionState.load(std::memory_order_relaxed);
+            const bool visible = sessionState == XR_SESSION_STATE_VISIBLE || sessionState == XR_SESSION_STATE_FOCUSED;
+            customSessionState->frameTiming.OnWaitFrame(waitEnd - waitStart, *frameState, visible);
+            const std::string report = customSessionState->frameTiming.TakeReport();
+            POSSIBLE_NONCONFORMANT_IF(!report.empty(), "%s", report.c_str());
+        }
     }
     return result;
 }
@@ -333,21 +364,29 @@ XrResult ConformanceHooks::xrBeginFrame(XrSession session, const XrFrameBeginInf
     const XrResult result = ConformanceHooksBase::xrBeginFrame(session, frameBeginInfo);
     if (XR_SUCCEEDED(result)) {
         CustomSessionState* const customSessionState = GetCustomSessionState(session);
-        std::unique_lock<std::mutex> lock(customSessionState->lock);
+        std::unique_lock<std::mutex> lock(customSessionState->frameLock);
         NONCONFORMANT_IF(customSessionState->frameBegun && result == XR_SUCCESS, "XR_FRAME_DISCARDED expected but XR_SUCCESS returned");
         NONCONFORMANT_IF(!customSessionState->frameBegun && result == XR_FRAME_DISCARDED,
                          "XR_SUCCESS expected but XR_FRAME_DISCARDED returned");
         customSessionState->frameBegun = true;
+        if (IsFrameTimingEnabled()) {
+            std::unique_lock<std::mutex> waitFrameLock(customSessionState->waitFrameLock);
+            customSessionState->frameTiming.OnBeginFrame(FrameTimingAnalyzer::Clock::now());
+        }
     }
     return result;
 }
 
 XrResult ConformanceHooks::xrEndFrame(XrSession session, const XrFrameEndInfo* frameEndInfo)
 {
-    // Call xrEndFrame under the lock because it might generate XR_SESSION_STATE_SYNCHRONIZED
+    // Taken before the call so the frame's time from xrBeginFrame does not include the runtime's submission.
+    const bool frameTimingEnabled = IsFrameTimingEnabled();
+    const auto endFrameStart = frameTimingEnabled ? FrameTimingAnalyzer::Clock::now() : FrameTimingAnalyzer::Clock::time_point{};
+
+    // Call xrEndFrame under the frame lock because it might generate XR_SESSION_STATE_SYNCHRONIZED
     // at any time during the call and frameCount needs to increment in unison.
     CustomSessionState* const customSessionState = GetCustomSessionState(session);
-    std::unique_lock<std::mutex> lock(customSessionState->lock);
+    std::unique_lock<std::mutex> lock(customSessionState->frameLock);
 
     const XrResult result = ConformanceHooksBase::xrEndFrame(session, frameEndInfo);
 
@@ -356,10 +395,14 @@ XrResult ConformanceHooks::xrEndFrame(XrSession session, const XrFrameEndInfo* f
                          "Unexpected success. XR_ERROR_CALL_ORDER_INVALID expected because xrBeginFrame was not called");
         customSessionState->frameBegun = false;
         customSessionState->frameCount++;
+        if (frameTimingEnabled) {
+            std::unique_lock<std::mutex> waitFrameLock(customSessionState->waitFrameLock);
+            customSessionState->frameTiming.OnEndFrame(endFrameStart);
+        }
     }
     else if (result == XR_ERROR_CALL_ORDER_INVALID) {
         // This error can also happen due to not having a released swapchain image available.
-        // std::unique_lock<std::mutex> lock(customSessionState->lock);
+        // std::unique_lock<std::mutex> lock(customSessionState->frameLock);
         // NONCONFORMANT_IF(customSessionState->frameBegun, "XR_ERROR_CALL_ORDER_INVALID returned but frame has been begun");
     }
     return result;
@@ -371,8 +414,7 @@ XrResult ConformanceHooks::xrEnumerateReferenceSpaces(XrSession session, uint32_
     const XrResult result = ConformanceHooksBase::xrEnumerateReferenceSpaces(session, spaceCapacityInput, spaceCountOutput, spaces);
     if (XR_SUCCEEDED(result)) {
         if (spaceCountOutput != nullptr && spaces != nullptr) {
-            std::vector<XrReferenceSpaceType> referenceSpaceCopy(spaces, spaces + *spaceCountOutput);
-            VectorInspection<XrReferenceSpaceType> referenceSpaceInspect(referenceSpaceCopy);
+            VectorInspection<XrReferenceSpaceType> referenceSpaceInspect(spaces, *spaceCountOutput);
 
             NONCONFORMANT_IF(referenceSpaceInspect.ContainsDuplicates(), "Duplicate reference spaces found");
 
@@ -388,16 +430,16 @@ XrResult ConformanceHooks::xrEnumerateReferenceSpaces(XrSession session, uint32_
             */
 
             CustomSessionState* const customSessionState = GetCustomSessionState(session);
-            std::unique_lock<std::mutex> lock(customSessionState->lock);
+            std::unique_lock<std::mutex> lock(customSessionState->enumerationLock);
 
             // If reference spaces are already cached, then make sure the enumeration function is returning the same results.
-            if (customSessionState->referenceSpaces.size() > 0) {
-                NONCONFORMANT_IF(!referenceSpaceInspect.SameElementsAs(customSessionState->referenceSpaces),
+            if (customSessionState->referenceSpaces.IsFilled()) {
+                NONCONFORMANT_IF(!referenceSpaceInspect.SameElementsAs(customSessionState->referenceSpaces.Values()),
                                  "References spaces differs from original enumeration of reference spaces.");
             }
             else {
                 // This is the first time the enumeration has been returned, so cache it.
-                customSessionState->referenceSpaces = std::move(referenceSpaceCopy);
+                customSessionState->referenceSpaces.Fill(spaces, *spaceCountOutput);
             }
         }
     }
@@ -414,7 +456,6 @@ XrResult ConformanceHooks::xrEnumerateSwapchainFormats(XrSession session, uint32
     if (formatCountOutput != nullptr && formats != nullptr) {
         CustomSessionState* const customSessionState = GetCustomSessionState(session);
 
-        std::unique_lock<std::mutex> lock(customSessionState->lock);
         if (customSessionState->headless) {
             NONCONFORMANT_IF(*formatCountOutput != 0, "Headless session must enumerate zero swapchain formats");
             return result;
@@ -424,14 +465,15 @@ XrResult ConformanceHooks::xrEnumerateSwapchainFormats(XrSession session, uint32
             NONCONFORMANT("Session must enumerate one or more swapchain formats");
         }
 
-        std::vector<int64_t> formatsCopy(formats, formats + *formatCountOutput);
-        VectorInspection<int64_t> formatsInspect(formatsCopy);
+        std::unique_lock<std::mutex> lock(customSessionState->enumerationLock);
+
+        VectorInspection<int64_t> formatsInspect(formats, *formatCountOutput);
         // TODO: Technically the spec doesn't disallow this explicitly like it does for reference spaces.
         NONCONFORMANT_IF(formatsInspect.ContainsDuplicates(), "Duplicate swapchain formats found");
 
         // If swapchain formats are already cached, then make sure the enumeration function is returning the same results.
-        if (customSessionState->swapchainFormats.size() > 0) {
-            NONCONFORMANT_IF(!formatsInspect.SameElementsAs(customSessionState->swapchainFormats),
+        if (customSessionState->swapchainFormats.IsFilled()) {
+            NONCONFORMANT_IF(!formatsInspect.SameElementsAs(customSessionState->swapchainFormats.Values()),
                              "Swapchain formats differs from original enumeration of swapchain formats");
 
             // TODO: Depending on the graphics API, Validate all swapchain formats are known good types.
@@ -439,7 +481,7 @@ XrResult ConformanceHooks::xrEnumerateSwapchainFormats(XrSession session, uint32
         }
         else {
             // This is the first time the enumeration has been returned, so cache it.
-            customSessionState->swapchainFormats = std::move(formatsCopy);
+            customSessionState->swapchainFormats.Fill(formats, *formatCountOutput);
         }
     }
 
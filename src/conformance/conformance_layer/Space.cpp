@@ -14,6 +14,8 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <limits>
+
 #include "ConformanceHooks.h"
 #include "CustomHandleState.h"
 #include "RuntimeFailure.h"
@@ -30,13 +32,29 @@ namespace space
 // ABI
 /////////////////
 
+XrResult ConformanceHooks::xrCreateReferenceSpace(XrSession session, const XrReferenceSpaceCreateInfo* createInfo, XrSpace* space)
+{
+    const XrResult result = ConformanceHooksBase::xrCreateReferenceSpace(session, createInfo, space);
+    if (XR_SUCCEEDED(result)) {
+        // Only checked once the app has enumerated the reference spaces, which it need not do.
+        const session::CustomSessionState* const customSessionState = session::GetCustomSessionState(session);
+        if (customSessionState->referenceSpaces.IsFilled()) {
+            NONCONFORMANT_IF(!customSessionState->referenceSpaces.Contains(createInfo->referenceSpaceType),
+                             "Created a reference space of type %d, which xrEnumerateReferenceSpaces did not return",
+                             createInfo->referenceSpaceType);
+        }
+    }
+    return result;
+}
+
 XrResult ConformanceHooks::xrLocateSpace(XrSpace space, XrSpace baseSpace, XrTime time, XrSpaceLocation* location)
 {
-    VALIDATE_STRUCT_CHAIN(location);
+    SAMPLE_DEEP_VALIDATION();
+    VALIDATE_STRUCT_CHAIN_IF(deepValidation, location);
 
     const XrResult result = ConformanceHooksBase::xrLocateSpace(space, baseSpace, time, location);
 
-    if (XR_SUCCEEDED(result)) {
+    if (XR_SUCCEEDED(result) && deepValidation) {
         if ((location->locationFlags & XR_SPACE_LOCATION_ORIENTATION_TRACKED_BIT) != 0 &&
             (location->locationFlags & XR_SPACE_LOCATION_ORIENTATION_VALID_BIT) == 0) {
             NONCONFORMANT("Location orientation cannot be tracked but invalid");
@@ -68,3 +86,50 @@ XrResult ConformanceHooks::xrLocateSpace(XrSpace space, XrSpace baseSpace, XrTim
     }
     return result;
 }
+
+XrResult ConformanceHooks::xrLocateHandJointsEXT(XrHandTrackerEXT handTracker, const XrHandJointsLocateInfoEXT* locateInfo,
+                                                XrHandJointLocationsEXT* locations)
+{
+    SAMPLE_DEEP_VALIDATION();
+    VALIDATE_STRUCT_CHAIN_IF(deepValidation, locations);
+
+    const XrResult result = ConformanceHooksBase::xrLocateHandJointsEXT(handTracker, locateInfo, locations);
+
+    if (XR_SUCCEEDED(result) && deepValidation) {
+        VALIDATE_XRBOOL32(locations->isActive);
+        if (locations->isActive == XR_FALSE) {
+            return result;
+        }
+
+        const XrHandJointLocationEXT* const joints = locations->jointLocations;
+        const uint32_t jointCount = locations->jointCount;
+        for (uint32_t i = 0; i < jointCount; i++) {
+            const XrSpaceLocationFlags flags = joints[i].locationFlags;
+            NONCONFORMANT_IF(
+                (flags & XR_SPACE_LOCATION_ORIENTATION_TRACKED_BIT) != 0 && (flags & XR_SPACE_LOCATION_ORIENTATION_VALID_BIT) == 0,
+                "Joint %u orientation cannot be tracked but invalid", i);
+            NONCONFORMANT_IF((flags & XR_SPACE_LOCATION_POSITION_TRACKED_BIT) != 0 && (flags & XR_SPACE_LOCATION_POSITION_VALID_BIT) == 0,
+                             "Joint %u position cannot be tracked but invalid", i);
+        }
+
+        VALIDATE_QUATERNION_ARRAY_IF_FLAGS(joints, jointCount, pose.orientation, locationFlags, XR_SPACE_LOCATION_ORIENTATION_VALID_BIT);
+        VALIDATE_VECTOR3F_ARRAY_IF_FLAGS(joints, jointCount, pose.position, locationFlags, XR_SPACE_LOCATION_POSITION_VALID_BIT);
+        VALIDATE_FLOAT_ARRAY_IF_FLAGS(joints, jointCount, radius, 0.0f, std::numeric_limits<float>::max(), locationFlags,
+                                      XR_SPACE_LOCATION_POSITION_VALID_BIT);
+
+        const XrHandJointVelocitiesEXT* velocities = nullptr;
+        ForEachExtension(locations->next, [&](const XrBaseInStructure* ext) {
+            if (ext->type == XR_TYPE_HAND_JOINT_VELOCITIES_EXT && velocities == nullptr) {
+                velocities = reinterpret_cast<const XrHandJointVelocitiesEXT*>(ext);
+            }
+        });
+        if (velocities != nullptr) {
+            const XrHandJointVelocityEXT* const jointVelocities = velocities->jointVelocities;
+            VALIDATE_VECTOR3F_ARRAY_IF_FLAGS(jointVelocities, velocities->jointCount, linearVelocity, velocityFlags,
+                                             XR_SPACE_VELOCITY_LINEAR_VALID_BIT);
+            VALIDATE_VECTOR3F_ARRAY_IF_FLAGS(jointVelocities, velocities->jointCount, angularVelocity, velocityFlags,
+                                             XR_SPACE_VELOCITY_ANGULAR_VALID_BIT);
+        }
+    }
+    return result;
+}
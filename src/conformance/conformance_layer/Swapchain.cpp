@@ -49,7 +49,7 @@ namespace swapchain
 
     CustomSwapchainState* GetCustomSwapchainState(XrSwapchain handle)
     {
-        return dynamic_cast<CustomSwapchainState*>(GetSwapchainState(handle)->customState.get());
+        return GetCustomState<CustomSwapchainState>(GetSwapchainState(handle));
     }
 
 }  // namespace swapchain
@@ -66,6 +66,12 @@ XrResult ConformanceHooks::xrCreateSwapchain(XrSession session, const XrSwapchai
         session::CustomSessionState* const customSessionState = session::GetCustomSessionState(session);
         GetSwapchainState(*swapchain)->customState =
             std::make_unique<CustomSwapchainState>(createInfo, customSessionState->graphicsBinding);
+
+        if (customSessionState->swapchainFormats.IsFilled()) {
+            NONCONFORMANT_IF(!customSessionState->swapchainFormats.Contains(createInfo->format),
+                             "Created a swapchain with format %lld, which xrEnumerateSwapchainFormats did not return",
+                             (long long)createInfo->format);
+        }
     }
     return result;
 }
@@ -77,27 +83,54 @@ XrResult ConformanceHooks::xrEnumerateSwapchainImages(XrSwapchain swapchain, uin
     if (XR_SUCCEEDED(result)) {
         if (imageCountOutput != nullptr) {
             CustomSwapchainState* const customSwapchainState = GetCustomSwapchainState(swapchain);
-            std::unique_lock<std::recursive_mutex> lock(customSwapchainState->mutex);
 
             NONCONFORMANT_IF(*imageCountOutput == 0, "Invalid empty image count.");
 
             NONCONFORMANT_IF(*imageCountOutput != 1 && customSwapchainState->isStatic, "Invalid image count %d for static swapchain.",
                              *imageCountOutput);
 
-            if (customSwapchainState->imageStates.empty()) {
+            uint32_t imageCount = customSwapchainState->imageCount.load(std::memory_order_acquire);
+            if (imageCount == 0 && *imageCountOutput != 0) {
                 // Set up initial image states once the capacity is known.
-                customSwapchainState->imageStates.resize(*imageCountOutput, ImageState::Created);
+                std::unique_lock<std::mutex> lock(customSwapchainState->setupMutex);
+                imageCount = customSwapchainState->imageCount.load(std::memory_order_relaxed);
+                if (imageCount == 0) {
+                    imageCount = *imageCountOutput;
+                    customSwapchainState->imageStates = std::make_unique<std::atomic<ImageState>[]>(imageCount);
+                    customSwapchainState->acquiredRing = std::make_unique<std::atomic<uint32_t>[]>(imageCount);
+                    for (uint32_t i = 0; i < imageCount; ++i) {
+                        customSwapchainState->imageStates[i].store(ImageState::Created, std::memory_order_relaxed);
+                        customSwapchainState->acquiredRing[i].store(0, std::memory_order_relaxed);
+                    }
+                    customSwapchainState->imageCount.store(imageCount, std::memory_order_release);
+                }
             }
 
-            NONCONFORMANT_IF(customSwapchainState->imageStates.size() != *imageCountOutput,
-                             "Image count %d differs from previous count %d.", *imageCountOutput,
-                             (uint32_t)customSwapchainState->imageStates.size());
+            NONCONFORMANT_IF(imageCount != *imageCountOutput, "Image count %d differs from previous count %d.", *imageCountOutput,
+                             imageCount);
+
+            const Conformance::IGraphicsValidator* const validator = customSwapchainState->graphicsValidator.get();
+            if (images != nullptr && validator != nullptr) {
+                const uint32_t count = std::min(imageCapacityInput, *imageCountOutput);
+                std::vector<bool> validate(count, true);
+                bool anyToValidate = false;
+                {
+                    std::unique_lock<std::mutex> lock(customSwapchainState->setupMutex);
+                    std::vector<uint64_t>& validatedImageKeys = customSwapchainState->validatedImageKeys;
+                    if (validatedImageKeys.size() < count) {
+                        validatedImageKeys.resize(count, 0);
+                    }
+                    for (uint32_t i = 0; i < count; i++) {
+                        const uint64_t key = validator->GetImageKey(images, i);
+                        validate[i] = key == 0 || key != validatedImageKeys[i];
+                        validatedImageKeys[i] = key;
+                        anyToValidate = anyToValidate || validate[i];
+                    }
+                }
 
-            if (images != nullptr) {
-                auto validator = Conformance::CreateGraphicsValidator(customSwapchainState->graphicsBinding);
-                if (validator) {
-                    validator->ValidateSwapchainImageStructs(this, customSwapchainState->createInfo.format, *imageCountOutput, images);
-                    validator->ValidateUsageFlags(this, customSwapchainState->createInfo.usageFlags, *imageCountOutput, images);
+                if (anyToValidate) {
+                    validator->ValidateSwapchainImageStructs(this, customSwapchainState->createInfo.format, count, images, validate);
+                    validator->ValidateUsageFlags(this, customSwapchainState->createInfo.usageFlags, count, images, validate);
                 }
             }
         }
@@ -110,31 +143,55 @@ XrResult ConformanceHooks::xrAcquireSwapchainImage(XrSwapchain swapchain, const
     const XrResult result = ConformanceHooksBase::xrAcquireSwapchainImage(swapchain, acquireInfo, index);
     if (XR_SUCCEEDED(result)) {
         CustomSwapchainState* const swapchainData = GetCustomSwapchainState(swapchain);
-        std::unique_lock<std::recursive_mutex> lock(swapchainData->mutex);
 
-        if (swapchainData->imageStates.empty()) {
-            // Must enumerate the swapchain images to set up the imageStates vector to the correct size.
+        if (swapchainData->imageCount.load(std::memory_order_acquire) == 0) {
+            // Must enumerate the swapchain images to set up the imageStates array to the correct size.
             // This is an unusual situation because it means the app is calling xrAcquireSwapchainImage without first enumerating the swapchain images.
             uint32_t imageCountOutput;
             const XrResult enumRes = ConformanceHooks::xrEnumerateSwapchainImages(swapchain, 0, &imageCountOutput, nullptr);
             NONCONFORMANT_IF(!XR_SUCCEEDED(enumRes), "Unable to enumerate swapchain images due to error %s", to_string(enumRes));
         }
-        else {
-            NONCONFORMANT_IF(*index >= swapchainData->imageStates.size(), "Out-of-bounds image index.");
+
+        const uint32_t imageCount = swapchainData->imageCount.load(std::memory_order_acquire);
+        if (*index >= imageCount) {
+            NONCONFORMANT("Out-of-bounds image index.");
+            return result;
+        }
+
+        // Checked before the image state changes, so that an acquire the ring cannot record leaves no image Acquired.
+        const uint64_t head = swapchainData->acquiredHead.load(std::memory_order_relaxed);
+        if (head - swapchainData->acquiredTail.load(std::memory_order_acquire) >= imageCount) {
+            NONCONFORMANT("Acquired more images than the swapchain has without releasing them.");
+            return result;
         }
 
-        ImageState& imageState = swapchainData->imageStates[*index];
+        const ImageState imageState = swapchainData->imageStates[*index].exchange(ImageState::Acquired, std::memory_order_acq_rel);
 
         NONCONFORMANT_IF(imageState == ImageState::Waited, "Acquired image in Waited state.");
         NONCONFORMANT_IF(imageState == ImageState::Acquired, "Acquired image already in Acquired state.");
         NONCONFORMANT_IF(imageState == ImageState::Released && swapchainData->isStatic, "Static image cannot be acquired again.");
 
-        imageState = ImageState::Acquired;
-        swapchainData->acquiredSwapchains.push(*index);
+        swapchainData->acquiredRing[head % imageCount].store(*index, std::memory_order_relaxed);
+        swapchainData->acquiredHead.store(head + 1, std::memory_order_release);
     }
     return result;
 }
 
+namespace
+{
+    // Returns the ring slot of the oldest acquired image that has not been released, or nullptr if there is none.
+    std::atomic<ImageState>* OldestAcquiredImageState(CustomSwapchainState* swapchainData)
+    {
+        const uint32_t imageCount = swapchainData->imageCount.load(std::memory_order_acquire);
+        const uint64_t tail = swapchainData->acquiredTail.load(std::memory_order_relaxed);
+        if (imageCount == 0 || tail == swapchainData->acquiredHead.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        const uint32_t imageIndex = swapchainData->acquiredRing[tail % imageCount].load(std::memory_order_relaxed);
+        return &swapchainData->imageStates[imageIndex];
+    }
+}  // namespace
+
 XrResult ConformanceHooks::xrWaitSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageWaitInfo* waitInfo)
 {
     auto waitStart = std::chrono::high_resolution_clock::now();
@@ -148,14 +205,14 @@ XrResult ConformanceHooks::xrWaitSwapchainImage(XrSwapchain swapchain, const XrS
     }
     else if (result == XR_SUCCESS) {
         CustomSwapchainState* const swapchainData = GetCustomSwapchainState(swapchain);
-        std::unique_lock<std::recursive_mutex> lock(swapchainData->mutex);
 
-        if (!swapchainData->acquiredSwapchains.empty()) {
-            const uint32_t waitIndex = swapchainData->acquiredSwapchains.front();
-            ImageState& imageState = swapchainData->imageStates[waitIndex];
-            NONCONFORMANT_IF(imageState != ImageState::Acquired, "Wait succeeded for image in wrong state %s", ToStr(imageState));
-
-            imageState = ImageState::Waited;
+        std::atomic<ImageState>* const imageState = OldestAcquiredImageState(swapchainData);
+        if (imageState != nullptr) {
+            ImageState expected = ImageState::Acquired;
+            if (!imageState->compare_exchange_strong(expected, ImageState::Waited, std::memory_order_acq_rel)) {
+                NONCONFORMANT("Wait succeeded for image in wrong state %s", ToStr(expected));
+                imageState->store(ImageState::Waited, std::memory_order_release);
+            }
         }
         else {
             NONCONFORMANT("Wait succeeded with no acquired image.");
@@ -172,15 +229,15 @@ XrResult ConformanceHooks::xrReleaseSwapchainImage(XrSwapchain swapchain, const
     const XrResult result = ConformanceHooksBase::xrReleaseSwapchainImage(swapchain, releaseInfo);
     if (XR_SUCCEEDED(result)) {
         CustomSwapchainState* const swapchainData = GetCustomSwapchainState(swapchain);
-        std::unique_lock<std::recursive_mutex> lock(swapchainData->mutex);
 
-        if (!swapchainData->acquiredSwapchains.empty()) {
-            const uint32_t waitIndex = swapchainData->acquiredSwapchains.front();
-            ImageState& imageState = swapchainData->imageStates[waitIndex];
-            NONCONFORMANT_IF(imageState != ImageState::Waited, "Release succeeded for image in wrong state %s", ToStr(imageState));
-
-            imageState = ImageState::Released;
-            swapchainData->acquiredSwapchains.pop();
+        std::atomic<ImageState>* const imageState = OldestAcquiredImageState(swapchainData);
+        if (imageState != nullptr) {
+            ImageState expected = ImageState::Waited;
+            if (!imageState->compare_exchange_strong(expected, ImageState::Released, std::memory_order_acq_rel)) {
+                NONCONFORMANT("Release succeeded for image in wrong state %s", ToStr(expected));
+                imageState->store(ImageState::Released, std::memory_order_release);
+            }
+            swapchainData->acquiredTail.fetch_add(1, std::memory_order_release);
         }
         else {
             NONCONFORMANT("Release succeeded with no acquired image.");
@@ -0,0 +1,73 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ValidationSettings.h"
+
+#include "platform_utils.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace
+{
+    constexpr const char* ValidationEnvVar = "XR_CONFORMANCE_LAYER_VALIDATION";
+
+    ValidationSettings ParseValidationSettings(const std::string& value)
+    {
+        ValidationSettings settings;
+        if (value.empty() || value == "full") {
+            return settings;
+        }
+        if (value == "minimal") {
+            settings.level = ValidationLevel::Minimal;
+            return settings;
+        }
+        if (value == "passthrough") {
+            settings.level = ValidationLevel::Passthrough;
+            return settings;
+        }
+
+        const std::string sampledPrefix = "sampled";
+        if (value.compare(0, sampledPrefix.size(), sampledPrefix) == 0) {
+            if (value.size() == sampledPrefix.size()) {
+                settings.level = ValidationLevel::Sampled;
+                return settings;
+            }
+            // Anything after "sampled" must be ":" and a positive decimal interval, so that a typo does not quietly
+            // sample at some other rate.
+            const char* digits = value.c_str() + sampledPrefix.size() + 1;
+            char* end = nullptr;
+            const unsigned long interval =
+                (value[sampledPrefix.size()] == ':' && *digits >= '0' && *digits <= '9') ? std::strtoul(digits, &end, 10) : 0;
+            if (interval > 0 && interval <= UINT32_MAX && end != nullptr && *end == '\0') {
+                settings.level = ValidationLevel::Sampled;
+                settings.sampleInterval = (uint32_t)interval;
+                return settings;
+            }
+        }
+
+        std::cerr << "Unrecognized " << ValidationEnvVar << " value '" << value << "', using full validation" << std::endl;
+        return settings;
+    }
+}  // namespace
+
+const ValidationSettings& GetValidationSettings()
+{
+    static const ValidationSettings settings = ParseValidationSettings(PlatformUtilsGetEnv(ValidationEnvVar));
+    return settings;
+}
@@ -0,0 +1,71 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// How much of the hand-written output validation the layer runs. Selected once per process with the
+// XR_CONFORMANCE_LAYER_VALIDATION environment variable:
+//   "full"       - Deep-validate every call (default).
+//   "sampled:N"  - Deep-validate one in every N calls of each sampled function. N is a positive integer and defaults
+//                  to 16 when omitted ("sampled").
+//   "minimal"    - Skip output struct deep validation entirely, keeping only state tracking, result code checks and the
+//                  action type check of xrGetActionState*.
+//   "passthrough" - As minimal, and functions without hand-written validation are not hooked at all: xrGetInstanceProcAddr
+//                  returns the runtime's function, so they get no result code checks, latency histograms or call trace.
+//                  Creating and destroying handles whose state no hook uses is passed through too.
+// Any other value, such as "sampled:0", is reported and treated as "full".
+enum class ValidationLevel
+{
+    Full,
+    Sampled,
+    Minimal,
+    Passthrough,
+};
+
+struct ValidationSettings
+{
+    ValidationLevel level{ValidationLevel::Full};
+    uint32_t sampleInterval{16};
+};
+
+const ValidationSettings& GetValidationSettings();
+
+// Decides whether a call to a hot function (per-frame or per-action) gets deep validation of its output structures.
+// Keep one per call site so each function is sampled independently.
+class ValidationSampler
+{
+public:
+    bool Sample()
+    {
+        const ValidationSettings& settings = GetValidationSettings();
+        switch (settings.level) {
+        case ValidationLevel::Sampled:
+            return (m_callCount.fetch_add(1, std::memory_order_relaxed) % settings.sampleInterval) == 0;
+        case ValidationLevel::Minimal:
+        case ValidationLevel::Passthrough:
+            return false;
+        case ValidationLevel::Full:
+        default:
+            return true;
+        }
+    }
+
+private:
+    std::atomic<uint32_t> m_callCount{0};
+};
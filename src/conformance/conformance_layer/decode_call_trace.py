@@ -0,0 +1,143 @@
+#!/usr/bin/python3
+#
+# Copyright (c) 2019-2022, The Khronos Group Inc.
+#
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Decodes the binary call trace written by the conformance layer when XR_CONFORMANCE_LAYER_TRACE is set.
+
+The trace is a ring, so it holds the most recent calls of the run. Records are printed in start time order,
+one per line, or as CSV with --csv. --summary prints per-function totals instead. Times are seconds since the
+trace was opened; --wall-clock prints them as local time instead.
+"""
+
+import argparse
+import collections
+import datetime
+import os
+import re
+import struct
+import sys
+
+FORMAT_HEADER = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..', 'common', 'call_trace_format.h')
+
+
+def read_format(path):
+    """Returns the constants of call_trace_format.h, which defines the layout for the layer and for this script."""
+    with open(path, 'r') as f:
+        text = f.read()
+    layout = {'Magic': re.search(r'constexpr char Magic\[\] = "(\w+)";', text).group(1).encode('ascii')}
+    for name, expression in re.findall(r'constexpr u?int\d+_t (\w+) = ([^;]+);', text):
+        layout[name] = eval(expression, {'__builtins__': {}}, dict(layout))
+    return layout
+
+
+# The type of each header and record field, at the offsets call_trace_format.h gives.
+HEADER_FIELDS = [('VersionOffset', 'I'), ('RecordSizeOffset', 'I'), ('RecordCapacityOffset', 'Q'),
+                 ('FunctionCountOffset', 'I'), ('ThreadCountOffset', 'I'), ('SteadyStartOffset', 'q'),
+                 ('SystemStartOffset', 'q'), ('RecordsReservedOffset', 'Q')]
+RECORD_FIELDS = [('RecordStartOffset', 'q'), ('RecordThreadOffset', 'I'), ('RecordFunctionOffset', 'H'),
+                 ('RecordHandleOffset', 'Q'), ('RecordResultOffset', 'i'), ('RecordDurationOffset', 'I')]
+
+
+def read_trace(path, layout):
+    with open(path, 'rb') as f:
+        data = f.read()
+
+    def unpack(fields, base):
+        return [struct.unpack_from('<' + kind, data, base + layout[offset])[0] for offset, kind in fields]
+
+    version, record_size, capacity, function_count, thread_count, steady_start, system_start, reserved = \
+        unpack(HEADER_FIELDS, 0)
+    if data[:layout['MagicSize']] != layout['Magic'] or version != layout['Version'] or \
+            record_size != layout['RecordSize']:
+        raise ValueError('{} is not a version {} conformance layer call trace'.format(path, layout['Version']))
+
+    names = []
+    name_size = layout['FunctionNameSize']
+    for i in range(min(function_count, layout['MaxFunctions'])):
+        offset = layout['HeaderSize'] + i * name_size
+        names.append(data[offset:offset + name_size].split(b'\0', 1)[0].decode('ascii', errors='replace'))
+
+    records = []
+    for i in range(capacity):
+        record = unpack(RECORD_FIELDS, layout['RecordsOffset'] + i * record_size)
+        if record[0] != 0:
+            records.append(tuple(record))
+    records.sort()
+
+    info = {'threads': thread_count, 'reserved': reserved, 'capacity': capacity,
+            'steady_start': steady_start, 'system_start': system_start}
+    return info, names, records
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('trace', help='trace file written by the layer')
+    parser.add_argument('--csv', action='store_true', help='print CSV instead of aligned text')
+    parser.add_argument('--summary', action='store_true', help='print per-function call counts and durations')
+    parser.add_argument('--wall-clock', action='store_true', help='print start times as local time')
+    parser.add_argument('--function', action='append', help='only print calls of this function (may be repeated)')
+    parser.add_argument('--thread', type=int, action='append', help='only print calls on this thread (may be repeated)')
+    parser.add_argument('--failed', action='store_true', help='only print calls that returned an error')
+    parser.add_argument('--format-header', default=FORMAT_HEADER,
+                        help='call_trace_format.h describing the layout (default: the one in this source tree)')
+    args = parser.parse_args()
+
+    info, names, records = read_trace(args.trace, read_format(args.format_header))
+
+    def name_of(function_id):
+        return names[function_id] if function_id < len(names) else '#{}'.format(function_id)
+
+    records = [r for r in records
+               if (not args.function or name_of(r[2]) in args.function) and
+               (not args.thread or r[1] in args.thread) and
+               (not args.failed or r[4] < 0)]
+
+    dropped = max(0, info['reserved'] - info['capacity'])
+    print('# {} calls on {} threads{}'.format(len(records), info['threads'],
+                                              ', oldest {} calls overwritten'.format(dropped) if dropped else ''),
+          file=sys.stderr)
+
+    if args.summary:
+        totals = collections.OrderedDict()
+        for _, _, function_id, _, result, duration_ns in records:
+            count, failed, total_ns, max_ns = totals.get(function_id, (0, 0, 0, 0))
+            totals[function_id] = (count + 1, failed + (result < 0), total_ns + duration_ns, max(max_ns, duration_ns))
+        rows = sorted(totals.items(), key=lambda item: -item[1][2])
+        if args.csv:
+            print('function,calls,failed,total_us,mean_us,max_us')
+        else:
+            print('{:48} {:>10} {:>8} {:>14} {:>10} {:>10}'.format('function', 'calls', 'failed', 'total_us', 'mean_us', 'max_us'))
+        for function_id, (count, failed, total_ns, max_ns) in rows:
+            fields = (name_of(function_id), count, failed, total_ns / 1000.0, total_ns / 1000.0 / count, max_ns / 1000.0)
+            print(('{},{},{},{:.1f},{:.1f},{:.1f}' if args.csv else '{:48} {:10} {:8} {:14.1f} {:10.1f} {:10.1f}').format(*fields))
+        return 0
+
+    if args.csv:
+        print('start,thread,function,handle,result,duration_us')
+    for start_ns, thread, function_id, handle, result, duration_ns in records:
+        if args.wall_clock:
+            seconds = (info['system_start'] + start_ns - info['steady_start']) / 1e9
+            start = datetime.datetime.fromtimestamp(seconds).strftime('%H:%M:%S.%f')
+        else:
+            start = '{:.6f}'.format((start_ns - info['steady_start']) / 1e9)
+        fields = (start, thread, name_of(function_id), '0x{:x}'.format(handle), result, duration_ns / 1000.0)
+        print(('{},{},{},{},{},{:.1f}' if args.csv else '{:>16} {:4} {:48} {:>18} {:6} {:10.1f}').format(*fields))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -26,13 +26,19 @@
 #include <conformance_framework.h>
 #include <conformance_utils.h>
 #include <openxr/openxr.h>
+#include <algorithm>
+#include <chrono>
 #include <vector>
 #include <string>
 #include <string.h>
 #include <unordered_map>
 
+#include "allocation_tracking.h"
 #include "conformance_test.h"
+#include "junit_stream.h"
 #include "report.h"
+#include "results_stream.h"
+#include "RGBAImage.h"
 #include "utils.h"
 #include "platform_utils.hpp"
 #include "filesystem_utils.hpp"
@@ -45,6 +51,29 @@ namespace
 {
     const ConformanceLaunchSettings* g_conformanceLaunchSettings = nullptr;
 
+    // Open while the tests of a run with --resultsStream execute.
+    ResultsStream g_resultsStream;
+
+    // Open while the tests of a run with --junitStream execute.
+    JUnitStream g_junitStream;
+
+    // Open while the tests of a run with --incremental execute, with the fingerprint its results are added under.
+    ResultsStream g_incrementalResults;
+    std::string g_incrementalFingerprint;
+
+    // Carries all output of xrcRunConformanceTests to conformanceLaunchSettings->message on a writer thread.
+    BufferedReportSink g_reportSink;
+
+    // The allocations of each test case run, in a build with BUILD_CONFORMANCE_ALLOCATION_TRACKING.
+    std::vector<std::pair<std::string, AllocationCounts>> g_testCaseAllocations;
+
+    void SendTestMessage(MessageType messageType, const char* message)
+    {
+        if (!g_reportSink.Post(messageType, message)) {
+            g_conformanceLaunchSettings->message(messageType, message);
+        }
+    }
+
     /// Console output redirection
     class ConsoleStream : public std::streambuf
     {
@@ -69,7 +98,7 @@ namespace
         {
             // if our buffer has anything meaningful, flush to the conformance_test host.
             if (m_s.length() > 0) {
-                g_conformanceLaunchSettings->message(m_messageType, m_s.c_str());
+                SendTestMessage(m_messageType, m_s.c_str());
                 m_s.clear();
             }
             return 0;
@@ -198,6 +227,8 @@ namespace
                 globalData.options.viewConfigurationValue = XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO;
             else if (striequal(globalData.options.viewConfiguration.c_str(), "mono"))
                 globalData.options.viewConfigurationValue = XR_VIEW_CONFIGURATION_TYPE_PRIMARY_MONO;
+            else if (striequal(globalData.options.viewConfiguration.c_str(), "quad"))
+                globalData.options.viewConfigurationValue = XR_VIEW_CONFIGURATION_TYPE_PRIMARY_QUAD_VARJO;
             else {
                 ReportF("invalid arg: %s", globalData.options.viewConfiguration.c_str());
                 return ParserResult::runtimeError("invalid view config '" + arg + "' passed on command line");
@@ -205,6 +236,36 @@ namespace
             return ParserResult::ok(ParseResultType::Matched);
         };
 
+        /// Handle secondary view config arg
+        auto const parseSecondaryViewConfig = [&](std::string const& arg) {
+            using namespace Conformance;
+            GlobalData& globalData = GetGlobalData();
+            globalData.options.secondaryViewConfiguration = arg;
+            if (striequal(arg.c_str(), "firstpersonobserver"))
+                globalData.options.secondaryViewConfigurationValue = XR_VIEW_CONFIGURATION_TYPE_SECONDARY_MONO_FIRST_PERSON_OBSERVER_MSFT;
+            else {
+                ReportF("invalid arg: %s", arg.c_str());
+                return ParserResult::runtimeError("invalid secondary view config '" + arg + "' passed on command line");
+            }
+            return ParserResult::ok(ParseResultType::Matched);
+        };
+
+        /// Handle view swapchains arg
+        auto const parseViewSwapchains = [&](std::string const& arg) {
+            using namespace Conformance;
+            GlobalData& globalData = GetGlobalData();
+            globalData.options.viewSwapchains = arg;
+            if (striequal(arg.c_str(), "separate"))
+                globalData.options.viewSwapchainArrays = false;
+            else if (striequal(arg.c_str(), "array"))
+                globalData.options.viewSwapchainArrays = true;
+            else {
+                ReportF("invalid arg: %s", arg.c_str());
+                return ParserResult::runtimeError("invalid view swapchains '" + arg + "' passed on command line");
+            }
+            return ParserResult::ok(ParseResultType::Matched);
+        };
+
         /// Handle blend mode arg
         auto const parseBlendMode = [&](std::string const& arg) {
             using namespace Conformance;
@@ -224,13 +285,49 @@ namespace
             return ParserResult::ok(ParseResultType::Matched);
         };
 
+        /// Handle swapchain coverage arg
+        auto const parseSwapchainCoverage = [&](std::string const& arg) {
+            using namespace Conformance;
+            GlobalData& globalData = GetGlobalData();
+            globalData.options.swapchainCoverage = arg;
+            if (striequal(arg.c_str(), "onefactor"))
+                globalData.options.swapchainCoveragePairwise = false;
+            else if (striequal(arg.c_str(), "pairwise"))
+                globalData.options.swapchainCoveragePairwise = true;
+            else {
+                ReportF("invalid arg: %s", arg.c_str());
+                return ParserResult::runtimeError("invalid swapchain coverage '" + arg + "' passed on command line");
+            }
+            return ParserResult::ok(ParseResultType::Matched);
+        };
+
+        /// Handle thread affinity and priority args, for the frame loop and worker threads
+        auto const makeAffinityParser = [&](Conformance::ThreadScheduling& scheduling) {
+            return [&scheduling](std::string const& arg) {
+                if (!Conformance::ParseThreadAffinity(arg, scheduling)) {
+                    ReportF("invalid arg: %s", arg.c_str());
+                    return ParserResult::runtimeError("invalid thread affinity '" + arg + "' passed on command line");
+                }
+                return ParserResult::ok(ParseResultType::Matched);
+            };
+        };
+        auto const makePriorityParser = [&](Conformance::ThreadScheduling& scheduling) {
+            return [&scheduling](std::string const& arg) {
+                if (!Conformance::ParseThreadPriority(arg, scheduling)) {
+                    ReportF("invalid arg: %s", arg.c_str());
+                    return ParserResult::runtimeError("invalid thread priority '" + arg + "' passed on command line");
+                }
+                return ParserResult::ok(ParseResultType::Matched);
+            };
+        };
+
         // NOTE: End of line comments are to encourage clang-format to work the way we want it to for this mini embedded DSL.
         // Clara requires that the "short" args be a single letter - we use capital letters here to avoid colliding with Catch2-provided
         // options.
         auto cli =
             Opt(options.graphicsPlugin,
-                "Vulkan|Vulkan2|OpenGLES|OpenGL|D3D11|D3D12")  // graphics plugin
-                ["-G"]["--graphicsPlugin"]                     //
+                "Vulkan|Vulkan2|OpenGLES|OpenGL|D3D11|D3D12|Null")  // graphics plugin
+                ["-G"]["--graphicsPlugin"]                          //
             ("Specify a graphics plugin to use. Required.")
                 .required()
 
@@ -244,9 +341,19 @@ namespace
               ("Specify a form factor to use. Default is HMD.")
                   .optional()
 
-            | Opt(parseViewConfig, "Stereo|Mono")  // view configuration
-                  ["-V"]["--viewConfiguration"]    //
-              ("Specify view configuration. Default is Stereo.")
+            | Opt(parseViewConfig, "Stereo|Mono|Quad")  // view configuration
+                  ["-V"]["--viewConfiguration"]         //
+              ("Specify view configuration. Quad enables XR_VARJO_quad_views. Default is Stereo.")
+                  .optional()
+
+            | Opt(parseSecondaryViewConfig, "FirstPersonObserver")  // secondary view configuration
+                  ["--secondaryViewConfiguration"]                  //
+              ("Also render this secondary view configuration while active, with XR_MSFT_secondary_view_configuration. Default is none.")
+                  .optional()
+
+            | Opt(parseViewSwapchains, "Separate|Array")  // view swapchains
+                  ["--viewSwapchains"]                    //
+              ("Render the views of equal size into one array swapchain, or each into its own. Default is Separate.")
                   .optional()
 
             | Opt(parseBlendMode, "Opaque|Additive|AlphaBlend")  // blend mode
@@ -279,6 +386,141 @@ namespace
               ("Disables tests that requires disconnectable devices (for debugging).")
                   .optional()
 
+            | Opt(options.multithreadingMaxThreads, "thread count")  // Multithreading benchmark thread count
+                  ["--multithreadingMaxThreads"]                     //
+              ("Specify the maximum thread count of the multithreading benchmark. Default is the hardware concurrency.")
+                  .optional()
+
+            | Opt(parseSwapchainCoverage, "OneFactor|Pairwise")  // Swapchain parameter coverage
+                  ["--swapchainCoverage"]                        //
+              ("Specify how swapchain creation parameters are combined. Default is OneFactor.")
+                  .optional()
+
+            | Opt(options.poolInstances)     // Instance pooling
+                  ["--poolInstances"]        //
+              ("Reuses instances between test cases that allow it, instead of creating one per test case.")
+                  .optional()
+
+            | Opt(options.reuseSectionFixtures)  // Section fixture reuse
+                  ["--reuseSectionFixtures"]     //
+              ("Keeps the fixtures of test cases that share them across sections, instead of making them for every section.")
+                  .optional()
+
+            | Opt(options.resultsStreamFile, "file")  // Results stream
+                  ["--resultsStream"]                 //
+              ("Write per-test-case and per-section timing to this file as JSON lines while the tests run.")
+                  .optional()
+
+            | Opt(options.junitStreamFile, "file")  // JUnit stream
+                  ["--junitStream"]                 //
+              ("Write each test case to this file as JUnit XML as soon as it ends; gzip compressed if the name ends in .gz.")
+                  .optional()
+
+            | Opt(options.junitStreamSyncSeconds, "seconds")  // JUnit stream sync interval
+                  ["--junitStreamSyncSeconds"]                //
+              ("Sync the --junitStream file to storage at most this many seconds apart; 0 syncs after every test case.")
+                  .optional()
+
+            | Opt(options.replayTraceFile, "file")  // Trace replay
+                  ["--replayTrace"]                 //
+              ("Replay this conformance layer call trace in the Trace Replay Benchmark.")
+                  .optional()
+
+            | Opt(options.replayOriginalTiming)  // Trace replay timing
+                  ["--replayOriginalTiming"]     //
+              ("Issue replayed calls at their traced times instead of as fast as possible.")
+                  .optional()
+
+            | Opt(options.capabilitySnapshotFile, "file")  // Capability snapshot
+                  ["--capabilitySnapshot"]                 //
+              ("Keep what probing the runtime finds at startup in this file, and read it back instead while the runtime is the same.")
+                  .optional()
+
+            | Opt(options.vulkanPipelineCacheFile, "file")  // Vulkan pipeline cache
+                  ["--vulkanPipelineCache"]                 //
+              ("Load and save the Vulkan plugin's pipeline cache in this file, so later runs skip most pipeline compiles.")
+                  .optional()
+
+            | Opt(options.d3d12PipelineLibraryFile, "file")  // D3D12 pipeline library
+                  ["--d3d12PipelineLibrary"]                 //
+              ("Load and save the D3D12 plugin's pipeline library in this file, so later runs skip most pipeline compiles.")
+                  .optional()
+
+            | Opt(options.vulkanRecordThreads, "thread count")  // Vulkan parallel view recording
+                  ["--vulkanRecordThreads"]                     //
+              ("Record the views of each frame in the Vulkan plugin on this many threads, into secondary command buffers.")
+                  .optional()
+
+            | Opt(options.d3d11RecordThreads, "thread count")  // D3D11 deferred context recording
+                  ["--d3d11RecordThreads"]                     //
+              ("Record the views of each frame in the D3D11 plugin on this many threads, on deferred contexts.")
+                  .optional()
+
+            | Opt(options.swapchainWaitThreads, "thread count")  // Parallel swapchain image waits
+                  ["--swapchainWaitThreads"]                     //
+              ("Acquire all swapchain images of a frame, then wait for them on this many threads at once. Not with OpenGL.")
+                  .optional()
+
+            | Opt(makeAffinityParser(options.frameLoopScheduling), "cpus|big")  // Frame loop affinity
+                  ["--frameLoopAffinity"]                                        //
+              ("Run frame loops on these CPUs, such as 0,2-3, or on the big cores. Default is unchanged.")
+                  .optional()
+
+            | Opt(makePriorityParser(options.frameLoopScheduling), "Normal|High|Realtime")  // Frame loop priority
+                  ["--frameLoopPriority"]                                                    //
+              ("Run frame loops at this thread priority. Realtime usually needs privileges. Default is Normal.")
+                  .optional()
+
+            | Opt(makeAffinityParser(options.workerScheduling), "cpus|big")  // Worker affinity
+                  ["--workerAffinity"]                                        //
+              ("Run the multithreading test workers on these CPUs, such as 0,2-3, or on the big cores. Default is unchanged.")
+                  .optional()
+
+            | Opt(makePriorityParser(options.workerScheduling), "Normal|High|Realtime")  // Worker priority
+                  ["--workerPriority"]                                                    //
+              ("Run the multithreading test workers at this thread priority. Default is Normal.")
+                  .optional()
+
+            | Opt(options.cpuCounters)  // CPU counters
+                  ["--cpuCounters"]     //
+              ("Count CPU cycles, instructions, cache misses and context switches in the benchmark frame loops.")
+                  .optional()
+
+            | Opt(options.powerSampleInterval, "milliseconds")  // Power sampling
+                  ["--powerSampleInterval"]                     //
+              ("Sample battery power and thermal status this often in the sustained-load benchmarks. Android only.")
+                  .optional()
+
+            | Opt(options.shardCount, "shard count")  // Shard count
+                  ["--shardCount"]                    //
+              ("Split the selected test cases into this many parts and run only one of them. Default is 1.")
+                  .optional()
+
+            | Opt(options.shardIndex, "shard index")  // Shard index
+                  ["--shardIndex"]                    //
+              ("Specify the zero-based part to run when --shardCount is used. Default is 0.")
+                  .optional()
+
+            | Opt(options.shardTimingFiles, "file")  // Shard timing
+                  ["--shardTiming"]                   //
+              ("Balance the parts by the test case times in this results stream of an earlier run. May repeat.")
+                  .optional()
+
+            | Opt(options.incrementalResultsFile, "file")  // Incremental run
+                  ["--incremental"]                        //
+              ("Record results in this file and run only the test cases that failed or did not run for this runtime and options.")
+                  .optional()
+
+            | Opt(options.incrementalRerunTags, "tag")  // Incremental run tags
+                  ["--incrementalRerunTag"]             //
+              ("Also run the test cases with this tag, such as [actions], in an --incremental run. May repeat.")
+                  .optional()
+
+            | Opt(options.incrementalFullRun)  // Incremental full run
+                  ["--incrementalFullRun"]     //
+              ("Run every selected test case in an --incremental run, still recording the results.")
+                  .optional()
+
             | Opt([&](bool /* flag */) { options.fileLineLoggingEnabled = false; })  // disable file/line logging
                   ["-F"]["--disableFileLineLogging"]                                 //
               ("Disables logging file/line data.")
@@ -305,9 +547,14 @@ namespace
         }
 
         globalData.enabledAPILayerNames = globalData.options.enabledAPILayers;
-        globalData.enabledInstanceExtensionNames = globalData.options.enabledInstanceExtensions;
+        globalData.SetEnabledInstanceExtensions(globalData.options.enabledInstanceExtensions);
         globalData.enabledInteractionProfiles = globalData.options.enabledInteractionProfiles;
 
+        if (globalData.options.shardCount == 0 || globalData.options.shardIndex >= globalData.options.shardCount) {
+            ReportStr("shardIndex must be less than shardCount.");
+            return false;
+        }
+
         // Check for required parameters.
         if (GetGlobalData().options.graphicsPlugin.empty()) {  // If no graphics system was specified...
             if (GetGlobalData().IsGraphicsPluginRequired()) {  // and if one is required...
@@ -319,6 +566,217 @@ namespace
         return result == 0;
     }
 
+    // Returns, for each of the names, the shard it runs in. Without recorded times the names are dealt out in turn.
+    // With them, each test case in turn from the longest goes to the shard with the least time so far, so that the
+    // long test cases are spread out first and the short ones fill in around them. Test cases with no recorded time
+    // are counted at the mean of the recorded ones. Every process computes the same assignment from the same inputs.
+    std::vector<uint32_t> AssignTestShards(const std::vector<std::string>& names, uint32_t shardCount,
+                                           const std::unordered_map<std::string, double>& testCaseSeconds)
+    {
+        std::vector<uint32_t> shards(names.size());
+        if (testCaseSeconds.empty()) {
+            for (size_t i = 0; i < names.size(); ++i) {
+                shards[i] = (uint32_t)(i % shardCount);
+            }
+            return shards;
+        }
+
+        double recordedSeconds = 0.0;
+        for (const auto& entry : testCaseSeconds) {
+            recordedSeconds += entry.second;
+        }
+        const double unrecordedSeconds = recordedSeconds / testCaseSeconds.size();
+
+        std::vector<double> seconds(names.size());
+        std::vector<size_t> order(names.size());
+        for (size_t i = 0; i < names.size(); ++i) {
+            auto it = testCaseSeconds.find(names[i]);
+            seconds[i] = it == testCaseSeconds.end() ? unrecordedSeconds : it->second;
+            order[i] = i;
+        }
+        // Stable, so that equal times keep the name order.
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return seconds[a] > seconds[b]; });
+
+        std::vector<double> shardSeconds(shardCount, 0.0);
+        for (size_t i : order) {
+            const uint32_t shard = (uint32_t)(std::min_element(shardSeconds.begin(), shardSeconds.end()) - shardSeconds.begin());
+            shards[i] = shard;
+            shardSeconds[shard] += seconds[i];
+        }
+        return shards;
+    }
+
+    // Returns the test cases that the command line selects, sorted by name so that the selection does not depend on
+    // the test order options.
+    std::vector<Catch::TestCase> GetSelectedTestCases(Catch::Session& catchSession)
+    {
+        const Catch::Config& config = catchSession.config();
+        std::vector<Catch::TestCase> testCases =
+            Catch::filterTests(Catch::getAllTestCasesSorted(config), config.testSpec(), config);
+        std::sort(testCases.begin(), testCases.end(),
+                  [](const Catch::TestCase& a, const Catch::TestCase& b) { return a.name < b.name; });
+        return testCases;
+    }
+
+    // Narrows the command line selection to exactly these test cases, which must not be empty.
+    void UseTestCases(Catch::Session& catchSession, const std::vector<Catch::TestCase>& testCases)
+    {
+        // Quoted test names only match exactly.
+        std::string testSpec;
+        for (const Catch::TestCase& testCase : testCases) {
+            if (!testSpec.empty()) {
+                testSpec += ',';
+            }
+            testSpec += '"' + testCase.name + '"';
+        }
+
+        Catch::ConfigData configData = catchSession.configData();
+        configData.testsOrTags = {testSpec};
+        catchSession.useConfigData(configData);
+    }
+
+    // Identifies the runtime and whatever in the options changes what the tests do, for the results of --incremental
+    // runs. Where results and capabilities are written, how the run is split and the incremental options themselves are
+    // left out.
+    std::string GetIncrementalFingerprint(const GlobalData& globalData)
+    {
+        Options keyOptions = globalData.GetOptions();
+        keyOptions.resultsStreamFile.clear();
+        keyOptions.junitStreamFile.clear();
+        keyOptions.junitStreamSyncSeconds = 0;
+        keyOptions.capabilitySnapshotFile.clear();
+        keyOptions.shardCount = 1;
+        keyOptions.shardIndex = 0;
+        keyOptions.shardTimingFiles.clear();
+        keyOptions.incrementalResultsFile.clear();
+        keyOptions.incrementalRerunTags.clear();
+        keyOptions.incrementalFullRun = false;
+
+        const XrInstanceProperties& instanceProperties = globalData.GetInstanceProperties();
+        std::string key = instanceProperties.runtimeName;
+        AppendSprintf(key, " %u.%u.%u\n", XR_VERSION_MAJOR(instanceProperties.runtimeVersion),
+                      XR_VERSION_MINOR(instanceProperties.runtimeVersion), XR_VERSION_PATCH(instanceProperties.runtimeVersion));
+        key += keyOptions.DescribeOptions();
+
+        // 64-bit FNV-1a
+        uint64_t hash = 0xcbf29ce484222325ull;
+        for (char c : key) {
+            hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001b3ull;
+        }
+        std::string fingerprint;
+        AppendSprintf(fingerprint, "%016llx", static_cast<unsigned long long>(hash));
+        return fingerprint;
+    }
+
+    // Keeps the test cases whose last result under the fingerprint is a failure or missing, and those with any of the
+    // tags. Tags may be given with or without their brackets, in any case.
+    void SelectIncrementalTestCases(std::vector<Catch::TestCase>& testCases, const std::unordered_map<std::string, bool>& testCasePassed,
+                                    const std::vector<std::string>& rerunTags)
+    {
+        std::vector<std::string> lcaseRerunTags;
+        for (const std::string& tag : rerunTags) {
+            std::string lcaseTag = Catch::toLower(tag);
+            if (lcaseTag.size() >= 2 && lcaseTag.front() == '[' && lcaseTag.back() == ']') {
+                lcaseTag = lcaseTag.substr(1, lcaseTag.size() - 2);
+            }
+            lcaseRerunTags.push_back(lcaseTag);
+        }
+
+        auto isUpToDate = [&](const Catch::TestCase& testCase) {
+            for (const std::string& tag : lcaseRerunTags) {
+                if (std::find(testCase.lcaseTags.begin(), testCase.lcaseTags.end(), tag) != testCase.lcaseTags.end()) {
+                    return false;
+                }
+            }
+            auto it = testCasePassed.find(testCase.name);
+            return it != testCasePassed.end() && it->second;
+        };
+        testCases.erase(std::remove_if(testCases.begin(), testCases.end(), isUpToDate), testCases.end());
+    }
+
+    // Narrows the test cases to the shardIndex-th of shardCount parts. They must be sorted by name, so that every
+    // shard process splits them the same way.
+    void SelectTestShard(std::vector<Catch::TestCase>& testCases, uint32_t shardIndex, uint32_t shardCount,
+                         const std::vector<std::string>& timingFiles)
+    {
+        std::vector<std::string> names;
+        for (const Catch::TestCase& testCase : testCases) {
+            names.push_back(testCase.name);
+        }
+
+        std::unordered_map<std::string, double> testCaseSeconds;
+        for (const std::string& file : timingFiles) {
+            if (!ReadTestCaseSeconds(file, testCaseSeconds)) {
+                ReportF("Could not read shard timing file %s.", file.c_str());
+            }
+        }
+        const std::vector<uint32_t> shards = AssignTestShards(names, shardCount, testCaseSeconds);
+
+        std::vector<Catch::TestCase> shardTestCases;
+        for (size_t i = 0; i < testCases.size(); ++i) {
+            if (shards[i] == shardIndex) {
+                shardTestCases.push_back(testCases[i]);
+            }
+        }
+        testCases.swap(shardTestCases);
+    }
+
+    // The allocations made on the test thread between Begin and End. Spans nest: a span's peak is measured from its own
+    // start, and the enclosing span's peak is restored at its end.
+    class AllocationSpan
+    {
+    public:
+        void Begin()
+        {
+            m_enclosingPeak = ResetThreadAllocationPeak();
+            m_start = GetThreadAllocationCounts();
+        }
+
+        // Returns the counts since Begin, with the live and peak bytes relative to those at Begin.
+        AllocationCounts End()
+        {
+            const AllocationCounts end = GetThreadAllocationCounts();
+            RaiseThreadAllocationPeak(m_enclosingPeak);
+
+            AllocationCounts span;
+            span.count = end.count - m_start.count;
+            span.bytes = end.bytes - m_start.bytes;
+            span.liveBytes = end.liveBytes - m_start.liveBytes;
+            span.peakLiveBytes = end.peakLiveBytes - m_start.liveBytes;
+            return span;
+        }
+
+    private:
+        AllocationCounts m_start;
+        int64_t m_enclosingPeak{0};
+    };
+
+    void AddAllocationCounts(JsonLine& line, const AllocationCounts& counts)
+    {
+        line.Add("allocations", counts.count)
+            .Add("allocatedBytes", counts.bytes)
+            .Add("peakAllocatedBytes", static_cast<uint64_t>(std::max<int64_t>(counts.peakLiveBytes, 0)));
+    }
+
+    // Reports the test cases that allocated the most bytes.
+    void ReportAllocationsByTestCase()
+    {
+        constexpr size_t MaxReportedTestCases = 20;
+
+        std::sort(g_testCaseAllocations.begin(), g_testCaseAllocations.end(),
+                  [](const std::pair<std::string, AllocationCounts>& a, const std::pair<std::string, AllocationCounts>& b) {
+                      return a.second.bytes > b.second.bytes;
+                  });
+        std::string report = "Allocations by test case (test thread only):\n";
+        for (size_t i = 0; i < g_testCaseAllocations.size() && i < MaxReportedTestCases; ++i) {
+            const AllocationCounts& counts = g_testCaseAllocations[i].second;
+            AppendSprintf(report, "  %10llu allocations %14llu bytes %12lld peak bytes  %s\n",
+                          static_cast<unsigned long long>(counts.count), static_cast<unsigned long long>(counts.bytes),
+                          static_cast<long long>(counts.peakLiveBytes), g_testCaseAllocations[i].first.c_str());
+        }
+        ReportStr(report.c_str());
+    }
+
     // Implements a class that listens to the results of individual test runs. This is used for
     // collecting telemetry.
     struct ConformanceTestListener : Catch::TestEventListenerBase
@@ -327,33 +785,107 @@ namespace
 
         using TestEventListenerBase::TestEventListenerBase;  // inherit constructor
 
+        void testCaseStarting(Catch::TestCaseInfo const& testInfo) override
+        {
+            Base::testCaseStarting(testInfo);
+
+            m_testCaseStart = MonotonicClock::now();
+            m_testCaseStartCalls = CheckedCallCount().load();
+
+            // Written before the test runs so that a crash can be attributed to it.
+            g_resultsStream.Write(JsonLine().Add("event", "testCaseStarting").Add("testCase", testInfo.name));
+
+            // Test boundaries are flush points, so console output never lags more than one test case behind.
+            g_reportSink.Flush();
+
+            // Last, so that the listener's own allocations are not counted against the test case.
+            m_testCaseAllocations.Begin();
+        }
+
         void testCaseEnded(Catch::TestCaseStats const& testCaseStats) override
         {
+            const AllocationCounts allocations = m_testCaseAllocations.End();
             Base::testCaseEnded(testCaseStats);
 
             Conformance::GlobalData& globalData = Conformance::GetGlobalData();
+            globalData.ReleaseSectionFixtures();
             globalData.conformanceReport.testSuccessCount += testCaseStats.totals.testCases.passed;
             globalData.conformanceReport.testFailureCount += testCaseStats.totals.testCases.failed;
+
+            if (g_resultsStream.IsOpen()) {
+                const std::chrono::duration<double> duration = MonotonicClock::now() - m_testCaseStart;
+                JsonLine line;
+                line.Add("event", "testCaseEnded")
+                    .Add("testCase", testCaseStats.testInfo.name)
+                    .Add("passed", testCaseStats.totals.testCases.failed == 0)
+                    .Add("seconds", duration.count())
+                    .Add("assertionsPassed", static_cast<uint64_t>(testCaseStats.totals.assertions.passed))
+                    .Add("assertionsFailed", static_cast<uint64_t>(testCaseStats.totals.assertions.failed))
+                    .Add("checkedCalls", CheckedCallCount().load() - m_testCaseStartCalls)
+                    .Add("peakResidentBytes", GetPeakResidentBytes());
+                if (IsAllocationTrackingEnabled()) {
+                    AddAllocationCounts(line, allocations);
+                }
+                g_resultsStream.Write(line);
+            }
+            if (IsAllocationTrackingEnabled()) {
+                g_testCaseAllocations.emplace_back(testCaseStats.testInfo.name, allocations);
+            }
+            g_incrementalResults.Write(JsonLine()
+                                           .Add("fingerprint", g_incrementalFingerprint)
+                                           .Add("testCase", testCaseStats.testInfo.name)
+                                           .Add("passed", testCaseStats.totals.testCases.failed == 0));
+
+            g_reportSink.Flush();
         }
 
         void sectionStarting(Catch::SectionInfo const& sectionInfo) override
         {
             Base::sectionStarting(sectionInfo);
+            m_sectionStartCalls.push_back(CheckedCallCount().load());
 
             // Track test progress by outputting the current test section.
             std::string indentStr(m_sectionIndent * 2, ' ');
-            g_conformanceLaunchSettings->message(MessageType_TestSectionStarting,
-                                                 (indentStr + "Executing \"" + sectionInfo.name + "\" tests...").c_str());
+            SendTestMessage(MessageType_TestSectionStarting, (indentStr + "Executing \"" + sectionInfo.name + "\" tests...").c_str());
             m_sectionIndent++;
+
+            m_sectionAllocations.emplace_back();
+            m_sectionAllocations.back().Begin();
         }
         void sectionEnded(Catch::SectionStats const& sectionStats) override
         {
+            const AllocationCounts allocations = m_sectionAllocations.back().End();
+            m_sectionAllocations.pop_back();
+
+            if (g_resultsStream.IsOpen()) {
+                JsonLine line;
+                line.Add("event", "sectionEnded")
+                    .Add("testCase", currentTestCaseInfo->name)
+                    .Add("section", sectionStats.sectionInfo.name)
+                    .Add("depth", static_cast<uint64_t>(m_sectionStartCalls.size() - 1))
+                    .Add("seconds", sectionStats.durationInSeconds)
+                    .Add("assertionsPassed", static_cast<uint64_t>(sectionStats.assertions.passed))
+                    .Add("assertionsFailed", static_cast<uint64_t>(sectionStats.assertions.failed))
+                    .Add("checkedCalls", CheckedCallCount().load() - m_sectionStartCalls.back());
+                if (IsAllocationTrackingEnabled()) {
+                    AddAllocationCounts(line, allocations);
+                }
+                g_resultsStream.Write(line);
+            }
+            m_sectionStartCalls.pop_back();
+
+            // The outermost section is a whole run of the test case body. Its section fixtures are only kept for the
+            // next run if asked to, and if nothing failed that might have left them in a bad state.
+            if (m_sectionStartCalls.empty() &&
+                (!Conformance::GetGlobalData().options.reuseSectionFixtures || sectionStats.assertions.failed > 0)) {
+                Conformance::GetGlobalData().ReleaseSectionFixtures();
+            }
+
             // Show a summary if something failed but leave the details to the (e.g. console or xml) reporter.
             if (sectionStats.assertions.failed > 0) {
                 std::string indentStr(m_sectionIndent * 2, ' ');
-                g_conformanceLaunchSettings->message(
-                    MessageType_AssertionFailed,
-                    (indentStr + std::to_string(sectionStats.assertions.failed) + " assertion(s) failed").c_str());
+                SendTestMessage(MessageType_AssertionFailed,
+                                (indentStr + std::to_string(sectionStats.assertions.failed) + " assertion(s) failed").c_str());
             }
 
             Base::sectionEnded(sectionStats);
@@ -361,9 +893,116 @@ namespace
         }
 
         int m_sectionIndent{0};
+        MonotonicClock::time_point m_testCaseStart;
+        uint64_t m_testCaseStartCalls{0};
+        std::vector<uint64_t> m_sectionStartCalls;  // One entry per open section, outermost first.
+        AllocationSpan m_testCaseAllocations;
+        std::vector<AllocationSpan> m_sectionAllocations;  // One entry per open section, outermost first.
     };
     CATCH_REGISTER_LISTENER(ConformanceTestListener)
 
+    // Writes each test case to g_junitStream as it ends, with the failed assertions Catch2's junit reporter would give
+    // it. That reporter keeps every result until the end of the run, which grows without bound on long runs and loses
+    // everything to a crash.
+    struct JUnitStreamListener : Catch::TestEventListenerBase
+    {
+        using Base = Catch::TestEventListenerBase;
+
+        using TestEventListenerBase::TestEventListenerBase;  // inherit constructor
+
+        // Failed assertions past this many in one test case are only counted, so a test failing in a loop does not hold
+        // them all.
+        static constexpr size_t MaxFailuresPerTestCase = 100;
+
+        void testCaseStarting(Catch::TestCaseInfo const& testInfo) override
+        {
+            Base::testCaseStarting(testInfo);
+            m_testCaseStart = MonotonicClock::now();
+            m_failures.clear();
+            m_omittedFailureCount = 0;
+        }
+
+        void sectionStarting(Catch::SectionInfo const& sectionInfo) override
+        {
+            Base::sectionStarting(sectionInfo);
+            m_sections.push_back(sectionInfo.name);
+        }
+
+        void sectionEnded(Catch::SectionStats const& sectionStats) override
+        {
+            m_sections.pop_back();
+            Base::sectionEnded(sectionStats);
+        }
+
+        bool assertionEnded(Catch::AssertionStats const& assertionStats) override
+        {
+            const Catch::AssertionResult& result = assertionStats.assertionResult;
+            if (!g_junitStream.IsOpen() || result.isOk()) {
+                return Base::assertionEnded(assertionStats);
+            }
+            if (m_failures.size() == MaxFailuresPerTestCase) {
+                ++m_omittedFailureCount;
+                return Base::assertionEnded(assertionStats);
+            }
+
+            JUnitFailure failure;
+            if (result.getResultType() == Catch::ResultWas::ThrewException ||
+                result.getResultType() == Catch::ResultWas::FatalErrorCondition) {
+                failure.element = "error";
+            }
+            failure.message = result.getExpandedExpression();
+            failure.type = static_cast<std::string>(result.getTestMacroName());
+            if (!result.getMessage().empty()) {
+                failure.text += result.getMessage() + "\n";
+            }
+            for (const Catch::MessageInfo& info : assertionStats.infoMessages) {
+                if (info.type == Catch::ResultWas::Info) {
+                    failure.text += info.message + "\n";
+                }
+            }
+            // The outermost section is the test case itself.
+            for (size_t i = 1; i < m_sections.size(); ++i) {
+                failure.text += "in section " + m_sections[i] + "\n";
+            }
+            const Catch::SourceLineInfo& source = result.getSourceInfo();
+            failure.text += std::string("at ") + source.file + ":" + std::to_string(source.line);
+            m_failures.push_back(std::move(failure));
+            return Base::assertionEnded(assertionStats);
+        }
+
+        void testCaseEnded(Catch::TestCaseStats const& testCaseStats) override
+        {
+            if (g_junitStream.IsOpen()) {
+                if (m_omittedFailureCount > 0) {
+                    JUnitFailure omitted;
+                    omitted.message = std::to_string(m_omittedFailureCount) + " more failed assertions";
+                    omitted.type = "omitted";
+                    m_failures.push_back(std::move(omitted));
+                }
+                // A test case that fails without a failed assertion, such as one that was expected to fail and did not,
+                // still gets a failure.
+                if (m_failures.empty() && testCaseStats.totals.testCases.failed > 0) {
+                    JUnitFailure failure;
+                    failure.message = "test case failed";
+                    failure.type = "testCase";
+                    m_failures.push_back(std::move(failure));
+                }
+                const std::chrono::duration<double> duration = MonotonicClock::now() - m_testCaseStart;
+                const std::string& className = testCaseStats.testInfo.className;
+                g_junitStream.WriteTestCase(className.empty() ? "conformance" : className, testCaseStats.testInfo.name,
+                                            duration.count(), m_failures);
+            }
+            m_failures.clear();
+            Base::testCaseEnded(testCaseStats);
+        }
+
+        MonotonicClock::time_point m_testCaseStart;
+        std::vector<std::string> m_sections;  // One entry per open section, outermost first.
+        std::vector<JUnitFailure> m_failures;
+        size_t m_omittedFailureCount{0};
+    };
+    CATCH_REGISTER_LISTENER(JUnitStreamListener)
+
     static Catch::Session catchSession;  // Only one Catch Session can ever be created.
 }  // namespace
 
@@ -429,7 +1068,24 @@ XrcResult XRAPI_CALL xrcRunConformanceTests(const ConformanceLaunchSettings* con
     XrcResult result = XRC_SUCCESS;
     bool conformanceTestsRun = false;
     try {
-        Conformance::g_reportCallback = [&](const char* message) { conformanceLaunchSettings->message(MessageType_Stdout, message); };
+        g_reportSink.Start([](int messageType, const char* message) {
+            g_conformanceLaunchSettings->message(static_cast<MessageType>(messageType), message);
+        });
+        Conformance::g_reportCallback = [](const char* message) { SendTestMessage(MessageType_Stdout, message); };
+        Conformance::g_benchmarkSamplesCallback = [](const char* label, const std::vector<int64_t>& nanosecondSamples) {
+            if (g_resultsStream.IsOpen()) {
+                // Labels end with the ':' that leads into the percentiles on the console.
+                std::string metric = label;
+                while (!metric.empty() && (metric.back() == ':' || metric.back() == ' ')) {
+                    metric.pop_back();
+                }
+                g_resultsStream.Write(JsonLine()
+                                          .Add("event", "benchmarkSamples")
+                                          .Add("testCase", Catch::getResultCapture().getCurrentTestName())
+                                          .Add("label", metric)
+                                          .Add("nanoseconds", nanosecondSamples));
+            }
+        };
 
         // Disable loader error output by default, as we intentionally generate errors.
         if (!PlatformUtilsGetEnvSet("XR_LOADER_DEBUG"))      // If not already set to something...
@@ -442,6 +1098,7 @@ XrcResult XRAPI_CALL xrcRunConformanceTests(const ConformanceLaunchSettings* con
 
         if (!UpdateOptionsFromCommandLine(catchSession, conformanceLaunchSettings->argc, conformanceLaunchSettings->argv)) {
             ReportStr("Test failure: Command line arguments were invalid or insufficient.");
+            g_reportSink.Stop();
             return XRC_ERROR_COMMAND_LINE_INVALID;
         }
 
@@ -458,9 +1115,100 @@ XrcResult XRAPI_CALL xrcRunConformanceTests(const ConformanceLaunchSettings* con
         }
 
         if (initialized) {
-            *failureCount = catchSession.run();
+            const Options& options = GetGlobalData().options;
+            if (!options.resultsStreamFile.empty()) {
+                if (g_resultsStream.Open(options.resultsStreamFile)) {
+                    g_resultsStream.Write(JsonLine()
+                                              .Add("event", "testRunStarting")
+                                              .Add("shardIndex", static_cast<uint64_t>(options.shardIndex))
+                                              .Add("shardCount", static_cast<uint64_t>(options.shardCount)));
+                }
+                else {
+                    ReportF("Could not open results stream file %s.", options.resultsStreamFile.c_str());
+                }
+            }
+            if (!options.junitStreamFile.empty()) {
+                if (!g_junitStream.Open(options.junitStreamFile, "conformance",
+                                        std::chrono::seconds(options.junitStreamSyncSeconds))) {
+                    ReportF("Could not open JUnit stream file %s%s.", options.junitStreamFile.c_str(),
+                            JUnitStream::SupportsCompression() ? "" : " (gzip output needs BUILD_CONFORMANCE_ZLIB)");
+                }
+            }
+
+            bool narrowed = false;
+            std::vector<Catch::TestCase> testCases;
+            if (!options.incrementalResultsFile.empty() || options.shardCount > 1) {
+                testCases = GetSelectedTestCases(catchSession);
+                narrowed = true;
+            }
+
+            // Shard the whole selection, before the incremental results narrow it: the shards run at once and append to
+            // the same file, so each would read it at a different point and split a different list.
+            if (options.shardCount > 1) {
+                SelectTestShard(testCases, options.shardIndex, options.shardCount, options.shardTimingFiles);
+            }
+
+            if (!options.incrementalResultsFile.empty()) {
+                g_incrementalFingerprint = GetIncrementalFingerprint(GetGlobalData());
+                if (!options.incrementalFullRun) {
+                    // A missing file is a first run, with no results yet.
+                    std::unordered_map<std::string, bool> testCasePassed;
+                    ReadTestCaseResults(options.incrementalResultsFile, g_incrementalFingerprint, testCasePassed);
+                    const size_t selectedCount = testCases.size();
+                    SelectIncrementalTestCases(testCases, testCasePassed, options.incrementalRerunTags);
+                    ReportF("Incremental run under fingerprint %s: %zu of %zu selected test cases failed, did not run or are "
+                            "tagged to rerun.",
+                            g_incrementalFingerprint.c_str(), testCases.size(), selectedCount);
+                }
+                if (!g_incrementalResults.Open(options.incrementalResultsFile, true)) {
+                    ReportF("Could not open incremental results file %s.", options.incrementalResultsFile.c_str());
+                }
+            }
+
+            // The example images are only shown next to interactive tests, so only decode them ahead when one will run.
+            const std::vector<Catch::TestCase> runTestCases = narrowed ? testCases : GetSelectedTestCases(catchSession);
+            if (std::any_of(runTestCases.begin(), runTestCases.end(), [](const Catch::TestCase& testCase) {
+                    return std::find(testCase.lcaseTags.begin(), testCase.lcaseTags.end(), "interactive") != testCase.lcaseTags.end();
+                })) {
+                PreloadImagesAsync({"eye_visibility.png", "grip_and_aim_pose.png", "projection_array.png", "projection_mutable.png",
+                                    "projection_separate.png", "projection_wide.png", "quad_hands.png", "quad_occlusion.png",
+                                    "quad_poses.png", "source_alpha_blending.png", "subimage.png"});
+            }
+
+            if (narrowed && testCases.empty()) {
+                if (options.shardCount > 1) {
+                    ReportF("Shard %u of %u has no test cases to run.", options.shardIndex, options.shardCount);
+                }
+                else {
+                    ReportStr("No test cases to run.");
+                }
+                *failureCount = 0;
+            }
+            else {
+                if (narrowed) {
+                    UseTestCases(catchSession, testCases);
+                }
+                *failureCount = catchSession.run();
+            }
+            g_incrementalResults.Close();
+            g_junitStream.Close();
             conformanceTestsRun = true;
 
+            if (IsAllocationTrackingEnabled()) {
+                ReportAllocationsByTestCase();
+            }
+
+            if (g_resultsStream.IsOpen()) {
+                const ConformanceReport& cr = GetGlobalData().GetConformanceReport();
+                g_resultsStream.Write(JsonLine()
+                                          .Add("event", "testRunEnded")
+                                          .Add("testSuccessCount", static_cast<uint64_t>(cr.testSuccessCount))
+                                          .Add("testFailureCount", static_cast<uint64_t>(cr.testFailureCount))
+                                          .Add("fastAssertionPassCount", cr.fastAssertionPassCount.load())
+                                          .Add("peakResidentBytes", GetPeakResidentBytes()));
+                g_resultsStream.Close();
+            }
+
             GetGlobalData().Shutdown();
         }
         else {
@@ -489,6 +1237,8 @@ XrcResult XRAPI_CALL xrcRunConformanceTests(const ConformanceLaunchSettings* con
             report.c_str());
     }
 
+    // The launch settings message function must not be called after we return.
+    g_reportSink.Stop();
     g_conformanceLaunchSettings = nullptr;
     return result;
 }
@@ -149,7 +149,7 @@ namespace Conformance
 
         // Create a sample image quad layer placed to the right.
         XrCompositionLayerQuad* const exampleQuad =
-            compositionHelper.CreateQuadLayer(compositionHelper.CreateStaticSwapchainImage(RGBAImage::Load(exampleImage)), localSpace,
+            compositionHelper.CreateQuadLayer(compositionHelper.CreateStaticSwapchainImage(*RGBAImage::LoadShared(exampleImage)), localSpace,
                                               1.25f, {{0, 0, 0, 1}, {1.5f, 0, -0.3f}});
         XrQuaternionf_CreateFromAxisAngle(&exampleQuad->pose.orientation, &Up, -70 * MATH_PI / 180);
 
@@ -252,22 +252,20 @@ namespace Conformance
                 }
             }
 
-            auto viewData = compositionHelper.LocateViews(localSpace, frameState.predictedDisplayTime);
-            const auto& viewState = std::get<XrViewState>(viewData);
+            const auto views = compositionHelper.LocateViews(localSpace, frameState.predictedDisplayTime);
+            const auto& viewState = views.viewState;
 
             std::vector<XrCompositionLayerBaseHeader*> layers;
             if (viewState.viewStateFlags & XR_VIEW_STATE_POSITION_VALID_BIT &&
                 viewState.viewStateFlags & XR_VIEW_STATE_ORIENTATION_VALID_BIT) {
-                const auto& views = std::get<std::vector<XrView>>(viewData);
-
                 // Render into each view port of the wide swapchain using the projection layer view fov and pose.
                 for (size_t view = 0; view < views.size(); view++) {
                     compositionHelper.AcquireWaitReleaseImage(
                         swapchains[view], [&](const XrSwapchainImageBaseHeader* swapchainImage, uint64_t format) {
-                            GetGlobalData().graphicsPlugin->ClearImageSlice(swapchainImage, 0, format);
                             const_cast<XrFovf&>(projLayer->views[view].fov) = views[view].fov;
                             const_cast<XrPosef&>(projLayer->views[view].pose) = views[view].pose;
-                            GetGlobalData().graphicsPlugin->RenderView(projLayer->views[view], swapchainImage, format, renderedCubes);
+                            GetGlobalData().graphicsPlugin->ClearAndRenderViews(&projLayer->views[view], 1, swapchainImage, format,
+                                                                                renderedCubes);
                         });
                 }
 
@@ -282,6 +280,6 @@ namespace Conformance
             return compositionHelper.PollEvents();
         };
 
-        RenderLoop(compositionHelper.GetSession(), update).Loop();
+        RenderLoop(compositionHelper, update).Loop();
     }
 }  // namespace Conformance
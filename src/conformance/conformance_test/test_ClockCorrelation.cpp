@@ -0,0 +1,331 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include "utils.h"
+#include "conformance_utils.h"
+#include "conformance_framework.h"
+#include "composition_utils.h"
+#include "report.h"
+#include <openxr/openxr.h>
+#include <catch2/catch.hpp>
+
+// Include all dependencies of openxr_platform as configured
+#include "xr_dependencies.h"
+#include <openxr/openxr_platform.h>
+
+#ifdef XR_USE_PLATFORM_WIN32
+#include <windows.h>
+#endif
+
+namespace Conformance
+{
+    namespace
+    {
+        constexpr int warmupCallCount = 1000;     // Per conversion direction, before measuring.
+        constexpr int measuredCallCount = 20000;  // Per conversion direction.
+
+        constexpr int driftSampleCount = 180;                          // Three minutes at one sample per second.
+        constexpr std::chrono::milliseconds driftSampleInterval{1000};  // Between drift samples.
+        constexpr int driftBracketAttempts = 8;                        // Reads of the host counter per drift sample.
+
+        constexpr int displayTimeWarmupFrameCount = 60;
+        constexpr int displayTimeMeasuredFrameCount = 1200;
+
+#if defined(XR_USE_PLATFORM_WIN32) || defined(XR_USE_TIMESPEC)
+        // Reads the host counter that the instance's time conversion extension converts from, as nanoseconds, and calls
+        // the conversion functions on it: QueryPerformanceCounter with XR_KHR_win32_convert_performance_counter_time and
+        // CLOCK_MONOTONIC with XR_KHR_convert_timespec_time. Only the conversion functions are timed by the benchmark;
+        // the nanosecond arithmetic around them is kept outside of the measured calls.
+        class HostClock
+        {
+        public:
+            explicit HostClock(XrInstance instance) : m_instance(instance)
+            {
+#if defined(XR_USE_PLATFORM_WIN32)
+                LARGE_INTEGER frequency;
+                QueryPerformanceFrequency(&frequency);
+                m_frequency = frequency.QuadPart;
+                m_toXrTime = GetInstanceExtensionFunction<PFN_xrConvertWin32PerformanceCounterToTimeKHR>(
+                    instance, "xrConvertWin32PerformanceCounterToTimeKHR");
+                m_fromXrTime = GetInstanceExtensionFunction<PFN_xrConvertTimeToWin32PerformanceCounterKHR>(
+                    instance, "xrConvertTimeToWin32PerformanceCounterKHR");
+#elif defined(XR_USE_TIMESPEC)
+                m_toXrTime = GetInstanceExtensionFunction<PFN_xrConvertTimespecTimeToTimeKHR>(instance, "xrConvertTimespecTimeToTimeKHR");
+                m_fromXrTime = GetInstanceExtensionFunction<PFN_xrConvertTimeToTimespecTimeKHR>(instance, "xrConvertTimeToTimespecTimeKHR");
+#endif
+            }
+
+            bool IsValid() const
+            {
+                return m_toXrTime != nullptr && m_fromXrTime != nullptr;
+            }
+
+#if defined(XR_USE_PLATFORM_WIN32)
+            using Counter = LARGE_INTEGER;
+
+            static Counter Read()
+            {
+                LARGE_INTEGER counter;
+                QueryPerformanceCounter(&counter);
+                return counter;
+            }
+
+            int64_t ToNanoseconds(const Counter& counter) const
+            {
+                // Split to keep the multiplication from overflowing.
+                return counter.QuadPart / m_frequency * 1000000000 + counter.QuadPart % m_frequency * 1000000000 / m_frequency;
+            }
+
+            XrResult ToXrTime(const Counter& counter, XrTime* time) const
+            {
+                return m_toXrTime(m_instance, &counter, time);
+            }
+
+            XrResult FromXrTime(XrTime time, Counter* counter) const
+            {
+                return m_fromXrTime(m_instance, time, counter);
+            }
+#elif defined(XR_USE_TIMESPEC)
+            using Counter = timespec;
+
+            static Counter Read()
+            {
+                timespec timespecTime;
+                clock_gettime(CLOCK_MONOTONIC, &timespecTime);
+                return timespecTime;
+            }
+
+            int64_t ToNanoseconds(const Counter& counter) const
+            {
+                return (int64_t)counter.tv_sec * 1000000000 + counter.tv_nsec;
+            }
+
+            XrResult ToXrTime(const Counter& counter, XrTime* time) const
+            {
+                return m_toXrTime(m_instance, &counter, time);
+            }
+
+            XrResult FromXrTime(XrTime time, Counter* counter) const
+            {
+                return m_fromXrTime(m_instance, time, counter);
+            }
+#endif
+
+        private:
+            XrInstance m_instance;
+#if defined(XR_USE_PLATFORM_WIN32)
+            LONGLONG m_frequency{1};
+            PFN_xrConvertWin32PerformanceCounterToTimeKHR m_toXrTime{nullptr};
+            PFN_xrConvertTimeToWin32PerformanceCounterKHR m_fromXrTime{nullptr};
+#elif defined(XR_USE_TIMESPEC)
+            PFN_xrConvertTimespecTimeToTimeKHR m_toXrTime{nullptr};
+            PFN_xrConvertTimeToTimespecTimeKHR m_fromXrTime{nullptr};
+#endif
+        };
+
+        // Times each call of both conversion functions, and reports their percentiles and mean.
+        void MeasureCallLatency(const HostClock& hostClock)
+        {
+            std::vector<int64_t> toXrTimeLatency, fromXrTimeLatency;
+            toXrTimeLatency.reserve(measuredCallCount);
+            fromXrTimeLatency.reserve(measuredCallCount);
+
+            Stopwatch stopwatch;
+            for (int call = 0; call < warmupCallCount + measuredCallCount; ++call) {
+                const HostClock::Counter counter = HostClock::Read();
+                XrTime time;
+                stopwatch.Restart();
+                const XrResult toXrTimeResult = hostClock.ToXrTime(counter, &time);
+                const int64_t toXrTimeNanoseconds = stopwatch.Elapsed().count();
+                REQUIRE_RESULT(toXrTimeResult, XR_SUCCESS);
+
+                HostClock::Counter roundTrip;
+                stopwatch.Restart();
+                const XrResult fromXrTimeResult = hostClock.FromXrTime(time, &roundTrip);
+                const int64_t fromXrTimeNanoseconds = stopwatch.Elapsed().count();
+                REQUIRE_RESULT(fromXrTimeResult, XR_SUCCESS);
+
+                if (call >= warmupCallCount) {
+                    toXrTimeLatency.push_back(toXrTimeNanoseconds);
+                    fromXrTimeLatency.push_back(fromXrTimeNanoseconds);
+                }
+            }
+
+            auto mean = [](const std::vector<int64_t>& samples) {
+                int64_t total = 0;
+                for (int64_t sample : samples) {
+                    total += sample;
+                }
+                return (double)total / samples.size();
+            };
+            ReportF("Time conversion call latency over %d calls each, including about one clock read of timing:", measuredCallCount);
+            ReportF("  Host counter to XrTime mean      : %.0fns", mean(toXrTimeLatency));
+            ReportF("  XrTime to host counter mean      : %.0fns", mean(fromXrTimeLatency));
+            ReportLatencyPercentiles("  Host counter to XrTime           :", toXrTimeLatency);
+            ReportLatencyPercentiles("  XrTime to host counter           :", fromXrTimeLatency);
+        }
+
+        // Samples XrTime minus host time once a second, the host counter being read between two MonotonicClock samples
+        // as MonotonicXrTimeConverter calibrates, and reports how the offset moves: a runtime whose XrTime runs on the
+        // host counter keeps it constant, one that runs on another clock shows its rate error as the fitted slope, and
+        // one that resynchronizes shows steps in the residuals.
+        void MeasureDrift(const HostClock& hostClock)
+        {
+            std::vector<double> elapsedSeconds;
+            std::vector<int64_t> offsets;
+            std::vector<int64_t> roundTripErrors;
+            std::vector<int64_t> brackets;
+
+            const MonotonicClock::time_point start = MonotonicClock::now();
+            for (int sample = 0; sample < driftSampleCount; ++sample) {
+                std::this_thread::sleep_until(start + driftSampleInterval * sample);
+
+                MonotonicClock::duration bestBracket = MonotonicClock::duration::max();
+                HostClock::Counter bestCounter{};
+                MonotonicClock::time_point bestMidpoint;
+                for (int attempt = 0; attempt < driftBracketAttempts; ++attempt) {
+                    const MonotonicClock::time_point before = MonotonicClock::now();
+                    const HostClock::Counter counter = HostClock::Read();
+                    const MonotonicClock::time_point after = MonotonicClock::now();
+                    if (after - before < bestBracket) {
+                        bestBracket = after - before;
+                        bestCounter = counter;
+                        bestMidpoint = before + (after - before) / 2;
+                    }
+                }
+
+                XrTime time;
+                REQUIRE_RESULT(hostClock.ToXrTime(bestCounter, &time), XR_SUCCESS);
+                HostClock::Counter roundTrip;
+                REQUIRE_RESULT(hostClock.FromXrTime(time, &roundTrip), XR_SUCCESS);
+
+                elapsedSeconds.push_back(std::chrono::duration<double>(bestMidpoint - start).count());
+                offsets.push_back(time - hostClock.ToNanoseconds(bestCounter));
+                roundTripErrors.push_back(std::abs(hostClock.ToNanoseconds(roundTrip) - hostClock.ToNanoseconds(bestCounter)));
+                brackets.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(bestBracket).count());
+            }
+
+            // Least squares fit of the offset change against elapsed time; its slope in ns/s is the rate error in ppb.
+            const size_t n = offsets.size();
+            double meanX = 0, meanY = 0;
+            for (size_t i = 0; i < n; ++i) {
+                meanX += elapsedSeconds[i] / n;
+                meanY += (double)(offsets[i] - offsets[0]) / n;
+            }
+            double covariance = 0, variance = 0;
+            for (size_t i = 0; i < n; ++i) {
+                covariance += (elapsedSeconds[i] - meanX) * ((double)(offsets[i] - offsets[0]) - meanY);
+                variance += (elapsedSeconds[i] - meanX) * (elapsedSeconds[i] - meanX);
+            }
+            const double slope = variance > 0 ? covariance / variance : 0;
+            std::vector<int64_t> residuals;
+            int64_t maxOffsetChange = 0;
+            for (size_t i = 0; i < n; ++i) {
+                const double fitted = meanY + slope * (elapsedSeconds[i] - meanX);
+                residuals.push_back(std::llround(std::abs((double)(offsets[i] - offsets[0]) - fitted)));
+                maxOffsetChange = std::max<int64_t>(maxOffsetChange, std::abs(offsets[i] - offsets[0]));
+            }
+
+            ReportF("XrTime to host clock correlation over %.0f s, %d samples:", elapsedSeconds.back(), (int)n);
+            ReportF("  Largest change of offset         : %lldns", (long long)maxOffsetChange);
+            ReportF("  Fitted rate error                : %.3f ppm", slope / 1000.0);
+            ReportLatencyPercentiles("  Residual from fitted rate        :", residuals);
+            ReportLatencyPercentiles("  Round-trip error                 :", roundTripErrors);
+            ReportLatencyPercentiles("  Host counter read bracket        :", brackets);
+        }
+
+        // Runs a frame loop and converts each predicted display time to host time, to report how evenly the predicted
+        // display times are spaced on the host clock and whether the conversion adds to their jitter.
+        void MeasureDisplayTimeJitter(const char* extension)
+        {
+            CompositionHelper compositionHelper("Clock Correlation Benchmark", {extension});
+            compositionHelper.GetInteractionManager().AttachActionSets();
+            compositionHelper.BeginSession();
+            const HostClock hostClock(compositionHelper.GetInstance());
+            REQUIRE(hostClock.IsValid());
+
+            SimpleProjectionLayerHelper simpleProjectionLayerHelper(compositionHelper);
+
+            std::vector<int64_t> hostJitter, conversionJitter, wakeToDisplay;
+            hostJitter.reserve(displayTimeMeasuredFrameCount);
+            conversionJitter.reserve(displayTimeMeasuredFrameCount);
+            wakeToDisplay.reserve(displayTimeMeasuredFrameCount);
+
+            int frame = 0;
+            XrTime lastDisplayTime = 0;
+            int64_t lastHostDisplayTime = 0;
+            RenderLoop renderLoop(compositionHelper, [&](const XrFrameState& frameState) {
+                const int64_t wokenAt = hostClock.ToNanoseconds(HostClock::Read());
+                HostClock::Counter displayCounter;
+                REQUIRE_RESULT(hostClock.FromXrTime(frameState.predictedDisplayTime, &displayCounter), XR_SUCCESS);
+                const int64_t hostDisplayTime = hostClock.ToNanoseconds(displayCounter);
+
+                if (frame > displayTimeWarmupFrameCount) {
+                    const int64_t hostInterval = hostDisplayTime - lastHostDisplayTime;
+                    const XrDuration interval = frameState.predictedDisplayTime - lastDisplayTime;
+                    hostJitter.push_back(std::abs(hostInterval - frameState.predictedDisplayPeriod));
+                    conversionJitter.push_back(std::abs(hostInterval - interval));
+                    wakeToDisplay.push_back(hostDisplayTime - wokenAt);
+                }
+                lastDisplayTime = frameState.predictedDisplayTime;
+                lastHostDisplayTime = hostDisplayTime;
+
+                compositionHelper.PollEvents();
+                XrCompositionLayerBaseHeader* const projLayer = simpleProjectionLayerHelper.TryGetUpdatedProjectionLayer(frameState);
+                compositionHelper.EndFrame(frameState.predictedDisplayTime, &projLayer, projLayer != nullptr ? 1 : 0);
+                return ++frame <= displayTimeWarmupFrameCount + displayTimeMeasuredFrameCount;
+            });
+            renderLoop.Loop();
+
+            ReportF("Predicted display times on the host clock over %d frames:", (int)hostJitter.size());
+            ReportLatencyPercentiles("  Interval jitter from period      :", hostJitter);
+            ReportLatencyPercentiles("  Interval change by conversion    :", conversionJitter);
+            ReportLatencyPercentiles("  Wake-up to predicted display     :", wakeToDisplay);
+        }
+#endif  // defined(XR_USE_PLATFORM_WIN32) || defined(XR_USE_TIMESPEC)
+    }  // namespace
+
+    // Measures what the latency pipelines of applications rely on when they correlate XrTime with the host clock: the
+    // cost of each conversion call, how the relation between the two clocks holds over a few minutes, and how evenly
+    // predicted display times land on the host clock.
+    TEST_CASE("Clock Correlation Benchmark", "[.][benchmark]")
+    {
+        const char* const extension = GetMonotonicTimeConversionExtension();
+        if (extension == nullptr) {
+            WARN("No time conversion extension is supported on this platform; skipping");
+            return;
+        }
+
+#if defined(XR_USE_PLATFORM_WIN32) || defined(XR_USE_TIMESPEC)
+        {
+            AutoBasicInstance instance({extension});
+            const HostClock hostClock(instance);
+            REQUIRE(hostClock.IsValid());
+
+            MeasureCallLatency(hostClock);
+            MeasureDrift(hostClock);
+        }
+
+        MeasureDisplayTimeJitter(extension);
+#endif
+    }
+}  // namespace Conformance
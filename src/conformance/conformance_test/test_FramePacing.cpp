@@ -0,0 +1,431 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "utils.h"
+#include "conformance_utils.h"
+#include "conformance_framework.h"
+#include "composition_utils.h"
+#include "frame_pacing.h"
+#include "power_monitor.h"
+#include "report.h"
+#include <openxr/openxr.h>
+#include <catch2/catch.hpp>
+
+namespace Conformance
+{
+    namespace
+    {
+        using ns = std::chrono::nanoseconds;
+
+        constexpr int warmupFrameCount = 180;    // Let the runtime settle its frame pacing before measuring.
+        constexpr int measuredFrameCount = 3000;  // Enough frames for stable p99 values and visible drift.
+
+        constexpr int gpuLoadWarmupFrameCount = 60;         // After each change of load.
+        constexpr int gpuLoadMeasuredFrameCount = 600;      // Per load step.
+        constexpr uint32_t gpuLoadProbeLayerCount = 32;     // Overdraw layers used to calibrate the cost of one.
+        constexpr uint32_t gpuLoadMaxLayerCount = 8192;     // Keeps a bad calibration from asking for an endless draw.
+        // GPU time per frame of each step of the sweep, as a fraction of the predicted display period.
+        constexpr double gpuLoadSteps[] = {0.25, 0.5, 0.75, 0.9, 1.0, 1.1, 1.25, 1.5, 2.0};
+
+        constexpr int cpuLoadWarmupFrameCount = 60;     // After each change of profile.
+        constexpr int cpuLoadMeasuredFrameCount = 600;  // Per profile.
+
+        // An application CPU profile for FrameCpuLoad, with durations as fractions of the predicted display period.
+        struct CpuLoadProfile
+        {
+            const char* name;
+            double beforeWait;
+            double beforeRender;
+            double afterEnd;
+            uint32_t lateFrameInterval;
+            double lateFrameDelay;
+        };
+        constexpr CpuLoadProfile cpuLoadProfiles[] = {
+            {"simulation before xrWaitFrame", 0.4, 0, 0, 0, 0},
+            {"render submission after xrBeginFrame", 0, 0.6, 0, 0, 0},
+            {"work after xrEndFrame", 0, 0, 0.3, 0, 0},
+            {"work in every phase", 0.2, 0.3, 0.2, 0, 0},
+            {"late frame every 30 frames", 0, 0.2, 0, 30, 1.5},
+            {"late frame every 7 frames", 0, 0.2, 0, 7, 1.1},
+        };
+
+        // Runs a RenderLoop that renders a simple projection layer, either serially or pipelined, see RenderLoop::PipelinedLoop.
+        void MeasureRenderLoop(const char* loopName, bool pipelined)
+        {
+            // Enable converting the CPU clock to XrTime where the runtime can, to report how early frames are woken.
+            std::vector<const char*> extensions;
+            if (const char* timeConversionExtension = GetMonotonicTimeConversionExtension()) {
+                extensions.push_back(timeConversionExtension);
+            }
+            CompositionHelper compositionHelper("Frame Pacing Benchmark", extensions);
+            compositionHelper.GetInteractionManager().AttachActionSets();
+            compositionHelper.BeginSession();
+            const MonotonicXrTimeConverter timeConverter(compositionHelper.GetInstance());
+
+            SimpleProjectionLayerHelper simpleProjectionLayerHelper(compositionHelper);
+
+            // Also time the GPU work of rendering each frame, if the graphics plugin can.
+            auto graphicsPlugin = GetGlobalData().GetGraphicsPlugin();
+            const bool gpuTiming = graphicsPlugin->SetGpuTimingEnabled(true);
+            std::vector<GpuTimingSample> gpuTimings;
+
+            FramePacingRecorder recorder;
+            recorder.SetTimeConverter(&timeConverter);
+            int frame = 0;
+            RenderLoop renderLoop(compositionHelper, [&](const XrFrameState& frameState) {
+                // RenderLoop has already called xrBeginFrame, which is expected to return promptly. When pipelined, the
+                // frame was woken on the wait thread, so the wake-up jitter also includes the hand-off to this thread.
+                const bool measured = frame >= warmupFrameCount;
+                if (measured) {
+                    recorder.OnFrameWoken(frameState);
+                }
+
+                compositionHelper.PollEvents();
+
+                XrCompositionLayerBaseHeader* const projLayer = simpleProjectionLayerHelper.TryGetUpdatedProjectionLayer(frameState);
+                compositionHelper.EndFrame(frameState.predictedDisplayTime, &projLayer, projLayer != nullptr ? 1 : 0);
+
+                if (measured) {
+                    recorder.OnFrameEnded();
+                }
+                if (gpuTiming) {
+                    // Timings are read back without waiting, so they lag the frame loop by a few frames.
+                    if (!measured) {
+                        gpuTimings.clear();
+                    }
+                    graphicsPlugin->CollectGpuTimings(gpuTimings);
+                }
+                return ++frame < warmupFrameCount + measuredFrameCount;
+            });
+            if (pipelined) {
+                renderLoop.PipelinedLoop();
+            }
+            else {
+                renderLoop.Loop();
+            }
+
+            REQUIRE(recorder.GetFrameCount() == measuredFrameCount);
+            recorder.Report(loopName);
+            ReportStageTimings(renderLoop.GetStageTimings());
+
+            if (gpuTiming) {
+                graphicsPlugin->Flush();
+                graphicsPlugin->CollectGpuTimings(gpuTimings);
+                graphicsPlugin->SetGpuTimingEnabled(false);
+                ReportGpuTimingPercentiles("  GPU time of", gpuTimings);
+            }
+        }
+
+        // Renders a simple projection layer with a RenderLoop running the given synthetic CPU load, feeding the measured
+        // frames to recorder and sampling the power of the device over them. Returns the loop's stage timings, which leave
+        // out the synthetic load.
+        RenderLoopStageTimings RunWithCpuLoad(CompositionHelper& compositionHelper,
+                                              SimpleProjectionLayerHelper& simpleProjectionLayerHelper, const FrameCpuLoad& cpuLoad,
+                                              FramePacingRecorder& recorder, PowerSummary& power)
+        {
+            PowerMonitor powerMonitor;
+            int frame = 0;
+            RenderLoop renderLoop(compositionHelper, [&](const XrFrameState& frameState) {
+                const bool measured = frame >= cpuLoadWarmupFrameCount;
+                if (frame == cpuLoadWarmupFrameCount) {
+                    powerMonitor.Start();
+                }
+                if (measured) {
+                    recorder.OnFrameWoken(frameState);
+                }
+
+                compositionHelper.PollEvents();
+
+                XrCompositionLayerBaseHeader* const projLayer = simpleProjectionLayerHelper.TryGetUpdatedProjectionLayer(frameState);
+                compositionHelper.EndFrame(frameState.predictedDisplayTime, &projLayer, projLayer != nullptr ? 1 : 0);
+
+                if (measured) {
+                    recorder.OnFrameEnded();
+                }
+                return ++frame < cpuLoadWarmupFrameCount + cpuLoadMeasuredFrameCount;
+            });
+            renderLoop.SetCpuLoad(cpuLoad);
+            renderLoop.Loop();
+            power = powerMonitor.Stop();
+            REQUIRE(recorder.GetFrameCount() == cpuLoadMeasuredFrameCount);
+            return renderLoop.GetStageTimings();
+        }
+
+        // The GPU time a frame loop spent rendering under one synthetic GPU load, see RunWithGpuLoad.
+        struct GpuLoadResult
+        {
+            int64_t gpuTimePerFrame;
+            XrDuration predictedDisplayPeriod;
+            PowerSummary power;
+        };
+
+        // Renders a simple projection layer with the given synthetic GPU load, feeding the measured frames to recorder and
+        // their GPU timings to gpuTimings. Returns the median RenderView GPU time times the number of views rendered per
+        // frame, the predicted display period of the last frame, and the power of the device over the measured frames.
+        GpuLoadResult RunWithGpuLoad(CompositionHelper& compositionHelper, SimpleProjectionLayerHelper& simpleProjectionLayerHelper,
+                                     uint32_t layerCount, FramePacingRecorder& recorder, std::vector<GpuTimingSample>& gpuTimings)
+        {
+            auto graphicsPlugin = GetGlobalData().GetGraphicsPlugin();
+            REQUIRE(graphicsPlugin->SetSyntheticGpuLoad(layerCount));
+
+            GpuLoadResult result{0, 0, {}};
+            gpuTimings.clear();
+            PowerMonitor powerMonitor;
+            int frame = 0;
+            RenderLoop renderLoop(compositionHelper, [&](const XrFrameState& frameState) {
+                const bool measured = frame >= gpuLoadWarmupFrameCount;
+                if (frame == gpuLoadWarmupFrameCount) {
+                    powerMonitor.Start();
+                }
+                if (measured) {
+                    recorder.OnFrameWoken(frameState);
+                }
+                result.predictedDisplayPeriod = frameState.predictedDisplayPeriod;
+
+                compositionHelper.PollEvents();
+
+                XrCompositionLayerBaseHeader* const projLayer = simpleProjectionLayerHelper.TryGetUpdatedProjectionLayer(frameState);
+                compositionHelper.EndFrame(frameState.predictedDisplayTime, &projLayer, projLayer != nullptr ? 1 : 0);
+
+                if (measured) {
+                    recorder.OnFrameEnded();
+                }
+                else {
+                    gpuTimings.clear();
+                }
+                graphicsPlugin->CollectGpuTimings(gpuTimings);
+                return ++frame < gpuLoadWarmupFrameCount + gpuLoadMeasuredFrameCount;
+            });
+            renderLoop.Loop();
+            result.power = powerMonitor.Stop();
+            graphicsPlugin->Flush();
+            graphicsPlugin->CollectGpuTimings(gpuTimings);
+
+            std::vector<int64_t> renderViewTimes;
+            for (const GpuTimingSample& sample : gpuTimings) {
+                if (std::string(sample.scope) == "RenderView") {
+                    renderViewTimes.push_back(sample.nanoseconds);
+                }
+            }
+            if (!renderViewTimes.empty()) {
+                // Timings lag the frame loop by a few frames and some may be dropped, so count the calls per frame
+                // rather than summing the samples.
+                const int64_t callsPerFrame =
+                    std::max<int64_t>(1, std::llround((double)renderViewTimes.size() / gpuLoadMeasuredFrameCount));
+                std::nth_element(renderViewTimes.begin(), renderViewTimes.begin() + renderViewTimes.size() / 2, renderViewTimes.end());
+                result.gpuTimePerFrame = renderViewTimes[renderViewTimes.size() / 2] * callsPerFrame;
+            }
+            return result;
+        }
+
+    }  // namespace
+
+    // Measures how evenly the runtime paces frames for a simple, well-behaved application. The results show regressions
+    // when comparing runtime builds.
+    TEST_CASE("Frame Pacing Benchmark", "[.][benchmark]")
+    {
+        GlobalData& globalData = GetGlobalData();
+        if (!globalData.IsUsingGraphicsPlugin()) {
+            // Nothing to measure - no graphics plugin means no frame submission
+            return;
+        }
+
+        SECTION("FrameIterator")
+        {
+            AutoBasicSession session(AutoBasicSession::beginSession | AutoBasicSession::createSwapchains | AutoBasicSession::createSpaces);
+
+            FrameIterator frameIterator(&session);
+            REQUIRE(FrameIterator::RunResult::Success == frameIterator.RunToSessionState(XR_SESSION_STATE_FOCUSED, 15_sec));
+
+            FramePacingRecorder recorder;
+            CpuCounters warmupCpuCounters;
+            for (int frame = 0; frame < warmupFrameCount + measuredFrameCount; ++frame) {
+                if (frame == warmupFrameCount) {
+                    warmupCpuCounters = frameIterator.GetCpuCounters();
+                }
+                REQUIRE(FrameIterator::TickResult::Error != frameIterator.PollEvent());
+
+                REQUIRE(FrameIterator::RunResult::Success == frameIterator.WaitAndBeginFrame());
+                const bool measured = frame >= warmupFrameCount;
+                if (measured) {
+                    recorder.OnFrameWoken(frameIterator.frameState);
+                }
+
+                REQUIRE(FrameIterator::RunResult::Success == frameIterator.CycleToNextSwapchainImage());
+                REQUIRE(FrameIterator::RunResult::Success == frameIterator.PrepareFrameEndInfo());
+
+                const XrCompositionLayerBaseHeader* headerPtrArray[1] = {
+                    reinterpret_cast<const XrCompositionLayerBaseHeader*>(&frameIterator.compositionLayerProjection)};
+                frameIterator.frameEndInfo.layerCount = 1;
+                frameIterator.frameEndInfo.layers = headerPtrArray;
+                FAST_REQUIRE_RESULT_SUCCEEDED(xrEndFrame(session, &frameIterator.frameEndInfo));
+
+                if (measured) {
+                    recorder.OnFrameEnded();
+                }
+            }
+
+            recorder.Report("FrameIterator");
+            ReportCpuCounters("  CPU counters from wait to begin  :", frameIterator.GetCpuCounters() - warmupCpuCounters,
+                              measuredFrameCount);
+        }
+
+        SECTION("RenderLoop")
+        {
+            MeasureRenderLoop("RenderLoop", false);
+        }
+
+        SECTION("PipelinedRenderLoop")
+        {
+            MeasureRenderLoop("PipelinedRenderLoop", true);
+        }
+    }
+
+    // Measures how the runtime paces frames as the application's GPU work per frame grows from well under to well over
+    // the display period. The graphics plugin draws a synthetic overdraw load behind the scene, calibrated with its GPU
+    // timestamp queries, and each step reports missed frames, predictedDisplayTime behaviour and GPU time. A runtime is
+    // expected to drop to a lower rate without its predicted display times going astray.
+    TEST_CASE("GPU Load Pacing Benchmark", "[.][benchmark]")
+    {
+        GlobalData& globalData = GetGlobalData();
+        if (!globalData.IsUsingGraphicsPlugin()) {
+            // Nothing to measure - no graphics plugin means no frame submission
+            return;
+        }
+
+        CompositionHelper compositionHelper("GPU Load Pacing Benchmark");
+        compositionHelper.GetInteractionManager().AttachActionSets();
+        compositionHelper.BeginSession();
+
+        SimpleProjectionLayerHelper simpleProjectionLayerHelper(compositionHelper);
+
+        auto graphicsPlugin = globalData.GetGraphicsPlugin();
+        if (!graphicsPlugin->SetGpuTimingEnabled(true)) {
+            WARN("Graphics plugin cannot time GPU work; skipping");
+            return;
+        }
+        if (!graphicsPlugin->SetSyntheticGpuLoad(0)) {
+            graphicsPlugin->SetGpuTimingEnabled(false);
+            WARN("Graphics plugin cannot add a synthetic GPU load; skipping");
+            return;
+        }
+
+        std::vector<GpuTimingSample> gpuTimings;
+
+        // Calibrate: the GPU time of one overdraw layer is the difference between a probe load and none, spread over the
+        // probe's layers. It depends on the device, the view size and the number of views.
+        FramePacingRecorder baselineRecorder;
+        const GpuLoadResult baseline = RunWithGpuLoad(compositionHelper, simpleProjectionLayerHelper, 0, baselineRecorder, gpuTimings);
+        baselineRecorder.Report("no synthetic load");
+        ReportPowerPerFrame("  Power                            :", baseline.power, gpuLoadMeasuredFrameCount);
+        ReportGpuTimingPercentiles("  GPU time of", gpuTimings);
+
+        FramePacingRecorder probeRecorder;
+        const GpuLoadResult probe =
+            RunWithGpuLoad(compositionHelper, simpleProjectionLayerHelper, gpuLoadProbeLayerCount, probeRecorder, gpuTimings);
+        const double layerCost = (double)(probe.gpuTimePerFrame - baseline.gpuTimePerFrame) / gpuLoadProbeLayerCount;
+        const XrDuration displayPeriod = probe.predictedDisplayPeriod;
+        ReportF("GPU load calibration: %.3fms per frame with no load, %.1fus per frame for each overdraw layer, display period %.3fms",
+                baseline.gpuTimePerFrame / 1000000.0, layerCost / 1000.0, displayPeriod / 1000000.0);
+        if (layerCost <= 0 || displayPeriod <= 0) {
+            graphicsPlugin->SetSyntheticGpuLoad(0);
+            graphicsPlugin->SetGpuTimingEnabled(false);
+            WARN("Could not calibrate the synthetic GPU load; skipping the sweep");
+            return;
+        }
+
+        for (double step : gpuLoadSteps) {
+            const double targetTime = step * displayPeriod;
+            const double layers = std::ceil((targetTime - baseline.gpuTimePerFrame) / layerCost);
+            const uint32_t layerCount = (uint32_t)std::min<double>(std::max(layers, 0.0), gpuLoadMaxLayerCount);
+
+            FramePacingRecorder recorder;
+            const GpuLoadResult result = RunWithGpuLoad(compositionHelper, simpleProjectionLayerHelper, layerCount, recorder, gpuTimings);
+
+            const std::string loopName = std::to_string((int)std::lround(step * 100)) + "% of the display period, " +
+                                         std::to_string(layerCount) + " overdraw layers";
+            recorder.Report(loopName.c_str());
+            ReportF("  Measured GPU time per frame      : %.3fms (target %.3fms)", result.gpuTimePerFrame / 1000000.0,
+                    targetTime / 1000000.0);
+            ReportPowerPerFrame("  Power                            :", result.power, gpuLoadMeasuredFrameCount);
+            ReportGpuTimingPercentiles("  GPU time of", gpuTimings);
+        }
+
+        graphicsPlugin->SetSyntheticGpuLoad(0);
+        graphicsPlugin->SetGpuTimingEnabled(false);
+    }
+
+    // Measures how the runtime predicts display times and paces frames for applications with different CPU profiles:
+    // work before xrWaitFrame, between xrBeginFrame and rendering, after xrEndFrame, and frames that run late on a
+    // schedule. The durations scale with the predicted display period.
+    TEST_CASE("CPU Load Pacing Benchmark", "[.][benchmark]")
+    {
+        GlobalData& globalData = GetGlobalData();
+        if (!globalData.IsUsingGraphicsPlugin()) {
+            // Nothing to measure - no graphics plugin means no frame submission
+            return;
+        }
+
+        CompositionHelper compositionHelper("CPU Load Pacing Benchmark");
+        compositionHelper.GetInteractionManager().AttachActionSets();
+        compositionHelper.BeginSession();
+
+        SimpleProjectionLayerHelper simpleProjectionLayerHelper(compositionHelper);
+
+        FramePacingRecorder baselineRecorder;
+        PowerSummary baselinePower;
+        const RenderLoopStageTimings baselineTimings =
+            RunWithCpuLoad(compositionHelper, simpleProjectionLayerHelper, FrameCpuLoad{}, baselineRecorder, baselinePower);
+        baselineRecorder.Report("no CPU load");
+        ReportStageTimings(baselineTimings);
+        ReportPowerPerFrame("  Power                            :", baselinePower, cpuLoadMeasuredFrameCount);
+        const XrDuration displayPeriod = baselineRecorder.GetAverageDisplayPeriod();
+        REQUIRE(displayPeriod > 0);
+
+        for (const CpuLoadProfile& profile : cpuLoadProfiles) {
+            auto periods = [&](double fraction) { return ns((int64_t)(fraction * displayPeriod)); };
+            FrameCpuLoad cpuLoad;
+            cpuLoad.beforeWait = periods(profile.beforeWait);
+            cpuLoad.beforeRender = periods(profile.beforeRender);
+            cpuLoad.afterEnd = periods(profile.afterEnd);
+            cpuLoad.lateFrameInterval = profile.lateFrameInterval;
+            cpuLoad.lateFrameDelay = periods(profile.lateFrameDelay);
+
+            FramePacingRecorder recorder;
+            PowerSummary power;
+            const RenderLoopStageTimings timings =
+                RunWithCpuLoad(compositionHelper, simpleProjectionLayerHelper, cpuLoad, recorder, power);
+            recorder.Report(profile.name);
+            ReportStageTimings(timings);
+            ReportPowerPerFrame("  Power                            :", power, cpuLoadMeasuredFrameCount);
+            ReportF("  Synthetic CPU load per frame     : before wait %.3fms, before render %.3fms, after end %.3fms",
+                    cpuLoad.beforeWait.count() / 1000000.0, cpuLoad.beforeRender.count() / 1000000.0,
+                    cpuLoad.afterEnd.count() / 1000000.0);
+            if (profile.lateFrameInterval != 0) {
+                ReportF("  Scheduled late frames            : %d, each %.3fms late",
+                        cpuLoadMeasuredFrameCount / (int)profile.lateFrameInterval, cpuLoad.lateFrameDelay.count() / 1000000.0);
+            }
+        }
+    }
+
+}  // namespace Conformance
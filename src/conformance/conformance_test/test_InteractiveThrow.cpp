@@ -14,7 +14,9 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <array>
+#include <map>
 #include <thread>
 #include <numeric>
 #include "utils.h"
@@ -22,6 +24,7 @@
 #include "conformance_utils.h"
 #include "conformance_framework.h"
 #include "composition_utils.h"
+#include "projectile_batch.h"
 #include <catch2/catch.hpp>
 #include <openxr/openxr.h>
 #include <xr_linear.h>
@@ -35,6 +38,164 @@ namespace Conformance
 {
     constexpr XrVector3f Up{0, 1, 0};
 
+    namespace
+    {
+        // Spaces attached to the hand (subaction).
+        struct HandThrowSpaces
+        {
+            XrPath subactionPath;
+            std::vector<XrSpace> spaces;
+        };
+
+        // The actions of the throw scenarios, suggested for the simple controller and attached to the session, with throw
+        // spaces at various offsets from each grip pose.
+        struct ThrowInput
+        {
+            XrActionSet actionSet;
+            XrAction throwAction, failAction, gripPoseAction;
+            std::vector<HandThrowSpaces> throwSpaces;
+        };
+
+        ThrowInput CreateThrowInput(CompositionHelper& compositionHelper)
+        {
+            ThrowInput input;
+
+            const std::vector<XrPath> subactionPaths{StringToPath(compositionHelper.GetInstance(), "/user/hand/left"),
+                                                     StringToPath(compositionHelper.GetInstance(), "/user/hand/right")};
+
+            {
+                XrActionSetCreateInfo actionSetInfo{XR_TYPE_ACTION_SET_CREATE_INFO};
+                strcpy(actionSetInfo.actionSetName, "interaction_test");
+                strcpy(actionSetInfo.localizedActionSetName, "Interaction Test");
+                XRC_CHECK_THROW_XRCMD(xrCreateActionSet(compositionHelper.GetInstance(), &actionSetInfo, &input.actionSet));
+
+                XrActionCreateInfo actionInfo{XR_TYPE_ACTION_CREATE_INFO};
+                actionInfo.actionType = XR_ACTION_TYPE_BOOLEAN_INPUT;
+                strcpy(actionInfo.actionName, "complete_test");
+                strcpy(actionInfo.localizedActionName, "Complete test");
+                XRC_CHECK_THROW_XRCMD(xrCreateAction(input.actionSet, &actionInfo, &input.failAction));
+
+                // Remainder of actions use subaction.
+                actionInfo.subactionPaths = subactionPaths.data();
+                actionInfo.countSubactionPaths = (uint32_t)subactionPaths.size();
+
+                actionInfo.actionType = XR_ACTION_TYPE_BOOLEAN_INPUT;
+                strcpy(actionInfo.actionName, "throw");
+                strcpy(actionInfo.localizedActionName, "Throw");
+                XRC_CHECK_THROW_XRCMD(xrCreateAction(input.actionSet, &actionInfo, &input.throwAction));
+
+                actionInfo.actionType = XR_ACTION_TYPE_POSE_INPUT;
+                strcpy(actionInfo.actionName, "grip_pose");
+                strcpy(actionInfo.localizedActionName, "Grip pose");
+                actionInfo.subactionPaths = subactionPaths.data();
+                actionInfo.countSubactionPaths = (uint32_t)subactionPaths.size();
+                XRC_CHECK_THROW_XRCMD(xrCreateAction(input.actionSet, &actionInfo, &input.gripPoseAction));
+            }
+
+            const std::vector<XrActionSuggestedBinding> bindings = {
+                {input.throwAction, StringToPath(compositionHelper.GetInstance(), "/user/hand/left/input/select/click")},
+                {input.throwAction, StringToPath(compositionHelper.GetInstance(), "/user/hand/right/input/select/click")},
+                {input.failAction, StringToPath(compositionHelper.GetInstance(), "/user/hand/left/input/menu/click")},
+                {input.failAction, StringToPath(compositionHelper.GetInstance(), "/user/hand/right/input/menu/click")},
+                {input.gripPoseAction, StringToPath(compositionHelper.GetInstance(), "/user/hand/left/input/grip/pose")},
+                {input.gripPoseAction, StringToPath(compositionHelper.GetInstance(), "/user/hand/right/input/grip/pose")},
+            };
+
+            XrInteractionProfileSuggestedBinding suggestedBindings{XR_TYPE_INTERACTION_PROFILE_SUGGESTED_BINDING};
+            suggestedBindings.interactionProfile =
+                StringToPath(compositionHelper.GetInstance(), "/interaction_profiles/khr/simple_controller");
+            suggestedBindings.suggestedBindings = bindings.data();
+            suggestedBindings.countSuggestedBindings = (uint32_t)bindings.size();
+            XRC_CHECK_THROW_XRCMD(xrSuggestInteractionProfileBindings(compositionHelper.GetInstance(), &suggestedBindings));
+
+            XrSessionActionSetsAttachInfo attachInfo{XR_TYPE_SESSION_ACTION_SETS_ATTACH_INFO};
+            attachInfo.actionSets = &input.actionSet;
+            attachInfo.countActionSets = 1;
+            XRC_CHECK_THROW_XRCMD(xrAttachSessionActionSets(compositionHelper.GetSession(), &attachInfo));
+
+            // Create XrSpaces at various spaces around the grip poses.
+            for (XrPath subactionPath : subactionPaths) {
+                HandThrowSpaces handThrowSpaces;
+                handThrowSpaces.subactionPath = subactionPath;
+                for (float meterDistance : {0.0f, 0.25f, 0.5f}) {
+                    XrSpace handSpace;
+                    XrActionSpaceCreateInfo spaceCreateInfo{XR_TYPE_ACTION_SPACE_CREATE_INFO};
+                    spaceCreateInfo.action = input.gripPoseAction;
+                    spaceCreateInfo.subactionPath = subactionPath;
+                    spaceCreateInfo.poseInActionSpace = {{0, 0, 0, 1}, {0, 0, -meterDistance}};
+                    XRC_CHECK_THROW_XRCMD(xrCreateActionSpace(compositionHelper.GetSession(), &spaceCreateInfo, &handSpace));
+                    handThrowSpaces.spaces.push_back(handSpace);
+                }
+                input.throwSpaces.push_back(std::move(handThrowSpaces));
+            }
+
+            return input;
+        }
+
+        // Syncs the throw actions and returns whether the user has requested to fail the test.
+        bool SyncThrowInput(CompositionHelper& compositionHelper, const ThrowInput& input)
+        {
+            const std::array<XrActiveActionSet, 1> activeActionSets = {{input.actionSet, XR_NULL_PATH}};
+            XrActionsSyncInfo syncInfo{XR_TYPE_ACTIONS_SYNC_INFO};
+            syncInfo.activeActionSets = activeActionSets.data();
+            syncInfo.countActiveActionSets = (uint32_t)activeActionSets.size();
+            XRC_CHECK_THROW_XRCMD(xrSyncActions(compositionHelper.GetSession(), &syncInfo));
+
+            XrActionStateGetInfo completeActionGetInfo{XR_TYPE_ACTION_STATE_GET_INFO};
+            completeActionGetInfo.action = input.failAction;
+            XrActionStateBoolean completeActionState{XR_TYPE_ACTION_STATE_BOOLEAN};
+            XRC_CHECK_THROW_XRCMD(xrGetActionStateBoolean(compositionHelper.GetSession(), &completeActionGetInfo, &completeActionState));
+            return completeActionState.currentState == XR_TRUE && completeActionState.changedSinceLastSync;
+        }
+
+        // Renders the cubes into each view of the projection layer, when the views are located, and ends the frame with
+        // the projection layer and the instructions.
+        void RenderThrowFrame(CompositionHelper& compositionHelper, XrSpace localSpace, XrCompositionLayerProjection* projLayer,
+                              const std::vector<XrSwapchain>& swapchains, XrCompositionLayerQuad* instructionsQuad,
+                              const XrFrameState& frameState, const std::vector<Cube>& cubes)
+        {
+            const auto views = compositionHelper.LocateViews(localSpace, frameState.predictedDisplayTime);
+            const auto& viewState = views.viewState;
+
+            std::vector<XrCompositionLayerBaseHeader*> layers;
+            if (viewState.viewStateFlags & XR_VIEW_STATE_POSITION_VALID_BIT &&
+                viewState.viewStateFlags & XR_VIEW_STATE_ORIENTATION_VALID_BIT) {
+                // Render into each view port of the wide swapchain using the projection layer view fov and pose.
+                for (size_t view = 0; view < views.size(); view++) {
+                    compositionHelper.AcquireWaitReleaseImage(
+                        swapchains[view], [&](const XrSwapchainImageBaseHeader* swapchainImage, uint64_t format) {
+                            const_cast<XrFovf&>(projLayer->views[view].fov) = views[view].fov;
+                            const_cast<XrPosef&>(projLayer->views[view].pose) = views[view].pose;
+                            GetGlobalData().graphicsPlugin->ClearAndRenderViews(&projLayer->views[view], 1, swapchainImage, format,
+                                                                                cubes);
+                        });
+                }
+
+                layers.push_back({reinterpret_cast<XrCompositionLayerBaseHeader*>(projLayer)});
+            }
+
+            layers.push_back({reinterpret_cast<XrCompositionLayerBaseHeader*>(instructionsQuad)});
+
+            compositionHelper.EndFrame(frameState.predictedDisplayTime, layers);
+        }
+
+        // Reports the percentiles of distances in millimeters, as ReportLatencyPercentiles does for durations.
+        void ReportDistancePercentiles(const char* label, std::vector<float>& meterSamples)
+        {
+            if (meterSamples.empty()) {
+                ReportF("%s no samples", label);
+                return;
+            }
+            std::sort(meterSamples.begin(), meterSamples.end());
+            auto percentile = [&](double p) {
+                const size_t rank = (size_t)std::ceil(p / 100.0 * meterSamples.size());
+                return meterSamples[std::max<size_t>(rank, 1) - 1] * 1000.0;
+            };
+            ReportF("%s p50 %.2fmm, p90 %.2fmm, p99 %.2fmm, max %.2fmm", label, percentile(50), percentile(90), percentile(99),
+                    meterSamples.back() * 1000.0);
+        }
+    }  // namespace
+
     // Purpose: Verify behavior of action timing and action space linear/angular velocity through throwing
     // 1. Use action state changed timestamp to query velocities
     // 2. Use action space velocities at various rigid offsets to verify "lever arm" effect is computed by runtime.
@@ -64,59 +225,7 @@ namespace Conformance
             }
         }
 
-        const std::vector<XrPath> subactionPaths{StringToPath(compositionHelper.GetInstance(), "/user/hand/left"),
-                                                 StringToPath(compositionHelper.GetInstance(), "/user/hand/right")};
-
-        XrActionSet actionSet;
-        XrAction throwAction, failAction, gripPoseAction;
-        {
-            XrActionSetCreateInfo actionSetInfo{XR_TYPE_ACTION_SET_CREATE_INFO};
-            strcpy(actionSetInfo.actionSetName, "interaction_test");
-            strcpy(actionSetInfo.localizedActionSetName, "Interaction Test");
-            XRC_CHECK_THROW_XRCMD(xrCreateActionSet(compositionHelper.GetInstance(), &actionSetInfo, &actionSet));
-
-            XrActionCreateInfo actionInfo{XR_TYPE_ACTION_CREATE_INFO};
-            actionInfo.actionType = XR_ACTION_TYPE_BOOLEAN_INPUT;
-            strcpy(actionInfo.actionName, "complete_test");
-            strcpy(actionInfo.localizedActionName, "Complete test");
-            XRC_CHECK_THROW_XRCMD(xrCreateAction(actionSet, &actionInfo, &failAction));
-
-            // Remainder of actions use subaction.
-            actionInfo.subactionPaths = subactionPaths.data();
-            actionInfo.countSubactionPaths = (uint32_t)subactionPaths.size();
-
-            actionInfo.actionType = XR_ACTION_TYPE_BOOLEAN_INPUT;
-            strcpy(actionInfo.actionName, "throw");
-            strcpy(actionInfo.localizedActionName, "Throw");
-            XRC_CHECK_THROW_XRCMD(xrCreateAction(actionSet, &actionInfo, &throwAction));
-
-            actionInfo.actionType = XR_ACTION_TYPE_POSE_INPUT;
-            strcpy(actionInfo.actionName, "grip_pose");
-            strcpy(actionInfo.localizedActionName, "Grip pose");
-            actionInfo.subactionPaths = subactionPaths.data();
-            actionInfo.countSubactionPaths = (uint32_t)subactionPaths.size();
-            XRC_CHECK_THROW_XRCMD(xrCreateAction(actionSet, &actionInfo, &gripPoseAction));
-        }
-
-        const std::vector<XrActionSuggestedBinding> bindings = {
-            {throwAction, StringToPath(compositionHelper.GetInstance(), "/user/hand/left/input/select/click")},
-            {throwAction, StringToPath(compositionHelper.GetInstance(), "/user/hand/right/input/select/click")},
-            {failAction, StringToPath(compositionHelper.GetInstance(), "/user/hand/left/input/menu/click")},
-            {failAction, StringToPath(compositionHelper.GetInstance(), "/user/hand/right/input/menu/click")},
-            {gripPoseAction, StringToPath(compositionHelper.GetInstance(), "/user/hand/left/input/grip/pose")},
-            {gripPoseAction, StringToPath(compositionHelper.GetInstance(), "/user/hand/right/input/grip/pose")},
-        };
-
-        XrInteractionProfileSuggestedBinding suggestedBindings{XR_TYPE_INTERACTION_PROFILE_SUGGESTED_BINDING};
-        suggestedBindings.interactionProfile = StringToPath(compositionHelper.GetInstance(), "/interaction_profiles/khr/simple_controller");
-        suggestedBindings.suggestedBindings = bindings.data();
-        suggestedBindings.countSuggestedBindings = (uint32_t)bindings.size();
-        XRC_CHECK_THROW_XRCMD(xrSuggestInteractionProfileBindings(compositionHelper.GetInstance(), &suggestedBindings));
-
-        XrSessionActionSetsAttachInfo attachInfo{XR_TYPE_SESSION_ACTION_SETS_ATTACH_INFO};
-        attachInfo.actionSets = &actionSet;
-        attachInfo.countActionSets = 1;
-        XRC_CHECK_THROW_XRCMD(xrAttachSessionActionSets(compositionHelper.GetSession(), &attachInfo));
+        const ThrowInput input = CreateThrowInput(compositionHelper);
 
         compositionHelper.BeginSession();
 
@@ -126,30 +235,6 @@ namespace Conformance
                                               localSpace, 1, {{0, 0, 0, 1}, {-1.5f, 0, -0.3f}});
         XrQuaternionf_CreateFromAxisAngle(&instructionsQuad->pose.orientation, &Up, 70 * MATH_PI / 180);
 
-        // Spaces attached to the hand (subaction).
-        struct HandThrowSpaces
-        {
-            XrPath subactionPath;
-            std::vector<XrSpace> spaces;
-        };
-        std::vector<HandThrowSpaces> throwSpaces;
-
-        // Create XrSpaces at various spaces around the grip poses.
-        for (XrPath subactionPath : subactionPaths) {
-            HandThrowSpaces handThrowSpaces;
-            handThrowSpaces.subactionPath = subactionPath;
-            for (float meterDistance : {0.0f, 0.25f, 0.5f}) {
-                XrSpace handSpace;
-                XrActionSpaceCreateInfo spaceCreateInfo{XR_TYPE_ACTION_SPACE_CREATE_INFO};
-                spaceCreateInfo.action = gripPoseAction;
-                spaceCreateInfo.subactionPath = subactionPath;
-                spaceCreateInfo.poseInActionSpace = {{0, 0, 0, 1}, {0, 0, -meterDistance}};
-                XRC_CHECK_THROW_XRCMD(xrCreateActionSpace(compositionHelper.GetSession(), &spaceCreateInfo, &handSpace));
-                handThrowSpaces.spaces.push_back(handSpace);
-            }
-            throwSpaces.push_back(std::move(handThrowSpaces));
-        }
-
         struct ThrownCube
         {
             XrSpaceVelocity velocity;  // Velocity of space that was captured when a throw happened.
@@ -171,22 +256,9 @@ namespace Conformance
         auto update = [&](const XrFrameState& frameState) {
             std::vector<Cube> cubes;
 
-            const std::array<XrActiveActionSet, 1> activeActionSets = {{actionSet, XR_NULL_PATH}};
-            XrActionsSyncInfo syncInfo{XR_TYPE_ACTIONS_SYNC_INFO};
-            syncInfo.activeActionSets = activeActionSets.data();
-            syncInfo.countActiveActionSets = (uint32_t)activeActionSets.size();
-            XRC_CHECK_THROW_XRCMD(xrSyncActions(compositionHelper.GetSession(), &syncInfo));
-
             // Check if user has requested to fail the test.
-            {
-                XrActionStateGetInfo completeActionGetInfo{XR_TYPE_ACTION_STATE_GET_INFO};
-                completeActionGetInfo.action = failAction;
-                XrActionStateBoolean completeActionState{XR_TYPE_ACTION_STATE_BOOLEAN};
-                XRC_CHECK_THROW_XRCMD(
-                    xrGetActionStateBoolean(compositionHelper.GetSession(), &completeActionGetInfo, &completeActionState));
-                if (completeActionState.currentState == XR_TRUE && completeActionState.changedSinceLastSync) {
-                    return false;
-                }
+            if (SyncThrowInput(compositionHelper, input)) {
+                return false;
             }
 
             // Remove thrown cubes older than 3s.
@@ -260,9 +332,9 @@ namespace Conformance
 
             // Locate throw spaces and add as cubes. Spawn thrown cubes when select released.
             {
-                for (auto& subactionSpaces : throwSpaces) {
+                for (auto& subactionSpaces : input.throwSpaces) {
                     XrActionStateGetInfo getInfo{XR_TYPE_ACTION_STATE_GET_INFO};
-                    getInfo.action = throwAction;
+                    getInfo.action = input.throwAction;
                     getInfo.subactionPath = subactionSpaces.subactionPath;
                     XrActionStateBoolean boolState{XR_TYPE_ACTION_STATE_BOOLEAN};
                     XRC_CHECK_THROW_XRCMD(xrGetActionStateBoolean(compositionHelper.GetSession(), &getInfo, &boolState));
@@ -305,40 +377,286 @@ namespace Conformance
                 }
             }
 
-            auto viewData = compositionHelper.LocateViews(localSpace, frameState.predictedDisplayTime);
-            const auto& viewState = std::get<XrViewState>(viewData);
+            RenderThrowFrame(compositionHelper, localSpace, projLayer, swapchains, instructionsQuad, frameState, cubes);
 
-            std::vector<XrCompositionLayerBaseHeader*> layers;
-            if (viewState.viewStateFlags & XR_VIEW_STATE_POSITION_VALID_BIT &&
-                viewState.viewStateFlags & XR_VIEW_STATE_ORIENTATION_VALID_BIT) {
-                const auto& views = std::get<std::vector<XrView>>(viewData);
+            return compositionHelper.PollEvents();
+        };
 
-                // Render into each view port of the wide swapchain using the projection layer view fov and pose.
-                for (size_t view = 0; view < views.size(); view++) {
-                    compositionHelper.AcquireWaitReleaseImage(
-                        swapchains[view], [&](const XrSwapchainImageBaseHeader* swapchainImage, uint64_t format) {
-                            GetGlobalData().graphicsPlugin->ClearImageSlice(swapchainImage, 0, format);
-                            const_cast<XrFovf&>(projLayer->views[view].fov) = views[view].fov;
-                            const_cast<XrPosef&>(projLayer->views[view].pose) = views[view].pose;
-                            GetGlobalData().graphicsPlugin->RenderView(projLayer->views[view], swapchainImage, format, cubes);
-                        });
-                }
+        RenderLoop(compositionHelper, update).Loop();
 
-                layers.push_back({reinterpret_cast<XrCompositionLayerBaseHeader*>(projLayer)});
+        // The render loop will end if the user hits and removes all three target cubes or if the user presses menu.
+        if (!targetCubes.empty()) {
+            FAIL("User has failed the test");
+        }
+    }
+
+    // Purpose: Verify action space velocities at scale, with bursts of thousands of thrown cubes.
+    // 1. Each throw launches a burst of cubes from every throw space, spread around the velocities located at the
+    //    action state changed timestamp; they are simulated together by ProjectileBatch and drawn instanced.
+    // 2. The located velocity of each throw space is checked against its next location, as the error of predicting one
+    //    frame ahead from the velocity, while many cubes are in flight.
+    TEST_CASE("Interactive Throw Batched", "[scenario][interactive]")
+    {
+        const char* instructions =
+            "Press and hold 'select' to spawn three rigidly-attached cubes to that controller. "
+            "Release 'select' to throw a burst of small cubes from each of them, spread around its velocity. "
+            "The bursts should leave in the direction and with the spin of the controller. "
+            "Hit the three target cubes to complete the test. Press the menu button to fail the test. ";
+
+        constexpr size_t projectilesPerThrowSpace = 1024;
+        constexpr size_t maxProjectiles = 16 * projectilesPerThrowSpace;
+        constexpr float linearSpread = 0.5f;   // meters per second, on each axis.
+        constexpr float angularSpread = 2.0f;  // radians per second, on each axis.
+        constexpr XrDuration projectileLifetime = 3'000'000'000;
+
+        CompositionHelper compositionHelper("Interactive Throw Batched");
+
+        const XrSpace localSpace = compositionHelper.CreateReferenceSpace(XR_REFERENCE_SPACE_TYPE_LOCAL, XrPosefCPP{});
+
+        // Set up composition projection layer and swapchains (one swapchain per view).
+        std::vector<XrSwapchain> swapchains;
+        XrCompositionLayerProjection* const projLayer = compositionHelper.CreateProjectionLayer(localSpace);
+        {
+            const std::vector<XrViewConfigurationView> viewProperties = compositionHelper.EnumerateConfigurationViews();
+            for (uint32_t j = 0; j < projLayer->viewCount; j++) {
+                const XrSwapchain swapchain = compositionHelper.CreateSwapchain(compositionHelper.DefaultColorSwapchainCreateInfo(
+                    viewProperties[j].recommendedImageRectWidth, viewProperties[j].recommendedImageRectHeight));
+                const_cast<XrSwapchainSubImage&>(projLayer->views[j].subImage) = compositionHelper.MakeDefaultSubImage(swapchain, 0);
+                swapchains.push_back(swapchain);
             }
+        }
 
-            layers.push_back({reinterpret_cast<XrCompositionLayerBaseHeader*>(instructionsQuad)});
+        const ThrowInput input = CreateThrowInput(compositionHelper);
 
-            compositionHelper.EndFrame(frameState.predictedDisplayTime, layers);
+        compositionHelper.BeginSession();
+
+        // Create the instructional quad layer placed to the left.
+        XrCompositionLayerQuad* const instructionsQuad =
+            compositionHelper.CreateQuadLayer(compositionHelper.CreateStaticSwapchainImage(CreateTextImage(1024, 512, instructions, 48)),
+                                              localSpace, 1, {{0, 0, 0, 1}, {-1.5f, 0, -0.3f}});
+        XrQuaternionf_CreateFromAxisAngle(&instructionsQuad->pose.orientation, &Up, 70 * MATH_PI / 180);
+
+        ProjectileBatch projectiles(maxProjectiles);
+        RandEngine randEngine(GetGlobalData().GetRandEngine().GetSeed(), RandEngine::StreamIndexFromName("Interactive Throw Batched"));
+        auto spread = [&randEngine](float amount) { return amount * (randEngine.RandInt32(-1000, 1001) / 1000.0f); };
+        XrTime simulatedTime = 0;
+        size_t peakProjectileCount = 0;
+
+        // The location of each throw space in the previous frame, to check the velocity it was located with.
+        struct LocatedThrowSpace
+        {
+            XrVector3f position;
+            XrVector3f linearVelocity;
+            XrTime time;
+        };
+        std::map<XrSpace, LocatedThrowSpace> previousLocations;
+        std::vector<float> predictionError;
+
+        std::vector<int64_t> simulateLatency;
+        std::vector<int64_t> renderLatency;
+
+        // Three fixed cubes which must be reached by the thrown cubes to pass the test.
+        std::vector<XrVector3f> targetCubes{{-1, -1, -3.0f}, {1, -1, -4.0f}, {0, 1.0f, -5.0f}};
+
+        constexpr XrVector3f projectileCubeScale{0.02f, 0.02f, 0.02f};
+        constexpr XrVector3f inactiveCubeScale{0.05f, 0.05f, 0.05f};
+        constexpr XrVector3f activateCubeScale{0.1f, 0.1f, 0.1f};
+        constexpr XrVector3f targetCubeScale{0.2f, 0.2f, 0.2f};
+        constexpr float targetCubeHitThreshold = 0.25f;
+
+        std::vector<Cube> cubes;
+        auto update = [&](const XrFrameState& frameState) {
+            cubes.clear();
+
+            // Check if user has requested to fail the test.
+            if (SyncThrowInput(compositionHelper, input)) {
+                return false;
+            }
+
+            // Advance the thrown cubes to this frame and remove the ones older than their lifetime.
+            Stopwatch stopwatch(true);
+            if (simulatedTime != 0) {
+                CHECK_MSG(frameState.predictedDisplayTime > simulatedTime, "Unexpected old frame state predictedDisplayTime");
+                projectiles.Integrate((frameState.predictedDisplayTime - simulatedTime) / (float)1'000'000'000);
+            }
+            simulatedTime = frameState.predictedDisplayTime;
+            projectiles.RemoveLaunchedBefore(frameState.predictedDisplayTime - projectileLifetime);
+
+            // Remove any target cubes which are hit by a thrown cube.
+            targetCubes.erase(std::remove_if(targetCubes.begin(), targetCubes.end(),
+                                             [&](const XrVector3f& target) { return projectiles.AnyWithin(target, targetCubeHitThreshold); }),
+                              targetCubes.end());
+            const int64_t simulateNanoseconds = stopwatch.Elapsed().count();
+
+            // Once all the targets have been hit and removed, the test is a pass.
+            if (targetCubes.empty()) {
+                return false;
+            }
+
+            // Add the targets.
+            for (const XrVector3f& targetCubePosition : targetCubes) {
+                cubes.push_back({{{0, 0, 0, 1}, targetCubePosition}, targetCubeScale});
+            }
+
+            // Locate throw spaces and add as cubes. Launch a burst from each when select is released.
+            for (auto& subactionSpaces : input.throwSpaces) {
+                XrActionStateGetInfo getInfo{XR_TYPE_ACTION_STATE_GET_INFO};
+                getInfo.action = input.throwAction;
+                getInfo.subactionPath = subactionSpaces.subactionPath;
+                XrActionStateBoolean boolState{XR_TYPE_ACTION_STATE_BOOLEAN};
+                XRC_CHECK_THROW_XRCMD(xrGetActionStateBoolean(compositionHelper.GetSession(), &getInfo, &boolState));
+
+                for (XrSpace throwSpace : subactionSpaces.spaces) {
+                    XrSpaceVelocity spaceVelocity{XR_TYPE_SPACE_VELOCITY};
+                    XrSpaceLocation spaceLocation{XR_TYPE_SPACE_LOCATION, &spaceVelocity};
+                    XRC_CHECK_THROW_XRCMD(xrLocateSpace(throwSpace, localSpace, frameState.predictedDisplayTime, &spaceLocation));
+                    if ((spaceLocation.locationFlags & XR_SPACE_LOCATION_POSITION_VALID_BIT) == 0) {
+                        previousLocations.erase(throwSpace);
+                        continue;
+                    }
+                    cubes.push_back(Cube{spaceLocation.pose, boolState.currentState ? activateCubeScale : inactiveCubeScale});
+
+                    // Compare the location with the one predicted from the previous location and its velocity.
+                    auto previous = previousLocations.find(throwSpace);
+                    if (previous != previousLocations.end()) {
+                        const float seconds = (frameState.predictedDisplayTime - previous->second.time) / (float)1'000'000'000;
+                        XrVector3f predicted, delta;
+                        XrVector3f_Scale(&predicted, &previous->second.linearVelocity, seconds);
+                        XrVector3f_Add(&predicted, &predicted, &previous->second.position);
+                        XrVector3f_Sub(&delta, &spaceLocation.pose.position, &predicted);
+                        predictionError.push_back(XrVector3f_Length(&delta));
+                    }
+                    if (spaceVelocity.velocityFlags & XR_SPACE_VELOCITY_LINEAR_VALID_BIT) {
+                        previousLocations[throwSpace] =
+                            LocatedThrowSpace{spaceLocation.pose.position, spaceVelocity.linearVelocity, frameState.predictedDisplayTime};
+                    }
+                    else {
+                        previousLocations.erase(throwSpace);
+                    }
+
+                    // Detect release of throw action.
+                    if (!boolState.changedSinceLastSync || boolState.currentState != XR_FALSE) {
+                        continue;
+                    }
+
+                    // Locate again, but this time use the action transition timestamp and also get the velocity.
+                    XrSpaceVelocity releaseSpaceVelocity{XR_TYPE_SPACE_VELOCITY};
+                    XrSpaceLocation releaseSpaceLocation{XR_TYPE_SPACE_LOCATION, &releaseSpaceVelocity};
+                    XRC_CHECK_THROW_XRCMD(xrLocateSpace(throwSpace, localSpace, boolState.lastChangeTime, &releaseSpaceLocation));
+                    if (!(releaseSpaceLocation.locationFlags & XR_SPACE_LOCATION_POSITION_VALID_BIT &&
+                          releaseSpaceLocation.locationFlags & XR_SPACE_LOCATION_ORIENTATION_VALID_BIT &&
+                          releaseSpaceVelocity.velocityFlags & XR_SPACE_VELOCITY_ANGULAR_VALID_BIT &&
+                          releaseSpaceVelocity.velocityFlags & XR_SPACE_VELOCITY_LINEAR_VALID_BIT)) {
+                        continue;
+                    }
+
+                    // The burst was launched at the release, before this frame: advance each cube to this frame before
+                    // adding it, as the batch is simulated from one time for all cubes.
+                    const float secondsSinceRelease = (frameState.predictedDisplayTime - boolState.lastChangeTime) / (float)1'000'000'000;
+                    for (size_t i = 0; i < projectilesPerThrowSpace; ++i) {
+                        XrVector3f linearVelocity = releaseSpaceVelocity.linearVelocity;
+                        linearVelocity = {linearVelocity.x + spread(linearSpread), linearVelocity.y + spread(linearSpread),
+                                          linearVelocity.z + spread(linearSpread)};
+                        XrVector3f angularVelocity = releaseSpaceVelocity.angularVelocity;
+                        angularVelocity = {angularVelocity.x + spread(angularSpread), angularVelocity.y + spread(angularSpread),
+                                           angularVelocity.z + spread(angularSpread)};
+
+                        XrPosef pose = releaseSpaceLocation.pose;
+                        XrVector3f displacement;
+                        XrVector3f_Scale(&displacement, &linearVelocity, secondsSinceRelease);
+                        displacement.y += 0.5f * ProjectileBatch::Gravity * secondsSinceRelease * secondsSinceRelease;
+                        XrVector3f_Add(&pose.position, &pose.position, &displacement);
+                        linearVelocity.y += ProjectileBatch::Gravity * secondsSinceRelease;
+
+                        // A cube that does not spin keeps the release orientation; its axis cannot be normalized.
+                        const float radiansPerSecond = XrVector3f_Length(&angularVelocity);
+                        if (radiansPerSecond > 0.0f) {
+                            XrVector3f angularAxis;
+                            XrVector3f_Scale(&angularAxis, &angularVelocity, 1.0f / radiansPerSecond);
+                            XrQuaternionf angularRotation;
+                            XrQuaternionf_CreateFromAxisAngle(&angularRotation, &angularAxis, radiansPerSecond * secondsSinceRelease);
+                            XrQuaternionf_Multiply(&pose.orientation, &releaseSpaceLocation.pose.orientation, &angularRotation);
+                        }
+
+                        if (!projectiles.Spawn(pose, linearVelocity, angularVelocity, boolState.lastChangeTime)) {
+                            break;  // Full; the oldest cubes make room as they expire.
+                        }
+                    }
+                }
+            }
+            peakProjectileCount = std::max(peakProjectileCount, projectiles.Size());
+
+            stopwatch.Restart();
+            projectiles.AppendCubes(cubes, projectileCubeScale);
+            RenderThrowFrame(compositionHelper, localSpace, projLayer, swapchains, instructionsQuad, frameState, cubes);
+            renderLatency.push_back(stopwatch.Elapsed().count());
+            simulateLatency.push_back(simulateNanoseconds);
 
             return compositionHelper.PollEvents();
         };
 
-        RenderLoop(compositionHelper.GetSession(), update).Loop();
+        RenderLoop(compositionHelper, update).Loop();
+
+        ReportF("Interactive Throw Batched, per frame, with up to %zu thrown cubes in flight:", peakProjectileCount);
+        ReportLatencyPercentiles("  simulate thrown cubes and hit targets    :", simulateLatency);
+        ReportLatencyPercentiles("  render and submit the frame              :", renderLatency);
+        ReportDistancePercentiles("  throw space one-frame velocity prediction error :", predictionError);
 
         // The render loop will end if the user hits and removes all three target cubes or if the user presses menu.
         if (!targetCubes.empty()) {
             FAIL("User has failed the test");
         }
     }
+
+    // Measures the CPU cost per frame of the thrown cubes of Interactive Throw Batched as their count grows: simulating
+    // them, building the cube list, and the instance transforms that the graphics plugins compute from the list for
+    // each view. There are no conformance requirements here.
+    TEST_CASE("Projectile Batch Scaling Benchmark", "[.][benchmark]")
+    {
+        constexpr int measuredFrameCount = 100;
+        constexpr float frameSeconds = 1.0f / 90;
+
+        RandEngine randEngine(GetGlobalData().GetRandEngine().GetSeed(),
+                              RandEngine::StreamIndexFromName("Projectile Batch Scaling Benchmark"));
+        auto spread = [&randEngine](float amount) { return amount * (randEngine.RandInt32(-1000, 1001) / 1000.0f); };
+
+        XrMatrix4x4f projection, view, viewProjection;
+        XrMatrix4x4f_CreateProjection(&projection, GRAPHICS_VULKAN, -1.0f, 1.0f, 1.0f, -1.0f, 0.05f, 100.0f);
+        XrMatrix4x4f_CreateIdentity(&view);
+        XrMatrix4x4f_Multiply(&viewProjection, &projection, &view);
+
+        ReportF("Thrown cubes, per frame over %d frames, by count:", measuredFrameCount);
+        for (size_t count = 1024; count <= 65536; count *= 4) {
+            ProjectileBatch projectiles(count);
+            for (size_t i = 0; i < count; ++i) {
+                const XrPosef pose{{0, 0, 0, 1}, {spread(0.5f), 1.0f + spread(0.5f), -1.0f + spread(0.5f)}};
+                projectiles.Spawn(pose, {spread(2.0f), 4.0f + spread(2.0f), -4.0f + spread(2.0f)},
+                                  {spread(10.0f), spread(10.0f), spread(10.0f)}, 0);
+            }
+
+            std::vector<Cube> cubes;
+            std::vector<XrMatrix4x4f> mvps(count);
+            std::vector<int64_t> integrateLatency, appendCubesLatency, computeMVPsLatency;
+            for (int frame = 0; frame < measuredFrameCount; ++frame) {
+                Stopwatch stopwatch(true);
+                projectiles.Integrate(frameSeconds);
+                integrateLatency.push_back(stopwatch.Elapsed().count());
+
+                cubes.clear();
+                stopwatch.Restart();
+                projectiles.AppendCubes(cubes, {0.02f, 0.02f, 0.02f});
+                appendCubesLatency.push_back(stopwatch.Elapsed().count());
+
+                stopwatch.Restart();
+                ComputeMVPs(viewProjection, cubes, mvps.data());
+                computeMVPsLatency.push_back(stopwatch.Elapsed().count());
+            }
+
+            std::string label;
+            AppendSprintf(label, "  %6zu cubes, ", count);
+            ReportLatencyPercentiles((label + "ProjectileBatch::Integrate   :").c_str(), integrateLatency);
+            ReportLatencyPercentiles((label + "ProjectileBatch::AppendCubes :").c_str(), appendCubesLatency);
+            ReportLatencyPercentiles((label + "ComputeMVPs, one view        :").c_str(), computeMVPsLatency);
+        }
+    }
 }  // namespace Conformance
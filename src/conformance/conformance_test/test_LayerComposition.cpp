@@ -14,14 +14,21 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <string>
+#include <vector>
 #include <array>
+#include <map>
 #include <thread>
+#include <future>
 #include <numeric>
 #include "utils.h"
 #include "report.h"
 #include "conformance_utils.h"
 #include "conformance_framework.h"
 #include "composition_utils.h"
+#include "perceptual_hash.h"
+#include "frame_pacing.h"
 #include <catch2/catch.hpp>
 #include <openxr/openxr.h>
 #include <xr_linear.h>
@@ -83,6 +90,54 @@ namespace
         }
     }  // namespace Quat
 
+    // The array swapchain of the Subimage Tests: a row of numbered cells per array slice, each inside a red border that should
+    // not be seen.
+    namespace NumberGrid
+    {
+        constexpr int ImageColCount = 4;
+        constexpr int ImageArrayCount = 2;
+        constexpr int ImageWidth = 1024;
+        constexpr int ImageHeight = ImageWidth / ImageColCount;
+        constexpr int RedZoneBorderSize = 16;
+        constexpr int CellWidth = (ImageWidth / ImageColCount);
+        constexpr int CellHeight = CellWidth;
+
+        // The rect inside the red border of the cell in column x.
+        XrRect2Di NumberRect(int x)
+        {
+            return {{x * CellWidth + RedZoneBorderSize, RedZoneBorderSize},
+                    {CellWidth - RedZoneBorderSize * 2, CellHeight - RedZoneBorderSize * 2}};
+        }
+
+        // The number shown in column x of an array slice, counting from 1 across the slices.
+        int Number(int arraySlice, int x)
+        {
+            return arraySlice * ImageColCount + x + 1;
+        }
+
+        // Draws an array slice of the swapchain, converted to sRGB.
+        RGBAImage CreateImage(int arraySlice)
+        {
+            RGBAImage numberGridImage(ImageWidth, ImageHeight);
+
+            // All unused areas are red (should not be seen).
+            numberGridImage.DrawRect(0, 0, numberGridImage.width, numberGridImage.height, Colors::Red);
+
+            for (int x = 0; x < ImageColCount; x++) {
+                const int number = Number(arraySlice, x);
+                const auto& color = Colors::UniqueColors[number % Colors::UniqueColors.size()];
+                const XrRect2Di numberRect = NumberRect(x);
+                numberGridImage.DrawRect(numberRect.offset.x, numberRect.offset.y, numberRect.extent.width, numberRect.extent.height,
+                                         Colors::Transparent);
+                numberGridImage.PutText(numberRect, std::to_string(number).c_str(), CellHeight, color);
+                numberGridImage.DrawRectBorder(numberRect.offset.x, numberRect.offset.y, numberRect.extent.width, numberRect.extent.height,
+                                               4, color);
+            }
+            numberGridImage.ConvertToSRGB();
+            return numberGridImage;
+        }
+    }  // namespace NumberGrid
+
     // Appends composition layers for interacting with interactive composition tests.
     struct InteractiveLayerManager
     {
@@ -126,7 +181,7 @@ namespace
             {
                 XrSwapchain exampleSwapchain;
                 if (exampleImage) {
-                    exampleSwapchain = compositionHelper.CreateStaticSwapchainImage(RGBAImage::Load(exampleImage));
+                    exampleSwapchain = compositionHelper.CreateStaticSwapchainImage(*RGBAImage::LoadShared(exampleImage));
                 }
                 else {
                     RGBAImage image(256, 256);
@@ -164,11 +219,12 @@ namespace
             m_sceneLayers.push_back(reinterpret_cast<XrCompositionLayerBaseHeader*>(layer));
         }
 
-        bool EndFrame(const XrFrameState& frameState, std::vector<XrCompositionLayerBaseHeader*> layers = {})
+        bool EndFrame(const XrFrameState& frameState, const std::vector<XrCompositionLayerBaseHeader*>& layers = {})
         {
-            bool keepRunning = AppendLayers(layers);
+            m_frameLayers.assign(layers.begin(), layers.end());
+            bool keepRunning = AppendLayers(m_frameLayers);
             keepRunning &= m_compositionHelper.PollEvents();
-            m_compositionHelper.EndFrame(frameState.predictedDisplayTime, std::move(layers));
+            m_compositionHelper.EndFrame(frameState.predictedDisplayTime, m_frameLayers);
             return keepRunning;
         }
 
@@ -243,6 +299,8 @@ namespace
         XrCompositionLayerQuad* m_descriptionQuad;
         XrCompositionLayerQuad* m_exampleQuad;
         std::vector<XrCompositionLayerBaseHeader*> m_sceneLayers;
+        // Kept between frames so that building each frame's layer list does not allocate.
+        std::vector<XrCompositionLayerBaseHeader*> m_frameLayers;
     };
 }  // namespace
 
@@ -261,9 +319,11 @@ namespace Conformance
         compositionHelper.GetInteractionManager().AttachActionSets();
         compositionHelper.BeginSession();
 
-        const XrSwapchain greenSwapchain = compositionHelper.CreateStaticSwapchainSolidColor(Colors::Green);
-        const XrSwapchain blueSwapchain = compositionHelper.CreateStaticSwapchainSolidColor(Colors::Blue);
-        const XrSwapchain redSwapchain = compositionHelper.CreateStaticSwapchainSolidColor(Colors::Red);
+        const std::vector<XrSwapchain> solidSwapchains =
+            compositionHelper.CreateStaticSwapchainSolidColors({Colors::Green, Colors::Blue, Colors::Red});
+        const XrSwapchain greenSwapchain = solidSwapchains[0];
+        const XrSwapchain blueSwapchain = solidSwapchains[1];
+        const XrSwapchain redSwapchain = solidSwapchains[2];
 
         const XrSpace viewSpace = compositionHelper.CreateReferenceSpace(XR_REFERENCE_SPACE_TYPE_VIEW);
 
@@ -277,7 +337,7 @@ namespace Conformance
         const XrQuaternionf redRot = Quat::FromAxisAngle({0, 1, 0}, Math::DegToRad(180));
         interactiveLayerManager.AddLayer(compositionHelper.CreateQuadLayer(redSwapchain, viewSpace, 1.0f, XrPosef{redRot, {0, 0, -1}}));
 
-        RenderLoop(compositionHelper.GetSession(), [&](const XrFrameState& frameState) {
+        RenderLoop(compositionHelper, [&](const XrFrameState& frameState) {
             return interactiveLayerManager.EndFrame(frameState);
         }).Loop();
     }
@@ -298,10 +358,12 @@ namespace Conformance
         compositionHelper.GetInteractionManager().AttachActionSets();
         compositionHelper.BeginSession();
 
-        const XrSwapchain blueSwapchain = compositionHelper.CreateStaticSwapchainSolidColor(Colors::Blue);
-        const XrSwapchain greenSwapchain = compositionHelper.CreateStaticSwapchainSolidColor(Colors::Green);
-        const XrSwapchain orangeSwapchain = compositionHelper.CreateStaticSwapchainSolidColor(Colors::Orange);
-        const XrSwapchain yellowSwapchain = compositionHelper.CreateStaticSwapchainSolidColor(Colors::Yellow);
+        const std::vector<XrSwapchain> solidSwapchains =
+            compositionHelper.CreateStaticSwapchainSolidColors({Colors::Blue, Colors::Green, Colors::Orange, Colors::Yellow});
+        const XrSwapchain blueSwapchain = solidSwapchains[0];
+        const XrSwapchain greenSwapchain = solidSwapchains[1];
+        const XrSwapchain orangeSwapchain = solidSwapchains[2];
+        const XrSwapchain yellowSwapchain = solidSwapchains[3];
 
         constexpr int RotationCount = 2;
         constexpr float MaxRotationDegrees = 30;
@@ -325,7 +387,7 @@ namespace Conformance
             interactiveLayerManager.AddLayer(quad2);
         }
 
-        RenderLoop(compositionHelper.GetSession(), [&](const XrFrameState& frameState) {
+        RenderLoop(compositionHelper, [&](const XrFrameState& frameState) {
             return interactiveLayerManager.EndFrame(frameState);
         }).Loop();
     }
@@ -412,7 +474,7 @@ namespace Conformance
         createGradientTest(true, -1.02f, 0);  // Test premultiplied (left of center "answer")
         createGradientTest(false, 1.02f, 0);  // Test unpremultiplied (right of center "answer")
 
-        RenderLoop(compositionHelper.GetSession(), [&](const XrFrameState& frameState) {
+        RenderLoop(compositionHelper, [&](const XrFrameState& frameState) {
             return interactiveLayerManager.EndFrame(frameState);
         }).Loop();
     }
@@ -441,7 +503,7 @@ namespace Conformance
         quad2->eyeVisibility = XR_EYE_VISIBILITY_RIGHT;
         interactiveLayerManager.AddLayer(quad2);
 
-        RenderLoop(compositionHelper.GetSession(), [&](const XrFrameState& frameState) {
+        RenderLoop(compositionHelper, [&](const XrFrameState& frameState) {
             return interactiveLayerManager.EndFrame(frameState);
         }).Loop();
     }
@@ -458,58 +520,34 @@ namespace Conformance
         const XrSpace viewSpace = compositionHelper.CreateReferenceSpace(XR_REFERENCE_SPACE_TYPE_VIEW, XrPosef{Quat::Identity, {0, 0, -1}});
 
         constexpr float QuadZ = -4;  // How far away quads are placed.
-        constexpr int ImageColCount = 4;
-        constexpr int ImageArrayCount = 2;
-        constexpr int ImageWidth = 1024;
-        constexpr int ImageHeight = ImageWidth / ImageColCount;
-        constexpr int RedZoneBorderSize = 16;
-        constexpr int CellWidth = (ImageWidth / ImageColCount);
-        constexpr int CellHeight = CellWidth;
 
         // Create an array swapchain
-        auto swapchainCreateInfo =
-            compositionHelper.DefaultColorSwapchainCreateInfo(ImageWidth, ImageHeight, XR_SWAPCHAIN_CREATE_STATIC_IMAGE_BIT);
+        auto swapchainCreateInfo = compositionHelper.DefaultColorSwapchainCreateInfo(NumberGrid::ImageWidth, NumberGrid::ImageHeight,
+                                                                                     XR_SWAPCHAIN_CREATE_STATIC_IMAGE_BIT);
         swapchainCreateInfo.format = GetGlobalData().graphicsPlugin->GetSRGBA8Format();
-        swapchainCreateInfo.arraySize = ImageArrayCount;
+        swapchainCreateInfo.arraySize = NumberGrid::ImageArrayCount;
         const XrSwapchain swapchain = compositionHelper.CreateSwapchain(swapchainCreateInfo);
 
         // Render a grid of numbers (1,2,3,4) in slice 0 and (5,6,7,8) in slice 1 of the swapchain
         // Create a quad layer referencing each number cell.
         compositionHelper.AcquireWaitReleaseImage(swapchain, [&](const XrSwapchainImageBaseHeader* swapchainImage, uint64_t format) {
-            int number = 1;
-            for (int arraySlice = 0; arraySlice < ImageArrayCount; arraySlice++) {
-                Conformance::RGBAImage numberGridImage(ImageWidth, ImageHeight);
-
-                // All unused areas are red (should not be seen).
-                numberGridImage.DrawRect(0, 0, numberGridImage.width, numberGridImage.height, Colors::Red);
-
-                for (int x = 0; x < ImageColCount; x++) {
-                    const auto& color = Colors::UniqueColors[number % Colors::UniqueColors.size()];
-                    const XrRect2Di numberRect{{x * CellWidth + RedZoneBorderSize, RedZoneBorderSize},
-                                               {CellWidth - RedZoneBorderSize * 2, CellHeight - RedZoneBorderSize * 2}};
-                    numberGridImage.DrawRect(numberRect.offset.x, numberRect.offset.y, numberRect.extent.width, numberRect.extent.height,
-                                             Colors::Transparent);
-                    numberGridImage.PutText(numberRect, std::to_string(number).c_str(), CellHeight, color);
-                    numberGridImage.DrawRectBorder(numberRect.offset.x, numberRect.offset.y, numberRect.extent.width,
-                                                   numberRect.extent.height, 4, color);
-                    number++;
-
-                    const float quadX = Math::LinearMap(x, 0, ImageColCount - 1, -2.0f, 2.0f);
-                    const float quadY = Math::LinearMap(arraySlice, 0, ImageArrayCount - 1, 0.75f, -0.75f);
+            for (int arraySlice = 0; arraySlice < NumberGrid::ImageArrayCount; arraySlice++) {
+                for (int x = 0; x < NumberGrid::ImageColCount; x++) {
+                    const float quadX = Math::LinearMap(x, 0, NumberGrid::ImageColCount - 1, -2.0f, 2.0f);
+                    const float quadY = Math::LinearMap(arraySlice, 0, NumberGrid::ImageArrayCount - 1, 0.75f, -0.75f);
                     XrCompositionLayerQuad* const quad =
                         compositionHelper.CreateQuadLayer(swapchain, viewSpace, 1.0f, XrPosef{Quat::Identity, {quadX, quadY, QuadZ}});
                     quad->layerFlags |= XR_COMPOSITION_LAYER_BLEND_TEXTURE_SOURCE_ALPHA_BIT;
                     quad->subImage.imageArrayIndex = arraySlice;
-                    quad->subImage.imageRect = numberRect;
+                    quad->subImage.imageRect = NumberGrid::NumberRect(x);
                     quad->size.height = 1.0f;  // Height needs to be corrected since the imageRect is customized.
                     interactiveLayerManager.AddLayer(quad);
                 }
-                numberGridImage.ConvertToSRGB();
-                GetGlobalData().graphicsPlugin->CopyRGBAImage(swapchainImage, format, arraySlice, numberGridImage);
+                GetGlobalData().graphicsPlugin->CopyRGBAImage(swapchainImage, format, arraySlice, NumberGrid::CreateImage(arraySlice));
             }
         });
 
-        RenderLoop(compositionHelper.GetSession(), [&](const XrFrameState& frameState) {
+        RenderLoop(compositionHelper, [&](const XrFrameState& frameState) {
             return interactiveLayerManager.EndFrame(frameState);
         }).Loop();
     }
@@ -559,25 +597,21 @@ namespace Conformance
         const std::vector<Cube> cubes = {Cube::Make({-1, 0, -2}), Cube::Make({1, 0, -2}), Cube::Make({0, -1, -2}), Cube::Make({0, 1, -2})};
 
         auto updateLayers = [&](const XrFrameState& frameState) {
-            auto viewData = compositionHelper.LocateViews(localSpace, frameState.predictedDisplayTime);
-            const auto& viewState = std::get<XrViewState>(viewData);
+            const auto views = compositionHelper.LocateViews(localSpace, frameState.predictedDisplayTime);
+            const auto& viewState = views.viewState;
 
             std::vector<XrCompositionLayerBaseHeader*> layers;
             if (viewState.viewStateFlags & XR_VIEW_STATE_POSITION_VALID_BIT &&
                 viewState.viewStateFlags & XR_VIEW_STATE_ORIENTATION_VALID_BIT) {
-                const auto& views = std::get<std::vector<XrView>>(viewData);
-
                 // Render into each slice of the array swapchain using the projection layer view fov and pose.
                 compositionHelper.AcquireWaitReleaseImage(
                     swapchain, [&](const XrSwapchainImageBaseHeader* swapchainImage, uint64_t format) {
                         for (uint32_t slice = 0; slice < (uint32_t)views.size(); slice++) {
-                            GetGlobalData().graphicsPlugin->ClearImageSlice(swapchainImage,
-                                                                            projLayer->views[slice].subImage.imageArrayIndex, format);
-
                             const_cast<XrFovf&>(projLayer->views[slice].fov) = views[slice].fov;
                             const_cast<XrPosef&>(projLayer->views[slice].pose) = views[slice].pose;
-                            GetGlobalData().graphicsPlugin->RenderView(projLayer->views[slice], swapchainImage, format, cubes);
                         }
+                        GetGlobalData().graphicsPlugin->ClearAndRenderViews(projLayer->views, (uint32_t)views.size(), swapchainImage,
+                                                                            format, cubes);
                     });
 
                 layers.push_back(reinterpret_cast<XrCompositionLayerBaseHeader*>(projLayer));
@@ -585,7 +619,7 @@ namespace Conformance
             return interactiveLayerManager.EndFrame(frameState, layers);
         };
 
-        RenderLoop(compositionHelper.GetSession(), updateLayers).Loop();
+        RenderLoop(compositionHelper, updateLayers).Loop();
     }
 
     TEST_CASE("Projection Wide Swapchain", "[composition][interactive]")
@@ -629,14 +663,12 @@ namespace Conformance
         const std::vector<Cube> cubes = {Cube::Make({-1, 0, -2}), Cube::Make({1, 0, -2}), Cube::Make({0, -1, -2}), Cube::Make({0, 1, -2})};
 
         auto updateLayers = [&](const XrFrameState& frameState) {
-            auto viewData = compositionHelper.LocateViews(localSpace, frameState.predictedDisplayTime);
-            const auto& viewState = std::get<XrViewState>(viewData);
+            const auto views = compositionHelper.LocateViews(localSpace, frameState.predictedDisplayTime);
+            const auto& viewState = views.viewState;
 
             std::vector<XrCompositionLayerBaseHeader*> layers;
             if (viewState.viewStateFlags & XR_VIEW_STATE_POSITION_VALID_BIT &&
                 viewState.viewStateFlags & XR_VIEW_STATE_ORIENTATION_VALID_BIT) {
-                const auto& views = std::get<std::vector<XrView>>(viewData);
-
                 // Render into each view port of the wide swapchain using the projection layer view fov and pose.
                 compositionHelper.AcquireWaitReleaseImage(
                     swapchain, [&](const XrSwapchainImageBaseHeader* swapchainImage, uint64_t format) {
@@ -644,8 +676,9 @@ namespace Conformance
                         for (size_t view = 0; view < views.size(); view++) {
                             const_cast<XrFovf&>(projLayer->views[view].fov) = views[view].fov;
                             const_cast<XrPosef&>(projLayer->views[view].pose) = views[view].pose;
-                            GetGlobalData().graphicsPlugin->RenderView(projLayer->views[view], swapchainImage, format, cubes);
                         }
+                        GetGlobalData().graphicsPlugin->RenderViews(projLayer->views, (uint32_t)views.size(), swapchainImage, format,
+                                                                    cubes);
                     });
 
                 layers.push_back(reinterpret_cast<XrCompositionLayerBaseHeader*>(projLayer));
@@ -653,7 +686,7 @@ namespace Conformance
             return interactiveLayerManager.EndFrame(frameState, layers);
         };
 
-        RenderLoop(compositionHelper.GetSession(), updateLayers).Loop();
+        RenderLoop(compositionHelper, updateLayers).Loop();
     }
 
     TEST_CASE("Projection Separate Swapchains", "[composition][interactive]")
@@ -674,7 +707,7 @@ namespace Conformance
             return interactiveLayerManager.EndFrame(frameState, layers);
         };
 
-        RenderLoop(compositionHelper.GetSession(), updateLayers).Loop();
+        RenderLoop(compositionHelper, updateLayers).Loop();
     }
 
     TEST_CASE("Quad Hands", "[composition][interactive]")
@@ -770,7 +803,7 @@ namespace Conformance
             return interactiveLayerManager.EndFrame(frameState, layers);
         };
 
-        RenderLoop(compositionHelper.GetSession(), updateLayers).Loop();
+        RenderLoop(compositionHelper, updateLayers).Loop();
     }
 
     TEST_CASE("Projection Mutable Field-of-View", "[composition][interactive]")
@@ -822,14 +855,12 @@ namespace Conformance
         XrQuaternionf_CreateFromAxisAngle(&roll180, &Forward, MATH_PI);
 
         auto updateLayers = [&](const XrFrameState& frameState) {
-            auto viewData = compositionHelper.LocateViews(localSpace, frameState.predictedDisplayTime);
-            const auto& viewState = std::get<XrViewState>(viewData);
+            const auto views = compositionHelper.LocateViews(localSpace, frameState.predictedDisplayTime);
+            const auto& viewState = views.viewState;
 
             std::vector<XrCompositionLayerBaseHeader*> layers;
             if (viewState.viewStateFlags & XR_VIEW_STATE_POSITION_VALID_BIT &&
                 viewState.viewStateFlags & XR_VIEW_STATE_ORIENTATION_VALID_BIT) {
-                const auto& views = std::get<std::vector<XrView>>(viewData);
-
                 // Render into each view port of the wide swapchain using the projection layer view fov and pose.
                 compositionHelper.AcquireWaitReleaseImage(
                     swapchain, [&](const XrSwapchainImageBaseHeader* swapchainImage, uint64_t format) {
@@ -863,6 +894,272 @@ namespace Conformance
             return interactiveLayerManager.EndFrame(frameState, layers);
         };
 
-        RenderLoop(compositionHelper.GetSession(), updateLayers).Loop();
+        RenderLoop(compositionHelper, updateLayers).Loop();
+    }
+
+    // Verifies that images copied into an array swapchain read back unchanged, without an operator. This checks the
+    // graphics plugin paths used by the interactive tests.
+    TEST_CASE("Swapchain Readback", "[.][composition][readback]")
+    {
+        if (!GetGlobalData().IsUsingGraphicsPlugin()) {
+            // Nothing to check - no graphics plugin means no swapchain
+            return;
+        }
+
+        CompositionHelper compositionHelper("Swapchain Readback");
+
+        constexpr int ImageWidth = 256;
+        constexpr int ImageHeight = 128;
+        constexpr uint32_t ImageArrayCount = 2;
+
+        auto swapchainCreateInfo = compositionHelper.DefaultColorSwapchainCreateInfo(ImageWidth, ImageHeight, 0,
+                                                                                     GetGlobalData().graphicsPlugin->GetSRGBA8Format());
+        swapchainCreateInfo.usageFlags |= XR_SWAPCHAIN_USAGE_TRANSFER_SRC_BIT | XR_SWAPCHAIN_USAGE_TRANSFER_DST_BIT;
+        swapchainCreateInfo.arraySize = ImageArrayCount;
+        const XrSwapchain swapchain = compositionHelper.CreateSwapchain(swapchainCreateInfo);
+
+        // A different pattern per slice, so a readback of the wrong slice is caught too.
+        std::vector<RGBAImage> expectedImages;
+        for (uint32_t arraySlice = 0; arraySlice < ImageArrayCount; arraySlice++) {
+            RGBAImage image(ImageWidth, ImageHeight);
+            image.DrawRect(0, 0, ImageWidth, ImageHeight, Colors::Transparent);
+            for (int x = 0; x < 4; x++) {
+                const auto& color = Colors::UniqueColors[(x + arraySlice) % Colors::UniqueColors.size()];
+                image.DrawRect(x * ImageWidth / 4, 0, ImageWidth / 4, ImageHeight / 2, color);
+            }
+            image.PutText(XrRect2Di{{0, ImageHeight / 2}, {ImageWidth, ImageHeight / 2}}, std::to_string(arraySlice).c_str(),
+                          ImageHeight / 2, Colors::White);
+            image.ConvertToSRGB();
+            expectedImages.push_back(std::move(image));
+        }
+
+        std::vector<std::future<RGBAImage>> readbacks;
+        compositionHelper.AcquireWaitReleaseImage(swapchain, [&](const XrSwapchainImageBaseHeader* swapchainImage, uint64_t format) {
+            for (uint32_t arraySlice = 0; arraySlice < ImageArrayCount; arraySlice++) {
+                GetGlobalData().graphicsPlugin->CopyRGBAImage(swapchainImage, format, arraySlice, expectedImages[arraySlice]);
+            }
+            for (uint32_t arraySlice = 0; arraySlice < ImageArrayCount; arraySlice++) {
+                readbacks.push_back(GetGlobalData().graphicsPlugin->ReadbackSwapchainImage(swapchainImage, format, arraySlice));
+            }
+        });
+
+        if (!readbacks.front().valid()) {
+            WARN("The graphics plugin does not support swapchain image readback");
+            return;
+        }
+
+        for (uint32_t arraySlice = 0; arraySlice < ImageArrayCount; arraySlice++) {
+            INFO("Array slice " << arraySlice);
+            const RGBAImage actual = readbacks[arraySlice].get();
+            const RGBAImageDiff diff = CompareRGBAImages(expectedImages[arraySlice], actual);
+            CHECK(diff.differingPixels == 0);
+            CHECK(diff.maxChannelDifference == 0);
+        }
+    }
+
+    // Renders the composition examples into swapchains the way the interactive tests do, reads them back and checks that each
+    // still looks like its stored perceptual hash, without an operator. The stored hashes were taken from the intended
+    // images, so content that is lost, garbled or put in the wrong array slice is caught, while format conversions and
+    // resampling are not. Only hashes are stored, at a few bytes per image.
+    TEST_CASE("Composition Example Perceptual Hashes", "[.][composition][readback]")
+    {
+        if (!GetGlobalData().IsUsingGraphicsPlugin()) {
+            // Nothing to check - no graphics plugin means no swapchain
+            return;
+        }
+
+        std::map<std::string, uint64_t> storedHashes;
+        REQUIRE_MSG(ReadPerceptualHashes(CompositionExampleHashesFile, storedHashes),
+                    "Could not read " << CompositionExampleHashesFile << " next to the composition example images");
+
+        CompositionHelper compositionHelper("Composition Example Perceptual Hashes");
+
+        std::vector<int64_t> hashLatency;
+        auto checkReadback = [&](const std::string& imageName, RGBAImage&& readback) {
+            INFO("Image " << imageName);
+            Stopwatch stopwatch(true);
+            const uint64_t readbackHash = ComputePerceptualHash(readback);
+            hashLatency.push_back(stopwatch.Elapsed().count());
+
+            // Shows the line to store if the image was changed on purpose.
+            INFO("Rendered image hash line: " << FormatPerceptualHashLine(imageName, readbackHash));
+            const auto stored = storedHashes.find(imageName);
+            REQUIRE_MSG(stored != storedHashes.end(), "No stored hash for " << imageName);
+            CHECK(PerceptualHashDistance(readbackHash, stored->second) <= PerceptualHashMatchDistance);
+        };
+
+        // The example images, shown by the interactive tests as static sRGB swapchain images.
+        for (const auto& stored : storedHashes) {
+            const std::string& imageName = stored.first;
+            if (imageName.size() < 4 || imageName.compare(imageName.size() - 4, 4, ".png") != 0) {
+                continue;
+            }
+
+            RGBAImage image = *RGBAImage::LoadShared(imageName.c_str());
+            if (!image.isSrgb) {
+                image.ConvertToSRGB();
+            }
+
+            auto swapchainCreateInfo = compositionHelper.DefaultColorSwapchainCreateInfo(
+                image.width, image.height, 0, GetGlobalData().graphicsPlugin->GetSRGBA8Format());
+            swapchainCreateInfo.usageFlags |= XR_SWAPCHAIN_USAGE_TRANSFER_SRC_BIT | XR_SWAPCHAIN_USAGE_TRANSFER_DST_BIT;
+            const XrSwapchain swapchain = compositionHelper.CreateSwapchain(swapchainCreateInfo);
+
+            std::future<RGBAImage> readback;
+            compositionHelper.AcquireWaitReleaseImage(swapchain, [&](const XrSwapchainImageBaseHeader* swapchainImage, uint64_t format) {
+                GetGlobalData().graphicsPlugin->CopyRGBAImage(swapchainImage, format, 0, image);
+                readback = GetGlobalData().graphicsPlugin->ReadbackSwapchainImage(swapchainImage, format, 0);
+            });
+
+            if (!readback.valid()) {
+                WARN("The graphics plugin does not support swapchain image readback");
+                return;
+            }
+            checkReadback(imageName, readback.get());
+        }
+
+        // The numbered array slices of the Subimage Tests, stored as subimage_number_grid_<slice>.
+        {
+            auto swapchainCreateInfo = compositionHelper.DefaultColorSwapchainCreateInfo(
+                NumberGrid::ImageWidth, NumberGrid::ImageHeight, 0, GetGlobalData().graphicsPlugin->GetSRGBA8Format());
+            swapchainCreateInfo.usageFlags |= XR_SWAPCHAIN_USAGE_TRANSFER_SRC_BIT | XR_SWAPCHAIN_USAGE_TRANSFER_DST_BIT;
+            swapchainCreateInfo.arraySize = NumberGrid::ImageArrayCount;
+            const XrSwapchain swapchain = compositionHelper.CreateSwapchain(swapchainCreateInfo);
+
+            std::vector<std::future<RGBAImage>> readbacks;
+            compositionHelper.AcquireWaitReleaseImage(swapchain, [&](const XrSwapchainImageBaseHeader* swapchainImage, uint64_t format) {
+                for (int arraySlice = 0; arraySlice < NumberGrid::ImageArrayCount; arraySlice++) {
+                    GetGlobalData().graphicsPlugin->CopyRGBAImage(swapchainImage, format, arraySlice, NumberGrid::CreateImage(arraySlice));
+                }
+                for (int arraySlice = 0; arraySlice < NumberGrid::ImageArrayCount; arraySlice++) {
+                    readbacks.push_back(GetGlobalData().graphicsPlugin->ReadbackSwapchainImage(swapchainImage, format, arraySlice));
+                }
+            });
+
+            if (!readbacks.front().valid()) {
+                WARN("The graphics plugin does not support swapchain image readback");
+                return;
+            }
+            for (int arraySlice = 0; arraySlice < NumberGrid::ImageArrayCount; arraySlice++) {
+                checkReadback("subimage_number_grid_" + std::to_string(arraySlice), readbacks[arraySlice].get());
+            }
+        }
+
+        ReportLatencyPercentiles("ComputePerceptualHash per rendered composition example:", hashLatency);
+    }
+
+    namespace
+    {
+        constexpr int layerScalingWarmupFrameCount = 60;     // After each change of layer count.
+        constexpr int layerScalingMeasuredFrameCount = 600;  // Per layer count, to keep the whole sweep to a few minutes.
+    }  // namespace
+
+    // Measures how the compositor scales with the number of layers submitted per frame, from one layer up to the
+    // system's maxLayerCount. The layers mix quads with cylinder and equirect layers where the runtime supports them,
+    // and their swapchains have a range of sizes.
+    TEST_CASE("Layer Count Scaling Benchmark", "[.][benchmark]")
+    {
+        GlobalData& globalData = GetGlobalData();
+        if (!globalData.IsUsingGraphicsPlugin()) {
+            // Nothing to measure - no graphics plugin means no frame submission
+            return;
+        }
+
+        std::vector<const char*> extensions;
+        const bool equirectSupported = globalData.IsInstanceExtensionSupported(XR_KHR_COMPOSITION_LAYER_EQUIRECT_EXTENSION_NAME);
+        if (equirectSupported) {
+            extensions.push_back(XR_KHR_COMPOSITION_LAYER_EQUIRECT_EXTENSION_NAME);
+        }
+        // Cylinder layers are enabled by default whenever the runtime supports them.
+        const bool cylinderEnabled = globalData.IsInstanceExtensionEnabled(XR_KHR_COMPOSITION_LAYER_CYLINDER_EXTENSION_NAME);
+
+        CompositionHelper compositionHelper("Layer Count Scaling Benchmark", extensions);
+
+        XrSystemProperties systemProperties{XR_TYPE_SYSTEM_PROPERTIES};
+        REQUIRE_RESULT(xrGetSystemProperties(compositionHelper.GetInstance(), compositionHelper.GetSystemId(), &systemProperties),
+                       XR_SUCCESS);
+        // CompositionHelper::EndFrame adds the test name quad to every frame.
+        const uint32_t maxLayerCount = systemProperties.graphicsProperties.maxLayerCount - 1;
+
+        compositionHelper.GetInteractionManager().AttachActionSets();
+        compositionHelper.BeginSession();
+
+        const XrSpace localSpace = compositionHelper.CreateReferenceSpace(XR_REFERENCE_SPACE_TYPE_LOCAL);
+
+        // Cycle through swapchain sizes and colors, so that the compositor samples from differently sized images.
+        constexpr int swapchainSizes[] = {128, 256, 512, 1024};
+        std::vector<RGBAImage> images;
+        images.reserve(maxLayerCount);
+        for (uint32_t i = 0; i < maxLayerCount; ++i) {
+            const int size = swapchainSizes[i % 4];
+            const float shade = (float)(i % 8) / 7;
+            images.emplace_back(size, size);
+            images.back().DrawRect(0, 0, size, size, XrColor4f{shade, 1 - shade, 0.5f, 1});
+        }
+        const std::vector<XrSwapchain> swapchains = compositionHelper.CreateStaticSwapchainImages(images);
+
+        // Quads are stacked in front of the viewer, each slightly further away than the last. Cylinders and equirects are
+        // centered on the viewer.
+        std::vector<XrCompositionLayerBaseHeader*> layers;
+        layers.reserve(maxLayerCount);
+        for (uint32_t i = 0; i < maxLayerCount; ++i) {
+            const XrPosef pose{{0, 0, 0, 1}, {0, 0, -1.5f - 0.01f * i}};
+            switch (i % 3) {
+            case 1:
+                if (cylinderEnabled) {
+                    layers.push_back(reinterpret_cast<XrCompositionLayerBaseHeader*>(
+                        compositionHelper.CreateCylinderLayer(swapchains[i], localSpace, 1.5f, 1.0f)));
+                    continue;
+                }
+                break;
+            case 2:
+                if (equirectSupported) {
+                    layers.push_back(reinterpret_cast<XrCompositionLayerBaseHeader*>(
+                        compositionHelper.CreateEquirectLayer(swapchains[i], localSpace, 10.0f)));
+                    continue;
+                }
+                break;
+            }
+            layers.push_back(reinterpret_cast<XrCompositionLayerBaseHeader*>(
+                compositionHelper.CreateQuadLayer(swapchains[i], localSpace, 0.5f, pose)));
+        }
+
+        ReportF("Layer count scaling up to %u layers, with%s cylinder and with%s equirect layers:", maxLayerCount,
+                cylinderEnabled ? "" : "out", equirectSupported ? "" : "out");
+
+        // Double the layer count each step, finishing on the maximum.
+        for (uint32_t layerCount = 1;; layerCount = std::min(layerCount * 2, maxLayerCount)) {
+            FramePacingRecorder recorder;
+            std::vector<int64_t> endFrameLatency;
+            endFrameLatency.reserve(layerScalingMeasuredFrameCount);
+            Stopwatch endFrameStopwatch;
+
+            int frame = 0;
+            RenderLoop renderLoop(compositionHelper, [&](const XrFrameState& frameState) {
+                const bool measured = frame >= layerScalingWarmupFrameCount;
+                if (measured) {
+                    recorder.OnFrameWoken(frameState);
+                }
+
+                compositionHelper.PollEvents();
+
+                endFrameStopwatch.Restart();
+                compositionHelper.EndFrame(frameState.predictedDisplayTime, layers.data(), layerCount);
+                if (measured) {
+                    endFrameLatency.push_back(endFrameStopwatch.Elapsed().count());
+                    recorder.OnFrameEnded();
+                }
+                return ++frame < layerScalingWarmupFrameCount + layerScalingMeasuredFrameCount;
+            });
+            renderLoop.Loop();
+
+            const std::string loopName = std::to_string(layerCount) + " layers";
+            recorder.Report(loopName.c_str());
+            ReportLatencyPercentiles("  xrEndFrame CPU time              :", endFrameLatency);
+
+            if (layerCount == maxLayerCount) {
+                break;
+            }
+        }
     }
 }  // namespace Conformance
@@ -0,0 +1,179 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "utils.h"
+#include "conformance_utils.h"
+#include "conformance_framework.h"
+#include "two_call_util.h"
+#include "report.h"
+#include <openxr/openxr.h>
+#include <catch2/catch.hpp>
+
+namespace Conformance
+{
+    namespace
+    {
+        constexpr int measuredIterationCount = 50;          // Enumerations and lookups are cheap.
+        constexpr int measuredInstanceIterationCount = 10;  // Each iteration creates and destroys an instance.
+
+        // Creates an instance with only the extensions the platform and graphics plugins need, so that any set of layers
+        // can be enabled: the extensions the framework enables by default may come from a layer, such as
+        // XR_EXT_debug_utils from the conformance layer.
+        XrResult CreateInstanceWithLayers(const std::vector<const char*>& layerNames, XrInstance* instance)
+        {
+            GlobalData& globalData = GetGlobalData();
+
+            StringVec extensions;
+            for (const std::string& extension : globalData.requiredPlatformInstanceExtensions) {
+                extensions.push_back_unique(extension);
+            }
+            for (const std::string& extension : globalData.requiredGraphicsInstanceExtensions) {
+                extensions.push_back_unique(extension);
+            }
+
+            XrInstanceCreateInfo createInfo{XR_TYPE_INSTANCE_CREATE_INFO};
+            createInfo.next = globalData.requiredPlaformInstanceCreateStruct;
+            createInfo.applicationInfo.applicationVersion = 1;
+            strcpy(createInfo.applicationInfo.applicationName, "conformance test");
+            createInfo.applicationInfo.apiVersion = XR_CURRENT_API_VERSION;
+            createInfo.enabledApiLayerCount = (uint32_t)layerNames.size();
+            createInfo.enabledApiLayerNames = layerNames.data();
+            createInfo.enabledExtensionCount = (uint32_t)extensions.size();
+            createInfo.enabledExtensionNames = extensions.data();
+            return xrCreateInstance(&createInfo, instance);
+        }
+
+        // Looks up every function of GetFunctionInfoMap once and returns how long that took. Lookups of functions whose
+        // extensions are not enabled fail, as they do in GlobalData::Initialize, and are timed all the same.
+        int64_t TimeFunctionLookups(XrInstance instance)
+        {
+            Stopwatch stopwatch(true);
+            for (const auto& functionInfo : GetFunctionInfoMap()) {
+                PFN_xrVoidFunction function = nullptr;
+                xrGetInstanceProcAddr(instance, functionInfo.first.c_str(), &function);
+            }
+            return stopwatch.Elapsed().count();
+        }
+    }  // namespace
+
+    // Compares the first calls into the loader, which read manifests and load the runtime and layers, with the same calls
+    // once those are cached. The first calls of the process are the ones GlobalData::Initialize made before any test
+    // ran; each reports as a single sample. Instance creation is also timed for every count of enabled layers, from
+    // none to all the available ones in the order the loader lists them, as the first instance with that many layers
+    // and the instances after it. There are no conformance requirements here.
+    TEST_CASE("Loader Cold and Warm Benchmark", "[.][benchmark]")
+    {
+        GlobalData& globalData = GetGlobalData();
+        const LoaderColdTimings& cold = globalData.loaderColdTimings;
+
+        auto reportCold = [](const char* label, std::chrono::nanoseconds elapsed) {
+            if (elapsed.count() == 0) {
+                ReportF("%s not called by this process", label);
+                return;
+            }
+            std::vector<int64_t> samples{elapsed.count()};
+            ReportLatencyPercentiles(label, samples);
+        };
+
+        SECTION("Enumerations")
+        {
+            std::vector<int64_t> enumerateApiLayersLatency;
+            std::vector<int64_t> enumerateInstanceExtensionsLatency;
+            for (int iteration = 0; iteration < measuredIterationCount; ++iteration) {
+                std::vector<XrApiLayerProperties> layers;
+                Stopwatch stopwatch(true);
+                REQUIRE_RESULT(doTwoCallInPlaceWithEmptyElement(layers, {XR_TYPE_API_LAYER_PROPERTIES}, xrEnumerateApiLayerProperties),
+                               XR_SUCCESS);
+                enumerateApiLayersLatency.push_back(stopwatch.Elapsed().count());
+
+                std::vector<XrExtensionProperties> extensions;
+                stopwatch.Restart();
+                REQUIRE_RESULT(doTwoCallInPlaceWithEmptyElement(extensions, {XR_TYPE_EXTENSION_PROPERTIES},
+                                                                xrEnumerateInstanceExtensionProperties, nullptr),
+                               XR_SUCCESS);
+                enumerateInstanceExtensionsLatency.push_back(stopwatch.Elapsed().count());
+            }
+
+            ReportF("Loader calls, cold (first of the process) and warm, over %d iterations:", measuredIterationCount);
+            reportCold("  xrEnumerateApiLayerProperties cold          :", cold.enumerateApiLayers);
+            ReportLatencyPercentiles("  xrEnumerateApiLayerProperties warm          :", enumerateApiLayersLatency);
+            reportCold("  xrEnumerateInstanceExtensionProperties cold :", cold.enumerateInstanceExtensions);
+            ReportLatencyPercentiles("  xrEnumerateInstanceExtensionProperties warm :", enumerateInstanceExtensionsLatency);
+        }
+
+        SECTION("xrCreateInstance by enabled layer count")
+        {
+            ReportF("xrCreateInstance, cold (first of the process), then first and warm by enabled layer count, over %d iterations:",
+                    measuredInstanceIterationCount);
+            std::vector<const char*> layerNames;
+            reportCold("  xrCreateInstance cold, default layers       :", cold.createInstance);
+            for (size_t layerCount = 0; layerCount <= globalData.availableAPILayerNames.size(); ++layerCount) {
+                if (layerCount > 0) {
+                    layerNames.push_back(globalData.availableAPILayerNames[layerCount - 1].c_str());
+                }
+
+                std::vector<int64_t> firstLatency;
+                std::vector<int64_t> warmLatency;
+                XrResult result = XR_SUCCESS;
+                for (int iteration = 0; iteration <= measuredInstanceIterationCount && XR_SUCCEEDED(result); ++iteration) {
+                    XrInstance instance{XR_NULL_HANDLE};
+                    Stopwatch stopwatch(true);
+                    result = CreateInstanceWithLayers(layerNames, &instance);
+                    const int64_t elapsed = stopwatch.Elapsed().count();
+                    if (XR_SUCCEEDED(result)) {
+                        (iteration == 0 ? firstLatency : warmLatency).push_back(elapsed);
+                        xrDestroyInstance(instance);
+                    }
+                }
+
+                std::string label;
+                AppendSprintf(label, "  xrCreateInstance, %zu layer%s", layerCount, layerCount == 1 ? "" : "s");
+                if (XR_FAILED(result)) {
+                    // A layer may need an extension or another layer; the counts after it would fail the same way.
+                    ReportF("%s: failed with %s, adding %s", label.c_str(), ResultToString(result),
+                            layerCount > 0 ? layerNames.back() : "no layer");
+                    break;
+                }
+                ReportLatencyPercentiles((label + " first :").c_str(), firstLatency);
+                ReportLatencyPercentiles((label + " warm  :").c_str(), warmLatency);
+            }
+        }
+
+        SECTION("xrGetInstanceProcAddr for every function")
+        {
+            // On each new instance the loader builds its dispatch for the instance, so its first lookups are cold
+            // again; the second pass over the same instance is warm.
+            std::vector<int64_t> firstPassLatency;
+            std::vector<int64_t> warmPassLatency;
+            for (int iteration = 0; iteration < measuredInstanceIterationCount; ++iteration) {
+                AutoBasicInstance instance(AutoBasicInstance::skipDebugMessenger);
+                firstPassLatency.push_back(TimeFunctionLookups(instance));
+                for (int pass = 0; pass < measuredIterationCount / measuredInstanceIterationCount; ++pass) {
+                    warmPassLatency.push_back(TimeFunctionLookups(instance));
+                }
+            }
+
+            ReportF("xrGetInstanceProcAddr of all %zu functions of GetFunctionInfoMap, per pass:", GetFunctionInfoMap().size());
+            reportCold("  cold, probe instance of the process       :", cold.getInstanceProcAddr);
+            ReportLatencyPercentiles("  first pass on a new instance              :", firstPassLatency);
+            ReportLatencyPercentiles("  warm, later passes on the same instance   :", warmPassLatency);
+        }
+    }
+}  // namespace Conformance
@@ -0,0 +1,181 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "utils.h"
+#include "conformance_utils.h"
+#include "conformance_framework.h"
+#include "report.h"
+#include <openxr/openxr.h>
+#include <catch2/catch.hpp>
+
+namespace Conformance
+{
+    namespace
+    {
+        constexpr int warmupIterationCount = 2;     // The first instance in a process tends to pay for loading the runtime.
+        constexpr int measuredIterationCount = 25;  // Each iteration runs a whole session, so keep this modest.
+
+        // Returns the next session state change on the instance's event queue, skipping other events.
+        bool TryGetNextSessionState(XrInstance instance, XrSessionState* state)
+        {
+            XrEventDataBuffer buffer{XR_TYPE_EVENT_DATA_BUFFER};
+            XrResult result;
+            while ((result = xrPollEvent(instance, &buffer)) == XR_SUCCESS) {
+                if (buffer.type == XR_TYPE_EVENT_DATA_SESSION_STATE_CHANGED) {
+                    *state = reinterpret_cast<const XrEventDataSessionStateChanged*>(&buffer)->state;
+                    return true;
+                }
+                buffer = {XR_TYPE_EVENT_DATA_BUFFER};
+            }
+            XRC_CHECK_THROW_XRCMD(result);
+            return false;
+        }
+
+        void SubmitEmptyFrame(XrSession session)
+        {
+            XrFrameState frameState{XR_TYPE_FRAME_STATE};
+            XRC_CHECK_THROW_XRCMD(xrWaitFrame(session, nullptr, &frameState));
+            XRC_CHECK_THROW_XRCMD(xrBeginFrame(session, nullptr));
+
+            XrFrameEndInfo frameEndInfo{XR_TYPE_FRAME_END_INFO};
+            frameEndInfo.displayTime = frameState.predictedDisplayTime;
+            frameEndInfo.environmentBlendMode = GetGlobalData().GetOptions().environmentBlendModeValue;
+            XRC_CHECK_THROW_XRCMD(xrEndFrame(session, &frameEndInfo));
+        }
+
+        // Waits for the session to reach the given state, passing through intermediate states. While the session is
+        // running, empty frames are submitted so that the runtime can advance it; otherwise the event queue is polled
+        // every millisecond, which bounds the resolution of the measured time.
+        void WaitForSessionState(XrInstance instance, XrSession session, XrSessionState targetState, bool sessionRunning)
+        {
+            CAPTURE(targetState);
+
+            CountdownTimer countdown(30_sec);
+            XrSessionState state;
+            while (!countdown.IsTimeUp()) {
+                while (TryGetNextSessionState(instance, &state)) {
+                    if (state == targetState) {
+                        return;
+                    }
+                }
+
+                if (sessionRunning) {
+                    SubmitEmptyFrame(session);
+                }
+                else {
+                    std::this_thread::sleep_for(1_ms);
+                }
+            }
+
+            FAIL("Failed to reach expected session state");
+        }
+    }  // namespace
+
+    // Times every step an application takes from launch to a focused session and back to exit, to show how long a
+    // cold start and a clean shutdown take on a runtime and which call dominates.
+    TEST_CASE("Session Lifecycle Benchmark", "[.][benchmark]")
+    {
+        GlobalData& globalData = GetGlobalData();
+        const Options& options = globalData.GetOptions();
+
+        std::vector<int64_t> createInstanceLatency, getSystemLatency, createSessionLatency, readyLatency, beginSessionLatency,
+            focusedLatency, stoppingLatency, endSessionLatency, destroySessionLatency, destroyInstanceLatency;
+
+        Stopwatch stopwatch;
+        for (int iteration = 0; iteration < warmupIterationCount + measuredIterationCount; ++iteration) {
+            const bool measured = iteration >= warmupIterationCount;
+            auto record = [&](std::vector<int64_t>& samples) {
+                if (measured) {
+                    samples.push_back(stopwatch.Elapsed().count());
+                }
+            };
+
+            // Declared in this order so that the scope guards tear down the session, then the device, then the instance.
+            std::unique_ptr<AutoBasicInstance> instance;
+            XrSession session{XR_NULL_HANDLE};
+
+            stopwatch.Restart();
+            instance.reset(new AutoBasicInstance(AutoBasicInstance::skipDebugMessenger));
+            record(createInstanceLatency);
+
+            XrSystemGetInfo systemGetInfo{XR_TYPE_SYSTEM_GET_INFO, nullptr, options.formFactorValue};
+            XrSystemId systemId{XR_NULL_SYSTEM_ID};
+            stopwatch.Restart();
+            REQUIRE_RESULT(xrGetSystem(*instance, &systemGetInfo, &systemId), XR_SUCCESS);
+            record(getSystemLatency);
+
+            // Device creation is application work, so it is kept out of the timed calls.
+            AutoGraphicsDevice graphicsDevice(*instance, systemId);
+            CleanupSessionOnScopeExit cleanupSession(session);
+
+            XrSessionCreateInfo sessionCreateInfo{XR_TYPE_SESSION_CREATE_INFO};
+            sessionCreateInfo.next = graphicsDevice.GetGraphicsBinding();
+            sessionCreateInfo.systemId = systemId;
+            stopwatch.Restart();
+            REQUIRE_RESULT(xrCreateSession(*instance, &sessionCreateInfo, &session), XR_SUCCESS);
+            record(createSessionLatency);
+
+            stopwatch.Restart();
+            WaitForSessionState(*instance, session, XR_SESSION_STATE_READY, false);
+            record(readyLatency);
+
+            XrSessionBeginInfo sessionBeginInfo{XR_TYPE_SESSION_BEGIN_INFO,
+                                                globalData.GetPlatformPlugin()->PopulateNextFieldForStruct(XR_TYPE_SESSION_BEGIN_INFO),
+                                                options.viewConfigurationValue};
+            stopwatch.Restart();
+            REQUIRE_RESULT(xrBeginSession(session, &sessionBeginInfo), XR_SUCCESS);
+            record(beginSessionLatency);
+
+            stopwatch.Restart();
+            WaitForSessionState(*instance, session, XR_SESSION_STATE_FOCUSED, true);
+            record(focusedLatency);
+
+            stopwatch.Restart();
+            REQUIRE_RESULT(xrRequestExitSession(session), XR_SUCCESS);
+            WaitForSessionState(*instance, session, XR_SESSION_STATE_STOPPING, true);
+            record(stoppingLatency);
+
+            stopwatch.Restart();
+            REQUIRE_RESULT(xrEndSession(session), XR_SUCCESS);
+            record(endSessionLatency);
+
+            stopwatch.Restart();
+            cleanupSession.Destroy();
+            record(destroySessionLatency);
+
+            stopwatch.Restart();
+            instance.reset();
+            record(destroyInstanceLatency);
+        }
+
+        ReportF("Session lifecycle over %d iterations:", measuredIterationCount);
+        ReportLatencyPercentiles("  xrCreateInstance                 :", createInstanceLatency);
+        ReportLatencyPercentiles("  xrGetSystem                      :", getSystemLatency);
+        ReportLatencyPercentiles("  xrCreateSession                  :", createSessionLatency);
+        ReportLatencyPercentiles("  xrCreateSession to READY         :", readyLatency);
+        ReportLatencyPercentiles("  xrBeginSession                   :", beginSessionLatency);
+        ReportLatencyPercentiles("  xrBeginSession to FOCUSED        :", focusedLatency);
+        ReportLatencyPercentiles("  xrRequestExitSession to STOPPING :", stoppingLatency);
+        ReportLatencyPercentiles("  xrEndSession                     :", endSessionLatency);
+        ReportLatencyPercentiles("  xrDestroySession                 :", destroySessionLatency);
+        ReportLatencyPercentiles("  xrDestroyInstance                :", destroyInstanceLatency);
+    }
+}  // namespace Conformance
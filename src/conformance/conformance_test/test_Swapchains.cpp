@@ -18,10 +18,16 @@
 #include "conformance_utils.h"
 #include "conformance_framework.h"
 #include "matchers.h"
+#include "pairwise_generator.h"
 #include "swapchain_parameters.h"
 #include "report.h"
+#include "results_stream.h"
 #include <openxr/openxr.h>
 #include <catch2/catch.hpp>
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <thread>
 #include <vector>
 #include <set>
 
@@ -163,8 +169,10 @@ namespace Conformance
             return;
         }
 
-        // Set up the session we will use for the testing
-        AutoBasicSession session(AutoBasicSession::OptionFlags::beginSession);
+        // Set up the session we will use for the testing. Every swapchain a section creates is destroyed again, so the
+        // sections can share the session.
+        AutoBasicSession& session =
+            GetGlobalData().GetSectionFixture<AutoBasicSession>("session", AutoBasicSession::OptionFlags::beginSession);
 
         std::vector<int64_t> imageFormatArray;
         const int64_t imageFormatInvalid = XRC_INVALID_IMAGE_FORMAT;
@@ -295,40 +303,432 @@ namespace Conformance
                             }
                         }
 
-                        for (const auto& cf : tp.createFlagsVector) {
-                            auto createInfo = createDefaultSwapchain();
-                            CAPTURE(createInfo.createFlags = (XrSwapchainCreateFlags)cf);
-                            testSwapchainCreation(createInfo);
+                        if (globalData.options.swapchainCoveragePairwise) {
+                            // Every pair of values of any two of the parameters is used together at least once, which also
+                            // uses every single value, for about as many swapchains as the two largest vectors multiplied.
+                            auto&& generator =
+                                pairwiseGenerator({tp.createFlagsVector.size(), tp.sampleCountVector.size(), tp.usageFlagsVector.size(),
+                                                   tp.arrayCountVector.size(), tp.mipCountVector.size()});
+                            while (generator.next()) {
+                                const std::vector<size_t>& values = generator.get();
+                                auto createInfo = createDefaultSwapchain();
+                                CAPTURE(createInfo.createFlags = (XrSwapchainCreateFlags)tp.createFlagsVector[values[0]]);
+                                CAPTURE(createInfo.sampleCount = tp.sampleCountVector[values[1]]);
+                                CAPTURE(createInfo.usageFlags = (XrSwapchainUsageFlags)tp.usageFlagsVector[values[2]]);
+                                CAPTURE(createInfo.arraySize = tp.arrayCountVector[values[3]]);
+                                CAPTURE(createInfo.mipCount = tp.mipCountVector[values[4]]);
+                                testSwapchainCreation(createInfo);
+                            }
                         }
+                        else {
+                            for (const auto& cf : tp.createFlagsVector) {
+                                auto createInfo = createDefaultSwapchain();
+                                CAPTURE(createInfo.createFlags = (XrSwapchainCreateFlags)cf);
+                                testSwapchainCreation(createInfo);
+                            }
 
-                        for (const auto& sc : tp.sampleCountVector) {
-                            auto createInfo = createDefaultSwapchain();
-                            CAPTURE(createInfo.sampleCount = sc);
-                            testSwapchainCreation(createInfo);
-                        }
+                            for (const auto& sc : tp.sampleCountVector) {
+                                auto createInfo = createDefaultSwapchain();
+                                CAPTURE(createInfo.sampleCount = sc);
+                                testSwapchainCreation(createInfo);
+                            }
 
-                        for (const auto& uf : tp.usageFlagsVector) {
-                            auto createInfo = createDefaultSwapchain();
-                            CAPTURE(createInfo.usageFlags = (XrSwapchainUsageFlags)uf);
-                            testSwapchainCreation(createInfo);
+                            for (const auto& uf : tp.usageFlagsVector) {
+                                auto createInfo = createDefaultSwapchain();
+                                CAPTURE(createInfo.usageFlags = (XrSwapchainUsageFlags)uf);
+                                testSwapchainCreation(createInfo);
+                            }
+
+                            for (const auto& ac : tp.arrayCountVector) {
+                                auto createInfo = createDefaultSwapchain();
+                                CAPTURE(createInfo.arraySize = ac);
+                                testSwapchainCreation(createInfo);
+                            }
+
+                            for (const auto& mc : tp.mipCountVector) {
+                                auto createInfo = createDefaultSwapchain();
+                                CAPTURE(createInfo.mipCount = mc);
+                                testSwapchainCreation(createInfo);
+                            }
                         }
 
-                        for (const auto& ac : tp.arrayCountVector) {
-                            auto createInfo = createDefaultSwapchain();
-                            CAPTURE(createInfo.arraySize = ac);
-                            testSwapchainCreation(createInfo);
+                        ReportF("    %d cases tested (%d unsupported)", swapchainCreateCount, unsupportedCount);
+                    }
+                }
+            }
+        }
+    }
+
+    namespace
+    {
+        constexpr int swapchainWarmupCycleCount = 50;
+        constexpr int swapchainMeasuredCycleCount = 1000;
+
+        // Timings of one swapchain's acquire/wait/release cycles, collected on its own thread.
+        struct SwapchainCycleTimings
+        {
+            XrResult failure{XR_SUCCESS};
+            const char* failedCall{nullptr};
+            std::vector<int64_t> acquireLatency;
+            std::vector<int64_t> waitLatency;
+            std::vector<int64_t> releaseLatency;
+        };
+
+        // Cycles the swapchain without rendering. Catch assertions are not thread-safe, so failures are recorded
+        // and checked by the caller after the threads have been joined.
+        void CycleSwapchainImages(XrSwapchain swapchain, std::mutex* graphicsMutex, SwapchainCycleTimings& timings)
+        {
+            using clock = MonotonicClock;
+            auto nanoseconds = [](clock::duration duration) {
+                return (int64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+            };
+            auto fail = [&](const char* call, XrResult result) {
+                timings.failure = result;
+                timings.failedCall = call;
+            };
+
+            timings.acquireLatency.reserve(swapchainMeasuredCycleCount);
+            timings.waitLatency.reserve(swapchainMeasuredCycleCount);
+            timings.releaseLatency.reserve(swapchainMeasuredCycleCount);
+
+            for (int cycle = 0; cycle < swapchainWarmupCycleCount + swapchainMeasuredCycleCount; ++cycle) {
+                XrSwapchainImageAcquireInfo acquireInfo{XR_TYPE_SWAPCHAIN_IMAGE_ACQUIRE_INFO};
+                XrSwapchainImageWaitInfo waitInfo{XR_TYPE_SWAPCHAIN_IMAGE_WAIT_INFO};
+                waitInfo.timeout = XR_INFINITE_DURATION;
+                XrSwapchainImageReleaseInfo releaseInfo{XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO};
+                uint32_t index;
+
+                const clock::time_point acquireStart = clock::now();
+                XrResult result;
+                {
+                    std::unique_lock<std::mutex> lock;
+                    if (graphicsMutex) {
+                        lock = std::unique_lock<std::mutex>(*graphicsMutex);
+                    }
+                    result = xrAcquireSwapchainImage(swapchain, &acquireInfo, &index);
+                }
+                const clock::time_point waitStart = clock::now();
+                if (result != XR_SUCCESS) {
+                    return fail("xrAcquireSwapchainImage", result);
+                }
+                result = xrWaitSwapchainImage(swapchain, &waitInfo);
+                const clock::time_point releaseStart = clock::now();
+                if (result != XR_SUCCESS) {
+                    return fail("xrWaitSwapchainImage", result);
+                }
+                {
+                    std::unique_lock<std::mutex> lock;
+                    if (graphicsMutex) {
+                        lock = std::unique_lock<std::mutex>(*graphicsMutex);
+                    }
+                    result = xrReleaseSwapchainImage(swapchain, &releaseInfo);
+                }
+                const clock::time_point releaseEnd = clock::now();
+                if (result != XR_SUCCESS) {
+                    return fail("xrReleaseSwapchainImage", result);
+                }
+
+                if (cycle >= swapchainWarmupCycleCount) {
+                    timings.acquireLatency.push_back(nanoseconds(waitStart - acquireStart));
+                    timings.waitLatency.push_back(nanoseconds(releaseStart - waitStart));
+                    timings.releaseLatency.push_back(nanoseconds(releaseEnd - releaseStart));
+                }
+            }
+        }
+    }  // namespace
+
+    // Measures how many swapchain image acquire/wait/release calls per second the runtime sustains, for every supported
+    // format and array size, with one to several swapchains cycled in parallel threads.
+    TEST_CASE("Swapchain Image Cycle Benchmark", "[.][benchmark]")
+    {
+        GlobalData& globalData = GetGlobalData();
+        if (!globalData.IsUsingGraphicsPlugin()) {
+            // Nothing to measure - no graphics plugin means no swapchain
+            return;
+        }
+
+        AutoBasicSession session(AutoBasicSession::OptionFlags::beginSession);
+
+        // An OpenGL context may only be used from the thread it is current on, so OpenGL only measures a single
+        // swapchain on this thread. Vulkan requires the queue used by acquire and release to be externally
+        // synchronized, so those calls are serialized across threads.
+        bool singleThreadOnly = false;
+        bool serializeQueueAccess = false;
+#if defined(XR_USE_GRAPHICS_API_OPENGL)
+        singleThreadOnly |= globalData.IsInstanceExtensionEnabled(XR_KHR_OPENGL_ENABLE_EXTENSION_NAME);
+#endif  // defined(XR_USE_GRAPHICS_API_OPENGL)
+#if defined(XR_USE_GRAPHICS_API_OPENGL_ES)
+        singleThreadOnly |= globalData.IsInstanceExtensionEnabled(XR_KHR_OPENGL_ES_ENABLE_EXTENSION_NAME);
+#endif  // defined(XR_USE_GRAPHICS_API_OPENGL_ES)
+#if defined(XR_USE_GRAPHICS_API_VULKAN)
+        serializeQueueAccess |= globalData.IsInstanceExtensionEnabled(XR_KHR_VULKAN_ENABLE_EXTENSION_NAME) ||
+                                globalData.IsInstanceExtensionEnabled(XR_KHR_VULKAN_ENABLE2_EXTENSION_NAME);
+#endif  // defined(XR_USE_GRAPHICS_API_VULKAN)
+        std::mutex queueMutex;
+
+        std::vector<uint32_t> swapchainCounts{1};
+        if (!singleThreadOnly) {
+            const uint32_t maxSwapchainCount = std::min(4u, std::max(1u, std::thread::hardware_concurrency()));
+            for (uint32_t count = 2; count <= maxSwapchainCount; count *= 2) {
+                swapchainCounts.push_back(count);
+            }
+        }
+
+        uint32_t formatCount = 0;
+        REQUIRE_RESULT_UNQUALIFIED_SUCCESS(xrEnumerateSwapchainFormats(session, 0, &formatCount, nullptr));
+        std::vector<int64_t> imageFormatArray(formatCount);
+        REQUIRE_RESULT_UNQUALIFIED_SUCCESS(xrEnumerateSwapchainFormats(session, formatCount, &formatCount, imageFormatArray.data()));
+
+        for (int64_t imageFormat : imageFormatArray) {
+            SwapchainCreateTestParameters tp;
+            REQUIRE(globalData.graphicsPlugin->GetSwapchainCreateTestParameters(session.instance, session, session.systemId, imageFormat,
+                                                                                &tp));
+
+            for (uint32_t arraySize : tp.arrayCountVector) {
+                for (uint32_t swapchainCount : swapchainCounts) {
+                    XrSwapchainCreateInfo createInfo{XR_TYPE_SWAPCHAIN_CREATE_INFO};
+                    createInfo.faceCount = 1;
+                    createInfo.format = imageFormat;
+                    createInfo.createFlags = 0;  // Static images can only be acquired once.
+                    createInfo.usageFlags = (XrSwapchainUsageFlags)tp.usageFlagsVector[0];
+                    createInfo.sampleCount = 1;
+                    createInfo.width = 64;
+                    createInfo.height = 64;
+                    createInfo.arraySize = arraySize;
+                    createInfo.mipCount = 1;
+
+                    std::vector<XrSwapchain> swapchains;
+                    XrResult createResult = XR_SUCCESS;
+                    while (swapchains.size() < swapchainCount) {
+                        XrSwapchain swapchain;
+                        createResult = xrCreateSwapchain(session, &createInfo, &swapchain);
+                        if (XR_FAILED(createResult)) {
+                            break;
                         }
+                        swapchains.push_back(swapchain);
 
-                        for (const auto& mc : tp.mipCountVector) {
-                            auto createInfo = createDefaultSwapchain();
-                            CAPTURE(createInfo.mipCount = mc);
-                            testSwapchainCreation(createInfo);
+                        // The images must be enumerated before they are acquired.
+                        uint32_t imageCount = 0;
+                        FAST_REQUIRE_RESULT_UNQUALIFIED_SUCCESS(xrEnumerateSwapchainImages(swapchain, 0, &imageCount, nullptr));
+                    }
+
+                    if (XR_SUCCEEDED(createResult)) {
+                        std::mutex* const graphicsMutex = serializeQueueAccess ? &queueMutex : nullptr;
+                        std::vector<SwapchainCycleTimings> timings(swapchainCount);
+
+                        const auto start = MonotonicClock::now();
+                        std::vector<std::thread> threads;
+                        for (uint32_t i = 1; i < swapchainCount; ++i) {
+                            threads.emplace_back(CycleSwapchainImages, swapchains[i], graphicsMutex, std::ref(timings[i]));
+                        }
+                        CycleSwapchainImages(swapchains[0], graphicsMutex, timings[0]);
+                        for (std::thread& thread : threads) {
+                            thread.join();
+                        }
+                        const double seconds = std::chrono::duration<double>(MonotonicClock::now() - start).count();
+
+                        std::vector<int64_t> acquireLatency, waitLatency, releaseLatency;
+                        for (SwapchainCycleTimings& swapchainTimings : timings) {
+                            INFO(tp.imageFormatName << " arraySize " << arraySize);
+                            if (swapchainTimings.failedCall != nullptr) {
+                                INFO(swapchainTimings.failedCall);
+                                REQUIRE_RESULT_UNQUALIFIED_SUCCESS(swapchainTimings.failure);
+                            }
+                            acquireLatency.insert(acquireLatency.end(), swapchainTimings.acquireLatency.begin(),
+                                                  swapchainTimings.acquireLatency.end());
+                            waitLatency.insert(waitLatency.end(), swapchainTimings.waitLatency.begin(), swapchainTimings.waitLatency.end());
+                            releaseLatency.insert(releaseLatency.end(), swapchainTimings.releaseLatency.begin(),
+                                                  swapchainTimings.releaseLatency.end());
                         }
 
-                        ReportF("    %d cases tested (%d unsupported)", swapchainCreateCount, unsupportedCount);
+                        // The wall time includes the warmup cycles, so count their calls as well.
+                        const double callCount = 3.0 * swapchainCount * (swapchainWarmupCycleCount + swapchainMeasuredCycleCount);
+                        ReportF("Swapchain image cycle: %s, arraySize %u, %u swapchain(s)%s: %.0f calls/s", tp.imageFormatName.c_str(),
+                                arraySize, swapchainCount, graphicsMutex ? " (queue access serialized)" : "", callCount / seconds);
+                        ReportLatencyPercentiles("  xrAcquireSwapchainImage :", acquireLatency);
+                        ReportLatencyPercentiles("  xrWaitSwapchainImage    :", waitLatency);
+                        ReportLatencyPercentiles("  xrReleaseSwapchainImage :", releaseLatency);
+                    }
+                    else {
+                        // Not every format supports every array size, and runtimes may limit the number of swapchains.
+                        REQUIRE_THAT(createResult, In<XrResult>({XR_ERROR_FEATURE_UNSUPPORTED, XR_ERROR_LIMIT_REACHED}));
+                        ReportF("Swapchain image cycle: %s, arraySize %u, %u swapchain(s): skipped (%s)", tp.imageFormatName.c_str(),
+                                arraySize, swapchainCount, ResultToString(createResult));
+                    }
+
+                    for (XrSwapchain swapchain : swapchains) {
+                        FAST_REQUIRE_RESULT_SUCCEEDED(xrDestroySwapchain(swapchain));
+                    }
+                    globalData.graphicsPlugin->Flush();
+                }
+            }
+        }
+    }
+
+    namespace
+    {
+        constexpr int swapchainChurnCycleCount = 4000;
+        constexpr int swapchainChurnWarmupCycleCount = 200;  // Lets allocator pools and caches fill before memory is sampled.
+        constexpr int swapchainChurnSampleInterval = 100;
+        constexpr uint32_t swapchainChurnSizes[] = {64, 256, 1024};
+
+        // Least-squares slope of y over x.
+        double LeastSquaresSlope(const std::vector<double>& x, const std::vector<double>& y)
+        {
+            const size_t count = x.size();
+            if (count < 2) {
+                return 0;
+            }
+            double meanX = 0;
+            double meanY = 0;
+            for (size_t i = 0; i < count; ++i) {
+                meanX += x[i] / count;
+                meanY += y[i] / count;
+            }
+            double covariance = 0;
+            double variance = 0;
+            for (size_t i = 0; i < count; ++i) {
+                covariance += (x[i] - meanX) * (y[i] - meanY);
+                variance += (x[i] - meanX) * (x[i] - meanX);
+            }
+            return variance > 0 ? covariance / variance : 0;
+        }
+
+        // Memory samples taken every swapchainChurnSampleInterval cycles, reported as growth and as bytes per cycle.
+        struct ChurnMemorySamples
+        {
+            std::vector<double> cycles;
+            std::vector<double> bytes;
+
+            void Report(const char* label) const
+            {
+                if (bytes.size() < 2) {
+                    ReportF("%s not reported", label);
+                    return;
+                }
+                ReportF("%s %+.2f MiB from cycle %d to %d, slope %+.1f bytes/cycle", label, (bytes.back() - bytes.front()) / (1024 * 1024),
+                        (int)cycles.front(), (int)cycles.back(), LeastSquaresSlope(cycles, bytes));
+            }
+        };
+    }  // namespace
+
+    // Creates and destroys swapchains of every supported format, several sizes and array sizes thousands of times, to
+    // measure create and destroy latency and to show memory the runtime fails to release. Resident memory of the
+    // process and, where the graphics plugin can report it, GPU memory are sampled along the way; a slope that stays
+    // well above zero points at a leak.
+    TEST_CASE("Swapchain Churn Benchmark", "[.][benchmark]")
+    {
+        GlobalData& globalData = GetGlobalData();
+        if (!globalData.IsUsingGraphicsPlugin()) {
+            // Nothing to measure - no graphics plugin means no swapchain
+            return;
+        }
+        auto graphicsPlugin = globalData.GetGraphicsPlugin();
+
+        AutoBasicSession session(AutoBasicSession::OptionFlags::beginSession);
+
+        uint32_t formatCount = 0;
+        REQUIRE_RESULT_UNQUALIFIED_SUCCESS(xrEnumerateSwapchainFormats(session, 0, &formatCount, nullptr));
+        std::vector<int64_t> imageFormatArray(formatCount);
+        REQUIRE_RESULT_UNQUALIFIED_SUCCESS(xrEnumerateSwapchainFormats(session, formatCount, &formatCount, imageFormatArray.data()));
+
+        // Every format at every size, with no array and with the largest array size tested for the format. Combinations the
+        // runtime rejects are dropped up front, so that every churn cycle is expected to succeed.
+        std::vector<XrSwapchainCreateInfo> createInfos;
+        for (int64_t imageFormat : imageFormatArray) {
+            SwapchainCreateTestParameters tp;
+            REQUIRE(graphicsPlugin->GetSwapchainCreateTestParameters(session.instance, session, session.systemId, imageFormat, &tp));
+
+            std::vector<uint32_t> arraySizes{1};
+            const uint32_t maxArraySize = *std::max_element(tp.arrayCountVector.begin(), tp.arrayCountVector.end());
+            if (maxArraySize > 1) {
+                arraySizes.push_back(maxArraySize);
+            }
+
+            for (uint32_t size : swapchainChurnSizes) {
+                for (uint32_t arraySize : arraySizes) {
+                    XrSwapchainCreateInfo createInfo{XR_TYPE_SWAPCHAIN_CREATE_INFO};
+                    createInfo.faceCount = 1;
+                    createInfo.format = imageFormat;
+                    createInfo.usageFlags = (XrSwapchainUsageFlags)tp.usageFlagsVector[0];
+                    createInfo.sampleCount = 1;
+                    createInfo.width = size;
+                    createInfo.height = size;
+                    createInfo.arraySize = arraySize;
+                    createInfo.mipCount = 1;
+
+                    XrSwapchain swapchain;
+                    const XrResult result = xrCreateSwapchain(session, &createInfo, &swapchain);
+                    if (XR_SUCCEEDED(result)) {
+                        REQUIRE_RESULT_SUCCEEDED(xrDestroySwapchain(swapchain));
+                        createInfos.push_back(createInfo);
+                    }
+                    else {
+                        INFO(tp.imageFormatName << " " << size << "x" << size << " arraySize " << arraySize);
+                        REQUIRE_THAT(result, In<XrResult>({XR_ERROR_FEATURE_UNSUPPORTED, XR_ERROR_LIMIT_REACHED}));
                     }
                 }
             }
         }
+        REQUIRE_FALSE(createInfos.empty());
+
+        std::vector<int64_t> createLatency;
+        std::vector<int64_t> destroyLatency;
+        createLatency.reserve(swapchainChurnCycleCount);
+        destroyLatency.reserve(swapchainChurnCycleCount);
+        ChurnMemorySamples residentSamples;
+        ChurnMemorySamples gpuSamples;
+
+        using clock = MonotonicClock;
+        auto nanoseconds = [](clock::duration duration) {
+            return (int64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+        };
+
+        for (int cycle = 0; cycle < swapchainChurnWarmupCycleCount + swapchainChurnCycleCount; ++cycle) {
+            const XrSwapchainCreateInfo& createInfo = createInfos[cycle % createInfos.size()];
+
+            XrSwapchain swapchain;
+            const clock::time_point createStart = clock::now();
+            FAST_REQUIRE_RESULT_UNQUALIFIED_SUCCESS(xrCreateSwapchain(session, &createInfo, &swapchain));
+            const clock::time_point createEnd = clock::now();
+
+            // Runtimes may allocate the images lazily, so make them ask for them.
+            uint32_t imageCount = 0;
+            FAST_REQUIRE_RESULT_UNQUALIFIED_SUCCESS(xrEnumerateSwapchainImages(swapchain, 0, &imageCount, nullptr));
+
+            const clock::time_point destroyStart = clock::now();
+            FAST_REQUIRE_RESULT_UNQUALIFIED_SUCCESS(xrDestroySwapchain(swapchain));
+            const clock::time_point destroyEnd = clock::now();
+
+            if (cycle < swapchainChurnWarmupCycleCount) {
+                continue;
+            }
+            createLatency.push_back(nanoseconds(createEnd - createStart));
+            destroyLatency.push_back(nanoseconds(destroyEnd - destroyStart));
+
+            const int measuredCycle = cycle - swapchainChurnWarmupCycleCount;
+            if (measuredCycle % swapchainChurnSampleInterval == 0 || measuredCycle + 1 == swapchainChurnCycleCount) {
+                // Let the device retire destroyed resources before sampling.
+                graphicsPlugin->Flush();
+
+                const uint64_t residentBytes = GetResidentBytes();
+                if (residentBytes != 0) {
+                    residentSamples.cycles.push_back(measuredCycle);
+                    residentSamples.bytes.push_back((double)residentBytes);
+                }
+                uint64_t gpuBytes = 0;
+                if (graphicsPlugin->GetGpuMemoryUsage(&gpuBytes)) {
+                    gpuSamples.cycles.push_back(measuredCycle);
+                    gpuSamples.bytes.push_back((double)gpuBytes);
+                }
+            }
+        }
+
+        ReportF("Swapchain churn: %d create/destroy cycles over %u format, size and array size combinations", swapchainChurnCycleCount,
+                (uint32_t)createInfos.size());
+        ReportLatencyPercentiles("  xrCreateSwapchain  :", createLatency);
+        ReportLatencyPercentiles("  xrDestroySwapchain :", destroyLatency);
+        residentSamples.Report("  Resident memory    :");
+        gpuSamples.Report("  GPU memory         :");
     }
 }  // namespace Conformance
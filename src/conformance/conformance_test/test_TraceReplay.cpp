@@ -0,0 +1,339 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+#include "call_trace.h"
+#include "utils.h"
+#include "conformance_utils.h"
+#include "conformance_framework.h"
+#include "report.h"
+#include <openxr/openxr.h>
+#include <catch2/catch.hpp>
+
+namespace Conformance
+{
+    namespace
+    {
+        // The traced calls that can be replayed. Their parameters are not in the trace, so each is replayed against the
+        // test's own session, spaces, swapchain and actions: the replay reproduces the order, mix and timing of the
+        // application's calls rather than their exact arguments.
+        enum class ReplayOp
+        {
+            PollEvent,
+            WaitFrame,
+            BeginFrame,
+            EndFrame,
+            LocateViews,
+            LocateSpace,
+            SyncActions,
+            GetActionStateBoolean,
+            GetActionStateFloat,
+            GetActionStateVector2f,
+            GetActionStatePose,
+            AcquireSwapchainImage,
+            WaitSwapchainImage,
+            ReleaseSwapchainImage,
+            Count,
+            NotReplayed = Count,
+        };
+
+        constexpr const char* ReplayOpNames[] = {
+            "xrPollEvent",           "xrWaitFrame",
+            "xrBeginFrame",          "xrEndFrame",
+            "xrLocateViews",         "xrLocateSpace",
+            "xrSyncActions",         "xrGetActionStateBoolean",
+            "xrGetActionStateFloat", "xrGetActionStateVector2f",
+            "xrGetActionStatePose",  "xrAcquireSwapchainImage",
+            "xrWaitSwapchainImage",  "xrReleaseSwapchainImage",
+        };
+        static_assert(sizeof(ReplayOpNames) / sizeof(ReplayOpNames[0]) == (size_t)ReplayOp::Count, "ReplayOpNames is out of date");
+
+        ReplayOp ReplayOpFromName(const std::string& name)
+        {
+            for (size_t i = 0; i < (size_t)ReplayOp::Count; ++i) {
+                if (name == ReplayOpNames[i]) {
+                    return (ReplayOp)i;
+                }
+            }
+            return ReplayOp::NotReplayed;
+        }
+
+        // One action of each input type, attached to the session so that the action calls have something to work on.
+        struct ReplayActions
+        {
+            XrActionSet actionSet{XR_NULL_HANDLE};
+            std::array<XrAction, 4> actions{};  // boolean, float, vector2f, pose
+            XrSpace poseSpace{XR_NULL_HANDLE};
+
+            ReplayActions(XrInstance instance, XrSession session)
+            {
+                XrActionSetCreateInfo actionSetCreateInfo{XR_TYPE_ACTION_SET_CREATE_INFO};
+                strcpy(actionSetCreateInfo.actionSetName, "trace_replay");
+                strcpy(actionSetCreateInfo.localizedActionSetName, "Trace Replay");
+                XRC_CHECK_THROW_XRCMD(xrCreateActionSet(instance, &actionSetCreateInfo, &actionSet));
+
+                const XrActionType types[] = {XR_ACTION_TYPE_BOOLEAN_INPUT, XR_ACTION_TYPE_FLOAT_INPUT, XR_ACTION_TYPE_VECTOR2F_INPUT,
+                                              XR_ACTION_TYPE_POSE_INPUT};
+                for (size_t i = 0; i < actions.size(); ++i) {
+                    XrActionCreateInfo actionCreateInfo{XR_TYPE_ACTION_CREATE_INFO};
+                    actionCreateInfo.actionType = types[i];
+                    snprintf(actionCreateInfo.actionName, sizeof(actionCreateInfo.actionName), "replay_action_%zu", i);
+                    snprintf(actionCreateInfo.localizedActionName, sizeof(actionCreateInfo.localizedActionName), "Replay Action %zu", i);
+                    XRC_CHECK_THROW_XRCMD(xrCreateAction(actionSet, &actionCreateInfo, &actions[i]));
+                }
+
+                XrActionSpaceCreateInfo spaceCreateInfo{XR_TYPE_ACTION_SPACE_CREATE_INFO};
+                spaceCreateInfo.action = actions[3];
+                spaceCreateInfo.poseInActionSpace = XrPosefCPP();
+                XRC_CHECK_THROW_XRCMD(xrCreateActionSpace(session, &spaceCreateInfo, &poseSpace));
+
+                XrSessionActionSetsAttachInfo attachInfo{XR_TYPE_SESSION_ACTION_SETS_ATTACH_INFO};
+                attachInfo.countActionSets = 1;
+                attachInfo.actionSets = &actionSet;
+                XRC_CHECK_THROW_XRCMD(xrAttachSessionActionSets(session, &attachInfo));
+            }
+
+            ~ReplayActions()
+            {
+                xrDestroySpace(poseSpace);
+                xrDestroyActionSet(actionSet);
+            }
+        };
+
+        // Tracks which frame and swapchain calls are legal next, so that calls the trace caught mid-sequence (the
+        // ring starts wherever it wrapped) or that interleave differently in this session are skipped, not failed.
+        struct ReplayState
+        {
+            bool frameWaited{false};
+            bool frameBegun{false};
+            bool imageAcquired{false};
+            bool imageWaited{false};
+            XrFrameState frameState{XR_TYPE_FRAME_STATE};
+        };
+    }  // namespace
+
+    // Replays the call stream captured by the conformance layer's call trace (run an application with the layer and
+    // XR_CONFORMANCE_LAYER_TRACE set) against the runtime under test, and reports the latency of every replayed call
+    // next to the latency the trace recorded. With --replayOriginalTiming the calls are issued at their traced times;
+    // otherwise they are issued as fast as the runtime allows. Select the trace with --replayTrace.
+    TEST_CASE("Trace Replay Benchmark", "[.][benchmark]")
+    {
+        GlobalData& globalData = GetGlobalData();
+        const Options& options = globalData.GetOptions();
+        if (options.replayTraceFile.empty() || !globalData.IsUsingGraphicsPlugin()) {
+            // Nothing to replay - the trace is only given when this benchmark is wanted
+            return;
+        }
+
+        CallTrace trace;
+        std::string error;
+        REQUIRE_MSG(ReadCallTrace(options.replayTraceFile, trace, error), error);
+        REQUIRE_MSG(!trace.records.empty(), "The call trace holds no calls");
+
+        std::vector<ReplayOp> opOfFunction;
+        for (const std::string& name : trace.functionNames) {
+            opOfFunction.push_back(ReplayOpFromName(name));
+        }
+
+        AutoBasicSession session(AutoBasicSession::beginSession | AutoBasicSession::createSwapchains | AutoBasicSession::createSpaces);
+        ReplayActions replayActions(session.GetInstance(), session);
+
+        FrameIterator frameIterator(&session);
+        REQUIRE(FrameIterator::RunResult::Success == frameIterator.RunToSessionState(XR_SESSION_STATE_FOCUSED, 15_sec));
+
+        const XrSpace baseSpace = session.spaceVector[0];
+        const XrSwapchain swapchain = session.swapchainVector.empty() ? XR_NULL_HANDLE : session.swapchainVector[0];
+        std::vector<XrView> views(session.viewConfigurationViewVector.size(), {XR_TYPE_VIEW});
+
+        std::array<std::vector<int64_t>, (size_t)ReplayOp::Count> replayedLatency, tracedLatency;
+        std::vector<uint64_t> notReplayedCounts(trace.functionNames.size(), 0);
+        uint64_t outOfSequenceCount = 0;
+        ReplayState state;
+
+        const int64_t traceStartNs = trace.records.front().startNs;
+        const auto replayStart = MonotonicClock::now();
+        for (const CallTraceRecord& record : trace.records) {
+            const ReplayOp op = record.functionId < opOfFunction.size() ? opOfFunction[record.functionId] : ReplayOp::NotReplayed;
+            if (op == ReplayOp::NotReplayed) {
+                if (record.functionId < notReplayedCounts.size()) {
+                    notReplayedCounts[record.functionId]++;
+                }
+                continue;
+            }
+
+            if (options.replayOriginalTiming) {
+                std::this_thread::sleep_until(replayStart + std::chrono::nanoseconds(record.startNs - traceStartNs));
+            }
+
+            const XrTime displayTime = state.frameState.predictedDisplayTime;
+            bool replayed = true;
+            const auto callStart = MonotonicClock::now();
+            switch (op) {
+            case ReplayOp::PollEvent:
+                REQUIRE(FrameIterator::TickResult::Error != frameIterator.PollEvent());
+                break;
+            case ReplayOp::WaitFrame:
+                // A second xrWaitFrame before xrBeginFrame would block this thread forever.
+                if ((replayed = !state.frameWaited)) {
+                    FAST_REQUIRE_RESULT_SUCCEEDED(xrWaitFrame(session, nullptr, &state.frameState));
+                    state.frameWaited = true;
+                }
+                break;
+            case ReplayOp::BeginFrame:
+                if ((replayed = state.frameWaited)) {
+                    FAST_REQUIRE_RESULT_SUCCEEDED(xrBeginFrame(session, nullptr));
+                    state.frameWaited = false;
+                    state.frameBegun = true;
+                }
+                break;
+            case ReplayOp::EndFrame:
+                if ((replayed = state.frameBegun)) {
+                    XrFrameEndInfo frameEndInfo{XR_TYPE_FRAME_END_INFO};
+                    frameEndInfo.displayTime = displayTime;
+                    frameEndInfo.environmentBlendMode = session.environmentBlendModeVector[0];
+                    FAST_REQUIRE_RESULT_SUCCEEDED(xrEndFrame(session, &frameEndInfo));
+                    state.frameBegun = false;
+                }
+                break;
+            case ReplayOp::LocateViews:
+                if ((replayed = displayTime != 0)) {
+                    XrViewLocateInfo locateInfo{XR_TYPE_VIEW_LOCATE_INFO};
+                    locateInfo.viewConfigurationType = session.viewConfigurationTypeVector[0];
+                    locateInfo.displayTime = displayTime;
+                    locateInfo.space = baseSpace;
+                    XrViewState viewState{XR_TYPE_VIEW_STATE};
+                    uint32_t viewCount = (uint32_t)views.size();
+                    FAST_REQUIRE_RESULT_SUCCEEDED(xrLocateViews(session, &locateInfo, &viewState, viewCount, &viewCount, views.data()));
+                }
+                break;
+            case ReplayOp::LocateSpace:
+                if ((replayed = displayTime != 0)) {
+                    XrSpaceLocation location{XR_TYPE_SPACE_LOCATION};
+                    FAST_REQUIRE_RESULT_SUCCEEDED(xrLocateSpace(replayActions.poseSpace, baseSpace, displayTime, &location));
+                }
+                break;
+            case ReplayOp::SyncActions: {
+                const XrActiveActionSet activeActionSet{replayActions.actionSet, XR_NULL_PATH};
+                XrActionsSyncInfo syncInfo{XR_TYPE_ACTIONS_SYNC_INFO};
+                syncInfo.countActiveActionSets = 1;
+                syncInfo.activeActionSets = &activeActionSet;
+                FAST_REQUIRE_RESULT_SUCCEEDED(xrSyncActions(session, &syncInfo));
+                break;
+            }
+            case ReplayOp::GetActionStateBoolean: {
+                XrActionStateGetInfo getInfo{XR_TYPE_ACTION_STATE_GET_INFO, nullptr, replayActions.actions[0], XR_NULL_PATH};
+                XrActionStateBoolean actionState{XR_TYPE_ACTION_STATE_BOOLEAN};
+                FAST_REQUIRE_RESULT_SUCCEEDED(xrGetActionStateBoolean(session, &getInfo, &actionState));
+                break;
+            }
+            case ReplayOp::GetActionStateFloat: {
+                XrActionStateGetInfo getInfo{XR_TYPE_ACTION_STATE_GET_INFO, nullptr, replayActions.actions[1], XR_NULL_PATH};
+                XrActionStateFloat actionState{XR_TYPE_ACTION_STATE_FLOAT};
+                FAST_REQUIRE_RESULT_SUCCEEDED(xrGetActionStateFloat(session, &getInfo, &actionState));
+                break;
+            }
+            case ReplayOp::GetActionStateVector2f: {
+                XrActionStateGetInfo getInfo{XR_TYPE_ACTION_STATE_GET_INFO, nullptr, replayActions.actions[2], XR_NULL_PATH};
+                XrActionStateVector2f actionState{XR_TYPE_ACTION_STATE_VECTOR2F};
+                FAST_REQUIRE_RESULT_SUCCEEDED(xrGetActionStateVector2f(session, &getInfo, &actionState));
+                break;
+            }
+            case ReplayOp::GetActionStatePose: {
+                XrActionStateGetInfo getInfo{XR_TYPE_ACTION_STATE_GET_INFO, nullptr, replayActions.actions[3], XR_NULL_PATH};
+                XrActionStatePose actionState{XR_TYPE_ACTION_STATE_POSE};
+                FAST_REQUIRE_RESULT_SUCCEEDED(xrGetActionStatePose(session, &getInfo, &actionState));
+                break;
+            }
+            case ReplayOp::AcquireSwapchainImage:
+                if ((replayed = swapchain != XR_NULL_HANDLE && !state.imageAcquired)) {
+                    uint32_t index;
+                    FAST_REQUIRE_RESULT_SUCCEEDED(xrAcquireSwapchainImage(swapchain, nullptr, &index));
+                    state.imageAcquired = true;
+                }
+                break;
+            case ReplayOp::WaitSwapchainImage:
+                if ((replayed = state.imageAcquired && !state.imageWaited)) {
+                    XrSwapchainImageWaitInfo waitInfo{XR_TYPE_SWAPCHAIN_IMAGE_WAIT_INFO, nullptr, XR_INFINITE_DURATION};
+                    FAST_REQUIRE_RESULT_SUCCEEDED(xrWaitSwapchainImage(swapchain, &waitInfo));
+                    state.imageWaited = true;
+                }
+                break;
+            case ReplayOp::ReleaseSwapchainImage:
+                if ((replayed = state.imageWaited)) {
+                    FAST_REQUIRE_RESULT_SUCCEEDED(xrReleaseSwapchainImage(swapchain, nullptr));
+                    state.imageAcquired = false;
+                    state.imageWaited = false;
+                }
+                break;
+            default:
+                replayed = false;
+                break;
+            }
+            const int64_t elapsedNs =
+                std::chrono::duration_cast<std::chrono::nanoseconds>(MonotonicClock::now() - callStart).count();
+
+            if (!replayed) {
+                outOfSequenceCount++;
+                continue;
+            }
+            replayedLatency[(size_t)op].push_back(elapsedNs);
+            tracedLatency[(size_t)op].push_back(record.durationNs);
+
+            const XrSessionState sessionState = frameIterator.GetCurrentSessionState();
+            if (sessionState == XR_SESSION_STATE_STOPPING || sessionState == XR_SESSION_STATE_LOSS_PENDING ||
+                sessionState == XR_SESSION_STATE_EXITING) {
+                WARN("Session left the running states during the replay; stopping early");
+                break;
+            }
+        }
+
+        // Leave the session with no frame or image outstanding.
+        if (state.imageWaited) {
+            XRC_CHECK_THROW_XRCMD(xrReleaseSwapchainImage(swapchain, nullptr));
+        }
+        if (state.frameBegun) {
+            XrFrameEndInfo frameEndInfo{XR_TYPE_FRAME_END_INFO};
+            frameEndInfo.displayTime = state.frameState.predictedDisplayTime;
+            frameEndInfo.environmentBlendMode = session.environmentBlendModeVector[0];
+            XRC_CHECK_THROW_XRCMD(xrEndFrame(session, &frameEndInfo));
+        }
+
+        ReportF("Trace Replay: %zu traced calls on %u threads (%llu older calls overwritten), replayed with %s timing",
+                trace.records.size(), trace.threadCount, (unsigned long long)trace.overwrittenCount,
+                options.replayOriginalTiming ? "original" : "as fast as possible");
+        for (size_t i = 0; i < (size_t)ReplayOp::Count; ++i) {
+            if (replayedLatency[i].empty()) {
+                continue;
+            }
+            ReportLatencyPercentiles((std::string("  replayed ") + ReplayOpNames[i]).c_str(), replayedLatency[i]);
+            ReportLatencyPercentiles((std::string("  traced   ") + ReplayOpNames[i]).c_str(), tracedLatency[i]);
+        }
+        if (outOfSequenceCount > 0) {
+            ReportF("  %llu calls skipped because they were out of sequence for the replay session",
+                    (unsigned long long)outOfSequenceCount);
+        }
+        for (size_t i = 0; i < notReplayedCounts.size(); ++i) {
+            if (notReplayedCounts[i] > 0) {
+                ReportF("  not replayed: %s x%llu", trace.functionNames[i].c_str(), (unsigned long long)notReplayedCounts[i]);
+            }
+        }
+    }
+}  // namespace Conformance
@@ -37,7 +37,7 @@ namespace Conformance
         // XrSystemId systemId, XrViewConfigurationType viewConfigurationType, uint32_t viewCapacityInput, uint32_t* viewCountOutput,
         // XrViewConfigurationView* views);
 
-        AutoBasicInstance instance(AutoBasicInstance::createSystemId);
+        AutoBasicInstance instance(AutoBasicInstance::createSystemId | AutoBasicInstance::allowPooled);
 
         uint32_t countOutput = 0;
         std::vector<XrViewConfigurationType> vctArray;
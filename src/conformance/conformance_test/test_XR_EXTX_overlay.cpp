@@ -0,0 +1,242 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "utils.h"
+#include "conformance_utils.h"
+#include "conformance_framework.h"
+#include "composition_utils.h"
+#include "frame_pacing.h"
+#include "report.h"
+#include <openxr/openxr.h>
+#include <catch2/catch.hpp>
+
+namespace Conformance
+{
+    namespace
+    {
+        constexpr int overlayWarmupFrameCount = 60;     // After each overlay session is added.
+        constexpr int overlayMeasuredFrameCount = 600;  // Per overlay count.
+        constexpr uint32_t overlayMaxCount = 4;         // Fewer if the runtime does not allow this many sessions.
+
+        // Serializes the frame loops of the main and overlay sessions around the calls that may use the graphics device or
+        // queue: the graphics plugin is not thread-safe, the runtime may submit to the application's queue in xrEndFrame,
+        // and an OpenGL context is current on one thread at a time. xrWaitFrame and xrBeginFrame stay outside it.
+        // Lives on the thread that initialized the graphics device, which only uses it through Run while this is alive.
+        class GraphicsLock
+        {
+        public:
+            GraphicsLock()
+            {
+                GetGlobalData().GetGraphicsPlugin()->MakeCurrent(false);
+            }
+
+            ~GraphicsLock()
+            {
+                GetGlobalData().GetGraphicsPlugin()->MakeCurrent(true);
+            }
+
+            GraphicsLock(const GraphicsLock&) = delete;
+            GraphicsLock& operator=(const GraphicsLock&) = delete;
+
+            template <typename F>
+            void Run(F&& f)
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                const std::shared_ptr<IGraphicsPlugin> graphicsPlugin = GetGlobalData().GetGraphicsPlugin();
+                graphicsPlugin->MakeCurrent(true);
+                struct Unbind
+                {
+                    IGraphicsPlugin& plugin;
+                    ~Unbind()
+                    {
+                        plugin.MakeCurrent(false);
+                    }
+                } unbind{*graphicsPlugin};
+                f();
+            }
+
+        private:
+            std::mutex m_mutex;
+        };
+
+        // An XR_EXTX_overlay session whose frame loop runs on its own thread from construction until Stop, submitting only
+        // the overlay's name quad, as a system overlay next to the application would. Catch is not thread-safe, so the
+        // thread keeps its failure for the main thread to check instead of asserting. Construct and destroy it inside
+        // GraphicsLock::Run, since that creates and destroys swapchains, but call Stop outside it.
+        class OverlaySessionLoop
+        {
+        public:
+            OverlaySessionLoop(CompositionHelper& mainHelper, GraphicsLock& graphicsLock, uint32_t sessionLayersPlacement)
+                : m_helper(mainHelper, ("Overlay " + std::to_string(sessionLayersPlacement)).c_str(), sessionLayersPlacement)
+            {
+                m_helper.BeginSession();
+                m_thread = std::thread([this, &graphicsLock] {
+                    ATTACH_THREAD;
+                    RenderLoop renderLoop(m_helper, [&](const XrFrameState& frameState) {
+                        graphicsLock.Run([&] { m_helper.EndFrame(frameState.predictedDisplayTime, nullptr, 0); });
+                        return !m_stop.load();
+                    });
+                    try {
+                        while (renderLoop.IterateFrame()) {
+                        }
+                    }
+                    catch (const std::exception& ex) {
+                        m_error = ex.what();
+                        m_failed.store(true);
+                    }
+                });
+            }
+
+            ~OverlaySessionLoop()
+            {
+                Stop();
+            }
+
+            void Stop()
+            {
+                m_stop.store(true);
+                if (m_thread.joinable()) {
+                    m_thread.join();
+                }
+            }
+
+            OverlaySessionLoop(const OverlaySessionLoop&) = delete;
+            OverlaySessionLoop& operator=(const OverlaySessionLoop&) = delete;
+
+            // Only read m_error once this returns true.
+            bool Failed() const
+            {
+                return m_failed.load();
+            }
+            const std::string& Error() const
+            {
+                return m_error;
+            }
+
+        private:
+            CompositionHelper m_helper;
+            std::atomic<bool> m_stop{false};
+            std::atomic<bool> m_failed{false};
+            std::string m_error;
+            std::thread m_thread;
+        };
+    }  // namespace
+
+    // Measures how frame pacing and xrEndFrame CPU time of an application degrade as XR_EXTX_overlay sessions are added
+    // next to it, one at a time up to overlayMaxCount or as many as the runtime allows the instance. Each overlay runs
+    // its own RenderLoop on its own thread, submitting a quad every frame, while the main session renders a projection
+    // layer. Calls that use the graphics device are serialized, see GraphicsLock, so the overlays contend in the
+    // runtime and compositor rather than in the graphics plugin.
+    TEST_CASE("Overlay Session Benchmark", "[.][benchmark][XR_EXTX_overlay]")
+    {
+        GlobalData& globalData = GetGlobalData();
+        if (!globalData.IsUsingGraphicsPlugin()) {
+            // Nothing to measure - no graphics plugin means no frame submission
+            return;
+        }
+        if (!globalData.IsInstanceExtensionSupported(XR_EXTX_OVERLAY_EXTENSION_NAME)) {
+            WARN(XR_EXTX_OVERLAY_EXTENSION_NAME " not supported; skipping");
+            return;
+        }
+
+        CompositionHelper compositionHelper("Overlay Session Benchmark", {XR_EXTX_OVERLAY_EXTENSION_NAME});
+        compositionHelper.GetInteractionManager().AttachActionSets();
+        compositionHelper.BeginSession();
+
+        SimpleProjectionLayerHelper simpleProjectionLayerHelper(compositionHelper);
+
+        // Both are destroyed before the main helper, whose instance and graphics device the overlays share.
+        GraphicsLock graphicsLock;
+        std::vector<std::unique_ptr<OverlaySessionLoop>> overlays;
+        struct StopOverlays
+        {
+            GraphicsLock& graphicsLock;
+            std::vector<std::unique_ptr<OverlaySessionLoop>>& overlays;
+            ~StopOverlays()
+            {
+                for (const auto& overlay : overlays) {
+                    overlay->Stop();
+                }
+                graphicsLock.Run([&] { overlays.clear(); });
+            }
+        } stopOverlays{graphicsLock, overlays};
+
+        for (uint32_t overlayCount = 0; overlayCount <= overlayMaxCount; ++overlayCount) {
+            if (overlayCount > 0) {
+                std::string error;
+                graphicsLock.Run([&] {
+                    try {
+                        overlays.emplace_back(new OverlaySessionLoop(compositionHelper, graphicsLock, overlayCount));
+                    }
+                    catch (const std::exception& ex) {
+                        error = ex.what();
+                    }
+                });
+                if (!error.empty()) {
+                    ReportF("Could not create overlay session %u, stopping: %s", overlayCount, error.c_str());
+                    break;
+                }
+            }
+
+            FramePacingRecorder recorder;
+            std::vector<int64_t> endFrameLatency;
+            endFrameLatency.reserve(overlayMeasuredFrameCount);
+            Stopwatch endFrameStopwatch;
+
+            int frame = 0;
+            RenderLoop renderLoop(compositionHelper, [&](const XrFrameState& frameState) {
+                const bool measured = frame >= overlayWarmupFrameCount;
+                if (measured) {
+                    recorder.OnFrameWoken(frameState);
+                }
+
+                compositionHelper.PollEvents();
+
+                graphicsLock.Run([&] {
+                    XrCompositionLayerBaseHeader* const projLayer = simpleProjectionLayerHelper.TryGetUpdatedProjectionLayer(frameState);
+                    endFrameStopwatch.Restart();
+                    compositionHelper.EndFrame(frameState.predictedDisplayTime, &projLayer, projLayer != nullptr ? 1 : 0);
+                    if (measured) {
+                        endFrameLatency.push_back(endFrameStopwatch.Elapsed().count());
+                    }
+                });
+
+                if (measured) {
+                    recorder.OnFrameEnded();
+                }
+                return ++frame < overlayWarmupFrameCount + overlayMeasuredFrameCount;
+            });
+            renderLoop.Loop();
+
+            for (const auto& overlay : overlays) {
+                if (overlay->Failed()) {
+                    FAIL("Overlay session frame loop failed: " << overlay->Error());
+                }
+            }
+
+            const std::string loopName = std::to_string(overlayCount) + " overlay sessions";
+            recorder.Report(loopName.c_str());
+            ReportLatencyPercentiles("  xrEndFrame CPU time              :", endFrameLatency);
+        }
+    }
+}  // namespace Conformance
@@ -17,6 +17,10 @@
 #include "utils.h"
 #include "conformance_utils.h"
 #include "composition_utils.h"
+#include "report.h"
+#include <atomic>
+#include <chrono>
+#include <vector>
 #include <catch2/catch.hpp>
 #include <openxr/openxr.h>
 #include <xr_linear.h>
@@ -104,7 +108,7 @@ namespace Conformance
     TEST_CASE("XR_EXT_hand_tracking_interactive", "[scenario][interactive]")
     {
         const char* instructions =
-            "Small cubes are rendered to represent the joints of each hand. "
+            "Each hand is rendered as a skinned mesh, or as small cubes at its joints if the graphics plugin cannot skin it. "
             "Bring index finger of both hands together to complete the validation.";
 
         GlobalData& globalData = GetGlobalData();
@@ -165,6 +169,9 @@ namespace Conformance
                                               localSpace, 1.0f, {{0, 0, 0, 1}, {-1.5f, 0, -0.3f}});
         XrQuaternionf_CreateFromAxisAngle(&instructionsQuad->pose.orientation, &Up, 70 * MATH_PI / 180);
 
+        // Cleared once the plugin declines to skin the hands, so that it renders the cubes as it best can from then on.
+        bool skinningSupported = true;
+
         auto update = [&](const XrFrameState& frameState) {
             std::vector<Cube> renderedCubes;
 
@@ -199,8 +206,19 @@ namespace Conformance
                 }
             }
 
-            // Locate and add to list of cubes to render.
+            // Skin a mesh to each hand whose joints are all located, and add cubes at the joints for the plugins that cannot
+            // and for the hands that are not. unskinnedCubes leaves out the skinned hands.
+            std::vector<SkinnedHand> skinnedHands;
+            std::vector<Cube> unskinnedCubes;
             for (auto hand : {LEFT_HAND, RIGHT_HAND}) {
+                SkinnedHand skinnedHand;
+                const bool skinned = ComputeHandBonePalette(hand == LEFT_HAND ? XR_HAND_LEFT_EXT : XR_HAND_RIGHT_EXT, jointLocations[hand],
+                                                            skinnedHand);
+                if (skinned) {
+                    skinnedHands.push_back(skinnedHand);
+                }
+
+                const size_t firstJointCube = renderedCubes.size();
                 for (int i = 0; i < XR_HAND_JOINT_COUNT_EXT; i++) {
                     XrHandJointLocationEXT& jointLocation = jointLocations[hand][i];
                     if ((jointLocation.locationFlags & XR_SPACE_LOCATION_POSITION_VALID_BIT) != 0) {
@@ -213,24 +231,36 @@ namespace Conformance
                         renderedCubes.push_back(Cube::Make(jointLocation.pose.position, radius, jointLocation.pose.orientation));
                     }
                 }
+                if (!skinned) {
+                    unskinnedCubes.insert(unskinnedCubes.end(), renderedCubes.begin() + firstJointCube, renderedCubes.end());
+                }
             }
 
-            auto viewData = compositionHelper.LocateViews(localSpace, frameState.predictedDisplayTime);
-            const auto& viewState = std::get<XrViewState>(viewData);
+            const auto views = compositionHelper.LocateViews(localSpace, frameState.predictedDisplayTime);
+            const auto& viewState = views.viewState;
 
             std::vector<XrCompositionLayerBaseHeader*> layers;
             if (viewState.viewStateFlags & XR_VIEW_STATE_POSITION_VALID_BIT &&
                 viewState.viewStateFlags & XR_VIEW_STATE_ORIENTATION_VALID_BIT) {
-                const auto& views = std::get<std::vector<XrView>>(viewData);
-
                 // Render into each viewport of the wide swapchain using the projection layer view fov and pose.
                 for (size_t view = 0; view < views.size(); view++) {
                     compositionHelper.AcquireWaitReleaseImage(
                         swapchains[view], [&](const XrSwapchainImageBaseHeader* swapchainImage, uint64_t format) {
-                            GetGlobalData().graphicsPlugin->ClearImageSlice(swapchainImage, 0, format);
                             const_cast<XrFovf&>(projLayer->views[view].fov) = views[view].fov;
                             const_cast<XrPosef&>(projLayer->views[view].pose) = views[view].pose;
-                            GetGlobalData().graphicsPlugin->RenderView(projLayer->views[view], swapchainImage, format, renderedCubes);
+                            IGraphicsPlugin& graphicsPlugin = *GetGlobalData().graphicsPlugin;
+                            const XrCompositionLayerProjectionView& layerView = projLayer->views[view];
+                            if (skinnedHands.empty() || !skinningSupported) {
+                                graphicsPlugin.ClearAndRenderViews(&layerView, 1, swapchainImage, format, renderedCubes);
+                                return;
+                            }
+                            graphicsPlugin.ClearImageSlice(swapchainImage, layerView.subImage.imageArrayIndex, format);
+                            if (!graphicsPlugin.RenderViewWithSkinnedHands(layerView, swapchainImage, format, skinnedHands,
+                                                                           unskinnedCubes)) {
+                                // The plugin cannot skin them, so stop asking.
+                                skinningSupported = false;
+                                graphicsPlugin.RenderView(layerView, swapchainImage, format, renderedCubes);
+                            }
                         });
                 }
 
@@ -244,8 +274,165 @@ namespace Conformance
             return compositionHelper.PollEvents();
         };
 
-        RenderLoop(compositionHelper.GetSession(), update).Loop();
+        RenderLoop(compositionHelper, update).Loop();
+
+        for (auto hand : {LEFT_HAND, RIGHT_HAND}) {
+            REQUIRE(XR_SUCCESS == xrDestroyHandTrackerEXT(handTracker[hand]));
+        }
+    }
+
+    namespace
+    {
+        constexpr int handLocateWarmupFrameCount = 60;
+        constexpr int handLocateMeasuredFrameCount = 1000;
+
+        // Timings of the xrLocateHandJointsEXT calls made by one thread. Catch assertions are not thread-safe, so a
+        // failure is recorded and checked by the caller.
+        struct HandJointLocateTimings
+        {
+            XrResult failure{XR_SUCCESS};
+            uint64_t callCount{0};
+            uint64_t activeCount{0};
+            LatencySamples latency;
+        };
+
+        // Locates every joint of both hands, with velocities, at the given time.
+        void LocateBothHands(PFN_xrLocateHandJointsEXT xrLocateHandJointsEXT, const XrHandTrackerEXT (&handTracker)[HAND_COUNT],
+                             XrSpace baseSpace, XrTime time, HandJointLocateTimings& timings)
+        {
+            using clock = MonotonicClock;
+            for (auto hand : {LEFT_HAND, RIGHT_HAND}) {
+                XrHandJointLocationEXT jointLocations[XR_HAND_JOINT_COUNT_EXT];
+                XrHandJointVelocityEXT jointVelocities[XR_HAND_JOINT_COUNT_EXT];
+
+                XrHandJointVelocitiesEXT velocities{XR_TYPE_HAND_JOINT_VELOCITIES_EXT};
+                velocities.jointCount = XR_HAND_JOINT_COUNT_EXT;
+                velocities.jointVelocities = jointVelocities;
+
+                XrHandJointLocationsEXT locations{XR_TYPE_HAND_JOINT_LOCATIONS_EXT, &velocities};
+                locations.jointCount = XR_HAND_JOINT_COUNT_EXT;
+                locations.jointLocations = jointLocations;
+
+                XrHandJointsLocateInfoEXT locateInfo{XR_TYPE_HAND_JOINTS_LOCATE_INFO_EXT};
+                locateInfo.baseSpace = baseSpace;
+                locateInfo.time = time;
+
+                const clock::time_point start = clock::now();
+                const XrResult result = xrLocateHandJointsEXT(handTracker[hand], &locateInfo, &locations);
+                const clock::time_point stop = clock::now();
+                if (result != XR_SUCCESS) {
+                    timings.failure = result;
+                    return;
+                }
+
+                timings.callCount++;
+                if (locations.isActive) {
+                    timings.activeCount++;
+                }
+                timings.latency.Add(stop - start);
+            }
+        }
+    }  // namespace
+
+    // Measures xrLocateHandJointsEXT for all joints of both hands with velocities, once per frame at the predicted
+    // display time on the frame loop thread, and free-running on a separate tracking thread while the frame loop keeps
+    // going.
+    TEST_CASE("Hand Joint Location Benchmark", "[.][benchmark]")
+    {
+        GlobalData& globalData = GetGlobalData();
+        if (!globalData.IsInstanceExtensionSupported(XR_EXT_HAND_TRACKING_EXTENSION_NAME)) {
+            return;
+        }
+
+        // how long the test should wait for the app to get focus: 10 seconds in release, infinite in debug builds.
+        auto timeout = (globalData.options.debugMode ? 3600_sec : 10_sec);
+        CAPTURE(timeout);
+
+        AutoBasicInstance instance({XR_EXT_HAND_TRACKING_EXTENSION_NAME});
+
+        PFN_xrCreateHandTrackerEXT xrCreateHandTrackerEXT = NULL;
+        REQUIRE(XR_SUCCESS == xrGetInstanceProcAddr(instance, "xrCreateHandTrackerEXT", (PFN_xrVoidFunction*)(&xrCreateHandTrackerEXT)));
+
+        PFN_xrDestroyHandTrackerEXT xrDestroyHandTrackerEXT = NULL;
+        REQUIRE(XR_SUCCESS ==
+                xrGetInstanceProcAddr(instance, "xrDestroyHandTrackerEXT", (PFN_xrVoidFunction*)(&xrDestroyHandTrackerEXT)));
+
+        PFN_xrLocateHandJointsEXT xrLocateHandJointsEXT = NULL;
+        REQUIRE(XR_SUCCESS == xrGetInstanceProcAddr(instance, "xrLocateHandJointsEXT", (PFN_xrVoidFunction*)(&xrLocateHandJointsEXT)));
+
+        if (!SystemSupportsHandTracking(instance)) {
+            WARN("Device does not support hand tracking");
+            return;
+        }
+
+        AutoBasicSession session(AutoBasicSession::beginSession | AutoBasicSession::createSwapchains | AutoBasicSession::createSpaces,
+                                 instance);
+
+        XrHandTrackerEXT handTracker[HAND_COUNT];
+        for (auto hand : {LEFT_HAND, RIGHT_HAND}) {
+            XrHandTrackerCreateInfoEXT createInfo{XR_TYPE_HAND_TRACKER_CREATE_INFO_EXT};
+            createInfo.handJointSet = XR_HAND_JOINT_SET_DEFAULT_EXT;
+            createInfo.hand = (hand == LEFT_HAND ? XR_HAND_LEFT_EXT : XR_HAND_RIGHT_EXT);
+            REQUIRE(XR_SUCCESS == xrCreateHandTrackerEXT(session, &createInfo, &handTracker[hand]));
+        }
+
+        XrReferenceSpaceCreateInfo baseSpaceCreateInfo{XR_TYPE_REFERENCE_SPACE_CREATE_INFO};
+        baseSpaceCreateInfo.referenceSpaceType = XR_REFERENCE_SPACE_TYPE_LOCAL;
+        baseSpaceCreateInfo.poseInReferenceSpace = XrPosefCPP();
+        XrSpace baseSpace;
+        REQUIRE_RESULT_UNQUALIFIED_SUCCESS(xrCreateReferenceSpace(session, &baseSpaceCreateInfo, &baseSpace));
+
+        FrameIterator frameIterator(&session);
+        REQUIRE(FrameIterator::RunResult::Success == frameIterator.RunToSessionState(XR_SESSION_STATE_FOCUSED, timeout));
+
+        auto submitFrame = [&]() {
+            REQUIRE(FrameIterator::TickResult::Error != frameIterator.PollEvent());
+            REQUIRE(FrameIterator::RunResult::Success == frameIterator.SubmitFrame());
+            return frameIterator.frameState.predictedDisplayTime;
+        };
+
+        auto report = [](const char* label, HandJointLocateTimings& timings, double seconds) {
+            ReportF("Hand joint location, %s: %.0f calls/s, hands active in %llu of %llu calls", label, timings.callCount / seconds,
+                    (unsigned long long)timings.activeCount, (unsigned long long)timings.callCount);
+            ReportLatencyPercentiles("  xrLocateHandJointsEXT :", timings.latency.nanoseconds);
+        };
+
+        SECTION("Frame loop thread")
+        {
+            HandJointLocateTimings warmupTimings;
+            HandJointLocateTimings timings;
+            timings.latency.nanoseconds.reserve(HAND_COUNT * handLocateMeasuredFrameCount);
+            for (int frame = 0; frame < handLocateWarmupFrameCount + handLocateMeasuredFrameCount; ++frame) {
+                const XrTime displayTime = submitFrame();
+                LocateBothHands(xrLocateHandJointsEXT, handTracker, baseSpace, displayTime,
+                                frame < handLocateWarmupFrameCount ? warmupTimings : timings);
+                REQUIRE_RESULT_UNQUALIFIED_SUCCESS(warmupTimings.failure);
+                REQUIRE_RESULT_UNQUALIFIED_SUCCESS(timings.failure);
+            }
+
+            // The calls are spread over the frames, so the rate is over the time spent in them rather than the wall time.
+            report("once per frame on the frame loop thread", timings, timings.latency.TotalSeconds());
+        }
+
+        SECTION("Tracking thread")
+        {
+            // The tracking thread locates as fast as it can at the latest predicted display time, while this thread keeps
+            // submitting frames.
+            std::atomic<XrTime> latestDisplayTime{0};
+            HandJointLocateTimings timings;
+            timings.latency.nanoseconds.reserve(LatencySamples::MaxSamples);
+            const double trackingSeconds = RunFreeRunningCalls(
+                handLocateWarmupFrameCount, handLocateMeasuredFrameCount, [&]() { latestDisplayTime = submitFrame(); },
+                [&]() {
+                    LocateBothHands(xrLocateHandJointsEXT, handTracker, baseSpace, latestDisplayTime, timings);
+                    return timings.failure == XR_SUCCESS;
+                });
+
+            REQUIRE_RESULT_UNQUALIFIED_SUCCESS(timings.failure);
+            report("free-running on a tracking thread", timings, trackingSeconds);
+        }
 
+        REQUIRE_RESULT_UNQUALIFIED_SUCCESS(xrDestroySpace(baseSpace));
         for (auto hand : {LEFT_HAND, RIGHT_HAND}) {
             REQUIRE(XR_SUCCESS == xrDestroyHandTrackerEXT(handTracker[hand]));
         }
@@ -17,7 +17,14 @@
 #include "utils.h"
 #include "conformance_utils.h"
 #include "conformance_framework.h"
+#include "composition_utils.h"
+#include "event_reader.h"
+#include "report.h"
+#include <algorithm>
 #include <array>
+#include <chrono>
+#include <cmath>
+#include <numeric>
 #include <vector>
 #include <set>
 #include <string>
@@ -34,4 +41,271 @@ namespace Conformance
         //              XrPerfSettingsLevelEXT level);
     }
 
+    namespace
+    {
+        constexpr int sweepWarmupFrameCount = 120;     // After each change of level.
+        constexpr int sweepMeasuredFrameCount = 2700;  // Per level, long enough for the temperature trend to respond.
+        constexpr uint32_t sweepGpuLoadLayerCount = 16;  // Overdraw layers of the synthetic GPU load.
+        constexpr double sweepCpuLoadFraction = 0.3;     // Synthetic CPU work per frame, as a fraction of the display period.
+        constexpr std::chrono::seconds thermalSampleInterval{1};
+
+        constexpr XrPerfSettingsDomainEXT sweepDomains[] = {XR_PERF_SETTINGS_DOMAIN_CPU_EXT, XR_PERF_SETTINGS_DOMAIN_GPU_EXT};
+        constexpr XrPerfSettingsLevelEXT sweepLevels[] = {
+            XR_PERF_SETTINGS_LEVEL_POWER_SAVINGS_EXT, XR_PERF_SETTINGS_LEVEL_SUSTAINED_LOW_EXT, XR_PERF_SETTINGS_LEVEL_SUSTAINED_HIGH_EXT,
+            XR_PERF_SETTINGS_LEVEL_BOOST_EXT};
+
+        const char* DomainName(XrPerfSettingsDomainEXT domain)
+        {
+            switch (domain) {
+            case XR_PERF_SETTINGS_DOMAIN_CPU_EXT:
+                return "CPU";
+            case XR_PERF_SETTINGS_DOMAIN_GPU_EXT:
+                return "GPU";
+            default:
+                return "unknown domain";
+            }
+        }
+
+        const char* LevelName(XrPerfSettingsLevelEXT level)
+        {
+            switch (level) {
+            case XR_PERF_SETTINGS_LEVEL_POWER_SAVINGS_EXT:
+                return "power savings";
+            case XR_PERF_SETTINGS_LEVEL_SUSTAINED_LOW_EXT:
+                return "sustained low";
+            case XR_PERF_SETTINGS_LEVEL_SUSTAINED_HIGH_EXT:
+                return "sustained high";
+            case XR_PERF_SETTINGS_LEVEL_BOOST_EXT:
+                return "boost";
+            default:
+                return "unknown level";
+            }
+        }
+
+        const char* SubDomainName(XrPerfSettingsSubDomainEXT subDomain)
+        {
+            switch (subDomain) {
+            case XR_PERF_SETTINGS_SUB_DOMAIN_COMPOSITING_EXT:
+                return "compositing";
+            case XR_PERF_SETTINGS_SUB_DOMAIN_RENDERING_EXT:
+                return "rendering";
+            case XR_PERF_SETTINGS_SUB_DOMAIN_THERMAL_EXT:
+                return "thermal";
+            default:
+                return "unknown sub-domain";
+            }
+        }
+
+        const char* NotificationLevelName(XrPerfSettingsNotificationLevelEXT level)
+        {
+            switch (level) {
+            case XR_PERF_SETTINGS_NOTIF_LEVEL_NORMAL_EXT:
+                return "normal";
+            case XR_PERF_SETTINGS_NOTIF_LEVEL_WARNING_EXT:
+                return "warning";
+            case XR_PERF_SETTINGS_NOTIF_LEVEL_IMPAIRED_EXT:
+                return "impaired";
+            default:
+                return "unknown";
+            }
+        }
+
+        // The xrThermalGetTemperatureTrendEXT readings of one domain over a sweep step.
+        struct ThermalTrend
+        {
+            int sampleCount{0};
+            XrPerfSettingsNotificationLevelEXT firstLevel{XR_PERF_SETTINGS_NOTIF_LEVEL_NORMAL_EXT};
+            XrPerfSettingsNotificationLevelEXT worstLevel{XR_PERF_SETTINGS_NOTIF_LEVEL_NORMAL_EXT};
+            XrPerfSettingsNotificationLevelEXT lastLevel{XR_PERF_SETTINGS_NOTIF_LEVEL_NORMAL_EXT};
+            float firstHeadroom{0};
+            float minHeadroom{0};
+            float lastHeadroom{0};
+            double slopeSum{0};
+            float maxSlope{0};
+
+            void Add(XrPerfSettingsNotificationLevelEXT level, float headroom, float slope)
+            {
+                if (sampleCount == 0) {
+                    firstLevel = worstLevel = level;
+                    firstHeadroom = minHeadroom = headroom;
+                    maxSlope = slope;
+                }
+                worstLevel = std::max(worstLevel, level);
+                minHeadroom = std::min(minHeadroom, headroom);
+                maxSlope = std::max(maxSlope, slope);
+                lastLevel = level;
+                lastHeadroom = headroom;
+                slopeSum += slope;
+                sampleCount++;
+            }
+
+            void Report(XrPerfSettingsDomainEXT domain) const
+            {
+                if (sampleCount == 0) {
+                    return;
+                }
+                ReportF("  %s thermal trend              : %d samples, %s to %s (worst %s), headroom %.2f to %.2f (min %.2f), "
+                        "slope mean %.4f max %.4f/s",
+                        DomainName(domain), sampleCount, NotificationLevelName(firstLevel), NotificationLevelName(lastLevel),
+                        NotificationLevelName(worstLevel), firstHeadroom, lastHeadroom, minHeadroom, slopeSum / sampleCount, maxSlope);
+            }
+        };
+    }  // namespace
+
+    // Steps the CPU and then the GPU domain through every XrPerfSettingsLevelEXT with
+    // xrPerfSettingsSetPerformanceLevelEXT, the other domain staying at sustained high, while rendering under a
+    // synthetic CPU load and, where the graphics plugin can add one, the synthetic GPU overdraw load. Each level
+    // reports the frame rate and frame interval it sustained, missed frames, GPU time, the XrEventDataPerfSettingsEXT
+    // notifications received and, with XR_EXT_thermal_query, the temperature trend of both domains sampled once a
+    // second. Run it on a device at its normal operating temperature; the levels run in order, so later ones inherit
+    // the heat of earlier ones.
+    TEST_CASE("Performance Settings Sweep Benchmark", "[.][benchmark]")
+    {
+        GlobalData& globalData = GetGlobalData();
+        if (!globalData.IsUsingGraphicsPlugin()) {
+            // Nothing to measure - no graphics plugin means no frame submission
+            return;
+        }
+        if (!globalData.IsInstanceExtensionSupported(XR_EXT_PERFORMANCE_SETTINGS_EXTENSION_NAME)) {
+            WARN(XR_EXT_PERFORMANCE_SETTINGS_EXTENSION_NAME " not supported; skipping");
+            return;
+        }
+
+        std::vector<const char*> extensions{XR_EXT_PERFORMANCE_SETTINGS_EXTENSION_NAME};
+        const bool thermalQuery = globalData.IsInstanceExtensionSupported(XR_EXT_THERMAL_QUERY_EXTENSION_NAME);
+        if (thermalQuery) {
+            extensions.push_back(XR_EXT_THERMAL_QUERY_EXTENSION_NAME);
+        }
+        CompositionHelper compositionHelper("Performance Settings Sweep Benchmark", extensions);
+        compositionHelper.GetInteractionManager().AttachActionSets();
+        compositionHelper.BeginSession();
+        const XrSession session = compositionHelper.GetSession();
+
+        auto xrPerfSettingsSetPerformanceLevelEXT = GetInstanceExtensionFunction<PFN_xrPerfSettingsSetPerformanceLevelEXT>(
+            compositionHelper.GetInstance(), "xrPerfSettingsSetPerformanceLevelEXT");
+        PFN_xrThermalGetTemperatureTrendEXT xrThermalGetTemperatureTrendEXT = nullptr;
+        if (thermalQuery) {
+            xrThermalGetTemperatureTrendEXT = GetInstanceExtensionFunction<PFN_xrThermalGetTemperatureTrendEXT>(
+                compositionHelper.GetInstance(), "xrThermalGetTemperatureTrendEXT");
+        }
+
+        SimpleProjectionLayerHelper simpleProjectionLayerHelper(compositionHelper);
+        EventReader eventReader(compositionHelper.GetEventQueue());
+
+        auto graphicsPlugin = globalData.GetGraphicsPlugin();
+        const bool gpuTiming = graphicsPlugin->SetGpuTimingEnabled(true);
+        const bool gpuLoad = graphicsPlugin->SetSyntheticGpuLoad(sweepGpuLoadLayerCount);
+        if (!gpuLoad) {
+            WARN("Graphics plugin cannot add a synthetic GPU load; sweeping with the CPU load only");
+        }
+
+        // The synthetic CPU load scales with the display period, which a short loop finds first.
+        XrDuration displayPeriod = 0;
+        int warmupFrame = 0;
+        RenderLoop(session, [&](const XrFrameState& frameState) {
+            displayPeriod = frameState.predictedDisplayPeriod;
+            compositionHelper.PollEvents();
+            XrCompositionLayerBaseHeader* const projLayer = simpleProjectionLayerHelper.TryGetUpdatedProjectionLayer(frameState);
+            compositionHelper.EndFrame(frameState.predictedDisplayTime, &projLayer, projLayer != nullptr ? 1 : 0);
+            return ++warmupFrame < sweepWarmupFrameCount;
+        }).Loop();
+        REQUIRE(displayPeriod > 0);
+        FrameCpuLoad cpuLoad;
+        cpuLoad.beforeRender = std::chrono::nanoseconds((int64_t)(sweepCpuLoadFraction * displayPeriod));
+
+        for (XrPerfSettingsDomainEXT domain : sweepDomains) {
+            for (XrPerfSettingsLevelEXT level : sweepLevels) {
+                for (XrPerfSettingsDomainEXT otherDomain : sweepDomains) {
+                    REQUIRE_RESULT(xrPerfSettingsSetPerformanceLevelEXT(
+                                       session, otherDomain, otherDomain == domain ? level : XR_PERF_SETTINGS_LEVEL_SUSTAINED_HIGH_EXT),
+                                   XR_SUCCESS);
+                }
+
+                std::vector<int64_t> frameIntervals;
+                frameIntervals.reserve(sweepMeasuredFrameCount);
+                std::vector<GpuTimingSample> gpuTimings;
+                std::vector<XrEventDataPerfSettingsEXT> notifications;
+                ThermalTrend cpuThermal, gpuThermal;
+                int64_t missedFrameCount = 0;
+                MonotonicClock::time_point lastWake, nextThermalSample = MonotonicClock::now();
+                XrTime lastDisplayTime = 0;
+
+                int frame = 0;
+                RenderLoop renderLoop(session, [&](const XrFrameState& frameState) {
+                    const MonotonicClock::time_point wake = MonotonicClock::now();
+                    const bool measured = frame >= sweepWarmupFrameCount;
+                    if (measured && frame > sweepWarmupFrameCount) {
+                        frameIntervals.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(wake - lastWake).count());
+                        const XrDuration displayTimeDelta = frameState.predictedDisplayTime - lastDisplayTime;
+                        if (frameState.predictedDisplayPeriod > 0 && displayTimeDelta * 2 > frameState.predictedDisplayPeriod * 3) {
+                            const double periods = (double)displayTimeDelta / (double)frameState.predictedDisplayPeriod;
+                            missedFrameCount += std::max<int64_t>(1, std::llround(periods) - 1);
+                        }
+                    }
+                    lastWake = wake;
+                    lastDisplayTime = frameState.predictedDisplayTime;
+                    displayPeriod = frameState.predictedDisplayPeriod;
+
+                    compositionHelper.PollEvents();
+                    XrEventDataBuffer eventBuffer;
+                    while (eventReader.TryReadNext(eventBuffer)) {
+                        if (measured && eventBuffer.type == XR_TYPE_EVENT_DATA_PERF_SETTINGS_EXT) {
+                            notifications.push_back(*reinterpret_cast<const XrEventDataPerfSettingsEXT*>(&eventBuffer));
+                        }
+                    }
+
+                    if (measured && xrThermalGetTemperatureTrendEXT != nullptr && wake >= nextThermalSample) {
+                        nextThermalSample = wake + thermalSampleInterval;
+                        for (XrPerfSettingsDomainEXT thermalDomain : sweepDomains) {
+                            XrPerfSettingsNotificationLevelEXT notificationLevel;
+                            float headroom, slope;
+                            REQUIRE_RESULT(xrThermalGetTemperatureTrendEXT(session, thermalDomain, &notificationLevel, &headroom, &slope),
+                                           XR_SUCCESS);
+                            (thermalDomain == XR_PERF_SETTINGS_DOMAIN_CPU_EXT ? cpuThermal : gpuThermal)
+                                .Add(notificationLevel, headroom, slope);
+                        }
+                    }
+
+                    XrCompositionLayerBaseHeader* const projLayer = simpleProjectionLayerHelper.TryGetUpdatedProjectionLayer(frameState);
+                    compositionHelper.EndFrame(frameState.predictedDisplayTime, &projLayer, projLayer != nullptr ? 1 : 0);
+
+                    if (!measured) {
+                        gpuTimings.clear();
+                    }
+                    if (gpuTiming) {
+                        graphicsPlugin->CollectGpuTimings(gpuTimings);
+                    }
+                    return ++frame < sweepWarmupFrameCount + sweepMeasuredFrameCount;
+                });
+                renderLoop.SetCpuLoad(cpuLoad);
+                renderLoop.Loop();
+
+                const int64_t elapsed = std::accumulate(frameIntervals.begin(), frameIntervals.end(), int64_t{0});
+                ReportF("Performance level %s %s over %d frames:", DomainName(domain), LevelName(level), (int)frameIntervals.size() + 1);
+                ReportF("  Frame rate                       : %.2f Hz (display period %.3fms)",
+                        elapsed > 0 ? frameIntervals.size() * 1e9 / elapsed : 0.0, displayPeriod / 1000000.0);
+                ReportLatencyPercentiles("  Frame interval                   :", frameIntervals);
+                ReportF("  Missed frames                    : %lld", (long long)missedFrameCount);
+                if (gpuTiming) {
+                    graphicsPlugin->Flush();
+                    graphicsPlugin->CollectGpuTimings(gpuTimings);
+                    ReportGpuTimingPercentiles("  GPU time of", gpuTimings);
+                }
+                ReportF("  Notifications                    : %d", (int)notifications.size());
+                for (const XrEventDataPerfSettingsEXT& notification : notifications) {
+                    ReportF("    %s %s: %s to %s", DomainName(notification.domain), SubDomainName(notification.subDomain),
+                            NotificationLevelName(notification.fromLevel), NotificationLevelName(notification.toLevel));
+                }
+                cpuThermal.Report(XR_PERF_SETTINGS_DOMAIN_CPU_EXT);
+                gpuThermal.Report(XR_PERF_SETTINGS_DOMAIN_GPU_EXT);
+            }
+        }
+
+        for (XrPerfSettingsDomainEXT domain : sweepDomains) {
+            xrPerfSettingsSetPerformanceLevelEXT(session, domain, XR_PERF_SETTINGS_LEVEL_SUSTAINED_HIGH_EXT);
+        }
+        graphicsPlugin->SetSyntheticGpuLoad(0);
+        graphicsPlugin->SetGpuTimingEnabled(false);
+    }
+
 }  // namespace Conformance
@@ -18,6 +18,8 @@
 #include "conformance_utils.h"
 #include "conformance_framework.h"
 #include "bitmask_generator.h"
+#include "composition_utils.h"
+#include "frame_pacing.h"
 #include <array>
 #include <vector>
 #include <set>
@@ -157,4 +159,69 @@ namespace Conformance
             CHECK(result == XR_SUCCESS);
         }
     }
+
+    namespace
+    {
+        constexpr int depthWarmupFrameCount = 60;     // After switching between submitting depth and not.
+        constexpr int depthMeasuredFrameCount = 600;  // Per pass of each mode.
+        constexpr int depthPassCount = 2;             // Passes of each mode, alternated so that drift shows up in both.
+    }  // namespace
+
+    // Measures what submitting depth with XR_KHR_composition_layer_depth costs the runtime, which may use it to
+    // reproject frames. The same projection layer is submitted with and without a depth swapchain per view, in
+    // alternating passes, and each mode reports xrEndFrame CPU time, xrWaitFrame wake-up jitter, missed frames and,
+    // where the graphics plugin supports timestamp queries, the GPU time of rendering the views. Needs a graphics
+    // plugin that can render into depth swapchains, see IGraphicsPlugin::RenderViewWithDepth.
+    TEST_CASE("Depth Submission Benchmark", "[.][benchmark]")
+    {
+        GlobalData& globalData = GetGlobalData();
+        if (!globalData.IsUsingGraphicsPlugin()) {
+            // Nothing to measure - no graphics plugin means no frame submission
+            return;
+        }
+        if (!globalData.IsInstanceExtensionSupported(XR_KHR_COMPOSITION_LAYER_DEPTH_EXTENSION_NAME)) {
+            WARN(XR_KHR_COMPOSITION_LAYER_DEPTH_EXTENSION_NAME " not supported; skipping");
+            return;
+        }
+
+        CompositionHelper compositionHelper("Depth Submission Benchmark", {XR_KHR_COMPOSITION_LAYER_DEPTH_EXTENSION_NAME});
+        compositionHelper.GetInteractionManager().AttachActionSets();
+        compositionHelper.BeginSession();
+
+        SimpleProjectionLayerHelper colorOnlyLayerHelper(compositionHelper);
+        SimpleProjectionLayerHelper depthLayerHelper(compositionHelper, true);
+
+        auto graphicsPlugin = globalData.GetGraphicsPlugin();
+        const bool gpuTiming = graphicsPlugin->SetGpuTimingEnabled(true);
+
+        struct Mode
+        {
+            const char* name;
+            SimpleProjectionLayerHelper& helper;
+        };
+        const Mode modes[] = {{"without depth", colorOnlyLayerHelper}, {"with depth", depthLayerHelper}};
+
+        for (int pass = 1; pass <= depthPassCount; ++pass) {
+            for (const Mode& mode : modes) {
+                FramePacingRecorder recorder;
+                std::vector<int64_t> endFrameTimes;
+                std::vector<GpuTimingSample> gpuTimings;
+                RunWithProjectionLayer(compositionHelper, mode.helper, depthWarmupFrameCount, depthMeasuredFrameCount, gpuTiming, recorder,
+                                       endFrameTimes, gpuTimings);
+                if (&mode.helper == &depthLayerHelper && !depthLayerHelper.IsSubmittingDepth()) {
+                    graphicsPlugin->SetGpuTimingEnabled(false);
+                    WARN("Graphics plugin cannot render into depth swapchains; skipping");
+                    return;
+                }
+
+                const std::string loopName = std::string(mode.name) + ", pass " + std::to_string(pass);
+                recorder.Report(loopName.c_str());
+                ReportLatencyPercentiles("  xrEndFrame CPU time              :", endFrameTimes);
+                if (gpuTiming) {
+                    ReportGpuTimingPercentiles("  GPU time of", gpuTimings);
+                }
+            }
+        }
+        graphicsPlugin->SetGpuTimingEnabled(false);
+    }
 }  // namespace Conformance
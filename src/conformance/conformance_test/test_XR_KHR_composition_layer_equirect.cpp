@@ -62,7 +62,9 @@ namespace Conformance
         XrSwapchain swapchainPair[2];
         XrExtent2Di extents{256, 256};
 
-        XrResult result = CreateColorSwapchain(session.GetSession(), graphicsPlugin.get(), &swapchainPair[0], &extents);
+        XrSwapchainCreateInfo createInfo;
+        XrResult result =
+            CreateColorSwapchain(session.GetSession(), graphicsPlugin.get(), &swapchainPair[0], &extents, 1, false, &createInfo);
         REQUIRE_RESULT_SUCCEEDED(result);
         SwapchainCHECK swapchainCHECK0(swapchainPair[0]);  // Auto-deletes the swapchain.
 
@@ -70,8 +72,11 @@ namespace Conformance
         REQUIRE_RESULT_SUCCEEDED(result);
         SwapchainCHECK swapchainCHECK1(swapchainPair[1]);  // Auto-deletes the swapchain.
 
-        result = CycleToNextSwapchainImage(swapchainPair, 2, 3_xrSeconds);
-        REQUIRE_RESULT_SUCCEEDED(result);
+        // Generated on the GPU, so that large equirect images need no CPU rasterization.
+        for (XrSwapchain swapchain : swapchainPair) {
+            result = RenderGeneratedSwapchainImage(graphicsPlugin.get(), swapchain, createInfo, 3_xrSeconds);
+            REQUIRE_RESULT_SUCCEEDED(result);
+        }
 
         // typedef struct XrCompositionLayerEquirectKHR {
         //     XrStructureType             type;
@@ -17,7 +17,12 @@
 #include "utils.h"
 #include "conformance_utils.h"
 #include "conformance_framework.h"
+#include "composition_utils.h"
+#include "frame_pacing.h"
+#include "report.h"
+#include <algorithm>
 #include <array>
+#include <cmath>
 #include <vector>
 #include <set>
 #include <string>
@@ -190,4 +195,111 @@ namespace Conformance
             }
         }
     }  // namespace Conformance
+
+    namespace
+    {
+        constexpr int visibilityMaskWarmupFrameCount = 60;     // After switching between drawing the mask and not.
+        constexpr int visibilityMaskMeasuredFrameCount = 600;  // Per pass of each mode.
+        constexpr int visibilityMaskPassCount = 2;             // Passes of each mode, alternated so that drift shows up in both.
+        constexpr uint32_t visibilityMaskGpuLoadLayerCount = 16;  // Overdraw layers, so that rendering is bound by fill rate.
+
+        // The fraction of the view's field of view that hiddenArea covers, both measured on the tangent plane.
+        double HiddenAreaFraction(const VisibilityMask& hiddenArea, const XrFovf& fov)
+        {
+            const double fovArea = (std::tan(fov.angleRight) - std::tan(fov.angleLeft)) * (std::tan(fov.angleUp) - std::tan(fov.angleDown));
+            if (fovArea <= 0) {
+                return 0;
+            }
+            double area = 0;
+            for (size_t i = 0; i + 3 <= hiddenArea.indices.size(); i += 3) {
+                if (hiddenArea.indices[i] >= hiddenArea.vertices.size() || hiddenArea.indices[i + 1] >= hiddenArea.vertices.size() ||
+                    hiddenArea.indices[i + 2] >= hiddenArea.vertices.size()) {
+                    continue;
+                }
+                const XrVector2f& a = hiddenArea.vertices[hiddenArea.indices[i]];
+                const XrVector2f& b = hiddenArea.vertices[hiddenArea.indices[i + 1]];
+                const XrVector2f& c = hiddenArea.vertices[hiddenArea.indices[i + 2]];
+                area += std::fabs((b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y)) / 2;
+            }
+            return std::min(area / fovArea, 1.0);
+        }
+    }  // namespace
+
+    // Measures what drawing the hidden area first saves: renders the simple projection layer over a synthetic GPU load
+    // that makes it fill-bound, with and without the XR_KHR_visibility_mask hidden triangle mesh of each view, see
+    // IGraphicsPlugin::RenderViewWithVisibilityMask, in alternating passes. Reports the fraction of each view the mask
+    // hides and, for each pass, the GPU time of rendering where timestamp queries are supported, xrEndFrame CPU time
+    // and frame pacing.
+    TEST_CASE("Visibility Mask Benchmark", "[.][benchmark]")
+    {
+        GlobalData& globalData = GetGlobalData();
+        if (!globalData.IsUsingGraphicsPlugin()) {
+            // Nothing to measure - no graphics plugin means no frame submission
+            return;
+        }
+        if (!globalData.IsInstanceExtensionSupported(XR_KHR_VISIBILITY_MASK_EXTENSION_NAME)) {
+            WARN(XR_KHR_VISIBILITY_MASK_EXTENSION_NAME " not supported; skipping");
+            return;
+        }
+
+        CompositionHelper compositionHelper("Visibility Mask Benchmark", {XR_KHR_VISIBILITY_MASK_EXTENSION_NAME});
+        compositionHelper.GetInteractionManager().AttachActionSets();
+        compositionHelper.BeginSession();
+
+        SimpleProjectionLayerHelper simpleProjectionLayerHelper(compositionHelper);
+        if (!simpleProjectionLayerHelper.UpdateVisibilityMasks()) {
+            WARN("xrGetVisibilityMaskKHR is not available; skipping");
+            return;
+        }
+
+        auto graphicsPlugin = globalData.GetGraphicsPlugin();
+        const bool gpuTiming = graphicsPlugin->SetGpuTimingEnabled(true);
+        if (!graphicsPlugin->SetSyntheticGpuLoad(visibilityMaskGpuLoadLayerCount)) {
+            WARN("Graphics plugin cannot add a synthetic GPU load; measuring the cubes alone");
+        }
+
+        for (int pass = 1; pass <= visibilityMaskPassCount; ++pass) {
+            for (const bool masked : {false, true}) {
+                // Fetched again for every masked pass, in case the runtime changed them in between.
+                if (masked) {
+                    simpleProjectionLayerHelper.UpdateVisibilityMasks();
+                }
+                else {
+                    simpleProjectionLayerHelper.ClearVisibilityMasks();
+                }
+
+                FramePacingRecorder recorder;
+                std::vector<int64_t> endFrameTimes;
+                std::vector<GpuTimingSample> gpuTimings;
+                RunWithProjectionLayer(compositionHelper, simpleProjectionLayerHelper, visibilityMaskWarmupFrameCount,
+                                       visibilityMaskMeasuredFrameCount, gpuTiming, recorder, endFrameTimes, gpuTimings);
+                const std::vector<VisibilityMask>& masks = simpleProjectionLayerHelper.GetVisibilityMasks();
+                if (masked && masks.empty()) {
+                    graphicsPlugin->SetSyntheticGpuLoad(0);
+                    graphicsPlugin->SetGpuTimingEnabled(false);
+                    WARN("Graphics plugin cannot draw the visibility mask; skipping");
+                    return;
+                }
+                if (gpuTiming) {
+                    graphicsPlugin->Flush();
+                    graphicsPlugin->CollectGpuTimings(gpuTimings);
+                }
+
+                const std::string loopName = std::string(masked ? "with" : "without") + " visibility mask, pass " + std::to_string(pass);
+                recorder.Report(loopName.c_str());
+                for (uint32_t view = 0; view < (uint32_t)masks.size(); ++view) {
+                    ReportF("  Hidden area of view %u            : %.1f%% (%zu triangles)", view,
+                            100 * HiddenAreaFraction(masks[view], simpleProjectionLayerHelper.GetViewFov(view)),
+                            masks[view].indices.size() / 3);
+                }
+                ReportLatencyPercentiles("  xrEndFrame CPU time              :", endFrameTimes);
+                if (gpuTiming) {
+                    ReportGpuTimingPercentiles("  GPU time of", gpuTimings);
+                }
+            }
+        }
+
+        graphicsPlugin->SetSyntheticGpuLoad(0);
+        graphicsPlugin->SetGpuTimingEnabled(false);
+    }
 }  // namespace Conformance
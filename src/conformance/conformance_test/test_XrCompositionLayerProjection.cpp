@@ -14,10 +14,18 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <type_traits>
+#include <vector>
 #include "utils.h"
 #include "conformance_utils.h"
 #include "conformance_framework.h"
 #include "bitmask_generator.h"
+#include "composition_utils.h"
+#include "frame_pacing.h"
+#include "report.h"
 #include <openxr/openxr.h>
 #include <openxr/openxr_reflection.h>
 #include <catch2/catch.hpp>
@@ -258,4 +266,132 @@ namespace Conformance
             }
         }
     }
+
+    namespace
+    {
+        constexpr int resolutionWarmupFrameCount = 60;     // After each change of swapchain size.
+        constexpr int resolutionMeasuredFrameCount = 600;  // Per size.
+        // Swapchain sizes of the sweep, as multiples of the recommended image rect size. The sweep ends on the largest
+        // multiple the maximum image rect size allows.
+        constexpr float resolutionScales[] = {0.5f, 0.75f, 1.0f, 1.25f, 1.5f, 1.75f, 2.0f, 2.5f, 3.0f};
+
+        constexpr int msaaWarmupFrameCount = 60;            // After each change of sample count.
+        constexpr int msaaMeasuredFrameCount = 600;         // Per sample count.
+        constexpr uint32_t msaaSampleCounts[] = {1, 2, 4};  // See IGraphicsPlugin::SetRenderSampleCount.
+    }  // namespace
+
+    // Measures how far the application can supersample: renders the simple projection layer into swapchains from half
+    // the recommended image rect size up to the maximum, and reports for each size the GPU time of rendering where the
+    // graphics plugin supports timestamp queries, xrEndFrame CPU time, and the frame rate the runtime sustains against
+    // its display rate.
+    TEST_CASE("Resolution Scaling Benchmark", "[.][benchmark]")
+    {
+        GlobalData& globalData = GetGlobalData();
+        if (!globalData.IsUsingGraphicsPlugin()) {
+            // Nothing to measure - no graphics plugin means no frame submission
+            return;
+        }
+
+        CompositionHelper compositionHelper("Resolution Scaling Benchmark");
+        compositionHelper.GetInteractionManager().AttachActionSets();
+        compositionHelper.BeginSession();
+
+        // The largest scale every view allows in both dimensions.
+        float maxScale = resolutionScales[std::extent<decltype(resolutionScales)>::value - 1];
+        for (const XrViewConfigurationView& view : compositionHelper.EnumerateConfigurationViews()) {
+            REQUIRE(view.recommendedImageRectWidth > 0);
+            REQUIRE(view.recommendedImageRectHeight > 0);
+            maxScale = std::min({maxScale, (float)view.maxImageRectWidth / view.recommendedImageRectWidth,
+                                 (float)view.maxImageRectHeight / view.recommendedImageRectHeight});
+        }
+
+        std::vector<float> scales;
+        for (float scale : resolutionScales) {
+            if (scale < maxScale) {
+                scales.push_back(scale);
+            }
+        }
+        scales.push_back(maxScale);
+
+        auto graphicsPlugin = globalData.GetGraphicsPlugin();
+        const bool gpuTiming = graphicsPlugin->SetGpuTimingEnabled(true);
+
+        for (float scale : scales) {
+            FramePacingRecorder recorder;
+            std::vector<int64_t> endFrameTimes;
+            std::vector<GpuTimingSample> gpuTimings;
+            {
+                SimpleProjectionLayerHelper simpleProjectionLayerHelper(compositionHelper, false, scale);
+                const XrExtent2Di extent = simpleProjectionLayerHelper.GetImageRectExtent(0);
+                RunWithProjectionLayer(compositionHelper, simpleProjectionLayerHelper, resolutionWarmupFrameCount,
+                                       resolutionMeasuredFrameCount, gpuTiming, recorder, endFrameTimes, gpuTimings);
+                if (gpuTiming) {
+                    // Collect the rest before the swapchains go away.
+                    graphicsPlugin->Flush();
+                    graphicsPlugin->CollectGpuTimings(gpuTimings);
+                }
+
+                char loopName[64];
+                snprintf(loopName, sizeof(loopName), "%.2fx, %dx%d per view", scale, extent.width, extent.height);
+                recorder.Report(loopName);
+            }
+
+            const XrDuration displayPeriod = recorder.GetAverageDisplayPeriod();
+            ReportF("  Frame rate                       : %.2f Hz (display %.2f Hz)", recorder.GetFrameRate(),
+                    displayPeriod > 0 ? 1e9 / displayPeriod : 0.0);
+            ReportLatencyPercentiles("  xrEndFrame CPU time              :", endFrameTimes);
+            if (gpuTiming) {
+                ReportGpuTimingPercentiles("  GPU time of", gpuTimings);
+            }
+        }
+
+        graphicsPlugin->SetGpuTimingEnabled(false);
+    }
+
+    // Measures what multisampling costs: renders the simple projection layer at 1x, 2x and 4x MSAA, see
+    // IGraphicsPlugin::SetRenderSampleCount, and reports for each sample count the plugin supports the GPU time of
+    // rendering where timestamp queries are supported, xrEndFrame CPU time and frame pacing.
+    TEST_CASE("MSAA Benchmark", "[.][benchmark]")
+    {
+        GlobalData& globalData = GetGlobalData();
+        if (!globalData.IsUsingGraphicsPlugin()) {
+            // Nothing to measure - no graphics plugin means no frame submission
+            return;
+        }
+
+        CompositionHelper compositionHelper("MSAA Benchmark");
+        compositionHelper.GetInteractionManager().AttachActionSets();
+        compositionHelper.BeginSession();
+
+        auto graphicsPlugin = globalData.GetGraphicsPlugin();
+        const bool gpuTiming = graphicsPlugin->SetGpuTimingEnabled(true);
+
+        SimpleProjectionLayerHelper simpleProjectionLayerHelper(compositionHelper);
+        for (uint32_t sampleCount : msaaSampleCounts) {
+            if (!graphicsPlugin->SetRenderSampleCount(sampleCount)) {
+                WARN("Graphics plugin cannot render with " << sampleCount << "x MSAA; skipping");
+                continue;
+            }
+
+            FramePacingRecorder recorder;
+            std::vector<int64_t> endFrameTimes;
+            std::vector<GpuTimingSample> gpuTimings;
+            RunWithProjectionLayer(compositionHelper, simpleProjectionLayerHelper, msaaWarmupFrameCount, msaaMeasuredFrameCount, gpuTiming,
+                                   recorder, endFrameTimes, gpuTimings);
+            if (gpuTiming) {
+                graphicsPlugin->Flush();
+                graphicsPlugin->CollectGpuTimings(gpuTimings);
+            }
+
+            const std::string loopName = std::to_string(sampleCount) + "x MSAA";
+            recorder.Report(loopName.c_str());
+            ReportLatencyPercentiles("  xrEndFrame CPU time              :", endFrameTimes);
+            if (gpuTiming) {
+                ReportGpuTimingPercentiles("  GPU time of", gpuTimings);
+            }
+        }
+
+        graphicsPlugin->SetRenderSampleCount(1);
+        graphicsPlugin->SetGpuTimingEnabled(false);
+    }
 }  // namespace Conformance
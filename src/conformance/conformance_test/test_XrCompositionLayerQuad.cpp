@@ -14,10 +14,17 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
 #include "utils.h"
 #include "conformance_utils.h"
 #include "conformance_framework.h"
 #include "bitmask_generator.h"
+#include "composition_utils.h"
+#include "frame_pacing.h"
+#include "report.h"
 #include <openxr/openxr.h>
 #include <openxr/openxr_reflection.h>
 #include <catch2/catch.hpp>
@@ -184,4 +191,117 @@ namespace Conformance
             }
         }
     }
+
+    namespace
+    {
+        constexpr int atlasWarmupFrameCount = 60;     // After switching between separate swapchains and the atlas.
+        constexpr int atlasMeasuredFrameCount = 600;  // Per mode.
+        constexpr uint32_t atlasMaxQuadCount = 64;    // Quads in the grid, fewer if the system allows fewer layers.
+    }  // namespace
+
+    // Measures what sub-image based composition saves: submits the same grid of quads with one static swapchain each
+    // and then from a shared atlas, see CompositionHelper::CreateStaticSwapchainAtlas, and reports for each the
+    // swapchain count and setup time, xrEndFrame CPU time and frame pacing.
+    TEST_CASE("Quad Atlas Benchmark", "[.][benchmark]")
+    {
+        GlobalData& globalData = GetGlobalData();
+        if (!globalData.IsUsingGraphicsPlugin()) {
+            // Nothing to measure - no graphics plugin means no frame submission
+            return;
+        }
+
+        CompositionHelper compositionHelper("Quad Atlas Benchmark");
+
+        XrSystemProperties systemProperties{XR_TYPE_SYSTEM_PROPERTIES};
+        REQUIRE_RESULT(xrGetSystemProperties(compositionHelper.GetInstance(), compositionHelper.GetSystemId(), &systemProperties),
+                       XR_SUCCESS);
+        // CompositionHelper::EndFrame adds the test name quad to every frame.
+        const uint32_t quadCount = std::min(atlasMaxQuadCount, systemProperties.graphicsProperties.maxLayerCount - 1);
+
+        compositionHelper.GetInteractionManager().AttachActionSets();
+        compositionHelper.BeginSession();
+
+        const XrSpace localSpace = compositionHelper.CreateReferenceSpace(XR_REFERENCE_SPACE_TYPE_LOCAL);
+
+        // Panels of a few sizes and colors, as a UI would have.
+        constexpr int imageSizes[] = {64, 128, 256};
+        std::vector<RGBAImage> images;
+        images.reserve(quadCount);
+        for (uint32_t i = 0; i < quadCount; ++i) {
+            const int size = imageSizes[i % 3];
+            const float shade = (float)(i % 8) / 7;
+            images.emplace_back(size, size);
+            images.back().DrawRect(0, 0, size, size, XrColor4f{shade, 0.5f, 1 - shade, 1});
+            images.back().DrawRectBorder(0, 0, size, size, 2, XrColor4f{1, 1, 1, 1});
+        }
+
+        const uint32_t columns = (uint32_t)std::ceil(std::sqrt((float)quadCount));
+        auto quadPose = [&](uint32_t i) {
+            const float x = ((float)(i % columns) - (columns - 1) / 2.0f) * 0.2f;
+            const float y = ((float)(i / columns) - (columns - 1) / 2.0f) * 0.2f;
+            return XrPosef{{0, 0, 0, 1}, {x, y, -2.0f}};
+        };
+
+        for (const bool atlas : {false, true}) {
+            Stopwatch setupStopwatch(true);
+            std::vector<XrSwapchainSubImage> subImages;
+            if (atlas) {
+                subImages = compositionHelper.CreateStaticSwapchainAtlas(images);
+            }
+            else {
+                for (XrSwapchain swapchain : compositionHelper.CreateStaticSwapchainImages(images)) {
+                    subImages.push_back(compositionHelper.MakeDefaultSubImage(swapchain));
+                }
+            }
+            const double setupMilliseconds = setupStopwatch.Elapsed().count() / 1000000.0;
+
+            std::vector<XrCompositionLayerBaseHeader*> layers;
+            layers.reserve(quadCount);
+            for (uint32_t i = 0; i < quadCount; ++i) {
+                layers.push_back(reinterpret_cast<XrCompositionLayerBaseHeader*>(
+                    compositionHelper.CreateQuadLayer(subImages[i], localSpace, 0.15f, quadPose(i))));
+            }
+
+            FramePacingRecorder recorder;
+            std::vector<int64_t> endFrameLatency;
+            endFrameLatency.reserve(atlasMeasuredFrameCount);
+            Stopwatch endFrameStopwatch;
+
+            int frame = 0;
+            RenderLoop renderLoop(compositionHelper, [&](const XrFrameState& frameState) {
+                const bool measured = frame >= atlasWarmupFrameCount;
+                if (measured) {
+                    recorder.OnFrameWoken(frameState);
+                }
+
+                compositionHelper.PollEvents();
+
+                endFrameStopwatch.Restart();
+                compositionHelper.EndFrame(frameState.predictedDisplayTime, layers.data(), layers.size());
+                if (measured) {
+                    endFrameLatency.push_back(endFrameStopwatch.Elapsed().count());
+                    recorder.OnFrameEnded();
+                }
+                return ++frame < atlasWarmupFrameCount + atlasMeasuredFrameCount;
+            });
+            renderLoop.Loop();
+
+            std::vector<XrSwapchain> swapchains;
+            for (const XrSwapchainSubImage& subImage : subImages) {
+                if (std::find(swapchains.begin(), swapchains.end(), subImage.swapchain) == swapchains.end()) {
+                    swapchains.push_back(subImage.swapchain);
+                }
+            }
+
+            const std::string loopName = std::to_string(quadCount) + (atlas ? " quads from an atlas" : " quads, a swapchain each");
+            recorder.Report(loopName.c_str());
+            ReportF("  Swapchains                       : %u, created and filled in %.3fms", (unsigned)swapchains.size(),
+                    setupMilliseconds);
+            ReportLatencyPercentiles("  xrEndFrame CPU time              :", endFrameLatency);
+
+            for (XrSwapchain swapchain : swapchains) {
+                compositionHelper.DestroySwapchain(swapchain);
+            }
+        }
+    }
 }  // namespace Conformance
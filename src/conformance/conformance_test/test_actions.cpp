@@ -52,7 +52,7 @@ namespace
             : m_compositionHelper(compositionHelper)
             , m_viewSpace(compositionHelper.CreateReferenceSpace(XR_REFERENCE_SPACE_TYPE_VIEW))
             , m_eventReader(m_compositionHelper.GetEventQueue())
-            , m_renderLoop(m_compositionHelper.GetSession(), [&](const XrFrameState& frameState) { return EndFrame(frameState); })
+            , m_renderLoop(m_compositionHelper, [&](const XrFrameState& frameState) { return EndFrame(frameState); })
         {
         }
 
@@ -63,6 +63,7 @@ namespace
             DisplayMessage("Waiting for session focus...");
 
             bool focused = WaitUntilPredicateWithTimeout(
+                m_compositionHelper.GetEventQueue(),
                 [&]() {
                     m_renderLoop.IterateFrame();
                     XrEventDataBuffer eventData;
@@ -140,11 +141,8 @@ namespace
                 m_messageQuad = std::make_unique<MessageQuad>(m_compositionHelper, std::move(m_displayMessageImage), m_viewSpace);
             }
 
-            std::vector<XrCompositionLayerBaseHeader*> layers;
-            if (m_messageQuad != nullptr) {
-                layers.push_back(reinterpret_cast<XrCompositionLayerBaseHeader*>(m_messageQuad.get()));
-            }
-            m_compositionHelper.EndFrame(frameState.predictedDisplayTime, std::move(layers));
+            XrCompositionLayerBaseHeader* const messageLayer = reinterpret_cast<XrCompositionLayerBaseHeader*>(m_messageQuad.get());
+            m_compositionHelper.EndFrame(frameState.predictedDisplayTime, &messageLayer, m_messageQuad != nullptr ? 1 : 0);
             return m_compositionHelper.PollEvents();
         }
 
@@ -220,6 +218,95 @@ namespace
 
         std::unique_ptr<MessageQuad> m_messageQuad;
     };
+
+    // The session, actions and bindings "State query functions and haptics" queries. None of its sections change them, so
+    // with --reuseSectionFixtures they are set up once for all of its sections.
+    struct StateQueryFixture
+    {
+        StateQueryFixture() : compositionHelper("Input device state query")
+        {
+            XrActionSetCreateInfo actionSetCreateInfo{XR_TYPE_ACTION_SET_CREATE_INFO};
+            strcpy(actionSetCreateInfo.localizedActionSetName, "test action set localized name");
+            strcpy(actionSetCreateInfo.actionSetName, "test_action_set_name");
+            REQUIRE_RESULT(xrCreateActionSet(compositionHelper.GetInstance(), &actionSetCreateInfo, &actionSet), XR_SUCCESS);
+
+            XrPath leftHandPath = StringToPath(compositionHelper.GetInstance(), "/user/hand/left");
+            XrPath rightHandPath = StringToPath(compositionHelper.GetInstance(), "/user/hand/right");
+            gamepadPath = StringToPath(compositionHelper.GetInstance(), "/user/gamepad");
+            XrPath bothHands[] = {leftHandPath, rightHandPath};
+
+            XrActionCreateInfo actionCreateInfo{XR_TYPE_ACTION_CREATE_INFO};
+            actionCreateInfo.actionType = XR_ACTION_TYPE_BOOLEAN_INPUT;
+            strcpy(actionCreateInfo.localizedActionName, "test action localized name bool");
+            strcpy(actionCreateInfo.actionName, "test_action_name_bool");
+            actionCreateInfo.countSubactionPaths = 2;
+            actionCreateInfo.subactionPaths = bothHands;
+            REQUIRE_RESULT(xrCreateAction(actionSet, &actionCreateInfo, &booleanAction), XR_SUCCESS);
+
+            actionCreateInfo.actionType = XR_ACTION_TYPE_FLOAT_INPUT;
+            strcpy(actionCreateInfo.localizedActionName, "test action localized name float");
+            strcpy(actionCreateInfo.actionName, "test_action_name_float");
+            REQUIRE_RESULT(xrCreateAction(actionSet, &actionCreateInfo, &floatAction), XR_SUCCESS);
+
+            actionCreateInfo.actionType = XR_ACTION_TYPE_VECTOR2F_INPUT;
+            strcpy(actionCreateInfo.localizedActionName, "test action localized name vector");
+            strcpy(actionCreateInfo.actionName, "test_action_name_vector");
+            REQUIRE_RESULT(xrCreateAction(actionSet, &actionCreateInfo, &vectorAction), XR_SUCCESS);
+
+            actionCreateInfo.actionType = XR_ACTION_TYPE_POSE_INPUT;
+            strcpy(actionCreateInfo.localizedActionName, "test action localized name pose");
+            strcpy(actionCreateInfo.actionName, "test_action_name_pose");
+            REQUIRE_RESULT(xrCreateAction(actionSet, &actionCreateInfo, &poseAction), XR_SUCCESS);
+
+            actionCreateInfo.actionType = XR_ACTION_TYPE_VIBRATION_OUTPUT;
+            strcpy(actionCreateInfo.localizedActionName, "test action localized name haptic");
+            strcpy(actionCreateInfo.actionName, "test_action_name_haptic");
+            REQUIRE_RESULT(xrCreateAction(actionSet, &actionCreateInfo, &hapticAction), XR_SUCCESS);
+
+            actionCreateInfo.actionType = XR_ACTION_TYPE_BOOLEAN_INPUT;
+            strcpy(actionCreateInfo.localizedActionName, "test action localized name confirm");
+            strcpy(actionCreateInfo.actionName, "test_action_name_confirm");
+            actionCreateInfo.countSubactionPaths = 0;
+            REQUIRE_RESULT(xrCreateAction(actionSet, &actionCreateInfo, &confirmAction), XR_SUCCESS);
+
+            strcpy(actionCreateInfo.localizedActionName, "test action localized name deny");
+            strcpy(actionCreateInfo.actionName, "test_action_name_deny");
+            REQUIRE_RESULT(xrCreateAction(actionSet, &actionCreateInfo, &denyAction), XR_SUCCESS);
+
+            compositionHelper.BeginSession();
+
+            actionLayerManager = std::make_unique<ActionLayerManager>(compositionHelper);
+            actionLayerManager->WaitForSessionFocusWithMessage();
+
+            XrPath simpleControllerInteractionProfile =
+                StringToPath(compositionHelper.GetInstance(), cSimpleKHRInteractionProfileDefinition.InteractionProfilePathString.c_str());
+
+            XrPath leftHandSelectClickPath = StringToPath(compositionHelper.GetInstance(), "/user/hand/left/input/select/click");
+            XrPath rightHandSelectClickPath = StringToPath(compositionHelper.GetInstance(), "/user/hand/right/input/select/click");
+            XrPath leftHandMenuClickPath = StringToPath(compositionHelper.GetInstance(), "/user/hand/left/input/menu/click");
+            XrPath rightHandMenuClickPath = StringToPath(compositionHelper.GetInstance(), "/user/hand/right/input/menu/click");
+
+            compositionHelper.GetInteractionManager().AddActionSet(actionSet);
+            compositionHelper.GetInteractionManager().AddActionBindings(simpleControllerInteractionProfile,
+                                                                        {{confirmAction, leftHandSelectClickPath},
+                                                                         {confirmAction, rightHandSelectClickPath},
+                                                                         {denyAction, leftHandMenuClickPath},
+                                                                         {denyAction, rightHandMenuClickPath}});
+            compositionHelper.GetInteractionManager().AttachActionSets();
+        }
+
+        CompositionHelper compositionHelper;
+        std::unique_ptr<ActionLayerManager> actionLayerManager;
+        XrActionSet actionSet{XR_NULL_HANDLE};
+        XrPath gamepadPath{XR_NULL_PATH};
+        XrAction booleanAction{XR_NULL_HANDLE};
+        XrAction floatAction{XR_NULL_HANDLE};
+        XrAction vectorAction{XR_NULL_HANDLE};
+        XrAction poseAction{XR_NULL_HANDLE};
+        XrAction hapticAction{XR_NULL_HANDLE};
+        XrAction confirmAction{XR_NULL_HANDLE};
+        XrAction denyAction{XR_NULL_HANDLE};
+    };
 }  // namespace
 
 namespace Conformance
@@ -631,11 +718,12 @@ namespace Conformance
                     strcpy(allIPActionCreateInfo.actionName, (actionNamePrefix + "test_haptic_action_name").c_str());
                     REQUIRE_RESULT(xrCreateAction(actionSet, &allIPActionCreateInfo, &hapticAction), XR_SUCCESS);
 
-                    bindings.interactionProfile = StringToPath(instance, ipMetadata.InteractionProfilePathString.c_str());
+                    const auto ipPaths = GetInteractionProfilePaths(instance, ipMetadata);
+                    bindings.interactionProfile = ipPaths->InteractionProfile;
                     bindings.countSuggestedBindings = 1;
-                    for (const auto& inputSourcePathData : ipMetadata.WhitelistData) {
-                        const std::string& bindingPath = inputSourcePathData.Path;
-                        const XrActionType& actionType = inputSourcePathData.Type;
+                    for (size_t sourceIndex = 0; sourceIndex < ipMetadata.WhitelistData.size(); ++sourceIndex) {
+                        const XrPath bindingPath = ipPaths->InputSourcePaths[sourceIndex];
+                        const XrActionType& actionType = ipMetadata.WhitelistData[sourceIndex].Type;
 
                         XrAction* actionRef;
                         if (actionType == XR_ACTION_TYPE_BOOLEAN_INPUT) {
@@ -654,7 +742,7 @@ namespace Conformance
                             actionRef = &hapticAction;
                         }
 
-                        XrActionSuggestedBinding suggestedBindings{*actionRef, StringToPath(instance, bindingPath.c_str())};
+                        XrActionSuggestedBinding suggestedBindings{*actionRef, bindingPath};
                         bindings.suggestedBindings = &suggestedBindings;
                         REQUIRE_RESULT(xrSuggestInteractionProfileBindings(instance, &bindings), XR_SUCCESS);
                     }
@@ -2534,84 +2622,14 @@ namespace Conformance
 
     TEST_CASE("State query functions and haptics", "[actions]")
     {
-        CompositionHelper compositionHelper("Input device state query");
-
-        XrActionSet actionSet{XR_NULL_HANDLE};
-        XrActionSetCreateInfo actionSetCreateInfo{XR_TYPE_ACTION_SET_CREATE_INFO};
-        strcpy(actionSetCreateInfo.localizedActionSetName, "test action set localized name");
-        strcpy(actionSetCreateInfo.actionSetName, "test_action_set_name");
-        REQUIRE_RESULT(xrCreateActionSet(compositionHelper.GetInstance(), &actionSetCreateInfo, &actionSet), XR_SUCCESS);
-
-        XrPath leftHandPath = StringToPath(compositionHelper.GetInstance(), "/user/hand/left");
-        XrPath rightHandPath = StringToPath(compositionHelper.GetInstance(), "/user/hand/right");
-        XrPath gamepadPath = StringToPath(compositionHelper.GetInstance(), "/user/gamepad");
-        XrPath bothHands[] = {leftHandPath, rightHandPath};
-
-        XrAction booleanAction{XR_NULL_HANDLE};
-        XrAction floatAction{XR_NULL_HANDLE};
-        XrAction vectorAction{XR_NULL_HANDLE};
-        XrAction poseAction{XR_NULL_HANDLE};
-        XrAction hapticAction{XR_NULL_HANDLE};
-        XrActionCreateInfo actionCreateInfo{XR_TYPE_ACTION_CREATE_INFO};
-        actionCreateInfo.actionType = XR_ACTION_TYPE_BOOLEAN_INPUT;
-        strcpy(actionCreateInfo.localizedActionName, "test action localized name bool");
-        strcpy(actionCreateInfo.actionName, "test_action_name_bool");
-        actionCreateInfo.countSubactionPaths = 2;
-        actionCreateInfo.subactionPaths = bothHands;
-        REQUIRE_RESULT(xrCreateAction(actionSet, &actionCreateInfo, &booleanAction), XR_SUCCESS);
-
-        actionCreateInfo.actionType = XR_ACTION_TYPE_FLOAT_INPUT;
-        strcpy(actionCreateInfo.localizedActionName, "test action localized name float");
-        strcpy(actionCreateInfo.actionName, "test_action_name_float");
-        REQUIRE_RESULT(xrCreateAction(actionSet, &actionCreateInfo, &floatAction), XR_SUCCESS);
-
-        actionCreateInfo.actionType = XR_ACTION_TYPE_VECTOR2F_INPUT;
-        strcpy(actionCreateInfo.localizedActionName, "test action localized name vector");
-        strcpy(actionCreateInfo.actionName, "test_action_name_vector");
-        REQUIRE_RESULT(xrCreateAction(actionSet, &actionCreateInfo, &vectorAction), XR_SUCCESS);
-
-        actionCreateInfo.actionType = XR_ACTION_TYPE_POSE_INPUT;
-        strcpy(actionCreateInfo.localizedActionName, "test action localized name pose");
-        strcpy(actionCreateInfo.actionName, "test_action_name_pose");
-        REQUIRE_RESULT(xrCreateAction(actionSet, &actionCreateInfo, &poseAction), XR_SUCCESS);
-
-        actionCreateInfo.actionType = XR_ACTION_TYPE_VIBRATION_OUTPUT;
-        strcpy(actionCreateInfo.localizedActionName, "test action localized name haptic");
-        strcpy(actionCreateInfo.actionName, "test_action_name_haptic");
-        REQUIRE_RESULT(xrCreateAction(actionSet, &actionCreateInfo, &hapticAction), XR_SUCCESS);
-
-        XrAction confirmAction{XR_NULL_HANDLE};
-        XrAction denyAction{XR_NULL_HANDLE};
-        actionCreateInfo.actionType = XR_ACTION_TYPE_BOOLEAN_INPUT;
-        strcpy(actionCreateInfo.localizedActionName, "test action localized name confirm");
-        strcpy(actionCreateInfo.actionName, "test_action_name_confirm");
-        actionCreateInfo.countSubactionPaths = 0;
-        REQUIRE_RESULT(xrCreateAction(actionSet, &actionCreateInfo, &confirmAction), XR_SUCCESS);
-
-        strcpy(actionCreateInfo.localizedActionName, "test action localized name deny");
-        strcpy(actionCreateInfo.actionName, "test_action_name_deny");
-        REQUIRE_RESULT(xrCreateAction(actionSet, &actionCreateInfo, &denyAction), XR_SUCCESS);
-
-        compositionHelper.BeginSession();
-
-        ActionLayerManager actionLayerManager(compositionHelper);
-        actionLayerManager.WaitForSessionFocusWithMessage();
-
-        XrPath simpleControllerInteractionProfile =
-            StringToPath(compositionHelper.GetInstance(), cSimpleKHRInteractionProfileDefinition.InteractionProfilePathString.c_str());
-
-        XrPath leftHandSelectClickPath = StringToPath(compositionHelper.GetInstance(), "/user/hand/left/input/select/click");
-        XrPath rightHandSelectClickPath = StringToPath(compositionHelper.GetInstance(), "/user/hand/right/input/select/click");
-        XrPath leftHandMenuClickPath = StringToPath(compositionHelper.GetInstance(), "/user/hand/left/input/menu/click");
-        XrPath rightHandMenuClickPath = StringToPath(compositionHelper.GetInstance(), "/user/hand/right/input/menu/click");
-
-        compositionHelper.GetInteractionManager().AddActionSet(actionSet);
-        compositionHelper.GetInteractionManager().AddActionBindings(simpleControllerInteractionProfile,
-                                                                    {{confirmAction, leftHandSelectClickPath},
-                                                                     {confirmAction, rightHandSelectClickPath},
-                                                                     {denyAction, leftHandMenuClickPath},
-                                                                     {denyAction, rightHandMenuClickPath}});
-        compositionHelper.GetInteractionManager().AttachActionSets();
+        StateQueryFixture& fixture = GetGlobalData().GetSectionFixture<StateQueryFixture>("state query session");
+        CompositionHelper& compositionHelper = fixture.compositionHelper;
+        const XrPath gamepadPath = fixture.gamepadPath;
+        const XrAction booleanAction = fixture.booleanAction;
+        const XrAction floatAction = fixture.floatAction;
+        const XrAction vectorAction = fixture.vectorAction;
+        const XrAction poseAction = fixture.poseAction;
+        const XrAction hapticAction = fixture.hapticAction;
 
         XrActionStateBoolean booleanState{XR_TYPE_ACTION_STATE_BOOLEAN};
         XrActionStateFloat floatState{XR_TYPE_ACTION_STATE_FLOAT};
@@ -3108,43 +3126,58 @@ namespace Conformance
                 getInfo.sourcePath = enumerateResult[0];
                 SECTION("xrGetInputSourceLocalizedName")
                 {
+                    std::vector<char> localizedNameBuffer;
                     getInfo.whichComponents = XR_INPUT_SOURCE_LOCALIZED_NAME_USER_PATH_BIT;
                     std::string localizedStringResult =
-                        REQUIRE_TWO_CALL(char, {}, xrGetInputSourceLocalizedName, compositionHelper.GetSession(), &getInfo).data();
+                        REQUIRE_TWO_CALL_INTO(localizedNameBuffer, char, {}, xrGetInputSourceLocalizedName, compositionHelper.GetSession(),
+                                              &getInfo)
+                            .data();
                     REQUIRE_FALSE(localizedStringResult.empty());
 
                     getInfo.whichComponents = XR_INPUT_SOURCE_LOCALIZED_NAME_INTERACTION_PROFILE_BIT;
                     localizedStringResult =
-                        REQUIRE_TWO_CALL(char, {}, xrGetInputSourceLocalizedName, compositionHelper.GetSession(), &getInfo).data();
+                        REQUIRE_TWO_CALL_INTO(localizedNameBuffer, char, {}, xrGetInputSourceLocalizedName, compositionHelper.GetSession(),
+                                              &getInfo)
+                            .data();
                     REQUIRE_FALSE(localizedStringResult.empty());
 
                     getInfo.whichComponents = XR_INPUT_SOURCE_LOCALIZED_NAME_COMPONENT_BIT;
                     localizedStringResult =
-                        REQUIRE_TWO_CALL(char, {}, xrGetInputSourceLocalizedName, compositionHelper.GetSession(), &getInfo).data();
+                        REQUIRE_TWO_CALL_INTO(localizedNameBuffer, char, {}, xrGetInputSourceLocalizedName, compositionHelper.GetSession(),
+                                              &getInfo)
+                            .data();
                     REQUIRE_FALSE(localizedStringResult.empty());
 
                     getInfo.whichComponents =
                         XR_INPUT_SOURCE_LOCALIZED_NAME_USER_PATH_BIT | XR_INPUT_SOURCE_LOCALIZED_NAME_INTERACTION_PROFILE_BIT;
                     localizedStringResult =
-                        REQUIRE_TWO_CALL(char, {}, xrGetInputSourceLocalizedName, compositionHelper.GetSession(), &getInfo).data();
+                        REQUIRE_TWO_CALL_INTO(localizedNameBuffer, char, {}, xrGetInputSourceLocalizedName, compositionHelper.GetSession(),
+                                              &getInfo)
+                            .data();
                     REQUIRE_FALSE(localizedStringResult.empty());
 
                     getInfo.whichComponents = XR_INPUT_SOURCE_LOCALIZED_NAME_USER_PATH_BIT | XR_INPUT_SOURCE_LOCALIZED_NAME_COMPONENT_BIT;
                     localizedStringResult =
-                        REQUIRE_TWO_CALL(char, {}, xrGetInputSourceLocalizedName, compositionHelper.GetSession(), &getInfo).data();
+                        REQUIRE_TWO_CALL_INTO(localizedNameBuffer, char, {}, xrGetInputSourceLocalizedName, compositionHelper.GetSession(),
+                                              &getInfo)
+                            .data();
                     REQUIRE_FALSE(localizedStringResult.empty());
 
                     getInfo.whichComponents =
                         XR_INPUT_SOURCE_LOCALIZED_NAME_INTERACTION_PROFILE_BIT | XR_INPUT_SOURCE_LOCALIZED_NAME_COMPONENT_BIT;
                     localizedStringResult =
-                        REQUIRE_TWO_CALL(char, {}, xrGetInputSourceLocalizedName, compositionHelper.GetSession(), &getInfo).data();
+                        REQUIRE_TWO_CALL_INTO(localizedNameBuffer, char, {}, xrGetInputSourceLocalizedName, compositionHelper.GetSession(),
+                                              &getInfo)
+                            .data();
                     REQUIRE_FALSE(localizedStringResult.empty());
 
                     getInfo.whichComponents = XR_INPUT_SOURCE_LOCALIZED_NAME_USER_PATH_BIT |
                                               XR_INPUT_SOURCE_LOCALIZED_NAME_INTERACTION_PROFILE_BIT |
                                               XR_INPUT_SOURCE_LOCALIZED_NAME_COMPONENT_BIT;
                     localizedStringResult =
-                        REQUIRE_TWO_CALL(char, {}, xrGetInputSourceLocalizedName, compositionHelper.GetSession(), &getInfo).data();
+                        REQUIRE_TWO_CALL_INTO(localizedNameBuffer, char, {}, xrGetInputSourceLocalizedName, compositionHelper.GetSession(),
+                                              &getInfo)
+                            .data();
                     REQUIRE_FALSE(localizedStringResult.empty());
 
                     uint32_t sourceCountOutput;
@@ -3190,4 +3223,373 @@ namespace Conformance
             }
         }
     }
+
+    namespace
+    {
+        constexpr uint32_t actionBenchmarkActionSetCount = 8;
+        constexpr uint32_t actionBenchmarkActionsPerSet = 64;
+        constexpr int actionBenchmarkWarmupFrameCount = 10;
+        constexpr int actionBenchmarkMeasuredFrameCount = 60;
+
+        // Returns true if the binding path is under one of the top level paths, or if there are none to restrict to.
+        bool IsBindingUnderTopLevelPaths(const std::string& bindingPath, const std::vector<std::string>& topLevelPaths)
+        {
+            if (topLevelPaths.empty()) {
+                return true;
+            }
+            for (const std::string& topLevelPath : topLevelPaths) {
+                if (bindingPath.compare(0, topLevelPath.size(), topLevelPath) == 0 && bindingPath.size() > topLevelPath.size() &&
+                    bindingPath[topLevelPath.size()] == '/') {
+                    return true;
+                }
+            }
+            return false;
+        }
+    }  // namespace
+
+    // Measures how xrSyncActions and the xrGetActionState* queries of a frame scale with the number of active actions,
+    // for actions with no, two and four subaction paths. Every interaction profile gets suggested bindings for every
+    // action.
+    TEST_CASE("Action System Scaling Benchmark", "[.][benchmark]")
+    {
+        CompositionHelper compositionHelper("Action system scaling benchmark");
+        XrInstance instance = compositionHelper.GetInstance();
+        XrSession session = compositionHelper.GetSession();
+
+        const std::vector<std::vector<std::string>> subactionPathConfigs{
+            {}, {"/user/hand/left", "/user/hand/right"}, {"/user/hand/left", "/user/hand/right", "/user/head", "/user/gamepad"}};
+        const XrActionType actionTypes[] = {XR_ACTION_TYPE_BOOLEAN_INPUT, XR_ACTION_TYPE_FLOAT_INPUT, XR_ACTION_TYPE_VECTOR2F_INPUT,
+                                            XR_ACTION_TYPE_POSE_INPUT};
+
+        struct BenchmarkAction
+        {
+            XrAction action;
+            XrActionType type;
+        };
+        struct BenchmarkConfig
+        {
+            std::vector<XrPath> subactionPaths;
+            std::vector<XrActionSet> actionSets;
+            std::vector<std::vector<BenchmarkAction>> actions;  // Per action set.
+        };
+        std::vector<BenchmarkConfig> configs(subactionPathConfigs.size());
+
+        for (size_t configIndex = 0; configIndex < subactionPathConfigs.size(); ++configIndex) {
+            BenchmarkConfig& config = configs[configIndex];
+            for (const std::string& subactionPathString : subactionPathConfigs[configIndex]) {
+                config.subactionPaths.push_back(StringToPath(instance, subactionPathString.c_str()));
+            }
+
+            for (uint32_t setIndex = 0; setIndex < actionBenchmarkActionSetCount; ++setIndex) {
+                XrActionSetCreateInfo actionSetCreateInfo{XR_TYPE_ACTION_SET_CREATE_INFO};
+                const std::string actionSetName = "benchmark_set_" + std::to_string(configIndex) + "_" + std::to_string(setIndex);
+                strcpy(actionSetCreateInfo.actionSetName, actionSetName.c_str());
+                strcpy(actionSetCreateInfo.localizedActionSetName, actionSetName.c_str());
+                XrActionSet actionSet{XR_NULL_HANDLE};
+                REQUIRE_RESULT(xrCreateActionSet(instance, &actionSetCreateInfo, &actionSet), XR_SUCCESS);
+                config.actionSets.push_back(actionSet);
+                compositionHelper.GetInteractionManager().AddActionSet(actionSet);
+
+                config.actions.emplace_back();
+                for (uint32_t actionIndex = 0; actionIndex < actionBenchmarkActionsPerSet; ++actionIndex) {
+                    XrActionCreateInfo actionCreateInfo{XR_TYPE_ACTION_CREATE_INFO};
+                    const std::string actionName = "benchmark_action_" + std::to_string(actionIndex);
+                    strcpy(actionCreateInfo.actionName, actionName.c_str());
+                    strcpy(actionCreateInfo.localizedActionName, actionName.c_str());
+                    actionCreateInfo.actionType = actionTypes[actionIndex % (sizeof(actionTypes) / sizeof(actionTypes[0]))];
+                    actionCreateInfo.countSubactionPaths = (uint32_t)config.subactionPaths.size();
+                    actionCreateInfo.subactionPaths = config.subactionPaths.data();
+                    XrAction action{XR_NULL_HANDLE};
+                    REQUIRE_RESULT(xrCreateAction(actionSet, &actionCreateInfo, &action), XR_SUCCESS);
+                    config.actions.back().push_back({action, actionCreateInfo.actionType});
+                }
+            }
+        }
+
+        // Bind every action on every interaction profile, rotating through the compatible input sources so the runtime
+        // sees many distinct bindings.
+        for (const InteractionProfileMetadata& ipMetadata : cInteractionProfileDefinitions) {
+            const auto ipPaths = GetInteractionProfilePaths(instance, ipMetadata);
+            std::vector<XrActionSuggestedBinding> bindings;
+            for (size_t configIndex = 0; configIndex < configs.size(); ++configIndex) {
+                for (const std::vector<BenchmarkAction>& setActions : configs[configIndex].actions) {
+                    for (size_t actionIndex = 0; actionIndex < setActions.size(); ++actionIndex) {
+                        std::vector<XrPath> candidates;
+                        for (size_t sourceIndex = 0; sourceIndex < ipMetadata.WhitelistData.size(); ++sourceIndex) {
+                            const InputSourcePathData& inputSourcePathData = ipMetadata.WhitelistData[sourceIndex];
+                            if (inputSourcePathData.Type == setActions[actionIndex].type &&
+                                IsBindingUnderTopLevelPaths(inputSourcePathData.Path, subactionPathConfigs[configIndex])) {
+                                candidates.push_back(ipPaths->InputSourcePaths[sourceIndex]);
+                            }
+                        }
+                        if (!candidates.empty()) {
+                            bindings.push_back({setActions[actionIndex].action, candidates[actionIndex % candidates.size()]});
+                        }
+                    }
+                }
+            }
+            compositionHelper.GetInteractionManager().AddActionBindings(ipPaths->InteractionProfile, bindings);
+        }
+
+        compositionHelper.BeginSession();
+
+        ActionLayerManager actionLayerManager(compositionHelper);
+        compositionHelper.GetInteractionManager().AttachActionSets();
+        actionLayerManager.WaitForSessionFocusWithMessage();
+
+        for (size_t configIndex = 0; configIndex < configs.size(); ++configIndex) {
+            const BenchmarkConfig& config = configs[configIndex];
+            // Actions without subaction paths are queried once, with XR_NULL_PATH.
+            const std::vector<XrPath> queryPaths = config.subactionPaths.empty() ? std::vector<XrPath>{XR_NULL_PATH} : config.subactionPaths;
+
+            for (uint32_t activeSetCount = 1; activeSetCount <= actionBenchmarkActionSetCount; ++activeSetCount) {
+                std::vector<XrActiveActionSet> activeActionSets;
+                for (uint32_t setIndex = 0; setIndex < activeSetCount; ++setIndex) {
+                    activeActionSets.push_back({config.actionSets[setIndex], XR_NULL_PATH});
+                }
+                XrActionsSyncInfo syncInfo{XR_TYPE_ACTIONS_SYNC_INFO};
+                syncInfo.countActiveActionSets = (uint32_t)activeActionSets.size();
+                syncInfo.activeActionSets = activeActionSets.data();
+
+                std::vector<int64_t> syncLatency;
+                std::vector<int64_t> queryLatency;
+                auto nanoseconds = [](std::chrono::steady_clock::duration duration) {
+                    return (int64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+                };
+
+                for (int frame = 0; frame < actionBenchmarkWarmupFrameCount + actionBenchmarkMeasuredFrameCount; ++frame) {
+                    actionLayerManager.GetRenderLoop().IterateFrame();
+
+                    const auto syncStart = std::chrono::steady_clock::now();
+                    const XrResult syncResult = xrSyncActions(session, &syncInfo);
+                    const auto syncStop = std::chrono::steady_clock::now();
+                    if (syncResult == XR_SESSION_NOT_FOCUSED) {
+                        // Focus was lost; wait for it to come back and retry the frame.
+                        actionLayerManager.SyncActionsUntilFocusWithMessage(syncInfo);
+                        --frame;
+                        continue;
+                    }
+                    FAST_REQUIRE_RESULT(syncResult, XR_SUCCESS);
+
+                    XrActionStateGetInfo getInfo{XR_TYPE_ACTION_STATE_GET_INFO};
+                    const auto queryStart = std::chrono::steady_clock::now();
+                    for (uint32_t setIndex = 0; setIndex < activeSetCount; ++setIndex) {
+                        for (const BenchmarkAction& benchmarkAction : config.actions[setIndex]) {
+                            getInfo.action = benchmarkAction.action;
+                            for (XrPath queryPath : queryPaths) {
+                                getInfo.subactionPath = queryPath;
+                                XrResult result = XR_ERROR_VALIDATION_FAILURE;
+                                switch (benchmarkAction.type) {
+                                case XR_ACTION_TYPE_BOOLEAN_INPUT: {
+                                    XrActionStateBoolean state{XR_TYPE_ACTION_STATE_BOOLEAN};
+                                    result = xrGetActionStateBoolean(session, &getInfo, &state);
+                                    break;
+                                }
+                                case XR_ACTION_TYPE_FLOAT_INPUT: {
+                                    XrActionStateFloat state{XR_TYPE_ACTION_STATE_FLOAT};
+                                    result = xrGetActionStateFloat(session, &getInfo, &state);
+                                    break;
+                                }
+                                case XR_ACTION_TYPE_VECTOR2F_INPUT: {
+                                    XrActionStateVector2f state{XR_TYPE_ACTION_STATE_VECTOR2F};
+                                    result = xrGetActionStateVector2f(session, &getInfo, &state);
+                                    break;
+                                }
+                                case XR_ACTION_TYPE_POSE_INPUT: {
+                                    XrActionStatePose state{XR_TYPE_ACTION_STATE_POSE};
+                                    result = xrGetActionStatePose(session, &getInfo, &state);
+                                    break;
+                                }
+                                default:
+                                    break;
+                                }
+                                FAST_REQUIRE_RESULT(result, XR_SUCCESS);
+                            }
+                        }
+                    }
+                    const auto queryStop = std::chrono::steady_clock::now();
+
+                    if (frame >= actionBenchmarkWarmupFrameCount) {
+                        syncLatency.push_back(nanoseconds(syncStop - syncStart));
+                        queryLatency.push_back(nanoseconds(queryStop - queryStart));
+                    }
+                }
+
+                const uint32_t actionCount = activeSetCount * actionBenchmarkActionsPerSet;
+                ReportF("Action system: %u actions in %u action set(s), %u subaction path(s): %u state queries per frame", actionCount,
+                        activeSetCount, (uint32_t)config.subactionPaths.size(), actionCount * (uint32_t)queryPaths.size());
+                ReportLatencyPercentiles("  xrSyncActions        :", syncLatency);
+                ReportLatencyPercentiles("  state queries (frame):", queryLatency);
+            }
+        }
+    }
+
+    namespace
+    {
+        constexpr int hapticBenchmarkWarmupFrameCount = 30;
+        constexpr int hapticBenchmarkMeasuredFrameCount = 600;
+
+        // Timings of the haptic calls made by one thread. Catch assertions are not thread-safe, so a failure is recorded and
+        // checked by the caller.
+        struct HapticCallTimings
+        {
+            XrResult failure{XR_SUCCESS};
+            const char* failedCall{nullptr};
+            uint64_t callCount{0};
+            uint64_t notFocusedCount{0};
+            LatencySamples applyLatency;
+            LatencySamples stopLatency;
+        };
+
+        // Applies a short vibration and stops it again on every subaction path.
+        void ApplyAndStopHaptics(XrSession session, XrAction action, const std::vector<XrPath>& subactionPaths, HapticCallTimings& timings)
+        {
+            using clock = MonotonicClock;
+            auto record = [&](const char* call, XrResult result, clock::duration duration, LatencySamples& latency) {
+                if (XR_FAILED(result)) {
+                    timings.failure = result;
+                    timings.failedCall = call;
+                    return false;
+                }
+                timings.callCount++;
+                if (result == XR_SESSION_NOT_FOCUSED) {
+                    timings.notFocusedCount++;
+                }
+                latency.Add(duration);
+                return true;
+            };
+
+            XrHapticVibration vibration{XR_TYPE_HAPTIC_VIBRATION};
+            vibration.amplitude = 0.5f;
+            vibration.duration = XR_MIN_HAPTIC_DURATION;
+            vibration.frequency = XR_FREQUENCY_UNSPECIFIED;
+
+            XrHapticActionInfo hapticActionInfo{XR_TYPE_HAPTIC_ACTION_INFO};
+            hapticActionInfo.action = action;
+            for (XrPath subactionPath : subactionPaths) {
+                hapticActionInfo.subactionPath = subactionPath;
+
+                clock::time_point start = clock::now();
+                XrResult result =
+                    xrApplyHapticFeedback(session, &hapticActionInfo, reinterpret_cast<const XrHapticBaseHeader*>(&vibration));
+                if (!record("xrApplyHapticFeedback", result, clock::now() - start, timings.applyLatency)) {
+                    return;
+                }
+
+                start = clock::now();
+                result = xrStopHapticFeedback(session, &hapticActionInfo);
+                if (!record("xrStopHapticFeedback", result, clock::now() - start, timings.stopLatency)) {
+                    return;
+                }
+            }
+        }
+    }  // namespace
+
+    // Measures xrApplyHapticFeedback and xrStopHapticFeedback latency and call rate on every subaction path that can
+    // have a haptic binding. The calls are made once per frame from the render thread, and free-running from a separate
+    // input thread while frames keep being submitted.
+    TEST_CASE("Haptics Latency Benchmark", "[.][benchmark]")
+    {
+        CompositionHelper compositionHelper("Haptics latency benchmark");
+        XrInstance instance = compositionHelper.GetInstance();
+        XrSession session = compositionHelper.GetSession();
+
+        const std::vector<std::string> subactionPathStrings{"/user/hand/left", "/user/hand/right", "/user/gamepad"};
+        std::vector<XrPath> subactionPaths;
+        for (const std::string& subactionPathString : subactionPathStrings) {
+            subactionPaths.push_back(StringToPath(instance, subactionPathString.c_str()));
+        }
+
+        XrActionSetCreateInfo actionSetCreateInfo{XR_TYPE_ACTION_SET_CREATE_INFO};
+        strcpy(actionSetCreateInfo.actionSetName, "haptics_benchmark");
+        strcpy(actionSetCreateInfo.localizedActionSetName, "Haptics Benchmark");
+        XrActionSet actionSet{XR_NULL_HANDLE};
+        REQUIRE_RESULT(xrCreateActionSet(instance, &actionSetCreateInfo, &actionSet), XR_SUCCESS);
+        compositionHelper.GetInteractionManager().AddActionSet(actionSet);
+
+        XrActionCreateInfo actionCreateInfo{XR_TYPE_ACTION_CREATE_INFO};
+        strcpy(actionCreateInfo.actionName, "vibrate");
+        strcpy(actionCreateInfo.localizedActionName, "Vibrate");
+        actionCreateInfo.actionType = XR_ACTION_TYPE_VIBRATION_OUTPUT;
+        actionCreateInfo.countSubactionPaths = (uint32_t)subactionPaths.size();
+        actionCreateInfo.subactionPaths = subactionPaths.data();
+        XrAction hapticAction{XR_NULL_HANDLE};
+        REQUIRE_RESULT(xrCreateAction(actionSet, &actionCreateInfo, &hapticAction), XR_SUCCESS);
+
+        // Bind the action to every haptic output of every interaction profile.
+        for (const InteractionProfileMetadata& ipMetadata : cInteractionProfileDefinitions) {
+            const auto ipPaths = GetInteractionProfilePaths(instance, ipMetadata);
+            std::vector<XrActionSuggestedBinding> bindings;
+            for (size_t sourceIndex = 0; sourceIndex < ipMetadata.WhitelistData.size(); ++sourceIndex) {
+                const InputSourcePathData& inputSourcePathData = ipMetadata.WhitelistData[sourceIndex];
+                if (inputSourcePathData.Type == XR_ACTION_TYPE_VIBRATION_OUTPUT &&
+                    IsBindingUnderTopLevelPaths(inputSourcePathData.Path, subactionPathStrings)) {
+                    bindings.push_back({hapticAction, ipPaths->InputSourcePaths[sourceIndex]});
+                }
+            }
+            if (!bindings.empty()) {
+                compositionHelper.GetInteractionManager().AddActionBindings(ipPaths->InteractionProfile, bindings);
+            }
+        }
+
+        compositionHelper.BeginSession();
+
+        ActionLayerManager actionLayerManager(compositionHelper);
+        compositionHelper.GetInteractionManager().AttachActionSets();
+        actionLayerManager.WaitForSessionFocusWithMessage();
+
+        XrActiveActionSet activeActionSet{actionSet, XR_NULL_PATH};
+        XrActionsSyncInfo syncInfo{XR_TYPE_ACTIONS_SYNC_INFO};
+        syncInfo.countActiveActionSets = 1;
+        syncInfo.activeActionSets = &activeActionSet;
+        actionLayerManager.SyncActionsUntilFocusWithMessage(syncInfo);
+
+        auto iterateFrame = [&]() {
+            actionLayerManager.GetRenderLoop().IterateFrame();
+            FAST_REQUIRE_RESULT_SUCCEEDED(xrSyncActions(session, &syncInfo));
+        };
+
+        auto report = [&](const char* label, HapticCallTimings& timings, double seconds) {
+            if (timings.failedCall != nullptr) {
+                INFO(timings.failedCall);
+                REQUIRE_RESULT_SUCCEEDED(timings.failure);
+            }
+            ReportF("Haptics, %s, %u subaction path(s): %.0f calls/s, %llu of %llu calls returned XR_SESSION_NOT_FOCUSED", label,
+                    (uint32_t)subactionPaths.size(), timings.callCount / seconds, (unsigned long long)timings.notFocusedCount,
+                    (unsigned long long)timings.callCount);
+            ReportLatencyPercentiles("  xrApplyHapticFeedback :", timings.applyLatency.nanoseconds);
+            ReportLatencyPercentiles("  xrStopHapticFeedback  :", timings.stopLatency.nanoseconds);
+        };
+
+        SECTION("Render thread")
+        {
+            HapticCallTimings warmupTimings;
+            HapticCallTimings timings;
+            for (int frame = 0; frame < hapticBenchmarkWarmupFrameCount + hapticBenchmarkMeasuredFrameCount; ++frame) {
+                iterateFrame();
+                HapticCallTimings& frameTimings = frame < hapticBenchmarkWarmupFrameCount ? warmupTimings : timings;
+                ApplyAndStopHaptics(session, hapticAction, subactionPaths, frameTimings);
+                if (warmupTimings.failedCall != nullptr || timings.failedCall != nullptr) {
+                    break;
+                }
+            }
+
+            // The calls are spread over the frames, so the rate is over the time spent in them rather than the wall time.
+            report("once per frame on the render thread", warmupTimings.failedCall != nullptr ? warmupTimings : timings,
+                   timings.applyLatency.TotalSeconds() + timings.stopLatency.TotalSeconds());
+        }
+
+        SECTION("Input thread")
+        {
+            // The input thread applies and stops haptics as fast as it can, while this thread keeps submitting frames.
+            HapticCallTimings timings;
+            const double inputSeconds =
+                RunFreeRunningCalls(hapticBenchmarkWarmupFrameCount, hapticBenchmarkMeasuredFrameCount, iterateFrame, [&]() {
+                    ApplyAndStopHaptics(session, hapticAction, subactionPaths, timings);
+                    return timings.failedCall == nullptr;
+                });
+
+            report("free-running on an input thread", timings, inputSeconds);
+        }
+    }
 }  // namespace Conformance
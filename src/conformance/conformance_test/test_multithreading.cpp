@@ -17,8 +17,13 @@
 #include "utils.h"
 #include "conformance_utils.h"
 #include "conformance_framework.h"
+#include "report.h"
+#include <algorithm>
 #include <array>
 #include <vector>
+#include <deque>
+#include <functional>
+#include <memory>
 #include <string>
 #include <thread>
 #include <condition_variable>
@@ -60,6 +65,25 @@ namespace Conformance
 
     extern const std::vector<ThreadTestFunction> globalTestFunctionVector;
 
+    // ThreadTestWorker
+    //
+    // The state owned by one worker thread of a run, so that workers neither contend with each other nor serialize on
+    // GlobalData. Failures are collected here and merged once the run has been joined.
+    //
+    struct ThreadTestWorker
+    {
+        ThreadTestWorker(uint64_t seed, uint64_t streamIndex) : randEngine(seed, streamIndex)
+        {
+            errors.reserve(16);
+        }
+
+        RandEngine randEngine;
+        std::vector<std::string> errors;
+    };
+
+    // The worker the calling thread is running the current task for, or nullptr outside of a run.
+    static thread_local ThreadTestWorker* t_threadTestWorker = nullptr;
+
     // ThreadTestEnvironment
     //
     // Defines the environment in which a multithreaded test occurs.
@@ -68,16 +92,10 @@ namespace Conformance
     {
     public:
         ThreadTestEnvironment(uint32_t invocationCountInitial)
-            : envMutex()
-            , autoBasicSession(AutoBasicSession::none)  // Do nothing yet.
+            : autoBasicSession(AutoBasicSession::none)  // Do nothing yet.
             , lastFrameTime(0)
             , hapticsAction(XR_NULL_HANDLE)
-            , shouldBegin(false)
-            , threadStartSignal()
             , invocationCount(invocationCountInitial)
-            , outputText()
-            , errorCount(0)
-            , threadVector()
             , testFunctionVector(globalTestFunctionVector)  // Just copy global one for now.
         {
             if (!GetGlobalData().IsUsingGraphicsPlugin()) {
@@ -100,50 +118,54 @@ namespace Conformance
             return autoBasicSession;
         }
 
-        void WaitToBegin()
+        uint32_t InvocationCount() const
         {
-            for (;;) {
-                std::unique_lock<std::mutex> lock(envMutex);
-                if (shouldBegin)
-                    break;
-                threadStartSignal.wait(lock);
-            }
+            return invocationCount;
         }
 
-        void SignalBegin()
+        // Replaces the workers with workerCount new ones for the next run. Each worker's engine is its own stream of
+        // the global seed (--randSeed), picked by the run and the worker index, so every worker's sequence is reproducible.
+        void PrepareWorkers(size_t workerCount)
         {
-            std::unique_lock<std::mutex> lock(envMutex);
-            shouldBegin = true;
-            threadStartSignal.notify_all();
+            const uint64_t seed = GetGlobalData().GetRandEngine().GetSeed();
+            workers.clear();
+            for (size_t i = 0; i < workerCount; ++i) {
+                workers.emplace_back(new ThreadTestWorker(seed, runIndex * 1024 + i));
+            }
+            ++runIndex;
         }
 
-        uint32_t InvocationCount() const
+        ThreadTestWorker& Worker(size_t workerIndex)
         {
-            return invocationCount;
+            return *workers[workerIndex];
         }
 
-        const std::string& OutputText() const
+        // The random engine of the worker the calling thread is running as, or the global one outside of a run.
+        RandEngine& GetRandEngine()
         {
-            return outputText;
-        }
-
-        // See AppendOutputText for text handling.
-        void AppendError(const char* text)
-        {
-            std::unique_lock<std::mutex> lock(envMutex);
-            errorCount++;
-            outputText += text;
-            outputText += '\n';
+            return t_threadTestWorker != nullptr ? t_threadTestWorker->randEngine : GetGlobalData().GetRandEngine();
         }
 
+        // Merges the errors of all workers. Only valid once the run has been joined.
         uint32_t ErrorCount() const
         {
-            return errorCount;
+            size_t count = 0;
+            for (const auto& worker : workers) {
+                count += worker->errors.size();
+            }
+            return (uint32_t)count;
         }
 
-        std::vector<std::thread>& ThreadVector()
+        std::string OutputText() const
         {
-            return threadVector;
+            std::string outputText;
+            for (const auto& worker : workers) {
+                for (const std::string& error : worker->errors) {
+                    outputText += error;
+                    outputText += '\n';
+                }
+            }
+            return outputText;
         }
 
         std::vector<ThreadTestFunction>& TestFunctionVector()
@@ -152,9 +174,6 @@ namespace Conformance
         }
 
     protected:
-        // Guards access to all the member data below.
-        std::mutex envMutex;
-
         // The instance may be XR_NULL_HANDLE if the environment is testing the case of instance not being active.
         // The session and systemId may be XR_NULL_HANDLE if the environment is testing the case of session not being active.
         AutoBasicSession autoBasicSession;
@@ -190,71 +209,290 @@ namespace Conformance
 #endif  // defined(XR_USE_GRAPHICS_API_OPENGL)
 
     protected:
-        // If true then each thread should begin executing.
-        bool shouldBegin;
-
-        // Threads should wait until this is signaled before beginning.
-        std::condition_variable threadStartSignal;
-
-        // The number of times each of the threads should invoke functions before exiting.
+        // The number of functions invoked per thread of the test.
         uint32_t invocationCount;
 
-        // Any text to be displayed upon completing the tests. Catch2 can't currently handle
-        // multithreaded testing, so we need to do the testing without Catch2 in threads, then
-        // when done print the test.
-        std::string outputText;
-
-        // The sum of errors produced by all functions from all threads.
-        std::atomic<std::uint32_t> errorCount;
-
-        // All the threads currently executing with this ThreadTestEnvironment.
-        std::vector<std::thread> threadVector;
+        // The state of each worker thread of the current run. Catch2 can't currently handle multithreaded
+        // testing, so the workers test without Catch2 and their errors are reported once the run is done.
+        std::vector<std::unique_ptr<ThreadTestWorker>> workers;
+        uint64_t runIndex{0};
 
         // Constant for the life of the ThreadTestEnvironment
         std::vector<ThreadTestFunction> testFunctionVector;
     };
 
-    // SessionThreadFunction
+    // WorkStealingPool
+    //
+    // A fixed set of worker threads, each owning a deque of tasks. A worker takes tasks from the back of its own
+    // deque and, once that runs dry, steals from the front of the others, so a thread stuck in a slow call does not
+    // hold back the tasks queued behind it.
     //
-    // Executes a single thread of a multithreading test.
-    // Works by invoking random Exercise functions a limited number of times.
-    // Returns the error count.
-    void SessionThreadFunction(ThreadTestEnvironment& env)
+    class WorkStealingPool
     {
-        RandEngine& randEngine = GetGlobalData().GetRandEngine();
+    public:
+        typedef std::function<void(size_t workerIndex)> Task;
 
-        env.WaitToBegin();
+        explicit WorkStealingPool(size_t threadCount) : queues(threadCount)
+        {
+            for (auto& queue : queues) {
+                queue.reset(new WorkerQueue);
+            }
+            for (size_t i = 0; i < threadCount; ++i) {
+                threads.emplace_back(&WorkStealingPool::WorkerLoop, this, i);
+            }
+        }
 
-        for (uint32_t i = 0; i < env.InvocationCount(); ++i) {
-            size_t functionIndex = randEngine.RandSizeT(0, env.TestFunctionVector().size());
-            const ThreadTestFunction& testFunction = env.TestFunctionVector()[functionIndex];
+        ~WorkStealingPool()
+        {
+            {
+                std::unique_lock<std::mutex> lock(stateMutex);
+                stopping = true;
+            }
+            stateSignal.notify_all();
+            for (std::thread& thread : threads) {
+                thread.join();
+            }
+        }
 
-            try {
-                if ((testFunction.callRequirement == CallRequirement::session) &&
-                    (env.GetAutoBasicSession().GetSession() != XR_NULL_HANDLE)) {
-                    testFunction.exerciseFunction(env);
-                }
-                else if ((testFunction.callRequirement == CallRequirement::systemId) &&
-                         (env.GetAutoBasicSession().GetSystemId() != XR_NULL_SYSTEM_ID)) {
-                    testFunction.exerciseFunction(env);
+        size_t ThreadCount() const
+        {
+            return threads.size();
+        }
+
+        // Queues a task on the given worker's deque. Must not be called while Run is executing.
+        void Submit(size_t workerIndex, Task task)
+        {
+            ++pendingTaskCount;
+            WorkerQueue& queue = *queues[workerIndex % queues.size()];
+            std::unique_lock<std::mutex> lock(queue.mutex);
+            queue.tasks.push_back(std::move(task));
+        }
+
+        // Releases the workers on the submitted tasks and returns once all of them have completed.
+        void Run()
+        {
+            {
+                std::unique_lock<std::mutex> lock(stateMutex);
+                ++runGeneration;
+            }
+            stateSignal.notify_all();
+
+            std::unique_lock<std::mutex> lock(stateMutex);
+            doneSignal.wait(lock, [&] { return pendingTaskCount == 0; });
+        }
+
+    protected:
+        struct WorkerQueue
+        {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        bool TakeTask(size_t workerIndex, Task& task)
+        {
+            {
+                WorkerQueue& own = *queues[workerIndex];
+                std::unique_lock<std::mutex> lock(own.mutex);
+                if (!own.tasks.empty()) {
+                    task = std::move(own.tasks.back());
+                    own.tasks.pop_back();
+                    return true;
                 }
-                else if ((testFunction.callRequirement == CallRequirement::instance) &&
-                         (env.GetAutoBasicSession().GetInstance() != XR_NULL_HANDLE)) {
-                    testFunction.exerciseFunction(env);
+            }
+            for (size_t offset = 1; offset < queues.size(); ++offset) {
+                WorkerQueue& victim = *queues[(workerIndex + offset) % queues.size()];
+                std::unique_lock<std::mutex> lock(victim.mutex);
+                if (!victim.tasks.empty()) {
+                    task = std::move(victim.tasks.front());
+                    victim.tasks.pop_front();
+                    return true;
                 }
-                else if (testFunction.callRequirement == CallRequirement::global) {
-                    testFunction.exerciseFunction(env);
+            }
+            return false;
+        }
+
+        void WorkerLoop(size_t workerIndex)
+        {
+            ATTACH_THREAD;
+            ScopedThreadScheduling scheduling(GetGlobalData().options.workerScheduling);
+            uint64_t seenGeneration = 0;
+            for (;;) {
+                {
+                    std::unique_lock<std::mutex> lock(stateMutex);
+                    stateSignal.wait(lock, [&] { return stopping || runGeneration != seenGeneration; });
+                    if (stopping) {
+                        return;
+                    }
+                    seenGeneration = runGeneration;
                 }
-                else {    // Else we can't call this function due to the environment.
-                    --i;  // Don't count it as an invocation.
+
+                // Tasks never queue further tasks, so once every deque is empty this run has nothing left for us.
+                Task task;
+                while (TakeTask(workerIndex, task)) {
+                    task(workerIndex);
+                    task = nullptr;
+                    if (--pendingTaskCount == 0) {
+                        std::unique_lock<std::mutex> lock(stateMutex);
+                        doneSignal.notify_all();
+                    }
                 }
             }
+        }
+
+        std::vector<std::unique_ptr<WorkerQueue>> queues;
+        std::vector<std::thread> threads;
+        std::atomic<size_t> pendingTaskCount{0};
+
+        // Guards runGeneration and stopping.
+        std::mutex stateMutex;
+        std::condition_variable stateSignal;
+        std::condition_variable doneSignal;
+        uint64_t runGeneration{0};
+        bool stopping{false};
+    };
+
+    // InvokeRandomFunction
+    //
+    // Invokes one random Exercise function that the environment can call as the given worker, and returns its
+    // latency in nanoseconds. Failures are recorded in the worker, as Catch2 can't be used from these threads.
+    int64_t InvokeRandomFunction(ThreadTestEnvironment& env, ThreadTestWorker& worker)
+    {
+        t_threadTestWorker = &worker;
+
+        RandEngine& randEngine = worker.randEngine;
+
+        for (;;) {
+            size_t functionIndex = randEngine.RandSizeT(0, env.TestFunctionVector().size());
+            const ThreadTestFunction& testFunction = env.TestFunctionVector()[functionIndex];
+
+            bool callable = false;
+            switch (testFunction.callRequirement) {
+            case CallRequirement::session:
+                callable = env.GetAutoBasicSession().GetSession() != XR_NULL_HANDLE;
+                break;
+            case CallRequirement::systemId:
+                callable = env.GetAutoBasicSession().GetSystemId() != XR_NULL_SYSTEM_ID;
+                break;
+            case CallRequirement::instance:
+                callable = env.GetAutoBasicSession().GetInstance() != XR_NULL_HANDLE;
+                break;
+            case CallRequirement::global:
+                callable = true;
+                break;
+            }
+            if (!callable) {
+                continue;  // We can't call this function due to the environment, so it doesn't count as an invocation.
+            }
+
+            const auto start = std::chrono::steady_clock::now();
+            try {
+                testFunction.exerciseFunction(env);
+            }
             catch (const std::exception& ex) {
-                env.AppendError(ex.what());
+                worker.errors.emplace_back(ex.what());
             }
+            const auto stop = std::chrono::steady_clock::now();
+            t_threadTestWorker = nullptr;
+            return (int64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count();
         }
     }
 
+    // RunTestEnvironment
+    //
+    // Runs InvocationCount() random invocations per thread on a work-stealing pool of the given size, appending the
+    // latency of every invocation to latencies if it is not null. Returns the wall time of the run in seconds.
+    double RunTestEnvironment(ThreadTestEnvironment& env, size_t threadCount, std::vector<int64_t>* latencies = nullptr)
+    {
+        // Each worker only appends to its own vector, so the samples need no locking.
+        std::vector<std::vector<int64_t>> workerLatencies(threadCount);
+        for (auto& samples : workerLatencies) {
+            samples.reserve(env.InvocationCount());
+        }
+
+        env.PrepareWorkers(threadCount);
+        WorkStealingPool pool(threadCount);
+        for (size_t i = 0; i < threadCount * env.InvocationCount(); ++i) {
+            pool.Submit(i, [&](size_t workerIndex) {
+                workerLatencies[workerIndex].push_back(InvokeRandomFunction(env, env.Worker(workerIndex)));
+            });
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        pool.Run();
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        REQUIRE_MSG(env.ErrorCount() == 0, env.OutputText())
+
+        if (latencies != nullptr) {
+            for (const auto& samples : workerLatencies) {
+                latencies->insert(latencies->end(), samples.begin(), samples.end());
+            }
+        }
+        return seconds;
+    }
+
+    // Creates the session state the session Exercise functions rely on and runs frames until the session is focused.
+    void InitSessionTestEnvironment(ThreadTestEnvironment& env)
+    {
+        // how long the test should wait for the app to get focus: 10 seconds in release, infinite in debug builds.
+        auto timeout = (GetGlobalData().options.debugMode ? 3600_sec : 10_sec);
+        CAPTURE(timeout);
+
+        env.GetAutoBasicSession().Init(AutoBasicSession::beginSession | AutoBasicSession::createActions | AutoBasicSession::createSpaces |
+                                       AutoBasicSession::createSwapchains);
+
+        // AutoBasicSession does not add vibrations or attach action sets
+        {
+            XrActionCreateInfo actionInfo = {XR_TYPE_ACTION_CREATE_INFO};
+            actionInfo.subactionPaths = env.GetAutoBasicSession().handSubactionArray.data();
+            actionInfo.countSubactionPaths = (uint32_t)env.GetAutoBasicSession().handSubactionArray.size();
+
+            actionInfo.actionType = XR_ACTION_TYPE_VIBRATION_OUTPUT;
+            strcpy(actionInfo.actionName, "haptics");
+            strcpy(actionInfo.localizedActionName, "haptics");
+            XRC_CHECK_THROW_XRCMD(xrCreateAction(env.GetAutoBasicSession().actionSet, &actionInfo, &env.hapticsAction));
+
+            actionInfo.actionType = XR_ACTION_TYPE_POSE_INPUT;
+            strcpy(actionInfo.actionName, "grip_pose");
+            strcpy(actionInfo.localizedActionName, "Grip pose");
+            XRC_CHECK_THROW_XRCMD(xrCreateAction(env.GetAutoBasicSession().actionSet, &actionInfo, &env.gripPoseAction));
+
+            // Ensure the actions are bound
+            XrPath interactionProfilePath = XR_NULL_PATH;
+            XRC_CHECK_THROW_XRCMD(xrStringToPath(env.GetAutoBasicSession().GetInstance(), "/interaction_profiles/khr/simple_controller",
+                                                 &interactionProfilePath));
+            XrPath gripPathL = XR_NULL_PATH;
+            XRC_CHECK_THROW_XRCMD(xrStringToPath(env.GetAutoBasicSession().GetInstance(), "/user/hand/left/input/grip/pose", &gripPathL));
+            XrPath gripPathR = XR_NULL_PATH;
+            XRC_CHECK_THROW_XRCMD(xrStringToPath(env.GetAutoBasicSession().GetInstance(), "/user/hand/right/input/grip/pose", &gripPathR));
+            XrPath hapticPathL = XR_NULL_PATH;
+            XRC_CHECK_THROW_XRCMD(xrStringToPath(env.GetAutoBasicSession().GetInstance(), "/user/hand/left/output/haptic", &hapticPathL));
+            XrPath hapticPathR = XR_NULL_PATH;
+            XRC_CHECK_THROW_XRCMD(xrStringToPath(env.GetAutoBasicSession().GetInstance(), "/user/hand/right/output/haptic", &hapticPathR));
+            std::vector<XrActionSuggestedBinding> bindings{{env.gripPoseAction, gripPathL},
+                                                           {env.gripPoseAction, gripPathR},
+                                                           {env.hapticsAction, hapticPathL},
+                                                           {env.hapticsAction, hapticPathR}};
+            XrInteractionProfileSuggestedBinding suggestedBindings = {XR_TYPE_INTERACTION_PROFILE_SUGGESTED_BINDING};
+            suggestedBindings.interactionProfile = interactionProfilePath;
+            suggestedBindings.suggestedBindings = (const XrActionSuggestedBinding*)bindings.data();
+            suggestedBindings.countSuggestedBindings = (uint32_t)bindings.size();
+            XRC_CHECK_THROW_XRCMD(xrSuggestInteractionProfileBindings(env.GetAutoBasicSession().GetInstance(), &suggestedBindings));
+
+            XrSessionActionSetsAttachInfo attachInfo{XR_TYPE_SESSION_ACTION_SETS_ATTACH_INFO};
+            attachInfo.countActionSets = 1;
+            attachInfo.actionSets = &env.GetAutoBasicSession().actionSet;
+            XRC_CHECK_THROW_XRCMD(xrAttachSessionActionSets(env.GetAutoBasicSession().session, &attachInfo));
+        }
+
+        // Get frames iterating to the point of app focused state. This will draw frames along the way.
+        FrameIterator frameIterator(&env.GetAutoBasicSession());
+        FrameIterator::RunResult runResult = frameIterator.RunToSessionState(XR_SESSION_STATE_FOCUSED, timeout);
+        REQUIRE(runResult == FrameIterator::RunResult::Success);
+
+        env.lastFrameTime = frameIterator.frameState.predictedDisplayTime;
+    }
+
     TEST_CASE("multithreading", "")
     {
         // As of May 2019, Catch2 documents that multithreaded tests must not access test primitives (e.g. REQUIRE)
@@ -267,29 +505,15 @@ namespace Conformance
         // executed within.
         //
         // See the Threading Behavior section of the OpenXR specification for documentation.
-        const size_t threadCount = 2;        // 10;         // To do: Make this configurable.
-        const size_t invocationCount = 100;  // 10000;  // To do: Make this configurable.
-
-        auto RunTestEnvironment = [threadCount](ThreadTestEnvironment& env) -> void {
-            std::vector<std::thread>& threadVector = env.ThreadVector();
-
-            for (size_t i = 0; i < threadCount; ++i)
-                threadVector.emplace_back(std::thread(SessionThreadFunction, std::ref(env)));
-
-            env.SignalBegin();
-
-            for (size_t i = 0; i < threadCount; ++i)
-                threadVector[i].join();
-
-            REQUIRE_MSG(env.ErrorCount() == 0, env.OutputText())
-        };
+        const size_t threadCount = 2;        // 10;
+        const size_t invocationCount = 100;  // 10000;
 
         // Exercise instanceless multithreading
         {
             // Leave instance and session NULL.
             ThreadTestEnvironment env(invocationCount);
 
-            RunTestEnvironment(env);
+            RunTestEnvironment(env, threadCount);
         }
 
         // Exercise instance without session multithreading
@@ -297,79 +521,69 @@ namespace Conformance
             ThreadTestEnvironment env(invocationCount);
             env.GetAutoBasicSession().Init(AutoBasicSession::createInstance);
 
-            RunTestEnvironment(env);
+            RunTestEnvironment(env, threadCount);
         }
 
         // Exercise session multithreading.
         {
-            // how long the test should wait for the app to get focus: 10 seconds in release, infinite in debug builds.
-            auto timeout = (GetGlobalData().options.debugMode ? 3600_sec : 10_sec);
-            CAPTURE(timeout);
-
             ThreadTestEnvironment env(invocationCount);
-            env.GetAutoBasicSession().Init(AutoBasicSession::beginSession | AutoBasicSession::createActions |
-                                           AutoBasicSession::createSpaces | AutoBasicSession::createSwapchains);
+            InitSessionTestEnvironment(env);
 
-            // AutoBasicSession does not add vibrations or attach action sets
-            {
-                XrActionCreateInfo actionInfo = {XR_TYPE_ACTION_CREATE_INFO};
-                actionInfo.subactionPaths = env.GetAutoBasicSession().handSubactionArray.data();
-                actionInfo.countSubactionPaths = (uint32_t)env.GetAutoBasicSession().handSubactionArray.size();
-
-                actionInfo.actionType = XR_ACTION_TYPE_VIBRATION_OUTPUT;
-                strcpy(actionInfo.actionName, "haptics");
-                strcpy(actionInfo.localizedActionName, "haptics");
-                XRC_CHECK_THROW_XRCMD(xrCreateAction(env.GetAutoBasicSession().actionSet, &actionInfo, &env.hapticsAction));
-
-                actionInfo.actionType = XR_ACTION_TYPE_POSE_INPUT;
-                strcpy(actionInfo.actionName, "grip_pose");
-                strcpy(actionInfo.localizedActionName, "Grip pose");
-                XRC_CHECK_THROW_XRCMD(xrCreateAction(env.GetAutoBasicSession().actionSet, &actionInfo, &env.gripPoseAction));
-
-                // Ensure the actions are bound
-                XrPath interactionProfilePath = XR_NULL_PATH;
-                XRC_CHECK_THROW_XRCMD(xrStringToPath(env.GetAutoBasicSession().GetInstance(), "/interaction_profiles/khr/simple_controller",
-                                                     &interactionProfilePath));
-                XrPath gripPathL = XR_NULL_PATH;
-                XRC_CHECK_THROW_XRCMD(
-                    xrStringToPath(env.GetAutoBasicSession().GetInstance(), "/user/hand/left/input/grip/pose", &gripPathL));
-                XrPath gripPathR = XR_NULL_PATH;
-                XRC_CHECK_THROW_XRCMD(
-                    xrStringToPath(env.GetAutoBasicSession().GetInstance(), "/user/hand/right/input/grip/pose", &gripPathR));
-                XrPath hapticPathL = XR_NULL_PATH;
-                XRC_CHECK_THROW_XRCMD(
-                    xrStringToPath(env.GetAutoBasicSession().GetInstance(), "/user/hand/left/output/haptic", &hapticPathL));
-                XrPath hapticPathR = XR_NULL_PATH;
-                XRC_CHECK_THROW_XRCMD(
-                    xrStringToPath(env.GetAutoBasicSession().GetInstance(), "/user/hand/right/output/haptic", &hapticPathR));
-                std::vector<XrActionSuggestedBinding> bindings{{env.gripPoseAction, gripPathL},
-                                                               {env.gripPoseAction, gripPathR},
-                                                               {env.hapticsAction, hapticPathL},
-                                                               {env.hapticsAction, hapticPathR}};
-                XrInteractionProfileSuggestedBinding suggestedBindings = {XR_TYPE_INTERACTION_PROFILE_SUGGESTED_BINDING};
-                suggestedBindings.interactionProfile = interactionProfilePath;
-                suggestedBindings.suggestedBindings = (const XrActionSuggestedBinding*)bindings.data();
-                suggestedBindings.countSuggestedBindings = (uint32_t)bindings.size();
-                XRC_CHECK_THROW_XRCMD(xrSuggestInteractionProfileBindings(env.GetAutoBasicSession().GetInstance(), &suggestedBindings));
-
-                XrSessionActionSetsAttachInfo attachInfo{XR_TYPE_SESSION_ACTION_SETS_ATTACH_INFO};
-                attachInfo.countActionSets = 1;
-                attachInfo.actionSets = &env.GetAutoBasicSession().actionSet;
-                XRC_CHECK_THROW_XRCMD(xrAttachSessionActionSets(env.GetAutoBasicSession().session, &attachInfo));
-            }
+            GlobalData& globalData = GetGlobalData();
+            globalData.GetGraphicsPlugin()->MakeCurrent(false);
 
-            // Get frames iterating to the point of app focused state. This will draw frames along the way.
-            FrameIterator frameIterator(&env.GetAutoBasicSession());
-            FrameIterator::RunResult runResult = frameIterator.RunToSessionState(XR_SESSION_STATE_FOCUSED, timeout);
-            REQUIRE(runResult == FrameIterator::RunResult::Success);
+            RunTestEnvironment(env, threadCount);
 
-            env.lastFrameTime = frameIterator.frameState.predictedDisplayTime;
+            globalData.GetGraphicsPlugin()->MakeCurrent(true);
+        }
+    }
 
-            GlobalData& globalData = GetGlobalData();
-            globalData.GetGraphicsPlugin()->MakeCurrent(false);
+    // Runs the same random invocations as the multithreading test on one thread and then on doubling thread counts up
+    // to --multithreadingMaxThreads (default: the hardware concurrency), and reports invocations per second and
+    // per-invocation latency for each.
+    TEST_CASE("multithreading benchmark", "[.][benchmark]")
+    {
+        GlobalData& globalData = GetGlobalData();
+        const size_t invocationCount = 1000;
+
+        const uint32_t hardwareThreadCount = std::max(1u, std::thread::hardware_concurrency());
+        uint32_t maxThreadCount = hardwareThreadCount;
+        if (globalData.options.multithreadingMaxThreads != 0) {
+            maxThreadCount = std::min(globalData.options.multithreadingMaxThreads, hardwareThreadCount);
+        }
+        std::vector<size_t> threadCounts;
+        for (uint32_t count = 1; count < maxThreadCount; count *= 2) {
+            threadCounts.push_back(count);
+        }
+        threadCounts.push_back(maxThreadCount);
+
+        auto RunScaling = [&](const char* environmentName, ThreadTestEnvironment& env) {
+            for (size_t threadCount : threadCounts) {
+                std::vector<int64_t> latencies;
+                const double seconds = RunTestEnvironment(env, threadCount, &latencies);
+                ReportF("Multithreading (%s): %u thread(s): %.0f invocations/s", environmentName, (uint32_t)threadCount,
+                        latencies.size() / seconds);
+                ReportLatencyPercentiles("  invocation :", latencies);
+            }
+        };
+
+        {
+            ThreadTestEnvironment env(invocationCount);
+            RunScaling("no instance", env);
+        }
 
-            RunTestEnvironment(env);
+        {
+            ThreadTestEnvironment env(invocationCount);
+            env.GetAutoBasicSession().Init(AutoBasicSession::createInstance);
+            RunScaling("instance", env);
+        }
 
+        {
+            ThreadTestEnvironment env(invocationCount);
+            InitSessionTestEnvironment(env);
+
+            globalData.GetGraphicsPlugin()->MakeCurrent(false);
+            RunScaling("session", env);
             globalData.GetGraphicsPlugin()->MakeCurrent(true);
         }
     }
@@ -435,7 +649,7 @@ namespace Conformance
     void Exercise_xrResultToString(ThreadTestEnvironment& env)
     {
         char buffer[XR_MAX_RESULT_STRING_SIZE];
-        RandEngine& randEngine = GetGlobalData().GetRandEngine();
+        RandEngine& randEngine = env.GetRandEngine();
         XrResult value = (XrResult)randEngine.RandInt32(-45, 9);  // Need a better way to id the min/max values,
         XRC_CHECK_THROW_XRCMD(xrResultToString(env.GetAutoBasicSession().GetInstance(), value, buffer));  // but this can be inaccurate.
     }
@@ -443,7 +657,7 @@ namespace Conformance
     void Exercise_xrStructureTypeToString(ThreadTestEnvironment& env)
     {
         char buffer[XR_MAX_STRUCTURE_NAME_SIZE];
-        RandEngine& randEngine = GetGlobalData().GetRandEngine();
+        RandEngine& randEngine = env.GetRandEngine();
         XrStructureType value = (XrStructureType)randEngine.RandInt32(0, 57);  // Need a better way to id the min/max values,
         XRC_CHECK_THROW_XRCMD(xrStructureTypeToString(env.GetAutoBasicSession().GetInstance(), value,
                                                       buffer));  // but this can be inaccurate.
@@ -537,7 +751,7 @@ namespace Conformance
     {
         std::array<XrPath, 2>& handSubactionArray = env.GetAutoBasicSession().handSubactionArray;
 
-        RandEngine& randEngine = GetGlobalData().GetRandEngine();
+        RandEngine& randEngine = env.GetRandEngine();
         size_t a = randEngine.RandSizeT(0, handSubactionArray.size());
 
         XrActionSpaceCreateInfo actionSpaceCreateInfo{XR_TYPE_ACTION_SPACE_CREATE_INFO};
@@ -555,7 +769,7 @@ namespace Conformance
 
     void Exercise_xrLocateSpace(ThreadTestEnvironment& env)
     {
-        RandEngine& randEngine = GetGlobalData().GetRandEngine();
+        RandEngine& randEngine = env.GetRandEngine();
         auto spaces = env.GetAutoBasicSession().spaceVector;
 
         const size_t iterationCount = 100;  // To do: Make this configurable.
@@ -730,7 +944,7 @@ namespace Conformance
 
     void Exercise_xrStringToPath(ThreadTestEnvironment& env)
     {
-        RandEngine& randEngine = GetGlobalData().GetRandEngine();
+        RandEngine& randEngine = env.GetRandEngine();
 
         const size_t iterationCount = 100;  // To do: Make this configurable.
         std::vector<std::pair<XrPath, std::string>> strVector;
@@ -838,7 +1052,7 @@ namespace Conformance
 
     void Exercise_xrSyncActions(ThreadTestEnvironment& env)
     {
-        RandEngine& randEngine = GetGlobalData().GetRandEngine();
+        RandEngine& randEngine = env.GetRandEngine();
 
         // References to AutoBasicSession members.
         XrSession& session = env.GetAutoBasicSession().session;
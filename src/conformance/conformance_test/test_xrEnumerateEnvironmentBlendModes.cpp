@@ -40,7 +40,7 @@ namespace Conformance
     {
         GlobalData& globalData = GetGlobalData();
 
-        AutoBasicInstance instance(AutoBasicInstance::createSystemId);
+        AutoBasicInstance instance(AutoBasicInstance::createSystemId | AutoBasicInstance::allowPooled);
 
         // Exercise all known view configurations types and ensure unsupported types fail.
         {
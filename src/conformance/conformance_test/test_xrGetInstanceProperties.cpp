@@ -32,7 +32,7 @@ namespace Conformance
     {
         // XrResult xrGetInstanceProperties(XrInstance instance, XrInstanceProperties* instanceProperties);
 
-        AutoBasicInstance instance;
+        AutoBasicInstance instance(AutoBasicInstance::allowPooled);
 
         XrInstanceProperties instanceProperties{XR_TYPE_INSTANCE_PROPERTIES};
         XrResult result;
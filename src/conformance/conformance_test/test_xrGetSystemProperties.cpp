@@ -32,7 +32,7 @@ namespace Conformance
     {
         auto &globalData = GetGlobalData();
 
-        AutoBasicInstance instance;
+        AutoBasicInstance instance(AutoBasicInstance::allowPooled);
 
         XrSystemProperties systemProperties{XR_TYPE_SYSTEM_PROPERTIES};
 
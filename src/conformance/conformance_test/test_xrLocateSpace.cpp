@@ -17,7 +17,14 @@
 #include "conformance_utils.h"
 #include "conformance_framework.h"
 #include "two_call.h"
+#include "report.h"
+#include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <cstring>
+#include <functional>
+#include <thread>
+#include <vector>
 #include <catch2/catch.hpp>
 #include <openxr/openxr.h>
 
@@ -228,4 +235,355 @@ namespace Conformance
         runResult = frameIterator.RunToSessionState(XR_SESSION_STATE_STOPPING, timeout);
         CHECK(runResult == FrameIterator::RunResult::Success);
     }
+
+    namespace
+    {
+        constexpr uint32_t locateBenchmarkReferenceSpaceCount = 256;
+        constexpr uint32_t locateBenchmarkActionSpaceCount = 64;
+        constexpr int locateBenchmarkTimeCount = 100;
+        constexpr XrDuration locateBenchmarkTimeStep = 1000000;  // 1ms
+        constexpr int locateBenchmarkViewTimeCount = 1000;
+
+        // Timings of the xrLocateSpace calls made by one thread.
+        struct SpaceLocateTimings
+        {
+            XrResult failure{XR_SUCCESS};
+            std::vector<int64_t> latency;
+        };
+
+        // Locates spaces[begin, end) against baseSpace at every benchmark time, starting at startTime. Catch
+        // assertions are not thread-safe, so a failure is recorded and checked by the caller after the threads
+        // have been joined.
+        void LocateSpacesOverTime(const std::vector<XrSpace>& spaces, size_t begin, size_t end, XrSpace baseSpace, XrTime startTime,
+                                  SpaceLocateTimings& timings)
+        {
+            using clock = MonotonicClock;
+            timings.latency.reserve((end - begin) * locateBenchmarkTimeCount);
+
+            for (int timeIndex = 0; timeIndex < locateBenchmarkTimeCount; ++timeIndex) {
+                const XrTime time = startTime + timeIndex * locateBenchmarkTimeStep;
+                for (size_t i = begin; i < end; ++i) {
+                    XrSpaceLocation location{XR_TYPE_SPACE_LOCATION};
+                    const clock::time_point start = clock::now();
+                    const XrResult result = xrLocateSpace(spaces[i], baseSpace, time, &location);
+                    const clock::time_point stop = clock::now();
+                    if (result != XR_SUCCESS) {
+                        timings.failure = result;
+                        return;
+                    }
+                    timings.latency.push_back((int64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count());
+                }
+            }
+        }
+        // Creates an action set with a pose action on both hands, bound to the grip of the simple controller, and
+        // attaches it to the session.
+        void CreateBenchmarkPoseAction(AutoBasicSession& session, const char* actionSetName, XrPath (&handPaths)[2], XrActionSet* actionSet,
+                                       XrAction* poseAction)
+        {
+            REQUIRE_RESULT_UNQUALIFIED_SUCCESS(xrStringToPath(session.instance, "/user/hand/left", &handPaths[0]));
+            REQUIRE_RESULT_UNQUALIFIED_SUCCESS(xrStringToPath(session.instance, "/user/hand/right", &handPaths[1]));
+
+            XrActionSetCreateInfo actionSetCreateInfo{XR_TYPE_ACTION_SET_CREATE_INFO};
+            strcpy(actionSetCreateInfo.actionSetName, actionSetName);
+            strcpy(actionSetCreateInfo.localizedActionSetName, actionSetName);
+            REQUIRE_RESULT_UNQUALIFIED_SUCCESS(xrCreateActionSet(session.instance, &actionSetCreateInfo, actionSet));
+
+            XrActionCreateInfo actionCreateInfo{XR_TYPE_ACTION_CREATE_INFO};
+            strcpy(actionCreateInfo.actionName, "grip_pose");
+            strcpy(actionCreateInfo.localizedActionName, "Grip Pose");
+            actionCreateInfo.actionType = XR_ACTION_TYPE_POSE_INPUT;
+            actionCreateInfo.countSubactionPaths = 2;
+            actionCreateInfo.subactionPaths = handPaths;
+            REQUIRE_RESULT_UNQUALIFIED_SUCCESS(xrCreateAction(*actionSet, &actionCreateInfo, poseAction));
+
+            XrPath simpleControllerPath;
+            REQUIRE_RESULT_UNQUALIFIED_SUCCESS(
+                xrStringToPath(session.instance, "/interaction_profiles/khr/simple_controller", &simpleControllerPath));
+            XrActionSuggestedBinding suggestedBindings[2]{{*poseAction}, {*poseAction}};
+            REQUIRE_RESULT_UNQUALIFIED_SUCCESS(
+                xrStringToPath(session.instance, "/user/hand/left/input/grip/pose", &suggestedBindings[0].binding));
+            REQUIRE_RESULT_UNQUALIFIED_SUCCESS(
+                xrStringToPath(session.instance, "/user/hand/right/input/grip/pose", &suggestedBindings[1].binding));
+            XrInteractionProfileSuggestedBinding profileBindings{XR_TYPE_INTERACTION_PROFILE_SUGGESTED_BINDING};
+            profileBindings.interactionProfile = simpleControllerPath;
+            profileBindings.countSuggestedBindings = 2;
+            profileBindings.suggestedBindings = suggestedBindings;
+            REQUIRE_RESULT_UNQUALIFIED_SUCCESS(xrSuggestInteractionProfileBindings(session.instance, &profileBindings));
+
+            XrSessionActionSetsAttachInfo attachInfo{XR_TYPE_SESSION_ACTION_SETS_ATTACH_INFO};
+            attachInfo.countActionSets = 1;
+            attachInfo.actionSets = actionSet;
+            REQUIRE_RESULT_UNQUALIFIED_SUCCESS(xrAttachSessionActionSets(session, &attachInfo));
+        }
+    }  // namespace
+
+    // Measures xrLocateSpace throughput and latency for hundreds of reference and action spaces located against a LOCAL
+    // base space over a range of times, on this thread and fanned out over several threads, as well as xrLocateViews
+    // over a range of times.
+    TEST_CASE("Space Location Benchmark", "[.][benchmark]")
+    {
+        GlobalData& globalData = GetGlobalData();
+
+        // how long the test should wait for the app to get focus: 10 seconds in release, infinite in debug builds.
+        auto timeout = (globalData.options.debugMode ? 3600_sec : 10_sec);
+        CAPTURE(timeout);
+
+        AutoBasicSession session(AutoBasicSession::createInstance | AutoBasicSession::createSession | AutoBasicSession::beginSession |
+                                 AutoBasicSession::createSwapchains | AutoBasicSession::createSpaces);
+
+        // A pose action on both hands provides the action spaces.
+        XrPath handPaths[2];
+        XrActionSet actionSet{XR_NULL_HANDLE_CPP};
+        XrAction poseAction{XR_NULL_HANDLE_CPP};
+        CreateBenchmarkPoseAction(session, "locate_benchmark", handPaths, &actionSet, &poseAction);
+
+        // Spread the spaces over every supported reference space type and both hands, each with its own offset so
+        // runtimes cannot share a single result.
+        std::vector<XrSpace> spaces;
+        auto benchmarkPose = [](uint32_t i) {
+            XrPosef pose = XrPosefCPP();
+            pose.position = {0.01f * (i % 10), 0.01f * ((i / 10) % 10), -0.01f * (i / 100)};
+            return pose;
+        };
+        for (uint32_t i = 0; i < locateBenchmarkReferenceSpaceCount; ++i) {
+            XrReferenceSpaceCreateInfo spaceCreateInfo{XR_TYPE_REFERENCE_SPACE_CREATE_INFO};
+            spaceCreateInfo.referenceSpaceType = session.spaceTypeVector[i % session.spaceTypeVector.size()];
+            spaceCreateInfo.poseInReferenceSpace = benchmarkPose(i);
+            XrSpace space;
+            FAST_REQUIRE_RESULT_UNQUALIFIED_SUCCESS(xrCreateReferenceSpace(session, &spaceCreateInfo, &space));
+            spaces.push_back(space);
+        }
+        for (uint32_t i = 0; i < locateBenchmarkActionSpaceCount; ++i) {
+            XrActionSpaceCreateInfo spaceCreateInfo{XR_TYPE_ACTION_SPACE_CREATE_INFO};
+            spaceCreateInfo.action = poseAction;
+            spaceCreateInfo.subactionPath = handPaths[i % 2];
+            spaceCreateInfo.poseInActionSpace = benchmarkPose(i);
+            XrSpace space;
+            FAST_REQUIRE_RESULT_UNQUALIFIED_SUCCESS(xrCreateActionSpace(session, &spaceCreateInfo, &space));
+            spaces.push_back(space);
+        }
+
+        XrReferenceSpaceCreateInfo baseSpaceCreateInfo{XR_TYPE_REFERENCE_SPACE_CREATE_INFO};
+        baseSpaceCreateInfo.referenceSpaceType = XR_REFERENCE_SPACE_TYPE_LOCAL;
+        baseSpaceCreateInfo.poseInReferenceSpace = XrPosefCPP();
+        XrSpace baseSpace;
+        REQUIRE_RESULT_UNQUALIFIED_SUCCESS(xrCreateReferenceSpace(session, &baseSpaceCreateInfo, &baseSpace));
+
+        // Get frames iterating to the point of app focused state, then render one frame to get a predicted
+        // display time to locate around.
+        FrameIterator frameIterator(&session);
+        FrameIterator::RunResult runResult = frameIterator.RunToSessionState(XR_SESSION_STATE_FOCUSED, timeout);
+        REQUIRE(runResult == FrameIterator::RunResult::Success);
+        runResult = frameIterator.SubmitFrame();
+        REQUIRE(runResult == FrameIterator::RunResult::Success);
+        const XrTime startTime = frameIterator.frameState.predictedDisplayTime;
+
+        // Sync once so the action spaces are backed by an active action, if the runtime has a controller.
+        XrActiveActionSet activeActionSet{actionSet, XR_NULL_PATH};
+        XrActionsSyncInfo syncInfo{XR_TYPE_ACTIONS_SYNC_INFO};
+        syncInfo.countActiveActionSets = 1;
+        syncInfo.activeActionSets = &activeActionSet;
+        REQUIRE_RESULT_SUCCEEDED(xrSyncActions(session, &syncInfo));
+
+        std::vector<uint32_t> threadCounts{1};
+        const uint32_t maxThreadCount = std::min(8u, std::max(1u, std::thread::hardware_concurrency()));
+        for (uint32_t count = 2; count <= maxThreadCount; count *= 2) {
+            threadCounts.push_back(count);
+        }
+
+        for (uint32_t threadCount : threadCounts) {
+            // Each thread locates its own contiguous slice of the spaces.
+            std::vector<SpaceLocateTimings> timings(threadCount);
+            auto sliceBegin = [&](uint32_t thread) { return spaces.size() * thread / threadCount; };
+
+            const auto start = MonotonicClock::now();
+            std::vector<std::thread> threads;
+            for (uint32_t i = 1; i < threadCount; ++i) {
+                threads.emplace_back(LocateSpacesOverTime, std::cref(spaces), sliceBegin(i), sliceBegin(i + 1), baseSpace, startTime,
+                                     std::ref(timings[i]));
+            }
+            LocateSpacesOverTime(spaces, sliceBegin(0), sliceBegin(1), baseSpace, startTime, timings[0]);
+            for (std::thread& thread : threads) {
+                thread.join();
+            }
+            const double seconds = std::chrono::duration<double>(MonotonicClock::now() - start).count();
+
+            std::vector<int64_t> latency;
+            for (SpaceLocateTimings& threadTimings : timings) {
+                REQUIRE_RESULT_UNQUALIFIED_SUCCESS(threadTimings.failure);
+                latency.insert(latency.end(), threadTimings.latency.begin(), threadTimings.latency.end());
+            }
+
+            ReportF("Space location: %u spaces x %d times, %u thread(s): %.0f locates/s", (uint32_t)spaces.size(), locateBenchmarkTimeCount,
+                    threadCount, latency.size() / seconds);
+            ReportLatencyPercentiles("  xrLocateSpace :", latency);
+        }
+
+        {
+            XrViewLocateInfo viewLocateInfo{XR_TYPE_VIEW_LOCATE_INFO};
+            viewLocateInfo.viewConfigurationType = globalData.options.viewConfigurationValue;
+            viewLocateInfo.space = baseSpace;
+            std::vector<XrView> views(session.viewConfigurationViewVector.size(), {XR_TYPE_VIEW});
+
+            std::vector<int64_t> latency;
+            latency.reserve(locateBenchmarkViewTimeCount);
+            const auto start = MonotonicClock::now();
+            for (int timeIndex = 0; timeIndex < locateBenchmarkViewTimeCount; ++timeIndex) {
+                viewLocateInfo.displayTime = startTime + (timeIndex % locateBenchmarkTimeCount) * locateBenchmarkTimeStep;
+                XrViewState viewState{XR_TYPE_VIEW_STATE};
+                uint32_t viewCount = (uint32_t)views.size();
+                const auto callStart = MonotonicClock::now();
+                const XrResult result = xrLocateViews(session, &viewLocateInfo, &viewState, viewCount, &viewCount, views.data());
+                const auto callStop = MonotonicClock::now();
+                FAST_REQUIRE_RESULT_UNQUALIFIED_SUCCESS(result);
+                latency.push_back((int64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(callStop - callStart).count());
+            }
+            const double seconds = std::chrono::duration<double>(MonotonicClock::now() - start).count();
+
+            ReportF("View location: %u views x %d calls: %.0f locates/s", (uint32_t)views.size(), locateBenchmarkViewTimeCount,
+                    locateBenchmarkViewTimeCount / seconds);
+            ReportLatencyPercentiles("  xrLocateViews :", latency);
+        }
+
+        for (XrSpace space : spaces) {
+            FAST_REQUIRE_RESULT_UNQUALIFIED_SUCCESS(xrDestroySpace(space));
+        }
+        REQUIRE_RESULT_UNQUALIFIED_SUCCESS(xrDestroySpace(baseSpace));
+        REQUIRE_RESULT_UNQUALIFIED_SUCCESS(xrDestroyActionSet(actionSet));
+    }
+
+    namespace
+    {
+        constexpr uint32_t spaceScalingCounts[] = {256, 1024, 4096};
+        constexpr uint32_t spaceScalingActionSpaceFraction = 4;  // One in this many of the live spaces is an action space.
+        constexpr uint32_t spaceScalingProbeSpaceCount = 64;     // The same spaces are located at every live space count.
+        constexpr int spaceScalingLocateTimeCount = 20;
+
+        // Returns a pose within a metre of the origin with a random orientation. RandEngine only provides integers,
+        // so they are scaled to the wanted range.
+        XrPosef RandomBenchmarkPose(RandEngine& randEngine)
+        {
+            auto randFloat = [&](float min, float max) { return min + (max - min) * randEngine.RandInt32(0, 1 << 20) / float(1 << 20); };
+
+            XrPosef pose;
+            pose.position = {randFloat(-1, 1), randFloat(-1, 1), randFloat(-1, 1)};
+            XrQuaternionf& q = pose.orientation;
+            q = {randFloat(-1, 1), randFloat(-1, 1), randFloat(-1, 1), randFloat(-1, 1)};
+            float length = std::sqrt(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+            if (length < 1e-3f) {
+                return XrPosefCPP();
+            }
+            q = {q.x / length, q.y / length, q.z / length, q.w / length};
+            return pose;
+        }
+    }  // namespace
+
+    // Creates thousands of reference spaces with random poses and action spaces on both hands, timing
+    // xrCreateReferenceSpace, xrCreateActionSpace and xrDestroySpace, and times xrLocateSpace on a fixed set of spaces
+    // at each live space count to show whether the cost of locating grows with the number of spaces the runtime is
+    // tracking.
+    TEST_CASE("Space Creation Scaling Benchmark", "[.][benchmark]")
+    {
+        GlobalData& globalData = GetGlobalData();
+        // A stream of its own keeps the poses the same whichever tests ran before.
+        RandEngine randEngine(globalData.GetRandEngine().GetSeed(), RandEngine::StreamIndexFromName("Space Creation Scaling Benchmark"));
+
+        // how long the test should wait for the app to get focus: 10 seconds in release, infinite in debug builds.
+        auto timeout = (globalData.options.debugMode ? 3600_sec : 10_sec);
+        CAPTURE(timeout);
+
+        AutoBasicSession session(AutoBasicSession::createInstance | AutoBasicSession::createSession | AutoBasicSession::beginSession |
+                                 AutoBasicSession::createSwapchains | AutoBasicSession::createSpaces);
+
+        XrPath handPaths[2];
+        XrActionSet actionSet{XR_NULL_HANDLE_CPP};
+        XrAction poseAction{XR_NULL_HANDLE_CPP};
+        CreateBenchmarkPoseAction(session, "space_scaling_benchmark", handPaths, &actionSet, &poseAction);
+
+        XrReferenceSpaceCreateInfo baseSpaceCreateInfo{XR_TYPE_REFERENCE_SPACE_CREATE_INFO};
+        baseSpaceCreateInfo.referenceSpaceType = XR_REFERENCE_SPACE_TYPE_LOCAL;
+        baseSpaceCreateInfo.poseInReferenceSpace = XrPosefCPP();
+        XrSpace baseSpace;
+        REQUIRE_RESULT_UNQUALIFIED_SUCCESS(xrCreateReferenceSpace(session, &baseSpaceCreateInfo, &baseSpace));
+
+        FrameIterator frameIterator(&session);
+        FrameIterator::RunResult runResult = frameIterator.RunToSessionState(XR_SESSION_STATE_FOCUSED, timeout);
+        REQUIRE(runResult == FrameIterator::RunResult::Success);
+        runResult = frameIterator.SubmitFrame();
+        REQUIRE(runResult == FrameIterator::RunResult::Success);
+        const XrTime startTime = frameIterator.frameState.predictedDisplayTime;
+
+        XrActiveActionSet activeActionSet{actionSet, XR_NULL_PATH};
+        XrActionsSyncInfo syncInfo{XR_TYPE_ACTIONS_SYNC_INFO};
+        syncInfo.countActiveActionSets = 1;
+        syncInfo.activeActionSets = &activeActionSet;
+        REQUIRE_RESULT_SUCCEEDED(xrSyncActions(session, &syncInfo));
+
+        using clock = MonotonicClock;
+        auto nanoseconds = [](clock::duration duration) {
+            return (int64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+        };
+
+        for (uint32_t spaceCount : spaceScalingCounts) {
+            std::vector<int64_t> createReferenceLatency, createActionLatency, locateLatency, destroyLatency;
+            std::vector<XrSpace> spaces;
+            spaces.reserve(spaceCount);
+
+            for (uint32_t i = 0; i < spaceCount; ++i) {
+                XrSpace space;
+                if (i % spaceScalingActionSpaceFraction == spaceScalingActionSpaceFraction - 1) {
+                    XrActionSpaceCreateInfo spaceCreateInfo{XR_TYPE_ACTION_SPACE_CREATE_INFO};
+                    spaceCreateInfo.action = poseAction;
+                    spaceCreateInfo.subactionPath = handPaths[(i / spaceScalingActionSpaceFraction) % 2];
+                    spaceCreateInfo.poseInActionSpace = RandomBenchmarkPose(randEngine);
+                    const clock::time_point start = clock::now();
+                    const XrResult result = xrCreateActionSpace(session, &spaceCreateInfo, &space);
+                    createActionLatency.push_back(nanoseconds(clock::now() - start));
+                    FAST_REQUIRE_RESULT_UNQUALIFIED_SUCCESS(result);
+                }
+                else {
+                    XrReferenceSpaceCreateInfo spaceCreateInfo{XR_TYPE_REFERENCE_SPACE_CREATE_INFO};
+                    spaceCreateInfo.referenceSpaceType = session.spaceTypeVector[i % session.spaceTypeVector.size()];
+                    spaceCreateInfo.poseInReferenceSpace = RandomBenchmarkPose(randEngine);
+                    const clock::time_point start = clock::now();
+                    const XrResult result = xrCreateReferenceSpace(session, &spaceCreateInfo, &space);
+                    createReferenceLatency.push_back(nanoseconds(clock::now() - start));
+                    FAST_REQUIRE_RESULT_UNQUALIFIED_SUCCESS(result);
+                }
+                spaces.push_back(space);
+            }
+
+            // Locate the same leading spaces at every count, so only the number of other live spaces changes.
+            const uint32_t probeCount = std::min(spaceScalingProbeSpaceCount, spaceCount);
+            locateLatency.reserve(probeCount * spaceScalingLocateTimeCount);
+            for (int timeIndex = 0; timeIndex < spaceScalingLocateTimeCount; ++timeIndex) {
+                const XrTime time = startTime + timeIndex * locateBenchmarkTimeStep;
+                for (uint32_t i = 0; i < probeCount; ++i) {
+                    XrSpaceLocation location{XR_TYPE_SPACE_LOCATION};
+                    const clock::time_point start = clock::now();
+                    const XrResult result = xrLocateSpace(spaces[i], baseSpace, time, &location);
+                    locateLatency.push_back(nanoseconds(clock::now() - start));
+                    FAST_REQUIRE_RESULT_UNQUALIFIED_SUCCESS(result);
+                }
+            }
+
+            destroyLatency.reserve(spaces.size());
+            for (XrSpace space : spaces) {
+                const clock::time_point start = clock::now();
+                const XrResult result = xrDestroySpace(space);
+                destroyLatency.push_back(nanoseconds(clock::now() - start));
+                FAST_REQUIRE_RESULT_UNQUALIFIED_SUCCESS(result);
+            }
+
+            ReportF("Space scaling: %u live spaces (%u reference, %u action), %u located x %d times:", spaceCount,
+                    (uint32_t)createReferenceLatency.size(), (uint32_t)createActionLatency.size(), probeCount, spaceScalingLocateTimeCount);
+            ReportLatencyPercentiles("  xrCreateReferenceSpace :", createReferenceLatency);
+            ReportLatencyPercentiles("  xrCreateActionSpace    :", createActionLatency);
+            ReportLatencyPercentiles("  xrLocateSpace          :", locateLatency);
+            ReportLatencyPercentiles("  xrDestroySpace         :", destroyLatency);
+        }
+
+        REQUIRE_RESULT_UNQUALIFIED_SUCCESS(xrDestroySpace(baseSpace));
+        REQUIRE_RESULT_UNQUALIFIED_SUCCESS(xrDestroyActionSet(actionSet));
+    }
 }  // namespace Conformance
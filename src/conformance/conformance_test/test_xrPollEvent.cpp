@@ -17,7 +17,10 @@
 #include "utils.h"
 #include "conformance_utils.h"
 #include "conformance_framework.h"
+#include "report.h"
 #include <array>
+#include <chrono>
+#include <thread>
 #include <vector>
 #include <set>
 #include <string>
@@ -207,4 +210,155 @@ namespace Conformance
             }
         }
     }
+
+    namespace
+    {
+        constexpr uint32_t eventStormSessionCounts[] = {16, 64, 256};
+
+        // Counts the events of one storm and times every xrPollEvent call made to read them.
+        class EventStormDrain
+        {
+        public:
+            explicit EventStormDrain(XrInstance instance) : m_instance(instance)
+            {
+            }
+
+            // Polls until the queue runs empty for the first time.
+            void Drain()
+            {
+                const auto start = std::chrono::steady_clock::now();
+                while (Poll(true)) {
+                }
+                m_drainSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            }
+
+            // Keeps polling for a while, to count events the runtime queues after the queue first ran empty.
+            void Settle(std::chrono::nanoseconds duration)
+            {
+                CountdownTimer countdown(duration);
+                while (!countdown.IsTimeUp()) {
+                    if (!Poll(false)) {
+                        std::this_thread::sleep_for(1_ms);
+                    }
+                }
+            }
+
+            void Report(const char* label)
+            {
+                ReportF("%s: %llu events drained in %.3fms, %.0f events/s", label, (unsigned long long)m_drainedCount,
+                        m_drainSeconds * 1000, m_drainedCount / m_drainSeconds);
+                ReportF("  Session state %llu, perf settings %llu, other %llu, queued after the drain %llu",
+                        (unsigned long long)m_sessionStateCount, (unsigned long long)m_perfSettingsCount,
+                        (unsigned long long)m_otherCount, (unsigned long long)m_lateCount);
+                ReportF("  XrEventDataEventsLost %llu, reporting %llu lost events", (unsigned long long)m_eventsLostCount,
+                        (unsigned long long)m_lostEventCount);
+                ReportLatencyPercentiles("  xrPollEvent with an event :", m_eventLatency);
+                ReportLatencyPercentiles("  xrPollEvent when empty    :", m_emptyLatency);
+            }
+
+        private:
+            // Returns false if the queue was empty.
+            bool Poll(bool draining)
+            {
+                XrEventDataBuffer buffer{XR_TYPE_EVENT_DATA_BUFFER};
+                const auto start = std::chrono::steady_clock::now();
+                const XrResult result = xrPollEvent(m_instance, &buffer);
+                const int64_t latency =
+                    (int64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+                REQUIRE_RESULT_SUCCEEDED(result);
+
+                if (result == XR_EVENT_UNAVAILABLE) {
+                    m_emptyLatency.push_back(latency);
+                    return false;
+                }
+
+                m_eventLatency.push_back(latency);
+                (draining ? m_drainedCount : m_lateCount)++;
+                switch (buffer.type) {
+                case XR_TYPE_EVENT_DATA_SESSION_STATE_CHANGED:
+                    m_sessionStateCount++;
+                    break;
+                case XR_TYPE_EVENT_DATA_PERF_SETTINGS_EXT:
+                    m_perfSettingsCount++;
+                    break;
+                case XR_TYPE_EVENT_DATA_EVENTS_LOST:
+                    m_eventsLostCount++;
+                    m_lostEventCount += reinterpret_cast<const XrEventDataEventsLost*>(&buffer)->lostEventCount;
+                    break;
+                default:
+                    m_otherCount++;
+                    break;
+                }
+                return true;
+            }
+
+            XrInstance m_instance;
+            double m_drainSeconds{0};
+            uint64_t m_drainedCount{0};
+            uint64_t m_lateCount{0};
+            uint64_t m_sessionStateCount{0};
+            uint64_t m_perfSettingsCount{0};
+            uint64_t m_eventsLostCount{0};
+            uint64_t m_lostEventCount{0};
+            uint64_t m_otherCount{0};
+            std::vector<int64_t> m_eventLatency;
+            std::vector<int64_t> m_emptyLatency;
+        };
+    }  // namespace
+
+    // Floods the event queue by creating and destroying sessions without polling in between, setting performance levels
+    // on each session when XR_EXT_performance_settings is supported, and then drains the queue. Reports drain
+    // throughput, lost events and per-poll latency; losing events under this load is allowed, so nothing is checked
+    // beyond the results.
+    TEST_CASE("Event Storm Benchmark", "[.][benchmark]")
+    {
+        GlobalData& globalData = GetGlobalData();
+
+        std::vector<const char*> extensions;
+        const bool perfSettingsSupported = globalData.IsInstanceExtensionSupported(XR_EXT_PERFORMANCE_SETTINGS_EXTENSION_NAME);
+        if (perfSettingsSupported) {
+            extensions.push_back(XR_EXT_PERFORMANCE_SETTINGS_EXTENSION_NAME);
+        }
+        AutoBasicInstance instance(extensions, AutoBasicInstance::createSystemId | AutoBasicInstance::skipDebugMessenger);
+
+        PFN_xrPerfSettingsSetPerformanceLevelEXT xrPerfSettingsSetPerformanceLevelEXT = nullptr;
+        if (perfSettingsSupported) {
+            REQUIRE_RESULT(xrGetInstanceProcAddr(instance, "xrPerfSettingsSetPerformanceLevelEXT",
+                                                 reinterpret_cast<PFN_xrVoidFunction*>(&xrPerfSettingsSetPerformanceLevelEXT)),
+                           XR_SUCCESS);
+        }
+
+        // One device for all of the sessions, so that the storm is not paced by device creation.
+        AutoGraphicsDevice graphicsDevice(instance, instance.systemId);
+        XrSessionCreateInfo sessionCreateInfo{XR_TYPE_SESSION_CREATE_INFO, graphicsDevice.GetGraphicsBinding(), 0, instance.systemId};
+
+        constexpr XrPerfSettingsLevelEXT perfLevels[] = {XR_PERF_SETTINGS_LEVEL_POWER_SAVINGS_EXT, XR_PERF_SETTINGS_LEVEL_SUSTAINED_LOW_EXT,
+                                                         XR_PERF_SETTINGS_LEVEL_SUSTAINED_HIGH_EXT, XR_PERF_SETTINGS_LEVEL_BOOST_EXT};
+
+        for (uint32_t sessionCount : eventStormSessionCounts) {
+            // Start each storm on an empty queue.
+            EventStormDrain(instance).Settle(100_ms);
+
+            for (uint32_t i = 0; i < sessionCount; ++i) {
+                XrSession session{XR_NULL_HANDLE};
+                CleanupSessionOnScopeExit cleanupSession(session);
+                REQUIRE_RESULT(xrCreateSession(instance, &sessionCreateInfo, &session), XR_SUCCESS);
+                if (xrPerfSettingsSetPerformanceLevelEXT != nullptr) {
+                    REQUIRE_RESULT_SUCCEEDED(
+                        xrPerfSettingsSetPerformanceLevelEXT(session, XR_PERF_SETTINGS_DOMAIN_CPU_EXT, perfLevels[i % 4]));
+                    REQUIRE_RESULT_SUCCEEDED(
+                        xrPerfSettingsSetPerformanceLevelEXT(session, XR_PERF_SETTINGS_DOMAIN_GPU_EXT, perfLevels[(i + 2) % 4]));
+                }
+                cleanupSession.Destroy();
+            }
+
+            EventStormDrain drain(instance);
+            drain.Drain();
+            drain.Settle(100_ms);
+
+            const std::string label = "Event storm of " + std::to_string(sessionCount) + " sessions" +
+                                      (perfSettingsSupported ? " with performance levels" : "");
+            drain.Report(label.c_str());
+        }
+    }
 }  // namespace Conformance
@@ -33,15 +33,15 @@ namespace Conformance
     {
         // XrResult xrResultToString(XrInstance instance, XrResult value, char buffer[XR_MAX_RESULT_STRING_SIZE]);
 
-        AutoBasicInstance instance;
+        AutoBasicInstance instance(AutoBasicInstance::allowPooled);
 
         XrResult result;
         char buffer[XR_MAX_RESULT_STRING_SIZE];
 
         // Exercise every known core xrResult.
-        const ResultStringMap& resultStringMap = GetResultStringMap();
+        const ResultStringTable& resultStringTable = GetResultStringTable();
 
-        for (auto value : resultStringMap) {
+        for (auto value : resultStringTable) {
             result = xrResultToString(instance, value.first, buffer);
             REQUIRE(ValidateResultAllowed("xrResultToString", result));
             REQUIRE(result == XR_SUCCESS);
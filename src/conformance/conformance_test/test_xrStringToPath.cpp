@@ -17,7 +17,14 @@
 #include "utils.h"
 #include "conformance_utils.h"
 #include "conformance_framework.h"
+#include "report.h"
+#include "results_stream.h"
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
 #include <vector>
 #include <set>
 #include <string>
@@ -28,6 +35,91 @@
 
 namespace Conformance
 {
+    namespace
+    {
+        constexpr uint32_t pathTableCheckpointPathCount = 100000;  // Paths interned between two reports of the sequential sweep.
+        constexpr uint32_t pathTableCheckpointCount = 10;          // So the sequential sweep interns 10^6 paths in total.
+        constexpr uint32_t pathTableThreadedPathCount = 200000;    // Paths interned for each thread count.
+
+        std::vector<std::string> MakeBenchmarkPathStrings(const std::string& prefix, uint32_t count)
+        {
+            std::vector<std::string> pathStrings;
+            pathStrings.reserve(count);
+            for (uint32_t i = 0; i < count; ++i) {
+                pathStrings.push_back(prefix + "/path_" + std::to_string(i));
+            }
+            return pathStrings;
+        }
+
+        struct PathTableRun
+        {
+            double stringToPathSeconds{0};
+            double pathToStringSeconds{0};
+            uint64_t residentBytesBefore{0};
+            uint64_t residentBytesAfter{0};
+            uint32_t failureCount{0};
+
+            void Report(const char* label, size_t pathCount) const
+            {
+                std::string memory = "resident memory not reported";
+                if (residentBytesBefore != 0 && residentBytesAfter != 0) {
+                    const double growth = (double)(int64_t)(residentBytesAfter - residentBytesBefore);
+                    memory = "resident memory " + std::to_string((long long)(growth / 1024)) + " KiB, " +
+                             std::to_string((long long)(growth / pathCount)) + " bytes/path";
+                }
+                ReportF("%s: xrStringToPath %.0f calls/s, xrPathToString %.0f calls/s, %s", label, pathCount / stringToPathSeconds,
+                        pathCount / pathToStringSeconds, memory.c_str());
+            }
+        };
+
+        // Interns every string and then converts every path back, splitting the strings evenly across the threads.
+        // Failed calls and paths that do not convert back to their string are counted rather than reported from the threads.
+        PathTableRun RunPathTable(XrInstance instance, const std::vector<std::string>& pathStrings, uint32_t threadCount)
+        {
+            std::vector<XrPath> paths(pathStrings.size(), XR_NULL_PATH);
+            std::atomic<uint32_t> failureCount{0};
+
+            auto timeOnThreads = [&](const std::function<void(size_t, size_t)>& work) {
+                auto sliceBegin = [&](uint32_t thread) { return pathStrings.size() * thread / threadCount; };
+
+                const auto start = std::chrono::steady_clock::now();
+                std::vector<std::thread> threads;
+                for (uint32_t thread = 1; thread < threadCount; ++thread) {
+                    threads.emplace_back(work, sliceBegin(thread), sliceBegin(thread + 1));
+                }
+                work(sliceBegin(0), sliceBegin(1));
+                for (std::thread& thread : threads) {
+                    thread.join();
+                }
+                return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            };
+
+            PathTableRun run;
+            run.residentBytesBefore = GetResidentBytes();
+            run.stringToPathSeconds = timeOnThreads([&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    if (xrStringToPath(instance, pathStrings[i].c_str(), &paths[i]) != XR_SUCCESS) {
+                        failureCount++;
+                    }
+                }
+            });
+            run.residentBytesAfter = GetResidentBytes();
+
+            run.pathToStringSeconds = timeOnThreads([&](size_t begin, size_t end) {
+                char buffer[XR_MAX_PATH_LENGTH];
+                for (size_t i = begin; i < end; ++i) {
+                    uint32_t countOutput = 0;
+                    if (xrPathToString(instance, paths[i], sizeof(buffer), &countOutput, buffer) != XR_SUCCESS ||
+                        pathStrings[i] != buffer) {
+                        failureCount++;
+                    }
+                }
+            });
+
+            run.failureCount = failureCount;
+            return run;
+        }
+    }  // namespace
 
     TEST_CASE("xrStringToPath", "")
     {
@@ -183,4 +275,46 @@ namespace Conformance
         }
     }
 
+    // Measures how a runtime's path table scales as it grows to a million unique paths, and how well it takes interning from
+    // several threads at once. Reports throughput and resident memory growth only; there are no conformance requirements here.
+    TEST_CASE("Path Table Scaling Benchmark", "[.][benchmark]")
+    {
+        SECTION("Sequential")
+        {
+            AutoBasicInstance instance(AutoBasicInstance::skipDebugMessenger);
+
+            for (uint32_t checkpoint = 0; checkpoint < pathTableCheckpointCount; ++checkpoint) {
+                const std::string prefix = "/benchmark/sequential/checkpoint_" + std::to_string(checkpoint);
+                const std::vector<std::string> pathStrings = MakeBenchmarkPathStrings(prefix, pathTableCheckpointPathCount);
+                const PathTableRun run = RunPathTable(instance, pathStrings, 1);
+                REQUIRE(run.failureCount == 0);
+
+                const std::string label = "Path table, " + std::to_string((checkpoint + 1) * pathTableCheckpointPathCount) +
+                                          " paths interned sequentially, last " + std::to_string(pathTableCheckpointPathCount);
+                run.Report(label.c_str(), pathStrings.size());
+            }
+        }
+
+        SECTION("Threads")
+        {
+            const uint32_t maxThreadCount = std::max(1u, std::thread::hardware_concurrency());
+            for (uint32_t threadCount = 1;; threadCount = std::min(threadCount * 2, maxThreadCount)) {
+                // Each thread count starts from an empty path table, so that the runs are comparable.
+                AutoBasicInstance instance(AutoBasicInstance::skipDebugMessenger);
+
+                const std::vector<std::string> pathStrings =
+                    MakeBenchmarkPathStrings("/benchmark/threads_" + std::to_string(threadCount), pathTableThreadedPathCount);
+                const PathTableRun run = RunPathTable(instance, pathStrings, threadCount);
+                REQUIRE(run.failureCount == 0);
+
+                const std::string label =
+                    "Path table, " + std::to_string(pathTableThreadedPathCount) + " paths on " + std::to_string(threadCount) + " thread(s)";
+                run.Report(label.c_str(), pathStrings.size());
+
+                if (threadCount == maxThreadCount) {
+                    break;
+                }
+            }
+        }
+    }
 }  // namespace Conformance
@@ -34,7 +34,7 @@ namespace Conformance
     {
         // XrResult xrStructureTypeToString(XrInstance instance, XrStructureType value, char buffer[XR_MAX_STRUCTURE_NAME_SIZE]);
 
-        AutoBasicInstance instance;
+        AutoBasicInstance instance(AutoBasicInstance::allowPooled);
 
         XrResult result;
         char buffer[XR_MAX_RESULT_STRING_SIZE];
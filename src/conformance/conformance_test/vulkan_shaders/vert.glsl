@@ -8,13 +8,10 @@
 
 #pragma vertex
 
-layout (std140, push_constant) uniform buf
-{
-    mat4 mvp;
-} ubuf;
-
 layout (location = 0) in vec3 Position;
 layout (location = 1) in vec3 Color;
+// Per-instance model-view-projection transform, occupies locations 2-5.
+layout (location = 2) in mat4 InstanceMvp;
 
 layout (location = 0) out vec4 oColor;
 out gl_PerVertex
@@ -26,5 +23,5 @@ void main()
 {
     oColor.rgb  = Color.rgb;
     oColor.a  = 1.0;
-    gl_Position = ubuf.mvp * vec4(Position, 1);
+    gl_Position = InstanceMvp * vec4(Position, 1);
 }
@@ -2,7 +2,11 @@
 //
 // SPDX-License-Identifier: Apache-2.0
 
+#pragma once
+
 #include <array>
+#include <cstdint>
+#include <cstring>
 #include <openxr/openxr.h>
 
 namespace Geometry
@@ -14,6 +18,51 @@ namespace Geometry
         XrVector3f Color;
     };
 
+    // The form vertices take in GPU vertex buffers, half the size of Vertex: a half-float position padded to four
+    // components (w is 1), read as R16G16B16A16_FLOAT, and a UNORM8 colour (alpha is 1), read as R8G8B8A8_UNORM.
+    // Halves keep about three decimal digits, which is plenty for meshes of a few meters around their origin.
+    struct PackedVertex
+    {
+        uint16_t Position[4];
+        uint8_t Color[4];
+    };
+    static_assert(sizeof(PackedVertex) == 12, "PackedVertex must be tightly packed");
+
+    // Rounds to the nearest half-float, flushing values too small for a normal half to zero.
+    inline uint16_t FloatToHalf(float value)
+    {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        const uint16_t sign = (uint16_t)((bits >> 16) & 0x8000u);
+        const uint32_t magnitude = bits & 0x7fffffffu;
+        if (magnitude >= 0x7f800000u) {
+            return (uint16_t)(sign | 0x7c00u | (magnitude > 0x7f800000u ? 0x200u : 0u));  // Inf or NaN.
+        }
+        if (magnitude >= 0x477ff000u) {
+            return (uint16_t)(sign | 0x7c00u);  // Rounds past the largest half, 65504.
+        }
+        if (magnitude < 0x38800000u) {
+            return sign;  // Below the smallest normal half.
+        }
+        // Rebias the exponent from 127 to 15, then round the 13 mantissa bits dropped to nearest even.
+        const uint32_t rebased = magnitude - 0x38000000u;
+        const uint32_t rounded = rebased + 0xfffu + ((rebased >> 13) & 1u);
+        return (uint16_t)(sign | (rounded >> 13));
+    }
+
+    inline uint8_t UnitToUnorm8(float value)
+    {
+        const float clamped = value < 0 ? 0 : (value > 1 ? 1 : value);
+        return (uint8_t)(clamped * 255.0f + 0.5f);
+    }
+
+    inline PackedVertex PackVertex(const Vertex& vertex)
+    {
+        constexpr uint16_t HalfOne = 0x3c00;
+        return PackedVertex{{FloatToHalf(vertex.Position.x), FloatToHalf(vertex.Position.y), FloatToHalf(vertex.Position.z), HalfOne},
+                            {UnitToUnorm8(vertex.Color.x), UnitToUnorm8(vertex.Color.y), UnitToUnorm8(vertex.Color.z), 255}};
+    }
+
     constexpr XrVector3f Red{1, 0, 0};
     constexpr XrVector3f DarkRed{0.25f, 0, 0};
     constexpr XrVector3f Green{0, 1, 0};
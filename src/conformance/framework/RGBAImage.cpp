@@ -6,9 +6,36 @@
 #include <stdexcept>
 #include <fstream>
 #include <array>
+#include <cstring>
+#include <atomic>
+#include <future>
+#include <iterator>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
 #include <unordered_map>
 #include "RGBAImage.h"
+#include "Geometry.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define RGBA_IMAGE_MAP_FILE_POSIX
+#elif defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#define RGBA_IMAGE_MAP_FILE_WIN32
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RGBA_IMAGE_USE_SSE2
+#endif
 
 // Only one compilation unit can have the STB implementations.
 #define STB_IMAGE_IMPLEMENTATION
@@ -30,55 +57,188 @@ namespace
         return {{(uint8_t)(255 * r), (uint8_t)(255 * g), (uint8_t)(255 * b), (uint8_t)(255 * a)}};
     };
 
+    // Calls body(beginRow, endRow) over [0, rows), split across threads once there are enough pixels for the
+    // threads to pay for themselves. The body must only touch its own rows.
+    template <typename Body>
+    void ParallelForRows(int rows, int rowPixels, const Body& body)
+    {
+        constexpr int64_t MinPixelsPerThread = 256 * 1024;
+        const int64_t threadLimit = std::min<int64_t>(int64_t(rows) * rowPixels / MinPixelsPerThread, rows);
+        const int threadCount = (int)std::min<int64_t>(threadLimit, std::max(1u, std::thread::hardware_concurrency()));
+        if (threadCount <= 1) {
+            body(0, rows);
+            return;
+        }
+
+        const int rowsPerThread = (rows + threadCount - 1) / threadCount;
+        std::vector<std::future<void>> others;
+        for (int beginRow = rowsPerThread; beginRow < rows; beginRow += rowsPerThread) {
+            others.push_back(std::async(std::launch::async, [&body, beginRow, rows, rowsPerThread] {
+                body(beginRow, std::min(rows, beginRow + rowsPerThread));
+            }));
+        }
+        body(0, rowsPerThread);
+        for (std::future<void>& other : others) {
+            other.get();
+        }
+    }
+
+    constexpr const char* FontPath = PATH_PREFIX "SourceCodePro-Regular.otf";
+
+    // The font file, mapped read-only into memory on first use and shared by every baked size.
+    class FontFile
+    {
+    public:
+        static const FontFile& Get()
+        {
+            static const FontFile s_fontFile;
+            return s_fontFile;
+        }
+
+        FontFile(const FontFile&) = delete;
+        FontFile& operator=(const FontFile&) = delete;
+
+        ~FontFile()
+        {
+#if defined(RGBA_IMAGE_MAP_FILE_POSIX)
+            if (m_mapped != nullptr) {
+                munmap(m_mapped, m_size);
+            }
+#elif defined(RGBA_IMAGE_MAP_FILE_WIN32)
+            if (m_mapped != nullptr) {
+                UnmapViewOfFile(m_mapped);
+            }
+#endif
+        }
+
+        // Null if the file could not be opened.
+        const uint8_t* Data() const
+        {
+            return m_mapped != nullptr ? static_cast<const uint8_t*>(m_mapped) : (m_contents.empty() ? nullptr : m_contents.data());
+        }
+
+    private:
+        FontFile()
+        {
+#if defined(RGBA_IMAGE_MAP_FILE_POSIX)
+            const int fd = open(FontPath, O_RDONLY);
+            if (fd >= 0) {
+                struct stat st;
+                if (fstat(fd, &st) == 0 && st.st_size > 0) {
+                    void* mapped = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                    if (mapped != MAP_FAILED) {
+                        m_mapped = mapped;
+                        m_size = (size_t)st.st_size;
+                    }
+                }
+                close(fd);
+            }
+#elif defined(RGBA_IMAGE_MAP_FILE_WIN32)
+            const HANDLE file = CreateFileA(FontPath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (file != INVALID_HANDLE_VALUE) {
+                const HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+                if (mapping != nullptr) {
+                    m_mapped = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+                    CloseHandle(mapping);
+                }
+                CloseHandle(file);
+            }
+#endif
+            if (m_mapped != nullptr) {
+                return;
+            }
+
+            // No mapping on this platform, or it failed: read the file instead.
+            std::ifstream file(FontPath, std::ios::in | std::ios::binary);
+            if (file) {
+                m_contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+            }
+        }
+
+        void* m_mapped{nullptr};
+        size_t m_size{0};
+        std::vector<uint8_t> m_contents;
+    };
+
     // Cached TrueType font baked as glyphs.
     struct BakedFont
     {
         BakedFont(int pixelHeight)
         {
-            constexpr const char* FontPath = PATH_PREFIX "SourceCodePro-Regular.otf";
-
-            std::ifstream file;
-            file.open(FontPath, std::ios::in | std::ios::binary);
-            if (!file) {
+            const uint8_t* const fontData = FontFile::Get().Data();
+            if (fontData == nullptr) {
                 throw std::runtime_error((std::string("Unable to open font ") + FontPath).c_str());
             }
 
-            file.seekg(0, std::ios::end);
-            std::vector<uint8_t> fontData((uint32_t)file.tellg());
-            file.seekg(0, std::ios::beg);
-
-            file.read(reinterpret_cast<char*>(fontData.data()), fontData.size());
-
-            // This is just a starting size.
+            // Start from an estimate of the packed size, since stbtt packs glyphs left to right in rows about
+            // pixelHeight tall. The monospace glyphs are well under pixelHeight wide.
             m_bitmapWidth = 1024;
+            const int glyphsPerRow = std::max(1, m_bitmapWidth / (pixelHeight * 3 / 4 + 2));
+            const int rows = ((int)m_bakedChars.size() + glyphsPerRow - 1) / glyphsPerRow;
             m_bitmapHeight = 64;
+            while (m_bitmapHeight < rows * (pixelHeight + 2) + 2) {
+                m_bitmapHeight *= 2;
+            }
 
-        retry:
-            glyphBitmap.resize(m_bitmapWidth * m_bitmapHeight);
+            for (;;) {
+                glyphBitmap.resize(m_bitmapWidth * m_bitmapHeight);
 
-            int res = stbtt_BakeFontBitmap(fontData.data(), 0, (float)pixelHeight, glyphBitmap.data(), m_bitmapWidth, m_bitmapHeight,
-                                           StartChar, (int)m_bakedChars.size(), m_bakedChars.data());
-            if (res == 0) {
-                throw std::runtime_error((std::string("Unable to parse font") + FontPath).c_str());
-            }
-            else if (res < 0) {
+                int res = stbtt_BakeFontBitmap(fontData, 0, (float)pixelHeight, glyphBitmap.data(), m_bitmapWidth, m_bitmapHeight,
+                                               StartChar, (int)m_bakedChars.size(), m_bakedChars.data());
+                if (res == 0) {
+                    throw std::runtime_error((std::string("Unable to parse font") + FontPath).c_str());
+                }
+                else if (res > 0) {
+                    break;
+                }
                 // Bitmap was not big enough to fit so double size and try again.
                 m_bitmapHeight *= 2;
-                goto retry;
             }
         }
 
+        // Fonts are baked once per pixel height and kept for the life of the process. A size being baked on
+        // another thread, for example by BakeFontsAsync, is waited for rather than baked again.
         static std::shared_ptr<const BakedFont> GetOrCreate(int pixelHeight)
         {
-            std::unordered_map<int, std::shared_ptr<BakedFont>> s_bakedFonts;
-            auto it = s_bakedFonts.find(pixelHeight);
-            if (it == s_bakedFonts.end()) {
-                std::shared_ptr<BakedFont> font = std::make_shared<BakedFont>(pixelHeight);
-                s_bakedFonts.insert({pixelHeight, font});
-                return font;
+            Registry& registry = GetRegistry();
+
+            std::promise<std::shared_ptr<const BakedFont>> promise;
+            std::shared_future<std::shared_ptr<const BakedFont>> font;
+            bool bake = false;
+            {
+                std::lock_guard<std::mutex> lock(registry.mutex);
+                auto it = registry.fonts.find(pixelHeight);
+                if (it != registry.fonts.end()) {
+                    font = it->second;
+                }
+                else {
+                    font = promise.get_future().share();
+                    registry.fonts.emplace(pixelHeight, font);
+                    bake = true;
+                }
+            }
+
+            if (bake) {
+                try {
+                    promise.set_value(std::make_shared<BakedFont>(pixelHeight));
+                }
+                catch (...) {
+                    promise.set_exception(std::current_exception());
+                }
             }
+            return font.get();
+        }
 
-            return it->second;
+        struct Registry
+        {
+            std::mutex mutex;
+            std::unordered_map<int, std::shared_future<std::shared_ptr<const BakedFont>>> fonts;
+        };
+
+        static Registry& GetRegistry()
+        {
+            static Registry s_registry;
+            return s_registry;
         }
 
         const stbtt_bakedchar& GetBakedChar(char c) const
@@ -101,10 +261,90 @@ namespace
         int m_bitmapWidth;
         int m_bitmapHeight;
     };
+
+    std::shared_ptr<const Conformance::RGBAImage> DecodeImage(const char* path)
+    {
+        constexpr int RequiredComponents = 4;  // RGBA
+
+        const std::string fullPath = std::string(PATH_PREFIX) + path;
+
+        // stb_image always decodes into a buffer of its own, so this is the one copy made per file.
+        int width, height;
+        stbi_uc* const uc = stbi_load(fullPath.c_str(), &width, &height, nullptr, RequiredComponents);
+        if (uc == nullptr) {
+            throw std::runtime_error("Unable to load file " + fullPath);
+        }
+
+        auto image = std::make_shared<Conformance::RGBAImage>(width, height);
+        memcpy(image->pixels.data(), uc, (size_t)width * height * RequiredComponents);
+
+        stbi_image_free(uc);
+
+        // Images loaded from files are assumed to be SRGB
+        image->isSrgb = true;
+
+        return image;
+    }
+
+    struct ImageCache
+    {
+        std::mutex mutex;
+        std::unordered_map<std::string, std::shared_future<std::shared_ptr<const Conformance::RGBAImage>>> images;
+    };
+
+    ImageCache& GetImageCache()
+    {
+        static ImageCache s_cache;
+        return s_cache;
+    }
 }  // namespace
 
 namespace Conformance
 {
+    void BakeFontsAsync(std::vector<int> pixelHeights)
+    {
+        // The shared statics are created up front so that they outlive s_baking, whose destructor waits for the thread.
+        (void)FontFile::Get();
+        (void)BakedFont::GetRegistry();
+
+        static std::future<void> s_baking;
+        s_baking = std::async(std::launch::async, [pixelHeights]() {
+            for (int pixelHeight : pixelHeights) {
+                try {
+                    (void)BakedFont::GetOrCreate(pixelHeight);
+                }
+                catch (...) {
+                    // The same error is thrown again to whoever draws text at this size.
+                }
+            }
+        });
+    }
+
+    void PreloadImagesAsync(std::vector<std::string> paths)
+    {
+        // As in BakeFontsAsync, the cache must outlive the workers.
+        (void)GetImageCache();
+
+        static std::vector<std::future<void>> s_decoding;
+        s_decoding.clear();
+
+        auto next = std::make_shared<std::atomic<size_t>>(0);
+        auto sharedPaths = std::make_shared<const std::vector<std::string>>(std::move(paths));
+        const size_t workerCount = std::min<size_t>(sharedPaths->size(), std::max(1u, std::thread::hardware_concurrency()));
+        for (size_t worker = 0; worker < workerCount; ++worker) {
+            s_decoding.push_back(std::async(std::launch::async, [next, sharedPaths]() {
+                for (size_t i = (*next)++; i < sharedPaths->size(); i = (*next)++) {
+                    try {
+                        (void)RGBAImage::LoadShared((*sharedPaths)[i].c_str());
+                    }
+                    catch (...) {
+                        // The same error is thrown again to whoever loads this image.
+                    }
+                }
+            }));
+        }
+    }
+
     RGBAImage::RGBAImage(int width, int height) : width(width), height(height)
     {
         pixels.resize(width * height);
@@ -112,27 +352,38 @@ namespace Conformance
 
     /* static */ RGBAImage RGBAImage::Load(const char* path)
     {
-        constexpr int RequiredComponents = 4;  // RGBA
+        return *LoadShared(path);
+    }
 
-        char fullPath[512];
-        strcpy(fullPath, PATH_PREFIX);
-        strcat(fullPath, path);
+    /* static */ std::shared_ptr<const RGBAImage> RGBAImage::LoadShared(const char* path)
+    {
+        ImageCache& cache = GetImageCache();
 
-        int width, height;
-        stbi_uc* const uc = stbi_load(fullPath, &width, &height, nullptr, RequiredComponents);
-        if (uc == nullptr) {
-            throw std::runtime_error((std::string("Unable to load file ") + fullPath).c_str());
+        std::promise<std::shared_ptr<const RGBAImage>> promise;
+        std::shared_future<std::shared_ptr<const RGBAImage>> image;
+        bool decode = false;
+        {
+            std::lock_guard<std::mutex> lock(cache.mutex);
+            auto it = cache.images.find(path);
+            if (it != cache.images.end()) {
+                image = it->second;
+            }
+            else {
+                image = promise.get_future().share();
+                cache.images.emplace(path, image);
+                decode = true;
+            }
         }
 
-        RGBAImage image(width, height);
-        memcpy(image.pixels.data(), uc, width * height * RequiredComponents);
-
-        free(uc);
-
-        // Images loaded from files are assumed to be SRGB
-        image.isSrgb = true;
-
-        return image;
+        if (decode) {
+            try {
+                promise.set_value(DecodeImage(path));
+            }
+            catch (...) {
+                promise.set_exception(std::current_exception());
+            }
+        }
+        return image.get();
     }
 
     void RGBAImage::PutText(const XrRect2Di& rect, const char* text, int pixelHeight, XrColor4f color)
@@ -146,6 +397,7 @@ namespace Conformance
             rect.offset.y + (int)(pixelHeight * 0.8f);  // Adjust down because glyphs are relative to the font baseline. This is hacky.
 
         // Loop through each character and copy over the chracters' glyphs.
+        const char* const start = text;
         for (; *text; text++) {
             if (*text == '\n') {
                 xadvance = (float)rect.offset.x;
@@ -153,11 +405,11 @@ namespace Conformance
                 continue;
             }
 
-            // Word wrap.
-            {
+            // Word wrap. Each word is measured once, at its first character, so layout stays linear in the text length.
+            if (*text > 32 && (text == start || text[-1] <= 32)) {
                 int remainingWordWidth = 0;
                 for (const char* w = text; *w > 32; w++) {
-                    const stbtt_bakedchar& bakedChar = font->GetBakedChar(*text);
+                    const stbtt_bakedchar& bakedChar = font->GetBakedChar(*w);
                     remainingWordWidth += (int)(bakedChar.x1 - bakedChar.x0);
                 }
 
@@ -181,6 +433,11 @@ namespace Conformance
                 yadvance += pixelHeight;
             }
 
+            // Clip the glyph's columns to the image and the destination rectangle once, rather than per pixel.
+            const int destX0 = (int)(bakedChar.xoff + xadvance + 0.5f);
+            const int cxBegin = std::max(std::max(0, rect.offset.x) - destX0, 0);
+            const int cxEnd = std::min(std::min(width, rect.offset.x + rect.extent.width) - destX0, characterWidth);
+
             // For each row of the glyph bitmap
             for (int cy = 0; cy < characterHeight; cy++) {
                 // Compute the destination row in the image.
@@ -193,11 +450,8 @@ namespace Conformance
                 const uint8_t* const srcGlyphRow = font->GetBakedCharRow(bakedChar, cy);
                 RGBA8Color* const destImageRow = pixels.data() + (destY * width);
 
-                for (int cx = 0; cx < characterWidth; cx++) {
-                    const int destX = (int)(bakedChar.xoff + xadvance + 0.5f) + cx;
-                    if (destX < 0 || destX >= width || destX < rect.offset.x || destX >= rect.offset.x + rect.extent.width) {
-                        continue;  // Don't bother copying if out of bounds.
-                    }
+                for (int cx = cxBegin; cx < cxEnd; cx++) {
+                    const int destX = destX0 + cx;
 
                     // Glyphs are 0-255 intensity.
                     const uint8_t srcGlyphPixel = srcGlyphRow[cx + bakedChar.x0];
@@ -223,12 +477,11 @@ namespace Conformance
         }
 
         const RGBA8Color color32 = AsRGBA(color.r, color.g, color.b, color.a);
-        for (int row = 0; row < h; row++) {
-            RGBA8Color* start = pixels.data() + ((row + y) * width) + x;
-            for (int col = 0; col < w; col++) {
-                *(start + col) = color32;
+        ParallelForRows(h, w, [&](int beginRow, int endRow) {
+            for (int row = beginRow; row < endRow; row++) {
+                std::fill_n(pixels.data() + ((row + y) * width) + x, w, color32);
             }
-        }
+        });
     }
 
     void RGBAImage::DrawRectBorder(int x, int y, int w, int h, int thickness, XrColor4f color)
@@ -241,20 +494,14 @@ namespace Conformance
         for (int row = 0; row < h; row++) {
             RGBA8Color* start = pixels.data() + ((row + y) * width) + x;
             if (row < thickness || row >= h - thickness) {
-                for (int col = 0; col < w; col++) {
-                    *(start + col) = color32;
-                }
+                std::fill_n(start, w, color32);
             }
             else {
                 int leftBorderEnd = std::min(thickness, w);
-                for (int col = 0; col < leftBorderEnd; col++) {
-                    *(start + col) = color32;
-                }
+                std::fill_n(start, leftBorderEnd, color32);
 
                 int rightBorderBegin = std::max(w - thickness, 0);
-                for (int col = rightBorderBegin; col < w; col++) {
-                    *(start + col) = color32;
-                }
+                std::fill(start + rightBorderBegin, start + w, color32);
             }
         }
     }
@@ -275,11 +522,212 @@ namespace Conformance
 
     void RGBAImage::ConvertToSRGB()
     {
-        for (RGBA8Color& pixel : pixels) {
-            pixel.Channels.R = (uint8_t)(ToSRGB((double)pixel.Channels.R / 255.0) * 255.0);
-            pixel.Channels.G = (uint8_t)(ToSRGB((double)pixel.Channels.G / 255.0) * 255.0);
-            pixel.Channels.B = (uint8_t)(ToSRGB((double)pixel.Channels.B / 255.0) * 255.0);
+        // There are only 256 possible channel values, so look them up rather than calling pow for every channel.
+        static const std::array<uint8_t, 256> toSRGB = [] {
+            std::array<uint8_t, 256> table{};
+            for (size_t i = 0; i < table.size(); ++i) {
+                table[i] = (uint8_t)(ToSRGB((double)i / 255.0) * 255.0);
+            }
+            return table;
+        }();
+
+        ParallelForRows(height, width, [&](int beginRow, int endRow) {
+            RGBA8Color* const end = pixels.data() + (size_t)endRow * width;
+            for (RGBA8Color* pixel = pixels.data() + (size_t)beginRow * width; pixel != end; ++pixel) {
+                pixel->Channels.R = toSRGB[pixel->Channels.R];
+                pixel->Channels.G = toSRGB[pixel->Channels.G];
+                pixel->Channels.B = toSRGB[pixel->Channels.B];
+            }
+        });
+    }
+
+    RGBAImage RGBAImage::Downsampled() const
+    {
+        static const std::array<float, 256> fromSRGB = [] {
+            std::array<float, 256> table{};
+            for (size_t i = 0; i < table.size(); ++i) {
+                table[i] = (float)FromSRGB((double)i / 255.0);
+            }
+            return table;
+        }();
+
+        RGBAImage result(std::max(1, width / 2), std::max(1, height / 2));
+        result.isSrgb = isSrgb;
+
+        // Odd source sizes leave the last row or column out of the filter, as GPU box filters do.
+        const int spanX = width > 1 ? 2 : 1;
+        const int spanY = height > 1 ? 2 : 1;
+        const float weight = 1.0f / float(spanX * spanY);
+        ParallelForRows(result.height, result.width, [&](int beginRow, int endRow) {
+            for (int row = beginRow; row < endRow; ++row) {
+                for (int column = 0; column < result.width; ++column) {
+                    float sum[4] = {};
+                    for (int dy = 0; dy < spanY; ++dy) {
+                        const RGBA8Color* source = &pixels[size_t(row * spanY + dy) * width + size_t(column) * spanX];
+                        for (int dx = 0; dx < spanX; ++dx) {
+                            const RGBA8Color& pixel = source[dx];
+                            if (isSrgb) {
+                                sum[0] += fromSRGB[pixel.Channels.R];
+                                sum[1] += fromSRGB[pixel.Channels.G];
+                                sum[2] += fromSRGB[pixel.Channels.B];
+                            }
+                            else {
+                                sum[0] += pixel.Channels.R / 255.0f;
+                                sum[1] += pixel.Channels.G / 255.0f;
+                                sum[2] += pixel.Channels.B / 255.0f;
+                            }
+                            sum[3] += pixel.Channels.A / 255.0f;
+                        }
+                    }
+
+                    const auto encode = [&](float linear, bool srgb) {
+                        const double value = srgb ? ToSRGB(linear * weight) : linear * weight;
+                        return (uint8_t)std::min(255.0, std::max(0.0, value * 255.0 + 0.5));
+                    };
+                    RGBA8Color& out = result.pixels[size_t(row) * result.width + column];
+                    out.Channels.R = encode(sum[0], isSrgb);
+                    out.Channels.G = encode(sum[1], isSrgb);
+                    out.Channels.B = encode(sum[2], isSrgb);
+                    out.Channels.A = encode(sum[3], false);
+                }
+            }
+        });
+        return result;
+    }
+
+    size_t RGBATexelSize(RGBATexelLayout layout)
+    {
+        switch (layout) {
+        case RGBATexelLayout::R16G16B16A16Float:
+            return 4 * sizeof(uint16_t);
+        case RGBATexelLayout::R32G32B32A32Float:
+            return 4 * sizeof(float);
+        default:
+            return sizeof(uint32_t);
+        }
+    }
+
+    void WriteRGBATexels(const RGBAImage& image, RGBATexelLayout layout, void* dest, size_t destRowPitch, bool flipRows)
+    {
+        // Each channel value has one linear value, so look them up rather than decoding every channel.
+        static const std::array<float, 256> fromUnorm = [] {
+            std::array<float, 256> table{};
+            for (size_t i = 0; i < table.size(); ++i) {
+                table[i] = (float)i / 255.0f;
+            }
+            return table;
+        }();
+        static const std::array<float, 256> fromSRGB = [] {
+            std::array<float, 256> table{};
+            for (size_t i = 0; i < table.size(); ++i) {
+                table[i] = (float)FromSRGB((double)i / 255.0);
+            }
+            return table;
+        }();
+        const std::array<float, 256>& colorValues = image.isSrgb ? fromSRGB : fromUnorm;
+
+        const int width = image.width;
+        ParallelForRows(image.height, width, [&](int beginRow, int endRow) {
+            for (int row = beginRow; row < endRow; ++row) {
+                const RGBA8Color* source = &image.pixels[size_t(flipRows ? image.height - 1 - row : row) * width];
+                uint8_t* const destRow = static_cast<uint8_t*>(dest) + size_t(row) * destRowPitch;
+                switch (layout) {
+                case RGBATexelLayout::R8G8B8A8:
+                    memcpy(destRow, source, size_t(width) * sizeof(RGBA8Color));
+                    break;
+                case RGBATexelLayout::B8G8R8A8: {
+                    RGBA8Color* const texels = reinterpret_cast<RGBA8Color*>(destRow);
+                    for (int x = 0; x < width; ++x) {
+                        texels[x] = {{source[x].Channels.B, source[x].Channels.G, source[x].Channels.R, source[x].Channels.A}};
+                    }
+                    break;
+                }
+                case RGBATexelLayout::R16G16B16A16Float: {
+                    uint16_t* texel = reinterpret_cast<uint16_t*>(destRow);
+                    for (int x = 0; x < width; ++x, texel += 4) {
+                        texel[0] = Geometry::FloatToHalf(colorValues[source[x].Channels.R]);
+                        texel[1] = Geometry::FloatToHalf(colorValues[source[x].Channels.G]);
+                        texel[2] = Geometry::FloatToHalf(colorValues[source[x].Channels.B]);
+                        texel[3] = Geometry::FloatToHalf(fromUnorm[source[x].Channels.A]);
+                    }
+                    break;
+                }
+                case RGBATexelLayout::R32G32B32A32Float: {
+                    float* texel = reinterpret_cast<float*>(destRow);
+                    for (int x = 0; x < width; ++x, texel += 4) {
+                        texel[0] = colorValues[source[x].Channels.R];
+                        texel[1] = colorValues[source[x].Channels.G];
+                        texel[2] = colorValues[source[x].Channels.B];
+                        texel[3] = fromUnorm[source[x].Channels.A];
+                    }
+                    break;
+                }
+                case RGBATexelLayout::R10G10B10A2: {
+                    uint32_t* const texels = reinterpret_cast<uint32_t*>(destRow);
+                    const auto to10 = [&](uint8_t value) { return (uint32_t)(colorValues[value] * 1023.0f + 0.5f); };
+                    for (int x = 0; x < width; ++x) {
+                        texels[x] = to10(source[x].Channels.R) | (to10(source[x].Channels.G) << 10) | (to10(source[x].Channels.B) << 20) |
+                                    (uint32_t(source[x].Channels.A >> 6) << 30);
+                    }
+                    break;
+                }
+                }
+            }
+        });
+    }
+
+    RGBAImageDiff CompareRGBAImages(const RGBAImage& expected, const RGBAImage& actual, uint8_t tolerance)
+    {
+        if (expected.width != actual.width || expected.height != actual.height) {
+            throw std::invalid_argument("Cannot compare images of different sizes");
+        }
+
+        const RGBA8Color* a = expected.pixels.data();
+        const RGBA8Color* b = actual.pixels.data();
+        const size_t count = expected.pixels.size();
+        size_t i = 0;
+
+        RGBAImageDiff diff{0, 0};
+
+#if defined(RGBA_IMAGE_USE_SSE2)
+        // Four pixels at a time: the absolute difference of unsigned bytes is the OR of both saturating subtractions,
+        // and a pixel differs if any of its bytes is still nonzero after subtracting the tolerance.
+        const __m128i tolerances = _mm_set1_epi8((char)tolerance);
+        const __m128i zero = _mm_setzero_si128();
+        __m128i maxDifference = zero;
+        for (; i + 4 <= count; i += 4) {
+            const __m128i pa = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+            const __m128i pb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+            const __m128i difference = _mm_or_si128(_mm_subs_epu8(pa, pb), _mm_subs_epu8(pb, pa));
+            maxDifference = _mm_max_epu8(maxDifference, difference);
+
+            const __m128i withinTolerance = _mm_cmpeq_epi32(_mm_subs_epu8(difference, tolerances), zero);
+            const int withinMask = _mm_movemask_ps(_mm_castsi128_ps(withinTolerance));
+            diff.differingPixels += 4 - ((withinMask & 1) + ((withinMask >> 1) & 1) + ((withinMask >> 2) & 1) + ((withinMask >> 3) & 1));
+        }
+
+        alignas(16) uint8_t maxBytes[16];
+        _mm_store_si128(reinterpret_cast<__m128i*>(maxBytes), maxDifference);
+        diff.maxChannelDifference = *std::max_element(std::begin(maxBytes), std::end(maxBytes));
+#endif
+
+        for (; i < count; ++i) {
+            const uint8_t channels[4][2] = {{a[i].Channels.R, b[i].Channels.R},
+                                            {a[i].Channels.G, b[i].Channels.G},
+                                            {a[i].Channels.B, b[i].Channels.B},
+                                            {a[i].Channels.A, b[i].Channels.A}};
+            bool differs = false;
+            for (const auto& channel : channels) {
+                const uint8_t difference = (uint8_t)(channel[0] > channel[1] ? channel[0] - channel[1] : channel[1] - channel[0]);
+                diff.maxChannelDifference = std::max(diff.maxChannelDifference, difference);
+                differs |= difference > tolerance;
+            }
+            if (differs) {
+                diff.differingPixels++;
+            }
         }
+
+        return diff;
     }
 
 }  // namespace Conformance
@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <memory>
+#include <string>
 #include <vector>
 #include <openxr/openxr.h>
 #include <cmath>
@@ -25,21 +27,69 @@ namespace Conformance
 
     static_assert(sizeof(RGBA8Color) == 4, "Incorrect RGBA8Color size");
 
+    // Bakes the font at each of the given pixel heights on a background thread, so the first text drawn at those
+    // sizes does not have to wait for it.
+    void BakeFontsAsync(std::vector<int> pixelHeights);
+
+    // Decodes each of the given image files on worker threads, so that later loads of them come from the cache.
+    void PreloadImagesAsync(std::vector<std::string> paths);
+
     struct RGBAImage
     {
         RGBAImage(int width, int height);
 
+        // Returns a copy of the cached image, for callers that draw on it.
         static RGBAImage Load(const char* path);
 
+        // Decodes the file the first time it is asked for, and shares that decoded image with every later caller.
+        // Throws std::runtime_error, every time, if the file cannot be decoded.
+        static std::shared_ptr<const RGBAImage> LoadShared(const char* path);
+
         void PutText(const XrRect2Di& rect, const char* text, int pixelHeight, XrColor4f color);
         void DrawRect(int x, int y, int w, int h, XrColor4f color);
         void DrawRectBorder(int x, int y, int w, int h, int thickness, XrColor4f color);
         void ConvertToSRGB();
 
+        // Returns the next mip level of this image: half the size in each dimension, but at least 1, with each pixel the box
+        // filtered average of the (up to) 2x2 pixels it covers. Colors of an sRGB image are averaged in linear space.
+        RGBAImage Downsampled() const;
+
         bool isSrgb = false;
         std::vector<RGBA8Color> pixels;
         int width;
         int height;
     };
 
+    // The texel layouts that CopyRGBAImage uploads an RGBAImage as, for swapchain formats whose upload does not convert
+    // from R8G8B8A8 on its own.
+    enum class RGBATexelLayout
+    {
+        R8G8B8A8,
+        B8G8R8A8,
+        R16G16B16A16Float,
+        R32G32B32A32Float,
+        // 10 bits each of R, G and B from the least significant bit up, then 2 of alpha, in a 32-bit word. This is
+        // DXGI_FORMAT_R10G10B10A2_UNORM, VK_FORMAT_A2B10G10R10_UNORM_PACK32 and GL_RGB10_A2.
+        R10G10B10A2,
+    };
+
+    size_t RGBATexelSize(RGBATexelLayout layout);
+
+    // Writes the pixels of image to dest in the layout, each row destRowPitch bytes after the one before, and the last
+    // row first if flipRows is set. The 8-bit layouts take the channels as they are. The others hold linear values, so
+    // the color channels of an sRGB image are decoded, and wide formats get real content rather than reinterpreted bytes.
+    void WriteRGBATexels(const RGBAImage& image, RGBATexelLayout layout, void* dest, size_t destRowPitch, bool flipRows = false);
+
+    struct RGBAImageDiff
+    {
+        // Pixels with any channel, alpha included, differing by more than the tolerance.
+        uint64_t differingPixels;
+        // Largest difference seen in any channel.
+        uint8_t maxChannelDifference;
+    };
+
+    // Compares two images of the same size channel by channel.
+    // Throws std::invalid_argument if the sizes differ.
+    RGBAImageDiff CompareRGBAImages(const RGBAImage& expected, const RGBAImage& actual, uint8_t tolerance = 0);
+
 }  // namespace Conformance
@@ -0,0 +1,78 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// The global operator new and delete replacements of BUILD_CONFORMANCE_ALLOCATION_TRACKING. They have to be defined in
+// exactly one module: where operators are replaced process wide, as with ELF, that is the conformance_cli executable,
+// so they also serve conformance_test without a shared library interposing on the loader and the runtime; where each
+// module keeps its own, as with Windows DLLs, it is conformance_test. CMake defines XR_CONFORMANCE_REPLACE_OPERATOR_NEW
+// for that module only.
+
+#include "allocation_tracking.h"
+
+#include <cstddef>
+#include <new>
+
+#if defined(XR_CONFORMANCE_REPLACE_OPERATOR_NEW)
+void* operator new(size_t size)
+{
+    return Conformance::TrackedAllocateOrThrow(size);
+}
+
+void* operator new[](size_t size)
+{
+    return Conformance::TrackedAllocateOrThrow(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return Conformance::TrackedAllocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return Conformance::TrackedAllocate(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+    Conformance::TrackedFree(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+    Conformance::TrackedFree(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+    Conformance::TrackedFree(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+    Conformance::TrackedFree(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+    Conformance::TrackedFree(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+    Conformance::TrackedFree(memory);
+}
+#endif
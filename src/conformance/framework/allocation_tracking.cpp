@@ -0,0 +1,113 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "allocation_tracking.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace Conformance
+{
+#if defined(XR_CONFORMANCE_TRACK_ALLOCATIONS)
+    namespace
+    {
+        // Trivially constructed, so that operator new can use it at any point in the life of a thread.
+        thread_local AllocationCounts t_allocationCounts;
+
+        // Each allocation is preceded by its size, in a header that keeps the memory after it suitably aligned.
+        constexpr size_t AllocationHeaderSize = alignof(std::max_align_t);
+        static_assert(AllocationHeaderSize >= sizeof(size_t), "Allocation header too small for the size");
+    }  // namespace
+
+    void* TrackedAllocate(size_t size) noexcept
+    {
+        unsigned char* const block = static_cast<unsigned char*>(std::malloc(size + AllocationHeaderSize));
+        if (block == nullptr) {
+            return nullptr;
+        }
+        *reinterpret_cast<size_t*>(block) = size;
+
+        AllocationCounts& counts = t_allocationCounts;
+        counts.count++;
+        counts.bytes += size;
+        counts.liveBytes += static_cast<int64_t>(size);
+        counts.peakLiveBytes = std::max(counts.peakLiveBytes, counts.liveBytes);
+        return block + AllocationHeaderSize;
+    }
+
+    void* TrackedAllocateOrThrow(size_t size)
+    {
+        void* const memory = TrackedAllocate(size);
+        if (memory == nullptr) {
+            throw std::bad_alloc();
+        }
+        return memory;
+    }
+
+    void TrackedFree(void* memory) noexcept
+    {
+        if (memory == nullptr) {
+            return;
+        }
+        unsigned char* const block = static_cast<unsigned char*>(memory) - AllocationHeaderSize;
+        t_allocationCounts.liveBytes -= static_cast<int64_t>(*reinterpret_cast<size_t*>(block));
+        std::free(block);
+    }
+
+    bool IsAllocationTrackingEnabled()
+    {
+        return true;
+    }
+
+    AllocationCounts GetThreadAllocationCounts()
+    {
+        return t_allocationCounts;
+    }
+
+    int64_t ResetThreadAllocationPeak()
+    {
+        const int64_t peak = t_allocationCounts.peakLiveBytes;
+        t_allocationCounts.peakLiveBytes = t_allocationCounts.liveBytes;
+        return peak;
+    }
+
+    void RaiseThreadAllocationPeak(int64_t peak)
+    {
+        t_allocationCounts.peakLiveBytes = std::max(t_allocationCounts.peakLiveBytes, peak);
+    }
+#else
+    bool IsAllocationTrackingEnabled()
+    {
+        return false;
+    }
+
+    AllocationCounts GetThreadAllocationCounts()
+    {
+        return {};
+    }
+
+    int64_t ResetThreadAllocationPeak()
+    {
+        return 0;
+    }
+
+    void RaiseThreadAllocationPeak(int64_t)
+    {
+    }
+#endif
+}  // namespace Conformance
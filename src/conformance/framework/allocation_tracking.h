@@ -0,0 +1,58 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Conformance
+{
+    // Counts of the operator new allocations made on one thread. With BUILD_CONFORMANCE_ALLOCATION_TRACKING the global
+    // operator new and delete are replaced to keep them, see allocation_operators.cpp; otherwise they stay zero.
+    // Memory freed on another thread than the one that allocated it is subtracted from the freeing thread's live bytes,
+    // so the live and peak bytes of a thread that hands memory to another one, or frees memory handed to it, are off by
+    // that much: a span of work on the test thread reads high when a worker frees what it allocated, and low when it
+    // frees what a worker allocated.
+    struct AllocationCounts
+    {
+        uint64_t count{0};     // Allocations made.
+        uint64_t bytes{0};     // Bytes requested by those allocations.
+        int64_t liveBytes{0};  // Bytes allocated less bytes freed.
+        int64_t peakLiveBytes{0};
+    };
+
+    // The allocation functions the replacement operator new and delete forward to. Only defined in a build with
+    // BUILD_CONFORMANCE_ALLOCATION_TRACKING. TrackedAllocate returns nullptr when out of memory, TrackedAllocateOrThrow
+    // throws std::bad_alloc.
+    void* TrackedAllocate(size_t size) noexcept;
+    void* TrackedAllocateOrThrow(size_t size);
+    void TrackedFree(void* memory) noexcept;
+
+    // Returns true if this build counts allocations.
+    bool IsAllocationTrackingEnabled();
+
+    // Returns the counts of the calling thread.
+    AllocationCounts GetThreadAllocationCounts();
+
+    // Sets the calling thread's peak to its current live bytes, so that the peak of a span of work can be read at its end,
+    // and returns the peak it replaced.
+    int64_t ResetThreadAllocationPeak();
+
+    // Raises the calling thread's peak to at least peak, so that the peak of an enclosing span can be restored after a
+    // span nested in it called ResetThreadAllocationPeak.
+    void RaiseThreadAllocationPeak(int64_t peak);
+}  // namespace Conformance
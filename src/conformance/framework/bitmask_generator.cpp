@@ -22,6 +22,7 @@
 
 #include "bitmask_generator.h"
 
+#include <cassert>
 #include <vector>
 #include <memory>
 
@@ -35,11 +36,11 @@ namespace Conformance
          *
          * @see bitmaskGenerator for the factory function to create one of these.
          *
-         * Uses the binary of an integer index as a selection of
+         * Steps an index through BitmaskCombinations, which uses the binary of the index as a selection of
          * which supplied bitmasks should be enabled in a given generated output.
          * Yes, this is a bitmask that selects bitmasks.
          */
-        class BitmaskGenerator : public GeneratorBase<BitmaskData const&>
+        class BitmaskGenerator : public GeneratorBase<BitmaskCombination const&>
         {
         public:
             ~BitmaskGenerator() override = default;
@@ -49,61 +50,84 @@ namespace Conformance
             BitmaskGenerator(BitmaskGenerator&&) = delete;
             BitmaskGenerator& operator=(BitmaskGenerator&&) = delete;
 
-            static std::unique_ptr<GeneratorBase<BitmaskData const&>> create(bool zeroOk, std::initializer_list<BitmaskData> const& bits)
+            static std::unique_ptr<GeneratorBase<BitmaskCombination const&>> create(bool zeroOk,
+                                                                                    std::initializer_list<BitmaskData> const& bits)
             {
                 std::unique_ptr<BitmaskGenerator> generator(new BitmaskGenerator(zeroOk, bits));
                 return generator;
             }
 
-            BitmaskGenerator(bool zeroOk, std::initializer_list<BitmaskData> const& bits) : bits_(bits), zeroOk_(zeroOk)
+            BitmaskGenerator(bool zeroOk, std::initializer_list<BitmaskData> const& bits) : combinations_(zeroOk, bits)
             {
             }
 
-            BitmaskData const& get() override
+            BitmaskCombination const& get() override
             {
                 return current_;
             }
 
             bool next() override
             {
-                // Return the zeroth combination first.
-                if (zeroOk_ && !gotZeroYet_) {
-                    gotZeroYet_ = true;
-                    return true;
-                }
-                // Otherwise, move on to the next index
-                currentIndex_++;
-                const auto n = bits_.size();
-                if (currentIndex_ >= (uint64_t(0x1) << n)) {
-                    // n is highest bit number + 1.
-                    // Thus, the largest mask is 0x1 << n - 1.
-                    // If we exceed that, we've run out of combinations.
+                if (nextIndex_ >= combinations_.size()) {
                     return false;
                 }
-
-                BitmaskData accumulate{{}, 0};
-                // Loop through the bits of our index to determine whether to enable a given bitmask
-                for (size_t i = 0; i < n; ++i) {
-                    uint64_t indexBit = (uint64_t(0x1) << i);
-                    if ((indexBit & currentIndex_) != 0) {
-                        // Yes, enable this bitmask
-                        accumulate |= bits_[i];
-                    }
-                }
-                current_ = accumulate;
+                current_ = combinations_[nextIndex_++];
                 return true;
             }
 
         private:
-            std::vector<BitmaskData> bits_;
-            bool zeroOk_;
-            bool gotZeroYet_ = false;
-            uint64_t currentIndex_ = 0;
-            BitmaskData current_;
+            BitmaskCombinations combinations_;
+            uint64_t nextIndex_ = 0;
+            BitmaskCombination current_{};
         };
 
     }  // namespace
 
+    BitmaskCombinations::BitmaskCombinations(bool zeroOk, std::initializer_list<BitmaskData> const& bits) : bits_(bits), zeroOk_(zeroOk)
+    {
+        assert(bits_.size() < 64);
+    }
+
+    uint64_t BitmaskCombinations::size() const
+    {
+        // n is highest bit number + 1, so there are 0x1 << n selections, the largest being (0x1 << n) - 1.
+        const uint64_t selections = uint64_t(0x1) << bits_.size();
+        return zeroOk_ ? selections : selections - 1;
+    }
+
+    BitmaskCombination BitmaskCombinations::operator[](uint64_t index) const
+    {
+        assert(index < size());
+        // The zeroth selection, if allowed, comes first.
+        const uint64_t selection = zeroOk_ ? index : index + 1;
+
+        uint64_t bitmask = 0;
+        // Loop through the bits of our selection to determine whether to enable a given bitmask
+        for (size_t i = 0; i < bits_.size(); ++i) {
+            if (((uint64_t(0x1) << i) & selection) != 0) {
+                bitmask |= bits_[i].bitmask;
+            }
+        }
+        return {bitmask, selection, &bits_};
+    }
+
+    std::string BitmaskCombination::description() const
+    {
+        return toBitmaskData().description;
+    }
+
+    BitmaskData BitmaskCombination::toBitmaskData() const
+    {
+        BitmaskData accumulate{{}, 0};
+        for (size_t i = 0; bits != nullptr && i < bits->size(); ++i) {
+            if (((uint64_t(0x1) << i) & selection) != 0) {
+                // Yes, enable this bitmask
+                accumulate |= (*bits)[i];
+            }
+        }
+        return accumulate;
+    }
+
     BitmaskData operator|(BitmaskData const& lhs, BitmaskData const& rhs)
     {
         if (lhs.empty()) {
@@ -136,12 +160,12 @@ namespace Conformance
         return *this;
     }
 
-    GeneratorWrapper<BitmaskData const&> bitmaskGeneratorIncluding0(std::initializer_list<BitmaskData> const& bits)
+    GeneratorWrapper<BitmaskCombination const&> bitmaskGeneratorIncluding0(std::initializer_list<BitmaskData> const& bits)
     {
         return {BitmaskGenerator::create(true, bits)};
     }
 
-    GeneratorWrapper<BitmaskData const&> bitmaskGenerator(std::initializer_list<BitmaskData> const& bits)
+    GeneratorWrapper<BitmaskCombination const&> bitmaskGenerator(std::initializer_list<BitmaskData> const& bits)
     {
         return {BitmaskGenerator::create(false, bits)};
     }
@@ -29,8 +29,10 @@
 
 #include "generator.h"
 
+#include <cstdint>
 #include <initializer_list>
 #include <string>
+#include <vector>
 
 namespace Conformance
 {
@@ -59,6 +61,51 @@ namespace Conformance
      */
     BitmaskData operator|(BitmaskData const& lhs, BitmaskData const& rhs);
 
+    /*!
+     * One combination of a list of bitmasks: the combined bits, plus what is needed to describe them.
+     *
+     * The combined description is only built when description() is called, for example when reporting a failure,
+     * so stepping through combinations does not allocate. Only valid while the BitmaskCombinations or generator
+     * that produced it exists.
+     */
+    struct BitmaskCombination
+    {
+        uint64_t bitmask;
+
+        /// Which of the supplied bitmasks are combined, as a bitmask over their indices.
+        uint64_t selection;
+
+        const std::vector<BitmaskData>* bits;
+
+        /// The descriptions of the combined bitmasks, joined as operator| does.
+        std::string description() const;
+
+        /// The combination as a BitmaskData, including its description.
+        BitmaskData toBitmaskData() const;
+    };
+
+    /*!
+     * Every combination of the supplied list of bitmasks, computed on demand by index rather than stored.
+     *
+     * Combinations are in the same order the generators produce them.
+     */
+    class BitmaskCombinations
+    {
+    public:
+        /// Fewer than 64 bitmasks may be supplied.
+        BitmaskCombinations(bool zeroOk, std::initializer_list<BitmaskData> const& bits);
+
+        /// The number of combinations: 2^N if zeroOk, otherwise 2^N - 1.
+        uint64_t size() const;
+
+        /// Computes the combination at an index below size(), in constant time apart from OR-ing the selected bits.
+        BitmaskCombination operator[](uint64_t index) const;
+
+    private:
+        std::vector<BitmaskData> bits_;
+        bool zeroOk_;
+    };
+
     /*!
      * Generate all combinations of the supplied list of bitmasks,
      * including the 0 combination with none of the element (and thus bits).
@@ -68,7 +115,7 @@ namespace Conformance
      *
      * @ingroup Generators
      */
-    GeneratorWrapper<BitmaskData const&> bitmaskGeneratorIncluding0(std::initializer_list<BitmaskData> const& bits);
+    GeneratorWrapper<BitmaskCombination const&> bitmaskGeneratorIncluding0(std::initializer_list<BitmaskData> const& bits);
 
     /*!
      * Generate all combinations of the supplied list of bitmasks that include at least one set element.
@@ -80,6 +127,6 @@ namespace Conformance
      *
      * @ingroup Generators
      */
-    GeneratorWrapper<BitmaskData const&> bitmaskGenerator(std::initializer_list<BitmaskData> const& bits);
+    GeneratorWrapper<BitmaskCombination const&> bitmaskGenerator(std::initializer_list<BitmaskData> const& bits);
 
 }  // namespace Conformance
@@ -0,0 +1,89 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "call_trace.h"
+
+#include "call_trace_format.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace Conformance
+{
+    namespace
+    {
+        using namespace CallTraceFormat;
+
+        template <typename T>
+        T ReadAt(const std::vector<char>& data, size_t offset)
+        {
+            T value;
+            std::memcpy(&value, data.data() + offset, sizeof(T));
+            return value;
+        }
+    }  // namespace
+
+    bool ReadCallTrace(const std::string& path, CallTrace& trace, std::string& error)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            error = "unable to open " + path;
+            return false;
+        }
+        const std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (data.size() < RecordsOffset || std::memcmp(data.data(), Magic, MagicSize) != 0 ||
+            ReadAt<uint32_t>(data, VersionOffset) != Version || ReadAt<uint32_t>(data, RecordSizeOffset) != RecordSize) {
+            error = path + " is not a version 1 conformance layer call trace";
+            return false;
+        }
+
+        const uint64_t capacity = ReadAt<uint64_t>(data, RecordCapacityOffset);
+        const uint32_t functionCount = std::min(ReadAt<uint32_t>(data, FunctionCountOffset), MaxFunctions);
+        if (data.size() < RecordsOffset + capacity * RecordSize) {
+            error = path + " is truncated";
+            return false;
+        }
+        trace.threadCount = ReadAt<uint32_t>(data, ThreadCountOffset);
+        const uint64_t reserved = ReadAt<uint64_t>(data, RecordsReservedOffset);
+        trace.overwrittenCount = reserved > capacity ? reserved - capacity : 0;
+
+        trace.functionNames.clear();
+        for (uint32_t i = 0; i < functionCount; ++i) {
+            const char* const name = data.data() + HeaderSize + i * FunctionNameSize;
+            trace.functionNames.emplace_back(name, strnlen(name, FunctionNameSize));
+        }
+
+        trace.records.clear();
+        for (uint64_t i = 0; i < capacity; ++i) {
+            const size_t offset = (size_t)(RecordsOffset + i * RecordSize);
+            CallTraceRecord record;
+            record.startNs = ReadAt<int64_t>(data, offset + RecordStartOffset);
+            if (record.startNs == 0) {
+                continue;  // Never written.
+            }
+            record.handle = ReadAt<uint64_t>(data, offset + RecordHandleOffset);
+            record.result = ReadAt<int32_t>(data, offset + RecordResultOffset);
+            record.durationNs = ReadAt<uint32_t>(data, offset + RecordDurationOffset);
+            record.threadIndex = ReadAt<uint32_t>(data, offset + RecordThreadOffset);
+            record.functionId = ReadAt<uint16_t>(data, offset + RecordFunctionOffset);
+            trace.records.push_back(record);
+        }
+        std::sort(trace.records.begin(), trace.records.end(),
+                  [](const CallTraceRecord& a, const CallTraceRecord& b) { return a.startNs < b.startNs; });
+        return true;
+    }
+}  // namespace Conformance
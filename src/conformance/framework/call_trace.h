@@ -0,0 +1,47 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Conformance
+{
+    // One call recorded by the conformance layer's call trace (XR_CONFORMANCE_LAYER_TRACE).
+    struct CallTraceRecord
+    {
+        int64_t startNs;  // steady clock of the traced process
+        uint64_t handle;  // the first parameter
+        int32_t result;
+        uint32_t durationNs;
+        uint32_t threadIndex;
+        uint16_t functionId;  // index into CallTrace::functionNames
+    };
+
+    struct CallTrace
+    {
+        std::vector<std::string> functionNames;
+        std::vector<CallTraceRecord> records;  // in start time order
+        uint32_t threadCount{0};
+        uint64_t overwrittenCount{0};  // calls lost because the ring wrapped
+    };
+
+    // Reads a trace file written by the conformance layer. The format is described in call_trace_format.h.
+    // Returns false with a description in error if the file cannot be read or is not a trace.
+    bool ReadCallTrace(const std::string& path, CallTrace& trace, std::string& error);
+}  // namespace Conformance
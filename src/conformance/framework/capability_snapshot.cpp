@@ -0,0 +1,261 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "capability_snapshot.h"
+#include "results_stream.h"
+#include "utils.h"
+#include "platform_utils.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+namespace Conformance
+{
+    namespace
+    {
+        // The snapshot is a JSON lines file: a capabilitySnapshot line, one line per instance extension, a system line
+        // followed by one line per view configuration when there is a system, and an end line, so that a file cut
+        // short is not used.
+        constexpr uint64_t ViewFieldCount = 6;
+
+        bool ParseJsonUnsigned(const char* c, uint64_t& value)
+        {
+            if (c == nullptr) {
+                return false;
+            }
+            char* end = nullptr;
+            value = strtoull(c, &end, 10);
+            return end != c;
+        }
+
+        bool ParseJsonBool(const char* c, bool& value)
+        {
+            if (c == nullptr) {
+                return false;
+            }
+            value = strncmp(c, "true", 4) == 0;
+            return value || strncmp(c, "false", 5) == 0;
+        }
+
+        bool ParseJsonIntegers(const char* c, std::vector<int64_t>& values)
+        {
+            if (c == nullptr || *c++ != '[') {
+                return false;
+            }
+            values.clear();
+            while (*c != ']') {
+                char* end = nullptr;
+                values.push_back(static_cast<int64_t>(strtoll(c, &end, 10)));
+                if (end == c) {
+                    return false;
+                }
+                c = *end == ',' ? end + 1 : end;
+            }
+            return true;
+        }
+
+        bool ParseJsonStringValue(const std::string& line, const char* key, std::string& value)
+        {
+            const char* c = FindJsonValue(line, key);
+            return c != nullptr && ParseJsonString(c, value);
+        }
+
+        template <size_t Size>
+        void CopyString(char (&destination)[Size], const std::string& source)
+        {
+            strncpy(destination, source.c_str(), Size - 1);
+            destination[Size - 1] = '\0';
+        }
+    }  // namespace
+
+    std::string DescribeCapabilityEnvironment(const Options& options)
+    {
+        std::string environment;
+        AppendSprintf(environment, "graphicsPlugin=%s formFactor=%d", options.graphicsPlugin.c_str(), (int)options.formFactorValue);
+        for (const std::string& layer : options.enabledAPILayers) {
+            environment += " layer=" + layer;
+        }
+        for (const char* variable : {"XR_RUNTIME_JSON", "XR_API_LAYER_PATH"}) {
+            environment += std::string(" ") + variable + "=" + PlatformUtilsGetEnv(variable);
+        }
+        return environment;
+    }
+
+    bool ReadCapabilitySnapshot(const std::string& path, CapabilitySnapshot& snapshot)
+    {
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            return false;
+        }
+
+        CapabilitySnapshot read;
+        std::shared_ptr<SystemSnapshot> system;
+        bool started = false;
+        std::string line;
+        std::string record;
+        while (std::getline(file, line)) {
+            if (!ParseJsonStringValue(line, "record", record)) {
+                return false;
+            }
+
+            if (record == "capabilitySnapshot") {
+                uint64_t version = 0;
+                if (!ParseJsonStringValue(line, "environment", read.environment) ||
+                    !ParseJsonStringValue(line, "runtimeName", read.runtimeName) ||
+                    !ParseJsonUnsigned(FindJsonValue(line, "runtimeVersion"), version)) {
+                    return false;
+                }
+                read.runtimeVersion = version;
+                started = true;
+            }
+            else if (!started) {
+                return false;
+            }
+            else if (record == "instanceExtension") {
+                XrExtensionProperties extension{XR_TYPE_EXTENSION_PROPERTIES};
+                std::string name;
+                uint64_t version = 0;
+                if (!ParseJsonStringValue(line, "name", name) || !ParseJsonUnsigned(FindJsonValue(line, "version"), version)) {
+                    return false;
+                }
+                CopyString(extension.extensionName, name);
+                extension.extensionVersion = (uint32_t)version;
+                read.instanceExtensions.push_back(extension);
+            }
+            else if (record == "system") {
+                system = std::make_shared<SystemSnapshot>();
+                XrSystemProperties& properties = system->systemProperties;
+                std::string systemName;
+                uint64_t systemId = 0, vendorId = 0, maxWidth = 0, maxHeight = 0, maxLayerCount = 0;
+                bool orientationTracking = false, positionTracking = false;
+                if (!ParseJsonUnsigned(FindJsonValue(line, "systemId"), systemId) ||
+                    !ParseJsonUnsigned(FindJsonValue(line, "vendorId"), vendorId) ||
+                    !ParseJsonStringValue(line, "systemName", systemName) ||
+                    !ParseJsonUnsigned(FindJsonValue(line, "maxSwapchainImageWidth"), maxWidth) ||
+                    !ParseJsonUnsigned(FindJsonValue(line, "maxSwapchainImageHeight"), maxHeight) ||
+                    !ParseJsonUnsigned(FindJsonValue(line, "maxLayerCount"), maxLayerCount) ||
+                    !ParseJsonBool(FindJsonValue(line, "orientationTracking"), orientationTracking) ||
+                    !ParseJsonBool(FindJsonValue(line, "positionTracking"), positionTracking)) {
+                    return false;
+                }
+                properties.systemId = (XrSystemId)systemId;
+                properties.vendorId = (uint32_t)vendorId;
+                CopyString(properties.systemName, systemName);
+                properties.graphicsProperties.maxSwapchainImageWidth = (uint32_t)maxWidth;
+                properties.graphicsProperties.maxSwapchainImageHeight = (uint32_t)maxHeight;
+                properties.graphicsProperties.maxLayerCount = (uint32_t)maxLayerCount;
+                properties.trackingProperties.orientationTracking = orientationTracking ? XR_TRUE : XR_FALSE;
+                properties.trackingProperties.positionTracking = positionTracking ? XR_TRUE : XR_FALSE;
+                read.system = system;
+            }
+            else if (record == "viewConfiguration") {
+                SystemSnapshot::ViewConfiguration viewConfiguration;
+                uint64_t type = 0;
+                bool fovMutable = false;
+                std::vector<int64_t> views;
+                std::vector<int64_t> blendModes;
+                if (system == nullptr || !ParseJsonUnsigned(FindJsonValue(line, "type"), type) ||
+                    !ParseJsonBool(FindJsonValue(line, "fovMutable"), fovMutable) ||
+                    !ParseJsonIntegers(FindJsonValue(line, "views"), views) || views.size() % ViewFieldCount != 0 ||
+                    !ParseJsonIntegers(FindJsonValue(line, "blendModes"), blendModes)) {
+                    return false;
+                }
+                viewConfiguration.type = (XrViewConfigurationType)type;
+                viewConfiguration.properties.viewConfigurationType = viewConfiguration.type;
+                viewConfiguration.properties.fovMutable = fovMutable ? XR_TRUE : XR_FALSE;
+                for (size_t i = 0; i < views.size(); i += ViewFieldCount) {
+                    XrViewConfigurationView view{XR_TYPE_VIEW_CONFIGURATION_VIEW};
+                    view.recommendedImageRectWidth = (uint32_t)views[i];
+                    view.maxImageRectWidth = (uint32_t)views[i + 1];
+                    view.recommendedImageRectHeight = (uint32_t)views[i + 2];
+                    view.maxImageRectHeight = (uint32_t)views[i + 3];
+                    view.recommendedSwapchainSampleCount = (uint32_t)views[i + 4];
+                    view.maxSwapchainSampleCount = (uint32_t)views[i + 5];
+                    viewConfiguration.views.push_back(view);
+                }
+                for (int64_t blendMode : blendModes) {
+                    viewConfiguration.environmentBlendModes.push_back((XrEnvironmentBlendMode)blendMode);
+                }
+                system->viewConfigurationTypes.push_back(viewConfiguration.type);
+                system->viewConfigurations.push_back(std::move(viewConfiguration));
+            }
+            else if (record == "end") {
+                snapshot = std::move(read);
+                return true;
+            }
+            else {
+                return false;
+            }
+        }
+        return false;
+    }
+
+    bool WriteCapabilitySnapshot(const std::string& path, const CapabilitySnapshot& snapshot)
+    {
+        // Built in memory and written at once, since the shards of a run may read the file while it is written.
+        std::string text;
+        auto writeLine = [&](const JsonLine& line) {
+            text += line.String();
+            text += '\n';
+        };
+
+        writeLine(JsonLine()
+                      .Add("record", "capabilitySnapshot")
+                      .Add("environment", snapshot.environment)
+                      .Add("runtimeName", snapshot.runtimeName)
+                      .Add("runtimeVersion", static_cast<uint64_t>(snapshot.runtimeVersion)));
+        for (const XrExtensionProperties& extension : snapshot.instanceExtensions) {
+            writeLine(JsonLine()
+                          .Add("record", "instanceExtension")
+                          .Add("name", extension.extensionName)
+                          .Add("version", static_cast<uint64_t>(extension.extensionVersion)));
+        }
+
+        if (snapshot.system != nullptr) {
+            const XrSystemProperties& properties = snapshot.system->systemProperties;
+            writeLine(JsonLine()
+                          .Add("record", "system")
+                          .Add("systemId", static_cast<uint64_t>(properties.systemId))
+                          .Add("vendorId", static_cast<uint64_t>(properties.vendorId))
+                          .Add("systemName", properties.systemName)
+                          .Add("maxSwapchainImageWidth", static_cast<uint64_t>(properties.graphicsProperties.maxSwapchainImageWidth))
+                          .Add("maxSwapchainImageHeight", static_cast<uint64_t>(properties.graphicsProperties.maxSwapchainImageHeight))
+                          .Add("maxLayerCount", static_cast<uint64_t>(properties.graphicsProperties.maxLayerCount))
+                          .Add("orientationTracking", properties.trackingProperties.orientationTracking == XR_TRUE)
+                          .Add("positionTracking", properties.trackingProperties.positionTracking == XR_TRUE));
+
+            for (const SystemSnapshot::ViewConfiguration& viewConfiguration : snapshot.system->viewConfigurations) {
+                std::vector<int64_t> views;
+                for (const XrViewConfigurationView& view : viewConfiguration.views) {
+                    views.insert(views.end(), {view.recommendedImageRectWidth, view.maxImageRectWidth, view.recommendedImageRectHeight,
+                                               view.maxImageRectHeight, view.recommendedSwapchainSampleCount, view.maxSwapchainSampleCount});
+                }
+                static_assert(ViewFieldCount == 6, "views holds six fields per view");
+                std::vector<int64_t> blendModes(viewConfiguration.environmentBlendModes.begin(),
+                                                viewConfiguration.environmentBlendModes.end());
+                writeLine(JsonLine()
+                              .Add("record", "viewConfiguration")
+                              .Add("type", static_cast<uint64_t>(viewConfiguration.type))
+                              .Add("fovMutable", viewConfiguration.properties.fovMutable == XR_TRUE)
+                              .Add("views", views)
+                              .Add("blendModes", blendModes));
+            }
+        }
+
+        writeLine(JsonLine().Add("record", "end"));
+        return WriteFileReplacing(path, text.data(), text.size());
+    }
+}  // namespace Conformance
@@ -0,0 +1,56 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "conformance_framework.h"
+#include <openxr/openxr.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Conformance
+{
+    // What GlobalData::Initialize learns about the runtime by probing it, kept in Options::capabilitySnapshotFile so
+    // that later runs against the same runtime, such as the shards of one run, can skip the probing. Layers are not
+    // kept: the loader lists them from their manifests without loading the runtime.
+    struct CapabilitySnapshot
+    {
+        // From DescribeCapabilityEnvironment; a snapshot taken in a different environment is not used.
+        std::string environment;
+
+        // From xrGetInstanceProperties. A snapshot whose runtime differs from the one the probe instance reports is
+        // taken again.
+        std::string runtimeName;
+        XrVersion runtimeVersion{0};
+
+        std::vector<XrExtensionProperties> instanceExtensions;
+
+        // The system of Options::formFactorValue, or null if the runtime had none available.
+        std::shared_ptr<const SystemSnapshot> system;
+    };
+
+    // Describes what selects the runtime and what it is asked for before an instance exists: the graphics plugin, the
+    // form factor, the enabled API layers and the loader's runtime and layer overrides.
+    std::string DescribeCapabilityEnvironment(const Options& options);
+
+    // Returns false if the file could not be opened or does not hold a whole snapshot.
+    bool ReadCapabilitySnapshot(const std::string& path, CapabilitySnapshot& snapshot);
+
+    // Writes the file with WriteFileReplacing, so a reader never sees it cut short. Returns false if the file could not
+    // be written.
+    bool WriteCapabilitySnapshot(const std::string& path, const CapabilitySnapshot& snapshot);
+}  // namespace Conformance
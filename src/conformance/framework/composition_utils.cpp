@@ -18,11 +18,19 @@
 #include "utils.h"
 #include "report.h"
 #include "conformance_framework.h"
+#include "trace_scope.h"
+#include "two_call_util.h"
+#include <algorithm>
+#include <cmath>
 #include <fstream>
 #include <array>
+#include <list>
+#include <mutex>
 #include <string>
 #include <cstring>
+#include <exception>
 #include <thread>
+#include <future>
 #include <condition_variable>
 #include <catch2/catch.hpp>
 #include <xr_linear.h>
@@ -31,51 +39,356 @@ using namespace std::chrono_literals;
 
 namespace Conformance
 {
+    namespace
+    {
+        RGBAImage RenderTextImage(int width, int height, const char* text, int fontHeight)
+        {
+            constexpr int FontPaddingPixels = 4;
+            constexpr int BorderPixels = 2;
+            constexpr int InsetPixels = BorderPixels + FontPaddingPixels;
+
+            RGBAImage image(width, height);
+            image.DrawRect(0, 0, image.width, image.height, {0, 0, 0, 0.5f});
+            image.DrawRectBorder(0, 0, image.width, image.height, BorderPixels, {1, 1, 1, 1});
+            image.PutText(XrRect2Di{{InsetPixels, InsetPixels}, {image.width - InsetPixels * 2, image.height - InsetPixels * 2}},
+                          text, fontHeight, {1, 1, 1, 1});
+            return image;
+        }
+
+        struct TextImageKey
+        {
+            std::string text;
+            int width;
+            int height;
+            int fontHeight;
+
+            bool operator==(const TextImageKey& other) const
+            {
+                return width == other.width && height == other.height && fontHeight == other.fontHeight && text == other.text;
+            }
+        };
+    }  // namespace
+
     RGBAImage CreateTextImage(int width, int height, const char* text, int fontHeight)
     {
-        constexpr int FontPaddingPixels = 4;
-        constexpr int BorderPixels = 2;
-        constexpr int InsetPixels = BorderPixels + FontPaddingPixels;
+        // Tests build the same instruction and title images again and again, so the most recent ones are kept,
+        // most recently used first, up to a pixel budget rather than a count, since one full-view image is as
+        // large as hundreds of title bars.
+        constexpr size_t CacheBudgetBytes = 4 * 1024 * 1024;
+        static std::mutex s_mutex;
+        static std::list<std::pair<TextImageKey, RGBAImage>> s_cache;
+        static size_t s_cacheBytes = 0;
+
+        TextImageKey key{text, width, height, fontHeight};
+        {
+            std::lock_guard<std::mutex> lock(s_mutex);
+            for (auto it = s_cache.begin(); it != s_cache.end(); ++it) {
+                if (it->first == key) {
+                    s_cache.splice(s_cache.begin(), s_cache, it);
+                    return it->second;
+                }
+            }
+        }
+
+        RGBAImage image = RenderTextImage(width, height, text, fontHeight);
+
+        const size_t imageBytes = image.pixels.size() * sizeof(RGBA8Color);
+        if (imageBytes > CacheBudgetBytes) {
+            return image;
+        }
 
-        RGBAImage image(width, height);
-        image.DrawRect(0, 0, image.width, image.height, {0, 0, 0, 0.5f});
-        image.DrawRectBorder(0, 0, image.width, image.height, BorderPixels, {1, 1, 1, 1});
-        image.PutText(XrRect2Di{{InsetPixels, InsetPixels}, {image.width - InsetPixels * 2, image.height - InsetPixels * 2}}, text,
-                      fontHeight, {1, 1, 1, 1});
+        std::lock_guard<std::mutex> lock(s_mutex);
+        s_cache.emplace_front(std::move(key), image);
+        s_cacheBytes += imageBytes;
+        while (s_cacheBytes > CacheBudgetBytes) {
+            s_cacheBytes -= s_cache.back().second.pixels.size() * sizeof(RGBA8Color);
+            s_cache.pop_back();
+        }
         return image;
     }
 
     XrPath StringToPath(XrInstance instance, const char* pathStr)
     {
         XrPath path;
-        XRC_CHECK_THROW_XRCMD(xrStringToPath(instance, pathStr, &path));
+        XRC_CHECK_THROW_XRCMD(CachedStringToPath(instance, pathStr, &path));
         return path;
     }
 
     using UpdateLayers = std::function<void(const XrFrameState&)>;
     using EndFrame = std::function<bool(const XrFrameState&)>;
 
+    namespace
+    {
+        // Asks xrWaitFrame for the state of the secondary view configuration of a helper, if it has one.
+        struct SecondaryViewWaitState
+        {
+            XrSecondaryViewConfigurationStateMSFT state{XR_TYPE_SECONDARY_VIEW_CONFIGURATION_STATE_MSFT};
+            XrSecondaryViewConfigurationFrameStateMSFT frameState{XR_TYPE_SECONDARY_VIEW_CONFIGURATION_FRAME_STATE_MSFT};
+
+            void Chain(const CompositionHelper* compositionHelper, XrFrameState& waitFrameState)
+            {
+                if (compositionHelper == nullptr ||
+                    compositionHelper->GetSecondaryViewConfigurationType() == XR_VIEW_CONFIGURATION_TYPE_MAX_ENUM) {
+                    return;
+                }
+                state.viewConfigurationType = compositionHelper->GetSecondaryViewConfigurationType();
+                frameState.viewConfigurationCount = 1;
+                frameState.viewConfigurationStates = &state;
+                waitFrameState.next = &frameState;
+            }
+
+            bool IsActive() const
+            {
+                return frameState.viewConfigurationCount != 0 && state.active == XR_TRUE;
+            }
+        };
+    }  // namespace
+
+    RenderLoop::RenderLoop(CompositionHelper& compositionHelper, EndFrame endFrame)
+        : m_session(compositionHelper.GetSession()), m_compositionHelper(&compositionHelper), m_endFrame(endFrame)
+    {
+    }
+
     bool RenderLoop::IterateFrame()
     {
+        XR_TRACE_SCOPE("RenderLoop::IterateFrame");
+
+        using clock = MonotonicClock;
+
+        SpinFor(m_cpuLoad.beforeWait);
+
         XrFrameState frameState{XR_TYPE_FRAME_STATE};
+        SecondaryViewWaitState secondaryViewState;
+        secondaryViewState.Chain(m_compositionHelper, frameState);
         XrFrameWaitInfo waitInfo{XR_TYPE_FRAME_WAIT_INFO};
-        XRC_CHECK_THROW_XRCMD(xrWaitFrame(m_session, &waitInfo, &frameState));
+        {
+            ScopedCpuCounters counting(m_stageTimings.cpuCounters);
+            const clock::time_point waitStart = clock::now();
+            XRC_CHECK_THROW_XRCMD(xrWaitFrame(m_session, &waitInfo, &frameState));
+            const clock::time_point beginStart = clock::now();
+            m_stageTimings.wait += beginStart - waitStart;
+
+            m_lastPredictedDisplayTime.store(frameState.predictedDisplayTime);
 
-        m_lastPredictedDisplayTime.store(frameState.predictedDisplayTime);
+            XrFrameBeginInfo beginInfo{XR_TYPE_FRAME_BEGIN_INFO};
+            XRC_CHECK_THROW_XRCMD(xrBeginFrame(m_session, &beginInfo));
+            m_stageTimings.begin += clock::now() - beginStart;
+        }
+
+        SpinFor(m_cpuLoad.BeforeRender(m_stageTimings.frameCount));
+
+        if (m_compositionHelper != nullptr) {
+            m_compositionHelper->SetSecondaryViewActive(secondaryViewState.IsActive());
+        }
+        bool keepRunning;
+        {
+            ScopedCpuCounters counting(m_stageTimings.cpuCounters);
+            const clock::time_point endFrameStart = clock::now();
+            keepRunning = m_endFrame(frameState);
+            m_stageTimings.endFrame += clock::now() - endFrameStart;
+        }
+        m_stageTimings.frameCount++;
+        XR_TRACE_FRAME_MARK("RenderLoop");
 
-        XrFrameBeginInfo beginInfo{XR_TYPE_FRAME_BEGIN_INFO};
-        XRC_CHECK_THROW_XRCMD(xrBeginFrame(m_session, &beginInfo));
-        return m_endFrame(frameState);
+        SpinFor(m_cpuLoad.afterEnd);
+        return keepRunning;
     }
 
     void RenderLoop::Loop()
     {
+        ATTACH_THREAD;
+        ScopedThreadScheduling scheduling(GetGlobalData().options.frameLoopScheduling);
         CHECK_NOTHROW([&]() {
             while (IterateFrame()) {
             }
         }());
     }
 
+    namespace
+    {
+        // Fixed-capacity single-producer single-consumer queue. Only the producer writes m_writeIndex and only the
+        // consumer writes m_readIndex, so neither side needs a lock.
+        template <typename T, size_t Capacity>
+        class SpscQueue
+        {
+        public:
+            bool TryPush(const T& value)
+            {
+                const size_t write = m_writeIndex.load(std::memory_order_relaxed);
+                if (write - m_readIndex.load(std::memory_order_acquire) == Capacity) {
+                    return false;
+                }
+                m_items[write % Capacity] = value;
+                m_writeIndex.store(write + 1, std::memory_order_release);
+                return true;
+            }
+
+            bool TryPop(T& value)
+            {
+                const size_t read = m_readIndex.load(std::memory_order_relaxed);
+                if (m_writeIndex.load(std::memory_order_acquire) == read) {
+                    return false;
+                }
+                value = m_items[read % Capacity];
+                m_readIndex.store(read + 1, std::memory_order_release);
+                return true;
+            }
+
+        private:
+            std::array<T, Capacity> m_items{};
+            std::atomic<size_t> m_writeIndex{0};
+            std::atomic<size_t> m_readIndex{0};
+        };
+
+        struct WaitedFrame
+        {
+            XrFrameState frameState;
+            MonotonicClock::time_point waitReturned;
+            bool secondaryViewActive;
+        };
+    }  // namespace
+
+    void RenderLoop::PipelinedLoop()
+    {
+        ATTACH_THREAD;
+        ScopedThreadScheduling scheduling(GetGlobalData().options.frameLoopScheduling);
+        CHECK_NOTHROW(RunPipelined());
+    }
+
+    void RenderLoop::RunPipelined()
+    {
+        using clock = MonotonicClock;
+
+        // xrWaitFrame does not return until the previous frame has begun, so the wait thread is at most one frame ahead.
+        SpscQueue<WaitedFrame, 4> waitedFrames;
+        std::atomic<bool> stopWaiting{false};
+        std::atomic<bool> waitThreadDone{false};
+        std::exception_ptr waitError;
+        // Added to the stage timings once the wait thread has exited, as the render thread counts into them meanwhile.
+        CpuCounters waitThreadCpuCounters;
+
+        std::thread waitThread([&] {
+            ATTACH_THREAD;
+            ScopedThreadScheduling scheduling(GetGlobalData().options.frameLoopScheduling);
+            try {
+                while (!stopWaiting.load()) {
+                    SpinFor(m_cpuLoad.beforeWait);
+
+                    WaitedFrame waited{{XR_TYPE_FRAME_STATE}, {}, false};
+                    SecondaryViewWaitState secondaryViewState;
+                    secondaryViewState.Chain(m_compositionHelper, waited.frameState);
+                    XrFrameWaitInfo waitInfo{XR_TYPE_FRAME_WAIT_INFO};
+                    const clock::time_point waitStart = clock::now();
+                    {
+                        ScopedCpuCounters counting(waitThreadCpuCounters);
+                        XRC_CHECK_THROW_XRCMD(xrWaitFrame(m_session, &waitInfo, &waited.frameState));
+                    }
+                    waited.waitReturned = clock::now();
+                    // The chained state stays on this thread.
+                    waited.frameState.next = nullptr;
+                    waited.secondaryViewActive = secondaryViewState.IsActive();
+                    m_stageTimings.wait += waited.waitReturned - waitStart;
+
+                    m_lastPredictedDisplayTime.store(waited.frameState.predictedDisplayTime);
+
+                    while (!waitedFrames.TryPush(waited)) {
+                        std::this_thread::yield();
+                    }
+                }
+            }
+            catch (...) {
+                waitError = std::current_exception();
+            }
+            waitThreadDone.store(true);
+        });
+
+        // Returns false once the wait thread has exited and every frame it waited for has been taken.
+        auto takeWaitedFrame = [&](WaitedFrame& waited) {
+            while (!waitedFrames.TryPop(waited)) {
+                if (waitThreadDone.load()) {
+                    return waitedFrames.TryPop(waited);
+                }
+                std::this_thread::yield();
+            }
+            return true;
+        };
+
+        auto beginFrame = [&](const WaitedFrame& waited) {
+            ScopedCpuCounters counting(m_stageTimings.cpuCounters);
+            const clock::time_point beginStart = clock::now();
+            m_stageTimings.handOff += beginStart - waited.waitReturned;
+            XrFrameBeginInfo beginInfo{XR_TYPE_FRAME_BEGIN_INFO};
+            XRC_CHECK_THROW_XRCMD(xrBeginFrame(m_session, &beginInfo));
+            m_stageTimings.begin += clock::now() - beginStart;
+        };
+
+        std::exception_ptr renderError;
+        WaitedFrame waited{};
+        bool unbegunFrame = false;
+        try {
+            while (takeWaitedFrame(waited)) {
+                unbegunFrame = true;
+                beginFrame(waited);
+                unbegunFrame = false;
+
+                SpinFor(m_cpuLoad.BeforeRender(m_stageTimings.frameCount));
+
+                if (m_compositionHelper != nullptr) {
+                    m_compositionHelper->SetSecondaryViewActive(waited.secondaryViewActive);
+                }
+                bool keepRunning;
+                {
+                    ScopedCpuCounters counting(m_stageTimings.cpuCounters);
+                    const clock::time_point endFrameStart = clock::now();
+                    keepRunning = m_endFrame(waited.frameState);
+                    m_stageTimings.endFrame += clock::now() - endFrameStart;
+                }
+                m_stageTimings.frameCount++;
+                if (!keepRunning) {
+                    break;
+                }
+
+                SpinFor(m_cpuLoad.afterEnd);
+            }
+        }
+        catch (...) {
+            renderError = std::current_exception();
+        }
+
+        // The wait thread may be blocked in xrWaitFrame until the frame it waited for last has begun, so submit every
+        // frame it still hands over, with no layers, until it has exited.
+        stopWaiting.store(true);
+        try {
+            auto submitEmptyFrame = [&](const WaitedFrame& frame) {
+                beginFrame(frame);
+                XrFrameEndInfo frameEndInfo{XR_TYPE_FRAME_END_INFO};
+                frameEndInfo.environmentBlendMode = GetGlobalData().GetOptions().environmentBlendModeValue;
+                frameEndInfo.displayTime = frame.frameState.predictedDisplayTime;
+                XRC_CHECK_THROW_XRCMD(xrEndFrame(m_session, &frameEndInfo));
+            };
+            if (unbegunFrame) {
+                submitEmptyFrame(waited);
+            }
+            while (takeWaitedFrame(waited)) {
+                submitEmptyFrame(waited);
+            }
+        }
+        catch (...) {
+            if (!renderError) {
+                renderError = std::current_exception();
+            }
+        }
+        waitThread.join();
+        m_stageTimings.cpuCounters += waitThreadCpuCounters;
+
+        if (renderError) {
+            std::rethrow_exception(renderError);
+        }
+        if (waitError) {
+            std::rethrow_exception(waitError);
+        }
+    }
+
     XrTime RenderLoop::GetLastPredictedDisplayTime() const
     {
         return m_lastPredictedDisplayTime.load();
@@ -134,16 +447,64 @@ namespace Conformance
         m_primaryViewType = GetGlobalData().GetOptions().viewConfigurationValue;
 
         XRC_CHECK_THROW_XRCMD(CreateBasicInstance(m_instance.resetAndGetAddress(), true, additionalEnabledExtensions));
+        m_instanceHandle = m_instance.get();
+        EnablePathCache(m_instanceHandle);
 
-        m_eventQueue = std::unique_ptr<EventQueue>(new EventQueue(m_instance.get()));
+        m_eventQueue = std::make_shared<EventQueue>(m_instanceHandle);
         m_privateEventReader = std::unique_ptr<EventReader>(new EventReader(*m_eventQueue));
 
-        XRC_CHECK_THROW_XRCMD(CreateBasicSession(m_instance.get(), &m_systemId, &m_session));
+        XRC_CHECK_THROW_XRCMD(CreateBasicSession(m_instanceHandle, &m_systemId, &m_session));
 
-        XRC_CHECK_THROW_XRCMD(
-            xrEnumerateViewConfigurationViews(m_instance.get(), m_systemId, m_primaryViewType, 0, &m_projectionViewCount, nullptr));
+        InitializeSession(testName);
+    }
+
+    CompositionHelper::CompositionHelper(CompositionHelper& mainHelper, const char* testName, uint32_t sessionLayersPlacement)
+        : m_instanceHandle(mainHelper.m_instanceHandle), m_systemId(mainHelper.m_systemId), m_ownsDevice(false),
+          m_eventQueue(mainHelper.m_eventQueue)
+    {
+        m_primaryViewType = GetGlobalData().GetOptions().viewConfigurationValue;
+        m_privateEventReader = std::unique_ptr<EventReader>(new EventReader(*m_eventQueue));
+
+        // The graphics requirements have been checked on this instance and the device created by mainHelper.
+        GlobalData& globalData = GetGlobalData();
+        XrSessionCreateInfoOverlayEXTX overlayCreateInfo{XR_TYPE_SESSION_CREATE_INFO_OVERLAY_EXTX};
+        overlayCreateInfo.next = globalData.IsUsingGraphicsPlugin() ? globalData.GetGraphicsPlugin()->GetGraphicsBinding() : nullptr;
+        overlayCreateInfo.sessionLayersPlacement = sessionLayersPlacement;
+        XrSessionCreateInfo sessionCreateInfo{XR_TYPE_SESSION_CREATE_INFO, &overlayCreateInfo, 0, m_systemId};
+        XRC_CHECK_THROW_XRCMD(xrCreateSession(m_instanceHandle, &sessionCreateInfo, &m_session));
+
+        InitializeSession(testName);
+    }
 
-        m_interactionManager = std::make_unique<InteractionManager>(m_instance.get(), m_session);
+    void CompositionHelper::InitializeSession(const char* testName)
+    {
+        const std::shared_ptr<const SystemSnapshot> snapshot = GetGlobalData().GetSystemSnapshot(m_instanceHandle, m_systemId);
+        const SystemSnapshot::ViewConfiguration* primaryViewConfiguration = snapshot->FindViewConfiguration(m_primaryViewType);
+        XRC_CHECK_THROW_MSG(primaryViewConfiguration != nullptr, "The system does not support the selected view configuration");
+        m_projectionViewCount = (uint32_t)primaryViewConfiguration->views.size();
+
+        const XrViewConfigurationType secondaryViewType = GetGlobalData().GetOptions().secondaryViewConfigurationValue;
+        if (secondaryViewType != XR_VIEW_CONFIGURATION_TYPE_MAX_ENUM) {
+            if (const SystemSnapshot::ViewConfiguration* secondaryViewConfiguration = snapshot->FindViewConfiguration(secondaryViewType)) {
+                m_secondaryViewType = secondaryViewType;
+                m_secondaryViewCount = (uint32_t)secondaryViewConfiguration->views.size();
+
+                // The blend mode of the primary views need not be one the secondary views support, so take their preferred one.
+                if (!secondaryViewConfiguration->environmentBlendModes.empty()) {
+                    m_secondaryBlendMode = secondaryViewConfiguration->environmentBlendModes[0];
+                }
+            }
+            else {
+                // Every test makes a helper, so only say it once.
+                static std::atomic<bool> reported{false};
+                if (!reported.exchange(true)) {
+                    ReportF("Secondary view configuration %s is not supported by the system, only the primary views are rendered",
+                            GetGlobalData().GetOptions().secondaryViewConfiguration.c_str());
+                }
+            }
+        }
+
+        m_interactionManager = std::make_unique<InteractionManager>(m_instanceHandle, m_session);
 
         std::vector<int64_t> swapchainFormats;
         {
@@ -192,7 +553,7 @@ namespace Conformance
         xrDestroySession(m_session);
 
         GlobalData& globalData = GetGlobalData();
-        if (globalData.IsUsingGraphicsPlugin()) {
+        if (m_ownsDevice && globalData.IsUsingGraphicsPlugin()) {
             auto graphicsPlugin = globalData.GetGraphicsPlugin();
             if (graphicsPlugin->IsInitialized()) {
                 graphicsPlugin->ShutdownDevice();
@@ -207,7 +568,7 @@ namespace Conformance
 
     XrInstance CompositionHelper::GetInstance() const
     {
-        return m_instance.get();
+        return m_instanceHandle;
     }
 
     XrSession CompositionHelper::GetSession() const
@@ -215,35 +576,57 @@ namespace Conformance
         return m_session;
     }
 
+    XrSystemId CompositionHelper::GetSystemId() const
+    {
+        return m_systemId;
+    }
+
+    XrViewConfigurationType CompositionHelper::GetPrimaryViewConfigurationType() const
+    {
+        return m_primaryViewType;
+    }
+
+    XrViewConfigurationType CompositionHelper::GetSecondaryViewConfigurationType() const
+    {
+        return m_secondaryViewType;
+    }
+
     std::vector<XrViewConfigurationView> CompositionHelper::EnumerateConfigurationViews()
     {
-        std::vector<XrViewConfigurationView> views;
+        return EnumerateConfigurationViews(m_primaryViewType);
+    }
 
-        uint32_t countOutput;
-        XRC_CHECK_THROW_XRCMD(xrEnumerateViewConfigurationViews(m_instance.get(), m_systemId, m_primaryViewType, 0, &countOutput, nullptr));
-        if (countOutput != 0) {
-            views.resize(countOutput, {XR_TYPE_VIEW_CONFIGURATION_VIEW});
-            XRC_CHECK_THROW_XRCMD(xrEnumerateViewConfigurationViews(m_instance.get(), m_systemId, m_primaryViewType, (uint32_t)views.size(),
-                                                                    &countOutput, views.data()));
+    std::vector<XrViewConfigurationView> CompositionHelper::EnumerateConfigurationViews(XrViewConfigurationType viewConfigurationType)
+    {
+        const std::shared_ptr<const SystemSnapshot> snapshot = GetGlobalData().GetSystemSnapshot(m_instanceHandle, m_systemId);
+        const SystemSnapshot::ViewConfiguration* viewConfiguration = snapshot->FindViewConfiguration(viewConfigurationType);
+        if (viewConfiguration != nullptr) {
+            return viewConfiguration->views;
         }
 
+        // Not a type the system enumerates, so let the runtime give its answer.
+        std::vector<XrViewConfigurationView> views;
+        XRC_CHECK_THROW_XRCMD(doTwoCallInPlaceWithEmptyElement(views, {XR_TYPE_VIEW_CONFIGURATION_VIEW}, xrEnumerateViewConfigurationViews,
+                                                               m_instanceHandle, m_systemId, viewConfigurationType));
         return views;
     }
 
     XrViewConfigurationProperties CompositionHelper::GetViewConfigurationProperties()
     {
-        XrViewConfigurationProperties properties{XR_TYPE_VIEW_CONFIGURATION_PROPERTIES};
-        XRC_CHECK_THROW_XRCMD(xrGetViewConfigurationProperties(m_instance.get(), m_systemId, m_primaryViewType, &properties));
-        return properties;
+        const std::shared_ptr<const SystemSnapshot> snapshot = GetGlobalData().GetSystemSnapshot(m_instanceHandle, m_systemId);
+        const SystemSnapshot::ViewConfiguration* viewConfiguration = snapshot->FindViewConfiguration(m_primaryViewType);
+        XRC_CHECK_THROW_MSG(viewConfiguration != nullptr, "The system does not support the selected view configuration");
+        return viewConfiguration->properties;
     }
 
     void CompositionHelper::BeginSession()
     {
         REQUIRE_MSG(WaitUntilPredicateWithTimeout(
+                        *m_eventQueue,
                         [&] {
-                            XrEventDataBuffer eventData;
-                            while (m_privateEventReader->TryReadUntilEvent(eventData, XR_TYPE_EVENT_DATA_SESSION_STATE_CHANGED)) {
-                                auto sessionStateChanged = reinterpret_cast<XrEventDataSessionStateChanged*>(&eventData);
+                            while (const XrEventDataBuffer* eventData =
+                                       m_privateEventReader->TryReadUntilEvent(XR_TYPE_EVENT_DATA_SESSION_STATE_CHANGED)) {
+                                auto sessionStateChanged = reinterpret_cast<const XrEventDataSessionStateChanged*>(eventData);
                                 if (sessionStateChanged->session == m_session && sessionStateChanged->state == XR_SESSION_STATE_READY) {
                                     return true;
                                 }
@@ -256,33 +639,93 @@ namespace Conformance
 
         XrSessionBeginInfo beginInfo{XR_TYPE_SESSION_BEGIN_INFO};
         beginInfo.primaryViewConfigurationType = m_primaryViewType;
+        XrSecondaryViewConfigurationSessionBeginInfoMSFT secondaryBeginInfo{XR_TYPE_SECONDARY_VIEW_CONFIGURATION_SESSION_BEGIN_INFO_MSFT};
+        if (m_secondaryViewType != XR_VIEW_CONFIGURATION_TYPE_MAX_ENUM) {
+            secondaryBeginInfo.viewConfigurationCount = 1;
+            secondaryBeginInfo.enabledViewConfigurationTypes = &m_secondaryViewType;
+            beginInfo.next = &secondaryBeginInfo;
+        }
         XRC_CHECK_THROW_XRCMD(xrBeginSession(m_session, &beginInfo));
     }
 
-    std::tuple<XrViewState, std::vector<XrView>> CompositionHelper::LocateViews(XrSpace space, int64_t displayTime)
+    CompositionHelper::LocatedViews CompositionHelper::LocateViews(XrSpace space, XrTime displayTime)
+    {
+        return LocateViews(space, displayTime, m_primaryViewType);
+    }
+
+    CompositionHelper::LocatedViews CompositionHelper::LocateViews(XrSpace space, XrTime displayTime,
+                                                                   XrViewConfigurationType viewConfigurationType)
     {
+        if (displayTime != m_locatedViewsTime) {
+            m_locatedViewsTime = displayTime;
+            m_locatedViewsCount = 0;
+        }
+        for (size_t i = 0; i < m_locatedViewsCount; ++i) {
+            const LocatedViewsEntry& entry = m_locatedViews[i];
+            if (entry.space == space && entry.viewConfigurationType == viewConfigurationType) {
+                return LocatedViews{entry.viewState, entry.views.data(), (uint32_t)entry.views.size()};
+            }
+        }
+
+        if (m_locatedViewsCount == m_locatedViews.size()) {
+            m_locatedViews.emplace_back();
+        }
+        LocatedViewsEntry& entry = m_locatedViews[m_locatedViewsCount];
+        uint32_t viewCount = viewConfigurationType == m_primaryViewType ? m_projectionViewCount : m_secondaryViewCount;
+        entry.space = space;
+        entry.viewConfigurationType = viewConfigurationType;
+        entry.viewState = {XR_TYPE_VIEW_STATE};
+        entry.views.assign(viewCount, {XR_TYPE_VIEW});
+
         XrViewLocateInfo viewLocateInfo{XR_TYPE_VIEW_LOCATE_INFO};
         viewLocateInfo.displayTime = displayTime;
         viewLocateInfo.space = space;
-        viewLocateInfo.viewConfigurationType = m_primaryViewType;
-        XrViewState viewState{XR_TYPE_VIEW_STATE};
-        std::vector<XrView> views(m_projectionViewCount, {XR_TYPE_VIEW});
-        uint32_t viewCount = m_projectionViewCount;
-        XRC_CHECK_THROW_XRCMD(xrLocateViews(m_session, &viewLocateInfo, &viewState, viewCount, &viewCount, views.data()));
+        viewLocateInfo.viewConfigurationType = viewConfigurationType;
+        XRC_CHECK_THROW_XRCMD(
+            xrLocateViews(m_session, &viewLocateInfo, &entry.viewState, viewCount, &viewCount, entry.views.data()));
+        entry.views.resize(viewCount);
+        // Only cached once located, so that a failed call is made again.
+        ++m_locatedViewsCount;
 
-        return std::make_tuple(viewState, std::move(views));
+        return LocatedViews{entry.viewState, entry.views.data(), (uint32_t)entry.views.size()};
     }
 
-    void CompositionHelper::EndFrame(XrTime predictedDisplayTime, std::vector<XrCompositionLayerBaseHeader*> layers)
+    void CompositionHelper::EndFrame(XrTime predictedDisplayTime, const std::vector<XrCompositionLayerBaseHeader*>& layers)
     {
-        layers.push_back(reinterpret_cast<XrCompositionLayerBaseHeader*>(&m_testNameQuad));
+        EndFrame(predictedDisplayTime, layers.data(), layers.size());
+    }
+
+    void CompositionHelper::EndFrame(XrTime predictedDisplayTime, XrCompositionLayerBaseHeader* const* layers, size_t layerCount)
+    {
+        XR_TRACE_SCOPE("CompositionHelper::EndFrame");
+
+        m_frameLayers.assign(layers, layers + layerCount);
+        m_frameLayers.push_back(reinterpret_cast<const XrCompositionLayerBaseHeader*>(&m_testNameQuad));
 
         XrFrameEndInfo frameEndInfo{XR_TYPE_FRAME_END_INFO};
         frameEndInfo.environmentBlendMode = GetGlobalData().GetOptions().environmentBlendModeValue;
         frameEndInfo.displayTime = predictedDisplayTime;
-        frameEndInfo.layerCount = (uint32_t)layers.size();
-        frameEndInfo.layers = layers.data();
+        frameEndInfo.layerCount = (uint32_t)m_frameLayers.size();
+        frameEndInfo.layers = m_frameLayers.data();
+
+        XrSecondaryViewConfigurationLayerInfoMSFT secondaryLayerInfo{XR_TYPE_SECONDARY_VIEW_CONFIGURATION_LAYER_INFO_MSFT};
+        XrSecondaryViewConfigurationFrameEndInfoMSFT secondaryFrameEndInfo{XR_TYPE_SECONDARY_VIEW_CONFIGURATION_FRAME_END_INFO_MSFT};
+        if (!m_secondaryLayers.empty()) {
+            secondaryLayerInfo.viewConfigurationType = m_secondaryViewType;
+            secondaryLayerInfo.environmentBlendMode = m_secondaryBlendMode;
+            secondaryLayerInfo.layerCount = (uint32_t)m_secondaryLayers.size();
+            secondaryLayerInfo.layers = m_secondaryLayers.data();
+            secondaryFrameEndInfo.viewConfigurationCount = 1;
+            secondaryFrameEndInfo.viewConfigurationLayersInfo = &secondaryLayerInfo;
+            frameEndInfo.next = &secondaryFrameEndInfo;
+        }
         XRC_CHECK_THROW_XRCMD(xrEndFrame(m_session, &frameEndInfo));
+        m_secondaryLayers.clear();
+    }
+
+    void CompositionHelper::AddSecondaryLayer(XrCompositionLayerBaseHeader* layer)
+    {
+        m_secondaryLayers.push_back(layer);
     }
 
     EventQueue& CompositionHelper::GetEventQueue() const
@@ -292,10 +735,12 @@ namespace Conformance
 
     bool CompositionHelper::PollEvents()
     {
-        XrEventDataBuffer eventBuffer;
-        while (m_privateEventReader->TryReadNext(eventBuffer)) {
-            if (eventBuffer.type == XR_TYPE_EVENT_DATA_SESSION_STATE_CHANGED) {
-                auto sessionState = reinterpret_cast<XrEventDataSessionStateChanged*>(&eventBuffer);
+        while (const XrEventDataBuffer* eventBuffer = m_privateEventReader->TryReadNext()) {
+            if (eventBuffer->type == XR_TYPE_EVENT_DATA_SESSION_STATE_CHANGED) {
+                auto sessionState = reinterpret_cast<const XrEventDataSessionStateChanged*>(eventBuffer);
+                if (sessionState->session != m_session) {
+                    continue;  // Another session on the instance, such as an overlay.
+                }
 
                 // The composition frame loop should always be running, otherwise something unexpected happened (perhaps a conformance bug
                 // or the runtime wants to move the session to IDLE which the user shouldn't have requested during conformance).
@@ -313,6 +758,8 @@ namespace Conformance
     void CompositionHelper::AcquireWaitReleaseImage(XrSwapchain swapchain,
                                                     std::function<void(const XrSwapchainImageBaseHeader*, uint64_t)> doUpdate)
     {
+        XR_TRACE_SCOPE("CompositionHelper::AcquireWaitReleaseImage");
+
         uint32_t imageIndex;
         XrSwapchainImageAcquireInfo acquireInfo{XR_TYPE_SWAPCHAIN_IMAGE_ACQUIRE_INFO};
         XRC_CHECK_THROW_XRCMD(xrAcquireSwapchainImage(swapchain, &acquireInfo, &imageIndex));
@@ -366,6 +813,25 @@ namespace Conformance
         return createInfo;
     }
 
+    XrSwapchainCreateInfo CompositionHelper::DefaultDepthSwapchainCreateInfo(uint32_t width, uint32_t height)
+    {
+        uint32_t countOutput;
+        XRC_CHECK_THROW_XRCMD(xrEnumerateSwapchainFormats(m_session, 0, &countOutput, nullptr));
+        std::vector<int64_t> swapchainFormats(countOutput);
+        XRC_CHECK_THROW_XRCMD(xrEnumerateSwapchainFormats(m_session, countOutput, &countOutput, swapchainFormats.data()));
+
+        XrSwapchainCreateInfo createInfo{XR_TYPE_SWAPCHAIN_CREATE_INFO};
+        createInfo.arraySize = 1;
+        createInfo.format = GetGlobalData().graphicsPlugin->SelectDepthSwapchainFormat(swapchainFormats.data(), swapchainFormats.size());
+        createInfo.width = width;
+        createInfo.height = height;
+        createInfo.mipCount = 1;
+        createInfo.faceCount = 1;
+        createInfo.sampleCount = 1;
+        createInfo.usageFlags = XR_SWAPCHAIN_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+        return createInfo;
+    }
+
     XrSwapchain CompositionHelper::CreateSwapchain(const XrSwapchainCreateInfo& createInfo)
     {
         if (!GetGlobalData().IsUsingGraphicsPlugin()) {
@@ -433,6 +899,170 @@ namespace Conformance
         return swapchain;
     }
 
+    std::vector<XrSwapchain> CompositionHelper::CreateStaticSwapchainSolidColors(const std::vector<XrColor4f>& colors)
+    {
+        std::vector<RGBAImage> images;
+        images.reserve(colors.size());
+        for (const XrColor4f& color : colors) {
+            images.emplace_back(256, 256);
+            images.back().DrawRect(0, 0, 256, 256, color);
+        }
+
+        return CreateStaticSwapchainImages(images);
+    }
+
+    std::vector<XrSwapchain> CompositionHelper::CreateStaticSwapchainImages(const std::vector<RGBAImage>& rgbaImages)
+    {
+        if (!GetGlobalData().IsUsingGraphicsPlugin()) {
+            return std::vector<XrSwapchain>(rgbaImages.size(), XR_NULL_HANDLE);
+        }
+
+        std::vector<std::future<RGBAImage>> srgbImages;
+        srgbImages.reserve(rgbaImages.size());
+        for (const RGBAImage& rgbaImage : rgbaImages) {
+            srgbImages.push_back(std::async(std::launch::async, [&rgbaImage] {
+                RGBAImage srgbImage = rgbaImage;
+                if (!srgbImage.isSrgb)
+                    srgbImage.ConvertToSRGB();
+                return srgbImage;
+            }));
+        }
+
+        // The swapchain format must be R8G8B8A8 UNORM to match the RGBAImage format.
+        const int64_t format = GetGlobalData().graphicsPlugin->GetSRGBA8Format();
+        std::vector<XrSwapchain> swapchains;
+        swapchains.reserve(rgbaImages.size());
+        for (const RGBAImage& rgbaImage : rgbaImages) {
+            swapchains.push_back(CreateSwapchain(
+                DefaultColorSwapchainCreateInfo(rgbaImage.width, rgbaImage.height, XR_SWAPCHAIN_CREATE_STATIC_IMAGE_BIT, format)));
+        }
+
+        std::vector<uint32_t> imageIndices(swapchains.size());
+        for (size_t i = 0; i < swapchains.size(); ++i) {
+            XrSwapchainImageAcquireInfo acquireInfo{XR_TYPE_SWAPCHAIN_IMAGE_ACQUIRE_INFO};
+            XRC_CHECK_THROW_XRCMD(xrAcquireSwapchainImage(swapchains[i], &acquireInfo, &imageIndices[i]));
+        }
+
+        for (size_t i = 0; i < swapchains.size(); ++i) {
+            XrSwapchainImageWaitInfo waitInfo{XR_TYPE_SWAPCHAIN_IMAGE_WAIT_INFO};
+            waitInfo.timeout = 500_xrMilliseconds;  // Call can block waiting for image to become available for writing.
+            XRC_CHECK_THROW_XRCMD(xrWaitSwapchainImage(swapchains[i], &waitInfo));
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+            const XrSwapchainImageBaseHeader* image = m_swapchainImages[swapchains[i]]->imagePtrVector[imageIndices[i]];
+            lock.unlock();
+
+            GetGlobalData().graphicsPlugin->CopyRGBAImage(image, format, 0, srgbImages[i].get());
+        }
+
+        for (XrSwapchain swapchain : swapchains) {
+            XrSwapchainImageReleaseInfo releaseInfo{XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO};
+            XRC_CHECK_THROW_XRCMD(xrReleaseSwapchainImage(swapchain, &releaseInfo));
+        }
+
+        return swapchains;
+    }
+
+    std::vector<XrSwapchainSubImage> CompositionHelper::CreateStaticSwapchainAtlas(const std::vector<RGBAImage>& rgbaImages,
+                                                                                   uint32_t maxAtlasSize /*= 4096*/)
+    {
+        constexpr int border = 1;
+
+        if (!GetGlobalData().IsUsingGraphicsPlugin()) {
+            std::vector<XrSwapchainSubImage> subImages(rgbaImages.size());
+            for (size_t i = 0; i < rgbaImages.size(); ++i) {
+                subImages[i] = {XR_NULL_HANDLE, {{0, 0}, {rgbaImages[i].width, rgbaImages[i].height}}, 0};
+            }
+            return subImages;
+        }
+
+        const XrSystemProperties systemProperties = GetGlobalData().GetSystemSnapshot(m_instanceHandle, m_systemId)->systemProperties;
+        const int atlasWidth = (int)std::min(maxAtlasSize, systemProperties.graphicsProperties.maxSwapchainImageWidth);
+        const int atlasHeight = (int)std::min(maxAtlasSize, systemProperties.graphicsProperties.maxSwapchainImageHeight);
+
+        // Shelf packing: the images go tallest first into rows across each atlas, and a new atlas is started when a
+        // row no longer fits below the previous one.
+        std::vector<size_t> order(rgbaImages.size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            order[i] = i;
+        }
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return rgbaImages[a].height > rgbaImages[b].height; });
+
+        struct Placement
+        {
+            size_t atlas;
+            XrOffset2Di offset;
+        };
+        std::vector<Placement> placements(rgbaImages.size());
+        std::vector<XrExtent2Di> atlasExtents;
+        int shelfX = 0;
+        int shelfY = 0;
+        int shelfHeight = 0;
+        for (size_t i : order) {
+            const int cellWidth = rgbaImages[i].width + 2 * border;
+            const int cellHeight = rgbaImages[i].height + 2 * border;
+            XRC_CHECK_THROW_MSG(cellWidth <= atlasWidth && cellHeight <= atlasHeight, "Image is too large for a swapchain atlas");
+
+            if (!atlasExtents.empty() && shelfX + cellWidth > atlasWidth) {
+                shelfY += shelfHeight;
+                shelfX = 0;
+                shelfHeight = 0;
+            }
+            if (atlasExtents.empty() || shelfY + cellHeight > atlasHeight) {
+                atlasExtents.push_back({0, 0});
+                shelfX = 0;
+                shelfY = 0;
+                shelfHeight = 0;
+            }
+
+            placements[i] = {atlasExtents.size() - 1, {shelfX + border, shelfY + border}};
+            shelfX += cellWidth;
+            shelfHeight = std::max(shelfHeight, cellHeight);
+            XrExtent2Di& extent = atlasExtents.back();
+            extent = {std::max(extent.width, shelfX), std::max(extent.height, shelfY + cellHeight)};
+        }
+
+        // The atlases are filled in sRGB, so that images of either encoding can share one.
+        std::vector<RGBAImage> atlases;
+        atlases.reserve(atlasExtents.size());
+        for (const XrExtent2Di& extent : atlasExtents) {
+            atlases.emplace_back(extent.width, extent.height);
+            atlases.back().isSrgb = true;
+        }
+        for (size_t i = 0; i < rgbaImages.size(); ++i) {
+            const RGBAImage* source = &rgbaImages[i];
+            RGBAImage srgbImage(0, 0);
+            if (!source->isSrgb) {
+                srgbImage = *source;
+                srgbImage.ConvertToSRGB();
+                source = &srgbImage;
+            }
+
+            RGBAImage& atlas = atlases[placements[i].atlas];
+            const XrOffset2Di& offset = placements[i].offset;
+            for (int y = -border; y < source->height + border; ++y) {
+                const int sourceY = std::min(std::max(y, 0), source->height - 1);
+                const RGBA8Color* sourceRow = &source->pixels[size_t(sourceY) * source->width];
+                RGBA8Color* atlasRow = &atlas.pixels[size_t(offset.y + y) * atlas.width + offset.x];
+                std::copy_n(sourceRow, source->width, atlasRow);
+                for (int x = 1; x <= border; ++x) {
+                    atlasRow[-x] = sourceRow[0];
+                    atlasRow[source->width - 1 + x] = sourceRow[source->width - 1];
+                }
+            }
+        }
+
+        const std::vector<XrSwapchain> swapchains = CreateStaticSwapchainImages(atlases);
+
+        std::vector<XrSwapchainSubImage> subImages(rgbaImages.size());
+        for (size_t i = 0; i < rgbaImages.size(); ++i) {
+            subImages[i].swapchain = swapchains[placements[i].atlas];
+            subImages[i].imageRect = {placements[i].offset, {rgbaImages[i].width, rgbaImages[i].height}};
+            subImages[i].imageArrayIndex = 0;
+        }
+        return subImages;
+    }
+
     XrSwapchainSubImage CompositionHelper::MakeDefaultSubImage(XrSwapchain swapchain, uint32_t imageArrayIndex /*= 0*/)
     {
         std::lock_guard<std::mutex> lock(m_mutex);
@@ -451,12 +1081,18 @@ namespace Conformance
 
     XrCompositionLayerQuad* CompositionHelper::CreateQuadLayer(XrSwapchain swapchain, XrSpace space, float width,
                                                                XrPosef pose /*= XrPosefCPP()*/)
+    {
+        return CreateQuadLayer(MakeDefaultSubImage(swapchain), space, width, pose);
+    }
+
+    XrCompositionLayerQuad* CompositionHelper::CreateQuadLayer(const XrSwapchainSubImage& subImage, XrSpace space, float width,
+                                                               XrPosef pose /*= XrPosefCPP()*/)
     {
         XrCompositionLayerQuad quad{XR_TYPE_COMPOSITION_LAYER_QUAD};
         quad.eyeVisibility = XR_EYE_VISIBILITY_BOTH;
         quad.pose = pose;
         quad.space = space;
-        quad.subImage = MakeDefaultSubImage(swapchain);
+        quad.subImage = subImage;
         quad.size = {width, width * quad.subImage.imageRect.extent.height / quad.subImage.imageRect.extent.width};
 
         std::lock_guard<std::mutex> lock(m_mutex);
@@ -465,15 +1101,21 @@ namespace Conformance
     }
 
     XrCompositionLayerProjection* CompositionHelper::CreateProjectionLayer(XrSpace space)
+    {
+        return CreateProjectionLayer(space, m_primaryViewType);
+    }
+
+    XrCompositionLayerProjection* CompositionHelper::CreateProjectionLayer(XrSpace space, XrViewConfigurationType viewConfigurationType)
     {
         std::lock_guard<std::mutex> lock(m_mutex);
 
         // Allocate projection views and store.
-        assert(m_projectionViewCount > 0);
+        const uint32_t viewCount = viewConfigurationType == m_primaryViewType ? m_projectionViewCount : m_secondaryViewCount;
+        assert(viewCount > 0);
         XrCompositionLayerProjectionView init{XR_TYPE_COMPOSITION_LAYER_PROJECTION_VIEW};
         // Make sure the pose is valid
         init.pose.orientation.w = 1.0f;
-        std::vector<XrCompositionLayerProjectionView> projViews(m_projectionViewCount, init);
+        std::vector<XrCompositionLayerProjectionView> projViews(viewCount, init);
         m_projectionViews.push_back(std::move(projViews));
 
         // Allocate projection and store.
@@ -486,47 +1128,304 @@ namespace Conformance
         return &m_projections.back();
     }
 
-    SimpleProjectionLayerHelper::SimpleProjectionLayerHelper(CompositionHelper& compositionHelper)
+    XrCompositionLayerCylinderKHR* CompositionHelper::CreateCylinderLayer(XrSwapchain swapchain, XrSpace space, float radius,
+                                                                          float centralAngle, XrPosef pose /*= XrPosefCPP()*/)
+    {
+        XrCompositionLayerCylinderKHR cylinder{XR_TYPE_COMPOSITION_LAYER_CYLINDER_KHR};
+        cylinder.eyeVisibility = XR_EYE_VISIBILITY_BOTH;
+        cylinder.pose = pose;
+        cylinder.space = space;
+        cylinder.subImage = MakeDefaultSubImage(swapchain);
+        cylinder.radius = radius;
+        cylinder.centralAngle = centralAngle;
+        cylinder.aspectRatio = (float)cylinder.subImage.imageRect.extent.width / cylinder.subImage.imageRect.extent.height;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_cylinders.push_back(cylinder);
+        return &m_cylinders.back();
+    }
+
+    XrCompositionLayerEquirectKHR* CompositionHelper::CreateEquirectLayer(XrSwapchain swapchain, XrSpace space, float radius,
+                                                                          XrPosef pose /*= XrPosefCPP()*/)
+    {
+        XrCompositionLayerEquirectKHR equirect{XR_TYPE_COMPOSITION_LAYER_EQUIRECT_KHR};
+        equirect.eyeVisibility = XR_EYE_VISIBILITY_BOTH;
+        equirect.pose = pose;
+        equirect.space = space;
+        equirect.subImage = MakeDefaultSubImage(swapchain);
+        equirect.radius = radius;
+        equirect.scale = {1.0f, 1.0f};
+        equirect.bias = {0.0f, 0.0f};
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_equirects.push_back(equirect);
+        return &m_equirects.back();
+    }
+
+    SimpleProjectionLayerHelper::SimpleProjectionLayerHelper(CompositionHelper& compositionHelper, bool submitDepth, float resolutionScale)
         : m_compositionHelper(compositionHelper)
         , m_localSpace(compositionHelper.CreateReferenceSpace(XR_REFERENCE_SPACE_TYPE_LOCAL, XrPosefCPP{}))
+        , m_submitDepth(submitDepth)
     {
-        const std::vector<XrViewConfigurationView> viewProperties = compositionHelper.EnumerateConfigurationViews();
+        m_primary.viewConfigurationType = compositionHelper.GetPrimaryViewConfigurationType();
+        CreateSwapchains(m_primary, submitDepth, resolutionScale);
 
-        m_projLayer = compositionHelper.CreateProjectionLayer(m_localSpace);
-        for (uint32_t j = 0; j < m_projLayer->viewCount; j++) {
-            const XrSwapchain swapchain = compositionHelper.CreateSwapchain(compositionHelper.DefaultColorSwapchainCreateInfo(
-                viewProperties[j].recommendedImageRectWidth, viewProperties[j].recommendedImageRectHeight));
-            const_cast<XrSwapchainSubImage&>(m_projLayer->views[j].subImage) = compositionHelper.MakeDefaultSubImage(swapchain, 0);
-            m_swapchains.push_back(swapchain);
+        if (compositionHelper.GetSecondaryViewConfigurationType() != XR_VIEW_CONFIGURATION_TYPE_MAX_ENUM) {
+            m_secondary.viewConfigurationType = compositionHelper.GetSecondaryViewConfigurationType();
+            CreateSwapchains(m_secondary, false, resolutionScale);
         }
     }
 
-    XrCompositionLayerBaseHeader* SimpleProjectionLayerHelper::TryGetUpdatedProjectionLayer(const XrFrameState& frameState,
-                                                                                            const std::vector<Cube> cubes)
+    void SimpleProjectionLayerHelper::CreateSwapchains(ProjectionViews& projection, bool submitDepth, float resolutionScale)
     {
-        auto viewData = m_compositionHelper.LocateViews(m_localSpace, frameState.predictedDisplayTime);
-        const auto& viewState = std::get<XrViewState>(viewData);
+        CompositionHelper& compositionHelper = m_compositionHelper;
+        const std::vector<XrViewConfigurationView> viewProperties =
+            compositionHelper.EnumerateConfigurationViews(projection.viewConfigurationType);
+        const bool secondary = projection.viewConfigurationType != compositionHelper.GetPrimaryViewConfigurationType();
+        // Depth is matched to its color swapchain one to one, so it keeps the views apart.
+        const bool arrays = GetGlobalData().GetOptions().viewSwapchainArrays && !submitDepth;
+
+        projection.layer = compositionHelper.CreateProjectionLayer(m_localSpace, projection.viewConfigurationType);
+        const uint32_t viewCount = projection.layer->viewCount;
+        projection.batch.reserve(viewCount);
+        if (submitDepth) {
+            // Reserved up front, the projection views point into it.
+            projection.depthInfos.reserve(viewCount);
+        }
 
-        if (viewState.viewStateFlags & XR_VIEW_STATE_POSITION_VALID_BIT && viewState.viewStateFlags & XR_VIEW_STATE_ORIENTATION_VALID_BIT) {
-            const auto& views = std::get<std::vector<XrView>>(viewData);
+        // Group the views into swapchains: each its own, or those of equal size as the slices of one.
+        std::vector<XrExtent2Di> swapchainExtents;
+        std::vector<XrExtent2Di> viewExtents;
+        for (uint32_t j = 0; j < viewCount; j++) {
+            auto scaled = [&](uint32_t recommended, uint32_t max) {
+                return std::max<uint32_t>(1, std::min<uint32_t>((uint32_t)std::lround(recommended * resolutionScale), max));
+            };
+            const XrExtent2Di extent{(int32_t)scaled(viewProperties[j].recommendedImageRectWidth, viewProperties[j].maxImageRectWidth),
+                                     (int32_t)scaled(viewProperties[j].recommendedImageRectHeight, viewProperties[j].maxImageRectHeight)};
+            viewExtents.push_back(extent);
+            size_t swapchainIndex = swapchainExtents.size();
+            if (arrays) {
+                for (size_t s = 0; s < swapchainExtents.size(); ++s) {
+                    if (swapchainExtents[s].width == extent.width && swapchainExtents[s].height == extent.height) {
+                        swapchainIndex = s;
+                        break;
+                    }
+                }
+            }
+            if (swapchainIndex == swapchainExtents.size()) {
+                swapchainExtents.push_back(extent);
+                projection.swapchainViews.emplace_back();
+            }
+            projection.swapchainViews[swapchainIndex].push_back(j);
+        }
 
-            // Render into each view swapchain using the recommended view fov and pose.
-            for (size_t view = 0; view < views.size(); view++) {
-                m_compositionHelper.AcquireWaitReleaseImage(
-                    m_swapchains[view], [&](const XrSwapchainImageBaseHeader* swapchainImage, uint64_t format) {
-                        GetGlobalData().graphicsPlugin->ClearImageSlice(swapchainImage, 0, format);
+        XrSecondaryViewConfigurationSwapchainCreateInfoMSFT secondaryCreateInfo{
+            XR_TYPE_SECONDARY_VIEW_CONFIGURATION_SWAPCHAIN_CREATE_INFO_MSFT};
+        secondaryCreateInfo.viewConfigurationType = projection.viewConfigurationType;
+        for (size_t s = 0; s < swapchainExtents.size(); ++s) {
+            const std::vector<uint32_t>& swapchainViews = projection.swapchainViews[s];
+            const XrExtent2Di& extent = swapchainExtents[s];
+            XrSwapchainCreateInfo createInfo =
+                compositionHelper.DefaultColorSwapchainCreateInfo((uint32_t)extent.width, (uint32_t)extent.height);
+            createInfo.arraySize = (uint32_t)swapchainViews.size();
+            if (secondary) {
+                createInfo.next = &secondaryCreateInfo;
+            }
+            const XrSwapchain swapchain = compositionHelper.CreateSwapchain(createInfo);
+            for (uint32_t slice = 0; slice < (uint32_t)swapchainViews.size(); ++slice) {
+                const_cast<XrSwapchainSubImage&>(projection.layer->views[swapchainViews[slice]].subImage) =
+                    compositionHelper.MakeDefaultSubImage(swapchain, slice);
+            }
+            projection.swapchains.push_back(swapchain);
+        }
 
-                        const_cast<XrFovf&>(m_projLayer->views[view].fov) = views[view].fov;
-                        const_cast<XrPosef&>(m_projLayer->views[view].pose) = views[view].pose;
-                        GetGlobalData().graphicsPlugin->RenderView(m_projLayer->views[view], swapchainImage, format, cubes);
-                    });
+        if (submitDepth) {
+            for (uint32_t j = 0; j < viewCount; j++) {
+                const XrSwapchain depthSwapchain = compositionHelper.CreateSwapchain(
+                    compositionHelper.DefaultDepthSwapchainCreateInfo((uint32_t)viewExtents[j].width, (uint32_t)viewExtents[j].height));
+                projection.depthSwapchains.push_back(depthSwapchain);
+
+                XrCompositionLayerDepthInfoKHR depthInfo{XR_TYPE_COMPOSITION_LAYER_DEPTH_INFO_KHR};
+                depthInfo.subImage = compositionHelper.MakeDefaultSubImage(depthSwapchain, 0);
+                depthInfo.minDepth = 0.0f;
+                depthInfo.maxDepth = 1.0f;
+                depthInfo.nearZ = IGraphicsPlugin::DepthNearZ;
+                depthInfo.farZ = IGraphicsPlugin::DepthFarZ;
+                projection.depthInfos.push_back(depthInfo);
+                const_cast<XrCompositionLayerProjectionView&>(projection.layer->views[j]).next = &projection.depthInfos.back();
             }
+        }
+    }
 
-            return reinterpret_cast<XrCompositionLayerBaseHeader*>(m_projLayer);
+    SimpleProjectionLayerHelper::~SimpleProjectionLayerHelper()
+    {
+        DestroySwapchains(m_primary);
+        DestroySwapchains(m_secondary);
+    }
+
+    void SimpleProjectionLayerHelper::DestroySwapchains(ProjectionViews& projection) noexcept
+    {
+        // Called from the destructor, so a swapchain that fails to go away is reported and the rest are still destroyed.
+        auto destroy = [&](XrSwapchain swapchain) {
+            try {
+                m_compositionHelper.DestroySwapchain(swapchain);
+            }
+            catch (const std::exception& e) {
+                ReportF("Destroying a projection layer swapchain failed: %s", e.what());
+            }
+        };
+        // Without a graphics plugin no swapchains were created.
+        for (XrSwapchain swapchain : projection.swapchains) {
+            if (swapchain != XR_NULL_HANDLE) {
+                destroy(swapchain);
+            }
         }
-        else {
+        for (XrSwapchain swapchain : projection.depthSwapchains) {
+            destroy(swapchain);
+        }
+    }
+
+    const std::vector<Cube>& SimpleProjectionLayerHelper::DefaultCubes()
+    {
+        static const std::vector<Cube> cubes{Cube::Make({-1, 0, -2}), Cube::Make({1, 0, -2}), Cube::Make({0, -1, -2}),
+                                             Cube::Make({0, 1, -2})};
+        return cubes;
+    }
+
+    bool SimpleProjectionLayerHelper::UpdateVisibilityMasks()
+    {
+        PFN_xrGetVisibilityMaskKHR getVisibilityMask = nullptr;
+        if (XR_FAILED(xrGetInstanceProcAddr(m_compositionHelper.GetInstance(), "xrGetVisibilityMaskKHR",
+                                            reinterpret_cast<PFN_xrVoidFunction*>(&getVisibilityMask))) ||
+            getVisibilityMask == nullptr) {
+            return false;
+        }
+
+        const XrSession session = m_compositionHelper.GetSession();
+        const XrViewConfigurationType viewConfigurationType = m_compositionHelper.GetPrimaryViewConfigurationType();
+        m_visibilityMasks.resize(m_primary.layer->viewCount);
+        for (uint32_t view = 0; view < (uint32_t)m_visibilityMasks.size(); ++view) {
+            VisibilityMask& mask = m_visibilityMasks[view];
+            XrVisibilityMaskKHR visibilityMask{XR_TYPE_VISIBILITY_MASK_KHR};
+            XRC_CHECK_THROW_XRCMD(
+                getVisibilityMask(session, viewConfigurationType, view, XR_VISIBILITY_MASK_TYPE_HIDDEN_TRIANGLE_MESH_KHR, &visibilityMask));
+
+            mask.vertices.resize(visibilityMask.vertexCountOutput);
+            mask.indices.resize(visibilityMask.indexCountOutput);
+            visibilityMask.vertexCapacityInput = visibilityMask.vertexCountOutput;
+            visibilityMask.vertices = mask.vertices.data();
+            visibilityMask.indexCapacityInput = visibilityMask.indexCountOutput;
+            visibilityMask.indices = mask.indices.data();
+            if (visibilityMask.vertexCapacityInput != 0 && visibilityMask.indexCapacityInput != 0) {
+                XRC_CHECK_THROW_XRCMD(getVisibilityMask(session, viewConfigurationType, view,
+                                                        XR_VISIBILITY_MASK_TYPE_HIDDEN_TRIANGLE_MESH_KHR, &visibilityMask));
+            }
+            mask.vertices.resize(visibilityMask.vertexCountOutput);
+            mask.indices.resize(visibilityMask.indexCountOutput);
+        }
+        return true;
+    }
+
+    XrCompositionLayerBaseHeader* SimpleProjectionLayerHelper::TryGetUpdatedProjectionLayer(const XrFrameState& frameState,
+                                                                                            const std::vector<Cube>& cubes)
+    {
+        auto isTracked = [](const XrViewState& viewState) {
+            return (viewState.viewStateFlags & XR_VIEW_STATE_POSITION_VALID_BIT) &&
+                   (viewState.viewStateFlags & XR_VIEW_STATE_ORIENTATION_VALID_BIT);
+        };
+
+        const CompositionHelper::LocatedViews views = m_compositionHelper.LocateViews(m_localSpace, frameState.predictedDisplayTime);
+        if (!isTracked(views.viewState)) {
             // Cannot use the projection layer because the swapchains it uses may not have ever been acquired and released.
             return nullptr;
         }
+
+        if (!m_scene) {
+            m_scene = GetGlobalData().graphicsPlugin->CreateCubeScene();
+        }
+        m_scene->Assign(cubes);
+
+        RenderViews(m_primary, views, cubes);
+
+        // The secondary layer only goes with frames whose primary layer is submitted.
+        if (m_secondary.layer != nullptr && m_compositionHelper.IsSecondaryViewActive()) {
+            const CompositionHelper::LocatedViews secondaryViews =
+                m_compositionHelper.LocateViews(m_localSpace, frameState.predictedDisplayTime, m_secondary.viewConfigurationType);
+            if (isTracked(secondaryViews.viewState) && secondaryViews.size() == m_secondary.layer->viewCount) {
+                RenderViews(m_secondary, secondaryViews, cubes);
+                m_compositionHelper.AddSecondaryLayer(reinterpret_cast<XrCompositionLayerBaseHeader*>(m_secondary.layer));
+            }
+        }
+
+        return reinterpret_cast<XrCompositionLayerBaseHeader*>(m_primary.layer);
+    }
+
+    void SimpleProjectionLayerHelper::RenderViews(ProjectionViews& projection, const CompositionHelper::LocatedViews& views,
+                                                  const std::vector<Cube>& cubes)
+    {
+        IGraphicsPlugin& graphicsPlugin = *GetGlobalData().graphicsPlugin;
+        const bool primary = &projection == &m_primary;
+        XrCompositionLayerProjectionView* layerViews = const_cast<XrCompositionLayerProjectionView*>(projection.layer->views);
+
+        // Render into each swapchain using the recommended fov and pose of its views.
+        for (size_t s = 0; s < projection.swapchains.size(); s++) {
+            const std::vector<uint32_t>& swapchainViews = projection.swapchainViews[s];
+            for (uint32_t view : swapchainViews) {
+                layerViews[view].fov = views[view].fov;
+                layerViews[view].pose = views[view].pose;
+            }
+
+            bool depthRendered = false;
+            auto renderSwapchain = [&](const XrSwapchainImageBaseHeader* depthSwapchainImage, uint64_t depthFormat) {
+                m_compositionHelper.AcquireWaitReleaseImage(
+                    projection.swapchains[s], [&](const XrSwapchainImageBaseHeader* swapchainImage, uint64_t format) {
+                        if (depthSwapchainImage == nullptr && (!primary || m_visibilityMasks.empty())) {
+                            // Nothing else is drawn into the image, so its render passes may clear it, and all of its
+                            // slices go to the plugin at once to record in parallel or with multiview.
+                            projection.batch.clear();
+                            for (uint32_t view : swapchainViews) {
+                                projection.batch.push_back(layerViews[view]);
+                            }
+                            graphicsPlugin.ClearAndRenderScene(projection.batch.data(), (uint32_t)projection.batch.size(),
+                                                               swapchainImage, format, *m_scene);
+                            return;
+                        }
+
+                        for (uint32_t view : swapchainViews) {
+                            const XrCompositionLayerProjectionView& layerView = layerViews[view];
+                            graphicsPlugin.ClearImageSlice(swapchainImage, layerView.subImage.imageArrayIndex, format);
+                            depthRendered = depthSwapchainImage != nullptr &&
+                                            graphicsPlugin.RenderViewWithDepth(layerView, swapchainImage, format, depthSwapchainImage,
+                                                                               depthFormat, cubes);
+                            if (depthRendered) {
+                                continue;
+                            }
+                            if (view < m_visibilityMasks.size()) {
+                                if (graphicsPlugin.RenderViewWithVisibilityMask(layerView, swapchainImage, format, m_visibilityMasks[view],
+                                                                                cubes)) {
+                                    continue;
+                                }
+                                // The plugin cannot draw them, so stop asking.
+                                m_visibilityMasks.clear();
+                            }
+                            graphicsPlugin.RenderView(layerView, swapchainImage, format, cubes);
+                        }
+                    });
+            };
+
+            if (primary && IsSubmittingDepth()) {
+                m_compositionHelper.AcquireWaitReleaseImage(projection.depthSwapchains[s], renderSwapchain);
+                if (!depthRendered) {
+                    // The depth of the other views would not match this one's, so submit none from now on.
+                    for (uint32_t j = 0; j < projection.layer->viewCount; j++) {
+                        layerViews[j].next = nullptr;
+                    }
+                    m_submitDepth = false;
+                }
+            }
+            else {
+                renderSwapchain(nullptr, 0);
+            }
+        }
     }
 }  // namespace Conformance
@@ -21,6 +21,7 @@
 #include <map>
 #include <string>
 #include <atomic>
+#include <chrono>
 #include <mutex>
 #include <thread>
 #include <memory>
@@ -39,6 +40,19 @@ namespace Conformance
     using UpdateLayers = std::function<void(const XrFrameState&)>;
     using EndFrame = std::function<bool(const XrFrameState&)>;  // Return false to stop the loop.
 
+    // Time spent in each stage of a RenderLoop, summed over the frames it has run.
+    struct RenderLoopStageTimings
+    {
+        uint64_t frameCount{0};
+        std::chrono::nanoseconds wait{0};      // In xrWaitFrame.
+        std::chrono::nanoseconds handOff{0};   // From xrWaitFrame returning until the render thread takes the frame. Pipelined only.
+        std::chrono::nanoseconds begin{0};     // In xrBeginFrame.
+        std::chrono::nanoseconds endFrame{0};  // In the EndFrame callback, which renders and calls xrEndFrame.
+        CpuCounters cpuCounters;               // Of the threads in the stages above, with Options::cpuCounters.
+    };
+
+    struct CompositionHelper;
+
     class RenderLoop
     {
     public:
@@ -46,15 +60,42 @@ namespace Conformance
         {
         }
 
+        // Also asks xrWaitFrame whether the secondary view configuration of the helper is active, and tells the helper
+        // before each EndFrame callback, so that SimpleProjectionLayerHelper renders the secondary views while it is.
+        RenderLoop(CompositionHelper& compositionHelper, EndFrame endFrame);
+
         bool IterateFrame();
         void Loop();
 
+        // Runs the loop like Loop, but calls xrWaitFrame on a separate wait thread, which hands each frame state to the calling
+        // thread through a lock-free queue. The calling thread calls xrBeginFrame and the EndFrame callback, so xrWaitFrame for
+        // the next frame overlaps rendering the current one, as in engines with separate game and render threads.
+        void PipelinedLoop();
+
         XrTime GetLastPredictedDisplayTime() const;
 
+        // Sets synthetic CPU work for each frame, none by default. When pipelined, the work before xrWaitFrame runs on the
+        // wait thread. The stage timings do not include it. Only call while no loop is running.
+        void SetCpuLoad(const FrameCpuLoad& cpuLoad)
+        {
+            m_cpuLoad = cpuLoad;
+        }
+
+        // Only valid while no loop is running.
+        const RenderLoopStageTimings& GetStageTimings() const
+        {
+            return m_stageTimings;
+        }
+
     private:
+        void RunPipelined();
+
         XrSession m_session;
+        CompositionHelper* m_compositionHelper{nullptr};
         EndFrame m_endFrame;
         std::atomic<XrTime> m_lastPredictedDisplayTime;
+        RenderLoopStageTimings m_stageTimings;
+        FrameCpuLoad m_cpuLoad;
     };
 
     struct InteractionManager
@@ -77,26 +118,91 @@ namespace Conformance
     struct CompositionHelper
     {
         CompositionHelper(const char* testName, const std::vector<const char*>& additionalEnabledExtensions = std::vector<const char*>());
+
+        // Creates an XR_EXTX_overlay session with the instance, system, event queue and graphics device of mainHelper, which
+        // must have enabled XR_EXTX_overlay and must outlive this helper. The overlay has its own swapchains, spaces and
+        // frame loop, and submits its test name quad with every EndFrame. Throws if the runtime does not allow another
+        // session, for example with XR_ERROR_LIMIT_REACHED. The graphics plugin is not thread-safe, so an overlay's
+        // RenderLoop may run on its own thread only while the frames it submits need no rendering.
+        CompositionHelper(CompositionHelper& mainHelper, const char* testName, uint32_t sessionLayersPlacement);
         ~CompositionHelper();
 
         InteractionManager& GetInteractionManager();
 
         XrInstance GetInstance() const;
         XrSession GetSession() const;
+        XrSystemId GetSystemId() const;
+        XrViewConfigurationType GetPrimaryViewConfigurationType() const;
+
+        // The secondary view configuration asked for with Options::secondaryViewConfiguration, begun with the session, or
+        // XR_VIEW_CONFIGURATION_TYPE_MAX_ENUM if none was or the system does not support it.
+        XrViewConfigurationType GetSecondaryViewConfigurationType() const;
 
         std::vector<XrViewConfigurationView> EnumerateConfigurationViews();
 
+        std::vector<XrViewConfigurationView> EnumerateConfigurationViews(XrViewConfigurationType viewConfigurationType);
+
         XrViewConfigurationProperties GetViewConfigurationProperties();
 
         void BeginSession();
 
-        std::tuple<XrViewState, std::vector<XrView>> LocateViews(XrSpace space, int64_t displayTime);
+        // The result of LocateViews: the view state and a span over the located views.
+        struct LocatedViews
+        {
+            XrViewState viewState;
+            const XrView* views;
+            uint32_t viewCount;
+
+            const XrView* begin() const
+            {
+                return views;
+            }
+            const XrView* end() const
+            {
+                return views + viewCount;
+            }
+            size_t size() const
+            {
+                return viewCount;
+            }
+            const XrView& operator[](size_t index) const
+            {
+                return views[index];
+            }
+        };
+
+        // Locates the primary views in space at displayTime. Each space is only located once per display time: later
+        // calls for the same pair return the first result, so helpers can share one xrLocateViews per frame. The storage
+        // is reused from frame to frame, so a steady-state frame loop does not allocate, and the span stays valid until
+        // the views are located for another display time. Only call from the frame loop thread.
+        LocatedViews LocateViews(XrSpace space, XrTime displayTime);
+
+        // As above, for the primary or the secondary view configuration.
+        LocatedViews LocateViews(XrSpace space, XrTime displayTime, XrViewConfigurationType viewConfigurationType);
+
+        // Whether the secondary view configuration is active for the frame being rendered, as RenderLoop last saw it.
+        // Only call from the frame loop thread.
+        void SetSecondaryViewActive(bool active)
+        {
+            m_secondaryViewActive = active;
+        }
+        bool IsSecondaryViewActive() const
+        {
+            return m_secondaryViewActive;
+        }
+
+        // Submits the layer for the secondary view configuration with the next EndFrame. Only call while it is active.
+        void AddSecondaryLayer(XrCompositionLayerBaseHeader* layer);
 
         bool PollEvents();
 
         EventQueue& GetEventQueue() const;
 
-        void EndFrame(XrTime predictedDisplayTime, std::vector<XrCompositionLayerBaseHeader*> layers);
+        void EndFrame(XrTime predictedDisplayTime, const std::vector<XrCompositionLayerBaseHeader*>& layers);
+
+        // Submits the layers followed by the test name quad. The list submitted to xrEndFrame is kept between frames,
+        // so once it has grown to the largest layer count a steady-state frame loop submits without allocating.
+        void EndFrame(XrTime predictedDisplayTime, XrCompositionLayerBaseHeader* const* layers, size_t layerCount);
 
         void AcquireWaitReleaseImage(XrSwapchain swapchain, std::function<void(const XrSwapchainImageBaseHeader*, uint64_t)> doUpdate);
 
@@ -105,6 +211,10 @@ namespace Conformance
         XrSwapchainCreateInfo DefaultColorSwapchainCreateInfo(uint32_t width, uint32_t height, XrSwapchainCreateFlags createFlags = 0,
                                                               int64_t format = -1);
 
+        // Uses the depth format the graphics plugin prefers among those the runtime offers, see
+        // IGraphicsPlugin::SelectDepthSwapchainFormat.
+        XrSwapchainCreateInfo DefaultDepthSwapchainCreateInfo(uint32_t width, uint32_t height);
+
         XrSwapchain CreateSwapchain(const XrSwapchainCreateInfo& createInfo);
 
         void DestroySwapchain(XrSwapchain swapchain);
@@ -113,20 +223,53 @@ namespace Conformance
 
         XrSwapchain CreateStaticSwapchainImage(const RGBAImage& rgbaImage);
 
+        // Batched forms of the above. The sRGB conversions run on worker threads while the swapchains are created, and
+        // all images are acquired before any are copied and released, so setup does not wait on one swapchain at a time.
+        std::vector<XrSwapchain> CreateStaticSwapchainSolidColors(const std::vector<XrColor4f>& colors);
+
+        std::vector<XrSwapchain> CreateStaticSwapchainImages(const std::vector<RGBAImage>& rgbaImages);
+
+        // Packs the images into as few static swapchains as fit them, each at most maxAtlasSize and the system's maximum
+        // swapchain image size square, and returns the sub-image of each in order. Each image gets a one pixel border
+        // repeating its edges, so filtering at the edges of its imageRect does not pick up its neighbours. Throws if an
+        // image does not fit in an atlas on its own.
+        std::vector<XrSwapchainSubImage> CreateStaticSwapchainAtlas(const std::vector<RGBAImage>& rgbaImages, uint32_t maxAtlasSize = 4096);
+
         XrSwapchainSubImage MakeDefaultSubImage(XrSwapchain swapchain, uint32_t imageArrayIndex = 0);
 
         XrCompositionLayerQuad* CreateQuadLayer(XrSwapchain swapchain, XrSpace space, float width, XrPosef pose = XrPosefCPP());
 
+        // Shows part of a swapchain, such as a sub-image from CreateStaticSwapchainAtlas, with the aspect ratio of its imageRect.
+        XrCompositionLayerQuad* CreateQuadLayer(const XrSwapchainSubImage& subImage, XrSpace space, float width,
+                                                XrPosef pose = XrPosefCPP());
+
         XrCompositionLayerProjection* CreateProjectionLayer(XrSpace space);
 
+        // With a view for each view of the primary or the secondary view configuration.
+        XrCompositionLayerProjection* CreateProjectionLayer(XrSpace space, XrViewConfigurationType viewConfigurationType);
+
+        // Requires XR_KHR_composition_layer_cylinder, which is enabled whenever the runtime supports it.
+        XrCompositionLayerCylinderKHR* CreateCylinderLayer(XrSwapchain swapchain, XrSpace space, float radius, float centralAngle,
+                                                           XrPosef pose = XrPosefCPP());
+
+        // Requires XR_KHR_composition_layer_equirect to be passed in additionalEnabledExtensions.
+        XrCompositionLayerEquirectKHR* CreateEquirectLayer(XrSwapchain swapchain, XrSpace space, float radius, XrPosef pose = XrPosefCPP());
+
     private:
+        void InitializeSession(const char* testName);
+
         std::mutex m_mutex;
 
+        // Null for an overlay helper, which uses the instance of its main helper.
         InstanceREQUIRE m_instance;
+        XrInstance m_instanceHandle{XR_NULL_HANDLE};
         XrSession m_session;
         XrSystemId m_systemId;
+        // Whether this helper initialized the graphics device, and shuts it down when destroyed.
+        bool m_ownsDevice{true};
 
-        std::unique_ptr<EventQueue> m_eventQueue;
+        // Shared with the overlay helpers of the instance.
+        std::shared_ptr<EventQueue> m_eventQueue;
         std::unique_ptr<EventReader> m_privateEventReader;
 
         std::unique_ptr<InteractionManager> m_interactionManager;
@@ -134,10 +277,18 @@ namespace Conformance
         uint64_t m_defaultColorFormat;
         XrViewConfigurationType m_primaryViewType;
         uint32_t m_projectionViewCount{0};
+        XrViewConfigurationType m_secondaryViewType{XR_VIEW_CONFIGURATION_TYPE_MAX_ENUM};
+        uint32_t m_secondaryViewCount{0};
+        XrEnvironmentBlendMode m_secondaryBlendMode{XR_ENVIRONMENT_BLEND_MODE_OPAQUE};
+        bool m_secondaryViewActive{false};
+        // Submitted with the next EndFrame, then cleared.
+        std::vector<const XrCompositionLayerBaseHeader*> m_secondaryLayers;
 
         std::list<XrCompositionLayerProjection> m_projections;
         std::list<std::vector<XrCompositionLayerProjectionView>> m_projectionViews;
         std::list<XrCompositionLayerQuad> m_quads;
+        std::list<XrCompositionLayerCylinderKHR> m_cylinders;
+        std::list<XrCompositionLayerEquirectKHR> m_equirects;
 
         std::map<XrSwapchain, XrSwapchainCreateInfo> m_createdSwapchains;
         std::map<XrSwapchain, std::shared_ptr<Conformance::IGraphicsPlugin::SwapchainImageStructs>> m_swapchainImages;
@@ -147,26 +298,110 @@ namespace Conformance
         XrSpace m_viewSpace{XR_NULL_HANDLE};
 
         XrCompositionLayerQuad m_testNameQuad{XR_TYPE_COMPOSITION_LAYER_QUAD};
+
+        // Reused by EndFrame, which is only called from the frame loop thread.
+        std::vector<const XrCompositionLayerBaseHeader*> m_frameLayers;
+
+        // The views LocateViews has located at m_locatedViewsTime, for either view configuration, in the first
+        // m_locatedViewsCount entries. Entries past those keep their storage for later frames. Moving an entry keeps its
+        // views where they are, so growing the vector does not invalidate spans already handed out.
+        struct LocatedViewsEntry
+        {
+            XrSpace space;
+            XrViewConfigurationType viewConfigurationType;
+            XrViewState viewState;
+            std::vector<XrView> views;
+        };
+        std::vector<LocatedViewsEntry> m_locatedViews;
+        size_t m_locatedViewsCount{0};
+        XrTime m_locatedViewsTime{0};
     };
 
-    // Helper class to provide simple world-locked projection layer of some cubes. Each view of the projection is a separate swapchain.
+    // Helper class to provide simple world-locked projection layer of some cubes, over every view of the view configuration.
+    // Each view of the projection is a separate swapchain, or with Options::viewSwapchainArrays a slice of one array
+    // swapchain shared by the views of its size. While the secondary view configuration of compositionHelper is active,
+    // its views are rendered into a layer of their own as well and submitted with CompositionHelper::AddSecondaryLayer.
     class SimpleProjectionLayerHelper
     {
     public:
-        SimpleProjectionLayerHelper(CompositionHelper& compositionHelper);
+        // With submitDepth, every primary view also gets a depth swapchain that is rendered with
+        // IGraphicsPlugin::RenderViewWithDepth and submitted with XR_KHR_composition_layer_depth, which compositionHelper
+        // must have enabled, and has a color swapchain of its own. The swapchains are the recommended image rect size of
+        // their view times resolutionScale, but no larger than the maximum image rect size.
+        SimpleProjectionLayerHelper(CompositionHelper& compositionHelper, bool submitDepth = false, float resolutionScale = 1.0f);
+        // Destroys the swapchains, so that a test can try several sizes in turn.
+        ~SimpleProjectionLayerHelper();
+        SimpleProjectionLayerHelper(const SimpleProjectionLayerHelper&) = delete;
+        SimpleProjectionLayerHelper& operator=(const SimpleProjectionLayerHelper&) = delete;
         XrCompositionLayerBaseHeader* TryGetUpdatedProjectionLayer(const XrFrameState& frameState,
-                                                                   const std::vector<Cube> cubes = {
-                                                                       Cube::Make({-1, 0, -2}), Cube::Make({1, 0, -2}),
-                                                                       Cube::Make({0, -1, -2}), Cube::Make({0, 1, -2})});
+                                                                   const std::vector<Cube>& cubes = DefaultCubes());
+        // False once the graphics plugin has turned out not to render into the depth swapchains, from which frame on the
+        // layer is submitted without depth, or if depth was not asked for.
+        bool IsSubmittingDepth() const
+        {
+            return m_submitDepth;
+        }
+        XrExtent2Di GetImageRectExtent(uint32_t view) const
+        {
+            return m_primary.layer->views[view].subImage.imageRect.extent;
+        }
+        // The field of view the primary view was last rendered with.
+        XrFovf GetViewFov(uint32_t view) const
+        {
+            return m_primary.layer->views[view].fov;
+        }
+        // Four cubes around the view direction, two meters ahead.
+        static const std::vector<Cube>& DefaultCubes();
         XrSpace GetLocalSpace() const
         {
             return m_localSpace;
         }
 
+        // Fetches the hidden area mesh of every view with xrGetVisibilityMaskKHR, which compositionHelper must have
+        // enabled XR_KHR_visibility_mask for, and from then on renders the views with
+        // IGraphicsPlugin::RenderViewWithVisibilityMask unless submitting depth. Call again after
+        // XrEventDataVisibilityMaskChangedKHR. Returns false, leaving the masks as they were, if the function is unavailable.
+        bool UpdateVisibilityMasks();
+        // Goes back to rendering the views without masks.
+        void ClearVisibilityMasks()
+        {
+            m_visibilityMasks.clear();
+        }
+        // Empty unless masks are in use; the graphics plugin not drawing them also clears them.
+        const std::vector<VisibilityMask>& GetVisibilityMasks() const
+        {
+            return m_visibilityMasks;
+        }
+
     private:
+        // The projection layer of one view configuration with the swapchains its views are rendered into.
+        struct ProjectionViews
+        {
+            XrViewConfigurationType viewConfigurationType{XR_VIEW_CONFIGURATION_TYPE_MAX_ENUM};
+            XrCompositionLayerProjection* layer{nullptr};
+            std::vector<XrSwapchain> swapchains;
+            // The views of each swapchain, in the order of its array slices.
+            std::vector<std::vector<uint32_t>> swapchainViews;
+            // One for each view, when submitting depth, in which case each swapchain holds one view.
+            std::vector<XrSwapchain> depthSwapchains;
+            std::vector<XrCompositionLayerDepthInfoKHR> depthInfos;
+            // Reused to pass the views of one swapchain to ClearAndRenderScene.
+            std::vector<XrCompositionLayerProjectionView> batch;
+        };
+
+        void CreateSwapchains(ProjectionViews& projection, bool submitDepth, float resolutionScale);
+        void DestroySwapchains(ProjectionViews& projection) noexcept;
+        void RenderViews(ProjectionViews& projection, const CompositionHelper::LocatedViews& views, const std::vector<Cube>& cubes);
+
         CompositionHelper& m_compositionHelper;
         XrSpace m_localSpace;
-        XrCompositionLayerProjection* m_projLayer;
-        std::vector<XrSwapchain> m_swapchains;
+        ProjectionViews m_primary;
+        // Without a layer unless the helper has a secondary view configuration.
+        ProjectionViews m_secondary;
+        bool m_submitDepth;
+        // For the primary views.
+        std::vector<VisibilityMask> m_visibilityMasks;
+        // The cubes of the views rendered without depth or masks, kept so that the plugin only updates those that change.
+        std::shared_ptr<CubeScene> m_scene;
     };
 }  // namespace Conformance
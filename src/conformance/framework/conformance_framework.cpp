@@ -15,9 +15,12 @@
 // limitations under the License.
 
 #include "conformance_framework.h"
+#include "conformance_utils.h"
+#include "capability_snapshot.h"
 #include "report.h"
 #include "utils.h"
 #include "two_call_util.h"
+#include "RGBAImage.h"
 #include <stdexcept>
 #include <cstring>
 #include <algorithm>
@@ -61,6 +64,12 @@ namespace Conformance
 
         AppendSprintf(result, "   viewConfiguration: %s\n", viewConfiguration.c_str());
 
+        if (!secondaryViewConfiguration.empty()) {
+            AppendSprintf(result, "   secondaryViewConfiguration: %s\n", secondaryViewConfiguration.c_str());
+        }
+
+        AppendSprintf(result, "   viewSwapchains: %s\n", viewSwapchains.c_str());
+
         AppendSprintf(result, "   enabledAPILayers:\n");
         for (auto& str : enabledAPILayers) {
             AppendSprintf(result, "      %s\n", str.c_str());
@@ -71,8 +80,81 @@ namespace Conformance
             AppendSprintf(result, "      %s\n", str.c_str());
         }
 
+        AppendSprintf(result, "   poolInstances: %s\n", poolInstances ? "yes" : "no");
+        AppendSprintf(result, "   reuseSectionFixtures: %s\n", reuseSectionFixtures ? "yes" : "no");
+
+        if (!resultsStreamFile.empty()) {
+            AppendSprintf(result, "   resultsStream: %s\n", resultsStreamFile.c_str());
+        }
+
+        if (!junitStreamFile.empty()) {
+            AppendSprintf(result, "   junitStream: %s (synced every %u s)\n", junitStreamFile.c_str(), junitStreamSyncSeconds);
+        }
+
+        if (!replayTraceFile.empty()) {
+            AppendSprintf(result, "   replayTrace: %s%s\n", replayTraceFile.c_str(), replayOriginalTiming ? " (original timing)" : "");
+        }
+
+        if (!capabilitySnapshotFile.empty()) {
+            AppendSprintf(result, "   capabilitySnapshot: %s\n", capabilitySnapshotFile.c_str());
+        }
+
+        if (!vulkanPipelineCacheFile.empty()) {
+            AppendSprintf(result, "   vulkanPipelineCache: %s\n", vulkanPipelineCacheFile.c_str());
+        }
+
+        if (!d3d12PipelineLibraryFile.empty()) {
+            AppendSprintf(result, "   d3d12PipelineLibrary: %s\n", d3d12PipelineLibraryFile.c_str());
+        }
+
+        if (vulkanRecordThreads > 1) {
+            AppendSprintf(result, "   vulkanRecordThreads: %u\n", vulkanRecordThreads);
+        }
+
+        if (d3d11RecordThreads > 1) {
+            AppendSprintf(result, "   d3d11RecordThreads: %u\n", d3d11RecordThreads);
+        }
+
+        if (swapchainWaitThreads > 1) {
+            AppendSprintf(result, "   swapchainWaitThreads: %u\n", swapchainWaitThreads);
+        }
+
+        if (!frameLoopScheduling.IsDefault()) {
+            AppendSprintf(result, "   frameLoopScheduling: %s\n", DescribeThreadScheduling(frameLoopScheduling).c_str());
+        }
+
+        if (!workerScheduling.IsDefault()) {
+            AppendSprintf(result, "   workerScheduling: %s\n", DescribeThreadScheduling(workerScheduling).c_str());
+        }
+
+        if (cpuCounters) {
+            AppendSprintf(result, "   cpuCounters: yes\n");
+        }
+
+        if (powerSampleInterval != 0) {
+            AppendSprintf(result, "   powerSampleInterval: %ums\n", powerSampleInterval);
+        }
+
         AppendSprintf(result, "   invalidHandleValidation: %s\n", invalidHandleValidation ? "yes" : "no");
 
+        AppendSprintf(result, "   multithreadingMaxThreads: %u\n", multithreadingMaxThreads);
+
+        AppendSprintf(result, "   swapchainCoverage: %s\n", swapchainCoverage.c_str());
+
+        if (!incrementalResultsFile.empty()) {
+            AppendSprintf(result, "   incremental: %s%s\n", incrementalResultsFile.c_str(), incrementalFullRun ? " (full run)" : "");
+            for (const std::string& tag : incrementalRerunTags) {
+                AppendSprintf(result, "   incrementalRerunTag: %s\n", tag.c_str());
+            }
+        }
+
+        if (shardCount > 1) {
+            AppendSprintf(result, "   shard: %u of %u\n", shardIndex, shardCount);
+            for (const std::string& file : shardTimingFiles) {
+                AppendSprintf(result, "   shardTiming: %s\n", file.c_str());
+            }
+        }
+
         AppendSprintf(result, "   fileLineLoggingEnabled: %s\n", fileLineLoggingEnabled ? "yes" : "no");
 
         AppendSprintf(result, "   debugMode: %s", debugMode ? "yes" : "no");
@@ -110,10 +192,32 @@ namespace Conformance
         AppendSprintf(reportString, "Non-disconnectable devices: %s\n", globalData.options.nonDisconnectableDevices ? "yes" : "no");
         AppendSprintf(reportString, "Test Success Count: %d\n", (int)testSuccessCount);
         AppendSprintf(reportString, "Test Failure Count: %d\n", (int)testFailureCount);
+        AppendSprintf(reportString, "Fast Assertion Pass Count: %llu\n", (unsigned long long)fastAssertionPassCount.load());
 
         return reportString;
     }
 
+    // Asks the runtime for everything in a SystemSnapshot. Throws if a query fails.
+    static std::shared_ptr<SystemSnapshot> QuerySystemSnapshot(XrInstance instance, XrSystemId systemId)
+    {
+        auto snapshot = std::make_shared<SystemSnapshot>();
+        XRC_CHECK_THROW_XRCMD(xrGetSystemProperties(instance, systemId, &snapshot->systemProperties));
+        snapshot->systemProperties.next = nullptr;
+        XRC_CHECK_THROW_XRCMD(doTwoCallInPlace(snapshot->viewConfigurationTypes, xrEnumerateViewConfigurations, instance, systemId));
+        for (XrViewConfigurationType type : snapshot->viewConfigurationTypes) {
+            SystemSnapshot::ViewConfiguration viewConfiguration;
+            viewConfiguration.type = type;
+            XRC_CHECK_THROW_XRCMD(xrGetViewConfigurationProperties(instance, systemId, type, &viewConfiguration.properties));
+            viewConfiguration.properties.next = nullptr;
+            XRC_CHECK_THROW_XRCMD(doTwoCallInPlaceWithEmptyElement(viewConfiguration.views, {XR_TYPE_VIEW_CONFIGURATION_VIEW},
+                                                                   xrEnumerateViewConfigurationViews, instance, systemId, type));
+            XRC_CHECK_THROW_XRCMD(
+                doTwoCallInPlace(viewConfiguration.environmentBlendModes, xrEnumerateEnvironmentBlendModes, instance, systemId, type));
+            snapshot->viewConfigurations.push_back(std::move(viewConfiguration));
+        }
+        return snapshot;
+    }
+
     bool GlobalData::Initialize()
     {
         // NOTE: Runs *after* population of command-line options.
@@ -134,7 +238,7 @@ namespace Conformance
 
         requiredPlatformInstanceExtensions = platformPlugin->GetInstanceExtensions();
         for (auto& str : requiredPlatformInstanceExtensions) {
-            globalData.enabledInstanceExtensionNames.push_back_unique(str);
+            globalData.EnableInstanceExtension(str);
         }
 
         if (globalData.enabledInteractionProfiles.empty()) {
@@ -166,19 +270,25 @@ namespace Conformance
 
             requiredGraphicsInstanceExtensions = graphicsPlugin->GetInstanceExtensions();
             for (auto& str : requiredGraphicsInstanceExtensions) {
-                globalData.enabledInstanceExtensionNames.push_back_unique(str);
+                globalData.EnableInstanceExtension(str);
             }
+
+            // The sizes of the composition test titles, action test messages and instruction text.
+            BakeFontsAsync({32, 40, 48});
         }
 
         // Identify available API layers, and enable at least the conformance layer if available.
         bool useDebugMessenger = false;
+        Stopwatch loaderStopwatch;
         {
+            loaderStopwatch.Restart();
             XrResult result =
                 doTwoCallInPlaceWithEmptyElement(availableAPILayers, {XR_TYPE_API_LAYER_PROPERTIES}, xrEnumerateApiLayerProperties);
             if (XR_FAILED(result)) {
                 ReportF("GlobalData::Initialize: xrEnumerateApiLayerProperties failed with result: %s", ResultToString(result));
                 return false;
             }
+            loaderColdTimings.enumerateApiLayers = loaderStopwatch.Elapsed();
             availableAPILayerNames.clear();
             for (auto& value : availableAPILayers) {
                 availableAPILayerNames.emplace_back(value.layerName);
@@ -193,22 +303,102 @@ namespace Conformance
             }
         }
 
-        XrResult result = doTwoCallInPlaceWithEmptyElement(availableInstanceExtensions, {XR_TYPE_EXTENSION_PROPERTIES},
-                                                           xrEnumerateInstanceExtensionProperties, nullptr);
-        if (XR_FAILED(result)) {
-            ReportF("GlobalData::Initialize: xrEnumerateInstanceExtensionProperties failed with result: %s", ResultToString(result));
+        // A capability snapshot from an earlier run in the same environment stands in for the runtime's answers, once the
+        // probe instance shows that the runtime is still the same.
+        CapabilitySnapshot capabilities;
+        bool useCapabilities = false;
+        if (!options.capabilitySnapshotFile.empty()) {
+            useCapabilities = ReadCapabilitySnapshot(options.capabilitySnapshotFile, capabilities) &&
+                              capabilities.environment == DescribeCapabilityEnvironment(options);
+        }
+
+        auto enumerateInstanceExtensions = [&] {
+            loaderStopwatch.Restart();
+            XrResult enumerateResult = doTwoCallInPlaceWithEmptyElement(availableInstanceExtensions, {XR_TYPE_EXTENSION_PROPERTIES},
+                                                                        xrEnumerateInstanceExtensionProperties, nullptr);
+            if (XR_FAILED(enumerateResult)) {
+                ReportF("GlobalData::Initialize: xrEnumerateInstanceExtensionProperties failed with result: %s",
+                        ResultToString(enumerateResult));
+                return false;
+            }
+            if (loaderColdTimings.enumerateInstanceExtensions.count() == 0) {
+                loaderColdTimings.enumerateInstanceExtensions = loaderStopwatch.Elapsed();
+            }
+            return true;
+        };
+
+        if (useCapabilities) {
+            availableInstanceExtensions = capabilities.instanceExtensions;
+        }
+        else if (!enumerateInstanceExtensions()) {
             return false;
         }
 
         // Create an initial instance for the purpose of identifying available extensions. And API layers, in some platform configurations.
+        loaderStopwatch.Restart();
         AutoBasicInstance autoInstance(AutoBasicInstance::skipDebugMessenger);
+        loaderColdTimings.createInstance = loaderStopwatch.Elapsed();
 
-        result = xrGetInstanceProperties(autoInstance, &instanceProperties);
+        XrResult result = xrGetInstanceProperties(autoInstance, &instanceProperties);
         if (XR_FAILED(result)) {
             ReportF("GlobalData::Initialize: GetInstanceProperties failed with result: %s", ResultToString(result));
             return false;
         }
 
+        if (useCapabilities &&
+            (capabilities.runtimeName != instanceProperties.runtimeName || capabilities.runtimeVersion != instanceProperties.runtimeVersion)) {
+            ReportF("GlobalData::Initialize: capability snapshot %s is of runtime %s, probing %s instead.",
+                    options.capabilitySnapshotFile.c_str(), capabilities.runtimeName.c_str(), instanceProperties.runtimeName);
+            useCapabilities = false;
+            if (!enumerateInstanceExtensions()) {
+                return false;
+            }
+        }
+
+        // The runtime may hand out a different system id, or none, than when the snapshot was taken.
+        XrSystemGetInfo systemGetInfo{XR_TYPE_SYSTEM_GET_INFO};
+        systemGetInfo.formFactor = options.formFactorValue;
+        XrSystemId systemId = XR_NULL_SYSTEM_ID;
+        const bool haveSystem =
+            !options.capabilitySnapshotFile.empty() && XR_SUCCEEDED(xrGetSystem(autoInstance, &systemGetInfo, &systemId));
+        const bool systemMatches = (capabilities.system == nullptr)
+                                       ? !haveSystem
+                                       : (haveSystem && capabilities.system->systemProperties.systemId == systemId);
+        if (useCapabilities && !systemMatches) {
+            ReportF("GlobalData::Initialize: capability snapshot %s does not match the runtime's system, probing it instead.",
+                    options.capabilitySnapshotFile.c_str());
+            useCapabilities = false;
+            if (!enumerateInstanceExtensions()) {
+                return false;
+            }
+        }
+
+        if (useCapabilities) {
+            persistedSystemSnapshot = capabilities.system;
+        }
+        else if (!options.capabilitySnapshotFile.empty()) {
+            capabilities = CapabilitySnapshot{};
+            capabilities.environment = DescribeCapabilityEnvironment(options);
+            capabilities.runtimeName = instanceProperties.runtimeName;
+            capabilities.runtimeVersion = instanceProperties.runtimeVersion;
+            capabilities.instanceExtensions = availableInstanceExtensions;
+
+            // A runtime with no system of the form factor yet is snapshotted without one.
+            if (haveSystem) {
+                try {
+                    capabilities.system = QuerySystemSnapshot(autoInstance, systemId);
+                }
+                catch (const std::exception& e) {
+                    ReportF("GlobalData::Initialize: capability snapshot left without its system: %s", e.what());
+                }
+            }
+            persistedSystemSnapshot = capabilities.system;
+
+            if (!WriteCapabilitySnapshot(options.capabilitySnapshotFile, capabilities)) {
+                ReportF("GlobalData::Initialize: could not write capability snapshot %s.", options.capabilitySnapshotFile.c_str());
+            }
+        }
+
         /// @todo Also query extensions provided by any layers that are enabled.
         availableInstanceExtensionNames.clear();
         for (auto& value : availableInstanceExtensions) {
@@ -222,18 +412,28 @@ namespace Conformance
         for (auto& value : enableIfAvailableInstanceExtensionNames) {
             auto& avail = availableInstanceExtensionNames;
             if (std::find(avail.begin(), avail.end(), value) != avail.end()) {
-                enabledInstanceExtensionNames.push_back_unique(value);
+                EnableInstanceExtension(value);
             }
         }
 
         if (useDebugMessenger) {
-            enabledInstanceExtensionNames.push_back_unique(XR_EXT_DEBUG_UTILS_EXTENSION_NAME);
+            EnableInstanceExtension(XR_EXT_DEBUG_UTILS_EXTENSION_NAME);
+        }
+
+        // The view configurations asked for on the command line need their extensions, which fail the test if unsupported.
+        if (options.viewConfigurationValue == XR_VIEW_CONFIGURATION_TYPE_PRIMARY_QUAD_VARJO) {
+            EnableInstanceExtension(XR_VARJO_QUAD_VIEWS_EXTENSION_NAME);
+        }
+        if (options.secondaryViewConfigurationValue == XR_VIEW_CONFIGURATION_TYPE_SECONDARY_MONO_FIRST_PERSON_OBSERVER_MSFT) {
+            EnableInstanceExtension(XR_MSFT_SECONDARY_VIEW_CONFIGURATION_EXTENSION_NAME);
+            EnableInstanceExtension(XR_MSFT_FIRST_PERSON_OBSERVER_EXTENSION_NAME);
         }
 
         // Fill out the functions in functionInfoMap.
         // Keep trying all functions, only failing out at end if one of them failed.
         bool functionMapInitialized = true;
         const FunctionInfoMap& functionInfoMap = GetFunctionInfoMap();
+        loaderStopwatch.Restart();
         for (auto& functionInfo : functionInfoMap) {
             // We need to poke the address pointer into map entries.
             result = xrGetInstanceProcAddr(autoInstance, functionInfo.first.c_str(),
@@ -269,6 +469,8 @@ namespace Conformance
             }
         }
 
+        loaderColdTimings.getInstanceProcAddr = loaderStopwatch.Elapsed();
+
         if (!functionMapInitialized) {
             ReportF("GlobalData::Initialize: xrGetInstanceProcAddr failed for one or more functions.");
             return false;
@@ -287,8 +489,17 @@ namespace Conformance
 
     void GlobalData::Shutdown()
     {
+        // Fixtures may hold instances, so they go first.
+        ReleaseSectionFixtures();
+
         std::lock_guard<std::recursive_mutex> lock(dataMutex);
 
+        for (XrInstance instance : idlePooledInstances) {
+            ForgetPathCache(instance);
+            xrDestroyInstance(instance);
+        }
+        idlePooledInstances.clear();
+
         if (IsUsingGraphicsPlugin()) {
             if (graphicsPlugin->IsInitialized()) {
                 graphicsPlugin->ShutdownDevice();
@@ -303,6 +514,108 @@ namespace Conformance
         isInitialized = false;
     }
 
+    XrResult GlobalData::AcquirePooledInstance(XrInstance* instance)
+    {
+        {
+            std::lock_guard<std::recursive_mutex> lock(dataMutex);
+            if (!idlePooledInstances.empty()) {
+                *instance = idlePooledInstances.back();
+                idlePooledInstances.pop_back();
+                return XR_SUCCESS;
+            }
+        }
+
+        return CreateBasicInstance(instance);
+    }
+
+    const SystemSnapshot::ViewConfiguration* SystemSnapshot::FindViewConfiguration(XrViewConfigurationType type) const
+    {
+        for (const ViewConfiguration& viewConfiguration : viewConfigurations) {
+            if (viewConfiguration.type == type) {
+                return &viewConfiguration;
+            }
+        }
+        return nullptr;
+    }
+
+    std::shared_ptr<const SystemSnapshot> GlobalData::GetSystemSnapshot(XrInstance instance, XrSystemId systemId)
+    {
+        const uint64_t generation = GetPathCacheGeneration(instance);
+        if (generation != 0) {
+            std::lock_guard<std::recursive_mutex> lock(dataMutex);
+            for (const CachedSystemSnapshot& cached : systemSnapshots) {
+                if (cached.instance == instance && cached.systemId == systemId && cached.pathCacheGeneration == generation) {
+                    return cached.snapshot;
+                }
+            }
+        }
+
+        // Queried without holding dataMutex, so that other threads are not held up by the runtime. Two threads may
+        // both query the same system, and then the later snapshot simply replaces the earlier. The persisted snapshot
+        // is only used once this instance reports its system id for the form factor, as system ids need not be the
+        // same across instances.
+        std::shared_ptr<const SystemSnapshot> snapshot;
+        if (generation != 0 && persistedSystemSnapshot != nullptr && persistedSystemSnapshot->systemProperties.systemId == systemId) {
+            XrSystemGetInfo systemGetInfo{XR_TYPE_SYSTEM_GET_INFO};
+            systemGetInfo.formFactor = options.formFactorValue;
+            XrSystemId liveSystemId = XR_NULL_SYSTEM_ID;
+            if (XR_SUCCEEDED(xrGetSystem(instance, &systemGetInfo, &liveSystemId)) && liveSystemId == systemId) {
+                snapshot = persistedSystemSnapshot;
+            }
+        }
+        if (snapshot == nullptr) {
+            snapshot = QuerySystemSnapshot(instance, systemId);
+        }
+
+        if (generation != 0) {
+            std::lock_guard<std::recursive_mutex> lock(dataMutex);
+            // Entries of destroyed instances, or of an earlier instance with the same handle, are dropped here.
+            systemSnapshots.erase(std::remove_if(systemSnapshots.begin(), systemSnapshots.end(),
+                                                 [&](const CachedSystemSnapshot& cached) {
+                                                     return (cached.instance == instance && cached.systemId == systemId) ||
+                                                            cached.pathCacheGeneration != GetPathCacheGeneration(cached.instance);
+                                                 }),
+                                  systemSnapshots.end());
+            systemSnapshots.push_back(CachedSystemSnapshot{instance, systemId, generation, snapshot});
+        }
+        return snapshot;
+    }
+
+    void GlobalData::ReleasePooledInstance(XrInstance instance)
+    {
+        // Keep enough instances for the test cases that use two at once; more would only hold runtime resources.
+        constexpr size_t maxIdlePooledInstances = 2;
+
+        std::lock_guard<std::recursive_mutex> lock(dataMutex);
+        if (!options.poolInstances || idlePooledInstances.size() >= maxIdlePooledInstances) {
+            ForgetPathCache(instance);
+            xrDestroyInstance(instance);
+            return;
+        }
+
+        // Events queued for sessions of the previous user must not reach the next one.
+        XrEventDataBuffer eventData{XR_TYPE_EVENT_DATA_BUFFER};
+        XrResult result;
+        while ((result = xrPollEvent(instance, &eventData)) == XR_SUCCESS) {
+            eventData = {XR_TYPE_EVENT_DATA_BUFFER};
+        }
+        if (XR_FAILED(result)) {
+            ForgetPathCache(instance);
+            xrDestroyInstance(instance);
+            return;
+        }
+
+        idlePooledInstances.push_back(instance);
+    }
+
+    void GlobalData::ReleaseSectionFixtures()
+    {
+        // Newest first, since a fixture may have been built from an earlier one.
+        while (!sectionFixtures.empty()) {
+            sectionFixtures.pop_back();
+        }
+    }
+
     RandEngine& GlobalData::GetRandEngine()
     {
         return randEngine;
@@ -355,6 +668,12 @@ namespace Conformance
     {
         std::lock_guard<std::recursive_mutex> lock(dataMutex);
 
+        const size_t index = XrExtensionIndexFromName(extensionName);
+        if (index != kXrExtensionCount) {
+            return enabledInstanceExtensions.Contains(index);
+        }
+
+        // Unknown to this build, so it can only be found by name.
         for (const char* name : enabledInstanceExtensionNames) {
             if (strequal(name, extensionName)) {
                 return true;
@@ -364,6 +683,25 @@ namespace Conformance
         return false;
     }
 
+    void GlobalData::EnableInstanceExtension(const std::string& extensionName)
+    {
+        std::lock_guard<std::recursive_mutex> lock(dataMutex);
+
+        enabledInstanceExtensionNames.push_back_unique(extensionName);
+        enabledInstanceExtensions.Insert(extensionName.c_str());
+    }
+
+    void GlobalData::SetEnabledInstanceExtensions(const std::vector<std::string>& extensionNames)
+    {
+        std::lock_guard<std::recursive_mutex> lock(dataMutex);
+
+        enabledInstanceExtensionNames = extensionNames;
+        enabledInstanceExtensions.Clear();
+        for (const std::string& extensionName : extensionNames) {
+            enabledInstanceExtensions.Insert(extensionName.c_str());
+        }
+    }
+
     bool GlobalData::IsInstanceExtensionSupported(const char* extensionName) const
     {
         std::lock_guard<std::recursive_mutex> lock(dataMutex);
@@ -16,7 +16,12 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <memory>
 #include <string>
+#include <typeinfo>
+#include <utility>
 #include <vector>
 #include <mutex>
 #include <stdarg.h>
@@ -24,8 +29,10 @@
 #include <openxr/openxr_reflection.h>
 #include "utils.h"
 #include "conformance_utils.h"
+#include "extension_registry.h"
 #include "platform_plugin.h"
 #include "graphics_plugin.h"
+#include "thread_scheduling.h"
 #include <catch2/catch.hpp>
 
 #ifdef XR_USE_PLATFORM_WIN32
@@ -86,6 +93,32 @@
 //
 #define REQUIRE_RESULT_UNQUALIFIED_SUCCESS(result) REQUIRE(result == XR_SUCCESS)
 
+// FAST_REQUIRE_RESULT / FAST_CHECK_RESULT_SUCCEEDED / FAST_REQUIRE_RESULT_SUCCEEDED / FAST_REQUIRE_RESULT_UNQUALIFIED_SUCCESS
+// The same checks as the macros above, for frame, stress and benchmark loops that make so many calls that Catch's
+// assertion handling would dominate them. A pass only increments ConformanceReport::fastAssertionPassCount; Catch
+// is only involved on failure, which is reported as usual with the checked expression as its message.
+// Example usage:
+//     for (XrSpace space : spaces) {
+//         FAST_REQUIRE_RESULT_UNQUALIFIED_SUCCESS(xrLocateSpace(space, baseSpace, time, &location));
+//     }
+//
+#define XRC_FAST_RESULT_ASSERTION(macroName, result, resultCondition)                                         \
+    do {                                                                                                      \
+        const XrResult xrcFastResult = (result);                                                              \
+        if (resultCondition) {                                                                                \
+            auto& xrcFastPassCount = ::Conformance::GetGlobalData().conformanceReport.fastAssertionPassCount; \
+            xrcFastPassCount.fetch_add(1, std::memory_order_relaxed);                                         \
+        }                                                                                                     \
+        else {                                                                                                \
+            INFO(#result);                                                                                    \
+            macroName(resultCondition);                                                                       \
+        }                                                                                                     \
+    } while (0)
+#define FAST_REQUIRE_RESULT(result, expectedResult) XRC_FAST_RESULT_ASSERTION(REQUIRE, result, xrcFastResult == (expectedResult))
+#define FAST_CHECK_RESULT_SUCCEEDED(result) XRC_FAST_RESULT_ASSERTION(CHECK, result, xrcFastResult >= 0)
+#define FAST_REQUIRE_RESULT_SUCCEEDED(result) XRC_FAST_RESULT_ASSERTION(REQUIRE, result, xrcFastResult >= 0)
+#define FAST_REQUIRE_RESULT_UNQUALIFIED_SUCCESS(result) XRC_FAST_RESULT_ASSERTION(REQUIRE, result, xrcFastResult == XR_SUCCESS)
+
 // XRC_FILE_AND_LINE
 // Represents a compile time file and line location as a single string.
 //
@@ -94,8 +127,14 @@
 #define XRC_FILE_AND_LINE __FILE__ ":" XRC_TO_STRING(__LINE__)
 
 #if defined(XR_USE_PLATFORM_ANDROID)
+// Attaches the calling thread to the Java VM, unless it is already attached, and detaches it when the thread exits.
+// Cheap after the first call on a thread, so pooled workers and frame loops call it on entry rather than per task.
 void Conformance_Android_Attach_Current_Thread();
+// Detaches the calling thread now, if Conformance_Android_Attach_Current_Thread attached it.
 void Conformance_Android_Detach_Current_Thread();
+// Reads the battery power draw in watts and PowerManager's thermal status, or -1 if the device has none, for PowerMonitor.
+// Returns false if the device does not report its battery current and voltage.
+bool Conformance_Android_Read_Power(double* watts, int32_t* thermalStatus);
 #define ATTACH_THREAD Conformance_Android_Attach_Current_Thread()
 #define DETACH_THREAD Conformance_Android_Detach_Current_Thread()
 #else
@@ -153,8 +192,17 @@ namespace Conformance
         Throw(StringSprintf("XrResult failure [%d]", res), originator, sourceLocation);
     }
 
+    // Counts the results checked by CheckThrowXrResult, which is almost every OpenXR call made by the framework
+    // helpers. The results stream reports it per test case as an approximate API call count.
+    inline std::atomic<uint64_t>& CheckedCallCount()
+    {
+        static std::atomic<uint64_t> count{0};
+        return count;
+    }
+
     inline XrResult CheckThrowXrResult(XrResult res, const char* originator = nullptr, const char* sourceLocation = nullptr) noexcept(false)
     {
+        CheckedCallCount().fetch_add(1, std::memory_order_relaxed);
         if (XR_FAILED(res)) {
             ThrowXrResult(res, originator, sourceLocation);
         }
@@ -210,11 +258,25 @@ namespace Conformance
         std::string formFactor{"Hmd"};
         XrFormFactor formFactorValue{XR_FORM_FACTOR_HEAD_MOUNTED_DISPLAY};
 
-        // Options include "stereo" "mono". See enum XrViewConfigurationType.
+        // Options include "stereo" "mono" "quad". See enum XrViewConfigurationType. Quad is
+        // XR_VIEW_CONFIGURATION_TYPE_PRIMARY_QUAD_VARJO and enables XR_VARJO_quad_views.
         // Default is stereo.
         std::string viewConfiguration{"Stereo"};
         XrViewConfigurationType viewConfigurationValue{XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO};
 
+        // Options include "firstpersonobserver", which enables XR_MSFT_secondary_view_configuration and
+        // XR_MSFT_first_person_observer, so that SimpleProjectionLayerHelper also renders the observer view while the
+        // runtime reports it active. Ignored if the system does not support it.
+        // Default is none.
+        std::string secondaryViewConfiguration{};
+        XrViewConfigurationType secondaryViewConfigurationValue{XR_VIEW_CONFIGURATION_TYPE_MAX_ENUM};
+
+        // Options include "separate" "array". With array, SimpleProjectionLayerHelper renders the views of equal size into
+        // the slices of one array swapchain, with one ClearAndRenderScene, unless it submits depth.
+        // Default is separate.
+        std::string viewSwapchains{"Separate"};
+        bool viewSwapchainArrays{false};
+
         // Options include "opaque" "additive" "alphablend". See enum XrEnvironmentBlendMode.
         // Default is opaque.
         std::string environmentBlendMode{"Opaque"};
@@ -249,6 +311,121 @@ namespace Conformance
         // If true the runtime does not support disconnectable devices.
         bool nonDisconnectableDevices{false};
 
+        // The maximum number of threads the multithreading benchmark scales up to. It is never more than the
+        // hardware concurrency.
+        // Default is 0, which means the hardware concurrency.
+        uint32_t multithreadingMaxThreads{0};
+
+        // How the xrCreateSwapchain test combines the create flags, sample counts, usage flags, array sizes and mip counts
+        // of each format. "OneFactor" varies one of them at a time from the defaults. "Pairwise" creates a covering array
+        // in which every pair of values of any two of them is used together at least once.
+        // Default is OneFactor.
+        std::string swapchainCoverage{"OneFactor"};
+        bool swapchainCoveragePairwise{false};
+
+        // If true then test cases that opt in with AutoBasicInstance::allowPooled get an instance reused from
+        // earlier test cases instead of a new one. Sessions, and the instances of AutoBasicSession, are always
+        // created fresh.
+        // Default is false.
+        bool poolInstances{false};
+
+        // If true then fixtures from GlobalData::GetSectionFixture stay alive while Catch2 re-runs a test case body
+        // for each of its leaf sections, instead of being made again for every run.
+        // Default is false.
+        bool reuseSectionFixtures{false};
+
+        // If not empty then per-test-case and per-section timing, checked API call counts and peak resident memory
+        // are written to this file as JSON lines while the tests run.
+        // Default is empty.
+        std::string resultsStreamFile;
+
+        // If not empty then every test case is written to this file as JUnit XML as soon as it ends, gzip compressed if
+        // the name ends in ".gz" and the build has zlib.
+        // Default is empty.
+        std::string junitStreamFile;
+
+        // The most seconds between syncs of the junitStreamFile to storage; 0 syncs after every test case.
+        // Default is 10.
+        uint32_t junitStreamSyncSeconds{10};
+
+        // If not empty then the Trace Replay Benchmark replays the calls in this conformance layer call trace
+        // (written with XR_CONFORMANCE_LAYER_TRACE) against the runtime.
+        // Default is empty.
+        std::string replayTraceFile;
+
+        // If true then the Trace Replay Benchmark issues each call at its traced time instead of as fast as possible.
+        // Default is false.
+        bool replayOriginalTiming{false};
+
+        // If not empty then GlobalData::Initialize keeps what it learns by probing the runtime in this file, and later
+        // runs in the same environment against the same runtime name and version read it back instead of probing: the
+        // instance extensions, and the system properties and view configurations of the form factor. See
+        // CapabilitySnapshot. Default is empty, which probes the runtime on every run.
+        std::string capabilitySnapshotFile;
+
+        // If not empty then the Vulkan graphics plugin loads its pipeline cache from this file when creating a device
+        // and saves it back when shutting the device down, so later runs skip most pipeline compiles.
+        // Default is empty, which keeps the cache in memory for the run only.
+        std::string vulkanPipelineCacheFile;
+
+        // If not empty then the D3D12 graphics plugin loads its pipeline library from this file when creating a device
+        // and saves it back when shutting the device down, so later runs skip most pipeline state compiles.
+        // Default is empty, which keeps the library in memory for the run only.
+        std::string d3d12PipelineLibraryFile;
+
+        // If more than 1 then the Vulkan graphics plugin records the views of a frame into secondary command buffers on
+        // this many worker threads, each with its own command pools, and executes them from one primary command buffer,
+        // as multi-threaded engines do. Default is 0, which records every view on the calling thread.
+        uint32_t vulkanRecordThreads{0};
+
+        // If more than 1 then the D3D11 graphics plugin records the views of a frame on this many deferred contexts, each
+        // on its own worker thread, and executes the command lists on the immediate context. Not used with a device
+        // created with D3D11_CREATE_DEVICE_SINGLETHREADED. Default is 0, which draws every view on the immediate context.
+        uint32_t d3d11RecordThreads{0};
+
+        // If more than 1 then FrameIterator::CycleToNextSwapchainImage acquires the image of every swapchain first, waits
+        // for them on this many worker threads at once and then releases them all, so that a frame with many layers
+        // waits about as long as its slowest swapchain rather than the sum of all of them. Not used with OpenGL and
+        // OpenGL ES, whose runtimes may use the context that is current on the calling thread when waiting.
+        // Default is 0, which acquires, waits for and releases each swapchain in turn.
+        uint32_t swapchainWaitThreads{0};
+
+        // CPU affinity and priority of the threads that run frame loops (RenderLoop and FrameIterator), and of the
+        // workers of the multithreading tests, while those run. See ThreadScheduling.
+        // Default is unchanged affinity and Normal priority.
+        ThreadScheduling frameLoopScheduling;
+        ThreadScheduling workerScheduling;
+
+        // If true then the frame loops (RenderLoop and FrameIterator) also count the CPU cycles, instructions, cache misses
+        // and context switches of their threads in the runtime calls they time, and the benchmarks report them per frame.
+        // See CpuCounters. Default is false.
+        bool cpuCounters{false};
+
+        // If not 0 then the sustained-load benchmarks sample the device's battery power draw and thermal status every this
+        // many milliseconds while they measure, and report the energy per frame. Android only, see PowerMonitor.
+        // Default is 0 (not sampled).
+        uint32_t powerSampleInterval{0};
+
+        // Splits the selected test cases into this many parts, by name, and runs only the part given by
+        // shardIndex. Separate processes with the same options and different shard indices run disjoint parts
+        // of the selection; conformance_cli --shards launches them.
+        // Default is 1 (no sharding) and shard 0.
+        uint32_t shardCount{1};
+        uint32_t shardIndex{0};
+
+        // Results streams of earlier runs. When given, the parts are balanced by the test case times recorded in them,
+        // longest first, instead of being dealt out by name. Default is none.
+        std::vector<std::string> shardTimingFiles;
+
+        // If not empty then the result of every test case run is added to this file, under a fingerprint of the
+        // runtime name and version and of these options, and only the selected test cases that failed or have no
+        // result under the current fingerprint are run. Test cases with any of incrementalRerunTags, such as
+        // "[actions]", run regardless, and incrementalFullRun runs the whole selection while still adding the results.
+        // Default is none (every selected test case runs).
+        std::string incrementalResultsFile;
+        std::vector<std::string> incrementalRerunTags;
+        bool incrementalFullRun{false};
+
         // If true then all test diagnostics are reported with the file/line that they occurred on.
         // Default is true (enabled).
         bool fileLineLoggingEnabled{true};
@@ -278,6 +455,44 @@ namespace Conformance
         XrVersion apiVersion{XR_CURRENT_API_VERSION};
         size_t testSuccessCount{};
         size_t testFailureCount{};
+
+        // Checks passed through the FAST_ assertion macros, which Catch does not see.
+        std::atomic<uint64_t> fastAssertionPassCount{};
+    };
+
+    // The answers of xrGetSystemProperties and of the view configuration queries for one system. They cannot change
+    // while the instance lives, so framework code reads them from GlobalData::GetSystemSnapshot rather than asking the
+    // runtime again. Test cases that verify these queries still make them.
+    struct SystemSnapshot
+    {
+        struct ViewConfiguration
+        {
+            XrViewConfigurationType type;
+            XrViewConfigurationProperties properties{XR_TYPE_VIEW_CONFIGURATION_PROPERTIES};
+            std::vector<XrViewConfigurationView> views;
+            std::vector<XrEnvironmentBlendMode> environmentBlendModes;
+        };
+
+        XrSystemProperties systemProperties{XR_TYPE_SYSTEM_PROPERTIES};
+
+        // As xrEnumerateViewConfigurations returns them, and one ViewConfiguration for each, in the same order.
+        std::vector<XrViewConfigurationType> viewConfigurationTypes;
+        std::vector<ViewConfiguration> viewConfigurations;
+
+        // Returns nullptr if the system does not support the view configuration type.
+        const ViewConfiguration* FindViewConfiguration(XrViewConfigurationType type) const;
+    };
+
+    // How long GlobalData::Initialize took for the first loader calls of the process, which pay for reading manifests and
+    // loading the runtime and layers. Zero for a call it did not make, such as an enumeration answered by the
+    // capability snapshot.
+    struct LoaderColdTimings
+    {
+        std::chrono::nanoseconds enumerateApiLayers{0};
+        std::chrono::nanoseconds enumerateInstanceExtensions{0};
+        std::chrono::nanoseconds createInstance{0};
+        // Every function of GetFunctionInfoMap, looked up on the probe instance.
+        std::chrono::nanoseconds getInstanceProcAddr{0};
     };
 
     // A single place where all singleton data hangs off of.
@@ -299,7 +514,9 @@ namespace Conformance
         // Matches a successful call to Initialize.
         void Shutdown();
 
-        // Returns the default random number engine.
+        // Returns the default random number engine, seeded by --randSeed. It is shared by every thread, so code that
+        // draws from several threads, or wants a sequence that does not depend on earlier tests, should construct
+        // its own stream of this engine's seed instead; see RandEngine.
         RandEngine& GetRandEngine();
 
         const FunctionInfo& GetFunctionInfo(const char* functionName) const;
@@ -316,6 +533,10 @@ namespace Conformance
         // case sensitive check.
         bool IsInstanceExtensionEnabled(const char* extensionName) const;
 
+        // Adds to or replaces enabledInstanceExtensionNames, keeping enabledInstanceExtensions in step with it.
+        void EnableInstanceExtension(const std::string& extensionName);
+        void SetEnabledInstanceExtensions(const std::vector<std::string>& extensionNames);
+
         // case sensitive check.
         bool IsInstanceExtensionSupported(const char* extensionName) const;
 
@@ -332,6 +553,42 @@ namespace Conformance
         // Returns true if a graphics plugin was supplied, or if IsGraphicsPluginRequired() is true.
         bool IsUsingGraphicsPlugin() const;
 
+        // Returns an instance created as CreateBasicInstance does by default. If Options::poolInstances is true
+        // an idle instance handed back by an earlier test case is reused.
+        XrResult AcquirePooledInstance(XrInstance* instance);
+
+        // Hands back an instance from AcquirePooledInstance. The caller must have destroyed every handle it
+        // created from the instance. Pending events are discarded before the instance is reused.
+        void ReleasePooledInstance(XrInstance instance);
+
+        // Returns the snapshot of the system's properties and view configurations. For instances with the path cache
+        // enabled (see EnablePathCache) the runtime is only queried the first time; for others on every call.
+        // Throws if a query fails.
+        std::shared_ptr<const SystemSnapshot> GetSystemSnapshot(XrInstance instance, XrSystemId systemId);
+
+        // Returns the fixture of this name for the current test case, constructing a T from args if there is none yet.
+        // Catch2 runs a test case body once per leaf section; with Options::reuseSectionFixtures the fixture is kept
+        // for the runs after the first, so only ask for fixtures that no section changes. Otherwise, and after a run
+        // with failed assertions, it is destroyed when the run ends, as a local would be. Only call from the thread
+        // running the test case, and not from the fixture's own constructor.
+        template <typename T, typename... Args>
+        T& GetSectionFixture(const char* name, Args&&... args)
+        {
+            for (const SectionFixture& fixture : sectionFixtures) {
+                if (fixture.name == name) {
+                    XRC_CHECK_THROW(*fixture.type == typeid(T));
+                    return *static_cast<T*>(fixture.object.get());
+                }
+            }
+            std::shared_ptr<T> object = std::make_shared<T>(std::forward<Args>(args)...);
+            sectionFixtures.push_back(SectionFixture{name, &typeid(T), object});
+            return *object;
+        }
+
+        // Destroys the fixtures from GetSectionFixture, newest first. Called at the end of every run of a test case
+        // body, and of the test case, as Options::reuseSectionFixtures asks.
+        void ReleaseSectionFixtures();
+
     public:
         // Guards all member data.
         mutable std::recursive_mutex dataMutex;
@@ -370,6 +627,9 @@ namespace Conformance
         XrSystemId invalidSystemId{XRC_INVALID_SYSTEM_ID_VALUE};
         XrPath invalidPath{XRC_INVALID_PATH_VALUE};
 
+        // Set by Initialize, for the Loader Cold and Warm Benchmark.
+        LoaderColdTimings loaderColdTimings;
+
         // The API layers currently available.
         std::vector<XrApiLayerProperties> availableAPILayers;
         std::vector<std::string> availableAPILayerNames;
@@ -390,9 +650,41 @@ namespace Conformance
         // The instance extensions that have been requested to be enabled. Suitable for passing to OpenXR.
         StringVec enabledInstanceExtensionNames;
 
+        // The extensions in enabledInstanceExtensionNames that are known to this build, so that checking for one is a
+        // bit test. Only valid if enabledInstanceExtensionNames is modified through EnableInstanceExtension and
+        // SetEnabledInstanceExtensions.
+        XrExtensionSet enabledInstanceExtensions;
+
         // The interaction profiles that have been requested to be tested.
         StringVec enabledInteractionProfiles;
 
+        // Instances waiting to be handed out again by AcquirePooledInstance.
+        std::vector<XrInstance> idlePooledInstances;
+
+        // The snapshots from GetSystemSnapshot, with the path cache generation of the instance they were taken on.
+        struct CachedSystemSnapshot
+        {
+            XrInstance instance;
+            XrSystemId systemId;
+            uint64_t pathCacheGeneration;
+            std::shared_ptr<const SystemSnapshot> snapshot;
+        };
+        std::vector<CachedSystemSnapshot> systemSnapshots;
+
+        // The system of the form factor from Options::capabilitySnapshotFile, given by GetSystemSnapshot for that system
+        // once xrGetSystem on the instance reports its id, without querying the rest. Null without a snapshot.
+        std::shared_ptr<const SystemSnapshot> persistedSystemSnapshot;
+
+        // The fixtures of the current test case, oldest first. Only used by the thread running the test case, and not
+        // guarded by dataMutex so that fixtures can take it while they are built.
+        struct SectionFixture
+        {
+            std::string name;
+            const std::type_info* type;
+            std::shared_ptr<void> object;
+        };
+        std::vector<SectionFixture> sectionFixtures;
+
         // Required instance creation extension struct, or nullptr.
         // This is a pointer into IPlatformPlugin-provided memory.
         XrBaseInStructure* requiredPlaformInstanceCreateStruct{};
@@ -24,9 +24,14 @@
 #include "openxr/openxr_platform.h"
 #include "openxr/openxr_reflection.h"
 #include "graphics_plugin.h"
+#include "trace_scope.h"
 #include <openxr/openxr_reflection.h>
+#include <atomic>
 #include <map>
+#include <mutex>
+#include <unordered_map>
 #include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <assert.h>
 #include <cstring>
@@ -52,40 +57,164 @@ namespace Conformance
 
     // We keep our own copy of this as opposed to calling the xrResultToString function, because our
     // purpose here it to validate the runtime's implementation of xrResultToString.
-    const ResultStringMap resultStringMap{XR_LIST_ENUM_XrResult(XRC_ENUM_NAME_PAIR)};
+    const ResultStringTable resultStringTable{XR_LIST_ENUM_XrResult(XRC_ENUM_NAME_PAIR)};
 
-    const ResultStringMap& GetResultStringMap()
+    const ResultStringTable& GetResultStringTable()
     {
-        return resultStringMap;
+        return resultStringTable;
     }
 
-    const std::map<uint64_t, const char*> GetNumberExtensionMap()
+    const char* ResultToString(XrResult result)
     {
-#define MAKE_EXTENSION_NUMBER_MAP(NAME, NUM) {NUM, #NAME},
-        static const std::map<uint64_t, const char*> myMap = {XR_LIST_EXTENSIONS(MAKE_EXTENSION_NUMBER_MAP)};
-        return myMap;
+        return resultStringTable.Find(result, "<unknown>");
     }
 
-    const char* ResultToString(XrResult result)
+    std::string PathToString(XrInstance instance, XrPath path)
+    {
+        std::string pathString;
+        if (XR_SUCCEEDED(CachedPathToString(instance, path, &pathString))) {
+            return pathString;
+        }
+        return "<unknown XrPath " + std::to_string(uint64_t(path)) + ">";
+    }
+
+    namespace
     {
-        auto it = resultStringMap.find(result);
+        struct InstancePaths
+        {
+            std::unordered_map<XrPath, std::string> strings;
+            std::unordered_map<std::string, XrPath> paths;
+            uint64_t generation{0};
+            std::unordered_map<const void*, std::shared_ptr<const void>> tables;
+        };
 
-        if (it != resultStringMap.end()) {
-            return it->second;
+        struct PathCache
+        {
+            std::mutex mutex;
+            std::unordered_map<XrInstance, InstancePaths> instances;
+            uint64_t lastGeneration{0};
+        };
+
+        PathCache& GetPathCache()
+        {
+            static PathCache s_cache;
+            return s_cache;
+        }
+
+        // Records a conversion the runtime has made, unless the instance was forgotten while it was being made.
+        void InsertPath(XrInstance instance, XrPath path, const std::string& pathString)
+        {
+            PathCache& cache = GetPathCache();
+            std::lock_guard<std::mutex> lock(cache.mutex);
+            auto it = cache.instances.find(instance);
+            if (it != cache.instances.end()) {
+                it->second.strings.emplace(path, pathString);
+                it->second.paths.emplace(pathString, path);
+            }
         }
+    }  // namespace
 
-        return "<unknown>";
+    void EnablePathCache(XrInstance instance)
+    {
+        PathCache& cache = GetPathCache();
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        InstancePaths& instancePaths = cache.instances[instance];
+        if (instancePaths.generation == 0) {
+            instancePaths.generation = ++cache.lastGeneration;
+        }
     }
 
-    std::string PathToString(XrInstance instance, XrPath path)
+    uint64_t GetPathCacheGeneration(XrInstance instance)
     {
-        uint32_t count = 0;
-        if (XR_SUCCEEDED(xrPathToString(instance, path, 0, &count, nullptr))) {
-            std::vector<char> buff(count);
-            xrPathToString(instance, path, count, &count, buff.data());
-            return std::string(buff.data());
+        PathCache& cache = GetPathCache();
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        auto it = cache.instances.find(instance);
+        return it == cache.instances.end() ? 0 : it->second.generation;
+    }
+
+    void ForgetPathCache(XrInstance instance)
+    {
+        PathCache& cache = GetPathCache();
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        cache.instances.erase(instance);
+    }
+
+    std::shared_ptr<const void> FindPathCacheTable(XrInstance instance, const void* key)
+    {
+        PathCache& cache = GetPathCache();
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        auto instanceIt = cache.instances.find(instance);
+        if (instanceIt == cache.instances.end()) {
+            return nullptr;
         }
-        return "<unknown XrPath " + std::to_string(uint64_t(path)) + ">";
+        auto it = instanceIt->second.tables.find(key);
+        return it == instanceIt->second.tables.end() ? nullptr : it->second;
+    }
+
+    std::shared_ptr<const void> StorePathCacheTable(XrInstance instance, uint64_t generation, const void* key,
+                                                    std::shared_ptr<const void> table)
+    {
+        PathCache& cache = GetPathCache();
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        auto instanceIt = cache.instances.find(instance);
+        if (instanceIt == cache.instances.end() || instanceIt->second.generation != generation) {
+            return table;
+        }
+        return instanceIt->second.tables.emplace(key, std::move(table)).first->second;
+    }
+
+    XrResult CachedStringToPath(XrInstance instance, const char* pathString, XrPath* path)
+    {
+        PathCache& cache = GetPathCache();
+        bool enabled;
+        {
+            std::lock_guard<std::mutex> lock(cache.mutex);
+            auto instanceIt = cache.instances.find(instance);
+            enabled = instanceIt != cache.instances.end();
+            if (enabled) {
+                auto it = instanceIt->second.paths.find(pathString);
+                if (it != instanceIt->second.paths.end()) {
+                    *path = it->second;
+                    return XR_SUCCESS;
+                }
+            }
+        }
+
+        // The runtime is called without the lock held, so a slow runtime does not hold up other threads.
+        const XrResult result = xrStringToPath(instance, pathString, path);
+        if (enabled && result == XR_SUCCESS) {
+            InsertPath(instance, *path, pathString);
+        }
+        return result;
+    }
+
+    XrResult CachedPathToString(XrInstance instance, XrPath path, std::string* pathString)
+    {
+        PathCache& cache = GetPathCache();
+        bool enabled;
+        {
+            std::lock_guard<std::mutex> lock(cache.mutex);
+            auto instanceIt = cache.instances.find(instance);
+            enabled = instanceIt != cache.instances.end();
+            if (enabled) {
+                auto it = instanceIt->second.strings.find(path);
+                if (it != instanceIt->second.strings.end()) {
+                    *pathString = it->second;
+                    return XR_SUCCESS;
+                }
+            }
+        }
+
+        std::vector<char> buffer;
+        const XrResult result = doTwoCallInPlace(buffer, xrPathToString, instance, path);
+        if (result != XR_SUCCESS) {
+            return result;
+        }
+        pathString->assign(buffer.data());
+        if (enabled) {
+            InsertPath(instance, path, *pathString);
+        }
+        return result;
     }
 
     bool ValidateResultAllowed(const char* functionName, XrResult result)
@@ -102,6 +231,7 @@ namespace Conformance
     {
         if (instance != XR_NULL_HANDLE) {
             INFO("Auto-destroying instance");
+            ForgetPathCache(instance);
             CHECK_RESULT_SUCCEEDED(xrDestroyInstance(instance));
             instance = XR_NULL_HANDLE;
         }
@@ -111,6 +241,7 @@ namespace Conformance
     {
         if (instance != XR_NULL_HANDLE) {
             INFO("Destroying instance on request");
+            ForgetPathCache(instance);
             CHECK_RESULT_SUCCEEDED(xrDestroyInstance(instance));
             instance = XR_NULL_HANDLE;
         }
@@ -133,9 +264,31 @@ namespace Conformance
         }
     }
 
+    AutoGraphicsDevice::AutoGraphicsDevice(XrInstance instance, XrSystemId systemId)
+    {
+        GlobalData& globalData = GetGlobalData();
+        if (globalData.IsUsingGraphicsPlugin()) {
+            m_graphicsPlugin = globalData.GetGraphicsPlugin();
+            REQUIRE(m_graphicsPlugin->InitializeDevice(instance, systemId));
+        }
+    }
+
+    AutoGraphicsDevice::~AutoGraphicsDevice()
+    {
+        if (m_graphicsPlugin) {
+            m_graphicsPlugin->ShutdownDevice();
+        }
+    }
+
+    const XrBaseInStructure* AutoGraphicsDevice::GetGraphicsBinding() const
+    {
+        return m_graphicsPlugin ? m_graphicsPlugin->GetGraphicsBinding() : nullptr;
+    }
+
     void InstanceDeleteCHECK::operator()(XrInstance i)
     {
         if (i != XR_NULL_HANDLE) {
+            ForgetPathCache(i);
             XrResult result = xrDestroyInstance(i);
             CHECK(result == XR_SUCCESS);
         }
@@ -144,6 +297,7 @@ namespace Conformance
     void InstanceDeleteREQUIRE::operator()(XrInstance i)
     {
         if (i != XR_NULL_HANDLE) {
+            ForgetPathCache(i);
             XrResult result = xrDestroyInstance(i);
             REQUIRE(result == XR_SUCCESS);
         }
@@ -214,6 +368,187 @@ namespace Conformance
     // Stopwatch
     ////////////////////////////////////////////////////////////////////////////////////////////////
 
+    std::function<void(const char* label, const std::vector<int64_t>& nanosecondSamples)> g_benchmarkSamplesCallback;
+
+    void ReportLatencyPercentiles(const char* label, std::vector<int64_t>& nanosecondSamples)
+    {
+        if (nanosecondSamples.empty()) {
+            ReportF("%s no samples", label);
+            return;
+        }
+        if (g_benchmarkSamplesCallback) {
+            g_benchmarkSamplesCallback(label, nanosecondSamples);
+        }
+
+        std::sort(nanosecondSamples.begin(), nanosecondSamples.end());
+        auto percentile = [&](double p) {
+            const size_t rank = (size_t)std::ceil(p / 100.0 * nanosecondSamples.size());
+            return nanosecondSamples[std::max<size_t>(rank, 1) - 1] / 1000.0;
+        };
+
+        ReportF("%s p50 %.1fus, p90 %.1fus, p99 %.1fus, max %.1fus", label, percentile(50), percentile(90), percentile(99),
+                nanosecondSamples.back() / 1000.0);
+    }
+
+    constexpr size_t LatencySamples::MaxSamples;
+
+    void LatencySamples::Add(MonotonicClock::duration duration)
+    {
+        if (nanoseconds.size() < MaxSamples) {
+            nanoseconds.push_back((int64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+        }
+    }
+
+    double LatencySamples::TotalSeconds() const
+    {
+        int64_t total = 0;
+        for (int64_t sample : nanoseconds) {
+            total += sample;
+        }
+        return total / 1e9;
+    }
+
+    double RunFreeRunningCalls(int warmupFrameCount, int measuredFrameCount, const std::function<void()>& iterateFrame,
+                               const std::function<bool()>& calls)
+    {
+        std::atomic<bool> measuring{warmupFrameCount == 0};
+        std::atomic<bool> stopping{false};
+        double seconds = 0;
+
+        std::thread callThread([&]() {
+            while (!measuring) {
+                if (stopping) {
+                    return;
+                }
+                std::this_thread::yield();
+            }
+
+            const auto start = MonotonicClock::now();
+            while (!stopping && calls()) {
+            }
+            seconds = std::chrono::duration<double>(MonotonicClock::now() - start).count();
+        });
+
+        try {
+            for (int frame = 0; frame < warmupFrameCount + measuredFrameCount; ++frame) {
+                iterateFrame();
+                if (frame + 1 == warmupFrameCount) {
+                    measuring = true;
+                }
+            }
+        }
+        catch (...) {
+            stopping = true;
+            callThread.join();
+            throw;
+        }
+        stopping = true;
+        callThread.join();
+        return seconds;
+    }
+
+    void ReportGpuTimingPercentiles(const char* label, const std::vector<GpuTimingSample>& samples)
+    {
+        std::map<std::string, std::vector<int64_t>> scopes;
+        for (const GpuTimingSample& sample : samples) {
+            scopes[sample.scope].push_back(sample.nanoseconds);
+        }
+        if (scopes.empty()) {
+            ReportF("%s no samples", label);
+            return;
+        }
+        for (auto& scope : scopes) {
+            ReportLatencyPercentiles((std::string(label) + " " + scope.first + ":").c_str(), scope.second);
+        }
+    }
+
+    void SpinFor(std::chrono::nanoseconds duration)
+    {
+        const auto end = MonotonicClock::now() + duration;
+        while (MonotonicClock::now() < end) {
+        }
+    }
+
+    namespace
+    {
+        // Finds XrTime minus MonotonicClock nanoseconds since its epoch. The platform counter is read between two
+        // MonotonicClock samples, whose midpoint then stands for it to within half the time between them; the closest
+        // bracket of a few attempts wins.
+        template <typename ReadCounter, typename ConvertCounter>
+        bool CalibrateMonotonicClock(ReadCounter readCounter, ConvertCounter convertCounter, int64_t* offset)
+        {
+            constexpr int CalibrationAttempts = 8;
+            MonotonicClock::duration bestBracket = MonotonicClock::duration::max();
+            for (int attempt = 0; attempt < CalibrationAttempts; ++attempt) {
+                const MonotonicClock::time_point before = MonotonicClock::now();
+                const auto counter = readCounter();
+                const MonotonicClock::time_point after = MonotonicClock::now();
+
+                XrTime time;
+                if (!convertCounter(counter, &time)) {
+                    return false;
+                }
+                if (after - before < bestBracket) {
+                    bestBracket = after - before;
+                    const MonotonicClock::time_point midpoint = before + (after - before) / 2;
+                    *offset = time - std::chrono::duration_cast<std::chrono::nanoseconds>(midpoint.time_since_epoch()).count();
+                }
+            }
+            return true;
+        }
+    }  // namespace
+
+    MonotonicXrTimeConverter::MonotonicXrTimeConverter(XrInstance instance)
+    {
+#if defined(XR_USE_PLATFORM_WIN32)
+        PFN_xrConvertWin32PerformanceCounterToTimeKHR xrConvertWin32PerformanceCounterToTimeKHR = nullptr;
+        if (XR_FAILED(xrGetInstanceProcAddr(instance, "xrConvertWin32PerformanceCounterToTimeKHR",
+                                            reinterpret_cast<PFN_xrVoidFunction*>(&xrConvertWin32PerformanceCounterToTimeKHR)))) {
+            return;
+        }
+        m_valid = CalibrateMonotonicClock(
+            [] {
+                LARGE_INTEGER counter;
+                QueryPerformanceCounter(&counter);
+                return counter;
+            },
+            [&](const LARGE_INTEGER& counter, XrTime* time) {
+                return XR_SUCCEEDED(xrConvertWin32PerformanceCounterToTimeKHR(instance, &counter, time));
+            },
+            &m_offset);
+#elif defined(XR_USE_TIMESPEC)
+        PFN_xrConvertTimespecTimeToTimeKHR xrConvertTimespecTimeToTimeKHR = nullptr;
+        if (XR_FAILED(xrGetInstanceProcAddr(instance, "xrConvertTimespecTimeToTimeKHR",
+                                            reinterpret_cast<PFN_xrVoidFunction*>(&xrConvertTimespecTimeToTimeKHR)))) {
+            return;
+        }
+        m_valid = CalibrateMonotonicClock(
+            [] {
+                timespec timespecTime;
+                clock_gettime(CLOCK_MONOTONIC, &timespecTime);
+                return timespecTime;
+            },
+            [&](const timespec& timespecTime, XrTime* time) {
+                return XR_SUCCEEDED(xrConvertTimespecTimeToTimeKHR(instance, &timespecTime, time));
+            },
+            &m_offset);
+#else
+        (void)instance;
+#endif
+    }
+
+    const char* GetMonotonicTimeConversionExtension()
+    {
+#if defined(XR_USE_PLATFORM_WIN32)
+        const char* const extension = XR_KHR_WIN32_CONVERT_PERFORMANCE_COUNTER_TIME_EXTENSION_NAME;
+#elif defined(XR_USE_TIMESPEC)
+        const char* const extension = XR_KHR_CONVERT_TIMESPEC_TIME_EXTENSION_NAME;
+#else
+        const char* const extension = nullptr;
+#endif
+        return extension != nullptr && GetGlobalData().IsInstanceExtensionSupported(extension) ? extension : nullptr;
+    }
+
     Stopwatch::Stopwatch(bool start) : startTime(), endTime(), running(false)
     {
         if (start)
@@ -222,13 +557,13 @@ namespace Conformance
 
     void Stopwatch::Restart()
     {
-        startTime = std::chrono::system_clock::now();
+        startTime = MonotonicClock::now();
         running = true;
     }
 
     void Stopwatch::Stop()
     {
-        endTime = std::chrono::system_clock::now();
+        endTime = MonotonicClock::now();
         running = false;
     }
 
@@ -239,10 +574,10 @@ namespace Conformance
 
     std::chrono::nanoseconds Stopwatch::Elapsed() const
     {
-        std::chrono::time_point<std::chrono::system_clock> lastTime;
+        MonotonicClock::time_point lastTime;
 
         if (running)
-            lastTime = std::chrono::system_clock::now();
+            lastTime = MonotonicClock::now();
         else
             lastTime = endTime;
 
@@ -333,9 +668,17 @@ namespace Conformance
             assert(additionalEnabledExtensions.size() == 0);
             instance = instance_;
         }
+        else if ((optionFlags & allowPooled) != 0 && additionalEnabledExtensions.empty() && GetGlobalData().options.poolInstances &&
+                 (optionFlags & skipDebugMessenger) == 0) {
+            instanceCreateResult = GetGlobalData().AcquirePooledInstance(&instance);
+            XRC_CHECK_THROW_XRRESULT(instanceCreateResult, "AcquirePooledInstance");
+            instancePooled = true;
+            EnablePathCache(instance);
+        }
         else {
             instanceCreateResult = CreateBasicInstance(&instance, permitDebugMessenger, additionalEnabledExtensions);
             XRC_CHECK_THROW_XRRESULT(instanceCreateResult, "CreateBasicInstance");
+            EnablePathCache(instance);
         }
 
         if (permitDebugMessenger) {
@@ -353,7 +696,13 @@ namespace Conformance
             XrResult getSystemResult = xrGetSystem(instance, &systemGetInfo, &systemId);
 
             if (XR_FAILED(getSystemResult)) {
-                xrDestroyInstance(instance);
+                if (instancePooled) {
+                    GetGlobalData().ReleasePooledInstance(instance);
+                }
+                else {
+                    ForgetPathCache(instance);
+                    xrDestroyInstance(instance);
+                }
                 instance = XR_NULL_HANDLE;
                 systemId = XR_NULL_SYSTEM_ID;
 
@@ -371,7 +720,13 @@ namespace Conformance
             debugMessenger = XR_NULL_HANDLE_CPP;
         }
         if (instance != XR_NULL_HANDLE) {
-            xrDestroyInstance(instance);
+            if (instancePooled) {
+                GetGlobalData().ReleasePooledInstance(instance);
+            }
+            else {
+                ForgetPathCache(instance);
+                xrDestroyInstance(instance);
+            }
         }
     }
 
@@ -434,8 +789,10 @@ namespace Conformance
                     return XR_ERROR_RUNTIME_FAILURE;
                 }
 
+                // The null graphics plugin has no binding and creates a headless session.
                 graphicsBinding = graphicsPlugin->GetGraphicsBinding();
-                assert(graphicsBinding);  // If this fails then this app has a bug, not the runtime.
+                // If this fails then this app has a bug, not the runtime.
+                assert(graphicsBinding || !globalData.IsGraphicsPluginRequired());
             }
             else if (globalData.IsGraphicsPluginRequired()) {
                 // We should have bailed out of testing on startup.
@@ -485,6 +842,7 @@ namespace Conformance
                 if (instance_ == XR_NULL_HANDLE) {
                     XRC_CHECK_THROW_XRCMD(CreateBasicInstance(&instance));
                     instanceOwned = true;
+                    EnablePathCache(instance);
                 }
 
                 assert(instance != XR_NULL_HANDLE);
@@ -546,15 +904,16 @@ namespace Conformance
                     XRC_CHECK_THROW_XRCMD(xrStringToPath(instance, "/user/hand/right", &handSubactionArray[1]));
 
                     // Note that while we are enumerating this, normally our testing is done via a pre-chosen one (globalData.options.viewConfigurationValue).
-                    XRC_CHECK_THROW_XRCMD(doTwoCallInPlace(viewConfigurationTypeVector, xrEnumerateViewConfigurations, instance, systemId));
+                    // The instance is the framework's own, so these come from the snapshot after the first session on it.
+                    const std::shared_ptr<const SystemSnapshot> snapshot = globalData.GetSystemSnapshot(instance, systemId);
+                    viewConfigurationTypeVector = snapshot->viewConfigurationTypes;
 
                     // We use globalData.options.viewConfigurationValue as the type we enumerate with, despite that the runtime may support others.
-                    XRC_CHECK_THROW_XRCMD(doTwoCallInPlaceWithEmptyElement(
-                        viewConfigurationViewVector, {XR_TYPE_VIEW_CONFIGURATION_VIEW, nullptr, 0, 0, 0, 0, 0, 0},
-                        xrEnumerateViewConfigurationViews, instance, systemId, globalData.options.viewConfigurationValue));
-
-                    XRC_CHECK_THROW_XRCMD(doTwoCallInPlace(environmentBlendModeVector, xrEnumerateEnvironmentBlendModes, instance, systemId,
-                                                           globalData.options.viewConfigurationValue));
+                    const SystemSnapshot::ViewConfiguration* viewConfiguration =
+                        snapshot->FindViewConfiguration(globalData.options.viewConfigurationValue);
+                    XRC_CHECK_THROW_MSG(viewConfiguration != nullptr, "The system does not support the selected view configuration");
+                    viewConfigurationViewVector = viewConfiguration->views;
+                    environmentBlendModeVector = viewConfiguration->environmentBlendModes;
 
                     if ((optionFlags & createSwapchains) && globalData.IsUsingGraphicsPlugin()) {
                         auto graphicsPlugin = globalData.GetGraphicsPlugin();
@@ -634,8 +993,10 @@ namespace Conformance
         }
 
         if (instanceOwned) {
-            if (instance != XR_NULL_HANDLE)  // Should be true.
+            if (instance != XR_NULL_HANDLE) {  // Should be true.
+                ForgetPathCache(instance);
                 xrDestroyInstance(instance);
+            }
             instanceOwned = false;
         }
 
@@ -676,6 +1037,11 @@ namespace Conformance
         autoBasicSession = autoBasicSession_;
     }
 
+    void FrameIterator::SetCpuLoad(const FrameCpuLoad& cpuLoad_)
+    {
+        cpuLoad = cpuLoad_;
+    }
+
     XrSessionState FrameIterator::GetCurrentSessionState() const
     {
         return sessionState;
@@ -726,6 +1092,8 @@ namespace Conformance
 
     FrameIterator::RunResult FrameIterator::CycleToNextSwapchainImage()
     {
+        XR_TRACE_SCOPE("FrameIterator::CycleToNextSwapchainImage");
+
         if (!GetGlobalData().IsUsingGraphicsPlugin())
             return RunResult::Success;
 
@@ -735,10 +1103,22 @@ namespace Conformance
         if (autoBasicSession->swapchainVector.empty())
             return RunResult::Error;
 
+        // The OpenGL runtimes may use the context current on the waiting thread, which the workers do not have.
+        const GlobalData& globalData = GetGlobalData();
+        const uint32_t waitThreads = globalData.options.swapchainWaitThreads;
+        if (!swapchainWaitWorkers && waitThreads > 1 && autoBasicSession->swapchainVector.size() > 1) {
+            const std::string graphics = globalData.graphicsPlugin->DescribeGraphics();
+            if (graphics != "OpenGL" && graphics != "OpenGLES") {
+                swapchainWaitWorkers = std::make_shared<ViewWorkerPool>();
+                swapchainWaitWorkers->Start(waitThreads);
+            }
+        }
+
         // Call the helper function for this.
         const XrDuration twoSeconds = 2_xrSeconds;
-        XrResult result = Conformance::CycleToNextSwapchainImage(autoBasicSession->swapchainVector.data(),
-                                                                 autoBasicSession->swapchainVector.size(), twoSeconds);
+        XrResult result =
+            Conformance::CycleToNextSwapchainImage(autoBasicSession->swapchainVector.data(), autoBasicSession->swapchainVector.size(),
+                                                   twoSeconds, swapchainWaitWorkers.get());
 
         if (XR_FAILED(result))
             return RunResult::Error;
@@ -751,6 +1131,13 @@ namespace Conformance
 
     FrameIterator::RunResult FrameIterator::WaitAndBeginFrame()
     {
+        XR_TRACE_SCOPE("FrameIterator::WaitAndBeginFrame");
+
+        const ThreadScheduling& frameLoopScheduling = GetGlobalData().options.frameLoopScheduling;
+        if (!threadScheduling && !frameLoopScheduling.IsDefault()) {
+            threadScheduling = std::make_shared<ScopedThreadScheduling>(frameLoopScheduling);
+        }
+
         // App must have called SetAutoBasicSession and set flags enabling these.
         if (!autoBasicSession)
             return RunResult::Error;
@@ -763,35 +1150,48 @@ namespace Conformance
 
         XrResult result;
 
-        // xrWaitFrame may block.
-        XrFrameWaitInfo frameWaitInfo{XR_TYPE_FRAME_WAIT_INFO};
-        frameState = XrFrameState{XR_TYPE_FRAME_STATE};
-        result = xrWaitFrame(autoBasicSession->session, &frameWaitInfo, &frameState);
-        if (XR_FAILED(result))
-            return RunResult::Error;
+        if (frameIndex > 0) {
+            SpinFor(cpuLoad.afterEnd);
+        }
+        SpinFor(cpuLoad.beforeWait);
 
-        XrViewLocateInfo viewLocateInfo{XR_TYPE_VIEW_LOCATE_INFO};
-        viewLocateInfo.viewConfigurationType = autoBasicSession->viewConfigurationTypeVector[0];
-        viewLocateInfo.displayTime = frameState.predictedDisplayTime;
-        viewLocateInfo.space = autoBasicSession->spaceVector[0];
-        XrViewState viewState{XR_TYPE_VIEW_STATE};
-        uint32_t viewCount = (uint32_t)autoBasicSession->viewConfigurationViewVector.size();
-        viewVector.resize(viewCount, {XR_TYPE_VIEW});
-        result = xrLocateViews(autoBasicSession->session, &viewLocateInfo, &viewState, viewCount, &viewCount, viewVector.data());
-        if (XR_FAILED(result))
-            return RunResult::Error;
-        viewVector.resize(viewCount);
+        {
+            ScopedCpuCounters counting(cpuCounters);
 
-        XrFrameBeginInfo frameBeginInfo{XR_TYPE_FRAME_BEGIN_INFO};
-        result = xrBeginFrame(autoBasicSession->session, &frameBeginInfo);
-        if (XR_FAILED(result))
-            return RunResult::Error;
+            // xrWaitFrame may block.
+            XrFrameWaitInfo frameWaitInfo{XR_TYPE_FRAME_WAIT_INFO};
+            frameState = XrFrameState{XR_TYPE_FRAME_STATE};
+            result = xrWaitFrame(autoBasicSession->session, &frameWaitInfo, &frameState);
+            if (XR_FAILED(result))
+                return RunResult::Error;
+
+            XrViewLocateInfo viewLocateInfo{XR_TYPE_VIEW_LOCATE_INFO};
+            viewLocateInfo.viewConfigurationType = autoBasicSession->viewConfigurationTypeVector[0];
+            viewLocateInfo.displayTime = frameState.predictedDisplayTime;
+            viewLocateInfo.space = autoBasicSession->spaceVector[0];
+            XrViewState viewState{XR_TYPE_VIEW_STATE};
+            uint32_t viewCount = (uint32_t)autoBasicSession->viewConfigurationViewVector.size();
+            viewVector.resize(viewCount, {XR_TYPE_VIEW});
+            result = xrLocateViews(autoBasicSession->session, &viewLocateInfo, &viewState, viewCount, &viewCount, viewVector.data());
+            if (XR_FAILED(result))
+                return RunResult::Error;
+            viewVector.resize(viewCount);
+
+            XrFrameBeginInfo frameBeginInfo{XR_TYPE_FRAME_BEGIN_INFO};
+            result = xrBeginFrame(autoBasicSession->session, &frameBeginInfo);
+            if (XR_FAILED(result))
+                return RunResult::Error;
+        }
+
+        SpinFor(cpuLoad.BeforeRender(frameIndex++));
 
         return RunResult::Success;
     }
 
     FrameIterator::RunResult FrameIterator::PrepareFrameEndInfo()
     {
+        XR_TRACE_SCOPE("FrameIterator::PrepareFrameEndInfo");
+
         // App must have called SetAutoBasicSession and set flags enabling these.
         if (!autoBasicSession)
             return RunResult::Error;
@@ -854,6 +1254,8 @@ namespace Conformance
 
     FrameIterator::RunResult FrameIterator::SubmitFrame()
     {
+        XR_TRACE_SCOPE("FrameIterator::SubmitFrame");
+
         RunResult runResult = PrepareSubmitFrame();
         if (runResult != RunResult::Success)
             return runResult;
@@ -866,6 +1268,7 @@ namespace Conformance
         XrResult result = xrEndFrame(autoBasicSession->session, &frameEndInfo);
         if (XR_FAILED(result))
             return RunResult::Error;
+        XR_TRACE_FRAME_MARK("FrameIterator");
 
         return RunResult::Success;
     }
@@ -947,18 +1350,77 @@ namespace Conformance
         return RunResult::Timeout;
     }
 
+    namespace
+    {
+        // The time between predicate calls: starts at InitialDelay, or the caller's delay if that is shorter, and
+        // doubles up to the caller's delay.
+        class WaitBackoff
+        {
+        public:
+            explicit WaitBackoff(std::chrono::nanoseconds maxDelay) : m_maxDelay(maxDelay)
+            {
+                Reset();
+            }
+
+            void Reset()
+            {
+                m_delay = std::min<std::chrono::nanoseconds>(InitialDelay, m_maxDelay);
+            }
+
+            // Returns the delay to use now, and backs off for next time.
+            std::chrono::nanoseconds Next()
+            {
+                const std::chrono::nanoseconds delay = m_delay;
+                m_delay = std::min(m_delay * 2, m_maxDelay);
+                return delay;
+            }
+
+        private:
+            static constexpr std::chrono::nanoseconds InitialDelay = std::chrono::milliseconds(1);
+
+            const std::chrono::nanoseconds m_maxDelay;
+            std::chrono::nanoseconds m_delay;
+        };
+
+        constexpr std::chrono::nanoseconds WaitBackoff::InitialDelay;
+    }  // namespace
+
     bool WaitUntilPredicateWithTimeout(std::function<bool()> predicate, const std::chrono::nanoseconds timeout,
                                        const std::chrono::nanoseconds delay)
     {
-        const auto timeoutTime = std::chrono::system_clock::now() + timeout;
+        const auto timeoutTime = MonotonicClock::now() + timeout;
+        WaitBackoff backoff(delay);
+
+        while (!predicate()) {
+            if (MonotonicClock::now() >= timeoutTime) {
+                return false;
+            }
+            const std::chrono::nanoseconds nextDelay = backoff.Next();
+            if (nextDelay > std::chrono::nanoseconds::zero()) {
+                std::this_thread::sleep_for(nextDelay);
+            }
+        }
+
+        return true;
+    }
+
+    bool WaitUntilPredicateWithTimeout(const EventQueue& eventQueue, std::function<bool()> predicate, const std::chrono::nanoseconds timeout,
+                                       const std::chrono::nanoseconds delay)
+    {
+        const auto timeoutTime = MonotonicClock::now() + timeout;
+        WaitBackoff backoff(delay);
 
         while (!predicate()) {
-            if (std::chrono::system_clock::now() >= timeoutTime) {
+            // The predicate reads, and so polls, events through its own EventReader: it has seen everything counted now.
+            const uint64_t seenCount = eventQueue.EventCount();
+
+            const auto now = MonotonicClock::now();
+            if (now >= timeoutTime) {
                 return false;
             }
-            const std::chrono::nanoseconds minDelay{0};
-            if (delay > minDelay) {
-                std::this_thread::sleep_for(delay);
+            const std::chrono::nanoseconds maxWait = std::min<std::chrono::nanoseconds>(backoff.Next(), timeoutTime - now);
+            if (eventQueue.WaitForEvents(seenCount, maxWait)) {
+                backoff.Reset();
             }
         }
 
@@ -1001,6 +1463,12 @@ namespace Conformance
     {
         GlobalData& globalData = GetGlobalData();
 
+        const size_t index = XrExtensionIndexFromName(extensionName);
+        if (index != kXrExtensionCount) {
+            return globalData.enabledInstanceExtensions.Contains(index);
+        }
+
+        // Unknown to this build, so it can only be found by name.
         auto caseInsensitivePredicate = [&extensionName](const std::string& str) -> bool { return striequal(extensionName, str.c_str()); };
 
         auto it = std::find_if(globalData.enabledInstanceExtensionNames.begin(), globalData.enabledInstanceExtensionNames.end(),
@@ -1011,12 +1479,7 @@ namespace Conformance
 
     bool IsInstanceExtensionEnabled(uint64_t extensionNumber)
     {
-        auto& map = GetNumberExtensionMap();
-        auto it = map.find(extensionNumber);
-        if (it == map.end()) {
-            return false;
-        }
-        return IsInstanceExtensionEnabled(it->second);
+        return GetGlobalData().enabledInstanceExtensions.ContainsNumber(extensionNumber);
     }
 
     bool IsInteractionProfileEnabled(const char* ipName)
@@ -1157,8 +1620,50 @@ namespace Conformance
         return result;
     }
 
-    XrResult CycleToNextSwapchainImage(XrSwapchain* swapchainArray, size_t count, XrDuration timeoutNs)
+    static XrResult CycleToNextSwapchainImagesWaitingInParallel(XrSwapchain* swapchainArray, size_t count, XrDuration timeoutNs,
+                                                                ViewWorkerPool& waitWorkers)
+    {
+        XrResult result = XR_SUCCESS;
+        for (size_t i = 0; i < count; ++i) {
+            uint32_t index;
+            XrSwapchainImageAcquireInfo acquireInfo{XR_TYPE_SWAPCHAIN_IMAGE_ACQUIRE_INFO};
+            result = xrAcquireSwapchainImage(swapchainArray[i], &acquireInfo, &index);
+            if (XR_FAILED(result))
+                return result;
+        }
+
+        // Each worker waits on its own swapchains, which the API allows from any thread.
+        std::vector<XrResult> waitResults(count, XR_SUCCESS);
+        waitWorkers.Run((uint32_t)count, [&](uint32_t /*worker*/, uint32_t i) {
+            XrSwapchainImageWaitInfo waitInfo{XR_TYPE_SWAPCHAIN_IMAGE_WAIT_INFO};
+            waitInfo.timeout = timeoutNs;
+            waitResults[i] = xrWaitSwapchainImage(swapchainArray[i], &waitInfo);
+        });
+
+        bool timeoutOccurred = false;
+        for (XrResult waitResult : waitResults) {
+            if (XR_FAILED(waitResult))
+                return waitResult;
+            timeoutOccurred |= waitResult == XR_TIMEOUT_EXPIRED;
+        }
+
+        // As when cycling in turn, timed out images are released too, and a failure to release takes precedence.
+        for (size_t i = 0; i < count; ++i) {
+            XrSwapchainImageReleaseInfo releaseInfo{XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO};
+            result = xrReleaseSwapchainImage(swapchainArray[i], &releaseInfo);
+            if (XR_FAILED(result))
+                return result;
+        }
+
+        return timeoutOccurred ? XR_TIMEOUT_EXPIRED : result;
+    }
+
+    XrResult CycleToNextSwapchainImage(XrSwapchain* swapchainArray, size_t count, XrDuration timeoutNs, ViewWorkerPool* waitWorkers)
     {
+        if (waitWorkers != nullptr && waitWorkers->IsRunning() && count > 1) {
+            return CycleToNextSwapchainImagesWaitingInParallel(swapchainArray, count, timeoutNs, *waitWorkers);
+        }
+
         XrResult result = XR_SUCCESS;
         bool timeoutOccurred = false;
 
@@ -1198,6 +1703,52 @@ namespace Conformance
         return result;
     }
 
+    XrResult RenderGeneratedSwapchainImage(IGraphicsPlugin* graphicsPlugin, XrSwapchain swapchain, const XrSwapchainCreateInfo& createInfo,
+                                           XrDuration timeoutNs)
+    {
+        // The plugin only renders into images it has enumerated.
+        uint32_t imageCount = 0;
+        XrResult result = xrEnumerateSwapchainImages(swapchain, 0, &imageCount, nullptr);
+        if (XR_FAILED(result))
+            return result;
+        std::shared_ptr<IGraphicsPlugin::SwapchainImageStructs> images =
+            graphicsPlugin->AllocateSwapchainImageStructs(imageCount, createInfo);
+        result = xrEnumerateSwapchainImages(swapchain, imageCount, &imageCount, images->imagePtrVector[0]);
+        if (XR_FAILED(result))
+            return result;
+
+        uint32_t index;
+        XrSwapchainImageAcquireInfo acquireInfo{XR_TYPE_SWAPCHAIN_IMAGE_ACQUIRE_INFO};
+        result = xrAcquireSwapchainImage(swapchain, &acquireInfo, &index);
+        if (XR_FAILED(result))
+            return result;
+
+        XrSwapchainImageWaitInfo waitInfo{XR_TYPE_SWAPCHAIN_IMAGE_WAIT_INFO};
+        waitInfo.timeout = timeoutNs;
+        result = xrWaitSwapchainImage(swapchain, &waitInfo);
+        if (XR_FAILED(result))
+            return result;
+
+        // As in CycleToNextSwapchainImage, a timed out image is still released, without drawing into it.
+        const bool timeoutOccurred = result == XR_TIMEOUT_EXPIRED;
+        if (!timeoutOccurred) {
+            const XrExtent2Di extent{(int32_t)createInfo.width, (int32_t)createInfo.height};
+            const uint32_t layerCount = createInfo.arraySize * std::max(1u, createInfo.faceCount);
+            for (uint32_t layer = 0; layer < layerCount; ++layer) {
+                graphicsPlugin->RenderGeneratedContent(images->imagePtrVector[index], createInfo.format, extent, layer, layer);
+            }
+            // The render targets the plugin made for the image go with the image structs on return.
+            graphicsPlugin->Flush();
+        }
+
+        XrSwapchainImageReleaseInfo releaseInfo{XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO};
+        result = xrReleaseSwapchainImage(swapchain, &releaseInfo);
+        if (XR_FAILED(result))
+            return result;
+
+        return timeoutOccurred ? XR_TIMEOUT_EXPIRED : result;
+    }
+
     // Encapsulates xrCreateActionSet/xrCreateAction
     XrResult CreateActionSet(XrInstance instance, XrActionSet* actionSet, std::vector<XrAction>* actionVector,
                              const XrPath* subactionPathArray, size_t subactionPathArraySize)
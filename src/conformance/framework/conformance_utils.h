@@ -26,6 +26,7 @@
 #include <string>
 #include <memory>
 #include <chrono>
+#include <functional>
 #include <stdint.h>
 #include <iosfwd>
 #include <utils.h>
@@ -33,6 +34,9 @@
 
 #include "event_reader.h"
 #include "graphics_plugin.h"
+#include "thread_scheduling.h"
+#include "cpu_counters.h"
+#include "view_worker_pool.h"
 
 namespace Conformance
 {
@@ -84,9 +88,9 @@ namespace Conformance
         }
     };
 
-    // We keep a private auto-generated map of all results and their string versions.
-    typedef std::map<XrResult, const char*> ResultStringMap;
-    const ResultStringMap& GetResultStringMap();
+    // We keep a private auto-generated table of all results and their string versions.
+    typedef EnumNameTable<XrResult> ResultStringTable;
+    const ResultStringTable& GetResultStringTable();
 
     // ResultToString
     //
@@ -109,6 +113,32 @@ namespace Conformance
     //
     std::string PathToString(XrInstance instance, XrPath path);
 
+    // Path cache
+    //
+    // Instances owned by the framework (AutoBasicInstance, AutoBasicSession and CompositionHelper) remember their
+    // paths in both directions, so that PathToString, StringToPath and the input devices do not go back to the runtime
+    // for paths they have already converted. Other instances always go to the runtime. The framework calls
+    // ForgetPathCache before destroying an instance, since a later instance may be given the same handle.
+    //
+    void EnablePathCache(XrInstance instance);
+    void ForgetPathCache(XrInstance instance);
+
+    // Nonzero while the path cache is enabled for the instance, and different for each time it is enabled, so that tables
+    // built on top of the cache can tell an instance from an earlier one that had the same handle.
+    uint64_t GetPathCacheGeneration(XrInstance instance);
+
+    // Tables built from the paths of an instance, such as the converted paths of an interaction profile, are kept with its
+    // path cache under a key of their own, and dropped with it by ForgetPathCache. FindPathCacheTable returns nullptr if
+    // there is none. StorePathCacheTable keeps the table unless the instance's cache is no longer at generation, and
+    // returns the table kept for the key, which is an earlier one if another thread stored one first.
+    std::shared_ptr<const void> FindPathCacheTable(XrInstance instance, const void* key);
+    std::shared_ptr<const void> StorePathCacheTable(XrInstance instance, uint64_t generation, const void* key,
+                                                    std::shared_ptr<const void> table);
+
+    // Like xrStringToPath and xrPathToString, but answered from the path cache when it is enabled for the instance.
+    XrResult CachedStringToPath(XrInstance instance, const char* pathString, XrPath* path);
+    XrResult CachedPathToString(XrInstance instance, XrPath path, std::string* pathString);
+
     // ValidateResultAllowed
     //
     // Returns true if the given function (e.g. "xrPollEvent") may return the given result (e.g. XR_ERROR_PATH_INVALID).
@@ -210,6 +240,25 @@ namespace Conformance
         XrSession& session;
     };
 
+    // Initializes the graphics plugin's device for a system, if a graphics plugin is in use, and shuts it down at scope exit.
+    // For tests that create sessions themselves rather than through CreateBasicSession or AutoBasicSession, for example to
+    // create many sessions on one device.
+    class AutoGraphicsDevice
+    {
+    public:
+        AutoGraphicsDevice(XrInstance instance, XrSystemId systemId);
+        ~AutoGraphicsDevice();
+
+        // The binding to chain to XrSessionCreateInfo, or null if no graphics plugin is in use.
+        const XrBaseInStructure* GetGraphicsBinding() const;
+
+        AutoGraphicsDevice(AutoGraphicsDevice const&) = delete;
+        AutoGraphicsDevice& operator=(AutoGraphicsDevice const&) = delete;
+
+    private:
+        std::shared_ptr<IGraphicsPlugin> m_graphicsPlugin;
+    };
+
     // CreateColorSwapchain
     //
     // Creates a swapchain for the given session and graphics plugin.
@@ -228,8 +277,20 @@ namespace Conformance
 
     // Executes xrAcquireSwapchainImage, xrWaitSwapchainImage, xrReleaseSwapchainImage, with no drawing.
     // The contents of the swapchain images have no predictable content as a result of this.
+    // If waitWorkers is running and there is more than one swapchain then every image is acquired first, the waits run
+    // on waitWorkers at once, and every image is then released, so the waits take as long as the slowest one; otherwise
+    // each swapchain is cycled in turn.
     // Returns any XrResult that xrAcquireSwapchainImage, xrWaitSwapchainImage, or xrReleaseSwapchainImage may return.
-    XrResult CycleToNextSwapchainImage(XrSwapchain* swapchainArray, size_t count, XrDuration timeoutNs);
+    XrResult CycleToNextSwapchainImage(XrSwapchain* swapchainArray, size_t count, XrDuration timeoutNs,
+                                       ViewWorkerPool* waitWorkers = nullptr);
+
+    // Like CycleToNextSwapchainImage for one swapchain, but fills every face and array slice of the image with
+    // IGraphicsPlugin::RenderGeneratedContent, each labelled with its layer index, before releasing it. createInfo is
+    // the one the swapchain was created with.
+    // Returns any XrResult that xrEnumerateSwapchainImages, xrAcquireSwapchainImage, xrWaitSwapchainImage, or
+    // xrReleaseSwapchainImage may return.
+    XrResult RenderGeneratedSwapchainImage(IGraphicsPlugin* graphicsPlugin, XrSwapchain swapchain, const XrSwapchainCreateInfo& createInfo,
+                                           XrDuration timeoutNs);
 
     // CreateActionSet
     //
@@ -657,9 +718,52 @@ namespace Conformance
         return std::chrono::seconds(s);
     }
 
+    // The clock every CPU-side timing of the framework, the frame loop and the benchmarks is taken with. It is monotonic,
+    // so that system clock corrections cannot make measured intervals jump or go negative, and it is the platform's
+    // high-resolution counter: QueryPerformanceCounter on Windows and CLOCK_MONOTONIC elsewhere, which are also the
+    // clocks XR_KHR_win32_convert_performance_counter_time and XR_KHR_convert_timespec_time convert from.
+    using MonotonicClock = std::chrono::steady_clock;
+
+    // MonotonicXrTimeConverter
+    //
+    // Converts between MonotonicClock time points and XrTime, such as when the frame loop was woken and the predicted
+    // display time. It calibrates once on construction through XR_KHR_win32_convert_performance_counter_time or
+    // XR_KHR_convert_timespec_time, whichever the instance has enabled, after which a conversion is an addition.
+    //
+    class MonotonicXrTimeConverter
+    {
+    public:
+        explicit MonotonicXrTimeConverter(XrInstance instance);
+
+        // False if the instance has neither extension enabled or the calibration failed, in which case the conversions
+        // must not be used.
+        bool IsValid() const
+        {
+            return m_valid;
+        }
+
+        XrTime ToXrTime(MonotonicClock::time_point timePoint) const
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(timePoint.time_since_epoch()).count() + m_offset;
+        }
+
+        MonotonicClock::time_point FromXrTime(XrTime time) const
+        {
+            return MonotonicClock::time_point(
+                std::chrono::duration_cast<MonotonicClock::duration>(std::chrono::nanoseconds(time - m_offset)));
+        }
+
+    private:
+        bool m_valid{false};
+        int64_t m_offset{0};  // XrTime minus MonotonicClock nanoseconds since its epoch.
+    };
+
+    // Returns the extension MonotonicXrTimeConverter needs for this platform if the runtime supports it, or null.
+    const char* GetMonotonicTimeConversionExtension();
+
     // Stopwatch
     //
-    // Implements a single-run stopwatch using std::chrono.
+    // Implements a single-run stopwatch on MonotonicClock.
     //
     class Stopwatch
     {
@@ -682,11 +786,72 @@ namespace Conformance
         std::chrono::nanoseconds Elapsed() const;
 
     private:
-        std::chrono::time_point<std::chrono::system_clock> startTime;
-        std::chrono::time_point<std::chrono::system_clock> endTime;
+        MonotonicClock::time_point startTime;
+        MonotonicClock::time_point endTime;
         bool running;
     };
 
+    // Reports the nearest-rank p50, p90, p99 and max of a set of durations given in nanoseconds, in microseconds,
+    // on one line after the label. Used by the benchmark test cases. Sorts the samples in place.
+    void ReportLatencyPercentiles(const char* label, std::vector<int64_t>& nanosecondSamples);
+
+    // Durations of one kind of call, in nanoseconds, for ReportLatencyPercentiles. At most MaxSamples are kept, which
+    // bounds the memory used by a benchmark thread that calls as fast as it can.
+    struct LatencySamples
+    {
+        static constexpr size_t MaxSamples = 1 << 20;
+
+        void Add(MonotonicClock::duration duration);
+
+        // Returns the sum of the kept samples: the time spent in the calls, when they are spread over frames.
+        double TotalSeconds() const;
+
+        std::vector<int64_t> nanoseconds;
+    };
+
+    // Calls iterateFrame warmupFrameCount + measuredFrameCount times on the calling thread, while a second thread calls
+    // calls over and over from the end of the warmup frames until the last frame is done or calls returns false.
+    // Catch assertions are not thread-safe, so calls must record its failures for the caller to check afterwards.
+    // If iterateFrame throws, the second thread is stopped and joined before the exception propagates.
+    // Returns the time the second thread spent calling, in seconds.
+    double RunFreeRunningCalls(int warmupFrameCount, int measuredFrameCount, const std::function<void()>& iterateFrame,
+                               const std::function<bool()>& calls);
+
+    // Called by ReportLatencyPercentiles with the label and samples of each non-empty report, before it sorts them, so
+    // that a benchmark harness can collect the raw durations. Empty unless the harness sets it.
+    extern std::function<void(const char* label, const std::vector<int64_t>& nanosecondSamples)> g_benchmarkSamplesCallback;
+
+    // Reports the percentiles of a graphics plugin's GPU timings as ReportLatencyPercentiles does, one line per scope,
+    // with the scope name after the label.
+    void ReportGpuTimingPercentiles(const char* label, const std::vector<GpuTimingSample>& samples);
+
+    // Busy-waits on the calling thread for the given duration, as application CPU work would occupy it.
+    void SpinFor(std::chrono::nanoseconds duration);
+
+    // Synthetic CPU work that RenderLoop and FrameIterator add to the phases of each frame, to imitate an application's CPU
+    // profile when measuring how a runtime predicts display times and paces frames. The work is a busy wait on the thread
+    // running the phase. Every lateFrameInterval-th frame also spends lateFrameDelay before rendering, so a
+    // delay longer than the display period makes those frames miss their display time.
+    struct FrameCpuLoad
+    {
+        std::chrono::nanoseconds beforeWait{0};    // Before xrWaitFrame.
+        std::chrono::nanoseconds beforeRender{0};  // After xrBeginFrame, before rendering.
+        std::chrono::nanoseconds afterEnd{0};      // After xrEndFrame.
+        uint32_t lateFrameInterval{0};             // 0 for no late frames.
+        std::chrono::nanoseconds lateFrameDelay{0};
+
+        bool IsLateFrame(uint64_t frameIndex) const
+        {
+            return lateFrameInterval != 0 && (frameIndex + 1) % lateFrameInterval == 0;
+        }
+
+        // The work before rendering the frame with this index, counted from 0, including any late-frame delay.
+        std::chrono::nanoseconds BeforeRender(uint64_t frameIndex) const
+        {
+            return IsLateFrame(frameIndex) ? beforeRender + lateFrameDelay : beforeRender;
+        }
+    };
+
     // CountdownTimer
     //
     // Implements a countdown timer.
@@ -765,6 +930,7 @@ namespace Conformance
             none = 0x00,
             createSystemId = 0x01,
             skipDebugMessenger = 0x02,
+            allowPooled = 0x04,  // The test does not depend on a new instance; see Options::poolInstances.
         };
 
         // Create a new XrInstance.
@@ -800,6 +966,7 @@ namespace Conformance
 
     public:
         XrInstance instance{XR_NULL_HANDLE_CPP};
+        bool instancePooled{false};  // True if the instance came from GlobalData::AcquirePooledInstance.
         XrResult instanceCreateResult{XR_SUCCESS};
         XrDebugUtilsMessengerEXT debugMessenger{XR_NULL_HANDLE_CPP};
         XrSystemId systemId{XR_NULL_SYSTEM_ID};
@@ -938,9 +1105,16 @@ namespace Conformance
 
     std::ostream& operator<<(std::ostream& os, AutoBasicSession const& sess);
 
+    // Calls the predicate until it returns true or the timeout passes. The time between calls starts short and doubles
+    // up to delay, so that conditions which become true quickly are seen quickly.
     bool WaitUntilPredicateWithTimeout(std::function<bool()> predicate, const std::chrono::nanoseconds timeout,
                                        const std::chrono::nanoseconds delay);
 
+    // As above, for predicates that wait on events: between calls it waits for an event to reach the queue, and calls
+    // the predicate again as soon as one does. The time between calls only backs off while no events arrive.
+    bool WaitUntilPredicateWithTimeout(const EventQueue& eventQueue, std::function<bool()> predicate, const std::chrono::nanoseconds timeout,
+                                       const std::chrono::nanoseconds delay);
+
     // Identifies conformance-related information about individual OpenXR functions.
     struct FunctionInfo
     {
@@ -963,8 +1137,9 @@ namespace Conformance
     typedef std::unordered_map<std::string, FunctionInfo> FunctionInfoMap;
     const FunctionInfoMap& GetFunctionInfoMap();
 
-    // Returns true if the extension name is in the list (case-insensitive) of extensions that are
-    // enabled by default for instance creation (GlobalData::Options::enabledInstanceExtensionNames).
+    // Returns true if the extension name is in the list of extensions that are enabled by default for instance
+    // creation (GlobalData::Options::enabledInstanceExtensionNames). Extensions known to this build are matched
+    // case-sensitively with a bit test; others are matched case-insensitively by name.
     bool IsInstanceExtensionEnabled(const char* extensionName);
 
     // Returns true if the extension of this number is in the list of extensions that are
@@ -1060,7 +1235,7 @@ namespace Conformance
 
         // Calls xrAcquireSwapchainImage, xrWaitSwapchainImage, xrReleaseSwapchainImage on each
         // of the swapchains, in preparation for a call to EndFrame with the swapchains. Does not
-        // draw anything to the images.
+        // draw anything to the images. Waits for them in parallel with Options::swapchainWaitThreads.
         // This is a building block function used by PrepareSubmitFrame or possibly an external
         // user wanting more custom control.
         RunResult CycleToNextSwapchainImage();
@@ -1093,10 +1268,31 @@ namespace Conformance
         // Will repeatedly call SubmitFrame if necessary to get to the desired state.
         RunResult RunToSessionState(XrSessionState targetSessionState, std::chrono::nanoseconds timeout);
 
+        // Sets synthetic CPU work for the frames that follow, none by default. WaitAndBeginFrame runs the work before
+        // xrWaitFrame and after xrBeginFrame. Callers may call xrEndFrame themselves, so the work after xrEndFrame runs
+        // at the start of the next WaitAndBeginFrame instead.
+        void SetCpuLoad(const FrameCpuLoad& cpuLoad_);
+
+        // The CPU counters of WaitAndBeginFrame from xrWaitFrame to xrBeginFrame, summed over every call so far. Only
+        // counted with Options::cpuCounters.
+        const CpuCounters& GetCpuCounters() const
+        {
+            return cpuCounters;
+        }
+
     protected:
         AutoBasicSession* autoBasicSession;
         XrSessionState sessionState;
         CountdownTimer countdownTimer;
+        FrameCpuLoad cpuLoad;
+        uint64_t frameIndex{0};  // Frames begun by WaitAndBeginFrame.
+        CpuCounters cpuCounters;
+        // Options::frameLoopScheduling, applied by the first WaitAndBeginFrame to its thread until the last copy of
+        // this iterator is destroyed, which restores that thread whichever thread it happens on.
+        std::shared_ptr<ScopedThreadScheduling> threadScheduling;
+        // Started by the first CycleToNextSwapchainImage with Options::swapchainWaitThreads, shared by the copies of this
+        // iterator.
+        std::shared_ptr<ViewWorkerPool> swapchainWaitWorkers;
 
     public:
         XrFrameState frameState;                                             // xrWaitFrame from WaitAndBeginFrame fills this in.
@@ -0,0 +1,229 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cpu_counters.h"
+#include "conformance_framework.h"
+#include "report.h"
+#include "utils.h"
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace Conformance
+{
+    namespace
+    {
+        std::atomic<bool> g_unavailableReported{false};
+
+        void ReportUnavailableOnce(const std::string& message)
+        {
+            if (!g_unavailableReported.exchange(true)) {
+                ReportF("CPU counters: %s", message.c_str());
+            }
+        }
+
+#if defined(__linux__)
+        // The counters of one thread in one perf event group, so that a single read returns all of them at the same instant.
+        class ThreadCounterGroup
+        {
+        public:
+            ThreadCounterGroup()
+            {
+                Open(CpuCounter_Cycles, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+                Open(CpuCounter_Instructions, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+                Open(CpuCounter_CacheMisses, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+                Open(CpuCounter_ContextSwitches, PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES);
+                if (m_count < MaxCounters) {
+                    ReportUnavailableOnce(std::string("perf_event_open refused some counters, last error: ") + strerror(m_error) +
+                                          ". Check /proc/sys/kernel/perf_event_paranoid.");
+                }
+            }
+
+            ~ThreadCounterGroup()
+            {
+                for (uint32_t i = 0; i < m_count; ++i) {
+                    close(m_fds[i]);
+                }
+            }
+
+            ThreadCounterGroup(const ThreadCounterGroup&) = delete;
+            ThreadCounterGroup& operator=(const ThreadCounterGroup&) = delete;
+
+            CpuCounters Read() const
+            {
+                CpuCounters counters;
+                if (m_count == 0) {
+                    return counters;
+                }
+                struct
+                {
+                    uint64_t count;
+                    uint64_t values[MaxCounters];
+                } data{};
+                if (read(m_fds[0], &data, sizeof(data)) <= 0) {
+                    return counters;
+                }
+                for (uint32_t i = 0; i < m_count && i < data.count; ++i) {
+                    counters.available |= m_bits[i];
+                    switch (m_bits[i]) {
+                    case CpuCounter_Cycles:
+                        counters.cycles = data.values[i];
+                        break;
+                    case CpuCounter_Instructions:
+                        counters.instructions = data.values[i];
+                        break;
+                    case CpuCounter_CacheMisses:
+                        counters.cacheMisses = data.values[i];
+                        break;
+                    default:
+                        counters.contextSwitches = data.values[i];
+                        break;
+                    }
+                }
+                return counters;
+            }
+
+        private:
+            static constexpr uint32_t MaxCounters = 4;
+
+            void Open(CpuCounterBits bit, uint32_t type, uint64_t config)
+            {
+                perf_event_attr attr;
+                memset(&attr, 0, sizeof(attr));
+                attr.size = sizeof(attr);
+                attr.type = type;
+                attr.config = config;
+                attr.read_format = PERF_FORMAT_GROUP;
+                attr.exclude_hv = 1;
+
+                // The calling thread on any CPU. Counting the kernel as well needs a lower perf_event_paranoid, so fall
+                // back to user space only; context switches are then still counted, as they are charged to the thread.
+                const int groupFd = m_count == 0 ? -1 : m_fds[0];
+                int fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, PERF_FLAG_FD_CLOEXEC);
+                if (fd < 0) {
+                    attr.exclude_kernel = 1;
+                    fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, PERF_FLAG_FD_CLOEXEC);
+                }
+                if (fd < 0) {
+                    m_error = errno;
+                    return;
+                }
+                m_fds[m_count] = fd;
+                m_bits[m_count] = bit;
+                m_count++;
+            }
+
+            int m_fds[MaxCounters]{};
+            CpuCounterBits m_bits[MaxCounters]{};
+            uint32_t m_count{0};
+            int m_error{0};
+        };
+#endif  // defined(__linux__)
+    }  // namespace
+
+    CpuCounters& CpuCounters::operator+=(const CpuCounters& other)
+    {
+        available |= other.available;
+        cycles += other.cycles;
+        instructions += other.instructions;
+        cacheMisses += other.cacheMisses;
+        contextSwitches += other.contextSwitches;
+        return *this;
+    }
+
+    CpuCounters operator-(const CpuCounters& later, const CpuCounters& earlier)
+    {
+        CpuCounters difference;
+        difference.available = later.available & earlier.available;
+        difference.cycles = later.cycles - earlier.cycles;
+        difference.instructions = later.instructions - earlier.instructions;
+        difference.cacheMisses = later.cacheMisses - earlier.cacheMisses;
+        difference.contextSwitches = later.contextSwitches - earlier.contextSwitches;
+        return difference;
+    }
+
+    CpuCounters ReadThreadCpuCounters()
+    {
+#if defined(_WIN32)
+        CpuCounters counters;
+        ULONG64 cycles = 0;
+        if (QueryThreadCycleTime(GetCurrentThread(), &cycles)) {
+            counters.available = CpuCounter_Cycles;
+            counters.cycles = cycles;
+        }
+        else {
+            ReportUnavailableOnce("QueryThreadCycleTime failed.");
+        }
+        return counters;
+#elif defined(__linux__)
+        // Opened on the first read of each thread and closed when the thread exits.
+        thread_local ThreadCounterGroup group;
+        return group.Read();
+#else
+        ReportUnavailableOnce("not supported on this platform.");
+        return CpuCounters{};
+#endif
+    }
+
+    ScopedCpuCounters::ScopedCpuCounters(CpuCounters& total)
+        : m_total(GetGlobalData().options.cpuCounters ? &total : nullptr)
+    {
+        if (m_total != nullptr) {
+            m_start = ReadThreadCpuCounters();
+        }
+    }
+
+    ScopedCpuCounters::~ScopedCpuCounters()
+    {
+        if (m_total != nullptr) {
+            *m_total += ReadThreadCpuCounters() - m_start;
+        }
+    }
+
+    void ReportCpuCounters(const char* label, const CpuCounters& counters, uint64_t frameCount)
+    {
+        if (counters.available == 0 || frameCount == 0) {
+            return;
+        }
+
+        std::string result;
+        auto append = [&](CpuCounterBits bit, const char* name, uint64_t total) {
+            if ((counters.available & bit) != 0) {
+                AppendSprintf(result, "%s%s %.0f", result.empty() ? "" : ", ", name, (double)total / frameCount);
+            }
+        };
+        append(CpuCounter_Cycles, "cycles", counters.cycles);
+        append(CpuCounter_Instructions, "instructions", counters.instructions);
+        const uint32_t ipcBits = CpuCounter_Cycles | CpuCounter_Instructions;
+        if ((counters.available & ipcBits) == ipcBits && counters.cycles != 0) {
+            AppendSprintf(result, " (IPC %.2f)", (double)counters.instructions / counters.cycles);
+        }
+        append(CpuCounter_CacheMisses, "cache misses", counters.cacheMisses);
+        if ((counters.available & CpuCounter_ContextSwitches) != 0) {
+            AppendSprintf(result, "%scontext switches %.2f", result.empty() ? "" : ", ", (double)counters.contextSwitches / frameCount);
+        }
+        ReportF("%s %s per frame", label, result.c_str());
+    }
+}  // namespace Conformance
@@ -0,0 +1,74 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+
+namespace Conformance
+{
+    enum CpuCounterBits : uint32_t
+    {
+        CpuCounter_Cycles = 1 << 0,
+        CpuCounter_Instructions = 1 << 1,
+        CpuCounter_CacheMisses = 1 << 2,
+        CpuCounter_ContextSwitches = 1 << 3,
+    };
+
+    // Counts of the CPU work of a thread, as the hardware performance counters and the scheduler see it. Together with the
+    // time spent they tell a benchmark whether a runtime got slower by doing more work, by doing it less efficiently, or by
+    // blocking. See Options::cpuCounters.
+    struct CpuCounters
+    {
+        // The CpuCounterBits of the counters the platform provided. The others stay zero.
+        uint32_t available{0};
+        uint64_t cycles{0};
+        uint64_t instructions{0};
+        uint64_t cacheMisses{0};
+        uint64_t contextSwitches{0};
+
+        CpuCounters& operator+=(const CpuCounters& other);
+    };
+
+    // The counts from an earlier reading of the same thread to a later one.
+    CpuCounters operator-(const CpuCounters& later, const CpuCounters& earlier);
+
+    // Reads the counters of the calling thread since it first asked, starting them on that first call. Uses
+    // perf_event_open on Linux and Android, which only counts user space where the kernel's perf_event_paranoid forbids
+    // more, and QueryThreadCycleTime on Windows, which has no other per-thread counters without a kernel trace session.
+    // Counters the platform refuses are reported once and left out of available.
+    CpuCounters ReadThreadCpuCounters();
+
+    // Adds the counts of the calling thread while it is alive to a total, if Options::cpuCounters is true. Does nothing
+    // otherwise, so that the frame loops can always scope their measured regions with it.
+    class ScopedCpuCounters
+    {
+    public:
+        explicit ScopedCpuCounters(CpuCounters& total);
+        ~ScopedCpuCounters();
+
+        ScopedCpuCounters(const ScopedCpuCounters&) = delete;
+        ScopedCpuCounters& operator=(const ScopedCpuCounters&) = delete;
+
+    private:
+        CpuCounters* m_total;
+        CpuCounters m_start;
+    };
+
+    // Reports the available counters averaged over a number of frames, with instructions per cycle, on one line after the
+    // label. Reports nothing if no counters were available, as when Options::cpuCounters is false.
+    void ReportCpuCounters(const char* label, const CpuCounters& counters, uint64_t frameCount);
+}  // namespace Conformance
@@ -9,6 +9,11 @@
 #include <common/xr_linear.h>
 #include <DirectXColors.h>
 #include <D3Dcompiler.h>
+#include <dxgi1_4.h>
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
 
 #include "d3d_common.h"
 
@@ -32,6 +37,23 @@ namespace Conformance
 
     ComPtr<ID3DBlob> CompileShader(const char* hlsl, const char* entrypoint, const char* shaderTarget)
     {
+        // Devices are created and destroyed many times per run, always from the same few shaders, so each result
+        // is kept for the rest of the process. Compiled blobs are never modified, so they can be shared.
+        static std::mutex cacheMutex;
+        static std::unordered_map<std::string, ComPtr<ID3DBlob>> cache;
+
+        std::string key = hlsl;
+        key += '\0';
+        key += entrypoint;
+        key += '\0';
+        key += shaderTarget;
+
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        auto cached = cache.find(key);
+        if (cached != cache.end()) {
+            return cached->second;
+        }
+
         ComPtr<ID3DBlob> compiled;
         ComPtr<ID3DBlob> errMsgs;
         DWORD flags = D3DCOMPILE_PACK_MATRIX_COLUMN_MAJOR | D3DCOMPILE_ENABLE_STRICTNESS | D3DCOMPILE_WARNINGS_ARE_ERRORS;
@@ -50,6 +72,7 @@ namespace Conformance
             XRC_CHECK_THROW_HRESULT(hr, "D3DCompile");
         }
 
+        cache.emplace(std::move(key), compiled);
         return compiled;
     }
 
@@ -81,6 +104,41 @@ namespace Conformance
         }
     }
 
+    bool GetDXGIAdapterLocalMemoryUsage(IDXGIAdapter* adapter, uint64_t* usedBytes)
+    {
+        // QueryVideoMemoryInfo is on IDXGIAdapter3, which needs Windows 10.
+        ComPtr<IDXGIAdapter3> adapter3;
+        if (adapter == nullptr ||
+            FAILED(adapter->QueryInterface(__uuidof(IDXGIAdapter3), reinterpret_cast<void**>(adapter3.ReleaseAndGetAddressOf())))) {
+            return false;
+        }
+
+        DXGI_QUERY_VIDEO_MEMORY_INFO memoryInfo{};
+        if (FAILED(adapter3->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &memoryInfo))) {
+            return false;
+        }
+        *usedBytes = memoryInfo.CurrentUsage;
+        return true;
+    }
+
+    RGBATexelLayout GetDxgiRGBATexelLayout(DXGI_FORMAT format)
+    {
+        switch (format) {
+        case DXGI_FORMAT_B8G8R8A8_TYPELESS:
+        case DXGI_FORMAT_B8G8R8A8_UNORM:
+        case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+            return RGBATexelLayout::B8G8R8A8;
+        case DXGI_FORMAT_R16G16B16A16_FLOAT:
+            return RGBATexelLayout::R16G16B16A16Float;
+        case DXGI_FORMAT_R32G32B32A32_FLOAT:
+            return RGBATexelLayout::R32G32B32A32Float;
+        case DXGI_FORMAT_R10G10B10A2_UNORM:
+            return RGBATexelLayout::R10G10B10A2;
+        default:
+            return RGBATexelLayout::R8G8B8A8;
+        }
+    }
+
     // Shorthand constants for usage below.
     static const uint64_t XRC_COLOR_TEXTURE_USAGE = (XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT | XR_SWAPCHAIN_USAGE_SAMPLED_BIT);
 
@@ -6,10 +6,12 @@
 #if (defined(XR_USE_GRAPHICS_API_D3D11) || defined(XR_USE_GRAPHICS_API_D3D12)) && !defined(MISSING_DIRECTX_COLORS)
 
 #include <DirectXMath.h>
+#include "RGBAImage.h"
 
 namespace Conformance
 {
-    struct ModelConstantBuffer
+    // Per-instance vertex data, one entry per cube, stored row by row.
+    struct ModelInstanceData
     {
         DirectX::XMFLOAT4X4 Model;
     };
@@ -28,16 +30,20 @@ namespace Conformance
         float3 Pos : POSITION;
         float3 Color : COLOR0;
     };
-    cbuffer ModelConstantBuffer : register(b0) {
-        float4x4 Model;
+    struct Instance {
+        float4 ModelRow0 : MODEL0;
+        float4 ModelRow1 : MODEL1;
+        float4 ModelRow2 : MODEL2;
+        float4 ModelRow3 : MODEL3;
     };
     cbuffer ViewProjectionConstantBuffer : register(b1) {
         float4x4 ViewProjection;
     };
 
-    PSVertex MainVS(Vertex input) {
+    PSVertex MainVS(Vertex input, Instance instance) {
        PSVertex output;
-       output.Pos = mul(mul(float4(input.Pos, 1), Model), ViewProjection);
+       const float4x4 model = float4x4(instance.ModelRow0, instance.ModelRow1, instance.ModelRow2, instance.ModelRow3);
+       output.Pos = mul(mul(float4(input.Pos, 1), model), ViewProjection);
        output.Color = input.Color;
        return output;
     }
@@ -50,9 +56,16 @@ namespace Conformance
     DirectX::XMMATRIX XM_CALLCONV LoadXrPose(const XrPosef& pose);
     DirectX::XMMATRIX XM_CALLCONV LoadXrMatrix(const XrMatrix4x4f& matrix);
 
+    // Results are cached for the life of the process, keyed on the source, entry point and target.
     Microsoft::WRL::ComPtr<ID3DBlob> CompileShader(const char* hlsl, const char* entrypoint, const char* shaderTarget);
     Microsoft::WRL::ComPtr<IDXGIAdapter1> GetDXGIAdapter(LUID adapterId) noexcept(false);
 
+    // Reads this process's usage of the adapter's local video memory. Returns false if the adapter cannot report it.
+    bool GetDXGIAdapterLocalMemoryUsage(IDXGIAdapter* adapter, uint64_t* usedBytes);
+
+    // The layout CopyRGBAImage writes texels of the format in. Formats it does not know get R8G8B8A8.
+    RGBATexelLayout GetDxgiRGBATexelLayout(DXGI_FORMAT format);
+
     typedef std::map<int64_t, SwapchainCreateTestParameters> SwapchainTestMap;
     SwapchainTestMap& GetDxgiSwapchainTestMap();
 }  // namespace Conformance
@@ -16,57 +16,200 @@
 
 #include "event_reader.h"
 #include "conformance_framework.h"
+#include <algorithm>
 
-EventQueue::EventQueue(XrInstance instance) : m_instance(instance)
+EventQueue::EventQueue(XrInstance instance) : m_instance(instance), m_head(new Segment(0)), m_tail(m_head)
 {
 }
 
+EventQueue::~EventQueue()
+{
+    while (m_head != nullptr) {
+        Segment* segment = m_head;
+        m_head = segment->next.load(std::memory_order_relaxed);
+        delete segment;
+    }
+}
+
 void EventQueue::ReadEvents() const
 {
+    // Only one thread polls at a time. If another thread is already polling, the events it gets are appended
+    // shortly, so carry on with the events already buffered rather than waiting for it.
+    std::unique_lock<std::mutex> lock(m_mutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        return;
+    }
+
     XrResult pollRes;
     XrEventDataBuffer eventDataBuffer{XR_TYPE_EVENT_DATA_BUFFER};
+    bool appended = false;
     while ((pollRes = xrPollEvent(m_instance, &eventDataBuffer)) == XR_SUCCESS) {
-        std::unique_lock<std::mutex> lock(m_mutex);
-        m_events.push_back(eventDataBuffer);
+        const uint64_t index = m_eventCount.load(std::memory_order_relaxed);
+        if (index == m_tail->EndIndex()) {
+            Segment* segment = new Segment(index);
+            m_tail->next.store(segment, std::memory_order_release);
+            m_tail = segment;
+        }
+        m_tail->events[index - m_tail->firstIndex] = eventDataBuffer;
+        m_tail->types[index - m_tail->firstIndex] = eventDataBuffer.type;
+        m_tail->typeMask.fetch_or(TypeBit(eventDataBuffer.type), std::memory_order_relaxed);
+        m_eventCount.store(index + 1, std::memory_order_release);
+        appended = true;
+
         eventDataBuffer.type = XR_TYPE_EVENT_DATA_BUFFER;
         eventDataBuffer.next = nullptr;
     }
 
+    if (appended) {
+        ReclaimSegments();
+
+        // Taking the wait mutex orders this against a waiter that has checked the count but not started waiting yet.
+        {
+            std::lock_guard<std::mutex> waitLock(m_waitMutex);
+        }
+        m_eventsAdded.notify_all();
+    }
+
     XRC_CHECK_THROW_XRRESULT(pollRes, "xrPollEvent");
 }
 
-EventReader::EventReader(const EventQueue& eventQueue) : m_eventQueue(eventQueue), m_nextEventIndex(eventQueue.m_events.size())
+bool EventQueue::WaitForEvents(uint64_t seenCount, std::chrono::nanoseconds maxWait) const
+{
+    // Nothing else may be polling, so keep polling while waiting. The condition variable still ends a slice early
+    // when another thread's poll appends events.
+    constexpr std::chrono::nanoseconds PollInterval = std::chrono::milliseconds(1);
+    const auto endTime = std::chrono::steady_clock::now() + maxWait;
+
+    for (;;) {
+        ReadEvents();
+        if (EventCount() > seenCount) {
+            return true;
+        }
+        const auto now = std::chrono::steady_clock::now();
+        if (now >= endTime) {
+            return false;
+        }
+        std::unique_lock<std::mutex> waitLock(m_waitMutex);
+        if (m_eventsAdded.wait_for(waitLock, std::min<std::chrono::nanoseconds>(PollInterval, endTime - now),
+                                   [&] { return EventCount() > seenCount; })) {
+            return true;
+        }
+    }
+}
+
+void EventQueue::AddReader(EventReader& reader) const
 {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    reader.m_segment = m_tail;
+    reader.m_nextEventIndex.store(m_eventCount.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    m_readers.push_back(&reader);
 }
 
-bool EventReader::TryReadNext(XrEventDataBuffer& dataBuffer)
+void EventQueue::RemoveReader(const EventReader& reader) const
 {
-    m_eventQueue.ReadEvents();
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_readers.erase(std::find(m_readers.begin(), m_readers.end(), &reader));
+    ReclaimSegments();
+}
 
-    std::unique_lock<std::mutex> lock(m_eventQueue.m_mutex);
-    if (m_nextEventIndex >= m_eventQueue.m_events.size()) {
-        return false;
+void EventQueue::ReclaimSegments() const
+{
+    // Requires m_mutex. New readers start at the current event count, so that bounds what any reader still needs.
+    uint64_t oldestNextEventIndex = m_eventCount.load(std::memory_order_relaxed);
+    for (const EventReader* reader : m_readers) {
+        oldestNextEventIndex = std::min(oldestNextEventIndex, reader->m_nextEventIndex.load(std::memory_order_acquire));
     }
 
-    dataBuffer = m_eventQueue.m_events[m_nextEventIndex++];
+    while (m_head != m_tail && m_head->EndIndex() < oldestNextEventIndex) {
+        Segment* segment = m_head;
+        m_head = segment->next.load(std::memory_order_relaxed);
+        delete segment;
+    }
+}
+
+EventReader::EventReader(const EventQueue& eventQueue) : m_eventQueue(eventQueue), m_segment(nullptr), m_nextEventIndex(0)
+{
+    m_eventQueue.AddReader(*this);
+}
+
+EventReader::~EventReader()
+{
+    m_eventQueue.RemoveReader(*this);
+}
+
+bool EventReader::TryReadNext(XrEventDataBuffer& dataBuffer)
+{
+    const XrEventDataBuffer* event = TryReadNext();
+    if (event == nullptr) {
+        return false;
+    }
+    dataBuffer = *event;
     return true;
 }
 
 bool EventReader::TryReadUntilEvent(XrEventDataBuffer& dataBuffer, XrStructureType eventType)
 {
-    while (TryReadNext(dataBuffer)) {
-        if (dataBuffer.type == eventType) {
-            return true;
+    const XrEventDataBuffer* event = TryReadUntilEvent(eventType);
+    if (event == nullptr) {
+        return false;
+    }
+    dataBuffer = *event;
+    return true;
+}
+
+const XrEventDataBuffer* EventReader::TryReadNext()
+{
+    m_eventQueue.ReadEvents();
+
+    const uint64_t index = m_nextEventIndex.load(std::memory_order_relaxed);
+    if (index >= m_eventQueue.m_eventCount.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+
+    if (index == m_segment->EndIndex()) {
+        m_segment = m_segment->next.load(std::memory_order_acquire);
+    }
+
+    // The queue may free m_segment's predecessor after this, but not m_segment itself, which ends after the new position.
+    m_nextEventIndex.store(index + 1, std::memory_order_release);
+    return &m_segment->events[index - m_segment->firstIndex];
+}
+
+const XrEventDataBuffer* EventReader::TryReadUntilEvent(XrStructureType eventType)
+{
+    m_eventQueue.ReadEvents();
+
+    // Events published by the acquire below have their types and segment mask bits visible too.
+    const uint64_t eventCount = m_eventQueue.m_eventCount.load(std::memory_order_acquire);
+    const uint64_t typeBit = EventQueue::TypeBit(eventType);
+    uint64_t index = m_nextEventIndex.load(std::memory_order_relaxed);
+    while (index < eventCount) {
+        if (index == m_segment->EndIndex()) {
+            m_segment = m_segment->next.load(std::memory_order_acquire);
+        }
+        const uint64_t segmentEnd = std::min(m_segment->EndIndex(), eventCount);
+        if ((m_segment->typeMask.load(std::memory_order_relaxed) & typeBit) != 0) {
+            for (; index < segmentEnd; ++index) {
+                if (m_segment->types[index - m_segment->firstIndex] == eventType) {
+                    m_nextEventIndex.store(index + 1, std::memory_order_release);
+                    return &m_segment->events[index - m_segment->firstIndex];
+                }
+            }
         }
+        index = segmentEnd;
     }
 
-    return false;
+    m_nextEventIndex.store(index, std::memory_order_release);
+    return nullptr;
 }
 
 void EventReader::ReadUntilEmpty()
 {
     m_eventQueue.ReadEvents();
 
-    std::unique_lock<std::mutex> lock(m_eventQueue.m_mutex);
-    m_nextEventIndex = m_eventQueue.m_events.size();
+    const uint64_t eventCount = m_eventQueue.m_eventCount.load(std::memory_order_acquire);
+    while (eventCount > m_segment->EndIndex()) {
+        m_segment = m_segment->next.load(std::memory_order_acquire);
+    }
+    m_nextEventIndex.store(eventCount, std::memory_order_release);
 }
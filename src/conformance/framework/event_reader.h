@@ -16,41 +16,127 @@
 
 #pragma once
 
-#include <vector>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
 #include <mutex>
+#include <vector>
 #include <openxr/openxr.h>
 
-// Buffered collection of all events read. Only accessible through an EventReader.
+class EventReader;
+
+// Buffered collection of the events read while EventReaders are live. Only accessible through an EventReader.
+// Events are appended to a chain of fixed-size segments which readers walk without taking a lock. A segment is
+// freed once every live EventReader has read past it, so memory stays bounded in long runs. Each segment also
+// indexes the types of its events, so that a reader waiting for one type skips the others without touching them.
+// The EventQueue must outlive all of its EventReaders.
 class EventQueue
 {
 public:
     explicit EventQueue(XrInstance instance);
+    ~EventQueue();
+
+    EventQueue(const EventQueue&) = delete;
+    EventQueue& operator=(const EventQueue&) = delete;
+
+    // Number of events added to the queue so far.
+    uint64_t EventCount() const
+    {
+        return m_eventCount.load(std::memory_order_acquire);
+    }
+
+    // Waits up to maxWait for the queue to hold more than seenCount events, polling the runtime every millisecond
+    // meanwhile and waking early when another thread's poll adds events. Returns true if it does by the time this
+    // returns.
+    bool WaitForEvents(uint64_t seenCount, std::chrono::nanoseconds maxWait) const;
 
 private:
     friend class EventReader;  // ;-)
 
+    static constexpr uint64_t SegmentEventCount = 16;
+
+    struct Segment
+    {
+        explicit Segment(uint64_t firstIndex_) : firstIndex(firstIndex_)
+        {
+        }
+
+        uint64_t EndIndex() const
+        {
+            return firstIndex + SegmentEventCount;
+        }
+
+        const uint64_t firstIndex;
+        std::atomic<Segment*> next{nullptr};
+        // Has TypeBit set for the type of every event appended, so a segment without a type can be skipped whole.
+        std::atomic<uint64_t> typeMask{0};
+        std::array<XrStructureType, SegmentEventCount> types;
+        std::array<XrEventDataBuffer, SegmentEventCount> events;
+    };
+
+    static uint64_t TypeBit(XrStructureType type)
+    {
+        // Fibonacci hashing into 64 bits; a collision only costs a scan of the segment's types.
+        return uint64_t(1) << ((static_cast<uint32_t>(type) * 2654435769u) >> 26);
+    }
+
     void ReadEvents() const;
+    void AddReader(EventReader& reader) const;
+    void RemoveReader(const EventReader& reader) const;
+    void ReclaimSegments() const;
 
     const XrInstance m_instance;
+
+    // Guards polling, appending, reclaiming and the reader list. Reading buffered events does not take it.
     mutable std::mutex m_mutex;
-    mutable std::vector<XrEventDataBuffer> m_events;
+    mutable Segment* m_head;  // Oldest segment that may still be read.
+    mutable Segment* m_tail;  // Segment that the next event is appended to, unless it is full.
+    mutable std::vector<const EventReader*> m_readers;
+
+    // Number of events appended so far. Published after the event itself is written.
+    mutable std::atomic<uint64_t> m_eventCount{0};
+
+    // Signalled after events are appended, for WaitForEvents. Its mutex is separate so that waiting never holds up polling.
+    mutable std::mutex m_waitMutex;
+    mutable std::condition_variable m_eventsAdded;
 };
 
 // Reads all events added to the EventQueue after this object was created.
 // Separate EventReaders from the same EventQueue will not impact each other.
 // This allows different parts of the tests to read events without impacting each other (event multiplexing).
+// A single EventReader must only be used by one thread at a time.
 class EventReader
 {
 public:
     EventReader(const EventQueue& eventQueue);
+    ~EventReader();
+
+    EventReader(const EventReader&) = delete;
+    EventReader& operator=(const EventReader&) = delete;
 
     bool TryReadNext(XrEventDataBuffer& dataBuffer);
 
     bool TryReadUntilEvent(XrEventDataBuffer& dataBuffer, XrStructureType eventType);
 
+    // Like the overloads above but return the event in the queue instead of copying it, or nullptr if there is none.
+    // The event stays valid until this reader next reads or is destroyed.
+    const XrEventDataBuffer* TryReadNext();
+
+    const XrEventDataBuffer* TryReadUntilEvent(XrStructureType eventType);
+
     void ReadUntilEmpty();
 
 private:
+    friend class EventQueue;
+
     const EventQueue& m_eventQueue;
-    size_t m_nextEventIndex;
+
+    // The segment holding the next event, or the full segment just before it. The queue never frees a segment
+    // whose end is at or after m_nextEventIndex.
+    const EventQueue::Segment* m_segment;
+
+    // Read by the queue to decide which segments can be freed.
+    std::atomic<uint64_t> m_nextEventIndex;
 };
@@ -0,0 +1,175 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "frame_pacing.h"
+#include "conformance_utils.h"
+#include "cpu_counters.h"
+#include "report.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace Conformance
+{
+    namespace
+    {
+        // Enough for the longest frame pacing benchmark loops without reallocating while measuring.
+        constexpr size_t ReservedFrameCount = 3000;
+
+        double ToMilliseconds(int64_t nanoseconds)
+        {
+            return nanoseconds / 1000000.0;
+        }
+    }  // namespace
+
+    FramePacingRecorder::FramePacingRecorder()
+    {
+        m_wakeJitter.reserve(ReservedFrameCount);
+        m_beginToEnd.reserve(ReservedFrameCount);
+        m_drift.reserve(ReservedFrameCount);
+    }
+
+    void FramePacingRecorder::SetTimeConverter(const MonotonicXrTimeConverter* converter)
+    {
+        m_timeConverter = converter != nullptr && converter->IsValid() ? converter : nullptr;
+        if (m_timeConverter != nullptr) {
+            m_wakeToDisplay.reserve(ReservedFrameCount);
+        }
+    }
+
+    void FramePacingRecorder::OnFrameWoken(const XrFrameState& frameState)
+    {
+        m_wakeTime = m_clock.Elapsed();
+        if (m_timeConverter != nullptr) {
+            m_wakeToDisplay.push_back(frameState.predictedDisplayTime - m_timeConverter->ToXrTime(MonotonicClock::now()));
+        }
+
+        if (m_frameCount > 0) {
+            // Wake-up jitter is how far the interval between two xrWaitFrame wake-ups strays from the
+            // display period the runtime predicted for the new frame.
+            const int64_t wakeInterval = (m_wakeTime - m_lastWakeTime).count();
+            m_wakeJitter.push_back(std::abs(wakeInterval - frameState.predictedDisplayPeriod));
+
+            // Every additional display period between consecutive predicted display times is a frame
+            // the runtime did not give us a chance to present.
+            const XrDuration displayTimeDelta = frameState.predictedDisplayTime - m_lastPredictedDisplayTime;
+            if (displayTimeDelta <= 0) {
+                m_nonIncreasingDisplayTimeCount++;
+            }
+            else if (frameState.predictedDisplayPeriod > 0 && displayTimeDelta * 2 > frameState.predictedDisplayPeriod * 3) {
+                const double periods = (double)displayTimeDelta / (double)frameState.predictedDisplayPeriod;
+                m_missedFrameCount += std::max<int64_t>(1, std::llround(periods) - 1);
+            }
+
+            // Drift compares how far predicted display time advanced against how far the CPU clock advanced over
+            // the same frames. A runtime that paces correctly keeps this bounded rather than growing with time.
+            const int64_t displayAdvance = frameState.predictedDisplayTime - m_firstPredictedDisplayTime;
+            const int64_t wallAdvance = (m_wakeTime - m_firstWakeTime).count();
+            m_drift.push_back(displayAdvance - wallAdvance);
+        }
+        else {
+            m_firstWakeTime = m_wakeTime;
+            m_firstPredictedDisplayTime = frameState.predictedDisplayTime;
+        }
+
+        m_totalDisplayPeriod += frameState.predictedDisplayPeriod;
+        m_lastWakeTime = m_wakeTime;
+        m_lastPredictedDisplayTime = frameState.predictedDisplayTime;
+        m_frameCount++;
+    }
+
+    void FramePacingRecorder::OnFrameEnded()
+    {
+        m_beginToEnd.push_back((m_clock.Elapsed() - m_wakeTime).count());
+    }
+
+    double FramePacingRecorder::GetFrameRate() const
+    {
+        const int64_t elapsed = (m_lastWakeTime - m_firstWakeTime).count();
+        return elapsed <= 0 ? 0 : (m_frameCount - 1) * 1e9 / elapsed;
+    }
+
+    void FramePacingRecorder::Report(const char* loopName)
+    {
+        ReportF("Frame pacing (%s) over %d frames:", loopName, (int)m_frameCount);
+        if (m_frameCount == 0) {
+            return;
+        }
+
+        ReportF("  Average predicted display period : %.3fms", ToMilliseconds(m_totalDisplayPeriod / m_frameCount));
+        ReportLatencyPercentiles("  xrWaitFrame wake-up jitter       :", m_wakeJitter);
+        ReportLatencyPercentiles("  Begin to End CPU time            :", m_beginToEnd);
+        if (m_timeConverter != nullptr) {
+            ReportLatencyPercentiles("  Wake-up to predicted display     :", m_wakeToDisplay);
+        }
+        ReportF("  Missed frames                    : %lld", (long long)m_missedFrameCount);
+        ReportF("  Non-increasing display times     : %lld", (long long)m_nonIncreasingDisplayTimeCount);
+
+        if (!m_drift.empty()) {
+            const auto maxDrift =
+                std::max_element(m_drift.begin(), m_drift.end(), [](int64_t a, int64_t b) { return std::abs(a) < std::abs(b); });
+            ReportF("  predictedDisplayTime drift       : final %.3fms, max %.3fms", ToMilliseconds(m_drift.back()),
+                    ToMilliseconds(*maxDrift));
+        }
+    }
+
+    void ReportStageTimings(const RenderLoopStageTimings& timings)
+    {
+        if (timings.frameCount == 0) {
+            return;
+        }
+        auto average = [&](std::chrono::nanoseconds total) { return total.count() / 1000000.0 / timings.frameCount; };
+        ReportF("  Average stage times per frame    : wait %.3fms, hand-off %.3fms, begin %.3fms, render and end %.3fms",
+                average(timings.wait), average(timings.handOff), average(timings.begin), average(timings.endFrame));
+        ReportCpuCounters("  CPU counters in those stages     :", timings.cpuCounters, timings.frameCount);
+    }
+
+    void RunWithProjectionLayer(CompositionHelper& compositionHelper, SimpleProjectionLayerHelper& simpleProjectionLayerHelper,
+                                int warmupFrameCount, int measuredFrameCount, bool gpuTiming, FramePacingRecorder& recorder,
+                                std::vector<int64_t>& endFrameTimes, std::vector<GpuTimingSample>& gpuTimings)
+    {
+        auto graphicsPlugin = GetGlobalData().GetGraphicsPlugin();
+        Stopwatch endFrameStopwatch;
+        int frame = 0;
+        RenderLoop renderLoop(compositionHelper, [&](const XrFrameState& frameState) {
+            const bool measured = frame >= warmupFrameCount;
+            if (measured) {
+                recorder.OnFrameWoken(frameState);
+            }
+
+            compositionHelper.PollEvents();
+
+            XrCompositionLayerBaseHeader* const projLayer = simpleProjectionLayerHelper.TryGetUpdatedProjectionLayer(frameState);
+            endFrameStopwatch.Restart();
+            compositionHelper.EndFrame(frameState.predictedDisplayTime, &projLayer, projLayer != nullptr ? 1 : 0);
+
+            if (measured) {
+                endFrameTimes.push_back(endFrameStopwatch.Elapsed().count());
+                recorder.OnFrameEnded();
+            }
+            if (gpuTiming) {
+                // Timings of the previous run's frames are still coming in during the warm-up.
+                std::vector<GpuTimingSample> collected;
+                graphicsPlugin->CollectGpuTimings(collected);
+                if (measured) {
+                    gpuTimings.insert(gpuTimings.end(), collected.begin(), collected.end());
+                }
+            }
+            return ++frame < warmupFrameCount + measuredFrameCount;
+        });
+        renderLoop.Loop();
+    }
+}  // namespace Conformance
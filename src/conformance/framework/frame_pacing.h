@@ -0,0 +1,85 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "composition_utils.h"
+#include "conformance_utils.h"
+#include "gpu_timing.h"
+#include <openxr/openxr.h>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace Conformance
+{
+    // Collects per-frame timing samples from a frame loop and reports them as percentiles.
+    // OnFrameWoken should be called as soon as xrWaitFrame has returned and OnFrameEnded
+    // right after xrEndFrame has returned.
+    class FramePacingRecorder
+    {
+    public:
+        FramePacingRecorder();
+
+        // With a valid converter, also records how long before its predicted display time each frame was woken.
+        void SetTimeConverter(const MonotonicXrTimeConverter* converter);
+
+        void OnFrameWoken(const XrFrameState& frameState);
+        void OnFrameEnded();
+
+        int64_t GetFrameCount() const
+        {
+            return m_frameCount;
+        }
+
+        XrDuration GetAverageDisplayPeriod() const
+        {
+            return m_frameCount == 0 ? 0 : m_totalDisplayPeriod / m_frameCount;
+        }
+
+        // The rate at which xrWaitFrame let the application start frames, which a runtime that keeps up holds at the
+        // display rate and one that cannot drops below it.
+        double GetFrameRate() const;
+
+        void Report(const char* loopName);
+
+    private:
+        Stopwatch m_clock{true};
+        const MonotonicXrTimeConverter* m_timeConverter{nullptr};
+        std::chrono::nanoseconds m_wakeTime{0};
+        std::chrono::nanoseconds m_lastWakeTime{0};
+        std::chrono::nanoseconds m_firstWakeTime{0};
+        XrTime m_lastPredictedDisplayTime{0};
+        XrTime m_firstPredictedDisplayTime{0};
+        XrDuration m_totalDisplayPeriod{0};
+        int64_t m_frameCount{0};
+        int64_t m_missedFrameCount{0};
+        int64_t m_nonIncreasingDisplayTimeCount{0};
+        std::vector<int64_t> m_wakeJitter;
+        std::vector<int64_t> m_beginToEnd;
+        std::vector<int64_t> m_drift;
+        std::vector<int64_t> m_wakeToDisplay;
+    };
+
+    // Reports the average time per frame spent in each RenderLoop stage, warm-up frames included.
+    void ReportStageTimings(const RenderLoopStageTimings& timings);
+
+    // Renders warmupFrameCount and then measuredFrameCount frames of a simple projection layer, feeding the measured
+    // frames to recorder, their xrEndFrame CPU times to endFrameTimes and, if gpuTiming, their GPU timings to gpuTimings.
+    void RunWithProjectionLayer(CompositionHelper& compositionHelper, SimpleProjectionLayerHelper& simpleProjectionLayerHelper,
+                                int warmupFrameCount, int measuredFrameCount, bool gpuTiming, FramePacingRecorder& recorder,
+                                std::vector<int64_t>& endFrameTimes, std::vector<GpuTimingSample>& gpuTimings);
+}  // namespace Conformance
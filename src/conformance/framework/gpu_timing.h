@@ -0,0 +1,97 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace Conformance
+{
+    /// One GPU duration measured by a graphics plugin, see IGraphicsPlugin::SetGpuTimingEnabled.
+    struct GpuTimingSample
+    {
+        /// The plugin call that was measured: "RenderView", "ClearImageSlice" or "CopyRGBAImage".
+        const char* scope;
+        int64_t nanoseconds;
+    };
+
+    /// The bookkeeping the graphics plugins share for timing their work with pairs of timestamp queries. Each plugin owns
+    /// PairCount() begin/end query pairs and asks this ring which one a new scope should use. Pairs are handed out and read
+    /// back in submission order, and a pair is only reused once its result has been read, so results are never waited for.
+    /// A scope is not measured if every pair is still waiting for the GPU. Not thread-safe.
+    class GpuTimestampRing
+    {
+    public:
+        enum class ReadResult
+        {
+            NotReady,   // The GPU has not written both timestamps yet.
+            Ready,      // The duration was read.
+            Discarded,  // The timestamps are unusable, for example because the GPU clock changed in between.
+        };
+
+        static constexpr uint32_t NoPair = UINT32_MAX;
+
+        /// Frees every pair and sets the number of pairs.
+        void Reset(uint32_t pairCount)
+        {
+            m_scopes.assign(pairCount, nullptr);
+            m_first = 0;
+            m_pending = 0;
+        }
+
+        uint32_t PairCount() const
+        {
+            return (uint32_t)m_scopes.size();
+        }
+
+        /// Returns the pair that a new scope should write its timestamps to, or NoPair if none is free.
+        uint32_t Begin(const char* scope)
+        {
+            if (m_pending == PairCount()) {
+                return NoPair;
+            }
+            const uint32_t pair = (m_first + m_pending) % PairCount();
+            m_scopes[pair] = scope;
+            m_pending++;
+            return pair;
+        }
+
+        /// Calls tryRead(pair, int64_t* nanoseconds) for each pending pair, oldest first, and appends the durations it
+        /// reads, until tryRead returns ReadResult::NotReady.
+        template <typename TryRead>
+        void Collect(TryRead&& tryRead, std::vector<GpuTimingSample>& samples)
+        {
+            while (m_pending != 0) {
+                int64_t nanoseconds = 0;
+                const ReadResult result = tryRead(m_first, &nanoseconds);
+                if (result == ReadResult::NotReady) {
+                    return;
+                }
+                if (result == ReadResult::Ready) {
+                    samples.push_back({m_scopes[m_first], nanoseconds});
+                }
+                m_first = (m_first + 1) % PairCount();
+                m_pending--;
+            }
+        }
+
+    private:
+        std::vector<const char*> m_scopes;
+        uint32_t m_first{0};
+        uint32_t m_pending{0};
+    };
+}  // namespace Conformance
@@ -0,0 +1,266 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "graphics_plugin.h"
+#include "Geometry.h"
+#include <common/xr_linear.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace Conformance
+{
+    void ComputeMVPs(const XrMatrix4x4f& viewProjection, const Cube* cubes, size_t cubeCount, XrMatrix4x4f* out)
+    {
+        size_t i = 0;
+
+#if defined(XR_LINEAR_USE_SSE) || defined(XR_LINEAR_USE_NEON)
+        // Four cubes at a time, one per SIMD lane: the poses are gathered into structure-of-arrays form, the model
+        // and model-view-projection entries are computed for all four at once, and the results scattered back out.
+        // This is the same arithmetic as XrMatrix4x4f_CreateTranslationRotationScale followed by XrMatrix4x4f_Multiply.
+        const float* vp = viewProjection.m;
+        for (; i + 4 <= cubeCount; i += 4) {
+            float lanes[10][4];
+            for (int lane = 0; lane < 4; ++lane) {
+                const Cube& cube = cubes[i + lane];
+                lanes[0][lane] = cube.Pose.orientation.x;
+                lanes[1][lane] = cube.Pose.orientation.y;
+                lanes[2][lane] = cube.Pose.orientation.z;
+                lanes[3][lane] = cube.Pose.orientation.w;
+                lanes[4][lane] = cube.Pose.position.x;
+                lanes[5][lane] = cube.Pose.position.y;
+                lanes[6][lane] = cube.Pose.position.z;
+                lanes[7][lane] = cube.Scale.x;
+                lanes[8][lane] = cube.Scale.y;
+                lanes[9][lane] = cube.Scale.z;
+            }
+            const XrSimd4f qx = XrSimd4f_Load(lanes[0]);
+            const XrSimd4f qy = XrSimd4f_Load(lanes[1]);
+            const XrSimd4f qz = XrSimd4f_Load(lanes[2]);
+            const XrSimd4f qw = XrSimd4f_Load(lanes[3]);
+            const XrSimd4f sx = XrSimd4f_Load(lanes[7]);
+            const XrSimd4f sy = XrSimd4f_Load(lanes[8]);
+            const XrSimd4f sz = XrSimd4f_Load(lanes[9]);
+
+            const XrSimd4f x2 = XrSimd4f_Add(qx, qx);
+            const XrSimd4f y2 = XrSimd4f_Add(qy, qy);
+            const XrSimd4f z2 = XrSimd4f_Add(qz, qz);
+            const XrSimd4f xx2 = XrSimd4f_Mul(qx, x2);
+            const XrSimd4f yy2 = XrSimd4f_Mul(qy, y2);
+            const XrSimd4f zz2 = XrSimd4f_Mul(qz, z2);
+            const XrSimd4f yz2 = XrSimd4f_Mul(qy, z2);
+            const XrSimd4f wx2 = XrSimd4f_Mul(qw, x2);
+            const XrSimd4f xy2 = XrSimd4f_Mul(qx, y2);
+            const XrSimd4f wz2 = XrSimd4f_Mul(qw, z2);
+            const XrSimd4f xz2 = XrSimd4f_Mul(qx, z2);
+            const XrSimd4f wy2 = XrSimd4f_Mul(qw, y2);
+            const XrSimd4f one = XrSimd4f_Splat(1.0f);
+
+            // The upper 3x4 of the model matrix, column by column; its last row is always (0, 0, 0, 1).
+            const XrSimd4f model[4][3] = {
+                {XrSimd4f_Mul(XrSimd4f_Sub(XrSimd4f_Sub(one, yy2), zz2), sx), XrSimd4f_Mul(XrSimd4f_Add(xy2, wz2), sx),
+                 XrSimd4f_Mul(XrSimd4f_Sub(xz2, wy2), sx)},
+                {XrSimd4f_Mul(XrSimd4f_Sub(xy2, wz2), sy), XrSimd4f_Mul(XrSimd4f_Sub(XrSimd4f_Sub(one, xx2), zz2), sy),
+                 XrSimd4f_Mul(XrSimd4f_Add(yz2, wx2), sy)},
+                {XrSimd4f_Mul(XrSimd4f_Add(xz2, wy2), sz), XrSimd4f_Mul(XrSimd4f_Sub(yz2, wx2), sz),
+                 XrSimd4f_Mul(XrSimd4f_Sub(XrSimd4f_Sub(one, xx2), yy2), sz)},
+                {XrSimd4f_Load(lanes[4]), XrSimd4f_Load(lanes[5]), XrSimd4f_Load(lanes[6])},
+            };
+
+            float mvps[16][4];
+            for (int c = 0; c < 4; ++c) {
+                for (int r = 0; r < 4; ++r) {
+                    XrSimd4f e = XrSimd4f_Mul(XrSimd4f_Splat(vp[r]), model[c][0]);
+                    e = XrSimd4f_MulAdd(XrSimd4f_Splat(vp[4 + r]), model[c][1], e);
+                    e = XrSimd4f_MulAdd(XrSimd4f_Splat(vp[8 + r]), model[c][2], e);
+                    if (c == 3) {
+                        e = XrSimd4f_Add(e, XrSimd4f_Splat(vp[12 + r]));
+                    }
+                    XrSimd4f_Store(mvps[4 * c + r], e);
+                }
+            }
+
+            // Written in address order, since out may be write-combined memory.
+            for (int lane = 0; lane < 4; ++lane) {
+                float* dst = out[i + lane].m;
+                for (int e = 0; e < 16; ++e) {
+                    dst[e] = mvps[e][lane];
+                }
+            }
+        }
+#endif
+
+        if (i < cubeCount) {
+            XrMatrix4x4f_MultiplyPoseArray(&out[i], &viewProjection, &cubes[i].Pose, &cubes[i].Scale, sizeof(Cube), cubeCount - i);
+        }
+    }
+
+    size_t CubeScene::Add(const Cube& cube)
+    {
+        m_cubes.push_back(cube);
+        MarkChanged(m_cubes.size() - 1);
+        return m_cubes.size() - 1;
+    }
+
+    void CubeScene::Set(size_t index, const Cube& cube)
+    {
+        Cube& current = m_cubes[index];
+        if (memcmp(&current, &cube, sizeof(Cube)) != 0) {
+            current = cube;
+            MarkChanged(index);
+        }
+    }
+
+    void CubeScene::Assign(const std::vector<Cube>& cubes)
+    {
+        const size_t keptCount = std::min(m_cubes.size(), cubes.size());
+        m_cubes.resize(cubes.size());
+        for (size_t i = 0; i < keptCount; ++i) {
+            Set(i, cubes[i]);
+        }
+        for (size_t i = keptCount; i < cubes.size(); ++i) {
+            m_cubes[i] = cubes[i];
+            MarkChanged(i);
+        }
+        m_changedEnd = std::min(m_changedEnd, m_cubes.size());
+        m_changedBegin = std::min(m_changedBegin, m_changedEnd);
+    }
+
+    void CubeScene::MarkChanged(size_t index)
+    {
+        if (m_changedBegin == m_changedEnd) {
+            m_changedBegin = index;
+            m_changedEnd = index + 1;
+        }
+        else {
+            m_changedBegin = std::min(m_changedBegin, index);
+            m_changedEnd = std::max(m_changedEnd, index + 1);
+        }
+    }
+
+    void CubeScene::TakeChangedRange(size_t* changedBegin, size_t* changedEnd)
+    {
+        *changedBegin = m_changedBegin;
+        *changedEnd = m_changedEnd;
+        m_changedBegin = m_changedEnd = 0;
+    }
+
+    const std::vector<Cube>& SyntheticGpuLoad::Apply(const XrCompositionLayerProjectionView* layerViews, uint32_t viewCount,
+                                                     const std::vector<Cube>& cubes)
+    {
+        if (m_layerCount == 0 || viewCount == 0) {
+            return cubes;
+        }
+
+        // The plugins project with a 0.05m to 100m depth range; the slabs stay inside it and behind anything the tests
+        // place within a few meters of the viewer.
+        constexpr float nearestDistance = 5.0f;
+        constexpr float farthestDistance = 90.0f;
+        // Views of one frame are centimeters apart, so slabs sized to the widest view from the first one, with a margin,
+        // cover all of them.
+        constexpr float margin = 1.1f;
+        constexpr float maxAngle = 1.48f;  // About 85 degrees, to keep the tangents finite.
+
+        float tanX = 0, tanY = 0;
+        for (uint32_t i = 0; i < viewCount; ++i) {
+            const XrFovf& fov = layerViews[i].fov;
+            tanX = std::max({tanX, std::tan(std::min(std::fabs(fov.angleLeft), maxAngle)),
+                             std::tan(std::min(std::fabs(fov.angleRight), maxAngle))});
+            tanY = std::max({tanY, std::tan(std::min(std::fabs(fov.angleUp), maxAngle)),
+                             std::tan(std::min(std::fabs(fov.angleDown), maxAngle))});
+        }
+
+        const XrPosef& viewPose = layerViews[0].pose;
+        const XrVector3f unitScale{1, 1, 1};
+        XrMatrix4x4f viewToWorld;
+        XrMatrix4x4f_CreateTranslationRotationScale(&viewToWorld, &viewPose.position, &viewPose.orientation, &unitScale);
+
+        m_cubes.clear();
+        m_cubes.reserve(m_layerCount + cubes.size());
+        for (uint32_t layer = 0; layer < m_layerCount; ++layer) {
+            const float t = m_layerCount > 1 ? (float)layer / (float)(m_layerCount - 1) : 0.0f;
+            const float distance = farthestDistance + (nearestDistance - farthestDistance) * t;
+
+            const XrVector3f inView{0, 0, -distance};
+            XrVector3f position;
+            XrMatrix4x4f_TransformVector3f(&position, &viewToWorld, &inView);
+
+            const XrVector3f scale{2 * distance * tanX * margin, 2 * distance * tanY * margin, 0.001f * distance};
+            m_cubes.push_back(Cube{{viewPose.orientation, position}, scale});
+        }
+        m_cubes.insert(m_cubes.end(), cubes.begin(), cubes.end());
+        return m_cubes;
+    }
+
+    void IGraphicsPlugin::RenderGeneratedContent(const XrSwapchainImageBaseHeader* colorSwapchainImage, int64_t colorSwapchainFormat,
+                                                 const XrExtent2Di& extent, uint32_t layer, uint32_t label)
+    {
+        // 45 degrees each way, the 90 degree field of view of a cube map face.
+        constexpr float halfFov = MATH_PI / 4;
+        XrCompositionLayerProjectionView view{XR_TYPE_COMPOSITION_LAYER_PROJECTION_VIEW};
+        view.pose = XrPosef{{0, 0, 0, 1}, {0, 0, 0}};
+        view.fov = XrFovf{-halfFov, halfFov, halfFov, -halfFov};
+        view.subImage.imageRect = {{0, 0}, extent};
+        view.subImage.imageArrayIndex = layer;
+
+        // One meter ahead the view spans -1 to 1 both ways.
+        const uint32_t barCount = std::min<uint32_t>(label + 1, 16);
+        const float barPitch = 1.6f / barCount;
+        std::vector<Cube> cubes;
+        cubes.reserve(barCount + 1);
+        for (uint32_t bar = 0; bar < barCount; ++bar) {
+            const XrVector3f position{-0.8f + barPitch * (bar + 0.5f), -0.6f, -1.0f};
+            cubes.push_back(Cube{{{0, 0, 0, 1}, position}, {barPitch * 0.6f, 0.3f, 0.05f}});
+        }
+        XrQuaternionf orientation;
+        const XrVector3f axis{0.577350f, 0.577350f, 0.577350f};
+        XrQuaternionf_CreateFromAxisAngle(&orientation, &axis, 0.5f + 0.7f * label);
+        cubes.push_back(Cube::Make({0, 0.25f, -2.0f}, 1.0f, orientation));
+
+        ClearAndRenderViews(&view, 1, colorSwapchainImage, colorSwapchainFormat, cubes);
+    }
+
+    void BuildHiddenAreaVertices(const VisibilityMask& hiddenArea, std::vector<Geometry::PackedVertex>& out)
+    {
+        // Just past the near plane, so that the mask wins the depth test against everything the tests draw.
+        constexpr float distance = IGraphicsPlugin::DepthNearZ * 1.01f;
+        constexpr XrVector3f black{0, 0, 0};
+
+        out.clear();
+        out.reserve(hiddenArea.indices.size());
+        const auto vertexCount = (uint32_t)hiddenArea.vertices.size();
+        for (size_t i = 0; i + 3 <= hiddenArea.indices.size(); i += 3) {
+            const uint32_t* triangle = &hiddenArea.indices[i];
+            if (triangle[0] >= vertexCount || triangle[1] >= vertexCount || triangle[2] >= vertexCount) {
+                continue;
+            }
+            const XrVector2f& a = hiddenArea.vertices[triangle[0]];
+            const XrVector2f& b = hiddenArea.vertices[triangle[1]];
+            const XrVector2f& c = hiddenArea.vertices[triangle[2]];
+
+            // The extension does not specify a winding order, and the plugins cull faces wound counter-clockwise as seen
+            // from the eye, so flip those.
+            const float signedArea = (b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y);
+            const XrVector2f* corners[3] = {&a, &b, &c};
+            if (signedArea > 0) {
+                std::swap(corners[1], corners[2]);
+            }
+            for (const XrVector2f* corner : corners) {
+                out.push_back(Geometry::PackVertex({{corner->x * distance, corner->y * distance, -distance}, black}));
+            }
+        }
+    }
+}  // namespace Conformance
@@ -18,13 +18,18 @@
 
 #include "platform_plugin.h"
 #include "RGBAImage.h"
+#include "gpu_timing.h"
+#include "hand_mesh.h"
 #include <openxr/openxr.h>
 #include <memory>
 #include <functional>
+#include <future>
 #include <vector>
 #include <string>
 #include <stdexcept>
 
+struct XrMatrix4x4f;
+
 // We #include all the possible graphics system headers here because openxr_platform.h assumes that
 // they are all visible when it is compiled.
 
@@ -60,6 +65,11 @@
 #include <d3d12.h>
 #endif
 
+namespace Geometry
+{
+    struct PackedVertex;
+}  // namespace Geometry
+
 namespace Conformance
 {
     struct Cube
@@ -73,6 +83,89 @@ namespace Conformance
         }
     };
 
+    /// Writes viewProjection * model transform for each of cubeCount cubes to out, which must have room for cubeCount
+    /// matrices and may be mapped GPU memory. The graphics plugins use this to fill their instance buffers.
+    void ComputeMVPs(const XrMatrix4x4f& viewProjection, const Cube* cubes, size_t cubeCount, XrMatrix4x4f* out);
+
+    inline void ComputeMVPs(const XrMatrix4x4f& viewProjection, const std::vector<Cube>& cubes, XrMatrix4x4f* out)
+    {
+        ComputeMVPs(viewProjection, cubes.data(), cubes.size(), out);
+    }
+
+    /// The hidden area of a view, as returned by xrGetVisibilityMaskKHR for XR_VISIBILITY_MASK_TYPE_HIDDEN_TRIANGLE_MESH_KHR:
+    /// a triangle list whose vertices lie in the view's tangent space, on the plane one meter ahead of the eye.
+    struct VisibilityMask
+    {
+        std::vector<XrVector2f> vertices;
+        std::vector<uint32_t> indices;
+    };
+
+    /// Expands hiddenArea into a non-indexed list of black triangles in view space, just beyond
+    /// IGraphicsPlugin::DepthNearZ, wound clockwise like the cube faces. Drawn with the view pose as the model transform
+    /// before the cubes, they fill the depth buffer over the hidden area so that nothing drawn later is shaded there.
+    void BuildHiddenAreaVertices(const VisibilityMask& hiddenArea, std::vector<Geometry::PackedVertex>& out);
+
+    /// The synthetic GPU load of IGraphicsPlugin::SetSyntheticGpuLoad, shared by the plugins that implement it. The load
+    /// is drawn with the plugin's own cube pipeline: view-filling slabs placed far to near behind the scene, so that each
+    /// passes the depth test and shades every pixel of the view again.
+    class SyntheticGpuLoad
+    {
+    public:
+        void SetLayerCount(uint32_t layerCount)
+        {
+            m_layerCount = layerCount;
+        }
+
+        uint32_t GetLayerCount() const
+        {
+            return m_layerCount;
+        }
+
+        /// Returns cubes if no load is set, otherwise a copy of them preceded by the load's slabs, sized to cover all the
+        /// views. The copy stays valid until the next call.
+        const std::vector<Cube>& Apply(const XrCompositionLayerProjectionView* layerViews, uint32_t viewCount,
+                                       const std::vector<Cube>& cubes);
+
+    private:
+        uint32_t m_layerCount{0};
+        std::vector<Cube> m_cubes;
+    };
+
+    /// Cubes kept from frame to frame, made by IGraphicsPlugin::CreateCubeScene and drawn with IGraphicsPlugin::RenderScene.
+    /// The scene tracks which cubes changed, so that a plugin that keeps their model transforms in GPU memory only
+    /// recomputes and uploads those.
+    class CubeScene
+    {
+    public:
+        virtual ~CubeScene() = default;
+
+        /// Returns the index of the new cube.
+        size_t Add(const Cube& cube);
+
+        /// Marks the cube as changed if it differs from the one at index.
+        void Set(size_t index, const Cube& cube);
+
+        /// Replaces the cubes, marking only those that differ from the ones at their index as changed, for callers that
+        /// build their cubes afresh every frame.
+        void Assign(const std::vector<Cube>& cubes);
+
+        const std::vector<Cube>& GetCubes() const
+        {
+            return m_cubes;
+        }
+
+        /// Sets [changedBegin, changedEnd) to the indices of the cubes changed since the last call, an empty range if none
+        /// changed, and starts tracking afresh.
+        void TakeChangedRange(size_t* changedBegin, size_t* changedEnd);
+
+    private:
+        void MarkChanged(size_t index);
+
+        std::vector<Cube> m_cubes;
+        size_t m_changedBegin{0};
+        size_t m_changedEnd{0};
+    };
+
     // Forward-declare
     struct SwapchainCreateTestParameters;
 
@@ -133,9 +226,63 @@ namespace Conformance
         // Must have successfully called InitializeDevice before calling this or else this returns nullptr.
         virtual const XrBaseInStructure* GetGraphicsBinding() const = 0;
 
+        // Copies image, which is the size of the swapchain, into level 0 of one array slice of a swapchain image. The other
+        // levels of a swapchain with a mipCount above 1 are filled with a chain filtered from it, on the GPU where possible.
+        // Half float, float and 10-bit formats get the image converted to their texels, see WriteRGBATexels.
         virtual void CopyRGBAImage(const XrSwapchainImageBaseHeader* /*swapchainImage*/, int64_t /*imageFormat*/, uint32_t /*arraySlice*/,
                                    const RGBAImage& /*image*/) = 0;
 
+        // Starts copying one array slice of a swapchain image in the GetSRGBA8Format() format back to host memory. The copy
+        // is submitted before this returns, while the image is still acquired, and is only waited for when the returned
+        // future is read, so several readbacks can be in flight at once. Read the future on the graphics thread and before
+        // ShutdownDevice. Returns an invalid future if the plugin cannot read back images.
+        virtual std::future<RGBAImage> ReadbackSwapchainImage(const XrSwapchainImageBaseHeader* /*swapchainImage*/, int64_t /*imageFormat*/,
+                                                              uint32_t /*arraySlice*/)
+        {
+            return {};
+        }
+
+        // Turns GPU timing of RenderView, RenderViews, ClearImageSlice and CopyRGBAImage on or off. While it is on, the work
+        // each of these calls submits is bracketed by timestamp queries, whose results CollectGpuTimings reads back later.
+        // Timing is off after InitializeDevice. Returns false if the plugin or device cannot measure GPU time.
+        virtual bool SetGpuTimingEnabled(bool /*enabled*/)
+        {
+            return false;
+        }
+
+        // Appends the timings whose queries the GPU has finished, oldest first, without waiting for the GPU. A result
+        // usually becomes available a few frames after its work was submitted. Pending results are lost at ShutdownDevice.
+        virtual void CollectGpuTimings(std::vector<GpuTimingSample>& /*samples*/)
+        {
+        }
+
+        // Makes RenderView and RenderViews draw layerCount view-filling layers behind the cubes, each of which shades every
+        // pixel of the view, so that benchmarks can make the application GPU-bound by a chosen amount. The GPU time this
+        // costs depends on the device and the view size; calibrate it with SetGpuTimingEnabled. The layers are visible
+        // where the cubes do not cover them. 0, the default after InitializeDevice, draws none. Returns false if the plugin
+        // cannot add the load.
+        virtual bool SetSyntheticGpuLoad(uint32_t /*layerCount*/)
+        {
+            return false;
+        }
+
+        // Makes RenderView and RenderViews rasterize with sampleCount samples per pixel, 1 by default after InitializeDevice.
+        // Above 1, each view is drawn into transient multisampled color and depth targets that start out cleared as by
+        // ClearImageSlice, and is then resolved into its imageRect of the swapchain image, so earlier drawing inside the
+        // rect is not kept. RenderViewWithDepth still renders single-sampled, since depth swapchains are not resolved.
+        // Returns false, leaving the count as it was, if the plugin or device cannot render with that many samples.
+        virtual bool SetRenderSampleCount(uint32_t sampleCount)
+        {
+            return sampleCount == 1;
+        }
+
+        // Reports the device-local GPU memory this process uses on the device, as the driver accounts for it, so that tests can
+        // watch for leaks. Returns false if the plugin or device cannot report it.
+        virtual bool GetGpuMemoryUsage(uint64_t* /*usedBytes*/) const
+        {
+            return false;
+        }
+
         // Returns a name for an image format. Returns "unknown" for unknown formats.
         virtual std::string GetImageFormatName(int64_t /*imageFormat*/) const = 0;
 
@@ -194,6 +341,116 @@ namespace Conformance
         virtual void RenderView(const XrCompositionLayerProjectionView& /*layerView*/,
                                 const XrSwapchainImageBaseHeader* /*colorSwapchainImage*/, int64_t /*colorSwapchainFormat*/,
                                 const std::vector<Cube>& /*cubes*/) = 0;
+
+        // Renders the cubes into several views of the same swapchain image, such as the array slices of a stereo
+        // projection layer. Plugins may override this to record every view into a single submission; the default
+        // renders the views one at a time.
+        virtual void RenderViews(const XrCompositionLayerProjectionView* layerViews, uint32_t viewCount,
+                                 const XrSwapchainImageBaseHeader* colorSwapchainImage, int64_t colorSwapchainFormat,
+                                 const std::vector<Cube>& cubes)
+        {
+            for (uint32_t i = 0; i < viewCount; ++i) {
+                RenderView(layerViews[i], colorSwapchainImage, colorSwapchainFormat, cubes);
+            }
+        }
+
+        // Clears the array slices of the views as ClearImageSlice does, then renders the cubes into them as RenderViews
+        // does. Plugins may override this to clear each view as its render pass loads the attachments and to discard the
+        // depth once it is done, which saves a tiled GPU a load and a store of every view; so a later RenderView into the
+        // image needs a ClearImageSlice first. The default does the two in turn.
+        virtual void ClearAndRenderViews(const XrCompositionLayerProjectionView* layerViews, uint32_t viewCount,
+                                         const XrSwapchainImageBaseHeader* colorSwapchainImage, int64_t colorSwapchainFormat,
+                                         const std::vector<Cube>& cubes)
+        {
+            ClearViewSlices(layerViews, viewCount, colorSwapchainImage, colorSwapchainFormat);
+            RenderViews(layerViews, viewCount, colorSwapchainImage, colorSwapchainFormat, cubes);
+        }
+
+        // Makes a scene for RenderScene. Plugins may return a subclass that keeps the model transforms in GPU memory.
+        virtual std::shared_ptr<CubeScene> CreateCubeScene()
+        {
+            return std::make_shared<CubeScene>();
+        }
+
+        // Renders a scene as RenderViews renders its cubes. Plugins may override this to draw from model transforms kept
+        // in GPU memory between frames, so that only the changed cubes and the view-projection of each view are uploaded.
+        virtual void RenderScene(const XrCompositionLayerProjectionView* layerViews, uint32_t viewCount,
+                                 const XrSwapchainImageBaseHeader* colorSwapchainImage, int64_t colorSwapchainFormat, CubeScene& scene)
+        {
+            RenderViews(layerViews, viewCount, colorSwapchainImage, colorSwapchainFormat, scene.GetCubes());
+        }
+
+        // Clears and renders a scene as ClearAndRenderViews does its cubes.
+        virtual void ClearAndRenderScene(const XrCompositionLayerProjectionView* layerViews, uint32_t viewCount,
+                                         const XrSwapchainImageBaseHeader* colorSwapchainImage, int64_t colorSwapchainFormat,
+                                         CubeScene& scene)
+        {
+            ClearAndRenderViews(layerViews, viewCount, colorSwapchainImage, colorSwapchainFormat, scene.GetCubes());
+        }
+
+        // The distances in meters that RenderView maps to depth 0.0 and 1.0, for XrCompositionLayerDepthInfoKHR.
+        static constexpr float DepthNearZ = 0.05f;
+        static constexpr float DepthFarZ = 100.0f;
+
+        // Renders like RenderView, but into depthSwapchainImage instead of the plugin's own depth buffer, so that the depth
+        // can be submitted with XR_KHR_composition_layer_depth. The depth swapchain must have the size and array slices of
+        // the color one and a format from SelectDepthSwapchainFormat, and its images must have been enumerated through
+        // AllocateSwapchainImageStructs. The view's imageArrayIndex of the depth image is cleared to 1.0 first; ClearImageSlice
+        // does not touch it. Returns false, without rendering, if the plugin cannot render into this depth swapchain.
+        virtual bool RenderViewWithDepth(const XrCompositionLayerProjectionView& /*layerView*/,
+                                         const XrSwapchainImageBaseHeader* /*colorSwapchainImage*/, int64_t /*colorSwapchainFormat*/,
+                                         const XrSwapchainImageBaseHeader* /*depthSwapchainImage*/, int64_t /*depthSwapchainFormat*/,
+                                         const std::vector<Cube>& /*cubes*/)
+        {
+            return false;
+        }
+
+        // Renders like RenderView, but first covers the view's hidden area, as BuildHiddenAreaVertices lays it out, with
+        // black at the near plane so that the depth test rejects the cubes and any synthetic GPU load behind it before they
+        // are shaded. Returns false, without rendering, if the plugin cannot draw the hidden area.
+        virtual bool RenderViewWithVisibilityMask(const XrCompositionLayerProjectionView& /*layerView*/,
+                                                  const XrSwapchainImageBaseHeader* /*colorSwapchainImage*/,
+                                                  int64_t /*colorSwapchainFormat*/, const VisibilityMask& /*hiddenArea*/,
+                                                  const std::vector<Cube>& /*cubes*/)
+        {
+            return false;
+        }
+
+        // Renders like RenderView, then draws the GetHandMeshes mesh of each hand skinned on the GPU: its bone palette is
+        // uploaded once per hand and the vertex shader blends the two bones of every vertex, so that the CPU cost does not
+        // grow with the mesh. Returns false, without rendering, if the plugin has no skinning pipeline.
+        virtual bool RenderViewWithSkinnedHands(const XrCompositionLayerProjectionView& /*layerView*/,
+                                                const XrSwapchainImageBaseHeader* /*colorSwapchainImage*/,
+                                                int64_t /*colorSwapchainFormat*/, const std::vector<SkinnedHand>& /*hands*/,
+                                                const std::vector<Cube>& /*cubes*/)
+        {
+            return false;
+        }
+
+        // Fills one layer of a color swapchain image with test content generated on the GPU, so that large cube map and
+        // equirect images need no CPU rasterization and upload: label + 1 bars, up to 16, along the bottom and a cube
+        // turned by the label above them, seen with the 90 degree field of view of a cube map face. The layer is the
+        // array slice, or arraySlice * 6 + face for a cube map swapchain, and extent the size of the swapchain. The
+        // default clears and renders it with ClearAndRenderViews; plugins may override this with a dedicated pass.
+        virtual void RenderGeneratedContent(const XrSwapchainImageBaseHeader* colorSwapchainImage, int64_t colorSwapchainFormat,
+                                            const XrExtent2Di& extent, uint32_t layer, uint32_t label);
+
+    protected:
+        // Calls ClearImageSlice once for each array slice the views render into.
+        void ClearViewSlices(const XrCompositionLayerProjectionView* layerViews, uint32_t viewCount,
+                             const XrSwapchainImageBaseHeader* colorSwapchainImage, int64_t colorSwapchainFormat)
+        {
+            for (uint32_t i = 0; i < viewCount; ++i) {
+                const uint32_t arraySlice = layerViews[i].subImage.imageArrayIndex;
+                bool cleared = false;
+                for (uint32_t j = 0; j < i; ++j) {
+                    cleared = cleared || layerViews[j].subImage.imageArrayIndex == arraySlice;
+                }
+                if (!cleared) {
+                    ClearImageSlice(colorSwapchainImage, arraySlice, colorSwapchainFormat);
+                }
+            }
+        }
     };
 
 #define IGRAPHICSPLUGIN_UNIMPLEMENTED_METHOD() \
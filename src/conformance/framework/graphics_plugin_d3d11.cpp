@@ -21,6 +21,10 @@
 #include "swapchain_parameters.h"
 #include "conformance_framework.h"
 #include "Geometry.h"
+#include "mesh_buffer.h"
+#include "projection_cache.h"
+#include "trace_scope.h"
+#include "view_worker_pool.h"
 #include <windows.h>
 #include <wrl/client.h>  // For Microsoft::WRL::ComPtr
 #include <common/xr_linear.h>
@@ -29,6 +33,8 @@
 #include <openxr/openxr_platform.h>
 #include <algorithm>
 #include <array>
+#include <map>
+#include <tuple>
 #include <catch2/catch.hpp>
 
 #include "d3d_common.h"
@@ -68,6 +74,9 @@ namespace Conformance
         void CopyRGBAImage(const XrSwapchainImageBaseHeader* swapchainImage, int64_t imageFormat, uint32_t arraySlice,
                            const RGBAImage& image) override;
 
+        std::future<RGBAImage> ReadbackSwapchainImage(const XrSwapchainImageBaseHeader* swapchainImage, int64_t imageFormat,
+                                                      uint32_t arraySlice) override;
+
         std::string GetImageFormatName(int64_t imageFormat) const override;
 
         bool IsImageFormatKnown(int64_t imageFormat) const override;
@@ -95,9 +104,117 @@ namespace Conformance
         void RenderView(const XrCompositionLayerProjectionView& layerView, const XrSwapchainImageBaseHeader* colorSwapchainImage,
                         int64_t colorSwapchainFormat, const std::vector<Cube>& cubes) override;
 
+        void RenderViews(const XrCompositionLayerProjectionView* layerViews, uint32_t viewCount,
+                         const XrSwapchainImageBaseHeader* colorSwapchainImage, int64_t colorSwapchainFormat,
+                         const std::vector<Cube>& cubes) override;
+
+        std::shared_ptr<CubeScene> CreateCubeScene() override
+        {
+            return std::make_shared<D3D11CubeScene>();
+        }
+
+        void RenderScene(const XrCompositionLayerProjectionView* layerViews, uint32_t viewCount,
+                         const XrSwapchainImageBaseHeader* colorSwapchainImage, int64_t colorSwapchainFormat, CubeScene& scene) override;
+
+        void ClearAndRenderScene(const XrCompositionLayerProjectionView* layerViews, uint32_t viewCount,
+                                 const XrSwapchainImageBaseHeader* colorSwapchainImage, int64_t colorSwapchainFormat,
+                                 CubeScene& scene) override
+        {
+            ClearViewSlices(layerViews, viewCount, colorSwapchainImage, colorSwapchainFormat);
+            RenderScene(layerViews, viewCount, colorSwapchainImage, colorSwapchainFormat, scene);
+        }
+
+        bool RenderViewWithDepth(const XrCompositionLayerProjectionView& layerView, const XrSwapchainImageBaseHeader* colorSwapchainImage,
+                                 int64_t colorSwapchainFormat, const XrSwapchainImageBaseHeader* depthSwapchainImage,
+                                 int64_t depthSwapchainFormat, const std::vector<Cube>& cubes) override;
+
+        bool RenderViewWithVisibilityMask(const XrCompositionLayerProjectionView& layerView,
+                                          const XrSwapchainImageBaseHeader* colorSwapchainImage, int64_t colorSwapchainFormat,
+                                          const VisibilityMask& hiddenArea, const std::vector<Cube>& cubes) override;
+
+        bool SetGpuTimingEnabled(bool enabled) override;
+
+        void CollectGpuTimings(std::vector<GpuTimingSample>& samples) override;
+
+        bool SetSyntheticGpuLoad(uint32_t layerCount) override
+        {
+            syntheticGpuLoad.SetLayerCount(layerCount);
+            return true;
+        }
+
+        bool SetRenderSampleCount(uint32_t sampleCount) override;
+
+        bool GetGpuMemoryUsage(uint64_t* usedBytes) const override;
+
     protected:
         ComPtr<ID3D11Texture2D> GetDepthStencilTexture(ID3D11Texture2D* colorTexture);
 
+        // The targets a view is rendered into while renderSampleCount is above 1, the size of its imageRect. resolve is
+        // only made for views that do not cover the whole swapchain, which cannot be resolved into directly.
+        struct MultisampleTargets
+        {
+            ComPtr<ID3D11Texture2D> color;
+            ComPtr<ID3D11Texture2D> depth;
+            ComPtr<ID3D11Texture2D> resolve;
+        };
+        MultisampleTargets& GetMultisampleTargets(UINT width, UINT height, DXGI_FORMAT colorFormat);
+
+        // The buffers a device context draws the cubes with.
+        struct ViewBuffers
+        {
+            ComPtr<ID3D11Buffer> viewProjectionCBuffer;
+            // Dynamic ring of per-cube model transforms. On the immediate context each view appends its cubes with
+            // WRITE_NO_OVERWRITE and the buffer is only discarded when it wraps, so consecutive views do not make the
+            // driver rename it. Deferred contexts discard it for every view.
+            ComPtr<ID3D11Buffer> instanceBuffer;
+            UINT instanceBufferCapacity{0};
+            UINT instanceBufferOffset{0};
+            // Dynamic vertices of the hidden area, discarded for every view that draws one.
+            ComPtr<ID3D11Buffer> hiddenAreaVertexBuffer;
+            UINT hiddenAreaVertexBufferCapacity{0};
+        };
+
+        // A scene whose model transforms stay in a default-usage instance buffer, into which only those of the changed
+        // cubes are computed and copied before a render.
+        struct D3D11CubeScene : public CubeScene
+        {
+            ComPtr<ID3D11Buffer> instanceBuffer;
+            UINT instanceBufferCapacity{0};
+            std::vector<XrMatrix4x4f> changedModelMatrices;
+        };
+
+        // Returns the pixels of image in the texel layout of format, converted into m_texelScratch unless that is the
+        // layout RGBAImage already has. Valid until the next call.
+        const void* GetTexels(const RGBAImage& image, DXGI_FORMAT format, UINT* rowPitch);
+
+        // Fills every mip level of one array slice of a swapchain with more than one, filtering the lower levels from image.
+        void CopyRGBAImageMips(ID3D11Texture2D* destTexture, const D3D11_TEXTURE2D_DESC& destDesc, DXGI_FORMAT format, uint32_t arraySlice,
+                               const RGBAImage& image);
+
+        // RenderView, drawing hiddenArea before the cubes if it is not null.
+        void RenderViewWithHiddenArea(const XrCompositionLayerProjectionView& layerView,
+                                      const XrSwapchainImageBaseHeader* colorSwapchainImage, int64_t colorSwapchainFormat,
+                                      const std::vector<Cube>& sceneCubes, const std::vector<Geometry::PackedVertex>* hiddenArea);
+
+        // Issues the draws of one view on context, which may be the immediate context or a deferred one. Only uses the
+        // device and buffers, so views can be recorded on several deferred contexts at once. hiddenArea, if not null, is
+        // drawn first with the view pose as its model transform. sceneInstanceBuffer, if not null, already holds the model
+        // transforms of the cubes, which are then not uploaded; hiddenArea must be null with it.
+        void RecordView(ID3D11DeviceContext* context, ViewBuffers& buffers, const XrCompositionLayerProjectionView& layerView,
+                        ID3D11Texture2D* colorTexture, ID3D11Texture2D* depthStencilTexture, int64_t colorSwapchainFormat,
+                        DXGI_FORMAT depthStencilFormat, const XrMatrix4x4f& projectionMatrix, const std::vector<Cube>& cubes,
+                        const std::vector<Geometry::PackedVertex>* hiddenArea = nullptr, ID3D11Buffer* sceneInstanceBuffer = nullptr);
+
+        // Brackets the work submitted while it is alive with a GPU timing scope, see SetGpuTimingEnabled.
+        struct GpuTimingScope
+        {
+            GpuTimingScope(D3D11GraphicsPlugin& plugin, const char* scope);
+            ~GpuTimingScope();
+
+            D3D11GraphicsPlugin& plugin;
+            const uint32_t pair;
+        };
+
         struct D3D11SwapchainImageStructs : public IGraphicsPlugin::SwapchainImageStructs
         {
             std::vector<XrSwapchainImageD3D11KHR> imageVector;
@@ -113,13 +230,48 @@ namespace Conformance
         ComPtr<ID3D11VertexShader> vertexShader;
         ComPtr<ID3D11PixelShader> pixelShader;
         ComPtr<ID3D11InputLayout> inputLayout;
-        ComPtr<ID3D11Buffer> modelCBuffer;
-        ComPtr<ID3D11Buffer> viewProjectionCBuffer;
         ComPtr<ID3D11Buffer> cubeVertexBuffer;
         ComPtr<ID3D11Buffer> cubeIndexBuffer;
+        ViewBuffers immediateBuffers;
+        ProjectionCache<GRAPHICS_D3D> m_projectionCache;
+        std::vector<uint8_t> m_texelScratch;  // See GetTexels
+
+        // RenderViews records the views on deferred contexts on worker threads when Options::d3d11RecordThreads is more
+        // than 1, and executes the command lists in view order. Each worker has its own deferred context and buffers.
+        // A device created with D3D11_CREATE_DEVICE_SINGLETHREADED cannot have deferred contexts.
+        struct DeferredViewContext
+        {
+            ComPtr<ID3D11DeviceContext> context;
+            ViewBuffers buffers;
+        };
+        bool singleThreadedDevice{false};
+        std::vector<DeferredViewContext> deferredContexts;
+        std::vector<XrMatrix4x4f> viewProjectionMatrices;
+        std::vector<ComPtr<ID3D11CommandList>> viewCommandLists;
+        ViewWorkerPool viewWorkers;
 
         // Map color buffer to associated depth buffer. This map is populated on demand.
         std::map<ID3D11Texture2D*, ComPtr<ID3D11Texture2D>> colorToDepthMap;
+
+        // See SetRenderSampleCount. The targets are shared by every view of the same size and format.
+        UINT renderSampleCount{1};
+        std::map<std::tuple<UINT, UINT, DXGI_FORMAT>, MultisampleTargets> multisampleTargets;
+
+        // GPU timing: each pair of the ring is a begin and an end timestamp inside a disjoint query, which gives the
+        // timestamp frequency and tells whether it changed in between.
+        struct TimestampQueries
+        {
+            ComPtr<ID3D11Query> disjoint;
+            ComPtr<ID3D11Query> begin;
+            ComPtr<ID3D11Query> end;
+        };
+        static constexpr uint32_t TimestampPairCount = 64;
+        std::vector<TimestampQueries> timestampQueries;
+        GpuTimestampRing timestampRing;
+        bool gpuTimingEnabled{false};
+        SyntheticGpuLoad syntheticGpuLoad;
+        // Scratch space for RenderViewWithVisibilityMask.
+        std::vector<Geometry::PackedVertex> hiddenAreaVertices;
     };
 
     D3D11GraphicsPlugin::D3D11GraphicsPlugin(std::shared_ptr<IPlatformPlugin>)
@@ -203,6 +355,7 @@ namespace Conformance
 
             // Create the device
             UINT creationFlags = deviceCreationFlags | D3D11_CREATE_DEVICE_BGRA_SUPPORT;
+            singleThreadedDevice = (deviceCreationFlags & D3D11_CREATE_DEVICE_SINGLETHREADED) != 0;
 #if !defined(NDEBUG)
             creationFlags |= D3D11_CREATE_DEVICE_DEBUG;
 #endif
@@ -247,31 +400,32 @@ namespace Conformance
                                                                      pixelShaderBytes->GetBufferSize(), nullptr,
                                                                      pixelShader.ReleaseAndGetAddressOf()));
 
-                const std::array<D3D11_INPUT_ELEMENT_DESC, 2> vertexDesc{{
-                    {"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
-                    {"COLOR", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
+                const std::array<D3D11_INPUT_ELEMENT_DESC, 6> vertexDesc{{
+                    {"POSITION", 0, DXGI_FORMAT_R16G16B16A16_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
+                    {"COLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
+                    {"MODEL", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1},
+                    {"MODEL", 1, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1},
+                    {"MODEL", 2, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1},
+                    {"MODEL", 3, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1},
                 }};
 
                 XRC_CHECK_THROW_HRCMD(d3d11Device->CreateInputLayout(vertexDesc.data(), (UINT)vertexDesc.size(),
                                                                      vertexShaderBytes->GetBufferPointer(),
                                                                      vertexShaderBytes->GetBufferSize(), &inputLayout));
 
-                const CD3D11_BUFFER_DESC modelConstantBufferDesc(sizeof(ModelConstantBuffer), D3D11_BIND_CONSTANT_BUFFER);
-                XRC_CHECK_THROW_HRCMD(d3d11Device->CreateBuffer(&modelConstantBufferDesc, nullptr, modelCBuffer.ReleaseAndGetAddressOf()));
+                const CD3D11_BUFFER_DESC viewProjectionConstantBufferDesc(sizeof(ViewProjectionConstantBuffer), D3D11_BIND_CONSTANT_BUFFER,
+                                                                          D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE);
+                XRC_CHECK_THROW_HRCMD(d3d11Device->CreateBuffer(&viewProjectionConstantBufferDesc, nullptr,
+                                                                immediateBuffers.viewProjectionCBuffer.ReleaseAndGetAddressOf()));
 
-                const CD3D11_BUFFER_DESC viewProjectionConstantBufferDesc(sizeof(ViewProjectionConstantBuffer), D3D11_BIND_CONSTANT_BUFFER);
-                XRC_CHECK_THROW_HRCMD(
-                    d3d11Device->CreateBuffer(&viewProjectionConstantBufferDesc, nullptr, viewProjectionCBuffer.ReleaseAndGetAddressOf()));
-
-                const D3D11_SUBRESOURCE_DATA vertexBufferData{Geometry::c_cubeVertices.data()};
-                const CD3D11_BUFFER_DESC vertexBufferDesc((UINT)(Geometry::c_cubeVertices.size() * sizeof(Geometry::c_cubeVertices[0])),
-                                                          D3D11_BIND_VERTEX_BUFFER);
+                const MeshBuffer& meshes = GetSharedMeshes().buffer;
+                const D3D11_SUBRESOURCE_DATA vertexBufferData{meshes.Vertices().data()};
+                const CD3D11_BUFFER_DESC vertexBufferDesc((UINT)meshes.VertexBytes(), D3D11_BIND_VERTEX_BUFFER);
                 XRC_CHECK_THROW_HRCMD(
                     d3d11Device->CreateBuffer(&vertexBufferDesc, &vertexBufferData, cubeVertexBuffer.ReleaseAndGetAddressOf()));
 
-                const D3D11_SUBRESOURCE_DATA indexBufferData{Geometry::c_cubeIndices.data()};
-                const CD3D11_BUFFER_DESC indexBufferDesc((UINT)(Geometry::c_cubeIndices.size() * sizeof(Geometry::c_cubeIndices[0])),
-                                                         D3D11_BIND_INDEX_BUFFER);
+                const D3D11_SUBRESOURCE_DATA indexBufferData{meshes.Indices().data()};
+                const CD3D11_BUFFER_DESC indexBufferDesc((UINT)meshes.IndexBytes(), D3D11_BIND_INDEX_BUFFER);
                 XRC_CHECK_THROW_HRCMD(
                     d3d11Device->CreateBuffer(&indexBufferDesc, &indexBufferData, cubeIndexBuffer.ReleaseAndGetAddressOf()));
             }
@@ -299,11 +453,21 @@ namespace Conformance
         vertexShader.Reset();
         pixelShader.Reset();
         inputLayout.Reset();
-        modelCBuffer.Reset();
-        viewProjectionCBuffer.Reset();
+        immediateBuffers = ViewBuffers{};
         cubeVertexBuffer.Reset();
         cubeIndexBuffer.Reset();
         colorToDepthMap.clear();
+        renderSampleCount = 1;
+        multisampleTargets.clear();
+
+        timestampQueries.clear();
+        timestampRing.Reset(0);
+        gpuTimingEnabled = false;
+        syntheticGpuLoad.SetLayerCount(0);
+
+        viewWorkers.Stop();
+        deferredContexts.clear();
+        viewCommandLists.clear();
 
         d3d11DeviceContext.Reset();
         d3d11Device.Reset();
@@ -320,6 +484,32 @@ namespace Conformance
     void D3D11GraphicsPlugin::CopyRGBAImage(const XrSwapchainImageBaseHeader* swapchainImage, int64_t imageFormat, uint32_t arraySlice,
                                             const RGBAImage& image)
     {
+        XR_TRACE_SCOPE("D3D11GraphicsPlugin::CopyRGBAImage");
+
+        const GpuTimingScope timingScope(*this, "CopyRGBAImage");
+
+        ID3D11Texture2D* const destTexture = reinterpret_cast<const XrSwapchainImageD3D11KHR*>(swapchainImage)->texture;
+
+        D3D11_TEXTURE2D_DESC destDesc;
+        destTexture->GetDesc(&destDesc);
+
+        if (destDesc.MipLevels > 1) {
+            CopyRGBAImageMips(destTexture, destDesc, (DXGI_FORMAT)imageFormat, arraySlice, image);
+            return;
+        }
+
+        const UINT destSubResource = D3D11CalcSubresource(0, arraySlice, destDesc.MipLevels);
+        const D3D11_BOX imageRegion{0, 0, 0, (UINT)image.width, (UINT)image.height, 1};
+        UINT rowPitch = 0;
+        const void* texels = GetTexels(image, (DXGI_FORMAT)imageFormat, &rowPitch);
+
+        // UpdateSubresource writes straight into a default-usage texture that is not multisampled, which is how runtimes
+        // create color swapchain images, so there is no upload texture to create and destroy on each copy.
+        if (destDesc.Usage == D3D11_USAGE_DEFAULT && destDesc.SampleDesc.Count == 1) {
+            d3d11DeviceContext->UpdateSubresource(destTexture, destSubResource, &imageRegion, texels, rowPitch, 0);
+            return;
+        }
+
         D3D11_TEXTURE2D_DESC rgbaImageDesc{};
         rgbaImageDesc.Width = image.width;
         rgbaImageDesc.Height = image.height;
@@ -332,22 +522,125 @@ namespace Conformance
         rgbaImageDesc.BindFlags = 0;
 
         D3D11_SUBRESOURCE_DATA initData{};
-        initData.pSysMem = image.pixels.data();
-        initData.SysMemPitch = image.width * sizeof(uint32_t);
+        initData.pSysMem = texels;
+        initData.SysMemPitch = rowPitch;
         initData.SysMemSlicePitch = initData.SysMemPitch * image.height;
 
         ComPtr<ID3D11Texture2D> texture2D;
         XRC_CHECK_THROW_HRCMD(d3d11Device->CreateTexture2D(&rgbaImageDesc, &initData, &texture2D));
 
-        ID3D11Texture2D* const destTexture = reinterpret_cast<const XrSwapchainImageD3D11KHR*>(swapchainImage)->texture;
+        d3d11DeviceContext->CopySubresourceRegion(destTexture, destSubResource, 0 /* X */, 0 /* Y */, 0 /* Z */, texture2D.Get(), 0,
+                                                  &imageRegion);
+    }
 
-        D3D11_TEXTURE2D_DESC destDesc;
-        destTexture->GetDesc(&destDesc);
+    const void* D3D11GraphicsPlugin::GetTexels(const RGBAImage& image, DXGI_FORMAT format, UINT* rowPitch)
+    {
+        const RGBATexelLayout layout = GetDxgiRGBATexelLayout(format);
+        *rowPitch = UINT(image.width * RGBATexelSize(layout));
+        if (layout == RGBATexelLayout::R8G8B8A8) {
+            return image.pixels.data();
+        }
+        m_texelScratch.resize(size_t(*rowPitch) * image.height);
+        WriteRGBATexels(image, layout, m_texelScratch.data(), *rowPitch);
+        return m_texelScratch.data();
+    }
 
-        const UINT destSubResource = D3D11CalcSubresource(0, arraySlice, destDesc.MipLevels);
-        const D3D11_BOX sourceRegion{0, 0, 0, rgbaImageDesc.Width, rgbaImageDesc.Height, 1};
-        d3d11DeviceContext->CopySubresourceRegion(destTexture, destSubResource, 0 /* X */, 0 /* Y */, 0 /* Z */, texture2D.Get(), 0,
-                                                  &sourceRegion);
+    void D3D11GraphicsPlugin::CopyRGBAImageMips(ID3D11Texture2D* destTexture, const D3D11_TEXTURE2D_DESC& destDesc, DXGI_FORMAT format,
+                                                uint32_t arraySlice, const RGBAImage& image)
+    {
+        UINT formatSupport = 0;
+        if (FAILED(d3d11Device->CheckFormatSupport(format, &formatSupport)) || (formatSupport & D3D11_FORMAT_SUPPORT_MIP_AUTOGEN) == 0) {
+            // No GPU filter for this format: upload mips downsampled on the CPU instead.
+            const RGBAImage* levelImage = &image;
+            RGBAImage downsampled(0, 0);
+            for (UINT level = 0; level < destDesc.MipLevels; ++level) {
+                if (level > 0) {
+                    downsampled = levelImage->Downsampled();
+                    levelImage = &downsampled;
+                }
+                UINT rowPitch = 0;
+                const void* texels = GetTexels(*levelImage, format, &rowPitch);
+                d3d11DeviceContext->UpdateSubresource(destTexture, D3D11CalcSubresource(level, arraySlice, destDesc.MipLevels), nullptr,
+                                                      texels, rowPitch, 0);
+            }
+            return;
+        }
+
+        // The swapchain texture is created by the runtime without D3D11_RESOURCE_MISC_GENERATE_MIPS, so generate the chain in
+        // a scratch texture that has it and copy every level across.
+        D3D11_TEXTURE2D_DESC scratchDesc{};
+        scratchDesc.Width = destDesc.Width;
+        scratchDesc.Height = destDesc.Height;
+        scratchDesc.MipLevels = destDesc.MipLevels;
+        scratchDesc.ArraySize = 1;
+        scratchDesc.Format = format;
+        scratchDesc.SampleDesc.Count = 1;
+        scratchDesc.Usage = D3D11_USAGE_DEFAULT;
+        scratchDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_RENDER_TARGET;
+        scratchDesc.MiscFlags = D3D11_RESOURCE_MISC_GENERATE_MIPS;
+
+        ComPtr<ID3D11Texture2D> scratch;
+        XRC_CHECK_THROW_HRCMD(d3d11Device->CreateTexture2D(&scratchDesc, nullptr, &scratch));
+        UINT rowPitch = 0;
+        const void* texels = GetTexels(image, format, &rowPitch);
+        d3d11DeviceContext->UpdateSubresource(scratch.Get(), 0, nullptr, texels, rowPitch, 0);
+
+        D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc{};
+        srvDesc.Format = format;
+        srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+        srvDesc.Texture2D.MipLevels = scratchDesc.MipLevels;
+        ComPtr<ID3D11ShaderResourceView> srv;
+        XRC_CHECK_THROW_HRCMD(d3d11Device->CreateShaderResourceView(scratch.Get(), &srvDesc, &srv));
+        d3d11DeviceContext->GenerateMips(srv.Get());
+
+        for (UINT level = 0; level < destDesc.MipLevels; ++level) {
+            d3d11DeviceContext->CopySubresourceRegion(destTexture, D3D11CalcSubresource(level, arraySlice, destDesc.MipLevels), 0, 0, 0,
+                                                      scratch.Get(), level, nullptr);
+        }
+    }
+
+    std::future<RGBAImage> D3D11GraphicsPlugin::ReadbackSwapchainImage(const XrSwapchainImageBaseHeader* swapchainImage,
+                                                                       int64_t /*imageFormat*/, uint32_t arraySlice)
+    {
+        ID3D11Texture2D* const sourceTexture = reinterpret_cast<const XrSwapchainImageD3D11KHR*>(swapchainImage)->texture;
+
+        D3D11_TEXTURE2D_DESC sourceDesc;
+        sourceTexture->GetDesc(&sourceDesc);
+
+        D3D11_TEXTURE2D_DESC stagingDesc{};
+        stagingDesc.Width = sourceDesc.Width;
+        stagingDesc.Height = sourceDesc.Height;
+        stagingDesc.MipLevels = 1;
+        stagingDesc.ArraySize = 1;
+        stagingDesc.Format = sourceDesc.Format;
+        stagingDesc.SampleDesc.Count = 1;
+        stagingDesc.SampleDesc.Quality = 0;
+        stagingDesc.Usage = D3D11_USAGE_STAGING;
+        stagingDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+
+        ComPtr<ID3D11Texture2D> stagingTexture;
+        XRC_CHECK_THROW_HRCMD(d3d11Device->CreateTexture2D(&stagingDesc, nullptr, &stagingTexture));
+
+        const UINT sourceSubResource = D3D11CalcSubresource(0, arraySlice, sourceDesc.MipLevels);
+        d3d11DeviceContext->CopySubresourceRegion(stagingTexture.Get(), 0, 0 /* X */, 0 /* Y */, 0 /* Z */, sourceTexture, sourceSubResource,
+                                                  nullptr);
+
+        // Map blocks until the copy has finished, so leave it to whoever reads the result.
+        ComPtr<ID3D11DeviceContext> context = d3d11DeviceContext;
+        return std::async(std::launch::deferred, [context, stagingTexture, stagingDesc] {
+            D3D11_MAPPED_SUBRESOURCE mapped{};
+            XRC_CHECK_THROW_HRCMD(context->Map(stagingTexture.Get(), 0, D3D11_MAP_READ, 0, &mapped));
+
+            RGBAImage image(stagingDesc.Width, stagingDesc.Height);
+            const uint32_t imageRowPitch = image.width * sizeof(uint32_t);
+            for (int y = 0; y < image.height; ++y) {
+                memcpy(&image.pixels[y * image.width], reinterpret_cast<const uint8_t*>(mapped.pData) + y * mapped.RowPitch, imageRowPitch);
+            }
+
+            context->Unmap(stagingTexture.Get(), 0);
+            image.isSrgb = true;
+            return image;
+        });
     }
 
     std::string D3D11GraphicsPlugin::GetImageFormatName(int64_t imageFormat) const
@@ -565,6 +858,8 @@ namespace Conformance
     void D3D11GraphicsPlugin::ClearImageSlice(const XrSwapchainImageBaseHeader* colorSwapchainImage, uint32_t imageArrayIndex,
                                               int64_t colorSwapchainFormat)
     {
+        const GpuTimingScope timingScope(*this, "ClearImageSlice");
+
         ID3D11Texture2D* const colorTexture = reinterpret_cast<const XrSwapchainImageD3D11KHR*>(colorSwapchainImage)->texture;
 
         // Clear color buffer.
@@ -589,7 +884,246 @@ namespace Conformance
 
     void D3D11GraphicsPlugin::RenderView(const XrCompositionLayerProjectionView& layerView,
                                          const XrSwapchainImageBaseHeader* colorSwapchainImage, int64_t colorSwapchainFormat,
-                                         const std::vector<Cube>& cubes)
+                                         const std::vector<Cube>& sceneCubes)
+    {
+        RenderViewWithHiddenArea(layerView, colorSwapchainImage, colorSwapchainFormat, sceneCubes, nullptr);
+    }
+
+    bool D3D11GraphicsPlugin::RenderViewWithVisibilityMask(const XrCompositionLayerProjectionView& layerView,
+                                                           const XrSwapchainImageBaseHeader* colorSwapchainImage,
+                                                           int64_t colorSwapchainFormat, const VisibilityMask& hiddenArea,
+                                                           const std::vector<Cube>& sceneCubes)
+    {
+        BuildHiddenAreaVertices(hiddenArea, hiddenAreaVertices);
+        RenderViewWithHiddenArea(layerView, colorSwapchainImage, colorSwapchainFormat, sceneCubes, &hiddenAreaVertices);
+        return true;
+    }
+
+    void D3D11GraphicsPlugin::RenderViewWithHiddenArea(const XrCompositionLayerProjectionView& layerView,
+                                                       const XrSwapchainImageBaseHeader* colorSwapchainImage, int64_t colorSwapchainFormat,
+                                                       const std::vector<Cube>& sceneCubes,
+                                                       const std::vector<Geometry::PackedVertex>* hiddenArea)
+    {
+        XR_TRACE_SCOPE("D3D11GraphicsPlugin::RenderView");
+
+        const std::vector<Cube>& cubes = syntheticGpuLoad.Apply(&layerView, 1, sceneCubes);
+
+        const GpuTimingScope timingScope(*this, "RenderView");
+
+        ID3D11Texture2D* const colorTexture = reinterpret_cast<const XrSwapchainImageD3D11KHR*>(colorSwapchainImage)->texture;
+        if (renderSampleCount <= 1) {
+            const ComPtr<ID3D11Texture2D> depthStencilTexture = GetDepthStencilTexture(colorTexture);
+            RecordView(d3d11DeviceContext.Get(), immediateBuffers, layerView, colorTexture, depthStencilTexture.Get(), colorSwapchainFormat,
+                       DXGI_FORMAT_D32_FLOAT, m_projectionCache.Get(layerView.fov, DepthNearZ, DepthFarZ), cubes, hiddenArea);
+            return;
+        }
+
+        // Render into multisampled targets the size of the view, cleared as ClearImageSlice would, and resolve them into
+        // the view's rect of the swapchain image.
+        const XrRect2Di& rect = layerView.subImage.imageRect;
+        const DXGI_FORMAT colorFormat = (DXGI_FORMAT)colorSwapchainFormat;
+        MultisampleTargets& targets = GetMultisampleTargets(rect.extent.width, rect.extent.height, colorFormat);
+
+        ComPtr<ID3D11RenderTargetView> renderTargetView;
+        const CD3D11_RENDER_TARGET_VIEW_DESC renderTargetViewDesc(D3D11_RTV_DIMENSION_TEXTURE2DMS, colorFormat);
+        XRC_CHECK_THROW_HRCMD(
+            d3d11Device->CreateRenderTargetView(targets.color.Get(), &renderTargetViewDesc, renderTargetView.ReleaseAndGetAddressOf()));
+        d3d11DeviceContext->ClearRenderTargetView(renderTargetView.Get(), DirectX::Colors::DarkSlateGray);
+
+        ComPtr<ID3D11DepthStencilView> depthStencilView;
+        const CD3D11_DEPTH_STENCIL_VIEW_DESC depthStencilViewDesc(D3D11_DSV_DIMENSION_TEXTURE2DMS, DXGI_FORMAT_D32_FLOAT);
+        XRC_CHECK_THROW_HRCMD(
+            d3d11Device->CreateDepthStencilView(targets.depth.Get(), &depthStencilViewDesc, depthStencilView.ReleaseAndGetAddressOf()));
+        d3d11DeviceContext->ClearDepthStencilView(depthStencilView.Get(), D3D11_CLEAR_DEPTH, 1.0f, 0);
+
+        RecordView(d3d11DeviceContext.Get(), immediateBuffers, layerView, targets.color.Get(), targets.depth.Get(), colorSwapchainFormat,
+                   DXGI_FORMAT_D32_FLOAT, m_projectionCache.Get(layerView.fov, DepthNearZ, DepthFarZ), cubes, hiddenArea);
+
+        D3D11_TEXTURE2D_DESC colorDesc;
+        colorTexture->GetDesc(&colorDesc);
+        const UINT destSubresource = D3D11CalcSubresource(0, layerView.subImage.imageArrayIndex, colorDesc.MipLevels);
+        if (rect.offset.x == 0 && rect.offset.y == 0 && (UINT)rect.extent.width == colorDesc.Width &&
+            (UINT)rect.extent.height == colorDesc.Height) {
+            d3d11DeviceContext->ResolveSubresource(colorTexture, destSubresource, targets.color.Get(), 0, colorFormat);
+            return;
+        }
+
+        if (!targets.resolve) {
+            const CD3D11_TEXTURE2D_DESC resolveDesc(colorFormat, rect.extent.width, rect.extent.height, 1, 1, 0);
+            XRC_CHECK_THROW_HRCMD(d3d11Device->CreateTexture2D(&resolveDesc, nullptr, targets.resolve.ReleaseAndGetAddressOf()));
+        }
+        d3d11DeviceContext->ResolveSubresource(targets.resolve.Get(), 0, targets.color.Get(), 0, colorFormat);
+        d3d11DeviceContext->CopySubresourceRegion(colorTexture, destSubresource, rect.offset.x, rect.offset.y, 0, targets.resolve.Get(), 0,
+                                                  nullptr);
+    }
+
+    bool D3D11GraphicsPlugin::SetRenderSampleCount(uint32_t sampleCount)
+    {
+        if (sampleCount != 1) {
+            // Check the formats the plugin renders most views with.
+            UINT colorQualityLevels = 0;
+            UINT depthQualityLevels = 0;
+            if (!d3d11Device || sampleCount == 0 || sampleCount > D3D11_MAX_MULTISAMPLE_SAMPLE_COUNT ||
+                FAILED(d3d11Device->CheckMultisampleQualityLevels((DXGI_FORMAT)GetSRGBA8Format(), sampleCount, &colorQualityLevels)) ||
+                FAILED(d3d11Device->CheckMultisampleQualityLevels(DXGI_FORMAT_D32_FLOAT, sampleCount, &depthQualityLevels)) ||
+                colorQualityLevels == 0 || depthQualityLevels == 0) {
+                return false;
+            }
+        }
+
+        if (sampleCount != renderSampleCount) {
+            multisampleTargets.clear();
+            renderSampleCount = sampleCount;
+        }
+        return true;
+    }
+
+    D3D11GraphicsPlugin::MultisampleTargets& D3D11GraphicsPlugin::GetMultisampleTargets(UINT width, UINT height, DXGI_FORMAT colorFormat)
+    {
+        MultisampleTargets& targets = multisampleTargets[std::make_tuple(width, height, colorFormat)];
+        if (!targets.color) {
+            const CD3D11_TEXTURE2D_DESC colorDesc(colorFormat, width, height, 1, 1, D3D11_BIND_RENDER_TARGET, D3D11_USAGE_DEFAULT, 0,
+                                                  renderSampleCount, 0);
+            XRC_CHECK_THROW_HRCMD(d3d11Device->CreateTexture2D(&colorDesc, nullptr, targets.color.ReleaseAndGetAddressOf()));
+            const CD3D11_TEXTURE2D_DESC depthDesc(DXGI_FORMAT_D32_FLOAT, width, height, 1, 1, D3D11_BIND_DEPTH_STENCIL, D3D11_USAGE_DEFAULT,
+                                                  0, renderSampleCount, 0);
+            XRC_CHECK_THROW_HRCMD(d3d11Device->CreateTexture2D(&depthDesc, nullptr, targets.depth.ReleaseAndGetAddressOf()));
+        }
+        return targets;
+    }
+
+    bool D3D11GraphicsPlugin::RenderViewWithDepth(const XrCompositionLayerProjectionView& layerView,
+                                                  const XrSwapchainImageBaseHeader* colorSwapchainImage, int64_t colorSwapchainFormat,
+                                                  const XrSwapchainImageBaseHeader* depthSwapchainImage, int64_t depthSwapchainFormat,
+                                                  const std::vector<Cube>& sceneCubes)
+    {
+        const std::vector<Cube>& cubes = syntheticGpuLoad.Apply(&layerView, 1, sceneCubes);
+
+        const GpuTimingScope timingScope(*this, "RenderView");
+
+        ID3D11Texture2D* const colorTexture = reinterpret_cast<const XrSwapchainImageD3D11KHR*>(colorSwapchainImage)->texture;
+        ID3D11Texture2D* const depthTexture = reinterpret_cast<const XrSwapchainImageD3D11KHR*>(depthSwapchainImage)->texture;
+
+        // Depth swapchain formats are all depth-stencil formats, so the view can use the swapchain format as it is.
+        ComPtr<ID3D11DepthStencilView> depthStencilView;
+        const CD3D11_DEPTH_STENCIL_VIEW_DESC depthStencilViewDesc(D3D11_DSV_DIMENSION_TEXTURE2DARRAY, (DXGI_FORMAT)depthSwapchainFormat,
+                                                                  0 /* mipSlice */, layerView.subImage.imageArrayIndex, 1 /* arraySize */);
+        XRC_CHECK_THROW_HRCMD(d3d11Device->CreateDepthStencilView(depthTexture, &depthStencilViewDesc, depthStencilView.GetAddressOf()));
+        d3d11DeviceContext->ClearDepthStencilView(depthStencilView.Get(), D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
+
+        RecordView(d3d11DeviceContext.Get(), immediateBuffers, layerView, colorTexture, depthTexture, colorSwapchainFormat,
+                   (DXGI_FORMAT)depthSwapchainFormat, m_projectionCache.Get(layerView.fov, DepthNearZ, DepthFarZ), cubes);
+        return true;
+    }
+
+    void D3D11GraphicsPlugin::RenderViews(const XrCompositionLayerProjectionView* layerViews, uint32_t viewCount,
+                                          const XrSwapchainImageBaseHeader* colorSwapchainImage, int64_t colorSwapchainFormat,
+                                          const std::vector<Cube>& sceneCubes)
+    {
+        const uint32_t recordThreads = GetGlobalData().options.d3d11RecordThreads;
+        if (recordThreads <= 1 || viewCount <= 1 || singleThreadedDevice || renderSampleCount > 1) {
+            for (uint32_t i = 0; i < viewCount; ++i) {
+                RenderView(layerViews[i], colorSwapchainImage, colorSwapchainFormat, sceneCubes);
+            }
+            return;
+        }
+
+        const std::vector<Cube>& cubes = syntheticGpuLoad.Apply(layerViews, viewCount, sceneCubes);
+
+        if (!viewWorkers.IsRunning()) {
+            deferredContexts.resize(recordThreads);
+            for (DeferredViewContext& deferred : deferredContexts) {
+                XRC_CHECK_THROW_HRCMD(d3d11Device->CreateDeferredContext(0, deferred.context.ReleaseAndGetAddressOf()));
+                const CD3D11_BUFFER_DESC viewProjectionConstantBufferDesc(sizeof(ViewProjectionConstantBuffer), D3D11_BIND_CONSTANT_BUFFER,
+                                                                          D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE);
+                XRC_CHECK_THROW_HRCMD(d3d11Device->CreateBuffer(&viewProjectionConstantBufferDesc, nullptr,
+                                                                deferred.buffers.viewProjectionCBuffer.ReleaseAndGetAddressOf()));
+            }
+            viewWorkers.Start(recordThreads);
+        }
+
+        // The depth buffer map and the projection cache are not thread-safe, so both are looked up here.
+        ID3D11Texture2D* const colorTexture = reinterpret_cast<const XrSwapchainImageD3D11KHR*>(colorSwapchainImage)->texture;
+        const ComPtr<ID3D11Texture2D> depthStencilTexture = GetDepthStencilTexture(colorTexture);
+        viewProjectionMatrices.resize(viewCount);
+        for (uint32_t i = 0; i < viewCount; ++i) {
+            viewProjectionMatrices[i] = m_projectionCache.Get(layerViews[i].fov, DepthNearZ, DepthFarZ);
+        }
+
+        viewCommandLists.resize(viewCount);
+        viewWorkers.Run(viewCount, [&](uint32_t worker, uint32_t i) {
+            DeferredViewContext& deferred = deferredContexts[worker];
+            RecordView(deferred.context.Get(), deferred.buffers, layerViews[i], colorTexture, depthStencilTexture.Get(),
+                       colorSwapchainFormat, DXGI_FORMAT_D32_FLOAT, viewProjectionMatrices[i], cubes);
+            XRC_CHECK_THROW_HRCMD(deferred.context->FinishCommandList(FALSE, viewCommandLists[i].ReleaseAndGetAddressOf()));
+        });
+
+        // Every view sets all the state it draws with, so the immediate context's state need not be restored in between.
+        const GpuTimingScope timingScope(*this, "RenderView");
+        for (ComPtr<ID3D11CommandList>& commandList : viewCommandLists) {
+            d3d11DeviceContext->ExecuteCommandList(commandList.Get(), FALSE);
+            commandList.Reset();
+        }
+    }
+
+    void D3D11GraphicsPlugin::RenderScene(const XrCompositionLayerProjectionView* layerViews, uint32_t viewCount,
+                                          const XrSwapchainImageBaseHeader* colorSwapchainImage, int64_t colorSwapchainFormat,
+                                          CubeScene& scene)
+    {
+        // The synthetic load and multisampling change what is drawn per view, so they take the usual path.
+        D3D11CubeScene* const d3d11Scene = dynamic_cast<D3D11CubeScene*>(&scene);
+        if (d3d11Scene == nullptr || syntheticGpuLoad.GetLayerCount() != 0 || renderSampleCount > 1 || scene.GetCubes().empty()) {
+            RenderViews(layerViews, viewCount, colorSwapchainImage, colorSwapchainFormat, scene.GetCubes());
+            return;
+        }
+
+        XR_TRACE_SCOPE("D3D11GraphicsPlugin::RenderScene");
+
+        // Copy the model transforms of the changed cubes, or of all of them into a grown buffer.
+        const std::vector<Cube>& cubes = scene.GetCubes();
+        size_t changedBegin = 0;
+        size_t changedEnd = 0;
+        scene.TakeChangedRange(&changedBegin, &changedEnd);
+        const UINT instanceDataSize = (UINT)(sizeof(ModelInstanceData) * cubes.size());
+        if (d3d11Scene->instanceBufferCapacity < instanceDataSize) {
+            UINT capacity = std::max(d3d11Scene->instanceBufferCapacity, (UINT)(64 * sizeof(ModelInstanceData)));
+            while (capacity < instanceDataSize) {
+                capacity *= 2;
+            }
+            const CD3D11_BUFFER_DESC instanceBufferDesc(capacity, D3D11_BIND_VERTEX_BUFFER, D3D11_USAGE_DEFAULT);
+            XRC_CHECK_THROW_HRCMD(
+                d3d11Device->CreateBuffer(&instanceBufferDesc, nullptr, d3d11Scene->instanceBuffer.ReleaseAndGetAddressOf()));
+            d3d11Scene->instanceBufferCapacity = capacity;
+            changedBegin = 0;
+            changedEnd = cubes.size();
+        }
+        if (changedBegin != changedEnd) {
+            XrMatrix4x4f identity;
+            XrMatrix4x4f_CreateIdentity(&identity);
+            std::vector<XrMatrix4x4f>& modelMatrices = d3d11Scene->changedModelMatrices;
+            modelMatrices.resize(changedEnd - changedBegin);
+            ComputeMVPs(identity, &cubes[changedBegin], modelMatrices.size(), modelMatrices.data());
+            const D3D11_BOX box{(UINT)(sizeof(ModelInstanceData) * changedBegin), 0, 0, (UINT)(sizeof(ModelInstanceData) * changedEnd),
+                                1, 1};
+            d3d11DeviceContext->UpdateSubresource(d3d11Scene->instanceBuffer.Get(), 0, &box, modelMatrices.data(), 0, 0);
+        }
+
+        const GpuTimingScope timingScope(*this, "RenderView");
+        ID3D11Texture2D* const colorTexture = reinterpret_cast<const XrSwapchainImageD3D11KHR*>(colorSwapchainImage)->texture;
+        const ComPtr<ID3D11Texture2D> depthStencilTexture = GetDepthStencilTexture(colorTexture);
+        for (uint32_t i = 0; i < viewCount; ++i) {
+            RecordView(d3d11DeviceContext.Get(), immediateBuffers, layerViews[i], colorTexture, depthStencilTexture.Get(),
+                       colorSwapchainFormat, DXGI_FORMAT_D32_FLOAT, m_projectionCache.Get(layerViews[i].fov, DepthNearZ, DepthFarZ),
+                       cubes, nullptr, d3d11Scene->instanceBuffer.Get());
+        }
+    }
+
+    void D3D11GraphicsPlugin::RecordView(ID3D11DeviceContext* context, ViewBuffers& buffers,
+                                         const XrCompositionLayerProjectionView& layerView, ID3D11Texture2D* colorTexture,
+                                         ID3D11Texture2D* depthStencilTexture, int64_t colorSwapchainFormat,
+                                         DXGI_FORMAT depthStencilFormat, const XrMatrix4x4f& projectionMatrix,
+                                         const std::vector<Cube>& cubes, const std::vector<Geometry::PackedVertex>* hiddenArea,
+                                         ID3D11Buffer* sceneInstanceBuffer)
     {
         auto LoadXrPose = [](const XrPosef& pose) -> XMMATRIX {
             return XMMatrixAffineTransformation(DirectX::g_XMOne, DirectX::g_XMZero,
@@ -602,63 +1136,228 @@ namespace Conformance
             return XMLoadFloat4x4(reinterpret_cast<const XMFLOAT4X4*>(&matrix));
         };
 
-        ID3D11Texture2D* const colorTexture = reinterpret_cast<const XrSwapchainImageD3D11KHR*>(colorSwapchainImage)->texture;
+        // Multisampled targets are the size of the view, see RenderView.
+        D3D11_TEXTURE2D_DESC colorDesc;
+        colorTexture->GetDesc(&colorDesc);
+        const bool multisampled = colorDesc.SampleDesc.Count > 1;
 
-        CD3D11_VIEWPORT viewport((float)layerView.subImage.imageRect.offset.x, (float)layerView.subImage.imageRect.offset.y,
-                                 (float)layerView.subImage.imageRect.extent.width, (float)layerView.subImage.imageRect.extent.height);
-        d3d11DeviceContext->RSSetViewports(1, &viewport);
+        const XrRect2Di& rect = layerView.subImage.imageRect;
+        CD3D11_VIEWPORT viewport(multisampled ? 0.0f : (float)rect.offset.x, multisampled ? 0.0f : (float)rect.offset.y,
+                                 (float)rect.extent.width, (float)rect.extent.height);
+        context->RSSetViewports(1, &viewport);
 
         // Create RenderTargetView with original swapchain format (swapchain is typeless).
         ComPtr<ID3D11RenderTargetView> renderTargetView;
-        const CD3D11_RENDER_TARGET_VIEW_DESC renderTargetViewDesc(D3D11_RTV_DIMENSION_TEXTURE2DARRAY, (DXGI_FORMAT)colorSwapchainFormat,
-                                                                  0 /* mipSlice */, layerView.subImage.imageArrayIndex, 1 /* arraySize */);
+        const CD3D11_RENDER_TARGET_VIEW_DESC renderTargetViewDesc(
+            multisampled ? D3D11_RTV_DIMENSION_TEXTURE2DMS : D3D11_RTV_DIMENSION_TEXTURE2DARRAY, (DXGI_FORMAT)colorSwapchainFormat,
+            0 /* mipSlice */, layerView.subImage.imageArrayIndex, 1 /* arraySize */);
         XRC_CHECK_THROW_HRCMD(
             d3d11Device->CreateRenderTargetView(colorTexture, &renderTargetViewDesc, renderTargetView.ReleaseAndGetAddressOf()));
 
-        const ComPtr<ID3D11Texture2D> depthStencilTexture = GetDepthStencilTexture(colorTexture);
         ComPtr<ID3D11DepthStencilView> depthStencilView;
-        CD3D11_DEPTH_STENCIL_VIEW_DESC depthStencilViewDesc(D3D11_DSV_DIMENSION_TEXTURE2DARRAY, DXGI_FORMAT_D32_FLOAT, 0 /* mipSlice */,
-                                                            layerView.subImage.imageArrayIndex, 1 /* arraySize */);
+        CD3D11_DEPTH_STENCIL_VIEW_DESC depthStencilViewDesc(multisampled ? D3D11_DSV_DIMENSION_TEXTURE2DMS
+                                                                         : D3D11_DSV_DIMENSION_TEXTURE2DARRAY,
+                                                            depthStencilFormat, 0 /* mipSlice */, layerView.subImage.imageArrayIndex,
+                                                            1 /* arraySize */);
         XRC_CHECK_THROW_HRCMD(
-            d3d11Device->CreateDepthStencilView(depthStencilTexture.Get(), &depthStencilViewDesc, depthStencilView.GetAddressOf()));
+            d3d11Device->CreateDepthStencilView(depthStencilTexture, &depthStencilViewDesc, depthStencilView.GetAddressOf()));
 
         std::array<ID3D11RenderTargetView*, 1> renderTargets{{renderTargetView.Get()}};
-        d3d11DeviceContext->OMSetRenderTargets((UINT)renderTargets.size(), renderTargets.data(), depthStencilView.Get());
+        context->OMSetRenderTargets((UINT)renderTargets.size(), renderTargets.data(), depthStencilView.Get());
 
         const XMMATRIX spaceToView = XMMatrixInverse(nullptr, LoadXrPose(layerView.pose));
-        XrMatrix4x4f projectionMatrix;
-        XrMatrix4x4f_CreateProjectionFov(&projectionMatrix, GRAPHICS_D3D, layerView.fov, 0.05f, 100.0f);
 
         // Set shaders and constant buffers.
         ViewProjectionConstantBuffer viewProjection;
         XMStoreFloat4x4(&viewProjection.ViewProjection, XMMatrixTranspose(spaceToView * LoadXrMatrix(projectionMatrix)));
-        d3d11DeviceContext->UpdateSubresource(viewProjectionCBuffer.Get(), 0, nullptr, &viewProjection, 0, 0);
+        {
+            D3D11_MAPPED_SUBRESOURCE mapped{};
+            XRC_CHECK_THROW_HRCMD(context->Map(buffers.viewProjectionCBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped));
+            memcpy(mapped.pData, &viewProjection, sizeof(viewProjection));
+            context->Unmap(buffers.viewProjectionCBuffer.Get(), 0);
+        }
+
+        std::array<ID3D11Buffer*, 1> constantBuffers{{buffers.viewProjectionCBuffer.Get()}};
+        context->VSSetConstantBuffers(1, (UINT)constantBuffers.size(), constantBuffers.data());
+        context->VSSetShader(vertexShader.Get(), nullptr, 0);
+        context->PSSetShader(pixelShader.Get(), nullptr, 0);
 
-        std::array<ID3D11Buffer*, 2> constantBuffers{{modelCBuffer.Get(), viewProjectionCBuffer.Get()}};
-        d3d11DeviceContext->VSSetConstantBuffers(0, (UINT)constantBuffers.size(), constantBuffers.data());
-        d3d11DeviceContext->VSSetShader(vertexShader.Get(), nullptr, 0);
-        d3d11DeviceContext->PSSetShader(pixelShader.Get(), nullptr, 0);
+        // The hidden area is drawn as one more instance ahead of the cubes, placed at the view pose.
+        const UINT hiddenAreaInstances = (hiddenArea != nullptr && !hiddenArea->empty()) ? 1 : 0;
+        if (cubes.empty() && hiddenAreaInstances == 0) {
+            return;
+        }
+
+        if (sceneInstanceBuffer != nullptr) {
+            const UINT sceneStrides[] = {sizeof(Geometry::PackedVertex), sizeof(ModelInstanceData)};
+            const UINT sceneOffsets[] = {0, 0};
+            std::array<ID3D11Buffer*, 2> sceneBuffers{{cubeVertexBuffer.Get(), sceneInstanceBuffer}};
+            context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+            context->IASetInputLayout(inputLayout.Get());
+            context->IASetVertexBuffers(0, (UINT)sceneBuffers.size(), sceneBuffers.data(), sceneStrides, sceneOffsets);
+            context->IASetIndexBuffer(cubeIndexBuffer.Get(), DXGI_FORMAT_R16_UINT, 0);
+            const MeshRange& cube = GetSharedMeshes().cube;
+            context->DrawIndexedInstanced(cube.indexCount, (UINT)cubes.size(), cube.firstIndex, cube.baseVertex, 0);
+            return;
+        }
+
+        // Append every cube's model transform to the instance ring in one map, growing the ring if a single view does
+        // not fit in it.
+        const UINT instanceDataSize = (UINT)(sizeof(ModelInstanceData) * (cubes.size() + hiddenAreaInstances));
+        if (buffers.instanceBufferCapacity < instanceDataSize) {
+            const UINT minimumCapacity = 64 * 1024;
+            UINT capacity = std::max(buffers.instanceBufferCapacity, minimumCapacity);
+            while (capacity < instanceDataSize) {
+                capacity *= 2;
+            }
+            const CD3D11_BUFFER_DESC instanceBufferDesc(capacity, D3D11_BIND_VERTEX_BUFFER, D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE);
+            XRC_CHECK_THROW_HRCMD(d3d11Device->CreateBuffer(&instanceBufferDesc, nullptr, buffers.instanceBuffer.ReleaseAndGetAddressOf()));
+            buffers.instanceBufferCapacity = capacity;
+            buffers.instanceBufferOffset = capacity;  // Forces a discard below.
+        }
+        D3D11_MAP instanceMapType = D3D11_MAP_WRITE_NO_OVERWRITE;
+        if (context->GetType() != D3D11_DEVICE_CONTEXT_IMMEDIATE ||
+            buffers.instanceBufferCapacity - buffers.instanceBufferOffset < instanceDataSize) {
+            instanceMapType = D3D11_MAP_WRITE_DISCARD;
+            buffers.instanceBufferOffset = 0;
+        }
+        const UINT instanceOffset = buffers.instanceBufferOffset;
+        buffers.instanceBufferOffset += instanceDataSize;
+        {
+            D3D11_MAPPED_SUBRESOURCE mapped{};
+            XRC_CHECK_THROW_HRCMD(context->Map(buffers.instanceBuffer.Get(), 0, instanceMapType, 0, &mapped));
+            // The view-projection is applied by the shader, so the instance data holds just the model transforms.
+            // XrMatrix4x4f has the same memory layout as the XMFLOAT4X4 in ModelInstanceData.
+            static_assert(sizeof(ModelInstanceData) == sizeof(XrMatrix4x4f), "instance data must be a bare matrix");
+            XrMatrix4x4f identity;
+            XrMatrix4x4f_CreateIdentity(&identity);
+            auto* instances = reinterpret_cast<XrMatrix4x4f*>(static_cast<uint8_t*>(mapped.pData) + instanceOffset);
+            if (hiddenAreaInstances != 0) {
+                const Cube viewCube{layerView.pose, {1, 1, 1}};
+                ComputeMVPs(identity, &viewCube, 1, instances);
+            }
+            ComputeMVPs(identity, cubes, instances + hiddenAreaInstances);
+            context->Unmap(buffers.instanceBuffer.Get(), 0);
+        }
+
+        const UINT strides[] = {sizeof(Geometry::PackedVertex), sizeof(ModelInstanceData)};
+        const UINT offsets[] = {0, instanceOffset};
+        context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+        context->IASetInputLayout(inputLayout.Get());
+
+        // Draw the hidden area first, so that the depth test rejects the cubes behind it before they are shaded.
+        if (hiddenAreaInstances != 0) {
+            const UINT hiddenAreaSize = (UINT)(sizeof(Geometry::PackedVertex) * hiddenArea->size());
+            if (buffers.hiddenAreaVertexBufferCapacity < hiddenAreaSize) {
+                const CD3D11_BUFFER_DESC hiddenAreaBufferDesc(hiddenAreaSize, D3D11_BIND_VERTEX_BUFFER, D3D11_USAGE_DYNAMIC,
+                                                              D3D11_CPU_ACCESS_WRITE);
+                XRC_CHECK_THROW_HRCMD(
+                    d3d11Device->CreateBuffer(&hiddenAreaBufferDesc, nullptr, buffers.hiddenAreaVertexBuffer.ReleaseAndGetAddressOf()));
+                buffers.hiddenAreaVertexBufferCapacity = hiddenAreaSize;
+            }
+            D3D11_MAPPED_SUBRESOURCE mapped{};
+            XRC_CHECK_THROW_HRCMD(context->Map(buffers.hiddenAreaVertexBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped));
+            memcpy(mapped.pData, hiddenArea->data(), hiddenAreaSize);
+            context->Unmap(buffers.hiddenAreaVertexBuffer.Get(), 0);
+
+            std::array<ID3D11Buffer*, 2> hiddenAreaBuffers{{buffers.hiddenAreaVertexBuffer.Get(), buffers.instanceBuffer.Get()}};
+            context->IASetVertexBuffers(0, (UINT)hiddenAreaBuffers.size(), hiddenAreaBuffers.data(), strides, offsets);
+            context->DrawInstanced((UINT)hiddenArea->size(), 1, 0, 0);
+        }
+
+        if (cubes.empty()) {
+            return;
+        }
 
         // Set cube primitive data.
-        const UINT strides[] = {sizeof(Geometry::Vertex)};
-        const UINT offsets[] = {0};
-        std::array<ID3D11Buffer*, 1> vertexBuffers{{cubeVertexBuffer.Get()}};
-        d3d11DeviceContext->IASetVertexBuffers(0, (UINT)vertexBuffers.size(), vertexBuffers.data(), strides, offsets);
-        d3d11DeviceContext->IASetIndexBuffer(cubeIndexBuffer.Get(), DXGI_FORMAT_R16_UINT, 0);
-        d3d11DeviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-        d3d11DeviceContext->IASetInputLayout(inputLayout.Get());
-
-        // Render each cube
-        for (const Cube& cube : cubes) {
-            // Compute and update the model transform.
-            ModelConstantBuffer model;
-            XMStoreFloat4x4(&model.Model,
-                            XMMatrixTranspose(XMMatrixScaling(cube.Scale.x, cube.Scale.y, cube.Scale.z) * LoadXrPose(cube.Pose)));
-            d3d11DeviceContext->UpdateSubresource(modelCBuffer.Get(), 0, nullptr, &model, 0, 0);
-
-            // Draw the cube.
-            d3d11DeviceContext->DrawIndexed((UINT)Geometry::c_cubeIndices.size(), 0, 0);
+        std::array<ID3D11Buffer*, 2> vertexBuffers{{cubeVertexBuffer.Get(), buffers.instanceBuffer.Get()}};
+        context->IASetVertexBuffers(0, (UINT)vertexBuffers.size(), vertexBuffers.data(), strides, offsets);
+        context->IASetIndexBuffer(cubeIndexBuffer.Get(), DXGI_FORMAT_R16_UINT, 0);
+
+        // Draw all the cubes at once, after the hidden area's instance.
+        const MeshRange& cube = GetSharedMeshes().cube;
+        context->DrawIndexedInstanced(cube.indexCount, (UINT)cubes.size(), cube.firstIndex, cube.baseVertex, hiddenAreaInstances);
+    }
+
+    bool D3D11GraphicsPlugin::SetGpuTimingEnabled(bool enabled)
+    {
+        if (!enabled) {
+            gpuTimingEnabled = false;
+            return true;
+        }
+        if (!d3d11Device) {
+            return false;
+        }
+
+        if (timestampQueries.empty()) {
+            const D3D11_QUERY_DESC disjointDesc{D3D11_QUERY_TIMESTAMP_DISJOINT, 0};
+            const D3D11_QUERY_DESC timestampDesc{D3D11_QUERY_TIMESTAMP, 0};
+            std::vector<TimestampQueries> queries(TimestampPairCount);
+            for (TimestampQueries& pair : queries) {
+                XRC_CHECK_THROW_HRCMD(d3d11Device->CreateQuery(&disjointDesc, pair.disjoint.ReleaseAndGetAddressOf()));
+                XRC_CHECK_THROW_HRCMD(d3d11Device->CreateQuery(&timestampDesc, pair.begin.ReleaseAndGetAddressOf()));
+                XRC_CHECK_THROW_HRCMD(d3d11Device->CreateQuery(&timestampDesc, pair.end.ReleaseAndGetAddressOf()));
+            }
+            timestampQueries = std::move(queries);
+            timestampRing.Reset(TimestampPairCount);
+        }
+        gpuTimingEnabled = true;
+        return true;
+    }
+
+    D3D11GraphicsPlugin::GpuTimingScope::GpuTimingScope(D3D11GraphicsPlugin& plugin, const char* scope)
+        : plugin(plugin), pair(plugin.gpuTimingEnabled ? plugin.timestampRing.Begin(scope) : GpuTimestampRing::NoPair)
+    {
+        if (pair != GpuTimestampRing::NoPair) {
+            plugin.d3d11DeviceContext->Begin(plugin.timestampQueries[pair].disjoint.Get());
+            plugin.d3d11DeviceContext->End(plugin.timestampQueries[pair].begin.Get());
+        }
+    }
+
+    D3D11GraphicsPlugin::GpuTimingScope::~GpuTimingScope()
+    {
+        if (pair != GpuTimestampRing::NoPair) {
+            plugin.d3d11DeviceContext->End(plugin.timestampQueries[pair].end.Get());
+            plugin.d3d11DeviceContext->End(plugin.timestampQueries[pair].disjoint.Get());
+        }
+    }
+
+    void D3D11GraphicsPlugin::CollectGpuTimings(std::vector<GpuTimingSample>& samples)
+    {
+        if (timestampQueries.empty()) {
+            return;
+        }
+
+        timestampRing.Collect(
+            [&](uint32_t pair, int64_t* nanoseconds) {
+                const TimestampQueries& queries = timestampQueries[pair];
+                // DONOTFLUSH keeps GetData from submitting work; it returns S_FALSE until the results are in.
+                D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjoint{};
+                UINT64 begin = 0;
+                UINT64 end = 0;
+                const UINT flags = D3D11_ASYNC_GETDATA_DONOTFLUSH;
+                if (d3d11DeviceContext->GetData(queries.disjoint.Get(), &disjoint, sizeof(disjoint), flags) != S_OK ||
+                    d3d11DeviceContext->GetData(queries.begin.Get(), &begin, sizeof(begin), flags) != S_OK ||
+                    d3d11DeviceContext->GetData(queries.end.Get(), &end, sizeof(end), flags) != S_OK) {
+                    return GpuTimestampRing::ReadResult::NotReady;
+                }
+                if (disjoint.Disjoint || disjoint.Frequency == 0) {
+                    return GpuTimestampRing::ReadResult::Discarded;
+                }
+                *nanoseconds = int64_t(double(end - begin) * 1e9 / double(disjoint.Frequency));
+                return GpuTimestampRing::ReadResult::Ready;
+            },
+            samples);
+    }
+
+    bool D3D11GraphicsPlugin::GetGpuMemoryUsage(uint64_t* usedBytes) const
+    {
+        ComPtr<IDXGIDevice> dxgiDevice;
+        ComPtr<IDXGIAdapter> adapter;
+        if (!d3d11Device || FAILED(d3d11Device.As(&dxgiDevice)) || FAILED(dxgiDevice->GetAdapter(adapter.ReleaseAndGetAddressOf()))) {
+            return false;
         }
+        return GetDXGIAdapterLocalMemoryUsage(adapter.Get(), usedBytes);
     }
 
     std::shared_ptr<IGraphicsPlugin> CreateGraphicsPlugin_D3D11(std::shared_ptr<IPlatformPlugin> platformPlugin)
@@ -21,6 +21,9 @@
 #include "swapchain_parameters.h"
 #include "conformance_framework.h"
 #include "Geometry.h"
+#include "mesh_buffer.h"
+#include "projection_cache.h"
+#include "trace_scope.h"
 #include <windows.h>
 #include <wrl/client.h>  // For Microsoft::WRL::ComPtr
 #include <common/xr_linear.h>
@@ -29,6 +32,11 @@
 #include <openxr/openxr_platform.h>
 #include <algorithm>
 #include <array>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <tuple>
 #include <catch2/catch.hpp>
 
 #include "d3d_common.h"
@@ -59,6 +67,9 @@ namespace Conformance
             d3d12ResourceState = D3D12_RESOURCE_STATE_GENERIC_READ;
             size = AlignTo<D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT>(size);
         }
+        else if (heapType == D3D12_HEAP_TYPE_READBACK) {
+            d3d12ResourceState = D3D12_RESOURCE_STATE_COPY_DEST;
+        }
         else {
             d3d12ResourceState = D3D12_RESOURCE_STATE_COMMON;
         }
@@ -88,6 +99,192 @@ namespace Conformance
         return buffer;
     }
 
+    // A readback buffer and the fence value after which its contents are valid. Waits for the copy when destroyed, so
+    // dropping an unread readback future does not release the buffer while the GPU still writes to it.
+    struct PendingReadback
+    {
+        ComPtr<ID3D12Fence> fence;
+        uint64_t fenceValue = 0;
+        ComPtr<ID3D12Resource> buffer;
+
+        ~PendingReadback()
+        {
+            if (fence) {
+                Wait();
+            }
+        }
+
+        void Wait() const
+        {
+            // A null event makes SetEventOnCompletion block until the fence is reached.
+            if (fence->GetCompletedValue() < fenceValue) {
+                fence->SetEventOnCompletion(fenceValue, nullptr);
+            }
+        }
+    };
+
+    // A persistently mapped upload heap that hands out short-lived sub-allocations, for data that is written by the
+    // CPU and read once by the GPU: image uploads, per-view constants and cube instances.
+    //
+    // Allocations are carved linearly out of fixed-size pages. A page that fills up is retired with the fence value of
+    // the last submission that used it and is rewound for reuse once the GPU has passed that value. Allocations larger
+    // than a page get a page of their own, which is reused the same way. In steady state no resources are created.
+    class UploadAllocator
+    {
+    public:
+        struct Allocation
+        {
+            ID3D12Resource* resource;
+            uint64_t offset;
+            uint8_t* cpuAddress;
+            D3D12_GPU_VIRTUAL_ADDRESS gpuAddress;
+        };
+
+        void Init(ID3D12Device* device, ID3D12Fence* fence)
+        {
+            m_device = device;
+            m_fence = fence;
+        }
+
+        // The caller must have waited for the GPU to finish every submission that used an allocation.
+        void Reset()
+        {
+            m_pages.clear();
+            m_currentPage = NoPage;
+            m_device = nullptr;
+            m_fence = nullptr;
+        }
+
+        // The allocation is valid for the command lists executed up to the next call to OnExecute.
+        Allocation Allocate(uint64_t size, uint64_t alignment)
+        {
+            if (size > PageSize) {
+                Page& page = GetFreePage(size);
+                page.offset = size;
+                return {page.resource.Get(), 0, page.cpuAddress, page.resource->GetGPUVirtualAddress()};
+            }
+
+            if (m_currentPage != NoPage) {
+                Page& page = m_pages[m_currentPage];
+                const uint64_t offset = (page.offset + alignment - 1) & ~(alignment - 1);
+                if (offset + size <= page.size) {
+                    page.offset = offset + size;
+                    page.usedSinceExecute = true;
+                    return {page.resource.Get(), offset, page.cpuAddress + offset, page.resource->GetGPUVirtualAddress() + offset};
+                }
+                page.current = false;  // Full. Becomes free once the submissions using it complete.
+            }
+
+            Page& page = GetFreePage(PageSize);
+            page.current = true;
+            m_currentPage = static_cast<size_t>(&page - m_pages.data());
+            page.offset = size;
+            return {page.resource.Get(), 0, page.cpuAddress, page.resource->GetGPUVirtualAddress()};
+        }
+
+        // Called after every command list submission, with the fence value signaled after it.
+        void OnExecute(uint64_t fenceValue)
+        {
+            for (Page& page : m_pages) {
+                if (page.usedSinceExecute) {
+                    page.fenceValue = fenceValue;
+                    page.usedSinceExecute = false;
+                }
+            }
+        }
+
+    private:
+        static constexpr uint64_t PageSize = 4 * 1024 * 1024;
+        static constexpr size_t NoPage = SIZE_MAX;
+
+        struct Page
+        {
+            ComPtr<ID3D12Resource> resource;
+            uint8_t* cpuAddress = nullptr;
+            uint64_t size = 0;
+            uint64_t offset = 0;
+            uint64_t fenceValue = 0;
+            bool usedSinceExecute = false;
+            bool current = false;
+        };
+
+        // Returns a rewound page of at least minSize bytes that the GPU is done with, creating one if needed.
+        Page& GetFreePage(uint64_t minSize)
+        {
+            const uint64_t completedValue = m_fence->GetCompletedValue();
+            for (Page& page : m_pages) {
+                if (!page.current && !page.usedSinceExecute && page.fenceValue <= completedValue && page.size >= minSize) {
+                    page.offset = 0;
+                    page.usedSinceExecute = true;
+                    return page;
+                }
+            }
+
+            Page page;
+            page.size = (minSize + 0xFFFF) & ~uint64_t(0xFFFF);  // Upload heaps are allocated in 64KB pages anyway.
+            page.resource = CreateBuffer(m_device, (uint32_t)page.size, D3D12_HEAP_TYPE_UPLOAD);
+            const D3D12_RANGE readRange{0, 0};
+            // Upload heap resources may stay mapped for their whole lifetime.
+            XRC_CHECK_THROW_HRCMD(page.resource->Map(0, &readRange, reinterpret_cast<void**>(&page.cpuAddress)));
+            page.usedSinceExecute = true;
+            m_pages.push_back(std::move(page));
+            return m_pages.back();
+        }
+
+        ID3D12Device* m_device{nullptr};
+        ID3D12Fence* m_fence{nullptr};
+        std::vector<Page> m_pages;
+        size_t m_currentPage{NoPage};
+    };
+
+    // Hands out CPU descriptors of one type, for render target and depth stencil views, from heaps of PageSize
+    // descriptors that are created as needed and reused through a free list. Those views are read when commands are
+    // recorded, not when they execute, so a freed descriptor can be handed out again right away.
+    class CpuDescriptorAllocator
+    {
+    public:
+        CpuDescriptorAllocator(ID3D12Device* device, D3D12_DESCRIPTOR_HEAP_TYPE type)
+            : m_device(device), m_type(type), m_increment(device->GetDescriptorHandleIncrementSize(type))
+        {
+        }
+
+        D3D12_CPU_DESCRIPTOR_HANDLE Allocate()
+        {
+            if (m_free.empty()) {
+                D3D12_DESCRIPTOR_HEAP_DESC heapDesc{};
+                heapDesc.NumDescriptors = PageSize;
+                heapDesc.Type = m_type;
+                heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+                ComPtr<ID3D12DescriptorHeap> heap;
+                XRC_CHECK_THROW_HRCMD(m_device->CreateDescriptorHeap(&heapDesc, __uuidof(ID3D12DescriptorHeap),
+                                                                     reinterpret_cast<void**>(heap.ReleaseAndGetAddressOf())));
+                const D3D12_CPU_DESCRIPTOR_HANDLE start = heap->GetCPUDescriptorHandleForHeapStart();
+                for (UINT i = PageSize; i > 0; --i) {
+                    m_free.push_back({start.ptr + SIZE_T(i - 1) * m_increment});
+                }
+                m_heaps.push_back(std::move(heap));
+            }
+
+            const D3D12_CPU_DESCRIPTOR_HANDLE handle = m_free.back();
+            m_free.pop_back();
+            return handle;
+        }
+
+        void Free(D3D12_CPU_DESCRIPTOR_HANDLE handle)
+        {
+            m_free.push_back(handle);
+        }
+
+    private:
+        static constexpr UINT PageSize = 64;
+
+        ID3D12Device* m_device;
+        const D3D12_DESCRIPTOR_HEAP_TYPE m_type;
+        const UINT m_increment;
+        std::vector<ComPtr<ID3D12DescriptorHeap>> m_heaps;
+        std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> m_free;
+    };
+
     struct D3D12GraphicsPlugin : public IGraphicsPlugin
     {
         D3D12GraphicsPlugin(std::shared_ptr<IPlatformPlugin>);
@@ -114,6 +311,9 @@ namespace Conformance
         void CopyRGBAImage(const XrSwapchainImageBaseHeader* swapchainImage, int64_t imageFormat, uint32_t arraySlice,
                            const RGBAImage& image) override;
 
+        std::future<RGBAImage> ReadbackSwapchainImage(const XrSwapchainImageBaseHeader* swapchainImage, int64_t imageFormat,
+                                                      uint32_t arraySlice) override;
+
         std::string GetImageFormatName(int64_t imageFormat) const override;
 
         bool IsImageFormatKnown(int64_t imageFormat) const override;
@@ -141,13 +341,41 @@ namespace Conformance
         void RenderView(const XrCompositionLayerProjectionView& layerView, const XrSwapchainImageBaseHeader* colorSwapchainImage,
                         int64_t colorSwapchainFormat, const std::vector<Cube>& cubes) override;
 
-    protected:
-        D3D12_CPU_DESCRIPTOR_HANDLE CreateRenderTargetView(ID3D12Resource* colorTexture, uint32_t imageArrayIndex,
-                                                           int64_t colorSwapchainFormat);
-        D3D12_CPU_DESCRIPTOR_HANDLE CreateDepthStencilView(ID3D12Resource* depthStencilTexture, uint32_t imageArrayIndex);
+        void RenderViews(const XrCompositionLayerProjectionView* layerViews, uint32_t viewCount,
+                         const XrSwapchainImageBaseHeader* colorSwapchainImage, int64_t colorSwapchainFormat,
+                         const std::vector<Cube>& cubes) override;
+
+        bool SetGpuTimingEnabled(bool enabled) override;
+
+        void CollectGpuTimings(std::vector<GpuTimingSample>& samples) override;
+
+        bool SetSyntheticGpuLoad(uint32_t layerCount) override
+        {
+            syntheticGpuLoad.SetLayerCount(layerCount);
+            return true;
+        }
 
+        bool GetGpuMemoryUsage(uint64_t* usedBytes) const override;
+
+    protected:
         struct D3D12SwapchainImageStructs : public IGraphicsPlugin::SwapchainImageStructs
         {
+            ~D3D12SwapchainImageStructs() override
+            {
+                // Submissions are not waited for, so the last command lists recorded here may still be using the
+                // allocator and depth texture. A null event makes SetEventOnCompletion block until the fence is reached.
+                if (fence && fence->GetCompletedValue() < fenceValue) {
+                    fence->SetEventOnCompletion(fenceValue, nullptr);
+                }
+
+                for (const auto& view : renderTargetViews) {
+                    rtvAllocator->Free(view.second);
+                }
+                for (const auto& view : depthStencilViews) {
+                    dsvAllocator->Free(view.second);
+                }
+            }
+
             std::vector<XrSwapchainImageBaseHeader*> Create(ID3D12Device* device, uint32_t capacity)
             {
                 d3d12Device = device;
@@ -162,8 +390,6 @@ namespace Conformance
                     d3d12Device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, __uuidof(ID3D12CommandAllocator),
                                                         reinterpret_cast<void**>(commandAllocator.ReleaseAndGetAddressOf())));
 
-                viewProjectionCBuffer = CreateBuffer(d3d12Device, sizeof(ViewProjectionConstantBuffer), D3D12_HEAP_TYPE_UPLOAD);
-
                 return bases;
             }
 
@@ -193,7 +419,7 @@ namespace Conformance
                     depthDesc.DepthOrArraySize = colorDesc.DepthOrArraySize;
                     depthDesc.MipLevels = 1;
                     depthDesc.Format = DXGI_FORMAT_R32_TYPELESS;
-                    depthDesc.SampleDesc.Count = 1;
+                    depthDesc.SampleDesc.Count = colorDesc.SampleDesc.Count;
                     depthDesc.Layout = colorDesc.Layout;
                     depthDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
 
@@ -228,40 +454,52 @@ namespace Conformance
                 XRC_CHECK_THROW_HRCMD(commandAllocator->Reset());
             }
 
-            void RequestModelCBuffer(uint32_t requiredSize)
-            {
-                if (!modelCBuffer || (requiredSize > modelCBuffer->GetDesc().Width)) {
-                    modelCBuffer = CreateBuffer(d3d12Device, requiredSize, D3D12_HEAP_TYPE_UPLOAD);
-                }
-            }
-
-            ID3D12Resource* GetModelCBuffer() const
-            {
-                return modelCBuffer.Get();
-            }
-
-            ID3D12Resource* GetViewProjectionCBuffer() const
-            {
-                return viewProjectionCBuffer.Get();
-            }
-
             std::vector<XrSwapchainImageD3D12KHR> imageVector;
 
             ID3D12Device* d3d12Device{nullptr};
             ComPtr<ID3D12CommandAllocator> commandAllocator;
             ComPtr<ID3D12Resource> depthStencilTexture;
-            ComPtr<ID3D12Resource> modelCBuffer;
-            ComPtr<ID3D12Resource> viewProjectionCBuffer;
+            ComPtr<ID3D12Fence> fence;  // The plugin's queue fence, which fenceValue refers to.
             uint64_t fenceValue = 0;
+
+            // Views of the swapchain images and of the depth texture, keyed on (resource, array slice, view format), see
+            // GetRenderTargetView and GetDepthStencilView. Their descriptors go back to the allocators with the swapchain.
+            using ViewKey = std::tuple<ID3D12Resource*, uint32_t, DXGI_FORMAT>;
+            std::shared_ptr<CpuDescriptorAllocator> rtvAllocator;
+            std::shared_ptr<CpuDescriptorAllocator> dsvAllocator;
+            std::map<ViewKey, D3D12_CPU_DESCRIPTOR_HANDLE> renderTargetViews;
+            std::map<ViewKey, D3D12_CPU_DESCRIPTOR_HANDLE> depthStencilViews;
         };
 
-        ID3D12PipelineState* GetOrCreatePipelineState(DXGI_FORMAT swapchainFormat);
+        // Returns the view of one array slice of a swapchain image or of its depth texture, creating it on first use.
+        D3D12_CPU_DESCRIPTOR_HANDLE GetRenderTargetView(D3D12SwapchainImageStructs& swapchainContext, ID3D12Resource* colorTexture,
+                                                        uint32_t imageArrayIndex, int64_t colorSwapchainFormat);
+        D3D12_CPU_DESCRIPTOR_HANDLE GetDepthStencilView(D3D12SwapchainImageStructs& swapchainContext, ID3D12Resource* depthStencilTexture,
+                                                        uint32_t imageArrayIndex);
+
+        // Pipeline states are keyed on (render target format, depth stencil format, sample count), and are loaded from
+        // and stored into pipelineLibrary where there is one.
+        using PipelineStateKey = std::tuple<DXGI_FORMAT, DXGI_FORMAT, UINT>;
+        ID3D12PipelineState* GetOrCreatePipelineState(DXGI_FORMAT swapchainFormat, DXGI_FORMAT depthStencilFormat, UINT sampleCount);
+        void CreatePipelineLibrary();
+        void SavePipelineLibrary();
         bool ExecuteCommandList(ID3D12CommandList* cmdList) const;
         void CpuWaitForFence(uint64_t fenceVal) const;
         void WaitForGpu() const;
 
+        // Writes the begin timestamp of a timing scope into a command list. Returns the pair to pass to EndGpuTiming, or
+        // GpuTimestampRing::NoPair if the scope is not measured.
+        uint32_t BeginGpuTiming(ID3D12GraphicsCommandList* cmdList, const char* scope);
+        // Writes the end timestamp and resolves the pair into the readback buffer. The list must be the next one executed.
+        void EndGpuTiming(ID3D12GraphicsCommandList* cmdList, uint32_t pair);
+
         D3D12SwapchainImageStructs& GetSwapchainImageContext(const XrSwapchainImageBaseHeader* swapchainImage);
 
+        // Records the draw of the cubes into one view of the swapchain image. Does not close or submit the list.
+        void RecordView(ID3D12GraphicsCommandList* cmdList, D3D12SwapchainImageStructs& swapchainContext,
+                        const XrCompositionLayerProjectionView& layerView, const XrSwapchainImageBaseHeader* colorSwapchainImage,
+                        int64_t colorSwapchainFormat, const std::vector<Cube>& cubes);
+
     protected:
         bool initialized = false;
         XrGraphicsBindingD3D12KHR graphicsBinding{XR_TYPE_GRAPHICS_BINDING_D3D12_KHR};
@@ -275,15 +513,35 @@ namespace Conformance
         std::map<const XrSwapchainImageBaseHeader*, D3D12SwapchainImageStructs*> swapchainImageContextMap;
         const XrSwapchainImageBaseHeader* lastSwapchainImage = nullptr;
 
+        mutable UploadAllocator uploadAllocator;
+        ProjectionCache<GRAPHICS_D3D> m_projectionCache;
+
         // Resources needed for rendering cubes
         const ComPtr<ID3DBlob> vertexShaderBytes;
         const ComPtr<ID3DBlob> pixelShaderBytes;
         ComPtr<ID3D12RootSignature> rootSignature;
-        std::map<DXGI_FORMAT, ComPtr<ID3D12PipelineState>> pipelineStates;
+        std::map<PipelineStateKey, ComPtr<ID3D12PipelineState>> pipelineStates;
+        // Null where ID3D12Device1 is not available. The library reads its pipelines out of pipelineLibraryData, which
+        // must outlive it, and is serialized back into it on ShutdownDevice; Options::d3d12PipelineLibraryFile keeps it
+        // across runs.
+        ComPtr<ID3D12PipelineLibrary> pipelineLibrary;
+        std::vector<uint8_t> pipelineLibraryData;
         ComPtr<ID3D12Resource> cubeVertexBuffer;
         ComPtr<ID3D12Resource> cubeIndexBuffer;
-        ComPtr<ID3D12DescriptorHeap> rtvHeap;
-        ComPtr<ID3D12DescriptorHeap> dsvHeap;
+        // Shared with the swapchain image structs, which may outlive the device and free their views into them.
+        std::shared_ptr<CpuDescriptorAllocator> rtvAllocator;
+        std::shared_ptr<CpuDescriptorAllocator> dsvAllocator;
+
+        // GPU timing: the query heap holds a begin and an end timestamp for each pair of the ring, resolved into the
+        // readback buffer at the same offsets. A pair can be read once the fence reaches its value in timestampFenceValues.
+        static constexpr uint32_t TimestampPairCount = 256;
+        ComPtr<ID3D12QueryHeap> timestampQueryHeap;
+        ComPtr<ID3D12Resource> timestampReadbackBuffer;
+        std::vector<uint64_t> timestampFenceValues;
+        GpuTimestampRing timestampRing;
+        uint64_t timestampFrequency = 0;
+        bool gpuTimingEnabled = false;
+        SyntheticGpuLoad syntheticGpuLoad;
     };
 
     D3D12GraphicsPlugin::D3D12GraphicsPlugin(std::shared_ptr<IPlatformPlugin>)
@@ -389,32 +647,15 @@ namespace Conformance
             XRC_CHECK_THROW_HRCMD(d3d12Device->CreateCommandQueue(&queueDesc, __uuidof(ID3D12CommandQueue),
                                                                   reinterpret_cast<void**>(d3d12CmdQueue.ReleaseAndGetAddressOf())));
 
-            {
-                D3D12_DESCRIPTOR_HEAP_DESC heapDesc{};
-                heapDesc.NumDescriptors = 1;
-                heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
-                heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-                XRC_CHECK_THROW_HRCMD(d3d12Device->CreateDescriptorHeap(&heapDesc, __uuidof(ID3D12DescriptorHeap),
-                                                                        reinterpret_cast<void**>(rtvHeap.ReleaseAndGetAddressOf())));
-            }
-            {
-                D3D12_DESCRIPTOR_HEAP_DESC heapDesc{};
-                heapDesc.NumDescriptors = 1;
-                heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
-                heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-                XRC_CHECK_THROW_HRCMD(d3d12Device->CreateDescriptorHeap(&heapDesc, __uuidof(ID3D12DescriptorHeap),
-                                                                        reinterpret_cast<void**>(dsvHeap.ReleaseAndGetAddressOf())));
-            }
+            rtvAllocator = std::make_shared<CpuDescriptorAllocator>(d3d12Device.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+            dsvAllocator = std::make_shared<CpuDescriptorAllocator>(d3d12Device.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_DSV);
 
-            D3D12_ROOT_PARAMETER rootParams[2];
+            // Model transforms arrive as per-instance vertex data, so only the view-projection needs a root parameter.
+            D3D12_ROOT_PARAMETER rootParams[1];
             rootParams[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
-            rootParams[0].Descriptor.ShaderRegister = 0;
+            rootParams[0].Descriptor.ShaderRegister = 1;
             rootParams[0].Descriptor.RegisterSpace = 0;
             rootParams[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_VERTEX;
-            rootParams[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
-            rootParams[1].Descriptor.ShaderRegister = 1;
-            rootParams[1].Descriptor.RegisterSpace = 0;
-            rootParams[1].ShaderVisibility = D3D12_SHADER_VISIBILITY_VERTEX;
 
             D3D12_ROOT_SIGNATURE_DESC rootSignatureDesc{};
             rootSignatureDesc.NumParameters = (UINT)ArraySize(rootParams);
@@ -430,6 +671,8 @@ namespace Conformance
                                                                    rootSignatureBlob->GetBufferSize(), __uuidof(ID3D12RootSignature),
                                                                    reinterpret_cast<void**>(rootSignature.ReleaseAndGetAddressOf())));
 
+            CreatePipelineLibrary();
+
             D3D12SwapchainImageStructs initializeContext;
             std::vector<XrSwapchainImageBaseHeader*> _ = initializeContext.Create(d3d12Device.Get(), 1);
 
@@ -437,49 +680,40 @@ namespace Conformance
                                                            reinterpret_cast<void**>(fence.ReleaseAndGetAddressOf())));
             fenceEvent = ::CreateEvent(nullptr, FALSE, FALSE, nullptr);
             CHECK(fenceEvent != nullptr);
+            uploadAllocator.Init(d3d12Device.Get(), fence.Get());
 
             ComPtr<ID3D12GraphicsCommandList> cmdList;
             XRC_CHECK_THROW_HRCMD(d3d12Device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, initializeContext.GetCommandAllocator(),
                                                                  nullptr, __uuidof(ID3D12GraphicsCommandList),
                                                                  reinterpret_cast<void**>(cmdList.ReleaseAndGetAddressOf())));
 
+            const MeshBuffer& meshes = GetSharedMeshes().buffer;
             ComPtr<ID3D12Resource> cubeVertexBufferUpload;
-            cubeVertexBuffer =
-                CreateBuffer(d3d12Device.Get(), (uint32_t)(Geometry::c_cubeVertices.size() * sizeof(Geometry::c_cubeVertices[0])),
-                             D3D12_HEAP_TYPE_DEFAULT);
+            cubeVertexBuffer = CreateBuffer(d3d12Device.Get(), (uint32_t)meshes.VertexBytes(), D3D12_HEAP_TYPE_DEFAULT);
             {
-                cubeVertexBufferUpload =
-                    CreateBuffer(d3d12Device.Get(), (uint32_t)(Geometry::c_cubeVertices.size() * sizeof(Geometry::c_cubeVertices[0])),
-                                 D3D12_HEAP_TYPE_UPLOAD);
+                cubeVertexBufferUpload = CreateBuffer(d3d12Device.Get(), (uint32_t)meshes.VertexBytes(), D3D12_HEAP_TYPE_UPLOAD);
 
                 void* data;
                 const D3D12_RANGE readRange{0, 0};
                 XRC_CHECK_THROW_HRCMD(cubeVertexBufferUpload->Map(0, &readRange, &data));
-                memcpy(data, Geometry::c_cubeVertices.data(),
-                       (uint32_t)(Geometry::c_cubeVertices.size() * sizeof(Geometry::c_cubeVertices[0])));
+                memcpy(data, meshes.Vertices().data(), meshes.VertexBytes());
                 cubeVertexBufferUpload->Unmap(0, nullptr);
 
-                cmdList->CopyBufferRegion(cubeVertexBuffer.Get(), 0, cubeVertexBufferUpload.Get(), 0,
-                                          Geometry::c_cubeVertices.size() * sizeof(Geometry::c_cubeVertices[0]));
+                cmdList->CopyBufferRegion(cubeVertexBuffer.Get(), 0, cubeVertexBufferUpload.Get(), 0, meshes.VertexBytes());
             }
 
             ComPtr<ID3D12Resource> cubeIndexBufferUpload;
-            cubeIndexBuffer =
-                CreateBuffer(d3d12Device.Get(), (uint32_t)(Geometry::c_cubeIndices.size() * sizeof(Geometry::c_cubeIndices[0])),
-                             D3D12_HEAP_TYPE_DEFAULT);
+            cubeIndexBuffer = CreateBuffer(d3d12Device.Get(), (uint32_t)meshes.IndexBytes(), D3D12_HEAP_TYPE_DEFAULT);
             {
-                cubeIndexBufferUpload =
-                    CreateBuffer(d3d12Device.Get(), (uint32_t)(Geometry::c_cubeIndices.size() * sizeof(Geometry::c_cubeIndices[0])),
-                                 D3D12_HEAP_TYPE_UPLOAD);
+                cubeIndexBufferUpload = CreateBuffer(d3d12Device.Get(), (uint32_t)meshes.IndexBytes(), D3D12_HEAP_TYPE_UPLOAD);
 
                 void* data;
                 const D3D12_RANGE readRange{0, 0};
                 XRC_CHECK_THROW_HRCMD(cubeIndexBufferUpload->Map(0, &readRange, &data));
-                memcpy(data, Geometry::c_cubeIndices.data(), Geometry::c_cubeIndices.size() * sizeof(Geometry::c_cubeIndices[0]));
+                memcpy(data, meshes.Indices().data(), meshes.IndexBytes());
                 cubeIndexBufferUpload->Unmap(0, nullptr);
 
-                cmdList->CopyBufferRegion(cubeIndexBuffer.Get(), 0, cubeIndexBufferUpload.Get(), 0,
-                                          Geometry::c_cubeIndices.size() * sizeof(Geometry::c_cubeIndices[0]));
+                cmdList->CopyBufferRegion(cubeIndexBuffer.Get(), 0, cubeIndexBufferUpload.Get(), 0, meshes.IndexBytes());
             }
 
             XRC_CHECK_THROW_HRCMD(cmdList->Close());
@@ -501,6 +735,19 @@ namespace Conformance
 
     void D3D12GraphicsPlugin::ShutdownDevice()
     {
+        // Work is no longer waited for as it is submitted, so let it finish before releasing what it uses.
+        if (fence && fenceEvent != INVALID_HANDLE_VALUE) {
+            WaitForGpu();
+        }
+        uploadAllocator.Reset();
+
+        timestampQueryHeap.Reset();
+        timestampReadbackBuffer.Reset();
+        timestampFenceValues.clear();
+        timestampRing.Reset(0);
+        gpuTimingEnabled = false;
+        syntheticGpuLoad.SetLayerCount(0);
+
         graphicsBinding = XrGraphicsBindingD3D12KHR{XR_TYPE_GRAPHICS_BINDING_D3D12_KHR};
         d3d12CmdQueue.Reset();
         fence.Reset();
@@ -510,19 +757,22 @@ namespace Conformance
         }
         rootSignature.Reset();
         pipelineStates.clear();
+        SavePipelineLibrary();
         cubeVertexBuffer.Reset();
         cubeIndexBuffer.Reset();
-        rtvHeap.Reset();
-        dsvHeap.Reset();
+        rtvAllocator.reset();
+        dsvAllocator.reset();
         swapchainImageContextMap.clear();
 
         d3d12Device.Reset();
         lastSwapchainImage = nullptr;
     }
 
-    void D3D12GraphicsPlugin::CopyRGBAImage(const XrSwapchainImageBaseHeader* swapchainImage, int64_t /*imageFormat*/, uint32_t arraySlice,
+    void D3D12GraphicsPlugin::CopyRGBAImage(const XrSwapchainImageBaseHeader* swapchainImage, int64_t imageFormat, uint32_t arraySlice,
                                             const RGBAImage& image)
     {
+        XR_TRACE_SCOPE("D3D12GraphicsPlugin::CopyRGBAImage");
+
         D3D12_HEAP_PROPERTIES heapProp{};
         heapProp.Type = D3D12_HEAP_TYPE_DEFAULT;
         heapProp.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
@@ -531,26 +781,27 @@ namespace Conformance
         ID3D12Resource* const destTexture = reinterpret_cast<const XrSwapchainImageD3D12KHR*>(swapchainImage)->texture;
         const D3D12_RESOURCE_DESC rgbaImageDesc = destTexture->GetDesc();
 
-        D3D12_PLACED_SUBRESOURCE_FOOTPRINT layout;
+        // Swapchains with mip levels get a chain filtered on the CPU, uploaded next to level 0 and copied in the same list.
+        // The footprints of the levels of slice 0 are those of every other slice.
+        const UINT mipCount = rgbaImageDesc.MipLevels;
+        std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts(mipCount);
         uint64_t requiredSize = 0;
-        uint64_t rowSizeInBytes = 0;
-        d3d12Device->GetCopyableFootprints(&rgbaImageDesc, 0, 1, 0, &layout, nullptr, &rowSizeInBytes, &requiredSize);
+        d3d12Device->GetCopyableFootprints(&rgbaImageDesc, 0, mipCount, 0, layouts.data(), nullptr, nullptr, &requiredSize);
 
-        ComPtr<ID3D12Resource> uploadBuffer = CreateBuffer(d3d12Device.Get(), (uint32_t)(requiredSize), D3D12_HEAP_TYPE_UPLOAD);
+        // Written in the texel layout of the swapchain format, which the copy does not convert.
+        const RGBATexelLayout texelLayout = GetDxgiRGBATexelLayout((DXGI_FORMAT)imageFormat);
+        const UploadAllocator::Allocation upload = uploadAllocator.Allocate(requiredSize, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
         {
-            const uint8_t* src = reinterpret_cast<const uint8_t*>(image.pixels.data());
-            const uint32_t imageRowPitch = image.width * sizeof(uint32_t);
-            uint8_t* dst;
-            const D3D12_RANGE readRange{0, 0};
-            XRC_CHECK_THROW_HRCMD(uploadBuffer->Map(0, &readRange, reinterpret_cast<void**>(&dst)));
-            for (int y = 0; y < image.height; ++y) {
-                memcpy(dst, src, imageRowPitch);
-
-                src += imageRowPitch;
-                dst += layout.Footprint.RowPitch;
+            const RGBAImage* levelImage = &image;
+            RGBAImage downsampled(0, 0);
+            for (UINT level = 0; level < mipCount; ++level) {
+                if (level > 0) {
+                    downsampled = levelImage->Downsampled();
+                    levelImage = &downsampled;
+                }
+                WriteRGBATexels(*levelImage, texelLayout, upload.cpuAddress + layouts[level].Offset, layouts[level].Footprint.RowPitch);
+                layouts[level].Offset += upload.offset;
             }
-            const D3D12_RANGE writeRange{0, (SIZE_T)requiredSize};
-            uploadBuffer->Unmap(0, &writeRange);
         }
 
         auto& swapchainContext = GetSwapchainImageContext(swapchainImage);
@@ -560,22 +811,98 @@ namespace Conformance
                                                              nullptr, __uuidof(ID3D12GraphicsCommandList),
                                                              reinterpret_cast<void**>(cmdList.ReleaseAndGetAddressOf())));
 
+        const uint32_t timingPair = BeginGpuTiming(cmdList.Get(), "CopyRGBAImage");
+        for (UINT level = 0; level < mipCount; ++level) {
+            D3D12_TEXTURE_COPY_LOCATION srcLocation;
+            srcLocation.pResource = upload.resource;
+            srcLocation.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+            srcLocation.PlacedFootprint = layouts[level];
+
+            D3D12_TEXTURE_COPY_LOCATION dstLocation;
+            dstLocation.pResource = destTexture;
+            dstLocation.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+            dstLocation.SubresourceIndex = D3D11CalcSubresource(level, arraySlice, mipCount);
+
+            cmdList->CopyTextureRegion(&dstLocation, 0 /* X */, 0 /* Y */, 0 /* Z */, &srcLocation, nullptr);
+        }
+        EndGpuTiming(cmdList.Get(), timingPair);
+
+        XRC_CHECK_THROW_HRCMD(cmdList->Close());
+        CHECK(ExecuteCommandList(cmdList.Get()));
+        swapchainContext.SetFrameFenceValue(fenceValue);
+    }
+
+    std::future<RGBAImage> D3D12GraphicsPlugin::ReadbackSwapchainImage(const XrSwapchainImageBaseHeader* swapchainImage,
+                                                                       int64_t /*imageFormat*/, uint32_t arraySlice)
+    {
+        ID3D12Resource* const sourceTexture = reinterpret_cast<const XrSwapchainImageD3D12KHR*>(swapchainImage)->texture;
+        const D3D12_RESOURCE_DESC sourceDesc = sourceTexture->GetDesc();
+        const UINT sourceSubresource = D3D11CalcSubresource(0, arraySlice, sourceDesc.MipLevels);
+
+        D3D12_PLACED_SUBRESOURCE_FOOTPRINT layout;
+        uint64_t requiredSize = 0;
+        d3d12Device->GetCopyableFootprints(&sourceDesc, sourceSubresource, 1, 0, &layout, nullptr, nullptr, &requiredSize);
+
+        // Each readback gets its own buffer so the results can be read in any order.
+        ComPtr<ID3D12Resource> readbackBuffer = CreateBuffer(d3d12Device.Get(), (uint32_t)requiredSize, D3D12_HEAP_TYPE_READBACK);
+
+        auto& swapchainContext = GetSwapchainImageContext(swapchainImage);
+
+        ComPtr<ID3D12GraphicsCommandList> cmdList;
+        XRC_CHECK_THROW_HRCMD(d3d12Device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, swapchainContext.GetCommandAllocator(),
+                                                             nullptr, __uuidof(ID3D12GraphicsCommandList),
+                                                             reinterpret_cast<void**>(cmdList.ReleaseAndGetAddressOf())));
+
+        // Acquired swapchain images are in the render target state and must be returned to it before release.
+        D3D12_RESOURCE_BARRIER barrier{};
+        barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+        barrier.Transition.pResource = sourceTexture;
+        barrier.Transition.Subresource = sourceSubresource;
+        barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_RENDER_TARGET;
+        barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_COPY_SOURCE;
+        cmdList->ResourceBarrier(1, &barrier);
+
         D3D12_TEXTURE_COPY_LOCATION srcLocation;
-        srcLocation.pResource = uploadBuffer.Get();
-        srcLocation.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
-        srcLocation.PlacedFootprint = layout;
+        srcLocation.pResource = sourceTexture;
+        srcLocation.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+        srcLocation.SubresourceIndex = sourceSubresource;
 
         D3D12_TEXTURE_COPY_LOCATION dstLocation;
-        dstLocation.pResource = destTexture;
-        dstLocation.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
-        dstLocation.SubresourceIndex = D3D11CalcSubresource(0, arraySlice, rgbaImageDesc.MipLevels);
+        dstLocation.pResource = readbackBuffer.Get();
+        dstLocation.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+        dstLocation.PlacedFootprint = layout;
 
         cmdList->CopyTextureRegion(&dstLocation, 0 /* X */, 0 /* Y */, 0 /* Z */, &srcLocation, nullptr);
 
+        std::swap(barrier.Transition.StateBefore, barrier.Transition.StateAfter);
+        cmdList->ResourceBarrier(1, &barrier);
+
         XRC_CHECK_THROW_HRCMD(cmdList->Close());
         CHECK(ExecuteCommandList(cmdList.Get()));
+        swapchainContext.SetFrameFenceValue(fenceValue);
 
-        WaitForGpu();
+        auto readback = std::make_shared<PendingReadback>();
+        readback->fence = fence;
+        readback->fenceValue = fenceValue;
+        readback->buffer = readbackBuffer;
+        return std::async(std::launch::deferred, [readback, layout] {
+            readback->Wait();
+
+            void* data = nullptr;
+            XRC_CHECK_THROW_HRCMD(readback->buffer->Map(0, nullptr, &data));
+
+            RGBAImage image((int)layout.Footprint.Width, (int)layout.Footprint.Height);
+            const uint32_t imageRowPitch = image.width * sizeof(uint32_t);
+            for (int y = 0; y < image.height; ++y) {
+                memcpy(&image.pixels[y * image.width], reinterpret_cast<const uint8_t*>(data) + layout.Offset + y * layout.Footprint.RowPitch,
+                       imageRowPitch);
+            }
+
+            const D3D12_RANGE writtenRange{0, 0};
+            readback->buffer->Unmap(0, &writtenRange);
+            image.isSrgb = true;
+            return image;
+        });
     }
 
     std::string D3D12GraphicsPlugin::GetImageFormatName(int64_t imageFormat) const
@@ -707,6 +1034,8 @@ namespace Conformance
         ++fenceValue;
         XRC_CHECK_THROW_HRCMD(d3d12CmdQueue->Signal(fence.Get(), fenceValue));
 
+        uploadAllocator.OnExecute(fenceValue);
+
         return success;
     }
 
@@ -819,8 +1148,11 @@ namespace Conformance
         // Map every swapchainImage base pointer to this context
         for (auto& base : bases) {
             derivedResult->imagePtrVector.push_back(base);
+            derivedResult->fence = fence;
             swapchainImageContextMap[base] = derivedResult.get();
         }
+        derivedResult->rtvAllocator = rtvAllocator;
+        derivedResult->dsvAllocator = dsvAllocator;
 
         // Cast our derived type to the caller-expected type.
         std::shared_ptr<SwapchainImageStructs> result =
@@ -829,13 +1161,21 @@ namespace Conformance
         return result;
     }
 
-    D3D12_CPU_DESCRIPTOR_HANDLE D3D12GraphicsPlugin::CreateRenderTargetView(ID3D12Resource* colorTexture, uint32_t imageArrayIndex,
-                                                                            int64_t colorSwapchainFormat)
+    D3D12_CPU_DESCRIPTOR_HANDLE D3D12GraphicsPlugin::GetRenderTargetView(D3D12SwapchainImageStructs& swapchainContext,
+                                                                         ID3D12Resource* colorTexture, uint32_t imageArrayIndex,
+                                                                         int64_t colorSwapchainFormat)
     {
+        const D3D12SwapchainImageStructs::ViewKey key{colorTexture, imageArrayIndex, (DXGI_FORMAT)colorSwapchainFormat};
+        auto it = swapchainContext.renderTargetViews.find(key);
+        if (it != swapchainContext.renderTargetViews.end()) {
+            return it->second;
+        }
+
         const D3D12_RESOURCE_DESC colorTextureDesc = colorTexture->GetDesc();
 
         // Create RenderTargetView with original swapchain format (swapchain is typeless).
-        D3D12_CPU_DESCRIPTOR_HANDLE renderTargetView = rtvHeap->GetCPUDescriptorHandleForHeapStart();
+        const D3D12_CPU_DESCRIPTOR_HANDLE renderTargetView = swapchainContext.rtvAllocator->Allocate();
+        swapchainContext.renderTargetViews.emplace(key, renderTargetView);
         D3D12_RENDER_TARGET_VIEW_DESC renderTargetViewDesc{};
         renderTargetViewDesc.Format = (DXGI_FORMAT)colorSwapchainFormat;
         if (colorTextureDesc.DepthOrArraySize > 1) {
@@ -863,11 +1203,19 @@ namespace Conformance
         return renderTargetView;
     }
 
-    D3D12_CPU_DESCRIPTOR_HANDLE D3D12GraphicsPlugin::CreateDepthStencilView(ID3D12Resource* depthStencilTexture, uint32_t imageArrayIndex)
+    D3D12_CPU_DESCRIPTOR_HANDLE D3D12GraphicsPlugin::GetDepthStencilView(D3D12SwapchainImageStructs& swapchainContext,
+                                                                         ID3D12Resource* depthStencilTexture, uint32_t imageArrayIndex)
     {
+        const D3D12SwapchainImageStructs::ViewKey key{depthStencilTexture, imageArrayIndex, DXGI_FORMAT_D32_FLOAT};
+        auto it = swapchainContext.depthStencilViews.find(key);
+        if (it != swapchainContext.depthStencilViews.end()) {
+            return it->second;
+        }
+
         const D3D12_RESOURCE_DESC depthStencilTextureDesc = depthStencilTexture->GetDesc();
 
-        D3D12_CPU_DESCRIPTOR_HANDLE depthStencilView = dsvHeap->GetCPUDescriptorHandleForHeapStart();
+        const D3D12_CPU_DESCRIPTOR_HANDLE depthStencilView = swapchainContext.dsvAllocator->Allocate();
+        swapchainContext.depthStencilViews.emplace(key, depthStencilView);
         D3D12_DEPTH_STENCIL_VIEW_DESC depthStencilViewDesc{};
         depthStencilViewDesc.Format = DXGI_FORMAT_D32_FLOAT;
         if (depthStencilTextureDesc.DepthOrArraySize > 1) {
@@ -908,142 +1256,294 @@ namespace Conformance
                                                              nullptr, __uuidof(ID3D12GraphicsCommandList),
                                                              reinterpret_cast<void**>(cmdList.ReleaseAndGetAddressOf())));
 
+        const uint32_t timingPair = BeginGpuTiming(cmdList.Get(), "ClearImageSlice");
+
         // Clear color buffer.
-        D3D12_CPU_DESCRIPTOR_HANDLE renderTargetView = CreateRenderTargetView(colorTexture, imageArrayIndex, colorSwapchainFormat);
+        D3D12_CPU_DESCRIPTOR_HANDLE renderTargetView =
+            GetRenderTargetView(swapchainContext, colorTexture, imageArrayIndex, colorSwapchainFormat);
         // TODO: Do not clear to a color when using a pass-through view configuration.
         cmdList->ClearRenderTargetView(renderTargetView, DirectX::Colors::DarkSlateGray, 0, nullptr);
 
         // Clear depth buffer.
         ID3D12Resource* depthStencilTexture = swapchainContext.GetDepthStencilTexture(colorTexture);
-        D3D12_CPU_DESCRIPTOR_HANDLE depthStencilView = CreateDepthStencilView(depthStencilTexture, imageArrayIndex);
+        D3D12_CPU_DESCRIPTOR_HANDLE depthStencilView = GetDepthStencilView(swapchainContext, depthStencilTexture, imageArrayIndex);
         cmdList->ClearDepthStencilView(depthStencilView, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
 
+        EndGpuTiming(cmdList.Get(), timingPair);
+
         XRC_CHECK_THROW_HRCMD(cmdList->Close());
         CHECK(ExecuteCommandList(cmdList.Get()));
+        swapchainContext.SetFrameFenceValue(fenceValue);
+    }
+
+    void D3D12GraphicsPlugin::RecordView(ID3D12GraphicsCommandList* cmdList, D3D12SwapchainImageStructs& swapchainContext,
+                                         const XrCompositionLayerProjectionView& layerView,
+                                         const XrSwapchainImageBaseHeader* colorSwapchainImage, int64_t colorSwapchainFormat,
+                                         const std::vector<Cube>& cubes)
+    {
+        ID3D12Resource* const colorTexture = reinterpret_cast<const XrSwapchainImageD3D12KHR*>(colorSwapchainImage)->texture;
+        const D3D12_RESOURCE_DESC colorTextureDesc = colorTexture->GetDesc();
+
+        ID3D12PipelineState* pipelineState =
+            GetOrCreatePipelineState((DXGI_FORMAT)colorSwapchainFormat, DXGI_FORMAT_D32_FLOAT, colorTextureDesc.SampleDesc.Count);
+        cmdList->SetPipelineState(pipelineState);
+        cmdList->SetGraphicsRootSignature(rootSignature.Get());
+
+        const D3D12_VIEWPORT viewport = {(float)layerView.subImage.imageRect.offset.x,
+                                         (float)layerView.subImage.imageRect.offset.y,
+                                         (float)layerView.subImage.imageRect.extent.width,
+                                         (float)layerView.subImage.imageRect.extent.height,
+                                         0,
+                                         1};
+        cmdList->RSSetViewports(1, &viewport);
+
+        const D3D12_RECT scissorRect = {layerView.subImage.imageRect.offset.x, layerView.subImage.imageRect.offset.y,
+                                        layerView.subImage.imageRect.offset.x + layerView.subImage.imageRect.extent.width,
+                                        layerView.subImage.imageRect.offset.y + layerView.subImage.imageRect.extent.height};
+        cmdList->RSSetScissorRects(1, &scissorRect);
+
+        // Create RenderTargetView with original swapchain format (swapchain is typeless).
+        D3D12_CPU_DESCRIPTOR_HANDLE renderTargetView =
+            GetRenderTargetView(swapchainContext, colorTexture, layerView.subImage.imageArrayIndex, colorSwapchainFormat);
+
+        ID3D12Resource* depthStencilTexture = swapchainContext.GetDepthStencilTexture(colorTexture);
+        D3D12_CPU_DESCRIPTOR_HANDLE depthStencilView =
+            GetDepthStencilView(swapchainContext, depthStencilTexture, layerView.subImage.imageArrayIndex);
+
+        D3D12_CPU_DESCRIPTOR_HANDLE renderTargets[] = {renderTargetView};
+        cmdList->OMSetRenderTargets((UINT)ArraySize(renderTargets), renderTargets, true, &depthStencilView);
+
+        const XMMATRIX spaceToView = XMMatrixInverse(nullptr, LoadXrPose(layerView.pose));
+        const XrMatrix4x4f& projectionMatrix = m_projectionCache.Get(layerView.fov, DepthNearZ, DepthFarZ);
+
+        // Set shaders and constant buffers.
+        // Each view gets its own constants and instances, so recording the next view cannot overwrite the data
+        // of one the GPU has not drawn yet.
+        const UploadAllocator::Allocation viewProjectionCBuffer =
+            uploadAllocator.Allocate(sizeof(ViewProjectionConstantBuffer), D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+        ViewProjectionConstantBuffer viewProjection;
+        XMStoreFloat4x4(&viewProjection.ViewProjection, XMMatrixTranspose(spaceToView * LoadXrMatrix(projectionMatrix)));
+        memcpy(viewProjectionCBuffer.cpuAddress, &viewProjection, sizeof(viewProjection));
+
+        cmdList->SetGraphicsRootConstantBufferView(0, viewProjectionCBuffer.gpuAddress);
+
+        // Write every cube's model transform into the instance data.
+        const uint32_t instanceDataSize = static_cast<uint32_t>(sizeof(ModelInstanceData) * cubes.size());
+        const UploadAllocator::Allocation instanceBuffer = uploadAllocator.Allocate(instanceDataSize, alignof(ModelInstanceData));
+        {
+            // The view-projection is applied by the shader, so the instance data holds just the model transforms.
+            // XrMatrix4x4f has the same memory layout as the XMFLOAT4X4 in ModelInstanceData.
+            static_assert(sizeof(ModelInstanceData) == sizeof(XrMatrix4x4f), "instance data must be a bare matrix");
+            XrMatrix4x4f identity;
+            XrMatrix4x4f_CreateIdentity(&identity);
+            ComputeMVPs(identity, cubes, reinterpret_cast<XrMatrix4x4f*>(instanceBuffer.cpuAddress));
+        }
+
+        // Set cube primitive data.
+        const SharedMeshes& meshes = GetSharedMeshes();
+        const D3D12_VERTEX_BUFFER_VIEW vertexBufferView[] = {
+            {cubeVertexBuffer->GetGPUVirtualAddress(), (uint32_t)meshes.buffer.VertexBytes(), sizeof(Geometry::PackedVertex)},
+            {instanceBuffer.gpuAddress, instanceDataSize, sizeof(ModelInstanceData)}};
+        cmdList->IASetVertexBuffers(0, (UINT)ArraySize(vertexBufferView), vertexBufferView);
+
+        D3D12_INDEX_BUFFER_VIEW indexBufferView{cubeIndexBuffer->GetGPUVirtualAddress(), (uint32_t)meshes.buffer.IndexBytes(),
+                                                DXGI_FORMAT_R16_UINT};
+        cmdList->IASetIndexBuffer(&indexBufferView);
+
+        cmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+        // Draw all the cubes at once.
+        cmdList->DrawIndexedInstanced(meshes.cube.indexCount, (uint32_t)cubes.size(), meshes.cube.firstIndex, meshes.cube.baseVertex, 0);
     }
 
     void D3D12GraphicsPlugin::RenderView(const XrCompositionLayerProjectionView& layerView,
                                          const XrSwapchainImageBaseHeader* colorSwapchainImage, int64_t colorSwapchainFormat,
                                          const std::vector<Cube>& cubes)
     {
+        XR_TRACE_SCOPE("D3D12GraphicsPlugin::RenderView");
+
+        RenderViews(&layerView, 1, colorSwapchainImage, colorSwapchainFormat, cubes);
+    }
+
+    void D3D12GraphicsPlugin::RenderViews(const XrCompositionLayerProjectionView* layerViews, uint32_t viewCount,
+                                          const XrSwapchainImageBaseHeader* colorSwapchainImage, int64_t colorSwapchainFormat,
+                                          const std::vector<Cube>& sceneCubes)
+    {
+        const std::vector<Cube>& cubes = syntheticGpuLoad.Apply(layerViews, viewCount, sceneCubes);
+
         auto& swapchainContext = GetSwapchainImageContext(colorSwapchainImage);
 
-        if (!cubes.empty()) {
+        if (!cubes.empty() && viewCount > 0) {
             ComPtr<ID3D12GraphicsCommandList> cmdList;
             XRC_CHECK_THROW_HRCMD(d3d12Device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, swapchainContext.GetCommandAllocator(),
                                                                  nullptr, __uuidof(ID3D12GraphicsCommandList),
                                                                  reinterpret_cast<void**>(cmdList.ReleaseAndGetAddressOf())));
 
-            ID3D12PipelineState* pipelineState = GetOrCreatePipelineState((DXGI_FORMAT)colorSwapchainFormat);
-            cmdList->SetPipelineState(pipelineState);
-            cmdList->SetGraphicsRootSignature(rootSignature.Get());
-
-            ID3D12Resource* const colorTexture = reinterpret_cast<const XrSwapchainImageD3D12KHR*>(colorSwapchainImage)->texture;
-            const D3D12_RESOURCE_DESC colorTextureDesc = colorTexture->GetDesc();
+            // All views go into one command list and one submission.
+            const uint32_t timingPair = BeginGpuTiming(cmdList.Get(), "RenderView");
+            for (uint32_t i = 0; i < viewCount; ++i) {
+                RecordView(cmdList.Get(), swapchainContext, layerViews[i], colorSwapchainImage, colorSwapchainFormat, cubes);
+            }
+            EndGpuTiming(cmdList.Get(), timingPair);
 
-            const D3D12_VIEWPORT viewport = {(float)layerView.subImage.imageRect.offset.x,
-                                             (float)layerView.subImage.imageRect.offset.y,
-                                             (float)layerView.subImage.imageRect.extent.width,
-                                             (float)layerView.subImage.imageRect.extent.height,
-                                             0,
-                                             1};
-            cmdList->RSSetViewports(1, &viewport);
+            XRC_CHECK_THROW_HRCMD(cmdList->Close());
+            CHECK(ExecuteCommandList(cmdList.Get()));
+            swapchainContext.SetFrameFenceValue(fenceValue);
+        }
+    }
 
-            const D3D12_RECT scissorRect = {layerView.subImage.imageRect.offset.x, layerView.subImage.imageRect.offset.y,
-                                            layerView.subImage.imageRect.offset.x + layerView.subImage.imageRect.extent.width,
-                                            layerView.subImage.imageRect.offset.y + layerView.subImage.imageRect.extent.height};
-            cmdList->RSSetScissorRects(1, &scissorRect);
+    bool D3D12GraphicsPlugin::SetGpuTimingEnabled(bool enabled)
+    {
+        if (!enabled) {
+            gpuTimingEnabled = false;
+            return true;
+        }
+        if (!d3d12Device || !d3d12CmdQueue) {
+            return false;
+        }
 
-            // Create RenderTargetView with original swapchain format (swapchain is typeless).
-            D3D12_CPU_DESCRIPTOR_HANDLE renderTargetView =
-                CreateRenderTargetView(colorTexture, layerView.subImage.imageArrayIndex, colorSwapchainFormat);
+        if (!timestampQueryHeap) {
+            // GetTimestampFrequency fails on queues that do not support timestamps.
+            if (FAILED(d3d12CmdQueue->GetTimestampFrequency(&timestampFrequency)) || timestampFrequency == 0) {
+                return false;
+            }
 
-            ID3D12Resource* depthStencilTexture = swapchainContext.GetDepthStencilTexture(colorTexture);
-            D3D12_CPU_DESCRIPTOR_HANDLE depthStencilView = CreateDepthStencilView(depthStencilTexture, layerView.subImage.imageArrayIndex);
+            D3D12_QUERY_HEAP_DESC queryHeapDesc{};
+            queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+            queryHeapDesc.Count = TimestampPairCount * 2;
+            XRC_CHECK_THROW_HRCMD(d3d12Device->CreateQueryHeap(&queryHeapDesc, __uuidof(ID3D12QueryHeap),
+                                                               reinterpret_cast<void**>(timestampQueryHeap.ReleaseAndGetAddressOf())));
+            timestampReadbackBuffer = CreateBuffer(d3d12Device.Get(), TimestampPairCount * 2 * sizeof(uint64_t), D3D12_HEAP_TYPE_READBACK);
+            timestampFenceValues.assign(TimestampPairCount, 0);
+            timestampRing.Reset(TimestampPairCount);
+        }
+        gpuTimingEnabled = true;
+        return true;
+    }
 
-            D3D12_CPU_DESCRIPTOR_HANDLE renderTargets[] = {renderTargetView};
-            cmdList->OMSetRenderTargets((UINT)ArraySize(renderTargets), renderTargets, true, &depthStencilView);
+    uint32_t D3D12GraphicsPlugin::BeginGpuTiming(ID3D12GraphicsCommandList* cmdList, const char* scope)
+    {
+        if (!gpuTimingEnabled) {
+            return GpuTimestampRing::NoPair;
+        }
+        const uint32_t pair = timestampRing.Begin(scope);
+        if (pair != GpuTimestampRing::NoPair) {
+            cmdList->EndQuery(timestampQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, pair * 2);
+        }
+        return pair;
+    }
 
-            const XMMATRIX spaceToView = XMMatrixInverse(nullptr, LoadXrPose(layerView.pose));
-            XrMatrix4x4f projectionMatrix;
-            XrMatrix4x4f_CreateProjectionFov(&projectionMatrix, GRAPHICS_D3D, layerView.fov, 0.05f, 100.0f);
+    void D3D12GraphicsPlugin::EndGpuTiming(ID3D12GraphicsCommandList* cmdList, uint32_t pair)
+    {
+        if (pair == GpuTimestampRing::NoPair) {
+            return;
+        }
+        cmdList->EndQuery(timestampQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, pair * 2 + 1);
+        cmdList->ResolveQueryData(timestampQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, pair * 2, 2, timestampReadbackBuffer.Get(),
+                                  pair * 2 * sizeof(uint64_t));
+        // ExecuteCommandList signals the next fence value right after submitting this list.
+        timestampFenceValues[pair] = fenceValue + 1;
+    }
 
-            // Set shaders and constant buffers.
-            ID3D12Resource* viewProjectionCBuffer = swapchainContext.GetViewProjectionCBuffer();
-            ViewProjectionConstantBuffer viewProjection;
-            XMStoreFloat4x4(&viewProjection.ViewProjection, XMMatrixTranspose(spaceToView * LoadXrMatrix(projectionMatrix)));
-            {
-                void* data;
-                const D3D12_RANGE readRange{0, 0};
-                XRC_CHECK_THROW_HRCMD(viewProjectionCBuffer->Map(0, &readRange, &data));
-                memcpy(data, &viewProjection, sizeof(viewProjection));
-                viewProjectionCBuffer->Unmap(0, nullptr);
-            }
+    void D3D12GraphicsPlugin::CollectGpuTimings(std::vector<GpuTimingSample>& samples)
+    {
+        if (!timestampQueryHeap) {
+            return;
+        }
 
-            cmdList->SetGraphicsRootConstantBufferView(1, viewProjectionCBuffer->GetGPUVirtualAddress());
-
-            // Set cube primitive data.
-            const D3D12_VERTEX_BUFFER_VIEW vertexBufferView[] = {
-                {cubeVertexBuffer->GetGPUVirtualAddress(),
-                 (uint32_t)(Geometry::c_cubeVertices.size() * sizeof(Geometry::c_cubeVertices[0])), sizeof(Geometry::Vertex)}};
-            cmdList->IASetVertexBuffers(0, (UINT)ArraySize(vertexBufferView), vertexBufferView);
-
-            D3D12_INDEX_BUFFER_VIEW indexBufferView{cubeIndexBuffer->GetGPUVirtualAddress(),
-                                                    (uint32_t)(Geometry::c_cubeIndices.size() * sizeof(Geometry::c_cubeIndices[0])),
-                                                    DXGI_FORMAT_R16_UINT};
-            cmdList->IASetIndexBuffer(&indexBufferView);
-
-            cmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-
-            constexpr uint32_t cubeCBufferSize = AlignTo<D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT>(sizeof(ModelConstantBuffer));
-            swapchainContext.RequestModelCBuffer(static_cast<uint32_t>(cubeCBufferSize * cubes.size()));
-            ID3D12Resource* modelCBuffer = swapchainContext.GetModelCBuffer();
-
-            // Render each cube
-            uint32_t offset = 0;
-            for (const Cube& cube : cubes) {
-                // Compute and update the model transform.
-                ModelConstantBuffer model;
-                XMStoreFloat4x4(&model.Model,
-                                XMMatrixTranspose(XMMatrixScaling(cube.Scale.x, cube.Scale.y, cube.Scale.z) * LoadXrPose(cube.Pose)));
-                {
-                    uint8_t* data;
-                    const D3D12_RANGE readRange{0, 0};
-                    XRC_CHECK_THROW_HRCMD(modelCBuffer->Map(0, &readRange, reinterpret_cast<void**>(&data)));
-                    memcpy(data + offset, &model, sizeof(model));
-                    const D3D12_RANGE writeRange{offset, offset + cubeCBufferSize};
-                    modelCBuffer->Unmap(0, &writeRange);
+        const uint64_t completedValue = fence->GetCompletedValue();
+        timestampRing.Collect(
+            [&](uint32_t pair, int64_t* nanoseconds) {
+                if (timestampFenceValues[pair] > completedValue) {
+                    return GpuTimestampRing::ReadResult::NotReady;
                 }
+                const D3D12_RANGE readRange{pair * 2 * sizeof(uint64_t), (pair * 2 + 2) * sizeof(uint64_t)};
+                void* data = nullptr;
+                XRC_CHECK_THROW_HRCMD(timestampReadbackBuffer->Map(0, &readRange, &data));
+                const uint64_t* ticks = reinterpret_cast<const uint64_t*>(data) + pair * 2;
+                const uint64_t begin = ticks[0];
+                const uint64_t end = ticks[1];
+                const D3D12_RANGE writtenRange{0, 0};
+                timestampReadbackBuffer->Unmap(0, &writtenRange);
+
+                *nanoseconds = int64_t(double(end - begin) * 1e9 / double(timestampFrequency));
+                return GpuTimestampRing::ReadResult::Ready;
+            },
+            samples);
+    }
+
+    bool D3D12GraphicsPlugin::GetGpuMemoryUsage(uint64_t* usedBytes) const
+    {
+        if (!d3d12Device) {
+            return false;
+        }
+        const ComPtr<IDXGIAdapter1> adapter = GetDXGIAdapter(d3d12Device->GetAdapterLuid());
+        return GetDXGIAdapterLocalMemoryUsage(adapter.Get(), usedBytes);
+    }
+
+    void D3D12GraphicsPlugin::CreatePipelineLibrary()
+    {
+        ComPtr<ID3D12Device1> device1;
+        if (FAILED(d3d12Device.As(&device1))) {
+            return;
+        }
 
-                cmdList->SetGraphicsRootConstantBufferView(0, modelCBuffer->GetGPUVirtualAddress() + offset);
+        const std::string& pipelineLibraryFile = GetGlobalData().options.d3d12PipelineLibraryFile;
+        if (pipelineLibraryData.empty() && !pipelineLibraryFile.empty()) {
+            std::ifstream file(pipelineLibraryFile, std::ios::binary);
+            pipelineLibraryData.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
 
-                // Draw the cube.
-                cmdList->DrawIndexedInstanced((uint32_t)Geometry::c_cubeIndices.size(), 1, 0, 0, 0);
+        HRESULT hr = device1->CreatePipelineLibrary(pipelineLibraryData.data(), pipelineLibraryData.size(), __uuidof(ID3D12PipelineLibrary),
+                                                    reinterpret_cast<void**>(pipelineLibrary.ReleaseAndGetAddressOf()));
+        if (FAILED(hr) && hr != DXGI_ERROR_UNSUPPORTED && !pipelineLibraryData.empty()) {
+            // A library from another driver or adapter, or a damaged file: start over with an empty one.
+            pipelineLibraryData.clear();
+            hr = device1->CreatePipelineLibrary(nullptr, 0, __uuidof(ID3D12PipelineLibrary),
+                                                reinterpret_cast<void**>(pipelineLibrary.ReleaseAndGetAddressOf()));
+        }
+        if (FAILED(hr)) {
+            pipelineLibrary.Reset();
+        }
+    }
 
-                offset += cubeCBufferSize;
-            }
+    void D3D12GraphicsPlugin::SavePipelineLibrary()
+    {
+        if (!pipelineLibrary) {
+            return;
+        }
 
-            XRC_CHECK_THROW_HRCMD(cmdList->Close());
-            CHECK(ExecuteCommandList(cmdList.Get()));
+        std::vector<uint8_t> serialized(pipelineLibrary->GetSerializedSize());
+        const bool saved = !serialized.empty() && SUCCEEDED(pipelineLibrary->Serialize(serialized.data(), serialized.size()));
+        pipelineLibrary.Reset();
+        if (!saved) {
+            return;
+        }
 
-            // TODO: Track down exactly why this wait is needed.
-            // On some drivers and/or hardware the test is generating the same image for the left and right eye,
-            // and generating images that fail the interactive tests. This did not seem to be the case several
-            // months ago, so it likely a driver change that flipped a race condition the other direction.
-            WaitForGpu();
+        pipelineLibraryData = std::move(serialized);
+        const std::string& pipelineLibraryFile = GetGlobalData().options.d3d12PipelineLibraryFile;
+        if (!pipelineLibraryFile.empty()) {
+            std::ofstream file(pipelineLibraryFile, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char*>(pipelineLibraryData.data()), std::streamsize(pipelineLibraryData.size()));
         }
     }
 
-    ID3D12PipelineState* D3D12GraphicsPlugin::GetOrCreatePipelineState(DXGI_FORMAT swapchainFormat)
+    ID3D12PipelineState* D3D12GraphicsPlugin::GetOrCreatePipelineState(DXGI_FORMAT swapchainFormat, DXGI_FORMAT depthStencilFormat,
+                                                                       UINT sampleCount)
     {
-        auto iter = pipelineStates.find(swapchainFormat);
+        const PipelineStateKey key{swapchainFormat, depthStencilFormat, sampleCount};
+        auto iter = pipelineStates.find(key);
         if (iter != pipelineStates.end()) {
             return iter->second.Get();
         }
 
         const D3D12_INPUT_ELEMENT_DESC inputElementDescs[] = {
-            {"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
-            {"COLOR", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
+            {"POSITION", 0, DXGI_FORMAT_R16G16B16A16_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
+            {"COLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
+            {"MODEL", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1},
+            {"MODEL", 1, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1},
+            {"MODEL", 2, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1},
+            {"MODEL", 3, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1},
         };
 
         D3D12_GRAPHICS_PIPELINE_STATE_DESC pipelineStateDesc{};
@@ -1101,18 +1601,30 @@ namespace Conformance
         pipelineStateDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
         pipelineStateDesc.NumRenderTargets = 1;
         pipelineStateDesc.RTVFormats[0] = swapchainFormat;
-        pipelineStateDesc.DSVFormat = DXGI_FORMAT_D32_FLOAT;
-        pipelineStateDesc.SampleDesc = {1, 0};
+        pipelineStateDesc.DSVFormat = depthStencilFormat;
+        pipelineStateDesc.SampleDesc = {sampleCount, 0};
         pipelineStateDesc.NodeMask = 0;
         pipelineStateDesc.CachedPSO = {nullptr, 0};
         pipelineStateDesc.Flags = D3D12_PIPELINE_STATE_FLAG_NONE;
 
+        // The library checks that a stored pipeline was created from the same description, so the name only needs to
+        // tell the keys apart.
+        const std::wstring name = L"Cube_" + std::to_wstring(swapchainFormat) + L"_" + std::to_wstring(depthStencilFormat) + L"_" +
+                                  std::to_wstring(sampleCount);
         ComPtr<ID3D12PipelineState> pipelineState;
-        XRC_CHECK_THROW_HRCMD(d3d12Device->CreateGraphicsPipelineState(&pipelineStateDesc, __uuidof(ID3D12PipelineState),
-                                                                       reinterpret_cast<void**>(pipelineState.ReleaseAndGetAddressOf())));
+        if (!pipelineLibrary ||
+            FAILED(pipelineLibrary->LoadGraphicsPipeline(name.c_str(), &pipelineStateDesc, __uuidof(ID3D12PipelineState),
+                                                         reinterpret_cast<void**>(pipelineState.ReleaseAndGetAddressOf())))) {
+            XRC_CHECK_THROW_HRCMD(d3d12Device->CreateGraphicsPipelineState(
+                &pipelineStateDesc, __uuidof(ID3D12PipelineState), reinterpret_cast<void**>(pipelineState.ReleaseAndGetAddressOf())));
+            if (pipelineLibrary) {
+                // Fails if a stale pipeline of this name is already stored; it is then compiled again on every run.
+                (void)pipelineLibrary->StorePipeline(name.c_str(), pipelineState.Get());
+            }
+        }
         ID3D12PipelineState* pipelineStateRaw = pipelineState.Get();
 
-        pipelineStates.emplace(swapchainFormat, std::move(pipelineState));
+        pipelineStates.emplace(key, std::move(pipelineState));
 
         return pipelineStateRaw;
     }
@@ -22,6 +22,8 @@ namespace Conformance
 {
 
 // Graphics API factories are forward declared here.
+    std::shared_ptr<IGraphicsPlugin> CreateGraphicsPlugin_Null(std::shared_ptr<IPlatformPlugin> platformPlugin);
+
 #ifdef XR_USE_GRAPHICS_API_OPENGL_ES
     std::shared_ptr<IGraphicsPlugin> CreateGraphicsPlugin_OpenGLES(std::shared_ptr<IPlatformPlugin> platformPlugin);
 #endif
@@ -46,6 +48,8 @@ namespace Conformance
     using GraphicsPluginFactory = std::function<std::shared_ptr<IGraphicsPlugin>(std::shared_ptr<IPlatformPlugin> platformPlugin)>;
 
     const std::map<std::string, GraphicsPluginFactory, IgnoreCaseStringLess> graphicsPluginMap = {
+        {"Null", [](std::shared_ptr<IPlatformPlugin> platformPlugin) { return CreateGraphicsPlugin_Null(std::move(platformPlugin)); }},
+
 #ifdef XR_USE_GRAPHICS_API_OPENGL_ES
         {"OpenGLES",
          [](std::shared_ptr<IPlatformPlugin> platformPlugin) { return CreateGraphicsPlugin_OpenGLES(std::move(platformPlugin)); }},
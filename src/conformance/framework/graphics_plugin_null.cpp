@@ -0,0 +1,172 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "graphics_plugin.h"
+#include "report.h"
+#include <atomic>
+#include <cstdint>
+
+namespace Conformance
+{
+    // A graphics plugin with no graphics API behind it, for measuring the CPU cost of the runtime on headless systems. Sessions
+    // are created through XR_MND_headless, so the runtime offers no swapchain formats and tests that need swapchains cannot run
+    // with it. The drawing entry points do nothing but count their calls, which are reported when the device is shut down.
+    struct NullGraphicsPlugin : public IGraphicsPlugin
+    {
+        NullGraphicsPlugin(std::shared_ptr<IPlatformPlugin> /*unused*/)
+        {
+        }
+
+        bool Initialize() override
+        {
+            if (initialized) {
+                return false;
+            }
+
+            initialized = true;
+            return initialized;
+        }
+
+        bool IsInitialized() const override
+        {
+            return initialized;
+        }
+
+        void Shutdown() override
+        {
+            initialized = false;
+        }
+
+        std::string DescribeGraphics() const override
+        {
+            return std::string("Null");
+        }
+
+        std::vector<std::string> GetInstanceExtensions() const override
+        {
+            return {XR_MND_HEADLESS_EXTENSION_NAME};
+        }
+
+        bool InitializeDevice(XrInstance /*instance*/, XrSystemId /*systemId*/, bool /*checkGraphicsRequirements*/,
+                              uint32_t /*deviceCreationFlags*/) override
+        {
+            deviceInitialized = true;
+            return true;
+        }
+
+        void ShutdownDevice() override
+        {
+            if (!deviceInitialized) {
+                return;
+            }
+            deviceInitialized = false;
+
+            const uint64_t rendered = renderViewCount.exchange(0);
+            const uint64_t copied = copyImageCount.exchange(0);
+            const uint64_t cleared = clearImageCount.exchange(0);
+            if (rendered != 0 || copied != 0 || cleared != 0) {
+                ReportF("Null graphics plugin: %llu views rendered, %llu images copied, %llu image slices cleared",
+                        (unsigned long long)rendered, (unsigned long long)copied, (unsigned long long)cleared);
+            }
+        }
+
+        // Sessions are created headless.
+        const XrBaseInStructure* GetGraphicsBinding() const override
+        {
+            return nullptr;
+        }
+
+        void CopyRGBAImage(const XrSwapchainImageBaseHeader* /*swapchainImage*/, int64_t /*imageFormat*/, uint32_t /*arraySlice*/,
+                           const RGBAImage& /*image*/) override
+        {
+            copyImageCount++;
+        }
+
+        std::string GetImageFormatName(int64_t /*imageFormat*/) const override
+        {
+            return "unknown";
+        }
+
+        bool IsImageFormatKnown(int64_t /*imageFormat*/) const override
+        {
+            return false;
+        }
+
+        bool GetSwapchainCreateTestParameters(XrInstance /*instance*/, XrSession /*session*/, XrSystemId /*systemId*/,
+                                              int64_t /*imageFormat*/, SwapchainCreateTestParameters* /*swapchainTestParameters*/) override
+        {
+            return false;
+        }
+
+        bool ValidateSwapchainImages(int64_t /*imageFormat*/, const SwapchainCreateTestParameters* /*tp*/, XrSwapchain /*swapchain*/,
+                                     uint32_t* /*imageCount*/) const override
+        {
+            return false;
+        }
+
+        bool ValidateSwapchainImageState(XrSwapchain /*swapchain*/, uint32_t /*index*/, int64_t /*imageFormat*/) const override
+        {
+            return false;
+        }
+
+        int64_t SelectColorSwapchainFormat(const int64_t* /*imageFormatArray*/, size_t /*count*/) const override
+        {
+            IGRAPHICSPLUGIN_UNIMPLEMENTED_METHOD();
+        }
+
+        int64_t SelectDepthSwapchainFormat(const int64_t* /*imageFormatArray*/, size_t /*count*/) const override
+        {
+            IGRAPHICSPLUGIN_UNIMPLEMENTED_METHOD();
+        }
+
+        int64_t GetSRGBA8Format() const override
+        {
+            IGRAPHICSPLUGIN_UNIMPLEMENTED_METHOD();
+        }
+
+        std::shared_ptr<SwapchainImageStructs> AllocateSwapchainImageStructs(size_t /*size*/,
+                                                                             const XrSwapchainCreateInfo& /*swapchainCreateInfo*/) override
+        {
+            IGRAPHICSPLUGIN_UNIMPLEMENTED_METHOD();
+        }
+
+        void ClearImageSlice(const XrSwapchainImageBaseHeader* /*colorSwapchainImage*/, uint32_t /*imageArrayIndex*/,
+                             int64_t /*colorSwapchainFormat*/) override
+        {
+            clearImageCount++;
+        }
+
+        void RenderView(const XrCompositionLayerProjectionView& /*layerView*/, const XrSwapchainImageBaseHeader* /*colorSwapchainImage*/,
+                        int64_t /*colorSwapchainFormat*/, const std::vector<Cube>& /*cubes*/) override
+        {
+            renderViewCount++;
+        }
+
+    private:
+        bool initialized{false};
+        bool deviceInitialized{false};
+
+        std::atomic<uint64_t> renderViewCount{0};
+        std::atomic<uint64_t> copyImageCount{0};
+        std::atomic<uint64_t> clearImageCount{0};
+    };
+
+    std::shared_ptr<IGraphicsPlugin> CreateGraphicsPlugin_Null(std::shared_ptr<IPlatformPlugin> platformPlugin)
+    {
+        return std::make_shared<NullGraphicsPlugin>(std::move(platformPlugin));
+    }
+
+}  // namespace Conformance
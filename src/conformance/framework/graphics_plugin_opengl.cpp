@@ -26,10 +26,14 @@
 
 #include "conformance_framework.h"
 #include "Geometry.h"
+#include "mesh_buffer.h"
+#include "projection_cache.h"
+#include "trace_scope.h"
 
 #include <catch2/catch.hpp>
 #include <openxr/openxr_platform.h>
 #include <openxr/openxr.h>
+#include <algorithm>
 #include <thread>
 
 // Why was this needed? hello_xr doesn't need these #defines
@@ -322,13 +326,34 @@ namespace Conformance
 
         in vec3 VertexPos;
         in vec3 VertexColor;
+        in mat4 InstanceModelViewProjection;
 
         out vec3 PSVertexColor;
 
-        uniform mat4 ModelViewProjection;
+        void main() {
+           gl_Position = InstanceModelViewProjection * vec4(VertexPos, 1.0);
+           PSVertexColor = VertexColor;
+        }
+        )_";
+
+    // The hands of RenderViewWithSkinnedHands: each vertex is moved by the weighted sum of its two bones' matrices.
+    static_assert(HandBoneCount == 26, "SkinnedVertexShaderGlsl sizes BonePalette for XR_HAND_JOINT_SET_DEFAULT_EXT");
+    static const char* SkinnedVertexShaderGlsl = R"_(
+        #version 410
+
+        uniform mat4 ViewProjection;
+        uniform mat4 BonePalette[26];
+
+        in vec3 VertexPos;
+        in vec3 VertexColor;
+        in vec2 VertexBones;
+        in vec2 VertexWeights;
+
+        out vec3 PSVertexColor;
 
         void main() {
-           gl_Position = ModelViewProjection * vec4(VertexPos, 1.0);
+           mat4 skin = BonePalette[int(VertexBones.x)] * VertexWeights.x + BonePalette[int(VertexBones.y)] * VertexWeights.y;
+           gl_Position = ViewProjection * (skin * vec4(VertexPos, 1.0));
            PSVertexColor = VertexColor;
         }
         )_";
@@ -369,6 +394,7 @@ namespace Conformance
                               uint32_t deviceCreationFlags) override;
         void DebugMessageCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message) const;
         void InitializeResources();
+        void EnableDebugOutput();
         void CheckFramebuffer(GLuint fb) const;
         void CheckShader(GLuint shader) const;
         void CheckProgram(GLuint prog) const;
@@ -407,7 +433,41 @@ namespace Conformance
         void RenderView(const XrCompositionLayerProjectionView& layerView, const XrSwapchainImageBaseHeader* colorSwapchainImage,
                         int64_t colorSwapchainFormat, const std::vector<Cube>& cubes) override;
 
+        void ClearAndRenderViews(const XrCompositionLayerProjectionView* layerViews, uint32_t viewCount,
+                                 const XrSwapchainImageBaseHeader* colorSwapchainImage, int64_t colorSwapchainFormat,
+                                 const std::vector<Cube>& cubes) override;
+
+        bool RenderViewWithVisibilityMask(const XrCompositionLayerProjectionView& layerView,
+                                          const XrSwapchainImageBaseHeader* colorSwapchainImage, int64_t colorSwapchainFormat,
+                                          const VisibilityMask& hiddenArea, const std::vector<Cube>& cubes) override;
+
+        bool RenderViewWithSkinnedHands(const XrCompositionLayerProjectionView& layerView,
+                                        const XrSwapchainImageBaseHeader* colorSwapchainImage, int64_t colorSwapchainFormat,
+                                        const std::vector<SkinnedHand>& hands, const std::vector<Cube>& cubes) override;
+
+        bool SetGpuTimingEnabled(bool enabled) override;
+
+        void CollectGpuTimings(std::vector<GpuTimingSample>& samples) override;
+
+        bool SetSyntheticGpuLoad(uint32_t layerCount) override
+        {
+            m_syntheticGpuLoad.SetLayerCount(layerCount);
+            return true;
+        }
+
+        bool SetRenderSampleCount(uint32_t sampleCount) override;
+
     protected:
+        // Brackets the commands issued while it is alive with a GPU timing scope, see SetGpuTimingEnabled.
+        struct GpuTimingScope
+        {
+            GpuTimingScope(OpenGLGraphicsPlugin& plugin, const char* scope);
+            ~GpuTimingScope();
+
+            OpenGLGraphicsPlugin& plugin;
+            const uint32_t pair;
+        };
+
         struct SwapchainImageContext : public IGraphicsPlugin::SwapchainImageStructs
         {
             // A packed array of XrSwapchainImageOpenGLKHR's for xrEnumerateSwapchainImages
@@ -424,6 +484,7 @@ namespace Conformance
                     ReportF("ArraySliceState copy ctor called");
                 }
                 GLuint depthBuffer;
+                std::vector<GLuint> framebuffers;  // per swapchain image, created on first use
             };
             std::vector<ArraySliceState> slice;
 
@@ -443,20 +504,39 @@ namespace Conformance
                     swapchainImages[i] = {XR_TYPE_SWAPCHAIN_IMAGE_OPENGL_KHR};
                     bases[i] = reinterpret_cast<XrSwapchainImageBaseHeader*>(&swapchainImages[i]);
                 }
-                slice.resize(swapchainCreateInfo.arraySize);
+                // The faces of a cube map are slices too, see IGraphicsPlugin::RenderGeneratedContent.
+                slice.resize(swapchainCreateInfo.arraySize * std::max(1u, swapchainCreateInfo.faceCount));
+                for (auto& s : slice) {
+                    s.framebuffers.resize(capacity, 0);
+                }
                 return bases;
             }
 
-            void Reset()
+            // Runs from the destructor and from ShutdownDevice, so must not throw: GL errors are logged, not checked.
+            void Reset() noexcept
             {
                 swapchainImages.clear();
                 createInfo = {};
                 for (const auto& s : slice) {
+                    for (GLuint framebuffer : s.framebuffers) {
+                        if (framebuffer) {
+                            glDeleteFramebuffers(1, &framebuffer);
+                        }
+                    }
                     if (s.depthBuffer) {
-                        XRC_CHECK_THROW_GLCMD(glDeleteTextures(1, &s.depthBuffer));
+                        glDeleteTextures(1, &s.depthBuffer);
                     }
                 }
                 slice.clear();
+                for (GLenum error = glGetError(); error != GL_NO_ERROR; error = glGetError()) {
+                    ReportF("Swapchain image context release: GL error 0x%x", (unsigned)error);
+                }
+            }
+
+            uint32_t ImageIndex(const XrSwapchainImageBaseHeader* swapchainImageHeader) const
+            {
+                auto p = reinterpret_cast<const XrSwapchainImageOpenGLKHR*>(swapchainImageHeader);
+                return (uint32_t)(p - &swapchainImages[0]);
             }
 
             GLuint GetDepthTexture(GLuint level)
@@ -478,6 +558,9 @@ namespace Conformance
     private:
         bool initialized = false;
         bool deviceInitialized = false;
+        // The window and its context outlive ShutdownDevice and are reused by the next InitializeDevice that they
+        // satisfy, since creating them through the window system costs far more than the device resources.
+        bool contextCreated = false;
 
         void deleteGLContext();
 
@@ -492,15 +575,68 @@ namespace Conformance
         XrGraphicsBindingOpenGLXlibKHR graphicsBinding{XR_TYPE_GRAPHICS_BINDING_OPENGL_XLIB_KHR};
 #endif
 
-        std::map<const XrSwapchainImageBaseHeader*, std::shared_ptr<SwapchainImageContext>> m_swapchainImageContextMap;
-        GLuint m_swapchainFramebuffer{0};
+        // Weak, so that a context and its framebuffers go away with the swapchain that owns them rather than keeping
+        // the runtime's destroyed textures attached until the device is shut down.
+        std::map<const XrSwapchainImageBaseHeader*, std::weak_ptr<SwapchainImageContext>> m_swapchainImageContextMap;
+
+        std::shared_ptr<SwapchainImageContext> GetSwapchainImageContext(const XrSwapchainImageBaseHeader* swapchainImage);
+
+        // Binds the framebuffer for one slice of a swapchain image, with its depth texture, creating it on first use.
+        void BindSwapchainFramebuffer(SwapchainImageContext& swapchainContext, const XrSwapchainImageBaseHeader* swapchainImage,
+                                      uint32_t arraySlice);
+
+        // Binds the multisampled framebuffer views are drawn into while m_renderSampleCount is above 1, recreating its
+        // renderbuffers when the swapchain size or format differs from the last view's.
+        void BindMultisampleFramebuffer(const XrSwapchainCreateInfo& createInfo);
+        void ReleaseMultisampleFramebuffer();
+
+        // RenderView, drawing hiddenArea before the cubes and the skinned hands after them, if they are not null.
+        void RenderViewInternal(const XrCompositionLayerProjectionView& layerView, const XrSwapchainImageBaseHeader* colorSwapchainImage,
+                                const std::vector<Cube>& sceneCubes, const std::vector<Geometry::PackedVertex>* hiddenArea,
+                                const std::vector<SkinnedHand>* hands);
         GLuint m_program{0};
-        GLint m_modelViewProjectionUniformLocation{0};
         GLint m_vertexAttribCoords{0};
         GLint m_vertexAttribColor{0};
+        GLint m_vertexAttribInstanceMvp{0};
         GLuint m_vao{0};
         GLuint m_cubeVertexBuffer{0};
         GLuint m_cubeIndexBuffer{0};
+        // Per-cube MVPs, re-specified every RenderView and drawn with a single instanced call.
+        GLuint m_instanceBuffer{0};
+        std::vector<XrMatrix4x4f> m_instanceMvps;
+        // The hidden area of RenderViewWithVisibilityMask: its vertices and single MVP, both re-specified for every view.
+        GLuint m_hiddenAreaVao{0};
+        GLuint m_hiddenAreaVertexBuffer{0};
+        GLuint m_hiddenAreaInstanceBuffer{0};
+        std::vector<Geometry::PackedVertex> m_hiddenAreaVertices;
+        // The hands of RenderViewWithSkinnedHands: both meshes in one static vertex and index buffer, drawn with their
+        // own program as the palettes are uniforms.
+        GLuint m_skinnedProgram{0};
+        GLint m_skinnedViewProjection{0};
+        GLint m_skinnedBonePalette{0};
+        GLuint m_handVao{0};
+        GLuint m_handVertexBuffer{0};
+        GLuint m_handIndexBuffer{0};
+        ProjectionCache<GRAPHICS_OPENGL> m_projectionCache;
+        // Scratch space for vertically flipping CopyRGBAImage uploads, kept to avoid reallocating.
+        std::vector<uint8_t> m_flippedPixels;
+
+        // GPU timing: pair i of the ring is the begin and end GL_TIMESTAMP queries at 2 * i and 2 * i + 1.
+        static constexpr uint32_t TimestampPairCount = 64;
+        std::vector<GLuint> m_timestampQueries;
+        GpuTimestampRing m_timestampRing;
+        bool m_gpuTimingEnabled{false};
+        SyntheticGpuLoad m_syntheticGpuLoad;
+
+        // See SetRenderSampleCount. The renderbuffers are the size of the whole swapchain so that a view resolves into
+        // the same rect it was drawn in.
+        GLsizei m_renderSampleCount{1};
+        GLuint m_multisampleFramebuffer{0};
+        GLuint m_multisampleColor{0};
+        GLuint m_multisampleDepth{0};
+        GLsizei m_multisampleWidth{0};
+        GLsizei m_multisampleHeight{0};
+        GLenum m_multisampleFormat{0};
     };
 
     OpenGLGraphicsPlugin::OpenGLGraphicsPlugin(const std::shared_ptr<IPlatformPlugin>& /*unused*/)
@@ -509,7 +645,13 @@ namespace Conformance
 
     OpenGLGraphicsPlugin::~OpenGLGraphicsPlugin()
     {
-        ShutdownDevice();
+        try {
+            ShutdownDevice();
+        }
+        catch (const std::exception& e) {
+            ReportF("OpenGL device shutdown failed in plugin destructor: %s", e.what());
+        }
+        deleteGLContext();
         Shutdown();
     }
 
@@ -555,10 +697,11 @@ namespace Conformance
 
     void OpenGLGraphicsPlugin::deleteGLContext()
     {
-        if (deviceInitialized) {
+        if (contextCreated) {
             //ReportF("Destroying window");
             ksGpuWindow_Destroy(&window);
         }
+        contextCreated = false;
         deviceInitialized = false;
     }
 
@@ -591,6 +734,19 @@ namespace Conformance
             }
 
             // delete the context to make a new one:
+            ShutdownDevice();
+            deleteGLContext();
+        }
+
+        if (contextCreated) {
+            // Left behind by an earlier device, so no window system calls are needed unless it is too old.
+            if (OpenGLVersionOfContext >= graphicsRequirements.minApiVersionSupported) {
+                ksGpuContext_SetCurrent(&window.context);
+                EnableDebugOutput();
+                InitializeResources();
+                deviceInitialized = true;
+                return true;
+            }
             deleteGLContext();
         }
 
@@ -602,6 +758,7 @@ namespace Conformance
         if (!ksGpuWindow_Create(&window, &driverInstance, &queueInfo, 0, colorFormat, depthFormat, sampleCount, 640, 480, false)) {
             XRC_THROW("Unable to create GL context");
         }
+        contextCreated = true;
         //ReportF("Created window");
 #if defined(XR_USE_PLATFORM_WIN32)
         graphicsBinding.hDC = window.context.hDC;
@@ -641,6 +798,15 @@ namespace Conformance
             return false;
         }
 
+        EnableDebugOutput();
+        InitializeResources();
+
+        deviceInitialized = true;
+        return true;
+    }
+
+    void OpenGLGraphicsPlugin::EnableDebugOutput()
+    {
 #if !defined(NDEBUG)
         glEnable(GL_DEBUG_OUTPUT);
         glDebugMessageCallback(
@@ -649,11 +815,6 @@ namespace Conformance
             },
             this);
 #endif
-
-        InitializeResources();
-
-        deviceInitialized = true;
-        return true;
     }
 
     void OpenGLGraphicsPlugin::DebugMessageCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length,
@@ -720,52 +881,110 @@ namespace Conformance
         XRC_CHECK_THROW_GLCMD(glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS));
 #endif
 
-        XRC_CHECK_THROW_GLCMD(glGenFramebuffers(1, &m_swapchainFramebuffer));
-        //ReportF("Got fb %d", m_swapchainFramebuffer);
-
-        GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertexShader, 1, &VertexShaderGlsl, nullptr);
-        glCompileShader(vertexShader);
-        CheckShader(vertexShader);
-
-        GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragmentShader, 1, &FragmentShaderGlsl, nullptr);
-        glCompileShader(fragmentShader);
-        CheckShader(fragmentShader);
-
-        m_program = glCreateProgram();
-        glAttachShader(m_program, vertexShader);
-        glAttachShader(m_program, fragmentShader);
-        glLinkProgram(m_program);
-        CheckProgram(m_program);
-
-        glDeleteShader(vertexShader);
-        glDeleteShader(fragmentShader);
+        auto buildProgram = [&](const char* vertexShaderGlsl) {
+            GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
+            glShaderSource(vertexShader, 1, &vertexShaderGlsl, nullptr);
+            glCompileShader(vertexShader);
+            CheckShader(vertexShader);
+
+            GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+            glShaderSource(fragmentShader, 1, &FragmentShaderGlsl, nullptr);
+            glCompileShader(fragmentShader);
+            CheckShader(fragmentShader);
+
+            GLuint program = glCreateProgram();
+            glAttachShader(program, vertexShader);
+            glAttachShader(program, fragmentShader);
+            glLinkProgram(program);
+            CheckProgram(program);
+
+            glDeleteShader(vertexShader);
+            glDeleteShader(fragmentShader);
+            return program;
+        };
 
-        m_modelViewProjectionUniformLocation = glGetUniformLocation(m_program, "ModelViewProjection");
+        m_program = buildProgram(VertexShaderGlsl);
 
         m_vertexAttribCoords = glGetAttribLocation(m_program, "VertexPos");
         m_vertexAttribColor = glGetAttribLocation(m_program, "VertexColor");
+        m_vertexAttribInstanceMvp = glGetAttribLocation(m_program, "InstanceModelViewProjection");
 
+        const SharedMeshes& meshes = GetSharedMeshes();
         XRC_CHECK_THROW_GLCMD(glGenBuffers(1, &m_cubeVertexBuffer));
         XRC_CHECK_THROW_GLCMD(glBindBuffer(GL_ARRAY_BUFFER, m_cubeVertexBuffer));
         XRC_CHECK_THROW_GLCMD(
-            glBufferData(GL_ARRAY_BUFFER, sizeof(Geometry::c_cubeVertices), &Geometry::c_cubeVertices[0], GL_STATIC_DRAW));
+            glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(meshes.buffer.VertexBytes()), meshes.buffer.Vertices().data(), GL_STATIC_DRAW));
 
         XRC_CHECK_THROW_GLCMD(glGenBuffers(1, &m_cubeIndexBuffer));
         XRC_CHECK_THROW_GLCMD(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_cubeIndexBuffer));
         XRC_CHECK_THROW_GLCMD(
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(Geometry::c_cubeIndices), &Geometry::c_cubeIndices[0], GL_STATIC_DRAW));
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, GLsizeiptr(meshes.buffer.IndexBytes()), meshes.buffer.Indices().data(), GL_STATIC_DRAW));
+
+        XRC_CHECK_THROW_GLCMD(glGenBuffers(1, &m_instanceBuffer));
+        XRC_CHECK_THROW_GLCMD(glGenBuffers(1, &m_hiddenAreaVertexBuffer));
+        XRC_CHECK_THROW_GLCMD(glGenBuffers(1, &m_hiddenAreaInstanceBuffer));
+
+        // Without glDrawElementsInstancedBaseVertex, a mesh's base vertex is applied by offsetting the attributes.
+        auto setUpVertexArray = [&](GLuint vao, GLuint vertexBuffer, GLuint instanceBuffer, int32_t baseVertex) {
+            const size_t baseOffset = sizeof(Geometry::PackedVertex) * size_t(baseVertex);
+            XRC_CHECK_THROW_GLCMD(glBindVertexArray(vao));
+            XRC_CHECK_THROW_GLCMD(glEnableVertexAttribArray(m_vertexAttribCoords));
+            XRC_CHECK_THROW_GLCMD(glEnableVertexAttribArray(m_vertexAttribColor));
+            XRC_CHECK_THROW_GLCMD(glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer));
+            XRC_CHECK_THROW_GLCMD(glVertexAttribPointer(m_vertexAttribCoords, 4, GL_HALF_FLOAT, GL_FALSE, sizeof(Geometry::PackedVertex),
+                                                        reinterpret_cast<const void*>(baseOffset)));
+            const size_t colorOffset = baseOffset + offsetof(Geometry::PackedVertex, Color);
+            XRC_CHECK_THROW_GLCMD(glVertexAttribPointer(m_vertexAttribColor, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Geometry::PackedVertex),
+                                                        reinterpret_cast<const void*>(colorOffset)));
+
+            // A mat4 attribute occupies four consecutive locations, one per column, advanced once per instance.
+            XRC_CHECK_THROW_GLCMD(glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer));
+            for (GLuint column = 0; column < 4; ++column) {
+                const GLuint location = GLuint(m_vertexAttribInstanceMvp) + column;
+                XRC_CHECK_THROW_GLCMD(glEnableVertexAttribArray(location));
+                XRC_CHECK_THROW_GLCMD(glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(XrMatrix4x4f),
+                                                            reinterpret_cast<const void*>(sizeof(float) * 4 * column)));
+                XRC_CHECK_THROW_GLCMD(glVertexAttribDivisor(location, 1));
+            }
+        };
 
         XRC_CHECK_THROW_GLCMD(glGenVertexArrays(1, &m_vao));
-        XRC_CHECK_THROW_GLCMD(glBindVertexArray(m_vao));
-        XRC_CHECK_THROW_GLCMD(glEnableVertexAttribArray(m_vertexAttribCoords));
-        XRC_CHECK_THROW_GLCMD(glEnableVertexAttribArray(m_vertexAttribColor));
-        XRC_CHECK_THROW_GLCMD(glBindBuffer(GL_ARRAY_BUFFER, m_cubeVertexBuffer));
+        setUpVertexArray(m_vao, m_cubeVertexBuffer, m_instanceBuffer, meshes.cube.baseVertex);
         XRC_CHECK_THROW_GLCMD(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_cubeIndexBuffer));
-        XRC_CHECK_THROW_GLCMD(glVertexAttribPointer(m_vertexAttribCoords, 3, GL_FLOAT, GL_FALSE, sizeof(Geometry::Vertex), nullptr));
-        XRC_CHECK_THROW_GLCMD(glVertexAttribPointer(m_vertexAttribColor, 3, GL_FLOAT, GL_FALSE, sizeof(Geometry::Vertex),
-                                                    reinterpret_cast<const void*>(sizeof(XrVector3f))));
+
+        // The hidden area is drawn with the same program, from its own vertices and a single instance.
+        XRC_CHECK_THROW_GLCMD(glGenVertexArrays(1, &m_hiddenAreaVao));
+        setUpVertexArray(m_hiddenAreaVao, m_hiddenAreaVertexBuffer, m_hiddenAreaInstanceBuffer, 0);
+
+        m_skinnedProgram = buildProgram(SkinnedVertexShaderGlsl);
+        m_skinnedViewProjection = glGetUniformLocation(m_skinnedProgram, "ViewProjection");
+        m_skinnedBonePalette = glGetUniformLocation(m_skinnedProgram, "BonePalette");
+
+        const HandMeshes& handMeshes = GetHandMeshes();
+        XRC_CHECK_THROW_GLCMD(glGenBuffers(1, &m_handVertexBuffer));
+        XRC_CHECK_THROW_GLCMD(glBindBuffer(GL_ARRAY_BUFFER, m_handVertexBuffer));
+        XRC_CHECK_THROW_GLCMD(
+            glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(handMeshes.VertexBytes()), handMeshes.vertices.data(), GL_STATIC_DRAW));
+
+        XRC_CHECK_THROW_GLCMD(glGenVertexArrays(1, &m_handVao));
+        XRC_CHECK_THROW_GLCMD(glBindVertexArray(m_handVao));
+        auto setUpSkinnedAttribute = [&](const char* name, GLint size, size_t offset) {
+            const GLuint location = GLuint(glGetAttribLocation(m_skinnedProgram, name));
+            XRC_CHECK_THROW_GLCMD(glEnableVertexAttribArray(location));
+            XRC_CHECK_THROW_GLCMD(
+                glVertexAttribPointer(location, size, GL_FLOAT, GL_FALSE, sizeof(SkinnedVertex), reinterpret_cast<const void*>(offset)));
+        };
+        setUpSkinnedAttribute("VertexPos", 3, offsetof(SkinnedVertex, Position));
+        setUpSkinnedAttribute("VertexColor", 3, offsetof(SkinnedVertex, Color));
+        setUpSkinnedAttribute("VertexBones", 2, offsetof(SkinnedVertex, Bones));
+        setUpSkinnedAttribute("VertexWeights", 2, offsetof(SkinnedVertex, Weights));
+
+        // The vertex array keeps the index buffer bound to it.
+        XRC_CHECK_THROW_GLCMD(glGenBuffers(1, &m_handIndexBuffer));
+        XRC_CHECK_THROW_GLCMD(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_handIndexBuffer));
+        XRC_CHECK_THROW_GLCMD(
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, GLsizeiptr(handMeshes.IndexBytes()), handMeshes.indices.data(), GL_STATIC_DRAW));
+        XRC_CHECK_THROW_GLCMD(glBindVertexArray(0));
     }
 
     void OpenGLGraphicsPlugin::CheckFramebuffer(GLuint fb) const
@@ -835,30 +1054,82 @@ namespace Conformance
 
     void OpenGLGraphicsPlugin::ShutdownDevice()
     {
-        if (m_swapchainFramebuffer != 0) {
-            glDeleteFramebuffers(1, &m_swapchainFramebuffer);
+        if (!deviceInitialized) {
+            return;
         }
+
+        // The context is kept for the next device, so everything made in it must actually be deleted.
         if (m_program != 0) {
             glDeleteProgram(m_program);
+            m_program = 0;
         }
         if (m_vao != 0) {
             glDeleteVertexArrays(1, &m_vao);
+            m_vao = 0;
         }
         if (m_cubeVertexBuffer != 0) {
             glDeleteBuffers(1, &m_cubeVertexBuffer);
+            m_cubeVertexBuffer = 0;
         }
         if (m_cubeIndexBuffer != 0) {
             glDeleteBuffers(1, &m_cubeIndexBuffer);
+            m_cubeIndexBuffer = 0;
+        }
+        if (m_instanceBuffer != 0) {
+            glDeleteBuffers(1, &m_instanceBuffer);
+            m_instanceBuffer = 0;
+        }
+        m_instanceMvps.clear();
+        if (m_hiddenAreaVao != 0) {
+            glDeleteVertexArrays(1, &m_hiddenAreaVao);
+            m_hiddenAreaVao = 0;
+        }
+        if (m_hiddenAreaVertexBuffer != 0) {
+            glDeleteBuffers(1, &m_hiddenAreaVertexBuffer);
+            m_hiddenAreaVertexBuffer = 0;
+        }
+        if (m_hiddenAreaInstanceBuffer != 0) {
+            glDeleteBuffers(1, &m_hiddenAreaInstanceBuffer);
+            m_hiddenAreaInstanceBuffer = 0;
         }
+        m_hiddenAreaVertices.clear();
+        if (m_skinnedProgram != 0) {
+            glDeleteProgram(m_skinnedProgram);
+            m_skinnedProgram = 0;
+        }
+        if (m_handVao != 0) {
+            glDeleteVertexArrays(1, &m_handVao);
+            m_handVao = 0;
+        }
+        if (m_handVertexBuffer != 0) {
+            glDeleteBuffers(1, &m_handVertexBuffer);
+            m_handVertexBuffer = 0;
+        }
+        if (m_handIndexBuffer != 0) {
+            glDeleteBuffers(1, &m_handIndexBuffer);
+            m_handIndexBuffer = 0;
+        }
+        m_flippedPixels.clear();
+        if (!m_timestampQueries.empty()) {
+            glDeleteQueries(GLsizei(m_timestampQueries.size()), m_timestampQueries.data());
+            m_timestampQueries.clear();
+        }
+        m_timestampRing.Reset(0);
+        m_gpuTimingEnabled = false;
+        m_syntheticGpuLoad.SetLayerCount(0);
+        ReleaseMultisampleFramebuffer();
+        m_renderSampleCount = 1;
 
         // Reset the swapchains to avoid calling Vulkan functions in the dtors after
         // we've shut down the device.
         for (auto& ctx : m_swapchainImageContextMap) {
-            ctx.second->Reset();
+            if (std::shared_ptr<SwapchainImageContext> swapchainContext = ctx.second.lock()) {
+                swapchainContext->Reset();
+            }
         }
         m_swapchainImageContextMap.clear();
 
-        deleteGLContext();
+        deviceInitialized = false;
     }
 
     // Only texture formats which are in OpenGL core and which are either color or depth renderable or
@@ -1100,6 +1371,11 @@ namespace Conformance
 
         std::vector<XrSwapchainImageBaseHeader*> bases = derivedResult->Create(uint32_t(size), swapchainCreateInfo);
 
+        // Drop the entries of swapchains that have since been destroyed.
+        for (auto it = m_swapchainImageContextMap.begin(); it != m_swapchainImageContextMap.end();) {
+            it = it->second.expired() ? m_swapchainImageContextMap.erase(it) : std::next(it);
+        }
+
         for (auto& base : bases) {
             // Set the generic vector of base pointers
             derivedResult->imagePtrVector.push_back(base);
@@ -1114,52 +1390,114 @@ namespace Conformance
         return result;
     }
 
+    std::shared_ptr<OpenGLGraphicsPlugin::SwapchainImageContext>
+    OpenGLGraphicsPlugin::GetSwapchainImageContext(const XrSwapchainImageBaseHeader* swapchainImage)
+    {
+        auto it = m_swapchainImageContextMap.find(swapchainImage);
+        std::shared_ptr<SwapchainImageContext> swapchainContext = it != m_swapchainImageContextMap.end() ? it->second.lock() : nullptr;
+        XRC_CHECK_THROW_MSG(swapchainContext != nullptr, "Swapchain image used after its image structs were released");
+        return swapchainContext;
+    }
+
+    void OpenGLGraphicsPlugin::BindSwapchainFramebuffer(SwapchainImageContext& swapchainContext,
+                                                        const XrSwapchainImageBaseHeader* swapchainImage, uint32_t arraySlice)
+    {
+        GLuint& framebuffer = swapchainContext.slice[arraySlice].framebuffers[swapchainContext.ImageIndex(swapchainImage)];
+        if (framebuffer != 0) {
+            XRC_CHECK_THROW_GLCMD(glBindFramebuffer(GL_FRAMEBUFFER, framebuffer));
+            return;
+        }
+
+        // Attach once; later frames only bind, which avoids a completeness revalidation on every view.
+        XRC_CHECK_THROW_GLCMD(glGenFramebuffers(1, &framebuffer));
+        XRC_CHECK_THROW_GLCMD(glBindFramebuffer(GL_FRAMEBUFFER, framebuffer));
+
+        const GLuint colorTexture = reinterpret_cast<const XrSwapchainImageOpenGLKHR*>(swapchainImage)->image;
+        const GLuint depthTexture = swapchainContext.GetDepthTexture(arraySlice);
+
+        if (swapchainContext.createInfo.arraySize > 1) {
+            XRC_CHECK_THROW_GLCMD(glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, colorTexture, 0, arraySlice));
+        }
+        else if (swapchainContext.createInfo.faceCount == 6) {
+            XRC_CHECK_THROW_GLCMD(
+                glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + arraySlice, colorTexture, 0));
+        }
+        else {
+            XRC_CHECK_THROW_GLCMD(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0));
+        }
+        XRC_CHECK_THROW_GLCMD(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0));
+
+        CheckFramebuffer(framebuffer);
+    }
+
     void OpenGLGraphicsPlugin::CopyRGBAImage(const XrSwapchainImageBaseHeader* swapchainImage, int64_t /*imageFormat*/, uint32_t arraySlice,
                                              const RGBAImage& image)
     {
-        auto swapchainContext = m_swapchainImageContextMap[swapchainImage];
+        XR_TRACE_SCOPE("OpenGLGraphicsPlugin::CopyRGBAImage");
+
+        const GpuTimingScope timingScope(*this, "CopyRGBAImage");
+
+        auto swapchainContext = GetSwapchainImageContext(swapchainImage);
 
         const uint32_t colorTexture = reinterpret_cast<const XrSwapchainImageOpenGLKHR*>(swapchainImage)->image;
         const GLint mip = 0;
         const GLint x = 0;
         const GLint z = arraySlice;
+        const GLint y = 0;
         const GLsizei w = swapchainContext->createInfo.width;
         const GLsizei h = swapchainContext->createInfo.height;
-        if (swapchainContext->createInfo.arraySize > 1) {
-            XRC_CHECK_THROW_GLCMD(glBindTexture(GL_TEXTURE_2D_ARRAY, colorTexture));
-            for (GLint y = 0; y < h; ++y) {
-                const void* pixels = &image.pixels[(h - 1 - y) * w];
-                XRC_CHECK_THROW_GLCMD(glTexSubImage3D(GL_TEXTURE_2D_ARRAY, mip, x, y, z, w, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixels));
-            }
+
+        // GL would convert unsigned bytes to the wide formats itself, but without decoding sRGB images to linear, so
+        // those get texels of the type they hold, as GLES needs.
+        GLenum type = GL_UNSIGNED_BYTE;
+        RGBATexelLayout texelLayout = RGBATexelLayout::R8G8B8A8;
+        switch (swapchainContext->createInfo.format) {
+        case GL_RGBA16F:
+            type = GL_HALF_FLOAT;
+            texelLayout = RGBATexelLayout::R16G16B16A16Float;
+            break;
+        case GL_RGBA32F:
+            type = GL_FLOAT;
+            texelLayout = RGBATexelLayout::R32G32B32A32Float;
+            break;
+        case GL_RGB10_A2:
+            type = GL_UNSIGNED_INT_2_10_10_10_REV;
+            texelLayout = RGBATexelLayout::R10G10B10A2;
+            break;
+        default:
+            break;
+        }
+
+        // GL's origin is bottom-left, so flip the rows on the CPU and upload the whole image in one call.
+        const size_t rowPitch = size_t(w) * RGBATexelSize(texelLayout);
+        m_flippedPixels.resize(rowPitch * h);
+        WriteRGBATexels(image, texelLayout, m_flippedPixels.data(), rowPitch, true);
+        const void* pixels = m_flippedPixels.data();
+
+        XRC_CHECK_THROW_GLCMD(glPixelStorei(GL_UNPACK_ROW_LENGTH, 0));
+        XRC_CHECK_THROW_GLCMD(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+        const GLenum target = swapchainContext->createInfo.arraySize > 1 ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D;
+        XRC_CHECK_THROW_GLCMD(glBindTexture(target, colorTexture));
+        if (target == GL_TEXTURE_2D_ARRAY) {
+            XRC_CHECK_THROW_GLCMD(glTexSubImage3D(target, mip, x, y, z, w, h, 1, GL_RGBA, type, pixels));
         }
         else {
-            XRC_CHECK_THROW_GLCMD(glBindTexture(GL_TEXTURE_2D, colorTexture));
-            for (GLint y = 0; y < h; ++y) {
-                const void* pixels = &image.pixels[(h - 1 - y) * w];
-                XRC_CHECK_THROW_GLCMD(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, y, w, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixels));
-            }
+            XRC_CHECK_THROW_GLCMD(glTexSubImage2D(target, mip, x, y, w, h, GL_RGBA, type, pixels));
+        }
+        if (swapchainContext->createInfo.mipCount > 1) {
+            // Filter the lower levels from the new level 0 on the GPU, sRGB-correctly for sRGB formats.
+            XRC_CHECK_THROW_GLCMD(glGenerateMipmap(target));
         }
     }
 
     void OpenGLGraphicsPlugin::ClearImageSlice(const XrSwapchainImageBaseHeader* colorSwapchainImage, uint32_t imageArrayIndex,
                                                int64_t /*colorSwapchainFormat*/)
     {
-        auto swapchainContext = m_swapchainImageContextMap[colorSwapchainImage];
+        const GpuTimingScope timingScope(*this, "ClearImageSlice");
 
-        XRC_CHECK_THROW_GLCMD(glBindFramebuffer(GL_FRAMEBUFFER, m_swapchainFramebuffer));
+        auto swapchainContext = GetSwapchainImageContext(colorSwapchainImage);
 
-        const uint32_t colorTexture = reinterpret_cast<const XrSwapchainImageOpenGLKHR*>(colorSwapchainImage)->image;
-        const uint32_t depthTexture = swapchainContext->GetDepthTexture(imageArrayIndex);
-
-        if (swapchainContext->createInfo.arraySize > 1) {
-            XRC_CHECK_THROW_GLCMD(glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, colorTexture, 0, imageArrayIndex));
-        }
-        else {
-            XRC_CHECK_THROW_GLCMD(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0));
-        }
-        XRC_CHECK_THROW_GLCMD(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0));
-
-        CheckFramebuffer(m_swapchainFramebuffer);
+        BindSwapchainFramebuffer(*swapchainContext, colorSwapchainImage, imageArrayIndex);
 
         GLint x = 0;
         GLint y = 0;
@@ -1180,26 +1518,79 @@ namespace Conformance
 
     void OpenGLGraphicsPlugin::RenderView(const XrCompositionLayerProjectionView& layerView,
                                           const XrSwapchainImageBaseHeader* colorSwapchainImage, int64_t /*colorSwapchainFormat*/,
-                                          const std::vector<Cube>& cubes)
+                                          const std::vector<Cube>& sceneCubes)
     {
-        auto swapchainContext = m_swapchainImageContextMap[colorSwapchainImage];
+        RenderViewInternal(layerView, colorSwapchainImage, sceneCubes, nullptr, nullptr);
+    }
 
-        XRC_CHECK_THROW_GLCMD(glBindFramebuffer(GL_FRAMEBUFFER, m_swapchainFramebuffer));
+    void OpenGLGraphicsPlugin::ClearAndRenderViews(const XrCompositionLayerProjectionView* layerViews, uint32_t viewCount,
+                                                   const XrSwapchainImageBaseHeader* colorSwapchainImage, int64_t colorSwapchainFormat,
+                                                   const std::vector<Cube>& cubes)
+    {
+        // glInvalidateFramebuffer is core from OpenGL 4.3 on.
+        const bool invalidateDepth = OpenGLVersionOfContext >= XR_MAKE_VERSION(4, 3, 0);
+        auto swapchainContext = GetSwapchainImageContext(colorSwapchainImage);
+
+        for (uint32_t i = 0; i < viewCount; ++i) {
+            const uint32_t arraySlice = layerViews[i].subImage.imageArrayIndex;
+            bool firstOfSlice = true;
+            bool lastOfSlice = true;
+            for (uint32_t j = 0; j < viewCount; ++j) {
+                if (layerViews[j].subImage.imageArrayIndex == arraySlice) {
+                    firstOfSlice = firstOfSlice && j >= i;
+                    lastOfSlice = lastOfSlice && j <= i;
+                }
+            }
 
-        GLint layer = layerView.subImage.imageArrayIndex;
+            if (firstOfSlice) {
+                ClearImageSlice(colorSwapchainImage, arraySlice, colorSwapchainFormat);
+            }
+            RenderView(layerViews[i], colorSwapchainImage, colorSwapchainFormat, cubes);
+
+            // Nothing reads the depth of the slice before its next clear, so a tiled GPU need not write it back.
+            if (lastOfSlice && invalidateDepth) {
+                const GLenum depthAttachment = GL_DEPTH_ATTACHMENT;
+                BindSwapchainFramebuffer(*swapchainContext, colorSwapchainImage, arraySlice);
+                XRC_CHECK_THROW_GLCMD(glInvalidateFramebuffer(GL_FRAMEBUFFER, 1, &depthAttachment));
+                glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            }
+        }
+    }
 
-        const GLuint colorTexture = reinterpret_cast<const XrSwapchainImageOpenGLKHR*>(colorSwapchainImage)->image;
-        const GLuint depthTexture = swapchainContext->GetDepthTexture(layer);
+    bool OpenGLGraphicsPlugin::RenderViewWithVisibilityMask(const XrCompositionLayerProjectionView& layerView,
+                                                            const XrSwapchainImageBaseHeader* colorSwapchainImage,
+                                                            int64_t /*colorSwapchainFormat*/, const VisibilityMask& hiddenArea,
+                                                            const std::vector<Cube>& sceneCubes)
+    {
+        BuildHiddenAreaVertices(hiddenArea, m_hiddenAreaVertices);
+        RenderViewInternal(layerView, colorSwapchainImage, sceneCubes, &m_hiddenAreaVertices, nullptr);
+        return true;
+    }
 
-        if (swapchainContext->createInfo.arraySize > 1) {
-            XRC_CHECK_THROW_GLCMD(glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, colorTexture, 0, layer));
-        }
-        else {
-            XRC_CHECK_THROW_GLCMD(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0));
-        }
-        XRC_CHECK_THROW_GLCMD(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0));
+    bool OpenGLGraphicsPlugin::RenderViewWithSkinnedHands(const XrCompositionLayerProjectionView& layerView,
+                                                          const XrSwapchainImageBaseHeader* colorSwapchainImage,
+                                                          int64_t /*colorSwapchainFormat*/, const std::vector<SkinnedHand>& hands,
+                                                          const std::vector<Cube>& sceneCubes)
+    {
+        RenderViewInternal(layerView, colorSwapchainImage, sceneCubes, nullptr, &hands);
+        return true;
+    }
+
+    void OpenGLGraphicsPlugin::RenderViewInternal(const XrCompositionLayerProjectionView& layerView,
+                                                  const XrSwapchainImageBaseHeader* colorSwapchainImage,
+                                                  const std::vector<Cube>& sceneCubes,
+                                                  const std::vector<Geometry::PackedVertex>* hiddenArea,
+                                                  const std::vector<SkinnedHand>* hands)
+    {
+        XR_TRACE_SCOPE("OpenGLGraphicsPlugin::RenderView");
+
+        const std::vector<Cube>& cubes = m_syntheticGpuLoad.Apply(&layerView, 1, sceneCubes);
 
-        CheckFramebuffer(m_swapchainFramebuffer);
+        const GpuTimingScope timingScope(*this, "RenderView");
+
+        auto swapchainContext = GetSwapchainImageContext(colorSwapchainImage);
+
+        BindSwapchainFramebuffer(*swapchainContext, colorSwapchainImage, layerView.subImage.imageArrayIndex);
 
         GLint x = layerView.subImage.imageRect.offset.x;
         GLint y = layerView.subImage.imageRect.offset.y;
@@ -1209,6 +1600,16 @@ namespace Conformance
         XRC_CHECK_THROW_GLCMD(glScissor(x, y, w, h));
 
         XRC_CHECK_THROW_GLCMD(glEnable(GL_SCISSOR_TEST));
+
+        const bool multisample = m_renderSampleCount > 1;
+        if (multisample) {
+            // Draw into the multisampled framebuffer, cleared as ClearImageSlice would, and resolve it below.
+            BindMultisampleFramebuffer(swapchainContext->createInfo);
+            XRC_CHECK_THROW_GLCMD(glClearColor(DarkSlateGray[0], DarkSlateGray[1], DarkSlateGray[2], DarkSlateGray[3]));
+            XRC_CHECK_THROW_GLCMD(glClearDepth(1.0f));
+            XRC_CHECK_THROW_GLCMD(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+        }
+
         XRC_CHECK_THROW_GLCMD(glEnable(GL_DEPTH_TEST));
         XRC_CHECK_THROW_GLCMD(glEnable(GL_CULL_FACE));
         XRC_CHECK_THROW_GLCMD(glFrontFace(GL_CW));
@@ -1218,8 +1619,7 @@ namespace Conformance
         XRC_CHECK_THROW_GLCMD(glUseProgram(m_program));
 
         const auto& pose = layerView.pose;
-        XrMatrix4x4f proj;
-        XrMatrix4x4f_CreateProjectionFov(&proj, GRAPHICS_OPENGL, layerView.fov, 0.05f, 100.0f);
+        const XrMatrix4x4f& proj = m_projectionCache.Get(layerView.fov, DepthNearZ, DepthFarZ);
         XrMatrix4x4f toView;
         XrVector3f scale{1.f, 1.f, 1.f};
         XrMatrix4x4f_CreateTranslationRotationScale(&toView, &pose.position, &pose.orientation, &scale);
@@ -1228,24 +1628,62 @@ namespace Conformance
         XrMatrix4x4f vp;
         XrMatrix4x4f_Multiply(&vp, &proj, &view);
 
+        // Draw the hidden area first, so that the depth test rejects the cubes behind it before they are shaded. Its
+        // vertices are in view space, so its MVP is just the projection.
+        if (hiddenArea != nullptr && !hiddenArea->empty()) {
+            XRC_CHECK_THROW_GLCMD(glBindVertexArray(m_hiddenAreaVao));
+            XRC_CHECK_THROW_GLCMD(glBindBuffer(GL_ARRAY_BUFFER, m_hiddenAreaVertexBuffer));
+            XRC_CHECK_THROW_GLCMD(glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(sizeof(Geometry::PackedVertex) * hiddenArea->size()),
+                                               hiddenArea->data(), GL_STREAM_DRAW));
+            XRC_CHECK_THROW_GLCMD(glBindBuffer(GL_ARRAY_BUFFER, m_hiddenAreaInstanceBuffer));
+            XRC_CHECK_THROW_GLCMD(glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(sizeof(XrMatrix4x4f)), &proj, GL_STREAM_DRAW));
+            XRC_CHECK_THROW_GLCMD(glBindBuffer(GL_ARRAY_BUFFER, 0));
+            XRC_CHECK_THROW_GLCMD(glDrawArraysInstanced(GL_TRIANGLES, 0, GLsizei(hiddenArea->size()), 1));
+        }
+
         // Set cube primitive data.
         XRC_CHECK_THROW_GLCMD(glBindVertexArray(m_vao));
 
-        // Render each cube
-        for (const Cube& cube : cubes) {
-            // Compute the model-view-projection transform and set it..
-            XrMatrix4x4f model;
-            XrMatrix4x4f_CreateTranslationRotationScale(&model, &cube.Pose.position, &cube.Pose.orientation, &cube.Scale);
-            XrMatrix4x4f mvp;
-            XrMatrix4x4f_Multiply(&mvp, &vp, &model);
-            glUniformMatrix4fv(m_modelViewProjectionUniformLocation, 1, GL_FALSE, reinterpret_cast<const GLfloat*>(&mvp));
+        if (!cubes.empty()) {
+            // Compute every cube's model-view-projection transform and upload them together.
+            m_instanceMvps.resize(cubes.size());
+            ComputeMVPs(vp, cubes, m_instanceMvps.data());
+            // Re-specifying the whole store lets the driver orphan the previous one instead of stalling on it.
+            XRC_CHECK_THROW_GLCMD(glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer));
+            XRC_CHECK_THROW_GLCMD(glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(sizeof(XrMatrix4x4f) * m_instanceMvps.size()),
+                                               m_instanceMvps.data(), GL_STREAM_DRAW));
+            XRC_CHECK_THROW_GLCMD(glBindBuffer(GL_ARRAY_BUFFER, 0));
+
+            // Draw all the cubes at once.
+            const MeshRange& cube = GetSharedMeshes().cube;
+            glDrawElementsInstanced(GL_TRIANGLES, GLsizei(cube.indexCount), GL_UNSIGNED_SHORT,
+                                    reinterpret_cast<const void*>(sizeof(uint16_t) * cube.firstIndex), GLsizei(m_instanceMvps.size()));
+        }
 
-            // Draw the cube.
-            glDrawElements(GL_TRIANGLES, GLsizei(Geometry::c_cubeIndices.size()), GL_UNSIGNED_SHORT, nullptr);
+        if (hands != nullptr && !hands->empty()) {
+            // Only the palettes change from hand to hand; the meshes stay in GPU memory.
+            XRC_CHECK_THROW_GLCMD(glUseProgram(m_skinnedProgram));
+            XRC_CHECK_THROW_GLCMD(glUniformMatrix4fv(m_skinnedViewProjection, 1, GL_FALSE, vp.m));
+            XRC_CHECK_THROW_GLCMD(glBindVertexArray(m_handVao));
+            const HandMeshes& handMeshes = GetHandMeshes();
+            for (const SkinnedHand& hand : *hands) {
+                const MeshRange& range = handMeshes.Range(hand.hand);
+                XRC_CHECK_THROW_GLCMD(glUniformMatrix4fv(m_skinnedBonePalette, GLsizei(HandBoneCount), GL_FALSE, hand.bonePalette[0].m));
+                XRC_CHECK_THROW_GLCMD(glDrawElements(GL_TRIANGLES, GLsizei(range.indexCount), GL_UNSIGNED_SHORT,
+                                                     reinterpret_cast<const void*>(sizeof(uint16_t) * range.firstIndex)));
+            }
         }
 
         glBindVertexArray(0);
         glUseProgram(0);
+
+        if (multisample) {
+            // Resolve the view's rect into the swapchain image; the blit honors the scissor, so turn it off.
+            BindSwapchainFramebuffer(*swapchainContext, colorSwapchainImage, layerView.subImage.imageArrayIndex);
+            XRC_CHECK_THROW_GLCMD(glBindFramebuffer(GL_READ_FRAMEBUFFER, m_multisampleFramebuffer));
+            XRC_CHECK_THROW_GLCMD(glDisable(GL_SCISSOR_TEST));
+            XRC_CHECK_THROW_GLCMD(glBlitFramebuffer(x, y, x + w, y + h, x, y, x + w, y + h, GL_COLOR_BUFFER_BIT, GL_NEAREST));
+        }
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
         // Swap our window every other eye for RenderDoc
@@ -1255,6 +1693,133 @@ namespace Conformance
         }
     }
 
+    bool OpenGLGraphicsPlugin::SetRenderSampleCount(uint32_t sampleCount)
+    {
+        if (sampleCount != 1) {
+            GLint maxSamples = 0;
+            if (deviceInitialized) {
+                XRC_CHECK_THROW_GLCMD(glGetIntegerv(GL_MAX_SAMPLES, &maxSamples));
+            }
+            if (sampleCount == 0 || (sampleCount & (sampleCount - 1)) != 0 || sampleCount > (uint32_t)maxSamples) {
+                return false;
+            }
+        }
+
+        if ((GLsizei)sampleCount != m_renderSampleCount) {
+            ReleaseMultisampleFramebuffer();
+            m_renderSampleCount = (GLsizei)sampleCount;
+        }
+        return true;
+    }
+
+    void OpenGLGraphicsPlugin::BindMultisampleFramebuffer(const XrSwapchainCreateInfo& createInfo)
+    {
+        const GLsizei width = (GLsizei)createInfo.width;
+        const GLsizei height = (GLsizei)createInfo.height;
+        const GLenum format = (GLenum)createInfo.format;
+        if (m_multisampleFramebuffer != 0 && m_multisampleWidth == width && m_multisampleHeight == height &&
+            m_multisampleFormat == format) {
+            XRC_CHECK_THROW_GLCMD(glBindFramebuffer(GL_FRAMEBUFFER, m_multisampleFramebuffer));
+            return;
+        }
+        ReleaseMultisampleFramebuffer();
+
+        XRC_CHECK_THROW_GLCMD(glGenRenderbuffers(1, &m_multisampleColor));
+        XRC_CHECK_THROW_GLCMD(glBindRenderbuffer(GL_RENDERBUFFER, m_multisampleColor));
+        XRC_CHECK_THROW_GLCMD(glRenderbufferStorageMultisample(GL_RENDERBUFFER, m_renderSampleCount, format, width, height));
+        XRC_CHECK_THROW_GLCMD(glGenRenderbuffers(1, &m_multisampleDepth));
+        XRC_CHECK_THROW_GLCMD(glBindRenderbuffer(GL_RENDERBUFFER, m_multisampleDepth));
+        XRC_CHECK_THROW_GLCMD(glRenderbufferStorageMultisample(GL_RENDERBUFFER, m_renderSampleCount, GL_DEPTH_COMPONENT24, width, height));
+        XRC_CHECK_THROW_GLCMD(glBindRenderbuffer(GL_RENDERBUFFER, 0));
+
+        XRC_CHECK_THROW_GLCMD(glGenFramebuffers(1, &m_multisampleFramebuffer));
+        XRC_CHECK_THROW_GLCMD(glBindFramebuffer(GL_FRAMEBUFFER, m_multisampleFramebuffer));
+        XRC_CHECK_THROW_GLCMD(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_multisampleColor));
+        XRC_CHECK_THROW_GLCMD(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_multisampleDepth));
+        CheckFramebuffer(m_multisampleFramebuffer);
+
+        m_multisampleWidth = width;
+        m_multisampleHeight = height;
+        m_multisampleFormat = format;
+    }
+
+    void OpenGLGraphicsPlugin::ReleaseMultisampleFramebuffer()
+    {
+        if (m_multisampleFramebuffer != 0) {
+            glDeleteFramebuffers(1, &m_multisampleFramebuffer);
+            m_multisampleFramebuffer = 0;
+        }
+        if (m_multisampleColor != 0) {
+            glDeleteRenderbuffers(1, &m_multisampleColor);
+            m_multisampleColor = 0;
+        }
+        if (m_multisampleDepth != 0) {
+            glDeleteRenderbuffers(1, &m_multisampleDepth);
+            m_multisampleDepth = 0;
+        }
+    }
+
+    bool OpenGLGraphicsPlugin::SetGpuTimingEnabled(bool enabled)
+    {
+        if (!enabled) {
+            m_gpuTimingEnabled = false;
+            return true;
+        }
+        // Timestamp queries are core since GL 3.3, but check anyway.
+        if (!deviceInitialized || glQueryCounter == nullptr || glGetQueryObjectui64v == nullptr) {
+            return false;
+        }
+
+        if (m_timestampQueries.empty()) {
+            std::vector<GLuint> queries(2 * TimestampPairCount);
+            XRC_CHECK_THROW_GLCMD(glGenQueries(GLsizei(queries.size()), queries.data()));
+            m_timestampQueries = std::move(queries);
+            m_timestampRing.Reset(TimestampPairCount);
+        }
+        m_gpuTimingEnabled = true;
+        return true;
+    }
+
+    OpenGLGraphicsPlugin::GpuTimingScope::GpuTimingScope(OpenGLGraphicsPlugin& plugin, const char* scope)
+        : plugin(plugin), pair(plugin.m_gpuTimingEnabled ? plugin.m_timestampRing.Begin(scope) : GpuTimestampRing::NoPair)
+    {
+        if (pair != GpuTimestampRing::NoPair) {
+            XRC_CHECK_THROW_GLCMD(glQueryCounter(plugin.m_timestampQueries[2 * pair], GL_TIMESTAMP));
+        }
+    }
+
+    OpenGLGraphicsPlugin::GpuTimingScope::~GpuTimingScope()
+    {
+        if (pair != GpuTimestampRing::NoPair) {
+            glQueryCounter(plugin.m_timestampQueries[2 * pair + 1], GL_TIMESTAMP);
+        }
+    }
+
+    void OpenGLGraphicsPlugin::CollectGpuTimings(std::vector<GpuTimingSample>& samples)
+    {
+        if (m_timestampQueries.empty()) {
+            return;
+        }
+
+        m_timestampRing.Collect(
+            [&](uint32_t pair, int64_t* nanoseconds) {
+                // Queries complete in order, so the end timestamp being available means the begin one is too.
+                GLuint available = GL_FALSE;
+                XRC_CHECK_THROW_GLCMD(glGetQueryObjectuiv(m_timestampQueries[2 * pair + 1], GL_QUERY_RESULT_AVAILABLE, &available));
+                if (available == GL_FALSE) {
+                    return GpuTimestampRing::ReadResult::NotReady;
+                }
+                GLuint64 begin = 0;
+                GLuint64 end = 0;
+                XRC_CHECK_THROW_GLCMD(glGetQueryObjectui64v(m_timestampQueries[2 * pair], GL_QUERY_RESULT, &begin));
+                XRC_CHECK_THROW_GLCMD(glGetQueryObjectui64v(m_timestampQueries[2 * pair + 1], GL_QUERY_RESULT, &end));
+                // GL timestamps are already in nanoseconds.
+                *nanoseconds = int64_t(end - begin);
+                return GpuTimestampRing::ReadResult::Ready;
+            },
+            samples);
+    }
+
     std::shared_ptr<IGraphicsPlugin> CreateGraphicsPlugin_OpenGL(std::shared_ptr<IPlatformPlugin> platformPlugin)
     {
         return std::make_shared<OpenGLGraphicsPlugin>(std::move(platformPlugin));
@@ -20,6 +20,21 @@
 // if more is needed, this could get replaced by a 3rd party extension loader
 #include <GL/gl.h>
 
+// vertex formats
+#if !defined(GL_HALF_FLOAT)
+#define GL_HALF_FLOAT 0x140B
+#endif
+
+// pixel upload types
+#if !defined(GL_UNSIGNED_INT_2_10_10_10_REV)
+#define GL_UNSIGNED_INT_2_10_10_10_REV 0x8368
+#endif
+
+// cube map faces
+#if !defined(GL_TEXTURE_CUBE_MAP_POSITIVE_X)
+#define GL_TEXTURE_CUBE_MAP_POSITIVE_X 0x8515
+#endif
+
 #if !defined(GL_MAJOR_VERSION)
 #define GL_MAJOR_VERSION 0x821B
 #endif
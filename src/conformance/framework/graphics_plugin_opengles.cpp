@@ -21,11 +21,15 @@
 #include "swapchain_parameters.h"
 #include "conformance_framework.h"
 #include "Geometry.h"
+#include "mesh_buffer.h"
+#include "projection_cache.h"
+#include "trace_scope.h"
 #include "common/gfxwrapper_opengl.h"
 #include <common/xr_linear.h>
 #include "xr_dependencies.h"
 #include <openxr/openxr.h>
 #include <openxr/openxr_platform.h>
+#include <algorithm>
 #include <list>
 #include <catch2/catch.hpp>
 #include <unordered_map>
@@ -55,13 +59,34 @@ namespace Conformance
 
     in vec3 VertexPos;
     in vec3 VertexColor;
+    in mat4 InstanceModelViewProjection;
 
     out vec3 PSVertexColor;
 
-    uniform mat4 ModelViewProjection;
+    void main() {
+       gl_Position = InstanceModelViewProjection * vec4(VertexPos, 1.0);
+       PSVertexColor = VertexColor;
+    }
+    )_";
+
+    // The hands of RenderViewWithSkinnedHands: each vertex is moved by the weighted sum of its two bones' matrices.
+    static_assert(HandBoneCount == 26, "SkinnedVertexShaderGlsl sizes BonePalette for XR_HAND_JOINT_SET_DEFAULT_EXT");
+    static const char* SkinnedVertexShaderGlsl = R"_(
+    #version 320 es
+
+    uniform mat4 ViewProjection;
+    uniform mat4 BonePalette[26];
+
+    in vec3 VertexPos;
+    in vec3 VertexColor;
+    in vec2 VertexBones;
+    in vec2 VertexWeights;
+
+    out vec3 PSVertexColor;
 
     void main() {
-       gl_Position = ModelViewProjection * vec4(VertexPos, 1.0);
+       mat4 skin = BonePalette[int(VertexBones.x)] * VertexWeights.x + BonePalette[int(VertexBones.y)] * VertexWeights.y;
+       gl_Position = ViewProjection * (skin * vec4(VertexPos, 1.0));
        PSVertexColor = VertexColor;
     }
     )_";
@@ -77,6 +102,91 @@ namespace Conformance
     }
     )_";
 
+    // Waits for a fence, flushing so that it is certain to signal, then deletes it.
+    static void WaitAndDeleteSync(GLsync fence)
+    {
+        const GLuint64 timeoutNs = 5ull * 1000 * 1000 * 1000;
+        const GLenum status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeoutNs);
+        glDeleteSync(fence);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+            throw std::runtime_error("Timed out waiting for a GL fence");
+        }
+    }
+
+    // PixelUnpackRing - a fixed set of pixel unpack buffers used round-robin for texture uploads. Each upload is
+    // fenced, and a buffer's fence is only waited on when the ring wraps back around to it, so the host writes the
+    // next upload while the GPU still reads earlier ones, and the driver never has to copy from client memory.
+    class PixelUnpackRing
+    {
+    public:
+        static constexpr uint32_t BufferCount = 4;
+
+        // Advances to the next buffer, waiting for the GPU to finish reading it if needed, and returns it bound to
+        // GL_PIXEL_UNPACK_BUFFER and mapped for writing size bytes.
+        void* Map(GLsizeiptr size)
+        {
+            m_current = (m_current + 1) % BufferCount;
+            Slot& slot = m_slots[m_current];
+            if (slot.fence != nullptr) {
+                WaitAndDeleteSync(slot.fence);
+                slot.fence = nullptr;
+            }
+            if (slot.buffer == 0) {
+                GL(glGenBuffers(1, &slot.buffer));
+            }
+            GL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer));
+            if (slot.size < size) {
+                GL(glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW));
+                slot.size = size;
+            }
+            // Unsynchronized, since the fence above already guarantees the GPU is done with the old contents.
+            void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+                                            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+            if (mapped == nullptr) {
+                throw std::runtime_error("Unable to map a pixel unpack buffer");
+            }
+            return mapped;
+        }
+
+        // Unmaps the buffer returned by Map, which stays bound so that uploads can source from it at offset 0.
+        void Unmap()
+        {
+            GL(glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER));
+        }
+
+        // Fences the uploads issued from the current buffer since Map, and unbinds it.
+        void Fence()
+        {
+            m_slots[m_current].fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            GL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+        }
+
+        // Deletes the buffers; GL keeps their storage alive for uploads that have not executed yet.
+        void Reset()
+        {
+            for (Slot& slot : m_slots) {
+                if (slot.fence != nullptr) {
+                    glDeleteSync(slot.fence);
+                }
+                if (slot.buffer != 0) {
+                    GL(glDeleteBuffers(1, &slot.buffer));
+                }
+                slot = {};
+            }
+            m_current = 0;
+        }
+
+    private:
+        struct Slot
+        {
+            GLuint buffer{0};
+            GLsizeiptr size{0};
+            GLsync fence{nullptr};
+        };
+        Slot m_slots[BufferCount]{};
+        uint32_t m_current{0};
+    };
+
     struct OpenGLESGraphicsPlugin : public IGraphicsPlugin
     {
         OpenGLESGraphicsPlugin(std::shared_ptr<IPlatformPlugin>& /*unused*/);
@@ -109,6 +219,9 @@ namespace Conformance
         void CopyRGBAImage(const XrSwapchainImageBaseHeader* swapchainImage, int64_t imageFormat, uint32_t arraySlice,
                            const RGBAImage& image) override;
 
+        std::future<RGBAImage> ReadbackSwapchainImage(const XrSwapchainImageBaseHeader* swapchainImage, int64_t imageFormat,
+                                                      uint32_t arraySlice) override;
+
         std::string GetImageFormatName(int64_t imageFormat) const override;
 
         bool IsImageFormatKnown(int64_t imageFormat) const override;
@@ -135,7 +248,41 @@ namespace Conformance
         void RenderView(const XrCompositionLayerProjectionView& layerView, const XrSwapchainImageBaseHeader* colorSwapchainImage,
                         int64_t colorSwapchainFormat, const std::vector<Cube>& cubes) override;
 
+        void ClearAndRenderViews(const XrCompositionLayerProjectionView* layerViews, uint32_t viewCount,
+                                 const XrSwapchainImageBaseHeader* colorSwapchainImage, int64_t colorSwapchainFormat,
+                                 const std::vector<Cube>& cubes) override;
+
+        bool RenderViewWithVisibilityMask(const XrCompositionLayerProjectionView& layerView,
+                                          const XrSwapchainImageBaseHeader* colorSwapchainImage, int64_t colorSwapchainFormat,
+                                          const VisibilityMask& hiddenArea, const std::vector<Cube>& cubes) override;
+
+        bool RenderViewWithSkinnedHands(const XrCompositionLayerProjectionView& layerView,
+                                        const XrSwapchainImageBaseHeader* colorSwapchainImage, int64_t colorSwapchainFormat,
+                                        const std::vector<SkinnedHand>& hands, const std::vector<Cube>& cubes) override;
+
+        bool SetGpuTimingEnabled(bool enabled) override;
+
+        void CollectGpuTimings(std::vector<GpuTimingSample>& samples) override;
+
+        bool SetSyntheticGpuLoad(uint32_t layerCount) override
+        {
+            m_syntheticGpuLoad.SetLayerCount(layerCount);
+            return true;
+        }
+
+        bool SetRenderSampleCount(uint32_t sampleCount) override;
+
     protected:
+        // Brackets the commands issued while it is alive with a GPU timing scope, see SetGpuTimingEnabled.
+        struct GpuTimingScope
+        {
+            GpuTimingScope(OpenGLESGraphicsPlugin& plugin, const char* scope);
+            ~GpuTimingScope();
+
+            OpenGLESGraphicsPlugin& plugin;
+            const uint32_t pair;
+        };
+
         struct OpenGLESSwapchainImageStructs : public IGraphicsPlugin::SwapchainImageStructs
         {
             std::vector<XrSwapchainImageOpenGLESKHR> imageVector;
@@ -146,10 +293,22 @@ namespace Conformance
 
         void InitializeResources();
         void ShutdownResources();
+        void DestroyContext();
         uint32_t GetDepthTexture(const XrSwapchainImageBaseHeader* colorSwapchainImage);
+        // Binds the multisampled framebuffer views are drawn into while m_renderSampleCount is above 1, recreating its
+        // renderbuffers when the swapchain size or format differs from the last view's.
+        void BindMultisampleFramebuffer(const XrSwapchainCreateInfo& createInfo);
+        void ReleaseMultisampleFramebuffer();
+        // RenderView, drawing hiddenArea before the cubes and the skinned hands after them, if they are not null.
+        void RenderViewInternal(const XrCompositionLayerProjectionView& layerView, const XrSwapchainImageBaseHeader* colorSwapchainImage,
+                                const std::vector<Cube>& sceneCubes, const std::vector<Geometry::PackedVertex>* hiddenArea,
+                                const std::vector<SkinnedHand>* hands);
         XrVersion OpenGLESVersionOfContext = 0;
 
         bool deviceInitialized{false};
+        // The window and its context outlive ShutdownDevice and are reused by the next InitializeDevice that they
+        // satisfy, since creating them through EGL costs far more than the device resources.
+        bool contextCreated{false};
 
         ksGpuWindow window{};
 
@@ -157,12 +316,48 @@ namespace Conformance
 
         GLuint m_swapchainFramebuffer{0};
         GLuint m_program{0};
-        GLint m_modelViewProjectionUniformLocation{0};
         GLint m_vertexAttribCoords{0};
         GLint m_vertexAttribColor{0};
+        GLint m_vertexAttribInstanceMvp{0};
         GLuint m_vao{0};
         GLuint m_cubeVertexBuffer{0};
         GLuint m_cubeIndexBuffer{0};
+        // Per-cube MVPs, re-specified every RenderView and drawn with a single instanced call.
+        GLuint m_instanceBuffer{0};
+        std::vector<XrMatrix4x4f> m_instanceMvps;
+        // The hidden area of RenderViewWithVisibilityMask: its vertices and single MVP, both re-specified for every view.
+        GLuint m_hiddenAreaVao{0};
+        GLuint m_hiddenAreaVertexBuffer{0};
+        GLuint m_hiddenAreaInstanceBuffer{0};
+        std::vector<Geometry::PackedVertex> m_hiddenAreaVertices;
+        // The hands of RenderViewWithSkinnedHands: both meshes in one static vertex and index buffer, drawn with their
+        // own program as the palettes are uniforms.
+        GLuint m_skinnedProgram{0};
+        GLint m_skinnedViewProjection{0};
+        GLint m_skinnedBonePalette{0};
+        GLuint m_handVao{0};
+        GLuint m_handVertexBuffer{0};
+        GLuint m_handIndexBuffer{0};
+        ProjectionCache<GRAPHICS_OPENGL_ES> m_projectionCache;
+        // CopyRGBAImage stages its flipped pixels here rather than uploading from client memory.
+        PixelUnpackRing m_pixelUnpackRing;
+
+        // GPU timing: pair i of the ring is the begin and end GL_TIMESTAMP queries at 2 * i and 2 * i + 1.
+        static constexpr uint32_t TimestampPairCount = 64;
+        std::vector<GLuint> m_timestampQueries;
+        GpuTimestampRing m_timestampRing;
+        bool m_gpuTimingEnabled{false};
+        SyntheticGpuLoad m_syntheticGpuLoad;
+
+        // See SetRenderSampleCount. The renderbuffers are the size of the whole swapchain, since ES only resolves
+        // between identical rects.
+        GLsizei m_renderSampleCount{1};
+        GLuint m_multisampleFramebuffer{0};
+        GLuint m_multisampleColor{0};
+        GLuint m_multisampleDepth{0};
+        GLsizei m_multisampleWidth{0};
+        GLsizei m_multisampleHeight{0};
+        GLenum m_multisampleFormat{0};
 
         // The OpenGLES interface uses a standard 2D target type when
         // arraySize == 1, so we need this info in some situations where
@@ -196,6 +391,7 @@ namespace Conformance
     OpenGLESGraphicsPlugin::~OpenGLESGraphicsPlugin()
     {
         ShutdownDevice();
+        DestroyContext();
         Shutdown();
     }
 
@@ -242,6 +438,10 @@ namespace Conformance
     void OpenGLESGraphicsPlugin::CopyRGBAImage(const XrSwapchainImageBaseHeader* swapchainImage, int64_t /* imageFormat */,
                                                uint32_t arraySlice, const RGBAImage& image)
     {
+        XR_TRACE_SCOPE("OpenGLESGraphicsPlugin::CopyRGBAImage");
+
+        const GpuTimingScope timingScope(*this, "CopyRGBAImage");
+
         auto imageInfoIt = m_imageInfo.find(swapchainImage);
         CHECK(imageInfoIt != m_imageInfo.end());
 
@@ -252,21 +452,109 @@ namespace Conformance
         GLuint height = image.height;
         GLenum target = isArray ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D;
 
+        // Unlike desktop GL, GLES does not convert unsigned bytes to float or packed 10-bit formats, so the texels are
+        // staged in the type the internal format takes.
+        GLenum type = GL_UNSIGNED_BYTE;
+        RGBATexelLayout texelLayout = RGBATexelLayout::R8G8B8A8;
+        switch (swapchainInfo.createInfo.format) {
+        case GL_RGBA16F:
+            type = GL_HALF_FLOAT;
+            texelLayout = RGBATexelLayout::R16G16B16A16Float;
+            break;
+        case GL_RGBA32F:
+            type = GL_FLOAT;
+            texelLayout = RGBATexelLayout::R32G32B32A32Float;
+            break;
+        case GL_RGB10_A2:
+            type = GL_UNSIGNED_INT_2_10_10_10_REV;
+            texelLayout = RGBATexelLayout::R10G10B10A2;
+            break;
+        default:
+            break;
+        }
+
+        // GL's origin is bottom-left, so flip the rows while staging them and upload the whole image in one call.
+        const size_t rowPitch = width * RGBATexelSize(texelLayout);
+        void* staged = m_pixelUnpackRing.Map(GLsizeiptr(rowPitch) * height);
+        WriteRGBATexels(image, texelLayout, staged, rowPitch, true);
+        m_pixelUnpackRing.Unmap();
+        const void* pixels = nullptr;  // offset 0 into the bound unpack buffer
+
         const uint32_t img = reinterpret_cast<const XrSwapchainImageOpenGLESKHR*>(swapchainImage)->image;
+        GL(glPixelStorei(GL_UNPACK_ROW_LENGTH, 0));
+        GL(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
         GL(glBindTexture(target, img));
         if (isArray) {
-            for (GLuint y = 0; y < height; ++y) {
-                const void* pixels = &image.pixels[(height - 1 - y) * width];
-                GL(glTexSubImage3D(target, 0, 0, y, arraySlice, width, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixels));
-            }
+            GL(glTexSubImage3D(target, 0, 0, 0, arraySlice, width, height, 1, GL_RGBA, type, pixels));
         }
         else {
-            for (GLuint y = 0; y < height; ++y) {
-                const void* pixels = &image.pixels[(height - 1 - y) * width];
-                GL(glTexSubImage2D(target, 0, 0, y, width, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixels));
-            }
+            GL(glTexSubImage2D(target, 0, 0, 0, width, height, GL_RGBA, type, pixels));
+        }
+        if (swapchainInfo.createInfo.mipCount > 1) {
+            // Filter the lower levels from the new level 0 on the GPU, sRGB-correctly for sRGB formats.
+            GL(glGenerateMipmap(target));
         }
         GL(glBindTexture(target, 0));
+        m_pixelUnpackRing.Fence();
+    }
+
+    std::future<RGBAImage> OpenGLESGraphicsPlugin::ReadbackSwapchainImage(const XrSwapchainImageBaseHeader* swapchainImage,
+                                                                          int64_t /* imageFormat */, uint32_t arraySlice)
+    {
+        auto imageInfoIt = m_imageInfo.find(swapchainImage);
+        if (imageInfoIt == m_imageInfo.end()) {
+            return {};
+        }
+        const XrSwapchainCreateInfo& createInfo = m_swapchainInfo[imageInfoIt->second.swapchainIndex].createInfo;
+        const GLuint width = createInfo.width;
+        const GLuint height = createInfo.height;
+        const GLsizeiptr size = GLsizeiptr(width) * height * sizeof(RGBA8Color);
+        const uint32_t img = reinterpret_cast<const XrSwapchainImageOpenGLESKHR*>(swapchainImage)->image;
+
+        GLuint readFramebuffer = 0;
+        GL(glGenFramebuffers(1, &readFramebuffer));
+        GL(glBindFramebuffer(GL_READ_FRAMEBUFFER, readFramebuffer));
+        if (createInfo.arraySize > 1) {
+            GL(glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, img, 0, arraySlice));
+        }
+        else {
+            GL(glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, img, 0));
+        }
+
+        // Reading into a pixel pack buffer only queues the copy; nothing waits on the GPU until the future is read.
+        GLuint packBuffer = 0;
+        GL(glGenBuffers(1, &packBuffer));
+        GL(glBindBuffer(GL_PIXEL_PACK_BUFFER, packBuffer));
+        GL(glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ));
+        GL(glPixelStorei(GL_PACK_ROW_LENGTH, 0));
+        GL(glPixelStorei(GL_PACK_ALIGNMENT, 4));
+        GL(glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+        GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        GL(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+        GL(glBindFramebuffer(GL_READ_FRAMEBUFFER, 0));
+        GL(glDeleteFramebuffers(1, &readFramebuffer));
+
+        return std::async(std::launch::deferred, [packBuffer, fence, width, height, size] {
+            WaitAndDeleteSync(fence);
+
+            RGBAImage image(width, height);
+            GL(glBindBuffer(GL_PIXEL_PACK_BUFFER, packBuffer));
+            const RGBA8Color* mapped = static_cast<const RGBA8Color*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT));
+            if (mapped != nullptr) {
+                // Flip back from GL's bottom-left origin.
+                for (GLuint row = 0; row < height; ++row) {
+                    std::copy_n(&mapped[size_t(height - 1 - row) * width], width, &image.pixels[size_t(row) * width]);
+                }
+                GL(glUnmapBuffer(GL_PIXEL_PACK_BUFFER));
+            }
+            GL(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+            GL(glDeleteBuffers(1, &packBuffer));
+            if (mapped == nullptr) {
+                throw std::runtime_error("Unable to map a pixel pack buffer");
+            }
+            image.isSrgb = true;
+            return image;
+        });
     }
 
     void OpenGLESGraphicsPlugin::Flush()
@@ -303,6 +591,18 @@ namespace Conformance
 
             // delete the context and resources to make a new one:
             ShutdownResources();
+            DestroyContext();
+        }
+
+        if (contextCreated) {
+            // Left behind by an earlier device, so no EGL calls are needed unless it is too old.
+            if (OpenGLESVersionOfContext >= graphicsRequirements.minApiVersionSupported) {
+                ksGpuContext_SetCurrent(&window.context);
+                InitializeResources();
+                deviceInitialized = true;
+                return true;
+            }
+            DestroyContext();
         }
 
         ksDriverInstance driverInstance{};
@@ -313,6 +613,7 @@ namespace Conformance
         if (!ksGpuWindow_Create(&window, &driverInstance, &queueInfo, 0, colorFormat, depthFormat, sampleCount, 640, 480, false)) {
             throw std::runtime_error("Unable to create GL context");
         }
+        contextCreated = true;
 
         // Initialize the binding once we have a context
         {
@@ -334,7 +635,7 @@ namespace Conformance
         GL(glGetIntegerv(GL_MINOR_VERSION, &minor));
         error = glGetError();
         if (error != GL_NO_ERROR) {
-            ShutdownResources();
+            DestroyContext();
             return false;
         }
 
@@ -342,7 +643,7 @@ namespace Conformance
         if (OpenGLESVersionOfContext < graphicsRequirements.minApiVersionSupported) {
             // OpenGL version of the conformance tests is lower than what the runtime requests -> can not be tested
 
-            ShutdownResources();
+            DestroyContext();
             return false;
         }
 
@@ -388,77 +689,192 @@ namespace Conformance
         //ReportF("OpenGLESGraphicsPlugin::InitializeResources");
         GL(glGenFramebuffers(1, &m_swapchainFramebuffer));
 
-        GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-        GL(glShaderSource(vertexShader, 1, &VertexShaderGlsl, nullptr));
-        GL(glCompileShader(vertexShader));
-        CheckShader(vertexShader);
-
-        GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-        GL(glShaderSource(fragmentShader, 1, &FragmentShaderGlsl, nullptr));
-        GL(glCompileShader(fragmentShader));
-        CheckShader(fragmentShader);
-
-        m_program = glCreateProgram();
-        GL(glAttachShader(m_program, vertexShader));
-        GL(glAttachShader(m_program, fragmentShader));
-        GL(glLinkProgram(m_program));
-        CheckProgram(m_program);
-
-        GL(glDeleteShader(vertexShader));
-        GL(glDeleteShader(fragmentShader));
+        auto buildProgram = [](const char* vertexShaderGlsl) {
+            GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
+            GL(glShaderSource(vertexShader, 1, &vertexShaderGlsl, nullptr));
+            GL(glCompileShader(vertexShader));
+            CheckShader(vertexShader);
+
+            GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+            GL(glShaderSource(fragmentShader, 1, &FragmentShaderGlsl, nullptr));
+            GL(glCompileShader(fragmentShader));
+            CheckShader(fragmentShader);
+
+            GLuint program = glCreateProgram();
+            GL(glAttachShader(program, vertexShader));
+            GL(glAttachShader(program, fragmentShader));
+            GL(glLinkProgram(program));
+            CheckProgram(program);
+
+            GL(glDeleteShader(vertexShader));
+            GL(glDeleteShader(fragmentShader));
+            return program;
+        };
 
-        m_modelViewProjectionUniformLocation = glGetUniformLocation(m_program, "ModelViewProjection");
+        m_program = buildProgram(VertexShaderGlsl);
 
         m_vertexAttribCoords = glGetAttribLocation(m_program, "VertexPos");
         m_vertexAttribColor = glGetAttribLocation(m_program, "VertexColor");
+        m_vertexAttribInstanceMvp = glGetAttribLocation(m_program, "InstanceModelViewProjection");
 
+        const SharedMeshes& meshes = GetSharedMeshes();
         GL(glGenBuffers(1, &m_cubeVertexBuffer));
         GL(glBindBuffer(GL_ARRAY_BUFFER, m_cubeVertexBuffer));
-        GL(glBufferData(GL_ARRAY_BUFFER, sizeof(Geometry::c_cubeVertices), Geometry::c_cubeVertices.data(), GL_STATIC_DRAW));
+        GL(glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(meshes.buffer.VertexBytes()), meshes.buffer.Vertices().data(), GL_STATIC_DRAW));
 
         GL(glGenBuffers(1, &m_cubeIndexBuffer));
         GL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_cubeIndexBuffer));
-        GL(glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(Geometry::c_cubeIndices), Geometry::c_cubeIndices.data(), GL_STATIC_DRAW));
+        GL(glBufferData(GL_ELEMENT_ARRAY_BUFFER, GLsizeiptr(meshes.buffer.IndexBytes()), meshes.buffer.Indices().data(), GL_STATIC_DRAW));
+
+        GL(glGenBuffers(1, &m_instanceBuffer));
+        GL(glGenBuffers(1, &m_hiddenAreaVertexBuffer));
+        GL(glGenBuffers(1, &m_hiddenAreaInstanceBuffer));
+
+        // Base vertex draws need OpenGL ES 3.2, so a mesh's base vertex is applied by offsetting the attributes instead.
+        auto setUpVertexArray = [&](GLuint vao, GLuint vertexBuffer, GLuint instanceBuffer, int32_t baseVertex) {
+            const size_t baseOffset = sizeof(Geometry::PackedVertex) * size_t(baseVertex);
+            glBindVertexArray(vao);
+            glEnableVertexAttribArray(m_vertexAttribCoords);
+            glEnableVertexAttribArray(m_vertexAttribColor);
+            glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+            glVertexAttribPointer(m_vertexAttribCoords, 4, GL_HALF_FLOAT, GL_FALSE, sizeof(Geometry::PackedVertex),
+                                  reinterpret_cast<const void*>(baseOffset));
+            glVertexAttribPointer(m_vertexAttribColor, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Geometry::PackedVertex),
+                                  reinterpret_cast<const void*>(baseOffset + offsetof(Geometry::PackedVertex, Color)));
+
+            // A mat4 attribute occupies four consecutive locations, one per column, advanced once per instance.
+            GL(glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer));
+            for (GLuint column = 0; column < 4; ++column) {
+                const GLuint location = GLuint(m_vertexAttribInstanceMvp) + column;
+                GL(glEnableVertexAttribArray(location));
+                GL(glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(XrMatrix4x4f),
+                                         reinterpret_cast<const void*>(sizeof(float) * 4 * column)));
+                GL(glVertexAttribDivisor(location, 1));
+            }
+        };
 
         glGenVertexArrays(1, &m_vao);
-        glBindVertexArray(m_vao);
-        glEnableVertexAttribArray(m_vertexAttribCoords);
-        glEnableVertexAttribArray(m_vertexAttribColor);
-        glBindBuffer(GL_ARRAY_BUFFER, m_cubeVertexBuffer);
+        setUpVertexArray(m_vao, m_cubeVertexBuffer, m_instanceBuffer, meshes.cube.baseVertex);
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_cubeIndexBuffer);
-        glVertexAttribPointer(m_vertexAttribCoords, 3, GL_FLOAT, GL_FALSE, sizeof(Geometry::Vertex), nullptr);
-        glVertexAttribPointer(m_vertexAttribColor, 3, GL_FLOAT, GL_FALSE, sizeof(Geometry::Vertex),
-                              reinterpret_cast<const void*>(sizeof(XrVector3f)));
+
+        // The hidden area is drawn with the same program, from its own vertices and a single instance.
+        glGenVertexArrays(1, &m_hiddenAreaVao);
+        setUpVertexArray(m_hiddenAreaVao, m_hiddenAreaVertexBuffer, m_hiddenAreaInstanceBuffer, 0);
+
+        m_skinnedProgram = buildProgram(SkinnedVertexShaderGlsl);
+        m_skinnedViewProjection = glGetUniformLocation(m_skinnedProgram, "ViewProjection");
+        m_skinnedBonePalette = glGetUniformLocation(m_skinnedProgram, "BonePalette");
+
+        const HandMeshes& handMeshes = GetHandMeshes();
+        GL(glGenBuffers(1, &m_handVertexBuffer));
+        GL(glBindBuffer(GL_ARRAY_BUFFER, m_handVertexBuffer));
+        GL(glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(handMeshes.VertexBytes()), handMeshes.vertices.data(), GL_STATIC_DRAW));
+
+        GL(glGenVertexArrays(1, &m_handVao));
+        GL(glBindVertexArray(m_handVao));
+        auto setUpSkinnedAttribute = [&](const char* name, GLint size, size_t offset) {
+            const GLuint location = GLuint(glGetAttribLocation(m_skinnedProgram, name));
+            GL(glEnableVertexAttribArray(location));
+            GL(glVertexAttribPointer(location, size, GL_FLOAT, GL_FALSE, sizeof(SkinnedVertex), reinterpret_cast<const void*>(offset)));
+        };
+        setUpSkinnedAttribute("VertexPos", 3, offsetof(SkinnedVertex, Position));
+        setUpSkinnedAttribute("VertexColor", 3, offsetof(SkinnedVertex, Color));
+        setUpSkinnedAttribute("VertexBones", 2, offsetof(SkinnedVertex, Bones));
+        setUpSkinnedAttribute("VertexWeights", 2, offsetof(SkinnedVertex, Weights));
+
+        // The vertex array keeps the index buffer bound to it.
+        GL(glGenBuffers(1, &m_handIndexBuffer));
+        GL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_handIndexBuffer));
+        GL(glBufferData(GL_ELEMENT_ARRAY_BUFFER, GLsizeiptr(handMeshes.IndexBytes()), handMeshes.indices.data(), GL_STATIC_DRAW));
+        GL(glBindVertexArray(0));
     }
 
     void OpenGLESGraphicsPlugin::ShutdownResources()
     {
         if (deviceInitialized) {
+            // The context is kept for the next device, so everything made in it must actually be deleted.
             if (m_swapchainFramebuffer != 0) {
                 GL(glDeleteFramebuffers(1, &m_swapchainFramebuffer));
+                m_swapchainFramebuffer = 0;
             }
             if (m_program != 0) {
                 GL(glDeleteProgram(m_program));
+                m_program = 0;
             }
             if (m_vao != 0) {
                 GL(glDeleteVertexArrays(1, &m_vao));
+                m_vao = 0;
             }
             if (m_cubeVertexBuffer != 0) {
                 GL(glDeleteBuffers(1, &m_cubeVertexBuffer));
+                m_cubeVertexBuffer = 0;
             }
             if (m_cubeIndexBuffer != 0) {
                 GL(glDeleteBuffers(1, &m_cubeIndexBuffer));
+                m_cubeIndexBuffer = 0;
             }
+            if (m_instanceBuffer != 0) {
+                GL(glDeleteBuffers(1, &m_instanceBuffer));
+                m_instanceBuffer = 0;
+            }
+            m_instanceMvps.clear();
+            if (m_hiddenAreaVao != 0) {
+                GL(glDeleteVertexArrays(1, &m_hiddenAreaVao));
+                m_hiddenAreaVao = 0;
+            }
+            if (m_hiddenAreaVertexBuffer != 0) {
+                GL(glDeleteBuffers(1, &m_hiddenAreaVertexBuffer));
+                m_hiddenAreaVertexBuffer = 0;
+            }
+            if (m_hiddenAreaInstanceBuffer != 0) {
+                GL(glDeleteBuffers(1, &m_hiddenAreaInstanceBuffer));
+                m_hiddenAreaInstanceBuffer = 0;
+            }
+            m_hiddenAreaVertices.clear();
+            if (m_skinnedProgram != 0) {
+                GL(glDeleteProgram(m_skinnedProgram));
+                m_skinnedProgram = 0;
+            }
+            if (m_handVao != 0) {
+                GL(glDeleteVertexArrays(1, &m_handVao));
+                m_handVao = 0;
+            }
+            if (m_handVertexBuffer != 0) {
+                GL(glDeleteBuffers(1, &m_handVertexBuffer));
+                m_handVertexBuffer = 0;
+            }
+            if (m_handIndexBuffer != 0) {
+                GL(glDeleteBuffers(1, &m_handIndexBuffer));
+                m_handIndexBuffer = 0;
+            }
+            m_pixelUnpackRing.Reset();
+            if (!m_timestampQueries.empty()) {
+                GL(glDeleteQueries(GLsizei(m_timestampQueries.size()), m_timestampQueries.data()));
+                m_timestampQueries.clear();
+            }
+            m_timestampRing.Reset(0);
+            m_gpuTimingEnabled = false;
+            m_syntheticGpuLoad.SetLayerCount(0);
+            ReleaseMultisampleFramebuffer();
+            m_renderSampleCount = 1;
 
             for (auto& colorToDepth : m_colorToDepthMap) {
                 if (colorToDepth.second != 0) {
                     GL(glDeleteTextures(1, &colorToDepth.second));
                 }
             }
+            m_colorToDepthMap.clear();
+        }
+        deviceInitialized = false;
+    }
 
+    void OpenGLESGraphicsPlugin::DestroyContext()
+    {
+        ShutdownResources();
+        if (contextCreated) {
             ksGpuWindow_Destroy(&window);
         }
-        deviceInitialized = false;
+        contextCreated = false;
     }
 
     std::shared_ptr<IGraphicsPlugin> CreateGraphicsPlugin_OpenGLES(std::shared_ptr<IPlatformPlugin> platformPlugin)
@@ -875,6 +1291,8 @@ namespace Conformance
     void OpenGLESGraphicsPlugin::ClearImageSlice(const XrSwapchainImageBaseHeader* colorSwapchainImage, uint32_t imageArrayIndex,
                                                  int64_t /*colorSwapchainFormat*/)
     {
+        const GpuTimingScope timingScope(*this, "ClearImageSlice");
+
         auto imageInfoIt = m_imageInfo.find(colorSwapchainImage);
         CHECK(imageInfoIt != m_imageInfo.end());
 
@@ -892,7 +1310,9 @@ namespace Conformance
             GL(glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthTexture, 0, imageArrayIndex));
         }
         else {
-            GL(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, target, colorTexture, 0));
+            // The faces of a cube map are attached by target, see IGraphicsPlugin::RenderGeneratedContent.
+            const GLenum colorTarget = swapchainInfo.createInfo.faceCount == 6 ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + imageArrayIndex : target;
+            GL(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, colorTarget, colorTexture, 0));
             GL(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, target, depthTexture, 0));
         }
 
@@ -955,9 +1375,74 @@ namespace Conformance
     }
 
     void OpenGLESGraphicsPlugin::RenderView(const XrCompositionLayerProjectionView& layerView,
-                                            const XrSwapchainImageBaseHeader* colorSwapchainImage, int64_t colorSwapchainFormat,
-                                            const std::vector<Cube>& cubes)
+                                            const XrSwapchainImageBaseHeader* colorSwapchainImage, int64_t /*colorSwapchainFormat*/,
+                                            const std::vector<Cube>& sceneCubes)
+    {
+        RenderViewInternal(layerView, colorSwapchainImage, sceneCubes, nullptr, nullptr);
+    }
+
+    void OpenGLESGraphicsPlugin::ClearAndRenderViews(const XrCompositionLayerProjectionView* layerViews, uint32_t viewCount,
+                                                     const XrSwapchainImageBaseHeader* colorSwapchainImage, int64_t colorSwapchainFormat,
+                                                     const std::vector<Cube>& cubes)
     {
+        for (uint32_t i = 0; i < viewCount; ++i) {
+            const uint32_t arraySlice = layerViews[i].subImage.imageArrayIndex;
+            bool firstOfSlice = true;
+            bool lastOfSlice = true;
+            for (uint32_t j = 0; j < viewCount; ++j) {
+                if (layerViews[j].subImage.imageArrayIndex == arraySlice) {
+                    firstOfSlice = firstOfSlice && j >= i;
+                    lastOfSlice = lastOfSlice && j <= i;
+                }
+            }
+
+            if (firstOfSlice) {
+                ClearImageSlice(colorSwapchainImage, arraySlice, colorSwapchainFormat);
+            }
+            RenderView(layerViews[i], colorSwapchainImage, colorSwapchainFormat, cubes);
+
+            // Nothing reads the depth of the slice before its next clear, so a tiler need not write it back to memory.
+            // RenderView left the slice attached to the swapchain framebuffer.
+            if (lastOfSlice) {
+                const GLenum attachments[] = {GL_DEPTH_ATTACHMENT};
+                GL(glBindFramebuffer(GL_FRAMEBUFFER, m_swapchainFramebuffer));
+                GL(glInvalidateFramebuffer(GL_FRAMEBUFFER, 1, attachments));
+                GL(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+            }
+        }
+    }
+
+    bool OpenGLESGraphicsPlugin::RenderViewWithVisibilityMask(const XrCompositionLayerProjectionView& layerView,
+                                                              const XrSwapchainImageBaseHeader* colorSwapchainImage,
+                                                              int64_t /*colorSwapchainFormat*/, const VisibilityMask& hiddenArea,
+                                                              const std::vector<Cube>& sceneCubes)
+    {
+        BuildHiddenAreaVertices(hiddenArea, m_hiddenAreaVertices);
+        RenderViewInternal(layerView, colorSwapchainImage, sceneCubes, &m_hiddenAreaVertices, nullptr);
+        return true;
+    }
+
+    bool OpenGLESGraphicsPlugin::RenderViewWithSkinnedHands(const XrCompositionLayerProjectionView& layerView,
+                                                            const XrSwapchainImageBaseHeader* colorSwapchainImage,
+                                                            int64_t /*colorSwapchainFormat*/, const std::vector<SkinnedHand>& hands,
+                                                            const std::vector<Cube>& sceneCubes)
+    {
+        RenderViewInternal(layerView, colorSwapchainImage, sceneCubes, nullptr, &hands);
+        return true;
+    }
+
+    void OpenGLESGraphicsPlugin::RenderViewInternal(const XrCompositionLayerProjectionView& layerView,
+                                                    const XrSwapchainImageBaseHeader* colorSwapchainImage,
+                                                    const std::vector<Cube>& sceneCubes,
+                                                    const std::vector<Geometry::PackedVertex>* hiddenArea,
+                                                    const std::vector<SkinnedHand>* hands)
+    {
+        XR_TRACE_SCOPE("OpenGLESGraphicsPlugin::RenderView");
+
+        const std::vector<Cube>& cubes = m_syntheticGpuLoad.Apply(&layerView, 1, sceneCubes);
+
+        const GpuTimingScope timingScope(*this, "RenderView");
+
         auto imageInfoIt = m_imageInfo.find(colorSwapchainImage);
         CHECK(imageInfoIt != m_imageInfo.end());
 
@@ -966,8 +1451,6 @@ namespace Conformance
         bool isArray = arraySize > 1;
         GLenum target = isArray ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D;
 
-        UNUSED_PARM(colorSwapchainFormat);  // Not used in this function for now.
-
         GL(glBindFramebuffer(GL_FRAMEBUFFER, m_swapchainFramebuffer));
 
         const uint32_t colorTexture = reinterpret_cast<const XrSwapchainImageOpenGLESKHR*>(colorSwapchainImage)->image;
@@ -992,16 +1475,26 @@ namespace Conformance
             GL(glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthTexture, 0, layerView.subImage.imageArrayIndex));
         }
         else {
-            GL(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, target, colorTexture, 0));
+            const GLenum colorTarget =
+                swapchainInfo.createInfo.faceCount == 6 ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + layerView.subImage.imageArrayIndex : target;
+            GL(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, colorTarget, colorTexture, 0));
             GL(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, target, depthTexture, 0));
         }
 
+        const bool multisample = m_renderSampleCount > 1;
+        if (multisample) {
+            // Draw into the multisampled framebuffer, cleared as ClearImageSlice would, and resolve it below.
+            BindMultisampleFramebuffer(swapchainInfo.createInfo);
+            GL(glClearColor(DarkSlateGray[0], DarkSlateGray[1], DarkSlateGray[2], DarkSlateGray[3]));
+            GL(glClearDepthf(1.0f));
+            GL(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+        }
+
         // Set shaders and uniform variables.
         GL(glUseProgram(m_program));
 
         const auto& pose = layerView.pose;
-        XrMatrix4x4f proj;
-        XrMatrix4x4f_CreateProjectionFov(&proj, GRAPHICS_OPENGL_ES, layerView.fov, 0.05f, 100.0f);
+        const XrMatrix4x4f& proj = m_projectionCache.Get(layerView.fov, DepthNearZ, DepthFarZ);
         XrMatrix4x4f toView;
         XrVector3f scale{1.f, 1.f, 1.f};
         XrMatrix4x4f_CreateTranslationRotationScale(&toView, &pose.position, &pose.orientation, &scale);
@@ -1010,28 +1503,203 @@ namespace Conformance
         XrMatrix4x4f vp;
         XrMatrix4x4f_Multiply(&vp, &proj, &view);
 
+        // Draw the hidden area first, so that the depth test rejects the cubes behind it before they are shaded. Its
+        // vertices are in view space, so its MVP is just the projection.
+        if (hiddenArea != nullptr && !hiddenArea->empty()) {
+            GL(glBindVertexArray(m_hiddenAreaVao));
+            GL(glBindBuffer(GL_ARRAY_BUFFER, m_hiddenAreaVertexBuffer));
+            GL(glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(sizeof(Geometry::PackedVertex) * hiddenArea->size()), hiddenArea->data(),
+                            GL_STREAM_DRAW));
+            GL(glBindBuffer(GL_ARRAY_BUFFER, m_hiddenAreaInstanceBuffer));
+            GL(glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(sizeof(XrMatrix4x4f)), &proj, GL_STREAM_DRAW));
+            GL(glBindBuffer(GL_ARRAY_BUFFER, 0));
+            GL(glDrawArraysInstanced(GL_TRIANGLES, 0, GLsizei(hiddenArea->size()), 1));
+        }
+
         // Set cube primitive data.
         GL(glBindVertexArray(m_vao));
 
-        // Render each cube
-        for (const Cube& cube : cubes) {
-            // Compute the model-view-projection transform and set it..
-            XrMatrix4x4f model;
-            XrMatrix4x4f_CreateTranslationRotationScale(&model, &cube.Pose.position, &cube.Pose.orientation, &cube.Scale);
-            XrMatrix4x4f mvp;
-            XrMatrix4x4f_Multiply(&mvp, &vp, &model);
-            GL(glUniformMatrix4fv(m_modelViewProjectionUniformLocation, 1, GL_FALSE, reinterpret_cast<const GLfloat*>(&mvp)));
-
-            // Draw the cube.
-            GL(glDrawElements(GL_TRIANGLES, Geometry::c_cubeIndices.size(), GL_UNSIGNED_SHORT, nullptr));
+        if (!cubes.empty()) {
+            // Compute every cube's model-view-projection transform and upload them together.
+            m_instanceMvps.resize(cubes.size());
+            ComputeMVPs(vp, cubes, m_instanceMvps.data());
+            // Re-specifying the whole store lets the driver orphan the previous one instead of stalling on it.
+            GL(glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer));
+            GL(glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(sizeof(XrMatrix4x4f) * m_instanceMvps.size()), m_instanceMvps.data(),
+                            GL_STREAM_DRAW));
+            GL(glBindBuffer(GL_ARRAY_BUFFER, 0));
+
+            // Draw all the cubes at once.
+            const MeshRange& cube = GetSharedMeshes().cube;
+            GL(glDrawElementsInstanced(GL_TRIANGLES, GLsizei(cube.indexCount), GL_UNSIGNED_SHORT,
+                                       reinterpret_cast<const void*>(sizeof(uint16_t) * cube.firstIndex), GLsizei(m_instanceMvps.size())));
+        }
+
+        if (hands != nullptr && !hands->empty()) {
+            // Only the palettes change from hand to hand; the meshes stay in GPU memory.
+            GL(glUseProgram(m_skinnedProgram));
+            GL(glUniformMatrix4fv(m_skinnedViewProjection, 1, GL_FALSE, vp.m));
+            GL(glBindVertexArray(m_handVao));
+            const HandMeshes& handMeshes = GetHandMeshes();
+            for (const SkinnedHand& hand : *hands) {
+                const MeshRange& range = handMeshes.Range(hand.hand);
+                GL(glUniformMatrix4fv(m_skinnedBonePalette, GLsizei(HandBoneCount), GL_FALSE, hand.bonePalette[0].m));
+                GL(glDrawElements(GL_TRIANGLES, GLsizei(range.indexCount), GL_UNSIGNED_SHORT,
+                                  reinterpret_cast<const void*>(sizeof(uint16_t) * range.firstIndex)));
+            }
         }
 
         GL(glBindVertexArray(0));
         GL(glUseProgram(0));
         GL(glDisable(GL_SCISSOR_TEST));
+
+        if (multisample) {
+            // Resolve the view's rect into the swapchain image, then tell a tiler that none of the multisampled
+            // contents need to be written back to memory.
+            GL(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_swapchainFramebuffer));
+            GL(glBlitFramebuffer(x, y, x + w, y + h, x, y, x + w, y + h, GL_COLOR_BUFFER_BIT, GL_NEAREST));
+            const GLenum attachments[] = {GL_COLOR_ATTACHMENT0, GL_DEPTH_ATTACHMENT};
+            GL(glBindFramebuffer(GL_FRAMEBUFFER, m_multisampleFramebuffer));
+            GL(glInvalidateFramebuffer(GL_FRAMEBUFFER, 2, attachments));
+        }
         GL(glBindFramebuffer(GL_FRAMEBUFFER, 0));
     }
 
+    bool OpenGLESGraphicsPlugin::SetRenderSampleCount(uint32_t sampleCount)
+    {
+        if (sampleCount != 1) {
+            GLint maxSamples = 0;
+            if (deviceInitialized) {
+                GL(glGetIntegerv(GL_MAX_SAMPLES, &maxSamples));
+            }
+            if (sampleCount == 0 || (sampleCount & (sampleCount - 1)) != 0 || sampleCount > (uint32_t)maxSamples) {
+                return false;
+            }
+        }
+
+        if ((GLsizei)sampleCount != m_renderSampleCount) {
+            ReleaseMultisampleFramebuffer();
+            m_renderSampleCount = (GLsizei)sampleCount;
+        }
+        return true;
+    }
+
+    void OpenGLESGraphicsPlugin::BindMultisampleFramebuffer(const XrSwapchainCreateInfo& createInfo)
+    {
+        const GLsizei width = (GLsizei)createInfo.width;
+        const GLsizei height = (GLsizei)createInfo.height;
+        const GLenum format = (GLenum)createInfo.format;
+        if (m_multisampleFramebuffer != 0 && m_multisampleWidth == width && m_multisampleHeight == height &&
+            m_multisampleFormat == format) {
+            GL(glBindFramebuffer(GL_FRAMEBUFFER, m_multisampleFramebuffer));
+            return;
+        }
+        ReleaseMultisampleFramebuffer();
+
+        GL(glGenRenderbuffers(1, &m_multisampleColor));
+        GL(glBindRenderbuffer(GL_RENDERBUFFER, m_multisampleColor));
+        GL(glRenderbufferStorageMultisample(GL_RENDERBUFFER, m_renderSampleCount, format, width, height));
+        GL(glGenRenderbuffers(1, &m_multisampleDepth));
+        GL(glBindRenderbuffer(GL_RENDERBUFFER, m_multisampleDepth));
+        GL(glRenderbufferStorageMultisample(GL_RENDERBUFFER, m_renderSampleCount, GL_DEPTH_COMPONENT24, width, height));
+        GL(glBindRenderbuffer(GL_RENDERBUFFER, 0));
+
+        GL(glGenFramebuffers(1, &m_multisampleFramebuffer));
+        GL(glBindFramebuffer(GL_FRAMEBUFFER, m_multisampleFramebuffer));
+        GL(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_multisampleColor));
+        GL(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_multisampleDepth));
+
+        m_multisampleWidth = width;
+        m_multisampleHeight = height;
+        m_multisampleFormat = format;
+    }
+
+    void OpenGLESGraphicsPlugin::ReleaseMultisampleFramebuffer()
+    {
+        if (m_multisampleFramebuffer != 0) {
+            GL(glDeleteFramebuffers(1, &m_multisampleFramebuffer));
+            m_multisampleFramebuffer = 0;
+        }
+        if (m_multisampleColor != 0) {
+            GL(glDeleteRenderbuffers(1, &m_multisampleColor));
+            m_multisampleColor = 0;
+        }
+        if (m_multisampleDepth != 0) {
+            GL(glDeleteRenderbuffers(1, &m_multisampleDepth));
+            m_multisampleDepth = 0;
+        }
+    }
+
+    bool OpenGLESGraphicsPlugin::SetGpuTimingEnabled(bool enabled)
+    {
+        if (!enabled) {
+            m_gpuTimingEnabled = false;
+            return true;
+        }
+        // Timestamps come from GL_EXT_disjoint_timer_query, which is optional.
+        if (!deviceInitialized || glQueryCounter == nullptr || glGetQueryObjectui64v == nullptr) {
+            return false;
+        }
+
+        if (m_timestampQueries.empty()) {
+            std::vector<GLuint> queries(2 * TimestampPairCount);
+            GL(glGenQueries(GLsizei(queries.size()), queries.data()));
+            m_timestampQueries = std::move(queries);
+            m_timestampRing.Reset(TimestampPairCount);
+        }
+        // Reading GL_GPU_DISJOINT clears it, so that an earlier clock change doesn't discard the first results.
+        GLint disjointOccurred = 0;
+        GL(glGetIntegerv(GL_GPU_DISJOINT, &disjointOccurred));
+        m_gpuTimingEnabled = true;
+        return true;
+    }
+
+    OpenGLESGraphicsPlugin::GpuTimingScope::GpuTimingScope(OpenGLESGraphicsPlugin& plugin, const char* scope)
+        : plugin(plugin), pair(plugin.m_gpuTimingEnabled ? plugin.m_timestampRing.Begin(scope) : GpuTimestampRing::NoPair)
+    {
+        if (pair != GpuTimestampRing::NoPair) {
+            GL(glQueryCounter(plugin.m_timestampQueries[2 * pair], GL_TIMESTAMP));
+        }
+    }
+
+    OpenGLESGraphicsPlugin::GpuTimingScope::~GpuTimingScope()
+    {
+        if (pair != GpuTimestampRing::NoPair) {
+            GL(glQueryCounter(plugin.m_timestampQueries[2 * pair + 1], GL_TIMESTAMP));
+        }
+    }
+
+    void OpenGLESGraphicsPlugin::CollectGpuTimings(std::vector<GpuTimingSample>& samples)
+    {
+        if (m_timestampQueries.empty()) {
+            return;
+        }
+
+        m_timestampRing.Collect(
+            [&](uint32_t pair, int64_t* nanoseconds) {
+                // Queries complete in order, so the end timestamp being available means the begin one is too.
+                GLuint available = GL_FALSE;
+                GL(glGetQueryObjectuiv(m_timestampQueries[2 * pair + 1], GL_QUERY_RESULT_AVAILABLE, &available));
+                if (available == GL_FALSE) {
+                    return GpuTimestampRing::ReadResult::NotReady;
+                }
+                // GL_GPU_DISJOINT is set, and cleared by reading it, if the GPU clock changed since it was last read.
+                GLint disjointOccurred = 0;
+                GL(glGetIntegerv(GL_GPU_DISJOINT, &disjointOccurred));
+                if (disjointOccurred != 0) {
+                    return GpuTimestampRing::ReadResult::Discarded;
+                }
+                GLuint64 begin = 0;
+                GLuint64 end = 0;
+                GL(glGetQueryObjectui64v(m_timestampQueries[2 * pair], GL_QUERY_RESULT, &begin));
+                GL(glGetQueryObjectui64v(m_timestampQueries[2 * pair + 1], GL_QUERY_RESULT, &end));
+                // GL timestamps are already in nanoseconds.
+                *nanoseconds = int64_t(end - begin);
+                return GpuTimestampRing::ReadResult::Ready;
+            },
+            samples);
+    }
+
 }  // namespace Conformance
 
 #endif  // XR_USE_GRAPHICS_API_OPENGL_ES
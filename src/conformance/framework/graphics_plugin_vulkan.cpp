@@ -18,27 +18,47 @@
 
 #ifdef XR_USE_GRAPHICS_API_VULKAN
 
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <iterator>
 #include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <unordered_map>
 #include <unordered_set>
 #include "report.h"
 #include "hex_and_handles.h"
 #include "swapchain_parameters.h"
 #include "conformance_framework.h"
+#include "view_worker_pool.h"
 #include "xr_dependencies.h"
 #include "Geometry.h"
+#include "mesh_buffer.h"
+#include "projection_cache.h"
+#include "trace_scope.h"
 #include <common/xr_linear.h>
 #include <openxr/openxr_platform.h>
 
-//#define USE_ONLINE_VULKAN_SHADERC
+// USE_ONLINE_VULKAN_SHADERC is defined by the BUILD_CONFORMANCE_VULKAN_SHADERC CMake option, to compile
+// vulkan_shaders/*.glsl at run time instead of using the SPIR-V compiled with the build.
 #ifdef USE_ONLINE_VULKAN_SHADERC
 #include <shaderc/shaderc.hpp>
 #endif
 
-#if defined(VK_USE_PLATFORM_WIN32_KHR)
-// Define USE_MIRROR_WINDOW to open an otherwise-unused window for e.g. RenderDoc
+#if defined(VK_USE_PLATFORM_WIN32_KHR) || defined(XR_USE_PLATFORM_XLIB)
+// Define USE_MIRROR_WINDOW to open a window that mirrors the rendered views, e.g. for RenderDoc
 //#define USE_MIRROR_WINDOW
 #endif
 
+#if defined(USE_MIRROR_WINDOW) && defined(XR_USE_PLATFORM_XLIB) && !defined(VK_USE_PLATFORM_XLIB_KHR)
+// graphics_plugin.h only enables the Win32 and Android WSI; xr_dependencies.h has already included Xlib.
+#define VK_USE_PLATFORM_XLIB_KHR
+#include <vulkan/vulkan_xlib.h>
+#endif
+
 // Define USE_CHECKPOINTS to use the nvidia checkpoint extension
 //#define USE_CHECKPOINTS
 
@@ -170,95 +190,390 @@ namespace Conformance
         return res;
     }
 
+    // The layout CopyRGBAImage stages texels of the format in, since vkCmdCopyBufferToImage does not convert them.
+    // Formats it does not know get R8G8B8A8.
+    static RGBATexelLayout GetVkRGBATexelLayout(VkFormat format)
+    {
+        switch (format) {
+        case VK_FORMAT_B8G8R8A8_UNORM:
+        case VK_FORMAT_B8G8R8A8_SRGB:
+            return RGBATexelLayout::B8G8R8A8;
+        case VK_FORMAT_R16G16B16A16_SFLOAT:
+            return RGBATexelLayout::R16G16B16A16Float;
+        case VK_FORMAT_R32G32B32A32_SFLOAT:
+            return RGBATexelLayout::R32G32B32A32Float;
+        case VK_FORMAT_A2B10G10R10_UNORM_PACK32:
+            return RGBATexelLayout::R10G10B10A2;
+        default:
+            return RGBATexelLayout::R8G8B8A8;
+        }
+    }
+
 // XXX These really shouldn't have trailing ';'s
 #define XRC_THROW_VK(res, cmd) ThrowVkResult(res, #cmd, XRC_FILE_AND_LINE);
 #define XRC_CHECK_THROW_VKCMD(cmd) CheckThrowVkResult(cmd, #cmd, XRC_FILE_AND_LINE);
 #define XRC_CHECK_THROW_VKRESULT(res, cmdStr) CheckThrowVkResult(res, cmdStr, XRC_FILE_AND_LINE);
 
 #ifdef USE_ONLINE_VULKAN_SHADERC
+    // vulkan_shaders/*.glsl, wrapped in raw string literals by CMake.
     constexpr char VertexShaderGlsl[] =
-        R"_(
-    #version 430
-    #extension GL_ARB_separate_shader_objects : enable
+#include "vert.glsl.inc"
+        ;
 
-    layout (std140, push_constant) uniform buf
-    {
-        mat4 mvp;
-    } ubuf;
+    constexpr char FragmentShaderGlsl[] =
+#include "frag.glsl.inc"
+        ;
+#else
+    // SPIR-V compiled from vulkan_shaders/*.glsl by the build.
+    constexpr uint32_t VertexShaderSpirv[] = SPV_PREFIX
+#include "vert.spv"
+        SPV_SUFFIX;
 
-    layout (location = 0) in vec3 Position;
-    layout (location = 1) in vec3 Color;
+    constexpr uint32_t FragmentShaderSpirv[] = SPV_PREFIX
+#include "frag.spv"
+        SPV_SUFFIX;
+#endif  // USE_ONLINE_VULKAN_SHADERC
 
-    layout (location = 0) out vec4 oColor;
-    out gl_PerVertex
+    // MemoryAllocation - a range of device memory handed out by MemoryAllocator. Bind resources at
+    // memory/offset. mapped points at offset for host visible memory, which stays mapped.
+    struct MemoryAllocation
     {
-        vec4 gl_Position;
+        VkDeviceMemory memory{VK_NULL_HANDLE};
+        VkDeviceSize offset{0};
+        VkDeviceSize size{0};
+        uint8_t* mapped{nullptr};
+
+    private:
+        friend struct MemoryAllocator;
+        void* block{nullptr};  // Owning MemoryAllocator block, or null for a dedicated allocation.
     };
 
-    void main()
+    // MemoryAllocator - sub-allocates buffers and images out of large per-memory-type blocks, so the
+    // plugin stays well under driver allocation count limits however many swapchains a test creates.
+    // Free ranges are kept per block, ordered by offset, and coalesced on free. Requests larger than
+    // half a block get a dedicated allocation. Linear resources (buffers) and optimal images never
+    // share a block, so bufferImageGranularity does not need to be considered.
+    struct MemoryAllocator
     {
-        oColor.rgba  = Color.rgba;
-        gl_Position = ubuf.mvp * Position;
-    }
-)_";
-
-    constexpr char FragmentShaderGlsl[] =
-        R"_(
-    #version 430
-    #extension GL_ARB_separate_shader_objects : enable
+        static constexpr VkDeviceSize BlockSize = 16 * 1024 * 1024;
 
-    layout (location = 0) in vec4 oColor;
+        MemoryAllocator() = default;
 
-    layout (location = 0) out vec4 FragColor;
+        MemoryAllocator(const MemoryAllocator&) = delete;
+        MemoryAllocator& operator=(const MemoryAllocator&) = delete;
 
-    void main()
-    {
-        FragColor = oColor;
-    }
-)_";
-#endif  // USE_ONLINE_VULKAN_SHADERC
+        ~MemoryAllocator()
+        {
+            Reset();
+        }
 
-    struct MemoryAllocator
-    {
         void Init(VkPhysicalDevice physicalDevice, VkDevice device)
         {
             m_vkDevice = device;
             vkGetPhysicalDeviceMemoryProperties(physicalDevice, &m_memProps);
         }
 
+        // Frees every block. All allocations must have been freed, or their resources destroyed, first.
         void Reset()
         {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_vkDevice != VK_NULL_HANDLE) {
+                for (auto& block : m_blocks) {
+                    FreeMemory(block->memory, block->mapped);
+                }
+            }
+            m_blocks.clear();
+            m_memoryTypeCache.clear();
             m_memProps = {};
             m_vkDevice = VK_NULL_HANDLE;
         }
 
         static const VkFlags defaultFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
 
-        void Allocate(VkMemoryRequirements const& memReqs, VkDeviceMemory* mem, VkFlags flags = defaultFlags,
-                      const void* pNext = nullptr) const
+        // Whether one of the memory types in memoryTypeBits has all of flags.
+        bool HasMemoryType(uint32_t memoryTypeBits, VkFlags flags) const
+        {
+            for (uint32_t i = 0; i < m_memProps.memoryTypeCount; ++i) {
+                if ((memoryTypeBits & (1u << i)) != 0u && (m_memProps.memoryTypes[i].propertyFlags & flags) == flags) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // linear is true for buffers and false for optimally tiled images.
+        MemoryAllocation Allocate(VkMemoryRequirements const& memReqs, VkFlags flags = defaultFlags, bool linear = true)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            const uint32_t memoryTypeIndex = FindMemoryType(memReqs.memoryTypeBits, flags);
+
+            MemoryAllocation allocation;
+            if (memReqs.size > BlockSize / 2) {
+                allocation.memory = AllocateMemory(memoryTypeIndex, memReqs.size, &allocation.mapped);
+                allocation.size = memReqs.size;
+                return allocation;
+            }
+
+            for (auto& block : m_blocks) {
+                if (block->memoryTypeIndex == memoryTypeIndex && block->linear == linear &&
+                    block->TryAllocate(memReqs.size, memReqs.alignment, &allocation)) {
+                    return allocation;
+                }
+            }
+
+            m_blocks.push_back(std::unique_ptr<Block>(new Block()));
+            Block& block = *m_blocks.back();
+            block.memoryTypeIndex = memoryTypeIndex;
+            block.linear = linear;
+            block.memory = AllocateMemory(memoryTypeIndex, BlockSize, &block.mapped);
+            block.freeRanges[0] = BlockSize;
+            XRC_CHECK_THROW(block.TryAllocate(memReqs.size, memReqs.alignment, &allocation));
+            return allocation;
+        }
+
+        // Returns the range to its block, or frees a dedicated allocation. Resets the allocation.
+        void Free(MemoryAllocation& allocation)
+        {
+            if (allocation.memory != VK_NULL_HANDLE) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (allocation.block != nullptr) {
+                    static_cast<Block*>(allocation.block)->Free(allocation.offset, allocation.size);
+                }
+                else {
+                    FreeMemory(allocation.memory, allocation.mapped);
+                }
+            }
+            allocation = {};
+        }
+
+    private:
+        struct Block
+        {
+            VkDeviceMemory memory{VK_NULL_HANDLE};
+            uint8_t* mapped{nullptr};
+            uint32_t memoryTypeIndex{0};
+            bool linear{true};
+            std::map<VkDeviceSize, VkDeviceSize> freeRanges;  // offset -> size
+
+            bool TryAllocate(VkDeviceSize size, VkDeviceSize alignment, MemoryAllocation* allocation)
+            {
+                for (auto it = freeRanges.begin(); it != freeRanges.end(); ++it) {
+                    const VkDeviceSize rangeStart = it->first;
+                    const VkDeviceSize rangeEnd = it->first + it->second;
+                    const VkDeviceSize start = (rangeStart + alignment - 1) / alignment * alignment;
+                    if (start + size > rangeEnd) {
+                        continue;
+                    }
+
+                    freeRanges.erase(it);
+                    if (start > rangeStart) {
+                        freeRanges[rangeStart] = start - rangeStart;
+                    }
+                    if (start + size < rangeEnd) {
+                        freeRanges[start + size] = rangeEnd - (start + size);
+                    }
+
+                    allocation->memory = memory;
+                    allocation->offset = start;
+                    allocation->size = size;
+                    allocation->mapped = mapped != nullptr ? mapped + start : nullptr;
+                    allocation->block = this;
+                    return true;
+                }
+                return false;
+            }
+
+            void Free(VkDeviceSize offset, VkDeviceSize size)
+            {
+                auto it = freeRanges.emplace(offset, size).first;
+
+                auto next = std::next(it);
+                if (next != freeRanges.end() && it->first + it->second == next->first) {
+                    it->second += next->second;
+                    freeRanges.erase(next);
+                }
+                if (it != freeRanges.begin()) {
+                    auto prev = std::prev(it);
+                    if (prev->first + prev->second == it->first) {
+                        prev->second += it->second;
+                        freeRanges.erase(it);
+                    }
+                }
+            }
+        };
+
+        VkDevice m_vkDevice{VK_NULL_HANDLE};
+        VkPhysicalDeviceMemoryProperties m_memProps{};
+        std::vector<std::unique_ptr<Block>> m_blocks;
+        // (memoryTypeBits << 32 | flags) -> memory type index
+        std::unordered_map<uint64_t, uint32_t> m_memoryTypeCache;
+        std::mutex m_mutex;
+
+        uint32_t FindMemoryType(uint32_t memoryTypeBits, VkFlags flags)
         {
+            const uint64_t key = (uint64_t(memoryTypeBits) << 32) | flags;
+            auto it = m_memoryTypeCache.find(key);
+            if (it != m_memoryTypeCache.end()) {
+                return it->second;
+            }
+
             // Search memtypes to find first index with those properties
             for (uint32_t i = 0; i < m_memProps.memoryTypeCount; ++i) {
-                if ((memReqs.memoryTypeBits & (1 << i)) != 0u) {
+                if ((memoryTypeBits & (1 << i)) != 0u) {
                     // Type is available, does it match user properties?
                     if ((m_memProps.memoryTypes[i].propertyFlags & flags) == flags) {
-                        VkMemoryAllocateInfo memAlloc{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, pNext};
-                        memAlloc.allocationSize = memReqs.size;
-                        memAlloc.memoryTypeIndex = i;
-                        XRC_CHECK_THROW_VKCMD(vkAllocateMemory(m_vkDevice, &memAlloc, nullptr, mem));
-                        return;
+                        m_memoryTypeCache.emplace(key, i);
+                        return i;
                     }
                 }
             }
             XRC_THROW("Memory format not supported");
         }
 
+        // Host visible memory is mapped for its whole lifetime, since a VkDeviceMemory can only be mapped once.
+        VkDeviceMemory AllocateMemory(uint32_t memoryTypeIndex, VkDeviceSize size, uint8_t** mapped)
+        {
+            VkMemoryAllocateInfo memAlloc{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+            memAlloc.allocationSize = size;
+            memAlloc.memoryTypeIndex = memoryTypeIndex;
+            VkDeviceMemory memory{VK_NULL_HANDLE};
+            XRC_CHECK_THROW_VKCMD(vkAllocateMemory(m_vkDevice, &memAlloc, nullptr, &memory));
+
+            *mapped = nullptr;
+            if ((m_memProps.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0) {
+                XRC_CHECK_THROW_VKCMD(vkMapMemory(m_vkDevice, memory, 0, VK_WHOLE_SIZE, 0, (void**)mapped));
+            }
+            return memory;
+        }
+
+        void FreeMemory(VkDeviceMemory memory, uint8_t* mapped)
+        {
+            if (mapped != nullptr) {
+                vkUnmapMemory(m_vkDevice, memory);
+            }
+            vkFreeMemory(m_vkDevice, memory, nullptr);
+        }
+    };
+
+    // SubmissionTracker - numbers every submission made through a CmdBuffer with the value it signals on one
+    // VK_KHR_timeline_semaphore timeline. Whether a submission, and everything it used, has retired is then a
+    // comparison against the timeline's counter instead of a query of a fence per command buffer. It is left
+    // uninitialized on devices without timeline semaphores, and CmdBuffer falls back to its own fence.
+    struct SubmissionTracker
+    {
+        SubmissionTracker() = default;
+
+        SubmissionTracker(const SubmissionTracker&) = delete;
+        SubmissionTracker& operator=(const SubmissionTracker&) = delete;
+        SubmissionTracker(SubmissionTracker&&) = delete;
+        SubmissionTracker& operator=(SubmissionTracker&&) = delete;
+
+        ~SubmissionTracker()
+        {
+            Reset();
+        }
+
+        // The device must have been created with the timelineSemaphore feature enabled.
+        void Init(VkDevice device)
+        {
+            Reset();
+            auto getCounterValue = (PFN_vkGetSemaphoreCounterValueKHR)vkGetDeviceProcAddr(device, "vkGetSemaphoreCounterValueKHR");
+            auto waitSemaphores = (PFN_vkWaitSemaphoresKHR)vkGetDeviceProcAddr(device, "vkWaitSemaphoresKHR");
+            if (getCounterValue == nullptr || waitSemaphores == nullptr) {
+                return;
+            }
+
+            VkSemaphoreTypeCreateInfoKHR typeInfo{VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR};
+            typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE_KHR;
+            typeInfo.initialValue = 0;
+            VkSemaphoreCreateInfo semInfo{VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+            semInfo.pNext = &typeInfo;
+            XRC_CHECK_THROW_VKCMD(vkCreateSemaphore(device, &semInfo, nullptr, &m_timeline));
+
+            m_vkDevice = device;
+            m_vkGetSemaphoreCounterValueKHR = getCounterValue;
+            m_vkWaitSemaphoresKHR = waitSemaphores;
+            m_lastSubmitted = 0;
+            m_lastCompleted = 0;
+        }
+
+        // Callers must have waited for every submission that signals the timeline.
+        void Reset()
+        {
+            if (m_timeline != VK_NULL_HANDLE) {
+                vkDestroySemaphore(m_vkDevice, m_timeline, nullptr);
+            }
+            m_timeline = VK_NULL_HANDLE;
+            m_vkDevice = VK_NULL_HANDLE;
+            m_vkGetSemaphoreCounterValueKHR = nullptr;
+            m_vkWaitSemaphoresKHR = nullptr;
+        }
+
+        bool IsTimeline() const
+        {
+            return m_timeline != VK_NULL_HANDLE;
+        }
+
+        VkSemaphore Timeline() const
+        {
+            return m_timeline;
+        }
+
+        // The value of the most recent submission, which work on another queue can wait for. Zero before the first.
+        uint64_t LastSubmitted() const
+        {
+            return m_lastSubmitted;
+        }
+
+        // Reserves the value the next submission signals. Submissions must reach the queue in the order of their values.
+        uint64_t NextValue()
+        {
+            return ++m_lastSubmitted;
+        }
+
+        // Returns true if the GPU has reached value, only asking the device when the cached counter is behind it.
+        bool IsComplete(uint64_t value)
+        {
+            if (value <= m_lastCompleted) {
+                return true;
+            }
+            uint64_t counter = 0;
+            XRC_CHECK_THROW_VKCMD(m_vkGetSemaphoreCounterValueKHR(m_vkDevice, m_timeline, &counter));
+            m_lastCompleted = std::max(m_lastCompleted, counter);
+            return value <= m_lastCompleted;
+        }
+
+        // Waits up to timeoutNs for the GPU to reach value, returning false if it times out.
+        bool Wait(uint64_t value, uint64_t timeoutNs)
+        {
+            if (IsComplete(value)) {
+                return true;
+            }
+            VkSemaphoreWaitInfoKHR waitInfo{VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR};
+            waitInfo.semaphoreCount = 1;
+            waitInfo.pSemaphores = &m_timeline;
+            waitInfo.pValues = &value;
+            VkResult res = m_vkWaitSemaphoresKHR(m_vkDevice, &waitInfo, timeoutNs);
+            if (res == VK_TIMEOUT) {
+                return false;
+            }
+            XRC_CHECK_THROW_VKRESULT(res, "vkWaitSemaphoresKHR");
+            m_lastCompleted = std::max(m_lastCompleted, value);
+            return true;
+        }
+
     private:
         VkDevice m_vkDevice{VK_NULL_HANDLE};
-        VkPhysicalDeviceMemoryProperties m_memProps{};
+        VkSemaphore m_timeline{VK_NULL_HANDLE};
+        PFN_vkGetSemaphoreCounterValueKHR m_vkGetSemaphoreCounterValueKHR{nullptr};
+        PFN_vkWaitSemaphoresKHR m_vkWaitSemaphoresKHR{nullptr};
+        uint64_t m_lastSubmitted{0};
+        uint64_t m_lastCompleted{0};
     };
 
     // CmdBuffer - manage VkCommandBuffer state
+    // Submissions are tracked on the SubmissionTracker's timeline when it is given one, or else with execFence.
     struct CmdBuffer
     {
         enum class CmdBufferState
@@ -299,6 +614,8 @@ namespace Conformance
             buf = VK_NULL_HANDLE;
             pool = VK_NULL_HANDLE;
             execFence = VK_NULL_HANDLE;
+            m_tracker = nullptr;
+            m_submitValue = 0;
             m_vkDevice = nullptr;
         }
 
@@ -307,11 +624,12 @@ namespace Conformance
             Reset();
         }
 
-        bool Init(VkDevice device, uint32_t queueFamilyIndex)
+        bool Init(VkDevice device, uint32_t queueFamilyIndex, SubmissionTracker* tracker = nullptr)
         {
             XRC_CHECK_THROW((state == CmdBufferState::Undefined) || (state == CmdBufferState::Initialized))
 
             m_vkDevice = device;
+            m_tracker = (tracker != nullptr && tracker->IsTimeline()) ? tracker : nullptr;
 
             // Create a command pool to allocate our command buffer from
             VkCommandPoolCreateInfo cmdPoolInfo{VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO};
@@ -326,8 +644,10 @@ namespace Conformance
             cmd.commandBufferCount = 1;
             XRC_CHECK_THROW_VKCMD(vkAllocateCommandBuffers(m_vkDevice, &cmd, &buf));
 
-            VkFenceCreateInfo fenceInfo{VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
-            XRC_CHECK_THROW_VKCMD(vkCreateFence(m_vkDevice, &fenceInfo, nullptr, &execFence));
+            if (m_tracker == nullptr) {
+                VkFenceCreateInfo fenceInfo{VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
+                XRC_CHECK_THROW_VKCMD(vkCreateFence(m_vkDevice, &fenceInfo, nullptr, &execFence));
+            }
 
             SetState(CmdBufferState::Initialized);
             return true;
@@ -350,13 +670,42 @@ namespace Conformance
             return true;
         }
 
-        bool Exec(VkQueue queue)
+        // waitValue is the value to wait for when waitSemaphore is a timeline semaphore, and must be zero otherwise.
+        bool Exec(VkQueue queue, VkSemaphore waitSemaphore = VK_NULL_HANDLE, VkPipelineStageFlags waitStage = 0,
+                  VkSemaphore signalSemaphore = VK_NULL_HANDLE, uint64_t waitValue = 0)
         {
             XRC_CHECK_THROW(state == CmdBufferState::Executable);
 
             VkSubmitInfo submitInfo{VK_STRUCTURE_TYPE_SUBMIT_INFO};
+            if (waitSemaphore != VK_NULL_HANDLE) {
+                submitInfo.waitSemaphoreCount = 1;
+                submitInfo.pWaitSemaphores = &waitSemaphore;
+                submitInfo.pWaitDstStageMask = &waitStage;
+            }
             submitInfo.commandBufferCount = 1;
             submitInfo.pCommandBuffers = &buf;
+
+            // The binary signalSemaphore, if any, comes first; its value is ignored.
+            VkSemaphore signalSemaphores[2] = {signalSemaphore, VK_NULL_HANDLE};
+            uint64_t signalValues[2] = {0, 0};
+            uint32_t signalCount = (signalSemaphore != VK_NULL_HANDLE) ? 1 : 0;
+            VkTimelineSemaphoreSubmitInfoKHR timelineInfo{VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR};
+            if (waitValue != 0) {
+                timelineInfo.waitSemaphoreValueCount = 1;
+                timelineInfo.pWaitSemaphoreValues = &waitValue;
+                submitInfo.pNext = &timelineInfo;
+            }
+            if (m_tracker != nullptr) {
+                m_submitValue = m_tracker->NextValue();
+                signalSemaphores[signalCount] = m_tracker->Timeline();
+                signalValues[signalCount] = m_submitValue;
+                ++signalCount;
+                timelineInfo.signalSemaphoreValueCount = signalCount;
+                timelineInfo.pSignalSemaphoreValues = signalValues;
+                submitInfo.pNext = &timelineInfo;
+            }
+            submitInfo.signalSemaphoreCount = signalCount;
+            submitInfo.pSignalSemaphores = signalCount > 0 ? signalSemaphores : nullptr;
             XRC_CHECK_THROW_VKCMD(vkQueueSubmit(queue, 1, &submitInfo, execFence));
 
             SetState(CmdBufferState::Executing);
@@ -374,8 +723,9 @@ namespace Conformance
 
             const uint32_t timeoutNs = 1 * 1000 * 1000 * 1000;
             for (int i = 0; i < 5; ++i) {
-                auto res = vkWaitForFences(m_vkDevice, 1, &execFence, VK_TRUE, timeoutNs);
-                if (res == VK_SUCCESS) {
+                const bool done = (m_tracker != nullptr) ? m_tracker->Wait(m_submitValue, timeoutNs)
+                                                         : vkWaitForFences(m_vkDevice, 1, &execFence, VK_TRUE, timeoutNs) == VK_SUCCESS;
+                if (done) {
                     // Buffer can be executed multiple times...
                     SetState(CmdBufferState::Executable);
                     return true;
@@ -386,12 +736,36 @@ namespace Conformance
             return false;
         }
 
+        // Returns true without blocking if the buffer is not in flight, retiring a submission that has completed.
+        bool Poll()
+        {
+            if (state != CmdBufferState::Executing) {
+                return true;
+            }
+            if (m_tracker != nullptr) {
+                if (!m_tracker->IsComplete(m_submitValue)) {
+                    return false;
+                }
+                SetState(CmdBufferState::Executable);
+                return true;
+            }
+            VkResult res = vkGetFenceStatus(m_vkDevice, execFence);
+            if (res == VK_NOT_READY) {
+                return false;
+            }
+            XRC_CHECK_THROW_VKRESULT(res, "vkGetFenceStatus");
+            SetState(CmdBufferState::Executable);
+            return true;
+        }
+
         bool Clear()
         {
             if (state != CmdBufferState::Initialized) {
                 XRC_CHECK_THROW(state == CmdBufferState::Executable);
 
-                XRC_CHECK_THROW_VKCMD(vkResetFences(m_vkDevice, 1, &execFence));
+                if (execFence != VK_NULL_HANDLE) {
+                    XRC_CHECK_THROW_VKCMD(vkResetFences(m_vkDevice, 1, &execFence));
+                }
                 XRC_CHECK_THROW_VKCMD(vkResetCommandBuffer(buf, 0));
 
                 SetState(CmdBufferState::Initialized);
@@ -400,8 +774,22 @@ namespace Conformance
             return true;
         }
 
+        // Waits for any in-flight execution to complete and returns the buffer to the Initialized state.
+        bool Recycle()
+        {
+            if (state == CmdBufferState::Executing) {
+                if (!Wait()) {
+                    return false;
+                }
+            }
+            return Clear();
+        }
+
     private:
         VkDevice m_vkDevice{VK_NULL_HANDLE};
+        SubmissionTracker* m_tracker{nullptr};
+        // The timeline value of the last Exec, when tracked by m_tracker.
+        uint64_t m_submitValue{0};
 
         void SetState(CmdBufferState newState)
         {
@@ -409,6 +797,182 @@ namespace Conformance
         }
     };
 
+    // CmdBufferRing - a fixed set of command buffers used round-robin, one per submission.
+    // A buffer's fence is only waited on when the ring wraps back around to it, so up to
+    // FramesInFlight submissions can execute while the next one is being recorded.
+    struct CmdBufferRing
+    {
+        static constexpr uint32_t FramesInFlight = 3;
+
+        CmdBufferRing() = default;
+
+        CmdBufferRing(const CmdBufferRing&) = delete;
+        CmdBufferRing& operator=(const CmdBufferRing&) = delete;
+        CmdBufferRing(CmdBufferRing&&) = delete;
+        CmdBufferRing& operator=(CmdBufferRing&&) = delete;
+
+        bool Init(VkDevice device, uint32_t queueFamilyIndex, SubmissionTracker* tracker)
+        {
+            for (auto& cmdBuffer : m_cmdBuffers) {
+                if (!cmdBuffer.Init(device, queueFamilyIndex, tracker)) {
+                    return false;
+                }
+            }
+            m_current = 0;
+            return true;
+        }
+
+        void Reset()
+        {
+            for (auto& cmdBuffer : m_cmdBuffers) {
+                cmdBuffer.Reset();
+            }
+            m_current = 0;
+        }
+
+        // Advances to the next command buffer, waiting for its previous submission if it is
+        // still executing, and returns it ready for Begin().
+        CmdBuffer& Acquire()
+        {
+            m_current = (m_current + 1) % FramesInFlight;
+            CmdBuffer& cmdBuffer = m_cmdBuffers[m_current];
+            XRC_CHECK_THROW_MSG(cmdBuffer.Recycle(), "Timed out waiting for an in-flight command buffer");
+            return cmdBuffer;
+        }
+
+        // The command buffer most recently returned by Acquire.
+        CmdBuffer& Current()
+        {
+            return m_cmdBuffers[m_current];
+        }
+
+        // Index of Current() in the ring, for keying per-frame resources guarded by its fence.
+        uint32_t CurrentIndex() const
+        {
+            return m_current;
+        }
+
+        // Blocks until every submission made from the ring has completed.
+        void WaitAll()
+        {
+            for (auto& cmdBuffer : m_cmdBuffers) {
+                if (cmdBuffer.state == CmdBuffer::CmdBufferState::Executing) {
+                    XRC_CHECK_THROW_MSG(cmdBuffer.Wait(), "Timed out waiting for an in-flight command buffer");
+                }
+            }
+        }
+
+    private:
+        std::array<CmdBuffer, FramesInFlight> m_cmdBuffers{};
+        uint32_t m_current{0};
+    };
+
+    // ViewRecorder - records the views of one RenderViews call into secondary command buffers on a ViewWorkerPool, for
+    // Options::vulkanRecordThreads. A command pool may only be used by one thread at a time, so every worker has its own
+    // pool for each slot of the CmdBufferRing. A slot's pools are reset when the slot comes around again; by then the
+    // ring has waited on the primary buffer that executed the slot's secondary buffers.
+    struct ViewRecorder
+    {
+        // Records one view into a secondary command buffer that has not been begun yet.
+        using RecordView = std::function<void(uint32_t view, VkCommandBuffer buf)>;
+
+        ViewRecorder() = default;
+
+        ViewRecorder(const ViewRecorder&) = delete;
+        ViewRecorder& operator=(const ViewRecorder&) = delete;
+        ViewRecorder(ViewRecorder&&) = delete;
+        ViewRecorder& operator=(ViewRecorder&&) = delete;
+
+        ~ViewRecorder()
+        {
+            Reset();
+        }
+
+        bool IsRunning() const
+        {
+            return m_workerPool.IsRunning();
+        }
+
+        void Init(VkDevice device, uint32_t queueFamilyIndex, uint32_t threadCount)
+        {
+            XRC_CHECK_THROW(!IsRunning());
+            m_vkDevice = device;
+            m_workers.resize(threadCount);
+            for (Worker& worker : m_workers) {
+                for (VkCommandPool& pool : worker.pools) {
+                    VkCommandPoolCreateInfo cmdPoolInfo{VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO};
+                    cmdPoolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+                    cmdPoolInfo.queueFamilyIndex = queueFamilyIndex;
+                    XRC_CHECK_THROW_VKCMD(vkCreateCommandPool(m_vkDevice, &cmdPoolInfo, nullptr, &pool));
+                }
+            }
+            m_workerPool.Start(threadCount);
+        }
+
+        // Stops the workers and destroys their pools. The device must be idle.
+        void Reset()
+        {
+            m_workerPool.Stop();
+            for (Worker& worker : m_workers) {
+                for (VkCommandPool& pool : worker.pools) {
+                    if (pool != VK_NULL_HANDLE) {
+                        // Destroying the pool frees its command buffers.
+                        vkDestroyCommandPool(m_vkDevice, pool, nullptr);
+                        pool = VK_NULL_HANDLE;
+                    }
+                }
+            }
+            m_workers.clear();
+            m_vkDevice = VK_NULL_HANDLE;
+        }
+
+        // Records viewCount views with record on the workers, into secondary buffers from the pools of ring slot slot,
+        // and returns the buffers in view order once all of them have been recorded. Rethrows the first error of a worker.
+        const std::vector<VkCommandBuffer>& Record(uint32_t slot, uint32_t viewCount, const RecordView& record)
+        {
+            XRC_CHECK_THROW(IsRunning() && slot < CmdBufferRing::FramesInFlight);
+
+            // No worker is using its pools between calls.
+            for (Worker& worker : m_workers) {
+                XRC_CHECK_THROW_VKCMD(vkResetCommandPool(m_vkDevice, worker.pools[slot], 0));
+            }
+
+            m_buffers.assign(viewCount, VK_NULL_HANDLE);
+            m_workerPool.Run(viewCount, [&](uint32_t workerIndex, uint32_t view) {
+                Worker& worker = m_workers[workerIndex];
+                std::vector<VkCommandBuffer>& buffers = worker.buffers[slot];
+                // This is the worker's nth view of the call, and needs its nth buffer of the slot.
+                const size_t index = view / m_workers.size();
+                if (index == buffers.size()) {
+                    VkCommandBufferAllocateInfo cmd{VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
+                    cmd.commandPool = worker.pools[slot];
+                    cmd.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+                    cmd.commandBufferCount = 1;
+                    VkCommandBuffer buf{VK_NULL_HANDLE};
+                    XRC_CHECK_THROW_VKCMD(vkAllocateCommandBuffers(m_vkDevice, &cmd, &buf));
+                    buffers.push_back(buf);
+                }
+                record(view, buffers[index]);
+                // Each worker writes only its own views' elements.
+                m_buffers[view] = buffers[index];
+            });
+            return m_buffers;
+        }
+
+    private:
+        struct Worker
+        {
+            std::array<VkCommandPool, CmdBufferRing::FramesInFlight> pools{};
+            // Allocated from the pool of the same slot as needed, and reused once it has been reset.
+            std::array<std::vector<VkCommandBuffer>, CmdBufferRing::FramesInFlight> buffers{};
+        };
+
+        VkDevice m_vkDevice{VK_NULL_HANDLE};
+        std::vector<Worker> m_workers;
+        std::vector<VkCommandBuffer> m_buffers;
+        ViewWorkerPool m_workerPool;
+    };
+
     // ShaderProgram to hold a pair of vertex & fragment shaders
     struct ShaderProgram
     {
@@ -441,14 +1005,14 @@ namespace Conformance
         ShaderProgram(ShaderProgram&&) = delete;
         ShaderProgram& operator=(ShaderProgram&&) = delete;
 
-        void LoadVertexShader(const std::vector<uint32_t>& code)
+        void LoadVertexShader(const uint32_t* code, size_t codeWords)
         {
-            Load(0, code);
+            Load(0, code, codeWords);
         }
 
-        void LoadFragmentShader(const std::vector<uint32_t>& code)
+        void LoadFragmentShader(const uint32_t* code, size_t codeWords)
         {
-            Load(1, code);
+            Load(1, code, codeWords);
         }
 
         void Init(VkDevice device)
@@ -459,7 +1023,7 @@ namespace Conformance
     private:
         VkDevice m_vkDevice{VK_NULL_HANDLE};
 
-        void Load(uint32_t index, const std::vector<uint32_t>& code)
+        void Load(uint32_t index, const uint32_t* code, size_t codeWords)
         {
             VkShaderModuleCreateInfo modInfo{VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO};
 
@@ -480,8 +1044,8 @@ namespace Conformance
                 XRC_THROW("Unknown code index " + std::to_string(index));
             }
 
-            modInfo.codeSize = code.size() * sizeof(code[0]);
-            modInfo.pCode = &code[0];
+            modInfo.codeSize = codeWords * sizeof(code[0]);
+            modInfo.pCode = code;
             XRC_CHECK_THROW_MSG((modInfo.codeSize > 0) && modInfo.pCode, "Invalid shader " + name);
 
             XRC_CHECK_THROW_VKCMD(vkCreateShaderModule(m_vkDevice, &modInfo, nullptr, &si.module));
@@ -494,10 +1058,12 @@ namespace Conformance
     struct VertexBufferBase
     {
         VkBuffer idxBuf{VK_NULL_HANDLE};
-        VkDeviceMemory idxMem{VK_NULL_HANDLE};
+        MemoryAllocation idxMem{};
         VkBuffer vtxBuf{VK_NULL_HANDLE};
-        VkDeviceMemory vtxMem{VK_NULL_HANDLE};
+        MemoryAllocation vtxMem{};
         VkVertexInputBindingDescription bindDesc{};
+        // Optional per-instance binding, used if stride is non-zero.
+        VkVertexInputBindingDescription instanceBindDesc{};
         std::vector<VkVertexInputAttributeDescription> attrDesc{};
         struct
         {
@@ -513,101 +1079,370 @@ namespace Conformance
                 if (idxBuf != VK_NULL_HANDLE) {
                     vkDestroyBuffer(m_vkDevice, idxBuf, nullptr);
                 }
-                if (idxMem != VK_NULL_HANDLE) {
-                    vkFreeMemory(m_vkDevice, idxMem, nullptr);
-                }
                 if (vtxBuf != VK_NULL_HANDLE) {
                     vkDestroyBuffer(m_vkDevice, vtxBuf, nullptr);
                 }
-                if (vtxMem != VK_NULL_HANDLE) {
-                    vkFreeMemory(m_vkDevice, vtxMem, nullptr);
+                m_memAllocator->Free(idxMem);
+                m_memAllocator->Free(vtxMem);
+            }
+            idxBuf = VK_NULL_HANDLE;
+            vtxBuf = VK_NULL_HANDLE;
+            bindDesc = {};
+            instanceBindDesc = {};
+            attrDesc.clear();
+            count = {0, 0};
+            m_vkDevice = nullptr;
+        }
+
+        ~VertexBufferBase()
+        {
+            Reset();
+        }
+
+        VertexBufferBase(const VertexBufferBase&) = delete;
+        VertexBufferBase& operator=(const VertexBufferBase&) = delete;
+        VertexBufferBase(VertexBufferBase&&) = delete;
+        VertexBufferBase& operator=(VertexBufferBase&&) = delete;
+        void Init(VkDevice device, MemoryAllocator* memAllocator, const std::vector<VkVertexInputAttributeDescription>& attr)
+        {
+            m_vkDevice = device;
+            m_memAllocator = memAllocator;
+            attrDesc = attr;
+        }
+
+        // Adds a per-instance vertex binding, sourced from a separately bound buffer.
+        void SetInstanceBinding(uint32_t binding, uint32_t stride)
+        {
+            instanceBindDesc.binding = binding;
+            instanceBindDesc.stride = stride;
+            instanceBindDesc.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+        }
+
+    protected:
+        VkDevice m_vkDevice{VK_NULL_HANDLE};
+        void AllocateBufferMemory(VkBuffer buf, MemoryAllocation* mem)
+        {
+            VkMemoryRequirements memReq = {};
+            vkGetBufferMemoryRequirements(m_vkDevice, buf, &memReq);
+            *mem = m_memAllocator->Allocate(memReq);
+            XRC_CHECK_THROW_VKCMD(vkBindBufferMemory(m_vkDevice, buf, mem->memory, mem->offset));
+        }
+
+    private:
+        MemoryAllocator* m_memAllocator{nullptr};
+    };
+
+    // VertexBuffer template to wrap the indices and vertices
+    template <typename T>
+    struct VertexBuffer : public VertexBufferBase
+    {
+        bool Create(uint32_t idxCount, uint32_t vtxCount)
+        {
+            VkBufferCreateInfo bufInfo{VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+            bufInfo.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+            bufInfo.size = sizeof(uint16_t) * idxCount;
+            XRC_CHECK_THROW_VKCMD(vkCreateBuffer(m_vkDevice, &bufInfo, nullptr, &idxBuf));
+            AllocateBufferMemory(idxBuf, &idxMem);
+
+            bufInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+            bufInfo.size = sizeof(T) * vtxCount;
+            XRC_CHECK_THROW_VKCMD(vkCreateBuffer(m_vkDevice, &bufInfo, nullptr, &vtxBuf));
+            AllocateBufferMemory(vtxBuf, &vtxMem);
+
+            bindDesc.binding = 0;
+            bindDesc.stride = sizeof(T);
+            bindDesc.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+            count = {idxCount, vtxCount};
+
+            return true;
+        }
+
+        void UpdateIndicies(const uint16_t* data, uint32_t elements, uint32_t offset = 0)
+        {
+            uint16_t* map = reinterpret_cast<uint16_t*>(idxMem.mapped) + offset;
+            for (size_t i = 0; i < elements; ++i) {
+                map[i] = data[i];
+            }
+        }
+
+        void UpdateVertices(const T* data, uint32_t elements, uint32_t offset = 0)
+        {
+            T* map = reinterpret_cast<T*>(vtxMem.mapped) + offset;
+            for (size_t i = 0; i < elements; ++i) {
+                map[i] = data[i];
+            }
+        }
+    };
+
+    // StagingRing - a small ring of persistently mapped upload buffers, each paired with its own
+    // command buffer. The command buffer's fence guards reuse of the slot's memory, so uploads
+    // can be submitted back-to-back without draining the queue in between.
+    //
+    // A ring on a dedicated transfer queue family also gives each slot a command buffer on the family
+    // that owns the images, to acquire them once the copy has released them, and the semaphore between the two.
+    struct StagingRing
+    {
+        static constexpr uint32_t SlotCount = 3;
+
+        struct Slot
+        {
+            VkBuffer buf{VK_NULL_HANDLE};
+            MemoryAllocation mem{};
+            VkDeviceSize size{0};
+            uint8_t* mapped{nullptr};
+            CmdBuffer cmdBuffer{};
+            CmdBuffer acquireCmdBuffer{};
+            VkSemaphore copyDone{VK_NULL_HANDLE};
+        };
+
+        StagingRing() = default;
+
+        StagingRing(const StagingRing&) = delete;
+        StagingRing& operator=(const StagingRing&) = delete;
+        StagingRing(StagingRing&&) = delete;
+        StagingRing& operator=(StagingRing&&) = delete;
+
+        ~StagingRing()
+        {
+            Reset();
+        }
+
+        void Init(VkDevice device, MemoryAllocator* memAllocator, uint32_t queueFamilyIndex, SubmissionTracker* tracker,
+                  uint32_t acquireQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED, SubmissionTracker* acquireTracker = nullptr)
+        {
+            m_vkDevice = device;
+            m_memAllocator = memAllocator;
+            for (auto& slot : m_slots) {
+                if (!slot.cmdBuffer.Init(m_vkDevice, queueFamilyIndex, tracker))
+                    XRC_THROW("Failed to create staging command buffer");
+                if (acquireQueueFamilyIndex != VK_QUEUE_FAMILY_IGNORED) {
+                    if (!slot.acquireCmdBuffer.Init(m_vkDevice, acquireQueueFamilyIndex, acquireTracker))
+                        XRC_THROW("Failed to create staging acquire command buffer");
+                    VkSemaphoreCreateInfo semInfo{VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+                    XRC_CHECK_THROW_VKCMD(vkCreateSemaphore(m_vkDevice, &semInfo, nullptr, &slot.copyDone));
                 }
             }
-            idxBuf = VK_NULL_HANDLE;
-            idxMem = VK_NULL_HANDLE;
-            vtxBuf = VK_NULL_HANDLE;
-            vtxMem = VK_NULL_HANDLE;
-            bindDesc = {};
-            attrDesc.clear();
-            count = {0, 0};
-            m_vkDevice = nullptr;
+            m_next = 0;
+        }
+
+        void Reset()
+        {
+            for (auto& slot : m_slots) {
+                ReleaseBuffer(slot);
+                slot.cmdBuffer.Reset();
+                slot.acquireCmdBuffer.Reset();
+                if (slot.copyDone != VK_NULL_HANDLE) {
+                    vkDestroySemaphore(m_vkDevice, slot.copyDone, nullptr);
+                    slot.copyDone = VK_NULL_HANDLE;
+                }
+            }
+            m_next = 0;
+            m_memAllocator = nullptr;
+            m_vkDevice = VK_NULL_HANDLE;
+        }
+
+        // Returns the next slot, ready for recording, with at least requiredSize bytes mapped.
+        // Only blocks if the slot's previous upload is still executing.
+        Slot& Acquire(VkDeviceSize requiredSize)
+        {
+            Slot& slot = m_slots[m_next];
+            m_next = (m_next + 1) % SlotCount;
+
+            XRC_CHECK_THROW_MSG(slot.cmdBuffer.Recycle(), "Timed out waiting for a staging buffer upload to complete");
+            if (slot.copyDone != VK_NULL_HANDLE) {
+                XRC_CHECK_THROW_MSG(slot.acquireCmdBuffer.Recycle(), "Timed out waiting for a staging buffer upload to complete");
+            }
+
+            if (slot.size < requiredSize) {
+                ReleaseBuffer(slot);
+
+                // Grow geometrically so a series of slightly larger images doesn't reallocate every time.
+                VkDeviceSize newSize = 64 * 1024;
+                while (newSize < requiredSize) {
+                    newSize *= 2;
+                }
+
+                VkBufferCreateInfo bufInfo{VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+                bufInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+                bufInfo.size = newSize;
+                bufInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+                XRC_CHECK_THROW_VKCMD(vkCreateBuffer(m_vkDevice, &bufInfo, nullptr, &slot.buf));
+
+                VkMemoryRequirements memReq{};
+                vkGetBufferMemoryRequirements(m_vkDevice, slot.buf, &memReq);
+                slot.mem = m_memAllocator->Allocate(memReq, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+                XRC_CHECK_THROW_VKCMD(vkBindBufferMemory(m_vkDevice, slot.buf, slot.mem.memory, slot.mem.offset));
+                slot.mapped = slot.mem.mapped;
+                slot.size = newSize;
+            }
+
+            return slot;
+        }
+
+        // Blocks until every upload submitted from the ring has completed.
+        void WaitAll()
+        {
+            for (auto& slot : m_slots) {
+                WaitSlot(slot);
+            }
         }
 
-        ~VertexBufferBase()
+    private:
+        VkDevice m_vkDevice{VK_NULL_HANDLE};
+        MemoryAllocator* m_memAllocator{nullptr};
+        std::array<Slot, SlotCount> m_slots{};
+        uint32_t m_next{0};
+
+        static void WaitSlot(Slot& slot)
         {
-            Reset();
+            for (CmdBuffer* cmdBuffer : {&slot.cmdBuffer, &slot.acquireCmdBuffer}) {
+                if (cmdBuffer->state == CmdBuffer::CmdBufferState::Executing) {
+                    XRC_CHECK_THROW_MSG(cmdBuffer->Wait(), "Timed out waiting for a staging buffer upload to complete");
+                }
+            }
         }
 
-        VertexBufferBase(const VertexBufferBase&) = delete;
-        VertexBufferBase& operator=(const VertexBufferBase&) = delete;
-        VertexBufferBase(VertexBufferBase&&) = delete;
-        VertexBufferBase& operator=(VertexBufferBase&&) = delete;
-        void Init(VkDevice device, const MemoryAllocator* memAllocator, const std::vector<VkVertexInputAttributeDescription>& attr)
+        void ReleaseBuffer(Slot& slot)
         {
-            m_vkDevice = device;
-            m_memAllocator = memAllocator;
-            attrDesc = attr;
+            if (m_vkDevice != VK_NULL_HANDLE) {
+                if (slot.buf != VK_NULL_HANDLE) {
+                    vkDestroyBuffer(m_vkDevice, slot.buf, nullptr);
+                }
+                m_memAllocator->Free(slot.mem);
+            }
+            slot.mapped = nullptr;
+            slot.buf = VK_NULL_HANDLE;
+            slot.size = 0;
         }
+    };
 
-    protected:
-        VkDevice m_vkDevice{VK_NULL_HANDLE};
-        void AllocateBufferMemory(VkBuffer buf, VkDeviceMemory* mem) const
+    // ReadbackBuffer - host visible buffer and command buffer for one swapchain image readback. It is
+    // owned by the future that reads it, and waits for the copy when destroyed so that dropping an
+    // unread future does not free memory the GPU is still writing.
+    struct ReadbackBuffer
+    {
+        VkBuffer buf{VK_NULL_HANDLE};
+        MemoryAllocation mem{};
+        uint8_t* mapped{nullptr};
+        CmdBuffer cmdBuffer{};
+
+        ReadbackBuffer(VkDevice device, MemoryAllocator* memAllocator, uint32_t queueFamilyIndex, SubmissionTracker* tracker,
+                       VkDeviceSize size)
+            : m_vkDevice(device), m_memAllocator(memAllocator)
         {
-            VkMemoryRequirements memReq = {};
+            if (!cmdBuffer.Init(m_vkDevice, queueFamilyIndex, tracker))
+                XRC_THROW("Failed to create readback command buffer");
+
+            VkBufferCreateInfo bufInfo{VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+            bufInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+            bufInfo.size = size;
+            bufInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            XRC_CHECK_THROW_VKCMD(vkCreateBuffer(m_vkDevice, &bufInfo, nullptr, &buf));
+
+            VkMemoryRequirements memReq{};
             vkGetBufferMemoryRequirements(m_vkDevice, buf, &memReq);
-            m_memAllocator->Allocate(memReq, mem);
+            mem = m_memAllocator->Allocate(memReq, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+            XRC_CHECK_THROW_VKCMD(vkBindBufferMemory(m_vkDevice, buf, mem.memory, mem.offset));
+            mapped = mem.mapped;
+        }
+
+        ReadbackBuffer(const ReadbackBuffer&) = delete;
+        ReadbackBuffer& operator=(const ReadbackBuffer&) = delete;
+
+        ~ReadbackBuffer()
+        {
+            if (cmdBuffer.state == CmdBuffer::CmdBufferState::Executing) {
+                (void)cmdBuffer.Wait();
+            }
+            if (buf != VK_NULL_HANDLE) {
+                vkDestroyBuffer(m_vkDevice, buf, nullptr);
+            }
+            m_memAllocator->Free(mem);
         }
 
     private:
-        const MemoryAllocator* m_memAllocator{nullptr};
+        VkDevice m_vkDevice{VK_NULL_HANDLE};
+        MemoryAllocator* m_memAllocator{nullptr};
     };
 
-    // VertexBuffer template to wrap the indices and vertices
-    template <typename T>
-    struct VertexBuffer : public VertexBufferBase
+    // InstanceBuffer - persistently mapped, host visible vertex buffer for per-instance data that is
+    // rewritten every frame. Callers must make sure the GPU is done with it before writing again.
+    struct InstanceBuffer
     {
-        bool Create(uint32_t idxCount, uint32_t vtxCount)
-        {
-            VkBufferCreateInfo bufInfo{VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
-            bufInfo.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
-            bufInfo.size = sizeof(uint16_t) * idxCount;
-            XRC_CHECK_THROW_VKCMD(vkCreateBuffer(m_vkDevice, &bufInfo, nullptr, &idxBuf));
-            AllocateBufferMemory(idxBuf, &idxMem);
-            XRC_CHECK_THROW_VKCMD(vkBindBufferMemory(m_vkDevice, idxBuf, idxMem, 0));
+        VkBuffer buf{VK_NULL_HANDLE};
+        MemoryAllocation mem{};
+        VkDeviceSize size{0};
+        uint8_t* mapped{nullptr};
 
-            bufInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-            bufInfo.size = sizeof(T) * vtxCount;
-            XRC_CHECK_THROW_VKCMD(vkCreateBuffer(m_vkDevice, &bufInfo, nullptr, &vtxBuf));
-            AllocateBufferMemory(vtxBuf, &vtxMem);
-            XRC_CHECK_THROW_VKCMD(vkBindBufferMemory(m_vkDevice, vtxBuf, vtxMem, 0));
+        InstanceBuffer() = default;
 
-            bindDesc.binding = 0;
-            bindDesc.stride = sizeof(T);
-            bindDesc.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+        InstanceBuffer(const InstanceBuffer&) = delete;
+        InstanceBuffer& operator=(const InstanceBuffer&) = delete;
+        InstanceBuffer(InstanceBuffer&&) = delete;
+        InstanceBuffer& operator=(InstanceBuffer&&) = delete;
 
-            count = {idxCount, vtxCount};
+        ~InstanceBuffer()
+        {
+            Reset();
+        }
 
-            return true;
+        void Init(VkDevice device, MemoryAllocator* memAllocator)
+        {
+            m_vkDevice = device;
+            m_memAllocator = memAllocator;
         }
 
-        void UpdateIndicies(const uint16_t* data, uint32_t elements, uint32_t offset = 0)
+        void Reset()
         {
-            uint16_t* map = nullptr;
-            XRC_CHECK_THROW_VKCMD(vkMapMemory(m_vkDevice, idxMem, sizeof(map[0]) * offset, sizeof(map[0]) * elements, 0, (void**)&map));
-            for (size_t i = 0; i < elements; ++i) {
-                map[i] = data[i];
+            Release();
+            m_memAllocator = nullptr;
+            m_vkDevice = VK_NULL_HANDLE;
+        }
+
+        // Makes sure at least requiredSize bytes are mapped, reallocating if needed.
+        void Reserve(VkDeviceSize requiredSize)
+        {
+            if (size >= requiredSize) {
+                return;
             }
-            vkUnmapMemory(m_vkDevice, idxMem);
+            Release();
+
+            // Grow geometrically so a slowly increasing instance count doesn't reallocate every frame.
+            VkDeviceSize newSize = 4 * 1024;
+            while (newSize < requiredSize) {
+                newSize *= 2;
+            }
+
+            VkBufferCreateInfo bufInfo{VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+            bufInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+            bufInfo.size = newSize;
+            bufInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            XRC_CHECK_THROW_VKCMD(vkCreateBuffer(m_vkDevice, &bufInfo, nullptr, &buf));
+
+            VkMemoryRequirements memReq{};
+            vkGetBufferMemoryRequirements(m_vkDevice, buf, &memReq);
+            mem = m_memAllocator->Allocate(memReq, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+            XRC_CHECK_THROW_VKCMD(vkBindBufferMemory(m_vkDevice, buf, mem.memory, mem.offset));
+            mapped = mem.mapped;
+            size = newSize;
         }
 
-        void UpdateVertices(const T* data, uint32_t elements, uint32_t offset = 0)
+    private:
+        VkDevice m_vkDevice{VK_NULL_HANDLE};
+        MemoryAllocator* m_memAllocator{nullptr};
+
+        void Release()
         {
-            T* map = nullptr;
-            XRC_CHECK_THROW_VKCMD(vkMapMemory(m_vkDevice, vtxMem, sizeof(map[0]) * offset, sizeof(map[0]) * elements, 0, (void**)&map));
-            for (size_t i = 0; i < elements; ++i) {
-                map[i] = data[i];
+            if (m_vkDevice != VK_NULL_HANDLE) {
+                if (buf != VK_NULL_HANDLE) {
+                    vkDestroyBuffer(m_vkDevice, buf, nullptr);
+                }
+                m_memAllocator->Free(mem);
             }
-            vkUnmapMemory(m_vkDevice, vtxMem);
+            mapped = nullptr;
+            buf = VK_NULL_HANDLE;
+            size = 0;
         }
     };
 
@@ -616,23 +1451,32 @@ namespace Conformance
     {
         VkFormat colorFmt{};
         VkFormat depthFmt{};
+        VkSampleCountFlagBits samples{VK_SAMPLE_COUNT_1_BIT};
         VkRenderPass pass{VK_NULL_HANDLE};
 
         RenderPass() = default;
 
-        bool Create(VkDevice device, VkFormat aColorFmt, VkFormat aDepthFmt)
+        // With more than one sample, the color and depth attachments are multisampled ones that are cleared on load and
+        // not stored, and the color is resolved into a third, single-sampled attachment: the swapchain image.
+        // With clear, a single-sampled pass also clears both attachments on load, and does not store the depth.
+        bool Create(VkDevice device, VkFormat aColorFmt, VkFormat aDepthFmt, VkSampleCountFlagBits aSamples = VK_SAMPLE_COUNT_1_BIT,
+                    bool clear = false)
         {
             m_vkDevice = device;
             colorFmt = aColorFmt;
             depthFmt = aDepthFmt;
+            samples = aSamples;
+            const bool multisampled = samples != VK_SAMPLE_COUNT_1_BIT;
+            const bool clearOnLoad = multisampled || clear;
 
             VkSubpassDescription subpass = {};
             subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
 
             VkAttachmentReference colorRef = {0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
             VkAttachmentReference depthRef = {1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+            VkAttachmentReference resolveRef = {2, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
 
-            std::array<VkAttachmentDescription, 2> at = {};
+            std::array<VkAttachmentDescription, 3> at = {};
 
             VkRenderPassCreateInfo rpInfo{VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO};
             rpInfo.attachmentCount = 0;
@@ -644,12 +1488,13 @@ namespace Conformance
                 colorRef.attachment = rpInfo.attachmentCount++;
 
                 at[colorRef.attachment].format = colorFmt;
-                at[colorRef.attachment].samples = VK_SAMPLE_COUNT_1_BIT;
-                at[colorRef.attachment].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
-                at[colorRef.attachment].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+                at[colorRef.attachment].samples = samples;
+                at[colorRef.attachment].loadOp = clearOnLoad ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD;
+                at[colorRef.attachment].storeOp = multisampled ? VK_ATTACHMENT_STORE_OP_DONT_CARE : VK_ATTACHMENT_STORE_OP_STORE;
                 at[colorRef.attachment].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
                 at[colorRef.attachment].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-                at[colorRef.attachment].initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+                at[colorRef.attachment].initialLayout =
+                    clearOnLoad ? VK_IMAGE_LAYOUT_UNDEFINED : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
                 at[colorRef.attachment].finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
                 subpass.colorAttachmentCount = 1;
@@ -660,17 +1505,49 @@ namespace Conformance
                 depthRef.attachment = rpInfo.attachmentCount++;
 
                 at[depthRef.attachment].format = depthFmt;
-                at[depthRef.attachment].samples = VK_SAMPLE_COUNT_1_BIT;
-                at[depthRef.attachment].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
-                at[depthRef.attachment].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+                at[depthRef.attachment].samples = samples;
+                at[depthRef.attachment].loadOp = clearOnLoad ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD;
+                at[depthRef.attachment].storeOp = clearOnLoad ? VK_ATTACHMENT_STORE_OP_DONT_CARE : VK_ATTACHMENT_STORE_OP_STORE;
                 at[depthRef.attachment].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
                 at[depthRef.attachment].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-                at[depthRef.attachment].initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+                at[depthRef.attachment].initialLayout =
+                    clearOnLoad ? VK_IMAGE_LAYOUT_UNDEFINED : VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
                 at[depthRef.attachment].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 
                 subpass.pDepthStencilAttachment = &depthRef;
             }
 
+            if (multisampled) {
+                XRC_CHECK_THROW_MSG(colorFmt != VK_FORMAT_UNDEFINED, "A multisampled render pass needs a color attachment to resolve");
+                resolveRef.attachment = rpInfo.attachmentCount++;
+
+                // The resolve writes every pixel of the render area, so the swapchain image need not be loaded.
+                at[resolveRef.attachment].format = colorFmt;
+                at[resolveRef.attachment].samples = VK_SAMPLE_COUNT_1_BIT;
+                at[resolveRef.attachment].loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+                at[resolveRef.attachment].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+                at[resolveRef.attachment].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+                at[resolveRef.attachment].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+                at[resolveRef.attachment].initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+                at[resolveRef.attachment].finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+                subpass.pResolveAttachments = &resolveRef;
+            }
+
+            // Several submissions may be in flight at once, so order this pass's attachment
+            // accesses after those of earlier passes on the same queue.
+            VkSubpassDependency dependency{};
+            dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+            dependency.dstSubpass = 0;
+            dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+                                      VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+            dependency.dstStageMask = dependency.srcStageMask;
+            dependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+            dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+                                       VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+            rpInfo.dependencyCount = 1;
+            rpInfo.pDependencies = &dependency;
+
             XRC_CHECK_THROW_VKCMD(vkCreateRenderPass(m_vkDevice, &rpInfo, nullptr, &pass));
 
             return true;
@@ -708,6 +1585,7 @@ namespace Conformance
         VkImage depthImage{VK_NULL_HANDLE};
         VkImageView colorView{VK_NULL_HANDLE};
         VkImageView depthView{VK_NULL_HANDLE};
+        VkImageView resolveView{VK_NULL_HANDLE};
         VkFramebuffer fb{VK_NULL_HANDLE};
 
         RenderTarget() = default;
@@ -724,6 +1602,9 @@ namespace Conformance
                 if (depthView != VK_NULL_HANDLE) {
                     vkDestroyImageView(m_vkDevice, depthView, nullptr);
                 }
+                if (resolveView != VK_NULL_HANDLE) {
+                    vkDestroyImageView(m_vkDevice, resolveView, nullptr);
+                }
             }
 
             // Note we don't own color/depthImage, it will get destroyed when xrDestroySwapchain is called
@@ -731,6 +1612,7 @@ namespace Conformance
             depthImage = VK_NULL_HANDLE;
             colorView = VK_NULL_HANDLE;
             depthView = VK_NULL_HANDLE;
+            resolveView = VK_NULL_HANDLE;
             fb = VK_NULL_HANDLE;
             m_vkDevice = VK_NULL_HANDLE;
         }
@@ -742,6 +1624,7 @@ namespace Conformance
             swap(depthImage, other.depthImage);
             swap(colorView, other.colorView);
             swap(depthView, other.depthView);
+            swap(resolveView, other.resolveView);
             swap(fb, other.fb);
             swap(m_vkDevice, other.m_vkDevice);
         }
@@ -757,19 +1640,21 @@ namespace Conformance
             swap(depthImage, other.depthImage);
             swap(colorView, other.colorView);
             swap(depthView, other.depthView);
+            swap(resolveView, other.resolveView);
             swap(fb, other.fb);
             swap(m_vkDevice, other.m_vkDevice);
             return *this;
         }
-        void Create(VkDevice device, VkImage aColorImage, VkImage aDepthImage, uint32_t baseArrayLayer, VkExtent2D size,
-                    RenderPass& renderPass)
+        // A multisampled renderPass also takes the image and array layer its color is resolved into.
+        void Create(VkDevice device, VkImage aColorImage, VkImage aDepthImage, uint32_t baseArrayLayer, uint32_t depthArrayLayer,
+                    VkExtent2D size, RenderPass& renderPass, VkImage resolveImage = VK_NULL_HANDLE, uint32_t resolveArrayLayer = 0)
         {
             m_vkDevice = device;
 
             colorImage = aColorImage;
             depthImage = aDepthImage;
 
-            std::array<VkImageView, 2> attachments{};
+            std::array<VkImageView, 3> attachments{};
             uint32_t attachmentCount = 0;
 
             // Create color image view
@@ -804,12 +1689,26 @@ namespace Conformance
                 depthViewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
                 depthViewInfo.subresourceRange.baseMipLevel = 0;
                 depthViewInfo.subresourceRange.levelCount = 1;
-                depthViewInfo.subresourceRange.baseArrayLayer = baseArrayLayer;
+                depthViewInfo.subresourceRange.baseArrayLayer = depthArrayLayer;
                 depthViewInfo.subresourceRange.layerCount = 1;
                 XRC_CHECK_THROW_VKCMD(vkCreateImageView(m_vkDevice, &depthViewInfo, nullptr, &depthView));
                 attachments[attachmentCount++] = depthView;
             }
 
+            if (resolveImage != VK_NULL_HANDLE) {
+                VkImageViewCreateInfo resolveViewInfo{VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO};
+                resolveViewInfo.image = resolveImage;
+                resolveViewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+                resolveViewInfo.format = renderPass.colorFmt;
+                resolveViewInfo.components.r = VK_COMPONENT_SWIZZLE_R;
+                resolveViewInfo.components.g = VK_COMPONENT_SWIZZLE_G;
+                resolveViewInfo.components.b = VK_COMPONENT_SWIZZLE_B;
+                resolveViewInfo.components.a = VK_COMPONENT_SWIZZLE_A;
+                resolveViewInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, resolveArrayLayer, 1};
+                XRC_CHECK_THROW_VKCMD(vkCreateImageView(m_vkDevice, &resolveViewInfo, nullptr, &resolveView));
+                attachments[attachmentCount++] = resolveView;
+            }
+
             VkFramebufferCreateInfo fbInfo{VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO};
             fbInfo.renderPass = renderPass.pass;
             fbInfo.attachmentCount = attachmentCount;
@@ -854,15 +1753,8 @@ namespace Conformance
         {
             m_vkDevice = device;
 
-            // MVP matrix is a push_constant
-            VkPushConstantRange pcr = {};
-            pcr.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-            pcr.offset = 0;
-            pcr.size = 4 * 4 * sizeof(float);
-
+            // MVP matrices are per-instance vertex attributes, so there are no push constants or descriptors.
             VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
-            pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
-            pipelineLayoutCreateInfo.pPushConstantRanges = &pcr;
             XRC_CHECK_THROW_VKCMD(vkCreatePipelineLayout(m_vkDevice, &pipelineLayoutCreateInfo, nullptr, &layout));
         }
 
@@ -875,6 +1767,79 @@ namespace Conformance
         VkDevice m_vkDevice{VK_NULL_HANDLE};
     };
 
+    // PipelineCache - a VkPipelineCache that starts from, and is saved back to, a blob that outlives the device.
+    // The blob's header is checked against the device before use, because not every driver rejects a foreign cache.
+    struct PipelineCache
+    {
+        VkPipelineCache cache{VK_NULL_HANDLE};
+
+        PipelineCache() = default;
+
+        PipelineCache(const PipelineCache&) = delete;
+        PipelineCache& operator=(const PipelineCache&) = delete;
+
+        ~PipelineCache()
+        {
+            Reset();
+        }
+
+        // Returns true if data starts with a VkPipelineCacheHeaderVersionOne that matches the physical device.
+        static bool IsCompatible(const std::vector<uint8_t>& data, const VkPhysicalDeviceProperties& properties)
+        {
+            // headerSize, headerVersion, vendorID and deviceID, followed by pipelineCacheUUID.
+            uint32_t header[4];
+            if (data.size() < sizeof(header) + VK_UUID_SIZE) {
+                return false;
+            }
+            memcpy(header, data.data(), sizeof(header));
+            return header[0] >= sizeof(header) + VK_UUID_SIZE && header[0] <= data.size() &&
+                   header[1] == uint32_t(VK_PIPELINE_CACHE_HEADER_VERSION_ONE) && header[2] == properties.vendorID &&
+                   header[3] == properties.deviceID &&
+                   memcmp(data.data() + sizeof(header), properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+        }
+
+        void Create(VkDevice device, const std::vector<uint8_t>& initialData)
+        {
+            m_vkDevice = device;
+
+            VkPipelineCacheCreateInfo cacheInfo{VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO};
+            cacheInfo.initialDataSize = initialData.size();
+            cacheInfo.pInitialData = initialData.empty() ? nullptr : initialData.data();
+            XRC_CHECK_THROW_VKCMD(vkCreatePipelineCache(m_vkDevice, &cacheInfo, nullptr, &cache));
+        }
+
+        // Returns the current contents, or an empty blob if there is no cache.
+        std::vector<uint8_t> GetData() const
+        {
+            std::vector<uint8_t> data;
+            if (cache != VK_NULL_HANDLE) {
+                size_t size = 0;
+                if (vkGetPipelineCacheData(m_vkDevice, cache, &size, nullptr) == VK_SUCCESS && size > 0) {
+                    data.resize(size);
+                    if (vkGetPipelineCacheData(m_vkDevice, cache, &size, data.data()) != VK_SUCCESS) {
+                        data.clear();
+                    }
+                    data.resize(size);
+                }
+            }
+            return data;
+        }
+
+        void Reset()
+        {
+            if (m_vkDevice != nullptr) {
+                if (cache != VK_NULL_HANDLE) {
+                    vkDestroyPipelineCache(m_vkDevice, cache, nullptr);
+                }
+            }
+            cache = VK_NULL_HANDLE;
+            m_vkDevice = nullptr;
+        }
+
+    private:
+        VkDevice m_vkDevice{VK_NULL_HANDLE};
+    };
+
     // Pipeline wrapper for rendering pipeline state
     struct Pipeline
     {
@@ -894,7 +1859,7 @@ namespace Conformance
         }
 
         void Create(VkDevice device, VkExtent2D /*size*/, const PipelineLayout& layout, const RenderPass& rp, const ShaderProgram& sp,
-                    const VertexBufferBase& vb)
+                    const VertexBufferBase& vb, VkPipelineCache pipelineCache = VK_NULL_HANDLE)
         {
             m_vkDevice = device;
 
@@ -902,9 +1867,14 @@ namespace Conformance
             dynamicState.dynamicStateCount = (uint32_t)dynamicStateEnables.size();
             dynamicState.pDynamicStates = dynamicStateEnables.data();
 
+            std::vector<VkVertexInputBindingDescription> bindings{vb.bindDesc};
+            if (vb.instanceBindDesc.stride != 0) {
+                bindings.push_back(vb.instanceBindDesc);
+            }
+
             VkPipelineVertexInputStateCreateInfo vi{VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO};
-            vi.vertexBindingDescriptionCount = 1;
-            vi.pVertexBindingDescriptions = &vb.bindDesc;
+            vi.vertexBindingDescriptionCount = (uint32_t)bindings.size();
+            vi.pVertexBindingDescriptions = bindings.data();
             vi.vertexAttributeDescriptionCount = (uint32_t)vb.attrDesc.size();
             vi.pVertexAttributeDescriptions = vb.attrDesc.data();
 
@@ -965,7 +1935,7 @@ namespace Conformance
             ds.maxDepthBounds = 1.0f;
 
             VkPipelineMultisampleStateCreateInfo ms{VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO};
-            ms.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+            ms.rasterizationSamples = rp.samples;
 
             VkGraphicsPipelineCreateInfo pipeInfo{VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO};
             pipeInfo.stageCount = (uint32_t)sp.shaderInfo.size();
@@ -984,7 +1954,7 @@ namespace Conformance
             pipeInfo.layout = layout.layout;
             pipeInfo.renderPass = rp.pass;
             pipeInfo.subpass = 0;
-            XRC_CHECK_THROW_VKCMD(vkCreateGraphicsPipelines(m_vkDevice, VK_NULL_HANDLE, 1, &pipeInfo, nullptr, &pipe));
+            XRC_CHECK_THROW_VKCMD(vkCreateGraphicsPipelines(m_vkDevice, pipelineCache, 1, &pipeInfo, nullptr, &pipe));
         }
 
         void Reset()
@@ -1004,7 +1974,7 @@ namespace Conformance
 
     struct DepthBuffer
     {
-        VkDeviceMemory depthMemory{VK_NULL_HANDLE};
+        MemoryAllocation depthMemory{};
         VkImage depthImage{VK_NULL_HANDLE};
 
         DepthBuffer() = default;
@@ -1019,12 +1989,10 @@ namespace Conformance
                 if (depthImage != VK_NULL_HANDLE) {
                     vkDestroyImage(m_vkDevice, depthImage, nullptr);
                 }
-                if (depthMemory != VK_NULL_HANDLE) {
-                    vkFreeMemory(m_vkDevice, depthMemory, nullptr);
-                }
+                m_memAllocator->Free(depthMemory);
             }
             depthImage = VK_NULL_HANDLE;
-            depthMemory = VK_NULL_HANDLE;
+            m_memAllocator = nullptr;
             m_vkDevice = nullptr;
         }
 
@@ -1034,6 +2002,7 @@ namespace Conformance
 
             swap(depthImage, other.depthImage);
             swap(depthMemory, other.depthMemory);
+            swap(m_memAllocator, other.m_memAllocator);
             swap(m_vkDevice, other.m_vkDevice);
         }
         DepthBuffer& operator=(DepthBuffer&& other)
@@ -1047,15 +2016,16 @@ namespace Conformance
 
             swap(depthImage, other.depthImage);
             swap(depthMemory, other.depthMemory);
+            swap(m_memAllocator, other.m_memAllocator);
             swap(m_vkDevice, other.m_vkDevice);
             return *this;
         }
 
-        void Create(VkDevice device, MemoryAllocator* memAllocator, VkFormat depthFormat, const XrSwapchainCreateInfo& swapchainCreateInfo)
+        // A single layer: every array slice renders into layer 0 of its own, possibly shared, depth buffer.
+        void Create(VkDevice device, MemoryAllocator* memAllocator, VkFormat depthFormat, VkExtent2D size, VkSampleCountFlagBits samples)
         {
             m_vkDevice = device;
-
-            VkExtent2D size = {swapchainCreateInfo.width, swapchainCreateInfo.height};
+            m_memAllocator = memAllocator;
 
             // Create a D32 depthbuffer
             VkImageCreateInfo imageInfo{VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
@@ -1064,19 +2034,19 @@ namespace Conformance
             imageInfo.extent.height = size.height;
             imageInfo.extent.depth = 1;
             imageInfo.mipLevels = 1;
-            imageInfo.arrayLayers = swapchainCreateInfo.arraySize;
+            imageInfo.arrayLayers = 1;
             imageInfo.format = depthFormat;
             imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
             imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
             imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
-            imageInfo.samples = (VkSampleCountFlagBits)swapchainCreateInfo.sampleCount;
+            imageInfo.samples = samples;
             imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
             XRC_CHECK_THROW_VKCMD(vkCreateImage(device, &imageInfo, nullptr, &depthImage));
 
             VkMemoryRequirements memRequirements{};
             vkGetImageMemoryRequirements(device, depthImage, &memRequirements);
-            memAllocator->Allocate(memRequirements, &depthMemory, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-            XRC_CHECK_THROW_VKCMD(vkBindImageMemory(device, depthImage, depthMemory, 0));
+            depthMemory = memAllocator->Allocate(memRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false);
+            XRC_CHECK_THROW_VKCMD(vkBindImageMemory(device, depthImage, depthMemory.memory, depthMemory.offset));
         }
 
         void TransitionLayout(CmdBuffer* cmdBuffer, VkImageLayout newLayout)
@@ -1100,16 +2070,118 @@ namespace Conformance
         DepthBuffer(const DepthBuffer&) = delete;
         DepthBuffer& operator=(const DepthBuffer&) = delete;
 
+        // The array slice this buffer was last cleared for, see DepthBufferCache.
+        const void* clearedFor{nullptr};
+
     private:
         VkDevice m_vkDevice{VK_NULL_HANDLE};
+        MemoryAllocator* m_memAllocator{nullptr};
         VkImageLayout m_vkLayout = VK_IMAGE_LAYOUT_UNDEFINED;
     };
 
+    // A multisampled color or depth attachment that only lives within a render pass, see
+    // VulkanGraphicsPlugin::SetRenderSampleCount. It is cleared on load and never stored, so a tiled GPU can keep it in
+    // tile memory, and it is backed by lazily allocated memory where the device has some.
+    struct TransientAttachment
+    {
+        VkImage image{VK_NULL_HANDLE};
+        MemoryAllocation memory{};
+
+        TransientAttachment() = default;
+        ~TransientAttachment()
+        {
+            if (m_vkDevice != VK_NULL_HANDLE) {
+                vkDestroyImage(m_vkDevice, image, nullptr);
+                m_memAllocator->Free(memory);
+            }
+        }
+
+        TransientAttachment(const TransientAttachment&) = delete;
+        TransientAttachment& operator=(const TransientAttachment&) = delete;
+
+        void Create(VkDevice device, MemoryAllocator* memAllocator, VkFormat format, VkImageUsageFlags usage, VkExtent2D size,
+                    VkSampleCountFlagBits samples)
+        {
+            VkImageCreateInfo imageInfo{VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
+            imageInfo.imageType = VK_IMAGE_TYPE_2D;
+            imageInfo.extent = {size.width, size.height, 1};
+            imageInfo.mipLevels = 1;
+            imageInfo.arrayLayers = 1;
+            imageInfo.format = format;
+            imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+            imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            imageInfo.usage = usage | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+            imageInfo.samples = samples;
+            imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            XRC_CHECK_THROW_VKCMD(vkCreateImage(device, &imageInfo, nullptr, &image));
+            m_vkDevice = device;
+            m_memAllocator = memAllocator;
+
+            VkMemoryRequirements memRequirements{};
+            vkGetImageMemoryRequirements(device, image, &memRequirements);
+            VkFlags memoryFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+            if (!memAllocator->HasMemoryType(memRequirements.memoryTypeBits, memoryFlags)) {
+                memoryFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+            }
+            memory = memAllocator->Allocate(memRequirements, memoryFlags, false);
+            XRC_CHECK_THROW_VKCMD(vkBindImageMemory(device, image, memory.memory, memory.offset));
+        }
+
+    private:
+        VkDevice m_vkDevice{VK_NULL_HANDLE};
+        MemoryAllocator* m_memAllocator{nullptr};
+    };
+
+    // Hands out one depth buffer per size and sample count, shared by every array slice of every swapchain that
+    // renders at that size, and frees it once the last of them is gone. All rendering is recorded on one thread and
+    // submitted to one queue, so the slices use it in turn; a slice whose depth was last cleared for another one
+    // clears it again before drawing, see DepthBuffer::clearedFor.
+    // The depth has to survive from the ClearImageSlice render pass to the RenderView ones, so it cannot be a
+    // transient attachment.
+    class DepthBufferCache
+    {
+    public:
+        static constexpr VkFormat DepthFormat = VK_FORMAT_D32_SFLOAT;
+
+        void Init(VkDevice device, MemoryAllocator* memAllocator)
+        {
+            m_vkDevice = device;
+            m_memAllocator = memAllocator;
+        }
+
+        void Reset()
+        {
+            m_buffers.clear();
+            m_memAllocator = nullptr;
+            m_vkDevice = VK_NULL_HANDLE;
+        }
+
+        std::shared_ptr<DepthBuffer> Get(VkExtent2D size, VkSampleCountFlagBits samples)
+        {
+            std::weak_ptr<DepthBuffer>& entry = m_buffers[std::make_tuple(size.width, size.height, samples)];
+            std::shared_ptr<DepthBuffer> depthBuffer = entry.lock();
+            if (!depthBuffer) {
+                depthBuffer = std::make_shared<DepthBuffer>();
+                depthBuffer->Create(m_vkDevice, m_memAllocator, DepthFormat, size, samples);
+                entry = depthBuffer;
+            }
+            return depthBuffer;
+        }
+
+    private:
+        VkDevice m_vkDevice{VK_NULL_HANDLE};
+        MemoryAllocator* m_memAllocator{nullptr};
+        std::map<std::tuple<uint32_t, uint32_t, VkSampleCountFlagBits>, std::weak_ptr<DepthBuffer>> m_buffers;
+    };
+
     struct SwapchainImageContext : public IGraphicsPlugin::SwapchainImageStructs
     {
         // A packed array of XrSwapchainImageVulkanKHR's for xrEnumerateSwapchainImages
         std::vector<XrSwapchainImageVulkanKHR> swapchainImages;
         VkExtent2D size{};
+        VkFormat format{VK_FORMAT_UNDEFINED};
+        uint32_t mipCount{1};
+        XrSwapchainUsageFlags usageFlags{0};
         class ArraySliceState
         {
         public:
@@ -1120,10 +2192,32 @@ namespace Conformance
             {
                 ReportF("ArraySliceState copy ctor called");
             }
-            std::vector<RenderTarget> renderTarget;  // per swapchain index
-            DepthBuffer depthBuffer{};
+            // Held from the first ClearImageSlice or RenderView on, so swapchains that are only ever copied into
+            // (static quad layers) never allocate one.
+            std::shared_ptr<DepthBuffer> depthBuffer;
+            std::vector<RenderTarget> renderTarget;  // per swapchain index, framebuffers created on first use
+            // Framebuffers that render into a depth swapchain image instead, see RenderViewWithDepth. Each holds on to
+            // the depth swapchain's context so that the image pointer it is keyed by is not reused while it exists.
+            struct DepthSwapchainTarget
+            {
+                std::shared_ptr<SwapchainImageContext> depthContext;
+                RenderTarget renderTarget;
+            };
+            std::map<std::pair<uint32_t, const XrSwapchainImageBaseHeader*>, DepthSwapchainTarget> depthSwapchainTargets;
             RenderPass rp{};
+            RenderPass clearRp{};  // compatible with rp, see BindClearingRenderTarget
             Pipeline pipe{};
+            // Used instead of the above while the plugin renders multisampled, see BindMultisampleRenderTarget.
+            struct Multisample
+            {
+                VkSampleCountFlagBits samples{VK_SAMPLE_COUNT_1_BIT};
+                TransientAttachment color;
+                TransientAttachment depth;
+                RenderPass rp;
+                Pipeline pipe;
+                std::vector<RenderTarget> renderTarget;  // per swapchain index, created on first use
+            };
+            std::unique_ptr<Multisample> multisample;
         };
         std::vector<ArraySliceState> slice{};
 
@@ -1133,15 +2227,26 @@ namespace Conformance
             Reset();
         }
 
-        std::vector<XrSwapchainImageBaseHeader*> Create(VkDevice device, MemoryAllocator* memAllocator, uint32_t capacity,
-                                                        const XrSwapchainCreateInfo& swapchainCreateInfo, const PipelineLayout& layout,
-                                                        const ShaderProgram& sp, const VertexBuffer<Geometry::Vertex>& vb)
+        std::vector<XrSwapchainImageBaseHeader*> Create(VkDevice device, MemoryAllocator* memAllocator, DepthBufferCache* depthBuffers,
+                                                        uint32_t capacity, const XrSwapchainCreateInfo& swapchainCreateInfo,
+                                                        const PipelineLayout& layout, const ShaderProgram& sp,
+                                                        const VertexBuffer<Geometry::PackedVertex>& vb, VkPipelineCache pipelineCache)
         {
             m_vkDevice = device;
+            m_memAllocator = memAllocator;
+            m_depthBuffers = depthBuffers;
+            m_pipelineLayout = &layout;
+            m_shaderProgram = &sp;
+            m_vertexBuffer = &vb;
+            m_pipelineCache = pipelineCache;
 
             size = {swapchainCreateInfo.width, swapchainCreateInfo.height};
-            VkFormat colorFormat = (VkFormat)swapchainCreateInfo.format;
-            VkFormat depthFormat = VK_FORMAT_D32_SFLOAT;
+            m_sampleCount = (VkSampleCountFlagBits)swapchainCreateInfo.sampleCount;
+            format = (VkFormat)swapchainCreateInfo.format;
+            mipCount = std::max(1u, swapchainCreateInfo.mipCount);
+            usageFlags = swapchainCreateInfo.usageFlags;
+            VkFormat colorFormat = format;
+            VkFormat depthFormat = DepthBufferCache::DepthFormat;
             // XXX handle swapchainCreateInfo.sampleCount
 
             swapchainImages.resize(capacity);
@@ -1151,15 +2256,21 @@ namespace Conformance
                 bases[i] = reinterpret_cast<XrSwapchainImageBaseHeader*>(&swapchainImages[i]);
             }
 
-            // Array slices could probably be handled via subpasses, but use a pipe/renderpass per slice for now
-            slice.resize(swapchainCreateInfo.arraySize);
+            // Depth swapchains are only ever rendered into alongside a color one, whose render passes they use.
+            if ((swapchainCreateInfo.usageFlags & XR_SWAPCHAIN_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT) != 0) {
+                return bases;
+            }
+
+            // Array slices could probably be handled via subpasses, but use a pipe/renderpass per slice for now. The faces of
+            // a cube map are array layers of the image, so they are slices too.
+            slice.resize(swapchainCreateInfo.arraySize * std::max(1u, swapchainCreateInfo.faceCount));
             for (auto& s : slice) {
                 s.renderTarget.resize(capacity);
-                s.depthBuffer.Create(m_vkDevice, memAllocator, depthFormat, swapchainCreateInfo);
                 s.rp.Create(m_vkDevice, colorFormat, depthFormat);
+                s.clearRp.Create(m_vkDevice, colorFormat, depthFormat, VK_SAMPLE_COUNT_1_BIT, true);
                 s.pipe.Dynamic(VK_DYNAMIC_STATE_SCISSOR);
                 s.pipe.Dynamic(VK_DYNAMIC_STATE_VIEWPORT);
-                s.pipe.Create(m_vkDevice, size, layout, s.rp, sp, vb);
+                s.pipe.Create(m_vkDevice, size, layout, s.rp, sp, vb, pipelineCache);
             }
 
             return bases;
@@ -1170,7 +2281,16 @@ namespace Conformance
             if (m_vkDevice) {
                 swapchainImages.clear();
                 size = {};
+                format = VK_FORMAT_UNDEFINED;
+                mipCount = 1;
+                usageFlags = 0;
                 slice.clear();
+                m_memAllocator = nullptr;
+                m_depthBuffers = nullptr;
+                m_pipelineLayout = nullptr;
+                m_shaderProgram = nullptr;
+                m_vertexBuffer = nullptr;
+                m_pipelineCache = VK_NULL_HANDLE;
                 m_vkDevice = VK_NULL_HANDLE;
             }
         }
@@ -1181,40 +2301,171 @@ namespace Conformance
             return (uint32_t)(p - &swapchainImages[0]);
         }
 
+        bool IsDepthSwapchain() const
+        {
+            return slice.empty();
+        }
+
+        DepthBuffer& GetDepthBuffer(uint32_t arraySlice)
+        {
+            auto& s = slice[arraySlice];
+            if (!s.depthBuffer) {
+                s.depthBuffer = m_depthBuffers->Get(size, m_sampleCount);
+            }
+            return *s.depthBuffer;
+        }
+
+        // Whether the depth buffer was last cleared for this array slice, by its ClearImageSlice or a view of it, rather
+        // than for another slice sharing the depth buffer or not at all.
+        bool HoldsDepth(uint32_t arraySlice)
+        {
+            return GetDepthBuffer(arraySlice).clearedFor == &slice[arraySlice];
+        }
+
+        void SetHoldsDepth(uint32_t arraySlice)
+        {
+            GetDepthBuffer(arraySlice).clearedFor = &slice[arraySlice];
+        }
+
+        // After a render pass that does not store the depth, no slice holds it any more.
+        void DiscardDepth(uint32_t arraySlice)
+        {
+            GetDepthBuffer(arraySlice).clearedFor = nullptr;
+        }
+
+        bool CoversImage(const VkRect2D& renderArea) const
+        {
+            return renderArea.offset.x == 0 && renderArea.offset.y == 0 && renderArea.extent.width == size.width &&
+                   renderArea.extent.height == size.height;
+        }
+
+        // The clear color and far plane of ClearImageSlice and of the render passes that clear as they load.
+        static const std::array<VkClearValue, 2>& ClearValues()
+        {
+            static const std::array<VkClearValue, 2> clearValues = [] {
+                std::array<VkClearValue, 2> values{};
+                values[0].color = {{0.184313729f, 0.309803933f, 0.309803933f, 1.0f}};
+                values[1].depthStencil = {1.0f, 0};
+                return values;
+            }();
+            return clearValues;
+        }
+
         void BindRenderTarget(uint32_t index, uint32_t arraySlice, const VkRect2D& renderArea, VkRenderPassBeginInfo* renderPassBeginInfo)
         {
             auto& s = slice[arraySlice];
             RenderTarget& rt = s.renderTarget[index];
             if (rt.fb == VK_NULL_HANDLE) {
-                rt.Create(m_vkDevice, swapchainImages[index].image, s.depthBuffer.depthImage, arraySlice, size, s.rp);
+                rt.Create(m_vkDevice, swapchainImages[index].image, GetDepthBuffer(arraySlice).depthImage, arraySlice, 0, size, s.rp);
+            }
+            renderPassBeginInfo->renderPass = s.rp.pass;
+            renderPassBeginInfo->framebuffer = rt.fb;
+            renderPassBeginInfo->renderArea = renderArea;
+        }
+
+        // Like BindRenderTarget, but with a render pass that clears the color and depth as it loads them, as
+        // ClearImageSlice would, and leaves the depth undefined. Where the render area covers the whole image, this
+        // takes the place of a ClearImageSlice pass, and a tiled GPU neither loads the attachments nor stores the depth.
+        // The pass is compatible with the one of BindRenderTarget, so it shares its framebuffers and pipeline.
+        void BindClearingRenderTarget(uint32_t index, uint32_t arraySlice, const VkRect2D& renderArea,
+                                      VkRenderPassBeginInfo* renderPassBeginInfo)
+        {
+            BindRenderTarget(index, arraySlice, renderArea, renderPassBeginInfo);
+            renderPassBeginInfo->renderPass = slice[arraySlice].clearRp.pass;
+            renderPassBeginInfo->clearValueCount = (uint32_t)ClearValues().size();
+            renderPassBeginInfo->pClearValues = ClearValues().data();
+        }
+
+        // Like BindRenderTarget, but with the same array slice of a depth swapchain image as the depth attachment.
+        void BindRenderTarget(uint32_t index, uint32_t arraySlice, const std::shared_ptr<SwapchainImageContext>& depthContext,
+                              const XrSwapchainImageBaseHeader* depthSwapchainImage, const VkRect2D& renderArea,
+                              VkRenderPassBeginInfo* renderPassBeginInfo)
+        {
+            auto& s = slice[arraySlice];
+            auto& target = s.depthSwapchainTargets[std::make_pair(index, depthSwapchainImage)];
+            if (target.renderTarget.fb == VK_NULL_HANDLE) {
+                target.depthContext = depthContext;
+                const VkImage depthImage = depthContext->swapchainImages[depthContext->ImageIndex(depthSwapchainImage)].image;
+                target.renderTarget.Create(m_vkDevice, swapchainImages[index].image, depthImage, arraySlice, arraySlice, size, s.rp);
             }
             renderPassBeginInfo->renderPass = s.rp.pass;
+            renderPassBeginInfo->framebuffer = target.renderTarget.fb;
+            renderPassBeginInfo->renderArea = renderArea;
+        }
+
+        // Like BindRenderTarget, but into multisampled targets the size of the swapchain that the render pass clears and
+        // resolves into the array slice of the swapchain image. The targets are remade when the sample count changes,
+        // by which time none of the old ones may still be in use.
+        void BindMultisampleRenderTarget(uint32_t index, uint32_t arraySlice, VkSampleCountFlagBits samples, const VkRect2D& renderArea,
+                                         VkRenderPassBeginInfo* renderPassBeginInfo)
+        {
+            auto& s = slice[arraySlice];
+            if (!s.multisample || s.multisample->samples != samples) {
+                s.multisample.reset();
+                std::unique_ptr<ArraySliceState::Multisample> ms(new ArraySliceState::Multisample());
+                ms->samples = samples;
+                ms->color.Create(m_vkDevice, m_memAllocator, format, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, size, samples);
+                ms->depth.Create(m_vkDevice, m_memAllocator, DepthBufferCache::DepthFormat, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+                                 size, samples);
+                ms->rp.Create(m_vkDevice, format, DepthBufferCache::DepthFormat, samples);
+                ms->pipe.Dynamic(VK_DYNAMIC_STATE_SCISSOR);
+                ms->pipe.Dynamic(VK_DYNAMIC_STATE_VIEWPORT);
+                ms->pipe.Create(m_vkDevice, size, *m_pipelineLayout, ms->rp, *m_shaderProgram, *m_vertexBuffer, m_pipelineCache);
+                ms->renderTarget.resize(swapchainImages.size());
+                s.multisample = std::move(ms);
+            }
+
+            ArraySliceState::Multisample& ms = *s.multisample;
+            RenderTarget& rt = ms.renderTarget[index];
+            if (rt.fb == VK_NULL_HANDLE) {
+                rt.Create(m_vkDevice, ms.color.image, ms.depth.image, 0, 0, size, ms.rp, swapchainImages[index].image, arraySlice);
+            }
+
+            renderPassBeginInfo->renderPass = ms.rp.pass;
             renderPassBeginInfo->framebuffer = rt.fb;
             renderPassBeginInfo->renderArea = renderArea;
+            renderPassBeginInfo->clearValueCount = (uint32_t)ClearValues().size();
+            renderPassBeginInfo->pClearValues = ClearValues().data();
         }
 
-        void BindPipeline(VkCommandBuffer buf, uint32_t arraySlice)
+        // multisample selects the pipeline of BindMultisampleRenderTarget.
+        void BindPipeline(VkCommandBuffer buf, uint32_t arraySlice, bool multisample = false)
         {
-            vkCmdBindPipeline(buf, VK_PIPELINE_BIND_POINT_GRAPHICS, slice[arraySlice].pipe.pipe);
+            const ArraySliceState& s = slice[arraySlice];
+            vkCmdBindPipeline(buf, VK_PIPELINE_BIND_POINT_GRAPHICS, multisample ? s.multisample->pipe.pipe : s.pipe.pipe);
         }
 
     private:
         VkDevice m_vkDevice{VK_NULL_HANDLE};
+        MemoryAllocator* m_memAllocator{nullptr};
+        DepthBufferCache* m_depthBuffers{nullptr};
+        // For the multisampled pipelines, which are made on first use.
+        const PipelineLayout* m_pipelineLayout{nullptr};
+        const ShaderProgram* m_shaderProgram{nullptr};
+        const VertexBuffer<Geometry::PackedVertex>* m_vertexBuffer{nullptr};
+        VkPipelineCache m_pipelineCache{VK_NULL_HANDLE};
+        VkSampleCountFlagBits m_sampleCount{VK_SAMPLE_COUNT_1_BIT};
     };
 
 #if defined(USE_MIRROR_WINDOW)
-    // Swapchain
+    // Swapchain - the window the rendered views are mirrored into.
+    // Mirroring never waits on the GPU: the blit into the window is its own submission, gated by its own fence and
+    // by semaphores shared only with the window's swapchain, and a frame is dropped from the mirror rather than
+    // holding up the caller when the previous one is still in flight or the window has no image ready.
     struct Swapchain
     {
         VkFormat format{VK_FORMAT_B8G8R8A8_SRGB};
         VkSurfaceKHR surface{VK_NULL_HANDLE};
         VkSwapchainKHR swapchain{VK_NULL_HANDLE};
-        VkFence readyFence{VK_NULL_HANDLE};
-        VkFence presentFence{VK_NULL_HANDLE};
-        static const uint32_t maxImages = 4;
+        static const uint32_t maxImages = 8;
         uint32_t swapchainCount = 0;
         uint32_t renderImageIdx = 0;
-        VkImage image[maxImages]{VK_NULL_HANDLE, VK_NULL_HANDLE, VK_NULL_HANDLE, VK_NULL_HANDLE};
+        VkImage image[maxImages]{};
+        // Signaled by vkAcquireNextImageKHR and waited on by the blit, which is single-buffered by cmdBuffer's fence.
+        VkSemaphore acquireSemaphore{VK_NULL_HANDLE};
+        // Signaled by the blit and waited on by the present, one per image so a pending present never shares one.
+        VkSemaphore blitDone[maxImages]{};
+        CmdBuffer cmdBuffer{};
 
         Swapchain()
         {
@@ -1224,33 +2475,30 @@ namespace Conformance
             Reset();
         }
 
-        void Create(VkInstance instance, VkPhysicalDevice physDevice, VkDevice device, uint32_t queueFamilyIndex);
-        void Prepare(VkCommandBuffer buf);
-        void Wait();
-        void Acquire(VkSemaphore readySemaphore = VK_NULL_HANDLE);
-        void Present(VkQueue queue, VkSemaphore drawComplete = VK_NULL_HANDLE);
+        void Create(VkInstance instance, VkPhysicalDevice physDevice, VkDevice device, uint32_t queueFamilyIndex,
+                    SubmissionTracker* tracker);
+        // Blits regions of srcImage, which must be in VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL and is left there, into
+        // the window and presents it. Runtimes only have to support this if the XR swapchain was created with
+        // XR_SWAPCHAIN_USAGE_TRANSFER_SRC_BIT, and the blit needs a color format the window's can be blitted from.
+        void Present(VkQueue queue, VkImage srcImage, const VkImageBlit* regions, uint32_t regionCount);
+        VkExtent2D Extent() const
+        {
+            return m_extent;
+        }
         void Reset()
         {
             if (m_vkDevice) {
-                // Flush any pending Present() calls which are using the fence
-                Wait();
-                if (swapchain)
-                    vkDestroySwapchainKHR(m_vkDevice, swapchain, nullptr);
-                if (readyFence)
-                    vkDestroyFence(m_vkDevice, readyFence, nullptr);
+                ResetSwapchain();
+                cmdBuffer.Reset();
+                if (acquireSemaphore)
+                    vkDestroySemaphore(m_vkDevice, acquireSemaphore, nullptr);
             }
 
             if (m_vkInstance && surface)
                 vkDestroySurfaceKHR(m_vkInstance, surface, nullptr);
 
-            readyFence = VK_NULL_HANDLE;
-            presentFence = VK_NULL_HANDLE;
-            swapchain = VK_NULL_HANDLE;
+            acquireSemaphore = VK_NULL_HANDLE;
             surface = VK_NULL_HANDLE;
-            for (uint32_t i = 0; i < swapchainCount; ++i) {
-                image[i] = VK_NULL_HANDLE;
-            }
-            swapchainCount = 0;
 
 #if defined(VK_USE_PLATFORM_WIN32_KHR)
             if (hWnd) {
@@ -1258,29 +2506,61 @@ namespace Conformance
                 hWnd = nullptr;
                 UnregisterClassW(L"conformance_test", hInst);
             }
+#elif defined(VK_USE_PLATFORM_XLIB_KHR)
+            if (xDisplay) {
+                if (xWindow) {
+                    XDestroyWindow(xDisplay, xWindow);
+                    xWindow = 0;
+                }
+                XCloseDisplay(xDisplay);
+                xDisplay = nullptr;
+            }
 #endif
 
             m_vkDevice = nullptr;
         }
+        // Replaces the swapchain, keeping the window and its surface, e.g. after the window was resized.
         void Recreate()
         {
-            Reset();
-            Create(m_vkInstance, m_vkPhysicalDevice, m_vkDevice, m_queueFamilyIndex);
+            // Rare enough that simply draining the device is fine, it may still be presenting the old images.
+            XRC_CHECK_THROW_VKCMD(vkDeviceWaitIdle(m_vkDevice));
+            ResetSwapchain();
+            CreateSwapchain();
         }
 
     private:
+        void CreateSwapchain();
+        void ResetSwapchain()
+        {
+            for (uint32_t i = 0; i < swapchainCount; ++i) {
+                if (blitDone[i])
+                    vkDestroySemaphore(m_vkDevice, blitDone[i], nullptr);
+                blitDone[i] = VK_NULL_HANDLE;
+                image[i] = VK_NULL_HANDLE;
+            }
+            swapchainCount = 0;
+            if (swapchain)
+                vkDestroySwapchainKHR(m_vkDevice, swapchain, nullptr);
+            swapchain = VK_NULL_HANDLE;
+        }
+
 #if defined(VK_USE_PLATFORM_WIN32_KHR)
         HINSTANCE hInst{NULL};
         HWND hWnd{NULL};
+#elif defined(VK_USE_PLATFORM_XLIB_KHR)
+        Display* xDisplay{nullptr};
+        Window xWindow{0};
 #endif
         const VkExtent2D size{640, 480};
+        VkExtent2D m_extent{};
         VkInstance m_vkInstance{VK_NULL_HANDLE};
         VkPhysicalDevice m_vkPhysicalDevice{VK_NULL_HANDLE};
         VkDevice m_vkDevice{VK_NULL_HANDLE};
         uint32_t m_queueFamilyIndex = 0;
     };
 
-    void Swapchain::Create(VkInstance instance, VkPhysicalDevice physDevice, VkDevice device, uint32_t queueFamilyIndex)
+    void Swapchain::Create(VkInstance instance, VkPhysicalDevice physDevice, VkDevice device, uint32_t queueFamilyIndex,
+                           SubmissionTracker* tracker)
     {
         m_vkInstance = instance;
         m_vkPhysicalDevice = physDevice;
@@ -1317,13 +2597,42 @@ namespace Conformance
         surfCreateInfo.hinstance = hInst;
         surfCreateInfo.hwnd = hWnd;
         XRC_CHECK_THROW_VKCMD(vkCreateWin32SurfaceKHR(m_vkInstance, &surfCreateInfo, nullptr, &surface));
+#elif defined(VK_USE_PLATFORM_XLIB_KHR)
+        // A separate connection, so the window never interferes with the one the platform plugin hands the runtime.
+        xDisplay = XOpenDisplay(nullptr);
+        XRC_CHECK_THROW_MSG(xDisplay != nullptr, "Unable to open the X display for the mirror window");
+        xWindow = XCreateSimpleWindow(xDisplay, DefaultRootWindow(xDisplay), 0, 0, size.width, size.height, 0, 0, 0);
+        XStoreName(xDisplay, xWindow, "conformance_test (Vulkan)");
+        XMapWindow(xDisplay, xWindow);
+        XFlush(xDisplay);
+
+        VkXlibSurfaceCreateInfoKHR surfCreateInfo{VK_STRUCTURE_TYPE_XLIB_SURFACE_CREATE_INFO_KHR};
+        surfCreateInfo.flags = 0;
+        surfCreateInfo.dpy = xDisplay;
+        surfCreateInfo.window = xWindow;
+        XRC_CHECK_THROW_VKCMD(vkCreateXlibSurfaceKHR(m_vkInstance, &surfCreateInfo, nullptr, &surface));
 #else
 #error CreateSurface not supported on this OS
 #endif  // defined(VK_USE_PLATFORM_WIN32_KHR)
 
+        VkBool32 presentable = false;
+        XRC_CHECK_THROW_VKCMD(vkGetPhysicalDeviceSurfaceSupportKHR(m_vkPhysicalDevice, m_queueFamilyIndex, surface, &presentable));
+        CHECK(presentable);
+
+        VkSemaphoreCreateInfo semaphoreInfo{VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+        XRC_CHECK_THROW_VKCMD(vkCreateSemaphore(m_vkDevice, &semaphoreInfo, nullptr, &acquireSemaphore));
+        cmdBuffer.Init(m_vkDevice, m_queueFamilyIndex, tracker);
+
+        CreateSwapchain();
+    }
+
+    void Swapchain::CreateSwapchain()
+    {
         VkSurfaceCapabilitiesKHR surfCaps;
         XRC_CHECK_THROW_VKCMD(vkGetPhysicalDeviceSurfaceCapabilitiesKHR(m_vkPhysicalDevice, surface, &surfCaps));
         XRC_CHECK_THROW(surfCaps.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+        // 0xFFFFFFFF means the surface takes its size from the swapchain.
+        m_extent = (surfCaps.currentExtent.width == 0xFFFFFFFF) ? size : surfCaps.currentExtent;
 
         uint32_t surfFmtCount = 0;
         XRC_CHECK_THROW_VKCMD(vkGetPhysicalDeviceSurfaceFormatsKHR(m_vkPhysicalDevice, surface, &surfFmtCount, nullptr));
@@ -1342,26 +2651,29 @@ namespace Conformance
         std::vector<VkPresentModeKHR> presentModes(presentModeCount);
         XRC_CHECK_THROW_VKCMD(vkGetPhysicalDeviceSurfacePresentModesKHR(m_vkPhysicalDevice, surface, &presentModeCount, &presentModes[0]));
 
-        // Do not use VSYNC for the mirror window, but Nvidia doesn't support IMMEDIATE so fall back to MAILBOX
-        VkPresentModeKHR presentMode = VK_PRESENT_MODE_IMMEDIATE_KHR;
-        for (uint32_t i = 0; i < presentModeCount; ++i) {
-            if ((presentModes[i] == VK_PRESENT_MODE_IMMEDIATE_KHR) || (presentModes[i] == VK_PRESENT_MODE_MAILBOX_KHR)) {
-                presentMode = presentModes[i];
+        // Do not use VSYNC for the mirror window. MAILBOX always has an image to acquire without tearing, fall back
+        // to IMMEDIATE, and to FIFO which every surface supports (a vsync'd window then just drops more frames).
+        VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
+        for (VkPresentModeKHR preferred : {VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR}) {
+            if (std::find(presentModes.begin(), presentModes.end(), preferred) != presentModes.end()) {
+                presentMode = preferred;
                 break;
             }
         }
 
-        VkBool32 presentable = false;
-        XRC_CHECK_THROW_VKCMD(vkGetPhysicalDeviceSurfaceSupportKHR(m_vkPhysicalDevice, m_queueFamilyIndex, surface, &presentable));
-        CHECK(presentable);
+        // One more than the minimum so that an image is free while one is displayed and another queued.
+        uint32_t imageCount = std::min(surfCaps.minImageCount + 1, maxImages);
+        if (surfCaps.maxImageCount != 0) {
+            imageCount = std::min(imageCount, surfCaps.maxImageCount);
+        }
 
         VkSwapchainCreateInfoKHR swapchainInfo{VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR};
         swapchainInfo.flags = 0;
         swapchainInfo.surface = surface;
-        swapchainInfo.minImageCount = surfCaps.minImageCount;
+        swapchainInfo.minImageCount = imageCount;
         swapchainInfo.imageFormat = format;
         swapchainInfo.imageColorSpace = surfFmts[foundFmt].colorSpace;
-        swapchainInfo.imageExtent = size;
+        swapchainInfo.imageExtent = m_extent;
         swapchainInfo.imageArrayLayers = 1;
         swapchainInfo.imageUsage = VK_IMAGE_USAGE_TRANSFER_DST_BIT;
         swapchainInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
@@ -1374,76 +2686,94 @@ namespace Conformance
         swapchainInfo.oldSwapchain = VK_NULL_HANDLE;
         XRC_CHECK_THROW_VKCMD(vkCreateSwapchainKHR(m_vkDevice, &swapchainInfo, nullptr, &swapchain));
 
-        // Fence to throttle host on Acquire
-        VkFenceCreateInfo fenceInfo{VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
-        XRC_CHECK_THROW_VKCMD(vkCreateFence(m_vkDevice, &fenceInfo, nullptr, &readyFence));
-
         swapchainCount = 0;
         XRC_CHECK_THROW_VKCMD(vkGetSwapchainImagesKHR(m_vkDevice, swapchain, &swapchainCount, nullptr));
-        assert(swapchainCount < maxImages);
+        XRC_CHECK_THROW_MSG(swapchainCount <= maxImages, "Mirror window swapchain has more images than supported");
         XRC_CHECK_THROW_VKCMD(vkGetSwapchainImagesKHR(m_vkDevice, swapchain, &swapchainCount, image));
-        if (swapchainCount > maxImages) {
-            //Log::Write(Log::Level::Info, "Reducing swapchain length from " + std::to_string(swapchainCount) + " to " + std::to_string(maxImages));
-            swapchainCount = maxImages;
-        }
 
-        //Log::Write(Log::Level::Info, "Swapchain length " + std::to_string(swapchainCount));
-    }
-
-    void Swapchain::Prepare(VkCommandBuffer buf)
-    {
-        // Convert swapchain images to VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+        VkSemaphoreCreateInfo semaphoreInfo{VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
         for (uint32_t i = 0; i < swapchainCount; ++i) {
-            VkImageMemoryBarrier imgBarrier{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
-            imgBarrier.srcAccessMask = 0;  // XXX was VK_ACCESS_TRANSFER_READ_BIT wrong?
-            imgBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-            imgBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-            imgBarrier.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-            imgBarrier.image = image[i];
-            imgBarrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
-            vkCmdPipelineBarrier(buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1,
-                                 &imgBarrier);
+            XRC_CHECK_THROW_VKCMD(vkCreateSemaphore(m_vkDevice, &semaphoreInfo, nullptr, &blitDone[i]));
         }
     }
 
-    void Swapchain::Wait()
+    void Swapchain::Present(VkQueue queue, VkImage srcImage, const VkImageBlit* regions, uint32_t regionCount)
     {
-        if (presentFence) {
-            // Wait for the fence...
-            XRC_CHECK_THROW_VKCMD(vkWaitForFences(m_vkDevice, 1, &presentFence, VK_TRUE, UINT64_MAX));
-            // ...then reset the fence for future Acquire calls
-            XRC_CHECK_THROW_VKCMD(vkResetFences(m_vkDevice, 1, &presentFence));
-            presentFence = VK_NULL_HANDLE;
+        // The previous blit still owns the command buffer and the acquire semaphore, skip this frame.
+        if (!cmdBuffer.Poll()) {
+            return;
         }
-    }
 
-    void Swapchain::Acquire(VkSemaphore readySemaphore)
-    {
-        // If we're not using a semaphore to rate-limit the GPU, rate limit the host with a fence instead
-        if (readySemaphore == VK_NULL_HANDLE) {
-            Wait();
-            presentFence = readyFence;
+        VkResult res = vkAcquireNextImageKHR(m_vkDevice, swapchain, 0, acquireSemaphore, VK_NULL_HANDLE, &renderImageIdx);
+        if ((res == VK_NOT_READY) || (res == VK_TIMEOUT)) {
+            return;
+        }
+        if (res == VK_ERROR_OUT_OF_DATE_KHR) {
+            Recreate();
+            return;
+        }
+        if (res != VK_SUBOPTIMAL_KHR) {
+            XRC_CHECK_THROW_VKRESULT(res, "vkAcquireNextImageKHR");
         }
 
-        XRC_CHECK_THROW_VKCMD(vkAcquireNextImageKHR(m_vkDevice, swapchain, UINT64_MAX, readySemaphore, presentFence, &renderImageIdx));
-    }
+        cmdBuffer.Clear();
+        cmdBuffer.Begin();
+
+        // The window image's old contents are never needed, the regions cover it.
+        VkImageMemoryBarrier toTransfer[2]{{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER}, {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER}};
+        toTransfer[0].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        toTransfer[0].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        toTransfer[0].oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        toTransfer[0].newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        toTransfer[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        toTransfer[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        toTransfer[0].image = srcImage;
+        toTransfer[0].subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, VK_REMAINING_ARRAY_LAYERS};
+        toTransfer[1].srcAccessMask = 0;
+        toTransfer[1].dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        toTransfer[1].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        toTransfer[1].newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        toTransfer[1].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        toTransfer[1].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        toTransfer[1].image = image[renderImageIdx];
+        toTransfer[1].subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+        vkCmdPipelineBarrier(cmdBuffer.buf, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 2, toTransfer);
+
+        // NEAREST, since not every color format supports linear filtering.
+        vkCmdBlitImage(cmdBuffer.buf, srcImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image[renderImageIdx],
+                       VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, regionCount, regions, VK_FILTER_NEAREST);
+
+        VkImageMemoryBarrier fromTransfer[2] = {toTransfer[0], toTransfer[1]};
+        fromTransfer[0].srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        fromTransfer[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        fromTransfer[0].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        fromTransfer[0].newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        fromTransfer[1].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        fromTransfer[1].dstAccessMask = 0;
+        fromTransfer[1].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        fromTransfer[1].newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        vkCmdPipelineBarrier(cmdBuffer.buf, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0,
+                             nullptr, 2, fromTransfer);
+
+        cmdBuffer.End();
+        cmdBuffer.Exec(queue, acquireSemaphore, VK_PIPELINE_STAGE_TRANSFER_BIT, blitDone[renderImageIdx]);
 
-    void Swapchain::Present(VkQueue queue, VkSemaphore drawComplete)
-    {
         VkPresentInfoKHR presentInfo{VK_STRUCTURE_TYPE_PRESENT_INFO_KHR};
-        if (drawComplete) {
-            presentInfo.waitSemaphoreCount = 1;
-            presentInfo.pWaitSemaphores = &drawComplete;
-        }
+        presentInfo.waitSemaphoreCount = 1;
+        presentInfo.pWaitSemaphores = &blitDone[renderImageIdx];
         presentInfo.swapchainCount = 1;
         presentInfo.pSwapchains = &swapchain;
         presentInfo.pImageIndices = &renderImageIdx;
-        auto res = vkQueuePresentKHR(queue, &presentInfo);
+        res = vkQueuePresentKHR(queue, &presentInfo);
         if (res == VK_ERROR_OUT_OF_DATE_KHR) {
             Recreate();
             return;
         }
-        XRC_CHECK_THROW_VKRESULT(res, "vkQueuePresentKHR");
+        if (res != VK_SUBOPTIMAL_KHR) {
+            XRC_CHECK_THROW_VKRESULT(res, "vkQueuePresentKHR");
+        }
     }
 #endif  // defined(USE_MIRROR_WINDOW)
 
@@ -1508,6 +2838,8 @@ namespace Conformance
 
         void InitializeResources();
 
+        void Flush() override;
+
         void ShutdownDevice() override;
 
         const XrBaseInStructure* GetGraphicsBinding() const override;
@@ -1536,7 +2868,14 @@ namespace Conformance
         void CopyRGBAImage(const XrSwapchainImageBaseHeader* swapchainImageBase, int64_t imageFormat, uint32_t arraySlice,
                            const RGBAImage& image) override;
 
-        void SetViewportAndScissor(const VkRect2D& rect);
+        // Records and submits the copy of CopyRGBAImage's staged levels on m_transferQueue, and the graphics queue's acquire.
+        void CopyRGBAImageOnTransferQueue(VkImage image, uint32_t mipCount, uint32_t arraySlice, StagingRing::Slot& staging,
+                                          const std::vector<VkBufferImageCopy>& regions);
+
+        std::future<RGBAImage> ReadbackSwapchainImage(const XrSwapchainImageBaseHeader* swapchainImageBase, int64_t imageFormat,
+                                                      uint32_t arraySlice) override;
+
+        void SetViewportAndScissor(VkCommandBuffer buf, const VkRect2D& rect);
 
         void ClearImageSlice(const XrSwapchainImageBaseHeader* colorSwapchainImage, uint32_t imageArrayIndex,
                              int64_t colorSwapchainFormat) override;
@@ -1544,11 +2883,54 @@ namespace Conformance
         void RenderView(const XrCompositionLayerProjectionView& layerView, const XrSwapchainImageBaseHeader* colorSwapchainImage,
                         int64_t colorSwapchainFormat, const std::vector<Cube>& cubes) override;
 
+        void RenderViews(const XrCompositionLayerProjectionView* layerViews, uint32_t viewCount,
+                         const XrSwapchainImageBaseHeader* colorSwapchainImage, int64_t colorSwapchainFormat,
+                         const std::vector<Cube>& cubes) override;
+
+        void ClearAndRenderViews(const XrCompositionLayerProjectionView* layerViews, uint32_t viewCount,
+                                 const XrSwapchainImageBaseHeader* colorSwapchainImage, int64_t colorSwapchainFormat,
+                                 const std::vector<Cube>& cubes) override;
+
+        bool RenderViewWithDepth(const XrCompositionLayerProjectionView& layerView, const XrSwapchainImageBaseHeader* colorSwapchainImage,
+                                 int64_t colorSwapchainFormat, const XrSwapchainImageBaseHeader* depthSwapchainImage,
+                                 int64_t depthSwapchainFormat, const std::vector<Cube>& cubes) override;
+
+        bool RenderViewWithVisibilityMask(const XrCompositionLayerProjectionView& layerView,
+                                          const XrSwapchainImageBaseHeader* colorSwapchainImage, int64_t colorSwapchainFormat,
+                                          const VisibilityMask& hiddenArea, const std::vector<Cube>& cubes) override;
+
+        bool SetGpuTimingEnabled(bool enabled) override;
+
+        void CollectGpuTimings(std::vector<GpuTimingSample>& samples) override;
+
+        bool SetSyntheticGpuLoad(uint32_t layerCount) override
+        {
+            m_syntheticGpuLoad.SetLayerCount(layerCount);
+            return true;
+        }
+
+        bool SetRenderSampleCount(uint32_t sampleCount) override;
+
+        bool GetGpuMemoryUsage(uint64_t* usedBytes) const override;
+
+        // Renders the views with either the plugin's depth buffers or, when depthSwapchainImage is not null, that image.
+        // hiddenArea, if not null, is drawn into every view before the cubes. With clear, the render passes clear the views
+        // as they load them, see ClearAndRenderViews.
+        void RenderViewsInto(const XrCompositionLayerProjectionView* layerViews, uint32_t viewCount,
+                             const XrSwapchainImageBaseHeader* colorSwapchainImage,
+                             const XrSwapchainImageBaseHeader* depthSwapchainImage, const std::vector<Cube>& sceneCubes,
+                             const std::vector<Geometry::PackedVertex>* hiddenArea = nullptr, bool clear = false);
+
+        // Writes the begin timestamp of a timing scope into a command buffer being recorded, outside a render pass.
+        // Returns the pair to pass to EndGpuTiming, or GpuTimestampRing::NoPair if the scope is not measured.
+        uint32_t BeginGpuTiming(VkCommandBuffer buf, const char* scope);
+        void EndGpuTiming(VkCommandBuffer buf, uint32_t pair);
+
 #if defined(USE_CHECKPOINTS)
         void Checkpoint(std::string msg)
         {
             auto check = checkpoints.emplace(std::move(msg));
-            vkCmdSetCheckpointNV(m_cmdBuffer.buf, check.first->c_str());
+            vkCmdSetCheckpointNV(m_cmdBufferRing.Current().buf, check.first->c_str());
         }
 
         void ShowCheckpoints()
@@ -1586,12 +2968,53 @@ namespace Conformance
         uint32_t m_queueFamilyIndex = 0;
         VkQueue m_vkQueue{VK_NULL_HANDLE};
         VkSemaphore m_vkDrawDone{VK_NULL_HANDLE};
+        // A queue of a transfer-only family, where there is one and the timeline semaphore to order it after m_vkQueue,
+        // for CopyRGBAImage to upload on while rendering continues.
+        uint32_t m_transferQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        VkQueue m_transferQueue{VK_NULL_HANDLE};
 
         MemoryAllocator m_memAllocator{};
         ShaderProgram m_shaderProgram{};
-        CmdBuffer m_cmdBuffer{};
+        // Shared by every CmdBuffer below that submits to m_vkQueue. Only m_vkQueue signals it, so its values stay in order.
+        SubmissionTracker m_submissionTracker{};
+        CmdBufferRing m_cmdBufferRing{};
+        StagingRing m_stagingRing{};
+        // Copies on m_transferQueue, tracked by fences, each followed by an acquire on m_vkQueue.
+        StagingRing m_transferStagingRing{};
         PipelineLayout m_pipelineLayout{};
-        VertexBuffer<Geometry::Vertex> m_drawBuffer{};
+        // Shared by the pipelines of every swapchain image context. Its contents are kept in m_pipelineCacheData
+        // across devices, and in Options::vulkanPipelineCacheFile across runs.
+        PipelineCache m_pipelineCache{};
+        std::vector<uint8_t> m_pipelineCacheData;
+        ProjectionCache<GRAPHICS_VULKAN> m_projectionCache;
+        VertexBuffer<Geometry::PackedVertex> m_drawBuffer{};
+        // Per-cube MVPs for RenderView, one buffer per in-flight command buffer.
+        std::array<InstanceBuffer, CmdBufferRing::FramesInFlight> m_instanceBuffers{};
+        // Hidden area vertices for RenderViewWithVisibilityMask, likewise, and the scratch space they are built in.
+        std::array<InstanceBuffer, CmdBufferRing::FramesInFlight> m_hiddenAreaBuffers{};
+        std::vector<Geometry::PackedVertex> m_hiddenAreaVertices;
+        // The render pass and view-projection transform of each view of the current RenderViews call, and whether
+        // it has to clear depth left behind for another array slice first.
+        std::vector<VkRenderPassBeginInfo> m_viewRenderPasses;
+        std::vector<XrMatrix4x4f> m_viewProjections;
+        std::vector<bool> m_viewClearsDepth;
+        std::vector<uint32_t> m_depthClearedSlices;  // the array slices whose views clear their own depth, in RenderViewsInto
+        DepthBufferCache m_depthBuffers{};
+        // Started on the first RenderViews call that records views in parallel, see Options::vulkanRecordThreads.
+        ViewRecorder m_viewRecorder{};
+
+        // GPU timing: the pool holds a begin and an end timestamp for each pair of the ring.
+        static constexpr uint32_t TimestampPairCount = 256;
+        VkQueryPool m_timestampPool{VK_NULL_HANDLE};
+        GpuTimestampRing m_timestampRing;
+        uint32_t m_timestampValidBits{0};
+        float m_timestampPeriod{0};
+        bool m_gpuTimingEnabled{false};
+        SyntheticGpuLoad m_syntheticGpuLoad;
+        VkSampleCountFlagBits m_renderSampleCount{VK_SAMPLE_COUNT_1_BIT};
+
+        // Set when VK_EXT_memory_budget is enabled on the device, for GetGpuMemoryUsage.
+        PFN_vkGetPhysicalDeviceMemoryProperties2KHR m_vkGetPhysicalDeviceMemoryProperties2KHR{nullptr};
 
 #if defined(USE_MIRROR_WINDOW)
         Swapchain m_swapchain{};
@@ -1986,6 +3409,27 @@ namespace Conformance
             // Note: This cannot outlive the extensionNames above, since it's just a collection of views into that string!
             std::vector<const char*> extensions;
             extensions.push_back("VK_EXT_debug_report");
+#if defined(USE_MIRROR_WINDOW)
+            extensions.push_back(VK_KHR_SURFACE_EXTENSION_NAME);
+#if defined(VK_USE_PLATFORM_WIN32_KHR)
+            extensions.push_back(VK_KHR_WIN32_SURFACE_EXTENSION_NAME);
+#elif defined(VK_USE_PLATFORM_XLIB_KHR)
+            extensions.push_back(VK_KHR_XLIB_SURFACE_EXTENSION_NAME);
+#endif
+#endif
+
+            // Needed to query VK_EXT_memory_budget on a Vulkan 1.0 instance.
+            {
+                uint32_t extensionCount = 0;
+                XRC_CHECK_THROW_VKCMD(vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr));
+                std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+                XRC_CHECK_THROW_VKCMD(vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, availableExtensions.data()));
+                for (const VkExtensionProperties& extension : availableExtensions) {
+                    if (strcmp(extension.extensionName, VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME) == 0) {
+                        extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+                    }
+                }
+            }
 
             std::vector<const char*> layers;
 #if !defined(NDEBUG)
@@ -2081,7 +3525,69 @@ namespace Conformance
             }
         }
 
+        // A family that can only transfer is usually backed by a copy engine that runs alongside the graphics queue.
+        uint32_t transferQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        for (uint32_t i = 0; i < queueFamilyCount; ++i) {
+            const VkQueueFlags flags = queueFamilyProps[i].queueFlags;
+            if ((flags & VK_QUEUE_TRANSFER_BIT) != 0u && (flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)) == 0u) {
+                transferQueueFamilyIndex = i;
+                break;
+            }
+        }
+
+        VkPhysicalDeviceProperties physicalDeviceProperties{};
+        vkGetPhysicalDeviceProperties(m_vkPhysicalDevice, &physicalDeviceProperties);
+        m_timestampValidBits = queueFamilyProps[m_queueFamilyIndex].timestampValidBits;
+        m_timestampPeriod = physicalDeviceProperties.limits.timestampPeriod;
+        m_gpuTimingEnabled = false;
+
         std::vector<const char*> deviceExtensions;
+#if defined(USE_MIRROR_WINDOW)
+        deviceExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+#endif
+
+        uint32_t extensionCount = 0;
+        XRC_CHECK_THROW_VKCMD(vkEnumerateDeviceExtensionProperties(m_vkPhysicalDevice, nullptr, &extensionCount, nullptr));
+        std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+        XRC_CHECK_THROW_VKCMD(
+            vkEnumerateDeviceExtensionProperties(m_vkPhysicalDevice, nullptr, &extensionCount, availableExtensions.data()));
+        auto isExtensionAvailable = [&](const char* name) {
+            return std::any_of(availableExtensions.begin(), availableExtensions.end(),
+                               [name](const VkExtensionProperties& extension) { return strcmp(extension.extensionName, name) == 0; });
+        };
+
+        // Enable VK_EXT_memory_budget where available, so that GetGpuMemoryUsage can report heap usage.
+        m_vkGetPhysicalDeviceMemoryProperties2KHR = nullptr;
+        auto vkGetPhysicalDeviceMemoryProperties2KHR = (PFN_vkGetPhysicalDeviceMemoryProperties2KHR)vkGetInstanceProcAddr(
+            m_vkInstance, "vkGetPhysicalDeviceMemoryProperties2KHR");
+        if (vkGetPhysicalDeviceMemoryProperties2KHR != nullptr && isExtensionAvailable(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME)) {
+            deviceExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+            m_vkGetPhysicalDeviceMemoryProperties2KHR = vkGetPhysicalDeviceMemoryProperties2KHR;
+        }
+
+        // Enable VK_KHR_timeline_semaphore where the device supports it, so that m_submissionTracker can retire
+        // submissions by counter value. Without it every command buffer keeps its own fence.
+        VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timelineSemaphoreFeatures{
+            VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR};
+        auto vkGetPhysicalDeviceFeatures2KHR =
+            (PFN_vkGetPhysicalDeviceFeatures2KHR)vkGetInstanceProcAddr(m_vkInstance, "vkGetPhysicalDeviceFeatures2KHR");
+        if (vkGetPhysicalDeviceFeatures2KHR != nullptr && isExtensionAvailable(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME)) {
+            VkPhysicalDeviceFeatures2KHR features2{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR};
+            features2.pNext = &timelineSemaphoreFeatures;
+            vkGetPhysicalDeviceFeatures2KHR(m_vkPhysicalDevice, &features2);
+            timelineSemaphoreFeatures.pNext = nullptr;
+            if (timelineSemaphoreFeatures.timelineSemaphore == VK_TRUE) {
+                deviceExtensions.push_back(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+            }
+        }
+        const bool useTimelineSemaphore = timelineSemaphoreFeatures.timelineSemaphore == VK_TRUE;
+
+        // Uploads on the transfer queue wait for the graphics queue's earlier work on the timeline semaphore.
+        std::array<VkDeviceQueueCreateInfo, 2> queueInfos{{queueInfo, queueInfo}};
+        uint32_t queueInfoCount = 1;
+        if (useTimelineSemaphore && transferQueueFamilyIndex != VK_QUEUE_FAMILY_IGNORED) {
+            queueInfos[queueInfoCount++].queueFamilyIndex = transferQueueFamilyIndex;
+        }
 
         VkPhysicalDeviceFeatures features{};
         // features.samplerAnisotropy = VK_TRUE;
@@ -2089,9 +3595,10 @@ namespace Conformance
         // features.shaderStorageImageMultisample = VK_TRUE;
 
         VkDeviceCreateInfo deviceInfo{VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO};
+        deviceInfo.pNext = useTimelineSemaphore ? &timelineSemaphoreFeatures : nullptr;
         deviceInfo.flags = VkDeviceCreateFlags(deviceCreationFlags);
-        deviceInfo.queueCreateInfoCount = 1;
-        deviceInfo.pQueueCreateInfos = &queueInfo;
+        deviceInfo.queueCreateInfoCount = queueInfoCount;
+        deviceInfo.pQueueCreateInfos = queueInfos.data();
         deviceInfo.enabledLayerCount = 0;
         deviceInfo.ppEnabledLayerNames = nullptr;
         deviceInfo.enabledExtensionCount = (uint32_t)deviceExtensions.size();
@@ -2109,7 +3616,20 @@ namespace Conformance
 
         vkGetDeviceQueue(m_vkDevice, queueInfo.queueFamilyIndex, 0, &m_vkQueue);
 
+        m_submissionTracker.Reset();
+        if (useTimelineSemaphore) {
+            m_submissionTracker.Init(m_vkDevice);
+        }
+
+        m_transferQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        m_transferQueue = VK_NULL_HANDLE;
+        if (queueInfoCount > 1 && m_submissionTracker.IsTimeline()) {
+            m_transferQueueFamilyIndex = transferQueueFamilyIndex;
+            vkGetDeviceQueue(m_vkDevice, m_transferQueueFamilyIndex, 0, &m_transferQueue);
+        }
+
         m_memAllocator.Init(m_vkPhysicalDevice, m_vkDevice);
+        m_depthBuffers.Init(m_vkDevice, &m_memAllocator);
 
         InitializeResources();
 
@@ -2145,56 +3665,92 @@ namespace Conformance
     void VulkanGraphicsPlugin::InitializeResources()
     {
 #ifdef USE_ONLINE_VULKAN_SHADERC
-        auto vertexSPIRV = CompileGlslShader("vertex", shaderc_glsl_default_vertex_shader, VertexShaderGlsl);
-        auto fragmentSPIRV = CompileGlslShader("fragment", shaderc_glsl_default_fragment_shader, FragmentShaderGlsl);
-#else
-        std::vector<uint32_t> vertexSPIRV = SPV_PREFIX
-#include "vert.spv"
-            SPV_SUFFIX;
-        std::vector<uint32_t> fragmentSPIRV = SPV_PREFIX
-#include "frag.spv"
-            SPV_SUFFIX;
-#endif
+        // The device is initialized many times per run, so only compile once.
+        static const std::vector<uint32_t> vertexSPIRV =
+            CompileGlslShader("vertex", shaderc_glsl_default_vertex_shader, VertexShaderGlsl);
+        static const std::vector<uint32_t> fragmentSPIRV =
+            CompileGlslShader("fragment", shaderc_glsl_default_fragment_shader, FragmentShaderGlsl);
         if (vertexSPIRV.empty())
             XRC_THROW("Failed to compile vertex shader");
         if (fragmentSPIRV.empty())
             XRC_THROW("Failed to compile fragment shader");
 
         m_shaderProgram.Init(m_vkDevice);
-        m_shaderProgram.LoadVertexShader(vertexSPIRV);
-        m_shaderProgram.LoadFragmentShader(fragmentSPIRV);
+        m_shaderProgram.LoadVertexShader(vertexSPIRV.data(), vertexSPIRV.size());
+        m_shaderProgram.LoadFragmentShader(fragmentSPIRV.data(), fragmentSPIRV.size());
+#else
+        m_shaderProgram.Init(m_vkDevice);
+        m_shaderProgram.LoadVertexShader(VertexShaderSpirv, sizeof(VertexShaderSpirv) / sizeof(VertexShaderSpirv[0]));
+        m_shaderProgram.LoadFragmentShader(FragmentShaderSpirv, sizeof(FragmentShaderSpirv) / sizeof(FragmentShaderSpirv[0]));
+#endif
 
         // Semaphore to block on draw complete
         VkSemaphoreCreateInfo semInfo{VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
         XRC_CHECK_THROW_VKCMD(vkCreateSemaphore(m_vkDevice, &semInfo, nullptr, &m_vkDrawDone));
 
-        if (!m_cmdBuffer.Init(m_vkDevice, m_queueFamilyIndex))
-            XRC_THROW("Failed to create command buffer");
+        if (!m_cmdBufferRing.Init(m_vkDevice, m_queueFamilyIndex, &m_submissionTracker))
+            XRC_THROW("Failed to create command buffers");
+
+        m_stagingRing.Init(m_vkDevice, &m_memAllocator, m_queueFamilyIndex, &m_submissionTracker);
+        if (m_transferQueue != VK_NULL_HANDLE) {
+            m_transferStagingRing.Init(m_vkDevice, &m_memAllocator, m_transferQueueFamilyIndex, nullptr, m_queueFamilyIndex,
+                                       &m_submissionTracker);
+        }
 
         m_pipelineLayout.Create(m_vkDevice);
 
-        static_assert(sizeof(Geometry::Vertex) == 24, "Unexpected Vertex size");
+        const std::string& pipelineCacheFile = GetGlobalData().options.vulkanPipelineCacheFile;
+        if (m_pipelineCacheData.empty() && !pipelineCacheFile.empty()) {
+            std::ifstream file(pipelineCacheFile, std::ios::binary);
+            m_pipelineCacheData.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+        if (!m_pipelineCacheData.empty()) {
+            VkPhysicalDeviceProperties properties{};
+            vkGetPhysicalDeviceProperties(m_vkPhysicalDevice, &properties);
+            if (!PipelineCache::IsCompatible(m_pipelineCacheData, properties)) {
+                ReportF("Vulkan pipeline cache is from another device or driver version, starting empty");
+                m_pipelineCacheData.clear();
+            }
+        }
+        m_pipelineCache.Create(m_vkDevice, m_pipelineCacheData);
+
+        static_assert(sizeof(Geometry::PackedVertex) == 12, "Unexpected Vertex size");
+        // Binding 1 carries one column-major MVP per cube instance, a mat4 spanning locations 2-5.
+        static_assert(sizeof(XrMatrix4x4f) == 64, "Unexpected XrMatrix4x4f size");
         m_drawBuffer.Init(m_vkDevice, &m_memAllocator,
-                          {{0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Geometry::Vertex, Position)},
-                           {1, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Geometry::Vertex, Color)}});
-        uint32_t numCubeIdicies = sizeof(Geometry::c_cubeIndices) / sizeof(Geometry::c_cubeIndices[0]);
-        uint32_t numCubeVerticies = sizeof(Geometry::c_cubeVertices) / sizeof(Geometry::c_cubeVertices[0]);
-        m_drawBuffer.Create(numCubeIdicies, numCubeVerticies);
-        m_drawBuffer.UpdateIndicies(Geometry::c_cubeIndices.data(), numCubeIdicies, 0);
-        m_drawBuffer.UpdateVertices(Geometry::c_cubeVertices.data(), numCubeVerticies, 0);
+                          {{0, 0, VK_FORMAT_R16G16B16A16_SFLOAT, offsetof(Geometry::PackedVertex, Position)},
+                           {1, 0, VK_FORMAT_R8G8B8A8_UNORM, offsetof(Geometry::PackedVertex, Color)},
+                           {2, 1, VK_FORMAT_R32G32B32A32_SFLOAT, 0},
+                           {3, 1, VK_FORMAT_R32G32B32A32_SFLOAT, 16},
+                           {4, 1, VK_FORMAT_R32G32B32A32_SFLOAT, 32},
+                           {5, 1, VK_FORMAT_R32G32B32A32_SFLOAT, 48}});
+        m_drawBuffer.SetInstanceBinding(1, sizeof(XrMatrix4x4f));
+        const MeshBuffer& meshes = GetSharedMeshes().buffer;
+        const auto indexCount = (uint32_t)meshes.Indices().size();
+        const auto vertexCount = (uint32_t)meshes.Vertices().size();
+        m_drawBuffer.Create(indexCount, vertexCount);
+        m_drawBuffer.UpdateIndicies(meshes.Indices().data(), indexCount, 0);
+        m_drawBuffer.UpdateVertices(meshes.Vertices().data(), vertexCount, 0);
+        for (auto& instanceBuffer : m_instanceBuffers) {
+            instanceBuffer.Init(m_vkDevice, &m_memAllocator);
+        }
+        for (auto& hiddenAreaBuffer : m_hiddenAreaBuffers) {
+            hiddenAreaBuffer.Init(m_vkDevice, &m_memAllocator);
+        }
 
 #if defined(USE_MIRROR_WINDOW)
-        m_swapchain.Create(m_vkInstance, m_vkPhysicalDevice, m_vkDevice, m_graphicsBinding.queueFamilyIndex);
-
-        m_cmdBuffer.Clear();
-        m_cmdBuffer.Begin();
-        m_swapchain.Prepare(m_cmdBuffer.buf);
-        m_cmdBuffer.End();
-        m_cmdBuffer.Exec(m_vkQueue);
-        m_cmdBuffer.Wait();
+        m_swapchain.Create(m_vkInstance, m_vkPhysicalDevice, m_vkDevice, m_graphicsBinding.queueFamilyIndex, &m_submissionTracker);
 #endif
     }
 
+    void VulkanGraphicsPlugin::Flush()
+    {
+        // Uploads and rendering are left in flight, make sure none outlive the caller's resources.
+        m_stagingRing.WaitAll();
+        m_transferStagingRing.WaitAll();
+        m_cmdBufferRing.WaitAll();
+    }
+
     void VulkanGraphicsPlugin::ShutdownDevice()
     {
         if (m_vkDevice != VK_NULL_HANDLE) {
@@ -2207,16 +3763,49 @@ namespace Conformance
                 ctx.second->Reset();
             }
             m_swapchainImageContextMap.clear();
+            m_depthBuffers.Reset();
 
             m_queueFamilyIndex = 0;
             m_vkQueue = VK_NULL_HANDLE;
+            m_transferQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            m_transferQueue = VK_NULL_HANDLE;
             if (m_vkDrawDone) {
                 vkDestroySemaphore(m_vkDevice, m_vkDrawDone, nullptr);
                 m_vkDrawDone = VK_NULL_HANDLE;
             }
 
+            for (auto& instanceBuffer : m_instanceBuffers) {
+                instanceBuffer.Reset();
+            }
+            for (auto& hiddenAreaBuffer : m_hiddenAreaBuffers) {
+                hiddenAreaBuffer.Reset();
+            }
             m_drawBuffer.Reset();
-            m_cmdBuffer.Reset();
+            m_stagingRing.Reset();
+            m_transferStagingRing.Reset();
+            m_viewRecorder.Reset();
+            m_cmdBufferRing.Reset();
+
+            if (m_timestampPool != VK_NULL_HANDLE) {
+                vkDestroyQueryPool(m_vkDevice, m_timestampPool, nullptr);
+                m_timestampPool = VK_NULL_HANDLE;
+            }
+            m_timestampRing.Reset(0);
+            m_gpuTimingEnabled = false;
+            m_syntheticGpuLoad.SetLayerCount(0);
+            m_renderSampleCount = VK_SAMPLE_COUNT_1_BIT;
+            m_vkGetPhysicalDeviceMemoryProperties2KHR = nullptr;
+
+            std::vector<uint8_t> pipelineCacheData = m_pipelineCache.GetData();
+            if (!pipelineCacheData.empty()) {
+                m_pipelineCacheData = std::move(pipelineCacheData);
+                const std::string& pipelineCacheFile = GetGlobalData().options.vulkanPipelineCacheFile;
+                if (!pipelineCacheFile.empty() &&
+                    !WriteFileReplacing(pipelineCacheFile, m_pipelineCacheData.data(), m_pipelineCacheData.size())) {
+                    ReportF("Failed to write Vulkan pipeline cache %s", pipelineCacheFile.c_str());
+                }
+            }
+            m_pipelineCache.Reset();
             m_pipelineLayout.Reset();
             m_shaderProgram.Reset();
             m_memAllocator.Reset();
@@ -2225,6 +3814,7 @@ namespace Conformance
             m_swapchain.Reset();
             m_swapchainImageContexts.clear();
 #endif
+            m_submissionTracker.Reset();
             vkDestroyDevice(m_vkDevice, nullptr);
             m_vkDevice = VK_NULL_HANDLE;
         }
@@ -2586,8 +4176,9 @@ namespace Conformance
         // Return back an array of pointers to each swapchain image struct so the consumer doesn't need to know the type/size.
         // Keep the buffer alive by adding it into the list of buffers.
 
-        std::vector<XrSwapchainImageBaseHeader*> bases = derivedResult->Create(
-            m_vkDevice, &m_memAllocator, uint32_t(size), swapchainCreateInfo, m_pipelineLayout, m_shaderProgram, m_drawBuffer);
+        std::vector<XrSwapchainImageBaseHeader*> bases =
+            derivedResult->Create(m_vkDevice, &m_memAllocator, &m_depthBuffers, uint32_t(size), swapchainCreateInfo, m_pipelineLayout,
+                                  m_shaderProgram, m_drawBuffer, m_pipelineCache.cache);
 
         for (auto& base : bases) {
             // Set the generic vector of base pointers
@@ -2598,7 +4189,9 @@ namespace Conformance
 
 #if defined(USE_MIRROR_WINDOW)
         // Keep these around for mirror rendering
-        m_swapchainImageContexts.push_back(derivedResult);
+        if (!derivedResult->IsDepthSwapchain()) {
+            m_swapchainImageContexts.push_back(derivedResult);
+        }
 #endif
 
         // Cast our derived type to the caller-expected type.
@@ -2608,67 +4201,74 @@ namespace Conformance
         return result;
     }
 
-    void VulkanGraphicsPlugin::CopyRGBAImage(const XrSwapchainImageBaseHeader* swapchainImageBase, int64_t imageFormat, uint32_t arraySlice,
-                                             const RGBAImage& image)
+    void VulkanGraphicsPlugin::CopyRGBAImage(const XrSwapchainImageBaseHeader* swapchainImageBase, int64_t /*imageFormat*/,
+                                             uint32_t arraySlice, const RGBAImage& image)
     {
+        XR_TRACE_SCOPE("VulkanGraphicsPlugin::CopyRGBAImage");
+
         const XrSwapchainImageVulkanKHR* swapchainImageVk = reinterpret_cast<const XrSwapchainImageVulkanKHR*>(swapchainImageBase);
+        const SwapchainImageContext& swapchainContext = *m_swapchainImageContextMap[swapchainImageBase];
 
         uint32_t w = image.width;
         uint32_t h = image.height;
 
-        // Create a linear staging buffer
-        VkImageCreateInfo imgInfo{VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
-        imgInfo.imageType = VK_IMAGE_TYPE_2D;
-        imgInfo.format = static_cast<VkFormat>(imageFormat);
-        imgInfo.extent = {w, h, 1};
-        imgInfo.mipLevels = 1;
-        imgInfo.arrayLayers = 1;
-        imgInfo.samples = VK_SAMPLE_COUNT_1_BIT;
-        imgInfo.tiling = VK_IMAGE_TILING_LINEAR;
-        imgInfo.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
-        imgInfo.initialLayout = VK_IMAGE_LAYOUT_PREINITIALIZED;
-        VkImage stagingImage{VK_NULL_HANDLE};
-        XRC_CHECK_THROW_VKCMD(vkCreateImage(m_vkDevice, &imgInfo, nullptr, &stagingImage));
-
-        VkMemoryRequirements memReq{};
-        vkGetImageMemoryRequirements(m_vkDevice, stagingImage, &memReq);
-        VkDeviceMemory stagingMemory{VK_NULL_HANDLE};
-        m_memAllocator.Allocate(memReq, &stagingMemory, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-        XRC_CHECK_THROW_VKCMD(vkBindImageMemory(m_vkDevice, stagingImage, stagingMemory, 0));
-
-        VkImageSubresource imgSubRes{};
-        imgSubRes.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        imgSubRes.mipLevel = 0;
-        imgSubRes.arrayLayer = 0;
-        VkSubresourceLayout layout{};
-        vkGetImageSubresourceLayout(m_vkDevice, stagingImage, &imgSubRes, &layout);
-
-        uint8_t* data{nullptr};
-        XRC_CHECK_THROW_VKCMD(vkMapMemory(m_vkDevice, stagingMemory, layout.offset, layout.size, 0, (void**)&data));
-        const size_t rowSize = w * sizeof(RGBA8Color);
-        for (size_t row = 0; row < h; ++row) {
-            uint8_t* rowPtr = &data[layout.offset + row * layout.rowPitch];
-            // Note pixels is a vector<RGBA8Color>
-            memcpy(rowPtr, &image.pixels[row * w], rowSize);
-        }
-        vkUnmapMemory(m_vkDevice, stagingMemory);
-
-        m_cmdBuffer.Clear();
-        m_cmdBuffer.Begin();
-
-        // Switch the staging buffer from PREINITIALIZED -> TRANSFER_SRC_OPTIMAL
+        // Lower mip levels are filtered from level 0 on the GPU with a chain of blits where the swapchain and format allow it,
+        // and are otherwise downsampled on the CPU and uploaded along with level 0.
+        const uint32_t mipCount = swapchainContext.mipCount;
+        bool blitMips = false;
+        if (mipCount > 1 && (swapchainContext.usageFlags & XR_SWAPCHAIN_USAGE_TRANSFER_SRC_BIT) != 0) {
+            constexpr VkFormatFeatureFlags blitFeatures =
+                VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+            VkFormatProperties formatProperties{};
+            vkGetPhysicalDeviceFormatProperties(m_vkPhysicalDevice, swapchainContext.format, &formatProperties);
+            blitMips = (formatProperties.optimalTilingFeatures & blitFeatures) == blitFeatures;
+        }
+        std::vector<RGBAImage> cpuMips;
+        if (mipCount > 1 && !blitMips) {
+            cpuMips.reserve(mipCount - 1);
+            for (uint32_t level = 1; level < mipCount; ++level) {
+                cpuMips.push_back((level == 1 ? image : cpuMips.back()).Downsampled());
+            }
+        }
+
+        // Stage the pixels in the next persistently mapped upload buffer, tightly packed in the texel layout of the format.
+        // VK_EXT_host_image_copy could skip the staging buffer and command buffer, but only for images created with
+        // VK_IMAGE_USAGE_HOST_TRANSFER_BIT_EXT, and the runtime creates swapchain images from XrSwapchainUsageFlags,
+        // none of which asks for it.
+        const RGBATexelLayout texelLayout = GetVkRGBATexelLayout(swapchainContext.format);
+        const size_t texelSize = RGBATexelSize(texelLayout);
+        std::vector<VkBufferImageCopy> regions;
+        VkDeviceSize stagingSize = 0;
+        for (uint32_t level = 0; level < 1 + cpuMips.size(); ++level) {
+            const RGBAImage& levelImage = level == 0 ? image : cpuMips[level - 1];
+            VkBufferImageCopy region{};
+            region.bufferOffset = stagingSize;
+            region.bufferRowLength = 0;  // tightly packed
+            region.bufferImageHeight = 0;
+            region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, arraySlice, 1};
+            region.imageOffset = {0, 0, 0};
+            region.imageExtent = {uint32_t(levelImage.width), uint32_t(levelImage.height), 1};
+            regions.push_back(region);
+            stagingSize += VkDeviceSize(levelImage.width) * levelImage.height * texelSize;
+        }
+        // Blits need a graphics queue, anything else is copied on the transfer queue where there is one.
+        const bool useTransferQueue = m_transferQueue != VK_NULL_HANDLE && !blitMips;
+        StagingRing::Slot& staging = (useTransferQueue ? m_transferStagingRing : m_stagingRing).Acquire(stagingSize);
+        for (uint32_t level = 0; level < regions.size(); ++level) {
+            const RGBAImage& levelImage = level == 0 ? image : cpuMips[level - 1];
+            WriteRGBATexels(levelImage, texelLayout, staging.mapped + regions[level].bufferOffset, levelImage.width * texelSize);
+        }
+
+        if (useTransferQueue) {
+            CopyRGBAImageOnTransferQueue(swapchainImageVk->image, mipCount, arraySlice, staging, regions);
+            return;
+        }
+
+        CmdBuffer& cmdBuffer = staging.cmdBuffer;
+        cmdBuffer.Begin();
+        const uint32_t timingPair = BeginGpuTiming(cmdBuffer.buf, "CopyRGBAImage");
+
         VkImageMemoryBarrier imgBarrier{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
-        imgBarrier.srcAccessMask = 0;
-        imgBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-        imgBarrier.oldLayout = VK_IMAGE_LAYOUT_PREINITIALIZED;
-        imgBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-        imgBarrier.srcQueueFamilyIndex = m_queueFamilyIndex;
-        imgBarrier.dstQueueFamilyIndex = m_queueFamilyIndex;
-        imgBarrier.image = stagingImage;
-        imgBarrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
-        vkCmdPipelineBarrier(m_cmdBuffer.buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1,
-                             &imgBarrier);
 
         // Switch the destination image from COLOR_ATTACHMENT_OPTIMAL -> TRANSFER_DST_OPTIMAL
         //
@@ -2679,26 +4279,51 @@ namespace Conformance
         // - The image has a memory layout compatible with VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
         //   for color images, or VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL for depth images.
         // - The VkQueue specified in XrGraphicsBindingVulkanKHR has ownership of the image.
-        imgBarrier.srcAccessMask = 0;
+        //
+        // Earlier work on this image is no longer waited for on the host, so order the layout
+        // transition after any color attachment writes still in flight.
+        imgBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
         imgBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
         imgBarrier.oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
         imgBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
         imgBarrier.srcQueueFamilyIndex = m_queueFamilyIndex;
         imgBarrier.dstQueueFamilyIndex = m_queueFamilyIndex;
         imgBarrier.image = swapchainImageVk->image;
-        imgBarrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, arraySlice, 1};
-        vkCmdPipelineBarrier(m_cmdBuffer.buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1,
-                             &imgBarrier);
-
-        // Blit staging -> swapchain
-        VkImageBlit blit = {{VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1},
-                            {{0, 0, 0}, {(int32_t)w, (int32_t)h, 1}},
-                            {VK_IMAGE_ASPECT_COLOR_BIT, 0, arraySlice, 1},
-                            {{0, 0, 0}, {(int32_t)w, (int32_t)h, 1}}};
-        vkCmdBlitImage(m_cmdBuffer.buf, stagingImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, swapchainImageVk->image,
-                       VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_NEAREST);
-
-        // Switch the destination image from TRANSFER_DST_OPTIMAL -> COLOR_ATTACHMENT_OPTIMAL
+        imgBarrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, mipCount, arraySlice, 1};
+        vkCmdPipelineBarrier(cmdBuffer.buf, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imgBarrier);
+
+        // Copy staging -> swapchain
+        vkCmdCopyBufferToImage(cmdBuffer.buf, staging.buf, swapchainImageVk->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                               uint32_t(regions.size()), regions.data());
+
+        // Each level is blitted from the one above it once that one is written and switched to TRANSFER_SRC_OPTIMAL,
+        // which leaves every level but the last in TRANSFER_SRC_OPTIMAL.
+        uint32_t sourceLevels = 0;
+        if (blitMips) {
+            for (uint32_t level = 1; level < mipCount; ++level) {
+                imgBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+                imgBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+                imgBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+                imgBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+                imgBarrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 1, arraySlice, 1};
+                vkCmdPipelineBarrier(cmdBuffer.buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0,
+                                     nullptr, 1, &imgBarrier);
+
+                const int32_t sourceWidth = int32_t(std::max(1u, w >> (level - 1)));
+                const int32_t sourceHeight = int32_t(std::max(1u, h >> (level - 1)));
+                VkImageBlit blit{};
+                blit.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level - 1, arraySlice, 1};
+                blit.srcOffsets[1] = {sourceWidth, sourceHeight, 1};
+                blit.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, arraySlice, 1};
+                blit.dstOffsets[1] = {std::max(1, sourceWidth / 2), std::max(1, sourceHeight / 2), 1};
+                vkCmdBlitImage(cmdBuffer.buf, swapchainImageVk->image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, swapchainImageVk->image,
+                               VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+            }
+            sourceLevels = mipCount - 1;
+        }
+
+        // Switch the destination image from TRANSFER_DST_OPTIMAL (and TRANSFER_SRC_OPTIMAL) -> COLOR_ATTACHMENT_OPTIMAL
         //
         // XR_KHR_vulkan_enable / XR_KHR_vulkan_enable2:
         // When an application releases a swapchain image by calling xrReleaseSwapchainImage,
@@ -2708,30 +4333,147 @@ namespace Conformance
         //    for color images, or VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL for depth
         //    images.
         //  - Being owned by the VkQueue specified in XrGraphicsBindingVulkanKHR.
+        VkImageMemoryBarrier releaseBarriers[2];
+        uint32_t releaseBarrierCount = 0;
+        if (sourceLevels > 0) {
+            VkImageMemoryBarrier& sourceBarrier = releaseBarriers[releaseBarrierCount++];
+            sourceBarrier = imgBarrier;
+            sourceBarrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+            sourceBarrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT;
+            sourceBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+            sourceBarrier.newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            sourceBarrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, sourceLevels, arraySlice, 1};
+        }
+        VkImageMemoryBarrier& destBarrier = releaseBarriers[releaseBarrierCount++];
+        destBarrier = imgBarrier;
+        destBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        destBarrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT;
+        destBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        destBarrier.newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        destBarrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, sourceLevels, mipCount - sourceLevels, arraySlice, 1};
+        vkCmdPipelineBarrier(cmdBuffer.buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0, 0, nullptr,
+                             0, nullptr, releaseBarrierCount, releaseBarriers);
+
+        EndGpuTiming(cmdBuffer.buf, timingPair);
+        cmdBuffer.End();
+        // No wait here: the staging ring only blocks when this slot comes around again.
+        cmdBuffer.Exec(m_vkQueue);
+    }
+
+    void VulkanGraphicsPlugin::CopyRGBAImageOnTransferQueue(VkImage image, uint32_t mipCount, uint32_t arraySlice,
+                                                            StagingRing::Slot& staging, const std::vector<VkBufferImageCopy>& regions)
+    {
+        // Every level of the slice is overwritten, so the transfer queue can take the image without an ownership transfer
+        // from the graphics queue, discarding its contents. Waiting for the last graphics submission orders the copy after
+        // any color attachment writes to it still in flight. There is no GPU timing here, since transfer queues cannot
+        // reset the timestamp queries.
+        CmdBuffer& copyCmdBuffer = staging.cmdBuffer;
+        copyCmdBuffer.Begin();
+
+        VkImageMemoryBarrier imgBarrier{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+        imgBarrier.srcAccessMask = 0;
+        imgBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        imgBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imgBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        imgBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imgBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imgBarrier.image = image;
+        imgBarrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, mipCount, arraySlice, 1};
+        vkCmdPipelineBarrier(copyCmdBuffer.buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr,
+                             1, &imgBarrier);
+
+        vkCmdCopyBufferToImage(copyCmdBuffer.buf, staging.buf, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, uint32_t(regions.size()),
+                               regions.data());
+
+        // Release the image to the graphics queue family in COLOR_ATTACHMENT_OPTIMAL, which the runtime expects it to own
+        // on xrReleaseSwapchainImage (see CopyRGBAImage). The acquire below repeats this barrier on the graphics queue.
         imgBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        imgBarrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT;
+        imgBarrier.dstAccessMask = 0;
         imgBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
         imgBarrier.newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        imgBarrier.srcQueueFamilyIndex = m_transferQueueFamilyIndex;
+        imgBarrier.dstQueueFamilyIndex = m_queueFamilyIndex;
+        vkCmdPipelineBarrier(copyCmdBuffer.buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0,
+                             nullptr, 1, &imgBarrier);
+
+        copyCmdBuffer.End();
+        const uint64_t graphicsValue = m_submissionTracker.LastSubmitted();
+        copyCmdBuffer.Exec(m_transferQueue, graphicsValue != 0 ? m_submissionTracker.Timeline() : VK_NULL_HANDLE,
+                           VK_PIPELINE_STAGE_TRANSFER_BIT, staging.copyDone, graphicsValue);
+
+        // Only the acquire is ordered with rendering on the graphics queue, so the copy itself overlaps it.
+        CmdBuffer& acquireCmdBuffer = staging.acquireCmdBuffer;
+        acquireCmdBuffer.Begin();
+        imgBarrier.srcAccessMask = 0;
+        imgBarrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        vkCmdPipelineBarrier(acquireCmdBuffer.buf, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                             VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0, 0, nullptr, 0, nullptr, 1, &imgBarrier);
+        acquireCmdBuffer.End();
+        acquireCmdBuffer.Exec(m_vkQueue, staging.copyDone, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+    }
+
+    std::future<RGBAImage> VulkanGraphicsPlugin::ReadbackSwapchainImage(const XrSwapchainImageBaseHeader* swapchainImageBase,
+                                                                        int64_t /*imageFormat*/, uint32_t arraySlice)
+    {
+        const XrSwapchainImageVulkanKHR* swapchainImageVk = reinterpret_cast<const XrSwapchainImageVulkanKHR*>(swapchainImageBase);
+        const VkExtent2D size = m_swapchainImageContextMap[swapchainImageBase]->size;
+
+        // Each readback gets its own buffer so the results can be read in any order.
+        const VkDeviceSize imageSize = VkDeviceSize(size.width) * size.height * sizeof(RGBA8Color);
+        auto readback = std::make_shared<ReadbackBuffer>(m_vkDevice, &m_memAllocator, m_queueFamilyIndex, &m_submissionTracker, imageSize);
+
+        CmdBuffer& cmdBuffer = readback->cmdBuffer;
+        cmdBuffer.Begin();
+
+        // Switch the source image from COLOR_ATTACHMENT_OPTIMAL -> TRANSFER_SRC_OPTIMAL, after any rendering to it,
+        // and back again afterwards, as the runtime expects on release. See CopyRGBAImage.
+        VkImageMemoryBarrier imgBarrier{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+        imgBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+        imgBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        imgBarrier.oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        imgBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
         imgBarrier.srcQueueFamilyIndex = m_queueFamilyIndex;
         imgBarrier.dstQueueFamilyIndex = m_queueFamilyIndex;
         imgBarrier.image = swapchainImageVk->image;
         imgBarrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, arraySlice, 1};
-        vkCmdPipelineBarrier(m_cmdBuffer.buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0, 0, nullptr,
+        vkCmdPipelineBarrier(cmdBuffer.buf, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imgBarrier);
+
+        // Copy swapchain -> readback buffer
+        VkBufferImageCopy region{};
+        region.bufferOffset = 0;
+        region.bufferRowLength = 0;  // tightly packed
+        region.bufferImageHeight = 0;
+        region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, arraySlice, 1};
+        region.imageOffset = {0, 0, 0};
+        region.imageExtent = {size.width, size.height, 1};
+        vkCmdCopyImageToBuffer(cmdBuffer.buf, swapchainImageVk->image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readback->buf, 1, &region);
+
+        imgBarrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        imgBarrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        imgBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        imgBarrier.newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        vkCmdPipelineBarrier(cmdBuffer.buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0, 0, nullptr,
                              0, nullptr, 1, &imgBarrier);
 
-        m_cmdBuffer.End();
-        m_cmdBuffer.Exec(m_vkQueue);
-        m_cmdBuffer.Wait();
+        cmdBuffer.End();
+        cmdBuffer.Exec(m_vkQueue);
+
+        return std::async(std::launch::deferred, [readback, size] {
+            XRC_CHECK_THROW_MSG(readback->cmdBuffer.Wait(), "Timed out waiting for a swapchain image readback to complete");
 
-        vkDestroyImage(m_vkDevice, stagingImage, nullptr);
-        vkFreeMemory(m_vkDevice, stagingMemory, nullptr);
+            RGBAImage image((int)size.width, (int)size.height);
+            memcpy(image.pixels.data(), readback->mapped, image.pixels.size() * sizeof(RGBA8Color));
+            image.isSrgb = true;
+            return image;
+        });
     }
 
-    void VulkanGraphicsPlugin::SetViewportAndScissor(const VkRect2D& rect)
+    void VulkanGraphicsPlugin::SetViewportAndScissor(VkCommandBuffer buf, const VkRect2D& rect)
     {
         VkViewport viewport{float(rect.offset.x), float(rect.offset.y), float(rect.extent.width), float(rect.extent.height), 0.0f, 1.0f};
-        vkCmdSetViewport(m_cmdBuffer.buf, 0, 1, &viewport);
-        vkCmdSetScissor(m_cmdBuffer.buf, 0, 1, &rect);
+        vkCmdSetViewport(buf, 0, 1, &viewport);
+        vkCmdSetScissor(buf, 0, 1, &rect);
     }
 
     void VulkanGraphicsPlugin::ClearImageSlice(const XrSwapchainImageBaseHeader* colorSwapchainImage, uint32_t imageArrayIndex,
@@ -2740,136 +4482,434 @@ namespace Conformance
         auto swapchainContext = m_swapchainImageContextMap[colorSwapchainImage];
         uint32_t imageIndex = swapchainContext->ImageIndex(colorSwapchainImage);
 
-        m_cmdBuffer.Clear();
-        m_cmdBuffer.Begin();
+        CmdBuffer& cmdBuffer = m_cmdBufferRing.Acquire();
+        cmdBuffer.Begin();
+        const uint32_t timingPair = BeginGpuTiming(cmdBuffer.buf, "ClearImageSlice");
 
         VkRect2D renderArea = {{0, 0}, {swapchainContext->size.width, swapchainContext->size.height}};
-        SetViewportAndScissor(renderArea);
+        SetViewportAndScissor(cmdBuffer.buf, renderArea);
 
         // Ensure depth is in the right layout
-        DepthBuffer& depthBuffer = swapchainContext->slice[imageArrayIndex].depthBuffer;
-        depthBuffer.TransitionLayout(&m_cmdBuffer, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+        swapchainContext->GetDepthBuffer(imageArrayIndex).TransitionLayout(&cmdBuffer, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+        swapchainContext->SetHoldsDepth(imageArrayIndex);
 
         // Bind eye render target
         VkRenderPassBeginInfo renderPassBeginInfo{VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO};
         swapchainContext->BindRenderTarget(imageIndex, imageArrayIndex, renderArea, &renderPassBeginInfo);
 
-        vkCmdBeginRenderPass(m_cmdBuffer.buf, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+        vkCmdBeginRenderPass(cmdBuffer.buf, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
-        swapchainContext->BindPipeline(m_cmdBuffer.buf, imageArrayIndex);
+        swapchainContext->BindPipeline(cmdBuffer.buf, imageArrayIndex);
 
-        // Clear the buffers
-        static XrColor4f darkSlateGrey = {0.184313729f, 0.309803933f, 0.309803933f, 1.0f};
-        static std::array<VkClearValue, 2> clearValues;
-        clearValues[0].color.float32[0] = darkSlateGrey.r;
-        clearValues[0].color.float32[1] = darkSlateGrey.g;
-        clearValues[0].color.float32[2] = darkSlateGrey.b;
-        clearValues[0].color.float32[3] = darkSlateGrey.a;
-        clearValues[1].depthStencil.depth = 1.0f;
-        clearValues[1].depthStencil.stencil = 0;
+        // Clear the buffers, to the same values as the render passes that take the place of this one.
+        const std::array<VkClearValue, 2>& clearValues = SwapchainImageContext::ClearValues();
         std::array<VkClearAttachment, 2> clearAttachments{{
             {VK_IMAGE_ASPECT_COLOR_BIT, 0, clearValues[0]},
             {VK_IMAGE_ASPECT_DEPTH_BIT, 0, clearValues[1]},
         }};
         // imageArrayIndex already included in the VkImageView
         VkClearRect clearRect{renderArea, 0, 1};
-        vkCmdClearAttachments(m_cmdBuffer.buf, 2, &clearAttachments[0], 1, &clearRect);
+        vkCmdClearAttachments(cmdBuffer.buf, 2, &clearAttachments[0], 1, &clearRect);
 
-        vkCmdEndRenderPass(m_cmdBuffer.buf);
+        vkCmdEndRenderPass(cmdBuffer.buf);
 
-        m_cmdBuffer.End();
-        m_cmdBuffer.Exec(m_vkQueue);
-        // XXX Should double-buffer the command buffers, for now just flush
-        m_cmdBuffer.Wait();
+        EndGpuTiming(cmdBuffer.buf, timingPair);
+        cmdBuffer.End();
+        // Left in flight, the ring waits on this buffer's fence when it comes back around.
+        cmdBuffer.Exec(m_vkQueue);
     }
 
     void VulkanGraphicsPlugin::RenderView(const XrCompositionLayerProjectionView& layerView,
-                                          const XrSwapchainImageBaseHeader* colorSwapchainImage, int64_t /*colorSwapchainFormat*/,
+                                          const XrSwapchainImageBaseHeader* colorSwapchainImage, int64_t colorSwapchainFormat,
                                           const std::vector<Cube>& cubes)
     {
-        auto swapchainContext = m_swapchainImageContextMap[colorSwapchainImage];
-        uint32_t imageIndex = swapchainContext->ImageIndex(colorSwapchainImage);
+        XR_TRACE_SCOPE("VulkanGraphicsPlugin::RenderView");
 
-        m_cmdBuffer.Clear();
-        m_cmdBuffer.Begin();
+        RenderViews(&layerView, 1, colorSwapchainImage, colorSwapchainFormat, cubes);
+    }
 
-        CHECKPOINT();
+    void VulkanGraphicsPlugin::RenderViews(const XrCompositionLayerProjectionView* layerViews, uint32_t viewCount,
+                                           const XrSwapchainImageBaseHeader* colorSwapchainImage, int64_t /*colorSwapchainFormat*/,
+                                           const std::vector<Cube>& sceneCubes)
+    {
+        RenderViewsInto(layerViews, viewCount, colorSwapchainImage, nullptr, sceneCubes);
+    }
 
-        const XrRect2Di& r = layerView.subImage.imageRect;
-        VkRect2D renderArea = {{r.offset.x, r.offset.y}, {uint32_t(r.extent.width), uint32_t(r.extent.height)}};
-        SetViewportAndScissor(renderArea);
+    void VulkanGraphicsPlugin::ClearAndRenderViews(const XrCompositionLayerProjectionView* layerViews, uint32_t viewCount,
+                                                   const XrSwapchainImageBaseHeader* colorSwapchainImage, int64_t colorSwapchainFormat,
+                                                   const std::vector<Cube>& sceneCubes)
+    {
+        XR_TRACE_SCOPE("VulkanGraphicsPlugin::ClearAndRenderViews");
 
-        // Just bind the eye render target, ClearImageSlice will have cleared it.
-        VkRenderPassBeginInfo renderPassBeginInfo{VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO};
+        // A render pass only clears its render area, so it can take the place of ClearImageSlice where every view covers
+        // an array slice of its own.
+        auto swapchainContext = m_swapchainImageContextMap[colorSwapchainImage];
+        for (uint32_t i = 0; i < viewCount; ++i) {
+            const XrSwapchainSubImage& subImage = layerViews[i].subImage;
+            const XrRect2Di& r = subImage.imageRect;
+            bool own = swapchainContext->CoversImage({{r.offset.x, r.offset.y}, {uint32_t(r.extent.width), uint32_t(r.extent.height)}});
+            for (uint32_t j = 0; j < i; ++j) {
+                own = own && layerViews[j].subImage.imageArrayIndex != subImage.imageArrayIndex;
+            }
+            if (!own) {
+                IGraphicsPlugin::ClearAndRenderViews(layerViews, viewCount, colorSwapchainImage, colorSwapchainFormat, sceneCubes);
+                return;
+            }
+        }
+        RenderViewsInto(layerViews, viewCount, colorSwapchainImage, nullptr, sceneCubes, nullptr, true);
+    }
 
-        swapchainContext->BindRenderTarget(imageIndex, layerView.subImage.imageArrayIndex, renderArea, &renderPassBeginInfo);
+    bool VulkanGraphicsPlugin::RenderViewWithDepth(const XrCompositionLayerProjectionView& layerView,
+                                                   const XrSwapchainImageBaseHeader* colorSwapchainImage, int64_t /*colorSwapchainFormat*/,
+                                                   const XrSwapchainImageBaseHeader* depthSwapchainImage, int64_t depthSwapchainFormat,
+                                                   const std::vector<Cube>& cubes)
+    {
+        // The render passes and pipelines are made for the plugin's own depth format.
+        if (depthSwapchainFormat != DepthBufferCache::DepthFormat) {
+            return false;
+        }
+        RenderViewsInto(&layerView, 1, colorSwapchainImage, depthSwapchainImage, cubes);
+        return true;
+    }
 
-        vkCmdBeginRenderPass(m_cmdBuffer.buf, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+    bool VulkanGraphicsPlugin::RenderViewWithVisibilityMask(const XrCompositionLayerProjectionView& layerView,
+                                                            const XrSwapchainImageBaseHeader* colorSwapchainImage,
+                                                            int64_t /*colorSwapchainFormat*/, const VisibilityMask& hiddenArea,
+                                                            const std::vector<Cube>& cubes)
+    {
+        XR_TRACE_SCOPE("VulkanGraphicsPlugin::RenderView");
 
-        CHECKPOINT();
+        BuildHiddenAreaVertices(hiddenArea, m_hiddenAreaVertices);
+        RenderViewsInto(&layerView, 1, colorSwapchainImage, nullptr, cubes, &m_hiddenAreaVertices);
+        return true;
+    }
 
-        swapchainContext->BindPipeline(m_cmdBuffer.buf, layerView.subImage.imageArrayIndex);
+    void VulkanGraphicsPlugin::RenderViewsInto(const XrCompositionLayerProjectionView* layerViews, uint32_t viewCount,
+                                               const XrSwapchainImageBaseHeader* colorSwapchainImage,
+                                               const XrSwapchainImageBaseHeader* depthSwapchainImage, const std::vector<Cube>& sceneCubes,
+                                               const std::vector<Geometry::PackedVertex>* hiddenArea, bool clear)
+    {
+        const std::vector<Cube>& cubes = m_syntheticGpuLoad.Apply(layerViews, viewCount, sceneCubes);
 
-        CHECKPOINT();
+        auto swapchainContext = m_swapchainImageContextMap[colorSwapchainImage];
+        uint32_t imageIndex = swapchainContext->ImageIndex(colorSwapchainImage);
 
-        // Bind index and vertex buffers
-        vkCmdBindIndexBuffer(m_cmdBuffer.buf, m_drawBuffer.idxBuf, 0, VK_INDEX_TYPE_UINT16);
+        CmdBuffer& cmdBuffer = m_cmdBufferRing.Acquire();
+        cmdBuffer.Begin();
+        const uint32_t timingPair = BeginGpuTiming(cmdBuffer.buf, "RenderView");
 
         CHECKPOINT();
 
-        VkDeviceSize offset = 0;
-        vkCmdBindVertexBuffers(m_cmdBuffer.buf, 0, 1, &m_drawBuffer.vtxBuf, &offset);
+        // Every view takes its own range of this frame's instance buffer, so all of them can be recorded into one
+        // command buffer. The buffer is only reused once the ring has waited on the command buffer that read it.
+        // A hidden area is drawn as one more instance ahead of each view's cubes, from vertices all the views share.
+        InstanceBuffer& instanceBuffer = m_instanceBuffers[m_cmdBufferRing.CurrentIndex()];
+        const uint32_t hiddenAreaInstances = (hiddenArea != nullptr && !hiddenArea->empty()) ? 1 : 0;
+        const size_t viewInstances = cubes.size() + hiddenAreaInstances;
+        if (viewInstances != 0) {
+            instanceBuffer.Reserve(sizeof(XrMatrix4x4f) * viewInstances * viewCount);
+        }
+        InstanceBuffer& hiddenAreaBuffer = m_hiddenAreaBuffers[m_cmdBufferRing.CurrentIndex()];
+        if (hiddenAreaInstances != 0) {
+            hiddenAreaBuffer.Reserve(sizeof(Geometry::PackedVertex) * hiddenArea->size());
+            memcpy(hiddenAreaBuffer.mapped, hiddenArea->data(), sizeof(Geometry::PackedVertex) * hiddenArea->size());
+        }
+
+        // Framebuffers are created on first use and the projection cache is not thread-safe, so both are taken care of
+        // here even when the views are recorded on the workers.
+        m_viewRenderPasses.assign(viewCount, {VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO});
+        m_viewProjections.resize(viewCount);
+        m_viewClearsDepth.resize(viewCount);
+        m_depthClearedSlices.clear();
+        std::shared_ptr<SwapchainImageContext> depthContext;
+        if (depthSwapchainImage != nullptr) {
+            depthContext = m_swapchainImageContextMap[depthSwapchainImage];
+        }
+        const bool multisample = m_renderSampleCount != VK_SAMPLE_COUNT_1_BIT && !depthContext;
+        for (uint32_t i = 0; i < viewCount; ++i) {
+            const XrCompositionLayerProjectionView& layerView = layerViews[i];
+
+            // Just bind the eye render target, ClearImageSlice will have cleared it unless its render pass is to. A depth
+            // swapchain image is always cleared here, the runtime hands it over in the depth attachment layout, and so are
+            // the multisampled targets, by their render pass.
+            const XrRect2Di& r = layerView.subImage.imageRect;
+            VkRect2D renderArea = {{r.offset.x, r.offset.y}, {uint32_t(r.extent.width), uint32_t(r.extent.height)}};
+            if (multisample) {
+                m_viewClearsDepth[i] = false;
+                swapchainContext->BindMultisampleRenderTarget(imageIndex, layerView.subImage.imageArrayIndex, m_renderSampleCount,
+                                                              renderArea, &m_viewRenderPasses[i]);
+            }
+            else if (depthContext) {
+                m_viewClearsDepth[i] = true;
+                swapchainContext->BindRenderTarget(imageIndex, layerView.subImage.imageArrayIndex, depthContext, depthSwapchainImage,
+                                                   renderArea, &m_viewRenderPasses[i]);
+            }
+            else if (clear) {
+                m_viewClearsDepth[i] = false;
+                swapchainContext->BindClearingRenderTarget(imageIndex, layerView.subImage.imageArrayIndex, renderArea,
+                                                           &m_viewRenderPasses[i]);
+            }
+            else {
+                // Decided in the order the views draw, as the slices share the depth buffer: a slice keeps the depth
+                // of its ClearImageSlice only until a view of another slice draws into it, and once a view of a slice
+                // has cleared its own area, the other views of that slice have to clear theirs too.
+                const uint32_t arraySlice = layerView.subImage.imageArrayIndex;
+                const bool sliceCleared =
+                    std::find(m_depthClearedSlices.begin(), m_depthClearedSlices.end(), arraySlice) != m_depthClearedSlices.end();
+                m_viewClearsDepth[i] = sliceCleared || !swapchainContext->HoldsDepth(arraySlice);
+                if (m_viewClearsDepth[i] && !sliceCleared) {
+                    swapchainContext->SetHoldsDepth(arraySlice);
+                    m_depthClearedSlices.push_back(arraySlice);
+                }
+                swapchainContext->BindRenderTarget(imageIndex, arraySlice, renderArea, &m_viewRenderPasses[i]);
+            }
+
+            // Compute the view-projection transform.
+            // Note all matrixes (including OpenXR's) are column-major, right-handed.
+            const auto& pose = layerView.pose;
+            const XrMatrix4x4f& proj = m_projectionCache.Get(layerView.fov, DepthNearZ, DepthFarZ);
+            XrMatrix4x4f toView;
+            XrVector3f scale{1.f, 1.f, 1.f};
+            XrMatrix4x4f_CreateTranslationRotationScale(&toView, &pose.position, &pose.orientation, &scale);
+            XrMatrix4x4f view;
+            XrMatrix4x4f_InvertRigidBody(&view, &toView);
+            XrMatrix4x4f_Multiply(&m_viewProjections[i], &proj, &view);
+        }
+        for (uint32_t i = 0; i < viewCount && !depthContext; ++i) {
+            const uint32_t arraySlice = layerViews[i].subImage.imageArrayIndex;
+            if (m_viewClearsDepth[i]) {
+                swapchainContext->GetDepthBuffer(arraySlice).TransitionLayout(&cmdBuffer, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+            }
+            else if (clear && !multisample) {
+                swapchainContext->GetDepthBuffer(arraySlice).TransitionLayout(&cmdBuffer, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+                swapchainContext->DiscardDepth(arraySlice);
+            }
+        }
+
+        // Every view takes its own range of the instance buffer, so the views can also be recorded in parallel.
+        auto recordView = [&](VkCommandBuffer buf, uint32_t i) {
+            SetViewportAndScissor(buf, m_viewRenderPasses[i].renderArea);
+            if (m_viewClearsDepth[i]) {
+                VkClearAttachment depthClear{VK_IMAGE_ASPECT_DEPTH_BIT, 0, {}};
+                depthClear.clearValue.depthStencil = {1.0f, 0};
+                VkClearRect clearRect{m_viewRenderPasses[i].renderArea, 0, 1};
+                vkCmdClearAttachments(buf, 1, &depthClear, 1, &clearRect);
+            }
+            swapchainContext->BindPipeline(buf, layerViews[i].subImage.imageArrayIndex, multisample);
 
-        CHECKPOINT();
+            if (viewInstances == 0) {
+                return;
+            }
 
-        // Compute the view-projection transform.
-        // Note all matrixes (including OpenXR's) are column-major, right-handed.
-        const auto& pose = layerView.pose;
-        XrMatrix4x4f proj;
-        XrMatrix4x4f_CreateProjectionFov(&proj, GRAPHICS_VULKAN, layerView.fov, 0.05f, 100.0f);
-        XrMatrix4x4f toView;
-        XrVector3f scale{1.f, 1.f, 1.f};
-        XrMatrix4x4f_CreateTranslationRotationScale(&toView, &pose.position, &pose.orientation, &scale);
-        XrMatrix4x4f view;
-        XrMatrix4x4f_InvertRigidBody(&view, &toView);
-        XrMatrix4x4f vp;
-        XrMatrix4x4f_Multiply(&vp, &proj, &view);
+            // Compute every cube's model-view-projection transform into this view's range of the instance buffer,
+            // after that of the hidden area.
+            const VkDeviceSize instanceOffset = sizeof(XrMatrix4x4f) * viewInstances * i;
+            auto* instances = reinterpret_cast<XrMatrix4x4f*>(instanceBuffer.mapped + instanceOffset);
+            if (hiddenAreaInstances != 0) {
+                const Cube viewCube{layerViews[i].pose, {1, 1, 1}};
+                ComputeMVPs(m_viewProjections[i], &viewCube, 1, instances);
+            }
+            ComputeMVPs(m_viewProjections[i], cubes, instances + hiddenAreaInstances);
+            vkCmdBindVertexBuffers(buf, 1, 1, &instanceBuffer.buf, &instanceOffset);
+
+            // Draw the hidden area first, so that the depth test rejects the cubes behind it before they are shaded.
+            VkDeviceSize offset = 0;
+            if (hiddenAreaInstances != 0) {
+                vkCmdBindVertexBuffers(buf, 0, 1, &hiddenAreaBuffer.buf, &offset);
+                vkCmdDraw(buf, (uint32_t)hiddenArea->size(), 1, 0, 0);
+            }
 
-        // Render each cube
-        for (const Cube& cube : cubes) {
-            // Compute the model-view-projection transform and push it.
-            XrMatrix4x4f model;
-            XrMatrix4x4f_CreateTranslationRotationScale(&model, &cube.Pose.position, &cube.Pose.orientation, &cube.Scale);
-            XrMatrix4x4f mvp;
-            XrMatrix4x4f_Multiply(&mvp, &vp, &model);
-            vkCmdPushConstants(m_cmdBuffer.buf, m_pipelineLayout.layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(mvp.m), &mvp.m[0]);
+            if (!cubes.empty()) {
+                // Bind index and vertex buffers
+                vkCmdBindIndexBuffer(buf, m_drawBuffer.idxBuf, 0, VK_INDEX_TYPE_UINT16);
+                vkCmdBindVertexBuffers(buf, 0, 1, &m_drawBuffer.vtxBuf, &offset);
 
-            CHECKPOINT();
+                // Draw all the cubes at once.
+                const MeshRange& cube = GetSharedMeshes().cube;
+                vkCmdDrawIndexed(buf, cube.indexCount, (uint32_t)cubes.size(), cube.firstIndex, cube.baseVertex, hiddenAreaInstances);
+            }
+        };
 
-            // Draw the cube.
-            vkCmdDrawIndexed(m_cmdBuffer.buf, m_drawBuffer.count.idx, 1, 0, 0, 0);
+        const uint32_t recordThreads = GetGlobalData().options.vulkanRecordThreads;
+        if (recordThreads > 1 && viewCount > 1) {
+            if (!m_viewRecorder.IsRunning()) {
+                m_viewRecorder.Init(m_vkDevice, m_queueFamilyIndex, recordThreads);
+            }
 
-            CHECKPOINT();
+            const std::vector<VkCommandBuffer>& viewBuffers =
+                m_viewRecorder.Record(m_cmdBufferRing.CurrentIndex(), viewCount, [&](uint32_t i, VkCommandBuffer buf) {
+                    VkCommandBufferInheritanceInfo inheritanceInfo{VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO};
+                    inheritanceInfo.renderPass = m_viewRenderPasses[i].renderPass;
+                    inheritanceInfo.subpass = 0;
+                    inheritanceInfo.framebuffer = m_viewRenderPasses[i].framebuffer;
+                    VkCommandBufferBeginInfo beginInfo{VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+                    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+                    beginInfo.pInheritanceInfo = &inheritanceInfo;
+                    XRC_CHECK_THROW_VKCMD(vkBeginCommandBuffer(buf, &beginInfo));
+                    recordView(buf, i);
+                    XRC_CHECK_THROW_VKCMD(vkEndCommandBuffer(buf));
+                });
+
+            for (uint32_t i = 0; i < viewCount; ++i) {
+                vkCmdBeginRenderPass(cmdBuffer.buf, &m_viewRenderPasses[i], VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+                vkCmdExecuteCommands(cmdBuffer.buf, 1, &viewBuffers[i]);
+                vkCmdEndRenderPass(cmdBuffer.buf);
+
+                CHECKPOINT();
+            }
         }
+        else {
+            for (uint32_t i = 0; i < viewCount; ++i) {
+                vkCmdBeginRenderPass(cmdBuffer.buf, &m_viewRenderPasses[i], VK_SUBPASS_CONTENTS_INLINE);
 
-        vkCmdEndRenderPass(m_cmdBuffer.buf);
+                CHECKPOINT();
 
-        CHECKPOINT();
+                recordView(cmdBuffer.buf, i);
+
+                CHECKPOINT();
+
+                vkCmdEndRenderPass(cmdBuffer.buf);
 
-        m_cmdBuffer.End();
-        m_cmdBuffer.Exec(m_vkQueue);
-        // XXX Should double-buffer the command buffers, for now just flush
-        m_cmdBuffer.Wait();
+                CHECKPOINT();
+            }
+        }
+
+        EndGpuTiming(cmdBuffer.buf, timingPair);
+        cmdBuffer.End();
+        // Left in flight, the ring waits on this buffer's fence when it comes back around.
+        cmdBuffer.Exec(m_vkQueue);
 
 #if defined(USE_MIRROR_WINDOW)
-        // Cycle the window's swapchain on the last view rendered
-        if (swapchainContext == &m_swapchainImageContexts.back()) {
-            m_swapchain.Acquire();
-            m_swapchain.Present(m_vkQueue);
+        // Mirror the views rendered into the most recently created swapchain, side by side across the window.
+        if (swapchainContext == m_swapchainImageContexts.back()) {
+            const VkExtent2D windowExtent = m_swapchain.Extent();
+            std::vector<VkImageBlit> regions(viewCount);
+            for (uint32_t i = 0; i < viewCount; ++i) {
+                const XrSwapchainSubImage& subImage = layerViews[i].subImage;
+                const XrRect2Di& r = subImage.imageRect;
+                VkImageBlit& region = regions[i];
+                region.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, uint32_t(subImage.imageArrayIndex), 1};
+                region.srcOffsets[0] = {r.offset.x, r.offset.y, 0};
+                region.srcOffsets[1] = {r.offset.x + r.extent.width, r.offset.y + r.extent.height, 1};
+                region.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+                region.dstOffsets[0] = {int32_t(windowExtent.width * i / viewCount), 0, 0};
+                region.dstOffsets[1] = {int32_t(windowExtent.width * (i + 1) / viewCount), int32_t(windowExtent.height), 1};
+            }
+            m_swapchain.Present(m_vkQueue, swapchainContext->swapchainImages[imageIndex].image, regions.data(), viewCount);
         }
 #endif
     }
 
+    bool VulkanGraphicsPlugin::SetRenderSampleCount(uint32_t sampleCount)
+    {
+        if (sampleCount != 1) {
+            if (m_vkDevice == VK_NULL_HANDLE || (sampleCount & (sampleCount - 1)) != 0) {
+                return false;
+            }
+            VkPhysicalDeviceProperties properties{};
+            vkGetPhysicalDeviceProperties(m_vkPhysicalDevice, &properties);
+            const VkSampleCountFlags supported =
+                properties.limits.framebufferColorSampleCounts & properties.limits.framebufferDepthSampleCounts;
+            if ((supported & sampleCount) == 0) {
+                return false;
+            }
+        }
+
+        if (sampleCount != (uint32_t)m_renderSampleCount) {
+            // The array slices remake their multisampled targets on next use, so none may still be in flight.
+            Flush();
+            m_renderSampleCount = (VkSampleCountFlagBits)sampleCount;
+        }
+        return true;
+    }
+
+    bool VulkanGraphicsPlugin::SetGpuTimingEnabled(bool enabled)
+    {
+        if (!enabled) {
+            m_gpuTimingEnabled = false;
+            return true;
+        }
+        if (m_vkDevice == VK_NULL_HANDLE || m_timestampValidBits == 0) {
+            return false;
+        }
+
+        if (m_timestampPool == VK_NULL_HANDLE) {
+            VkQueryPoolCreateInfo queryPoolInfo{VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+            queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+            queryPoolInfo.queryCount = TimestampPairCount * 2;
+            XRC_CHECK_THROW_VKCMD(vkCreateQueryPool(m_vkDevice, &queryPoolInfo, nullptr, &m_timestampPool));
+            m_timestampRing.Reset(TimestampPairCount);
+        }
+        m_gpuTimingEnabled = true;
+        return true;
+    }
+
+    uint32_t VulkanGraphicsPlugin::BeginGpuTiming(VkCommandBuffer buf, const char* scope)
+    {
+        if (!m_gpuTimingEnabled) {
+            return GpuTimestampRing::NoPair;
+        }
+        const uint32_t pair = m_timestampRing.Begin(scope);
+        if (pair != GpuTimestampRing::NoPair) {
+            // The pair's previous results have been read, so it can be reset on the GPU timeline.
+            vkCmdResetQueryPool(buf, m_timestampPool, pair * 2, 2);
+            vkCmdWriteTimestamp(buf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_timestampPool, pair * 2);
+        }
+        return pair;
+    }
+
+    void VulkanGraphicsPlugin::EndGpuTiming(VkCommandBuffer buf, uint32_t pair)
+    {
+        if (pair != GpuTimestampRing::NoPair) {
+            vkCmdWriteTimestamp(buf, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_timestampPool, pair * 2 + 1);
+        }
+    }
+
+    void VulkanGraphicsPlugin::CollectGpuTimings(std::vector<GpuTimingSample>& samples)
+    {
+        if (m_timestampPool == VK_NULL_HANDLE) {
+            return;
+        }
+
+        const uint64_t validMask = m_timestampValidBits >= 64 ? UINT64_MAX : ((uint64_t(1) << m_timestampValidBits) - 1);
+        m_timestampRing.Collect(
+            [&](uint32_t pair, int64_t* nanoseconds) {
+                uint64_t ticks[2] = {};
+                // Without VK_QUERY_RESULT_WAIT_BIT this returns VK_NOT_READY instead of blocking.
+                const VkResult result = vkGetQueryPoolResults(m_vkDevice, m_timestampPool, pair * 2, 2, sizeof(ticks), ticks,
+                                                              sizeof(ticks[0]), VK_QUERY_RESULT_64_BIT);
+                if (result == VK_NOT_READY) {
+                    return GpuTimestampRing::ReadResult::NotReady;
+                }
+                if (result != VK_SUCCESS) {
+                    return GpuTimestampRing::ReadResult::Discarded;
+                }
+                *nanoseconds = int64_t(double((ticks[1] - ticks[0]) & validMask) * m_timestampPeriod);
+                return GpuTimestampRing::ReadResult::Ready;
+            },
+            samples);
+    }
+
+    bool VulkanGraphicsPlugin::GetGpuMemoryUsage(uint64_t* usedBytes) const
+    {
+        if (m_vkDevice == VK_NULL_HANDLE || m_vkGetPhysicalDeviceMemoryProperties2KHR == nullptr) {
+            return false;
+        }
+
+        VkPhysicalDeviceMemoryBudgetPropertiesEXT budget{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT};
+        VkPhysicalDeviceMemoryProperties2KHR memoryProperties{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2_KHR, &budget};
+        m_vkGetPhysicalDeviceMemoryProperties2KHR(m_vkPhysicalDevice, &memoryProperties);
+
+        uint64_t deviceLocalUsage = 0;
+        for (uint32_t i = 0; i < memoryProperties.memoryProperties.memoryHeapCount; ++i) {
+            if ((memoryProperties.memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0) {
+                deviceLocalUsage += budget.heapUsage[i];
+            }
+        }
+        *usedBytes = deviceLocalUsage;
+        return true;
+    }
+
 #if defined(USE_CHECKPOINTS)
     static void ShowCheckpoints()
     {
@@ -0,0 +1,305 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "hand_mesh.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace Conformance
+{
+    namespace
+    {
+        struct BindJoint
+        {
+            XrVector3f position;
+            float radius;
+        };
+
+        // An open right hand, in meters from the wrist, with the thumb towards -X. The left hand mirrors it in X.
+        constexpr BindJoint RightHandBindJoints[HandBoneCount] = {
+            {{0.0f, 0.0f, -0.045f}, 0.0f},          // XR_HAND_JOINT_PALM_EXT
+            {{0.0f, 0.0f, 0.0f}, 0.0f},             // XR_HAND_JOINT_WRIST_EXT
+            {{-0.020f, -0.010f, -0.015f}, 0.012f},  // XR_HAND_JOINT_THUMB_METACARPAL_EXT
+            {{-0.045f, -0.012f, -0.045f}, 0.010f},  // XR_HAND_JOINT_THUMB_PROXIMAL_EXT
+            {{-0.060f, -0.012f, -0.072f}, 0.009f},  // XR_HAND_JOINT_THUMB_DISTAL_EXT
+            {{-0.068f, -0.012f, -0.095f}, 0.008f},  // XR_HAND_JOINT_THUMB_TIP_EXT
+            {{-0.012f, 0.0f, -0.015f}, 0.010f},     // XR_HAND_JOINT_INDEX_METACARPAL_EXT
+            {{-0.025f, 0.0f, -0.090f}, 0.010f},     // XR_HAND_JOINT_INDEX_PROXIMAL_EXT
+            {{-0.027f, 0.0f, -0.130f}, 0.009f},     // XR_HAND_JOINT_INDEX_INTERMEDIATE_EXT
+            {{-0.028f, 0.0f, -0.155f}, 0.008f},     // XR_HAND_JOINT_INDEX_DISTAL_EXT
+            {{-0.029f, 0.0f, -0.175f}, 0.007f},     // XR_HAND_JOINT_INDEX_TIP_EXT
+            {{-0.003f, 0.0f, -0.015f}, 0.010f},     // XR_HAND_JOINT_MIDDLE_METACARPAL_EXT
+            {{-0.005f, 0.0f, -0.095f}, 0.010f},     // XR_HAND_JOINT_MIDDLE_PROXIMAL_EXT
+            {{-0.005f, 0.0f, -0.140f}, 0.009f},     // XR_HAND_JOINT_MIDDLE_INTERMEDIATE_EXT
+            {{-0.005f, 0.0f, -0.168f}, 0.008f},     // XR_HAND_JOINT_MIDDLE_DISTAL_EXT
+            {{-0.005f, 0.0f, -0.190f}, 0.007f},     // XR_HAND_JOINT_MIDDLE_TIP_EXT
+            {{0.007f, 0.0f, -0.015f}, 0.010f},      // XR_HAND_JOINT_RING_METACARPAL_EXT
+            {{0.015f, 0.0f, -0.090f}, 0.010f},      // XR_HAND_JOINT_RING_PROXIMAL_EXT
+            {{0.017f, 0.0f, -0.132f}, 0.009f},      // XR_HAND_JOINT_RING_INTERMEDIATE_EXT
+            {{0.018f, 0.0f, -0.159f}, 0.008f},      // XR_HAND_JOINT_RING_DISTAL_EXT
+            {{0.019f, 0.0f, -0.180f}, 0.007f},      // XR_HAND_JOINT_RING_TIP_EXT
+            {{0.015f, 0.0f, -0.015f}, 0.009f},      // XR_HAND_JOINT_LITTLE_METACARPAL_EXT
+            {{0.034f, 0.0f, -0.080f}, 0.009f},      // XR_HAND_JOINT_LITTLE_PROXIMAL_EXT
+            {{0.038f, 0.0f, -0.112f}, 0.008f},      // XR_HAND_JOINT_LITTLE_INTERMEDIATE_EXT
+            {{0.040f, 0.0f, -0.132f}, 0.007f},      // XR_HAND_JOINT_LITTLE_DISTAL_EXT
+            {{0.042f, 0.0f, -0.150f}, 0.006f},      // XR_HAND_JOINT_LITTLE_TIP_EXT
+        };
+
+        // The first and last joint of the thumb and each finger.
+        constexpr uint32_t FingerChains[][2] = {
+            {XR_HAND_JOINT_THUMB_METACARPAL_EXT, XR_HAND_JOINT_THUMB_TIP_EXT},
+            {XR_HAND_JOINT_INDEX_METACARPAL_EXT, XR_HAND_JOINT_INDEX_TIP_EXT},
+            {XR_HAND_JOINT_MIDDLE_METACARPAL_EXT, XR_HAND_JOINT_MIDDLE_TIP_EXT},
+            {XR_HAND_JOINT_RING_METACARPAL_EXT, XR_HAND_JOINT_RING_TIP_EXT},
+            {XR_HAND_JOINT_LITTLE_METACARPAL_EXT, XR_HAND_JOINT_LITTLE_TIP_EXT},
+        };
+
+        constexpr uint32_t RingSides = 8;
+        constexpr XrVector3f SkinColor{0.87f, 0.66f, 0.53f};
+        constexpr XrVector3f PalmColor{0.78f, 0.58f, 0.46f};
+
+        XrVector3f Add(const XrVector3f& a, const XrVector3f& b)
+        {
+            return {a.x + b.x, a.y + b.y, a.z + b.z};
+        }
+
+        XrVector3f Sub(const XrVector3f& a, const XrVector3f& b)
+        {
+            return {a.x - b.x, a.y - b.y, a.z - b.z};
+        }
+
+        XrVector3f Scale(const XrVector3f& a, float scale)
+        {
+            return {a.x * scale, a.y * scale, a.z * scale};
+        }
+
+        XrVector3f Cross(const XrVector3f& a, const XrVector3f& b)
+        {
+            return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+        }
+
+        XrVector3f Normalize(XrVector3f v)
+        {
+            XrVector3f_Normalize(&v);
+            return v;
+        }
+
+        // A joint's bind pose as axes and a position in hand space.
+        struct JointFrame
+        {
+            XrVector3f x{1, 0, 0};
+            XrVector3f y{0, 1, 0};
+            XrVector3f z{0, 0, 1};
+            XrVector3f position{0, 0, 0};
+            float radius{0};
+        };
+
+        // Every finger joint points its -Z at the next joint and its +Y out of the back of the hand, as the extension
+        // orients them; the tip keeps the orientation of the bone before it. The palm and wrist are not rotated.
+        void ComputeBindFrames(bool mirror, JointFrame (&frames)[HandBoneCount])
+        {
+            for (uint32_t joint = 0; joint < HandBoneCount; ++joint) {
+                const BindJoint& bind = RightHandBindJoints[joint];
+                frames[joint].position = {mirror ? -bind.position.x : bind.position.x, bind.position.y, bind.position.z};
+                frames[joint].radius = bind.radius;
+            }
+            for (const auto& chain : FingerChains) {
+                for (uint32_t joint = chain[0]; joint <= chain[1]; ++joint) {
+                    const uint32_t from = joint < chain[1] ? joint : joint - 1;
+                    JointFrame& frame = frames[joint];
+                    frame.z = Normalize(Sub(frames[from].position, frames[from + 1].position));
+                    frame.x = Normalize(Cross({0, 1, 0}, frame.z));
+                    frame.y = Cross(frame.z, frame.x);
+                }
+            }
+        }
+
+        XrMatrix4x4f FrameMatrix(const JointFrame& frame)
+        {
+            const XrVector3f& x = frame.x;
+            const XrVector3f& y = frame.y;
+            const XrVector3f& z = frame.z;
+            const XrVector3f& p = frame.position;
+            return XrMatrix4x4f{{x.x, x.y, x.z, 0, y.x, y.y, y.z, 0, z.x, z.y, z.z, 0, p.x, p.y, p.z, 1}};
+        }
+
+        class HandMeshBuilder
+        {
+        public:
+            HandMeshBuilder(HandMeshes& meshes, const JointFrame (&frames)[HandBoneCount]) : m_meshes(meshes), m_frames(frames)
+            {
+            }
+
+            void AddFinger(uint32_t first, uint32_t last)
+            {
+                // A ring at each joint, blending the bones on either side of it, and one halfway along each bone, moved by
+                // that bone alone, so that a bent joint keeps its volume. The ends are rigid and capped.
+                const JointFrame& base = m_frames[first];
+                const uint16_t baseApex = AddVertex(Add(base.position, Scale(base.z, base.radius * 0.5f)), SkinColor, first, first, 1);
+                uint16_t previousRing = AddRing(base.position, base, base.radius, first, first, 1);
+                CapRing(previousRing, baseApex, base.position);
+
+                for (uint32_t joint = first + 1; joint <= last; ++joint) {
+                    const JointFrame& from = m_frames[joint - 1];
+                    const JointFrame& to = m_frames[joint];
+                    const XrVector3f middle = Scale(Add(from.position, to.position), 0.5f);
+                    const uint16_t middleRing = AddRing(middle, from, (from.radius + to.radius) * 0.5f, joint - 1, joint - 1, 1);
+                    ConnectRings(previousRing, middleRing, Scale(Add(from.position, middle), 0.5f));
+
+                    const bool tip = joint == last;
+                    const uint16_t jointRing = AddRing(to.position, to, to.radius, joint - 1, joint, tip ? 1.0f : 0.5f);
+                    ConnectRings(middleRing, jointRing, Scale(Add(middle, to.position), 0.5f));
+                    previousRing = jointRing;
+                }
+
+                const JointFrame& tip = m_frames[last];
+                const uint16_t tipApex = AddVertex(Sub(tip.position, Scale(tip.z, tip.radius)), SkinColor, last - 1, last - 1, 1);
+                CapRing(previousRing, tipApex, tip.position);
+            }
+
+            void AddPalm()
+            {
+                // A slab from the wrist to the knuckles, its wrist end moved by the wrist and its knuckle end by the palm.
+                const XrVector3f& index = m_frames[XR_HAND_JOINT_INDEX_PROXIMAL_EXT].position;
+                const XrVector3f& little = m_frames[XR_HAND_JOINT_LITTLE_PROXIMAL_EXT].position;
+                const float xMin = std::min(index.x, little.x) - 0.008f;
+                const float xMax = std::max(index.x, little.x) + 0.008f;
+                const float zKnuckles = (index.z + little.z) * 0.5f;
+                constexpr float halfThickness = 0.012f;
+
+                uint16_t corners[8];
+                for (uint32_t i = 0; i < 8; ++i) {
+                    const bool knuckle = (i & 4) != 0;
+                    const XrVector3f position{(i & 1) != 0 ? xMax : xMin, (i & 2) != 0 ? halfThickness : -halfThickness,
+                                              knuckle ? zKnuckles : 0.0f};
+                    const uint32_t bone = knuckle ? XR_HAND_JOINT_PALM_EXT : XR_HAND_JOINT_WRIST_EXT;
+                    corners[i] = AddVertex(position, PalmColor, bone, bone, 1);
+                }
+
+                const XrVector3f center{(xMin + xMax) * 0.5f, 0, zKnuckles * 0.5f};
+                constexpr uint8_t faces[6][4] = {{0, 2, 6, 4}, {1, 5, 7, 3}, {0, 4, 5, 1}, {2, 3, 7, 6}, {0, 1, 3, 2}, {4, 6, 7, 5}};
+                for (const auto& face : faces) {
+                    AddTriangle(corners[face[0]], corners[face[1]], corners[face[2]], center);
+                    AddTriangle(corners[face[0]], corners[face[2]], corners[face[3]], center);
+                }
+            }
+
+        private:
+            uint16_t AddVertex(const XrVector3f& position, const XrVector3f& color, uint32_t bone0, uint32_t bone1, float weight0)
+            {
+                m_meshes.vertices.push_back({position, color, {(float)bone0, (float)bone1}, {weight0, 1 - weight0}});
+                return (uint16_t)(m_meshes.vertices.size() - 1);
+            }
+
+            // RingSides vertices around center in the plane of the frame's X and Y, lit from the back of the hand.
+            uint16_t AddRing(const XrVector3f& center, const JointFrame& frame, float radius, uint32_t bone0, uint32_t bone1,
+                             float weight0)
+            {
+                const auto first = (uint16_t)m_meshes.vertices.size();
+                for (uint32_t side = 0; side < RingSides; ++side) {
+                    const float angle = 6.2831853f * side / RingSides;
+                    const XrVector3f offset = Add(Scale(frame.x, radius * std::cos(angle)), Scale(frame.y, radius * std::sin(angle)));
+                    const float shade = 0.75f + 0.25f * std::sin(angle);
+                    AddVertex(Add(center, offset), Scale(SkinColor, shade), bone0, bone1, weight0);
+                }
+                return first;
+            }
+
+            void ConnectRings(uint16_t from, uint16_t to, const XrVector3f& inside)
+            {
+                for (uint16_t side = 0; side < RingSides; ++side) {
+                    const auto next = (uint16_t)((side + 1) % RingSides);
+                    AddTriangle(from + side, from + next, to + next, inside);
+                    AddTriangle(from + side, to + next, to + side, inside);
+                }
+            }
+
+            void CapRing(uint16_t ring, uint16_t apex, const XrVector3f& inside)
+            {
+                for (uint16_t side = 0; side < RingSides; ++side) {
+                    AddTriangle(ring + side, (uint16_t)(ring + (side + 1) % RingSides), apex, inside);
+                }
+            }
+
+            // Winds the triangle clockwise as seen from outside, away from inside: like the cube faces, its
+            // cross(b - a, c - a) then points into the mesh.
+            void AddTriangle(uint16_t a, uint16_t b, uint16_t c, const XrVector3f& inside)
+            {
+                const XrVector3f& pa = m_meshes.vertices[a].Position;
+                const XrVector3f& pb = m_meshes.vertices[b].Position;
+                const XrVector3f& pc = m_meshes.vertices[c].Position;
+                const XrVector3f normal = Cross(Sub(pb, pa), Sub(pc, pa));
+                const XrVector3f outward = Sub(Scale(Add(Add(pa, pb), pc), 1.0f / 3), inside);
+                if (XrVector3f_Dot(&normal, &outward) > 0) {
+                    std::swap(b, c);
+                }
+                m_meshes.indices.insert(m_meshes.indices.end(), {a, b, c});
+            }
+
+            HandMeshes& m_meshes;
+            const JointFrame (&m_frames)[HandBoneCount];
+        };
+    }  // namespace
+
+    const HandMeshes& GetHandMeshes()
+    {
+        static const HandMeshes meshes = [] {
+            HandMeshes result;
+            for (uint32_t handIndex = 0; handIndex < 2; ++handIndex) {
+                // The left hand comes first, as in XrHandEXT.
+                JointFrame frames[HandBoneCount];
+                ComputeBindFrames(handIndex == 0, frames);
+                for (uint32_t joint = 0; joint < HandBoneCount; ++joint) {
+                    const XrMatrix4x4f bindPose = FrameMatrix(frames[joint]);
+                    XrMatrix4x4f_InvertRigidBody(&result.inverseBindPoses[handIndex][joint], &bindPose);
+                }
+
+                MeshRange& range = result.hands[handIndex];
+                range.firstIndex = (uint32_t)result.indices.size();
+                HandMeshBuilder builder(result, frames);
+                builder.AddPalm();
+                for (const auto& chain : FingerChains) {
+                    builder.AddFinger(chain[0], chain[1]);
+                }
+                range.indexCount = (uint32_t)result.indices.size() - range.firstIndex;
+            }
+            return result;
+        }();
+        return meshes;
+    }
+
+    bool ComputeHandBonePalette(XrHandEXT hand, const XrHandJointLocationEXT* joints, SkinnedHand& out)
+    {
+        constexpr XrSpaceLocationFlags validFlags = XR_SPACE_LOCATION_POSITION_VALID_BIT | XR_SPACE_LOCATION_ORIENTATION_VALID_BIT;
+        for (uint32_t joint = 0; joint < HandBoneCount; ++joint) {
+            if ((joints[joint].locationFlags & validFlags) != validFlags) {
+                return false;
+            }
+        }
+
+        const auto& inverseBindPoses = GetHandMeshes().inverseBindPoses[HandMeshes::HandIndex(hand)];
+        const XrVector3f scale{1, 1, 1};
+        for (uint32_t joint = 0; joint < HandBoneCount; ++joint) {
+            const XrPosef& pose = joints[joint].pose;
+            XrMatrix4x4f jointPose;
+            XrMatrix4x4f_CreateTranslationRotationScale(&jointPose, &pose.position, &pose.orientation, &scale);
+            XrMatrix4x4f_Multiply(&out.bonePalette[joint], &jointPose, &inverseBindPoses[joint]);
+        }
+        out.hand = hand;
+        return true;
+    }
+}  // namespace Conformance
@@ -0,0 +1,89 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "mesh_buffer.h"
+#include <openxr/openxr.h>
+#include <common/xr_linear.h>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace Conformance
+{
+    /// The bones of a hand mesh, one per joint of XR_HAND_JOINT_SET_DEFAULT_EXT, in XrHandJointEXT order.
+    constexpr uint32_t HandBoneCount = XR_HAND_JOINT_COUNT_EXT;
+
+    /// A vertex of a skinned mesh: its position and colour in bind space, and the two bones that move it with their
+    /// weights, which sum to one. The bone indices are floats so that every graphics API reads them as plain attributes.
+    struct SkinnedVertex
+    {
+        XrVector3f Position;
+        XrVector3f Color;
+        float Bones[2];
+        float Weights[2];
+    };
+
+    /// Meshes of both hands, skinned to the hand tracking joints: a tube along the bones of each finger and the thumb,
+    /// and a slab for the palm, held open and flat with the fingers along -Z and the back of the hand towards +Y, as
+    /// OpenXR orients the joints. Both are in one vertex and one index array; the indices are into the whole vertex
+    /// array, so the baseVertex of each range is zero. Triangles are wound clockwise, like the cube faces.
+    struct HandMeshes
+    {
+        std::vector<SkinnedVertex> vertices;
+        std::vector<uint16_t> indices;
+        // Both indexed by HandIndex: the left hand first, as in XrHandEXT.
+        MeshRange hands[2];
+        // The inverse of each joint's bind pose, taking hand space to the joint's space.
+        std::array<XrMatrix4x4f, HandBoneCount> inverseBindPoses[2];
+
+        static size_t HandIndex(XrHandEXT hand)
+        {
+            return hand == XR_HAND_RIGHT_EXT ? 1 : 0;
+        }
+
+        const MeshRange& Range(XrHandEXT hand) const
+        {
+            return hands[HandIndex(hand)];
+        }
+
+        size_t VertexBytes() const
+        {
+            return vertices.size() * sizeof(SkinnedVertex);
+        }
+
+        size_t IndexBytes() const
+        {
+            return indices.size() * sizeof(uint16_t);
+        }
+    };
+
+    /// Builds the hand meshes once per process, so the plugins share one CPU copy.
+    const HandMeshes& GetHandMeshes();
+
+    /// A hand to draw with IGraphicsPlugin::RenderViewWithSkinnedHands: which mesh, and its bone palette, the matrix
+    /// taking each bone from bind space to the base space of the views.
+    struct SkinnedHand
+    {
+        XrHandEXT hand{XR_HAND_LEFT_EXT};
+        std::array<XrMatrix4x4f, HandBoneCount> bonePalette;
+    };
+
+    /// Fills the bone palette of out from the joints xrLocateHandJointsEXT returned for hand, each the joint's pose
+    /// times its inverse bind pose. Returns false, leaving out unchanged, if any joint's pose is not valid.
+    bool ComputeHandBonePalette(XrHandEXT hand, const XrHandJointLocationEXT* joints, SkinnedHand& out);
+}  // namespace Conformance
@@ -15,8 +15,11 @@
 // limitations under the License.
 
 #include <chrono>
+#include <functional>
 #include <thread>
 #include <array>
+#include <mutex>
+#include <unordered_map>
 
 #include <openxr/openxr.h>
 
@@ -24,7 +27,6 @@
 #include "conformance_framework.h"
 #include "conformance_utils.h"
 
-#include "two_call.h"
 
 using namespace std::chrono_literals;
 
@@ -48,20 +50,330 @@ const std::chrono::nanoseconds instructionDelay = 250ms;
 
 namespace Conformance
 {
-    class HumanDrivenInputdevice : public IInputTestDevice
+    // clang-format off
+
+    const InteractionProfileWhitelistData cSimpleControllerIPData{
+        {"/user/hand/left/input/select/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/left/input/menu/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/left/input/grip/pose", XR_ACTION_TYPE_POSE_INPUT},
+        {"/user/hand/left/input/aim/pose", XR_ACTION_TYPE_POSE_INPUT},
+        {"/user/hand/left/output/haptic", XR_ACTION_TYPE_VIBRATION_OUTPUT},
+        {"/user/hand/right/input/select/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/right/input/menu/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/right/input/grip/pose", XR_ACTION_TYPE_POSE_INPUT},
+        {"/user/hand/right/input/aim/pose", XR_ACTION_TYPE_POSE_INPUT},
+        {"/user/hand/right/output/haptic", XR_ACTION_TYPE_VIBRATION_OUTPUT},
+    };
+
+    const InteractionProfileWhitelistData cGoogleDaydreamControllerIPData{
+        {"/user/hand/left/input/select/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/left/input/trackpad/x", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/hand/left/input/trackpad/y", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/hand/left/input/trackpad/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/left/input/trackpad/touch", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/left/input/trackpad", XR_ACTION_TYPE_VECTOR2F_INPUT},
+        {"/user/hand/left/input/grip/pose", XR_ACTION_TYPE_POSE_INPUT},
+        {"/user/hand/left/input/aim/pose", XR_ACTION_TYPE_POSE_INPUT},
+        {"/user/hand/right/input/select/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/right/input/trackpad/x", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/hand/right/input/trackpad/y", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/hand/right/input/trackpad/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/right/input/trackpad/touch", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/right/input/trackpad", XR_ACTION_TYPE_VECTOR2F_INPUT},
+        {"/user/hand/right/input/grip/pose", XR_ACTION_TYPE_POSE_INPUT},
+        {"/user/hand/right/input/aim/pose", XR_ACTION_TYPE_POSE_INPUT},
+    };
+
+    const InteractionProfileWhitelistData cViveControllerIPData{
+        {"/user/hand/left/input/menu/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/left/input/squeeze/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/left/input/trigger/value", XR_ACTION_TYPE_FLOAT_INPUT},
+        // TODO should we include this? value should coerce to click on conformant systems
+        {"/user/hand/left/input/trigger/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/left/input/trackpad/x", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/hand/left/input/trackpad/y", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/hand/left/input/trackpad/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/left/input/trackpad/touch", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/left/input/trackpad", XR_ACTION_TYPE_VECTOR2F_INPUT},
+        {"/user/hand/left/input/grip/pose", XR_ACTION_TYPE_POSE_INPUT},
+        {"/user/hand/left/input/aim/pose", XR_ACTION_TYPE_POSE_INPUT},
+        {"/user/hand/left/output/haptic", XR_ACTION_TYPE_VIBRATION_OUTPUT},
+        {"/user/hand/right/input/menu/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/right/input/squeeze/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/right/input/trigger/value", XR_ACTION_TYPE_FLOAT_INPUT},
+        // TODO should we include this? value should coerce to click on conformant systems
+        {"/user/hand/right/input/trigger/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/right/input/trackpad/x", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/hand/right/input/trackpad/y", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/hand/right/input/trackpad/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/right/input/trackpad/touch", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/right/input/trackpad", XR_ACTION_TYPE_VECTOR2F_INPUT},
+        {"/user/hand/right/input/grip/pose", XR_ACTION_TYPE_POSE_INPUT},
+        {"/user/hand/right/input/aim/pose", XR_ACTION_TYPE_POSE_INPUT},
+        {"/user/hand/right/output/haptic", XR_ACTION_TYPE_VIBRATION_OUTPUT},
+    };
+
+    const InteractionProfileWhitelistData cViveProIPData{
+        {"/user/head/input/volume_up/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/head/input/volume_down/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/head/input/mute_mic/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+    };
+
+    const InteractionProfileWhitelistData cWMRControllerIPData{
+        {"/user/hand/left/input/menu/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/left/input/squeeze/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/left/input/trigger/value", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/hand/left/input/thumbstick/x", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/hand/left/input/thumbstick/y", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/hand/left/input/thumbstick/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        // TODO should we include these or just infer them from /x and /y?
+        {"/user/hand/left/input/thumbstick", XR_ACTION_TYPE_VECTOR2F_INPUT},
+        {"/user/hand/left/input/trackpad/x", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/hand/left/input/trackpad/y", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/hand/left/input/trackpad", XR_ACTION_TYPE_VECTOR2F_INPUT},
+        {"/user/hand/left/input/trackpad/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/left/input/trackpad/touch", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/left/input/grip/pose", XR_ACTION_TYPE_POSE_INPUT},
+        {"/user/hand/left/input/aim/pose", XR_ACTION_TYPE_POSE_INPUT},
+        {"/user/hand/left/output/haptic", XR_ACTION_TYPE_VIBRATION_OUTPUT},
+        {"/user/hand/right/input/menu/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/right/input/squeeze/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/right/input/trigger/value", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/hand/right/input/thumbstick/x", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/hand/right/input/thumbstick/y", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/hand/right/input/thumbstick/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/right/input/thumbstick", XR_ACTION_TYPE_VECTOR2F_INPUT},
+        {"/user/hand/right/input/trackpad/x", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/hand/right/input/trackpad/y", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/hand/right/input/trackpad", XR_ACTION_TYPE_VECTOR2F_INPUT},
+        {"/user/hand/right/input/trackpad/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/right/input/trackpad/touch", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/right/input/grip/pose", XR_ACTION_TYPE_POSE_INPUT},
+        {"/user/hand/right/input/aim/pose", XR_ACTION_TYPE_POSE_INPUT},
+        {"/user/hand/right/output/haptic", XR_ACTION_TYPE_VIBRATION_OUTPUT},
+    };
+
+    const InteractionProfileWhitelistData cGamepadIPData{
+        {"/user/gamepad/input/menu/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/gamepad/input/view/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/gamepad/input/a/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/gamepad/input/b/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/gamepad/input/x/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/gamepad/input/y/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/gamepad/input/dpad_down/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/gamepad/input/dpad_right/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/gamepad/input/dpad_up/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/gamepad/input/dpad_left/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/gamepad/input/shoulder_left/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/gamepad/input/shoulder_right/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/gamepad/input/thumbstick_left/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/gamepad/input/thumbstick_right/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/gamepad/input/trigger_left/value", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/gamepad/input/trigger_right/value", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/gamepad/input/thumbstick_left/x", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/gamepad/input/thumbstick_left/y", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/gamepad/input/thumbstick_left", XR_ACTION_TYPE_VECTOR2F_INPUT},
+        {"/user/gamepad/input/thumbstick_right/x", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/gamepad/input/thumbstick_right/y", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/gamepad/input/thumbstick_right", XR_ACTION_TYPE_VECTOR2F_INPUT},
+        {"/user/gamepad/output/haptic_left", XR_ACTION_TYPE_VIBRATION_OUTPUT},
+        {"/user/gamepad/output/haptic_right", XR_ACTION_TYPE_VIBRATION_OUTPUT},
+        {"/user/gamepad/output/haptic_left_trigger", XR_ACTION_TYPE_VIBRATION_OUTPUT},
+        {"/user/gamepad/output/haptic_right_trigger", XR_ACTION_TYPE_VIBRATION_OUTPUT},
+    };
+
+    const InteractionProfileWhitelistData cOculusGoIPData{
+        {"/user/hand/left/input/trigger/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/left/input/back/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/left/input/trackpad/x", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/hand/left/input/trackpad/y", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/hand/left/input/trackpad", XR_ACTION_TYPE_VECTOR2F_INPUT},
+        {"/user/hand/left/input/trackpad/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/left/input/trackpad/touch", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/left/input/grip/pose", XR_ACTION_TYPE_POSE_INPUT},
+        {"/user/hand/left/input/aim/pose", XR_ACTION_TYPE_POSE_INPUT},
+        {"/user/hand/right/input/trigger/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/right/input/back/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/right/input/trackpad/x", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/hand/right/input/trackpad/y", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/hand/right/input/trackpad", XR_ACTION_TYPE_VECTOR2F_INPUT},
+        {"/user/hand/right/input/trackpad/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/right/input/trackpad/touch", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/right/input/grip/pose", XR_ACTION_TYPE_POSE_INPUT},
+        {"/user/hand/right/input/aim/pose", XR_ACTION_TYPE_POSE_INPUT},
+    };
+
+    const InteractionProfileWhitelistData cOculusTouchIPData{
+        {"/user/hand/left/input/x/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/left/input/x/touch", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/left/input/y/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/left/input/y/touch", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/left/input/menu/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/left/input/squeeze/value", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/hand/left/input/trigger/value", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/hand/left/input/trigger/touch", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/left/input/thumbstick/x", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/hand/left/input/thumbstick/y", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/hand/left/input/thumbstick/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/left/input/thumbstick/touch", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/left/input/thumbstick", XR_ACTION_TYPE_VECTOR2F_INPUT},
+        // Rift S and Quest controllers lack thumbrests
+        // {"/user/hand/left/input/thumbrest/touch", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/left/input/grip/pose", XR_ACTION_TYPE_POSE_INPUT},
+        {"/user/hand/left/input/aim/pose", XR_ACTION_TYPE_POSE_INPUT},
+        {"/user/hand/left/output/haptic", XR_ACTION_TYPE_VIBRATION_OUTPUT},
+        {"/user/hand/right/input/a/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/right/input/a/touch", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/right/input/b/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/right/input/b/touch", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        // The system ("Oculus") button is reserved for system applications
+        // {"/user/hand/right/input/system/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/right/input/squeeze/value", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/hand/right/input/trigger/value", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/hand/right/input/trigger/touch", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/right/input/thumbstick/x", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/hand/right/input/thumbstick/y", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/hand/right/input/thumbstick/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/right/input/thumbstick/touch", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/right/input/thumbstick", XR_ACTION_TYPE_VECTOR2F_INPUT},
+        // Rift S and Quest controllers lack thumbrests
+        // {"/user/hand/right/input/thumbrest/touch", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/right/input/grip/pose", XR_ACTION_TYPE_POSE_INPUT},
+        {"/user/hand/right/input/aim/pose", XR_ACTION_TYPE_POSE_INPUT},
+        {"/user/hand/right/output/haptic", XR_ACTION_TYPE_VIBRATION_OUTPUT},
+    };
+
+    const InteractionProfileWhitelistData cValveIndexIPData{
+        {"/user/hand/left/input/a/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/left/input/a/touch", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/left/input/b/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/left/input/b/touch", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/left/input/squeeze/value", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/hand/left/input/squeeze/force", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/hand/left/input/trigger/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/left/input/trigger/value", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/hand/left/input/trigger/touch", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/left/input/thumbstick/x", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/hand/left/input/thumbstick/y", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/hand/left/input/thumbstick/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/left/input/thumbstick/touch", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/left/input/thumbstick", XR_ACTION_TYPE_VECTOR2F_INPUT},
+        {"/user/hand/left/input/trackpad/x", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/hand/left/input/trackpad/y", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/hand/left/input/trackpad/force", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/hand/left/input/trackpad/touch", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/left/input/trackpad", XR_ACTION_TYPE_VECTOR2F_INPUT},
+        {"/user/hand/left/input/grip/pose", XR_ACTION_TYPE_POSE_INPUT},
+        {"/user/hand/left/input/aim/pose", XR_ACTION_TYPE_POSE_INPUT},
+        {"/user/hand/left/output/haptic", XR_ACTION_TYPE_VIBRATION_OUTPUT},
+        {"/user/hand/right/input/a/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/right/input/a/touch", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/right/input/b/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/right/input/b/touch", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/right/input/squeeze/value", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/hand/right/input/squeeze/force", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/hand/right/input/trigger/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/right/input/trigger/value", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/hand/right/input/trigger/touch", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/right/input/thumbstick/x", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/hand/right/input/thumbstick/y", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/hand/right/input/thumbstick/click", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/right/input/thumbstick/touch", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/right/input/thumbstick", XR_ACTION_TYPE_VECTOR2F_INPUT},
+        {"/user/hand/right/input/trackpad/x", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/hand/right/input/trackpad/y", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/hand/right/input/trackpad/force", XR_ACTION_TYPE_FLOAT_INPUT},
+        {"/user/hand/right/input/trackpad/touch", XR_ACTION_TYPE_BOOLEAN_INPUT},
+        {"/user/hand/right/input/trackpad", XR_ACTION_TYPE_VECTOR2F_INPUT},
+        {"/user/hand/right/input/grip/pose", XR_ACTION_TYPE_POSE_INPUT},
+        {"/user/hand/right/input/aim/pose", XR_ACTION_TYPE_POSE_INPUT},
+        {"/user/hand/right/output/haptic", XR_ACTION_TYPE_VIBRATION_OUTPUT},
+    };
+
+    // clang-format on
+
+    const InteractionProfileMetadata cSimpleKHRInteractionProfileDefinition{
+        "/interaction_profiles/khr/simple_controller",
+        // The prefix has been removed from these as Catch2 cannot handle args that begin with a forward slash and it cannot be escaped
+        "khr/simple_controller",
+        {"/user/hand/left", "/user/hand/right"},
+        cSimpleControllerIPData};
+
+    const InteractionProfileMetadata cInteractionProfileDefinitions[cInteractionProfileDefinitionCount] = {
+        cSimpleKHRInteractionProfileDefinition,
+        {"/interaction_profiles/google/daydream_controller",
+         "google/daydream_controller",
+         {"/user/hand/left", "/user/hand/right"},
+         cGoogleDaydreamControllerIPData},
+        {"/interaction_profiles/htc/vive_controller",
+         "htc/vive_controller",
+         {"/user/hand/left", "/user/hand/right"},
+         cViveControllerIPData},
+        {"/interaction_profiles/htc/vive_pro", "htc/vive_pro", {"/user/head"}, cViveProIPData},
+        {"/interaction_profiles/microsoft/motion_controller",
+         "microsoft/motion_controller",
+         {"/user/hand/left", "/user/hand/right"},
+         cWMRControllerIPData},
+        {"/interaction_profiles/microsoft/xbox_controller", "microsoft/xbox_controller", {"/user/gamepad"}, cGamepadIPData},
+        {"/interaction_profiles/oculus/go_controller", "oculus/go_controller", {"/user/hand/left", "/user/hand/right"}, cOculusGoIPData},
+        {"/interaction_profiles/oculus/touch_controller",
+         "oculus/touch_controller",
+         {"/user/hand/left", "/user/hand/right"},
+         cOculusTouchIPData},
+        {"/interaction_profiles/valve/index_controller",
+         "valve/index_controller",
+         {"/user/hand/left", "/user/hand/right"},
+         cValveIndexIPData}};
+
+    namespace
+    {
+        std::shared_ptr<const InteractionProfilePaths> ConvertInteractionProfilePaths(XrInstance instance,
+                                                                                      const InteractionProfileMetadata& ipMetadata)
+        {
+            auto paths = std::make_shared<InteractionProfilePaths>();
+            paths->InteractionProfile = StringToPath(instance, ipMetadata.InteractionProfilePathString.c_str());
+            paths->TopLevelPaths.reserve(ipMetadata.TopLevelPaths.size());
+            for (const std::string& topLevelPath : ipMetadata.TopLevelPaths) {
+                paths->TopLevelPaths.push_back(StringToPath(instance, topLevelPath.c_str()));
+            }
+            paths->InputSourcePaths.reserve(ipMetadata.WhitelistData.size());
+            for (const InputSourcePathData& inputSourceData : ipMetadata.WhitelistData) {
+                paths->InputSourcePaths.push_back(StringToPath(instance, inputSourceData.Path.c_str()));
+            }
+            return paths;
+        }
+    }  // namespace
+
+    std::shared_ptr<const InteractionProfilePaths> GetInteractionProfilePaths(XrInstance instance,
+                                                                              const InteractionProfileMetadata& ipMetadata)
+    {
+        const uint64_t generation = GetPathCacheGeneration(instance);
+        if (generation == 0) {
+            return ConvertInteractionProfilePaths(instance, ipMetadata);
+        }
+
+        std::shared_ptr<const void> paths = FindPathCacheTable(instance, &ipMetadata);
+        if (!paths) {
+            // Converted outside the path cache lock, as CachedStringToPath does, and the first table stored wins.
+            paths = StorePathCacheTable(instance, generation, &ipMetadata, ConvertInteractionProfilePaths(instance, ipMetadata));
+        }
+        return std::static_pointer_cast<const InteractionProfilePaths>(paths);
+    }
+
+    // Creates an action for every input of the device's top level path in the interaction profile, through which the
+    // test devices see the input state that the runtime reports.
+    class InputTestDeviceBase : public IInputTestDevice
     {
     public:
-        HumanDrivenInputdevice(ITestMessageDisplay* const messageDisplay, InteractionManager* const interactionManager, XrInstance instance,
-                               XrSession session, XrPath interactionProfile, XrPath topLevelPath,
-                               InteractionProfileWhitelistData interactionProfilePaths)
+        InputTestDeviceBase(ITestMessageDisplay* const messageDisplay, InteractionManager* const interactionManager, XrInstance instance,
+                            XrSession session, XrPath interactionProfile, XrPath topLevelPath,
+                            InteractionProfileWhitelistData interactionProfilePaths)
             : m_messageDisplay(messageDisplay)
             , m_instance(instance)
             , m_session(session)
             , m_interactionProfile(interactionProfile)
             , m_topLevelPath(topLevelPath)
-            , m_conformanceAutomationExtensionEnabled(GetGlobalData().IsInstanceExtensionEnabled("XR_EXT_conformance_automation"))
         {
-
             std::string actionSetName = "test_device_action_set_" + std::to_string(m_topLevelPath);
             std::string localizedActionSetName = "Test Device Action Set " + std::to_string(m_topLevelPath);
 
@@ -77,7 +389,8 @@ namespace Conformance
                                                             "test device action " + std::to_string(i)};
             };
 
-            std::string topLevelPathString = std::string(CHECK_TWO_CALL(char, {}, xrPathToString, m_instance, m_topLevelPath).data());
+            std::string topLevelPathString;
+            CHECK_RESULT_SUCCEEDED(CachedPathToString(m_instance, m_topLevelPath, &topLevelPathString));
             auto PrefixedByTopLevelPath = [&topLevelPathString](std::string binding) {
                 return (binding.length() > topLevelPathString.size()) &&
                        (std::mismatch(topLevelPathString.begin(), topLevelPathString.end(), binding.begin()).first ==
@@ -110,7 +423,7 @@ namespace Conformance
             interactionManager->AddActionSet(m_actionSet);
         }
 
-        ~HumanDrivenInputdevice()
+        ~InputTestDeviceBase()
         {
             for (const auto& pair : m_actionMap) {
                 REQUIRE_RESULT(xrDestroyAction(pair.second), XR_SUCCESS);
@@ -123,61 +436,109 @@ namespace Conformance
             return m_topLevelPath;
         }
 
-        void SetDeviceActive(bool state, bool skipInteraction = false) override
+    protected:
+        enum class ControllerState
         {
-            if (m_conformanceAutomationExtensionEnabled) {
-                PFN_xrSetInputDeviceActiveEXT xrSetInputDeviceActiveEXT{nullptr};
-                REQUIRE_RESULT(
-                    xrGetInstanceProcAddr(m_instance, "xrSetInputDeviceActiveEXT", (PFN_xrVoidFunction*)&xrSetInputDeviceActiveEXT),
-                    XR_SUCCESS);
-                REQUIRE_RESULT(xrSetInputDeviceActiveEXT(m_session, m_interactionProfile, m_topLevelPath, (XrBool32)state), XR_SUCCESS);
+            NotFocused,
+            Active,
+            Inactive
+        };
+
+        ControllerState GetControllerState()
+        {
+            if (!SyncActions(XR_NULL_HANDLE)) {
+                return ControllerState::NotFocused;
             }
 
-            if (skipInteraction) {
-                // Skip human interaction, this is just a hint to the runtime via the extension
-                return;
+            XrActionStateBoolean booleanActionData{XR_TYPE_ACTION_STATE_BOOLEAN};
+            XrActionStateGetInfo getInfo{XR_TYPE_ACTION_STATE_GET_INFO};
+            getInfo.action = m_firstBooleanAction;
+            REQUIRE_RESULT(xrGetActionStateBoolean(m_session, &getInfo, &booleanActionData), XR_SUCCESS);
+
+            return booleanActionData.isActive ? ControllerState::Active : ControllerState::Inactive;
+        }
+
+        // Syncs the device's action set, and extraActionSet if it is not null. Returns false while the session is not
+        // focused, when the action states are not to be read.
+        bool SyncActions(XrActionSet extraActionSet)
+        {
+            XrActiveActionSet activeActionSet[] = {{m_actionSet}, {extraActionSet}};
+            XrActionsSyncInfo syncInfo{XR_TYPE_ACTIONS_SYNC_INFO};
+            syncInfo.countActiveActionSets = extraActionSet == XR_NULL_HANDLE ? 1 : 2;
+            syncInfo.activeActionSets = activeActionSet;
+            const XrResult syncRes = xrSyncActions(m_session, &syncInfo);
+            if (syncRes == XR_SESSION_NOT_FOCUSED) {
+                return false;
             }
 
-            std::vector<char> humanReadableName = CHECK_TWO_CALL(char, {}, xrPathToString, m_instance, m_topLevelPath);
+            REQUIRE_RESULT(syncRes, XR_SUCCESS);
+            return true;
+        }
 
-            std::string action = state ? "Turn on" : "Turn off";
-            m_messageDisplay->DisplayMessage(action + " " + humanReadableName.data());
+        XrActionStateBoolean GetBooleanState(XrPath button)
+        {
+            XrActionStateBoolean booleanActionData{XR_TYPE_ACTION_STATE_BOOLEAN};
+            XrActionStateGetInfo getInfo{XR_TYPE_ACTION_STATE_GET_INFO};
+            getInfo.action = m_actionMap.at(button);
+            REQUIRE_RESULT(xrGetActionStateBoolean(m_session, &getInfo, &booleanActionData), XR_SUCCESS);
+            return booleanActionData;
+        }
 
-            enum class ControllerState
-            {
-                NotFocused,
-                Active,
-                Inactive
-            };
+        XrActionStateFloat GetFloatState(XrPath button)
+        {
+            XrActionStateFloat floatActionData{XR_TYPE_ACTION_STATE_FLOAT};
+            XrActionStateGetInfo getInfo{XR_TYPE_ACTION_STATE_GET_INFO};
+            getInfo.action = m_actionMap.at(button);
+            REQUIRE_RESULT(xrGetActionStateFloat(m_session, &getInfo, &floatActionData), XR_SUCCESS);
+            return floatActionData;
+        }
 
-            auto findController = [&]() -> ControllerState {
-                XrActiveActionSet activeActionSet{m_actionSet};
-                XrActionsSyncInfo syncInfo{XR_TYPE_ACTIONS_SYNC_INFO};
-                syncInfo.countActiveActionSets = 1;
-                syncInfo.activeActionSets = &activeActionSet;
-                const XrResult syncRes = xrSyncActions(m_session, &syncInfo);
-                if (syncRes == XR_SESSION_NOT_FOCUSED) {
-                    return ControllerState::NotFocused;
-                }
+        XrActionStateVector2f GetVector2State(XrPath button)
+        {
+            XrActionStateVector2f vectorActionData{XR_TYPE_ACTION_STATE_VECTOR2F};
+            XrActionStateGetInfo getInfo{XR_TYPE_ACTION_STATE_GET_INFO};
+            getInfo.action = m_actionMap.at(button);
+            REQUIRE_RESULT(xrGetActionStateVector2f(m_session, &getInfo, &vectorActionData), XR_SUCCESS);
+            return vectorActionData;
+        }
+
+        ITestMessageDisplay* const m_messageDisplay;
+        const XrInstance m_instance;
+        const XrSession m_session;
+        const XrPath m_interactionProfile;
+        const XrPath m_topLevelPath;
+        XrActionSet m_actionSet;
+        std::map<XrPath, XrAction> m_actionMap;
 
-                REQUIRE_RESULT(syncRes, XR_SUCCESS);
+        XrAction m_firstBooleanAction{XR_NULL_PATH};  // Used to detect controller state
+    };
 
-                XrActionStateBoolean booleanActionData{XR_TYPE_ACTION_STATE_BOOLEAN};
-                XrActionStateGetInfo getInfo{XR_TYPE_ACTION_STATE_GET_INFO};
-                getInfo.action = m_firstBooleanAction;
-                REQUIRE_RESULT(xrGetActionStateBoolean(m_session, &getInfo, &booleanActionData), XR_SUCCESS);
+    // Asks the tester to operate the device, and waits until the runtime reports what was asked for.
+    class HumanDrivenInputdevice : public InputTestDeviceBase
+    {
+    public:
+        using InputTestDeviceBase::InputTestDeviceBase;
 
-                return booleanActionData.isActive ? ControllerState::Active : ControllerState::Inactive;
-            };
+        void SetDeviceActive(bool state, bool skipInteraction = false) override
+        {
+            if (skipInteraction) {
+                return;
+            }
+
+            std::string humanReadableName;
+            CHECK_RESULT_SUCCEEDED(CachedPathToString(m_instance, m_topLevelPath, &humanReadableName));
+
+            std::string action = state ? "Turn on" : "Turn off";
+            m_messageDisplay->DisplayMessage(action + " " + humanReadableName);
 
             const ControllerState desiredControllerState = state ? ControllerState::Active : ControllerState::Inactive;
-            auto timeSinceStateChanged = std::chrono::high_resolution_clock::now();
+            auto timeSinceStateChanged = MonotonicClock::now();
             REQUIRE_MSG(WaitUntilPredicateWithTimeout(
                             [&] {
-                                if (findController() != desiredControllerState) {
-                                    timeSinceStateChanged = std::chrono::high_resolution_clock::now();
+                                if (GetControllerState() != desiredControllerState) {
+                                    timeSinceStateChanged = MonotonicClock::now();
                                 }
-                                else if (std::chrono::high_resolution_clock::now() - timeSinceStateChanged > 250ms) {
+                                else if (MonotonicClock::now() - timeSinceStateChanged > 250ms) {
                                     return true;  // Only return true when the controller has been stably active for 250ms.
                                 }
                                 m_messageDisplay->IterateFrame();
@@ -192,16 +553,7 @@ namespace Conformance
 
         void SetButtonStateBool(XrPath button, bool state, bool skipInteraction, XrActionSet extraActionSet = XR_NULL_HANDLE) override
         {
-            if (m_conformanceAutomationExtensionEnabled) {
-                PFN_xrSetInputDeviceStateBoolEXT xrSetInputDeviceStateBoolEXT{nullptr};
-                REQUIRE_RESULT(
-                    xrGetInstanceProcAddr(m_instance, "xrSetInputDeviceStateBoolEXT", (PFN_xrVoidFunction*)&xrSetInputDeviceStateBoolEXT),
-                    XR_SUCCESS);
-                REQUIRE_RESULT(xrSetInputDeviceStateBoolEXT(m_session, m_topLevelPath, button, (XrBool32)state), XR_SUCCESS);
-            }
-
             if (skipInteraction) {
-                // Skip human interaction, this is just a hint to the runtime via the extension
                 return;
             }
 
@@ -214,37 +566,16 @@ namespace Conformance
                 },
                 instructionDelay, waitDelay);
 
-            std::vector<char> humanReadableName = CHECK_TWO_CALL(char, {}, xrPathToString, m_instance, button);
+            std::string humanReadableName;
+            CHECK_RESULT_SUCCEEDED(CachedPathToString(m_instance, button, &humanReadableName));
 
             std::string action = state ? "Press" : "Release";
-            m_messageDisplay->DisplayMessage(action + " " + humanReadableName.data());
-
-            XrAction actionToDetect = m_actionMap.at(button);
-
-            auto GetButtonState = [&](XrAction action) -> bool {
-                XrActiveActionSet activeActionSet[] = {{m_actionSet}, {extraActionSet}};
-                XrActionsSyncInfo syncInfo{XR_TYPE_ACTIONS_SYNC_INFO};
-                syncInfo.countActiveActionSets = extraActionSet == XR_NULL_HANDLE ? 1 : 2;
-                syncInfo.activeActionSets = activeActionSet;
-                const XrResult syncRes = xrSyncActions(m_session, &syncInfo);
-                if (syncRes == XR_SESSION_NOT_FOCUSED) {
-                    return false;
-                }
-
-                REQUIRE_RESULT(syncRes, XR_SUCCESS);
-
-                XrActionStateBoolean booleanActionData{XR_TYPE_ACTION_STATE_BOOLEAN};
-                XrActionStateGetInfo getInfo{XR_TYPE_ACTION_STATE_GET_INFO};
-                getInfo.action = action;
-                REQUIRE_RESULT(xrGetActionStateBoolean(m_session, &getInfo, &booleanActionData), XR_SUCCESS);
-
-                return booleanActionData.currentState;
-            };
+            m_messageDisplay->DisplayMessage(action + " " + humanReadableName);
 
             REQUIRE_MSG(WaitUntilPredicateWithTimeout(
                             [&]() {
                                 m_messageDisplay->IterateFrame();
-                                return GetButtonState(actionToDetect) == state;
+                                return SyncActions(extraActionSet) && (bool)GetBooleanState(button).currentState == state;
                             },
                             30s, waitDelay),
                         "Boolean button state not detected");
@@ -255,16 +586,7 @@ namespace Conformance
         void SetButtonStateFloat(XrPath button, float state, float epsilon, bool skipInteraction = false,
                                  XrActionSet extraActionSet = XR_NULL_HANDLE) override
         {
-            if (m_conformanceAutomationExtensionEnabled) {
-                PFN_xrSetInputDeviceStateFloatEXT xrSetInputDeviceStateFloatEXT{nullptr};
-                REQUIRE_RESULT(
-                    xrGetInstanceProcAddr(m_instance, "xrSetInputDeviceStateFloatEXT", (PFN_xrVoidFunction*)&xrSetInputDeviceStateFloatEXT),
-                    XR_SUCCESS);
-                REQUIRE_RESULT(xrSetInputDeviceStateFloatEXT(m_session, m_topLevelPath, button, state), XR_SUCCESS);
-            }
-
             if (skipInteraction) {
-                // Skip human interaction, this is just a hint to the runtime via the extension
                 return;
             }
 
@@ -277,28 +599,17 @@ namespace Conformance
                 },
                 instructionDelay, waitDelay);
 
-            std::vector<char> humanReadableName = CHECK_TWO_CALL(char, {}, xrPathToString, m_instance, button);
+            std::string humanReadableName;
+            CHECK_RESULT_SUCCEEDED(CachedPathToString(m_instance, button, &humanReadableName));
 
-            auto message = std::string("Set ") + humanReadableName.data() + "\nExpected:  " + std::to_string(state);
+            auto message = std::string("Set ") + humanReadableName + "\nExpected:  " + std::to_string(state);
 
-            XrAction actionToDetect = m_actionMap.at(button);
-
-            auto FloatStateWithinEpsilon = [&](XrAction action, float target, float epsilon) -> bool {
-                XrActiveActionSet activeActionSet[] = {{m_actionSet}, {extraActionSet}};
-                XrActionsSyncInfo syncInfo{XR_TYPE_ACTIONS_SYNC_INFO};
-                syncInfo.countActiveActionSets = extraActionSet == XR_NULL_HANDLE ? 1 : 2;
-                syncInfo.activeActionSets = activeActionSet;
-                const XrResult syncRes = xrSyncActions(m_session, &syncInfo);
-                if (syncRes == XR_SESSION_NOT_FOCUSED) {
+            auto FloatStateWithinEpsilon = [&](float target, float epsilon) -> bool {
+                if (!SyncActions(extraActionSet)) {
                     return false;
                 }
 
-                REQUIRE_RESULT(syncRes, XR_SUCCESS);
-
-                XrActionStateFloat floatActionData{XR_TYPE_ACTION_STATE_FLOAT};
-                XrActionStateGetInfo getInfo{XR_TYPE_ACTION_STATE_GET_INFO};
-                getInfo.action = action;
-                REQUIRE_RESULT(xrGetActionStateFloat(m_session, &getInfo, &floatActionData), XR_SUCCESS);
+                const XrActionStateFloat floatActionData = GetFloatState(button);
 
                 auto currentValueMessage = "Current:  " + std::to_string(floatActionData.currentState);
                 m_messageDisplay->DisplayMessage(message + "\n" + currentValueMessage);
@@ -309,7 +620,7 @@ namespace Conformance
             REQUIRE_MSG(WaitUntilPredicateWithTimeout(
                             [&]() {
                                 m_messageDisplay->IterateFrame();
-                                return FloatStateWithinEpsilon(actionToDetect, state, epsilon);
+                                return FloatStateWithinEpsilon(state, epsilon);
                             },
                             30s, waitDelay),
                         "Float input state not detected");
@@ -320,16 +631,7 @@ namespace Conformance
         void SetButtonStateVector2(XrPath button, XrVector2f state, float epsilon, bool skipInteraction = false,
                                    XrActionSet extraActionSet = XR_NULL_HANDLE) override
         {
-            if (m_conformanceAutomationExtensionEnabled) {
-                PFN_xrSetInputDeviceStateVector2fEXT xrSetInputDeviceStateVector2fEXT{nullptr};
-                REQUIRE_RESULT(xrGetInstanceProcAddr(m_instance, "xrSetInputDeviceStateVector2fEXT",
-                                                     (PFN_xrVoidFunction*)&xrSetInputDeviceStateVector2fEXT),
-                               XR_SUCCESS);
-                REQUIRE_RESULT(xrSetInputDeviceStateVector2fEXT(m_session, m_topLevelPath, button, state), XR_SUCCESS);
-            }
-
             if (skipInteraction) {
-                // Skip human interaction, this is just a hint to the runtime via the extension
                 return;
             }
 
@@ -342,29 +644,18 @@ namespace Conformance
                 },
                 instructionDelay, waitDelay);
 
-            std::vector<char> humanReadableName = CHECK_TWO_CALL(char, {}, xrPathToString, m_instance, button);
+            std::string humanReadableName;
+            CHECK_RESULT_SUCCEEDED(CachedPathToString(m_instance, button, &humanReadableName));
 
-            auto message = std::string("Set ") + humanReadableName.data() + "\nExpected: (" + std::to_string(state.x) + ", " +
+            auto message = std::string("Set ") + humanReadableName + "\nExpected: (" + std::to_string(state.x) + ", " +
                            std::to_string(state.y) + ")";
 
-            XrAction actionToDetect = m_actionMap.at(button);
-
-            auto VectorStateWithinEpsilon = [&](XrAction action, XrVector2f target, float epsilon) -> bool {
-                XrActiveActionSet activeActionSet[] = {{m_actionSet}, {extraActionSet}};
-                XrActionsSyncInfo syncInfo{XR_TYPE_ACTIONS_SYNC_INFO};
-                syncInfo.countActiveActionSets = extraActionSet == XR_NULL_HANDLE ? 1 : 2;
-                syncInfo.activeActionSets = activeActionSet;
-                const XrResult syncRes = xrSyncActions(m_session, &syncInfo);
-                if (syncRes == XR_SESSION_NOT_FOCUSED) {
+            auto VectorStateWithinEpsilon = [&](XrVector2f target, float epsilon) -> bool {
+                if (!SyncActions(extraActionSet)) {
                     return false;
                 }
 
-                REQUIRE_RESULT(syncRes, XR_SUCCESS);
-
-                XrActionStateVector2f vectorActionData{XR_TYPE_ACTION_STATE_VECTOR2F};
-                XrActionStateGetInfo getInfo{XR_TYPE_ACTION_STATE_GET_INFO};
-                getInfo.action = action;
-                REQUIRE_RESULT(xrGetActionStateVector2f(m_session, &getInfo, &vectorActionData), XR_SUCCESS);
+                const XrActionStateVector2f vectorActionData = GetVector2State(button);
 
                 auto currentValueMessage = "Current:  (" + std::to_string(vectorActionData.currentState.x) + ", " +
                                            std::to_string(vectorActionData.currentState.y) + ")";
@@ -377,25 +668,113 @@ namespace Conformance
             REQUIRE_MSG(WaitUntilPredicateWithTimeout(
                             [&]() {
                                 m_messageDisplay->IterateFrame();
-                                return VectorStateWithinEpsilon(actionToDetect, state, epsilon);
+                                return VectorStateWithinEpsilon(state, epsilon);
                             },
                             30s, waitDelay),
                         "Float input state not detected");
 
             m_messageDisplay->DisplayMessage("");
         }
+    };
+
+    // Sets the input state through XR_EXT_conformance_automation and shows nothing to the tester. Rather than sleeping,
+    // it iterates frames until the runtime reports the new state, so the interactive action tests run unattended and as
+    // fast as the runtime hands out frames.
+    class AutomationDrivenInputDevice : public InputTestDeviceBase
+    {
+    public:
+        AutomationDrivenInputDevice(ITestMessageDisplay* const messageDisplay, InteractionManager* const interactionManager,
+                                    XrInstance instance, XrSession session, XrPath interactionProfile, XrPath topLevelPath,
+                                    InteractionProfileWhitelistData interactionProfilePaths)
+            : InputTestDeviceBase(messageDisplay, interactionManager, instance, session, interactionProfile, topLevelPath,
+                                  std::move(interactionProfilePaths))
+        {
+            REQUIRE_RESULT(
+                xrGetInstanceProcAddr(instance, "xrSetInputDeviceActiveEXT", reinterpret_cast<PFN_xrVoidFunction*>(&m_setActive)),
+                XR_SUCCESS);
+            REQUIRE_RESULT(
+                xrGetInstanceProcAddr(instance, "xrSetInputDeviceStateBoolEXT", reinterpret_cast<PFN_xrVoidFunction*>(&m_setBool)),
+                XR_SUCCESS);
+            REQUIRE_RESULT(
+                xrGetInstanceProcAddr(instance, "xrSetInputDeviceStateFloatEXT", reinterpret_cast<PFN_xrVoidFunction*>(&m_setFloat)),
+                XR_SUCCESS);
+            REQUIRE_RESULT(xrGetInstanceProcAddr(instance, "xrSetInputDeviceStateVector2fEXT",
+                                                 reinterpret_cast<PFN_xrVoidFunction*>(&m_setVector2f)),
+                           XR_SUCCESS);
+        }
+
+        void SetDeviceActive(bool state, bool skipInteraction = false) override
+        {
+            REQUIRE_RESULT(m_setActive(m_session, m_interactionProfile, m_topLevelPath, (XrBool32)state), XR_SUCCESS);
+            if (skipInteraction) {
+                return;
+            }
+
+            const ControllerState desiredControllerState = state ? ControllerState::Active : ControllerState::Inactive;
+            IterateFramesUntil([&] { return GetControllerState() == desiredControllerState; }, "Input device activity not detected");
+        }
+
+        void SetButtonStateBool(XrPath button, bool state, bool skipInteraction, XrActionSet extraActionSet = XR_NULL_HANDLE) override
+        {
+            REQUIRE_RESULT(m_setBool(m_session, m_topLevelPath, button, (XrBool32)state), XR_SUCCESS);
+            if (skipInteraction) {
+                return;
+            }
+
+            IterateFramesUntil([&] { return SyncActions(extraActionSet) && (bool)GetBooleanState(button).currentState == state; },
+                               "Boolean button state not detected");
+        }
+
+        void SetButtonStateFloat(XrPath button, float state, float epsilon, bool skipInteraction = false,
+                                 XrActionSet extraActionSet = XR_NULL_HANDLE) override
+        {
+            REQUIRE_RESULT(m_setFloat(m_session, m_topLevelPath, button, state), XR_SUCCESS);
+            if (skipInteraction) {
+                return;
+            }
+
+            IterateFramesUntil([&] { return SyncActions(extraActionSet) && fabs(state - GetFloatState(button).currentState) < epsilon; },
+                               "Float input state not detected");
+        }
+
+        void SetButtonStateVector2(XrPath button, XrVector2f state, float epsilon, bool skipInteraction = false,
+                                   XrActionSet extraActionSet = XR_NULL_HANDLE) override
+        {
+            REQUIRE_RESULT(m_setVector2f(m_session, m_topLevelPath, button, state), XR_SUCCESS);
+            if (skipInteraction) {
+                return;
+            }
+
+            IterateFramesUntil(
+                [&] {
+                    if (!SyncActions(extraActionSet)) {
+                        return false;
+                    }
+                    const XrVector2f current = GetVector2State(button).currentState;
+                    return fabs(state.x - current.x) < epsilon && fabs(state.y - current.y) < epsilon;
+                },
+                "Vector2 input state not detected");
+        }
 
     private:
-        ITestMessageDisplay* const m_messageDisplay;
-        const XrInstance m_instance;
-        const XrSession m_session;
-        const XrPath m_interactionProfile;
-        const XrPath m_topLevelPath;
-        const bool m_conformanceAutomationExtensionEnabled{false};
-        XrActionSet m_actionSet;
-        std::map<XrPath, XrAction> m_actionMap;
+        // The runtime is expected to report a new state by the next sync or so; the limit only bounds a failure.
+        static constexpr uint32_t MaxFramesToDetect = 300;
 
-        XrAction m_firstBooleanAction{XR_NULL_PATH};  // Used to detect controller state
+        void IterateFramesUntil(const std::function<bool()>& predicate, const char* failureMessage)
+        {
+            for (uint32_t frame = 0; frame < MaxFramesToDetect; ++frame) {
+                if (predicate()) {
+                    return;
+                }
+                m_messageDisplay->IterateFrame();
+            }
+            REQUIRE_MSG(predicate(), failureMessage);
+        }
+
+        PFN_xrSetInputDeviceActiveEXT m_setActive{nullptr};
+        PFN_xrSetInputDeviceStateBoolEXT m_setBool{nullptr};
+        PFN_xrSetInputDeviceStateFloatEXT m_setFloat{nullptr};
+        PFN_xrSetInputDeviceStateVector2fEXT m_setVector2f{nullptr};
     };
 
     std::unique_ptr<IInputTestDevice> CreateTestDevice(ITestMessageDisplay* const messageDisplay,
@@ -403,6 +782,10 @@ namespace Conformance
                                                        XrPath interactionProfile, XrPath topLevelPath,
                                                        InteractionProfileWhitelistData interactionProfilePaths)
     {
+        if (GetGlobalData().IsInstanceExtensionEnabled("XR_EXT_conformance_automation")) {
+            return std::make_unique<AutomationDrivenInputDevice>(messageDisplay, interactionManager, instance, session, interactionProfile,
+                                                                 topLevelPath, interactionProfilePaths);
+        }
         return std::make_unique<HumanDrivenInputdevice>(messageDisplay, interactionManager, instance, session, interactionProfile,
                                                         topLevelPath, interactionProfilePaths);
     }
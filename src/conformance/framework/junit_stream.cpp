@@ -0,0 +1,247 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "junit_stream.h"
+#include <ctime>
+
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if defined(XR_CONFORMANCE_USE_ZLIB)
+#include <zlib.h>
+#endif
+
+namespace Conformance
+{
+    namespace
+    {
+        const char* const ClosingTags = "  </testsuite>\n</testsuites>\n";
+
+        bool EndsWith(const std::string& text, const char* suffix)
+        {
+            const std::string s(suffix);
+            return text.size() >= s.size() && text.compare(text.size() - s.size(), s.size(), s) == 0;
+        }
+
+        // Asks the operating system to write what it has buffered of the file to storage.
+        void SyncDescriptor(int descriptor)
+        {
+#if defined(_WIN32)
+            _commit(descriptor);
+#else
+            fsync(descriptor);
+#endif
+        }
+    }  // namespace
+
+    std::string EscapeXml(const std::string& text)
+    {
+        std::string escaped;
+        escaped.reserve(text.size());
+        for (const char c : text) {
+            switch (c) {
+            case '&':
+                escaped += "&amp;";
+                break;
+            case '<':
+                escaped += "&lt;";
+                break;
+            case '>':
+                escaped += "&gt;";
+                break;
+            case '"':
+                escaped += "&quot;";
+                break;
+            case '\t':
+            case '\n':
+            case '\r':
+                escaped += c;
+                break;
+            default:
+                // Other control characters cannot appear in XML 1.0, even as character references.
+                escaped += (static_cast<unsigned char>(c) < 0x20) ? '?' : c;
+                break;
+            }
+        }
+        return escaped;
+    }
+
+    JUnitStream::~JUnitStream()
+    {
+        Close();
+    }
+
+    bool JUnitStream::SupportsCompression()
+    {
+#if defined(XR_CONFORMANCE_USE_ZLIB)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    bool JUnitStream::Open(const std::string& path, const std::string& suiteName, std::chrono::seconds syncInterval)
+    {
+        Close();
+
+        if (EndsWith(path, ".gz")) {
+#if defined(XR_CONFORMANCE_USE_ZLIB)
+#if defined(_WIN32)
+            m_descriptor = _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+            m_descriptor = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+            if (m_descriptor < 0) {
+                return false;
+            }
+            // gzclose closes the descriptor, which is kept to sync it.
+            m_gzFile = gzdopen(m_descriptor, "wb");
+            if (m_gzFile == nullptr) {
+#if defined(_WIN32)
+                _close(m_descriptor);
+#else
+                close(m_descriptor);
+#endif
+                m_descriptor = -1;
+                return false;
+            }
+#else
+            return false;
+#endif
+        }
+        else {
+            m_file = fopen(path.c_str(), "wb");
+            if (m_file == nullptr) {
+                return false;
+            }
+#if defined(_WIN32)
+            m_descriptor = _fileno(m_file);
+#else
+            m_descriptor = fileno(m_file);
+#endif
+        }
+
+        char timestamp[32] = "";
+        const std::time_t now = std::time(nullptr);
+        if (const std::tm* utc = std::gmtime(&now)) {
+            std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", utc);
+        }
+
+        // The test suite has no test counts, which are not known until the end; JUnit readers count the test cases.
+        WriteText("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<testsuites>\n  <testsuite name=\"" + EscapeXml(suiteName) +
+                  "\" timestamp=\"" + timestamp + "\">\n");
+        if (m_file != nullptr) {
+            m_closingTagsOffset = ftell(m_file);
+            WriteText(ClosingTags);
+        }
+
+        m_syncInterval = syncInterval;
+        Commit(true);
+        return true;
+    }
+
+    void JUnitStream::Close()
+    {
+        if (m_file != nullptr) {
+            // The closing tags are already there.
+            Commit(true);
+            fclose(m_file);
+            m_file = nullptr;
+        }
+#if defined(XR_CONFORMANCE_USE_ZLIB)
+        if (m_gzFile != nullptr) {
+            WriteText(ClosingTags);
+            gzflush(m_gzFile, Z_FINISH);
+            SyncDescriptor(m_descriptor);
+            gzclose(m_gzFile);
+            m_gzFile = nullptr;
+        }
+#endif
+        m_descriptor = -1;
+    }
+
+    void JUnitStream::WriteTestCase(const std::string& className, const std::string& name, double seconds,
+                                    const std::vector<JUnitFailure>& failures)
+    {
+        if (!IsOpen()) {
+            return;
+        }
+
+        char time[32];
+        snprintf(time, sizeof(time), "%.3f", seconds);
+        std::string element = "    <testcase classname=\"" + EscapeXml(className) + "\" name=\"" + EscapeXml(name) + "\" time=\"" +
+                              time + "\"";
+        if (failures.empty()) {
+            element += "/>\n";
+        }
+        else {
+            element += ">\n";
+            for (const JUnitFailure& failure : failures) {
+                element += std::string("      <") + failure.element + " message=\"" + EscapeXml(failure.message) + "\" type=\"" +
+                           EscapeXml(failure.type) + "\">" + EscapeXml(failure.text) + "</" + failure.element + ">\n";
+            }
+            element += "    </testcase>\n";
+        }
+
+        if (m_file != nullptr) {
+            // Every test case is longer than the closing tags it replaces, so nothing is left of them but what follows it.
+            fseek(m_file, m_closingTagsOffset, SEEK_SET);
+            WriteText(element);
+            m_closingTagsOffset = ftell(m_file);
+            WriteText(ClosingTags);
+        }
+        else {
+            WriteText(element);
+        }
+        Commit(false);
+    }
+
+    void JUnitStream::WriteText(const std::string& text)
+    {
+        if (m_file != nullptr) {
+            fwrite(text.data(), 1, text.size(), m_file);
+        }
+#if defined(XR_CONFORMANCE_USE_ZLIB)
+        if (m_gzFile != nullptr) {
+            gzwrite(m_gzFile, text.data(), static_cast<unsigned>(text.size()));
+        }
+#endif
+    }
+
+    void JUnitStream::Commit(bool forceSync)
+    {
+        if (m_file != nullptr) {
+            fflush(m_file);
+        }
+#if defined(XR_CONFORMANCE_USE_ZLIB)
+        if (m_gzFile != nullptr) {
+            // A sync flush ends the compressed data on a byte boundary, so that what is written so far decompresses.
+            gzflush(m_gzFile, Z_SYNC_FLUSH);
+        }
+#endif
+
+        const auto now = std::chrono::steady_clock::now();
+        if (forceSync || now - m_lastSync >= m_syncInterval) {
+            SyncDescriptor(m_descriptor);
+            m_lastSync = now;
+        }
+    }
+}  // namespace Conformance
@@ -0,0 +1,83 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+struct gzFile_s;
+
+namespace Conformance
+{
+    // One failed assertion of a test case, as a <failure> or <error> element of a JUnit test case.
+    struct JUnitFailure
+    {
+        const char* element{"failure"};  // "failure", or "error" for an unexpected exception or a fatal error condition.
+        std::string message;             // The expanded expression.
+        std::string type;                // The assertion macro.
+        std::string text;                // The messages, sections and source location.
+    };
+
+    // Writes JUnit XML a test case at a time, so that memory does not grow with the length of the run and a run which
+    // crashes or is killed still leaves every completed test case behind.
+    //
+    // An uncompressed file is a complete document after every test case: the closing tags are written after each one and
+    // overwritten by the next. A file ending in ".gz" is gzip compressed, when built with BUILD_CONFORMANCE_ZLIB, and is
+    // flushed to a point that decompresses after every test case; only Close writes its closing tags. Either way the
+    // file is synced to storage at most once per sync interval, and at Close.
+    class JUnitStream
+    {
+    public:
+        ~JUnitStream();
+
+        // Creates or truncates the file and writes the start of a test suite of the given name. Returns false if it
+        // could not be opened, or if it asks for compression that this build does not have.
+        bool Open(const std::string& path, const std::string& suiteName, std::chrono::seconds syncInterval);
+
+        // Writes the end of the test suite and closes the file.
+        void Close();
+
+        bool IsOpen() const
+        {
+            return m_file != nullptr || m_gzFile != nullptr;
+        }
+
+        // Returns whether this build can write gzip compressed files.
+        static bool SupportsCompression();
+
+        // Adds a test case, which passed if there are no failures. Does nothing if the stream is not open.
+        void WriteTestCase(const std::string& className, const std::string& name, double seconds,
+                           const std::vector<JUnitFailure>& failures);
+
+    private:
+        void WriteText(const std::string& text);
+        void Commit(bool forceSync);
+
+        FILE* m_file{nullptr};
+        gzFile_s* m_gzFile{nullptr};
+        int m_descriptor{-1};
+        long m_closingTagsOffset{0};  // Where the next test case overwrites the closing tags, uncompressed only.
+        std::chrono::seconds m_syncInterval{0};
+        std::chrono::steady_clock::time_point m_lastSync;
+    };
+
+    // Returns the text escaped for an XML attribute value or element content.
+    std::string EscapeXml(const std::string& text);
+}  // namespace Conformance
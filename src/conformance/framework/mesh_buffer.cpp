@@ -0,0 +1,50 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mesh_buffer.h"
+#include <stdexcept>
+
+namespace Conformance
+{
+    MeshRange MeshBuffer::Add(const Geometry::Vertex* vertices, size_t vertexCount, const uint16_t* indices, size_t indexCount)
+    {
+        if (vertexCount > 65536) {
+            throw std::invalid_argument("MeshBuffer meshes are limited to 65536 vertices");
+        }
+
+        MeshRange range;
+        range.firstIndex = (uint32_t)m_indices.size();
+        range.indexCount = (uint32_t)indexCount;
+        range.baseVertex = (int32_t)m_vertices.size();
+
+        m_vertices.reserve(m_vertices.size() + vertexCount);
+        for (size_t i = 0; i < vertexCount; ++i) {
+            m_vertices.push_back(Geometry::PackVertex(vertices[i]));
+        }
+        m_indices.insert(m_indices.end(), indices, indices + indexCount);
+        return range;
+    }
+
+    const SharedMeshes& GetSharedMeshes()
+    {
+        static const SharedMeshes meshes = [] {
+            SharedMeshes result;
+            result.cube = result.buffer.Add(Geometry::c_cubeVertices, Geometry::c_cubeIndices);
+            return result;
+        }();
+        return meshes;
+    }
+}  // namespace Conformance
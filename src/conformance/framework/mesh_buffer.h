@@ -0,0 +1,82 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "Geometry.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Conformance
+{
+    /// Where one mesh of a MeshBuffer lies: draw indexCount indices from firstIndex, adding baseVertex to each.
+    struct MeshRange
+    {
+        uint32_t firstIndex{0};
+        uint32_t indexCount{0};
+        int32_t baseVertex{0};
+    };
+
+    /// Packs any number of indexed meshes into one array of Geometry::PackedVertex and one array of 16-bit indices, so
+    /// that a graphics plugin uploads them as a single vertex buffer and a single index buffer, binds them once and
+    /// draws each mesh by its MeshRange. Indices stay relative to their own mesh, so each mesh may have up to 65536
+    /// vertices however many meshes the buffer holds.
+    class MeshBuffer
+    {
+    public:
+        MeshRange Add(const Geometry::Vertex* vertices, size_t vertexCount, const uint16_t* indices, size_t indexCount);
+
+        template <size_t VertexCount, size_t IndexCount>
+        MeshRange Add(const std::array<Geometry::Vertex, VertexCount>& vertices, const std::array<uint16_t, IndexCount>& indices)
+        {
+            return Add(vertices.data(), VertexCount, indices.data(), IndexCount);
+        }
+
+        const std::vector<Geometry::PackedVertex>& Vertices() const
+        {
+            return m_vertices;
+        }
+
+        const std::vector<uint16_t>& Indices() const
+        {
+            return m_indices;
+        }
+
+        size_t VertexBytes() const
+        {
+            return m_vertices.size() * sizeof(Geometry::PackedVertex);
+        }
+
+        size_t IndexBytes() const
+        {
+            return m_indices.size() * sizeof(uint16_t);
+        }
+
+    private:
+        std::vector<Geometry::PackedVertex> m_vertices;
+        std::vector<uint16_t> m_indices;
+    };
+
+    /// The meshes every graphics plugin draws, packed once per process, so the plugins share one CPU copy.
+    struct SharedMeshes
+    {
+        MeshBuffer buffer;
+        MeshRange cube;
+    };
+
+    const SharedMeshes& GetSharedMeshes();
+}  // namespace Conformance
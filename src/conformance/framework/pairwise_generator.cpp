@@ -0,0 +1,180 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*!
+ * @file
+ * @brief  Implementation
+ */
+
+#include "pairwise_generator.h"
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace Conformance
+{
+    namespace
+    {
+        constexpr size_t Unassigned = SIZE_MAX;
+
+        /*!
+         * GeneratorBase implementation for pairwiseGenerator - implementation details.
+         *
+         * Builds every element up front: each one starts from the first pair that is still uncovered, and then picks,
+         * parameter by parameter, the value that covers the most uncovered pairs with the values picked so far.
+         */
+        class PairwiseGenerator : public GeneratorBase<std::vector<size_t> const&>
+        {
+        public:
+            ~PairwiseGenerator() override = default;
+
+            PairwiseGenerator(const PairwiseGenerator&) = delete;
+            PairwiseGenerator& operator=(const PairwiseGenerator&) = delete;
+            PairwiseGenerator(PairwiseGenerator&&) = delete;
+            PairwiseGenerator& operator=(PairwiseGenerator&&) = delete;
+
+            explicit PairwiseGenerator(std::vector<size_t> valueCounts) : counts_(std::move(valueCounts))
+            {
+                for (size_t count : counts_) {
+                    if (count == 0) {
+                        return;
+                    }
+                }
+                if (counts_.size() < 2) {
+                    // No pairs: every value of the single parameter, if any, is its own element.
+                    for (size_t value = 0; !counts_.empty() && value < counts_[0]; ++value) {
+                        elements_.push_back({value});
+                    }
+                    return;
+                }
+                buildElements();
+            }
+
+            std::vector<size_t> const& get() override
+            {
+                return elements_[index_ - 1];
+            }
+
+            bool next() override
+            {
+                if (index_ >= elements_.size()) {
+                    return false;
+                }
+                index_++;
+                return true;
+            }
+
+        private:
+            // Uncovered pairs are kept as one flag per combination of values, for every pair of parameters i < j.
+            size_t pairOffset(size_t i, size_t j) const
+            {
+                return pairOffsets_[i * counts_.size() + j];
+            }
+
+            bool isUncovered(size_t i, size_t a, size_t j, size_t b) const
+            {
+                return uncovered_[pairOffset(i, j) + a * counts_[j] + b];
+            }
+
+            void cover(const std::vector<size_t>& element)
+            {
+                for (size_t i = 0; i < counts_.size(); ++i) {
+                    for (size_t j = i + 1; j < counts_.size(); ++j) {
+                        uint8_t& flag = uncovered_[pairOffset(i, j) + element[i] * counts_[j] + element[j]];
+                        if (flag != 0) {
+                            flag = 0;
+                            uncoveredCount_--;
+                        }
+                    }
+                }
+            }
+
+            void buildElements()
+            {
+                const size_t n = counts_.size();
+                pairOffsets_.assign(n * n, 0);
+                size_t total = 0;
+                for (size_t i = 0; i < n; ++i) {
+                    for (size_t j = i + 1; j < n; ++j) {
+                        pairOffsets_[i * n + j] = total;
+                        total += counts_[i] * counts_[j];
+                    }
+                }
+                uncovered_.assign(total, 1);
+                uncoveredCount_ = total;
+
+                size_t seedSearchStart = 0;
+                while (uncoveredCount_ != 0) {
+                    // Find the first uncovered pair, which fixes two of the parameters of the new element.
+                    while (uncovered_[seedSearchStart] == 0) {
+                        seedSearchStart++;
+                    }
+                    std::vector<size_t> element(n, Unassigned);
+                    for (size_t i = 0; i < n; ++i) {
+                        for (size_t j = i + 1; j < n; ++j) {
+                            const size_t offset = pairOffset(i, j);
+                            if (seedSearchStart >= offset && seedSearchStart < offset + counts_[i] * counts_[j]) {
+                                element[i] = (seedSearchStart - offset) / counts_[j];
+                                element[j] = (seedSearchStart - offset) % counts_[j];
+                            }
+                        }
+                    }
+
+                    // Fill in the other parameters greedily, in order.
+                    for (size_t k = 0; k < n; ++k) {
+                        if (element[k] != Unassigned) {
+                            continue;
+                        }
+                        size_t bestValue = 0;
+                        size_t bestGain = 0;
+                        for (size_t value = 0; value < counts_[k]; ++value) {
+                            size_t gain = 0;
+                            for (size_t other = 0; other < n; ++other) {
+                                if (other == k || element[other] == Unassigned) {
+                                    continue;
+                                }
+                                gain += other < k ? isUncovered(other, element[other], k, value)
+                                                  : isUncovered(k, value, other, element[other]);
+                            }
+                            if (gain > bestGain) {
+                                bestGain = gain;
+                                bestValue = value;
+                            }
+                        }
+                        element[k] = bestValue;
+                    }
+
+                    cover(element);
+                    elements_.push_back(std::move(element));
+                }
+            }
+
+            std::vector<size_t> counts_;
+            std::vector<size_t> pairOffsets_;
+            std::vector<uint8_t> uncovered_;
+            size_t uncoveredCount_ = 0;
+            std::vector<std::vector<size_t>> elements_;
+            size_t index_ = 0;
+        };
+
+    }  // namespace
+
+    GeneratorWrapper<std::vector<size_t> const&> pairwiseGenerator(std::vector<size_t> valueCounts)
+    {
+        return {std::unique_ptr<GeneratorBase<std::vector<size_t> const&>>(new PairwiseGenerator(std::move(valueCounts)))};
+    }
+}  // namespace Conformance
@@ -0,0 +1,45 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*!
+ * @file
+ * @brief  Header for a generator of test cases that cover every pair of parameter values.
+ *
+ * See the xrCreateSwapchain test for an example of usage.
+ */
+
+#pragma once
+
+#include "generator.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace Conformance
+{
+    /*!
+     * Generate a covering array of strength two over parameters with the given numbers of values.
+     *
+     * Each generated element holds one value index per parameter. For every two parameters, every combination of their
+     * values appears in at least one element, so interactions between any two parameters are exercised with far fewer
+     * elements than the full Cartesian product: roughly the product of the two largest value counts, rather than the
+     * product of them all. Elements are chosen greedily and deterministically. Generates nothing if any count is zero.
+     *
+     * @ingroup Generators
+     */
+    GeneratorWrapper<std::vector<size_t> const&> pairwiseGenerator(std::vector<size_t> valueCounts);
+
+}  // namespace Conformance
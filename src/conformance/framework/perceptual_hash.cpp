@@ -0,0 +1,234 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "perceptual_hash.h"
+#include "results_stream.h"
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PERCEPTUAL_HASH_USE_SSE2
+#endif
+
+// Some platforms require reading files from specific
+// sandboxed directories.
+#ifndef PATH_PREFIX
+#define PATH_PREFIX ""
+#endif
+
+namespace Conformance
+{
+    namespace
+    {
+        constexpr int BlockCount = 32;  // The image is box filtered to BlockCount x BlockCount before the transform.
+        constexpr int HashSize = 8;     // The lowest HashSize x HashSize frequencies make up the hash.
+
+        // The rows of the orthonormal DCT-II matrix for the frequencies of the hash: coefficients[u][x] weighs sample x
+        // for frequency u.
+        using DctCoefficients = std::array<std::array<float, BlockCount>, HashSize>;
+
+        const DctCoefficients& GetDctCoefficients()
+        {
+            static const DctCoefficients coefficients = [] {
+                const double pi = 3.14159265358979323846;
+                DctCoefficients c;
+                for (int u = 0; u < HashSize; ++u) {
+                    const double scale = std::sqrt((u == 0 ? 1.0 : 2.0) / BlockCount);
+                    for (int x = 0; x < BlockCount; ++x) {
+                        c[u][x] = (float)(scale * std::cos((2 * x + 1) * u * pi / (2 * BlockCount)));
+                    }
+                }
+                return c;
+            }();
+            return coefficients;
+        }
+
+        // Writes the alpha weighted luma, from 0 to 255, of each pixel of a row.
+        void ComputeLumaRow(const RGBA8Color* pixels, int width, float* luma)
+        {
+            int x = 0;
+#if defined(PERCEPTUAL_HASH_USE_SSE2)
+            // Four pixels at a time, each channel shifted down into its own 32-bit lane.
+            const __m128i byteMask = _mm_set1_epi32(0xFF);
+            const __m128 redWeight = _mm_set1_ps(0.299f / 255);
+            const __m128 greenWeight = _mm_set1_ps(0.587f / 255);
+            const __m128 blueWeight = _mm_set1_ps(0.114f / 255);
+            for (; x + 4 <= width; x += 4) {
+                const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + x));
+                const __m128 r = _mm_cvtepi32_ps(_mm_and_si128(p, byteMask));
+                const __m128 g = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(p, 8), byteMask));
+                const __m128 b = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(p, 16), byteMask));
+                const __m128 a = _mm_cvtepi32_ps(_mm_srli_epi32(p, 24));
+                const __m128 y =
+                    _mm_add_ps(_mm_add_ps(_mm_mul_ps(r, redWeight), _mm_mul_ps(g, greenWeight)), _mm_mul_ps(b, blueWeight));
+                _mm_storeu_ps(luma + x, _mm_mul_ps(y, a));
+            }
+#endif
+            for (; x < width; ++x) {
+                const auto& c = pixels[x].Channels;
+                luma[x] = (0.299f / 255 * c.R + 0.587f / 255 * c.G + 0.114f / 255 * c.B) * c.A;
+            }
+        }
+
+        // The pixels of block b of BlockCount along a dimension of the given size; at least one, so that images smaller
+        // than BlockCount repeat pixels instead of leaving blocks empty.
+        int BlockBegin(int b, int size)
+        {
+            return b * size / BlockCount;
+        }
+
+        int BlockEnd(int b, int size)
+        {
+            return std::max((b + 1) * size / BlockCount, BlockBegin(b, size) + 1);
+        }
+    }  // namespace
+
+    uint64_t ComputePerceptualHash(const RGBAImage& image)
+    {
+        if (image.width <= 0 || image.height <= 0) {
+            return 0;
+        }
+
+        // Box filter the luma to BlockCount x BlockCount.
+        alignas(16) float blocks[BlockCount][BlockCount];
+        std::vector<float> luma(image.width);
+        for (int by = 0; by < BlockCount; ++by) {
+            const int rowBegin = BlockBegin(by, image.height);
+            const int rowEnd = BlockEnd(by, image.height);
+            std::fill(std::begin(blocks[by]), std::end(blocks[by]), 0.0f);
+            for (int y = rowBegin; y < rowEnd; ++y) {
+                ComputeLumaRow(image.pixels.data() + (size_t)y * image.width, image.width, luma.data());
+                for (int bx = 0; bx < BlockCount; ++bx) {
+                    const int columnEnd = BlockEnd(bx, image.width);
+                    for (int x = BlockBegin(bx, image.width); x < columnEnd; ++x) {
+                        blocks[by][bx] += luma[x];
+                    }
+                }
+            }
+            for (int bx = 0; bx < BlockCount; ++bx) {
+                blocks[by][bx] /= (float)((rowEnd - rowBegin) * (BlockEnd(bx, image.width) - BlockBegin(bx, image.width)));
+            }
+        }
+
+        // Transform the columns, then the rows, keeping only the frequencies of the hash.
+        const DctCoefficients& c = GetDctCoefficients();
+        alignas(16) float columns[HashSize][BlockCount];
+        float frequencies[HashSize][HashSize];
+#if defined(PERCEPTUAL_HASH_USE_SSE2)
+        // Four samples at a time along each row of blocks.
+        for (int u = 0; u < HashSize; ++u) {
+            for (int x = 0; x < BlockCount; x += 4) {
+                __m128 sum = _mm_setzero_ps();
+                for (int y = 0; y < BlockCount; ++y) {
+                    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(c[u][y]), _mm_load_ps(&blocks[y][x])));
+                }
+                _mm_store_ps(&columns[u][x], sum);
+            }
+        }
+        for (int u = 0; u < HashSize; ++u) {
+            for (int v = 0; v < HashSize; ++v) {
+                __m128 sum = _mm_setzero_ps();
+                for (int x = 0; x < BlockCount; x += 4) {
+                    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_load_ps(&columns[u][x]), _mm_loadu_ps(&c[v][x])));
+                }
+                alignas(16) float lanes[4];
+                _mm_store_ps(lanes, sum);
+                frequencies[u][v] = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+            }
+        }
+#else
+        for (int u = 0; u < HashSize; ++u) {
+            for (int x = 0; x < BlockCount; ++x) {
+                float sum = 0;
+                for (int y = 0; y < BlockCount; ++y) {
+                    sum += c[u][y] * blocks[y][x];
+                }
+                columns[u][x] = sum;
+            }
+        }
+        for (int u = 0; u < HashSize; ++u) {
+            for (int v = 0; v < HashSize; ++v) {
+                float sum = 0;
+                for (int x = 0; x < BlockCount; ++x) {
+                    sum += columns[u][x] * c[v][x];
+                }
+                frequencies[u][v] = sum;
+            }
+        }
+#endif
+
+        // The DC coefficient, the average luma, is left out of the median so that brightness alone does not decide it.
+        std::vector<float> ac(&frequencies[0][0] + 1, &frequencies[0][0] + HashSize * HashSize);
+        std::nth_element(ac.begin(), ac.begin() + ac.size() / 2, ac.end());
+        const float median = ac[ac.size() / 2];
+
+        uint64_t hash = 0;
+        for (int i = 1; i < HashSize * HashSize; ++i) {
+            if ((&frequencies[0][0])[i] > median) {
+                hash |= uint64_t(1) << i;
+            }
+        }
+        return hash;
+    }
+
+    int PerceptualHashDistance(uint64_t a, uint64_t b)
+    {
+        return (int)std::bitset<64>(a ^ b).count();
+    }
+
+    std::string FormatPerceptualHashLine(const std::string& imageName, uint64_t hash)
+    {
+        char hex[17];
+        snprintf(hex, sizeof(hex), "%016" PRIx64, hash);
+        return JsonLine().Add("image", imageName).Add("hash", hex).String();
+    }
+
+    bool ReadPerceptualHashes(const char* path, std::map<std::string, uint64_t>& hashes)
+    {
+        std::ifstream file(std::string(PATH_PREFIX) + path);
+        if (!file.is_open()) {
+            return false;
+        }
+
+        // The hash is kept as a hex string, since JSON readers may hold numbers as doubles.
+        std::string line;
+        while (std::getline(file, line)) {
+            std::string imageName;
+            std::string hex;
+            const char* imageValue = FindJsonValue(line, "image");
+            const char* hashValue = FindJsonValue(line, "hash");
+            if (imageValue == nullptr || !ParseJsonString(imageValue, imageName) || hashValue == nullptr ||
+                !ParseJsonString(hashValue, hex) || hex.empty()) {
+                return false;
+            }
+            char* end = nullptr;
+            const uint64_t hash = strtoull(hex.c_str(), &end, 16);
+            if (*end != '\0') {
+                return false;
+            }
+            hashes[imageName] = hash;
+        }
+        return true;
+    }
+}  // namespace Conformance
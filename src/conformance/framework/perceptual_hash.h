@@ -0,0 +1,49 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "RGBAImage.h"
+#include <cstdint>
+#include <map>
+#include <string>
+
+namespace Conformance
+{
+    // The file, next to the composition example images, that holds the perceptual hash of each of them and of the images the
+    // composition tests generate.
+    constexpr const char* CompositionExampleHashesFile = "composition_example_hashes.jsonl";
+
+    // Hashes whose distance is at most this are taken to be of the same picture. Resampling, compression and small
+    // color shifts move a hash by a few bits; different pictures are typically 20 or more bits apart.
+    constexpr int PerceptualHashMatchDistance = 8;
+
+    // Returns a 64-bit hash of what the image looks like: the signs, against their median, of the 8x8 lowest frequency
+    // coefficients of a discrete cosine transform of the image's luma box filtered to 32x32. The luma is taken of the
+    // channel values as stored and weighted by alpha, as if the image were composited over black. Images of any size
+    // can be compared; the DC coefficient's bit is always zero.
+    uint64_t ComputePerceptualHash(const RGBAImage& image);
+
+    // Returns the number of bits that differ between two hashes.
+    int PerceptualHashDistance(uint64_t a, uint64_t b);
+
+    // Returns the line of a hashes file for one image, such as that of an image missing from it.
+    std::string FormatPerceptualHashLine(const std::string& imageName, uint64_t hash);
+
+    // Reads a hashes file, one JSON line per image, into hashes keyed by image name. The file is found the way
+    // RGBAImage::Load finds images. Returns false if the file could not be opened or a line does not parse.
+    bool ReadPerceptualHashes(const char* path, std::map<std::string, uint64_t>& hashes);
+}  // namespace Conformance
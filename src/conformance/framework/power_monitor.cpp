@@ -0,0 +1,157 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "power_monitor.h"
+#include "conformance_framework.h"
+#include "conformance_utils.h"
+#include "report.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+
+namespace Conformance
+{
+    namespace
+    {
+        std::atomic<bool> g_unavailableReported{false};
+
+        bool ReadPower(double* watts, int32_t* thermalStatus)
+        {
+#if defined(XR_USE_PLATFORM_ANDROID)
+            if (Conformance_Android_Read_Power(watts, thermalStatus)) {
+                return true;
+            }
+            if (!g_unavailableReported.exchange(true)) {
+                ReportF("Power sampling: the device does not report its battery current and voltage.");
+            }
+#else
+            (void)watts;
+            (void)thermalStatus;
+            if (!g_unavailableReported.exchange(true)) {
+                ReportF("Power sampling: only supported by the Android driver.");
+            }
+#endif
+            return false;
+        }
+
+        const char* ThermalStatusName(int32_t status)
+        {
+            switch (status) {
+            case 0:
+                return "none";
+            case 1:
+                return "light";
+            case 2:
+                return "moderate";
+            case 3:
+                return "severe";
+            case 4:
+                return "critical";
+            case 5:
+                return "emergency";
+            case 6:
+                return "shutdown";
+            default:
+                return "unknown";
+            }
+        }
+    }  // namespace
+
+    PowerMonitor::~PowerMonitor()
+    {
+        Stop();
+    }
+
+    void PowerMonitor::Start()
+    {
+        Stop();
+        m_summary = PowerSummary{};
+        const uint32_t interval = GetGlobalData().options.powerSampleInterval;
+        if (interval == 0) {
+            return;
+        }
+        m_stopping = false;
+        m_startTime = std::chrono::steady_clock::now();
+        m_thread = std::thread(&PowerMonitor::SampleLoop, this, interval);
+    }
+
+    PowerSummary PowerMonitor::Stop()
+    {
+        if (m_thread.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stopping = true;
+            }
+            m_wake.notify_all();
+            m_thread.join();
+            m_summary.elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_startTime).count();
+        }
+        return m_summary;
+    }
+
+    void PowerMonitor::SampleLoop(uint32_t intervalMilliseconds)
+    {
+        // Answers the calls that Conformance_Android_Read_Power makes into the Java VM.
+        ATTACH_THREAD;
+
+        // The power of each sample is held until the next one, and the last until Stop. A read that fails, such as one
+        // that races a battery update, is skipped, and the time from the last good sample to the next is left out.
+        PowerSummary summary;
+        double watts = 0;
+        int32_t thermalStatus = -1;
+        bool haveSample = false;
+        MonotonicClock::time_point sampleTime = MonotonicClock::now();
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (;;) {
+            lock.unlock();
+            double newWatts = 0;
+            const bool read = ReadPower(&newWatts, &thermalStatus);
+            const MonotonicClock::time_point now = MonotonicClock::now();
+            if (haveSample) {
+                const double seconds = std::chrono::duration<double>(now - sampleTime).count();
+                summary.seconds += seconds;
+                summary.joules += watts * seconds;
+            }
+            haveSample = read;
+            if (read) {
+                watts = newWatts;
+                sampleTime = now;
+                summary.sampleCount++;
+                summary.lastThermalStatus = thermalStatus;
+                summary.maxThermalStatus = std::max(summary.maxThermalStatus, thermalStatus);
+            }
+            lock.lock();
+            if (m_stopping) {
+                break;
+            }
+            m_wake.wait_for(lock, std::chrono::milliseconds(intervalMilliseconds), [&] { return m_stopping; });
+            // Sample once more at Stop, to close the last interval.
+        }
+        m_summary = summary;
+    }
+
+    void ReportPowerPerFrame(const char* label, const PowerSummary& summary, uint64_t frameCount)
+    {
+        if (summary.sampleCount < 2 || summary.seconds <= 0 || frameCount == 0) {
+            return;
+        }
+        // The samples may not cover every frame, so spread the average power over the time the frames took.
+        const double watts = summary.joules / summary.seconds;
+        ReportF("%s %.2fW average, %.1fmJ per frame over %zu samples, thermal status %s (worst %s)", label, watts,
+                watts * summary.elapsedSeconds * 1000.0 / frameCount, summary.sampleCount,
+                ThermalStatusName(summary.lastThermalStatus), ThermalStatusName(summary.maxThermalStatus));
+    }
+}  // namespace Conformance
@@ -0,0 +1,74 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+namespace Conformance
+{
+    // The device's power draw and thermal state over the time a PowerMonitor ran.
+    struct PowerSummary
+    {
+        size_t sampleCount{0};
+        // The time between samples that were read, and the energy drawn over it. Time around a failed read is left out.
+        double seconds{0};
+        double joules{0};
+        // From Start to Stop, the time the measured work took.
+        double elapsedSeconds{0};
+        // Android's PowerManager thermal status, from THERMAL_STATUS_NONE (0) to THERMAL_STATUS_SHUTDOWN (6), or -1 if the
+        // device does not report it.
+        int32_t maxThermalStatus{-1};
+        int32_t lastThermalStatus{-1};
+    };
+
+    // Samples the battery power draw and the thermal status of the device on its own thread every
+    // Options::powerSampleInterval between Start and Stop, so that sustained-load benchmarks can report the energy of a
+    // frame next to its pacing. Only the Android driver can read them, through BatteryManager and PowerManager; anywhere
+    // else, and with no interval set, Stop returns no samples. The draw is the whole device's, as the battery sees it, so
+    // it is only meaningful while the device runs from its battery.
+    class PowerMonitor
+    {
+    public:
+        PowerMonitor() = default;
+        ~PowerMonitor();
+
+        PowerMonitor(const PowerMonitor&) = delete;
+        PowerMonitor& operator=(const PowerMonitor&) = delete;
+
+        void Start();
+        PowerSummary Stop();
+
+    private:
+        void SampleLoop(uint32_t intervalMilliseconds);
+
+        std::thread m_thread;
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        bool m_stopping{false};
+        std::chrono::steady_clock::time_point m_startTime;
+        PowerSummary m_summary;
+    };
+
+    // Reports the average power and the energy per frame, that power over the time from Start to Stop divided among the
+    // frames, with the thermal status, on one line after the label. Reports nothing if the monitor took no samples.
+    void ReportPowerPerFrame(const char* label, const PowerSummary& summary, uint64_t frameCount);
+}  // namespace Conformance
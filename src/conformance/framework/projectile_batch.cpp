@@ -0,0 +1,162 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "projectile_batch.h"
+#include <common/xr_linear.h>
+
+namespace Conformance
+{
+    ProjectileBatch::ProjectileBatch(size_t capacity) : m_capacity(capacity)
+    {
+        for (std::vector<float>* values :
+             {&m_positionX, &m_positionY, &m_positionZ, &m_velocityX, &m_velocityY, &m_velocityZ, &m_orientationX, &m_orientationY,
+              &m_orientationZ, &m_orientationW, &m_angularX, &m_angularY, &m_angularZ}) {
+            values->resize(capacity);
+        }
+        m_launchTime.resize(capacity);
+    }
+
+    bool ProjectileBatch::Spawn(const XrPosef& pose, const XrVector3f& linearVelocity, const XrVector3f& angularVelocity, XrTime launchTime)
+    {
+        if (m_size == m_capacity) {
+            return false;
+        }
+        const size_t i = m_size++;
+        m_positionX[i] = pose.position.x;
+        m_positionY[i] = pose.position.y;
+        m_positionZ[i] = pose.position.z;
+        m_velocityX[i] = linearVelocity.x;
+        m_velocityY[i] = linearVelocity.y;
+        m_velocityZ[i] = linearVelocity.z;
+        m_orientationX[i] = pose.orientation.x;
+        m_orientationY[i] = pose.orientation.y;
+        m_orientationZ[i] = pose.orientation.z;
+        m_orientationW[i] = pose.orientation.w;
+        m_angularX[i] = angularVelocity.x;
+        m_angularY[i] = angularVelocity.y;
+        m_angularZ[i] = angularVelocity.z;
+        m_launchTime[i] = launchTime;
+        return true;
+    }
+
+    void ProjectileBatch::Integrate(float seconds)
+    {
+        // The orientation changes by half the time step times the angular velocity (as a pure quaternion, in the space of
+        // the pose) times the orientation. One Newton step towards unit length, q * (3 - |q|^2) / 2, then renormalizes it
+        // without a square root.
+        size_t i = 0;
+
+#if defined(XR_LINEAR_USE_SSE) || defined(XR_LINEAR_USE_NEON)
+        // Four projectiles at a time, one per SIMD lane; the same arithmetic as the scalar loop below.
+        const XrSimd4f dt = XrSimd4f_Splat(seconds);
+        const XrSimd4f halfDt = XrSimd4f_Splat(0.5f * seconds);
+        const XrSimd4f gravityDt = XrSimd4f_Splat(Gravity * seconds);
+        const XrSimd4f threeHalves = XrSimd4f_Splat(1.5f);
+        const XrSimd4f minusHalf = XrSimd4f_Splat(-0.5f);
+        for (; i + 4 <= m_size; i += 4) {
+            const XrSimd4f vy = XrSimd4f_Add(XrSimd4f_Load(&m_velocityY[i]), gravityDt);
+            XrSimd4f_Store(&m_velocityY[i], vy);
+            XrSimd4f_Store(&m_positionX[i], XrSimd4f_MulAdd(XrSimd4f_Load(&m_velocityX[i]), dt, XrSimd4f_Load(&m_positionX[i])));
+            XrSimd4f_Store(&m_positionY[i], XrSimd4f_MulAdd(vy, dt, XrSimd4f_Load(&m_positionY[i])));
+            XrSimd4f_Store(&m_positionZ[i], XrSimd4f_MulAdd(XrSimd4f_Load(&m_velocityZ[i]), dt, XrSimd4f_Load(&m_positionZ[i])));
+
+            const XrSimd4f qx = XrSimd4f_Load(&m_orientationX[i]);
+            const XrSimd4f qy = XrSimd4f_Load(&m_orientationY[i]);
+            const XrSimd4f qz = XrSimd4f_Load(&m_orientationZ[i]);
+            const XrSimd4f qw = XrSimd4f_Load(&m_orientationW[i]);
+            const XrSimd4f wx = XrSimd4f_Mul(XrSimd4f_Load(&m_angularX[i]), halfDt);
+            const XrSimd4f wy = XrSimd4f_Mul(XrSimd4f_Load(&m_angularY[i]), halfDt);
+            const XrSimd4f wz = XrSimd4f_Mul(XrSimd4f_Load(&m_angularZ[i]), halfDt);
+
+            const XrSimd4f nx = XrSimd4f_Add(qx, XrSimd4f_Sub(XrSimd4f_MulAdd(wx, qw, XrSimd4f_Mul(wy, qz)), XrSimd4f_Mul(wz, qy)));
+            const XrSimd4f ny = XrSimd4f_Add(qy, XrSimd4f_Sub(XrSimd4f_MulAdd(wy, qw, XrSimd4f_Mul(wz, qx)), XrSimd4f_Mul(wx, qz)));
+            const XrSimd4f nz = XrSimd4f_Add(qz, XrSimd4f_Sub(XrSimd4f_MulAdd(wz, qw, XrSimd4f_Mul(wx, qy)), XrSimd4f_Mul(wy, qx)));
+            const XrSimd4f nw = XrSimd4f_Sub(qw, XrSimd4f_MulAdd(wx, qx, XrSimd4f_MulAdd(wy, qy, XrSimd4f_Mul(wz, qz))));
+
+            const XrSimd4f lengthSquared = XrSimd4f_MulAdd(nx, nx, XrSimd4f_MulAdd(ny, ny, XrSimd4f_MulAdd(nz, nz, XrSimd4f_Mul(nw, nw))));
+            const XrSimd4f scale = XrSimd4f_MulAdd(lengthSquared, minusHalf, threeHalves);
+            XrSimd4f_Store(&m_orientationX[i], XrSimd4f_Mul(nx, scale));
+            XrSimd4f_Store(&m_orientationY[i], XrSimd4f_Mul(ny, scale));
+            XrSimd4f_Store(&m_orientationZ[i], XrSimd4f_Mul(nz, scale));
+            XrSimd4f_Store(&m_orientationW[i], XrSimd4f_Mul(nw, scale));
+        }
+#endif
+
+        const float halfSeconds = 0.5f * seconds;
+        for (; i < m_size; ++i) {
+            m_velocityY[i] += Gravity * seconds;
+            m_positionX[i] += m_velocityX[i] * seconds;
+            m_positionY[i] += m_velocityY[i] * seconds;
+            m_positionZ[i] += m_velocityZ[i] * seconds;
+
+            const float qx = m_orientationX[i], qy = m_orientationY[i], qz = m_orientationZ[i], qw = m_orientationW[i];
+            const float wx = m_angularX[i] * halfSeconds, wy = m_angularY[i] * halfSeconds, wz = m_angularZ[i] * halfSeconds;
+            const float nx = qx + (wx * qw + wy * qz - wz * qy);
+            const float ny = qy + (wy * qw + wz * qx - wx * qz);
+            const float nz = qz + (wz * qw + wx * qy - wy * qx);
+            const float nw = qw - (wx * qx + wy * qy + wz * qz);
+            const float scale = 1.5f - 0.5f * (nx * nx + ny * ny + nz * nz + nw * nw);
+            m_orientationX[i] = nx * scale;
+            m_orientationY[i] = ny * scale;
+            m_orientationZ[i] = nz * scale;
+            m_orientationW[i] = nw * scale;
+        }
+    }
+
+    void ProjectileBatch::RemoveLaunchedBefore(XrTime time)
+    {
+        size_t kept = 0;
+        for (size_t i = 0; i < m_size; ++i) {
+            if (m_launchTime[i] < time) {
+                continue;
+            }
+            if (kept != i) {
+                for (std::vector<float>* values :
+                     {&m_positionX, &m_positionY, &m_positionZ, &m_velocityX, &m_velocityY, &m_velocityZ, &m_orientationX,
+                      &m_orientationY, &m_orientationZ, &m_orientationW, &m_angularX, &m_angularY, &m_angularZ}) {
+                    (*values)[kept] = (*values)[i];
+                }
+                m_launchTime[kept] = m_launchTime[i];
+            }
+            ++kept;
+        }
+        m_size = kept;
+    }
+
+    bool ProjectileBatch::AnyWithin(const XrVector3f& point, float radius) const
+    {
+        const float radiusSquared = radius * radius;
+        for (size_t i = 0; i < m_size; ++i) {
+            const float dx = m_positionX[i] - point.x, dy = m_positionY[i] - point.y, dz = m_positionZ[i] - point.z;
+            if (dx * dx + dy * dy + dz * dz < radiusSquared) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void ProjectileBatch::AppendCubes(std::vector<Cube>& cubes, const XrVector3f& scale) const
+    {
+        cubes.reserve(cubes.size() + m_size);
+        for (size_t i = 0; i < m_size; ++i) {
+            Cube cube;
+            cube.Pose.orientation = {m_orientationX[i], m_orientationY[i], m_orientationZ[i], m_orientationW[i]};
+            cube.Pose.position = {m_positionX[i], m_positionY[i], m_positionZ[i]};
+            cube.Scale = scale;
+            cubes.push_back(cube);
+        }
+    }
+}  // namespace Conformance
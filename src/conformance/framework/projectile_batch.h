@@ -0,0 +1,77 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "graphics_plugin.h"
+#include <openxr/openxr.h>
+#include <cstddef>
+#include <vector>
+
+namespace Conformance
+{
+    /// Thrown objects falling under gravity and spinning at a constant angular velocity, kept as structure-of-arrays so
+    /// that Integrate advances four of them per SIMD instruction where xr_linear.h has SIMD. Thousands of them cost
+    /// little CPU, so the throw scenarios can launch many at once.
+    class ProjectileBatch
+    {
+    public:
+        /// The acceleration of every projectile, in meters per second squared along Y.
+        static constexpr float Gravity = -9.8f;
+
+        /// Holds up to capacity projectiles.
+        explicit ProjectileBatch(size_t capacity);
+
+        size_t Size() const
+        {
+            return m_size;
+        }
+
+        size_t Capacity() const
+        {
+            return m_capacity;
+        }
+
+        /// Adds a projectile at pose, launched at launchTime with velocities in the same space as the pose. Returns false,
+        /// adding nothing, when the batch is full.
+        bool Spawn(const XrPosef& pose, const XrVector3f& linearVelocity, const XrVector3f& angularVelocity, XrTime launchTime);
+
+        /// Advances every projectile by the given time: gravity, position, then orientation. The orientation follows the
+        /// first order of the angular velocity and is renormalized, which stays close to the exact rotation for the
+        /// rotation of one frame.
+        void Integrate(float seconds);
+
+        /// Removes the projectiles launched before the given time, keeping the others in order.
+        void RemoveLaunchedBefore(XrTime time);
+
+        /// Returns whether any projectile is within radius of point.
+        bool AnyWithin(const XrVector3f& point, float radius) const;
+
+        /// Appends a cube of the given scale for every projectile, for IGraphicsPlugin::RenderView.
+        void AppendCubes(std::vector<Cube>& cubes, const XrVector3f& scale) const;
+
+    private:
+        size_t m_capacity;
+        size_t m_size{0};
+
+        // One entry per projectile, each sized to the capacity; the first m_size entries are live.
+        std::vector<float> m_positionX, m_positionY, m_positionZ;
+        std::vector<float> m_velocityX, m_velocityY, m_velocityZ;
+        std::vector<float> m_orientationX, m_orientationY, m_orientationZ, m_orientationW;
+        std::vector<float> m_angularX, m_angularY, m_angularZ;
+        std::vector<XrTime> m_launchTime;
+    };
+}  // namespace Conformance
@@ -0,0 +1,70 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <openxr/openxr.h>
+#include <common/xr_linear.h>
+#include <array>
+#include <cstddef>
+
+namespace Conformance
+{
+    /// Remembers the last few projection matrices a graphics plugin built, keyed on the FOV and clip planes, so
+    /// the tangents are only evaluated again when a view's FOV changes. Views usually keep their FOV for a whole
+    /// test, so with one entry per view almost every lookup is a hit. graphicsApi is a template argument so the
+    /// clip space choices in XrMatrix4x4f_CreateProjection are resolved when it is inlined. Not thread-safe.
+    template <GraphicsAPI graphicsApi, size_t Capacity = 4>
+    class ProjectionCache
+    {
+    public:
+        const XrMatrix4x4f& Get(const XrFovf& fov, float nearZ, float farZ)
+        {
+            for (size_t i = 0; i < m_count; ++i) {
+                const Entry& entry = m_entries[i];
+                if (entry.fov.angleLeft == fov.angleLeft && entry.fov.angleRight == fov.angleRight && entry.fov.angleUp == fov.angleUp &&
+                    entry.fov.angleDown == fov.angleDown && entry.nearZ == nearZ && entry.farZ == farZ) {
+                    return entry.projection;
+                }
+            }
+
+            // Replace the oldest entry once full.
+            Entry& entry = m_entries[m_next];
+            m_next = (m_next + 1) % Capacity;
+            if (m_count < Capacity) {
+                ++m_count;
+            }
+            entry.fov = fov;
+            entry.nearZ = nearZ;
+            entry.farZ = farZ;
+            XrMatrix4x4f_CreateProjectionFov(&entry.projection, graphicsApi, fov, nearZ, farZ);
+            return entry.projection;
+        }
+
+    private:
+        struct Entry
+        {
+            XrFovf fov;
+            float nearZ;
+            float farZ;
+            XrMatrix4x4f projection;
+        };
+
+        std::array<Entry, Capacity> m_entries{};
+        size_t m_count{0};
+        size_t m_next{0};
+    };
+}  // namespace Conformance
@@ -58,8 +58,10 @@ namespace Conformance
                 ReportStr(buffer);
             }
             else {
-                std::string result(requiredStrlen, '\0');
-                std::vsnprintf(&result[0], result.size(), format, args);
+                // Reused by every long message of this thread, so formatting does not allocate once it has grown.
+                thread_local std::string result;
+                result.assign(requiredStrlen, '\0');
+                std::vsnprintf(&result[0], result.size() + 1, format, args);
                 ReportStr(result.c_str());
             }
         }
@@ -76,4 +78,129 @@ namespace Conformance
         va_end(args);
     }
 
+    BufferedReportSink::BufferedReportSink() : m_head(&m_stub), m_tail(&m_stub)
+    {
+    }
+
+    BufferedReportSink::~BufferedReportSink()
+    {
+        Stop();
+    }
+
+    void BufferedReportSink::Start(WriteFunction writeFunction)
+    {
+        m_writeFunction = std::move(writeFunction);
+        m_stopping = false;
+        m_running = true;
+        m_writer = std::thread(&BufferedReportSink::WriterThread, this);
+    }
+
+    void BufferedReportSink::Stop()
+    {
+        if (!m_running.exchange(false)) {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_messagePosted.notify_one();
+        m_writer.join();
+        m_writeFunction = nullptr;
+    }
+
+    bool BufferedReportSink::Post(int messageType, const char* message)
+    {
+        if (!m_running) {
+            return false;
+        }
+
+        Node* node = new Node;
+        node->messageType = messageType;
+        node->message = message;
+
+        // Counted before it is queued, so that Flush never returns while a message it counted is still queued.
+        m_postedCount.fetch_add(1);
+        Push(node);
+
+        if (m_writerWaiting) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_messagePosted.notify_one();
+        }
+        return true;
+    }
+
+    void BufferedReportSink::Flush()
+    {
+        if (!m_running) {
+            return;
+        }
+
+        const uint64_t target = m_postedCount.load();
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_messagesWritten.wait(lock, [&] { return m_writtenCount.load() >= target; });
+    }
+
+    void BufferedReportSink::Push(Node* node)
+    {
+        node->next.store(nullptr, std::memory_order_relaxed);
+        Node* previous = m_head.exchange(node);
+        previous->next.store(node);
+    }
+
+    BufferedReportSink::Node* BufferedReportSink::PopNode()
+    {
+        Node* tail = m_tail;
+        Node* next = tail->next.load();
+        if (tail == &m_stub) {
+            if (next == nullptr) {
+                return nullptr;
+            }
+            m_tail = next;
+            tail = next;
+            next = next->next.load();
+        }
+        if (next != nullptr) {
+            m_tail = next;
+            return tail;
+        }
+        if (tail != m_head.load()) {
+            return nullptr;  // A producer is between swapping m_head and linking its node; retry later.
+        }
+        // tail is the last node: put the stub behind it so that it can be handed out.
+        Push(&m_stub);
+        next = tail->next.load();
+        if (next != nullptr) {
+            m_tail = next;
+            return tail;
+        }
+        return nullptr;
+    }
+
+    void BufferedReportSink::WriterThread()
+    {
+        for (;;) {
+            while (Node* node = PopNode()) {
+                m_writeFunction(node->messageType, node->message.c_str());
+                delete node;
+                m_writtenCount.fetch_add(1);
+            }
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_messagesWritten.notify_all();
+
+            // Everything the write function was given has been written; as long as a posted message has not been,
+            // it is in the queue or about to be linked into it.
+            const auto allWritten = [&] { return m_writtenCount.load() == m_postedCount.load(); };
+            if (m_stopping && allWritten()) {
+                return;
+            }
+
+            m_writerWaiting = true;
+            m_messagePosted.wait(lock, [&] { return !allWritten() || m_stopping; });
+            m_writerWaiting = false;
+        }
+    }
+
 }  // namespace Conformance
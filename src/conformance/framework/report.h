@@ -17,9 +17,15 @@
 #pragma once
 
 #include <stdarg.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
 #include <iostream>
+#include <mutex>
 #include <streambuf>
 #include <functional>
+#include <string>
+#include <thread>
 
 namespace Conformance
 {
@@ -39,4 +45,64 @@ namespace Conformance
     // May include multiple lines separated by \n.
     // This function supplies the final newline.
     void ReportF(const char* format, ...);
+
+    // Moves console output off the threads that produce it. Post hands a message to a writer thread through a
+    // lock-free queue, and the writer passes the messages to the write function one at a time, in the order they
+    // were posted. Messages from one thread therefore stay in order, and messages from different threads are
+    // ordered as if the write function had been called directly.
+    class BufferedReportSink
+    {
+    public:
+        // messageType is passed through to the write function unchanged.
+        using WriteFunction = std::function<void(int messageType, const char* message)>;
+
+        BufferedReportSink();
+        BufferedReportSink(const BufferedReportSink&) = delete;
+        BufferedReportSink& operator=(const BufferedReportSink&) = delete;
+        ~BufferedReportSink();
+
+        // Starts the writer thread. Must not be called while already started.
+        void Start(WriteFunction writeFunction);
+
+        // Writes everything posted so far and stops the writer thread. Does nothing if not started.
+        void Stop();
+
+        // Returns false, and does nothing, if the sink is not started; the caller then writes the message itself.
+        bool Post(int messageType, const char* message);
+
+        // Blocks until every message posted before the call has been written.
+        void Flush();
+
+    private:
+        struct Node
+        {
+            std::atomic<Node*> next{nullptr};
+            int messageType{0};
+            std::string message;
+        };
+
+        void WriterThread();
+        Node* PopNode();  // Writer thread only.
+        void Push(Node* node);
+
+        // Intrusive multiple-producer single-consumer queue: producers swap themselves into m_head, and the writer
+        // follows the next links from m_tail. m_stub keeps the queue non-empty so that neither side needs a lock.
+        Node m_stub;
+        std::atomic<Node*> m_head;
+        Node* m_tail;
+
+        std::atomic<bool> m_running{false};
+        std::atomic<bool> m_stopping{false};
+        std::atomic<bool> m_writerWaiting{false};
+        std::atomic<uint64_t> m_postedCount{0};
+        std::atomic<uint64_t> m_writtenCount{0};
+
+        // Only taken to put the writer to sleep and wake it, or to wait for a flush.
+        std::mutex m_mutex;
+        std::condition_variable m_messagePosted;
+        std::condition_variable m_messagesWritten;
+
+        WriteFunction m_writeFunction;
+        std::thread m_writer;
+    };
 }  // namespace Conformance
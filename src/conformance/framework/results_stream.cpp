@@ -0,0 +1,372 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "results_stream.h"
+#include "utils.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__APPLE__)
+#include <sys/resource.h>
+#include <mach/mach.h>
+#else
+#include <cstdio>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+namespace Conformance
+{
+    namespace
+    {
+        void AppendJsonString(std::string& out, const char* value)
+        {
+            out += '"';
+            for (const char* c = value; *c != '\0'; ++c) {
+                switch (*c) {
+                case '"':
+                    out += "\\\"";
+                    break;
+                case '\\':
+                    out += "\\\\";
+                    break;
+                case '\n':
+                    out += "\\n";
+                    break;
+                case '\r':
+                    out += "\\r";
+                    break;
+                case '\t':
+                    out += "\\t";
+                    break;
+                default:
+                    if (static_cast<unsigned char>(*c) < 0x20) {
+                        AppendSprintf(out, "\\u%04x", static_cast<unsigned int>(static_cast<unsigned char>(*c)));
+                    }
+                    else {
+                        out += *c;
+                    }
+                    break;
+                }
+            }
+            out += '"';
+        }
+
+    }  // namespace
+
+    const char* FindJsonValue(const std::string& line, const char* key)
+    {
+        std::string quotedKey;
+        AppendJsonString(quotedKey, key);
+        quotedKey += ':';
+        const size_t position = line.find(quotedKey);
+        return position == std::string::npos ? nullptr : line.c_str() + position + quotedKey.size();
+    }
+
+    bool ParseJsonString(const char* c, std::string& value)
+    {
+        if (*c++ != '"') {
+            return false;
+        }
+        value.clear();
+        for (; *c != '"'; ++c) {
+            if (*c == '\0') {
+                return false;
+            }
+            if (*c != '\\') {
+                value += *c;
+                continue;
+            }
+            switch (*++c) {
+            case 'n':
+                value += '\n';
+                break;
+            case 'r':
+                value += '\r';
+                break;
+            case 't':
+                value += '\t';
+                break;
+            case 'u': {
+                // Only control characters are escaped this way.
+                char digits[5] = {};
+                for (int i = 0; i < 4; ++i) {
+                    if (c[1 + i] == '\0') {
+                        return false;
+                    }
+                    digits[i] = c[1 + i];
+                }
+                value += static_cast<char>(strtoul(digits, nullptr, 16));
+                c += 4;
+                break;
+            }
+            case '\0':
+                return false;
+            default:
+                value += *c;
+                break;
+            }
+        }
+        return true;
+    }
+
+    void JsonLine::AddKey(const char* key)
+    {
+        if (!m_members.empty()) {
+            m_members += ',';
+        }
+        AppendJsonString(m_members, key);
+        m_members += ':';
+    }
+
+    JsonLine& JsonLine::Add(const char* key, const char* value)
+    {
+        AddKey(key);
+        AppendJsonString(m_members, value);
+        return *this;
+    }
+
+    JsonLine& JsonLine::Add(const char* key, const std::string& value)
+    {
+        return Add(key, value.c_str());
+    }
+
+    JsonLine& JsonLine::Add(const char* key, uint64_t value)
+    {
+        AddKey(key);
+        m_members += std::to_string(value);
+        return *this;
+    }
+
+    JsonLine& JsonLine::Add(const char* key, double value)
+    {
+        AddKey(key);
+        AppendSprintf(m_members, "%.6f", value);
+        return *this;
+    }
+
+    JsonLine& JsonLine::Add(const char* key, bool value)
+    {
+        AddKey(key);
+        m_members += value ? "true" : "false";
+        return *this;
+    }
+
+    JsonLine& JsonLine::Add(const char* key, const std::vector<int64_t>& values)
+    {
+        AddKey(key);
+        m_members += '[';
+        for (size_t i = 0; i < values.size(); ++i) {
+            if (i != 0) {
+                m_members += ',';
+            }
+            m_members += std::to_string(values[i]);
+        }
+        m_members += ']';
+        return *this;
+    }
+
+    std::string JsonLine::String() const
+    {
+        return "{" + m_members + "}";
+    }
+
+    bool ResultsStream::Open(const std::string& path, bool append)
+    {
+        Close();
+        m_file.open(path, std::ios::out | (append ? std::ios::app : std::ios::trunc));
+        return m_file.is_open();
+    }
+
+    void ResultsStream::Close()
+    {
+        if (m_file.is_open()) {
+            m_file.close();
+        }
+    }
+
+    void ResultsStream::Write(const JsonLine& line)
+    {
+        if (m_file.is_open()) {
+            m_file << line.String() << std::endl;  // Flushes.
+        }
+    }
+
+    bool ReadTestCaseSeconds(const std::string& path, std::unordered_map<std::string, double>& testCaseSeconds)
+    {
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            return false;
+        }
+
+        std::string line;
+        std::string event;
+        std::string testCase;
+        while (std::getline(file, line)) {
+            const char* eventValue = FindJsonValue(line, "event");
+            if (eventValue == nullptr || !ParseJsonString(eventValue, event) || event != "testCaseEnded") {
+                continue;
+            }
+            const char* testCaseValue = FindJsonValue(line, "testCase");
+            const char* secondsValue = FindJsonValue(line, "seconds");
+            if (testCaseValue == nullptr || secondsValue == nullptr || !ParseJsonString(testCaseValue, testCase)) {
+                continue;
+            }
+            char* secondsEnd = nullptr;
+            const double seconds = strtod(secondsValue, &secondsEnd);
+            if (secondsEnd != secondsValue && seconds >= 0.0) {
+                testCaseSeconds[testCase] = seconds;
+            }
+        }
+        return true;
+    }
+
+    bool ReadTestCaseResults(const std::string& path, const std::string& fingerprint, std::unordered_map<std::string, bool>& testCasePassed)
+    {
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            return false;
+        }
+
+        std::string line;
+        std::string lineFingerprint;
+        std::string testCase;
+        while (std::getline(file, line)) {
+            const char* fingerprintValue = FindJsonValue(line, "fingerprint");
+            if (fingerprintValue == nullptr || !ParseJsonString(fingerprintValue, lineFingerprint) || lineFingerprint != fingerprint) {
+                continue;
+            }
+            const char* testCaseValue = FindJsonValue(line, "testCase");
+            const char* passedValue = FindJsonValue(line, "passed");
+            if (testCaseValue == nullptr || passedValue == nullptr || !ParseJsonString(testCaseValue, testCase)) {
+                continue;
+            }
+            testCasePassed[testCase] = strncmp(passedValue, "true", 4) == 0;
+        }
+        return true;
+    }
+
+    bool ReadBenchmarkSamples(const std::string& path, std::map<std::string, std::vector<int64_t>>& samplesByMetric)
+    {
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            return false;
+        }
+
+        std::string line;
+        std::string event;
+        std::string testCase;
+        std::string label;
+        while (std::getline(file, line)) {
+            const char* eventValue = FindJsonValue(line, "event");
+            if (eventValue == nullptr || !ParseJsonString(eventValue, event) || event != "benchmarkSamples") {
+                continue;
+            }
+            const char* testCaseValue = FindJsonValue(line, "testCase");
+            const char* labelValue = FindJsonValue(line, "label");
+            const char* samplesValue = FindJsonValue(line, "nanoseconds");
+            if (testCaseValue == nullptr || labelValue == nullptr || samplesValue == nullptr || *samplesValue != '[' ||
+                !ParseJsonString(testCaseValue, testCase) || !ParseJsonString(labelValue, label)) {
+                continue;
+            }
+
+            // Only a line that holds the whole array counts, not one cut short by a crash.
+            std::vector<int64_t> samples;
+            const char* c = samplesValue + 1;
+            bool complete = *c == ']';
+            while (!complete) {
+                char* end = nullptr;
+                const long long sample = strtoll(c, &end, 10);
+                if (end == c) {
+                    break;
+                }
+                samples.push_back(static_cast<int64_t>(sample));
+                c = end;
+                if (*c == ',') {
+                    ++c;
+                }
+                else {
+                    complete = *c == ']';
+                    if (!complete) {
+                        break;
+                    }
+                }
+            }
+            if (complete) {
+                std::vector<int64_t>& metric = samplesByMetric[testCase + ": " + label];
+                metric.insert(metric.end(), samples.begin(), samples.end());
+            }
+        }
+        return true;
+    }
+
+    uint64_t GetPeakResidentBytes()
+    {
+#if defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS counters{};
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+            return counters.PeakWorkingSetSize;
+        }
+        return 0;
+#else
+        struct rusage usage {};
+        if (getrusage(RUSAGE_SELF, &usage) != 0) {
+            return 0;
+        }
+#if defined(__APPLE__)
+        return static_cast<uint64_t>(usage.ru_maxrss);  // Already in bytes.
+#else
+        return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+    }
+
+    uint64_t GetResidentBytes()
+    {
+#if defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS counters{};
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+            return counters.WorkingSetSize;
+        }
+        return 0;
+#elif defined(__APPLE__)
+        mach_task_basic_info info{};
+        mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+        if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) != KERN_SUCCESS) {
+            return 0;
+        }
+        return static_cast<uint64_t>(info.resident_size);
+#else
+        // The second field of statm is the resident set size in pages.
+        FILE* statm = fopen("/proc/self/statm", "r");
+        if (statm == nullptr) {
+            return 0;
+        }
+        unsigned long long totalPages = 0;
+        unsigned long long residentPages = 0;
+        const int fieldCount = fscanf(statm, "%llu %llu", &totalPages, &residentPages);
+        fclose(statm);
+        if (fieldCount != 2) {
+            return 0;
+        }
+        return static_cast<uint64_t>(residentPages) * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+#endif
+    }
+}  // namespace Conformance
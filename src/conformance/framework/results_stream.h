@@ -0,0 +1,97 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Conformance
+{
+    // Builds one JSON object, member by member, for a ResultsStream line.
+    class JsonLine
+    {
+    public:
+        JsonLine& Add(const char* key, const char* value);
+        JsonLine& Add(const char* key, const std::string& value);
+        JsonLine& Add(const char* key, uint64_t value);
+        JsonLine& Add(const char* key, double value);
+        JsonLine& Add(const char* key, bool value);
+        JsonLine& Add(const char* key, const std::vector<int64_t>& values);
+
+        // Returns the object text, without a trailing newline.
+        std::string String() const;
+
+    private:
+        void AddKey(const char* key);
+
+        std::string m_members;
+    };
+
+    // Writes test progress as JSON lines: one object per line, each flushed as soon as it is written, so that a
+    // run which crashes or is killed still leaves everything up to the last completed line behind.
+    class ResultsStream
+    {
+    public:
+        // Creates or truncates the file, or with append adds to the end of it. Returns false if it could not be opened.
+        bool Open(const std::string& path, bool append = false);
+
+        void Close();
+
+        bool IsOpen() const
+        {
+            return m_file.is_open();
+        }
+
+        // Does nothing if the stream is not open.
+        void Write(const JsonLine& line);
+
+    private:
+        std::ofstream m_file;
+    };
+
+    // Finds the value of a top-level member of a line written by JsonLine, returning the position just past the colon,
+    // or nullptr when the key is not there.
+    const char* FindJsonValue(const std::string& line, const char* key);
+
+    // Parses a JSON string as JsonLine writes it. Returns false if it is malformed or not terminated.
+    bool ParseJsonString(const char* c, std::string& value);
+
+    // Reads the testCaseEnded lines of a results stream written by an earlier run and sets the seconds of every test
+    // case they name; a later line for the same test case replaces an earlier one. Lines that do not parse, such as
+    // one cut short by a crash, are skipped. Returns false if the file could not be opened.
+    bool ReadTestCaseSeconds(const std::string& path, std::unordered_map<std::string, double>& testCaseSeconds);
+
+    // Reads the lines of an --incremental results file that carry the given fingerprint and sets whether every test
+    // case they name passed; a later line for the same test case replaces an earlier one. Returns false if the file
+    // could not be opened.
+    bool ReadTestCaseResults(const std::string& path, const std::string& fingerprint,
+                             std::unordered_map<std::string, bool>& testCasePassed);
+
+    // Reads the benchmarkSamples lines of a results stream and appends their samples to those already there for the
+    // same test case and label, keyed "<test case>: <label>". Returns false if the file could not be opened.
+    bool ReadBenchmarkSamples(const std::string& path, std::map<std::string, std::vector<int64_t>>& samplesByMetric);
+
+    // Returns the peak resident memory of this process so far, or 0 if the platform does not report it.
+    uint64_t GetPeakResidentBytes();
+
+    // Returns the current resident memory of this process, or 0 if the platform does not report it.
+    uint64_t GetResidentBytes();
+}  // namespace Conformance
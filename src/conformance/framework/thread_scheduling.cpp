@@ -0,0 +1,388 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "thread_scheduling.h"
+#include "report.h"
+#include "utils.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#if defined(__linux__)
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace Conformance
+{
+    namespace
+    {
+        // Each kind of refusal is reported once, since every frame loop and worker would otherwise repeat it.
+        std::atomic<bool> g_affinityFailureReported{false};
+        std::atomic<bool> g_priorityFailureReported{false};
+
+        void ReportOnce(std::atomic<bool>& reported, const std::string& message)
+        {
+            if (!reported.exchange(true)) {
+                ReportF("Thread scheduling: %s", message.c_str());
+            }
+        }
+
+        const char* PriorityName(ThreadPriority priority)
+        {
+            switch (priority) {
+            case ThreadPriority::High:
+                return "High";
+            case ThreadPriority::Realtime:
+                return "Realtime";
+            default:
+                return "Normal";
+            }
+        }
+
+        // The CPUs with the highest cpuinfo_max_freq, or none if the kernel does not expose it.
+        std::vector<uint32_t> FindBigCores()
+        {
+            std::vector<uint32_t> cpus;
+#if defined(__linux__)
+            const long cpuCount = sysconf(_SC_NPROCESSORS_CONF);
+            unsigned long maxFrequency = 0;
+            for (long cpu = 0; cpu < cpuCount; ++cpu) {
+                char path[96];
+                snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%ld/cpufreq/cpuinfo_max_freq", cpu);
+                FILE* file = fopen(path, "r");
+                if (file == nullptr) {
+                    continue;
+                }
+                unsigned long frequency = 0;
+                const bool read = fscanf(file, "%lu", &frequency) == 1;
+                fclose(file);
+                if (!read || frequency < maxFrequency) {
+                    continue;
+                }
+                if (frequency > maxFrequency) {
+                    maxFrequency = frequency;
+                    cpus.clear();
+                }
+                cpus.push_back((uint32_t)cpu);
+            }
+#endif
+            return cpus;
+        }
+
+        // The number of CPUs the system is configured with, which bounds the CPU numbers an affinity may name.
+        uint32_t CpuCount()
+        {
+#if defined(__linux__)
+            const long cpuCount = sysconf(_SC_NPROCESSORS_CONF);
+            if (cpuCount > 0) {
+                return (uint32_t)cpuCount;
+            }
+#endif
+            const unsigned int threadCount = std::thread::hardware_concurrency();
+            return threadCount > 0 ? threadCount : 1024;
+        }
+
+        std::vector<uint32_t> ResolveCpus(const ThreadScheduling& scheduling)
+        {
+            return scheduling.bigCores ? FindBigCores() : scheduling.cpus;
+        }
+
+        std::string DescribeCpus(const std::vector<uint32_t>& cpus)
+        {
+            std::string result;
+            for (uint32_t cpu : cpus) {
+                AppendSprintf(result, result.empty() ? "%u" : ",%u", cpu);
+            }
+            return result;
+        }
+    }  // namespace
+
+    bool ParseThreadAffinity(const std::string& text, ThreadScheduling& scheduling)
+    {
+        if (striequal(text.c_str(), "big")) {
+            scheduling.cpus.clear();
+            scheduling.bigCores = true;
+            return true;
+        }
+
+        const uint32_t cpuCount = CpuCount();
+        std::vector<uint32_t> cpus;
+        const char* c = text.c_str();
+        while (*c != '\0') {
+            char* end = nullptr;
+            const unsigned long first = strtoul(c, &end, 10);
+            if (end == c) {
+                return false;
+            }
+            unsigned long last = first;
+            c = end;
+            if (*c == '-') {
+                ++c;
+                last = strtoul(c, &end, 10);
+                if (end == c || last < first) {
+                    return false;
+                }
+                c = end;
+            }
+            if (last >= cpuCount) {
+                return false;  // Also keeps a range such as 0-4000000000 from listing billions of CPUs.
+            }
+            for (unsigned long cpu = first; cpu <= last; ++cpu) {
+                cpus.push_back((uint32_t)cpu);
+            }
+            if (*c == ',') {
+                ++c;
+            }
+            else if (*c != '\0') {
+                return false;
+            }
+        }
+        if (cpus.empty()) {
+            return false;
+        }
+        std::sort(cpus.begin(), cpus.end());
+        cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+        scheduling.cpus = cpus;
+        scheduling.bigCores = false;
+        return true;
+    }
+
+    bool ParseThreadPriority(const std::string& text, ThreadScheduling& scheduling)
+    {
+        if (striequal(text.c_str(), "normal")) {
+            scheduling.priority = ThreadPriority::Normal;
+        }
+        else if (striequal(text.c_str(), "high")) {
+            scheduling.priority = ThreadPriority::High;
+        }
+        else if (striequal(text.c_str(), "realtime")) {
+            scheduling.priority = ThreadPriority::Realtime;
+        }
+        else {
+            return false;
+        }
+        return true;
+    }
+
+    std::string DescribeThreadScheduling(const ThreadScheduling& scheduling)
+    {
+        std::string result;
+        if (scheduling.bigCores) {
+            const std::vector<uint32_t> cpus = FindBigCores();
+            AppendSprintf(result, "affinity big (CPUs %s), ", cpus.empty() ? "unknown" : DescribeCpus(cpus).c_str());
+        }
+        else if (!scheduling.cpus.empty()) {
+            AppendSprintf(result, "affinity CPUs %s, ", DescribeCpus(scheduling.cpus).c_str());
+        }
+        else {
+            result += "affinity unchanged, ";
+        }
+        AppendSprintf(result, "priority %s", PriorityName(scheduling.priority));
+        return result;
+    }
+
+#if defined(_WIN32)
+
+    struct ScopedThreadScheduling::SavedState
+    {
+        // A real handle to the thread the scheduling was applied to, as the destructor may run on another one.
+        HANDLE thread{nullptr};
+        DWORD_PTR affinityMask{0};
+        bool prioritySet{false};
+        int priority{THREAD_PRIORITY_NORMAL};
+    };
+
+    ScopedThreadScheduling::ScopedThreadScheduling(const ThreadScheduling& scheduling) : m_saved(new SavedState)
+    {
+        const HANDLE thread = GetCurrentThread();
+        m_saved->thread = OpenThread(THREAD_SET_INFORMATION | THREAD_QUERY_INFORMATION, FALSE, GetCurrentThreadId());
+        if (scheduling.bigCores) {
+            ReportOnce(g_affinityFailureReported, "big core affinity is only supported on Linux and Android.");
+        }
+        else if (!scheduling.cpus.empty()) {
+            DWORD_PTR mask = 0;
+            for (uint32_t cpu : scheduling.cpus) {
+                if (cpu < sizeof(DWORD_PTR) * 8) {
+                    mask |= DWORD_PTR(1) << cpu;
+                }
+            }
+            m_saved->affinityMask = mask == 0 ? 0 : SetThreadAffinityMask(thread, mask);
+            if (m_saved->affinityMask == 0) {
+                ReportOnce(g_affinityFailureReported, "SetThreadAffinityMask failed, affinity unchanged.");
+            }
+        }
+
+        if (scheduling.priority != ThreadPriority::Normal) {
+            const int priority = scheduling.priority == ThreadPriority::Realtime ? THREAD_PRIORITY_TIME_CRITICAL : THREAD_PRIORITY_HIGHEST;
+            m_saved->priority = GetThreadPriority(thread);
+            m_saved->prioritySet = SetThreadPriority(thread, priority) != FALSE;
+            if (!m_saved->prioritySet) {
+                ReportOnce(g_priorityFailureReported, "SetThreadPriority failed, priority unchanged.");
+            }
+        }
+    }
+
+    ScopedThreadScheduling::~ScopedThreadScheduling()
+    {
+        const HANDLE thread = m_saved->thread;
+        if (thread == nullptr) {
+            return;
+        }
+        if (m_saved->prioritySet) {
+            SetThreadPriority(thread, m_saved->priority);
+        }
+        if (m_saved->affinityMask != 0) {
+            SetThreadAffinityMask(thread, m_saved->affinityMask);
+        }
+        CloseHandle(thread);
+    }
+
+#else  // !defined(_WIN32)
+
+    struct ScopedThreadScheduling::SavedState
+    {
+        // The thread the scheduling was applied to, as the destructor may run on another one.
+#if defined(__linux__)
+        pid_t tid{0};
+#else
+        pthread_t thread{};
+#endif
+#if defined(__linux__)
+        bool affinitySet{false};
+        cpu_set_t affinity;
+        bool niceSet{false};
+        int nice{0};
+#endif
+        bool schedulerSet{false};
+        int policy{SCHED_OTHER};
+        sched_param param{};
+    };
+
+    ScopedThreadScheduling::ScopedThreadScheduling(const ThreadScheduling& scheduling) : m_saved(new SavedState)
+    {
+        const std::vector<uint32_t> cpus = ResolveCpus(scheduling);
+#if defined(__linux__)
+        m_saved->tid = (pid_t)syscall(SYS_gettid);
+#else
+        m_saved->thread = pthread_self();
+#endif
+#if defined(__linux__)
+        if (scheduling.bigCores && cpus.empty()) {
+            ReportOnce(g_affinityFailureReported, "no cpufreq information to find the big cores, affinity unchanged.");
+        }
+        else if (!cpus.empty()) {
+            // On Linux, pid 0 is the calling thread rather than the whole process.
+            cpu_set_t affinity;
+            CPU_ZERO(&affinity);
+            for (uint32_t cpu : cpus) {
+                if (cpu < CPU_SETSIZE) {
+                    CPU_SET(cpu, &affinity);
+                }
+            }
+            if (sched_getaffinity(0, sizeof(m_saved->affinity), &m_saved->affinity) == 0 &&
+                sched_setaffinity(0, sizeof(affinity), &affinity) == 0) {
+                m_saved->affinitySet = true;
+            }
+            else {
+                ReportOnce(g_affinityFailureReported, std::string("sched_setaffinity failed: ") + strerror(errno));
+            }
+        }
+
+        if (scheduling.priority == ThreadPriority::High) {
+            const pid_t tid = m_saved->tid;
+            errno = 0;
+            m_saved->nice = getpriority(PRIO_PROCESS, (id_t)tid);
+            if (errno == 0 && setpriority(PRIO_PROCESS, (id_t)tid, -10) == 0) {
+                m_saved->niceSet = true;
+            }
+            else {
+                ReportOnce(g_priorityFailureReported, std::string("setpriority failed: ") + strerror(errno));
+            }
+        }
+#else
+        if (!cpus.empty() || scheduling.bigCores) {
+            ReportOnce(g_affinityFailureReported, "thread affinity is not supported on this platform.");
+        }
+#endif
+
+        // Other POSIX platforms have no per-thread nice value, so High raises the thread within SCHED_OTHER.
+        bool setScheduler = scheduling.priority == ThreadPriority::Realtime;
+#if !defined(__linux__)
+        setScheduler = setScheduler || scheduling.priority == ThreadPriority::High;
+#endif
+        if (setScheduler) {
+            const int policy = scheduling.priority == ThreadPriority::Realtime ? SCHED_FIFO : SCHED_OTHER;
+            // Halfway up the range, so that the kernel's own real-time threads still run first.
+            sched_param param{};
+            const int minPriority = sched_get_priority_min(policy);
+            const int maxPriority = sched_get_priority_max(policy);
+            param.sched_priority = policy == SCHED_FIFO ? minPriority + (maxPriority - minPriority) / 2 : maxPriority;
+            int result = pthread_getschedparam(pthread_self(), &m_saved->policy, &m_saved->param);
+            if (result == 0) {
+                result = pthread_setschedparam(pthread_self(), policy, &param);
+            }
+            if (result == 0) {
+                m_saved->schedulerSet = true;
+            }
+            else {
+                ReportOnce(g_priorityFailureReported, std::string("pthread_setschedparam failed: ") + strerror(result));
+            }
+        }
+    }
+
+    ScopedThreadScheduling::~ScopedThreadScheduling()
+    {
+#if defined(__linux__)
+        // Linux schedules threads by their id, which the calls take from any thread. They fail harmlessly once the
+        // thread has exited.
+        const pid_t tid = m_saved->tid;
+        if (m_saved->schedulerSet) {
+            sched_setscheduler(tid, m_saved->policy, &m_saved->param);
+        }
+        if (m_saved->niceSet) {
+            setpriority(PRIO_PROCESS, (id_t)tid, m_saved->nice);
+        }
+        if (m_saved->affinitySet) {
+            sched_setaffinity(tid, sizeof(m_saved->affinity), &m_saved->affinity);
+        }
+#else
+        // A pthread_t may not be used once its thread has exited, so elsewhere only the thread itself can restore.
+        if (m_saved->schedulerSet) {
+            if (pthread_equal(pthread_self(), m_saved->thread)) {
+                pthread_setschedparam(m_saved->thread, m_saved->policy, &m_saved->param);
+            }
+            else {
+                ReportOnce(g_priorityFailureReported, "scheduling ended on another thread, priority left as it is.");
+            }
+        }
+#endif
+    }
+
+#endif  // !defined(_WIN32)
+}  // namespace Conformance
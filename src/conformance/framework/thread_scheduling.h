@@ -0,0 +1,78 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Conformance
+{
+    enum class ThreadPriority
+    {
+        Normal,
+        // Above other threads of the process: nice -10 on Linux and Android, THREAD_PRIORITY_HIGHEST on Windows.
+        High,
+        // SCHED_FIFO on POSIX platforms, THREAD_PRIORITY_TIME_CRITICAL on Windows. Usually needs privileges.
+        Realtime
+    };
+
+    // CPU affinity and scheduling priority for the threads that run frame loops or benchmark workers, so that
+    // measurements can be separated from scheduler noise. See Options::frameLoopScheduling and Options::workerScheduling.
+    struct ThreadScheduling
+    {
+        // The CPUs the thread may run on. Empty with bigCores false leaves the affinity as it is.
+        std::vector<uint32_t> cpus;
+        // Runs the thread on the CPUs with the highest maximum frequency, the big cores of a big.LITTLE SoC. Linux and
+        // Android only.
+        bool bigCores{false};
+        ThreadPriority priority{ThreadPriority::Normal};
+
+        bool IsDefault() const
+        {
+            return cpus.empty() && !bigCores && priority == ThreadPriority::Normal;
+        }
+    };
+
+    // Parses a CPU list such as "0,2-3", or "big". Returns false if it is malformed or names a CPU the system does not have.
+    bool ParseThreadAffinity(const std::string& text, ThreadScheduling& scheduling);
+
+    // Parses "Normal", "High" or "Realtime", in any case. Returns false for anything else.
+    bool ParseThreadPriority(const std::string& text, ThreadScheduling& scheduling);
+
+    // Describes the settings for the report, with the CPUs that "big" picks on this device.
+    std::string DescribeThreadScheduling(const ThreadScheduling& scheduling);
+
+    // Applies the scheduling to the calling thread while alive, and gives that thread back the affinity and priority it
+    // had when destroyed, even when destroyed on another thread; except on POSIX platforms other than Linux, which can
+    // only restore on the same thread. Settings the platform refuses, such as real-time priority without the privilege
+    // for it, are reported once and otherwise ignored.
+    class ScopedThreadScheduling
+    {
+    public:
+        explicit ScopedThreadScheduling(const ThreadScheduling& scheduling);
+        ~ScopedThreadScheduling();
+
+        ScopedThreadScheduling(const ScopedThreadScheduling&) = delete;
+        ScopedThreadScheduling& operator=(const ScopedThreadScheduling&) = delete;
+
+    private:
+        struct SavedState;
+        std::unique_ptr<SavedState> m_saved;
+    };
+}  // namespace Conformance
@@ -23,6 +23,7 @@
 
 #include "conformance_framework.h"
 
+#include <exception>
 #include <string>
 #include <vector>
 
@@ -63,56 +64,93 @@ namespace Conformance
             std::string callStart;
         };
 
-        /// Main workings of the two-call checker.
-        template <typename T, typename F, typename... Args>
-        inline std::vector<T> test(Catch::StringRef const& macroName, Strings const& strings, const Catch::SourceLineInfo& lineinfo,
-                                   Catch::ResultDisposition::Flags resultDisposition, T const& empty, F&& wrappedCall, Args&&... a)
+        /// Runs one call of the idiom as an assertion that it returns XR_SUCCESS. The assertion text is only built, by
+        /// describe, when the call fails or the reporter also shows passing assertions.
+        template <typename Call, typename Describe>
+        inline XrResult checkCall(Catch::StringRef const& macroName, Strings const& strings, const Catch::SourceLineInfo& lineinfo,
+                                  Catch::ResultDisposition::Flags resultDisposition, Call&& call, Describe&& describe)
         {
-            std::vector<T> ret;
-            uint32_t count = 0;
+            XrResult result = XR_ERROR_RUNTIME_FAILURE;
+            std::exception_ptr thrown;
+            try {
+                result = call();
+            }
+            catch (...) {
+                thrown = std::current_exception();
+            }
+
+            std::string name;
+            if (thrown || result != XR_SUCCESS || Catch::getCurrentContext().getConfig()->includeSuccessfulResults()) {
+                name = describe();
+            }
+
+            Catch::AssertionHandler catchAssertionHandler(macroName, lineinfo, name.empty() ? strings.expressionString : name,
+                                                          resultDisposition);
+            INTERNAL_CATCH_TRY
             {
-                std::string name = (Catch::ReusableStringStream() << strings.expressionString << " ) // count request call: "
-                                                                  << strings.callStart << "0, &count, nullptr")
-                                       .str();
-
-                Catch::AssertionHandler catchAssertionHandler(macroName, lineinfo, name, resultDisposition);
-                INTERNAL_CATCH_TRY
-                {
-                    auto result = wrappedCall(std::forward<Args>(a)..., 0, &count, nullptr);
-                    catchAssertionHandler.handleExpr(Catch::ExprLhs<XrResult>(XR_SUCCESS) == result);
+                if (thrown) {
+                    std::rethrow_exception(thrown);
                 }
-                INTERNAL_CATCH_CATCH(catchAssertionHandler)
-                INTERNAL_CATCH_REACT(catchAssertionHandler)
+                catchAssertionHandler.handleExpr(Catch::ExprLhs<XrResult>(XR_SUCCESS) == result);
             }
+            INTERNAL_CATCH_CATCH(catchAssertionHandler)
+            INTERNAL_CATCH_REACT(catchAssertionHandler)
+            return result;
+        }
+
+        /// Main workings of the two-call checker, filling a caller-provided buffer. The buffer keeps its capacity, so
+        /// reusing it across calls does not allocate once it is large enough.
+        template <typename T, typename F, typename... Args>
+        inline std::vector<T>& testInto(std::vector<T>& ret, Catch::StringRef const& macroName, Strings const& strings,
+                                        const Catch::SourceLineInfo& lineinfo, Catch::ResultDisposition::Flags resultDisposition,
+                                        T const& empty, F&& wrappedCall, Args&&... a)
+        {
+            ret.clear();
+            uint32_t count = 0;
+            checkCall(
+                macroName, strings, lineinfo, resultDisposition, [&] { return wrappedCall(a..., 0, &count, nullptr); },
+                [&] {
+                    return (Catch::ReusableStringStream() << strings.expressionString << " ) // count request call: " << strings.callStart
+                                                          << "0, &count, nullptr")
+                        .str();
+                });
 
             if (Catch::getResultCapture().lastAssertionPassed() && count > 0) {
-                std::string name = (Catch::ReusableStringStream() << strings.expressionString << " ) // buffer fill call: "
-                                                                  << strings.callStart << count << " /*capacity*/, &count, array")
-                                       .str();
-
-                Catch::AssertionHandler catchAssertionHandler(macroName, lineinfo, name, resultDisposition);
-                INTERNAL_CATCH_TRY
-                {
-                    // Allocate
-                    ret.resize(count, empty);
-
-                    // Perform call and handle assertion
-                    auto result = wrappedCall(std::forward<Args>(a)..., uint32_t(ret.size()), &count, ret.data());
-                    catchAssertionHandler.handleExpr(Catch::ExprLhs<XrResult>(XR_SUCCESS) == result);
-                    if (Catch::getResultCapture().lastAssertionPassed()) {
-                        // If success, resize to exact length.
-                        ret.resize(count);
-                    }
-                    else {
-                        // In case of error, clear return value
-                        ret.clear();
-                    }
+                const uint32_t capacity = count;
+                checkCall(
+                    macroName, strings, lineinfo, resultDisposition,
+                    [&] {
+                        // Allocate, if the buffer has not held this many before.
+                        ret.assign(capacity, empty);
+
+                        return wrappedCall(a..., capacity, &count, ret.data());
+                    },
+                    [&] {
+                        return (Catch::ReusableStringStream() << strings.expressionString << " ) // buffer fill call: " << strings.callStart
+                                                              << capacity << " /*capacity*/, &count, array")
+                            .str();
+                    });
+                if (Catch::getResultCapture().lastAssertionPassed()) {
+                    // If success, resize to exact length.
+                    ret.resize(count);
+                }
+                else {
+                    // In case of error, clear return value
+                    ret.clear();
                 }
-                INTERNAL_CATCH_CATCH(catchAssertionHandler)
-                INTERNAL_CATCH_REACT(catchAssertionHandler)
             }
             return ret;
         }
+
+        /// Main workings of the two-call checker.
+        template <typename T, typename F, typename... Args>
+        inline std::vector<T> test(Catch::StringRef const& macroName, Strings const& strings, const Catch::SourceLineInfo& lineinfo,
+                                   Catch::ResultDisposition::Flags resultDisposition, T const& empty, F&& wrappedCall, Args&&... a)
+        {
+            std::vector<T> ret;
+            testInto(ret, macroName, strings, lineinfo, resultDisposition, empty, std::forward<F>(wrappedCall), std::forward<Args>(a)...);
+            return ret;
+        }
     }  // namespace twocallimpl
 }  // namespace Conformance
 
@@ -123,11 +161,21 @@ namespace Conformance
         CATCH_REC_LIST(CATCH_INTERNAL_STRINGIFY, __VA_ARGS__) \
     }
 
-// Internal macro providing shared implementation between CHECK_TWO_CALL and REQUIRE_TWO_CALL
-#define INTERNAL_TEST_TWO_CALL(macroName, resultDisposition, STRINGS, TYPE, ...)                                                 \
-    [&] {                                                                                                                        \
-        return ::Conformance::twocallimpl::test<TYPE>(macroName##_catch_sr, STRINGS, CATCH_INTERNAL_LINEINFO, resultDisposition, \
-                                                      __VA_ARGS__);                                                              \
+// Internal macro providing shared implementation between CHECK_TWO_CALL and REQUIRE_TWO_CALL.
+// The strings only depend on the call site, so they are built once per call site.
+#define INTERNAL_TEST_TWO_CALL(macroName, resultDisposition, STRINGS, TYPE, ...)                                                  \
+    [&] {                                                                                                                         \
+        static const ::Conformance::twocallimpl::Strings twoCallStrings = STRINGS;                                                \
+        return ::Conformance::twocallimpl::test<TYPE>(macroName##_catch_sr, twoCallStrings, CATCH_INTERNAL_LINEINFO,              \
+                                                      resultDisposition, __VA_ARGS__);                                            \
+    }()
+
+// Internal macro providing shared implementation between CHECK_TWO_CALL_INTO and REQUIRE_TWO_CALL_INTO
+#define INTERNAL_TEST_TWO_CALL_INTO(macroName, resultDisposition, STRINGS, BUFFER, TYPE, ...)                                     \
+    [&]() -> std::vector<TYPE>& {                                                                                                 \
+        static const ::Conformance::twocallimpl::Strings twoCallStrings = STRINGS;                                                \
+        return ::Conformance::twocallimpl::testInto<TYPE>(BUFFER, macroName##_catch_sr, twoCallStrings, CATCH_INTERNAL_LINEINFO,  \
+                                                          resultDisposition, __VA_ARGS__);                                        \
     }()
 
     /*!
@@ -139,6 +187,9 @@ namespace Conformance
  * - An initializer for an empty single buffer element
  * - The name of the call
  * - Any additional arguments that should be passed **before**  the capacityInput, countOutput, and array parameters
+ *
+ * The _INTO variants take a std::vector<T> to fill first, and return a reference to it, so that a buffer reused
+ * across calls only allocates when it has to grow.
  */
     /// @{
 
@@ -151,6 +202,14 @@ namespace Conformance
 #define REQUIRE_TWO_CALL(TYPE, ...)                                                                                                      \
     INTERNAL_TEST_TWO_CALL("REQUIRE_TWO_CALL", Catch::ResultDisposition::Normal, (INTERNAL_TWO_CALL_STRINGIFY(TYPE, __VA_ARGS__)), TYPE, \
                            __VA_ARGS__)
+/// Like CHECK_TWO_CALL, but fills and returns the given buffer.
+#define CHECK_TWO_CALL_INTO(BUFFER, TYPE, ...)                                                         \
+    INTERNAL_TEST_TWO_CALL_INTO("CHECK_TWO_CALL_INTO", Catch::ResultDisposition::ContinueOnFailure, \
+                                (INTERNAL_TWO_CALL_STRINGIFY(TYPE, __VA_ARGS__)), BUFFER, TYPE, __VA_ARGS__)
+/// Like REQUIRE_TWO_CALL, but fills and returns the given buffer.
+#define REQUIRE_TWO_CALL_INTO(BUFFER, TYPE, ...)                                              \
+    INTERNAL_TEST_TWO_CALL_INTO("REQUIRE_TWO_CALL_INTO", Catch::ResultDisposition::Normal, \
+                                (INTERNAL_TWO_CALL_STRINGIFY(TYPE, __VA_ARGS__)), BUFFER, TYPE, __VA_ARGS__)
 #else
 /// Try a two-call idiom in "check" mode: failures are recorded but return an empty container.
 #define CHECK_TWO_CALL(TYPE, ...)                                                         \
@@ -160,5 +219,13 @@ namespace Conformance
 #define REQUIRE_TWO_CALL(TYPE, ...)                                              \
     INTERNAL_TEST_TWO_CALL("REQUIRE_TWO_CALL", Catch::ResultDisposition::Normal, \
                            INTERNAL_CATCH_EXPAND_VARGS(INTERNAL_TWO_CALL_STRINGIFY(TYPE, __VA_ARGS__)), TYPE, __VA_ARGS__)
+/// Like CHECK_TWO_CALL, but fills and returns the given buffer.
+#define CHECK_TWO_CALL_INTO(BUFFER, TYPE, ...)                                                         \
+    INTERNAL_TEST_TWO_CALL_INTO("CHECK_TWO_CALL_INTO", Catch::ResultDisposition::ContinueOnFailure, \
+                                INTERNAL_CATCH_EXPAND_VARGS(INTERNAL_TWO_CALL_STRINGIFY(TYPE, __VA_ARGS__)), BUFFER, TYPE, __VA_ARGS__)
+/// Like REQUIRE_TWO_CALL, but fills and returns the given buffer.
+#define REQUIRE_TWO_CALL_INTO(BUFFER, TYPE, ...)                                              \
+    INTERNAL_TEST_TWO_CALL_INTO("REQUIRE_TWO_CALL_INTO", Catch::ResultDisposition::Normal, \
+                                INTERNAL_CATCH_EXPAND_VARGS(INTERNAL_TWO_CALL_STRINGIFY(TYPE, __VA_ARGS__)), BUFFER, TYPE, __VA_ARGS__)
 #endif
 /// @}
@@ -27,6 +27,8 @@
 
 #ifdef _WIN32
 #include <windows.h>
+#else
+#include <unistd.h>
 #endif
 
 namespace Conformance
@@ -96,6 +98,30 @@ namespace Conformance
     {
     }
 
+    // Mixes the seed and stream index with the SplitMix64 finalizer, so that neighbouring seeds and streams do not
+    // start the engine in related states.
+    static uint64_t StreamSeed(uint64_t seed, uint64_t streamIndex)
+    {
+        uint64_t z = seed + 0x9E3779B97F4A7C15ull * (streamIndex + 1);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    RandEngine::RandEngine(uint64_t seed_, uint64_t streamIndex) : RandEngine(StreamSeed(seed_, streamIndex))
+    {
+    }
+
+    uint64_t RandEngine::StreamIndexFromName(const char* name)
+    {
+        // FNV-1a
+        uint64_t hash = 14695981039346656037ull;
+        for (; *name != '\0'; ++name) {
+            hash = (hash ^ static_cast<unsigned char>(*name)) * 1099511628211ull;
+        }
+        return hash;
+    }
+
     void RandEngine::SetSeed(uint64_t seed_)
     {
         std::unique_lock<std::mutex> lock(randEngineMutex);
@@ -227,6 +253,35 @@ namespace Conformance
         std::this_thread::sleep_for(std::chrono::milliseconds(ms));
     }
 
+    bool WriteFileReplacing(const std::string& path, const void* data, std::size_t size)
+    {
+        // Per process, so that processes writing the same file at once, such as the shards of a run, do not share one.
+#ifdef _WIN32
+        const unsigned long processId = GetCurrentProcessId();
+#else
+        const unsigned long processId = static_cast<unsigned long>(getpid());
+#endif
+        const std::string tempPath = path + "." + std::to_string(processId) + ".tmp";
+        FILE* file = fopen(tempPath.c_str(), "wb");
+        if (file == nullptr) {
+            return false;
+        }
+        const bool written = (size == 0 || fwrite(data, 1, size, file) == size);
+        if ((fclose(file) != 0) || !written) {
+            remove(tempPath.c_str());
+            return false;
+        }
+#ifdef _WIN32
+        if (!MoveFileExA(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+#else
+        if (rename(tempPath.c_str(), path.c_str()) != 0) {
+#endif
+            remove(tempPath.c_str());
+            return false;
+        }
+        return true;
+    }
+
     StringVec::StringVec(StringVec const& other)
     {
         for (auto& str : other) {
@@ -17,7 +17,10 @@
 #pragma once
 
 #include <stdarg.h>
+#include <algorithm>
+#include <initializer_list>
 #include <string>
+#include <utility>
 #include <vector>
 #include <cstdint>
 #include <cstddef>
@@ -250,6 +253,15 @@ namespace Conformance
     //
     void SleepMs(std::uint32_t ms);
 
+    // WriteFileReplacing
+    //
+    // Writes size bytes to a temporary file named after path and the process id, and then renames
+    // that over path, so that a concurrent reader or writer, or a run that stops part way, never
+    // sees a partially written file.
+    // Returns false if the file could not be written; path is then left as it was.
+    //
+    bool WriteFileReplacing(const std::string& path, const void* data, std::size_t size);
+
 // XRC_UTF8_EXERCISE_STR
 //
 // This is a specially crafted valid UTF8 string which has four Unicode code points,
@@ -277,6 +289,18 @@ namespace Conformance
         RandEngine();
         RandEngine(uint64_t seed);
 
+        // Constructs the streamIndex-th stream of seed. Engines for different streams of one seed produce unrelated
+        // sequences, so each thread or test can own one and stay reproducible however they interleave, without
+        // contending on a shared engine.
+        //
+        // Example usage:
+        //     RandEngine randEngine(GetGlobalData().GetRandEngine().GetSeed(), RandEngine::StreamIndexFromName("my test"));
+        //
+        RandEngine(uint64_t seed, uint64_t streamIndex);
+
+        // Returns a stable stream index for a name, such as that of a test case.
+        static uint64_t StreamIndexFromName(const char* name);
+
         // Sets the new seed, overriding whatever seed was set by the constructor.
         void SetSeed(uint64_t seed);
 
@@ -470,6 +494,50 @@ namespace Conformance
         inner strPtrVector;
     };
 
+    // EnumNameTable
+    //
+    // The enumerants of an enum and their names, as generated by the reflection macros, kept sorted by value so that
+    // a name is found by binary search over contiguous storage. Lookups return the stored C string, so they never
+    // allocate; this is on every failure-reporting path.
+    //
+    // Example usage:
+    //     const EnumNameTable<XrResult> resultNames{XR_LIST_ENUM_XrResult(XRC_ENUM_NAME_PAIR)};
+    //     const char* name = resultNames.Find(result, "<unknown>");
+    //
+    template <typename Enum>
+    class EnumNameTable
+    {
+    public:
+        using Entry = std::pair<Enum, const char*>;
+        using const_iterator = typename std::vector<Entry>::const_iterator;
+
+        EnumNameTable(std::initializer_list<Entry> entries) : m_entries(entries)
+        {
+            std::sort(m_entries.begin(), m_entries.end(), [](const Entry& a, const Entry& b) { return a.first < b.first; });
+        }
+
+        // Returns the name of value, or unknown if the table does not contain it.
+        const char* Find(Enum value, const char* unknown) const
+        {
+            auto it = std::lower_bound(m_entries.begin(), m_entries.end(), value,
+                                       [](const Entry& entry, Enum v) { return entry.first < v; });
+            return (it != m_entries.end() && it->first == value) ? it->second : unknown;
+        }
+
+        // Iterates the entries in order of value.
+        const_iterator begin() const
+        {
+            return m_entries.begin();
+        }
+        const_iterator end() const
+        {
+            return m_entries.end();
+        }
+
+    private:
+        std::vector<Entry> m_entries;
+    };
+
     struct Size2D
     {
         uint32_t w;
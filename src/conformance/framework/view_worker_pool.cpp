@@ -0,0 +1,105 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "view_worker_pool.h"
+#include "conformance_framework.h"
+
+namespace Conformance
+{
+    void ViewWorkerPool::Start(uint32_t threadCount)
+    {
+        Stop();
+        m_threads.reserve(threadCount);
+        for (uint32_t i = 0; i < threadCount; ++i) {
+            m_threads.emplace_back(&ViewWorkerPool::WorkerLoop, this, i, threadCount);
+        }
+    }
+
+    void ViewWorkerPool::Stop()
+    {
+        if (m_threads.empty()) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_wake.notify_all();
+        for (std::thread& thread : m_threads) {
+            thread.join();
+        }
+        m_threads.clear();
+        m_stopping = false;
+    }
+
+    void ViewWorkerPool::Run(uint32_t viewCount, const RecordView& record)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_viewCount = viewCount;
+            m_record = &record;
+            m_error = nullptr;
+            m_pending = (uint32_t)m_threads.size();
+            m_generation++;
+        }
+        m_wake.notify_all();
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait(lock, [&] { return m_pending == 0; });
+        m_record = nullptr;
+        if (m_error) {
+            std::rethrow_exception(m_error);
+        }
+    }
+
+    void ViewWorkerPool::WorkerLoop(uint32_t worker, uint32_t threadCount)
+    {
+        ATTACH_THREAD;
+        uint64_t generation = 0;
+        for (;;) {
+            uint32_t viewCount;
+            const RecordView* record;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wake.wait(lock, [&] { return m_stopping || m_generation != generation; });
+                if (m_stopping) {
+                    return;
+                }
+                generation = m_generation;
+                viewCount = m_viewCount;
+                record = m_record;
+            }
+
+            for (uint32_t view = worker; view < viewCount; view += threadCount) {
+                try {
+                    (*record)(worker, view);
+                }
+                catch (...) {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    if (!m_error) {
+                        m_error = std::current_exception();
+                    }
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (--m_pending == 0) {
+                m_done.notify_one();
+            }
+        }
+    }
+}  // namespace Conformance
@@ -0,0 +1,82 @@
+// Copyright (c) 2019-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Conformance
+{
+    /// Worker threads that a graphics plugin uses to record the views of one RenderViews call in parallel, for
+    /// Options::vulkanRecordThreads and Options::d3d11RecordThreads. Worker w records views w, w + ThreadCount(), and so
+    /// on, in order, so state that each worker owns needs no locking. Start and Stop must not overlap Run.
+    class ViewWorkerPool
+    {
+    public:
+        /// Records one view on the worker with the given index.
+        using RecordView = std::function<void(uint32_t worker, uint32_t view)>;
+
+        ViewWorkerPool() = default;
+        ViewWorkerPool(const ViewWorkerPool&) = delete;
+        ViewWorkerPool& operator=(const ViewWorkerPool&) = delete;
+
+        ~ViewWorkerPool()
+        {
+            Stop();
+        }
+
+        void Start(uint32_t threadCount);
+
+        /// Joins the workers. Does nothing if they are not running.
+        void Stop();
+
+        bool IsRunning() const
+        {
+            return !m_threads.empty();
+        }
+
+        uint32_t ThreadCount() const
+        {
+            return (uint32_t)m_threads.size();
+        }
+
+        /// Calls record for each of viewCount views on the workers and returns once all of them are done. Rethrows the
+        /// first exception a worker threw; the other views are still recorded.
+        void Run(uint32_t viewCount, const RecordView& record);
+
+    private:
+        void WorkerLoop(uint32_t worker, uint32_t threadCount);
+
+        std::vector<std::thread> m_threads;
+
+        // The current Run call, guarded by m_mutex.
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::condition_variable m_done;
+        uint64_t m_generation{0};
+        uint32_t m_viewCount{0};
+        const RecordView* m_record{nullptr};
+        uint32_t m_pending{0};
+        std::exception_ptr m_error;
+        bool m_stopping{false};
+    };
+}  // namespace Conformance
@@ -18,6 +18,9 @@
 #define PATH_PREFIX "/sdcard/"
 #endif
 
+// Written as the tests run unless debug.xr.conform.args has its own --resultsStream, see collect_android_results.py
+#define RESULTS_STREAM_PATH PATH_PREFIX "openxr_conformance_results.jsonl"
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
@@ -28,6 +31,9 @@
 #include <pthread.h>
 #include <sys/prctl.h>
 #include <sys/system_properties.h>
+#include <climits>
+#include <cstdlib>
+#include <mutex>
 #include <thread>
 #include <vector>
 
@@ -83,19 +89,186 @@ void* Conformance_Android_Get_Application_Activity()
     return AndroidApplicationActivity;
 }
 
+// Attaching to the VM is slow and serialized inside it, so each native thread attaches only the first time it asks.
+// The key's value is set on the threads attached here, and its destructor detaches them when they exit.
+static pthread_key_t AttachedThreadKey;
+static pthread_once_t AttachedThreadKeyOnce = PTHREAD_ONCE_INIT;
+
+static void DetachExitingThread(void* /* env */)
+{
+    ALOGV("DetachCurrentThread at thread exit");
+    AndroidApplicationVM->DetachCurrentThread();
+}
+
+static void CreateAttachedThreadKey()
+{
+    pthread_key_create(&AttachedThreadKey, DetachExitingThread);
+}
+
 void Conformance_Android_Attach_Current_Thread()
 {
+    pthread_once(&AttachedThreadKeyOnce, CreateAttachedThreadKey);
+    if (pthread_getspecific(AttachedThreadKey) != nullptr) {
+        return;
+    }
+
+    // Threads the VM created, or that attached themselves, are left for their owner to detach.
+    JNIEnv* Env = nullptr;
+    if (AndroidApplicationVM->GetEnv((void**)&Env, JNI_VERSION_1_6) == JNI_OK) {
+        return;
+    }
+
     ALOGV("AttachCurrentThread");
-    JNIEnv* Env;
-    AndroidApplicationVM->AttachCurrentThread(&Env, nullptr);
+    if (AndroidApplicationVM->AttachCurrentThread(&Env, nullptr) == JNI_OK) {
+        pthread_setspecific(AttachedThreadKey, Env);
+    }
 }
 
 void Conformance_Android_Detach_Current_Thread()
 {
+    pthread_once(&AttachedThreadKeyOnce, CreateAttachedThreadKey);
+    if (pthread_getspecific(AttachedThreadKey) == nullptr) {
+        return;
+    }
+
     ALOGV("DetachCurrentThread");
+    pthread_setspecific(AttachedThreadKey, nullptr);
     AndroidApplicationVM->DetachCurrentThread();
 }
 
+// The Java objects and methods that Conformance_Android_Read_Power calls, looked up on its first call and kept for the run.
+struct PowerQueries
+{
+    bool initialized{false};
+    jobject batteryManager{nullptr};
+    jmethodID getIntProperty{nullptr};
+    jobject batteryChangedFilter{nullptr};
+    jmethodID registerReceiver{nullptr};
+    jmethodID getIntExtra{nullptr};
+    jobject powerManager{nullptr};
+    jmethodID getCurrentThermalStatus{nullptr};
+};
+static std::mutex AndroidPowerQueriesMutex;
+static PowerQueries AndroidPowerQueries;
+
+static bool ClearJniException(JNIEnv* Env)
+{
+    if (!Env->ExceptionCheck()) {
+        return false;
+    }
+    Env->ExceptionClear();
+    return true;
+}
+
+static jobject NewGlobalSystemService(JNIEnv* Env, jclass contextClass, const char* name)
+{
+    jmethodID getSystemService = Env->GetMethodID(contextClass, "getSystemService", "(Ljava/lang/String;)Ljava/lang/Object;");
+    jstring serviceName = Env->NewStringUTF(name);
+    jobject service = Env->CallObjectMethod(AndroidApplicationActivity, getSystemService, serviceName);
+    Env->DeleteLocalRef(serviceName);
+    if (ClearJniException(Env) || service == nullptr) {
+        return nullptr;
+    }
+    jobject globalService = Env->NewGlobalRef(service);
+    Env->DeleteLocalRef(service);
+    return globalService;
+}
+
+static void InitializePowerQueries(JNIEnv* Env, PowerQueries& queries)
+{
+    jclass contextClass = Env->FindClass("android/content/Context");
+    jclass batteryManagerClass = Env->FindClass("android/os/BatteryManager");
+    jclass intentFilterClass = Env->FindClass("android/content/IntentFilter");
+    jclass intentClass = Env->FindClass("android/content/Intent");
+    jclass powerManagerClass = Env->FindClass("android/os/PowerManager");
+    // These are all framework classes, which every thread's class loader finds.
+    if (ClearJniException(Env)) {
+        return;
+    }
+
+    queries.batteryManager = NewGlobalSystemService(Env, contextClass, "batterymanager");
+    queries.getIntProperty = Env->GetMethodID(batteryManagerClass, "getIntProperty", "(I)I");
+
+    // The voltage is only in the sticky ACTION_BATTERY_CHANGED intent, which registering a null receiver returns.
+    jmethodID intentFilterConstructor = Env->GetMethodID(intentFilterClass, "<init>", "(Ljava/lang/String;)V");
+    jstring batteryChanged = Env->NewStringUTF("android.intent.action.BATTERY_CHANGED");
+    jobject filter = Env->NewObject(intentFilterClass, intentFilterConstructor, batteryChanged);
+    Env->DeleteLocalRef(batteryChanged);
+    if (!ClearJniException(Env) && filter != nullptr) {
+        queries.batteryChangedFilter = Env->NewGlobalRef(filter);
+        Env->DeleteLocalRef(filter);
+    }
+    queries.registerReceiver =
+        Env->GetMethodID(contextClass, "registerReceiver", "(Landroid/content/BroadcastReceiver;Landroid/content/IntentFilter;)"
+                                                           "Landroid/content/Intent;");
+    queries.getIntExtra = Env->GetMethodID(intentClass, "getIntExtra", "(Ljava/lang/String;I)I");
+    ClearJniException(Env);
+
+    // PowerManager.getCurrentThermalStatus is API level 29.
+    queries.powerManager = NewGlobalSystemService(Env, contextClass, "power");
+    queries.getCurrentThermalStatus = Env->GetMethodID(powerManagerClass, "getCurrentThermalStatus", "()I");
+    if (ClearJniException(Env)) {
+        queries.getCurrentThermalStatus = nullptr;
+    }
+
+    Env->DeleteLocalRef(contextClass);
+    Env->DeleteLocalRef(batteryManagerClass);
+    Env->DeleteLocalRef(intentFilterClass);
+    Env->DeleteLocalRef(intentClass);
+    Env->DeleteLocalRef(powerManagerClass);
+}
+
+bool Conformance_Android_Read_Power(double* watts, int32_t* thermalStatus)
+{
+    Conformance_Android_Attach_Current_Thread();
+    JNIEnv* Env = nullptr;
+    if (AndroidApplicationVM->GetEnv((void**)&Env, JNI_VERSION_1_6) != JNI_OK) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(AndroidPowerQueriesMutex);
+    if (!AndroidPowerQueries.initialized) {
+        AndroidPowerQueries.initialized = true;
+        InitializePowerQueries(Env, AndroidPowerQueries);
+    }
+    const PowerQueries& queries = AndroidPowerQueries;
+    if (queries.batteryManager == nullptr || queries.getIntProperty == nullptr || queries.batteryChangedFilter == nullptr ||
+        queries.registerReceiver == nullptr || queries.getIntExtra == nullptr) {
+        return false;
+    }
+
+    // BatteryManager.BATTERY_PROPERTY_CURRENT_NOW, in microamperes. The sign depends on the device, so only the magnitude
+    // is used; devices that do not measure it return Integer.MIN_VALUE or 0.
+    constexpr jint BATTERY_PROPERTY_CURRENT_NOW = 2;
+    const jint microamperes = Env->CallIntMethod(queries.batteryManager, queries.getIntProperty, BATTERY_PROPERTY_CURRENT_NOW);
+    if (ClearJniException(Env) || microamperes == INT_MIN || microamperes == 0) {
+        return false;
+    }
+
+    jobject batteryStatus =
+        Env->CallObjectMethod(AndroidApplicationActivity, queries.registerReceiver, nullptr, queries.batteryChangedFilter);
+    if (ClearJniException(Env) || batteryStatus == nullptr) {
+        return false;
+    }
+    jstring voltageExtra = Env->NewStringUTF("voltage");  // BatteryManager.EXTRA_VOLTAGE, in millivolts.
+    const jint millivolts = Env->CallIntMethod(batteryStatus, queries.getIntExtra, voltageExtra, 0);
+    Env->DeleteLocalRef(voltageExtra);
+    Env->DeleteLocalRef(batteryStatus);
+    if (ClearJniException(Env) || millivolts <= 0) {
+        return false;
+    }
+
+    *watts = std::abs((double)microamperes) * 1e-6 * millivolts * 1e-3;
+    *thermalStatus = -1;
+    if (queries.powerManager != nullptr && queries.getCurrentThermalStatus != nullptr) {
+        const jint status = Env->CallIntMethod(queries.powerManager, queries.getCurrentThermalStatus);
+        if (!ClearJniException(Env)) {
+            *thermalStatus = status;
+        }
+    }
+    return true;
+}
+
 /**
  * Process the next main command.
  */
@@ -302,11 +475,14 @@ void android_main(struct android_app* app)
                         }
                     }
                     bool hasGfxFlag = false;
+                    bool hasResultsStream = false;
                     for (int i = 0; i < (int)args.size(); i++) {
                         std::string s = args[i];
                         if (s == "-G") {
                             hasGfxFlag = true;
-                            break;
+                        }
+                        else if (s == "--resultsStream") {
+                            hasResultsStream = true;
                         }
                     }
                     if (hasGfxFlag == false) {
@@ -314,6 +490,13 @@ void android_main(struct android_app* app)
                         args.push_back("OpenGLES");
                     }
 
+                    // Stream structured results to a file that is flushed line by line, rather than relying on
+                    // logcat, which drops lines on long runs. The host can follow it while the tests run.
+                    if (hasResultsStream == false) {
+                        args.push_back("--resultsStream");
+                        args.push_back(RESULTS_STREAM_PATH);
+                    }
+
                     if (reportXml) {
                         args.push_back("-r");
                         args.push_back("xml");
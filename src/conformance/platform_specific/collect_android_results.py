@@ -0,0 +1,90 @@
+#!/usr/bin/python3
+#
+# Copyright (c) 2019-2022, The Khronos Group Inc.
+#
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Follows the results stream of a conformance run on an Android device and copies it to the host.
+
+The Android driver writes one JSON object per line to its results stream, flushing every line. This
+follows that file over adb while the tests run, appending each line to a local file as soon as it
+arrives, and stops after the testRunEnded line. If the device or adb goes away the local file still
+holds every line received so far.
+
+Start the collector before launching the tests: it removes the results of any previous run from the
+device first, so that their testRunEnded line is not mistaken for this run's, and then waits for the
+file to appear. Pass --keep-existing to collect a run that is already in progress or finished.
+"""
+
+import argparse
+import json
+import subprocess
+import sys
+
+DEFAULT_DEVICE_PATH = '/sdcard/openxr_conformance_results.jsonl'
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('output', help='local file to write the JSON lines to')
+    parser.add_argument('-s', '--serial', help='device serial, passed to adb -s')
+    parser.add_argument('--device-path', default=DEFAULT_DEVICE_PATH,
+                        help='results stream on the device (default: %(default)s)')
+    parser.add_argument('--append', action='store_true', help='append to the output file instead of truncating it')
+    parser.add_argument('--keep-existing', action='store_true',
+                        help='collect the results already on the device instead of removing them first')
+    parser.add_argument('-q', '--quiet', action='store_true', help='do not print a line per finished test case')
+    args = parser.parse_args()
+
+    adb = ['adb']
+    if args.serial:
+        adb += ['-s', args.serial]
+    if not args.keep_existing:
+        subprocess.check_call(adb + ['shell', 'rm', '-f', args.device_path])
+    # -F waits for the file to be created and follows it by name should the app be relaunched.
+    tail = subprocess.Popen(adb + ['exec-out', 'tail', '-n', '+1', '-F', args.device_path],
+                            stdout=subprocess.PIPE, stderr=subprocess.DEVNULL)
+
+    run_ended = False
+    line_count = 0
+    with open(args.output, 'a' if args.append else 'w') as out:
+        for raw in tail.stdout:
+            line = raw.decode('utf-8', errors='replace').rstrip('\r\n')
+            if not line:
+                continue
+            out.write(line + '\n')
+            out.flush()
+            line_count += 1
+
+            try:
+                event = json.loads(line)
+            except ValueError:
+                # Only a line cut short by a crash on the device can fail to parse; keep it, readers can skip it.
+                continue
+            if event.get('event') == 'testCaseEnded' and not args.quiet:
+                print('{} {} ({:.1f} s)'.format('passed' if event.get('passed') else 'FAILED', event.get('testCase', '?'),
+                                                 event.get('seconds', 0.0)))
+            elif event.get('event') == 'testRunEnded':
+                run_ended = True
+                break
+
+    tail.terminate()
+    tail.wait()
+    print('{} lines written to {}{}'.format(line_count, args.output, '' if run_ended else ' (run did not finish)'))
+    return 0 if run_ended else 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -11,7 +11,9 @@
 
 #include "loader_interfaces.h"
 #include "loader_logger.hpp"
+#include "loader_parallel.hpp"
 #include "loader_platform.hpp"
+#include "loader_startup_profile.hpp"
 #include "manifest_file.hpp"
 #include "platform_utils.hpp"
 
@@ -26,6 +28,31 @@
 
 #define OPENXR_ENABLE_LAYERS_ENV_VAR "XR_ENABLE_API_LAYERS"
 
+namespace {
+// An API layer library opened ahead of negotiation, along with the platform error if opening it failed.
+struct PreopenedLayerLibrary {
+    LoaderPlatformLibraryHandle handle = nullptr;
+    std::string open_error;
+};
+}  // namespace
+
+// Open the libraries of all the layers to be loaded.  Opening one layer does not depend on any other, so this
+// is done in parallel; negotiation, which calls into the layers, then happens in layer order on this thread.
+static std::vector<PreopenedLayerLibrary> OpenApiLayerLibraries(
+    const std::vector<std::unique_ptr<ApiLayerManifestFile>>& manifest_files) {
+    std::vector<PreopenedLayerLibrary> libraries(manifest_files.size());
+    LoaderParallelFor(manifest_files.size(), [&](size_t index) {
+        const std::string& library_path = manifest_files[index]->LibraryPath();
+        LoaderStartupTimer timer("open layer", manifest_files[index]->LayerName());
+        libraries[index].handle = LoaderPlatformLibraryOpen(library_path);
+        if (nullptr == libraries[index].handle) {
+            // The platform error is per-thread so it has to be fetched on the thread that failed.
+            libraries[index].open_error = LoaderPlatformLibraryOpenError(library_path);
+        }
+    });
+    return libraries;
+}
+
 // Add any layers defined in the loader layer environment variable.
 static void AddEnvironmentApiLayers(std::vector<std::string>& enabled_layers) {
     std::string layers = PlatformUtilsGetEnv(OPENXR_ENABLE_LAYERS_ENV_VAR);
@@ -191,20 +218,18 @@ XrResult ApiLayerInterface::LoadApiLayers(const std::string& openxr_command, uin
     std::vector<std::unique_ptr<ApiLayerManifestFile>> enabled_layer_manifest_files_in_init_order = {};
 
     // Find any implicit layers.
-    XrResult result =
-        ApiLayerManifestFile::FindManifestFiles(MANIFEST_TYPE_IMPLICIT_API_LAYER, enabled_layer_manifest_files_in_init_order);
+    XrResult result;
+    {
+        LoaderStartupTimer timer("find implicit layer manifests");
+        result = ApiLayerManifestFile::FindManifestFiles(MANIFEST_TYPE_IMPLICIT_API_LAYER, enabled_layer_manifest_files_in_init_order);
+    }
 
     for (const auto& enabled_layer_manifest_file : enabled_layer_manifest_files_in_init_order) {
         layers_already_found.insert(enabled_layer_manifest_file->LayerName());
     }
 
-    // Find any explicit layers.
     std::vector<std::unique_ptr<ApiLayerManifestFile>> explicit_layer_manifest_files = {};
 
-    if (XR_SUCCEEDED(result)) {
-        result = ApiLayerManifestFile::FindManifestFiles(MANIFEST_TYPE_EXPLICIT_API_LAYER, explicit_layer_manifest_files);
-    }
-
     bool found_all_layers = true;
 
     if (XR_SUCCEEDED(result)) {
@@ -228,9 +253,20 @@ XrResult ApiLayerInterface::LoadApiLayers(const std::string& openxr_command, uin
                       std::back_inserter(enabled_explicit_api_layer_names));
         }
 
+        // Find the explicit layers, validating only the manifests of the layers to enable.
+        if (!enabled_explicit_api_layer_names.empty()) {
+            const std::unordered_set<std::string> wanted_layer_names(enabled_explicit_api_layer_names.begin(),
+                                                                     enabled_explicit_api_layer_names.end());
+            LoaderStartupTimer timer("find explicit layer manifests");
+            result = ApiLayerManifestFile::FindManifestFiles(MANIFEST_TYPE_EXPLICIT_API_LAYER, explicit_layer_manifest_files,
+                                                             &wanted_layer_names);
+        }
+
         // add explicit layers to list of layers to enable
         for (const auto& layer_name : enabled_explicit_api_layer_names) {
-            bool found_this_layer = false;
+            // Only the manifests of enabled explicit layers are kept, so a layer already enabled implicitly may have no
+            // explicit manifest left to match against.
+            bool found_this_layer = layers_already_found.count(layer_name) > 0;
 
             for (auto it = explicit_layer_manifest_files.begin(); it != explicit_layer_manifest_files.end();) {
                 bool erased_layer_manifest_file = false;
@@ -260,13 +296,16 @@ XrResult ApiLayerInterface::LoadApiLayers(const std::string& openxr_command, uin
         }
     }
 
-    for (std::unique_ptr<ApiLayerManifestFile>& manifest_file : enabled_layer_manifest_files_in_init_order) {
-        LoaderPlatformLibraryHandle layer_library = LoaderPlatformLibraryOpen(manifest_file->LibraryPath());
+    std::vector<PreopenedLayerLibrary> layer_libraries = OpenApiLayerLibraries(enabled_layer_manifest_files_in_init_order);
+
+    for (size_t layer_index = 0; layer_index < enabled_layer_manifest_files_in_init_order.size(); ++layer_index) {
+        std::unique_ptr<ApiLayerManifestFile>& manifest_file = enabled_layer_manifest_files_in_init_order[layer_index];
+        LoaderPlatformLibraryHandle layer_library = layer_libraries[layer_index].handle;
         if (nullptr == layer_library) {
             if (!any_loaded) {
                 last_error = XR_ERROR_FILE_ACCESS_ERROR;
             }
-            std::string library_message = LoaderPlatformLibraryOpenError(manifest_file->LibraryPath());
+            const std::string& library_message = layer_libraries[layer_index].open_error;
             std::string warning_message = "ApiLayerInterface::LoadApiLayers skipping layer ";
             warning_message += manifest_file->LayerName();
             warning_message += ", failed to load with message \"";
@@ -307,7 +346,11 @@ XrResult ApiLayerInterface::LoadApiLayers(const std::string& openxr_command, uin
         api_layer_info.structVersion = XR_API_LAYER_INFO_STRUCT_VERSION;
         api_layer_info.structSize = sizeof(XrNegotiateApiLayerRequest);
 
-        XrResult res = negotiate(&loader_info, manifest_file->LayerName().c_str(), &api_layer_info);
+        XrResult res;
+        {
+            LoaderStartupTimer timer("negotiate layer", manifest_file->LayerName());
+            res = negotiate(&loader_info, manifest_file->LayerName().c_str(), &api_layer_info);
+        }
         // If we supposedly succeeded, but got a nullptr for getInstanceProcAddr
         // then something still went wrong, so return with an error.
         if (XR_SUCCEEDED(res) && nullptr == api_layer_info.getInstanceProcAddr) {
@@ -339,16 +382,11 @@ XrResult ApiLayerInterface::LoadApiLayers(const std::string& openxr_command, uin
 
         // Grab the list of extensions this layer supports for easy filtering after the
         // xrCreateInstance call
-        std::vector<std::string> supported_extensions;
         std::vector<XrExtensionProperties> extension_properties;
         manifest_file->GetInstanceExtensionProperties(extension_properties);
-        supported_extensions.reserve(extension_properties.size());
-        for (XrExtensionProperties& ext_prop : extension_properties) {
-            supported_extensions.emplace_back(ext_prop.extensionName);
-        }
 
         // Add this API layer to the vector
-        api_layer_interfaces.emplace_back(new ApiLayerInterface(manifest_file->LayerName(), layer_library, supported_extensions,
+        api_layer_interfaces.emplace_back(new ApiLayerInterface(manifest_file->LayerName(), layer_library, extension_properties,
                                                                 api_layer_info.getInstanceProcAddr,
                                                                 api_layer_info.createApiLayerInstance));
 
@@ -371,14 +409,17 @@ XrResult ApiLayerInterface::LoadApiLayers(const std::string& openxr_command, uin
 }
 
 ApiLayerInterface::ApiLayerInterface(const std::string& layer_name, LoaderPlatformLibraryHandle layer_library,
-                                     std::vector<std::string>& supported_extensions,
+                                     const std::vector<XrExtensionProperties>& supported_extensions,
                                      PFN_xrGetInstanceProcAddr get_instance_proc_addr,
                                      PFN_xrCreateApiLayerInstance create_api_layer_instance)
     : _layer_name(layer_name),
       _layer_library(layer_library),
       _get_instance_proc_addr(get_instance_proc_addr),
-      _create_api_layer_instance(create_api_layer_instance),
-      _supported_extensions(supported_extensions) {}
+      _create_api_layer_instance(create_api_layer_instance) {
+    for (const XrExtensionProperties& ext_prop : supported_extensions) {
+        _supported_extensions.Insert(ext_prop.extensionName);
+    }
+}
 
 ApiLayerInterface::~ApiLayerInterface() {
     std::string info_message = "ApiLayerInterface being destroyed for layer ";
@@ -387,13 +428,4 @@ ApiLayerInterface::~ApiLayerInterface() {
     LoaderPlatformLibraryClose(_layer_library);
 }
 
-bool ApiLayerInterface::SupportsExtension(const std::string& extension_name) const {
-    bool found_prop = false;
-    for (const std::string& supported_extension : _supported_extensions) {
-        if (supported_extension == extension_name) {
-            found_prop = true;
-            break;
-        }
-    }
-    return found_prop;
-}
+bool ApiLayerInterface::SupportsExtension(const char* extension_name) const { return _supported_extensions.Contains(extension_name); }
@@ -15,6 +15,7 @@
 
 #include <openxr/openxr.h>
 
+#include "extension_registry.h"
 #include "loader_platform.hpp"
 #include "loader_interfaces.h"
 
@@ -33,22 +34,22 @@ class ApiLayerInterface {
                                                    std::vector<XrExtensionProperties>& extension_properties);
 
     ApiLayerInterface(const std::string& layer_name, LoaderPlatformLibraryHandle layer_library,
-                      std::vector<std::string>& supported_extensions, PFN_xrGetInstanceProcAddr get_instance_proc_addr,
+                      const std::vector<XrExtensionProperties>& supported_extensions, PFN_xrGetInstanceProcAddr get_instance_proc_addr,
                       PFN_xrCreateApiLayerInstance create_api_layer_instance);
     virtual ~ApiLayerInterface();
 
     PFN_xrGetInstanceProcAddr GetInstanceProcAddrFuncPointer() { return _get_instance_proc_addr; }
     PFN_xrCreateApiLayerInstance GetCreateApiLayerInstanceFuncPointer() { return _create_api_layer_instance; }
 
-    std::string LayerName() { return _layer_name; }
+    const std::string& LayerName() const { return _layer_name; }
 
     // Generated methods
-    bool SupportsExtension(const std::string& extension_name) const;
+    bool SupportsExtension(const char* extension_name) const;
 
    private:
     std::string _layer_name;
     LoaderPlatformLibraryHandle _layer_library;
     PFN_xrGetInstanceProcAddr _get_instance_proc_addr;
     PFN_xrCreateApiLayerInstance _create_api_layer_instance;
-    std::vector<std::string> _supported_extensions;
+    XrExtensionNameSet _supported_extensions;
 };
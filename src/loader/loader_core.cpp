@@ -18,12 +18,14 @@
 #include "loader_logger_recorders.hpp"
 #include "loader_logger.hpp"
 #include "loader_platform.hpp"
+#include "loader_startup_profile.hpp"
 #include "runtime_interface.hpp"
 #include "xr_generated_dispatch_table.h"
 #include "xr_generated_loader.hpp"
 
 #include <openxr/openxr.h>
 
+#include <chrono>
 #include <cstring>
 #include <memory>
 #include <mutex>
@@ -33,7 +35,8 @@
 #include <vector>
 
 // Global loader lock to:
-//   1. Ensure ActiveLoaderInstance get and set operations are done atomically.
+//   1. Ensure an ActiveLoaderInstance::IsAvailable check and the Set or Remove that follows it are done atomically.
+//      ActiveLoaderInstance::Get itself is lock-free, so the per-call trampolines do not take this lock.
 //   2. Ensure RuntimeInterface isn't used to unload the runtime while the runtime is in use.
 std::mutex &GetGlobalLoaderMutex() {
     static std::mutex loader_mutex;
@@ -236,6 +239,7 @@ static XRAPI_ATTR XrResult XRAPI_CALL LoaderXrCreateInstance(const XrInstanceCre
 
     // Make sure the ActiveLoaderInstance::IsAvailable check is done atomically with RuntimeInterface::LoadRuntime.
     std::unique_lock<std::mutex> instance_lock(GetGlobalLoaderMutex());
+    const auto startup_begin = std::chrono::steady_clock::now();
 
     // Check if there is already an XrInstance that is alive. If so, another instance cannot be created.
     // The loader does not support multiple simultaneous instances because the loader is intended to be
@@ -310,6 +314,11 @@ static XRAPI_ATTR XrResult XRAPI_CALL LoaderXrCreateInstance(const XrInstanceCre
         LoaderLogger::LogVerboseMessage("xrCreateInstance", "Completed loader trampoline");
     }
 
+    if (LoaderStartupProfile::IsEnabled()) {
+        LoaderStartupProfile::Record("xrCreateInstance", {}, std::chrono::steady_clock::now() - startup_begin);
+        LoaderStartupProfile::Report("xrCreateInstance", XR_SUCCEEDED(result));
+    }
+
     return result;
 }
 XRLOADER_ABI_CATCH_FALLBACK
@@ -353,6 +362,9 @@ static XRAPI_ATTR XrResult XRAPI_CALL LoaderXrDestroyInstance(XrInstance instanc
     // Finally, unload the runtime if necessary
     RuntimeInterface::UnloadRuntime("xrDestroyInstance");
 
+    // Make sure everything logged for this instance has been written out.
+    FlushLoaderLogRecorderOutput();
+
     return XR_SUCCESS;
 }
 XRLOADER_ABI_CATCH_FALLBACK
@@ -652,7 +664,6 @@ XRAPI_ATTR XrResult XRAPI_CALL LoaderXrTermCreateDebugUtilsMessengerEXT(XrInstan
     }
     if (XR_SUCCEEDED(result)) {
         LoaderLogger::GetInstance().AddLogRecorderForXrInstance(instance, MakeDebugUtilsLoaderLogRecorder(createInfo, *messenger));
-        RuntimeInterface::GetRuntime().TrackDebugMessenger(instance, *messenger);
     }
     LoaderLogger::LogVerboseMessage("xrCreateDebugUtilsMessengerEXT", "Completed loader terminator");
     return result;
@@ -664,7 +675,6 @@ XRAPI_ATTR XrResult XRAPI_CALL LoaderXrTermDestroyDebugUtilsMessengerEXT(XrDebug
     const XrGeneratedDispatchTable *dispatch_table = RuntimeInterface::GetDebugUtilsMessengerDispatchTable(messenger);
     XrResult result = XR_SUCCESS;
     LoaderLogger::GetInstance().RemoveLogRecorder(MakeHandleGeneric(messenger));
-    RuntimeInterface::GetRuntime().ForgetDebugMessenger(messenger);
     // This extension is supported entirely by the loader which means the runtime may or may not support it.
     if (nullptr != dispatch_table->DestroyDebugUtilsMessengerEXT) {
         result = dispatch_table->DestroyDebugUtilsMessengerEXT(messenger);
@@ -806,6 +816,14 @@ XRAPI_ATTR XrResult XRAPI_CALL LoaderXrGetInstanceProcAddr(XrInstance instance,
         return XR_SUCCESS;
     }
 
+    // The dispatch table was populated from the topmost xrGetInstanceProcAddr when the instance was created,
+    // so any entry it holds is exactly what the layer chain would return. Empty entries still go down the
+    // chain so the caller gets the same error the layers or runtime would report.
+    *function = LoaderLookUpDispatchTable(loader_instance->DispatchTable().get(), name);
+    if (*function != nullptr) {
+        return XR_SUCCESS;
+    }
+
     // If the function is not supported by the loader, call down to the next layer.
     return loader_instance->GetInstanceProcAddr(name, function);
 }
@@ -14,15 +14,18 @@
 #include "loader_instance.hpp"
 
 #include "api_layer_interface.hpp"
+#include "exception_handling.hpp"
 #include "hex_and_handles.h"
 #include "loader_interfaces.h"
 #include "loader_logger.hpp"
+#include "loader_startup_profile.hpp"
 #include "runtime_interface.hpp"
 #include "xr_generated_dispatch_table.h"
 #include "xr_generated_loader.hpp"
 
 #include <openxr/openxr.h>
 
+#include <atomic>
 #include <cstring>
 #include <memory>
 #include <sstream>
@@ -31,25 +34,29 @@
 #include <vector>
 
 namespace {
-std::unique_ptr<LoaderInstance>& GetSetCurrentLoaderInstance() {
-    static std::unique_ptr<LoaderInstance> current_loader_instance;
-    return current_loader_instance;
-}
+// Owns the active LoaderInstance while it is set. Constant initialized, so it is usable before any static constructor runs.
+std::atomic<LoaderInstance*> g_current_loader_instance{nullptr};
 }  // namespace
 
 namespace ActiveLoaderInstance {
+namespace detail {
+std::atomic<const XrGeneratedDispatchTable*> g_dispatch_table{nullptr};
+}  // namespace detail
+
 XrResult Set(std::unique_ptr<LoaderInstance> loader_instance, const char* log_function_name) {
-    if (GetSetCurrentLoaderInstance() != nullptr) {
+    LoaderInstance* expected = nullptr;
+    if (!g_current_loader_instance.compare_exchange_strong(expected, loader_instance.get(), std::memory_order_acq_rel)) {
         LoaderLogger::LogErrorMessage(log_function_name, "Active XrInstance handle already exists");
         return XR_ERROR_LIMIT_REACHED;
     }
 
-    GetSetCurrentLoaderInstance() = std::move(loader_instance);
+    detail::g_dispatch_table.store(loader_instance->DispatchTable().get(), std::memory_order_release);
+    loader_instance.release();
     return XR_SUCCESS;
 }
 
 XrResult Get(LoaderInstance** loader_instance, const char* log_function_name) {
-    *loader_instance = GetSetCurrentLoaderInstance().get();
+    *loader_instance = g_current_loader_instance.load(std::memory_order_acquire);
     if (*loader_instance == nullptr) {
         LoaderLogger::LogErrorMessage(log_function_name, "No active XrInstance handle.");
         return XR_ERROR_HANDLE_INVALID;
@@ -58,9 +65,18 @@ XrResult Get(LoaderInstance** loader_instance, const char* log_function_name) {
     return XR_SUCCESS;
 }
 
-bool IsAvailable() { return GetSetCurrentLoaderInstance() != nullptr; }
+bool IsAvailable() { return g_current_loader_instance.load(std::memory_order_acquire) != nullptr; }
+
+XrResult NoActiveInstance(const char* log_function_name) XRLOADER_ABI_TRY {
+    LoaderLogger::LogErrorMessage(log_function_name, "No active XrInstance handle.");
+    return XR_ERROR_HANDLE_INVALID;
+}
+XRLOADER_ABI_CATCH_FALLBACK
 
-void Remove() { GetSetCurrentLoaderInstance().release(); }
+void Remove() {
+    detail::g_dispatch_table.store(nullptr, std::memory_order_release);
+    g_current_loader_instance.store(nullptr, std::memory_order_release);
+}
 }  // namespace ActiveLoaderInstance
 
 // Extensions that are supported by the loader, but may not be supported
@@ -243,10 +259,12 @@ XrResult LoaderInstance::CreateInstance(PFN_xrGetInstanceProcAddr get_instance_p
             api_layer_ci.nextInfo = next_info_list.get();
             //! @todo do we filter our create info extension list here?
             //! Think that actually each layer might need to filter...
+            LoaderStartupTimer timer("create instance through layers");
             last_error = topmost_cali_fp(modified_create_info, &api_layer_ci, &instance);
 
         } else {
             // The loader's terminator is the topmost CreateInstance if there are no layers.
+            LoaderStartupTimer timer("create instance");
             last_error = create_instance_term(modified_create_info, &instance);
         }
 
@@ -281,9 +299,11 @@ LoaderInstance::LoaderInstance(XrInstance instance, const XrInstanceCreateInfo*
       _dispatch_table(new XrGeneratedDispatchTable{}) {
     for (uint32_t ext = 0; ext < create_info->enabledExtensionCount; ++ext) {
         _enabled_extensions.push_back(create_info->enabledExtensionNames[ext]);
+        _enabled_extension_set.Insert(create_info->enabledExtensionNames[ext]);
     }
 
-    GeneratedXrPopulateDispatchTable(_dispatch_table.get(), instance, topmost_gipa);
+    LoaderStartupTimer timer("populate dispatch table");
+    LoaderPopulateDispatchTable(_dispatch_table.get(), instance, topmost_gipa, _enabled_extensions);
 }
 
 LoaderInstance::~LoaderInstance() {
@@ -294,6 +314,10 @@ LoaderInstance::~LoaderInstance() {
 }
 
 bool LoaderInstance::ExtensionIsEnabled(const std::string& extension) {
+    const size_t index = XrExtensionIndexFromName(extension.c_str());
+    if (index != kXrExtensionCount) {
+        return _enabled_extension_set.Contains(index);
+    }
     for (std::string& cur_enabled : _enabled_extensions) {
         if (cur_enabled == extension) {
             return true;
@@ -9,12 +9,14 @@
 
 #pragma once
 
+#include "extension_registry.h"
 #include "extra_algorithms.h"
 #include "loader_interfaces.h"
 
 #include <openxr/openxr.h>
 
 #include <array>
+#include <atomic>
 #include <cmath>
 #include <memory>
 #include <mutex>
@@ -27,6 +29,11 @@ struct XrGeneratedDispatchTable;
 class LoaderInstance;
 
 // Manage the single loader instance that is available.
+//
+// The active instance is published through an atomic pointer, so Get, IsAvailable and GetDispatchTable take no lock and
+// may be called from any thread. Set and Remove are called with the global loader mutex held by xrCreateInstance and
+// xrDestroyInstance. A removed LoaderInstance is never freed, so a reader that raced with Remove still points at live
+// memory; calling other functions on an instance while it is being destroyed is an application error in any case.
 namespace ActiveLoaderInstance {
 // Set the active loader instance. This will fail if there is already an active loader instance.
 XrResult Set(std::unique_ptr<LoaderInstance> loader_instance, const char* log_function_name);
@@ -39,6 +46,18 @@ XrResult Get(LoaderInstance** loader_instance, const char* log_function_name);
 
 // Destroy the currently active LoaderInstance if there is one. This will make the loader able to create a new XrInstance if needed.
 void Remove();
+
+namespace detail {
+extern std::atomic<const XrGeneratedDispatchTable*> g_dispatch_table;
+}  // namespace detail
+
+// The dispatch table of the active LoaderInstance, or nullptr if there is none. Cached when the instance is set so the
+// per-frame trampolines reach the next function in the chain with one load, no call and no exception guard.
+inline const XrGeneratedDispatchTable* GetDispatchTable() { return detail::g_dispatch_table.load(std::memory_order_acquire); }
+
+// Logs that there is no active instance and returns XR_ERROR_HANDLE_INVALID. The cold path for GetDispatchTable callers;
+// it catches its own exceptions so they need no guard.
+XrResult NoActiveInstance(const char* log_function_name);
 };  // namespace ActiveLoaderInstance
 
 // Manages information needed by the loader for an XrInstance, such as what extensions are available and the dispatch table.
@@ -69,6 +88,8 @@ class LoaderInstance {
     XrInstance _runtime_instance{XR_NULL_HANDLE};
     PFN_xrGetInstanceProcAddr _topmost_gipa{nullptr};
     std::vector<std::string> _enabled_extensions;
+    // The same extensions as _enabled_extensions, for those known to this build; lets ExtensionIsEnabled skip the string compares.
+    XrExtensionSet _enabled_extension_set;
     std::vector<std::unique_ptr<ApiLayerInterface>> _api_layer_interfaces;
 
     std::unique_ptr<XrGeneratedDispatchTable> _dispatch_table;
@@ -17,6 +17,7 @@
 #include <openxr/openxr.h>
 
 #include <algorithm>
+#include <cstdlib>
 #include <iterator>
 #include <memory>
 #include <mutex>
@@ -26,6 +27,43 @@
 #include <utility>
 #include <vector>
 
+namespace {
+// Hands out this thread's reusable T, so that the containers in it keep their capacity from one message to the
+// next.  A recorder callback that logs again while the outer message is still being delivered gets a fresh T.
+template <typename T>
+class ThreadScratch {
+   public:
+    ThreadScratch() : _use_scratch(!InUse()) {
+        if (_use_scratch) {
+            InUse() = true;
+        }
+    }
+    ~ThreadScratch() {
+        if (_use_scratch) {
+            InUse() = false;
+        }
+    }
+
+    ThreadScratch(const ThreadScratch&) = delete;
+    ThreadScratch& operator=(const ThreadScratch&) = delete;
+
+    T& Get() { return _use_scratch ? Scratch() : _nested; }
+
+   private:
+    static bool& InUse() {
+        thread_local bool in_use = false;
+        return in_use;
+    }
+    static T& Scratch() {
+        thread_local T scratch;
+        return scratch;
+    }
+
+    bool _use_scratch;
+    T _nested;
+};
+}  // namespace
+
 bool LoaderLogRecorder::LogDebugUtilsMessage(XrDebugUtilsMessageSeverityFlagsEXT /*message_severity*/,
                                              XrDebugUtilsMessageTypeFlagsEXT /*message_type*/,
                                              const XrDebugUtilsMessengerCallbackDataEXT* /*callback_data*/) {
@@ -134,17 +172,30 @@ LoaderLogger::LoaderLogger() {
         }
         AddLogRecorder(MakeStdOutLoaderLogRecorder(nullptr, debug_flags));
     }
+
+    // If the ring buffer is asked for, keep every message in memory and only write them out when an error is logged.
+    std::string ring_string = PlatformUtilsGetEnv("XR_LOADER_LOG_RING");
+    if (!ring_string.empty()) {
+        size_t record_count = static_cast<size_t>(std::strtoul(ring_string.c_str(), nullptr, 10));
+        if (record_count == 0) {
+            record_count = 1024;
+        }
+        record_count = std::min(record_count, static_cast<size_t>(65536));
+        AddLogRecorder(MakeRingBufferLoaderLogRecorder(record_count));
+    }
 }
 
 void LoaderLogger::AddLogRecorder(std::unique_ptr<LoaderLogRecorder>&& recorder) {
     std::unique_lock<std::shared_timed_mutex> lock(_mutex);
     _recorders.push_back(std::move(recorder));
+    UpdateRecorderMasks();
 }
 
 void LoaderLogger::AddLogRecorderForXrInstance(XrInstance instance, std::unique_ptr<LoaderLogRecorder>&& recorder) {
     std::unique_lock<std::shared_timed_mutex> lock(_mutex);
     _recordersByInstance[instance].insert(recorder->UniqueId());
     _recorders.emplace_back(std::move(recorder));
+    UpdateRecorderMasks();
 }
 
 void LoaderLogger::RemoveLogRecorder(uint64_t unique_id) {
@@ -157,6 +208,7 @@ void LoaderLogger::RemoveLogRecorder(uint64_t unique_id) {
             messengersForInstance.erase(unique_id);
         }
     }
+    UpdateRecorderMasks();
 }
 
 void LoaderLogger::RemoveLogRecordersForXrInstance(XrInstance instance) {
@@ -167,18 +219,38 @@ void LoaderLogger::RemoveLogRecordersForXrInstance(XrInstance instance) {
             return recorders.find(recorder->UniqueId()) != recorders.end();
         });
         _recordersByInstance.erase(instance);
+        UpdateRecorderMasks();
     }
 }
 
+void LoaderLogger::UpdateRecorderMasks() {
+    XrLoaderLogMessageSeverityFlags severities = 0;
+    XrLoaderLogMessageTypeFlags types = 0;
+    for (const std::unique_ptr<LoaderLogRecorder>& recorder : _recorders) {
+        severities |= recorder->MessageSeverities();
+        types |= recorder->MessageTypes();
+    }
+    _recorder_severities.store(severities, std::memory_order_relaxed);
+    _recorder_types.store(types, std::memory_order_relaxed);
+}
+
 bool LoaderLogger::LogMessage(XrLoaderLogMessageSeverityFlagBits message_severity, XrLoaderLogMessageTypeFlags message_type,
                               const std::string& message_id, const std::string& command_name, const std::string& message,
                               const std::vector<XrSdkLogObjectInfo>& objects) {
+    // No recorder can accept a message that shares no bit with the combined masks.
+    if ((_recorder_severities.load(std::memory_order_relaxed) & message_severity) == 0 ||
+        (_recorder_types.load(std::memory_order_relaxed) & message_type) == 0) {
+        return false;
+    }
+
     XrLoaderLogMessengerCallbackData callback_data = {};
     callback_data.message_id = message_id.c_str();
     callback_data.command_name = command_name.c_str();
     callback_data.message = message.c_str();
 
-    auto names_and_labels = data_.PopulateNamesAndLabels(objects);
+    ThreadScratch<NamesAndLabels> scratch;
+    NamesAndLabels& names_and_labels = scratch.Get();
+    data_.PopulateNamesAndLabels(objects, names_and_labels);
     callback_data.objects = names_and_labels.sdk_objects.empty() ? nullptr : names_and_labels.sdk_objects.data();
     callback_data.object_count = static_cast<uint8_t>(names_and_labels.objects.size());
 
@@ -204,7 +276,8 @@ bool LoaderLogger::LogDebugUtilsMessage(XrDebugUtilsMessageSeverityFlagsEXT mess
     XrLoaderLogMessageSeverityFlags log_message_severity = DebugUtilsSeveritiesToLoaderLogMessageSeverities(message_severity);
     XrLoaderLogMessageTypeFlags log_message_type = DebugUtilsMessageTypesToLoaderLogMessageTypes(message_type);
 
-    AugmentedCallbackData augmented_data;
+    ThreadScratch<AugmentedCallbackData> scratch;
+    AugmentedCallbackData& augmented_data = scratch.Get();
     data_.WrapCallbackData(&augmented_data, callback_data);
 
     // Loop through the recorders
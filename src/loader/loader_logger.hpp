@@ -9,6 +9,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -59,6 +60,7 @@ enum XrLoaderLogType {
     XR_LOADER_LOG_DEBUG_UTILS,
     XR_LOADER_LOG_DEBUGGER,
     XR_LOADER_LOG_LOGCAT,
+    XR_LOADER_LOG_RING_BUFFER,
 };
 
 class LoaderLogRecorder {
@@ -174,8 +176,16 @@ class LoaderLogger {
    private:
     LoaderLogger();
 
+    // Recomputes the combined masks below; must be called with _mutex held exclusively.
+    void UpdateRecorderMasks();
+
     std::shared_timed_mutex _mutex;
 
+    // Union of the severities and types of every recorder, so messages that no recorder accepts can be
+    // dropped before any callback data is built.
+    std::atomic<XrLoaderLogMessageSeverityFlags> _recorder_severities{0};
+    std::atomic<XrLoaderLogMessageTypeFlags> _recorder_types{0};
+
     // List of *all* available recorder objects (including created specifically for an Instance)
     std::vector<std::unique_ptr<LoaderLogRecorder>> _recorders;
 
@@ -14,12 +14,33 @@
 
 #include <openxr/openxr.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 #include <iostream>
 #include <sstream>
 
+// Stream, logcat and debugger output is written from a background thread.  Windows is left out because
+// joining a thread while the loader DLL is unloaded can deadlock on the loader lock, and the thread can't be
+// started safely without exception handling.
+#if !defined(_WIN32) && !defined(XRLOADER_DISABLE_EXCEPTION_HANDLING)
+#define XR_LOADER_ASYNC_LOG_OUTPUT
+#endif
+
+#ifdef XR_LOADER_ASYNC_LOG_OUTPUT
+#include <condition_variable>
+#include <deque>
+#include <iterator>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#endif  // XR_LOADER_ASYNC_LOG_OUTPUT
+
 #ifdef __ANDROID__
 #include "android/log.h"
 #endif
@@ -68,17 +89,182 @@ void OutputMessageToStream(std::ostream& os, XrLoaderLogMessageSeverityFlagBits
     }
 }
 
-// With std::cerr: Standard Error logger, always on for now
-// With std::cout: Standard Output logger used with XR_LOADER_DEBUG
-class OstreamLoaderLogRecorder : public LoaderLogRecorder {
+// Writes an already formatted message to its destination.  The context always refers to something that
+// lives for the whole process (a standard stream), so queued messages never outlive their destination.
+typedef void (*LogOutputFunction)(void* context, XrLoaderLogMessageSeverityFlagBits message_severity, const std::string& text);
+
+#ifdef XR_LOADER_ASYNC_LOG_OUTPUT
+// Moves the blocking I/O of the output recorders onto a background thread.  Messages are queued in a bounded
+// queue and written in batches; a full queue makes the logging thread wait rather than drop messages.  Errors
+// are often the last thing logged before a crash or abort, so the thread logging one waits until it, and
+// everything queued before it, has been written.
+class AsyncLogOutput {
    public:
-    OstreamLoaderLogRecorder(std::ostream& os, void* user_data, XrLoaderLogMessageSeverityFlags flags);
+    static AsyncLogOutput& Get() {
+        static AsyncLogOutput instance;
+        return instance;
+    }
+
+    void Write(LogOutputFunction output, void* context, XrLoaderLogMessageSeverityFlagBits message_severity, std::string&& text);
+
+    // Waits until every message queued so far has been written.
+    void Flush();
+
+   private:
+    struct Entry {
+        LogOutputFunction output;
+        void* context;
+        XrLoaderLogMessageSeverityFlagBits message_severity;
+        std::string text;
+    };
+
+    static const size_t kMaxQueuedMessages = 1024;
+
+    AsyncLogOutput() = default;
+    ~AsyncLogOutput();
+
+    bool StartThread();
+    void Run();
+
+    std::mutex _mutex;
+    std::condition_variable _queue_changed;
+    std::deque<Entry> _queue;
+    size_t _writing = 0;
+    bool _stop = false;
+    bool _thread_failed = false;
+    std::thread _thread;
+};
+
+AsyncLogOutput::~AsyncLogOutput() {
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _queue_changed.notify_all();
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+}
+
+bool AsyncLogOutput::StartThread() {
+    if (!_thread.joinable() && !_thread_failed) {
+        try {
+            _thread = std::thread(&AsyncLogOutput::Run, this);
+        } catch (const std::system_error&) {
+            _thread_failed = true;
+        }
+    }
+    return !_thread_failed;
+}
+
+void AsyncLogOutput::Write(LogOutputFunction output, void* context, XrLoaderLogMessageSeverityFlagBits message_severity,
+                           std::string&& text) {
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (!_stop && StartThread()) {
+            _queue_changed.wait(lock, [this] { return _queue.size() < kMaxQueuedMessages; });
+            _queue.push_back(Entry{output, context, message_severity, std::move(text)});
+            _queue_changed.notify_all();
+            if (message_severity >= XR_LOADER_LOG_MESSAGE_SEVERITY_ERROR_BIT) {
+                _queue_changed.wait(lock, [this] { return _queue.empty() && _writing == 0; });
+            }
+            return;
+        }
+    }
+    // No background thread: write on the calling thread instead.
+    output(context, message_severity, text);
+}
+
+void AsyncLogOutput::Flush() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _queue_changed.wait(lock, [this] { return _queue.empty() && _writing == 0; });
+}
+
+void AsyncLogOutput::Run() {
+    std::vector<Entry> batch;
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true) {
+        _queue_changed.wait(lock, [this] { return _stop || !_queue.empty(); });
+        if (_queue.empty()) {
+            // Only reached when stopping, after everything queued has been written.
+            break;
+        }
+        batch.assign(std::make_move_iterator(_queue.begin()), std::make_move_iterator(_queue.end()));
+        _queue.clear();
+        _writing = batch.size();
+        lock.unlock();
+        _queue_changed.notify_all();
+
+        for (Entry& entry : batch) {
+            entry.output(entry.context, entry.message_severity, entry.text);
+        }
+        batch.clear();
+
+        lock.lock();
+        _writing = 0;
+        _queue_changed.notify_all();
+    }
+}
+#endif  // XR_LOADER_ASYNC_LOG_OUTPUT
+
+// Writes formatted text out, from the background thread where there is one.
+void WriteLogOutput(LogOutputFunction output, void* context, XrLoaderLogMessageSeverityFlagBits message_severity, std::string&& text) {
+#ifdef XR_LOADER_ASYNC_LOG_OUTPUT
+    AsyncLogOutput::Get().Write(output, context, message_severity, std::move(text));
+#else
+    output(context, message_severity, text);
+#endif  // XR_LOADER_ASYNC_LOG_OUTPUT
+}
+
+// Base for the recorders that only write text out.  The message is formatted on the logging thread, since
+// the callback data does not outlive the call, and handed to the output function.
+class OutputLoaderLogRecorder : public LoaderLogRecorder {
+   public:
+    OutputLoaderLogRecorder(XrLoaderLogType type, void* user_data, XrLoaderLogMessageSeverityFlags message_severities,
+                            LogOutputFunction output, void* output_context);
 
     bool LogMessage(XrLoaderLogMessageSeverityFlagBits message_severity, XrLoaderLogMessageTypeFlags message_type,
                     const XrLoaderLogMessengerCallbackData* callback_data) override;
 
    private:
-    std::ostream& os_;
+    LogOutputFunction _output;
+    void* _output_context;
+};
+
+OutputLoaderLogRecorder::OutputLoaderLogRecorder(XrLoaderLogType type, void* user_data,
+                                                 XrLoaderLogMessageSeverityFlags message_severities, LogOutputFunction output,
+                                                 void* output_context)
+    : LoaderLogRecorder(type, user_data, message_severities, 0xFFFFFFFFUL), _output(output), _output_context(output_context) {
+#ifdef XR_LOADER_ASYNC_LOG_OUTPUT
+    // Construct the output queue before any recorder so that it is destroyed, and drained, after them.
+    AsyncLogOutput::Get();
+#endif  // XR_LOADER_ASYNC_LOG_OUTPUT
+    // Automatically start
+    Start();
+}
+
+bool OutputLoaderLogRecorder::LogMessage(XrLoaderLogMessageSeverityFlagBits message_severity,
+                                         XrLoaderLogMessageTypeFlags message_type,
+                                         const XrLoaderLogMessengerCallbackData* callback_data) {
+    if (_active && 0 != (_message_severities & message_severity) && 0 != (_message_types & message_type)) {
+        std::ostringstream oss;
+        OutputMessageToStream(oss, message_severity, message_type, callback_data);
+        WriteLogOutput(_output, _output_context, message_severity, oss.str());
+    }
+
+    // Return of "true" means that we should exit the application after the logged message.  We
+    // don't want to do that for our internal logging.  Only let a user return true.
+    return false;
+}
+
+// With std::cerr: Standard Error logger, always on for now
+// With std::cout: Standard Output logger used with XR_LOADER_DEBUG
+class OstreamLoaderLogRecorder : public OutputLoaderLogRecorder {
+   public:
+    OstreamLoaderLogRecorder(std::ostream& os, void* user_data, XrLoaderLogMessageSeverityFlags flags);
+
+   private:
+    static void WriteToStream(void* context, XrLoaderLogMessageSeverityFlagBits message_severity, const std::string& text);
 };
 
 // Debug Utils logger used with XR_EXT_debug_utils
@@ -98,43 +284,35 @@ class DebugUtilsLogRecorder : public LoaderLogRecorder {
 };
 #ifdef __ANDROID__
 
-class LogcatLoaderLogRecorder : public LoaderLogRecorder {
+class LogcatLoaderLogRecorder : public OutputLoaderLogRecorder {
    public:
     LogcatLoaderLogRecorder();
 
-    bool LogMessage(XrLoaderLogMessageSeverityFlagBits message_severity, XrLoaderLogMessageTypeFlags message_type,
-                    const XrLoaderLogMessengerCallbackData* callback_data) override;
+   private:
+    static void WriteToLogcat(void* context, XrLoaderLogMessageSeverityFlagBits message_severity, const std::string& text);
 };
 #endif
 
 #ifdef _WIN32
 // Output to debugger
-class DebuggerLoaderLogRecorder : public LoaderLogRecorder {
+class DebuggerLoaderLogRecorder : public OutputLoaderLogRecorder {
    public:
     DebuggerLoaderLogRecorder(void* user_data, XrLoaderLogMessageSeverityFlags flags);
 
-    bool LogMessage(XrLoaderLogMessageSeverityFlagBits message_severity, XrLoaderLogMessageTypeFlags message_type,
-                    const XrLoaderLogMessengerCallbackData* callback_data) override;
+   private:
+    static void WriteToDebugger(void* context, XrLoaderLogMessageSeverityFlagBits message_severity, const std::string& text);
 };
 #endif
 
 // Unified stdout/stderr logger
 OstreamLoaderLogRecorder::OstreamLoaderLogRecorder(std::ostream& os, void* user_data, XrLoaderLogMessageSeverityFlags flags)
-    : LoaderLogRecorder(XR_LOADER_LOG_STDOUT, user_data, flags, 0xFFFFFFFFUL), os_(os) {
-    // Automatically start
-    Start();
-}
+    : OutputLoaderLogRecorder(XR_LOADER_LOG_STDOUT, user_data, flags, &OstreamLoaderLogRecorder::WriteToStream, &os) {}
 
-bool OstreamLoaderLogRecorder::LogMessage(XrLoaderLogMessageSeverityFlagBits message_severity,
-                                          XrLoaderLogMessageTypeFlags message_type,
-                                          const XrLoaderLogMessengerCallbackData* callback_data) {
-    if (_active && 0 != (_message_severities & message_severity) && 0 != (_message_types & message_type)) {
-        OutputMessageToStream(os_, message_severity, message_type, callback_data);
-    }
-
-    // Return of "true" means that we should exit the application after the logged message.  We
-    // don't want to do that for our internal logging.  Only let a user return true.
-    return false;
+void OstreamLoaderLogRecorder::WriteToStream(void* context, XrLoaderLogMessageSeverityFlagBits /*message_severity*/,
+                                             const std::string& text) {
+    std::ostream& os = *static_cast<std::ostream*>(context);
+    os.write(text.data(), static_cast<std::streamsize>(text.size()));
+    os.flush();
 }
 
 // A logger associated with the XR_EXT_debug_utils extension
@@ -211,52 +389,220 @@ static inline android_LogPriority LoaderToAndroidLogPriority(XrLoaderLogMessageS
 }
 
 LogcatLoaderLogRecorder::LogcatLoaderLogRecorder()
-    : LoaderLogRecorder(XR_LOADER_LOG_LOGCAT, nullptr,
-                        XR_LOADER_LOG_MESSAGE_SEVERITY_VERBOSE_BIT | XR_LOADER_LOG_MESSAGE_SEVERITY_INFO_BIT |
-                            XR_LOADER_LOG_MESSAGE_SEVERITY_WARNING_BIT | XR_LOADER_LOG_MESSAGE_SEVERITY_ERROR_BIT,
-                        0xFFFFFFFFUL) {
-    // Automatically start
-    Start();
-}
-
-bool LogcatLoaderLogRecorder::LogMessage(XrLoaderLogMessageSeverityFlagBits message_severity,
-                                         XrLoaderLogMessageTypeFlags message_type,
-                                         const XrLoaderLogMessengerCallbackData* callback_data) {
-    if (_active && 0 != (_message_severities & message_severity) && 0 != (_message_types & message_type)) {
-        std::stringstream ss;
-        OutputMessageToStream(ss, message_severity, message_type, callback_data);
-        __android_log_write(LoaderToAndroidLogPriority(message_severity), "OpenXR-Loader", ss.str().c_str());
-    }
-
-    // Return of "true" means that we should exit the application after the logged message.  We
-    // don't want to do that for our internal logging.  Only let a user return true.
-    return false;
+    : OutputLoaderLogRecorder(XR_LOADER_LOG_LOGCAT, nullptr,
+                              XR_LOADER_LOG_MESSAGE_SEVERITY_VERBOSE_BIT | XR_LOADER_LOG_MESSAGE_SEVERITY_INFO_BIT |
+                                  XR_LOADER_LOG_MESSAGE_SEVERITY_WARNING_BIT | XR_LOADER_LOG_MESSAGE_SEVERITY_ERROR_BIT,
+                              &LogcatLoaderLogRecorder::WriteToLogcat, nullptr) {}
+
+void LogcatLoaderLogRecorder::WriteToLogcat(void* /*context*/, XrLoaderLogMessageSeverityFlagBits message_severity,
+                                            const std::string& text) {
+    __android_log_write(LoaderToAndroidLogPriority(message_severity), "OpenXR-Loader", text.c_str());
 }
 #endif  // __ANDROID__
 
 #ifdef _WIN32
 // Unified stdout/stderr logger
 DebuggerLoaderLogRecorder::DebuggerLoaderLogRecorder(void* user_data, XrLoaderLogMessageSeverityFlags flags)
-    : LoaderLogRecorder(XR_LOADER_LOG_DEBUGGER, user_data, flags, 0xFFFFFFFFUL) {
-    // Automatically start
+    : OutputLoaderLogRecorder(XR_LOADER_LOG_DEBUGGER, user_data, flags, &DebuggerLoaderLogRecorder::WriteToDebugger, nullptr) {}
+
+void DebuggerLoaderLogRecorder::WriteToDebugger(void* /*context*/, XrLoaderLogMessageSeverityFlagBits /*message_severity*/,
+                                                const std::string& text) {
+    OutputDebugStringA(text.c_str());
+}
+#endif
+
+// Keeps every message in a fixed ring of binary records, and formats them only when they are written out: when an error
+// is logged, or when DumpLoaderLogRing is called. Recording is lock-free: each message claims a record with one atomic
+// increment and publishes it with a sequence number, and every field of a record is itself atomic, so a dump can read a
+// record while it is being rewritten and tell from the sequence number to skip it. A dump stops at a record that is
+// still being written, and the next dump starts from it. Text that does not fit in a record is cut short, and the
+// objects and session labels of a message are not kept.
+class RingBufferLoaderLogRecorder : public LoaderLogRecorder {
+   public:
+    explicit RingBufferLoaderLogRecorder(size_t record_count);
+    ~RingBufferLoaderLogRecorder() override;
+
+    bool LogMessage(XrLoaderLogMessageSeverityFlagBits message_severity, XrLoaderLogMessageTypeFlags message_type,
+                    const XrLoaderLogMessengerCallbackData* callback_data) override;
+
+    // Writes out the records logged since the last dump that are still in the ring.
+    void Dump() { DumpUntil(_next_index.load(std::memory_order_acquire), UINT64_MAX); }
+
+    static std::atomic<RingBufferLoaderLogRecorder*> s_current;
+
+   private:
+    static const size_t kTextSize = 224;
+    static const size_t kTextWords = kTextSize / sizeof(uint64_t);
+    static_assert(kTextSize % sizeof(uint64_t) == 0, "record text must be a whole number of words");
+
+    struct Record {
+        // 0 while unused, 2 * index + 1 while message number index is written and 2 * index + 2 once it is complete.
+        std::atomic<uint64_t> sequence{0};
+        std::atomic<int64_t> time_ns{0};
+        std::atomic<XrLoaderLogMessageSeverityFlagBits> message_severity{XR_LOADER_LOG_MESSAGE_SEVERITY_VERBOSE_BIT};
+        std::atomic<XrLoaderLogMessageTypeFlags> message_type{0};
+        // command_name, message_id and message, each followed by a terminator, copied in and out a word at a time.
+        std::atomic<uint64_t> text[kTextWords];
+    };
+
+    // Writes out the records from the last dump up to, but not including, message number end, leaving out message
+    // number skip. Stops early at a record that is still being written, so that the next dump includes it.
+    void DumpUntil(uint64_t end, uint64_t skip);
+
+    static void WriteDump(void* context, XrLoaderLogMessageSeverityFlagBits message_severity, const std::string& text);
+
+    std::unique_ptr<Record[]> _records;
+    size_t _record_count;
+    std::atomic<uint64_t> _next_index{0};
+    // Serializes dumps, which read and advance _dumped_index.
+    std::mutex _dump_mutex;
+    uint64_t _dumped_index{0};
+};
+
+std::atomic<RingBufferLoaderLogRecorder*> RingBufferLoaderLogRecorder::s_current{nullptr};
+
+RingBufferLoaderLogRecorder::RingBufferLoaderLogRecorder(size_t record_count)
+    : LoaderLogRecorder(XR_LOADER_LOG_RING_BUFFER, nullptr,
+                        XR_LOADER_LOG_MESSAGE_SEVERITY_VERBOSE_BIT | XR_LOADER_LOG_MESSAGE_SEVERITY_INFO_BIT |
+                            XR_LOADER_LOG_MESSAGE_SEVERITY_WARNING_BIT | XR_LOADER_LOG_MESSAGE_SEVERITY_ERROR_BIT,
+                        0xFFFFFFFFUL),
+      _records(new Record[record_count]),
+      _record_count(record_count) {
+#ifdef XR_LOADER_ASYNC_LOG_OUTPUT
+    // Construct the output queue before any recorder so that it is destroyed, and drained, after them.
+    AsyncLogOutput::Get();
+#endif  // XR_LOADER_ASYNC_LOG_OUTPUT
+    s_current.store(this, std::memory_order_release);
     Start();
 }
 
-bool DebuggerLoaderLogRecorder::LogMessage(XrLoaderLogMessageSeverityFlagBits message_severity,
-                                           XrLoaderLogMessageTypeFlags message_type,
-                                           const XrLoaderLogMessengerCallbackData* callback_data) {
-    if (_active && 0 != (_message_severities & message_severity) && 0 != (_message_types & message_type)) {
-        std::stringstream ss;
-        OutputMessageToStream(ss, message_severity, message_type, callback_data);
+RingBufferLoaderLogRecorder::~RingBufferLoaderLogRecorder() {
+    RingBufferLoaderLogRecorder* self = this;
+    s_current.compare_exchange_strong(self, nullptr, std::memory_order_acq_rel);
+}
 
-        OutputDebugStringA(ss.str().c_str());
+bool RingBufferLoaderLogRecorder::LogMessage(XrLoaderLogMessageSeverityFlagBits message_severity,
+                                             XrLoaderLogMessageTypeFlags message_type,
+                                             const XrLoaderLogMessengerCallbackData* callback_data) {
+    if (!_active) {
+        return false;
     }
 
-    // Return of "true" means that we should exit the application after the logged message.  We
-    // don't want to do that for our internal logging.  Only let a user return true.
+    char text[kTextSize] = {};
+    size_t offset = 0;
+    for (const char* str : {callback_data->command_name, callback_data->message_id, callback_data->message}) {
+        const size_t length = std::min(std::strlen(str), kTextSize - offset - 1);
+        std::memcpy(text + offset, str, length);
+        offset += length;
+        if (offset < kTextSize - 1) {
+            ++offset;
+        }
+    }
+
+    const uint64_t index = _next_index.fetch_add(1, std::memory_order_relaxed);
+    Record& record = _records[index % _record_count];
+    record.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    record.time_ns.store(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count(),
+        std::memory_order_relaxed);
+    record.message_severity.store(message_severity, std::memory_order_relaxed);
+    record.message_type.store(message_type, std::memory_order_relaxed);
+    for (size_t word = 0; word < kTextWords; ++word) {
+        uint64_t value;
+        std::memcpy(&value, text + word * sizeof(uint64_t), sizeof(value));
+        record.text[word].store(value, std::memory_order_relaxed);
+    }
+
+    record.sequence.store(2 * index + 2, std::memory_order_release);
+
+    // The error itself reaches standard error through its own recorder; show what led up to it.
+    if ((message_severity & XR_LOADER_LOG_MESSAGE_SEVERITY_ERROR_BIT) != 0) {
+        DumpUntil(index + 1, index);
+    }
     return false;
 }
-#endif
+
+void RingBufferLoaderLogRecorder::DumpUntil(uint64_t end, uint64_t skip) {
+    std::lock_guard<std::mutex> lock(_dump_mutex);
+    uint64_t begin = _dumped_index;
+    if (begin >= end) {
+        return;
+    }
+    if (end - begin > _record_count) {
+        begin = end - _record_count;
+    }
+
+    const int64_t now_ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    std::ostringstream oss;
+    bool any = false;
+    uint64_t index = begin;
+    for (; index < end; ++index) {
+        if (index == skip) {
+            continue;
+        }
+        const Record& record = _records[index % _record_count];
+        const uint64_t sequence = record.sequence.load(std::memory_order_acquire);
+        if (sequence < 2 * index + 2) {
+            break;  // Claimed but not written yet; left for the next dump.
+        }
+        if (sequence != 2 * index + 2) {
+            continue;  // Already reused for a later message.
+        }
+        const int64_t time_ns = record.time_ns.load(std::memory_order_relaxed);
+        const XrLoaderLogMessageSeverityFlagBits message_severity = record.message_severity.load(std::memory_order_relaxed);
+        const XrLoaderLogMessageTypeFlags message_type = record.message_type.load(std::memory_order_relaxed);
+        char text[kTextSize];
+        for (size_t word = 0; word < kTextWords; ++word) {
+            const uint64_t value = record.text[word].load(std::memory_order_relaxed);
+            std::memcpy(text + word * sizeof(uint64_t), &value, sizeof(value));
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (record.sequence.load(std::memory_order_relaxed) != sequence) {
+            continue;  // Rewritten while it was copied.
+        }
+        text[kTextSize - 1] = '\0';
+
+        // A string cut short by the end of the record leaves the ones after it empty.
+        const char* const text_end = text + kTextSize - 1;
+        const char* command_name = text;
+        const char* message_id = std::min(command_name + std::strlen(command_name) + 1, text_end);
+        const char* message = std::min(message_id + std::strlen(message_id) + 1, text_end);
+        XrLoaderLogMessengerCallbackData callback_data = {};
+        callback_data.command_name = command_name;
+        callback_data.message_id = message_id;
+        callback_data.message = message;
+
+        if (!any) {
+            oss << "OpenXR loader log ring, oldest first:" << std::endl;
+            any = true;
+        }
+        oss << "  -" << (now_ns - time_ns) / 1000 << "us ";
+        OutputMessageToStream(oss, message_severity, message_type, &callback_data);
+    }
+    _dumped_index = index;
+    if (any) {
+        WriteLogOutput(&RingBufferLoaderLogRecorder::WriteDump, nullptr, XR_LOADER_LOG_MESSAGE_SEVERITY_ERROR_BIT, oss.str());
+    }
+}
+
+void RingBufferLoaderLogRecorder::WriteDump(void* /*context*/, XrLoaderLogMessageSeverityFlagBits message_severity,
+                                            const std::string& text) {
+#ifdef __ANDROID__
+    // Logcat truncates long entries, so write a line at a time.
+    std::istringstream lines(text);
+    std::string line;
+    while (std::getline(lines, line)) {
+        __android_log_write(LoaderToAndroidLogPriority(message_severity), "OpenXR-Loader", line.c_str());
+    }
+#else
+    (void)message_severity;
+    std::cerr.write(text.data(), static_cast<std::streamsize>(text.size()));
+    std::cerr.flush();
+#endif  // __ANDROID__
+}
 }  // namespace
 
 std::unique_ptr<LoaderLogRecorder> MakeStdOutLoaderLogRecorder(void* user_data, XrLoaderLogMessageSeverityFlags flags) {
@@ -276,6 +622,24 @@ std::unique_ptr<LoaderLogRecorder> MakeDebugUtilsLoaderLogRecorder(const XrDebug
     return recorder;
 }
 
+std::unique_ptr<LoaderLogRecorder> MakeRingBufferLoaderLogRecorder(size_t record_count) {
+    std::unique_ptr<LoaderLogRecorder> recorder(new RingBufferLoaderLogRecorder(record_count));
+    return recorder;
+}
+
+void DumpLoaderLogRing() {
+    RingBufferLoaderLogRecorder* recorder = RingBufferLoaderLogRecorder::s_current.load(std::memory_order_acquire);
+    if (recorder != nullptr) {
+        recorder->Dump();
+    }
+}
+
+void FlushLoaderLogRecorderOutput() {
+#ifdef XR_LOADER_ASYNC_LOG_OUTPUT
+    AsyncLogOutput::Get().Flush();
+#endif  // XR_LOADER_ASYNC_LOG_OUTPUT
+}
+
 #ifdef __ANDROID__
 std::unique_ptr<LoaderLogRecorder> MakeLogcatLoaderLogRecorder() {
     std::unique_ptr<LoaderLogRecorder> recorder(new LogcatLoaderLogRecorder());
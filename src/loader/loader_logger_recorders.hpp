@@ -30,6 +30,18 @@ std::unique_ptr<LoaderLogRecorder> MakeLogcatLoaderLogRecorder();
 std::unique_ptr<LoaderLogRecorder> MakeDebugUtilsLoaderLogRecorder(const XrDebugUtilsMessengerCreateInfoEXT* create_info,
                                                                    XrDebugUtilsMessengerEXT debug_messenger);
 
+//! In-memory logger used with the XR_LOADER_LOG_RING environment variable. Keeps the last record_count messages, of every
+//! severity, and writes them out to standard error (logcat on Android) when an error is logged.
+std::unique_ptr<LoaderLogRecorder> MakeRingBufferLoaderLogRecorder(size_t record_count);
+
+//! Writes out the messages the ring buffer recorder holds that have not been written yet, if there is one. For calling
+//! from a debugger or an unhandled exception filter; it takes a lock and allocates, so it is not async-signal-safe and
+//! must not be called from a signal handler.
+void DumpLoaderLogRing();
+
+//! Waits until the standard stream, logcat and debugger recorders have written every message logged so far.
+void FlushLoaderLogRecorderOutput();
+
 #ifdef _WIN32
 //! Win32 debugger output
 std::unique_ptr<LoaderLogRecorder> MakeDebuggerLoaderLogRecorder(void* user_data);
@@ -0,0 +1,58 @@
+// Copyright (c) 2017-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0 OR MIT
+//
+
+#pragma once
+
+#ifdef OPENXR_HAVE_COMMON_CONFIG
+#include "common_config.h"
+#endif  // OPENXR_HAVE_COMMON_CONFIG
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#ifndef XRLOADER_DISABLE_EXCEPTION_HANDLING
+#include <system_error>
+#endif
+
+// Upper bound on the worker threads used for loader start-up work such as reading manifests and opening
+// API layer libraries.  That work is mostly file I/O and dynamic linking, so a few threads are enough.
+static const size_t kLoaderMaxWorkerThreads = 4;
+
+// Calls func(index) for every index in [0, count), spreading the calls over a small pool of short-lived
+// worker threads plus the calling thread, and returns once every call has finished.  The order in which the
+// calls run is unspecified, so func must only write to per-index results and must not log; callers then
+// consume the results in index order to keep behavior deterministic.
+template <typename Func>
+static inline void LoaderParallelFor(size_t count, const Func& func) {
+    std::atomic<size_t> next_index{0};
+    auto run = [&]() {
+        for (size_t index = next_index++; index < count; index = next_index++) {
+            func(index);
+        }
+    };
+
+    std::vector<std::thread> workers;
+#ifndef XRLOADER_DISABLE_EXCEPTION_HANDLING
+    const size_t hardware_threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    const size_t worker_count = std::min(std::min(count, kLoaderMaxWorkerThreads), hardware_threads);
+    // The calling thread is one of the workers.
+    for (size_t worker = 1; worker < worker_count; ++worker) {
+        try {
+            workers.emplace_back(run);
+        } catch (const std::system_error&) {
+            // Could not start another thread; the threads already running pick up the remaining work.
+            break;
+        }
+    }
+#endif  // !XRLOADER_DISABLE_EXCEPTION_HANDLING
+
+    run();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
@@ -0,0 +1,107 @@
+// Copyright (c) 2017-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0 OR MIT
+//
+
+#include "loader_startup_profile.hpp"
+
+#include "loader_logger.hpp"
+#include "platform_utils.hpp"
+
+#include <json/json.h>
+
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#define OPENXR_STARTUP_PROFILE_ENV_VAR "XR_LOADER_STARTUP_PROFILE"
+
+namespace {
+struct StartupPhase {
+    const char* phase;
+    std::string subject;
+    std::chrono::steady_clock::duration duration;
+};
+
+struct StartupProfile {
+    std::mutex mutex;
+    std::vector<StartupPhase> phases;
+};
+
+StartupProfile& GetStartupProfile() {
+    static StartupProfile profile;
+    return profile;
+}
+
+double ToMilliseconds(std::chrono::steady_clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+}  // namespace
+
+namespace LoaderStartupProfile {
+bool IsEnabled() {
+    static const bool enabled = PlatformUtilsGetEnvSet(OPENXR_STARTUP_PROFILE_ENV_VAR);
+    return enabled;
+}
+
+void Record(const char* phase, const std::string& subject, std::chrono::steady_clock::duration duration) {
+    StartupProfile& profile = GetStartupProfile();
+    std::lock_guard<std::mutex> lock(profile.mutex);
+    profile.phases.push_back(StartupPhase{phase, subject, duration});
+}
+
+void Report(const std::string& openxr_command, bool succeeded) {
+    if (!IsEnabled()) {
+        return;
+    }
+    std::vector<StartupPhase> phases;
+    {
+        StartupProfile& profile = GetStartupProfile();
+        std::lock_guard<std::mutex> lock(profile.mutex);
+        phases.swap(profile.phases);
+    }
+
+    Json::Value summary(Json::objectValue);
+    summary["command"] = openxr_command;
+    summary["succeeded"] = succeeded;
+    Json::Value& json_phases = summary["phases"] = Json::Value(Json::arrayValue);
+    for (const StartupPhase& phase : phases) {
+        std::ostringstream oss;
+        oss << "Startup profile: " << phase.phase;
+        if (!phase.subject.empty()) {
+            oss << " " << phase.subject;
+        }
+        oss << " took " << ToMilliseconds(phase.duration) << " ms";
+        LoaderLogger::GetInstance().LogMessage(XR_LOADER_LOG_MESSAGE_SEVERITY_INFO_BIT, XR_LOADER_LOG_MESSAGE_TYPE_PERFORMANCE_BIT,
+                                               "OpenXR-Loader", openxr_command, oss.str());
+
+        Json::Value json_phase(Json::objectValue);
+        json_phase["phase"] = phase.phase;
+        if (!phase.subject.empty()) {
+            json_phase["subject"] = phase.subject;
+        }
+        json_phase["us"] = Json::Int64(std::chrono::duration_cast<std::chrono::microseconds>(phase.duration).count());
+        json_phases.append(json_phase);
+    }
+
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "";
+    const std::string json = Json::writeString(builder, summary);
+    LoaderLogger::GetInstance().LogMessage(XR_LOADER_LOG_MESSAGE_SEVERITY_INFO_BIT, XR_LOADER_LOG_MESSAGE_TYPE_PERFORMANCE_BIT,
+                                           "OpenXR-Loader", openxr_command, "Startup profile summary: " + json);
+
+    const std::string path = PlatformUtilsGetEnv(OPENXR_STARTUP_PROFILE_ENV_VAR);
+    if (!path.empty() && path != "1") {
+        std::ofstream file(path, std::ios::app);
+        if (file) {
+            file << json << "\n";
+        } else {
+            LoaderLogger::LogWarningMessage(openxr_command, "Could not open startup profile file " + path);
+        }
+    }
+}
+}  // namespace LoaderStartupProfile
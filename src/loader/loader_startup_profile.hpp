@@ -0,0 +1,49 @@
+// Copyright (c) 2017-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0 OR MIT
+//
+// Times the phases of loader startup - manifest discovery and parsing, opening libraries, negotiation, instance
+// creation down the chain and dispatch table population - per runtime and per API layer. Enabled by setting the
+// XR_LOADER_STARTUP_PROFILE environment variable; see BUILDING.md.
+
+#pragma once
+
+#include <chrono>
+#include <string>
+
+namespace LoaderStartupProfile {
+// Returns true if XR_LOADER_STARTUP_PROFILE is set. Read once per process.
+bool IsEnabled();
+
+// Records that a phase of startup took this long. The subject is the manifest, runtime or layer it was for, or empty
+// for a phase that covers all of them. Thread safe, as libraries are opened in parallel.
+void Record(const char* phase, const std::string& subject, std::chrono::steady_clock::duration duration);
+
+// Logs the phases recorded since the last report, one info message each, then a JSON summary of them, which is also
+// appended to the file XR_LOADER_STARTUP_PROFILE names if it is not "1". Clears the recorded phases.
+void Report(const std::string& openxr_command, bool succeeded);
+}  // namespace LoaderStartupProfile
+
+// Records the time from its construction to its destruction as a phase of startup, if profiling is enabled.
+class LoaderStartupTimer {
+   public:
+    LoaderStartupTimer(const char* phase, std::string subject = {})
+        : _enabled(LoaderStartupProfile::IsEnabled()), _phase(phase), _subject(_enabled ? std::move(subject) : std::string{}) {
+        if (_enabled) {
+            _start = std::chrono::steady_clock::now();
+        }
+    }
+    ~LoaderStartupTimer() {
+        if (_enabled) {
+            LoaderStartupProfile::Record(_phase, _subject, std::chrono::steady_clock::now() - _start);
+        }
+    }
+    LoaderStartupTimer(const LoaderStartupTimer&) = delete;
+    LoaderStartupTimer& operator=(const LoaderStartupTimer&) = delete;
+
+   private:
+    bool _enabled;
+    const char* _phase;
+    std::string _subject;
+    std::chrono::steady_clock::time_point _start;
+};
@@ -21,20 +21,27 @@
 #include "loader_platform.hpp"
 #include "platform_utils.hpp"
 #include "loader_logger.hpp"
+#include "loader_parallel.hpp"
+#include "loader_startup_profile.hpp"
+#include "manifest_reader.hpp"
 
 #include <json/json.h>
 #include <openxr/openxr.h>
 
 #include <algorithm>
+#include <cctype>
 #include <cstring>
 #include <fstream>
+#include <iterator>
 #include <memory>
+#include <mutex>
 #include <sstream>
 #include <stdexcept>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -76,33 +83,208 @@ static void AddIfJson(const std::string &full_file, std::vector<std::string> &ma
     manifest_files.push_back(full_file);
 }
 
+// Process-wide cache of manifest search results, so that enumerating layers, enumerating extensions and
+// creating an instance do not each re-scan the search directories and re-parse every manifest.  Entries
+// are keyed by path and invalidated whenever the modification stamp of the directory or file changes,
+// so environment variable changes (which change the paths searched) and edits on disk are still seen.
+namespace {
+struct CachedManifestDirectory {
+    FileSysUtilsFileStamp stamp;
+    std::vector<std::string> manifest_files;
+};
+
+struct CachedManifestJson {
+    FileSysUtilsFileStamp stamp;
+    bool parsed;
+    std::string errors;
+    ManifestData data;
+};
+
+class ManifestCache {
+   public:
+    static ManifestCache &Get() {
+        static ManifestCache cache;
+        return cache;
+    }
+
+    // Returns the JSON manifest files in the directory, scanning it only if its stamp changed since the last call.
+    void FindManifestFilesInDirectory(const std::string &directory, const FileSysUtilsFileStamp &stamp,
+                                      std::vector<std::string> &manifest_files);
+
+    // Returns the parsed contents of the manifest file, parsing it only if it changed since the last call.
+    // Returns nullptr if the file does not exist or could not be opened.
+    std::shared_ptr<const CachedManifestJson> LoadJson(const std::string &filename);
+
+    // Returns true if LoadJson would read the file: it exists and is not cached with its current stamp.
+    bool NeedsLoad(const std::string &filename);
+
+   private:
+    std::shared_ptr<const CachedManifestJson> FindJson(const std::string &filename, const FileSysUtilsFileStamp &stamp);
+
+    std::mutex _mutex;
+    std::unordered_map<std::string, CachedManifestDirectory> _directories;
+    std::unordered_map<std::string, std::shared_ptr<const CachedManifestJson>> _json_files;
+};
+
+void ManifestCache::FindManifestFilesInDirectory(const std::string &directory, const FileSysUtilsFileStamp &stamp,
+                                                 std::vector<std::string> &manifest_files) {
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        auto found = _directories.find(directory);
+        if (found != _directories.end() && found->second.stamp == stamp) {
+            manifest_files.insert(manifest_files.end(), found->second.manifest_files.begin(), found->second.manifest_files.end());
+            return;
+        }
+    }
+
+    CachedManifestDirectory entry{stamp, {}};
+    FileSysUtilsFindAbsoluteFilesInPath(directory, ".json", entry.manifest_files);
+
+    manifest_files.insert(manifest_files.end(), entry.manifest_files.begin(), entry.manifest_files.end());
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _directories[directory] = std::move(entry);
+}
+
+std::shared_ptr<const CachedManifestJson> ManifestCache::FindJson(const std::string &filename,
+                                                                   const FileSysUtilsFileStamp &stamp) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    auto found = _json_files.find(filename);
+    if (found != _json_files.end() && found->second->stamp == stamp) {
+        return found->second;
+    }
+    return nullptr;
+}
+
+bool ManifestCache::NeedsLoad(const std::string &filename) {
+    FileSysUtilsFileStamp stamp;
+    return FileSysUtilsGetFileStamp(filename, stamp) && !FindJson(filename, stamp);
+}
+
+std::shared_ptr<const CachedManifestJson> ManifestCache::LoadJson(const std::string &filename) {
+    FileSysUtilsFileStamp stamp;
+    if (!FileSysUtilsGetFileStamp(filename, stamp)) {
+        return nullptr;
+    }
+
+    std::shared_ptr<const CachedManifestJson> cached = FindJson(filename, stamp);
+    if (cached) {
+        return cached;
+    }
+
+    auto entry = std::make_shared<CachedManifestJson>();
+    {
+        LoaderStartupTimer timer("read manifest", filename);
+        std::ifstream json_stream(filename, std::ifstream::in | std::ifstream::binary);
+        if (!json_stream.is_open()) {
+            return nullptr;
+        }
+        const std::string contents((std::istreambuf_iterator<char>(json_stream)), std::istreambuf_iterator<char>());
+
+        entry->stamp = stamp;
+        entry->parsed = ManifestReader::Parse(contents.data(), contents.data() + contents.size(), entry->data, entry->errors);
+    }
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _json_files[filename] = entry;
+    return entry;
+}
+}  // namespace
+
 // Check the current path for any manifest files.  If the provided search_path is a directory, look for
 // all included JSON files in that directory.  Otherwise, just check the provided search_path which should
 // be a single filename.
 static void CheckAllFilesInThePath(const std::string &search_path, bool is_directory_list,
                                    std::vector<std::string> &manifest_files) {
-    if (FileSysUtilsPathExists(search_path)) {
-        std::string absolute_path;
+    // One status query answers whether the path exists, what it is and whether a cached scan is still valid.
+    FileSysUtilsFileStatus status;
+    if (FileSysUtilsGetFileStatus(search_path, status)) {
         if (!is_directory_list) {
             // If the file exists, try to add it
-            if (FileSysUtilsIsRegularFile(search_path)) {
+            if (status.is_regular_file) {
+                std::string absolute_path;
                 FileSysUtilsGetAbsolutePath(search_path, absolute_path);
                 AddIfJson(absolute_path, manifest_files);
             }
         } else {
-            std::vector<std::string> files;
-            if (FileSysUtilsFindFilesInPath(search_path, files)) {
-                for (std::string &cur_file : files) {
-                    std::string relative_path;
-                    FileSysUtilsCombinePaths(search_path, cur_file, relative_path);
-                    if (!FileSysUtilsGetAbsolutePath(relative_path, absolute_path)) {
-                        continue;
-                    }
-                    AddIfJson(absolute_path, manifest_files);
-                }
+            ManifestCache::Get().FindManifestFilesInDirectory(search_path, status.stamp, manifest_files);
+        }
+    }
+}
+
+// Lexically normalizes a manifest path without touching the file system: one kind of separator, no empty or "." segments,
+// and each ".." applied to the segment before it.  On Windows, where paths are case-insensitive, it is also lowercased.
+static std::string NormalizeManifestPath(const std::string &path) {
+    std::string prefix;
+    std::vector<std::string> segments;
+    std::size_t start = 0;
+    while (start <= path.size()) {
+        std::size_t end = path.find_first_of("/\\", start);
+        if (end == std::string::npos) {
+            end = path.size();
+        }
+        std::string segment = path.substr(start, end - start);
+        if (start == 0 && end < path.size() && (segment.empty() || segment.back() == ':')) {
+            prefix = segment + "/";  // root, or a Windows drive
+        } else if (segment == "..") {
+            if (!segments.empty() && segments.back() != "..") {
+                segments.pop_back();
+            } else if (prefix.empty()) {
+                segments.push_back(segment);
             }
+        } else if (!segment.empty() && segment != ".") {
+            segments.push_back(std::move(segment));
+        }
+        start = end + 1;
+    }
+
+    std::string normalized = prefix;
+    for (std::size_t i = 0; i < segments.size(); ++i) {
+        if (i != 0) {
+            normalized += '/';
         }
+        normalized += segments[i];
     }
+#ifdef XR_OS_WINDOWS
+    std::transform(normalized.begin(), normalized.end(), normalized.begin(),
+                   [](char c) { return static_cast<char>(tolower(static_cast<unsigned char>(c))); });
+#endif
+    return normalized;
+}
+
+// Remove the manifest files that are the same file as one earlier in the list, reached through another spelling of its
+// path, so that each is read and validated once and the copy first in search order is the one used.  The comparison
+// uses the path strings; only two paths that normalize to the same string are canonicalized, since a ".." after a
+// symbolic link can make them different files.
+static void RemoveDuplicateManifestFiles(std::vector<std::string> &manifest_files) {
+    if (manifest_files.size() < 2) {
+        return;
+    }
+    std::unordered_map<std::string, std::size_t> seen;  // normalized path to its index among the kept files
+    std::size_t kept = 0;
+    for (std::size_t index = 0; index < manifest_files.size(); ++index) {
+        std::string normalized = NormalizeManifestPath(manifest_files[index]);
+        auto found = seen.find(normalized);
+        if (found != seen.end()) {
+            std::string earlier_canonical;
+            std::string canonical;
+            const bool different_files = FileSysUtilsGetCanonicalPath(manifest_files[found->second], earlier_canonical) &&
+                                         FileSysUtilsGetCanonicalPath(manifest_files[index], canonical) &&
+                                         earlier_canonical != canonical;
+            if (!different_files) {
+                LoaderLogger::LogInfoMessage(
+                    "", "Skipping manifest file " + manifest_files[index] + ", which is the same file as one found earlier");
+                continue;
+            }
+        } else {
+            seen.emplace(std::move(normalized), kept);
+        }
+        if (kept != index) {
+            manifest_files[kept] = std::move(manifest_files[index]);
+        }
+        ++kept;
+    }
+    manifest_files.erase(manifest_files.begin() + kept, manifest_files.end());
 }
 
 // Add all manifest files in the provided paths to the manifest_files list.  If search_path
@@ -408,12 +590,12 @@ static void ReadLayerDataFilesInRegistry(const std::string &registry_location, s
 ManifestFile::ManifestFile(ManifestFileType type, const std::string &filename, const std::string &library_path)
     : _filename(filename), _type(type), _library_path(library_path) {}
 
-bool ManifestFile::IsValidJson(const Json::Value &root_node, JsonVersion &version) {
-    if (root_node["file_format_version"].isNull() || !root_node["file_format_version"].isString()) {
+bool ManifestFile::IsValidJson(const ManifestData &data, JsonVersion &version) {
+    if (!data.file_format_version.IsString()) {
         LoaderLogger::LogErrorMessage("", "ManifestFile::IsValidJson - JSON file missing \"file_format_version\"");
         return false;
     }
-    std::string file_format = root_node["file_format_version"].asString();
+    const std::string &file_format = data.file_format_version.string_value;
     const int num_fields = sscanf(file_format.c_str(), "%u.%u.%u", &version.major, &version.minor, &version.patch);
 
     // Only version 1.0.0 is defined currently.  Eventually we may have more version, but
@@ -466,93 +648,152 @@ const std::string &ManifestFile::GetFunctionName(const std::string &func_name) c
 RuntimeManifestFile::RuntimeManifestFile(const std::string &filename, const std::string &library_path)
     : ManifestFile(MANIFEST_TYPE_RUNTIME, filename, library_path) {}
 
-static void ParseExtension(Json::Value const &ext, std::vector<ExtensionListing> &extensions) {
-    Json::Value ext_name = ext["name"];
-    Json::Value ext_version = ext["extension_version"];
+static void ParseExtension(const ManifestExtension &ext, std::vector<ExtensionListing> &extensions) {
+    const ManifestScalar &ext_name = ext.name;
+    const ManifestScalar &ext_version = ext.extension_version;
 
     // Allow "extension_version" as a String or a UInt to maintain backwards compatibility, even though it should be a String.
     // Internal Issue 1411: https://gitlab.khronos.org/openxr/openxr/-/issues/1411
     // Internal MR !1867: https://gitlab.khronos.org/openxr/openxr/-/merge_requests/1867
-    if (ext_name.isString() && (ext_version.isString() || ext_version.isUInt())) {
+    if (ext_name.IsString() && (ext_version.IsString() || ext_version.IsUInt())) {
         ExtensionListing ext_listing = {};
-        ext_listing.name = ext_name.asString();
-        if (ext_version.isUInt()) {
-            ext_listing.extension_version = ext_version.asUInt();
+        ext_listing.name = ext_name.string_value;
+        if (ext_version.IsUInt()) {
+            ext_listing.extension_version = ext_version.uint_value;
         } else {
-            ext_listing.extension_version = atoi(ext_version.asString().c_str());
+            ext_listing.extension_version = atoi(ext_version.string_value.c_str());
         }
         extensions.push_back(ext_listing);
     }
 }
 
-void ManifestFile::ParseCommon(Json::Value const &root_node) {
-    const Json::Value &inst_exts = root_node["instance_extensions"];
-    if (!inst_exts.isNull() && inst_exts.isArray()) {
-        for (const auto &ext : inst_exts) {
-            ParseExtension(ext, _instance_extensions);
-        }
+void ManifestFile::ParseCommon(const ManifestSection &section) {
+    for (const auto &ext : section.instance_extensions) {
+        ParseExtension(ext, _instance_extensions);
     }
-    const Json::Value &funcs_renamed = root_node["functions"];
-    if (!funcs_renamed.isNull() && !funcs_renamed.empty()) {
-        for (Json::ValueConstIterator func_it = funcs_renamed.begin(); func_it != funcs_renamed.end(); ++func_it) {
-            if (!(*func_it).isString()) {
-                LoaderLogger::LogWarningMessage(
-                    "", "ManifestFile::ParseCommon " + _filename + " \"functions\" section contains non-string values.");
-                continue;
-            }
-            std::string original_name = func_it.key().asString();
-            std::string new_name = (*func_it).asString();
-            _functions_renamed.emplace(original_name, new_name);
+    for (const auto &func : section.functions) {
+        if (!func.second.IsString()) {
+            LoaderLogger::LogWarningMessage("",
+                                            "ManifestFile::ParseCommon " + _filename + " \"functions\" section contains non-string values.");
+            continue;
         }
+        _functions_renamed.emplace(func.first, func.second.string_value);
     }
 }
 
 void RuntimeManifestFile::CreateIfValid(std::string const &filename,
                                         std::vector<std::unique_ptr<RuntimeManifestFile>> &manifest_files) {
-    std::ifstream json_stream(filename, std::ifstream::in);
-
     LoaderLogger::LogInfoMessage("", "RuntimeManifestFile::CreateIfValid - attempting to load " + filename);
     std::ostringstream error_ss("RuntimeManifestFile::CreateIfValid ");
-    if (!json_stream.is_open()) {
+    std::shared_ptr<const CachedManifestJson> json = ManifestCache::Get().LoadJson(filename);
+    if (!json) {
         error_ss << "failed to open " << filename << ".  Does it exist?";
         LoaderLogger::LogErrorMessage("", error_ss.str());
         return;
     }
-    Json::CharReaderBuilder builder;
-    std::string errors;
-    Json::Value root_node = Json::nullValue;
-    if (!Json::parseFromStream(builder, json_stream, &root_node, &errors) || !root_node.isObject()) {
+    if (!json->parsed) {
         error_ss << "failed to parse " << filename << ".";
-        if (!errors.empty()) {
-            error_ss << " (Error message: " << errors << ")";
+        if (!json->errors.empty()) {
+            error_ss << " (Error message: " << json->errors << ")";
         }
         error_ss << " Is it a valid runtime manifest file?";
         LoaderLogger::LogErrorMessage("", error_ss.str());
         return;
     }
 
-    CreateIfValid(root_node, filename, manifest_files);
+    CreateIfValid(json->data, filename, manifest_files);
+}
+
+// Reduces a manifest already held as a jsoncpp document to what ManifestReader records from manifest text, so that both
+// are validated identically.
+static ManifestScalar ReadManifestScalar(const Json::Value &parent, const char *key) {
+    ManifestScalar scalar;
+    if (!parent.isObject() || !parent.isMember(key)) {
+        return scalar;
+    }
+    const Json::Value &value = parent[key];
+    if (value.isString()) {
+        scalar.type = ManifestScalar::String;
+        scalar.string_value = value.asString();
+    } else if (value.isUInt()) {
+        scalar.type = ManifestScalar::UInt;
+        scalar.uint_value = value.asUInt();
+    } else {
+        scalar.type = ManifestScalar::Other;
+    }
+    return scalar;
+}
+
+static ManifestSection ReadManifestSection(const Json::Value &root_node, const char *key) {
+    ManifestSection section;
+    if (!root_node.isObject() || !root_node.isMember(key)) {
+        return section;
+    }
+    section.present = true;
+    const Json::Value &node = root_node[key];
+    if (!node.isObject()) {
+        return section;
+    }
+    section.is_object = true;
+    section.name = ReadManifestScalar(node, "name");
+    section.library_path = ReadManifestScalar(node, "library_path");
+    section.api_version = ReadManifestScalar(node, "api_version");
+    section.implementation_version = ReadManifestScalar(node, "implementation_version");
+    section.description = ReadManifestScalar(node, "description");
+    section.disable_environment = ReadManifestScalar(node, "disable_environment");
+    section.enable_environment = ReadManifestScalar(node, "enable_environment");
+
+    const Json::Value &extensions = node["instance_extensions"];
+    if (extensions.isArray()) {
+        for (const auto &extension : extensions) {
+            if (extension.isObject()) {
+                section.instance_extensions.push_back({ReadManifestScalar(extension, "name"),
+                                                       ReadManifestScalar(extension, "extension_version")});
+            }
+        }
+    }
+    const Json::Value &functions = node["functions"];
+    if (functions.isObject()) {
+        for (const auto &function_name : functions.getMemberNames()) {
+            section.functions.emplace_back(function_name, ReadManifestScalar(functions, function_name.c_str()));
+        }
+    }
+    return section;
 }
 
 void RuntimeManifestFile::CreateIfValid(const Json::Value &root_node, const std::string &filename,
                                         std::vector<std::unique_ptr<RuntimeManifestFile>> &manifest_files) {
+    if (!root_node.isObject()) {
+        LoaderLogger::LogErrorMessage("", "RuntimeManifestFile::CreateIfValid failed to read " + filename +
+                                              ": root value must be an object");
+        return;
+    }
+    ManifestData data;
+    data.file_format_version = ReadManifestScalar(root_node, "file_format_version");
+    data.runtime = ReadManifestSection(root_node, "runtime");
+    data.api_layer = ReadManifestSection(root_node, "api_layer");
+    CreateIfValid(data, filename, manifest_files);
+}
+
+void RuntimeManifestFile::CreateIfValid(const ManifestData &data, const std::string &filename,
+                                        std::vector<std::unique_ptr<RuntimeManifestFile>> &manifest_files) {
     std::ostringstream error_ss("RuntimeManifestFile::CreateIfValid ");
     JsonVersion file_version = {};
-    if (!ManifestFile::IsValidJson(root_node, file_version)) {
+    if (!ManifestFile::IsValidJson(data, file_version)) {
         error_ss << "isValidJson indicates " << filename << " is not a valid manifest file.";
         LoaderLogger::LogErrorMessage("", error_ss.str());
         return;
     }
-    const Json::Value &runtime_root_node = root_node["runtime"];
+    const ManifestSection &runtime_section = data.runtime;
     // The Runtime manifest file needs the "runtime" root as well as a sub-node for "library_path".  If any of those aren't there,
     // fail.
-    if (runtime_root_node.isNull() || runtime_root_node["library_path"].isNull() || !runtime_root_node["library_path"].isString()) {
+    if (!runtime_section.is_object || !runtime_section.library_path.IsString()) {
         error_ss << filename << " is missing required fields.  Verify all proper fields exist.";
         LoaderLogger::LogErrorMessage("", error_ss.str());
         return;
     }
 
-    std::string lib_path = runtime_root_node["library_path"].asString();
+    std::string lib_path = runtime_section.library_path.string_value;
 
     // If the library_path variable has no directory symbol, it's just a file name and should be accessible on the
     // global library path.
@@ -589,7 +830,7 @@ void RuntimeManifestFile::CreateIfValid(const Json::Value &root_node, const std:
 
     // Add any extensions to it after the fact.
     // Handle any renamed functions
-    manifest_files.back()->ParseCommon(runtime_root_node);
+    manifest_files.back()->ParseCommon(runtime_section);
 }
 
 // Find all manifest files in the appropriate search paths/registries for the given type.
@@ -657,65 +898,64 @@ ApiLayerManifestFile::ApiLayerManifestFile(ManifestFileType type, const std::str
       _implementation_version(implementation_version) {}
 
 void ApiLayerManifestFile::CreateIfValid(ManifestFileType type, const std::string &filename,
+                                         const std::unordered_set<std::string> *layer_names,
                                          std::vector<std::unique_ptr<ApiLayerManifestFile>> &manifest_files) {
-    std::ifstream json_stream(filename, std::ifstream::in);
-
     std::ostringstream error_ss("ApiLayerManifestFile::CreateIfValid ");
-    if (!json_stream.is_open()) {
+    std::shared_ptr<const CachedManifestJson> json = ManifestCache::Get().LoadJson(filename);
+    if (!json) {
         error_ss << "failed to open " << filename << ".  Does it exist?";
         LoaderLogger::LogErrorMessage("", error_ss.str());
         return;
     }
-
-    Json::CharReaderBuilder builder;
-    std::string errors;
-    Json::Value root_node = Json::nullValue;
-    if (!Json::parseFromStream(builder, json_stream, &root_node, &errors) || !root_node.isObject()) {
+    if (!json->parsed) {
         error_ss << "failed to parse " << filename << ".";
-        if (!errors.empty()) {
-            error_ss << " (Error message: " << errors << ")";
+        if (!json->errors.empty()) {
+            error_ss << " (Error message: " << json->errors << ")";
         }
         error_ss << " Is it a valid layer manifest file?";
         LoaderLogger::LogErrorMessage("", error_ss.str());
         return;
     }
+    const ManifestData &data = json->data;
     JsonVersion file_version = {};
-    if (!ManifestFile::IsValidJson(root_node, file_version)) {
+    if (!ManifestFile::IsValidJson(data, file_version)) {
         error_ss << "isValidJson indicates " << filename << " is not a valid manifest file.";
         LoaderLogger::LogErrorMessage("", error_ss.str());
         return;
     }
 
-    Json::Value layer_root_node = root_node["api_layer"];
+    const ManifestSection &layer_section = data.api_layer;
 
     // The API Layer manifest file needs the "api_layer" root as well as other sub-nodes.
     // If any of those aren't there, fail.
-    if (layer_root_node.isNull() || layer_root_node["name"].isNull() || !layer_root_node["name"].isString() ||
-        layer_root_node["api_version"].isNull() || !layer_root_node["api_version"].isString() ||
-        layer_root_node["library_path"].isNull() || !layer_root_node["library_path"].isString() ||
-        layer_root_node["implementation_version"].isNull() || !layer_root_node["implementation_version"].isString()) {
+    if (!layer_section.is_object || !layer_section.name.IsString() || !layer_section.api_version.IsString() ||
+        !layer_section.library_path.IsString() || !layer_section.implementation_version.IsString()) {
         error_ss << filename << " is missing required fields.  Verify all proper fields exist.";
         LoaderLogger::LogErrorMessage("", error_ss.str());
         return;
     }
+    if (layer_names != nullptr && layer_names->count(layer_section.name.string_value) == 0) {
+        // Not asked for, so skip checking its library and reading its extensions.
+        return;
+    }
     if (MANIFEST_TYPE_IMPLICIT_API_LAYER == type) {
         bool enabled = true;
         // Implicit layers require the disable environment variable.
-        if (layer_root_node["disable_environment"].isNull() || !layer_root_node["disable_environment"].isString()) {
+        if (!layer_section.disable_environment.IsString()) {
             error_ss << "Implicit layer " << filename << " is missing \"disable_environment\"";
             LoaderLogger::LogErrorMessage("", error_ss.str());
             return;
         }
         // Check if there's an enable environment variable provided
-        if (!layer_root_node["enable_environment"].isNull() && layer_root_node["enable_environment"].isString()) {
-            std::string env_var = layer_root_node["enable_environment"].asString();
+        if (layer_section.enable_environment.IsString()) {
+            const std::string &env_var = layer_section.enable_environment.string_value;
             // If it's not set in the environment, disable the layer
             if (!PlatformUtilsGetEnvSet(env_var.c_str())) {
                 enabled = false;
             }
         }
         // Check for the disable environment variable, which must be provided in the JSON
-        std::string env_var = layer_root_node["disable_environment"].asString();
+        const std::string &env_var = layer_section.disable_environment.string_value;
         // If the env var is set, disable the layer. Disable env var overrides enable above
         if (PlatformUtilsGetEnvSet(env_var.c_str())) {
             enabled = false;
@@ -728,8 +968,8 @@ void ApiLayerManifestFile::CreateIfValid(ManifestFileType type, const std::strin
             return;
         }
     }
-    std::string layer_name = layer_root_node["name"].asString();
-    std::string api_version_string = layer_root_node["api_version"].asString();
+    const std::string &layer_name = layer_section.name.string_value;
+    const std::string &api_version_string = layer_section.api_version.string_value;
     JsonVersion api_version = {};
     const int num_fields = sscanf(api_version_string.c_str(), "%u.%u", &api_version.major, &api_version.minor);
     api_version.patch = 0;
@@ -741,8 +981,8 @@ void ApiLayerManifestFile::CreateIfValid(ManifestFileType type, const std::strin
         return;
     }
 
-    uint32_t implementation_version = atoi(layer_root_node["implementation_version"].asString().c_str());
-    std::string library_path = layer_root_node["library_path"].asString();
+    uint32_t implementation_version = atoi(layer_section.implementation_version.string_value.c_str());
+    std::string library_path = layer_section.library_path.string_value;
 
     // If the library_path variable has no directory symbol, it's just a file name and should be accessible on the
     // global library path.
@@ -769,8 +1009,8 @@ void ApiLayerManifestFile::CreateIfValid(ManifestFileType type, const std::strin
     }
 
     std::string description;
-    if (!layer_root_node["description"].isNull() && layer_root_node["description"].isString()) {
-        description = layer_root_node["description"].asString();
+    if (layer_section.description.IsString()) {
+        description = layer_section.description.string_value;
     }
 
     // Add this layer manifest file
@@ -778,7 +1018,7 @@ void ApiLayerManifestFile::CreateIfValid(ManifestFileType type, const std::strin
         new ApiLayerManifestFile(type, filename, layer_name, description, api_version, implementation_version, library_path));
 
     // Add any extensions to it after the fact.
-    manifest_files.back()->ParseCommon(layer_root_node);
+    manifest_files.back()->ParseCommon(layer_section);
 }
 
 void ApiLayerManifestFile::PopulateApiLayerProperties(XrApiLayerProperties &props) const {
@@ -796,7 +1036,8 @@ void ApiLayerManifestFile::PopulateApiLayerProperties(XrApiLayerProperties &prop
 
 // Find all layer manifest files in the appropriate search paths/registries for the given type.
 XrResult ApiLayerManifestFile::FindManifestFiles(ManifestFileType type,
-                                                 std::vector<std::unique_ptr<ApiLayerManifestFile>> &manifest_files) {
+                                                 std::vector<std::unique_ptr<ApiLayerManifestFile>> &manifest_files,
+                                                 const std::unordered_set<std::string> *layer_names) {
     std::string relative_path;
     std::string override_env_var;
     std::string registry_location;
@@ -837,8 +1078,21 @@ XrResult ApiLayerManifestFile::FindManifestFiles(ManifestFileType type,
     }
 #endif
 
+    RemoveDuplicateManifestFiles(filenames);
+
+    // Read and parse the manifests missing from the cache in parallel, then validate them all in order so that
+    // logging and the resulting layer order are the same as reading them one at a time.  A warm cache starts no
+    // threads.
+    std::vector<const std::string *> to_load;
+    for (const std::string &cur_file : filenames) {
+        if (ManifestCache::Get().NeedsLoad(cur_file)) {
+            to_load.push_back(&cur_file);
+        }
+    }
+    LoaderParallelFor(to_load.size(), [&](size_t index) { ManifestCache::Get().LoadJson(*to_load[index]); });
+
     for (std::string &cur_file : filenames) {
-        ApiLayerManifestFile::CreateIfValid(type, cur_file, manifest_files);
+        ApiLayerManifestFile::CreateIfValid(type, cur_file, layer_names, manifest_files);
     }
 
     return XR_SUCCESS;
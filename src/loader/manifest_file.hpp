@@ -15,11 +15,15 @@
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 
 namespace Json {
 class Value;
 }
 
+struct ManifestData;
+struct ManifestSection;
+
 enum ManifestFileType {
     MANIFEST_TYPE_UNDEFINED = 0,
     MANIFEST_TYPE_RUNTIME,
@@ -54,8 +58,8 @@ class ManifestFile {
 
    protected:
     ManifestFile(ManifestFileType type, const std::string &filename, const std::string &library_path);
-    void ParseCommon(Json::Value const &root_node);
-    static bool IsValidJson(const Json::Value &root, JsonVersion &version);
+    void ParseCommon(const ManifestSection &section);
+    static bool IsValidJson(const ManifestData &data, JsonVersion &version);
 
    private:
     std::string _filename;
@@ -77,14 +81,19 @@ class RuntimeManifestFile : public ManifestFile {
     static void CreateIfValid(const std::string &filename, std::vector<std::unique_ptr<RuntimeManifestFile>> &manifest_files);
     static void CreateIfValid(const Json::Value &root_node, const std::string &filename,
                               std::vector<std::unique_ptr<RuntimeManifestFile>> &manifest_files);
+    static void CreateIfValid(const ManifestData &data, const std::string &filename,
+                              std::vector<std::unique_ptr<RuntimeManifestFile>> &manifest_files);
 };
 
 // ApiLayerManifestFile class -
 // Responsible for finding and parsing API Layer-specific manifest files.
 class ApiLayerManifestFile : public ManifestFile {
    public:
-    // Factory method
-    static XrResult FindManifestFiles(ManifestFileType type, std::vector<std::unique_ptr<ApiLayerManifestFile>> &manifest_files);
+    // Factory method.  A manifest reachable through several search paths, directly or through symbolic links, is only
+    // read once, in the place first in search order.  If layer_names is not null only the manifests of the named layers
+    // are validated and kept; the rest are only read far enough to learn their names.
+    static XrResult FindManifestFiles(ManifestFileType type, std::vector<std::unique_ptr<ApiLayerManifestFile>> &manifest_files,
+                                      const std::unordered_set<std::string> *layer_names = nullptr);
 
     const std::string &LayerName() const { return _layer_name; }
     void PopulateApiLayerProperties(XrApiLayerProperties &props) const;
@@ -93,7 +102,7 @@ class ApiLayerManifestFile : public ManifestFile {
     ApiLayerManifestFile(ManifestFileType type, const std::string &filename, const std::string &layer_name,
                          const std::string &description, const JsonVersion &api_version, const uint32_t &implementation_version,
                          const std::string &library_path);
-    static void CreateIfValid(ManifestFileType type, const std::string &filename,
+    static void CreateIfValid(ManifestFileType type, const std::string &filename, const std::unordered_set<std::string> *layer_names,
                               std::vector<std::unique_ptr<ApiLayerManifestFile>> &manifest_files);
 
     JsonVersion _api_version;
@@ -0,0 +1,522 @@
+// Copyright (c) 2017-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0 OR MIT
+//
+
+#include "manifest_reader.hpp"
+
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <string>
+
+// Same nesting limit jsoncpp applies by default.
+static const int kMaxManifestDepth = 1000;
+
+static bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+
+static int HexValue(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+static void AppendUtf8(uint32_t code_point, std::string& out) {
+    if (code_point < 0x80) {
+        out += static_cast<char>(code_point);
+    } else if (code_point < 0x800) {
+        out += static_cast<char>(0xC0 | (code_point >> 6));
+        out += static_cast<char>(0x80 | (code_point & 0x3F));
+    } else if (code_point < 0x10000) {
+        out += static_cast<char>(0xE0 | (code_point >> 12));
+        out += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (code_point & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (code_point >> 18));
+        out += static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (code_point & 0x3F));
+    }
+}
+
+bool ManifestReader::Parse(const char* begin, const char* end, ManifestData& data, std::string& error) {
+    // Skip a UTF-8 byte order mark.
+    if (end - begin >= 3 && memcmp(begin, "\xEF\xBB\xBF", 3) == 0) {
+        begin += 3;
+    }
+    ManifestReader reader(begin, end);
+    data = ManifestData{};
+    if (!reader.ParseRoot(data)) {
+        error = reader._error;
+        return false;
+    }
+    return true;
+}
+
+bool ManifestReader::ParseRoot(ManifestData& data) {
+    if (!BeginObject()) {
+        return Fail("root value must be an object");
+    }
+    bool first = true;
+    while (NextMember(first)) {
+        bool ok;
+        if (_key == "file_format_version") {
+            ok = ParseScalar(data.file_format_version);
+        } else if (_key == "runtime") {
+            ok = ParseSection(data.runtime);
+        } else if (_key == "api_layer") {
+            ok = ParseSection(data.api_layer);
+        } else {
+            ok = SkipValue(1);
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+    return !Failed();
+}
+
+bool ManifestReader::ParseSection(ManifestSection& section) {
+    // A repeated section replaces the earlier one, matching how jsoncpp handles duplicate keys.
+    section = ManifestSection{};
+    section.present = true;
+    if (!BeginObject()) {
+        return SkipValue(1);
+    }
+    section.is_object = true;
+
+    bool first = true;
+    while (NextMember(first)) {
+        bool ok;
+        if (_key == "name") {
+            ok = ParseScalar(section.name);
+        } else if (_key == "library_path") {
+            ok = ParseScalar(section.library_path);
+        } else if (_key == "api_version") {
+            ok = ParseScalar(section.api_version);
+        } else if (_key == "implementation_version") {
+            ok = ParseScalar(section.implementation_version);
+        } else if (_key == "description") {
+            ok = ParseScalar(section.description);
+        } else if (_key == "disable_environment") {
+            ok = ParseScalar(section.disable_environment);
+        } else if (_key == "enable_environment") {
+            ok = ParseScalar(section.enable_environment);
+        } else if (_key == "instance_extensions") {
+            section.instance_extensions.clear();
+            if (BeginArray()) {
+                bool first_element = true;
+                ok = true;
+                while (ok && NextElement(first_element)) {
+                    if (BeginObject()) {
+                        section.instance_extensions.emplace_back();
+                        ok = ParseExtension(section.instance_extensions.back());
+                    } else {
+                        ok = SkipValue(3);
+                    }
+                }
+                ok = ok && !Failed();
+            } else {
+                ok = SkipValue(2);
+            }
+        } else if (_key == "functions") {
+            section.functions.clear();
+            ok = BeginObject() ? ParseFunctions(section) : SkipValue(2);
+        } else {
+            ok = SkipValue(2);
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+    return !Failed();
+}
+
+bool ManifestReader::ParseExtension(ManifestExtension& extension) {
+    bool first = true;
+    while (NextMember(first)) {
+        bool ok;
+        if (_key == "name") {
+            ok = ParseScalar(extension.name);
+        } else if (_key == "extension_version") {
+            ok = ParseScalar(extension.extension_version);
+        } else {
+            ok = SkipValue(4);
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+    return !Failed();
+}
+
+bool ManifestReader::ParseFunctions(ManifestSection& section) {
+    bool first = true;
+    while (NextMember(first)) {
+        ManifestScalar value;
+        if (!ParseScalar(value)) {
+            return false;
+        }
+        bool replaced = false;
+        for (auto& function : section.functions) {
+            if (function.first == _key) {
+                function.second = std::move(value);
+                replaced = true;
+                break;
+            }
+        }
+        if (!replaced) {
+            section.functions.emplace_back(_key, std::move(value));
+        }
+    }
+    return !Failed();
+}
+
+bool ManifestReader::ParseScalar(ManifestScalar& scalar) {
+    SkipWhitespace();
+    scalar = ManifestScalar{};
+    if (_cur < _end && *_cur == '"') {
+        scalar.type = ManifestScalar::String;
+        return ParseString(&scalar.string_value);
+    }
+    if (_cur < _end && (*_cur == '-' || IsDigit(*_cur))) {
+        return ParseNumber(&scalar);
+    }
+    scalar.type = ManifestScalar::Other;
+    return SkipValue(3);
+}
+
+// Parses a string starting at the opening quote.  If out is null the string is only validated and skipped.
+bool ManifestReader::ParseString(std::string* out) {
+    ++_cur;  // opening quote
+    while (_cur < _end) {
+        // Copy runs of plain characters in one go.
+        const char* run_start = _cur;
+        while (_cur < _end && *_cur != '"' && *_cur != '\\') {
+            ++_cur;
+        }
+        if (out != nullptr) {
+            out->append(run_start, _cur);
+        }
+        if (_cur >= _end) {
+            break;
+        }
+        if (*_cur == '"') {
+            ++_cur;
+            return true;
+        }
+
+        // Escape sequence
+        ++_cur;
+        if (_cur >= _end) {
+            break;
+        }
+        char escaped = *_cur++;
+        char decoded = 0;
+        switch (escaped) {
+            case '"':
+            case '\\':
+            case '/':
+                decoded = escaped;
+                break;
+            case 'b':
+                decoded = '\b';
+                break;
+            case 'f':
+                decoded = '\f';
+                break;
+            case 'n':
+                decoded = '\n';
+                break;
+            case 'r':
+                decoded = '\r';
+                break;
+            case 't':
+                decoded = '\t';
+                break;
+            case 'u': {
+                auto read_hex4 = [this](uint32_t& value) {
+                    if (_end - _cur < 4) {
+                        return false;
+                    }
+                    value = 0;
+                    for (int i = 0; i < 4; ++i) {
+                        int digit = HexValue(*_cur++);
+                        if (digit < 0) {
+                            return false;
+                        }
+                        value = (value << 4) | static_cast<uint32_t>(digit);
+                    }
+                    return true;
+                };
+                uint32_t code_point;
+                if (!read_hex4(code_point)) {
+                    return Fail("bad unicode escape sequence in string");
+                }
+                if (code_point >= 0xD800 && code_point <= 0xDBFF) {
+                    // Surrogate pair
+                    uint32_t low;
+                    if (_end - _cur < 2 || _cur[0] != '\\' || _cur[1] != 'u') {
+                        return Fail("expected a low surrogate in unicode escape sequence");
+                    }
+                    _cur += 2;
+                    if (!read_hex4(low) || low < 0xDC00 || low > 0xDFFF) {
+                        return Fail("bad low surrogate in unicode escape sequence");
+                    }
+                    code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+                }
+                if (out != nullptr) {
+                    AppendUtf8(code_point, *out);
+                }
+                continue;
+            }
+            default:
+                return Fail("bad escape sequence in string");
+        }
+        if (out != nullptr) {
+            *out += decoded;
+        }
+    }
+    return Fail("missing '\"' at the end of a string");
+}
+
+// Parses a number.  If scalar is null the number is only validated and skipped.
+bool ManifestReader::ParseNumber(ManifestScalar* scalar) {
+    bool negative = false;
+    bool integral = true;
+    if (*_cur == '-') {
+        negative = true;
+        ++_cur;
+    }
+    if (_cur >= _end || !IsDigit(*_cur)) {
+        return Fail("bad number");
+    }
+    uint64_t value = 0;
+    bool overflow = false;
+    while (_cur < _end && IsDigit(*_cur)) {
+        value = value * 10 + static_cast<uint64_t>(*_cur - '0');
+        if (value > std::numeric_limits<uint32_t>::max()) {
+            overflow = true;
+            value = std::numeric_limits<uint32_t>::max();
+        }
+        ++_cur;
+    }
+    if (_cur < _end && *_cur == '.') {
+        ++_cur;
+        if (_cur >= _end || !IsDigit(*_cur)) {
+            return Fail("bad number");
+        }
+        while (_cur < _end && IsDigit(*_cur)) {
+            // A fraction of all zeros still names an integer, which jsoncpp also reports as an unsigned int.
+            if (*_cur != '0') {
+                integral = false;
+            }
+            ++_cur;
+        }
+    }
+    if (_cur < _end && (*_cur == 'e' || *_cur == 'E')) {
+        // Exponents are never used for the values the loader reads; treat them as some other number.
+        integral = false;
+        ++_cur;
+        if (_cur < _end && (*_cur == '+' || *_cur == '-')) {
+            ++_cur;
+        }
+        if (_cur >= _end || !IsDigit(*_cur)) {
+            return Fail("bad number");
+        }
+        while (_cur < _end && IsDigit(*_cur)) {
+            ++_cur;
+        }
+    }
+    if (scalar != nullptr) {
+        if (integral && !overflow && (!negative || value == 0)) {
+            scalar->type = ManifestScalar::UInt;
+            scalar->uint_value = static_cast<uint32_t>(value);
+        } else {
+            scalar->type = ManifestScalar::Other;
+        }
+    }
+    return true;
+}
+
+bool ManifestReader::SkipValue(int depth) {
+    if (depth > kMaxManifestDepth) {
+        return Fail("exceeded the maximum nesting depth");
+    }
+    SkipWhitespace();
+    if (_cur >= _end) {
+        return Fail("unexpected end of file, expected a value");
+    }
+    switch (*_cur) {
+        case '{': {
+            BeginObject();
+            bool first = true;
+            while (NextMember(first)) {
+                if (!SkipValue(depth + 1)) {
+                    return false;
+                }
+            }
+            return !Failed();
+        }
+        case '[': {
+            BeginArray();
+            bool first = true;
+            while (NextElement(first)) {
+                if (!SkipValue(depth + 1)) {
+                    return false;
+                }
+            }
+            return !Failed();
+        }
+        case '"':
+            return ParseString(nullptr);
+        case 't':
+            return SkipLiteral("true");
+        case 'f':
+            return SkipLiteral("false");
+        case 'n':
+            return SkipLiteral("null");
+        default:
+            if (*_cur == '-' || IsDigit(*_cur)) {
+                return ParseNumber(nullptr);
+            }
+            return Fail("syntax error, expected a value");
+    }
+}
+
+bool ManifestReader::SkipLiteral(const char* literal) {
+    const size_t length = strlen(literal);
+    if (static_cast<size_t>(_end - _cur) < length || strncmp(_cur, literal, length) != 0) {
+        return Fail("syntax error, expected a value");
+    }
+    _cur += length;
+    return true;
+}
+
+bool ManifestReader::BeginObject() {
+    SkipWhitespace();
+    if (_cur < _end && *_cur == '{') {
+        ++_cur;
+        return true;
+    }
+    return false;
+}
+
+bool ManifestReader::NextMember(bool& first) {
+    SkipWhitespace();
+    if (_cur >= _end) {
+        return Fail("missing '}' at the end of an object");
+    }
+    if (*_cur == '}') {
+        ++_cur;
+        return false;
+    }
+    if (!first) {
+        if (*_cur != ',') {
+            return Fail("missing ',' or '}' in object declaration");
+        }
+        ++_cur;
+        SkipWhitespace();
+        // Trailing commas are accepted, as they were by the jsoncpp defaults.
+        if (_cur < _end && *_cur == '}') {
+            ++_cur;
+            return false;
+        }
+    }
+    first = false;
+
+    if (_cur >= _end || *_cur != '"') {
+        return Fail("missing '\"' at the start of an object member name");
+    }
+    _key.clear();
+    if (!ParseString(&_key)) {
+        return false;
+    }
+    SkipWhitespace();
+    if (_cur >= _end || *_cur != ':') {
+        return Fail("missing ':' after object member name");
+    }
+    ++_cur;
+    return true;
+}
+
+bool ManifestReader::BeginArray() {
+    SkipWhitespace();
+    if (_cur < _end && *_cur == '[') {
+        ++_cur;
+        return true;
+    }
+    return false;
+}
+
+bool ManifestReader::NextElement(bool& first) {
+    SkipWhitespace();
+    if (_cur >= _end) {
+        return Fail("missing ']' at the end of an array");
+    }
+    if (*_cur == ']') {
+        ++_cur;
+        return false;
+    }
+    if (!first) {
+        if (*_cur != ',') {
+            return Fail("missing ',' or ']' in array declaration");
+        }
+        ++_cur;
+        SkipWhitespace();
+        if (_cur < _end && *_cur == ']') {
+            ++_cur;
+            return false;
+        }
+    }
+    first = false;
+    return true;
+}
+
+void ManifestReader::SkipWhitespace() {
+    while (_cur < _end) {
+        const char c = *_cur;
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+            ++_cur;
+        } else if (c == '/' && _end - _cur >= 2 && _cur[1] == '/') {
+            while (_cur < _end && *_cur != '\n') {
+                ++_cur;
+            }
+        } else if (c == '/' && _end - _cur >= 2 && _cur[1] == '*') {
+            _cur += 2;
+            while (_end - _cur >= 2 && !(_cur[0] == '*' && _cur[1] == '/')) {
+                ++_cur;
+            }
+            _cur = (_end - _cur >= 2) ? _cur + 2 : _end;
+        } else {
+            break;
+        }
+    }
+}
+
+bool ManifestReader::Fail(const char* message) {
+    if (Failed()) {
+        return false;
+    }
+    int line = 1;
+    int column = 1;
+    for (const char* c = _begin; c < _cur && c < _end; ++c) {
+        if (*c == '\n') {
+            ++line;
+            column = 1;
+        } else {
+            ++column;
+        }
+    }
+    std::ostringstream error_ss;
+    error_ss << "Line " << line << ", Column " << column << ": " << message;
+    _error = error_ss.str();
+    return false;
+}
@@ -0,0 +1,97 @@
+// Copyright (c) 2017-2022, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: Apache-2.0 OR MIT
+//
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+// A single value read from a manifest.  Only strings and unsigned integers are kept; any other kind of JSON
+// value (objects, arrays, booleans, null, negative or fractional numbers) is recorded as Other so that
+// callers can still tell "present but the wrong type" apart from "missing".
+struct ManifestScalar {
+    enum Type { Missing, String, UInt, Other };
+
+    Type type = Missing;
+    std::string string_value;
+    uint32_t uint_value = 0;
+
+    bool IsMissing() const { return type == Missing; }
+    bool IsString() const { return type == String; }
+    bool IsUInt() const { return type == UInt; }
+};
+
+struct ManifestExtension {
+    ManifestScalar name;
+    ManifestScalar extension_version;
+};
+
+// The "runtime" or "api_layer" object of a manifest, reduced to the members the loader uses.
+struct ManifestSection {
+    bool present = false;
+    bool is_object = false;
+
+    ManifestScalar name;
+    ManifestScalar library_path;
+    ManifestScalar api_version;
+    ManifestScalar implementation_version;
+    ManifestScalar description;
+    ManifestScalar disable_environment;
+    ManifestScalar enable_environment;
+
+    // Only object elements of an "instance_extensions" array are recorded.
+    std::vector<ManifestExtension> instance_extensions;
+
+    // Members of a "functions" object, in file order, with later duplicates replacing earlier ones.
+    std::vector<std::pair<std::string, ManifestScalar>> functions;
+};
+
+struct ManifestData {
+    ManifestScalar file_format_version;
+    ManifestSection runtime;
+    ManifestSection api_layer;
+};
+
+// Single-pass reader for runtime and API layer manifest files.  Instead of building a full JSON document
+// it walks the text once, records the handful of fields the loader looks at, and skips everything else
+// without allocating.  Accepts the same input as the jsoncpp defaults the loader used before, including
+// C and C++ style comments and trailing content after the root object.
+class ManifestReader {
+   public:
+    // Parses manifest text held in memory.  Returns false and sets the error on syntax errors.
+    static bool Parse(const char* begin, const char* end, ManifestData& data, std::string& error);
+
+   private:
+    ManifestReader(const char* begin, const char* end) : _begin(begin), _cur(begin), _end(end) {}
+
+    bool ParseRoot(ManifestData& data);
+    bool ParseSection(ManifestSection& section);
+    bool ParseExtension(ManifestExtension& extension);
+    bool ParseFunctions(ManifestSection& section);
+    bool ParseScalar(ManifestScalar& scalar);
+    bool ParseString(std::string* out);
+    bool ParseNumber(ManifestScalar* scalar);
+    bool SkipValue(int depth);
+    bool SkipLiteral(const char* literal);
+
+    // Iterates the members of an object.  Call BeginObject once, then NextMember until it returns false;
+    // check Failed() afterwards to tell the end of the object apart from an error.
+    bool BeginObject();
+    bool NextMember(bool& first);
+    bool BeginArray();
+    bool NextElement(bool& first);
+
+    void SkipWhitespace();
+    bool Fail(const char* message);
+    bool Failed() const { return !_error.empty(); }
+
+    const char* _begin;
+    const char* _cur;
+    const char* _end;
+    std::string _key;
+    std::string _error;
+};
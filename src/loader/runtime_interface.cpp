@@ -13,6 +13,8 @@
 #include "loader_interfaces.h"
 #include "loader_logger.hpp"
 #include "loader_platform.hpp"
+#include "loader_startup_profile.hpp"
+#include "platform_utils.hpp"
 #include "xr_generated_dispatch_table.h"
 
 #include <openxr/openxr.h>
@@ -112,12 +114,39 @@ XrResult InitializeLoader(const XrLoaderInitInfoBaseHeaderKHR* loaderInitInfo) {
 #endif  // XR_KHR_LOADER_INIT_SUPPORT
 
 #ifdef XR_USE_PLATFORM_ANDROID
+namespace {
+/*!
+ * The virtual manifest last built from the runtime broker, so that loading the runtime again in the same process does
+ * not repeat the broker queries, which are cross-process calls.
+ */
+struct VirtualManifestCache {
+    static VirtualManifestCache& instance() {
+        static VirtualManifestCache obj;
+        return obj;
+    }
+
+    std::mutex mutex;
+    bool valid = false;
+    //! The application context the manifest was queried with.
+    void* context = nullptr;
+    Json::Value manifest;
+};
+}  // namespace
+
 XrResult GetPlatformRuntimeVirtualManifest(Json::Value& out_manifest) {
     using wrap::android::content::Context;
     auto& initData = LoaderInitData::instance();
     if (!initData.initialized()) {
         return XR_ERROR_INITIALIZATION_FAILED;
     }
+
+    auto& cache = VirtualManifestCache::instance();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    if (cache.valid && cache.context == initData.getData().applicationContext) {
+        out_manifest = cache.manifest;
+        return XR_SUCCESS;
+    }
+
     auto context = Context(reinterpret_cast<jobject>(initData.getData().applicationContext));
     if (context.isNull()) {
         return XR_ERROR_INITIALIZATION_FAILED;
@@ -126,14 +155,126 @@ XrResult GetPlatformRuntimeVirtualManifest(Json::Value& out_manifest) {
     if (0 != openxr_android::getActiveRuntimeVirtualManifest(context, virtualManifest)) {
         return XR_ERROR_INITIALIZATION_FAILED;
     }
+    cache.valid = true;
+    cache.context = initData.getData().applicationContext;
+    cache.manifest = virtualManifest;
     out_manifest = virtualManifest;
     return XR_SUCCESS;
 }
+
+void InvalidatePlatformRuntimeVirtualManifest() {
+    auto& cache = VirtualManifestCache::instance();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    cache.valid = false;
+    cache.manifest = Json::Value();
+}
 #endif  // XR_USE_PLATFORM_ANDROID
 
+#ifdef XR_LOADER_STATIC_RUNTIME_NEGOTIATE
+// The negotiate entry point of the runtime linked into the loader, named by the LOADER_STATIC_RUNTIME_NEGOTIATE_FUNCTION
+// CMake option.
+extern "C" XRAPI_ATTR XrResult XRAPI_CALL XR_LOADER_STATIC_RUNTIME_NEGOTIATE(const XrNegotiateLoaderInfo* loaderInfo,
+                                                                              XrNegotiateRuntimeRequest* runtimeRequest);
+#endif  // XR_LOADER_STATIC_RUNTIME_NEGOTIATE
+
+namespace {
+// Settles on a runtime interface version with the negotiate function, if there is one, and checks what the runtime
+// returned. The source names the runtime in error messages, the profile_name in the startup profile.
+XrResult NegotiateRuntime(const std::string& openxr_command, const std::string& source, const std::string& profile_name,
+                          PFN_xrNegotiateLoaderRuntimeInterface negotiate, XrNegotiateRuntimeRequest& runtime_info) {
+    // Loader info for negotiation
+    XrNegotiateLoaderInfo loader_info = {};
+    loader_info.structType = XR_LOADER_INTERFACE_STRUCT_LOADER_INFO;
+    loader_info.structVersion = XR_LOADER_INFO_STRUCT_VERSION;
+    loader_info.structSize = sizeof(XrNegotiateLoaderInfo);
+    loader_info.minInterfaceVersion = 1;
+    loader_info.maxInterfaceVersion = XR_CURRENT_LOADER_RUNTIME_VERSION;
+    loader_info.minApiVersion = XR_MAKE_VERSION(1, 0, 0);
+    loader_info.maxApiVersion = XR_MAKE_VERSION(1, 0x3ff, 0xfff);  // Maximum allowed version for this major version.
+
+    // Set up the runtime return structure
+    runtime_info = {};
+    runtime_info.structType = XR_LOADER_INTERFACE_STRUCT_RUNTIME_REQUEST;
+    runtime_info.structVersion = XR_RUNTIME_INFO_STRUCT_VERSION;
+    runtime_info.structSize = sizeof(XrNegotiateRuntimeRequest);
+
+    // Skip calling the negotiate function and fail if the function pointer
+    // could not get loaded
+    XrResult res = XR_ERROR_RUNTIME_FAILURE;
+    if (nullptr != negotiate) {
+        LoaderStartupTimer timer("negotiate runtime", profile_name);
+        res = negotiate(&loader_info, &runtime_info);
+    }
+    // If we supposedly succeeded, but got a nullptr for GetInstanceProcAddr
+    // then something still went wrong, so return with an error.
+    if (XR_SUCCEEDED(res)) {
+        uint32_t runtime_major = XR_VERSION_MAJOR(runtime_info.runtimeApiVersion);
+        uint32_t runtime_minor = XR_VERSION_MINOR(runtime_info.runtimeApiVersion);
+        uint32_t loader_major = XR_VERSION_MAJOR(XR_CURRENT_API_VERSION);
+        if (nullptr == runtime_info.getInstanceProcAddr) {
+            std::string error_message = "RuntimeInterface::LoadRuntime skipping ";
+            error_message += source;
+            error_message += ", negotiation succeeded but returned NULL getInstanceProcAddr";
+            LoaderLogger::LogErrorMessage(openxr_command, error_message);
+            res = XR_ERROR_FILE_CONTENTS_INVALID;
+        } else if (0 >= runtime_info.runtimeInterfaceVersion ||
+                   XR_CURRENT_LOADER_RUNTIME_VERSION < runtime_info.runtimeInterfaceVersion) {
+            std::string error_message = "RuntimeInterface::LoadRuntime skipping ";
+            error_message += source;
+            error_message += ", negotiation succeeded but returned invalid interface version";
+            LoaderLogger::LogErrorMessage(openxr_command, error_message);
+            res = XR_ERROR_FILE_CONTENTS_INVALID;
+        } else if (runtime_major != loader_major || (runtime_major == 0 && runtime_minor == 0)) {
+            std::string error_message = "RuntimeInterface::LoadRuntime skipping ";
+            error_message += source;
+            error_message += ", OpenXR version returned not compatible with this loader";
+            LoaderLogger::LogErrorMessage(openxr_command, error_message);
+            res = XR_ERROR_FILE_CONTENTS_INVALID;
+        }
+    }
+    return res;
+}
+
+#ifdef XR_KHR_LOADER_INIT_SUPPORT
+// Forwards xrInitializeLoaderKHR to a negotiated runtime through its xrGetInstanceProcAddr, if it has it.
+XrResult ForwardInitializeLoader(const std::string& openxr_command, PFN_xrGetInstanceProcAddr get_instance_proc_addr) {
+    XrResult res = XR_SUCCESS;
+    PFN_xrVoidFunction initializeVoid = nullptr;
+    PFN_xrInitializeLoaderKHR initialize = nullptr;
+
+    // Now we may try asking xrGetInstanceProcAddr
+    if (XR_SUCCEEDED(get_instance_proc_addr(XR_NULL_HANDLE, "xrInitializeLoaderKHR", &initializeVoid))) {
+        if (initializeVoid == nullptr) {
+            LoaderLogger::LogErrorMessage(openxr_command,
+                                          "RuntimeInterface::LoadRuntime got success from xrGetInstanceProcAddr "
+                                          "for xrInitializeLoaderKHR, but output a null pointer.");
+            res = XR_ERROR_RUNTIME_FAILURE;
+        } else {
+            initialize = reinterpret_cast<PFN_xrInitializeLoaderKHR>(initializeVoid);
+        }
+    }
+    if (initialize != nullptr) {
+        // we found the entry point one way or another.
+        LoaderLogger::LogInfoMessage(openxr_command,
+                                     "RuntimeInterface::LoadRuntime forwarding xrInitializeLoaderKHR call to runtime after "
+                                     "calling xrNegotiateLoaderRuntimeInterface.");
+        res = initialize(LoaderInitData::instance().getParam());
+        if (!XR_SUCCEEDED(res)) {
+            LoaderLogger::LogErrorMessage(openxr_command, "RuntimeInterface::LoadRuntime forwarded call to xrInitializeLoaderKHR failed.");
+        }
+    }
+    return res;
+}
+#endif  // XR_KHR_LOADER_INIT_SUPPORT
+}  // namespace
+
 XrResult RuntimeInterface::TryLoadingSingleRuntime(const std::string& openxr_command,
                                                    std::unique_ptr<RuntimeManifestFile>& manifest_file) {
-    LoaderPlatformLibraryHandle runtime_library = LoaderPlatformLibraryOpen(manifest_file->LibraryPath());
+    LoaderPlatformLibraryHandle runtime_library;
+    {
+        LoaderStartupTimer timer("open runtime", manifest_file->LibraryPath());
+        runtime_library = LoaderPlatformLibraryOpen(manifest_file->LibraryPath());
+    }
     if (nullptr == runtime_library) {
         std::string library_message = LoaderPlatformLibraryOpenError(manifest_file->LibraryPath());
         std::string warning_message = "RuntimeInterface::LoadRuntime skipping manifest file ";
@@ -182,83 +323,13 @@ XrResult RuntimeInterface::TryLoadingSingleRuntime(const std::string& openxr_com
     auto negotiate =
         reinterpret_cast<PFN_xrNegotiateLoaderRuntimeInterface>(LoaderPlatformLibraryGetProcAddr(runtime_library, function_name));
 
-    // Loader info for negotiation
-    XrNegotiateLoaderInfo loader_info = {};
-    loader_info.structType = XR_LOADER_INTERFACE_STRUCT_LOADER_INFO;
-    loader_info.structVersion = XR_LOADER_INFO_STRUCT_VERSION;
-    loader_info.structSize = sizeof(XrNegotiateLoaderInfo);
-    loader_info.minInterfaceVersion = 1;
-    loader_info.maxInterfaceVersion = XR_CURRENT_LOADER_RUNTIME_VERSION;
-    loader_info.minApiVersion = XR_MAKE_VERSION(1, 0, 0);
-    loader_info.maxApiVersion = XR_MAKE_VERSION(1, 0x3ff, 0xfff);  // Maximum allowed version for this major version.
-
-    // Set up the runtime return structure
     XrNegotiateRuntimeRequest runtime_info = {};
-    runtime_info.structType = XR_LOADER_INTERFACE_STRUCT_RUNTIME_REQUEST;
-    runtime_info.structVersion = XR_RUNTIME_INFO_STRUCT_VERSION;
-    runtime_info.structSize = sizeof(XrNegotiateRuntimeRequest);
-
-    // Skip calling the negotiate function and fail if the function pointer
-    // could not get loaded
-    XrResult res = XR_ERROR_RUNTIME_FAILURE;
-    if (nullptr != negotiate) {
-        res = negotiate(&loader_info, &runtime_info);
-    }
-    // If we supposedly succeeded, but got a nullptr for GetInstanceProcAddr
-    // then something still went wrong, so return with an error.
-    if (XR_SUCCEEDED(res)) {
-        uint32_t runtime_major = XR_VERSION_MAJOR(runtime_info.runtimeApiVersion);
-        uint32_t runtime_minor = XR_VERSION_MINOR(runtime_info.runtimeApiVersion);
-        uint32_t loader_major = XR_VERSION_MAJOR(XR_CURRENT_API_VERSION);
-        if (nullptr == runtime_info.getInstanceProcAddr) {
-            std::string error_message = "RuntimeInterface::LoadRuntime skipping manifest file ";
-            error_message += manifest_file->Filename();
-            error_message += ", negotiation succeeded but returned NULL getInstanceProcAddr";
-            LoaderLogger::LogErrorMessage(openxr_command, error_message);
-            res = XR_ERROR_FILE_CONTENTS_INVALID;
-        } else if (0 >= runtime_info.runtimeInterfaceVersion ||
-                   XR_CURRENT_LOADER_RUNTIME_VERSION < runtime_info.runtimeInterfaceVersion) {
-            std::string error_message = "RuntimeInterface::LoadRuntime skipping manifest file ";
-            error_message += manifest_file->Filename();
-            error_message += ", negotiation succeeded but returned invalid interface version";
-            LoaderLogger::LogErrorMessage(openxr_command, error_message);
-            res = XR_ERROR_FILE_CONTENTS_INVALID;
-        } else if (runtime_major != loader_major || (runtime_major == 0 && runtime_minor == 0)) {
-            std::string error_message = "RuntimeInterface::LoadRuntime skipping manifest file ";
-            error_message += manifest_file->Filename();
-            error_message += ", OpenXR version returned not compatible with this loader";
-            LoaderLogger::LogErrorMessage(openxr_command, error_message);
-            res = XR_ERROR_FILE_CONTENTS_INVALID;
-        }
-    }
+    XrResult res = NegotiateRuntime(openxr_command, "manifest file " + manifest_file->Filename(), manifest_file->LibraryPath(),
+                                    negotiate, runtime_info);
 #ifdef XR_KHR_LOADER_INIT_SUPPORT
     if (XR_SUCCEEDED(res) && !forwardedInitLoader) {
         // Forward initialize loader call, where possible and if we did not do so before.
-        PFN_xrVoidFunction initializeVoid = nullptr;
-        PFN_xrInitializeLoaderKHR initialize = nullptr;
-
-        // Now we may try asking xrGetInstanceProcAddr
-        if (XR_SUCCEEDED(runtime_info.getInstanceProcAddr(XR_NULL_HANDLE, "xrInitializeLoaderKHR", &initializeVoid))) {
-            if (initializeVoid == nullptr) {
-                LoaderLogger::LogErrorMessage(openxr_command,
-                                              "RuntimeInterface::LoadRuntime got success from xrGetInstanceProcAddr "
-                                              "for xrInitializeLoaderKHR, but output a null pointer.");
-                res = XR_ERROR_RUNTIME_FAILURE;
-            } else {
-                initialize = reinterpret_cast<PFN_xrInitializeLoaderKHR>(initializeVoid);
-            }
-        }
-        if (initialize != nullptr) {
-            // we found the entry point one way or another.
-            LoaderLogger::LogInfoMessage(openxr_command,
-                                         "RuntimeInterface::LoadRuntime forwarding xrInitializeLoaderKHR call to runtime after "
-                                         "calling xrNegotiateLoaderRuntimeInterface.");
-            res = initialize(LoaderInitData::instance().getParam());
-            if (!XR_SUCCEEDED(res)) {
-                LoaderLogger::LogErrorMessage(openxr_command,
-                                              "RuntimeInterface::LoadRuntime forwarded call to xrInitializeLoaderKHR failed.");
-            }
-        }
+        res = ForwardInitializeLoader(openxr_command, runtime_info.getInstanceProcAddr);
     }
 #endif
     if (XR_FAILED(res)) {
@@ -282,20 +353,53 @@ XrResult RuntimeInterface::TryLoadingSingleRuntime(const std::string& openxr_com
     LoaderLogger::LogInfoMessage(openxr_command, info_message);
 
     // Use this runtime
-    GetInstance().reset(new RuntimeInterface(runtime_library, runtime_info.getInstanceProcAddr));
+    UseRuntime(runtime_library, runtime_info.getInstanceProcAddr, manifest_file->LibraryPath());
+    return XR_SUCCESS;
+}
+
+#ifdef XR_LOADER_STATIC_RUNTIME_NEGOTIATE
+XrResult RuntimeInterface::TryUsingStaticRuntime(const std::string& openxr_command) {
+    XrNegotiateRuntimeRequest runtime_info = {};
+    XrResult res = NegotiateRuntime(openxr_command, "statically linked runtime", "statically linked runtime",
+                                    &XR_LOADER_STATIC_RUNTIME_NEGOTIATE, runtime_info);
+#ifdef XR_KHR_LOADER_INIT_SUPPORT
+    if (XR_SUCCEEDED(res)) {
+        // There is no library to look for an exported xrInitializeLoaderKHR in, so always ask xrGetInstanceProcAddr.
+        res = ForwardInitializeLoader(openxr_command, runtime_info.getInstanceProcAddr);
+    }
+#endif
+    if (XR_FAILED(res)) {
+        LoaderLogger::LogErrorMessage(openxr_command,
+                                      "RuntimeInterface::LoadRuntime negotiation with the statically linked runtime failed with error " +
+                                          std::to_string(res));
+        return XR_ERROR_RUNTIME_UNAVAILABLE;
+    }
+
+    std::string info_message = "RuntimeInterface::LoadRuntime using the statically linked runtime with interface version ";
+    info_message += std::to_string(runtime_info.runtimeInterfaceVersion);
+    info_message += " and OpenXR API version ";
+    info_message += std::to_string(XR_VERSION_MAJOR(runtime_info.runtimeApiVersion));
+    info_message += ".";
+    info_message += std::to_string(XR_VERSION_MINOR(runtime_info.runtimeApiVersion));
+    LoaderLogger::LogInfoMessage(openxr_command, info_message);
+
+    UseRuntime(nullptr, runtime_info.getInstanceProcAddr, "statically linked runtime");
+    return XR_SUCCESS;
+}
+#endif  // XR_LOADER_STATIC_RUNTIME_NEGOTIATE
+
+void RuntimeInterface::UseRuntime(LoaderPlatformLibraryHandle runtime_library, PFN_xrGetInstanceProcAddr get_instance_proc_addr,
+                                  const std::string& runtime_description) {
+    GetInstance().reset(new RuntimeInterface(runtime_library, get_instance_proc_addr));
 
     // Grab the list of extensions this runtime supports for easy filtering after the
     // xrCreateInstance call
-    std::vector<std::string> supported_extensions;
     std::vector<XrExtensionProperties> extension_properties;
-    GetInstance()->GetInstanceExtensionProperties(extension_properties);
-    supported_extensions.reserve(extension_properties.size());
-    for (XrExtensionProperties ext_prop : extension_properties) {
-        supported_extensions.emplace_back(ext_prop.extensionName);
+    {
+        LoaderStartupTimer timer("enumerate runtime extensions", runtime_description);
+        GetInstance()->GetInstanceExtensionProperties(extension_properties);
     }
-    GetInstance()->SetSupportedExtensions(supported_extensions);
-
-    return XR_SUCCESS;
+    GetInstance()->SetSupportedExtensions(extension_properties);
 }
 
 XrResult RuntimeInterface::LoadRuntime(const std::string& openxr_command) {
@@ -312,10 +416,18 @@ XrResult RuntimeInterface::LoadRuntime(const std::string& openxr_command) {
     }
 #endif  // XR_KHR_LOADER_INIT_SUPPORT
 
+#ifdef XR_LOADER_STATIC_RUNTIME_NEGOTIATE
+    // The runtime is linked into the loader: there are no manifests to find and no library to open.
+    return TryUsingStaticRuntime(openxr_command);
+#else
     std::vector<std::unique_ptr<RuntimeManifestFile>> runtime_manifest_files = {};
 
     // Find the available runtimes which we may need to report information for.
-    XrResult last_error = RuntimeManifestFile::FindManifestFiles(runtime_manifest_files);
+    XrResult last_error;
+    {
+        LoaderStartupTimer timer("find runtime manifests");
+        last_error = RuntimeManifestFile::FindManifestFiles(runtime_manifest_files);
+    }
     if (XR_FAILED(last_error)) {
         LoaderLogger::LogErrorMessage(openxr_command, "RuntimeInterface::LoadRuntimes - unknown error");
     } else {
@@ -332,42 +444,86 @@ XrResult RuntimeInterface::LoadRuntime(const std::string& openxr_command) {
     if (XR_FAILED(last_error)) {
         LoaderLogger::LogErrorMessage(openxr_command, "RuntimeInterface::LoadRuntimes - failed to load a runtime");
         last_error = XR_ERROR_RUNTIME_UNAVAILABLE;
+#ifdef XR_USE_PLATFORM_ANDROID
+        // The active runtime may have changed since the manifest was cached, so ask the broker again next time.
+        InvalidatePlatformRuntimeVirtualManifest();
+#endif  // XR_USE_PLATFORM_ANDROID
     }
 
     return last_error;
+#endif  // XR_LOADER_STATIC_RUNTIME_NEGOTIATE
 }
 
+// When this environment variable is set, the runtime stays loaded, and negotiated, once no instance uses it, so that
+// creating the next instance does not have to find, open and negotiate with it again.
+#define OPENXR_KEEP_RUNTIME_LOADED_ENV_VAR "XR_LOADER_KEEP_RUNTIME_LOADED"
+
 void RuntimeInterface::UnloadRuntime(const std::string& openxr_command) {
     if (GetInstance()) {
+        static const bool keep_runtime_loaded = PlatformUtilsGetEnvSet(OPENXR_KEEP_RUNTIME_LOADED_ENV_VAR);
+        if (keep_runtime_loaded) {
+            LoaderLogger::LogInfoMessage(openxr_command, "RuntimeInterface::UnloadRuntime - Keeping RuntimeInterface loaded because " +
+                                                             std::string(OPENXR_KEEP_RUNTIME_LOADED_ENV_VAR) + " is set");
+            return;
+        }
         LoaderLogger::LogInfoMessage(openxr_command, "RuntimeInterface::UnloadRuntime - Unloading RuntimeInterface");
         GetInstance().reset();
     }
 }
 
+struct RuntimeInterface::InstanceDispatch {
+    XrInstance instance;
+    XrGeneratedDispatchTable table;
+
+    // What the runtime's xrGetInstanceProcAddr answered for each name asked for this instance. The loader's dispatch
+    // table, every API layer and the application each ask for the same functions, and the answers cannot change for
+    // the life of the instance, so the runtime is only asked once per name.
+    struct ResolvedFunction {
+        XrResult result;
+        PFN_xrVoidFunction function;
+    };
+    mutable std::mutex resolved_mutex;
+    mutable std::unordered_map<std::string, ResolvedFunction> resolved_functions;
+};
+
 XrResult RuntimeInterface::GetInstanceProcAddr(XrInstance instance, const char* name, PFN_xrVoidFunction* function) {
-    return GetInstance()->_get_instance_proc_addr(instance, name, function);
+    RuntimeInterface& runtime = *GetInstance();
+    const InstanceDispatch* instance_dispatch = runtime._active_instance_dispatch.load(std::memory_order_acquire);
+    if (instance == XR_NULL_HANDLE || instance_dispatch == nullptr || instance_dispatch->instance != instance) {
+        return runtime._get_instance_proc_addr(instance, name, function);
+    }
+
+    std::lock_guard<std::mutex> lock(instance_dispatch->resolved_mutex);
+    auto it = instance_dispatch->resolved_functions.find(name);
+    if (it == instance_dispatch->resolved_functions.end()) {
+        PFN_xrVoidFunction resolved = nullptr;
+        const XrResult result = runtime._get_instance_proc_addr(instance, name, &resolved);
+        // Other errors, such as XR_ERROR_HANDLE_INVALID, may not be the runtime's last word on the name.
+        if (result != XR_SUCCESS && result != XR_ERROR_FUNCTION_UNSUPPORTED) {
+            *function = resolved;
+            return result;
+        }
+        it = instance_dispatch->resolved_functions.emplace(name, InstanceDispatch::ResolvedFunction{result, resolved}).first;
+    }
+    *function = it->second.function;
+    return it->second.result;
 }
 
 const XrGeneratedDispatchTable* RuntimeInterface::GetDispatchTable(XrInstance instance) {
-    XrGeneratedDispatchTable* table = nullptr;
-    std::lock_guard<std::mutex> mlock(GetInstance()->_dispatch_table_mutex);
-    auto it = GetInstance()->_dispatch_table_map.find(instance);
-    if (it != GetInstance()->_dispatch_table_map.end()) {
-        table = it->second.get();
+    const InstanceDispatch* instance_dispatch = GetInstance()->_active_instance_dispatch.load(std::memory_order_acquire);
+    if (instance_dispatch != nullptr && instance_dispatch->instance == instance) {
+        return &instance_dispatch->table;
     }
-    return table;
+    return nullptr;
 }
 
-const XrGeneratedDispatchTable* RuntimeInterface::GetDebugUtilsMessengerDispatchTable(XrDebugUtilsMessengerEXT messenger) {
-    XrInstance runtime_instance = XR_NULL_HANDLE;
-    {
-        std::lock_guard<std::mutex> mlock(GetInstance()->_messenger_to_instance_mutex);
-        auto it = GetInstance()->_messenger_to_instance_map.find(messenger);
-        if (it != GetInstance()->_messenger_to_instance_map.end()) {
-            runtime_instance = it->second;
-        }
+const XrGeneratedDispatchTable* RuntimeInterface::GetDebugUtilsMessengerDispatchTable(XrDebugUtilsMessengerEXT /* messenger */) {
+    // Every messenger belongs to the one active instance.
+    const InstanceDispatch* instance_dispatch = GetInstance()->_active_instance_dispatch.load(std::memory_order_acquire);
+    if (instance_dispatch != nullptr) {
+        return &instance_dispatch->table;
     }
-    return GetDispatchTable(runtime_instance);
+    return nullptr;
 }
 
 RuntimeInterface::RuntimeInterface(LoaderPlatformLibraryHandle runtime_library, PFN_xrGetInstanceProcAddr get_instance_proc_addr)
@@ -376,31 +532,38 @@ RuntimeInterface::RuntimeInterface(LoaderPlatformLibraryHandle runtime_library,
 RuntimeInterface::~RuntimeInterface() {
     std::string info_message = "RuntimeInterface being destroyed.";
     LoaderLogger::LogInfoMessage("", info_message);
-    {
-        std::lock_guard<std::mutex> mlock(_dispatch_table_mutex);
-        _dispatch_table_map.clear();
+    _active_instance_dispatch.store(nullptr, std::memory_order_release);
+    _instance_dispatch.reset();
+    // A statically linked runtime has no library to close.
+    if (_runtime_library != nullptr) {
+        LoaderPlatformLibraryClose(_runtime_library);
     }
-    LoaderPlatformLibraryClose(_runtime_library);
 }
 
 void RuntimeInterface::GetInstanceExtensionProperties(std::vector<XrExtensionProperties>& extension_properties) {
-    std::vector<XrExtensionProperties> runtime_extension_properties;
-    PFN_xrEnumerateInstanceExtensionProperties rt_xrEnumerateInstanceExtensionProperties;
-    _get_instance_proc_addr(XR_NULL_HANDLE, "xrEnumerateInstanceExtensionProperties",
-                            reinterpret_cast<PFN_xrVoidFunction*>(&rt_xrEnumerateInstanceExtensionProperties));
-    uint32_t count = 0;
-    uint32_t count_output = 0;
-    // Get the count from the runtime
-    rt_xrEnumerateInstanceExtensionProperties(nullptr, count, &count_output, nullptr);
-    if (count_output > 0) {
-        runtime_extension_properties.resize(count_output);
-        count = count_output;
-        for (XrExtensionProperties& ext_prop : runtime_extension_properties) {
-            ext_prop.type = XR_TYPE_EXTENSION_PROPERTIES;
-            ext_prop.next = nullptr;
+    // The extensions of a loaded runtime do not change, so they are only asked for once. The first call is the one
+    // TryLoadingSingleRuntime makes; xrEnumerateInstanceExtensionProperties and xrCreateInstance reuse its answer.
+    if (!_extension_properties_queried) {
+        PFN_xrEnumerateInstanceExtensionProperties rt_xrEnumerateInstanceExtensionProperties;
+        _get_instance_proc_addr(XR_NULL_HANDLE, "xrEnumerateInstanceExtensionProperties",
+                                reinterpret_cast<PFN_xrVoidFunction*>(&rt_xrEnumerateInstanceExtensionProperties));
+        uint32_t count = 0;
+        uint32_t count_output = 0;
+        // Get the count from the runtime
+        rt_xrEnumerateInstanceExtensionProperties(nullptr, count, &count_output, nullptr);
+        if (count_output > 0) {
+            _extension_properties.resize(count_output);
+            count = count_output;
+            for (XrExtensionProperties& ext_prop : _extension_properties) {
+                ext_prop.type = XR_TYPE_EXTENSION_PROPERTIES;
+                ext_prop.next = nullptr;
+            }
+            rt_xrEnumerateInstanceExtensionProperties(nullptr, count, &count_output, _extension_properties.data());
+            _extension_properties.resize(count_output < count ? count_output : count);
         }
-        rt_xrEnumerateInstanceExtensionProperties(nullptr, count, &count_output, runtime_extension_properties.data());
+        _extension_properties_queried = true;
     }
+    const std::vector<XrExtensionProperties>& runtime_extension_properties = _extension_properties;
     size_t ext_count = runtime_extension_properties.size();
     size_t props_count = extension_properties.size();
     for (size_t ext = 0; ext < ext_count; ++ext) {
@@ -421,6 +584,13 @@ void RuntimeInterface::GetInstanceExtensionProperties(std::vector<XrExtensionPro
     }
 }
 
+namespace {
+// RuntimeInterface::GetInstanceProcAddr with the calling convention of a PFN_xrGetInstanceProcAddr.
+XRAPI_ATTR XrResult XRAPI_CALL RuntimeGetInstanceProcAddr(XrInstance instance, const char* name, PFN_xrVoidFunction* function) {
+    return RuntimeInterface::GetInstanceProcAddr(instance, name, function);
+}
+}  // namespace
+
 XrResult RuntimeInterface::CreateInstance(const XrInstanceCreateInfo* info, XrInstance* instance) {
     XrResult res = XR_SUCCESS;
     bool create_succeeded = false;
@@ -429,10 +599,13 @@ XrResult RuntimeInterface::CreateInstance(const XrInstanceCreateInfo* info, XrIn
     res = rt_xrCreateInstance(info, instance);
     if (XR_SUCCEEDED(res)) {
         create_succeeded = true;
-        std::unique_ptr<XrGeneratedDispatchTable> dispatch_table(new XrGeneratedDispatchTable());
-        GeneratedXrPopulateDispatchTable(dispatch_table.get(), *instance, _get_instance_proc_addr);
-        std::lock_guard<std::mutex> mlock(_dispatch_table_mutex);
-        _dispatch_table_map[*instance] = std::move(dispatch_table);
+        std::unique_ptr<InstanceDispatch> instance_dispatch(new InstanceDispatch());
+        instance_dispatch->instance = *instance;
+        // Published before it is populated so that populating it fills the resolved functions as well. No other thread
+        // can look it up yet, since the instance handle has not been returned.
+        _active_instance_dispatch.store(instance_dispatch.get(), std::memory_order_release);
+        _instance_dispatch = std::move(instance_dispatch);
+        GeneratedXrPopulateDispatchTable(&_instance_dispatch->table, *instance, RuntimeGetInstanceProcAddr);
     }
 
     // If the failure occurred during the populate, clean up the instance we had picked up from the runtime
@@ -449,12 +622,9 @@ XrResult RuntimeInterface::CreateInstance(const XrInstanceCreateInfo* info, XrIn
 XrResult RuntimeInterface::DestroyInstance(XrInstance instance) {
     if (XR_NULL_HANDLE != instance) {
         // Destroy the dispatch table for this instance first
-        {
-            std::lock_guard<std::mutex> mlock(_dispatch_table_mutex);
-            auto map_iter = _dispatch_table_map.find(instance);
-            if (map_iter != _dispatch_table_map.end()) {
-                _dispatch_table_map.erase(map_iter);
-            }
+        if (_instance_dispatch && _instance_dispatch->instance == instance) {
+            _active_instance_dispatch.store(nullptr, std::memory_order_release);
+            _instance_dispatch.reset();
         }
         // Now delete the instance
         PFN_xrDestroyInstance rt_xrDestroyInstance;
@@ -464,30 +634,10 @@ XrResult RuntimeInterface::DestroyInstance(XrInstance instance) {
     return XR_SUCCESS;
 }
 
-bool RuntimeInterface::TrackDebugMessenger(XrInstance instance, XrDebugUtilsMessengerEXT messenger) {
-    std::lock_guard<std::mutex> mlock(_messenger_to_instance_mutex);
-    _messenger_to_instance_map[messenger] = instance;
-    return true;
-}
-
-void RuntimeInterface::ForgetDebugMessenger(XrDebugUtilsMessengerEXT messenger) {
-    if (XR_NULL_HANDLE != messenger) {
-        std::lock_guard<std::mutex> mlock(_messenger_to_instance_mutex);
-        _messenger_to_instance_map.erase(messenger);
+void RuntimeInterface::SetSupportedExtensions(const std::vector<XrExtensionProperties>& supported_extensions) {
+    for (const XrExtensionProperties& ext_prop : supported_extensions) {
+        _supported_extensions.Insert(ext_prop.extensionName);
     }
 }
 
-void RuntimeInterface::SetSupportedExtensions(std::vector<std::string>& supported_extensions) {
-    _supported_extensions = supported_extensions;
-}
-
-bool RuntimeInterface::SupportsExtension(const std::string& extension_name) {
-    bool found_prop = false;
-    for (const std::string& supported_extension : _supported_extensions) {
-        if (supported_extension == extension_name) {
-            found_prop = true;
-            break;
-        }
-    }
-    return found_prop;
-}
+bool RuntimeInterface::SupportsExtension(const char* extension_name) const { return _supported_extensions.Contains(extension_name); }
@@ -9,14 +9,14 @@
 
 #pragma once
 
+#include "extension_registry.h"
 #include "loader_platform.hpp"
 
 #include <openxr/openxr.h>
 
+#include <atomic>
 #include <string>
 #include <vector>
-#include <unordered_map>
-#include <mutex>
 #include <memory>
 
 #ifdef XR_USE_PLATFORM_ANDROID
@@ -30,9 +30,15 @@ class Value;
 #ifdef XR_KHR_LOADER_INIT_SUPPORT
 //! Initialize loader, where required.
 XrResult InitializeLoader(const XrLoaderInitInfoBaseHeaderKHR* loaderInitInfo);
+//! Returns the runtime broker's virtual manifest, cached for the process after the first successful query.
 XrResult GetPlatformRuntimeVirtualManifest(Json::Value& out_manifest);
 #endif
 
+#ifdef XR_USE_PLATFORM_ANDROID
+//! Drops the cached virtual manifest, so that the next GetPlatformRuntimeVirtualManifest queries the broker again.
+void InvalidatePlatformRuntimeVirtualManifest();
+#endif
+
 class RuntimeManifestFile;
 struct XrGeneratedDispatchTable;
 
@@ -51,11 +57,9 @@ class RuntimeInterface {
     static const XrGeneratedDispatchTable* GetDebugUtilsMessengerDispatchTable(XrDebugUtilsMessengerEXT messenger);
 
     void GetInstanceExtensionProperties(std::vector<XrExtensionProperties>& extension_properties);
-    bool SupportsExtension(const std::string& extension_name);
+    bool SupportsExtension(const char* extension_name) const;
     XrResult CreateInstance(const XrInstanceCreateInfo* info, XrInstance* instance);
     XrResult DestroyInstance(XrInstance instance);
-    bool TrackDebugMessenger(XrInstance instance, XrDebugUtilsMessengerEXT messenger);
-    void ForgetDebugMessenger(XrDebugUtilsMessengerEXT messenger);
 
     // No default construction
     RuntimeInterface() = delete;
@@ -66,8 +70,14 @@ class RuntimeInterface {
 
    private:
     RuntimeInterface(LoaderPlatformLibraryHandle runtime_library, PFN_xrGetInstanceProcAddr get_instance_proc_addr);
-    void SetSupportedExtensions(std::vector<std::string>& supported_extensions);
+    void SetSupportedExtensions(const std::vector<XrExtensionProperties>& supported_extensions);
     static XrResult TryLoadingSingleRuntime(const std::string& openxr_command, std::unique_ptr<RuntimeManifestFile>& manifest_file);
+#ifdef XR_LOADER_STATIC_RUNTIME_NEGOTIATE
+    static XrResult TryUsingStaticRuntime(const std::string& openxr_command);
+#endif  // XR_LOADER_STATIC_RUNTIME_NEGOTIATE
+    // Makes the negotiated runtime the loaded one. runtime_library is nullptr for a statically linked runtime.
+    static void UseRuntime(LoaderPlatformLibraryHandle runtime_library, PFN_xrGetInstanceProcAddr get_instance_proc_addr,
+                           const std::string& runtime_description);
 
     static std::unique_ptr<RuntimeInterface>& GetInstance() {
         static std::unique_ptr<RuntimeInterface> instance;
@@ -76,9 +86,14 @@ class RuntimeInterface {
 
     LoaderPlatformLibraryHandle _runtime_library;
     PFN_xrGetInstanceProcAddr _get_instance_proc_addr;
-    std::unordered_map<XrInstance, std::unique_ptr<XrGeneratedDispatchTable>> _dispatch_table_map;
-    std::mutex _dispatch_table_mutex;
-    std::unordered_map<XrDebugUtilsMessengerEXT, XrInstance> _messenger_to_instance_map;
-    std::mutex _messenger_to_instance_mutex;
-    std::vector<std::string> _supported_extensions;
+    // The loader only allows one XrInstance at a time, so the runtime dispatch table for it is published
+    // through an atomic pointer and looked up without taking a lock. It also holds the functions resolved through
+    // GetInstanceProcAddr for the instance, dropped with it at DestroyInstance.
+    struct InstanceDispatch;
+    std::unique_ptr<InstanceDispatch> _instance_dispatch;
+    std::atomic<const InstanceDispatch*> _active_instance_dispatch{nullptr};
+    XrExtensionNameSet _supported_extensions;
+    // The runtime's answer to xrEnumerateInstanceExtensionProperties, from the first GetInstanceExtensionProperties.
+    std::vector<XrExtensionProperties> _extension_properties;
+    bool _extension_properties_queried{false};
 };
@@ -18,6 +18,9 @@
 # See the License for the specific language governing permissions and
 # limitations under the License.
 
+import os
+import re
+
 from automatic_source_generator import AutomaticSourceOutputGenerator, write
 from jinja_helpers import JinjaTemplate, make_jinja_environment
 
@@ -31,6 +34,85 @@ def make_ext_variable_name(extName):
     return extName.lower()[3:]
 
 
+def make_gipa_buckets(sorted_cmds, skip_hooks):
+    """Group the commands that xrGetInstanceProcAddr returns hooks for by name length.
+
+    The generated lookup switches on the length of the requested name, so each name is
+    only compared against the few commands whose names are just as long.
+    Returns (length, commands) pairs sorted by length, keeping command order within each."""
+    buckets = {}
+    for cmd in sorted_cmds:
+        if cmd.name in skip_hooks or cmd.name == 'xrGetInstanceProcAddr':
+            continue
+        buckets.setdefault(len(cmd.name), []).append(cmd)
+    return sorted(buckets.items())
+
+
+HOOKS_HEADER = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'conformance', 'conformance_layer',
+                            'ConformanceHooks.h')
+
+
+def strip_inactive_code(text):
+    """Return text without comments and without the lines of #if 0 blocks, up to their #else or #endif."""
+    text = re.sub(r'/\*.*?\*/', '', text, flags=re.DOTALL)
+    text = re.sub(r'//[^\n]*', '', text)
+    lines = []
+    skip_depth = 0
+    for line in text.splitlines():
+        directive = line.strip()
+        if skip_depth:
+            if directive.startswith('#if'):
+                skip_depth += 1
+            elif directive.startswith('#endif'):
+                skip_depth -= 1
+            elif skip_depth == 1 and (directive.startswith('#else') or directive.startswith('#elif')):
+                skip_depth = 0
+            continue
+        if re.match(r'#\s*if\s+0\b', directive):
+            skip_depth = 1
+            continue
+        lines.append(line)
+    return '\n'.join(lines)
+
+
+def find_hand_written_hooks(header=HOOKS_HEADER):
+    """Return the names of the functions ConformanceHooks overrides with hand-written validation."""
+    with open(header, 'r', encoding='utf-8') as f:
+        text = strip_inactive_code(f.read())
+    return set(re.findall(r'\bXrResult\s+(xr\w+)\s*\([^;{]*\)\s*override\s*;', text))
+
+
+def is_create_or_destroy(cmd):
+    return cmd.params[-1].is_handle and ('xrCreate' in cmd.name or 'xrDestroy' in cmd.name)
+
+
+def find_passthrough_commands(sorted_cmds, skip_hooks, api_handles, hooked):
+    """Return the names of the commands that the layer can hand straight to the runtime when asked to.
+
+    These have no hand-written validation, and if they create or destroy a handle, nothing ever looks up the state of
+    that handle type. Handle state is needed for the first parameter of every hand-written hook, for the types a hook
+    creates (the hook attaches custom state to them), and for all of their ancestors, whose state new children are
+    cloned from."""
+    ancestors = {handle.name: handle.ancestors for handle in api_handles}
+    needed = set()
+    for cmd in sorted_cmds:
+        if cmd.name in hooked:
+            needed.add(cmd.params[0].type)
+            if is_create_or_destroy(cmd):
+                needed.add(cmd.params[-1].type)
+    for handle in list(needed):
+        needed.update(ancestors.get(handle, []))
+
+    passthrough = set()
+    for cmd in sorted_cmds:
+        if cmd.name in skip_hooks or cmd.name == 'xrGetInstanceProcAddr' or cmd.name in hooked:
+            continue
+        if is_create_or_destroy(cmd) and cmd.params[-1].type in needed:
+            continue
+        passthrough.add(cmd.name)
+    return passthrough
+
+
 def make_environment():
     env = make_jinja_environment(file_with_templates_as_sibs=__file__)
     env.filters['make_ext_variable_name'] = make_ext_variable_name
@@ -71,11 +153,14 @@ class ConformanceLayerGenerator(AutomaticSourceOutputGenerator):
         sorted_cmds = self.core_commands + self.ext_commands
         skip_hooks = set(self.no_trampoline_or_terminator).union(
             set(MANUALLY_DEFINED_IN_LAYER))
+        passthrough_cmds = find_passthrough_commands(sorted_cmds, skip_hooks, self.api_handles, find_hand_written_hooks())
         file_data = self.template.render(
                 gen=self,
                 registry=self.registry,
                 sorted_cmds=sorted_cmds,
-                skip_hooks=skip_hooks)
+                skip_hooks=skip_hooks,
+                passthrough_cmds=passthrough_cmds,
+                gipa_buckets=make_gipa_buckets(sorted_cmds, skip_hooks))
         write(file_data, file=self.outFile)
 
         # Finish processing in superclass
@@ -39,6 +39,23 @@ MANUAL_LOADER_FUNCS = set((
     'xrInitializeLoaderKHR',
 ))
 
+# Per-frame commands whose trampolines read the cached dispatch table of the active instance and call through it
+# directly, without the ActiveLoaderInstance::Get call or the exception guard. They only forward their parameters,
+# so nothing in them can throw. Applications that want to skip the trampoline entirely can get the next function
+# in the chain from xrGetInstanceProcAddr, which returns the dispatch table entry for any command the loader does
+# not implement itself.
+FAST_PATH_LOADER_FUNCS = set((
+    'xrWaitFrame',
+    'xrBeginFrame',
+    'xrEndFrame',
+    'xrLocateViews',
+    'xrLocateSpace',
+    'xrSyncActions',
+    'xrAcquireSwapchainImage',
+    'xrWaitSwapchainImage',
+    'xrReleaseSwapchainImage',
+))
+
 # This is a list of extensions that the loader implements.  This means that
 # the runtime underneath may not support these extensions and the terminators
 # need to check before they call
@@ -127,7 +144,10 @@ class LoaderSourceOutputGenerator(AutomaticSourceOutputGenerator):
             preamble += '#include <openxr/openxr.h>\n'
             preamble += '#include <openxr/openxr_platform.h>\n\n'
 
+            preamble += '#include <algorithm>\n'
+            preamble += '#include <cstddef>\n'
             preamble += '#include <cstring>\n'
+            preamble += '#include <iterator>\n'
             preamble += '#include <memory>\n'
             preamble += '#include <new>\n'
             preamble += '#include <string>\n'
@@ -149,9 +169,19 @@ class LoaderSourceOutputGenerator(AutomaticSourceOutputGenerator):
             file_data += '#ifdef __cplusplus\n'
             file_data += '} // extern "C"\n'
             file_data += '#endif\n'
+            file_data += '\n// Returns the function pointer stored in the dispatch table for the named command,\n'
+            file_data += '// or nullptr if the command is not in the table or the table has no entry for it.\n'
+            file_data += 'PFN_xrVoidFunction LoaderLookUpDispatchTable(const XrGeneratedDispatchTable* table, const char* name);\n'
+            file_data += '\n// Fills in the dispatch table through get_inst_proc_addr, querying only core commands and the commands\n'
+            file_data += '// of the enabled extensions.  Entries for commands of other extensions are left nullptr.\n'
+            file_data += 'void LoaderPopulateDispatchTable(XrGeneratedDispatchTable* table, XrInstance instance,\n'
+            file_data += '                                 PFN_xrGetInstanceProcAddr get_inst_proc_addr,\n'
+            file_data += '                                 const std::vector<std::string>& enabled_extensions);\n'
 
         elif self.genOpts.filename == 'xr_generated_loader.cpp':
             file_data += self.outputLoaderGeneratedFuncs()
+            file_data += self.outputDispatchTableLookup()
+            file_data += self.outputLoaderPopulateDispatchTable()
 
         write(file_data, file=self.outFile)
 
@@ -195,6 +225,10 @@ class LoaderSourceOutputGenerator(AutomaticSourceOutputGenerator):
             # Remove 'xr' from proto name
             base_name = cur_cmd.name[2:]
 
+            if cur_cmd.name in FAST_PATH_LOADER_FUNCS:
+                generated_funcs += self.outputLoaderFastPathFunc(cur_cmd, base_name)
+                continue
+
             has_return = False
 
             if cur_cmd.is_create_connect or cur_cmd.is_destroy_disconnect:
@@ -295,3 +329,107 @@ class LoaderSourceOutputGenerator(AutomaticSourceOutputGenerator):
                 generated_funcs += '#endif // %s\n' % cur_cmd.protect_string
             generated_funcs += '\n'
         return generated_funcs
+
+    # Output a trampoline for one of FAST_PATH_LOADER_FUNCS: a load of the cached dispatch table, a null check and
+    # a tail call to the next function in the chain.
+    #   self            the LoaderSourceOutputGenerator object
+    #   cur_cmd         the command to output the trampoline for
+    #   base_name       the command name without the 'xr' prefix, as used in the dispatch table
+    def outputLoaderFastPathFunc(self, cur_cmd, base_name):
+        assert cur_cmd.params[0].is_handle and cur_cmd.return_type is not None
+        assert not (cur_cmd.is_create_connect or cur_cmd.is_destroy_disconnect)
+        func = ''
+        if cur_cmd.protect_value:
+            func += '#if %s\n' % cur_cmd.protect_string
+        func += self.getProto(cur_cmd).replace(";", " {\n")
+        func += '    const XrGeneratedDispatchTable* dispatch_table = ActiveLoaderInstance::GetDispatchTable();\n'
+        func += '    if (dispatch_table == nullptr) {\n'
+        func += '        return ActiveLoaderInstance::NoActiveInstance("%s");\n' % cur_cmd.name
+        func += '    }\n'
+        func += '    return dispatch_table->%s(%s);\n' % (base_name, ', '.join(param.name for param in cur_cmd.params))
+        func += '}\n'
+        if cur_cmd.protect_value:
+            func += '#endif // %s\n' % cur_cmd.protect_string
+        func += '\n'
+        return func
+
+    # Output a table of dispatch table member offsets sorted by command name, and a
+    # function that binary searches it. This lets the loader answer xrGetInstanceProcAddr
+    # from the dispatch table it already populated instead of querying the whole layer chain.
+    #   self            the LoaderSourceOutputGenerator object
+    def outputDispatchTableLookup(self):
+        lookup = '\n// Dispatch table offsets, sorted by command name for LoaderLookUpDispatchTable\n'
+        lookup += 'namespace {\n'
+        lookup += 'struct LoaderDispatchTableOffset {\n'
+        lookup += '    const char* name;\n'
+        lookup += '    size_t offset;\n'
+        lookup += '};\n\n'
+        lookup += 'const LoaderDispatchTableOffset kLoaderDispatchTableOffsets[] = {\n'
+
+        # xrGetInstanceProcAddr always needs to go through the loader trampoline.
+        commands = [cur_cmd for cur_cmd in self.core_commands + self.ext_commands
+                    if cur_cmd.name != 'xrGetInstanceProcAddr' and cur_cmd.name not in self.no_trampoline_or_terminator]
+        for cur_cmd in sorted(commands, key=lambda cmd: cmd.name):
+            if cur_cmd.protect_value:
+                lookup += '#if %s\n' % cur_cmd.protect_string
+            lookup += '    {"%s", offsetof(XrGeneratedDispatchTable, %s)},\n' % (cur_cmd.name, cur_cmd.name[2:])
+            if cur_cmd.protect_value:
+                lookup += '#endif // %s\n' % cur_cmd.protect_string
+
+        lookup += '};\n'
+        lookup += '}  // namespace\n\n'
+        lookup += 'PFN_xrVoidFunction LoaderLookUpDispatchTable(const XrGeneratedDispatchTable* table, const char* name) {\n'
+        lookup += '    const auto begin = std::begin(kLoaderDispatchTableOffsets);\n'
+        lookup += '    const auto end = std::end(kLoaderDispatchTableOffsets);\n'
+        lookup += '    const auto it = std::lower_bound(begin, end, name, [](const LoaderDispatchTableOffset& entry, const char* value) {\n'
+        lookup += '        return std::strcmp(entry.name, value) < 0;\n'
+        lookup += '    });\n'
+        lookup += '    if (it == end || std::strcmp(it->name, name) != 0) {\n'
+        lookup += '        return nullptr;\n'
+        lookup += '    }\n'
+        lookup += '    return *reinterpret_cast<const PFN_xrVoidFunction*>(reinterpret_cast<const char*>(table) + it->offset);\n'
+        lookup += '}\n'
+        return lookup
+
+    # Output a version of GeneratedXrPopulateDispatchTable that skips the commands of extensions
+    # the application did not enable. Those commands can't be used on the instance, so there is
+    # no point in sending every one of them down the whole layer chain at instance creation.
+    #   self            the LoaderSourceOutputGenerator object
+    def outputLoaderPopulateDispatchTable(self):
+        populate = '\nvoid LoaderPopulateDispatchTable(XrGeneratedDispatchTable* table, XrInstance instance,\n'
+        populate += '                                 PFN_xrGetInstanceProcAddr get_inst_proc_addr,\n'
+        populate += '                                 const std::vector<std::string>& enabled_extensions) {\n'
+        populate += '    auto extension_enabled = [&enabled_extensions](const char* extension_name) {\n'
+        populate += '        return std::find(enabled_extensions.begin(), enabled_extensions.end(), extension_name) != enabled_extensions.end();\n'
+        populate += '    };\n'
+
+        cur_extension_name = ''
+        for cur_cmd in self.core_commands + self.ext_commands:
+            if cur_cmd.name in self.no_trampoline_or_terminator:
+                continue
+
+            if cur_cmd.ext_name != cur_extension_name:
+                if cur_extension_name and not self.isCoreExtensionName(cur_extension_name):
+                    populate += '    }\n'
+                if self.isCoreExtensionName(cur_cmd.ext_name):
+                    populate += '\n    // ---- Core %s commands\n' % cur_cmd.ext_name[11:].replace("_", ".")
+                else:
+                    populate += '\n    // ---- %s extension commands\n' % cur_cmd.ext_name
+                    populate += '    if (extension_enabled("%s")) {\n' % cur_cmd.ext_name
+                cur_extension_name = cur_cmd.ext_name
+
+            indent = '    ' if self.isCoreExtensionName(cur_cmd.ext_name) else '        '
+            if cur_cmd.protect_value:
+                populate += '#if %s\n' % cur_cmd.protect_string
+            if cur_cmd.name == 'xrGetInstanceProcAddr':
+                populate += '%stable->GetInstanceProcAddr = get_inst_proc_addr;\n' % indent
+            else:
+                populate += '%s(get_inst_proc_addr(instance, "%s", (PFN_xrVoidFunction*)&table->%s));\n' % (
+                    indent, cur_cmd.name, cur_cmd.name[2:])
+            if cur_cmd.protect_value:
+                populate += '#endif // %s\n' % cur_cmd.protect_string
+
+        if cur_extension_name and not self.isCoreExtensionName(cur_extension_name):
+            populate += '    }\n'
+        populate += '}\n'
+        return populate
@@ -5,6 +5,11 @@
 // Used in conformance layer.
 
 #include "gen_dispatch.h"
+#include "CallTrace.h"
+#include "LatencyHistogram.h"
+#include "ScratchArena.h"
+#include "ValidationSettings.h"
+#include "trace_scope.h"
 
 // Unhandled exception at ABI is a catastrophic error in the layer (a bug).
 #define ABI_CATCH \
@@ -29,9 +34,18 @@
 }*/ {
 //#         set first_param_object_type = gen.genXrObjectType(handle_type)
     try {
+        static const LatencyHistogramId latencyHistogramId = RegisterLatencyHistogram(/*{cur_cmd.name | quote_string}*/);
+        const ScopedLatencyRecord latencyRecord(latencyHistogramId);
+        XR_TRACE_SCOPE(/*{cur_cmd.name | quote_string}*/);
+
+        static const CallTraceFunctionId callTraceFunctionId = RegisterCallTraceFunction(/*{cur_cmd.name | quote_string}*/);
+        const ScopedCallTrace callTrace(callTraceFunctionId, (uint64_t)HandleToInt(/*{first_handle_name}*/));
+
         HandleState* const handleState = GetHandleState({HandleToInt(/*{first_handle_name}*/), /*{first_param_object_type}*/});
+        ScopedDispatchHandleState dispatchScope(handleState);
+        const ScratchScope scratchScope;
 
-        return handleState->conformanceHooks->/*{cur_cmd.name}*/(/*{ cur_cmd.params | map(attribute="name") | join(", ") }*/);
+        return callTrace.Finish(handleState->conformanceHooks->/*{cur_cmd.name}*/(/*{ cur_cmd.params | map(attribute="name") | join(", ") }*/));
     }
     ABI_CATCH
 }
@@ -99,24 +113,37 @@ static PFN_xrVoidFunction ConformanceLayer_InnerGetInstanceProcAddr(
     if (strcmp(name, "xrGetInstanceProcAddr") == 0) {
         return reinterpret_cast<PFN_xrVoidFunction>(ConformanceLayer_xrGetInstanceProcAddr);
     }
-//# for cur_cmd in sorted_cmds
-//#     set is_core = "XR_VERSION_" in cur_cmd.ext_name
-//#     if cur_cmd.name not in skip_hooks and cur_cmd.name != "xrGetInstanceProcAddr"
 
+    // Only compare the name against the commands whose names are the same length.
+    switch (strlen(name)) {
+//# for name_length, bucket_cmds in gipa_buckets
+    case /*{name_length}*/:
+//#     for cur_cmd in bucket_cmds
+//#         set is_core = "XR_VERSION_" in cur_cmd.ext_name
 /*{ protect_begin(cur_cmd) }*/
-    if (strcmp(name, /*{cur_cmd.name | quote_string}*/) == 0) {
+        if (strcmp(name, /*{cur_cmd.name | quote_string}*/) == 0) {
+//#         if cur_cmd.name in passthrough_cmds
+            // No hand-written validation: let the runtime answer when only hooked functions are wanted.
+            if (GetValidationSettings().level == ValidationLevel::Passthrough) {
+                return nullptr;
+            }
+//#         endif
 //#         if not is_core
-        if (handleState->conformanceHooks->enabledExtensions./*{cur_cmd.ext_name | make_ext_variable_name}*/) {
+            if (handleState->conformanceHooks->enabledExtensions./*{cur_cmd.ext_name | make_ext_variable_name}*/) {
 //#         endif
-            return reinterpret_cast<PFN_xrVoidFunction>(ConformanceLayer_/*{cur_cmd.name}*/);
+                return reinterpret_cast<PFN_xrVoidFunction>(ConformanceLayer_/*{cur_cmd.name}*/);
 //#         if not is_core
-        }
-        return nullptr;
+            }
+            return nullptr;
 //#         endif
-    }
+        }
 /*{ protect_end(cur_cmd) }*/
-//#     endif
+//#     endfor
+        break;
 //# endfor
+    default:
+        break;
+    }
     return nullptr;
 }
 
@@ -20,6 +20,27 @@
 from automatic_source_generator import AutomaticSourceOutputGenerator
 from generator import write
 
+# The core commands an application calls every frame, most frequent first. They lead the
+# dispatch table so that dispatching a frame touches two cache lines rather than one line per
+# command scattered through the table. Everything else keeps its spec order after them, and
+# every command keeps its member name, so code that uses the table by name is unaffected.
+PER_FRAME_COMMANDS = (
+    'xrWaitFrame',
+    'xrBeginFrame',
+    'xrEndFrame',
+    'xrLocateViews',
+    'xrAcquireSwapchainImage',
+    'xrWaitSwapchainImage',
+    'xrReleaseSwapchainImage',
+    'xrLocateSpace',
+    'xrSyncActions',
+    'xrGetActionStateBoolean',
+    'xrGetActionStateFloat',
+    'xrGetActionStateVector2f',
+    'xrGetActionStatePose',
+    'xrPollEvent',
+)
+
 # UtilitySourceOutputGenerator - subclass of AutomaticSourceOutputGenerator.
 
 
@@ -95,28 +116,37 @@ class UtilitySourceOutputGenerator(AutomaticSourceOutputGenerator):
         table_helper += '                                      PFN_xrGetInstanceProcAddr get_inst_proc_addr);\n'
         return table_helper
 
+    # Return the commands in dispatch table order: the PER_FRAME_COMMANDS first, and then the
+    # core commands followed by the extension commands, as the spec orders them.
+    #   self            the UtilitySourceOutputGenerator object
+    def dispatchTableGroups(self):
+        all_commands = self.core_commands + self.ext_commands
+        by_name = {cur_cmd.name: cur_cmd for cur_cmd in all_commands}
+        per_frame = [by_name[name] for name in PER_FRAME_COMMANDS if name in by_name]
+        rest = [cur_cmd for cur_cmd in all_commands if cur_cmd.name not in PER_FRAME_COMMANDS]
+        return [per_frame, rest]
+
     # Write out a C-style structure used to store the Dispatch table information
     #   self            the ApiDumpOutputGenerator object
     def outputDispatchTable(self):
-        commands = []
         table = ''
         cur_extension_name = ''
 
         table += '// Generated dispatch table\n'
         table += 'struct XrGeneratedDispatchTable {\n'
 
-        # Loop through both core commands, and extension commands
-        # Outputting the core commands first, and then the extension commands.
-        for x in range(0, 2):
-            if x == 0:
-                commands = self.core_commands
-            else:
-                commands = self.ext_commands
+        # Output the per-frame commands first, and then the rest with core commands before
+        # extension commands.
+        per_frame, rest = self.dispatchTableGroups()
+        for commands in (per_frame, rest):
+            if commands is per_frame:
+                table += '\n    // ---- Per-frame commands, kept together at the start of the table\n'
+                cur_extension_name = None
 
             for cur_cmd in commands:
                 # If we've switched to a new "feature" print out a comment on what it is.  Usually,
                 # this is a group of core commands or a group of commands in an extension.
-                if cur_cmd.ext_name != cur_extension_name:
+                if commands is rest and cur_cmd.ext_name != cur_extension_name:
                     if self.isCoreExtensionName(cur_cmd.ext_name):
                         table += '\n    // ---- Core %s commands\n' % cur_cmd.ext_name[11:].replace(
                             "_", ".")
@@ -144,7 +174,6 @@ class UtilitySourceOutputGenerator(AutomaticSourceOutputGenerator):
     # an instance handle and a corresponding xrGetInstanceProcAddr command.
     #   self            the ApiDumpOutputGenerator object
     def outputDispatchTableHelper(self):
-        commands = []
         table_helper = ''
         cur_extension_name = ''
 
@@ -153,13 +182,12 @@ class UtilitySourceOutputGenerator(AutomaticSourceOutputGenerator):
         table_helper += '                                      XrInstance instance,\n'
         table_helper += '                                      PFN_xrGetInstanceProcAddr get_inst_proc_addr) {\n'
 
-        # Loop through both core commands, and extension commands
-        # Outputting the core commands first, and then the extension commands.
-        for x in range(0, 2):
-            if x == 0:
-                commands = self.core_commands
-            else:
-                commands = self.ext_commands
+        # Fill in the table in the order of its members.
+        per_frame, rest = self.dispatchTableGroups()
+        for commands in (per_frame, rest):
+            if commands is per_frame:
+                table_helper += '\n    // ---- Per-frame commands\n'
+                cur_extension_name = None
 
             for cur_cmd in commands:
                 # If the command is only manually implemented in the loader,
@@ -169,7 +197,7 @@ class UtilitySourceOutputGenerator(AutomaticSourceOutputGenerator):
 
                 # If we've switched to a new "feature" print out a comment on what it is.  Usually,
                 # this is a group of core commands or a group of commands in an extension.
-                if cur_cmd.ext_name != cur_extension_name:
+                if commands is rest and cur_cmd.ext_name != cur_extension_name:
                     if self.isCoreExtensionName(cur_cmd.ext_name):
                         table_helper += '\n    // ---- Core %s commands\n' % cur_cmd.ext_name[11:].replace(
                             "_", ".")